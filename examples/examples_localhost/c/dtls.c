@@ -42,8 +42,8 @@ int client2 = 1;
 fifo_t *server_fifo;
 
 void send_pending_messages(struct rasta_handle *h) {
-    while (server_fifo->size) {
-        rastaApplicationMessage *oldestMessage = server_fifo->head->data;
+    while (fifo_get_size(server_fifo)) {
+        rastaApplicationMessage *oldestMessage = fifo_peek(server_fifo);
 
         struct rasta_connection* con;
         int message_forwarded = 0;
@@ -55,12 +55,12 @@ void send_pending_messages(struct rasta_handle *h) {
                 allocateRastaMessageData(&messageData1, 1);
 
                 addRastaString(&messageData1, 0, (char*)oldestMessage->appMessage.bytes);
-                sr_send(h, con->remote_id, messageData1);
+                sr_send_connection(h, con, messageData1);
                 freeRastaMessageData(&messageData1);
 
                 printf("Message forwarded\n");
-                // printf("Disconnect to client %lu \n", (long unsigned int) result->connection.remote_id);
-                // sr_disconnect(result->handle, &result->connection);
+                // printf("Disconnect to client %lu \n", (long unsigned int) result->con->remote_id);
+                // sr_disconnect(result->handle, result->con);
                 message_forwarded = 1;
             }
         }
@@ -74,9 +74,9 @@ void send_pending_messages(struct rasta_handle *h) {
 }
 
 void onConnectionStateChange(struct rasta_notification_result *result) {
-    printf("Connection state change (remote: %u)\n", result->connection.remote_id);
+    printf("Connection state change (remote: %u)\n", result->con->remote_id);
 
-    switch (result->connection.current_state) {
+    switch (result->con->current_state) {
         case RASTA_CONNECTION_CLOSED:
             printf("CONNECTION_CLOSED\n");
             break;
@@ -89,7 +89,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
         case RASTA_CONNECTION_UP:
             printf("CONNECTION_UP\n");
             //send data to server
-            if (result->connection.my_id == ID_S1) { //Client 1
+            if (result->con->my_id == ID_S1) { //Client 1
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -101,7 +101,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
                 sr_send(result->handle,ID_R, messageData1);
 
                 //freeRastaMessageData(&messageData1);
-            } else if (result->connection.my_id == ID_S2) { //Client 2
+            } else if (result->con->my_id == ID_S2) { //Client 2
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -114,9 +114,9 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 
                 //freeRastaMessageData(&messageData1);
             }
-            else if (result->connection.my_id == ID_R) {
-                if (result->connection.remote_id == ID_S1) client1 = 0;
-                else if (result->connection.remote_id == ID_S2) client2 = 0;
+            else if (result->con->my_id == ID_R) {
+                if (result->con->remote_id == ID_S1) client1 = 0;
+                else if (result->con->remote_id == ID_S2) client2 = 0;
                 send_pending_messages(result->handle);
             }
 
@@ -134,22 +134,22 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 }
 
 void onHandshakeCompleted(struct rasta_notification_result *result){
-    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->connection.remote_id);
+    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->con->remote_id);
 }
 
 void onTimeout(struct rasta_notification_result *result){
-    printf("Entity 0x%X had a heartbeat timeout!\n", result->connection.remote_id);
+    printf("Entity 0x%X had a heartbeat timeout!\n", result->con->remote_id);
 }
 
 void onReceive(struct rasta_notification_result *result) {
     rastaApplicationMessage p;
 
-    switch (result->connection.my_id) {
+    switch (result->con->my_id) {
         case ID_R:
             // Server
-            printf("Received data from Client %u\n", result->connection.remote_id);
+            printf("Received data from Client %u\n", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle, &result->connection);
+            p = sr_get_received_data(result->handle, result->con);
 
             printf("Packet is from %lu\n", p.id);
             printf("Msg: %s\n", p.appMessage.bytes);
@@ -164,9 +164,9 @@ void onReceive(struct rasta_notification_result *result) {
 
             break;
         case ID_S1: case ID_S2:
-            printf("Received data from Server %u\n", result->connection.remote_id);
+            printf("Received data from Server %u\n", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle,&result->connection);
+            p = sr_get_received_data(result->handle,result->con);
 
             printf("Packet is from %lu\n", p.id);
             printf("Msg: %s\n", p.appMessage.bytes);
@@ -259,6 +259,8 @@ int main(int argc, char *argv[]){
             .connect_event = &connect_on_timeout_event
     };
 
+    memset(&termination_event, 0, sizeof(timed_event));
+    memset(&connect_on_timeout_event, 0, sizeof(timed_event));
     termination_event.callback = terminator;
     termination_event.carry_data = &rc->h;
     termination_event.interval = 30000000000ul;
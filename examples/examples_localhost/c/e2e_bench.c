@@ -0,0 +1,521 @@
+#include <rasta_lib.h>
+#include <rastametrics.h>
+#include <rmemory.h>
+#include <scils.h>
+#include <scils_telegram_factory.h>
+#include <udpimpairment.h>
+#include <fifo.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// runs a server and several clients on localhost in one process and pushes application messages from the clients
+// through sr_send and the loopback interface to the on_receive of the server. Prints the throughput, the latency of
+// the application messages from sr_send to on_receive, and the CPU time and the allocations per message of both
+// sides together, to size the hardware for an amount of connections. With the impaired configs, both sides inject loss,
+// jitter, reordering and skew into their transport channels, so the defer queue and the retransmissions are used.
+// The clients use as many transport channels as the server config has, so the configs decide on the amount of paths.
+// In the SCI mode, every client is a light signal that sends SCI-LS signal aspect status telegrams through
+// scils_send_signal_aspect_status, and every shard of the server is an interlocking that dispatches them with
+// scils_on_rasta_receive, so the latency and the allocations include the SCI layer on both sides
+
+// the server confirms the data PDUs with its heartbeats, so the configs use a short heartbeat interval
+#define CONFIG_PATH_S "rasta_server_benchmark_local.cfg"
+#define CONFIG_PATH_C "rasta_client_benchmark_local.cfg"
+#define CONFIG_PATH_S_IMPAIRED "rasta_server_impaired_local.cfg"
+#define CONFIG_PATH_C_IMPAIRED "rasta_client_impaired_local.cfg"
+
+#define ID_R 0x61
+
+#define MS_TO_NANO(ms) ((ms) * (uint64_t) 1000000)
+
+// how often a client fills the send queue of its connection
+#define SEND_INTERVAL (MS_TO_NANO(1) / 10)
+#define CONNECT_DELAY MS_TO_NANO(100)
+
+// every message starts with the time it was passed to sr_send, the clients and the server share the clock
+#define TIMESTAMP_LENGTH sizeof(uint64_t)
+
+// the SCI name of the server, the SCI-LS telegrams carry the timestamp in the nationally specified information
+#define SCI_NAME_SERVER "ixl"
+
+struct benchmark_client {
+    struct rasta_lib_configuration_s configuration;
+    pthread_t thread;
+    struct RastaIPData * server_channels;
+    timed_event connect_event;
+    timed_event send_event;
+    timed_event termination_event;
+
+    // the time the connection was up first and the amount of messages sent since then, for the rate
+    uint64_t send_start;
+    unsigned long sent_messages;
+
+    // the light signal of the client in the SCI mode
+    scils_t * ls;
+    char sci_name[SCI_NAME_LENGTH + 1];
+};
+
+static rasta_lib_shards_t server;
+
+// one histogram per shard of the server, as histograms may only have a single writer
+static struct rasta_histogram * latency;
+
+static atomic_ulong received_messages;
+static atomic_ulong first_receive;
+static atomic_ulong last_receive;
+
+static unsigned int message_length = 40;
+static unsigned long message_rate = 0;
+static const char * client_config_path = CONFIG_PATH_C;
+static int sci_mode = 0;
+
+// the interlocking of every shard of the server in the SCI mode
+static scils_t ** server_ls;
+
+// the transport channels of the first shard of the server, every client has as many
+static const struct RastaIPData * server_connections;
+static unsigned int path_count;
+
+uint64_t get_walltime() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static uint64_t get_cputime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000 +
+           (uint64_t) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+void* on_con_start(rasta_lib_connection_t connection) {
+    (void) connection;
+    return malloc(sizeof(rasta_lib_connection_t));
+}
+
+void on_con_end(rasta_lib_connection_t connection, void* memory) {
+    (void) connection;
+    free(memory);
+}
+
+/**
+ * records a received message
+ * @param shard the shard of the server that received it
+ * @param sent the time the message was passed to sr_send
+ */
+static void record_receive(unsigned int shard, uint64_t sent) {
+    uint64_t now = get_walltime();
+    rasta_histogram_record(&latency[shard], (unsigned long) ((now - sent) / 1000));
+
+    unsigned long expected = 0;
+    atomic_compare_exchange_strong(&first_receive, &expected, now);
+    atomic_store_explicit(&last_receive, now, memory_order_relaxed);
+    atomic_fetch_add_explicit(&received_messages, 1, memory_order_relaxed);
+}
+
+void on_signal_aspect_status(scils_t * ls, char * sender, scils_signal_aspect signal_aspect) {
+    (void) sender;
+    uint64_t sent;
+    memcpy(&sent, signal_aspect.nationally_specified_information, TIMESTAMP_LENGTH);
+
+    for (unsigned int i = 0; i < server->count; i++) {
+        if (server_ls[i] == ls) {
+            record_receive(i, sent);
+            break;
+        }
+    }
+}
+
+void on_receive(struct rasta_notification_result *result) {
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
+
+    for (unsigned int i = 0; i < server->count; i++) {
+        if (&server->shards[i].configuration.h == result->handle) {
+            if (sci_mode) {
+                // records the message in on_signal_aspect_status
+                scils_on_rasta_receive(server_ls[i], message);
+            } else {
+                uint64_t sent;
+                memcpy(&sent, message.appMessage.bytes, TIMESTAMP_LENGTH);
+                record_receive(i, sent);
+            }
+            break;
+        }
+    }
+    freeRastaByteArray(&message.appMessage);
+}
+
+int connect_event(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    sr_connect(&client->configuration.h, ID_R, client->server_channels);
+    disable_timed_event(&client->connect_event);
+    return 0;
+}
+
+int send_event(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    struct rasta_handle * h = &client->configuration.h;
+    struct rasta_connection * con = h->first_con;
+    if (con == NULL || con->current_state != RASTA_CONNECTION_UP) {
+        return 0;
+    }
+
+    uint64_t now = get_walltime();
+    if (client->send_start == 0) {
+        client->send_start = now;
+    }
+
+    // with a rate, the messages that are due since the connection is up are sent, otherwise as many as fit
+    unsigned long due = (unsigned long) -1;
+    if (message_rate > 0) {
+        due = (unsigned long) ((now - client->send_start) * message_rate / 1000000000) - client->sent_messages;
+    }
+
+    unsigned char bytes[MAX_APP_MSG_LEN];
+    memset(bytes, 0x5a, sizeof(bytes));
+    struct RastaByteArray message = { .bytes = bytes, .length = message_length };
+    struct RastaMessageData data = { .count = 1, .data_array = &message };
+
+    scils_signal_aspect signal_aspect;
+    memset(&signal_aspect, 0, sizeof(signal_aspect));
+    signal_aspect.main = SCILS_MAIN_HP_0;
+
+    // keep enough messages queued for full data PDUs, but do not overflow the queue
+    while (due > 0 && fifo_get_size(con->fifo_send) < h->config.values.sending.max_packet) {
+        uint64_t timestamp = get_walltime();
+        if (sci_mode) {
+            memcpy(signal_aspect.nationally_specified_information, &timestamp, TIMESTAMP_LENGTH);
+            scils_send_signal_aspect_status(client->ls, SCI_NAME_SERVER, signal_aspect);
+        } else {
+            memcpy(bytes, &timestamp, TIMESTAMP_LENGTH);
+            sr_send_connection(h, con, data);
+        }
+        client->sent_messages++;
+        due--;
+    }
+    return 0;
+}
+
+int terminate_event(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+static void * client_run(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    rasta_lib_start(&client->configuration, 0);
+
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->connect_event);
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->send_event);
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->termination_event);
+    return NULL;
+}
+
+static void client_init(struct benchmark_client * client, unsigned int index, unsigned int shard_count,
+                        int shared_ports, uint64_t runtime) {
+    memset(client, 0, sizeof(struct benchmark_client));
+
+    // every client is a separate entity with its own RaSTA ID and ports
+    sr_init_handle_with_offsets(&client->configuration.h, client_config_path, index, path_count * index);
+    client->configuration.h.user_handles = &client->configuration.callback;
+    client->configuration.callback.on_connection_start = on_con_start;
+    client->configuration.callback.on_disconnect = on_con_end;
+
+    if (sci_mode) {
+        snprintf(client->sci_name, sizeof(client->sci_name), "ls%u", index);
+        client->ls = scils_init(&client->configuration.h, client->sci_name);
+        scils_register_sci_name(client->ls, SCI_NAME_SERVER, ID_R);
+    }
+
+    // with shared ports the kernel of the server steers the datagrams to the shard
+    unsigned int shard_index = shared_ports ? 0 :
+                               rasta_lib_shard_index(client->configuration.h.config.values.general.rasta_id, shard_count);
+    client->server_channels = calloc(path_count, sizeof(struct RastaIPData));
+    rasta_lib_shard_channels(server_connections, path_count, shard_index, client->server_channels);
+
+    event_system * ev_sys = &client->configuration.rasta_lib_event_system;
+
+    client->connect_event.callback = connect_event;
+    client->connect_event.carry_data = client;
+    client->connect_event.interval = CONNECT_DELAY;
+    enable_timed_event(&client->connect_event);
+    add_timed_event(ev_sys, &client->connect_event);
+
+    client->send_event.callback = send_event;
+    client->send_event.carry_data = client;
+    client->send_event.interval = SEND_INTERVAL;
+    enable_timed_event(&client->send_event);
+    add_timed_event(ev_sys, &client->send_event);
+
+    client->termination_event.callback = terminate_event;
+    client->termination_event.interval = runtime;
+    enable_timed_event(&client->termination_event);
+    add_timed_event(ev_sys, &client->termination_event);
+}
+
+/**
+ * adds the statistics of the impaired transport channels of a handle
+ * @param h the handle
+ * @param total the statistics are added to this
+ */
+static void add_histogram(struct rasta_histogram * total, const struct rasta_histogram * snapshot) {
+    for (unsigned int b = 0; b < RASTA_HISTOGRAM_BUCKETS; b++) {
+        total->buckets[b] += snapshot->buckets[b];
+    }
+    total->count += snapshot->count;
+    total->sum += snapshot->sum;
+    if (snapshot->max > total->max) {
+        total->max = snapshot->max;
+    }
+}
+
+static void add_impairment_stats(struct rasta_handle * h, struct udp_impairment_stats * total) {
+    for (unsigned int i = 0; i < h->mux.port_count; i++) {
+        if (h->mux.udp_socket_states[i].impairment == NULL) {
+            continue;
+        }
+        struct udp_impairment_stats stats;
+        udp_impairment_get_stats(h->mux.udp_socket_states[i].impairment, &stats);
+        total->datagrams += stats.datagrams;
+        total->dropped += stats.dropped;
+        total->duplicated += stats.duplicated;
+        total->reordered += stats.reordered;
+        total->delayed += stats.delayed;
+        total->overflows += stats.overflows;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int client_count = argc > 1 ? atoi(argv[1]) : 1;
+    int length = argc > 2 ? atoi(argv[2]) : 40;
+    long rate = argc > 3 ? atol(argv[3]) : 0;
+    int seconds = argc > 4 ? atoi(argv[4]) : 5;
+    int shard_count = argc > 5 ? atoi(argv[5]) : 1;
+    int impaired = argc > 6 ? atoi(argv[6]) : 0;
+    sci_mode = argc > 7 ? atoi(argv[7]) : 0;
+    if (client_count <= 0 || length < (int) TIMESTAMP_LENGTH || length > MAX_APP_MSG_LEN || rate < 0 ||
+        seconds <= 0 || shard_count <= 0) {
+        printf("usage: %s [connections] [message length, %d to %d bytes] [messages/s per connection, 0 = as fast as "
+               "possible] [seconds] [server shards] [impaired, 0 or 1] [SCI-LS telegrams, 0 or 1]\n", argv[0],
+               (int) TIMESTAMP_LENGTH, MAX_APP_MSG_LEN);
+        return 1;
+    }
+    message_length = (unsigned int) length;
+    message_rate = (unsigned long) rate;
+    if (impaired) {
+        client_config_path = CONFIG_PATH_C_IMPAIRED;
+    }
+
+    if (sci_mode) {
+        // the length of a signal aspect status telegram
+        scils_signal_aspect signal_aspect;
+        memset(&signal_aspect, 0, sizeof(signal_aspect));
+        sci_telegram * telegram = scils_create_signal_aspect_status("ls0", SCI_NAME_SERVER, signal_aspect);
+        unsigned char encoded[SCI_MAX_TELEGRAM_LENGTH];
+        message_length = sci_encode_telegram_into(telegram, encoded);
+        rfree(telegram);
+    }
+
+    rasta_lib_init_shards(server, impaired ? CONFIG_PATH_S_IMPAIRED : CONFIG_PATH_S, shard_count);
+    server_ls = calloc(shard_count, sizeof(scils_t *));
+    for (int i = 0; i < shard_count; i++) {
+        struct rasta_lib_configuration_s * shard = &server->shards[i].configuration;
+        shard->callback.on_connection_start = on_con_start;
+        shard->callback.on_disconnect = on_con_end;
+        shard->h.notifications.on_receive = on_receive;
+        if (sci_mode) {
+            server_ls[i] = scils_init(&shard->h, SCI_NAME_SERVER);
+            server_ls[i]->notifications.on_signal_aspect_status_received = on_signal_aspect_status;
+        }
+    }
+    latency = calloc(shard_count, sizeof(struct rasta_histogram));
+    server_connections = server->shards[0].configuration.h.config.values.redundancy.connections.data;
+    path_count = server->shards[0].configuration.h.config.values.redundancy.connections.count;
+
+    struct benchmark_client * clients = calloc(client_count, sizeof(struct benchmark_client));
+    for (int i = 0; i < client_count; i++) {
+        client_init(&clients[i], i, shard_count, rasta_lib_shards_share_ports(server), MS_TO_NANO(1000) * seconds);
+    }
+
+    // the handshakes allocate as well, but are spread over all messages of the run
+    struct rmemory_stats memory_start, memory_end;
+    struct rmemory_subsystem_stats subsystem_start[RMEMORY_SUBSYSTEMS];
+    rmemory_get_stats(&memory_start);
+    for (unsigned int i = 0; i < RMEMORY_SUBSYSTEMS; i++) {
+        rmemory_get_subsystem_stats((rmemory_subsystem) i, &subsystem_start[i]);
+    }
+    uint64_t cpu_start = get_cputime();
+
+    rasta_lib_start_shards(server, 0, 1);
+    for (int i = 0; i < client_count; i++) {
+        pthread_create(&clients[i].thread, NULL, client_run, &clients[i]);
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        pthread_join(clients[i].thread, NULL);
+    }
+    rasta_lib_stop_shards(server);
+
+    uint64_t cpu_time = get_cputime() - cpu_start;
+    rmemory_get_stats(&memory_end);
+
+    unsigned long packets = 0;
+    for (int i = 0; i < shard_count; i++) {
+        packets += server->shards[i].configuration.h.receive_stats.packets;
+    }
+    unsigned long sent = 0;
+    for (int i = 0; i < client_count; i++) {
+        sent += clients[i].sent_messages;
+    }
+
+    struct rasta_histogram total;
+    memset(&total, 0, sizeof(total));
+    // how late the timers of the server loops fired
+    struct rasta_histogram total_lag;
+    memset(&total_lag, 0, sizeof(total_lag));
+    for (int i = 0; i < shard_count; i++) {
+        struct rasta_histogram shard_latency;
+        rasta_histogram_snapshot(&latency[i], &shard_latency);
+        add_histogram(&total, &shard_latency);
+
+        struct rasta_histogram shard_lag;
+        sr_get_loop_lag(&server->shards[i].configuration.h, &shard_lag);
+        add_histogram(&total_lag, &shard_lag);
+    }
+
+    unsigned long messages = atomic_load(&received_messages);
+    uint64_t elapsed = atomic_load(&last_receive) - atomic_load(&first_receive);
+    if (messages == 0 || elapsed == 0) {
+        printf("no application messages were received\n");
+        return 1;
+    }
+
+    printf("%d connections, %u byte %s, %lu messages/s per connection, %d shards, %u paths%s\n", client_count,
+           message_length, sci_mode ? "SCI-LS signal aspect status telegrams" : "messages", message_rate, shard_count,
+           path_count, impaired ? ", impaired transport channels" : "");
+    printf("  throughput:  %lu PDUs/s, %lu messages/s (%lu sent, %lu received)\n",
+           (unsigned long) (packets * 1000000000 / elapsed), (unsigned long) (messages * 1000000000 / elapsed),
+           sent, messages);
+    printf("  latency:     p50 %lu us, p99 %lu us, p99.9 %lu us, max %lu us, mean %lu us\n",
+           rasta_histogram_percentile(&total, 50), rasta_histogram_percentile(&total, 99),
+           rasta_histogram_percentile(&total, 99.9), total.max, total.sum / total.count);
+    if (total_lag.count > 0) {
+        printf("  timer jitter: p50 %lu us, p99 %lu us, p99.9 %lu us, max %lu us\n",
+               rasta_histogram_percentile(&total_lag, 50), rasta_histogram_percentile(&total_lag, 99),
+               rasta_histogram_percentile(&total_lag, 99.9), total_lag.max);
+    }
+    const struct rasta_handle * first_shard = &server->shards[0].configuration.h;
+    if (first_shard->config.values.loop.realtime_priority > 0 || first_shard->config.values.loop.lock_memory) {
+        const event_realtime_status * realtime = &server->shards[0].configuration.rasta_lib_event_system.realtime;
+        printf("  real-time:   SCHED_FIFO priority %d, CPU %d, memory %s\n", realtime->priority, realtime->cpu,
+               realtime->memory_locked ? "locked" : "not locked");
+    }
+    printf("  per message: %.2f us CPU, %.2f allocations, %.4f system allocations\n",
+           (double) cpu_time / 1000.0 / (double) messages,
+           (double) (memory_end.allocations - memory_start.allocations) / (double) messages,
+           (double) (memory_end.system_allocations - memory_start.system_allocations) / (double) messages);
+    // only mapped with RASTA_NUMA_PLACEMENT or RASTA_HUGE_PAGES
+    if (memory_end.mapped_bytes > 0) {
+        printf("  placed:      %.1f MiB mapped, %.1f MiB on reserved huge pages\n",
+               (double) memory_end.mapped_bytes / (1024.0 * 1024.0),
+               (double) memory_end.huge_page_bytes / (1024.0 * 1024.0));
+    }
+
+    // only counted if librasta is built with ENABLE_RASTA_MEMORY_ACCOUNTING
+    struct rmemory_subsystem_stats subsystem_end;
+    if (rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_OTHER, &subsystem_end)) {
+        printf("  allocations per message by subsystem:");
+        for (unsigned int i = 0; i < RMEMORY_SUBSYSTEMS; i++) {
+            rmemory_get_subsystem_stats((rmemory_subsystem) i, &subsystem_end);
+            printf(" %s %.2f (peak %lu bytes)", rmemory_subsystem_name((rmemory_subsystem) i),
+                   (double) (subsystem_end.allocations - subsystem_start[i].allocations) / (double) messages,
+                   subsystem_end.peak_live_bytes);
+        }
+        printf("\n");
+    }
+
+    // every path carries a copy of every PDU, the copies after the first one are discarded by their sequence number
+    printf("  paths:      ");
+    for (unsigned int p = 0; p < path_count; p++) {
+        struct rasta_transport_metrics total_path;
+        memset(&total_path, 0, sizeof(total_path));
+        for (int i = 0; i < shard_count; i++) {
+            struct rasta_transport_metrics path;
+            if (sr_get_path_metrics(&server->shards[i].configuration.h, p, &path)) {
+                total_path.pdus_in += path.pdus_in;
+                total_path.pdus_out += path.pdus_out;
+            }
+        }
+        printf(" %u: %lu in %lu out", p, total_path.pdus_in, total_path.pdus_out);
+    }
+    printf("\n");
+
+    // the connections that cost the server the most time
+    printf("  top peers:  ");
+    for (int i = 0; i < shard_count; i++) {
+        struct rasta_peer_usage top[3];
+        unsigned int top_count = sr_get_top_peers(&server->shards[i].configuration.h, top, 3);
+        for (unsigned int j = 0; j < top_count; j++) {
+            unsigned long pdus = top[j].pdus_in + top[j].pdus_out;
+            printf(" 0x%lX %.2f us per PDU (%lu PDUs)", top[j].remote_id,
+                   pdus ? (double) rasta_peer_usage_ns(&top[j]) / 1000.0 / (double) pdus : 0.0, pdus);
+        }
+    }
+    printf("\n");
+
+    if (impaired) {
+        struct udp_impairment_stats impairment;
+        memset(&impairment, 0, sizeof(impairment));
+        for (int i = 0; i < shard_count; i++) {
+            add_impairment_stats(&server->shards[i].configuration.h, &impairment);
+        }
+
+        unsigned long retransmitted = 0;
+        unsigned long defer_timeouts = 0;
+        struct rasta_connection_metrics_snapshot snapshot;
+        for (int i = 0; i < shard_count; i++) {
+            struct rasta_handle * h = &server->shards[i].configuration.h;
+            for (struct rasta_connection * con = h->first_con; con != NULL; con = con->linkedlist_next) {
+                if (sr_get_connection_metrics(h, con->remote_id, &snapshot)) {
+                    defer_timeouts += snapshot.defer_timeouts;
+                }
+            }
+        }
+        for (int i = 0; i < client_count; i++) {
+            add_impairment_stats(&clients[i].configuration.h, &impairment);
+
+            if (sr_get_connection_metrics(&clients[i].configuration.h, ID_R, &snapshot)) {
+                retransmitted += snapshot.metrics.retransmitted_pdus;
+                defer_timeouts += snapshot.defer_timeouts;
+            }
+        }
+
+        printf("  impairment:  %lu datagrams, %lu dropped, %lu duplicated, %lu reordered, %lu delayed, %lu overflows\n",
+               impairment.datagrams, impairment.dropped, impairment.duplicated, impairment.reordered,
+               impairment.delayed, impairment.overflows);
+        printf("  recovery:    %lu data PDUs retransmitted, %lu defer queue timeouts\n", retransmitted, defer_timeouts);
+    }
+
+    for (int i = 0; i < shard_count; i++) {
+        if (server_ls[i] != NULL) {
+            scils_cleanup(server_ls[i]);
+        }
+    }
+    free(server_ls);
+    rasta_lib_cleanup_shards(server);
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].ls != NULL) {
+            scils_cleanup(clients[i].ls);
+        }
+        sr_cleanup(&clients[i].configuration.h);
+        free(clients[i].server_channels);
+    }
+    free(clients);
+    free(latency);
+    return 0;
+}
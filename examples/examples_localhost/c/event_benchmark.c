@@ -0,0 +1,197 @@
+#include <event_system.h>
+#include <rastametrics.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// simulates the timed events of many RaSTA connections and measures the cpu time the event loop needs per dispatch.
+// With "latency", measures the time from writing a datagram into a socket until the fd event of the loop handles it,
+// with "busy" for the busy polling loop
+
+#define MS_TO_NANO(ms) ((ms) * (uint64_t) 1000000)
+
+// per connection: heartbeat (T_h) and timeout (T_max) like in rasta_new.c
+#define HEARTBEAT_INTERVAL MS_TO_NANO(300)
+#define TIMEOUT_INTERVAL MS_TO_NANO(750)
+// the polling interval of the send / receive events in sr_begin()
+#define IO_INTERVAL MS_TO_NANO(1)
+#define RUNTIME MS_TO_NANO(3000)
+
+// the latency benchmark sends a datagram every millisecond
+#define LATENCY_SAMPLES 3000
+#define LATENCY_INTERVAL MS_TO_NANO(1)
+
+static uint64_t dispatch_count = 0;
+
+uint64_t get_cputime() {
+    struct timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+int count_event(void* carry_data) {
+    (void) carry_data;
+    dispatch_count++;
+    return 0;
+}
+
+int heartbeat_event(void* carry_data) {
+    // a heartbeat was sent, so the partner resets its timeout
+    reschedule_event((timed_event*) carry_data);
+    dispatch_count++;
+    return 0;
+}
+
+int terminate_event(void* carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+struct latency_benchmark {
+    int sockets[2];
+    struct rasta_histogram latency;
+};
+
+static void* latency_sender(void* carry_data) {
+    struct latency_benchmark* benchmark = carry_data;
+    struct timespec interval = {0, LATENCY_INTERVAL};
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        nanosleep(&interval, NULL);
+        uint64_t sent = get_nanotime();
+        if (write(benchmark->sockets[1], &sent, sizeof(sent)) != sizeof(sent)) {
+            perror("write");
+            exit(1);
+        }
+    }
+    // 0 stops the loop
+    uint64_t stop = 0;
+    if (write(benchmark->sockets[1], &stop, sizeof(stop)) != sizeof(stop)) {
+        perror("write");
+        exit(1);
+    }
+    return NULL;
+}
+
+int latency_event(void* carry_data) {
+    struct latency_benchmark* benchmark = carry_data;
+    uint64_t sent;
+    if (read(benchmark->sockets[0], &sent, sizeof(sent)) != sizeof(sent) || sent == 0) {
+        return 1;
+    }
+    rasta_histogram_record(&benchmark->latency, get_nanotime() - sent);
+    return 0;
+}
+
+static int run_latency_benchmark(int busy_poll, int cpu) {
+    static struct latency_benchmark benchmark;
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, benchmark.sockets)) {
+        perror("socketpair");
+        return 1;
+    }
+
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    ev_sys.busy_poll = (char) busy_poll;
+    ev_sys.pin_cpu = cpu >= 0;
+    ev_sys.busy_poll_cpu = cpu;
+
+    // a heartbeat timer, so the loop also has to watch the clock
+    timed_event heartbeat;
+    memset(&heartbeat, 0, sizeof(timed_event));
+    heartbeat.callback = count_event;
+    heartbeat.interval = HEARTBEAT_INTERVAL;
+    enable_timed_event(&heartbeat);
+    add_timed_event(&ev_sys, &heartbeat);
+
+    fd_event receive;
+    memset(&receive, 0, sizeof(fd_event));
+    receive.callback = latency_event;
+    receive.carry_data = &benchmark;
+    receive.fd = benchmark.sockets[0];
+    enable_fd_event(&receive);
+    add_fd_event(&ev_sys, &receive, EV_READABLE);
+
+    pthread_t sender;
+    pthread_create(&sender, NULL, latency_sender, &benchmark);
+    uint64_t start = get_cputime();
+    event_system_start(&ev_sys);
+    uint64_t cpu_time = get_cputime() - start;
+    pthread_join(sender, NULL);
+
+    printf("%s loop: %lu samples, latency p50 %lu ns, p99 %lu ns, max %lu ns, %lu ms cpu time\n",
+           busy_poll ? "busy polling" : "sleeping", benchmark.latency.count,
+           rasta_histogram_percentile(&benchmark.latency, 50), rasta_histogram_percentile(&benchmark.latency, 99),
+           benchmark.latency.max, (unsigned long) (cpu_time / MS_TO_NANO(1)));
+
+    remove_fd_event(&ev_sys, &receive);
+    remove_timed_event(&ev_sys, &heartbeat);
+    close(benchmark.sockets[0]);
+    close(benchmark.sockets[1]);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "latency") == 0) {
+        int busy_poll = argc > 2 && strcmp(argv[2], "busy") == 0;
+        return run_latency_benchmark(busy_poll, argc > 3 ? atoi(argv[3]) : -1);
+    }
+
+    int connections = argc > 1 ? atoi(argv[1]) : 500;
+    if (connections <= 0) {
+        printf("usage: %s [connections] | latency [busy [cpu]]\n", argv[0]);
+        return 1;
+    }
+
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+
+    timed_event* events = calloc(2 * connections, sizeof(timed_event));
+    for (int i = 0; i < connections; i++) {
+        timed_event* timeout = &events[2 * i];
+        timed_event* heartbeat = &events[2 * i + 1];
+
+        timeout->callback = count_event;
+        // stagger the intervals so the connections do not fire at the same time
+        timeout->interval = TIMEOUT_INTERVAL + i * 1000;
+        enable_timed_event(timeout);
+        add_timed_event(&ev_sys, timeout);
+
+        heartbeat->callback = heartbeat_event;
+        heartbeat->carry_data = timeout;
+        heartbeat->interval = HEARTBEAT_INTERVAL + i * 1000;
+        enable_timed_event(heartbeat);
+        add_timed_event(&ev_sys, heartbeat);
+    }
+
+    timed_event io_event, termination_event;
+    memset(&io_event, 0, sizeof(timed_event));
+    io_event.callback = count_event;
+    io_event.interval = IO_INTERVAL;
+    enable_timed_event(&io_event);
+    add_timed_event(&ev_sys, &io_event);
+
+    memset(&termination_event, 0, sizeof(timed_event));
+    termination_event.callback = terminate_event;
+    termination_event.interval = RUNTIME;
+    enable_timed_event(&termination_event);
+    add_timed_event(&ev_sys, &termination_event);
+
+    uint64_t start = get_cputime();
+    event_system_start(&ev_sys);
+    uint64_t cpu_time = get_cputime() - start;
+
+    printf("%d connections: %lu dispatches in %lu us cpu time, %lu ns per dispatch\n",
+           connections, (unsigned long) dispatch_count, (unsigned long) (cpu_time / 1000),
+           (unsigned long) (dispatch_count ? cpu_time / dispatch_count : 0));
+
+    for (int i = 0; i < 2 * connections; i++) {
+        remove_timed_event(&ev_sys, &events[i]);
+    }
+    remove_timed_event(&ev_sys, &io_event);
+    remove_timed_event(&ev_sys, &termination_event);
+    free(events);
+    return 0;
+}
@@ -42,7 +42,7 @@ int event_read(void * carry_data) {
 int main() {
     last_time = test_get_nanotime();
     event_system ev_sys = {0};
-    timed_event t_events[2];
+    timed_event t_events[2] = {0};
     t_events[0].callback = send_heartbeat_event;
     t_events[0].interval = heartbeat_interval;
     t_events[0].carry_data = NULL;
@@ -55,7 +55,7 @@ int main() {
     enable_timed_event(&t_events[1]);
     add_timed_event(&ev_sys, &t_events[1]);
 
-    fd_event f_events[1];
+    fd_event f_events[1] = {0};
     f_events[0].callback = event_read;
     f_events[0].fd = STDIN_FILENO;
     f_events[0].carry_data = t_events + 1;
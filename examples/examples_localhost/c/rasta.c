@@ -20,7 +20,8 @@
 #define ID_S2 0x63
 
 void printHelpAndExit(void){
-    printf("Invalid Arguments!\n use 'r' to start in receiver mode and 's1' or 's2' to start in sender mode.\n");
+    printf("Invalid Arguments!\n use 'r' to start in receiver mode and 's1' or 's2' to start in sender mode.\n"
+           " 's12' starts both senders in one event loop on the sockets of 's1'.\n");
     exit(1);
 }
 
@@ -41,11 +42,23 @@ int client2 = 1;
 fifo_t *server_fifo;
 
 void send_pending_messages(struct rasta_handle *h) {
-    while (server_fifo->size) {
-        rastaApplicationMessage *oldestMessage = server_fifo->head->data;
+    while (fifo_get_size(server_fifo)) {
+        rastaApplicationMessage *oldestMessage = fifo_peek(server_fifo);
 
         struct rasta_connection* con;
         int message_forwarded = 0;
+
+        // sending on a connection that is not up yet closes it, keep the message until all receivers are up
+        int receivers_up = 1;
+        for (con = h->first_con; con; con = con->linkedlist_next) {
+            if (con->remote_id != oldestMessage->id && con->current_state != RASTA_CONNECTION_UP) {
+                receivers_up = 0;
+            }
+        }
+        if (!receivers_up) {
+            break;
+        }
+
         for (con = h->first_con; con; con = con->linkedlist_next) {
             if (con->remote_id != oldestMessage->id) {
                  printf("Client message from %lu is now sent to %lu\n", oldestMessage->id, (long unsigned int) con->remote_id);
@@ -54,12 +67,12 @@ void send_pending_messages(struct rasta_handle *h) {
                 allocateRastaMessageData(&messageData1, 1);
 
                 addRastaString(&messageData1, 0, (char*)oldestMessage->appMessage.bytes);
-                sr_send(h, con->remote_id, messageData1);
+                sr_send_connection(h, con, messageData1);
                 freeRastaMessageData(&messageData1);
 
                 printf("Message forwarded\n");
-                // printf("Disconnect to client %lu \n", (long unsigned int) result->connection.remote_id);
-                // sr_disconnect(result->handle, &result->connection);
+                // printf("Disconnect to client %lu \n", (long unsigned int) result->con->remote_id);
+                // sr_disconnect(result->handle, result->con);
                 message_forwarded = 1;
             }
         }
@@ -73,9 +86,9 @@ void send_pending_messages(struct rasta_handle *h) {
 }
 
 void onConnectionStateChange(struct rasta_notification_result *result) {
-    printf("Connection state change (remote: %u)\n", result->connection.remote_id);
+    printf("Connection state change (remote: %u)\n", result->con->remote_id);
 
-    switch (result->connection.current_state) {
+    switch (result->con->current_state) {
         case RASTA_CONNECTION_CLOSED:
             printf("CONNECTION_CLOSED\n");
             break;
@@ -88,7 +101,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
         case RASTA_CONNECTION_UP:
             printf("CONNECTION_UP\n");
             //send data to server
-            if (result->connection.my_id == ID_S1) { //Client 1
+            if (result->con->my_id == ID_S1) { //Client 1
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -100,7 +113,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
                 sr_send(result->handle,ID_R, messageData1);
 
                 //freeRastaMessageData(&messageData1);
-            } else if (result->connection.my_id == ID_S2) { //Client 2
+            } else if (result->con->my_id == ID_S2) { //Client 2
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -113,9 +126,9 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 
                 //freeRastaMessageData(&messageData1);
             }
-            else if (result->connection.my_id == ID_R) {
-                if (result->connection.remote_id == ID_S1) client1 = 0;
-                else if (result->connection.remote_id == ID_S2) client2 = 0;
+            else if (result->con->my_id == ID_R) {
+                if (result->con->remote_id == ID_S1) client1 = 0;
+                else if (result->con->remote_id == ID_S2) client2 = 0;
                 send_pending_messages(result->handle);
             }
 
@@ -133,22 +146,22 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 }
 
 void onHandshakeCompleted(struct rasta_notification_result *result){
-    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->connection.remote_id);
+    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->con->remote_id);
 }
 
 void onTimeout(struct rasta_notification_result *result){
-    printf("Entity 0x%X had a heartbeat timeout!\n", result->connection.remote_id);
+    printf("Entity 0x%X had a heartbeat timeout!\n", result->con->remote_id);
 }
 
 void onReceive(struct rasta_notification_result *result) {
     rastaApplicationMessage p;
 
-    switch (result->connection.my_id) {
+    switch (result->con->my_id) {
         case ID_R:
             // Server
-            printf("Received data from Client %u\n", result->connection.remote_id);
+            printf("Received data from Client %u\n", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle, &result->connection);
+            p = sr_get_received_data(result->handle, result->con);
 
             printf("Packet is from %lu\n", p.id);
             printf("Msg: %s\n", p.appMessage.bytes);
@@ -163,9 +176,9 @@ void onReceive(struct rasta_notification_result *result) {
 
             break;
         case ID_S1: case ID_S2:
-            printf("Received data from Server %u\n", result->connection.remote_id);
+            printf("Received data from Server %u\n", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle,&result->connection);
+            p = sr_get_received_data(result->handle,result->con);
 
             printf("Packet is from %lu\n", p.id);
             printf("Msg: %s\n", p.appMessage.bytes);
@@ -226,6 +239,29 @@ void on_con_end(rasta_lib_connection_t connection, void* memory) {
     free(memory);
 }
 
+/**
+ * ends the shared event loop of both senders, they are cleaned up after it
+ */
+int shared_terminator(void* carry_data) {
+    (void) carry_data;
+    printf("terminating\n");
+    printf("Check server log for test status!\n");
+    test_success = true;
+    return 1;
+}
+
+/**
+ * sets up a sender of the 's12' mode
+ */
+static void init_shared_sender(struct rasta_lib_configuration_s * sender) {
+    sender->h.user_handles->on_connection_start = on_con_start;
+    sender->h.user_handles->on_disconnect = on_con_end;
+
+    sender->h.notifications.on_connection_state_change = onConnectionStateChange;
+    sender->h.notifications.on_receive = onReceive;
+    sender->h.notifications.on_handshake_complete = onHandshakeCompleted;
+}
+
 int main(int argc, char *argv[]){
 
     if (argc != 2) printHelpAndExit();
@@ -247,6 +283,8 @@ int main(int argc, char *argv[]){
             .connect_event = &connect_on_timeout_event
     };
 
+    memset(&termination_event, 0, sizeof(timed_event));
+    memset(&connect_on_timeout_event, 0, sizeof(timed_event));
     termination_event.callback = terminator;
     termination_event.carry_data = &rc->h;
     termination_event.interval = 30000000000ul;
@@ -264,6 +302,9 @@ int main(int argc, char *argv[]){
 
         server_fifo = fifo_init(128);
 
+        // kill -HUP applies the changed timings of rasta_server_local.cfg to the running connections
+        sr_reload_on_sighup(&rc->h);
+
         rc->h.notifications.on_connection_state_change = onConnectionStateChange;
         rc->h.notifications.on_receive = onReceive;
         rc->h.notifications.on_handshake_complete = onHandshakeCompleted;
@@ -306,6 +347,37 @@ int main(int argc, char *argv[]){
         add_timed_event(&rc->rasta_lib_event_system, &connect_on_timeout_event);
         rasta_lib_start(rc, 0);
     }
+    else if (strcmp(argv[1], "s12") == 0) {
+        printf("->   S1 (ID = 0x%lX) and S2 (ID = 0x%lX)\n", (unsigned long)ID_S1, (unsigned long)ID_S2);
+        rasta_lib_entities_t senders;
+        const unsigned long ids[2] = { ID_S1, ID_S2 };
+        rasta_lib_init_entities(senders, CONFIG_PATH_C1, ids, 2);
+
+        timed_event connect_events[2];
+        struct connect_event_data connect_data[2];
+        for (unsigned int i = 0; i < 2; i++) {
+            struct rasta_lib_configuration_s * sender = rasta_lib_get_entity(senders, ids[i]);
+            init_shared_sender(sender);
+
+            connect_data[i] = connect_on_stdin_event_data;
+            connect_data[i].h = &sender->h;
+            connect_data[i].connect_event = &connect_events[i];
+            memset(&connect_events[i], 0, sizeof(timed_event));
+            connect_events[i].callback = connect_timed;
+            connect_events[i].carry_data = &connect_data[i];
+            connect_events[i].interval = 3000000000ul;
+            enable_timed_event(&connect_events[i]);
+            add_timed_event(&senders->entities[0].rasta_lib_event_system, &connect_events[i]);
+        }
+
+        // all entities run in the event loop of the first one
+        termination_event.callback = shared_terminator;
+        termination_event.carry_data = NULL;
+        add_timed_event(&senders->entities[0].rasta_lib_event_system, &termination_event);
+        rasta_lib_start_entities(senders, 0);
+
+        rasta_lib_cleanup_entities(senders);
+    }
     return test_success != true;
 }
 
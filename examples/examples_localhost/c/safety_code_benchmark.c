@@ -0,0 +1,101 @@
+#include <rastahashing.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// checks the safety codes of received batches of PDUs one by one and with rasta_hash_verify_batch() and
+// measures the cpu time per PDU
+
+// a batch of the redundancy layer receive path, see UDP_RECEIVE_BATCH_SIZE
+#define BATCH_SIZE 32
+#define ROUNDS 20000
+
+uint64_t get_cputime() {
+    struct timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+int main(int argc, char* argv[]) {
+    int pdu_length = argc > 1 ? atoi(argv[1]) : 64;
+    const char * algorithm = argc > 2 ? argv[2] : "md4";
+    if (pdu_length <= 0 || pdu_length > 1000) {
+        printf("usage: %s [pdu length (1-1000)] [md4|blake2b|siphash]\n", argv[0]);
+        return 1;
+    }
+
+    rasta_hashing_context_t context;
+    unsigned int lanes;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    if (strcmp(algorithm, "blake2b") == 0) {
+        unsigned char key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+        context.key.bytes = NULL;
+        context.algorithm = RASTA_ALGO_BLAKE2B;
+        rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+        lanes = BLAKE2B_LANES;
+    } else if (strcmp(algorithm, "siphash") == 0) {
+        unsigned char key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+        context.key.bytes = NULL;
+        context.algorithm = RASTA_ALGO_SIPHASH_2_4;
+        rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+        lanes = SIPHASH_LANES;
+    } else {
+        context.algorithm = RASTA_ALGO_MD4;
+        rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+        lanes = MD4_LANES;
+    }
+
+    unsigned char * pdus = malloc((size_t) BATCH_SIZE * pdu_length);
+    const unsigned char * messages[BATCH_SIZE];
+    unsigned int lengths[BATCH_SIZE];
+    unsigned char hashes[BATCH_SIZE][16];
+    const unsigned char * expected[BATCH_SIZE];
+    int results[BATCH_SIZE];
+
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        messages[i] = &pdus[i * pdu_length];
+        lengths[i] = (unsigned int) pdu_length;
+        expected[i] = hashes[i];
+        for (int j = 0; j < pdu_length; j++) {
+            pdus[i * pdu_length + j] = (unsigned char) rand();
+        }
+
+        struct RastaByteArray data;
+        data.bytes = &pdus[i * pdu_length];
+        data.length = (unsigned int) pdu_length;
+        rasta_calculate_hash(data, &context, hashes[i]);
+    }
+
+    unsigned long correct = 0;
+    uint64_t start = get_cputime();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            unsigned char hash[16];
+            struct RastaByteArray data;
+            data.bytes = (unsigned char *) messages[i];
+            data.length = lengths[i];
+            rasta_calculate_hash(data, &context, hash);
+            correct += (memcmp(hash, expected[i], 8) == 0);
+        }
+    }
+    uint64_t scalar_time = get_cputime() - start;
+
+    start = get_cputime();
+    for (int r = 0; r < ROUNDS; r++) {
+        rasta_hash_verify_batch(&context, messages, lengths, expected, BATCH_SIZE, results);
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            correct += (unsigned long) results[i];
+        }
+    }
+    uint64_t batch_time = get_cputime() - start;
+
+    unsigned long pdu_count = (unsigned long) ROUNDS * BATCH_SIZE;
+    printf("%s, %d byte PDUs, %lu of %lu safety codes correct\n", algorithm, pdu_length, correct, 2 * pdu_count);
+    printf("one by one: %lu ns per PDU\n", (unsigned long) (scalar_time / pdu_count));
+    printf("batch (%u lanes): %lu ns per PDU\n", lanes, (unsigned long) (batch_time / pdu_count));
+
+    free(pdus);
+    freeRastaByteArray(&context.key);
+    return 0;
+}
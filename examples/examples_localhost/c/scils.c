@@ -23,12 +23,12 @@ void printHelpAndExit(void){
 }
 
 void onReceive(struct rasta_notification_result *result){
-    rastaApplicationMessage message = sr_get_received_data(result->handle, &result->connection);
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
     scils_on_rasta_receive(scils, message);
 }
 
 void onHandshakeComplete(struct rasta_notification_result *result) {
-    if (result->connection.my_id == ID_C){
+    if (result->con->my_id == ID_C){
 
         printf("Sending show signal aspect command...\n");
         scils_signal_aspect * signal_aspect = scils_signal_aspect_defaults();
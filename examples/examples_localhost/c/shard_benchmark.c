@@ -0,0 +1,192 @@
+#include <rasta_lib.h>
+#include <fifo.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// runs a sharded server and several clients on localhost, every client sends application messages as fast as the
+// server confirms them. Prints how many PDUs the shards of the server received per second, run it with a growing
+// amount of shards to see how the throughput scales with the cores
+
+// the server confirms the data PDUs with its heartbeats, so the configs use a short heartbeat interval
+#define CONFIG_PATH_S "rasta_server_benchmark_local.cfg"
+#define CONFIG_PATH_C "rasta_client_benchmark_local.cfg"
+
+#define ID_R 0x61
+
+#define MS_TO_NANO(ms) ((ms) * (uint64_t) 1000000)
+
+// how often a client fills the send queue of its connection
+#define SEND_INTERVAL (MS_TO_NANO(1) / 10)
+#define CONNECT_DELAY MS_TO_NANO(100)
+
+#define MESSAGE_LENGTH 40
+
+struct benchmark_client {
+    struct rasta_lib_configuration_s configuration;
+    pthread_t thread;
+    struct RastaIPData server_channels[2];
+    timed_event connect_event;
+    timed_event send_event;
+    timed_event termination_event;
+};
+
+static atomic_ulong received_messages;
+
+static unsigned char message_bytes[MESSAGE_LENGTH];
+
+uint64_t get_walltime() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+void* on_con_start(rasta_lib_connection_t connection) {
+    (void) connection;
+    return malloc(sizeof(rasta_lib_connection_t));
+}
+
+void on_con_end(rasta_lib_connection_t connection, void* memory) {
+    (void) connection;
+    free(memory);
+}
+
+void on_receive(struct rasta_notification_result *result) {
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
+    freeRastaByteArray(&message.appMessage);
+    atomic_fetch_add_explicit(&received_messages, 1, memory_order_relaxed);
+}
+
+int connect_event(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    sr_connect(&client->configuration.h, ID_R, client->server_channels);
+    disable_timed_event(&client->connect_event);
+    return 0;
+}
+
+int send_event(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    struct rasta_handle * h = &client->configuration.h;
+    struct rasta_connection * con = h->first_con;
+    if (con == NULL || con->current_state != RASTA_CONNECTION_UP) {
+        return 0;
+    }
+
+    struct RastaByteArray message = { .bytes = message_bytes, .length = MESSAGE_LENGTH };
+    struct RastaMessageData data = { .count = 1, .data_array = &message };
+
+    // keep enough messages queued for full data PDUs, but do not overflow the queue
+    while (fifo_get_size(con->fifo_send) < h->config.values.sending.max_packet) {
+        sr_send_connection(h, con, data);
+    }
+    return 0;
+}
+
+int terminate_event(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+static void * client_run(void * carry_data) {
+    struct benchmark_client * client = carry_data;
+    rasta_lib_start(&client->configuration, 0);
+
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->connect_event);
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->send_event);
+    remove_timed_event(&client->configuration.rasta_lib_event_system, &client->termination_event);
+    return NULL;
+}
+
+static void client_init(struct benchmark_client * client, unsigned int index, unsigned int shard_count,
+                        int shared_ports, uint64_t runtime) {
+    memset(client, 0, sizeof(struct benchmark_client));
+
+    // every client is a separate entity with its own RaSTA ID and ports
+    sr_init_handle_with_offsets(&client->configuration.h, CONFIG_PATH_C, index, 2 * index);
+    client->configuration.h.user_handles = &client->configuration.callback;
+    client->configuration.callback.on_connection_start = on_con_start;
+    client->configuration.callback.on_disconnect = on_con_end;
+
+    struct RastaIPData server_channels[2];
+    strcpy(server_channels[0].ip, "127.0.0.1");
+    strcpy(server_channels[1].ip, "127.0.0.1");
+    server_channels[0].port = 8888;
+    server_channels[1].port = 8889;
+    // with shared ports the kernel of the server steers the datagrams to the shard
+    unsigned int shard_index = shared_ports ? 0 :
+                               rasta_lib_shard_index(client->configuration.h.config.values.general.rasta_id, shard_count);
+    rasta_lib_shard_channels(server_channels, 2, shard_index, client->server_channels);
+
+    event_system * ev_sys = &client->configuration.rasta_lib_event_system;
+
+    client->connect_event.callback = connect_event;
+    client->connect_event.carry_data = client;
+    client->connect_event.interval = CONNECT_DELAY;
+    enable_timed_event(&client->connect_event);
+    add_timed_event(ev_sys, &client->connect_event);
+
+    client->send_event.callback = send_event;
+    client->send_event.carry_data = client;
+    client->send_event.interval = SEND_INTERVAL;
+    enable_timed_event(&client->send_event);
+    add_timed_event(ev_sys, &client->send_event);
+
+    client->termination_event.callback = terminate_event;
+    client->termination_event.interval = runtime;
+    enable_timed_event(&client->termination_event);
+    add_timed_event(ev_sys, &client->termination_event);
+}
+
+int main(int argc, char* argv[]) {
+    int shard_count = argc > 1 ? atoi(argv[1]) : 1;
+    int client_count = argc > 2 ? atoi(argv[2]) : 8;
+    int seconds = argc > 3 ? atoi(argv[3]) : 5;
+    if (shard_count <= 0 || client_count <= 0 || seconds <= 0) {
+        printf("usage: %s [shards] [clients] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    rasta_lib_shards_t server;
+    rasta_lib_init_shards(server, CONFIG_PATH_S, shard_count);
+    for (int i = 0; i < shard_count; i++) {
+        struct rasta_lib_configuration_s * shard = &server->shards[i].configuration;
+        shard->callback.on_connection_start = on_con_start;
+        shard->callback.on_disconnect = on_con_end;
+        shard->h.notifications.on_receive = on_receive;
+    }
+
+    struct benchmark_client * clients = calloc(client_count, sizeof(struct benchmark_client));
+    for (int i = 0; i < client_count; i++) {
+        client_init(&clients[i], i, shard_count, rasta_lib_shards_share_ports(server), MS_TO_NANO(1000) * seconds);
+    }
+
+    uint64_t start = get_walltime();
+    rasta_lib_start_shards(server, 0, 1);
+    for (int i = 0; i < client_count; i++) {
+        pthread_create(&clients[i].thread, NULL, client_run, &clients[i]);
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        pthread_join(clients[i].thread, NULL);
+    }
+    rasta_lib_stop_shards(server);
+    uint64_t elapsed = get_walltime() - start;
+
+    unsigned long packets = 0;
+    for (int i = 0; i < shard_count; i++) {
+        packets += server->shards[i].configuration.h.receive_stats.packets;
+    }
+    unsigned long messages = atomic_load(&received_messages);
+
+    printf("%d shards, %d clients: %lu PDUs/s, %lu messages/s\n", shard_count, client_count,
+           (unsigned long) (packets * 1000000000 / elapsed), (unsigned long) (messages * 1000000000 / elapsed));
+
+    rasta_lib_cleanup_shards(server);
+    for (int i = 0; i < client_count; i++) {
+        sr_cleanup(&clients[i].configuration.h);
+    }
+    free(clients);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// The rasta example on the C++ wrapper: the receiver echoes every message back, the sender sends three messages in
+// one data PDU and checks the echoes.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <rasta.hpp>
+
+#define CONFIG_PATH_S "rasta_server_local.cfg"
+#define CONFIG_PATH_C1 "rasta_client1_local.cfg"
+
+#define ID_R 0x61
+
+static const char* const MESSAGES[] = {"Message 1 from Sender 1", "Message 2 from Sender 1", "Message 3 from Sender 1"};
+static constexpr int MESSAGE_COUNT = 3;
+
+static void printHelpAndExit() {
+    printf("Invalid Arguments!\n use 'r' to start in receiver mode and 's1' to start in sender mode.\n");
+    exit(1);
+}
+
+static int terminator(void* carry_data) {
+    (void) carry_data;
+    printf("terminating\n");
+    return 1;
+}
+
+struct connect_event_data {
+    rasta::Handle* handle;
+    struct RastaIPData* ip_data_arr;
+    timed_event* connect_event;
+};
+
+static int connect_timed(void* carry_data) {
+    auto* data = static_cast<connect_event_data*>(carry_data);
+    printf("->   Connection request sent to 0x%lX\n", (unsigned long) ID_R);
+    data->handle->Connect(ID_R, data->ip_data_arr);
+    disable_timed_event(data->connect_event);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) printHelpAndExit();
+
+    timed_event termination_event;
+    memset(&termination_event, 0, sizeof(timed_event));
+    termination_event.callback = terminator;
+    termination_event.interval = 10000000000ul;
+    enable_timed_event(&termination_event);
+
+    if (strcmp(argv[1], "r") == 0) {
+        rasta::Handle handle(CONFIG_PATH_S);
+        printf("->   R (ID = 0x%lX)\n", handle.Id());
+
+        handle.OnReceive([](rasta::Connection con, rasta::Message message) {
+            printf("Msg: %.*s\n", (int) message.size(), reinterpret_cast<const char*>(message.data()));
+            con.Send(message.View());
+        });
+
+        add_timed_event(handle.Events(), &termination_event);
+        handle.Run(0);
+    } else if (strcmp(argv[1], "s1") == 0) {
+        rasta::Handle handle(CONFIG_PATH_C1);
+        printf("->   S1 (ID = 0x%lX)\n", handle.Id());
+
+        struct RastaIPData toServer[2];
+        strcpy(toServer[0].ip, "127.0.0.1");
+        strcpy(toServer[1].ip, "127.0.0.1");
+        toServer[0].port = 8888;
+        toServer[1].port = 8889;
+
+        handle.OnHandshakeComplete([](rasta::Connection con) {
+            printf("->   Connection to 0x%lX is up\n", con.RemoteId());
+            rasta::ByteView messages[MESSAGE_COUNT];
+            for (int i = 0; i < MESSAGE_COUNT; i++) {
+                messages[i] = rasta::ByteView(MESSAGES[i], strlen(MESSAGES[i]));
+            }
+            con.Send(messages);
+        });
+
+        int echoed = 0;
+        bool in_order = true;
+        handle.OnReceive([&echoed, &in_order](rasta::Connection, rasta::Message message) {
+            printf("Msg: %.*s\n", (int) message.size(), reinterpret_cast<const char*>(message.data()));
+            if (echoed >= MESSAGE_COUNT || message.size() != strlen(MESSAGES[echoed]) ||
+                memcmp(message.data(), MESSAGES[echoed], message.size()) != 0) {
+                in_order = false;
+            }
+            echoed++;
+        });
+
+        timed_event connect_event;
+        memset(&connect_event, 0, sizeof(timed_event));
+        struct connect_event_data connect_data = {&handle, toServer, &connect_event};
+        connect_event.callback = connect_timed;
+        connect_event.carry_data = &connect_data;
+        connect_event.interval = 1000000000ul;
+        enable_timed_event(&connect_event);
+        add_timed_event(handle.Events(), &connect_event);
+
+        add_timed_event(handle.Events(), &termination_event);
+        handle.Run(0);
+
+        if (echoed == MESSAGE_COUNT && in_order) {
+            printf("Test success!\n");
+        } else {
+            printf("Test failure - %d of %d messages were echoed%s\n", echoed, MESSAGE_COUNT,
+                   in_order ? "" : ", not in order");
+            return 1;
+        }
+    } else {
+        printHelpAndExit();
+    }
+    return 0;
+}
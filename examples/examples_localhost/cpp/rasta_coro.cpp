@@ -0,0 +1,139 @@
+// The rasta example on the coroutines of the C++ wrapper: the receiver serves every connection with a coroutine that
+// echoes every message back, the sender connects, sends three messages and awaits the echoes.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <rasta_coro.hpp>
+
+#define CONFIG_PATH_S "rasta_server_local.cfg"
+#define CONFIG_PATH_C1 "rasta_client1_local.cfg"
+
+#define ID_R 0x61
+
+using namespace std::chrono_literals;
+
+static const char* const MESSAGES[] = {"Message 1 from Sender 1", "Message 2 from Sender 1", "Message 3 from Sender 1"};
+static constexpr int MESSAGE_COUNT = 3;
+
+static void printHelpAndExit() {
+    printf("Invalid Arguments!\n use 'r' to start in receiver mode and 's1' to start in sender mode.\n");
+    exit(1);
+}
+
+static int terminator(void* carry_data) {
+    (void) carry_data;
+    printf("terminating\n");
+    return 1;
+}
+
+static rasta::Task echo(rasta::AsyncConnection con) {
+    for (;;) {
+        rasta::Message message = co_await con.Receive();
+        if (message.Sender() == 0) {
+            printf("->   Connection to 0x%lX closed\n", con.RemoteId());
+            co_return;
+        }
+        printf("Msg: %.*s\n", (int) message.size(), reinterpret_cast<const char*>(message.data()));
+        co_await con.Send(message.View());
+    }
+}
+
+static rasta::Task serve(rasta::Scheduler& scheduler) {
+    for (;;) {
+        rasta::AsyncConnection con = co_await scheduler.Accept();
+        printf("->   Connection from 0x%lX is up\n", con.RemoteId());
+        echo(con);
+    }
+}
+
+struct sender_result {
+    int echoed = 0;
+    bool in_order = true;
+};
+
+static rasta::Task send(rasta::Scheduler& scheduler, struct RastaIPData* toServer, sender_result& result) {
+    // gives the receiver time to start, the connection is initiated by the loop
+    co_await scheduler.Sleep(1s);
+
+    printf("->   Connection request sent to 0x%lX\n", (unsigned long) ID_R);
+    rasta::AsyncConnection con = co_await scheduler.Connect(ID_R, toServer);
+    if (!con) {
+        printf("->   Connection to 0x%lX failed\n", (unsigned long) ID_R);
+        scheduler.Stop();
+        co_return;
+    }
+    printf("->   Connection to 0x%lX is up\n", con.RemoteId());
+
+    for (const char* text : MESSAGES) {
+        co_await con.Send(rasta::ByteView(text, strlen(text)));
+    }
+
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+        rasta::Message message = co_await con.Receive();
+        if (message.Sender() == 0) {
+            break;
+        }
+        printf("Msg: %.*s\n", (int) message.size(), reinterpret_cast<const char*>(message.data()));
+        if (message.size() != strlen(MESSAGES[i]) || memcmp(message.data(), MESSAGES[i], message.size()) != 0) {
+            result.in_order = false;
+        }
+        result.echoed++;
+    }
+    scheduler.Stop();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) printHelpAndExit();
+
+    timed_event termination_event;
+    memset(&termination_event, 0, sizeof(timed_event));
+    termination_event.callback = terminator;
+    termination_event.interval = 10000000000ul;
+    enable_timed_event(&termination_event);
+
+    if (strcmp(argv[1], "r") == 0) {
+        rasta::Handle handle(CONFIG_PATH_S);
+        printf("->   R (ID = 0x%lX)\n", handle.Id());
+
+        {
+            rasta::Scheduler scheduler(handle);
+            serve(scheduler);
+
+            add_timed_event(handle.Events(), &termination_event);
+            handle.Run(0);
+            remove_timed_event(handle.Events(), &termination_event);
+        }
+    } else if (strcmp(argv[1], "s1") == 0) {
+        rasta::Handle handle(CONFIG_PATH_C1);
+        printf("->   S1 (ID = 0x%lX)\n", handle.Id());
+
+        struct RastaIPData toServer[2];
+        strcpy(toServer[0].ip, "127.0.0.1");
+        strcpy(toServer[1].ip, "127.0.0.1");
+        toServer[0].port = 8888;
+        toServer[1].port = 8889;
+
+        sender_result result;
+        {
+            rasta::Scheduler scheduler(handle);
+            send(scheduler, toServer, result);
+
+            add_timed_event(handle.Events(), &termination_event);
+            handle.Run(0);
+            remove_timed_event(handle.Events(), &termination_event);
+        }
+
+        if (result.echoed == MESSAGE_COUNT && result.in_order) {
+            printf("Test success!\n");
+        } else {
+            printf("Test failure - %d of %d messages were echoed%s\n", result.echoed, MESSAGE_COUNT,
+                   result.in_order ? "" : ", not in order");
+            return 1;
+        }
+    } else {
+        printHelpAndExit();
+    }
+    return 0;
+}
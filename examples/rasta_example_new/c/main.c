@@ -36,9 +36,9 @@ int client1 = 1;
 int client2 = 1;
 
 void onConnectionStateChange(struct rasta_notification_result *result) {
-    printf("\n Connectionstate change (remote: %u)", result->connection.remote_id);
+    printf("\n Connectionstate change (remote: %u)", result->con->remote_id);
 
-    switch (result->connection.current_state) {
+    switch (result->con->current_state) {
         case RASTA_CONNECTION_CLOSED:
             printf("\nCONNECTION_CLOSED \n\n");
             break;
@@ -51,7 +51,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
         case RASTA_CONNECTION_UP:
             printf("\nCONNECTION_UP \n\n");
             //send data to server
-            if (result->connection.my_id == ID_S1) { //Client 1
+            if (result->con->my_id == ID_S1) { //Client 1
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -63,7 +63,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
                 sr_send(result->handle,ID_R, messageData1);
 
                 //freeRastaMessageData(&messageData1);
-            } else if (result->connection.my_id == ID_S2) { //Client 2
+            } else if (result->con->my_id == ID_S2) { //Client 2
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -76,9 +76,9 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 
                 //freeRastaMessageData(&messageData1);
             }
-            else if (result->connection.my_id == ID_R) {
-                if (result->connection.remote_id == ID_S1) client1 = 0;
-                else if (result->connection.remote_id == ID_S2) client2 = 0;
+            else if (result->con->my_id == ID_R) {
+                if (result->con->remote_id == ID_S1) client1 = 0;
+                else if (result->con->remote_id == ID_S2) client2 = 0;
             }
 
 
@@ -96,22 +96,22 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 }
 
 void onHandshakeCompleted(struct rasta_notification_result *result){
-    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->connection.remote_id);
+    printf("Handshake complete, tls_state is now UP (with ID 0x%X)\n", result->con->remote_id);
 }
 
 void onTimeout(struct rasta_notification_result *result){
-    printf("Entity 0x%X had a heartbeat timeout!\n", result->connection.remote_id);
+    printf("Entity 0x%X had a heartbeat timeout!\n", result->con->remote_id);
 }
 
 void onReceive(struct rasta_notification_result *result) {
     rastaApplicationMessage p;
 
-    switch (result->connection.my_id) {
+    switch (result->con->my_id) {
         case ID_R:
             //Server
-            printf("\nReceived data from Client %u", result->connection.remote_id);
+            printf("\nReceived data from Client %u", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle,&result->connection);
+            p = sr_get_received_data(result->handle,result->con);
 
             printf("\nPacket is from %lu", p.id);
             printf("\nMsg: %s", p.appMessage.bytes);
@@ -157,9 +157,9 @@ void onReceive(struct rasta_notification_result *result) {
             sr_disconnect(result->handle, con);
             break;
         case ID_S1: case ID_S2:
-            printf("\nReceived data from Server %u", result->connection.remote_id);
+            printf("\nReceived data from Server %u", result->con->remote_id);
 
-            p = sr_get_received_data(result->handle,&result->connection);
+            p = sr_get_received_data(result->handle,result->con);
 
             printf("\nPacket is from %lu", p.id);
             printf("\nMsg: %s", p.appMessage.bytes);
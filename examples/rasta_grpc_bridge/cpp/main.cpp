@@ -1,16 +1,21 @@
 #include <iostream>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/eventfd.h>
 #include <unistd.h>
 
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
 #include <grpcpp/health_check_service_interface.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 
@@ -23,11 +28,21 @@
 
 using namespace std::chrono_literals;
 
-static std::mutex s_busy;
+// Messages that are queued per stream in each direction. Messages from RaSTA that do not fit anymore are dropped, the
+// messages of a gRPC peer are only read while there is room
+static constexpr size_t STREAM_QUEUE_CAPACITY = 1024;
 
-// Client
-static std::unique_ptr<grpc::ClientContext> s_currentContext;
-static std::unique_ptr<grpc::ClientReaderWriter<sci::SciPacket, sci::SciPacket>> s_currentStream;
+// Messages that are written to a gRPC peer in one packet at most, if the peer accepts batches
+static constexpr int BATCH_MAX_MESSAGES = 64;
+
+// How long a stream waits for the handshake of a connection that is initiated by the bridge
+static constexpr auto HANDSHAKE_TIMEOUT = 1000ms;
+
+// Commands of the gRPC threads that wait for the RaSTA thread at most
+static constexpr unsigned int COMMAND_QUEUE_SIZE = 1024;
+
+// How often a closed connection to the configured remote entity is initiated again
+static constexpr uint64_t RECONNECT_INTERVAL_NS = 1000000000;
 
 void* on_con_start(rasta_lib_connection_t connection) {
     (void) connection;
@@ -39,406 +54,799 @@ void on_con_end(rasta_lib_connection_t connection, void* memory) {
     free(memory);
 }
 
-class RastaService final : public sci::Rasta::Service
-{
+static struct rasta_connection* find_connection(struct rasta_handle* h, unsigned long remote_id) {
+    for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
+        if (con->remote_id == remote_id) {
+            return con;
+        }
+    }
+    return nullptr;
+}
+
+class Bridge;
+
+/**
+ * A gRPC stream that is bound to the RaSTA connection to one remote entity. All gRPC operations of a stream are
+ * started and completed on the thread of the completion queue. The RaSTA event loop only queues the received messages
+ * in a bounded queue and wakes that thread up with an alarm, so a slow gRPC peer never stalls the event loop.
+ */
+class BridgeStream {
  public:
-    RastaService(std::string rasta_channel1_address, std::string rasta_channel1_port,
-                std::string rasta_channel2_address, std::string rasta_channel2_port,
-                std::string rasta_local_id, std::string rasta_target_id)
-                : _rasta_channel1_address(rasta_channel1_address), _rasta_channel1_port(rasta_channel1_port)
-                , _rasta_channel2_address(rasta_channel2_address), _rasta_channel2_port(rasta_channel2_port)
-                , _rasta_local_id(rasta_local_id), _rasta_target_id(rasta_target_id) {}
-
-    grpc::Status Stream(grpc::ServerContext* context, grpc::ServerReaderWriter<sci::SciPacket, sci::SciPacket>* stream) override {
-        static grpc::ServerReaderWriter<sci::SciPacket, sci::SciPacket>* s_currentStream;
-        static grpc::ServerContext* s_currentContext;
-        static std::mutex s_handshake_mutex;
-        static std::condition_variable s_handshake_condition;
-
-        std::lock_guard<std::mutex> guard(s_busy);
-        s_currentContext = context;
-        s_currentStream = stream;
-
-        rasta_lib_configuration_t rc;
-
-        auto onHandshakeCompleted = [](struct rasta_notification_result *result) {
-            (void)result;
-            s_handshake_condition.notify_one();
-        };
-
-        auto onReceive = [](struct rasta_notification_result *result) {
-            static std::mutex s_busy_writing;
-            std::lock_guard<std::mutex> guard(s_busy_writing);
-            rastaApplicationMessage p;
-            p = sr_get_received_data(result->handle, &result->connection);
-
-            sci::SciPacket outPacket;
-            outPacket.set_message(p.appMessage.bytes, p.appMessage.length);
-            s_currentStream->Write(outPacket);
-        };
-
-        auto onConnectionStateChange = [](struct rasta_notification_result *result) {
-            if (result->connection.current_state ==  RASTA_CONNECTION_CLOSED) {
-                s_currentContext->TryCancel();
-            }
-        };
-
-        rasta_lib_init_configuration(rc, "rasta.cfg");
-        rc->h.user_handles->on_connection_start = on_con_start;
-        rc->h.user_handles->on_disconnect = on_con_end;
-
-        rc->h.notifications.on_connection_state_change = onConnectionStateChange;
-        rc->h.notifications.on_receive = onReceive;
-        rc->h.notifications.on_handshake_complete = onHandshakeCompleted;
-
-        unsigned long localId = std::stoul(_rasta_local_id);
-        unsigned long targetId = std::stoul(_rasta_target_id);
-
-        auto handshakeTimeout = 0ms;
-        if (localId < targetId) {
-            // This is a client, initiate handshake
-            struct RastaIPData toServer[2];
-            strcpy(toServer[0].ip, _rasta_channel1_address.c_str());
-            toServer[0].port = std::stoi(_rasta_channel1_port);
-            strcpy(toServer[1].ip, _rasta_channel2_address.c_str());
-            toServer[1].port = std::stoi(_rasta_channel2_port);
-            sr_connect(&rc->h, targetId, toServer);
-
-            handshakeTimeout = 1000ms;
-        }
-
-        fd_event fd_event;
-        memset(&fd_event, 0, sizeof(fd_event));
-        fd_event.callback = [](void* h) { sr_cleanup(reinterpret_cast<rasta_handle*>(h)); return 1; };
-        fd_event.carry_data = &rc->h;
-        fd_event.fd = STDIN_FILENO;
-        fd_event.enabled = 0;
-
-        enable_fd_event(&fd_event);
-        add_fd_event(&rc->rasta_lib_event_system, &fd_event, EV_READABLE);
-        rasta_lib_start(rc, 0);
-
-        std::unique_lock<std::mutex> handshake_complete(s_handshake_mutex);
-        if (handshakeTimeout > 0ms) {
-            auto waitResult = s_handshake_condition.wait_until(handshake_complete, std::chrono::system_clock::now() + handshakeTimeout);
-            if (waitResult == std::cv_status::timeout) {
-                for (struct rasta_connection* con = rc->h.first_con; con; con = con->linkedlist_next) {
-                    if (con->remote_id == targetId) {
-                        sr_disconnect(&rc->h, con);
-                        break;
-                    }
-                }
-                sr_cleanup(&rc->h);
+    enum class Event { Started, Read, Written, Wake, Timeout, Done, Finished, Count };
 
-                s_currentStream = nullptr;
-                s_currentContext = nullptr;
+    struct Tag {
+        BridgeStream* stream;
+        Event event;
+    };
 
-                return grpc::Status::CANCELLED;
-            }
-        } else {
-            s_handshake_condition.wait(handshake_complete);
+    BridgeStream(Bridge& bridge, grpc::CompletionQueue* cq) : _bridge(bridge), _cq(cq) {
+        for (int i = 0; i < static_cast<int>(Event::Count); i++) {
+            _tags[i].stream = this;
+            _tags[i].event = static_cast<Event>(i);
+        }
+    }
+
+    virtual ~BridgeStream() = default;
+
+    unsigned long RemoteId() const { return _remote_id; }
+
+    /**
+     * Queues a message from RaSTA for the gRPC peer. Called on the RaSTA thread
+     * @return false if the queue is full and the message was dropped
+     */
+    bool Push(const unsigned char* data, unsigned int length) {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_to_grpc.size() >= STREAM_QUEUE_CAPACITY) {
+            _dropped++;
+            return false;
         }
+        _to_grpc.emplace_back(reinterpret_cast<const char*>(data), length);
+        Wake();
+        return true;
+    }
 
-        sci::SciPacket message;
-        while (s_currentStream->Read(&message)) {
-            struct RastaByteArray msg;
-            allocateRastaByteArray(&msg, message.message().size());
-            rmemcpy(msg.bytes, message.message().c_str(), message.message().size());
+    /**
+     * Moves messages of the gRPC peer into the send queue of the connection, one data PDU worth of messages per
+     * sr_send_connection(), until the send queue is full. RaSTA calls on_writable once there is room again. Called on
+     * the RaSTA thread
+     */
+    void Drain(struct rasta_handle* h, struct rasta_connection* con) {
+        std::lock_guard<std::mutex> guard(_lock);
+        bool full = _to_rasta.size() >= STREAM_QUEUE_CAPACITY;
+
+        unsigned int max_packet = h->config.values.sending.max_packet;
+        _batch.resize(max_packet);
+        while (!_to_rasta.empty()) {
+            // the messages of one call fill one data PDU
+            unsigned int count = 0;
+            for (; count < max_packet && count < _to_rasta.size(); count++) {
+                std::string& bytes = _to_rasta[count];
+                _batch[count].bytes = reinterpret_cast<unsigned char*>(&bytes[0]);
+                _batch[count].length = bytes.size();
+            }
 
             struct RastaMessageData messageData;
-            allocateRastaMessageData(&messageData, 1);
-            messageData.data_array[0] = msg;
+            messageData.count = count;
+            messageData.data_array = _batch.data();
 
-            sr_send(&rc->h, targetId, messageData);
+            if (!sr_send_connection(h, con, messageData)) {
+                break;
+            }
+            _to_rasta.erase(_to_rasta.begin(), _to_rasta.begin() + count);
+        }
 
-            freeRastaMessageData(&messageData); // Also frees the byte array
+        if (full && _to_rasta.size() < STREAM_QUEUE_CAPACITY) {
+            // the stream stopped reading, there is room again
+            Wake();
         }
+    }
 
-        for (struct rasta_connection* con = rc->h.first_con; con; con = con->linkedlist_next) {
-            if (con->remote_id == targetId) {
-                sr_disconnect(&rc->h, con);
+    /**
+     * The RaSTA connection is up, messages of the gRPC peer can be sent now. Called on the RaSTA thread
+     */
+    void SetConnected() {
+        std::lock_guard<std::mutex> guard(_lock);
+        _connected = true;
+        Wake();
+    }
+
+    /**
+     * The RaSTA connection was closed, the stream ends. Called on the RaSTA thread
+     */
+    void Close() {
+        std::lock_guard<std::mutex> guard(_lock);
+        _closed = true;
+        Wake();
+    }
+
+    /**
+     * Handles a completed operation. Called on the thread of the completion queue
+     */
+    void Proceed(Event event, bool ok) {
+        switch (event) {
+            case Event::Started:
+                _pending--;
+                OnStarted(ok);
+                if (!_started) {
+                    break;
+                }
+                if (_finishing) {
+                    // the stream ended before the call was established
+                    if (_cancel_on_start) {
+                        Cancel();
+                    }
+                    TryFinish();
+                } else {
+                    StartRead();
+                    Flush();
+                }
+                break;
+            case Event::Read:
+                _pending--;
+                _reading = false;
+                if (ok) {
+                    OnRead();
+                    Queue();
+                    StartRead();
+                } else {
+                    // the peer is done writing or the call broke
+                    RequestFinish(grpc::Status::OK, false);
+                }
+                break;
+            case Event::Written:
+                _pending--;
+                _writing = false;
+                if (ok) {
+                    Flush();
+                } else {
+                    RequestFinish(grpc::Status::CANCELLED, true);
+                }
+                TryFinish();
+                break;
+            case Event::Wake: {
+                bool connected, closed;
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    _wake_pending = false;
+                    connected = _connected;
+                    closed = _closed;
+                }
+                if (closed) {
+                    RequestFinish(grpc::Status(grpc::StatusCode::UNAVAILABLE, "The RaSTA connection was closed"), true);
+                } else if (connected && !_connected_seen) {
+                    _connected_seen = true;
+                    _timeout_alarm.Cancel();
+                }
+                StartRead();
+                Flush();
                 break;
             }
+            case Event::Timeout:
+                _pending--;
+                if (!_connected_seen) {
+                    RequestFinish(grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, "The RaSTA handshake timed out"), true);
+                }
+                break;
+            case Event::Done:
+                _pending--;
+                OnDone();
+                break;
+            case Event::Finished:
+                _pending--;
+                _finished = true;
+                OnFinished();
+                break;
+            case Event::Count:
+                break;
         }
-        sr_cleanup(&rc->h);
 
-        s_currentStream = nullptr;
-        s_currentContext = nullptr;
+        MaybeDelete();
+    }
 
-        return grpc::Status::OK;
+ protected:
+    void* GetTag(Event event) { return &_tags[static_cast<int>(event)]; }
+
+    /**
+     * The call was established, the stream is attached to its RaSTA connection with Attach()
+     */
+    virtual void OnStarted(bool ok) = 0;
+    virtual void OnDone() {}
+    virtual void OnRead() {}
+    virtual void OnFinished() {}
+    virtual void StartReadCall(sci::SciPacket* packet) = 0;
+    virtual void StartWriteCall(const sci::SciPacket& packet) = 0;
+    virtual void StartFinishCall(const grpc::Status& status) = 0;
+    virtual void Cancel() = 0;
+
+    /**
+     * Binds the stream to the connection to a remote entity, see Bridge::Attach()
+     */
+    bool Attach(unsigned long remote_id, bool initiate);
+
+    /**
+     * Waits for the handshake of a connection that is initiated by the bridge for at most HANDSHAKE_TIMEOUT
+     */
+    void StartHandshakeTimeout() {
+        _pending++;
+        _timeout_alarm.Set(_cq, std::chrono::system_clock::now() + HANDSHAKE_TIMEOUT, GetTag(Event::Timeout));
     }
 
-protected:
-    std::string _rasta_channel1_address;
-    std::string _rasta_channel1_port;
-    std::string _rasta_channel2_address;
-    std::string _rasta_channel2_port;
-    std::string _rasta_local_id;
-    std::string _rasta_target_id;
-};
+    /**
+     * Ends the stream and its RaSTA connection. The call is finished as soon as no write is in flight anymore
+     * @param status the status the call is finished with (only used on the server side)
+     * @param cancel if the operations in flight are cancelled
+     */
+    void RequestFinish(const grpc::Status& status, bool cancel);
+
+    void TryFinish() {
+        if (!_finishing || _finish_started || _writing || !_started) {
+            return;
+        }
+        _finish_started = true;
+        _pending++;
+        StartFinishCall(_status);
+    }
 
-struct RastaChannel {
-    unsigned long remote_id;
-    // The size of subchannels implicitly equals the number of local listen endpoints
-    RastaIPData *subchannels;
+    Bridge& _bridge;
+    grpc::CompletionQueue* _cq;
+    unsigned long _remote_id = 0;
+    // operations and alarms in flight except the wake alarm, the stream is deleted when there are none left
+    int _pending = 0;
+    bool _started = false;
+    bool _finishing = false;
+    bool _finished = false;
+    // if the peer accepts packets with a batch of messages
+    bool _batch_writes = false;
+
+ private:
+    // the calls must be guarded by _lock
+    void Wake() {
+        if (!_wake_pending) {
+            _wake_pending = true;
+            _wake_alarm.Set(_cq, std::chrono::system_clock::now(), GetTag(Event::Wake));
+        }
+    }
+
+    void StartRead() {
+        if (!_started || !_connected_seen || _finishing || _reading) {
+            return;
+        }
+        {
+            // Drain() wakes the stream up when there is room again, a batch may exceed the capacity
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_to_rasta.size() >= STREAM_QUEUE_CAPACITY) {
+                return;
+            }
+        }
+        _reading = true;
+        _pending++;
+        StartReadCall(&_in);
+    }
+
+    /**
+     * Queues the message or the batch of messages that was read for the event loop
+     */
+    void Queue();
+
+    // must be guarded by _lock
+    bool QueueMessage(std::string* bytes);
+
+    void Flush() {
+        if (!_started || _writing || _finishing) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_to_grpc.empty()) {
+                return;
+            }
+            if (_batch_writes) {
+                // the cleared strings of the last batch are reused
+                _out.clear_message();
+                _out.clear_messages();
+                for (int i = 0; i < BATCH_MAX_MESSAGES && !_to_grpc.empty(); i++) {
+                    _out.add_messages()->swap(_to_grpc.front());
+                    _to_grpc.pop_front();
+                }
+            } else {
+                _out.set_message(std::move(_to_grpc.front()));
+                _to_grpc.pop_front();
+            }
+        }
+        _writing = true;
+        _pending++;
+        StartWriteCall(_out);
+    }
+
+    void MaybeDelete() {
+        if (_pending > 0 || !(_finished || (!_started && _finishing))) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_wake_pending) {
+                return;
+            }
+            if (_dropped > 0) {
+                fprintf(stderr, "Dropped %lu messages from RaSTA ID %lu, the gRPC peer did not keep up\n",
+                        _dropped, _remote_id);
+            }
+        }
+        delete this;
+    }
+
+    Tag _tags[static_cast<int>(Event::Count)];
+    bool _attached = false;
+    bool _connected_seen = false;
+    bool _reading = false;
+    bool _writing = false;
+    bool _finish_started = false;
+    bool _cancel_on_start = false;
+    grpc::Status _status;
+
+    sci::SciPacket _in;
+    sci::SciPacket _out;
+
+    grpc::Alarm _wake_alarm;
+    grpc::Alarm _timeout_alarm;
+
+    // shared with the RaSTA thread
+    std::mutex _lock;
+    std::deque<std::string> _to_grpc;
+    std::deque<std::string> _to_rasta;
+    std::vector<struct RastaByteArray> _batch;
+    bool _wake_pending = false;
+    bool _connected = false;
+    bool _closed = false;
+    unsigned long _dropped = 0;
 };
 
-static int accept_event = -1;
-static struct rasta_connection accept_connection;
-void handle_handshake_complete(struct rasta_notification_result *result) {
-    memcpy(&accept_connection, &result->connection, sizeof(struct rasta_connection));
-    struct rasta_connection* r = &accept_connection;
-    uint64_t ignore = write(accept_event, &r, sizeof(struct rasta_connection*));
-    (void)ignore;
-}
+/**
+ * One RaSTA entity whose connections are bridged to gRPC streams. The event loop runs in its own thread, which is
+ * the only one that touches the connections. Other threads hand it work with Post()
+ */
+class Bridge {
+ public:
+    Bridge(const std::string& config, struct RastaIPData* channels, unsigned long default_remote_id)
+            : _default_remote_id(default_remote_id) {
+        memcpy(_channels, channels, sizeof(_channels));
+
+        s_bridge = this;
+        rasta_lib_init_shards(_shards, config.c_str(), 1);
+        _rc = rasta_lib_get_shard(_shards, default_remote_id);
+        _rc->h.user_handles->on_connection_start = on_con_start;
+        _rc->h.user_handles->on_disconnect = on_con_end;
+        _rc->h.notifications.on_receive = OnReceive;
+        _rc->h.notifications.on_handshake_complete = OnHandshakeComplete;
+        _rc->h.notifications.on_connection_state_change = OnConnectionStateChange;
+        _rc->h.notifications.on_writable = OnWritable;
+
+        event_system_enable_posting(&_rc->rasta_lib_event_system, COMMAND_QUEUE_SIZE);
+    }
+
+    unsigned long DefaultRemoteId() const { return _default_remote_id; }
+
+    struct rasta_handle* Handle() { return &_rc->h; }
 
-void handle_connection_state_change(struct rasta_notification_result *result) {
-    if (result->connection.current_state == RASTA_CONNECTION_CLOSED) {
-        if (accept_event != -1) {
-            uint64_t ignore = write(accept_event, (void*)-1, sizeof(struct rasta_connection*));
-            (void)ignore;
+    /**
+     * Opens a gRPC stream for every RaSTA connection whose handshake completes, instead of waiting for gRPC peers
+     */
+    void SetClient(sci::Rasta::Stub* stub, grpc::CompletionQueue* cq) {
+        _stub = stub;
+        _client_cq = cq;
+    }
+
+    /**
+     * Initiates the connection to the default remote entity whenever it is closed, if the local entity is the client
+     */
+    void KeepConnected() {
+        if (Handle()->config.values.general.rasta_id >= _default_remote_id) {
+            return;
         }
+        memset(&_reconnect_event, 0, sizeof(timed_event));
+        _reconnect_event.callback = Reconnect;
+        _reconnect_event.carry_data = this;
+        _reconnect_event.interval = RECONNECT_INTERVAL_NS;
+        enable_timed_event(&_reconnect_event);
+        add_timed_event(&_rc->rasta_lib_event_system, &_reconnect_event);
+
+        // the first connection is initiated as soon as the event loop runs
+        Post([this](struct rasta_handle*) { Reconnect(this); });
     }
-}
 
-void rasta_listen(rasta_lib_configuration_t rc, const char* config_file_path) {
-    rasta_lib_init_configuration(rc, config_file_path);
-    rc->h.user_handles->on_connection_start = on_con_start;
-    rc->h.user_handles->on_disconnect = on_con_end;
-
-    rc->h.notifications.on_handshake_complete = handle_handshake_complete;
-    rc->h.notifications.on_connection_state_change = handle_connection_state_change;
-    rc->h.notifications.on_receive =  [](struct rasta_notification_result *result) {
-        static std::mutex s_busy_writing;
-        std::lock_guard<std::mutex> guard(s_busy_writing);
-        rastaApplicationMessage p;
-        p = sr_get_received_data(result->handle, &result->connection);
-
-        std::lock_guard<std::mutex> streamGuard(s_busy);
-        if (s_currentStream != nullptr) {
-            sci::SciPacket outPacket;
-            outPacket.set_message(p.appMessage.bytes, p.appMessage.length);
-            s_currentStream->Write(outPacket);
+    void Start() {
+        rasta_lib_start_shards(_shards, 0, 0);
+    }
+
+    /**
+     * Runs work on the RaSTA thread
+     */
+    void Post(std::function<void(struct rasta_handle*)> command) {
+        Command* task = new Command{this, std::move(command)};
+        // the gRPC threads only wait here while the RaSTA thread works through a full queue
+        while (!event_system_post(&_rc->rasta_lib_event_system, RunCommand, task)) {
+            std::this_thread::yield();
         }
-    };
-}
+    }
 
-int rasta_accept(rasta_lib_configuration_t rc, struct RastaChannel *channel, struct rasta_connection *connection) {
-    struct rasta_connection * existing_connection = NULL;
-    for (struct rasta_connection* con = rc->h.first_con; con; con = con->linkedlist_next) {
-        if (con->remote_id == channel->remote_id) {
-            existing_connection = con;
-            break;
+    /**
+     * Lets the event loop pass the queued messages of the streams to RaSTA
+     */
+    void RequestDrain() {
+        if (!_drain_requested.exchange(true)) {
+            Post([this](struct rasta_handle* h) { Drain(h); });
         }
     }
 
-    if ((existing_connection == NULL || existing_connection->current_state == RASTA_CONNECTION_CLOSED)
-        && rc->h.config.values.general.rasta_id < channel->remote_id) {
-        // This is a client, initiate handshake
-        rc->h.ev_sys = &rc->rasta_lib_event_system;
-        sr_connect(&rc->h, channel->remote_id, channel->subchannels);
+    /**
+     * Binds a stream to the connection to a remote entity. The stream is told when the connection is up, the
+     * connection is initiated first if @p initiate is set and the local entity is the client
+     * @return false if another stream is bound to the remote entity already
+     */
+    bool Attach(BridgeStream* stream, bool initiate) {
+        unsigned long remote_id = stream->RemoteId();
+        {
+            std::lock_guard<std::mutex> guard(_streams_lock);
+            if (!_streams.emplace(remote_id, stream).second) {
+                return false;
+            }
+        }
+
+        Post([this, remote_id, initiate](struct rasta_handle* h) {
+            struct rasta_connection* con = find_connection(h, remote_id);
+            if (con != nullptr && con->current_state == RASTA_CONNECTION_UP) {
+                std::lock_guard<std::mutex> guard(_streams_lock);
+                auto it = _streams.find(remote_id);
+                if (it != _streams.end()) {
+                    it->second->SetConnected();
+                }
+            } else if (initiate && h->config.values.general.rasta_id < remote_id &&
+                       (con == nullptr || con->current_state == RASTA_CONNECTION_CLOSED)) {
+                sr_connect(h, remote_id, _channels);
+            }
+        });
+        return true;
     }
 
-    // Wait until a handshake has succeeded or the connection dropped to state RASTA_CONNECTION_CLOSED
-    accept_event = eventfd(0, 0);
-    fd_event fd_event;
-    memset(&fd_event, 0, sizeof(fd_event));
-    fd_event.callback = [](void*) { return 1; };
-    fd_event.carry_data = &rc->h;
-    fd_event.fd = accept_event;
-    fd_event.enabled = 0;
+    /**
+     * Unbinds a stream. The RaSTA connection stays up for the next stream to the remote entity: only the receiver
+     * of a DiscReq resets its redundancy channel, so the same pair of entities could not connect again
+     */
+    void Detach(BridgeStream* stream) {
+        std::lock_guard<std::mutex> guard(_streams_lock);
+        auto it = _streams.find(stream->RemoteId());
+        if (it != _streams.end() && it->second == stream) {
+            _streams.erase(it);
+        }
+    }
 
-    enable_fd_event(&fd_event);
+ private:
+    /**
+     * work that was posted to the RaSTA thread
+     */
+    struct Command {
+        Bridge* bridge;
+        std::function<void(struct rasta_handle*)> run;
+    };
 
-    add_fd_event(&rc->rasta_lib_event_system, &fd_event, EV_READABLE);
-    if (rc->h.config.values.general.rasta_id < channel->remote_id) {
-        // Wait for channel establishment indefinitely (server)
-        rasta_lib_start(rc, 0);
-    } else {
-        rasta_lib_start(rc, 2000);
+    static int RunCommand(void* carry_data) {
+        std::unique_ptr<Command> command(reinterpret_cast<Command*>(carry_data));
+        command->run(command->bridge->Handle());
+        return 0;
     }
-    remove_fd_event(&rc->rasta_lib_event_system, &fd_event);
 
-    existing_connection = NULL;
-    for (struct rasta_connection* con = rc->h.first_con; con; con = con->linkedlist_next) {
-        if (con->remote_id == channel->remote_id) {
-            existing_connection = con;
-            break;
+    void Drain(struct rasta_handle* h) {
+        _drain_requested = false;
+
+        std::lock_guard<std::mutex> guard(_streams_lock);
+        for (auto& entry : _streams) {
+            struct rasta_connection* con = find_connection(h, entry.first);
+            if (con != nullptr && con->current_state == RASTA_CONNECTION_UP) {
+                entry.second->Drain(h, con);
+            }
         }
     }
 
-    if (existing_connection != NULL &&
-            (existing_connection->current_state == RASTA_CONNECTION_START
-                || existing_connection->current_state == RASTA_CONNECTION_CLOSED)) {
-        // Connection request timeout
-        if (existing_connection->current_state == RASTA_CONNECTION_START) {
-            sr_disconnect(&rc->h, existing_connection);
+    /**
+     * The send queue of a connection has room again, the stream bound to it continues
+     */
+    static void OnWritable(struct rasta_notification_result* result) {
+        std::lock_guard<std::mutex> guard(s_bridge->_streams_lock);
+        auto it = s_bridge->_streams.find(result->con->remote_id);
+        if (it != s_bridge->_streams.end()) {
+            it->second->Drain(result->handle, result->con);
         }
-        return false;
     }
 
-    struct rasta_connection* result;
-    uint64_t ignore = read(accept_event, &result, sizeof(struct rasta_connection*));
-    (void)ignore;
-    if (result == &accept_connection) {
-        memcpy(connection, &accept_connection, sizeof(struct rasta_connection));
+    static int Reconnect(void* carry_data) {
+        Bridge* bridge = reinterpret_cast<Bridge*>(carry_data);
+        struct rasta_connection* con = find_connection(bridge->Handle(), bridge->_default_remote_id);
+        if (con == nullptr || con->current_state == RASTA_CONNECTION_CLOSED) {
+            sr_connect(bridge->Handle(), bridge->_default_remote_id, bridge->_channels);
+        }
+        return 0;
     }
-    close(accept_event);
-    accept_event = -1;
 
-    return result == &accept_connection;
-}
+    static void OnReceive(struct rasta_notification_result* result);
+    static void OnHandshakeComplete(struct rasta_notification_result* result);
+    static void OnConnectionStateChange(struct rasta_notification_result* result);
 
-void rastaServer(std::string config,
-                std::string rasta_channel1_address, std::string rasta_channel1_port,
-                std::string rasta_channel2_address, std::string rasta_channel2_port,
-                std::string rasta_local_id, std::string rasta_target_id, std::string grpc_server_address) {
-    (void)rasta_local_id;
-    static uint32_t s_remote_id = 0;
+    /**
+     * Opens a stream to the gRPC server for a remote entity, only in client mode
+     * @return true if the stream is bound to the remote entity
+     */
+    bool OpenClientStream(unsigned long remote_id);
 
-    static int s_terminator_fd;
-    static int s_data_fd;
+    static Bridge* s_bridge;
 
-    // Channels
-    struct RastaIPData toServer[2];
-    strcpy(toServer[0].ip, rasta_channel1_address.c_str());
-    toServer[0].port = std::stoi(rasta_channel1_port);
-    strcpy(toServer[1].ip, rasta_channel2_address.c_str());
-    toServer[1].port = std::stoi(rasta_channel2_port);
+    rasta_lib_shards_t _shards;
+    struct rasta_lib_configuration_s* _rc;
+    struct RastaIPData _channels[2];
+    unsigned long _default_remote_id;
 
-    struct RastaChannel channel;
-    channel.remote_id = s_remote_id = std::stoul(rasta_target_id);
-    channel.subchannels = toServer;
+    sci::Rasta::Stub* _stub = nullptr;
+    grpc::CompletionQueue* _client_cq = nullptr;
+    timed_event _reconnect_event;
+    std::atomic<bool> _drain_requested{false};
 
-    rasta_lib_configuration_t rc;
-    rasta_listen(rc, config.c_str());
+    std::mutex _streams_lock;
+    std::unordered_map<unsigned long, BridgeStream*> _streams;
+    unsigned long _unbound = 0;
+};
+
+Bridge* Bridge::s_bridge = nullptr;
+
+bool BridgeStream::Attach(unsigned long remote_id, bool initiate) {
+    _remote_id = remote_id;
+    _attached = _bridge.Attach(this, initiate);
+    return _attached;
+}
 
-    while (true)
+void BridgeStream::Queue() {
+    bool queued = false;
     {
-        struct rasta_connection new_connection;
-        if (rasta_accept(rc, &channel, &new_connection)) {
-            static std::mutex s_fifo_mutex;
-            static fifo_t *s_message_fifo = fifo_init(128);
-
-            // Data event
-            s_data_fd = eventfd(0, 0);
-            fd_event data_event;
-            memset(&data_event, 0, sizeof(fd_event));
-            data_event.callback = [](void* carry) {
-                rasta_handle *h = reinterpret_cast<rasta_handle*>(carry);
-                RastaByteArray *msg = nullptr;
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_in.messages_size() == 0) {
+            queued = QueueMessage(_in.mutable_message());
+        }
+        for (int i = 0; i < _in.messages_size(); i++) {
+            queued |= QueueMessage(_in.mutable_messages(i));
+        }
+    }
+    if (queued) {
+        _bridge.RequestDrain();
+    }
+}
 
-                {
-                    std::lock_guard<std::mutex> guard(s_fifo_mutex);
-                    msg = reinterpret_cast<RastaByteArray*>(fifo_pop(s_message_fifo));
-                }
+bool BridgeStream::QueueMessage(std::string* bytes) {
+    if (bytes->size() > MAX_APP_MSG_LEN) {
+        fprintf(stderr, "Dropped a message of %zu bytes for RaSTA ID %lu\n", bytes->size(), _remote_id);
+        return false;
+    }
+    _to_rasta.push_back(std::move(*bytes));
+    return true;
+}
 
-                if (msg != nullptr) {
-                    struct RastaMessageData messageData;
-                    allocateRastaMessageData(&messageData, 1);
-                    messageData.data_array[0] = *msg;
-                    rfree(msg);
+void BridgeStream::RequestFinish(const grpc::Status& status, bool cancel) {
+    if (_finishing) {
+        return;
+    }
+    _finishing = true;
+    _status = status;
+    if (_attached) {
+        _bridge.Detach(this);
+    }
+    _timeout_alarm.Cancel();
+    if (cancel) {
+        if (_started) {
+            Cancel();
+        } else {
+            _cancel_on_start = true;
+        }
+    }
+    TryFinish();
+}
 
-                    sr_send(h, s_remote_id, messageData);
+/**
+ * A stream of a gRPC peer that connects to the bridge. The peer selects the remote entity with the metadata
+ * "rasta-id", without it the stream is bound to the remote entity from the command line. Messages are written in
+ * batches if the peer sent the metadata "rasta-batch"
+ */
+class ServerStream final : public BridgeStream {
+ public:
+    ServerStream(Bridge& bridge, sci::Rasta::AsyncService* service, grpc::ServerCompletionQueue* cq)
+            : BridgeStream(bridge, cq), _service(service), _server_cq(cq), _stream(&_context) {
+        _context.AsyncNotifyWhenDone(GetTag(Event::Done));
+        _pending++;
+        _service->RequestStream(&_context, &_stream, cq, cq, GetTag(Event::Started));
+        _pending++;
+    }
 
-                    freeRastaMessageData(&messageData); // Also frees the byte array
-                }
+ protected:
+    void OnStarted(bool ok) override {
+        if (!ok) {
+            // the server shuts down
+            _finishing = true;
+            return;
+        }
+        _started = true;
 
-                return 0;
-            };
-            data_event.carry_data = &rc->h;
-            data_event.fd = s_data_fd;
-            enable_fd_event(&data_event);
-            add_fd_event(&rc->rasta_lib_event_system, &data_event, EV_READABLE);
-
-            // Terminator event
-            s_terminator_fd = eventfd(0, 0);
-            fd_event terminator_event;
-            memset(&terminator_event, 0, sizeof(fd_event));
-            terminator_event.callback = [](void* carry) {
-                rasta_handle *h = reinterpret_cast<rasta_handle*>(carry);
-                struct rasta_connection * existing_connection = NULL;
-                for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
-                    if (con->remote_id == s_remote_id) {
-                        existing_connection = con;
-                        break;
-                    }
-                }
-                if (existing_connection != NULL) {
-                    sr_disconnect(h, existing_connection);
-                }
-                return 1;
-            };
-            terminator_event.carry_data = &rc->h;
-            terminator_event.fd = s_terminator_fd;
-            enable_fd_event(&terminator_event);
-            add_fd_event(&rc->rasta_lib_event_system, &terminator_event, EV_READABLE);
-
-            std::thread grpc_thread([&]() {
-                printf("Creating gRPC connection to %s...\n", grpc_server_address.c_str());
-                auto channel = grpc::CreateChannel(grpc_server_address, grpc::InsecureChannelCredentials());
-                auto stub = sci::Rasta::NewStub(channel);
+        // the next peer is served by another stream
+        new ServerStream(_bridge, _service, _server_cq);
 
-                {
-                    // Establish gRPC connection
-                    std::lock_guard<std::mutex> guard(s_busy);
-                    s_currentContext = std::make_unique<grpc::ClientContext>();
-                    s_currentContext->AddMetadata("rasta-id", std::to_string(s_remote_id));
-                    s_currentStream = stub->Stream(s_currentContext.get());
-                }
+        unsigned long remote_id = _bridge.DefaultRemoteId();
+        auto metadata = _context.client_metadata().find("rasta-id");
+        if (metadata != _context.client_metadata().end()) {
+            remote_id = std::stoul(std::string(metadata->second.data(), metadata->second.length()));
+        }
 
-                sci::SciPacket message;
-                while (s_currentStream->Read(&message)) {
-                    struct RastaByteArray *msg = reinterpret_cast<RastaByteArray*>(rmalloc(sizeof(struct RastaByteArray)));
-                    allocateRastaByteArray(msg, message.message().size());
-                    rmemcpy(msg->bytes, message.message().c_str(), message.message().size());
+        if (_context.client_metadata().find("rasta-batch") != _context.client_metadata().end()) {
+            _batch_writes = true;
+            _context.AddInitialMetadata("rasta-batch", "1");
+        }
 
-                    {
-                        std::lock_guard<std::mutex> guard(s_fifo_mutex);
-                        fifo_push(s_message_fifo, msg);
-                    }
+        if (!Attach(remote_id, true)) {
+            RequestFinish(grpc::Status(grpc::StatusCode::ALREADY_EXISTS,
+                                       "Another stream is bound to RaSTA ID " + std::to_string(remote_id)), false);
+            return;
+        }
+        if (_bridge.Handle()->config.values.general.rasta_id < remote_id) {
+            StartHandshakeTimeout();
+        }
+    }
 
-                    uint64_t notify_data = 1;
-                    uint64_t ignore = write(s_data_fd, &notify_data, sizeof(uint64_t));
-                    (void)ignore;
-                }
+    void OnDone() override {
+        if (_context.IsCancelled()) {
+            RequestFinish(grpc::Status::CANCELLED, false);
+        }
+    }
 
-                {
-                    std::lock_guard<std::mutex> guard(s_busy);
-                    s_currentStream = nullptr;
-                    s_currentContext = nullptr;
-                }
+    void StartReadCall(sci::SciPacket* packet) override { _stream.Read(packet, GetTag(Event::Read)); }
+    void StartWriteCall(const sci::SciPacket& packet) override { _stream.Write(packet, GetTag(Event::Written)); }
+    void StartFinishCall(const grpc::Status& status) override { _stream.Finish(status, GetTag(Event::Finished)); }
+    void Cancel() override { _context.TryCancel(); }
+
+ private:
+    sci::Rasta::AsyncService* _service;
+    grpc::ServerCompletionQueue* _server_cq;
+    grpc::ServerContext _context;
+    grpc::ServerAsyncReaderWriter<sci::SciPacket, sci::SciPacket> _stream;
+};
 
-                uint64_t terminate = 1;
-                uint64_t ignore = write(s_terminator_fd, &terminate, sizeof(uint64_t));
-                (void)ignore;
-            });
+/**
+ * A stream that the bridge opens to a gRPC server for a RaSTA connection whose handshake completed. The remote
+ * entity is passed to the server with the metadata "rasta-id". Messages are written in batches once the initial
+ * metadata of the server contains "rasta-batch"
+ */
+class ClientStream final : public BridgeStream {
+ public:
+    ClientStream(Bridge& bridge, sci::Rasta::Stub* stub, grpc::CompletionQueue* cq, unsigned long remote_id)
+            : BridgeStream(bridge, cq) {
+        _context.AddMetadata("rasta-id", std::to_string(remote_id));
+        _context.AddMetadata("rasta-batch", "1");
+        _stream = stub->PrepareAsyncStream(&_context, cq);
+    }
 
-            rasta_lib_start(rc, 0);
+    /**
+     * Binds the stream and starts the call. Called on the RaSTA thread once the handshake completed
+     */
+    bool Open(unsigned long remote_id) {
+        if (!Attach(remote_id, false)) {
+            return false;
+        }
+        SetConnected();
+        _pending++;
+        _stream->StartCall(GetTag(Event::Started));
+        return true;
+    }
 
-            {
-                std::lock_guard<std::mutex> guard(s_busy);
-                if (s_currentContext) {
-                    s_currentContext->TryCancel();
-                }
-            }
+ protected:
+    void OnStarted(bool ok) override {
+        _started = true;
+        if (!ok) {
+            RequestFinish(grpc::Status::CANCELLED, false);
+        }
+    }
 
-            grpc_thread.join();
+    void OnRead() override {
+        // the initial metadata arrived with the first message at the latest
+        if (!_batch_writes) {
+            const auto& metadata = _context.GetServerInitialMetadata();
+            _batch_writes = metadata.find("rasta-batch") != metadata.end();
+        }
+    }
 
-            remove_fd_event(&rc->rasta_lib_event_system, &data_event);
-            remove_fd_event(&rc->rasta_lib_event_system, &terminator_event);
+    void OnFinished() override {
+        if (!_final_status.ok()) {
+            fprintf(stderr, "gRPC stream of RaSTA ID %lu ended: %s\n", _remote_id, _final_status.error_message().c_str());
+        }
+    }
 
-            close(s_data_fd);
-            close(s_terminator_fd);
+    void StartReadCall(sci::SciPacket* packet) override { _stream->Read(packet, GetTag(Event::Read)); }
+    void StartWriteCall(const sci::SciPacket& packet) override { _stream->Write(packet, GetTag(Event::Written)); }
+    void StartFinishCall(const grpc::Status&) override { _stream->Finish(&_final_status, GetTag(Event::Finished)); }
+    void Cancel() override { _context.TryCancel(); }
 
-            fifo_destroy(s_message_fifo);
+ private:
+    grpc::ClientContext _context;
+    std::unique_ptr<grpc::ClientAsyncReaderWriterInterface<sci::SciPacket, sci::SciPacket>> _stream;
+    grpc::Status _final_status;
+};
+
+void Bridge::OnReceive(struct rasta_notification_result* result) {
+    rastaApplicationMessage p = sr_get_received_data(result->handle, result->con);
+
+    // a client opens a new stream if the last one to the remote entity has ended
+    for (int attempt = 0; attempt < 2; attempt++) {
+        {
+            std::lock_guard<std::mutex> guard(s_bridge->_streams_lock);
+            auto it = s_bridge->_streams.find(p.id);
+            if (it != s_bridge->_streams.end()) {
+                it->second->Push(p.appMessage.bytes, p.appMessage.length);
+                break;
+            }
+        }
+        if (attempt == 0 && s_bridge->OpenClientStream(p.id)) {
+            continue;
+        }
+        if (s_bridge->_unbound++ == 0) {
+            fprintf(stderr, "Dropping messages from RaSTA ID %lu, no gRPC stream is bound to it\n", p.id);
         }
+        break;
     }
 
-    sr_cleanup(&rc->h);
+    freeRastaByteArray(&p.appMessage);
+}
+
+void Bridge::OnHandshakeComplete(struct rasta_notification_result* result) {
+    unsigned long remote_id = result->con->remote_id;
+    {
+        std::lock_guard<std::mutex> guard(s_bridge->_streams_lock);
+        auto it = s_bridge->_streams.find(remote_id);
+        if (it != s_bridge->_streams.end()) {
+            it->second->SetConnected();
+            return;
+        }
+    }
 
-    // Give the remote the chance to notice the possibly broken connection
-    usleep(1000);
+    s_bridge->OpenClientStream(remote_id);
+}
+
+bool Bridge::OpenClientStream(unsigned long remote_id) {
+    if (_stub == nullptr) {
+        return false;
+    }
+    printf("Opening a gRPC stream for RaSTA ID %lu...\n", remote_id);
+    ClientStream* stream = new ClientStream(*this, _stub, _client_cq, remote_id);
+    if (!stream->Open(remote_id)) {
+        delete stream;
+        return false;
+    }
+    return true;
+}
+
+void Bridge::OnConnectionStateChange(struct rasta_notification_result* result) {
+    if (result->con->current_state != RASTA_CONNECTION_CLOSED) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(s_bridge->_streams_lock);
+    auto it = s_bridge->_streams.find(result->con->remote_id);
+    if (it != s_bridge->_streams.end()) {
+        it->second->Close();
+    }
+}
+
+/**
+ * Handles the completed operations of all streams, one stream is never handled by two threads at once
+ */
+static void run_completion_queue(grpc::CompletionQueue* cq) {
+    void* tag;
+    bool ok;
+    while (cq->Next(&tag, &ok)) {
+        BridgeStream::Tag* streamTag = static_cast<BridgeStream::Tag*>(tag);
+        streamTag->stream->Proceed(streamTag->event, ok);
+    }
 }
 
 int main(int argc, char * argv[]) {
@@ -467,11 +875,18 @@ int main(int argc, char * argv[]) {
         grpc_server_address = std::string(argv[9]);
     }
 
+    // Channels
+    struct RastaIPData toServer[2];
+    strcpy(toServer[0].ip, rasta_channel1_address.c_str());
+    toServer[0].port = std::stoi(rasta_channel1_port);
+    strcpy(toServer[1].ip, rasta_channel2_address.c_str());
+    toServer[1].port = std::stoi(rasta_channel2_port);
+
+    Bridge bridge(config, toServer, std::stoul(rasta_target_id));
+
     if (grpc_server_address.length() == 0) {
-        // Start a gRPC server and wait for incoming connection before doing anything RaSTA
-        RastaService svc(rasta_channel1_address, rasta_channel1_port,
-                            rasta_channel2_address, rasta_channel2_port,
-                            rasta_local_id, rasta_target_id);
+        // Start a gRPC server, every stream of a peer is bound to a RaSTA connection
+        sci::Rasta::AsyncService svc;
 
         grpc::EnableDefaultHealthCheckService(true);
         grpc::reflection::InitProtoReflectionServerBuilderPlugin();
@@ -479,21 +894,30 @@ int main(int argc, char * argv[]) {
         // Listen on the given address without any authentication mechanism.
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
         // Register "service" as the instance through which we'll communicate with
-        // clients. In this case it corresponds to an *synchronous* service.
+        // clients. In this case it corresponds to an *asynchronous* service.
         builder.RegisterService(&svc);
+        std::unique_ptr<grpc::ServerCompletionQueue> cq = builder.AddCompletionQueue();
         // Finally assemble the server.
         std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
         std::cout << "Server listening on " << server_address << std::endl;
 
-        // Wait for the server to shutdown. Note that some other thread must be
-        // responsible for shutting down the server for this call to ever return.
-        server->Wait();
+        bridge.Start();
+
+        // the first stream waits for a peer, every stream that starts creates the next one
+        new ServerStream(bridge, &svc, cq.get());
+        run_completion_queue(cq.get());
     } else {
-        // Establish a RaSTA connection and connect to gRPC server afterwards
-        rastaServer(config,
-                        rasta_channel1_address, rasta_channel1_port,
-                        rasta_channel2_address, rasta_channel2_port,
-                        rasta_local_id, rasta_target_id, grpc_server_address);
+        // Establish RaSTA connections and open a stream to the gRPC server for each of them
+        printf("Creating gRPC connection to %s...\n", grpc_server_address.c_str());
+        auto channel = grpc::CreateChannel(grpc_server_address, grpc::InsecureChannelCredentials());
+        auto stub = sci::Rasta::NewStub(channel);
+        grpc::CompletionQueue cq;
+
+        bridge.SetClient(stub.get(), &cq);
+        bridge.KeepConnected();
+        bridge.Start();
+
+        run_completion_queue(&cq);
     }
     return 0;
 }
@@ -23,12 +23,12 @@ void printHelpAndExit(void){
 }
 
 void onReceive(struct rasta_notification_result *result){
-    rastaApplicationMessage message = sr_get_received_data(result->handle, &result->connection);
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
     scip_on_rasta_receive(scip, message);
 }
 
 void onHandshakeComplete(struct rasta_notification_result *result){
-    if (result->connection.my_id == ID_C){
+    if (result->con->my_id == ID_C){
 
         printf("Sending change location command...\n");
         sci_return_code code = scip_send_change_location(scip, SCI_NAME_S, POINT_LOCATION_CHANGE_TO_RIGHT);
@@ -1,77 +1,176 @@
 #include <stdio.h>
+#include <pthread.h>
 #include <jni.h>
 #include "RastaNative.h"
 #include <rasta_new.h>
 #include <rmemory.h>
 #include <rastaredundancy_new.h>
 
+/**
+ * length of the header of a message in the receive buffer: the sender id (8 bytes) and the length of the message
+ * (4 bytes), both big endian like the default order of a java.nio.ByteBuffer
+ */
+#define RECEIVE_RECORD_HEADER 12
+
 struct rasta_handle * handle;
 static JavaVM * javaVM;
 jobject global_obj;
 
-void onReceive(struct rasta_notification_result *result){
+/**
+ * the methods of librasta.RastaNative, resolved once in librasta_init because FindClass on a callback thread only
+ * sees the system class loader
+ */
+static jmethodID mid_on_receive;
+static jmethodID mid_on_receive_batch;
+static jmethodID mid_on_disconnection;
+static jmethodID mid_on_new_connection;
+static jclass string_class;
+
+/**
+ * the direct ByteBuffer set with librasta_setReceiveBuffer, the messages of a batch are written in here
+ */
+static jobject receive_buffer;
+static unsigned char * receive_buffer_address;
+static jlong receive_buffer_capacity;
+
+/**
+ * the callback threads stay attached to the JVM, they are detached when they exit
+ */
+static pthread_key_t env_key;
+static pthread_once_t env_key_once = PTHREAD_ONCE_INIT;
+static __thread JNIEnv * callback_env;
+
+static void detach_thread(void * env) {
+    (void) env;
+    (*javaVM)->DetachCurrentThread(javaVM);
+}
 
-    JNIEnv *env;
-    (*javaVM)->AttachCurrentThread(javaVM, &env, NULL);
+static void create_env_key() {
+    pthread_key_create(&env_key, detach_thread);
+}
 
-    jclass cls = (*env)->FindClass(env, "librasta/RastaNative");
-    jmethodID mid = (*env)->GetMethodID(env, cls, "librasta_onReceive", "(J[B)V");
+/**
+ * @return the environment of the calling thread, the thread is attached to the JVM on the first call
+ */
+static JNIEnv * get_env() {
+    if (callback_env == NULL) {
+        if ((*javaVM)->GetEnv(javaVM, (void **) &callback_env, JNI_VERSION_1_6) == JNI_EDETACHED) {
+            (*javaVM)->AttachCurrentThreadAsDaemon(javaVM, (void **) &callback_env, NULL);
+            // only threads attached here are detached
+            pthread_once(&env_key_once, create_env_key);
+            pthread_setspecific(env_key, callback_env);
+        }
+    }
+    return callback_env;
+}
 
+static jmethodID resolve_method(JNIEnv * env, jclass cls, const char * name, const char * signature) {
+    jmethodID mid = (*env)->GetMethodID(env, cls, name, signature);
     if (mid == 0){
         printf("CALLBACK NOT FOUND!\n");
+        (*env)->ExceptionClear(env);
     }
+    return mid;
+}
+
+static void write_big_endian(unsigned char * out, unsigned long long value, int length) {
+    for (int i = length - 1; i >= 0; --i) {
+        out[i] = (unsigned char) value;
+        value >>= 8;
+    }
+}
 
-    rastaApplicationMessage message = sr_get_received_data(result->handle, &result->connection);
+/**
+ * delivers a message in a new byte[], used if no receive buffer is set or the message does not fit into it
+ */
+static void deliver_array(JNIEnv * env, rastaApplicationMessage * message) {
+    if (mid_on_receive == 0) {
+        return;
+    }
+    jbyteArray array = (*env)->NewByteArray(env, message->appMessage.length);
+    (*env)->SetByteArrayRegion(env, array, 0, message->appMessage.length, (jbyte *)message->appMessage.bytes);
 
-    jbyteArray array = (*env)->NewByteArray(env, message.appMessage.length);
-    (*env)->SetByteArrayRegion(env, array, 0, message.appMessage.length, (jbyte *)message.appMessage.bytes);
+    (*env)->CallVoidMethod(env, global_obj, mid_on_receive, (jlong) message->id, array);
+    (*env)->DeleteLocalRef(env, array);
+}
 
-    (*env)->CallVoidMethod(env, global_obj, mid, message.id, array);
+/**
+ * passes the messages in the receive buffer to Java. The callback reads them before it returns, so the next batch
+ * starts at the beginning of the buffer again
+ */
+static void deliver_batch(JNIEnv * env, jint count, jint length) {
+    if (count > 0) {
+        (*env)->CallVoidMethod(env, global_obj, mid_on_receive_batch, count, length);
+    }
 }
 
-void onDisconnection(struct rasta_notification_result *result, unsigned short reason, unsigned short details){
-    JNIEnv *env;
-    (*javaVM)->AttachCurrentThread(javaVM, &env, NULL);
+void onReceive(struct rasta_notification_result *result){
+    JNIEnv *env = get_env();
+
+    jint count = 0;
+    jlong length = 0;
+
+    // all messages that wait on the connection are delivered in one batch
+    while (fifo_get_size(result->con->fifo_app_msg) > 0) {
+        rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
+        jlong record_length = RECEIVE_RECORD_HEADER + message.appMessage.length;
+
+        if (receive_buffer_address == NULL || mid_on_receive_batch == 0 || record_length > receive_buffer_capacity) {
+            deliver_batch(env, count, (jint) length);
+            count = 0;
+            length = 0;
+            deliver_array(env, &message);
+        } else {
+            if (length + record_length > receive_buffer_capacity) {
+                deliver_batch(env, count, (jint) length);
+                count = 0;
+                length = 0;
+            }
+            unsigned char * record = receive_buffer_address + length;
+            write_big_endian(record, message.id, 8);
+            write_big_endian(record + 8, message.appMessage.length, 4);
+            rmemcpy(record + RECEIVE_RECORD_HEADER, message.appMessage.bytes, message.appMessage.length);
+            count++;
+            length += record_length;
+        }
+
+        freeRastaByteArray(&message.appMessage);
+    }
 
-    jclass cls = (*env)->FindClass(env, "librasta/RastaNative");
-    jmethodID mid = (*env)->GetMethodID(env, cls, "librasta_onDisconnection", "(JSS)V");
+    deliver_batch(env, count, (jint) length);
+}
 
-    if (mid == 0){
-        printf("CALLBACK NOT FOUND!\n");
+void onDisconnection(struct rasta_notification_result *result, unsigned short reason, unsigned short details){
+    JNIEnv *env = get_env();
+
+    if (mid_on_disconnection == 0){
+        return;
     }
 
-    (*env)->CallVoidMethod(env, global_obj, mid, (long)result->connection.remote_id, reason, details);
+    (*env)->CallVoidMethod(env, global_obj, mid_on_disconnection, (jlong)result->con->remote_id, reason, details);
 }
 
 void onTimeout(struct rasta_notification_result *result){
-    JNIEnv *env;
-    (*javaVM)->AttachCurrentThread(javaVM, &env, NULL);
-
-    jclass cls = (*env)->FindClass(env, "librasta/RastaNative");
-    jmethodID mid = (*env)->GetMethodID(env, cls, "librasta_onDisconnection", "(JSS)V");
+    JNIEnv *env = get_env();
 
-    if (mid == 0){
-        printf("CALLBACK NOT FOUND!\n");
+    if (mid_on_disconnection == 0){
+        return;
     }
 
-    (*env)->CallVoidMethod(env, global_obj, mid, (long)result->connection.remote_id, 0xFF, 0xFF);
+    (*env)->CallVoidMethod(env, global_obj, mid_on_disconnection, (jlong)result->con->remote_id, 0xFF, 0xFF);
 }
 
 void onNewConnection(struct rasta_notification_result *result){
-    JNIEnv *env;
-    (*javaVM)->AttachCurrentThread(javaVM, &env, NULL);
-
-    jclass cls = (*env)->FindClass(env, "librasta/RastaNative");
-    jmethodID mid = (*env)->GetMethodID(env, cls, "librasta_onNewConnection", "(J[Ljava/lang/String;[I)V");
+    JNIEnv *env = get_env();
 
-    if (mid == 0){
-        printf("CALLBACK NOT FOUND!\n");
+    if (mid_on_new_connection == 0){
+        return;
     }
-    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&result->handle->mux, result->connection.remote_id);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&result->handle->mux, result->con->remote_id);
 
     jobjectArray ip_array = 0;
     jintArray port_array = (*env)->NewIntArray(env, channel->connected_channel_count);
-    ip_array = (*env)->NewObjectArray(env, channel->connected_channel_count, (*env)->FindClass(env,"java/lang/String"),0);
+    ip_array = (*env)->NewObjectArray(env, channel->connected_channel_count, string_class, 0);
 
 
 
@@ -82,11 +181,16 @@ void onNewConnection(struct rasta_notification_result *result){
         printf("Channel %d: %s:%d\n", i, channel->connected_channels[i].ip_address, channel->connected_channels[i].port);
         jstring str = (*env)->NewStringUTF(env, channel->connected_channels[i].ip_address);
         (*env)->SetObjectArrayElement(env, ip_array, i, str);
+        (*env)->DeleteLocalRef(env, str);
     }
 
     (*env)->SetIntArrayRegion(env, port_array, 0, channel->transport_channel_count, ports);
 
-    (*env)->CallVoidMethod(env, global_obj, mid, result->connection.remote_id, ip_array, port_array);
+    (*env)->CallVoidMethod(env, global_obj, mid_on_new_connection, (jlong) result->con->remote_id, ip_array, port_array);
+
+    // the thread never returns to Java, so the local references are not freed otherwise
+    (*env)->DeleteLocalRef(env, ip_array);
+    (*env)->DeleteLocalRef(env, port_array);
 }
 
 
@@ -97,10 +201,20 @@ JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1init
 
         const char * nativeFile = (*env)->GetStringUTFChars(env, configFile, 0);
   		sr_init_handle(handle, nativeFile);
+        (*env)->ReleaseStringUTFChars(env, configFile, nativeFile);
 
         global_obj = (*env)->NewGlobalRef(env, obj);
         (*env)->GetJavaVM(env, &javaVM);
 
+        jclass cls = (*env)->GetObjectClass(env, obj);
+        mid_on_receive = resolve_method(env, cls, "librasta_onReceive", "(J[B)V");
+        mid_on_receive_batch = resolve_method(env, cls, "librasta_onReceiveBatch", "(II)V");
+        mid_on_disconnection = resolve_method(env, cls, "librasta_onDisconnection", "(JSS)V");
+        mid_on_new_connection = resolve_method(env, cls, "librasta_onNewConnection", "(J[Ljava/lang/String;[I)V");
+
+        jclass string_cls = (*env)->FindClass(env, "java/lang/String");
+        string_class = (*env)->NewGlobalRef(env, string_cls);
+
   		handle->notifications.on_receive = onReceive;
   		handle->notifications.on_disconnection_request_received = onDisconnection;
   		handle->notifications.on_handshake_complete = onNewConnection;
@@ -120,6 +234,7 @@ JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1send
         struct RastaByteArray array;
         allocateRastaByteArray(&array, (unsigned int)dataLen);
         rmemcpy(array.bytes, dataArray, (unsigned int)dataLen);
+        (*env)->ReleaseByteArrayElements(env, data, (jbyte *) dataArray, JNI_ABORT);
 
         dataToSend.data_array[0] = array;
 
@@ -128,6 +243,49 @@ JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1send
   		freeRastaMessageData(&dataToSend);
   }
 
+JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1sendDirect
+  (JNIEnv * env, jobject obj, jlong receiverId, jobject data, jint length){
+        unsigned char * address = (*env)->GetDirectBufferAddress(env, data);
+        if (address == NULL || length < 0 || length > (*env)->GetDirectBufferCapacity(env, data)) {
+            printf("librasta_sendDirect needs a direct ByteBuffer\n");
+            return;
+        }
+
+        // sr_send copies the message into the send queue, so it is passed without a copy
+        struct RastaByteArray array;
+        array.bytes = address;
+        array.length = (unsigned int) length;
+
+        struct RastaMessageData dataToSend;
+        dataToSend.count = 1;
+        dataToSend.data_array = &array;
+
+  		sr_send(handle, (unsigned long)receiverId, dataToSend);
+  }
+
+JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1setReceiveBuffer
+  (JNIEnv * env, jobject obj, jobject buffer){
+        if (receive_buffer != NULL) {
+            (*env)->DeleteGlobalRef(env, receive_buffer);
+            receive_buffer = NULL;
+            receive_buffer_address = NULL;
+            receive_buffer_capacity = 0;
+        }
+        if (buffer == NULL) {
+            return;
+        }
+
+        unsigned char * address = (*env)->GetDirectBufferAddress(env, buffer);
+        if (address == NULL) {
+            printf("librasta_setReceiveBuffer needs a direct ByteBuffer\n");
+            return;
+        }
+        // the global reference keeps the memory of the buffer alive
+        receive_buffer = (*env)->NewGlobalRef(env, buffer);
+        receive_buffer_capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+        receive_buffer_address = address;
+  }
+
 
 JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1disconnectFrom
   (JNIEnv * env, jobject obj, jlong id, jint reason, jlong details){
@@ -138,5 +296,11 @@ JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1cleanup
   (JNIEnv * env, jobject obj){
         sr_cleanup(handle);
         rfree(handle);
+        if (receive_buffer != NULL) {
+            (*env)->DeleteGlobalRef(env, receive_buffer);
+            receive_buffer = NULL;
+            receive_buffer_address = NULL;
+        }
+        (*env)->DeleteGlobalRef(env, string_class);
         (*env)->DeleteGlobalRef(env, global_obj);
   }
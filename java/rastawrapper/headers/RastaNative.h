@@ -23,6 +23,22 @@ JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1init
 JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1send
   (JNIEnv *, jobject, jlong, jbyteArray);
 
+/*
+ * Class:     librasta_RastaNative
+ * Method:    librasta_sendDirect
+ * Signature: (JLjava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1sendDirect
+  (JNIEnv *, jobject, jlong, jobject, jint);
+
+/*
+ * Class:     librasta_RastaNative
+ * Method:    librasta_setReceiveBuffer
+ * Signature: (Ljava/nio/ByteBuffer;)V
+ */
+JNIEXPORT void JNICALL Java_librasta_RastaNative_librasta_1setReceiveBuffer
+  (JNIEnv *, jobject, jobject);
+
 /*
  * Class:     librasta_RastaNative
  * Method:    librasta_disconnectFrom
@@ -36,7 +36,7 @@ void printHelpAndExit(void){
 }
 
 void onReceive(struct rasta_notification_result *result){
-    rastaApplicationMessage message = sr_get_received_data(result->handle, &result->connection);
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
 
     if (mode == MODE_SCILS){
         scils_on_rasta_receive(scils, message);
@@ -46,7 +46,7 @@ void onReceive(struct rasta_notification_result *result){
 }
 
 void onConnectionStateChange(struct rasta_notification_result *result){
-    if (result->connection.current_state == RASTA_CONNECTION_UP){
+    if (result->con->current_state == RASTA_CONNECTION_UP){
         printf("Connection established! Sending message to let the server know my SCI name\n");
 
         sci_return_code code;
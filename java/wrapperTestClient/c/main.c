@@ -26,9 +26,9 @@ void addRastaString(struct RastaMessageData * data, int pos, char * str) {
 }
 
 void onConnectionStateChange(struct rasta_notification_result *result) {
-    printf("\n Connectionstate change (remote: %lu)", result->connection.remote_id);
+    printf("\n Connectionstate change (remote: %lu)", result->con->remote_id);
 
-    switch (result->connection.current_state) {
+    switch (result->con->current_state) {
         case RASTA_CONNECTION_CLOSED:
             printf("\nCONNECTION_CLOSED \n\n");
             break;
@@ -41,7 +41,7 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
         case RASTA_CONNECTION_UP:
             printf("\nCONNECTION_UP \n\n");
             //send data to server
-            if (result->connection.my_id == ID_S1) {
+            if (result->con->my_id == ID_S1) {
                 struct RastaMessageData messageData1;
                 allocateRastaMessageData(&messageData1, 1);
 
@@ -68,9 +68,9 @@ void onConnectionStateChange(struct rasta_notification_result *result) {
 void onReceive(struct rasta_notification_result *result) {
     rastaApplicationMessage p;
 
-    printf("\nReceived data from %lu\n", result->connection.remote_id);
+    printf("\nReceived data from %lu\n", result->con->remote_id);
 
-    p = sr_get_received_data(result->handle,&result->connection);
+    p = sr_get_received_data(result->handle,result->con);
 
     printf("\nPacket is from %lu\n", p.id);
     printf("\nMsg: %s\n", p.appMessage.bytes);
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <rmemory.h>
 #include <ifaddrs.h>
 #include <sys/types.h>
@@ -15,9 +16,19 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "config.h"
+#include "rastaflightrecorder.h"
 #include <inttypes.h>
 
+/**
+ * logs an error of the config and counts it, a config with errors cannot be written as a snapshot
+ */
+#define config_error(cfg, ...) \
+    ((cfg)->errors++, logger_log(&(cfg)->logger, LOG_LEVEL_ERROR, (cfg)->filename, __VA_ARGS__))
+
 struct LineParser {
     char buf[CONFIG_BUFFER_LENGTH];
     unsigned int pos;
@@ -67,7 +78,7 @@ int parser_next(struct LineParser *p) {
 void parser_skipBlanc(struct LineParser* p) {
     while (p->current == ' ' || p->current == '\t') {
         if (!parser_next(p)) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Reached unexpected end of line", p->line);
+            config_error(p->cfg, "Error in line %d: Reached unexpected end of line", p->line);
             return;
         }
     }
@@ -83,7 +94,7 @@ void parser_parseIdentifier(struct LineParser *p, char* identifier) {
     int i = 0;
     while (isdigit(p->current) || isalpha(p->current) || (p->current == '_')) {
         if (i >= MAX_DICTIONARY_STRING_LENGTH_BYTES - 1) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Identifiers is too long", p->line);
+            config_error(p->cfg, "Error in line %d: Identifiers is too long", p->line);
             return;
         }
         if (isalpha(p->current)) {
@@ -111,7 +122,7 @@ int parser_parseNumber(struct LineParser *p, int *number) {
         parser_next(p);
     }
     if (!isdigit(p->current)) {
-        logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Expected a digit after '-'", p->line);
+        config_error(p->cfg, "Error in line %d: Expected a digit after '-'", p->line);
         return 0;
     }
 
@@ -119,7 +130,7 @@ int parser_parseNumber(struct LineParser *p, int *number) {
     int i = 0;
     while (isdigit(p->current)) {
         if (i >= 100) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Number is too long", p->line);
+            config_error(p->cfg, "Error in line %d: Number is too long", p->line);
             return 0;
         }
         num_buf[i] = p->current;
@@ -148,13 +159,13 @@ int parser_parseString(struct LineParser *p, char *string) {
 
     while (p->current != '"') {
         if (i >= MAX_DICTIONARY_STRING_LENGTH_BYTES - 1) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: String is too long", p->line);
+            config_error(p->cfg, "Error in line %d: String is too long", p->line);
             return 0;
         }
         string[i] = p->current;
 
         if (!parser_next(p)) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Missing closing '\"'", p->line);
+            config_error(p->cfg, "Error in line %d: Missing closing '\"'", p->line);
             return 0;
         }
         i++;
@@ -180,7 +191,7 @@ int parser_parseHex(struct LineParser *p, int *hex) {
 
     while (isdigit(c) || c == 'a' || c == 'b' || c == 'c' || c == 'd' || c == 'e' || c == 'f') {
         if (i >= 100) {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Hex is too long", p->line);
+            config_error(p->cfg, "Error in line %d: Hex is too long", p->line);
             return 0;
         }
         num_buf[i] = c;
@@ -219,7 +230,7 @@ int parser_parseArray(struct LineParser *p, struct DictionaryArray * array) {
         }
 
         if (p->current != '"') {
-            logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Expected '\"' but found %c", p->line, p->current);
+            config_error(p->cfg, "Error in line %d: Expected '\"' but found %c", p->line, p->current);
             return 0;
         }
 
@@ -242,7 +253,7 @@ int parser_parseArray(struct LineParser *p, struct DictionaryArray * array) {
         else {
             if (p->current == '}') break;
             else {
-                logger_log(&p->cfg->logger,LOG_LEVEL_ERROR, p->cfg->filename, "Error in line %d: Expected ';' or '}'", p->line);
+                config_error(p->cfg, "Error in line %d: Expected ';' or '}'", p->line);
                 return 0;
             }
         }
@@ -392,6 +403,89 @@ char* getIpByNic(int index){
     return ip;
 }
 
+/**
+ * accepts a string like loss=1,duplicate=0.5,reorder=2,reorder_us=1000,delay_us=3000,jitter_us=500 and returns the
+ * impairment, values that are not in the string are 0
+ * @param data the string
+ * @param impairment the impairment is written in here
+ * @return 1 if the format is correct, 0 otherwise
+ */
+static int extractImpairment(const char * data, struct RastaConfigImpairment * impairment) {
+    rmemset(impairment, 0, sizeof(struct RastaConfigImpairment));
+
+    const char * pos = data;
+    while (*pos != '\0') {
+        const char * value = strchr(pos, '=');
+        if (value == NULL) {
+            return 0;
+        }
+        size_t name_length = (size_t) (value - pos);
+        value++;
+
+        char * end;
+        double number = strtod(value, &end);
+        if (end == value || number < 0 || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+
+        if (name_length == 4 && strncmp(pos, "loss", 4) == 0) {
+            impairment->loss = number;
+        } else if (name_length == 9 && strncmp(pos, "duplicate", 9) == 0) {
+            impairment->duplicate = number;
+        } else if (name_length == 7 && strncmp(pos, "reorder", 7) == 0) {
+            impairment->reorder = number;
+        } else if (name_length == 10 && strncmp(pos, "reorder_us", 10) == 0) {
+            impairment->reorder_us = (unsigned int) number;
+        } else if (name_length == 8 && strncmp(pos, "delay_us", 8) == 0) {
+            impairment->delay_us = (unsigned int) number;
+        } else if (name_length == 9 && strncmp(pos, "jitter_us", 9) == 0) {
+            impairment->jitter_us = (unsigned int) number;
+        } else {
+            return 0;
+        }
+
+        pos = *end == ',' ? end + 1 : end;
+    }
+    return 1;
+}
+
+/**
+ * accepts a string like rcvbuf=4194304,sndbuf=1048576 and returns the record, missing sizes are 0
+ * @param data the string
+ * @param buffer the record
+ * @return 1 if the format is valid
+ */
+static int extractSocketBuffer(const char * data, struct RastaConfigSocketBuffer * buffer) {
+    rmemset(buffer, 0, sizeof(struct RastaConfigSocketBuffer));
+
+    const char * pos = data;
+    while (*pos != '\0') {
+        const char * value = strchr(pos, '=');
+        if (value == NULL) {
+            return 0;
+        }
+        size_t name_length = (size_t) (value - pos);
+        value++;
+
+        char * end;
+        unsigned long number = strtoul(value, &end, 10);
+        if (end == value || *value == '-' || number > INT_MAX || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+
+        if (name_length == 6 && strncmp(pos, "rcvbuf", 6) == 0) {
+            buffer->receive = (unsigned int) number;
+        } else if (name_length == 6 && strncmp(pos, "sndbuf", 6) == 0) {
+            buffer->send = (unsigned int) number;
+        } else {
+            return 0;
+        }
+
+        pos = *end == ',' ? end + 1 : end;
+    }
+    return 1;
+}
+
 /**
  * accepts a string like 192.168.2.1:80 and returns the record
  * @param data
@@ -523,7 +617,7 @@ void config_setstd(struct RastaConfig * cfg) {
         }
         else {
             //set std
-            logger_log(&cfg->logger,LOG_LEVEL_ERROR, cfg->filename, "RASTA_MD4_TYPE or RASTA_SR_CHECKSUM_LEN  may only be NONE, HALF or FULL");
+            config_error(cfg, "RASTA_MD4_TYPE or RASTA_SR_CHECKSUM_LEN  may only be NONE, HALF or FULL");
             cfg->values.sending.md4_type = RASTA_CHECKSUM_8B;
         }
     }
@@ -639,6 +733,452 @@ void config_setstd(struct RastaConfig * cfg) {
         cfg->values.sending.diag_window = (unsigned int)entr.value.number;
     }
 
+    //receivebudget
+    entr = config_get(cfg, "RASTA_RECEIVE_BUDGET");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.receive_budget = 16;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.receive_budget = (unsigned int)entr.value.number;
+    }
+
+    //send budget
+    entr = config_get(cfg, "RASTA_SEND_BUDGET");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.send_budget = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.send_budget = (unsigned int)entr.value.number;
+    }
+
+    //receive backpressure
+    entr = config_get(cfg, "RASTA_RECEIVE_BACKPRESSURE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.sending.receive_backpressure = 1;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.receive_backpressure = (unsigned int)entr.value.number;
+    }
+
+    //sendrate
+    entr = config_get(cfg, "RASTA_SEND_RATE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.send_rate = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.send_rate = (unsigned int)entr.value.number;
+    }
+
+    //sendburst
+    entr = config_get(cfg, "RASTA_SEND_BURST");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 1) {
+        //set std
+        cfg->values.sending.send_burst = 10;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.send_burst = (unsigned int)entr.value.number;
+    }
+
+    //retransmission pacing
+    entr = config_get(cfg, "RASTA_RETRANSMIT_RATE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.retransmit_rate = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.retransmit_rate = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_RETRANSMIT_BURST");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 1) {
+        //set std
+        cfg->values.sending.retransmit_burst = 16;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.retransmit_burst = (unsigned int)entr.value.number;
+    }
+
+    //send coalescing
+    entr = config_get(cfg, "RASTA_SEND_COALESCE_US");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.send_coalesce_us = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.send_coalesce_us = (unsigned int)entr.value.number;
+    }
+
+    //heartbeat batching
+    entr = config_get(cfg, "RASTA_HEARTBEAT_TICK_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.heartbeat_tick_ms = 0;
+    }
+    else if ((unsigned int) entr.value.number >= cfg->values.sending.t_h) {
+        config_error(cfg, "RASTA_HEARTBEAT_TICK_MS has to be less than RASTA_T_H");
+        cfg->values.sending.heartbeat_tick_ms = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.heartbeat_tick_ms = (unsigned int)entr.value.number;
+    }
+
+    //connection pool
+    entr = config_get(cfg, "RASTA_MAX_CONNECTIONS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.max_connections = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.max_connections = (unsigned int)entr.value.number;
+    }
+
+    //admission control
+    entr = config_get(cfg, "RASTA_CONREQ_BUDGET");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.conreq_budget = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.conreq_budget = (unsigned int)entr.value.number;
+    }
+
+    //reconnect backoff
+    entr = config_get(cfg, "RASTA_RECONNECT_MIN_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.reconnect_min_ms = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.reconnect_min_ms = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_RECONNECT_MAX_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 ||
+        (unsigned int)entr.value.number < cfg->values.sending.reconnect_min_ms) {
+        //set std
+        cfg->values.sending.reconnect_max_ms = cfg->values.sending.reconnect_min_ms > 30000 ?
+                                               cfg->values.sending.reconnect_min_ms : 30000;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.reconnect_max_ms = (unsigned int)entr.value.number;
+    }
+
+    //bulk connect
+    entr = config_get(cfg, "RASTA_CONNECT_WAVE_SIZE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.connect_wave_size = 32;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.connect_wave_size = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_CONNECT_WAVE_INTERVAL_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 1) {
+        //set std
+        cfg->values.sending.connect_wave_interval_ms = 5;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.connect_wave_interval_ms = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_CONNECT_MAX_IN_FLIGHT");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.sending.connect_max_in_flight = 128;
+    }
+    else {
+        //check valid format
+        cfg->values.sending.connect_max_in_flight = (unsigned int)entr.value.number;
+    }
+
+    //metrics endpoint
+    entr = config_get(cfg, "RASTA_METRICS_PORT");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 65535) {
+        //set std
+        cfg->values.metrics.port = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.metrics.port = (uint16_t)entr.value.number;
+    }
+
+    //event loop profiling
+    entr = config_get(cfg, "RASTA_PROFILE_INTERVAL_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.metrics.profile_interval_ms = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.metrics.profile_interval_ms = (unsigned int)entr.value.number;
+    }
+
+    //residency histograms of the messages
+    entr = config_get(cfg, "RASTA_RESIDENCY_HISTOGRAMS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.metrics.residency = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.metrics.residency = (int)entr.value.number;
+    }
+
+    //shared memory page of the metrics
+    entr = config_get(cfg, "RASTA_STAT_PAGE");
+    if (entr.type != DICTIONARY_STRING) {
+        //set std
+        cfg->values.metrics.stat_page[0] = '\0';
+    }
+    else {
+        //check valid format
+        snprintf(cfg->values.metrics.stat_page, PATH_MAX, "%s", entr.value.string.c);
+    }
+
+    entr = config_get(cfg, "RASTA_STAT_INTERVAL_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number <= 0) {
+        //set std
+        cfg->values.metrics.stat_interval_ms = 1000;
+    }
+    else {
+        //check valid format
+        cfg->values.metrics.stat_interval_ms = (unsigned int)entr.value.number;
+    }
+
+    //flight recorder
+    entr = config_get(cfg, "RASTA_FLIGHT_RECORDS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.flight_recorder.records = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.flight_recorder.records = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_FLIGHT_TRIGGERS");
+    if (entr.type != DICTIONARY_ARRAY || entr.value.array.count == 0) {
+        //set std
+        cfg->values.flight_recorder.triggers = RASTA_FLIGHT_TRIGGER_ALL;
+    }
+    else {
+        //check right parameters
+        cfg->values.flight_recorder.triggers = 0;
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            const char * trigger = entr.value.array.data[i].c;
+            if (strcmp(trigger, "TIMEOUT") == 0) {
+                cfg->values.flight_recorder.triggers |= RASTA_FLIGHT_TRIGGER_TIMEOUT;
+            } else if (strcmp(trigger, "DISCREQ") == 0) {
+                cfg->values.flight_recorder.triggers |= RASTA_FLIGHT_TRIGGER_DISCREQ;
+            } else if (strcmp(trigger, "SAFETY") == 0) {
+                cfg->values.flight_recorder.triggers |= RASTA_FLIGHT_TRIGGER_SAFETY;
+            } else if (strcmp(trigger, "CHANNEL") == 0) {
+                cfg->values.flight_recorder.triggers |= RASTA_FLIGHT_TRIGGER_CHANNEL;
+            } else {
+                config_error(cfg, "RASTA_FLIGHT_TRIGGERS may only contain TIMEOUT, DISCREQ, SAFETY and CHANNEL");
+                cfg->values.flight_recorder.triggers = RASTA_FLIGHT_TRIGGER_ALL;
+                break;
+            }
+        }
+    }
+
+    entr = config_get(cfg, "RASTA_FLIGHT_SAFETY_ERRORS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number <= 0) {
+        //set std
+        cfg->values.flight_recorder.safety_errors = 5;
+    }
+    else {
+        //check valid format
+        cfg->values.flight_recorder.safety_errors = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_FLIGHT_DIRECTORY");
+    if (entr.type != DICTIONARY_STRING) {
+        //set std
+        strcpy(cfg->values.flight_recorder.directory, ".");
+    }
+    else {
+        //check valid format
+        snprintf(cfg->values.flight_recorder.directory, PATH_MAX, "%s", entr.value.string.c);
+    }
+
+    //busy polling event loop
+    entr = config_get(cfg, "RASTA_BUSY_POLL");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.loop.busy_poll = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.busy_poll = (int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_BUSY_POLL_CPU");
+    if (entr.type != DICTIONARY_NUMBER) {
+        //set std
+        cfg->values.loop.busy_poll_cpu = -1;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.busy_poll_cpu = (int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_SOCKET_BUSY_POLL_US");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.loop.socket_busy_poll_us = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.socket_busy_poll_us = (unsigned int)entr.value.number;
+    }
+
+    //real-time event loop
+    entr = config_get(cfg, "RASTA_REALTIME_PRIORITY");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 99) {
+        //set std
+        cfg->values.loop.realtime_priority = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.realtime_priority = (int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_LOCK_MEMORY");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.loop.lock_memory = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.lock_memory = (int)entr.value.number;
+    }
+
+    //callback executor
+    entr = config_get(cfg, "RASTA_CALLBACK_QUEUE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 65536) {
+        //set std
+        cfg->values.loop.callback_queue = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.callback_queue = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_CALLBACK_THREAD");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.loop.callback_thread = 1;
+    }
+    else {
+        //check valid format
+        cfg->values.loop.callback_thread = (int)entr.value.number;
+    }
+
+    //cpus and memory of the shards
+    cfg->values.placement.cpu_count = 0;
+    entr = config_get(cfg, "RASTA_SHARD_CPUS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.placement.cpus = rmalloc(sizeof(int) * entr.value.array.count);
+        cfg->values.placement.cpu_count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            char * end;
+            long cpu = strtol(entr.value.array.data[i].c, &end, 10);
+            if (end == entr.value.array.data[i].c || *end != '\0' || cpu < 0 || cpu > INT_MAX) {
+                config_error(cfg, "RASTA_SHARD_CPUS may only contain CPU numbers");
+                rfree(cfg->values.placement.cpus);
+                cfg->values.placement.cpu_count = 0;
+                break;
+            }
+            cfg->values.placement.cpus[i] = (int) cpu;
+        }
+    }
+
+    entr = config_get(cfg, "RASTA_NUMA_PLACEMENT");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.placement.numa = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.placement.numa = entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_HUGE_PAGES");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.placement.huge_pages = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.placement.huge_pages = entr.value.number;
+    }
+
+    //hot standby
+    entr = config_get(cfg, "RASTA_REPLICATION_ROLE");
+    if (entr.type != DICTIONARY_STRING) {
+        //set std
+        cfg->values.replication.role = RASTA_REPLICATION_NONE;
+    }
+    else {
+        //check right parameters
+        if (strcmp(entr.value.string.c, "NONE") == 0) {
+            cfg->values.replication.role = RASTA_REPLICATION_NONE;
+        }
+        else if (strcmp(entr.value.string.c, "PRIMARY") == 0) {
+            cfg->values.replication.role = RASTA_REPLICATION_PRIMARY;
+        }
+        else if (strcmp(entr.value.string.c, "STANDBY") == 0) {
+            cfg->values.replication.role = RASTA_REPLICATION_STANDBY;
+        }
+        else {
+            config_error(cfg, "RASTA_REPLICATION_ROLE has to be NONE, PRIMARY or STANDBY");
+            cfg->values.replication.role = RASTA_REPLICATION_NONE;
+        }
+    }
+
+    entr = config_get(cfg, "RASTA_REPLICATION_ADDRESS");
+    memset(&cfg->values.replication.address, 0, sizeof(cfg->values.replication.address));
+    if (entr.type == DICTIONARY_STRING) {
+        //check valid format
+        cfg->values.replication.address = extractIPData(entr.value.string.c, 0);
+    }
+    if (cfg->values.replication.role != RASTA_REPLICATION_NONE && cfg->values.replication.address.port == 0) {
+        config_error(cfg, "RASTA_REPLICATION_ADDRESS has to be ip:port when RASTA_REPLICATION_ROLE is set");
+        cfg->values.replication.role = RASTA_REPLICATION_NONE;
+    }
+
+    entr = config_get(cfg, "RASTA_REPLICATION_INTERVAL_MS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number <= 0) {
+        //set std
+        cfg->values.replication.interval_ms = 20;
+    }
+    else {
+        //check valid format
+        cfg->values.replication.interval_ms = (unsigned int)entr.value.number;
+    }
+
     /*
      * Redundancy part
      */
@@ -656,9 +1196,9 @@ void config_setstd(struct RastaConfig * cfg) {
         for (unsigned int i = 0; i < entr.value.array.count; i++) {
             struct RastaIPData ip = extractIPData(entr.value.array.data[i].c, i);
             if (ip.port == 0) {
-                logger_log(&cfg->logger,LOG_LEVEL_ERROR, cfg->filename, "RASTA_REDUNDANCY_CONNECTIONS may only contain strings in format ip:port or *:port");
-                rfree(entr.value.array.data);
-                entr.value.array.count = 0;
+                config_error(cfg, "RASTA_REDUNDANCY_CONNECTIONS may only contain strings in format ip:port or *:port");
+                rfree(cfg->values.redundancy.connections.data);
+                cfg->values.redundancy.connections.count = 0;
                 break;
             }
             cfg->values.redundancy.connections.data[i] = ip;
@@ -690,7 +1230,7 @@ void config_setstd(struct RastaConfig * cfg) {
         }
         else {
             //set std
-            logger_log(&cfg->logger,LOG_LEVEL_ERROR, cfg->filename, "RASTA_CRC_TYPE may only be TYPE_A, TYPE_B, TYPE_C, TYPE_D or TYPE_E");
+            config_error(cfg, "RASTA_CRC_TYPE may only be TYPE_A, TYPE_B, TYPE_C, TYPE_D or TYPE_E");
             cfg->values.redundancy.crc_type = crc_init_opt_a();
         }
     }
@@ -706,6 +1246,17 @@ void config_setstd(struct RastaConfig * cfg) {
         cfg->values.redundancy.t_seq = (unsigned short)entr.value.number;
     }
 
+    //adaptive t_seq
+    entr = config_get(cfg, "RASTA_ADAPTIVE_T_SEQ");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 10) {
+        //set std
+        cfg->values.redundancy.adaptive_t_seq = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.adaptive_t_seq = (unsigned int)entr.value.number;
+    }
+
     //ndiagnose
     entr = config_get(cfg, "RASTA_N_DIAGNOSE");
     if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
@@ -728,6 +1279,177 @@ void config_setstd(struct RastaConfig * cfg) {
         cfg->values.redundancy.n_deferqueue_size = (unsigned short)entr.value.number;
     }
 
+    //kernel receive timestamps
+    entr = config_get(cfg, "RASTA_RECEIVE_TIMESTAMPS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.redundancy.receive_timestamps = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.receive_timestamps = (int)entr.value.number;
+    }
+
+    //UDP segmentation offloads
+    entr = config_get(cfg, "RASTA_UDP_OFFLOAD");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.redundancy.udp_offload = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.udp_offload = (int)entr.value.number;
+    }
+
+    //redundancy channels of unknown senders
+    entr = config_get(cfg, "RASTA_MAX_PENDING_CHANNELS");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.redundancy.max_pending_channels = 64;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.max_pending_channels = (unsigned int)entr.value.number;
+    }
+
+    //PDUs of unknown senders
+    entr = config_get(cfg, "RASTA_PENDING_PDU_LIMIT");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.redundancy.pending_pdu_limit = 16;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.pending_pdu_limit = (unsigned int)entr.value.number;
+    }
+
+    //shared listen ports of the shards
+    entr = config_get(cfg, "RASTA_REUSEPORT");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0 || entr.value.number > 1) {
+        //set std
+        cfg->values.redundancy.reuseport = 0;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.reuseport = (int)entr.value.number;
+    }
+    cfg->values.redundancy.reuseport_group = 0;
+
+    //impairments
+    cfg->values.redundancy.impairments.count = 0;
+    entr = config_get(cfg, "RASTA_IMPAIRMENTS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.redundancy.impairments.data = rmalloc(sizeof(struct RastaConfigImpairment) * entr.value.array.count);
+        cfg->values.redundancy.impairments.count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            if (!extractImpairment(entr.value.array.data[i].c, &cfg->values.redundancy.impairments.data[i])) {
+                config_error(cfg, "RASTA_IMPAIRMENTS may only contain strings in format name=value,name=value");
+                rfree(cfg->values.redundancy.impairments.data);
+                cfg->values.redundancy.impairments.count = 0;
+                break;
+            }
+        }
+    }
+
+    //shared memory transport channels
+    cfg->values.redundancy.shm_channels.count = 0;
+    entr = config_get(cfg, "RASTA_SHM_CHANNELS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.redundancy.shm_channels.names = rmalloc(RASTA_SHM_NAME_LEN * entr.value.array.count);
+        cfg->values.redundancy.shm_channels.count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            if (strlen(entr.value.array.data[i].c) >= RASTA_SHM_NAME_LEN) {
+                config_error(cfg, "RASTA_SHM_CHANNELS may only contain names with less than %d characters", RASTA_SHM_NAME_LEN);
+                rfree(cfg->values.redundancy.shm_channels.names);
+                cfg->values.redundancy.shm_channels.count = 0;
+                break;
+            }
+            strcpy(cfg->values.redundancy.shm_channels.names[i], entr.value.array.data[i].c);
+        }
+    }
+
+    //AF_XDP transport channels
+    cfg->values.redundancy.xdp_channels.count = 0;
+    entr = config_get(cfg, "RASTA_XDP_CHANNELS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.redundancy.xdp_channels.interfaces = rmalloc(RASTA_XDP_INTERFACE_LEN * entr.value.array.count);
+        cfg->values.redundancy.xdp_channels.count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            if (strlen(entr.value.array.data[i].c) >= RASTA_XDP_INTERFACE_LEN) {
+                config_error(cfg, "RASTA_XDP_CHANNELS may only contain interface names with less than %d characters", RASTA_XDP_INTERFACE_LEN);
+                rfree(cfg->values.redundancy.xdp_channels.interfaces);
+                cfg->values.redundancy.xdp_channels.count = 0;
+                break;
+            }
+            strcpy(cfg->values.redundancy.xdp_channels.interfaces[i], entr.value.array.data[i].c);
+        }
+    }
+
+    //TCP transport channels
+    cfg->values.redundancy.tcp_channels.count = 0;
+    entr = config_get(cfg, "RASTA_TCP_CHANNELS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.redundancy.tcp_channels.types = rmalloc(sizeof(enum RastaTransportChannelType) * entr.value.array.count);
+        cfg->values.redundancy.tcp_channels.count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            const char * type = entr.value.array.data[i].c;
+            if (type[0] == '\0') {
+                cfg->values.redundancy.tcp_channels.types[i] = TRANSPORT_CHANNEL_UDP;
+            } else if (strcmp(type, "tcp") == 0) {
+                cfg->values.redundancy.tcp_channels.types[i] = TRANSPORT_CHANNEL_TCP;
+            } else if (strcmp(type, "tls") == 0) {
+                cfg->values.redundancy.tcp_channels.types[i] = TRANSPORT_CHANNEL_TLS;
+            } else {
+                config_error(cfg, "RASTA_TCP_CHANNELS may only contain \"tcp\", \"tls\" or empty strings");
+                rfree(cfg->values.redundancy.tcp_channels.types);
+                cfg->values.redundancy.tcp_channels.count = 0;
+                break;
+            }
+        }
+    }
+
+    //socket buffers
+    cfg->values.redundancy.socket_buffers.count = 0;
+    entr = config_get(cfg, "RASTA_SOCKET_BUFFERS");
+    if (entr.type == DICTIONARY_ARRAY && entr.value.array.count > 0) {
+        cfg->values.redundancy.socket_buffers.data = rmalloc(sizeof(struct RastaConfigSocketBuffer) * entr.value.array.count);
+        cfg->values.redundancy.socket_buffers.count = entr.value.array.count;
+        //check valid format
+        for (unsigned int i = 0; i < entr.value.array.count; i++) {
+            if (!extractSocketBuffer(entr.value.array.data[i].c, &cfg->values.redundancy.socket_buffers.data[i])) {
+                config_error(cfg, "RASTA_SOCKET_BUFFERS may only contain strings in format rcvbuf=bytes,sndbuf=bytes");
+                rfree(cfg->values.redundancy.socket_buffers.data);
+                cfg->values.redundancy.socket_buffers.count = 0;
+                break;
+            }
+        }
+    }
+
+    //AF_XDP receive queue
+    entr = config_get(cfg, "RASTA_XDP_QUEUE");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.redundancy.xdp_channels.queue = 0;
+    }
+    else {
+        cfg->values.redundancy.xdp_channels.queue = (unsigned int)entr.value.number;
+    }
+
+    //impairment seed
+    entr = config_get(cfg, "RASTA_IMPAIRMENT_SEED");
+    if (entr.type != DICTIONARY_NUMBER || entr.value.number < 0) {
+        //set std
+        cfg->values.redundancy.impairments.seed = 1;
+    }
+    else {
+        //check valid format
+        cfg->values.redundancy.impairments.seed = (unsigned long)entr.value.number;
+    }
+
     /*
      * General
      */
@@ -801,6 +1523,8 @@ void config_setstd(struct RastaConfig * cfg) {
 #endif
 
     cfg->values.kex.mode = KEY_EXCHANGE_MODE_NONE;
+    cfg->values.kex.rekeying_jitter_percent = 25;
+    cfg->values.kex.rekeying_max_concurrent = 4;
 
 #ifdef ENABLE_OPAQUE
     entr = config_get(cfg, "RASTA_KEX_MODE");
@@ -829,6 +1553,16 @@ void config_setstd(struct RastaConfig * cfg) {
     if(entr.type == DICTIONARY_NUMBER){
         cfg->values.kex.rekeying_interval_ms = entr.value.number;
     }
+
+    entr = config_get(cfg, "RASTA_KEX_REKEYING_JITTER_PERCENT");
+    if(entr.type == DICTIONARY_NUMBER && entr.value.number >= 0 && entr.value.number <= 50){
+        cfg->values.kex.rekeying_jitter_percent = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_KEX_REKEYING_MAX_CONCURRENT");
+    if(entr.type == DICTIONARY_NUMBER && entr.value.number >= 0){
+        cfg->values.kex.rekeying_max_concurrent = (unsigned int)entr.value.number;
+    }
     cfg->values.kex.has_psk_record = false;
     entr = config_get(cfg,"RASTA_KEX_PSK_RECORD");
     if(entr.type == DICTIONARY_STRING){
@@ -856,27 +1590,87 @@ void config_setstd(struct RastaConfig * cfg) {
         }
     }
 
+    entr = config_get(cfg, "RASTA_KEX_WORKERS");
+    cfg->values.kex.worker_count = 1;
+    if(entr.type == DICTIONARY_NUMBER){
+        if(entr.value.number <= 0){
+            fprintf(stderr, "RASTA_KEX_WORKERS must be at least 1\n");
+            exit(1);
+        }
+        cfg->values.kex.worker_count = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_KEX_MAX_PENDING");
+    cfg->values.kex.max_pending = 16;
+    if(entr.type == DICTIONARY_NUMBER){
+        if(entr.value.number <= 0){
+            fprintf(stderr, "RASTA_KEX_MAX_PENDING must be at least 1\n");
+            exit(1);
+        }
+        cfg->values.kex.max_pending = (unsigned int)entr.value.number;
+    }
+
+    entr = config_get(cfg, "RASTA_KEX_PRECOMPUTE");
+    cfg->values.kex.precompute = true;
+    if(entr.type == DICTIONARY_NUMBER){
+        if(entr.value.number < 0 || entr.value.number > 1){
+            fprintf(stderr, "RASTA_KEX_PRECOMPUTE must be 0 or 1\n");
+            exit(1);
+        }
+        cfg->values.kex.precompute = entr.value.number == 1;
+    }
+
+#endif
+
+#ifdef USE_STATIC_MEMORY
+    // the static memory is sized for the capacities, a connection takes its slot when the handle is created
+    if (cfg->values.sending.max_connections == 0) {
+        cfg->values.sending.max_connections = RASTA_STATIC_MAX_CONNECTIONS;
+    }
+    if (cfg->values.sending.max_connections > RASTA_STATIC_MAX_CONNECTIONS) {
+        config_error(cfg, "RASTA_MAX_CONNECTIONS may be at most %d in a build with static memory",
+                     RASTA_STATIC_MAX_CONNECTIONS);
+    }
+    if (cfg->values.sending.send_max > RASTA_STATIC_SEND_WINDOW || cfg->values.sending.mwa > RASTA_STATIC_SEND_WINDOW) {
+        config_error(cfg, "RASTA_SEND_MAX and RASTA_MWA may be at most %d in a build with static memory",
+                     RASTA_STATIC_SEND_WINDOW);
+    }
+    if (cfg->values.redundancy.n_deferqueue_size > RASTA_STATIC_DEFER_QUEUE_SIZE) {
+        config_error(cfg, "RASTA_N_DEFERQUEUE_SIZE may be at most %d in a build with static memory",
+                     RASTA_STATIC_DEFER_QUEUE_SIZE);
+    }
+    if (cfg->values.redundancy.connections.count > RASTA_STATIC_MAX_TRANSPORT_CHANNELS) {
+        config_error(cfg, "RASTA_REDUNDANCY_CONNECTIONS may have at most %d entries in a build with static memory",
+                     RASTA_STATIC_MAX_TRANSPORT_CHANNELS);
+    }
 #endif
 }
 
 /*
  * Public functions
  */
-struct RastaConfig config_load(const char filename[256]) {
+struct RastaConfig config_load(const char * filename) {
 
     FILE *f;
     char buf[CONFIG_BUFFER_LENGTH];
     struct RastaConfig config = {0};
-    strcpy(config.filename,filename);
+    strncpy(config.filename, filename, sizeof(config.filename) - 1);
 
     config.logger = logger_init(LOG_LEVEL_INFO,LOGGER_TYPE_CONSOLE);
 
     f = fopen(config.filename,"r");
     if (!f){
-        logger_log(&config.logger, LOG_LEVEL_ERROR, config.filename, "File not found");
+        config_error(&config, "File not found");
         return config;
     }
 
+    uint32_t magic;
+    if (fread(&magic, sizeof(magic), 1, f) == 1 && magic == RASTA_CONFIG_SNAPSHOT_MAGIC) {
+        fclose(f);
+        return config_load_snapshot(filename);
+    }
+    rewind(f);
+
     config.dictionary = dictionary_create(2);
 
     int n = 1;
@@ -915,7 +1709,7 @@ struct RastaConfig config_load(const char filename[256]) {
         parser_skipBlanc(&p);
 
         if (p.current != '=') {
-            logger_log(&p.cfg->logger,LOG_LEVEL_ERROR, p.cfg->filename, "Error in line %d: Expected '=' but found '%c'", p.line,p.current);
+            config_error(p.cfg, "Error in line %d: Expected '=' but found '%c'", p.line,p.current);
             n++;
             continue;
         }
@@ -942,7 +1736,203 @@ struct DictionaryEntry config_get(struct RastaConfig * cfg, const char* key) {
     return dictionary_get(&cfg->dictionary, key);
 }
 
+/**
+ * FNV-1a hash of the part of a snapshot behind its header
+ * @param data the entries and strings
+ * @param length their size in bytes
+ * @return the checksum
+ */
+static uint64_t snapshot_checksum(const unsigned char * data, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+int config_write_snapshot(struct RastaConfig * cfg, const char * filename) {
+    if (cfg->dictionary.data == NULL || cfg->errors > 0) {
+        return 0;
+    }
+
+    uint32_t string_count = 0;
+    for (unsigned int i = 0; i < cfg->dictionary.size; i++) {
+        if (cfg->dictionary.data[i].type == DICTIONARY_ARRAY) {
+            string_count += cfg->dictionary.data[i].value.array.count;
+        }
+    }
+
+    size_t entries_length = (size_t) cfg->dictionary.size * sizeof(struct DictionaryEntry);
+    size_t length = sizeof(struct rasta_config_snapshot_header) + entries_length +
+                    (size_t) string_count * sizeof(struct DictionaryString);
+    unsigned char * buffer = rmalloc(length);
+    // the padding is written too, it has to be the same for the same config
+    memset(buffer, 0, length);
+
+    struct rasta_config_snapshot_header * header = (struct rasta_config_snapshot_header *) buffer;
+    struct DictionaryEntry * entries = (struct DictionaryEntry *) (header + 1);
+    struct DictionaryString * strings = (struct DictionaryString *) ((unsigned char *) entries + entries_length);
+
+    uint32_t next_string = 0;
+    for (unsigned int i = 0; i < cfg->dictionary.size; i++) {
+        const struct DictionaryEntry * entry = &cfg->dictionary.data[i];
+        entries[i].type = entry->type;
+        strcpy(entries[i].key, entry->key);
+        switch (entry->type) {
+            case DICTIONARY_STRING:
+                strcpy(entries[i].value.string.c, entry->value.string.c);
+                break;
+            case DICTIONARY_ARRAY:
+                // a position in the file instead of a pointer, see dictionary_map()
+                entries[i].value.array.data = (struct DictionaryString *) (uintptr_t) next_string;
+                entries[i].value.array.count = entry->value.array.count;
+                for (unsigned int j = 0; j < entry->value.array.count; j++) {
+                    strcpy(strings[next_string++].c, entry->value.array.data[j].c);
+                }
+                break;
+            default:
+                entries[i].value.number = entry->value.number;
+                break;
+        }
+    }
+
+    header->magic = RASTA_CONFIG_SNAPSHOT_MAGIC;
+    header->version = RASTA_CONFIG_SNAPSHOT_VERSION;
+    header->entry_size = sizeof(struct DictionaryEntry);
+    header->string_size = sizeof(struct DictionaryString);
+    header->entry_count = cfg->dictionary.size;
+    header->string_count = string_count;
+    strcpy(header->source, cfg->filename);
+    header->checksum = snapshot_checksum((unsigned char *) entries, length - sizeof(*header));
+
+    // a new file replaces the old one, the processes that mapped the old one keep reading it
+    char temporary[sizeof(cfg->filename) + 8];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", filename);
+    FILE * out = fopen(temporary, "wb");
+    int written = out != NULL && fwrite(buffer, length, 1, out) == 1;
+    if (out != NULL && fclose(out) != 0) {
+        written = 0;
+    }
+    rfree(buffer);
+    if (!written || rename(temporary, filename) != 0) {
+        unlink(temporary);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * checks that the strings of a mapped snapshot are terminated and its arrays are inside of it
+ * @param header the header, its sizes are checked already
+ * @return 1 if the snapshot can be used
+ */
+static int snapshot_valid(const struct rasta_config_snapshot_header * header) {
+    const struct DictionaryEntry * entries = (const struct DictionaryEntry *) (header + 1);
+    const struct DictionaryString * strings = (const struct DictionaryString *) (entries + header->entry_count);
+
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if (memchr(entries[i].key, '\0', sizeof(entries[i].key)) == NULL) {
+            return 0;
+        }
+        switch (entries[i].type) {
+            case DICTIONARY_STRING:
+                if (memchr(entries[i].value.string.c, '\0', sizeof(entries[i].value.string.c)) == NULL) {
+                    return 0;
+                }
+                break;
+            case DICTIONARY_ARRAY:
+                if ((uintptr_t) entries[i].value.array.data > header->string_count ||
+                    entries[i].value.array.count > header->string_count - (uintptr_t) entries[i].value.array.data) {
+                    return 0;
+                }
+                break;
+            case DICTIONARY_NUMBER:
+                break;
+            default:
+                return 0;
+        }
+    }
+    for (uint32_t i = 0; i < header->string_count; i++) {
+        if (memchr(strings[i].c, '\0', sizeof(strings[i].c)) == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+struct RastaConfig config_load_snapshot(const char * filename) {
+    struct RastaConfig config = {0};
+    strncpy(config.filename, filename, sizeof(config.filename) - 1);
+
+    config.logger = logger_init(LOG_LEVEL_INFO,LOGGER_TYPE_CONSOLE);
+
+    int fd = open(config.filename, O_RDONLY);
+    if (fd == -1) {
+        config_error(&config, "File not found");
+        return config;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) == -1) {
+        perror("fstat");
+        exit(1);
+    }
+    size_t length = (size_t) status.st_size;
+    if (length < sizeof(struct rasta_config_snapshot_header)) {
+        close(fd);
+        config_error(&config, "Snapshot is truncated");
+        return config;
+    }
+
+    void * mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    close(fd);
+
+    const struct rasta_config_snapshot_header * header = mapping;
+    if (header->magic != RASTA_CONFIG_SNAPSHOT_MAGIC || header->version != RASTA_CONFIG_SNAPSHOT_VERSION ||
+        header->entry_size != sizeof(struct DictionaryEntry) || header->string_size != sizeof(struct DictionaryString)) {
+        munmap(mapping, length);
+        config_error(&config, "Snapshot was written by a different version");
+        return config;
+    }
+
+    uint64_t expected = sizeof(*header) + (uint64_t) header->entry_count * sizeof(struct DictionaryEntry) +
+                        (uint64_t) header->string_count * sizeof(struct DictionaryString);
+    if (expected != length ||
+        snapshot_checksum((const unsigned char *) (header + 1), length - sizeof(*header)) != header->checksum ||
+        !snapshot_valid(header)) {
+        munmap(mapping, length);
+        config_error(&config, "Snapshot is corrupted");
+        return config;
+    }
+
+    const struct DictionaryEntry * entries = (const struct DictionaryEntry *) (header + 1);
+    config.dictionary = dictionary_map(entries, header->entry_count,
+                                       (const struct DictionaryString *) (entries + header->entry_count));
+    config.snapshot = mapping;
+    config.snapshot_length = length;
+
+    // values like the addresses of network interfaces depend on the host
+    config_setstd(&config);
+
+    return config;
+}
+
 void config_free(struct RastaConfig *cfg) {
     dictionary_free(&cfg->dictionary);
+    if (cfg->snapshot != NULL) {
+        munmap(cfg->snapshot, cfg->snapshot_length);
+        cfg->snapshot = NULL;
+    }
     if (cfg->values.redundancy.connections.count > 0) rfree(cfg->values.redundancy.connections.data);
+    if (cfg->values.redundancy.impairments.count > 0) rfree(cfg->values.redundancy.impairments.data);
+    if (cfg->values.redundancy.shm_channels.count > 0) rfree(cfg->values.redundancy.shm_channels.names);
+    if (cfg->values.redundancy.xdp_channels.count > 0) rfree(cfg->values.redundancy.xdp_channels.interfaces);
+    if (cfg->values.redundancy.tcp_channels.count > 0) rfree(cfg->values.redundancy.tcp_channels.types);
+    if (cfg->values.redundancy.socket_buffers.count > 0) rfree(cfg->values.redundancy.socket_buffers.data);
+    if (cfg->values.placement.cpu_count > 0) rfree(cfg->values.placement.cpus);
 }
@@ -2,6 +2,7 @@
 // Created by tobia on 18.12.2017.
 //
 #include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 #include "rmemory.h"
 #include "dictionary.h"
@@ -17,6 +18,89 @@ void uppercase(char * string) {
         }
     }
 }
+/**
+ * FNV-1a hash of a key as if it was uppercase, so the key does not have to be copied to look it up
+ * @param key the key
+ * @return the hash
+ */
+static uint32_t hash_key(const char * key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char * c = (const unsigned char *) key; *c != '\0'; c++) {
+        hash ^= (uint32_t) toupper(*c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * compares a key with the uppercase key of an entry
+ * @param key the key in any case
+ * @param stored the uppercase key
+ * @return 1 if they are equal
+ */
+static int key_matches(const char * key, const char * stored) {
+    while (*key != '\0' && toupper((unsigned char) *key) == (unsigned char) *stored) {
+        key++;
+        stored++;
+    }
+    return *key == '\0' && *stored == '\0';
+}
+
+/**
+ * inserts the position of an entry into the hash table, the table has a free slot
+ * @param dict
+ * @param index the position of the entry in dict#data
+ */
+static void index_insert(struct Dictionary* dict, unsigned int index) {
+    unsigned int slot = hash_key(dict->data[index].key) & dict->slot_mask;
+    while (dict->slots[slot] != -1) {
+        slot = (slot + 1) & dict->slot_mask;
+    }
+    dict->slots[slot] = (int) index;
+}
+
+/**
+ * allocates a hash table for at least @p entry_count entries and inserts the entries of the dictionary
+ * @param dict
+ * @param entry_count
+ */
+static void index_rebuild(struct Dictionary* dict, unsigned int entry_count) {
+    unsigned int slot_count = 4;
+    while (slot_count < 2 * entry_count) {
+        slot_count *= 2;
+    }
+
+    rfree(dict->slots);
+    dict->slots = rmalloc(slot_count * sizeof(int));
+    memset(dict->slots, 0xFF, slot_count * sizeof(int));
+    dict->slot_mask = slot_count - 1;
+
+    for (unsigned int i = 0; i < dict->size; i++) {
+        index_insert(dict, i);
+    }
+}
+
+/**
+ * finds the position of the entry with a key
+ * @param dict
+ * @param key the key in any case
+ * @return the position in dict#data or -1
+ */
+static int dictionary_find(struct Dictionary* dict, const char* key) {
+    if (dict->slots == NULL) {
+        return -1;
+    }
+
+    unsigned int slot = hash_key(key) & dict->slot_mask;
+    while (dict->slots[slot] != -1) {
+        if (key_matches(key, dict->data[dict->slots[slot]].key)) {
+            return dict->slots[slot];
+        }
+        slot = (slot + 1) & dict->slot_mask;
+    }
+    return -1;
+}
+
 /**
  * changes the directories size
  * @param dict
@@ -35,7 +119,7 @@ void dictionary_change_size(struct Dictionary* dict, unsigned int size) {
  * @return 1 if the entry was added successfully else 0
  */
 int dictionary_add(struct Dictionary* dict, struct DictionaryEntry entry) {
-    if (dictionary_isin(dict,entry.key)) return 0;
+    if (dict->mapped_strings != NULL || dictionary_isin(dict,entry.key)) return 0;
 
     uppercase(entry.key);
 
@@ -45,6 +129,12 @@ int dictionary_add(struct Dictionary* dict, struct DictionaryEntry entry) {
     dict->data[dict->size] = entry;
     dict->size++;
 
+    if (2 * dict->size > dict->slot_mask + 1) {
+        index_rebuild(dict, dict->actual_size);
+    } else {
+        index_insert(dict, dict->size - 1);
+    }
+
     return 1;
 }
 
@@ -76,11 +166,37 @@ struct Dictionary dictionary_create(unsigned int initial_size) {
     result.size = 0;
     result.actual_size = initial_size;
     result.data = rmalloc(sizeof(struct DictionaryEntry) * initial_size);
+    result.slots = NULL;
+    result.mapped_strings = NULL;
+    index_rebuild(&result, initial_size);
+
+    return result;
+}
+
+struct Dictionary dictionary_map(const struct DictionaryEntry* entries, unsigned int count,
+                                 const struct DictionaryString* strings) {
+    struct Dictionary result;
+    result.size = count;
+    // nothing can be added, the entries are not owned
+    result.actual_size = 0;
+    result.data = (struct DictionaryEntry*) entries;
+    result.slots = NULL;
+    result.mapped_strings = strings;
+    index_rebuild(&result, count);
 
     return result;
 }
 
 void dictionary_free(struct Dictionary* dict) {
+    rfree(dict->slots);
+    dict->slots = NULL;
+    if (dict->mapped_strings != NULL) {
+        dict->mapped_strings = NULL;
+        dict->size = 0;
+        dict->data = NULL;
+        return;
+    }
+
     for (unsigned int i = 0; i < dict->size; i++) {
         if (dict->data[i].type == DICTIONARY_ARRAY) {
             free_DictionaryArray(&dict->data[i].value.array);
@@ -94,20 +210,7 @@ void dictionary_free(struct Dictionary* dict) {
 }
 
 int dictionary_isin(struct Dictionary* dict, const char* key) {
-    int result = 0;
-    char nkey[256];
-    strcpy(nkey,key);
-    uppercase(nkey);
-
-    for (unsigned int i = 0; i < dict->size; i++) {
-        if (strcmp(nkey, dict->data[i].key) == 0) {
-            //key matched
-            result = 1;
-            return result;
-        }
-    }
-
-    return result;
+    return dictionary_find(dict, key) != -1;
 }
 
 int dictionary_addNumber(struct Dictionary* dict, const char* key, int number) {
@@ -139,17 +242,16 @@ int dictionary_addArray(struct Dictionary* dict, const char* key, struct Diction
 
 struct DictionaryEntry dictionary_get(struct Dictionary* dict, const char* key) {
     struct DictionaryEntry result;
-    result.type = DICTIONARY_ERROR;
-    char nkey[256];
-    strncpy(nkey,key, 255);
-    uppercase(nkey);
-    for (unsigned int i = 0; i < dict->size; i++) {
-        if (strcmp(nkey, dict->data[i].key) == 0) {
-            //found
-            return dict->data[i];
-        }
+    int index = dictionary_find(dict, key);
+    if (index == -1) {
+        result.type = DICTIONARY_ERROR;
+        return result;
+    }
+
+    result = dict->data[index];
+    if (dict->mapped_strings != NULL && result.type == DICTIONARY_ARRAY) {
+        // the mapped entry holds the position of the elements
+        result.value.array.data = (struct DictionaryString*) &dict->mapped_strings[(uintptr_t) result.value.array.data];
     }
     return result;
 }
-
-
@@ -1,9 +1,24 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
 #include "event_system.h"
 #include "rasta_new.h"
+#include "rmemory.h"
+#include "mpscqueue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+#include <malloc.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#ifdef ENABLE_EPOLL
+#include <sys/epoll.h>
+#else
 #include <sys/select.h>
-
-typedef uint_fast64_t evtime_t;
+#endif
 
 /**
  * convert an integer (at least 64 bit) to timespec format
@@ -15,7 +30,7 @@ typedef uint_fast64_t evtime_t;
 static inline struct timeval evtime_to_timeval(evtime_t t) {
     return (struct timeval) {
         t / 1000000000,
-        t % 1000000000
+        (t % 1000000000) / 1000
     };
 }
 
@@ -44,6 +59,262 @@ evtime_t get_nanotime() {
     return timeval_to_evtime(t);
 }
 
+/**
+ * the time of the current iteration of the event loop on this thread, 0 if no event loop runs on this thread
+ */
+static _Thread_local evtime_t loop_time;
+
+void event_clock_init_virtual(event_clock* clock, evtime_t start) {
+    clock->read = NULL;
+    clock->carry_data = NULL;
+    clock->virtual_now = start;
+}
+
+evtime_t event_clock_read(event_clock* clock) {
+    if (clock == NULL) return get_nanotime();
+    return clock->read ? clock->read(clock->carry_data) : clock->virtual_now;
+}
+
+/**
+ * reads the clock for the current iteration of the event loop
+ * @param ev_sys the event system whose clock is read
+ * @return the current time
+ */
+static inline evtime_t event_system_tick(event_system* ev_sys) {
+    loop_time = event_clock_read(ev_sys->clock);
+    return loop_time;
+}
+
+evtime_t event_system_now() {
+    return loop_time ? loop_time : get_nanotime();
+}
+
+uint64_t event_system_now_us() {
+    return event_system_now() / 1000;
+}
+
+uint32_t event_system_now_ms() {
+    return (uint32_t) (event_system_now() / NS_PER_MS);
+}
+
+/**
+ * finds the entry of a callback in the profile and adds it if it is missing
+ * @param profile the profile
+ * @param callback the callback
+ * @return the entry, NULL if the profile is full
+ */
+static struct event_profile_entry* event_profile_entry(event_profile* profile, event_ptr callback) {
+    for (unsigned int i = 0; i < profile->entry_count; i++) {
+        if (profile->entries[i].callback == callback) {
+            return &profile->entries[i];
+        }
+    }
+    if (profile->entry_count == EV_PROFILE_MAX_CALLBACKS) {
+        return NULL;
+    }
+    struct event_profile_entry* entry = &profile->entries[profile->entry_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->callback = callback;
+    return entry;
+}
+
+/**
+ * calls a callback and measures it if the event system has a profile
+ * @param ev_sys the event system
+ * @param callback the callback
+ * @param carry_data the argument of the callback
+ * @param due the time a timed event was due, 0 for fd events
+ * @return the result of the callback
+ */
+static inline int event_system_call(event_system* ev_sys, event_ptr callback, void* carry_data, uint64_t due) {
+    if (!ev_sys->profile) return callback(carry_data);
+
+    uint64_t start = get_nanotime();
+    int result = callback(carry_data);
+    uint64_t duration = get_nanotime() - start;
+
+    struct event_profile_entry* entry = event_profile_entry(ev_sys->profile, callback);
+    if (entry == NULL) {
+        ev_sys->profile->dropped_calls++;
+        return result;
+    }
+    entry->count++;
+    entry->total_ns += duration;
+    if (duration > entry->max_ns) entry->max_ns = duration;
+    if (due) {
+        uint64_t lag = start > due ? start - due : 0;
+        entry->timed_count++;
+        entry->lag_total_ns += lag;
+        if (lag > entry->lag_max_ns) entry->lag_max_ns = lag;
+    }
+    return result;
+}
+
+void event_profile_name(event_profile* profile, event_ptr callback, const char* name) {
+    struct event_profile_entry* entry = event_profile_entry(profile, callback);
+    if (entry) entry->name = name;
+}
+
+const struct event_profile_entry* event_profile_get(const event_profile* profile, event_ptr callback) {
+    for (unsigned int i = 0; i < profile->entry_count; i++) {
+        if (profile->entries[i].callback == callback) {
+            return &profile->entries[i];
+        }
+    }
+    return NULL;
+}
+
+void event_profile_reset(event_profile* profile) {
+    for (unsigned int i = 0; i < profile->entry_count; i++) {
+        struct event_profile_entry* entry = &profile->entries[i];
+        event_ptr callback = entry->callback;
+        const char* name = entry->name;
+        memset(entry, 0, sizeof(*entry));
+        entry->callback = callback;
+        entry->name = name;
+    }
+    profile->dropped_calls = 0;
+}
+
+void event_profile_describe(const struct event_profile_entry* entry, char* out, size_t size) {
+    char address[32];
+    const char* name = entry->name;
+    if (name == NULL) {
+        // function pointers can not be printed with %p
+        snprintf(address, sizeof(address), "0x%" PRIxPTR, (uintptr_t) entry->callback);
+        name = address;
+    }
+
+    int length = snprintf(out, size, "%s: %" PRIu64 " calls, avg %" PRIu64 " us, max %" PRIu64 " us", name,
+                          entry->count, entry->count ? entry->total_ns / entry->count / 1000 : 0,
+                          entry->max_ns / 1000);
+    if (entry->timed_count && length >= 0 && (size_t) length < size) {
+        snprintf(out + length, size - (size_t) length, ", fired avg %" PRIu64 " us, max %" PRIu64 " us late",
+                 entry->lag_total_ns / entry->timed_count / 1000, entry->lag_max_ns / 1000);
+    }
+}
+
+void event_profile_dump(const event_profile* profile, FILE* out) {
+    char line[256];
+    for (unsigned int i = 0; i < profile->entry_count; i++) {
+        if (profile->entries[i].count == 0) continue;
+        event_profile_describe(&profile->entries[i], line, sizeof(line));
+        fprintf(out, "%s\n", line);
+    }
+    if (profile->dropped_calls) {
+        fprintf(out, "%" PRIu64 " calls of further callbacks were not profiled\n", profile->dropped_calls);
+    }
+}
+
+#ifdef ENABLE_EPOLL
+
+/**
+ * translates the options of a fd event to the epoll event mask
+ * a disabled event stays registered, but with an empty mask
+ * @param event the fd event
+ * @return the epoll event mask
+ */
+static inline uint32_t fd_event_to_epoll_events(fd_event* event) {
+    uint32_t events = 0;
+    if (!event->enabled) return events;
+    if (event->options & EV_READABLE)
+        events |= EPOLLIN;
+    if (event->options & EV_WRITABLE)
+        events |= EPOLLOUT;
+    if (event->options & EV_EXCEPTIONAL)
+        events |= EPOLLPRI;
+    return events;
+}
+
+/**
+ * adds, modifies or removes the epoll registration of a fd event
+ * @param event the fd event
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL
+ */
+static void epoll_update_fd_event(fd_event* event, int op) {
+    struct epoll_event ev;
+    ev.events = fd_event_to_epoll_events(event);
+    ev.data.ptr = event;
+    // errors are ignored on purpose: the kernel already dropped fds that got closed while registered
+    epoll_ctl(event->ev_sys->epoll_fd, op, event->fd, &ev);
+}
+
+/**
+ * creates the epoll instance and registers every fd event once
+ * @param ev_sys the event system
+ * @return 0 on success, -1 if the epoll instance could not be created
+ */
+static int epoll_open(event_system* ev_sys) {
+    ev_sys->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ev_sys->epoll_fd == -1) return -1;
+    ev_sys->ready_count = 0;
+    ev_sys->ready_index = 0;
+    ev_sys->running = 1;
+    for (fd_event* current = ev_sys->fd_events.first; current; current = current->next) {
+        current->ev_sys = ev_sys;
+        epoll_update_fd_event(current, EPOLL_CTL_ADD);
+    }
+    return 0;
+}
+
+/**
+ * closes the epoll instance, the fd events stay in the event system
+ * @param ev_sys the event system
+ */
+static void epoll_close(event_system* ev_sys) {
+    ev_sys->running = 0;
+    ev_sys->ready_count = 0;
+    close(ev_sys->epoll_fd);
+    ev_sys->epoll_fd = -1;
+}
+
+/**
+ * calls the callback of the currently dispatched ready event
+ * @param ev_sys the event system
+ * @param option the fd event option that was triggered
+ * @return the result of the callback, 0 if the event was removed, disabled or doesn't wait for @p option
+ */
+static int dispatch_ready_event(event_system* ev_sys, int option) {
+    fd_event* current = ev_sys->ready_events[ev_sys->ready_index].data.ptr;
+    if (current == NULL || !current->enabled || !(current->options & option)) return 0;
+    return event_system_call(ev_sys, current->callback, current->carry_data, 0);
+}
+
+/**
+ * sleeps but keeps track of the fd events
+ * @param time_to_wait the time to sleep in nanoseconds
+ * @param ev_sys the event system whose fd events are watched
+ * @return the amount of fd events that got called or -1 to terminate the event loop
+ */
+int event_system_sleep(uint64_t time_to_wait, event_system* ev_sys) {
+    int timeout_ms = -1;
+    if (time_to_wait != UINT64_MAX) {
+        // round up, otherwise the loop would spin until the timed event is due
+        uint64_t ms = time_to_wait / NS_PER_MS + (time_to_wait % NS_PER_MS != 0);
+        timeout_ms = ms > INT_MAX ? INT_MAX : (int) ms;
+    }
+    int result = epoll_wait(ev_sys->epoll_fd, ev_sys->ready_events, EV_EPOLL_MAX_EVENTS, timeout_ms);
+    // interrupted waits are no error, io_uring interrupts them to run the completions of the thread
+    if (result == -1 && errno == EINTR) return 0;
+    // syscall error or error on epoll_wait()
+    if (result == -1) return -1;
+    if (result == 0) return 0;
+    event_system_tick(ev_sys);
+    ev_sys->ready_count = result;
+    for (ev_sys->ready_index = 0; ev_sys->ready_index < ev_sys->ready_count; ev_sys->ready_index++) {
+        uint32_t events = ev_sys->ready_events[ev_sys->ready_index].events;
+        // like select() errors and hang ups are reported as readable / writable
+        if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && dispatch_ready_event(ev_sys, EV_READABLE)) break;
+        if ((events & (EPOLLOUT | EPOLLERR)) && dispatch_ready_event(ev_sys, EV_WRITABLE)) break;
+        if ((events & EPOLLPRI) && dispatch_ready_event(ev_sys, EV_EXCEPTIONAL)) break;
+    }
+    int terminated = ev_sys->ready_index < ev_sys->ready_count;
+    ev_sys->ready_count = 0;
+    return terminated ? -1 : result;
+}
+
+#else
+
 static inline int get_max_nfds(struct fd_event_linked_list_s* fd_events) {
     int nfds = 0;
     // find highest fd and set nfds to 1 higher
@@ -76,16 +347,16 @@ static void prepare_fd_sets(fd_set* on_readable,
 static int handle_fd_events(fd_set* on_readable,
                             fd_set* on_writable,
                             fd_set* on_exception,
-                            struct fd_event_linked_list_s* fd_events) {
-    for (fd_event* current = fd_events->first; current; current = current->next) {
+                            event_system* ev_sys) {
+    for (fd_event* current = ev_sys->fd_events.first; current; current = current->next) {
         if (current->enabled && FD_ISSET(current->fd, on_readable)) {
-            if (current->callback(current->carry_data)) return -1;
+            if (event_system_call(ev_sys, current->callback, current->carry_data, 0)) return -1;
         }
         if (current->enabled && FD_ISSET(current->fd, on_writable)) {
-            if (current->callback(current->carry_data)) return -1;
+            if (event_system_call(ev_sys, current->callback, current->carry_data, 0)) return -1;
         }
         if (current->enabled && FD_ISSET(current->fd, on_exception)) {
-            if (current->callback(current->carry_data)) return -1;
+            if (event_system_call(ev_sys, current->callback, current->carry_data, 0)) return -1;
         }
     }
     return 0;
@@ -94,11 +365,11 @@ static int handle_fd_events(fd_set* on_readable,
 /**
  * sleeps but keeps track of the fd events
  * @param time_to_wait the time to sleep in nanoseconds
- * @param fd_events the fd event array
- * @param len the length of the fd event array
+ * @param ev_sys the event system whose fd events are watched
  * @return the amount of fd events that got called or -1 to terminate the event loop
  */
-int event_system_sleep(uint64_t time_to_wait, struct fd_event_linked_list_s* fd_events) {
+int event_system_sleep(uint64_t time_to_wait, event_system* ev_sys) {
+    struct fd_event_linked_list_s* fd_events = &ev_sys->fd_events;
     struct timeval tv = evtime_to_timeval(time_to_wait);
     int nfds = get_max_nfds(fd_events);
     if (nfds >= FD_SETSIZE) {
@@ -112,51 +383,257 @@ int event_system_sleep(uint64_t time_to_wait, struct fd_event_linked_list_s* fd_
     prepare_fd_sets(&on_readable, &on_writable, &on_exception, fd_events);
     // call select and wait
     int result = select(nfds, &on_readable, &on_writable, &on_exception, &tv);
+    // interrupted waits are no error, the fd sets are prepared again by the next iteration
+    if (result == -1 && errno == EINTR) return 0;
     // syscall error or error on select()
     if (result == -1) return -1;
-    if (handle_fd_events(&on_readable, &on_writable, &on_exception, fd_events)) return -1;
+    if (result == 0) return 0;
+    event_system_tick(ev_sys);
+    if (handle_fd_events(&on_readable, &on_writable, &on_exception, ev_sys)) return -1;
     return result;
 }
 
+#endif
+
+/**
+ * the time at which the timed event has to be called next
+ */
+static inline uint64_t timed_event_deadline(timed_event* event) {
+    return event->last_call + event->interval;
+}
+
+static inline int timed_event_heap_contains(timed_event* event) {
+    struct timed_event_heap_s* heap;
+    if (!event->ev_sys) return 0;
+    heap = &event->ev_sys->timed_event_heap;
+    return event->heap_index < heap->count && heap->events[event->heap_index] == event;
+}
+
+static inline void timed_event_heap_set(struct timed_event_heap_s* heap, size_t index, timed_event* event) {
+    heap->events[index] = event;
+    event->heap_index = index;
+}
+
+static void timed_event_heap_sift_up(struct timed_event_heap_s* heap, size_t index) {
+    timed_event* event = heap->events[index];
+    uint64_t deadline = timed_event_deadline(event);
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (timed_event_deadline(heap->events[parent]) <= deadline) break;
+        timed_event_heap_set(heap, index, heap->events[parent]);
+        index = parent;
+    }
+    timed_event_heap_set(heap, index, event);
+}
+
+static void timed_event_heap_sift_down(struct timed_event_heap_s* heap, size_t index) {
+    timed_event* event = heap->events[index];
+    uint64_t deadline = timed_event_deadline(event);
+    while (1) {
+        size_t child = 2 * index + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count &&
+            timed_event_deadline(heap->events[child + 1]) < timed_event_deadline(heap->events[child])) {
+            child++;
+        }
+        if (deadline <= timed_event_deadline(heap->events[child])) break;
+        timed_event_heap_set(heap, index, heap->events[child]);
+        index = child;
+    }
+    timed_event_heap_set(heap, index, event);
+}
+
+static void timed_event_heap_insert(struct timed_event_heap_s* heap, timed_event* event) {
+    if (heap->count == heap->capacity) {
+        heap->capacity = heap->capacity ? heap->capacity * 2 : 16;
+        heap->events = rrealloc(heap->events, heap->capacity * sizeof(timed_event*));
+    }
+    timed_event_heap_set(heap, heap->count++, event);
+    timed_event_heap_sift_up(heap, event->heap_index);
+}
+
+static void timed_event_heap_remove(struct timed_event_heap_s* heap, timed_event* event) {
+    size_t index = event->heap_index;
+    timed_event* last = heap->events[--heap->count];
+    if (last != event) {
+        timed_event_heap_set(heap, index, last);
+        timed_event_heap_sift_up(heap, index);
+        timed_event_heap_sift_down(heap, last->heap_index);
+    }
+    if (heap->count == 0) {
+        // the event system has no destructor, so release the heap as soon as it is empty
+        rfree(heap->events);
+        heap->events = NULL;
+        heap->capacity = 0;
+    }
+}
+
+/**
+ * brings the position of the event in the timer heap of its event system up to date
+ * after timed_event::enabled or timed_event::last_call have been changed
+ * @param event the changed event
+ */
+static void timed_event_update_schedule(timed_event* event) {
+    if (!event->ev_sys) return;
+    struct timed_event_heap_s* heap = &event->ev_sys->timed_event_heap;
+    if (timed_event_heap_contains(event)) {
+        if (event->enabled) {
+            timed_event_heap_sift_up(heap, event->heap_index);
+            timed_event_heap_sift_down(heap, event->heap_index);
+        }
+        else {
+            timed_event_heap_remove(heap, event);
+        }
+    }
+    else if (event->enabled) {
+        timed_event_heap_insert(heap, event);
+    }
+}
+
 /**
  * reschedules the event to the current time + the event interval
  * resulting in a delay of the event
  * @param event the event to delay
  */
 void reschedule_event(timed_event * event) {
-    event->last_call = get_nanotime();
+    event->last_call = event_system_now();
+    timed_event_update_schedule(event);
 }
 
 /**
  * calculates the next timed event that has to be called and the time to wait for it
- * @param timed_events array of the events
- * @param len the lenght of the array
- * @param next_event_index the index of the next event will be written in here, can be NULL
+ * @param ev_sys the event system containing the timer heap
+ * @param next_timed_event the next event will be written in here, can be NULL
  * @param cur_time the current time
  * @return uint64_t the time to wait
  */
-uint64_t calc_next_timed_event(struct timed_event_linked_list_s* timed_events,
+uint64_t calc_next_timed_event(event_system* ev_sys,
                                timed_event** next_timed_event,
                                uint64_t cur_time) {
-    uint64_t time_to_wait = UINT64_MAX;
-    for (timed_event* current = timed_events->first; current; current = current->next) {
-        if (!current->enabled) continue;
-        uint64_t continue_at = current->last_call + current->interval;
-        if (continue_at <= cur_time) {
-            if (next_timed_event) {
-                *next_timed_event = current;
-            }
-            return 0;
-        }
-        uint64_t new_time_to_wait = continue_at - cur_time;
-        if (new_time_to_wait < time_to_wait) {
-            if (next_timed_event) {
-                *next_timed_event = current;
+    if (ev_sys->timed_event_heap.count == 0) return UINT64_MAX;
+    timed_event* next = ev_sys->timed_event_heap.events[0];
+    if (next_timed_event) {
+        *next_timed_event = next;
+    }
+    uint64_t continue_at = timed_event_deadline(next);
+    return continue_at <= cur_time ? 0 : continue_at - cur_time;
+}
+
+/**
+ * pins the calling thread to a single CPU
+ * @param cpu the CPU
+ * @param previous the CPUs the thread was allowed to run on before are written in here
+ * @return 1 if the thread was pinned, 0 if it runs where it did before
+ */
+static int pin_thread(int cpu, cpu_set_t* previous) {
+    cpu_set_t pinned;
+    if (cpu < 0 || cpu >= CPU_SETSIZE || pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), previous)) return 0;
+    CPU_ZERO(&pinned);
+    CPU_SET(cpu, &pinned);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &pinned)) {
+        fprintf(stderr, "could not pin the event loop to CPU %d\n", cpu);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * the part of the stack of a real-time loop that is faulted in before the first event
+ */
+#define EV_REALTIME_STACK_BYTES (128 * 1024)
+
+/**
+ * gives the thread of a loop a SCHED_FIFO priority
+ * @param priority the priority
+ * @param previous_policy the policy of the thread before is written in here
+ * @param previous the scheduling parameters of the thread before are written in here
+ * @return 1 if the priority was set, 0 if the thread keeps its policy
+ */
+static int set_realtime_priority(int priority, int* previous_policy, struct sched_param* previous) {
+    if (pthread_getschedparam(pthread_self(), previous_policy, previous)) return 0;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error) {
+        // needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least the priority
+        fprintf(stderr, "could not run the event loop with SCHED_FIFO priority %d: %s\n", priority, strerror(error));
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * touches the stack below the caller, so its pages are mapped and locked before the first event
+ */
+static __attribute__((noinline)) void prefault_stack(void) {
+    volatile unsigned char stack[EV_REALTIME_STACK_BYTES];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+/**
+ * locks the memory of the process into RAM. The allocator is told to keep freed memory instead of giving it back to
+ * the system, so a block that is allocated again does not fault
+ */
+static void lock_memory(void) {
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    // needs CAP_IPC_LOCK or an RLIMIT_MEMLOCK that holds the process
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        perror("could not lock the memory of the event loop");
+    }
+    prefault_stack();
+}
+
+/**
+ * @return 1 if the kernel reports locked memory of the process
+ */
+static int memory_is_locked(void) {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == NULL) return 0;
+    char line[128];
+    unsigned long locked_kb = 0;
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (sscanf(line, "VmLck: %lu kB", &locked_kb) == 1) break;
+    }
+    fclose(status);
+    return locked_kb > 0;
+}
+
+/**
+ * reads back the real-time settings of the thread and reports the ones that were asked for but not applied
+ * @param ev_sys the event loop, its realtime status is written
+ */
+static void check_realtime(event_system* ev_sys) {
+    event_realtime_status* status = &ev_sys->realtime;
+    memset(status, 0, sizeof(*status));
+
+    int policy;
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy == SCHED_FIFO) {
+        status->priority = param.sched_priority;
+    }
+    status->cpu = -1;
+    cpu_set_t cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus) == 0 && CPU_COUNT(&cpus) == 1) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpus)) {
+                status->cpu = cpu;
+                break;
             }
-            time_to_wait = new_time_to_wait;
         }
     }
-    return time_to_wait;
+    status->memory_locked = (char) memory_is_locked();
+
+    if ((ev_sys->realtime_priority > 0 && status->priority != ev_sys->realtime_priority) ||
+        (ev_sys->realtime_priority > 0 && ev_sys->pin_cpu && status->cpu != ev_sys->busy_poll_cpu) ||
+        (ev_sys->lock_memory && !status->memory_locked)) {
+        fprintf(stderr, "the event loop runs with priority %d on CPU %d and %s memory instead of the configured "
+                        "real-time settings\n", status->priority, status->cpu,
+                status->memory_locked ? "locked" : "unlocked");
+    }
 }
 
 /**
@@ -166,27 +643,67 @@ uint64_t calc_next_timed_event(struct timed_event_linked_list_s* timed_events,
  * Can be modified from the calling thread while running.
  */
 void event_system_start(event_system* ev_sys) {
-    uint64_t cur_time = get_nanotime();
+#ifdef ENABLE_EPOLL
+    if (epoll_open(ev_sys)) return;
+#endif
+    cpu_set_t previous_cpus;
+    int pinned = (ev_sys->busy_poll || ev_sys->realtime_priority > 0) && ev_sys->pin_cpu &&
+                 pin_thread(ev_sys->busy_poll_cpu, &previous_cpus);
+    int previous_policy;
+    struct sched_param previous_param;
+    int scheduled = ev_sys->realtime_priority > 0 &&
+                    set_realtime_priority(ev_sys->realtime_priority, &previous_policy, &previous_param);
+    if (ev_sys->lock_memory) {
+        lock_memory();
+    }
+    if (ev_sys->realtime_priority > 0 || ev_sys->lock_memory) {
+        check_realtime(ev_sys);
+    } else {
+        memset(&ev_sys->realtime, 0, sizeof(ev_sys->realtime));
+        ev_sys->realtime.cpu = -1;
+    }
+    // an event loop can be started in the callback of another one, restore its time when this loop stops
+    evtime_t outer_loop_time = loop_time;
+    // a loop on a virtual clock only looks at the fds and jumps to the next timed event if none is ready
+    int virtual_time = ev_sys->clock != NULL && ev_sys->clock->read == NULL;
+    uint64_t cur_time = event_system_tick(ev_sys);
+    // all events start now, rebuild the timer heap from the event list
+    ev_sys->timed_event_heap.count = 0;
     for (timed_event* current = ev_sys->timed_events.first; current; current = current->next) {
         current->last_call = cur_time;
+        current->ev_sys = ev_sys;
+        if (current->enabled) {
+            timed_event_heap_insert(&ev_sys->timed_event_heap, current);
+        }
+    }
+    if (ev_sys->timed_event_heap.count == 0) {
+        rfree(ev_sys->timed_event_heap.events);
+        ev_sys->timed_event_heap.events = NULL;
+        ev_sys->timed_event_heap.capacity = 0;
     }
     while (1) {
         timed_event* next_event;
-        cur_time = get_nanotime();
-        uint64_t time_to_wait = calc_next_timed_event(&ev_sys->timed_events, &next_event, cur_time);
+        cur_time = event_system_tick(ev_sys);
+        uint64_t time_to_wait = calc_next_timed_event(ev_sys, &next_event, cur_time);
         if (time_to_wait == UINT64_MAX) {
             // there are no active events - just wait for fd events
-            int result = event_system_sleep(~0, &ev_sys->fd_events);
+            int result = event_system_sleep(ev_sys->busy_poll ? 0 : ~0, ev_sys);
             if (result == -1) {
                 break;
             }
             continue;
         }
         else if (time_to_wait != 0) {
-            int result = event_system_sleep(time_to_wait, &ev_sys->fd_events);
+            // a busy polling loop only looks at the fds and comes back to check the clock
+            int result = event_system_sleep(ev_sys->busy_poll || virtual_time ? 0 : time_to_wait, ev_sys);
             if (result == -1) {
                 // select failed, exit loop
-                return;
+                break;
+            }
+            else if (result == 0 && virtual_time) {
+                // nothing happens before the timed event is due
+                ev_sys->clock->virtual_now += time_to_wait;
+                continue;
             }
             else if (result >= 0) {
                 // the sleep didn't time out, but a fd event occured
@@ -194,13 +711,32 @@ void event_system_start(event_system* ev_sys) {
                 continue;
             }
         }
+        if (ev_sys->lag_histogram) {
+            rasta_histogram_record(ev_sys->lag_histogram, (loop_time - timed_event_deadline(next_event)) / 1000);
+        }
         // fire event and exit in case it returns something else than 0
-        if (next_event->callback(next_event->carry_data)) {
+        ev_sys->firing_event = next_event;
+        if (event_system_call(ev_sys, next_event->callback, next_event->carry_data, timed_event_deadline(next_event))) {
+            ev_sys->firing_event = NULL;
             break;
         }
-        // update timed_event::last_call
-        next_event->last_call = cur_time + time_to_wait;
+        // update timed_event::last_call, unless the callback removed the event
+        if (ev_sys->firing_event == next_event) {
+            next_event->last_call = cur_time + time_to_wait;
+            timed_event_update_schedule(next_event);
+        }
+        ev_sys->firing_event = NULL;
     }
+    loop_time = outer_loop_time;
+    if (scheduled) {
+        pthread_setschedparam(pthread_self(), previous_policy, &previous_param);
+    }
+    if (pinned) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous_cpus);
+    }
+#ifdef ENABLE_EPOLL
+    epoll_close(ev_sys);
+#endif
 }
 
 /**
@@ -218,6 +754,7 @@ void enable_timed_event(timed_event* event) {
  */
 void disable_timed_event(timed_event* event) {
     event->enabled = 0;
+    timed_event_update_schedule(event);
 }
 
 /**
@@ -226,6 +763,11 @@ void disable_timed_event(timed_event* event) {
  */
 void enable_fd_event(fd_event* event) {
     event->enabled = 1;
+#ifdef ENABLE_EPOLL
+    if (event->ev_sys && event->ev_sys->running) {
+        epoll_update_fd_event(event, EPOLL_CTL_MOD);
+    }
+#endif
 }
 
 /**
@@ -234,6 +776,11 @@ void enable_fd_event(fd_event* event) {
  */
 void disable_fd_event(fd_event* event) {
     event->enabled = 0;
+#ifdef ENABLE_EPOLL
+    if (event->ev_sys && event->ev_sys->running) {
+        epoll_update_fd_event(event, EPOLL_CTL_MOD);
+    }
+#endif
 }
 
 /**
@@ -257,6 +804,8 @@ void add_timed_event(event_system* ev_sys, timed_event* event) {
         event->next = NULL;
         event->prev = NULL;
     }
+    event->ev_sys = ev_sys;
+    timed_event_update_schedule(event);
 }
 
 /**
@@ -266,6 +815,13 @@ void add_timed_event(event_system* ev_sys, timed_event* event) {
  * @param event the event to add
  */
 void remove_timed_event(event_system* ev_sys, timed_event* event) {
+    if (timed_event_heap_contains(event)) {
+        timed_event_heap_remove(&ev_sys->timed_event_heap, event);
+    }
+    if (ev_sys->firing_event == event) {
+        ev_sys->firing_event = NULL;
+    }
+    event->ev_sys = NULL;
     // simple linked list remove
     if (ev_sys->timed_events.first == event) {
         ev_sys->timed_events.first = ev_sys->timed_events.first->next;
@@ -301,6 +857,12 @@ void add_fd_event(event_system* ev_sys, fd_event* event, int options) {
     }
 
     event->options = options;
+#ifdef ENABLE_EPOLL
+    event->ev_sys = ev_sys;
+    if (ev_sys->running) {
+        epoll_update_fd_event(event, EPOLL_CTL_ADD);
+    }
+#endif
 }
 
 /**
@@ -318,4 +880,126 @@ void remove_fd_event(event_system* ev_sys, fd_event* event) {
     }
     if (event->prev) event->prev->next = event->next;
     if (event->next) event->next->prev = event->prev;
+#ifdef ENABLE_EPOLL
+    if (ev_sys->running) {
+        epoll_update_fd_event(event, EPOLL_CTL_DEL);
+        // the event may still be pending in the current epoll_wait() result
+        for (int i = ev_sys->ready_index + 1; i < ev_sys->ready_count; i++) {
+            if (ev_sys->ready_events[i].data.ptr == event) {
+                ev_sys->ready_events[i].data.ptr = NULL;
+            }
+        }
+    }
+    event->ev_sys = NULL;
+#endif
+}
+
+/**
+ * a function that another thread posted to the loop
+ */
+struct event_task {
+    event_ptr callback;
+    void* carry_data;
+};
+
+/**
+ * signals the eventfd of the posted tasks unless it is signaled already
+ * @param ev_sys the event system
+ */
+static void event_system_signal_tasks(event_system* ev_sys) {
+    if (!__atomic_exchange_n(&ev_sys->tasks_signaled, 1, __ATOMIC_SEQ_CST)) {
+        rasta_handle_notify(ev_sys->tasks_fd);
+    }
+}
+
+/**
+ * runs the posted tasks, at most EV_TASK_BATCH of them
+ * @param carry_data the event system
+ * @return the result of the task that stopped the loop, 0 otherwise
+ */
+static int event_system_run_tasks(void* carry_data) {
+    event_system* ev_sys = carry_data;
+
+    // the signal is taken before the queue is read, so a task that is posted meanwhile signals the eventfd again
+    __atomic_store_n(&ev_sys->tasks_signaled, 0, __ATOMIC_SEQ_CST);
+    uint64_t count;
+    ssize_t ignore = read(ev_sys->tasks_fd, &count, sizeof(count));
+    (void) ignore;
+
+    int result = 0;
+    for (unsigned int i = 0; i < EV_TASK_BATCH && result == 0; i++) {
+        struct event_task* slot = mpsc_queue_front(ev_sys->tasks);
+        if (slot == NULL) {
+            return 0;
+        }
+        struct event_task task = *slot;
+        mpsc_queue_release(ev_sys->tasks);
+
+        result = task.callback(task.carry_data);
+    }
+
+    // the remaining tasks run after the other events had their turn, or when the loop is started again
+    if (mpsc_queue_front(ev_sys->tasks) != NULL) {
+        event_system_signal_tasks(ev_sys);
+    }
+    return result;
+}
+
+void event_system_enable_posting(event_system* ev_sys, unsigned int capacity) {
+    if (ev_sys->tasks != NULL) {
+        return;
+    }
+
+    ev_sys->tasks_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ev_sys->tasks_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+    ev_sys->tasks_signaled = 0;
+
+    memset(&ev_sys->tasks_event, 0, sizeof(fd_event));
+    ev_sys->tasks_event.callback = event_system_run_tasks;
+    ev_sys->tasks_event.carry_data = ev_sys;
+    ev_sys->tasks_event.fd = ev_sys->tasks_fd;
+    enable_fd_event(&ev_sys->tasks_event);
+    add_fd_event(ev_sys, &ev_sys->tasks_event, EV_READABLE);
+
+    // the queue is published last, event_system_post() checks it
+    __atomic_store_n(&ev_sys->tasks, mpsc_queue_init(capacity, sizeof(struct event_task)), __ATOMIC_RELEASE);
+}
+
+void event_system_disable_posting(event_system* ev_sys) {
+    if (ev_sys->tasks == NULL) {
+        return;
+    }
+
+    remove_fd_event(ev_sys, &ev_sys->tasks_event);
+    close(ev_sys->tasks_fd);
+    ev_sys->tasks_fd = -1;
+    mpsc_queue_destroy(ev_sys->tasks);
+    ev_sys->tasks = NULL;
+}
+
+int event_system_post(event_system* ev_sys, event_ptr callback, void* carry_data) {
+    struct mpsc_queue* tasks = __atomic_load_n(&ev_sys->tasks, __ATOMIC_ACQUIRE);
+    if (tasks == NULL) {
+        return 0;
+    }
+
+    struct event_task* task = mpsc_queue_reserve(tasks);
+    if (task == NULL) {
+        return 0;
+    }
+    task->callback = callback;
+    task->carry_data = carry_data;
+    mpsc_queue_commit(tasks, task);
+
+    event_system_signal_tasks(ev_sys);
+    return 1;
+}
+
+void event_system_wakeup(event_system* ev_sys) {
+    if (__atomic_load_n(&ev_sys->tasks, __ATOMIC_ACQUIRE) != NULL) {
+        event_system_signal_tasks(ev_sys);
+    }
 }
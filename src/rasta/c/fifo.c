@@ -1,73 +1,142 @@
-#include <fifo.h>
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_FIFO
+#include <stdatomic.h>
 #include "fifo.h"
 #include "rmemory.h"
-#include <stdlib.h>
+
+struct fifo {
+    /**
+     * the slots of the ring, a power of 2 that is at least max_size, so the slot of a counter stays the same when
+     * the counter wraps around
+     */
+    void ** elements;
+    /**
+     * The maximum amount of elements in the FIFO
+     */
+    unsigned int max_size;
+    /**
+     * the amount of slots minus 1
+     */
+    unsigned int mask;
+    /**
+     * amount of elements that were popped so far, only written by the consumer.
+     * The first (oldest) element is at head & mask
+     */
+    atomic_uint head;
+    /**
+     * amount of elements that were pushed so far, only written by the producer.
+     * The next element is added at tail & mask
+     */
+    atomic_uint tail;
+};
+
+/**
+ * @return the amount of slots for @p max_size elements, the smallest power of 2 that is not smaller, at least 1
+ */
+static unsigned int slot_count(unsigned int max_size){
+    unsigned int count = 1;
+    while (count < max_size){
+        count <<= 1;
+    }
+    return count;
+}
+
+static void init_counters(fifo_t * fifo, unsigned int max_size){
+    fifo->max_size = max_size;
+    fifo->mask = slot_count(max_size) - 1;
+    atomic_init(&fifo->head, 0);
+    atomic_init(&fifo->tail, 0);
+}
+
+void fifo_reset(fifo_t * fifo, unsigned int position){
+    atomic_store_explicit(&fifo->head, position, memory_order_relaxed);
+    atomic_store_explicit(&fifo->tail, position, memory_order_relaxed);
+}
 
 fifo_t * fifo_init(unsigned int max_size){
     fifo_t * fifo = rmalloc(sizeof(fifo_t));
 
-    fifo->size = 0;
-    fifo->max_size = max_size;
-    fifo->head = NULL;
-    fifo->tail = NULL;
+    fifo->elements = rmalloc(slot_count(max_size) * sizeof(void *));
+    init_counters(fifo, max_size);
 
     return fifo;
 }
 
-void * fifo_pop(fifo_t * fifo){
-    void * res= NULL;
+/**
+ * the size of the FIFO structure, rounded up so the slots behind it are aligned
+ */
+#define FIFO_HEADER_SIZE ((sizeof(fifo_t) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+size_t fifo_memory_size(unsigned int max_size){
+    return FIFO_HEADER_SIZE + slot_count(max_size) * sizeof(void *);
+}
 
-    if (fifo->size > 0 && fifo->head != NULL && fifo->tail != NULL){
-        struct fifo_element * element = fifo->head;
-        res = element->data;
-        fifo->head = fifo->head->next;
+fifo_t * fifo_init_in(void * memory, unsigned int max_size){
+    fifo_t * fifo = memory;
+
+    fifo->elements = (void **) ((unsigned char *) memory + FIFO_HEADER_SIZE);
+    init_counters(fifo, max_size);
+
+    return fifo;
+}
 
-        if (fifo->size == 1){
-            fifo->tail = NULL;
-        }
+void * fifo_pop(fifo_t * fifo){
+    unsigned int head = atomic_load_explicit(&fifo->head, memory_order_relaxed);
+    // pairs with the release in fifo_push, so the slot is written before it is read
+    unsigned int tail = atomic_load_explicit(&fifo->tail, memory_order_acquire);
 
-        rfree(element);
-        fifo->size--;
+    if (head == tail){
+        return NULL;
     }
 
+    void * res = fifo->elements[head & fifo->mask];
+    atomic_store_explicit(&fifo->head, head + 1, memory_order_release);
+
     return res;
 }
 
+void * fifo_peek(fifo_t * fifo){
+    unsigned int head = atomic_load_explicit(&fifo->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&fifo->tail, memory_order_acquire);
+
+    if (head == tail){
+        return NULL;
+    }
+
+    return fifo->elements[head & fifo->mask];
+}
+
 int fifo_push(fifo_t * fifo, void * element){
     if (element == NULL){
         return 0;
     }
 
-    if (fifo->size == fifo->max_size){
+    unsigned int tail = atomic_load_explicit(&fifo->tail, memory_order_relaxed);
+    // pairs with the release in fifo_pop, so the slot is not overwritten before it is read
+    unsigned int head = atomic_load_explicit(&fifo->head, memory_order_acquire);
+
+    // the counters wrap around, their difference stays the amount of elements
+    if (tail - head == fifo->max_size){
         return 0;
     }
 
-    struct fifo_element * new_entry = rmalloc(sizeof(struct fifo_element));
-    new_entry->data = element;
-    new_entry->next = NULL;
-
-    if (fifo->size == 0){
-        fifo->head = new_entry;
-        fifo->tail = fifo->head;
-    } else {
-        fifo->tail->next = new_entry;
-        fifo->tail = new_entry;
-    }
+    fifo->elements[tail & fifo->mask] = element;
+    atomic_store_explicit(&fifo->tail, tail + 1, memory_order_release);
 
-    fifo->size++;
     return 1;
 }
 
 unsigned int fifo_get_size(fifo_t * fifo){
-    unsigned int size = fifo->size;
+    unsigned int head = atomic_load_explicit(&fifo->head, memory_order_acquire);
+    unsigned int tail = atomic_load_explicit(&fifo->tail, memory_order_acquire);
 
-    return size;
+    return tail - head;
 }
 
-void fifo_destroy(fifo_t * fifo){
-    for (unsigned int i = 0; i < fifo->size; ++i) {
-        fifo_pop(fifo);
-    }
+unsigned int fifo_get_capacity(fifo_t * fifo){
+    return fifo->max_size;
+}
 
+void fifo_destroy(fifo_t * fifo){
+    rfree(fifo->elements);
     rfree(fifo);
 }
@@ -1,7 +1,12 @@
 //
 // Created by erica on 03/07/2022.
 //
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_CODEC
 #include <endian.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <sys/mman.h>
 
 #include <rastahandle.h>
@@ -42,12 +47,165 @@ int key_exchange_prepare_credential_request(struct key_exchange_state *kex_state
                    "Could not lock client pages!");
         return ret;
     }
+    kex_state->secret_owner = NULL;
     kex_state->password_length = password_length;
 
     return opaque_CreateCredentialRequest((const uint8_t *) psk, password_length, kex_state->client_secret,
                                           kex_state->client_public);
 }
 
+int key_exchange_secrets_init(struct key_exchange_secrets *secrets, struct logger_t *logger) {
+    size_t records_length = KEX_RECORD_CACHE_SLOTS * sizeof(struct key_exchange_record);
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t length = (records_length + KEX_SECRET_SLOTS * KEX_SECRET_SLOT_SIZE + page - 1) / page * page;
+
+    memset(secrets, 0, sizeof(*secrets));
+    pthread_mutex_init(&secrets->lock, NULL);
+
+    void *pages = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    // make sure the data cannot be stolen from swap partition or core dumps
+    if (mlock(pages, length)) {
+        logger_log(logger, LOG_LEVEL_ERROR, "key_exchange:key_exchange_secrets_init",
+                   "Could not lock %lu bytes for the key exchange secrets: %s", length, strerror(errno));
+        munmap(pages, length);
+        return 1;
+    }
+    madvise(pages, length, MADV_DONTDUMP);
+
+    secrets->pages = pages;
+    secrets->pages_length = length;
+    secrets->records = pages;
+    secrets->secret_slots = (uint8_t *) pages + records_length;
+    return 0;
+}
+
+void key_exchange_secrets_free(struct key_exchange_secrets *secrets) {
+    if (secrets->pages != NULL) {
+        memset(secrets->pages, 0, secrets->pages_length);
+        munlock(secrets->pages, secrets->pages_length);
+        munmap(secrets->pages, secrets->pages_length);
+        secrets->pages = NULL;
+    }
+    pthread_mutex_destroy(&secrets->lock);
+}
+
+/**
+ * @return the slot of the record cache the user record of the RaSTA IDs is kept in first
+ */
+static unsigned int record_home(uint32_t my_id, uint32_t remote_id) {
+    return ((my_id * 0x9E3779B1u) ^ remote_id) % KEX_RECORD_CACHE_SLOTS;
+}
+
+int key_exchange_prepare_from_psk_cached(struct key_exchange_secrets *secrets, struct key_exchange_state *kex_state,
+                                         const char *psk, const uint32_t my_id, const uint32_t remote_id,
+                                         struct logger_t *logger) {
+    if (secrets->pages == NULL) {
+        return key_exchange_prepare_from_psk(kex_state, psk, my_id, remote_id, logger);
+    }
+
+    unsigned int home = record_home(my_id, remote_id);
+    struct key_exchange_record *free_record = NULL;
+    pthread_mutex_lock(&secrets->lock);
+    for (unsigned int i = 0; i < KEX_RECORD_CACHE_SLOTS; i++) {
+        struct key_exchange_record *record = &secrets->records[(home + i) % KEX_RECORD_CACHE_SLOTS];
+        if (!record->used) {
+            free_record = record;
+            break;
+        }
+        if (record->my_id == my_id && record->remote_id == remote_id) {
+            memcpy(kex_state->user_record, record->user_record, sizeof(kex_state->user_record));
+            secrets->record_hits++;
+            pthread_mutex_unlock(&secrets->lock);
+            return 0;
+        }
+    }
+    secrets->record_misses++;
+    pthread_mutex_unlock(&secrets->lock);
+
+    // the registration runs without the lock, a concurrent one for the same IDs derives an equally valid record
+    int ret = key_exchange_prepare_from_psk(kex_state, psk, my_id, remote_id, logger);
+    if (ret) {
+        return ret;
+    }
+
+    pthread_mutex_lock(&secrets->lock);
+    struct key_exchange_record *record = free_record != NULL && !free_record->used ? free_record
+                                                                                    : &secrets->records[home];
+    record->my_id = my_id;
+    record->remote_id = remote_id;
+    record->used = 1;
+    memcpy(record->user_record, kex_state->user_record, sizeof(record->user_record));
+    pthread_mutex_unlock(&secrets->lock);
+    return 0;
+}
+
+/**
+ * gives a client secret back to the pool it was lent from and erases it
+ * @param secrets the pool
+ * @param client_secret the client secret
+ */
+static void secrets_release(struct key_exchange_secrets *secrets, uint8_t *client_secret) {
+    unsigned int slot = (unsigned int) ((client_secret - secrets->secret_slots) / KEX_SECRET_SLOT_SIZE);
+    memset(client_secret, 0, KEX_SECRET_SLOT_SIZE);
+    pthread_mutex_lock(&secrets->lock);
+    secrets->secret_taken[slot] = 0;
+    pthread_mutex_unlock(&secrets->lock);
+}
+
+int key_exchange_prepare_credential_request_pooled(struct key_exchange_secrets *secrets,
+                                                   struct key_exchange_state *kex_state, const char *psk,
+                                                   struct logger_t *logger) {
+    const size_t password_length = strlen(psk);
+    uint8_t *client_secret = NULL;
+
+    if (secrets->pages != NULL && password_length <= KEX_PSK_MAX) {
+        pthread_mutex_lock(&secrets->lock);
+        for (unsigned int i = 0; i < KEX_SECRET_SLOTS; i++) {
+            if (!secrets->secret_taken[i]) {
+                secrets->secret_taken[i] = 1;
+                client_secret = secrets->secret_slots + i * KEX_SECRET_SLOT_SIZE;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&secrets->lock);
+    }
+    if (client_secret == NULL) {
+        return key_exchange_prepare_credential_request(kex_state, psk, logger);
+    }
+
+    kex_state->client_secret = client_secret;
+    kex_state->secret_owner = secrets;
+    kex_state->password_length = password_length;
+
+    return opaque_CreateCredentialRequest((const uint8_t *) psk, password_length, kex_state->client_secret,
+                                          kex_state->client_public);
+}
+
+int key_exchange_discard_credential_request(struct key_exchange_state *kex_state) {
+    int ret;
+
+    if (kex_state->client_secret == NULL) {
+        return 0;
+    }
+    // make sure the secret is destroyed properly
+    if (kex_state->secret_owner) {
+        secrets_release(kex_state->secret_owner, kex_state->client_secret);
+        kex_state->secret_owner = NULL;
+        kex_state->client_secret = NULL;
+        return 0;
+    }
+    size_t length = kex_state->password_length + OPAQUE_USER_SESSION_SECRET_LEN;
+    memset(kex_state->client_secret, 0, length);
+    ret = munlock(kex_state->client_secret, length);
+    free(kex_state->client_secret);
+    kex_state->client_secret = NULL;
+    return ret;
+}
+
 int kex_prepare_credential_response(struct key_exchange_state *kex_state,
                                              const uint8_t *received_client_public,
                                              const size_t received_client_public_length,
@@ -93,14 +251,10 @@ int kex_recover_credential(struct key_exchange_state *kex_state,
         logger_log(logger,LOG_LEVEL_ERROR, "key_exchange:kex_recover_credential",
                    "Recovering credentials failed: %d!",ret);
     }
-    // make sure the secret is destroyed properly
-    memset(kex_state->client_secret,0,kex_state->password_length);
-    munlock_ret = munlock(kex_state->client_secret,kex_state->password_length);
+    munlock_ret = key_exchange_discard_credential_request(kex_state);
     if(munlock_ret){
         logger_log(logger, LOG_LEVEL_ERROR, "kex_exchange:kex_recover_credential","munlock failed: %s", strerror(errno));
     }
-    free(kex_state->client_secret);
-    kex_state->client_secret = NULL;
 
     return ret;
 }
@@ -1,6 +1,10 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_LOGGING
 #include <time.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
 #include <sys/time.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -12,6 +16,49 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <ctype.h>
+#include "mpscqueue.h"
+#include "rastatrace.h"
+
+/**
+ * size of the stdio buffer of the log file of an asynchronous logger
+ */
+#define LOGGER_ASYNC_FILE_BUFFER_SIZE 65536
+
+/**
+ * a formatted log message, the element type of the ring of an asynchronous logger
+ */
+struct logger_record {
+    unsigned int length;
+    char text[LOGGER_ASYNC_RECORD_SIZE];
+};
+
+struct logger_async {
+    /**
+     * the formatted messages, any thread may add to it while only the writer thread takes them out
+     */
+    mpsc_queue_t * records;
+
+    /**
+     * the amount of messages that did not fit into the ring and the amount the writer already reported
+     */
+    atomic_ulong dropped;
+    unsigned long reported_dropped;
+
+    /**
+     * the log file that stays open while the logger exists, NULL if only the console is used
+     */
+    FILE * file;
+    int to_console;
+
+    pthread_t writer;
+
+    /**
+     * eventfd that wakes up the writer thread while sleeping is set
+     */
+    int notify_fd;
+    atomic_int sleeping;
+    atomic_int stopping;
+};
 
 /**
  * logs a string to the console
@@ -54,14 +101,17 @@ void log_to_file(const char * message, const char * log_file){
  * @param level the log level of the message to log
  * @param location the location the log message occurred
  * @param msg_str the log message
- * @return the log message string
+ * @param out the log message string is written in here
+ * @param size the size of @p out, longer log message strings are truncated
+ * @return 1 if the log message string was generated, 0 if the log level is too low
  */
-char * get_log_message_string(log_level max_log_level, log_level level, char * location, char * msg_str){
+static int get_log_message_string(log_level max_log_level, log_level level, char * location, char * msg_str,
+                                  char * out, size_t size){
 
     // check if maximum log level allows this message
     if (level > max_log_level){
         // not allowed, return
-        return NULL;
+        return 0;
     }
 
     // generate timestamp
@@ -103,10 +153,9 @@ char * get_log_message_string(log_level max_log_level, log_level level, char * l
     // add milliseconds to timestamp
     sprintf(timestamp2, "%s (Epoch time: %llu)", timestamp, millisecondsSinceEpoch);
 
-    char *  msg_string = rmalloc(LOGGER_MAX_MSG_SIZE);
-    sprintf(msg_string, LOG_FORMAT, timestamp2, level_str, location, msg_str);
+    snprintf(out, size, LOG_FORMAT, timestamp2, level_str, location, msg_str);
 
-    return msg_string;
+    return 1;
 }
 
 struct logger_t logger_init(log_level max_log_level, logger_type type){
@@ -115,9 +164,8 @@ struct logger_t logger_init(log_level max_log_level, logger_type type){
     logger.type = type;
     logger.max_log_level = max_log_level;
     logger.log_file = NULL;
-
-    // init the buffer FIFO
-    logger.buffer = fifo_init(LOGGER_BUFFER_SIZE);
+    logger.async = NULL;
+    logger.trace = NULL;
 
     return logger;
 }
@@ -126,7 +174,144 @@ void logger_set_log_file(struct logger_t* logger, char * path){
     logger->log_file = path;
 }
 
+/**
+ * writes the messages of an asynchronous logger, until the logger is destroyed
+ * @param carry_data the struct logger_async of the logger
+ * @return NULL
+ */
+static void * logger_write_run(void * carry_data) {
+    struct logger_async * async = carry_data;
+
+    while (1) {
+        // the messages that were added before the logger was destroyed are still written
+        int stopping = atomic_load(&async->stopping);
+
+        struct logger_record * record;
+        while ((record = mpsc_queue_front(async->records)) != NULL) {
+            if (async->to_console) {
+                fwrite(record->text, 1, record->length, stdout);
+            }
+            if (async->file != NULL) {
+                fwrite(record->text, 1, record->length, async->file);
+            }
+            mpsc_queue_release(async->records);
+        }
+
+        unsigned long dropped = atomic_load_explicit(&async->dropped, memory_order_relaxed);
+        if (dropped != async->reported_dropped) {
+            char notice[64];
+            int length = snprintf(notice, sizeof(notice), "[logger] %lu log messages dropped\n",
+                                  dropped - async->reported_dropped);
+            if (async->to_console) {
+                fwrite(notice, 1, length, stdout);
+            }
+            if (async->file != NULL) {
+                fwrite(notice, 1, length, async->file);
+            }
+            async->reported_dropped = dropped;
+        }
+
+        // the buffered messages are flushed once the ring is empty
+        if (async->to_console) {
+            fflush(stdout);
+        }
+        if (async->file != NULL) {
+            fflush(async->file);
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        atomic_store(&async->sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mpsc_queue_front(async->records) == NULL && !atomic_load(&async->stopping)) {
+            uint64_t value;
+            ssize_t result = read(async->notify_fd, &value, sizeof(value));
+            (void) result;
+        }
+        atomic_store(&async->sleeping, 0);
+    }
+
+    return NULL;
+}
+
+void logger_enable_async(struct logger_t * logger, unsigned int record_count) {
+    struct logger_async * async = rmalloc(sizeof(struct logger_async));
+
+    async->records = mpsc_queue_init(record_count, sizeof(struct logger_record));
+    atomic_init(&async->dropped, 0);
+    async->reported_dropped = 0;
+    atomic_init(&async->sleeping, 0);
+    atomic_init(&async->stopping, 0);
+
+    async->to_console = logger->type == LOGGER_TYPE_CONSOLE || logger->type == LOGGER_TYPE_BOTH;
+    async->file = NULL;
+    if (logger->type == LOGGER_TYPE_FILE || logger->type == LOGGER_TYPE_BOTH) {
+        async->file = fopen(logger->log_file, "a");
+        if (async->file == NULL) {
+            perror("Could not open log file");
+            exit(1);
+        }
+        setvbuf(async->file, NULL, _IOFBF, LOGGER_ASYNC_FILE_BUFFER_SIZE);
+    }
+
+    async->notify_fd = eventfd(0, EFD_CLOEXEC);
+    if (async->notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+
+    if (pthread_create(&async->writer, NULL, logger_write_run, async) != 0) {
+        perror("Could not create logger thread");
+        exit(1);
+    }
+
+    logger->async = async;
+}
+
+unsigned long logger_dropped_messages(const struct logger_t * logger) {
+    if (logger->async == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(&logger->async->dropped, memory_order_relaxed);
+}
+
+/**
+ * copies a message into the ring of an asynchronous logger and wakes up the writer thread if it is sleeping
+ * @param async the asynchronous logger
+ * @param msg the message
+ */
+static void enqueue_log_message(struct logger_async * async, const char * msg) {
+    struct logger_record * record = mpsc_queue_reserve(async->records);
+    if (record == NULL) {
+        atomic_fetch_add_explicit(&async->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    size_t length = strlen(msg);
+    if (length > sizeof(record->text)) {
+        length = sizeof(record->text);
+    }
+    memcpy(record->text, msg, length);
+    record->length = (unsigned int) length;
+    mpsc_queue_commit(async->records, record);
+
+    // the writer checks the ring again after it set sleeping, so either it sees the record or it is woken up
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_exchange(&async->sleeping, 0)) {
+        uint64_t value = 1;
+        ssize_t written = write(async->notify_fd, &value, sizeof(value));
+        (void) written;
+    }
+}
+
 static void do_log_message(struct logger_t *logger, const char *msg) {
+    if (logger->async != NULL) {
+        enqueue_log_message(logger->async, msg);
+        return;
+    }
+
     logger_type type = logger->type;
     char *file = logger->log_file;
     if (type == LOGGER_TYPE_CONSOLE) {
@@ -142,7 +327,7 @@ static void do_log_message(struct logger_t *logger, const char *msg) {
 }
 }
 
-void logger_log(struct logger_t * logger, log_level level, char* location, char* format, ...){
+void (logger_log)(struct logger_t * logger, log_level level, char* location, char* format, ...){
     if (logger == NULL || logger->max_log_level == LOG_LEVEL_NONE){
         return;
     }
@@ -151,19 +336,18 @@ void logger_log(struct logger_t * logger, log_level level, char* location, char*
     va_list args;
     va_start(args, format);
 
-    vsprintf(&message[0], format, args);
+    vsnprintf(&message[0], sizeof(message), format, args);
     va_end(args);
 
-    log_level max_lvl = logger->max_log_level;
-    char * msg = get_log_message_string(max_lvl, level, location, message);
-    if (msg == NULL){
+    char msg[LOGGER_MAX_MSG_SIZE];
+    if (!get_log_message_string(logger->max_log_level, level, location, message, msg, sizeof(msg))){
         // log level to low
         return;
     }
     do_log_message(logger, msg);
 }
 
-void logger_hexdump(struct logger_t *logger, log_level level, const void *data, size_t data_length, char *header_fmt, ...){
+void (logger_hexdump)(struct logger_t *logger, log_level level, const void *data, size_t data_length, char *header_fmt, ...){
     char message[LOGGER_MAX_MSG_SIZE / 2];
     char *data_char = (char *) data;
     va_list args;
@@ -177,27 +361,20 @@ void logger_hexdump(struct logger_t *logger, log_level level, const void *data,
     logger_log(logger,level,"","%s\n", message);
     if(level <= logger->max_log_level) {
         for (size_t line_start = 0; line_start < data_length; line_start += 16) {
-            char line_number[LOGGER_MAX_MSG_SIZE/2];
-            snprintf(line_number,LOGGER_MAX_MSG_SIZE / 2,"0x%04lx    ",line_start);
-            do_log_message(logger,line_number);
+            // every line is logged at once: offset, 16 bytes in hex and the printable characters
+            char line[128];
+            int length = snprintf(line, sizeof(line), "0x%04lx    ", line_start);
             for (size_t line_cur = line_start; line_cur < data_length && line_cur < line_start + 16; line_cur++) {
-                char msg[3];
-                snprintf(msg,3,"%02"PRIx8,(uint8_t)data_char[line_cur]);
-                do_log_message(logger,msg);
+                length += snprintf(&line[length], sizeof(line) - length, "%02"PRIx8, (uint8_t)data_char[line_cur]);
             }
-            do_log_message(logger,"    ");
+            length += snprintf(&line[length], sizeof(line) - length, "    ");
             for (size_t line_cur = line_start; line_cur < data_length && line_cur < line_start + 16; line_cur++) {
-                char msg[3];
                 char current = data_char[line_cur];
-                if(isprint(current)) {
-                    snprintf(msg, 3, "%c", current);
-                }
-                else{
-                    snprintf(msg,3,".");
-                }
-                do_log_message(logger,msg);
+                line[length++] = isprint(current) ? current : '.';
             }
-            do_log_message(logger,"\n");
+            line[length++] = '\n';
+            line[length] = 0;
+            do_log_message(logger, line);
         }
     }
 }
@@ -217,28 +394,44 @@ void logger_log_if(struct logger_t * logger, int cond, log_level level, char * l
     va_list args;
     va_start(args, format);
 
-    vsprintf(&message[0], format, args);
+    vsnprintf(&message[0], sizeof(message), format, args);
     va_end(args);
 
-    log_level max_lvl = logger->max_log_level;
-
-    char * msg = get_log_message_string(max_lvl, level, location, message);
-    if (msg == NULL){
+    char msg[LOGGER_MAX_MSG_SIZE];
+    if (!get_log_message_string(logger->max_log_level, level, location, message, msg, sizeof(msg))){
         // log level to low
         return;
     }
+    do_log_message(logger, msg);
+}
 
-    // add message string to the write buffer
-    fifo_push(logger->buffer, msg);
+void logger_enable_trace(struct logger_t * logger, const char * path, unsigned int record_count) {
+    logger->trace = rasta_trace_open(path, record_count);
 }
 
 void logger_destroy(struct logger_t * logger){
+    if (logger->trace != NULL) {
+        rasta_trace_close(logger->trace);
+        logger->trace = NULL;
+    }
 
-    // free all remaining log messages
-    char * elem;
-    while ((elem = fifo_pop(logger->buffer)) != NULL) {
-        rfree(elem);
+    struct logger_async * async = logger->async;
+    if (async == NULL) {
+        return;
     }
 
-    fifo_destroy(logger->buffer);
+    // the writer writes the remaining messages before it returns
+    atomic_store(&async->stopping, 1);
+    uint64_t value = 1;
+    ssize_t written = write(async->notify_fd, &value, sizeof(value));
+    (void) written;
+    pthread_join(async->writer, NULL);
+
+    close(async->notify_fd);
+    if (async->file != NULL) {
+        fclose(async->file);
+    }
+    mpsc_queue_destroy(async->records);
+    rfree(async);
+    logger->async = NULL;
 }
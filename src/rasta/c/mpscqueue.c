@@ -0,0 +1,135 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_FIFO
+#include <stdatomic.h>
+#include <stddef.h>
+#include "mpscqueue.h"
+#include "rmemory.h"
+
+/**
+ * precedes every element in the slots of the queue
+ */
+struct mpsc_slot {
+    /**
+     * the position that may use the slot next. A producer may write the slot at position p if sequence == p, the
+     * consumer may read it if sequence == p + 1
+     */
+    atomic_uint sequence;
+};
+
+/**
+ * the size of the struct mpsc_slot in front of an element, keeps the elements aligned like malloc()
+ */
+#define SLOT_HEADER_SIZE ((sizeof(struct mpsc_slot) + _Alignof(max_align_t) - 1) / _Alignof(max_align_t) * \
+                          _Alignof(max_align_t))
+
+struct mpsc_queue {
+    /**
+     * the slots, every slot is a struct mpsc_slot followed by the element
+     */
+    unsigned char * slots;
+    /**
+     * the size of a slot in bytes, keeps the elements aligned
+     */
+    size_t slot_size;
+    /**
+     * the amount of slots - 1, the amount of slots is a power of two
+     */
+    unsigned int mask;
+    /**
+     * the position of the next element that is reserved, shared by the producers
+     */
+    atomic_uint tail;
+    /**
+     * the position of the oldest element, only used by the consumer
+     */
+    unsigned int head;
+};
+
+static struct mpsc_slot * slot_at(mpsc_queue_t * queue, unsigned int position){
+    return (struct mpsc_slot *) &queue->slots[(position & queue->mask) * queue->slot_size];
+}
+
+mpsc_queue_t * mpsc_queue_init(unsigned int max_size, unsigned int element_size){
+    mpsc_queue_t * queue = rmalloc(sizeof(mpsc_queue_t));
+
+    unsigned int count = 1;
+    while (count < max_size){
+        count *= 2;
+    }
+
+    queue->slot_size = SLOT_HEADER_SIZE + (element_size + _Alignof(max_align_t) - 1) / _Alignof(max_align_t) *
+                                          _Alignof(max_align_t);
+    queue->mask = count - 1;
+    queue->slots = rmalloc((unsigned int) (count * queue->slot_size));
+    queue->head = 0;
+    atomic_init(&queue->tail, 0);
+
+    for (unsigned int i = 0; i < count; i++){
+        atomic_init(&slot_at(queue, i)->sequence, i);
+    }
+
+    return queue;
+}
+
+void mpsc_queue_destroy(mpsc_queue_t * queue){
+    rfree(queue->slots);
+    rfree(queue);
+}
+
+/**
+ * @param slot a slot of the queue
+ * @return the element of @p slot
+ */
+static void * element_of(struct mpsc_slot * slot){
+    return (unsigned char *) slot + SLOT_HEADER_SIZE;
+}
+
+void * mpsc_queue_reserve(mpsc_queue_t * queue){
+    unsigned int position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    while (1){
+        struct mpsc_slot * slot = slot_at(queue, position);
+        // pairs with the release in mpsc_queue_release, the consumer is done with the slot
+        unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int difference = (int) (sequence - position);
+
+        if (difference == 0){
+            // the slot is free, claim it unless another producer was faster
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)){
+                return element_of(slot);
+            }
+        } else if (difference < 0){
+            // the consumer did not release the slot of the previous round yet
+            return NULL;
+        } else{
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+void mpsc_queue_commit(mpsc_queue_t * queue, void * element){
+    struct mpsc_slot * slot = (struct mpsc_slot *) ((unsigned char *) element - SLOT_HEADER_SIZE);
+    // the slot stores its own position, the next round uses position + amount of slots
+    unsigned int position = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    (void) queue;
+
+    // pairs with the acquire in mpsc_queue_front, the element is written before the consumer reads it
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+}
+
+void * mpsc_queue_front(mpsc_queue_t * queue){
+    struct mpsc_slot * slot = slot_at(queue, queue->head);
+
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != queue->head + 1){
+        return NULL;
+    }
+
+    return element_of(slot);
+}
+
+void mpsc_queue_release(mpsc_queue_t * queue){
+    struct mpsc_slot * slot = slot_at(queue, queue->head);
+
+    atomic_store_explicit(&slot->sequence, queue->head + queue->mask + 1, memory_order_release);
+    queue->head++;
+}
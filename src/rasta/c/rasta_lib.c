@@ -1,7 +1,15 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
 #include<rasta_lib.h>
 #include<rasta_new.h>
+#include<rmemory.h>
 #include<memory.h>
 #include<stdbool.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+#include<sched.h>
+#include<sys/eventfd.h>
 
 void rasta_lib_init_configuration(rasta_lib_configuration_t user_configuration, const char* config_file_path) {
     sr_init_handle(&user_configuration->h, config_file_path);
@@ -13,3 +21,182 @@ void rasta_lib_init_configuration(rasta_lib_configuration_t user_configuration,
 void rasta_lib_start(rasta_lib_configuration_t user_configuration, int channel_timeout_ms) {
     sr_begin(&user_configuration->h, &user_configuration->rasta_lib_event_system, channel_timeout_ms);
 }
+
+void rasta_lib_init_shards(rasta_lib_shards_t shards, const char* config_file_path, unsigned int count) {
+    shards->count = count;
+    shards->shards = rmalloc(count * sizeof(struct rasta_lib_shard_s));
+    if (shards->shards == NULL) {
+        perror("Could not allocate shards");
+        exit(1);
+    }
+
+    // the handles are initialized one after another, so tables that are shared by all handles are only generated here.
+    // The order also gives the shards their index in the SO_REUSEPORT groups of shared ports
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_lib_shard_s * shard = &shards->shards[i];
+        memset(shard, 0, sizeof(struct rasta_lib_shard_s));
+
+        sr_init_shard_handle(&shard->configuration.h, config_file_path, i, count);
+        // every shard busy polls on a CPU of its own, the one of RASTA_SHARD_CPUS if it has one
+        struct rasta_handle * h = &shard->configuration.h;
+        if (h->config.values.loop.busy_poll_cpu >= 0) {
+            h->config.values.loop.busy_poll_cpu = h->cpu >= 0 ? h->cpu : h->config.values.loop.busy_poll_cpu + (int) i;
+        }
+
+        shard->configuration.h.user_handles = &shard->configuration.callback;
+        shard->cpu = -1;
+        shard->stop_notify_fd = -1;
+    }
+}
+
+int rasta_lib_shards_share_ports(rasta_lib_shards_t shards) {
+    return shards->count > 0 && shards->shards[0].configuration.h.config.values.redundancy.reuseport_group > 0;
+}
+
+unsigned int rasta_lib_shard_index(unsigned long remote_id, unsigned int count) {
+    return remote_id % count;
+}
+
+struct rasta_lib_configuration_s * rasta_lib_get_shard(rasta_lib_shards_t shards, unsigned long remote_id) {
+    return &shards->shards[rasta_lib_shard_index(remote_id, shards->count)].configuration;
+}
+
+void rasta_lib_shard_channels(const struct RastaIPData * channels, unsigned int channel_count, unsigned int shard_index,
+                              struct RastaIPData * shard_channels) {
+    for (unsigned int i = 0; i < channel_count; i++) {
+        shard_channels[i] = channels[i];
+        shard_channels[i].port += shard_index * channel_count;
+    }
+}
+
+static int shard_stop_event(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+static void * shard_run(void * carry_data) {
+    struct rasta_lib_shard_s * shard = carry_data;
+
+    rasta_lib_start(&shard->configuration, shard->channel_timeout_ms);
+
+    remove_fd_event(&shard->configuration.rasta_lib_event_system, &shard->stop_event);
+    return NULL;
+}
+
+void rasta_lib_start_shards(rasta_lib_shards_t shards, int channel_timeout_ms, int pin_threads) {
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (unsigned int i = 0; i < shards->count; i++) {
+        struct rasta_lib_shard_s * shard = &shards->shards[i];
+
+        shard->channel_timeout_ms = channel_timeout_ms;
+        shard->stop_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shard->stop_notify_fd == -1) {
+            perror("Could not create eventfd");
+            exit(1);
+        }
+
+        // the event loop of the shard is not running yet, so its events can be added from this thread
+        memset(&shard->stop_event, 0, sizeof(fd_event));
+        shard->stop_event.callback = shard_stop_event;
+        shard->stop_event.fd = shard->stop_notify_fd;
+        enable_fd_event(&shard->stop_event);
+        add_fd_event(&shard->configuration.rasta_lib_event_system, &shard->stop_event, EV_READABLE);
+
+        shard->cpu = shard->configuration.h.cpu;
+        if (shard->cpu < 0 && pin_threads && cpu_count > 0) {
+            shard->cpu = (int) (i % cpu_count);
+        }
+
+        // the thread starts on its CPU, so its stack is already taken from the node of the CPU
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        if (shard->cpu >= 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(shard->cpu, &cpus);
+            pthread_attr_setaffinity_np(&attributes, sizeof(cpu_set_t), &cpus);
+        }
+        int error = pthread_create(&shard->thread, &attributes, shard_run, shard);
+        pthread_attr_destroy(&attributes);
+        if (error && shard->cpu >= 0) {
+            // the shard still works, it is just not pinned
+            shard->cpu = -1;
+            error = pthread_create(&shard->thread, NULL, shard_run, shard);
+        }
+        if (error) {
+            perror("Could not start shard thread");
+            exit(1);
+        }
+    }
+}
+
+void rasta_lib_stop_shards(rasta_lib_shards_t shards) {
+    for (unsigned int i = 0; i < shards->count; i++) {
+        rasta_handle_notify(shards->shards[i].stop_notify_fd);
+    }
+
+    for (unsigned int i = 0; i < shards->count; i++) {
+        struct rasta_lib_shard_s * shard = &shards->shards[i];
+        pthread_join(shard->thread, NULL);
+        close(shard->stop_notify_fd);
+        shard->stop_notify_fd = -1;
+    }
+}
+
+void rasta_lib_cleanup_shards(rasta_lib_shards_t shards) {
+    for (unsigned int i = 0; i < shards->count; i++) {
+        sr_cleanup(&shards->shards[i].configuration.h);
+    }
+
+    rfree(shards->shards);
+    shards->shards = NULL;
+    shards->count = 0;
+}
+
+void rasta_lib_init_entities(rasta_lib_entities_t entities, const char* config_file_path, const unsigned long * rasta_ids,
+                             unsigned int count) {
+    entities->count = count;
+    entities->entities = rmalloc(count * sizeof(struct rasta_lib_configuration_s));
+    if (entities->entities == NULL) {
+        perror("Could not allocate entities");
+        exit(1);
+    }
+
+    // the handles must not move once the members are added to the first one
+    struct rasta_handle * owner = &entities->entities[0].h;
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_lib_configuration_s * entity = &entities->entities[i];
+        memset(entity, 0, sizeof(struct rasta_lib_configuration_s));
+
+        sr_init_member_handle(&entity->h, config_file_path, rasta_ids[i], i == 0 ? NULL : owner);
+        entity->h.user_handles = &entity->callback;
+    }
+}
+
+struct rasta_lib_configuration_s * rasta_lib_get_entity(rasta_lib_entities_t entities, unsigned long rasta_id) {
+    for (unsigned int i = 0; i < entities->count; i++) {
+        if (entities->entities[i].h.config.values.general.rasta_id == rasta_id) {
+            return &entities->entities[i];
+        }
+    }
+    return NULL;
+}
+
+void rasta_lib_start_entities(rasta_lib_entities_t entities, int channel_timeout_ms) {
+    struct rasta_handle * handles[entities->count];
+    for (unsigned int i = 0; i < entities->count; i++) {
+        handles[i] = &entities->entities[i].h;
+    }
+    sr_begin_shared(handles, entities->count, &entities->entities[0].rasta_lib_event_system, channel_timeout_ms);
+}
+
+void rasta_lib_cleanup_entities(rasta_lib_entities_t entities) {
+    for (unsigned int i = entities->count; i > 0; i--) {
+        sr_cleanup(&entities->entities[i - 1].h);
+    }
+
+    rfree(entities->entities);
+    entities->entities = NULL;
+    entities->count = 0;
+}
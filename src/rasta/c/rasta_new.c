@@ -2,6 +2,7 @@
 // Created by tobia on 24.02.2018.
 //
 
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
 #include <stdlib.h>
 #include <unistd.h>
 #include <rmemory.h>
@@ -9,33 +10,133 @@
 #include <rastaredundancy_new.h>
 #include <time.h>
 #include <errno.h>
+#include <limits.h>
 #include <syscall.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include <rasta_new.h>
 #include <event_system.h>
 #include <rastahandle.h>
 #include <rasta_lib.h>
+#include <rastatrace.h>
+#include <rastastatpage.h>
+#include <rastaprobes.h>
+#include <rastawire.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+// the layout of struct rasta_connection keeps the fields of the send loop and of the per-PDU checks together
+_Static_assert(offsetof(struct rasta_connection, fifo_send_urgent) + sizeof(fifo_t *) <= 64,
+               "the fields the send loop reads have to fit into the first 64 bytes of a connection");
+_Static_assert(offsetof(struct rasta_connection, role) + sizeof(rasta_role) <= 128,
+               "the fields a received PDU is checked against have to fit into the first 128 bytes of a connection");
+
+/**
+ * changes the state of a connection, all transitions go through here so they can be traced with the sr_state probe
+ * @param connection the connection
+ * @param state the new state
+ */
+static inline void sr_set_state(struct rasta_connection * connection, rasta_sr_state state) {
+    RASTA_PROBE3(sr_state, connection->remote_id, connection->current_state, state);
+    connection->current_state = state;
+}
 
 /**
- * this will generate a 4 byte timestamp of the current system time
- * @return current system time in s since 1970
+ * this will generate a 4 byte timestamp of the current time
+ * @return the time of the event loop in ms, see event_system_now_ms()
  */
 uint32_t cur_timestamp() {
-    long ms;
-    time_t s;
-    struct timespec spec;
+    return event_system_now_ms();
+}
+
+/**
+ * the timestamp of the PDUs of a connection
+ * @param connection the connection
+ * @return cur_timestamp() on the clock of the entity that started the connection, see rasta_connection#timestamp_offset
+ */
+static inline uint32_t sr_timestamp(const struct rasta_connection * connection) {
+    return cur_timestamp() + connection->timestamp_offset;
+}
 
-    clock_gettime(CLOCK_MONOTONIC, &spec);
+/**
+ * @param value a size
+ * @return @p value, at most UINT16_MAX
+ */
+static inline uint16_t sr_flight_clamp(unsigned int value) {
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t) value;
+}
 
-    s = spec.tv_sec;
+/**
+ * records a PDU in the flight recorder of a connection
+ * @param connection the connection
+ * @param event what happened to the PDU
+ * @param packet the PDU
+ * @param detail see rasta_flight_event
+ */
+static inline void sr_flight_record(struct rasta_connection * connection, rasta_flight_event event,
+                                    const struct RastaPacket * packet, unsigned int detail) {
+    struct rasta_flight_record * record = rasta_flight_recorder_next(&connection->flight_recorder);
+    if (record == NULL) {
+        return;
+    }
+    record->time_ns = event_system_now();
+    record->sequence_number = packet->sequence_number;
+    record->confirmed_sequence_number = packet->confirmed_sequence_number;
+    record->timestamp = packet->timestamp;
+    record->confirmed_timestamp = packet->confirmed_timestamp;
+    record->type = packet->type;
+    record->event = (uint8_t) event;
+    record->detail = detail > UINT8_MAX ? UINT8_MAX : (uint8_t) detail;
+    record->send_queue = sr_flight_clamp(fifo_get_size(connection->fifo_send) +
+                                         fifo_get_size(connection->fifo_send_urgent));
+    record->retransmission_queue = sr_flight_clamp(connection->retr_buffer.count);
+    record->receive_queue = sr_flight_clamp(fifo_get_size(connection->fifo_app_msg));
+}
 
-    // seconds to milliseconds
-    ms = s * 1000;
+/**
+ * dumps the flight recorder of a connection, if the trigger is enabled
+ * @param h the handle
+ * @param connection the connection
+ * @param trigger the anomaly
+ * @param detail a description of the anomaly
+ */
+static void sr_flight_dump(struct rasta_handle * h, struct rasta_connection * connection, rasta_flight_trigger trigger,
+                           const char * detail) {
+    const struct RastaConfigFlightRecorder * cfg = &h->config.values.flight_recorder;
+    if (connection->flight_recorder.records == NULL || !(cfg->triggers & trigger) ||
+        connection->flight_recorder.next == 0) {
+        return;
+    }
 
-    // nanoseconds to milliseconds
-    ms += (long)(spec.tv_nsec / 1.0e6);
+    char path[PATH_MAX];
+    if (rasta_flight_recorder_dump(&connection->flight_recorder, cfg->directory, connection->my_id,
+                                   connection->remote_id, trigger, detail, event_system_now(), path, sizeof(path))) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA flight recorder", "%s of 0x%lX, wrote %s",
+                   rasta_flight_trigger_name(trigger), (unsigned long) connection->remote_id, path);
+    } else {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA flight recorder", "%s of 0x%lX, could not write %s",
+                   rasta_flight_trigger_name(trigger), (unsigned long) connection->remote_id, path);
+    }
+}
 
-    return (uint32_t)ms;
+/**
+ * dumps the flight recorder of a connection whose transport channel failed, see redundancy_mux#on_transport_failure
+ * @param context the handle
+ * @param id the RaSTA ID of the remote entity
+ * @param channel the index of the transport channel
+ */
+static void sr_on_transport_failure(void * context, unsigned long id, unsigned int channel) {
+    struct rasta_handle * h = context;
+    struct rasta_connection * connection = rasta_id_index_get(&h->connection_index, id);
+    if (connection == NULL) {
+        return;
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "transport channel %u received none of the PDUs of the diagnosis window", channel);
+    sr_flight_dump(h, connection, RASTA_FLIGHT_TRIGGER_CHANNEL, detail);
 }
 
 unsigned long mix(unsigned long a, unsigned long b, unsigned long c)
@@ -99,9 +200,13 @@ uint32_t get_initial_seq_num(struct RastaConfig * config){
  *          1 if local_version > remote_version
  */
 int compare_version(const char local_version[4], const char remote_version[4]){
+    // the versions are not terminated
+    char local_text[5] = { 0 }, remote_text[5] = { 0 };
+    memcpy(local_text, local_version, 4);
+    memcpy(remote_text, remote_version, 4);
     char * tmp;
-    long local = strtol(local_version, &tmp, 4);
-    long remote = strtol(remote_version, &tmp, 4);
+    long local = strtol(local_text, &tmp, 4);
+    long remote = strtol(remote_text, &tmp, 4);
 
     if (local == remote){
         return 0;
@@ -154,9 +259,10 @@ void send_DisconnectionRequest(redundancy_mux *mux, struct rasta_connection * co
 
     struct RastaPacket discReq = createDisconnectionRequest(connection->remote_id, connection->my_id,
                                                             connection->sn_t, connection->cs_t,
-                                                            cur_timestamp(), connection->ts_r, disconnectionData, &mux->sr_hashing_context);
+                                                            sr_timestamp(connection), connection->ts_r, disconnectionData, &mux->sr_hashing_context);
 
     redundancy_mux_send(mux, discReq);
+    sr_flight_record(connection, RASTA_FLIGHT_SEND, &discReq, 0);
 
     freeRastaByteArray(&discReq.data);
 }
@@ -169,11 +275,14 @@ void send_DisconnectionRequest(redundancy_mux *mux, struct rasta_connection * co
  */
 void send_Heartbeat(redundancy_mux *mux, struct rasta_connection * connection, char reschedule_manually){
     struct RastaPacket hb = createHeartbeat(connection->remote_id, connection->my_id, connection->sn_t,
-                                            connection->cs_t, cur_timestamp(), connection->ts_r, &mux->sr_hashing_context);
+                                            connection->cs_t, sr_timestamp(connection), connection->ts_r, &mux->sr_hashing_context);
 
     redundancy_mux_send(mux, hb);
+    sr_flight_record(connection, RASTA_FLIGHT_SEND, &hb, 0);
+    RASTA_PROBE2(sr_heartbeat_send, connection->remote_id, connection->sn_t);
 
     connection->sn_t = connection->sn_t +1;
+    connection->unconfirmed_received = 0;
     if (reschedule_manually) {
         reschedule_event(&connection->send_heartbeat_event);
     }
@@ -181,20 +290,23 @@ void send_Heartbeat(redundancy_mux *mux, struct rasta_connection * connection, c
 
 void send_RetransmissionRequest(redundancy_mux *mux, struct rasta_connection * connection){
     struct RastaPacket retrreq = createRetransmissionRequest(connection->remote_id, connection->my_id,
-                                                             connection->sn_t, connection->cs_t, cur_timestamp(),
+                                                             connection->sn_t, connection->cs_t, sr_timestamp(connection),
                                                              connection->ts_r, &mux->sr_hashing_context);
 
     redundancy_mux_send(mux, retrreq);
+    sr_flight_record(connection, RASTA_FLIGHT_SEND, &retrreq, 0);
+    rasta_metrics_add(&connection->metrics.retransmission_requests, 1);
 
     connection->sn_t = connection->sn_t + 1;
 }
 
 void send_RetransmissionResponse(redundancy_mux *mux, struct rasta_connection * connection) {
     struct RastaPacket retrresp = createRetransmissionResponse(connection->remote_id, connection->my_id,
-                                                               connection->sn_t, connection->cs_t, cur_timestamp(),
+                                                               connection->sn_t, connection->cs_t, sr_timestamp(connection),
                                                                connection->ts_r, &mux->sr_hashing_context);
 
     redundancy_mux_send(mux, retrresp);
+    sr_flight_record(connection, RASTA_FLIGHT_SEND, &retrresp, 0);
     connection->sn_t = connection->sn_t + 1;
 }
 
@@ -203,17 +315,28 @@ void send_RetransmissionResponse(redundancy_mux *mux, struct rasta_connection *
 
 unsigned int sr_retr_data_available(struct logger_t *logger,struct rasta_connection * connection){
     (void)logger;
-    return fifo_get_size(connection->fifo_retr);
+    return retrbuffer_size(&connection->retr_buffer);
 }
 
 unsigned int sr_rasta_send_data_available(struct logger_t *logger,struct rasta_connection * connection){
     (void)logger;
-    return fifo_get_size(connection->fifo_send);
+    return fifo_get_size(connection->fifo_send) + fifo_get_size(connection->fifo_send_urgent);
+}
+
+/**
+ * @return the length of a clock tick in milliseconds, which is added to the measured round trip delay
+ */
+static unsigned long clock_tick_ms() {
+    static unsigned long tick = 0;
+    if (tick == 0) {
+        tick = (unsigned long) (1000 / sysconf(_SC_CLK_TCK));
+    }
+    return tick;
 }
 
 void updateTI(long confirmed_timestamp, struct rasta_connection * con, struct RastaConfigInfoSending cfg) {
-    unsigned long t_local = cur_timestamp();
-    unsigned long t_rtd = t_local + (1000 / sysconf(_SC_CLK_TCK)) - confirmed_timestamp;
+    unsigned long t_local = sr_timestamp(con);
+    unsigned long t_rtd = t_local + clock_tick_ms() - confirmed_timestamp;
     con->t_i = (uint32_t )(cfg.t_max - t_rtd);
 
     // update the timeout start time
@@ -221,28 +344,37 @@ void updateTI(long confirmed_timestamp, struct rasta_connection * con, struct Ra
 }
 
 void resetDiagnostic(struct rasta_connection * connection) {
+    // the next window starts counting from the beginning
+    connection->received_diagnostic_message_count = 0;
     for (unsigned int i = 0; i < connection->diagnostic_intervals_length; i++) {
         connection->diagnostic_intervals[i].message_count = 0;
         connection->diagnostic_intervals[i].t_alive_message_count = 0;
     }
 }
 
+void sr_diagnostic_record(struct rasta_connection * connection, unsigned long t_rtd, unsigned long t_alive) {
+    // the sub intervals are DIAGNOSTIC_INTERVAL_SIZE wide and start at 0, so the index follows from t_rtd
+    unsigned long index = t_rtd / DIAGNOSTIC_INTERVAL_SIZE;
+    if (index >= connection->diagnostic_intervals_length) {
+        // T_MAX is exceeded, the connection is closed by the timeout anyway
+        return;
+    }
+    struct diagnostic_interval * interval = &connection->diagnostic_intervals[index];
+    ++interval->message_count;
+
+    // lies t_alive in interval range, too?
+    if (t_alive / DIAGNOSTIC_INTERVAL_SIZE == index) {
+        ++interval->t_alive_message_count;
+    }
+}
+
 void updateDiagnostic(struct rasta_connection * connection, struct RastaPacket receivedPacket, struct RastaConfigInfoSending cfg, struct rasta_handle *h) {
-    unsigned long t_local = cur_timestamp();
-    unsigned long t_rtd = t_local + (1000 / sysconf(_SC_CLK_TCK)) - receivedPacket.confirmed_timestamp;
+    unsigned long t_local = sr_timestamp(connection);
+    unsigned long t_rtd = t_local + clock_tick_ms() - receivedPacket.confirmed_timestamp;
     unsigned long t_alive = t_local - connection->cts_r;
-    for (unsigned int i = 0; i < connection->diagnostic_intervals_length; i++) {
-        if (connection->diagnostic_intervals[i].interval_start >= t_rtd && connection->diagnostic_intervals[i].interval_end <= t_rtd) {
-            // found the sub interval this message can be assigned to
-            ++connection->diagnostic_intervals[i].message_count;
+    rasta_histogram_record(&connection->metrics.round_trip_delay, t_local - receivedPacket.confirmed_timestamp);
+    sr_diagnostic_record(connection, t_rtd, t_alive);
 
-            // lies t_alive in interval range, too?
-            if (connection->diagnostic_intervals[i].interval_start >= t_alive && connection->diagnostic_intervals[i].interval_end <= t_alive) {
-                ++connection->diagnostic_intervals[i].t_alive_message_count;
-            }
-            break; // we found our interval. Other executions aren't necessary anymore
-        }
-    }
     ++connection->received_diagnostic_message_count;
     if (connection->received_diagnostic_message_count >= cfg.diag_window) {
         fire_on_diagnostic_notification(sr_create_notification_result(h,connection));
@@ -273,28 +405,116 @@ uint32_t bytesToLong2(const unsigned char v[4]) {
     return result;
 }
 
+/**
+ * an application message in the receive queue of a connection
+ */
+struct rasta_received_message {
+    rastaApplicationMessage message;
+
+    /**
+     * the time the message was queued, 0 if the connection records no residency
+     */
+    uint64_t queued_ns;
+};
+
 void sr_add_app_messages_to_buffer(struct rasta_receive_handle *h, struct rasta_connection * con, struct RastaPacket packet){
-    struct RastaMessageData received_data;
-    received_data = extractMessageData(packet);
+    // the messages are copied straight from the packet into the application messages
+    struct RastaMessageIterator messages;
+    const unsigned char * message;
+    unsigned int message_length;
+    unsigned int count = 0;
+    uint64_t queued_ns = con->residency != NULL ? get_nanotime() : 0;
+
+    rastaMessageIteratorInit(&messages, packet.data.bytes, packet.data.length);
+
+    while (rastaMessageIteratorNext(&messages, &message, &message_length)) {
+        count++;
+        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA add to buffer", "received msg of length %u", message_length);
+
+        struct rasta_received_message * elem = rmalloc(sizeof(struct rasta_received_message));
+        elem->message.id = packet.sender_id;
+        allocateRastaByteArray(&elem->message.appMessage, message_length);
+        elem->queued_ns = queued_ns;
+
+        rmemcpy(elem->message.appMessage.bytes, message, message_length);
+        if (!fifo_push(con->fifo_app_msg, elem)) {
+            // the application did not retrieve its messages and the partner sent more than its send window
+            logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA add to buffer",
+                       "receive queue of 0x%X is full, dropping a message", con->remote_id);
+            rasta_metrics_add(&con->metrics.receive_overflows, 1);
+            freeRastaByteArray(&elem->message.appMessage);
+            rfree(elem);
+            count--;
+        } else {
+            // fire onReceive event
+            fire_on_receive(sr_create_notification_result(h->handle,con));
+        }
 
-    logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA add to buffer", "received %d application messages", received_data.count);
+        updateTI(packet.confirmed_timestamp, con,h->config);
+        updateDiagnostic(con,packet,h->config,h->handle);
+    }
 
+    logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA add to buffer", "received %u application messages", count);
 
-    for (unsigned int i = 0; i < received_data.count; ++i) {
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA add to buffer", "received msg: %s", received_data.data_array[i].bytes);
+    if (count > 0) {
+        fire_on_receive_bulk(sr_create_notification_result(h->handle,con));
+    }
+}
 
-        rastaApplicationMessage * elem = rmalloc(sizeof(rastaApplicationMessage));
-        elem->id = packet.sender_id;
-        allocateRastaByteArray(&elem->appMessage, received_data.data_array[i].length);
+unsigned int sr_receive_reserve(struct RastaConfigInfoSending cfg) {
+    return cfg.receive_backpressure ? cfg.send_max * cfg.max_packet : 0;
+}
 
-        rmemcpy(elem->appMessage.bytes, received_data.data_array[i].bytes, received_data.data_array[i].length);
-        fifo_push(con->fifo_app_msg, elem);
-        // fire onReceive event
-        fire_on_receive(sr_create_notification_result(h->handle,con));
+/**
+ * @param h the receive handle
+ * @param con the connection
+ * @return 1 if the receive queue of a connection has room for the messages of another send window of the partner
+ */
+static int sr_receive_room(struct rasta_receive_handle *h, struct rasta_connection * con) {
+    unsigned int free = fifo_get_capacity(con->fifo_app_msg) - fifo_get_size(con->fifo_app_msg);
+    return free >= sr_receive_reserve(h->config);
+}
 
-        updateTI(packet.confirmed_timestamp, con,h->config);
-        updateDiagnostic(con,packet,h->config,h->handle);
+void sr_confirm_received(struct rasta_receive_handle *h, struct rasta_connection * connection,
+                         uint32_t sequence_number) {
+    connection->cs_received = sequence_number;
+    if (sr_receive_room(h, connection)) {
+        connection->cs_t = sequence_number;
+        connection->receive_held = 0;
+        return;
+    }
+
+    // the messages of the send window the partner has in flight still fit in, a confirmation would open another one
+    if (!connection->receive_held) {
+        logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA confirm", "receive queue of 0x%X is filling up, holding back "
+                   "confirmations at SN %lu", connection->remote_id, (unsigned long) connection->cs_t);
+        connection->receive_held = 1;
+        rasta_metrics_add(&connection->metrics.receive_holds, 1);
+        h->receive_held_count++;
+    }
+}
+
+int sr_release_received(struct rasta_receive_handle *h, struct rasta_connection * connection) {
+    if (!connection->receive_held) {
+        return 0;
+    }
+    if (connection->current_state == RASTA_CONNECTION_DOWN || connection->current_state == RASTA_CONNECTION_CLOSED) {
+        // nothing is left to confirm
+        connection->receive_held = 0;
+        return 0;
+    }
+    if (connection->current_state != RASTA_CONNECTION_UP || !sr_receive_room(h, connection)) {
+        // during a retransmission the heartbeat has to wait, the next received PDU is confirmed anyway
+        return 1;
     }
+
+    logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA confirm", "receive queue of 0x%X has room again, confirming SN %lu",
+               connection->remote_id, (unsigned long) connection->cs_received);
+    connection->cs_t = connection->cs_received;
+    connection->receive_held = 0;
+    connection->unconfirmed_received = 0;
+    send_Heartbeat(h->mux, connection, 1);
+    return 0;
 }
 
 /**
@@ -305,32 +525,9 @@ void sr_remove_confirmed_messages(struct rasta_receive_handle *h,struct rasta_co
     // remove confirmed messages from retransmission fifo
     logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA remove confirmed", "confirming messages with SN_PDU <= %lu", (long unsigned int) con->cs_r);
 
-    struct RastaByteArray * elem;
-    while ((elem = fifo_pop(con->fifo_retr)) != NULL){
-        struct RastaPacket packet = bytesToRastaPacket(*elem, h->hashing_context);
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA remove confirmed", "removing packet with sn = %lu",
-                   (long unsigned int) packet.sequence_number);
-
-
-        // message is confirmed when CS_R - SN_PDU >= 0
-        // equivalent to SN_PDU <= CS_R
-        if (packet.sequence_number == con->cs_r){
-            // this packet has the last same sequence number as the confirmed sn, i.e. the next packet in the queue's
-            // SN_PDU will be bigger than CS_R (because of FIFO property of mqueue)
-            // that means we removed all confirmed messages and have to leave the loop to stop removing packets
-            logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA remove confirmed", "last confirmed packet removed");
-
-            freeRastaByteArray(elem);
-            freeRastaByteArray(&packet.data);
-            rfree(elem);
-
-            break;
-        }
-
-        freeRastaByteArray(elem);
-        freeRastaByteArray(&packet.data);
-        rfree(elem);
-    }
+    unsigned int removed = retrbuffer_confirm(&con->retr_buffer, con->cs_r);
+    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA remove confirmed", "removed %u packets, %u left", removed,
+               retrbuffer_size(&con->retr_buffer));
 }
 
 /* ----- processing of received packet types ----- */
@@ -455,12 +652,21 @@ int sr_check_packet(struct rasta_connection *con, struct logger_t *logger, struc
 
 void sr_reset_connection(struct rasta_connection* connection, unsigned long id, struct RastaConfigInfoGeneral info) {
     connection->remote_id = (uint32_t )id;
-    connection->current_state = RASTA_CONNECTION_CLOSED;
+    sr_set_state(connection, RASTA_CONNECTION_CLOSED);
     connection->my_id = (uint32_t )info.rasta_id;
     connection->network_id = (uint32_t )info.rasta_network;
     connection->connected_recv_buffer_size = -1;
+    connection->unconfirmed_received = 0;
     connection->hb_locked = 1;
     connection->hb_stopped = 0;
+    connection->resync = 0;
+#ifdef ENABLE_OPAQUE
+    // a key exchange that is still computed belongs to the old connection
+    connection->kex_job = NULL;
+    connection->kex_prepare_job = NULL;
+    key_exchange_discard_credential_request(&connection->kex_prepared);
+    connection->rekeying_due_ms = 0;
+#endif
 
     // set all error counters to 0
     struct rasta_error_counters error_counters;
@@ -485,23 +691,26 @@ void sr_close_connection(struct rasta_connection * connection,struct rasta_handl
         sr_reset_connection(connection,connection->remote_id,info);
         send_DisconnectionRequest(mux,connection, reason, details);
 
-        connection->current_state = RASTA_CONNECTION_CLOSED;
+        sr_set_state(connection, RASTA_CONNECTION_CLOSED);
 
         // fire connection tls_state changed event
         fire_on_connection_state_change(sr_create_notification_result(handle, connection));
     }
 }
 
-void sr_diagnostic_interval_init(struct rasta_connection * connection, struct RastaConfigInfoSending cfg) {
+/**
+ * sets up the diagnostic sub intervals of a connection in the given memory
+ * @param connection the connection
+ * @param intervals room for @p length intervals
+ * @param length the amount of intervals, one for every DIAGNOSTIC_INTERVAL_SIZE ms up to T_MAX
+ */
+static void sr_diagnostic_interval_setup(struct rasta_connection * connection, struct diagnostic_interval * intervals,
+                                         unsigned int length) {
     connection->received_diagnostic_message_count = 0;
 
-    unsigned int diagnostic_interval_length = cfg.t_max / DIAGNOSTIC_INTERVAL_SIZE;
-    if (cfg.t_max % DIAGNOSTIC_INTERVAL_SIZE > 0) {
-        ++diagnostic_interval_length;
-    }
-    connection->diagnostic_intervals = rmalloc(diagnostic_interval_length * sizeof(struct diagnostic_interval));
-    connection->diagnostic_intervals_length = diagnostic_interval_length;
-    for (unsigned int i = 0; i < diagnostic_interval_length; i++) {
+    connection->diagnostic_intervals = intervals;
+    connection->diagnostic_intervals_length = length;
+    for (unsigned int i = 0; i < length; i++) {
         struct diagnostic_interval sub_interval;
 
         sub_interval.interval_start = DIAGNOSTIC_INTERVAL_SIZE * i;
@@ -514,99 +723,409 @@ void sr_diagnostic_interval_init(struct rasta_connection * connection, struct Ra
     }
 }
 
-void sr_init_connection(struct rasta_connection* connection, unsigned long id, struct RastaConfigInfoGeneral info, struct RastaConfigInfoSending cfg, struct logger_t *logger, rasta_role role) {
+void sr_diagnostic_interval_init(struct rasta_connection * connection, struct RastaConfigInfoSending cfg) {
+    unsigned int diagnostic_interval_length = cfg.t_max / DIAGNOSTIC_INTERVAL_SIZE;
+    if (cfg.t_max % DIAGNOSTIC_INTERVAL_SIZE > 0) {
+        ++diagnostic_interval_length;
+    }
+    sr_diagnostic_interval_setup(connection, rmalloc(diagnostic_interval_length * sizeof(struct diagnostic_interval)),
+                                 diagnostic_interval_length);
+}
+
+/**
+ * the send credit a single data packet costs
+ * @param rate the data packets per second, has to be greater than 0
+ * @return the cost in nanoseconds
+ */
+static uint64_t sr_send_bucket_cost(unsigned int rate) {
+    return 1000000000ull / rate;
+}
+
+/**
+ * fills the token bucket of a connection, so that a full burst can be sent
+ * @param bucket the token bucket
+ * @param cfg the sending configuration
+ */
+static void sr_send_bucket_init(struct rasta_send_bucket * bucket, struct RastaConfigInfoSending cfg) {
+    bucket->last_refill_ns = event_system_now();
+    bucket->credit_ns = cfg.send_rate == 0 ? 0 : cfg.send_burst * sr_send_bucket_cost(cfg.send_rate);
+}
+
+/**
+ * tops up the send credit by the time that passed since the last refill, limited to one burst
+ * @param bucket the token bucket
+ * @param rate the data packets per second, has to be greater than 0
+ * @param burst the data packets of a burst
+ * @param now the current time
+ */
+static void sr_send_bucket_refill(struct rasta_send_bucket * bucket, unsigned int rate, unsigned int burst,
+                                  evtime_t now) {
+    uint64_t max_credit = burst * sr_send_bucket_cost(rate);
+    if (now > bucket->last_refill_ns) {
+        bucket->credit_ns += now - bucket->last_refill_ns;
+        bucket->last_refill_ns = now;
+    }
+    if (bucket->credit_ns > max_credit) {
+        bucket->credit_ns = max_credit;
+    }
+}
+
+/**
+ * checks if a connection has the send credit for another data packet
+ * @param bucket the token bucket of the connection
+ * @param cfg the sending configuration
+ * @param now the current time
+ * @return 1 if a data packet may be sent, 0 otherwise
+ */
+static int sr_send_bucket_ready(struct rasta_send_bucket * bucket, struct RastaConfigInfoSending cfg, evtime_t now) {
+    if (cfg.send_rate == 0) {
+        return 1;
+    }
+    sr_send_bucket_refill(bucket, cfg.send_rate, cfg.send_burst, now);
+    return bucket->credit_ns >= sr_send_bucket_cost(cfg.send_rate);
+}
+
+/**
+ * takes the send credit for one data packet from the token bucket of a connection
+ * @param bucket the token bucket of the connection
+ * @param cfg the sending configuration
+ * @param now the current time
+ * @return 1 if the credit was taken and the data packet may be sent, 0 otherwise
+ */
+static int sr_send_bucket_take(struct rasta_send_bucket * bucket, struct RastaConfigInfoSending cfg, evtime_t now) {
+    if (!sr_send_bucket_ready(bucket, cfg, now)) {
+        return 0;
+    }
+    if (cfg.send_rate != 0) {
+        bucket->credit_ns -= sr_send_bucket_cost(cfg.send_rate);
+    }
+    return 1;
+}
+
+/**
+ * calculates how long a connection has to wait until it can send another data packet
+ * @param bucket the token bucket of the connection, refilled by sr_send_bucket_ready()
+ * @param rate the data packets per second, has to be greater than 0
+ * @return the time to wait in nanoseconds
+ */
+static uint64_t sr_send_bucket_wait(struct rasta_send_bucket * bucket, unsigned int rate) {
+    uint64_t cost = sr_send_bucket_cost(rate);
+    return bucket->credit_ns >= cost ? 0 : cost - bucket->credit_ns;
+}
+
+/**
+ * checks if the application messages queued on a connection are sent now or wait for further messages, so more of
+ * them are packed into the same data packet. Messages wait at most RASTA_SEND_COALESCE_US after the oldest one was
+ * queued and never once a data packet is full
+ * @param con the connection
+ * @param cfg the sending configuration
+ * @param now the current time
+ * @param wait_ns set to the time until the queued messages have to be sent if they wait
+ * @return 1 if a data packet may be sent, 0 if the messages wait
+ */
+static int sr_send_coalesce_ready(struct rasta_connection * con, struct RastaConfigInfoSending cfg, evtime_t now,
+                                  uint64_t * wait_ns) {
+    if (cfg.send_coalesce_us == 0) {
+        return 1;
+    }
+    // urgent messages do not wait for others, the data of a data packet has to leave room for the safety code
+    if (fifo_get_size(con->fifo_send_urgent) > 0 ||
+        fifo_get_size(con->fifo_send) >= cfg.max_packet || con->send_queued_bytes + 16 >= MAX_PACKET_LEN) {
+        return 1;
+    }
+    uint64_t budget_ns = (uint64_t)cfg.send_coalesce_us * 1000;
+    uint64_t waited_ns = now > con->send_queued_since_ns ? now - con->send_queued_since_ns : 0;
+    if (waited_ns >= budget_ns) {
+        return 1;
+    }
+    *wait_ns = budget_ns - waited_ns;
+    return 0;
+}
+
+/**
+ * the send window of a connection is the size of the retransmission buffer, at most the N_SENDMAX of the connection
+ * partner
+ * @param con the connection
+ * @return the amount of data packets that may be unconfirmed at once
+ */
+static unsigned int sr_send_window(struct rasta_connection * con) {
+    unsigned int window = con->retr_buffer.max_count;
+    if (con->connected_recv_buffer_size > 0 && (unsigned int) con->connected_recv_buffer_size < window) {
+        window = (unsigned int) con->connected_recv_buffer_size;
+    }
+    return window;
+}
+
+/**
+ * checks if a connection may send another data packet. The send window is used up by the data packets that are not
+ * confirmed yet
+ * @param con the connection
+ * @return 1 if a data packet may be sent, 0 if the connection has to wait for confirmations
+ */
+static int sr_send_window_open(struct rasta_connection * con) {
+    return retrbuffer_size(&con->retr_buffer) < sr_send_window(con);
+}
+
+/**
+ * fires on_writable if sr_send() rejected messages of a connection and its send queue has room for a data packet of
+ * messages again
+ * @param h the RaSTA handle
+ * @param con the connection
+ * @param cfg the sending configuration
+ */
+static void sr_send_check_writable(struct rasta_handle * h, struct rasta_connection * con,
+                                   struct RastaConfigInfoSending cfg) {
+    if (con->send_blocked && fifo_get_capacity(con->fifo_send) - fifo_get_size(con->fifo_send) >= cfg.max_packet &&
+        fifo_get_capacity(con->fifo_send_urgent) - fifo_get_size(con->fifo_send_urgent) >= cfg.max_packet) {
+        con->send_blocked = 0;
+        // submissions wait for the same room
+        rasta_handle_notify(h->submit_notify_fd);
+        fire_on_writable(sr_create_notification_result(h, con));
+    }
+}
+
+/**
+ * initializes a connection and its queues
+ * @param connection the connection
+ * @param pool the pool the queues are taken from
+ * @param state the slot of a closed connection that is opened again, its queues are reused. NULL takes a new slot
+ * @return 1 on success, 0 if every slot of the pool is in use
+ */
+static int sr_init_connection(struct rasta_connection* connection, struct rasta_connection_pool* pool, void* state,
+                              unsigned long id, struct RastaConfigInfoGeneral info, struct RastaConfigInfoSending cfg,
+                              struct logger_t *logger, rasta_role role) {
     (void)logger;
+    struct rasta_connection_slot slot;
+    if (state != NULL) {
+        rasta_connection_pool_reset(pool, state, &slot);
+    } else if (!rasta_connection_pool_take(pool, &slot)) {
+        return 0;
+    }
+
     sr_reset_connection(connection,id,info);
     connection->role = role;
+    connection->state = slot.memory;
 
     // initalize diagnostic interval and store it in connection
-    sr_diagnostic_interval_init(connection, cfg);
+    sr_diagnostic_interval_setup(connection, slot.diagnostic_intervals, pool->diagnostic_interval_count);
 
     // create receive queue
-    connection->fifo_app_msg = fifo_init(cfg.send_max);
-
-    // init retransmission fifo
-    connection->fifo_retr = fifo_init(MAX_QUEUE_SIZE);
-
-    // create send queue
-    connection->fifo_send = fifo_init(2* cfg.max_packet);
+    connection->fifo_app_msg = slot.fifo_app_msg;
+
+    // init retransmission buffer, it holds the data packets of the send window
+    connection->retr_buffer = retrbuffer_init_in(slot.retransmission_elements, pool->retransmission_count);
+
+    // create send queue, its bulk lane holds the messages of a full send window
+    connection->fifo_send = slot.fifo_send;
+    connection->fifo_send_urgent = slot.fifo_send_urgent;
+    connection->send_queued_since_ns = 0;
+    connection->send_ready_since_ns = 0;
+    connection->cs_received = 0;
+    connection->receive_held = 0;
+    connection->state_change_queued = 0;
+    connection->residency = slot.residency;
+    rasta_flight_recorder_init(&connection->flight_recorder, slot.flight_records, pool->flight_record_count);
+    connection->send_queued_bytes = 0;
+    connection->send_blocked = 0;
+
+    // paced connections may send a full burst right away
+    sr_send_bucket_init(&connection->send_bucket, cfg);
+    connection->retransmitting = 0;
+    connection->retransmit_sn = 0;
 
     // reset last rekeying time
 #ifdef ENABLE_OPAQUE
     connection->kex_state.last_key_exchanged_millis = 0;
 #endif
-}
 
-void sr_retransmit_data(struct rasta_receive_handle *h, struct rasta_connection * connection){
-    /**
-         *  * retransmit messages in queue
-         */
+    rmemset(&connection->metrics, 0, sizeof(connection->metrics));
 
-    // prepare Array Buffer
-    struct RastaByteArray packets[MAX_QUEUE_SIZE];
+    // set by sr_take_over() for the connections of a primary
+    connection->timestamp_offset = 0;
+    connection->replicated = 0;
+    return 1;
+}
 
-    int buffer_n = 0; // how many valid elements are in the buffer
-    buffer_n = fifo_get_size(connection->fifo_retr);
+/**
+ * restamps the next data packets that a connection retransmits and sends them in one batch. The last one is followed
+ * by the heartbeat that closes the retransmission
+ * @param h the receive handle
+ * @param connection the connection, it has to be retransmitting
+ * @param limit the maximum amount of data packets that are sent
+ * @return the amount of data packets that were sent
+ */
+static unsigned int sr_retransmit_next(struct rasta_receive_handle *h, struct rasta_connection * connection,
+                                       unsigned int limit){
+    if (connection->current_state == RASTA_CONNECTION_DOWN || connection->current_state == RASTA_CONNECTION_CLOSED) {
+        connection->retransmitting = 0;
+        return 0;
+    }
 
-    // get all packets and store them in the buffer
-    for (int j = 0; j < buffer_n; ++j) {
-        struct RastaByteArray * element;
-        element = fifo_pop(connection->fifo_retr);
+    // the buffer holds consecutive sequence numbers and loses confirmed packets only at its front, so the packets in
+    // front of retransmit_sn are the ones that were sent already
+    unsigned int buffer_n = retrbuffer_size(&connection->retr_buffer);
+    unsigned int first = 0;
+    if (buffer_n > 0) {
+        int32_t offset = (int32_t) (connection->retransmit_sn - retrbuffer_get(&connection->retr_buffer, 0)->sequence_number);
+        first = offset < 0 ? 0 : (unsigned int) offset;
+        if (first > buffer_n) {
+            first = buffer_n;
+        }
+    }
+    unsigned int count = buffer_n - first < limit ? buffer_n - first : limit;
+    evtime_t started = get_nanotime();
+    unsigned char * packets[count > 0 ? count : 1];
+    unsigned int lengths[count > 0 ? count : 1];
+
+    // the retransmitted packets keep their data and their place in the buffer, only the header fields and the
+    // safety code are updated
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_retr_element * element = retrbuffer_get(&connection->retr_buffer, first + i);
+        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "retransmitting packet with sn=%lu",
+            (long unsigned int) element->sequence_number);
+
+        rastaPacketRestamp(element->pdu, element->length, RASTA_TYPE_RETRDATA, element->sequence_number,
+                           connection->cs_t, sr_timestamp(connection), connection->cts_r, h->hashing_context);
+
+        packets[i] = element->pdu;
+        lengths[i] = element->length;
+    }
 
-        allocateRastaByteArray(&packets[j], element->length);
-        rmemcpy(packets[j].bytes, element->bytes, element->length);
+    if (count > 0) {
+        redundancy_mux_send_encoded_batch(h->mux, connection->remote_id, packets, lengths, count);
+        if (connection->flight_recorder.records != NULL) {
+            struct RastaPacket first_packet;
+            memset(&first_packet, 0, sizeof(first_packet));
+            first_packet.type = RASTA_TYPE_RETRDATA;
+            first_packet.sequence_number = connection->retransmit_sn;
+            first_packet.confirmed_sequence_number = connection->cs_t;
+            first_packet.timestamp = sr_timestamp(connection);
+            first_packet.confirmed_timestamp = connection->cts_r;
+            sr_flight_record(connection, RASTA_FLIGHT_RETRANSMIT, &first_packet, count);
+        }
+        connection->retransmit_sn += count;
 
-        freeRastaByteArray(element);
-        rfree(element);
+        // set last message ts
+        reschedule_event(&connection->send_heartbeat_event);
     }
 
-    // re-open fifo in write mode
-    // now retransmit each packet in the buffer with new sequence numbers
-    for (int i = 0; i <= buffer_n; i++)
-    {
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "retransmit packet %d", i);
+    if (first + count == buffer_n) {
+        connection->retransmitting = 0;
+
+        // close retransmission with heartbeat
+        send_Heartbeat(h->mux,connection, 1);
+        RASTA_PROBE2(sr_retransmit_end, connection->remote_id, connection->sn_t - 1);
+
+        // the data packets that were queued in the meantime follow the retransmission
+        rasta_handle_notify(h->handle->send_notify_fd);
+    }
+    rasta_metrics_add(&connection->metrics.send_ns, (unsigned long) (get_nanotime() - started));
+    return count;
+}
 
-        // retrieve retransmission data to
-        struct RastaPacket old_p = bytesToRastaPacket(packets[i], h->hashing_context);
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "convert packet %d to packet structure", i);
+/**
+ * sends the data packets of the connections of a handle that retransmit. Without retransmit_rate, or without an event
+ * loop, all of them are sent at once. Otherwise the connections take turns with the credit of the handle, every
+ * connection gets the same share and the rest is sent when there is credit again, so the other traffic gets through
+ * in between
+ * @param h the receive handle
+ */
+static void sr_retransmit_run(struct rasta_receive_handle *h){
+    unsigned int rate = h->config.retransmit_rate;
+    int paced = rate != 0 && h->retransmit_event != NULL;
+    unsigned long budget = UINT_MAX;
+
+    if (paced) {
+        sr_send_bucket_refill(&h->retransmit_bucket, rate, h->config.retransmit_burst, event_system_now());
+        budget = h->retransmit_bucket.credit_ns / sr_send_bucket_cost(rate);
+    }
 
-        struct RastaMessageData app_messages = extractMessageData(old_p);
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "extract data from packet %d ", i);
+    unsigned long sent = 0;
+    unsigned int waiting;
+    for (;;) {
+        waiting = 0;
+        for (struct rasta_connection * con = h->handle->first_con; con; con = con->linkedlist_next) {
+            waiting += con->retransmitting ? 1 : 0;
+        }
+        if (waiting == 0 || budget == 0) {
+            break;
+        }
+        unsigned long share = budget / waiting > 0 ? budget / waiting : 1;
+
+        // the turn starts behind the connection that retransmitted last, so the remainder of the credit rotates
+        struct rasta_connection * start = h->handle->first_con;
+        for (struct rasta_connection * con = h->handle->first_con; con; con = con->linkedlist_next) {
+            if (con->remote_id == h->retransmit_last_id && con->linkedlist_next != NULL) {
+                start = con->linkedlist_next;
+                break;
+            }
+        }
+        struct rasta_connection * con = start;
+        do {
+            if (con->retransmitting && budget > 0) {
+                unsigned int n = sr_retransmit_next(h, con, (unsigned int) (share < budget ? share : budget));
+                budget -= n;
+                sent += n;
+                h->retransmit_last_id = con->remote_id;
+            }
+            con = con->linkedlist_next != NULL ? con->linkedlist_next : h->handle->first_con;
+        } while (con != start);
+    }
 
-        // create new packet for retransmission
-        struct RastaPacket data = createRetransmittedDataMessage(connection->remote_id, connection->my_id, connection->sn_t,
-                                                                 connection->cs_t, cur_timestamp(), connection->cts_r,
-                                                                 app_messages, h->hashing_context);
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "created retransmission packet %d ", i);
+    if (paced) {
+        h->retransmit_bucket.credit_ns -= sent * sr_send_bucket_cost(rate);
+        if (waiting > 0) {
+            h->retransmit_event->interval = sr_send_bucket_wait(&h->retransmit_bucket, rate);
+            enable_timed_event(h->retransmit_event);
+        }
+    }
+}
 
-        struct RastaByteArray new_p = rastaModuleToBytes(data, h->hashing_context);
+/**
+ * sends the next retransmitted data packet of a connection whose heartbeat is due while the connection waits for the
+ * credit of the handle, so the partner receives a PDU at least every T_H however many connections share the credit.
+ * The packet is taken from the credit, even if the credit does not cover it
+ * @param h the receive handle
+ * @param connection the connection, it has to be retransmitting
+ */
+static void sr_retransmit_keepalive(struct rasta_receive_handle *h, struct rasta_connection * connection){
+    unsigned int rate = h->config.retransmit_rate;
+    if (sr_retransmit_next(h, connection, 1) > 0 && rate != 0) {
+        uint64_t cost = sr_send_bucket_cost(rate);
+        uint64_t credit = h->retransmit_bucket.credit_ns;
+        h->retransmit_bucket.credit_ns = credit > cost ? credit - cost : 0;
+    }
+}
 
-        // add packet to retrFifo again
-        struct RastaByteArray * to_fifo = rmalloc(sizeof(struct RastaByteArray));
-        allocateRastaByteArray(to_fifo, new_p.length);
-        rmemcpy(to_fifo->bytes, new_p.bytes, new_p.length);
-        fifo_push(connection->fifo_retr, to_fifo);
-        logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA retransmission", "added packet %d to queue", i);
+int retransmit_pacing_event(void * carry_data) {
+    struct rasta_receive_handle * h = carry_data;
+    disable_timed_event(h->retransmit_event);
+    sr_retransmit_run(h);
+    return 0;
+}
 
-        // send packet
-        redundancy_mux_send(h->mux, data);
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA retransmission", "retransmitted packet with old sn=%lu",
-            (long unsigned int) old_p.sequence_number);
+void sr_retransmit_data(struct rasta_receive_handle *h, struct rasta_connection * connection){
+    /**
+         *  * retransmit messages in queue
+         */
 
-        // increase sn_t
-        connection->sn_t = connection->sn_t +1;
+    unsigned int buffer_n = retrbuffer_size(&connection->retr_buffer);
 
-        // set last message ts
-        reschedule_event(&connection->send_heartbeat_event);
+    rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_RETRANSMIT, connection->remote_id, connection->sn_t, 0, 0,
+                    buffer_n);
+    RASTA_PROBE3(sr_retransmit_start, connection->remote_id, connection->sn_t, buffer_n);
+    rasta_metrics_add(&connection->metrics.retransmitted_pdus, buffer_n);
 
-        // free allocated memory of current packet
-        freeRastaByteArray(&packets[i]);
-        freeRastaByteArray(&new_p);
-        freeRastaByteArray(&old_p.data);
+    // the packets get their new sequence numbers now, so the buffer stays in order while they wait for their turn. A
+    // retransmission that is still running starts again with the packets that were not confirmed
+    for (unsigned int i = 0; i < buffer_n; i++) {
+        retrbuffer_get(&connection->retr_buffer, i)->sequence_number = connection->sn_t;
+        connection->sn_t = connection->sn_t + 1;
     }
+    connection->retransmit_sn = connection->sn_t - buffer_n;
+    connection->retransmitting = 1;
 
-    // close retransmission with heartbeat
-    send_Heartbeat(h->mux,connection, 1);
+    sr_retransmit_run(h);
 }
 
 int event_connection_expired(void* carry_data);
@@ -621,7 +1140,6 @@ void init_connection_timeout_event(timed_event* ev, struct timed_event_data* car
     enable_timed_event(ev);
 }
 
-int heartbeat_send_event(void* carry_data);
 void init_send_heartbeat_event(timed_event* ev, struct timed_event_data* carry_data,
         struct rasta_connection* connection, struct rasta_handle* h) {
     memset(ev, 0, sizeof(timed_event));
@@ -633,20 +1151,60 @@ void init_send_heartbeat_event(timed_event* ev, struct timed_event_data* carry_d
     enable_timed_event(ev);
 }
 
+/**
+ * the time a due rekeying waits when rekeying_max_concurrent connections of the handle are rekeying already
+ */
+#define REKEYING_RETRY_MS 100
+
+/**
+ * the time until the next rekeying of a connection. Half of the rekeying interval adds some headroom for computation
+ * and communication, it is shortened by a random jitter so the connections of a handle do not rekey together
+ * @param h the RaSTA handle
+ * @return the delay in nanoseconds
+ */
+static uint64_t rekeying_delay(struct rasta_handle* h) {
+    uint64_t delay_ms = h->config.values.kex.rekeying_interval_ms / 2;
+    uint64_t max_jitter_ms = delay_ms * h->config.values.kex.rekeying_jitter_percent / 100;
+    if (max_jitter_ms > 0) {
+        delay_ms -= (uint64_t) rand_r(&h->rekeying_seed) % (max_jitter_ms + 1);
+    }
+    return delay_ms * NS_PER_MS;
+}
+
 int send_timed_key_exchange(void *arg);
 void init_send_key_exchange_event(timed_event* ev, struct timed_event_data* carry_data,
                                   struct rasta_connection* connection, struct rasta_handle* h) {
     ev->callback = send_timed_key_exchange;
     ev->carry_data = carry_data;
-    ev->interval = h->config.values.kex.rekeying_interval_ms  * NS_PER_MS;
-    // add some headroom for computation and communication
-    ev->interval /= 2;
+    ev->interval = rekeying_delay(h);
     carry_data->handle = h->receive_handle;
     carry_data->connection = connection;
     enable_timed_event(ev);
 }
 
+/**
+ * removes the timed events of a connection from the event system of the handle, if they were added before
+ * @param h the handle
+ * @param connection the connection
+ */
+static void remove_connection_events(struct rasta_handle* h, struct rasta_connection* connection) {
+    if (connection->timeout_event.ev_sys) {
+        remove_timed_event(h->ev_sys, &connection->timeout_event);
+    }
+    if (connection->send_heartbeat_event.ev_sys) {
+        remove_timed_event(h->ev_sys, &connection->send_heartbeat_event);
+    }
+#ifdef ENABLE_OPAQUE
+    if (connection->rekeying_event.ev_sys) {
+        remove_timed_event(h->ev_sys, &connection->rekeying_event);
+    }
+#endif
+}
+
 void init_connection_events(struct rasta_handle* h, struct rasta_connection* connection) {
+    // a client added the events when it sent the ConReq, they must not be in the event system twice
+    remove_connection_events(h, connection);
+
     init_connection_timeout_event(&connection->timeout_event, &connection->timeout_carry_data, connection, h);
     init_send_heartbeat_event(&connection->send_heartbeat_event, &connection->timeout_carry_data, connection, h);
     add_timed_event(h->ev_sys, &connection->timeout_event);
@@ -659,11 +1217,64 @@ void init_connection_events(struct rasta_handle* h, struct rasta_connection* con
 #endif
 }
 
+unsigned int sr_reconnect_delay_ms(struct RastaConfigInfoSending cfg, unsigned int attempt, unsigned int * seed) {
+    uint64_t delay_ms = cfg.reconnect_min_ms;
+    for (unsigned int i = 0; i < attempt && delay_ms < cfg.reconnect_max_ms; i++) {
+        delay_ms *= 2;
+    }
+    if (delay_ms > cfg.reconnect_max_ms) {
+        delay_ms = cfg.reconnect_max_ms;
+    }
+
+    uint64_t max_jitter_ms = delay_ms / 2;
+    if (max_jitter_ms > 0) {
+        delay_ms -= (uint64_t) rand_r(seed) % (max_jitter_ms + 1);
+    }
+    return (unsigned int) delay_ms;
+}
+
+/**
+ * lets a client send its connection request again after the reconnect delay, if reconnecting is enabled
+ * @param h the RaSTA handle
+ * @param connection the connection
+ */
+static void sr_schedule_reconnect(struct rasta_handle* h, struct rasta_connection* connection) {
+    if (connection->role != RASTA_ROLE_CLIENT || connection->reconnect_event.ev_sys == NULL) {
+        return;
+    }
+
+    unsigned int delay_ms = sr_reconnect_delay_ms(h->config.values.sending, connection->reconnect_attempts,
+                                                  &h->reconnect_seed);
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA RECONNECT", "connecting to %X again in %u ms",
+               connection->remote_id, delay_ms);
+    connection->reconnect_event.interval = delay_ms * NS_PER_MS;
+    enable_timed_event(&connection->reconnect_event);
+}
+
+/**
+ * counts the peer of a connection as connected if a bulk connect waits for its handshake
+ * @param h the RaSTA handle
+ * @param con the connection whose handshake, and key exchange if it is enabled, completed
+ */
+static void sr_bulk_connect_handshake_complete(struct rasta_handle *h, struct rasta_connection *con);
+
+/**
+ * [PRIMARY] replicates a connection before the round ends if it sent so many data packets that a standby taking over
+ * would use their sequence numbers again
+ */
+static void sr_replicate_if_due(struct rasta_handle* h, struct rasta_connection* con);
+
+/**
+ * [PRIMARY] tells the standby that a replicated connection is gone
+ */
+static void sr_replicate_removed(struct rasta_handle* h, struct rasta_connection* con);
+
 void add_connection_to_list(struct rasta_handle* h, struct rasta_connection* con) {
     if (h->last_con) {
         con->linkedlist_prev = h->last_con;
         con->linkedlist_next = NULL;
         h->last_con->linkedlist_next = con;
+        h->last_con = con;
     }
     else {
         h->first_con = con;
@@ -671,9 +1282,11 @@ void add_connection_to_list(struct rasta_handle* h, struct rasta_connection* con
         con->linkedlist_prev = NULL;
         con->linkedlist_next = NULL;
     }
+    rasta_id_index_put(&h->connection_index, con->remote_id, con);
 }
 
 void remove_connection_from_list(struct rasta_handle* h, struct rasta_connection* con) {
+    sr_replicate_removed(h, con);
     if (h->first_con == con) {
         h->first_con = con->linkedlist_next;
     }
@@ -682,6 +1295,9 @@ void remove_connection_from_list(struct rasta_handle* h, struct rasta_connection
     }
     if (con->linkedlist_prev) con->linkedlist_prev->linkedlist_next = con->linkedlist_next;
     if (con->linkedlist_next) con->linkedlist_next->linkedlist_prev = con->linkedlist_prev;
+    if (rasta_id_index_get(&h->connection_index, con->remote_id) == con) {
+        rasta_id_index_remove(&h->connection_index, con->remote_id);
+    }
 }
 
 /*
@@ -689,12 +1305,7 @@ void remove_connection_from_list(struct rasta_handle* h, struct rasta_connection
  */
 
 static uint64_t get_current_time_ms() {
-    uint64_t current_time;
-    struct timespec current_time_tv;
-    clock_gettime(CLOCK_MONOTONIC, &current_time_tv);
-
-    current_time = current_time_tv.tv_nsec/NS_PER_MS + current_time_tv.tv_sec * MS_PER_S;
-    return current_time;
+    return event_system_now() / NS_PER_MS;
 }
 
 /**
@@ -703,27 +1314,375 @@ static uint64_t get_current_time_ms() {
  * @param host the host where the HB will be sent to
  * @param port the port where the HB will be sent to
  */
-void send_KexRequest(redundancy_mux *mux, struct rasta_connection * connection, struct rasta_receive_handle *h){
 #ifdef ENABLE_OPAQUE
-    struct RastaPacket hb = createKexRequest(connection->remote_id, connection->my_id, connection->sn_t,
-                                             connection->cs_t, cur_timestamp(), connection->ts_r,
-                                             &mux->sr_hashing_context, h->handle->config.values.kex.psk, &connection->kex_state, h->logger);
+/**
+ * a key exchange computation of a connection that runs on the kex_pool of the handle
+ */
+struct rasta_kex_job {
+    struct rasta_receive_handle * h;
+
+    /**
+     * the RaSTA IDs and the initial sequence number of the connection. The connection is looked up by its remote ID
+     * when the job completes, it might have been reset in the meantime
+     */
+    unsigned long remote_id;
+    uint32_t my_id;
+    uint32_t sn_i;
+
+    /**
+     * copy of the key exchange state of the connection, only the worker uses it until the job completes
+     */
+    struct key_exchange_state kex_state;
+
+    /**
+     * the key exchange data of the received PDU
+     */
+    uint8_t received[MAX_DEFER_QUEUE_MSG_SIZE];
+    unsigned int received_length;
+
+    /**
+     * 0 if the computation succeeded
+     */
+    int result;
+};
+
+/**
+ * creates the job for the next key exchange computation of a connection
+ * @param h the receive handle
+ * @param connection the connection
+ * @param received the received key exchange PDU or NULL
+ * @return the job, freed when it completes
+ */
+static struct rasta_kex_job * kex_job_create(struct rasta_receive_handle *h, struct rasta_connection *connection,
+                                             const struct RastaPacket *received) {
+    struct rasta_kex_job * job = rmalloc(sizeof(struct rasta_kex_job));
+    job->h = h;
+    job->remote_id = connection->remote_id;
+    job->my_id = connection->my_id;
+    job->sn_i = connection->sn_i;
+    job->kex_state = connection->kex_state;
+    job->received_length = 0;
+    if (received != NULL && received->data.length <= sizeof(job->received)) {
+        rmemcpy(job->received, received->data.bytes, received->data.length);
+        job->received_length = received->data.length;
+    }
+    job->result = 0;
+    return job;
+}
+
+/**
+ * hands the job to the kex_pool of the handle. If max_pending key exchanges are computed already, the job is
+ * computed and completed on the event loop
+ * @param connection the connection the job belongs to
+ * @param job the job
+ * @param work the computation
+ * @param complete finishes the key exchange step on the event loop
+ */
+static void kex_job_start(struct rasta_connection *connection, struct rasta_kex_job *job, worker_pool_work_ptr work,
+                          worker_pool_complete_ptr complete) {
+    connection->kex_job = job;
+    if (!worker_pool_submit(&job->h->handle->kex_pool, work, complete, job)) {
+        work(job);
+        complete(job, 0);
+    }
+}
+
+/**
+ * takes the result of a completed job over into its connection
+ * @param job the job
+ * @param cancelled 1 if the job was cancelled
+ * @return the connection or NULL if the job does not belong to a connection anymore
+ */
+static struct rasta_connection * kex_job_finish(struct rasta_kex_job *job, int cancelled) {
+    if (cancelled) {
+        return NULL;
+    }
+
+    struct rasta_connection * connection = rasta_id_index_get(&job->h->handle->connection_index, job->remote_id);
+    if (connection == NULL || connection->kex_job != job) {
+        logger_log(job->h->logger, LOG_LEVEL_INFO, "RaSTA KEX", "Discarding key exchange of a reset connection");
+        return NULL;
+    }
+
+    connection->kex_job = NULL;
+    connection->kex_state = job->kex_state;
+    return connection;
+}
+
+/**
+ * [CLIENT] prepares the credential request on a worker
+ * @param carry_data the job
+ */
+static void kex_request_work(void *carry_data) {
+    struct rasta_kex_job * job = carry_data;
+    job->result = key_exchange_prepare_credential_request_pooled(&job->h->handle->kex_secrets, &job->kex_state,
+                                                                 job->h->handle->config.values.kex.psk,
+                                                                 job->h->logger);
+}
+
+/**
+ * [CLIENT] sends the Key Exchange Request that was prepared in the key exchange state of the connection
+ * @param h the receive handle
+ * @param connection the connection
+ */
+static void kex_request_send(struct rasta_receive_handle *h, struct rasta_connection *connection) {
+    struct RastaPacket request = createPreparedKexRequest(connection->remote_id, connection->my_id, connection->sn_t,
+                                                          connection->cs_t, sr_timestamp(connection), connection->ts_r,
+                                                          &h->mux->sr_hashing_context, &connection->kex_state);
 
     if(!connection->kex_state.last_key_exchanged_millis && h->handle->config.values.kex.rekeying_interval_ms){
-        // first key exchanged - need to enable periodic rekeying
-        init_send_key_exchange_event(&connection->rekeying_event,&connection->rekeying_carry_data,connection,h->handle);
-        add_timed_event(h->handle->ev_sys, &connection->rekeying_event);
+        // first key exchanged - need to enable periodic rekeying, unless the event was added with the connection
+        if (connection->rekeying_event.ev_sys == NULL) {
+            init_send_key_exchange_event(&connection->rekeying_event,&connection->rekeying_carry_data,connection,h->handle);
+            add_timed_event(h->handle->ev_sys, &connection->rekeying_event);
+        }
     }
     else{
         logger_log(h->logger,LOG_LEVEL_INFO,"RaSTA KEX", "Rekeying at %"PRIu64,get_current_time_ms());
     }
 
-    redundancy_mux_send(mux, hb);
+    redundancy_mux_send(h->mux, request);
 
     connection->sn_t = connection->sn_t +1;
 
     connection->kex_state.last_key_exchanged_millis = get_current_time_ms();
-    connection->current_state = RASTA_CONNECTION_KEX_RESP;
+}
+
+/**
+ * [CLIENT] sends the prepared Key Exchange Request
+ * @param carry_data the job
+ * @param cancelled 1 if the job was cancelled
+ */
+static void kex_request_complete(void *carry_data, int cancelled) {
+    struct rasta_kex_job * job = carry_data;
+    struct rasta_receive_handle * h = job->h;
+    struct rasta_connection * connection = kex_job_finish(job, cancelled);
+    int result = job->result;
+    rfree(job);
+    if (connection == NULL) {
+        return;
+    }
+
+    if (result) {
+        logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA KEX", "Could not prepare credential request!");
+        sr_close_connection(connection, h->handle, h->mux, h->info, RASTA_DISC_REASON_PROTOCOLERROR, 0);
+        return;
+    }
+
+    kex_request_send(h, connection);
+}
+
+/**
+ * [CLIENT] keeps the credential request that was prepared for the next rekeying
+ * @param carry_data the job
+ * @param cancelled 1 if the job was cancelled
+ */
+static void kex_prepare_complete(void *carry_data, int cancelled) {
+    struct rasta_kex_job * job = carry_data;
+    struct rasta_connection * connection = NULL;
+
+    if (!cancelled) {
+        connection = rasta_id_index_get(&job->h->handle->connection_index, job->remote_id);
+    }
+    if (connection != NULL && connection->kex_prepare_job == job) {
+        connection->kex_prepare_job = NULL;
+        if (!job->result) {
+            connection->kex_prepared = job->kex_state;
+            rfree(job);
+            return;
+        }
+    }
+
+    // the connection was reset in the meantime, the request is not sent
+    if (!cancelled && !job->result) {
+        key_exchange_discard_credential_request(&job->kex_state);
+    }
+    rfree(job);
+}
+
+/**
+ * [CLIENT] prepares the credential request of the next rekeying on the kex_pool, so the due rekeying only sends it.
+ * Nothing is prepared if the pool is busy, the rekeying prepares its request when it is due then
+ * @param h the receive handle
+ * @param connection the connection whose key exchange was just completed
+ */
+static void kex_prepare_next(struct rasta_receive_handle *h, struct rasta_connection *connection) {
+    const struct RastaConfigKex * kex_config = &h->handle->config.values.kex;
+    if (!kex_config->rekeying_interval_ms || !kex_config->precompute || connection->kex_prepare_job != NULL ||
+        connection->kex_prepared.client_secret != NULL) {
+        return;
+    }
+
+    struct rasta_kex_job * job = kex_job_create(h, connection, NULL);
+    if (!worker_pool_submit(&h->handle->kex_pool, kex_request_work, kex_prepare_complete, job)) {
+        rfree(job);
+        return;
+    }
+    connection->kex_prepare_job = job;
+}
+
+/**
+ * [SERVER] prepares the credential response to the received Key Exchange Request on a worker
+ * @param carry_data the job
+ */
+static void kex_response_work(void *carry_data) {
+    struct rasta_kex_job * job = carry_data;
+    const struct RastaConfigKex * kex_config = &job->h->handle->config.values.kex;
+
+    job->result = 0;
+    if(kex_config->has_psk_record){
+        rmemcpy(job->kex_state.user_record,kex_config->psk_record,sizeof(job->kex_state.user_record));
+    }
+    else{
+        job->result = key_exchange_prepare_from_psk_cached(&job->h->handle->kex_secrets, &job->kex_state,
+                                                           kex_config->psk, job->my_id, job->remote_id,
+                                                           job->h->logger);
+    }
+
+    if (!job->result) {
+        job->result = kex_prepare_credential_response(&job->kex_state, job->received, job->received_length,
+                                                      job->my_id, job->remote_id, job->sn_i, job->h->logger);
+    }
+}
+
+/**
+ * [SERVER] sends the prepared Key Exchange Response and switches to the new session key
+ * @param carry_data the job
+ * @param cancelled 1 if the job was cancelled
+ */
+static void kex_response_complete(void *carry_data, int cancelled) {
+    struct rasta_kex_job * job = carry_data;
+    struct rasta_receive_handle * h = job->h;
+    struct rasta_connection * connection = kex_job_finish(job, cancelled);
+    int result = job->result;
+    rfree(job);
+    if (connection == NULL) {
+        return;
+    }
+
+    if (result) {
+        logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Req", "Could not prepare credential response!");
+        sr_close_connection(connection, h->handle, h->mux, h->info, RASTA_DISC_REASON_PROTOCOLERROR, 0);
+        return;
+    }
+
+    struct RastaPacket response = createPreparedKexResponse(connection->remote_id, connection->my_id, connection->sn_t,
+                                                            connection->cs_t, sr_timestamp(connection), connection->ts_r,
+                                                            h->hashing_context, &connection->kex_state);
+
+    redundancy_mux_send(h->mux, response);
+
+    connection->sn_t += 1;
+
+    // wait for client to send auth packet, indicating that on the client's side, the exchange worked
+    sr_set_state(connection, RASTA_CONNECTION_KEX_AUTH);
+
+    logger_hexdump(h->logger,LOG_LEVEL_INFO,connection->kex_state.session_key,sizeof(connection->kex_state.session_key),"Setting hash key to:");
+
+    rasta_set_hash_key_variable(h->hashing_context, (char *) connection->kex_state.session_key, sizeof(connection->kex_state.session_key));
+}
+
+/**
+ * [CLIENT] recovers the credentials from the received Key Exchange Response on a worker
+ * @param carry_data the job
+ */
+static void kex_recover_work(void *carry_data) {
+    struct rasta_kex_job * job = carry_data;
+    job->result = kex_recover_credential(&job->kex_state, job->received, job->received_length, job->my_id,
+                                         job->remote_id, job->sn_i, job->h->logger);
+}
+
+/**
+ * [CLIENT] sends the Key Exchange Authentication and switches to the new session key
+ * @param carry_data the job
+ * @param cancelled 1 if the job was cancelled
+ */
+static void kex_recover_complete(void *carry_data, int cancelled) {
+    struct rasta_kex_job * job = carry_data;
+    struct rasta_receive_handle * h = job->h;
+    struct rasta_connection * connection = kex_job_finish(job, cancelled);
+    int result = job->result;
+    rfree(job);
+    if (connection == NULL) {
+        return;
+    }
+
+    if (result) {
+        logger_log(h->logger,LOG_LEVEL_ERROR,"RaSTA HANDLE: KEX Resp", "Could not recover credentials!");
+        sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_UNEXPECTEDTYPE ,0);
+        return;
+    }
+
+    struct RastaPacket response = createKexAuthentication(connection->remote_id, connection->my_id, connection->sn_t,
+                                                          connection->cs_t, sr_timestamp(connection), connection->ts_r,
+                                                          h->hashing_context, connection->kex_state.user_auth_server,
+                                                          sizeof(connection->kex_state.user_auth_server), h->logger);
+
+    redundancy_mux_send(h->mux, response);
+
+    connection->sn_t += 1;
+
+    // kex is done from our PoV, can expect data from now
+    sr_set_state(connection, RASTA_CONNECTION_UP);
+    sr_bulk_connect_handshake_complete(h->handle, connection);
+
+    kex_prepare_next(h, connection);
+
+    logger_hexdump(h->logger,LOG_LEVEL_INFO,connection->kex_state.session_key,sizeof(connection->kex_state.session_key),"Setting hash key to:");
+
+    rasta_set_hash_key_variable(h->hashing_context, (char *) connection->kex_state.session_key, sizeof(connection->kex_state.session_key));
+
+    if (connection->rekeying_due_ms) {
+        struct rasta_rekeying_statistics * stats = &h->handle->rekeying_stats;
+        uint64_t latency = get_current_time_ms() - connection->rekeying_due_ms;
+        connection->rekeying_due_ms = 0;
+
+        stats->completed++;
+        stats->last_latency_ms = latency;
+        stats->total_latency_ms += latency;
+        if (latency > stats->max_latency_ms) {
+            stats->max_latency_ms = latency;
+        }
+    }
+}
+
+/**
+ * the handler of the notify_fd of the kex_pool, finishes the computed key exchange steps
+ * @param carry_data the RaSTA handle
+ * @return 0 to continue the event loop
+ */
+static int kex_completion_event(void *carry_data) {
+    struct rasta_handle * h = carry_data;
+    worker_pool_complete(&h->kex_pool);
+    return 0;
+}
+#endif
+
+void send_KexRequest(redundancy_mux *mux, struct rasta_connection * connection, struct rasta_receive_handle *h){
+#ifdef ENABLE_OPAQUE
+    (void) mux;
+    if (connection->kex_job != NULL) {
+        // the previous key exchange is still computed
+        return;
+    }
+
+    // the request is sent when the worker prepared it, the response is expected from now on
+    sr_set_state(connection, RASTA_CONNECTION_KEX_RESP);
+    if (connection->kex_prepared.client_secret != NULL) {
+        // prepared after the previous key exchange, see kex_prepare_next()
+        connection->kex_state.client_secret = connection->kex_prepared.client_secret;
+        connection->kex_state.secret_owner = connection->kex_prepared.secret_owner;
+        connection->kex_state.password_length = connection->kex_prepared.password_length;
+        rmemcpy(connection->kex_state.client_public, connection->kex_prepared.client_public,
+                sizeof(connection->kex_state.client_public));
+        connection->kex_prepared.client_secret = NULL;
+        connection->kex_prepared.secret_owner = NULL;
+
+        h->handle->rekeying_stats.precomputed++;
+        kex_request_send(h, connection);
+        return;
+    }
+    kex_job_start(connection, kex_job_create(h, connection, NULL), kex_request_work, kex_request_complete);
 #else
     // should never be called
     (void) mux;
@@ -732,14 +1691,59 @@ void send_KexRequest(redundancy_mux *mux, struct rasta_connection * connection,
     abort();
 #endif
 }
+#ifdef ENABLE_OPAQUE
+/**
+ * checks if a due rekeying has to wait, because rekeying_max_concurrent other connections of the handle are
+ * rekeying already. A rekeying is not deferred past the rekeying interval, the server expects it shortly after
+ * (see sr_rekeying_skipped())
+ * @param h the RaSTA handle
+ * @param connection the connection that is due
+ * @return true if the rekeying has to be tried again after REKEYING_RETRY_MS
+ */
+static bool rekeying_deferred(struct rasta_handle* h, struct rasta_connection* connection) {
+    const struct RastaConfigKex * kex_config = &h->config.values.kex;
+    if (!kex_config->rekeying_max_concurrent) {
+        return false;
+    }
+
+    unsigned int rekeying = 0;
+    for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
+        if (con != connection && con->current_state == RASTA_CONNECTION_KEX_RESP) {
+            rekeying++;
+        }
+    }
+    if (rekeying < kex_config->rekeying_max_concurrent) {
+        return false;
+    }
+
+    return get_current_time_ms() + REKEYING_RETRY_MS <
+           connection->kex_state.last_key_exchanged_millis + kex_config->rekeying_interval_ms;
+}
+#endif
 
 int send_timed_key_exchange(void *arg){
 #ifdef ENABLE_OPAQUE
     struct timed_event_data *event_data = (struct timed_event_data *) arg;
     struct rasta_receive_handle *handle = (struct rasta_receive_handle *) event_data->handle;
-    send_KexRequest(handle->mux,event_data->connection,handle);
-    // call periodically
-    reschedule_event(&event_data->connection->rekeying_event);
+    struct rasta_connection *connection = event_data->connection;
+    struct rasta_handle *h = handle->handle;
+
+    if (!connection->rekeying_due_ms) {
+        connection->rekeying_due_ms = get_current_time_ms();
+    }
+
+    if (rekeying_deferred(h, connection)) {
+        h->rekeying_stats.deferred++;
+        connection->rekeying_event.interval = REKEYING_RETRY_MS * NS_PER_MS;
+        reschedule_event(&connection->rekeying_event);
+        return 0;
+    }
+
+    h->rekeying_stats.started++;
+    send_KexRequest(handle->mux,connection,handle);
+    // call periodically, every interval gets a new jitter
+    connection->rekeying_event.interval = rekeying_delay(h);
+    reschedule_event(&connection->rekeying_event);
 #else
     // should never be called
     (void) arg;
@@ -759,8 +1763,16 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
             logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Reset existing client");
         }
         struct rasta_connection new_con;
-
-        sr_init_connection(&new_con,receivedPacket.sender_id,h->info,h->config,h->logger, RASTA_ROLE_SERVER);
+        memset(&new_con, 0, sizeof(struct rasta_connection));
+
+        // a connection that is opened again keeps its slot
+        if (!sr_init_connection(&new_con, &h->handle->connection_pool, connection ? connection->state : NULL,
+                                receivedPacket.sender_id, h->info, h->config, h->logger, RASTA_ROLE_SERVER)) {
+            logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: ConnectionRequest",
+                       "refused %d, all %u connections are in use", receivedPacket.sender_id,
+                       h->handle->connection_pool.capacity);
+            return connection;
+        }
 
         // initialize seq num
         new_con.sn_t = new_con.sn_i = receivedPacket.sequence_number;
@@ -774,13 +1786,16 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
         if (!sr_check_packet(&new_con,h->logger,h->config,receivedPacket, "RaSTA HANDLE: ConnectionRequest")) {
             logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Packet is not valid");
             sr_close_connection(&new_con,h->handle,h->mux,h->info,RASTA_DISC_REASON_PROTOCOLERROR,0);
+            if (connection == 0) {
+                rasta_connection_pool_release(&h->handle->connection_pool, new_con.state);
+            }
             return connection;
         }
 
         // received packet is a ConReq -> check version
         struct RastaConnectionData connectionData = extractRastaConnectionData(receivedPacket);
 
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Client has version %s", connectionData.version);
+        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Client has version %.4s", connectionData.version);
 
         if (compare_version(RASTA_VERSION, connectionData.version) == 0 ||
             compare_version(RASTA_VERSION, connectionData.version) == -1 ||
@@ -788,6 +1803,9 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
 
             logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Version accepted");
 
+            // the sender is authentic, its redundancy channel is kept from now on
+            redundancy_mux_confirm_channel(h->mux, receivedPacket.sender_id);
+
             // same version, or lower version -> client has to decide -> send ConResp
 
             // set values according to 5.6.2 [3]
@@ -819,6 +1837,13 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
             //check if the connection was just closed
             if (connection) {
                 logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionRequest", "Update Client %d", receivedPacket.sender_id);
+                // the events of the old connection are overwritten
+                remove_connection_events(h->handle, connection);
+                // the standby still has to be told that the old connection is gone
+                new_con.replicated = connection->replicated;
+                // the connection keeps its place in the list
+                new_con.linkedlist_next = connection->linkedlist_next;
+                new_con.linkedlist_prev = connection->linkedlist_prev;
                 *connection = new_con;
                 fire_on_connection_state_change(sr_create_notification_result(h->handle, connection));
                 init_connection_events(h->handle, connection);
@@ -827,6 +1852,7 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
                 struct rasta_connection* memory = h->handle->user_handles->on_connection_start(&new_con);
                 if (memory == NULL) {
                     logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: ConnectionRequest", "refused %d", receivedPacket.sender_id);
+                    rasta_connection_pool_release(&h->handle->connection_pool, new_con.state);
                     return NULL;
                 }
                 *memory = new_con;
@@ -845,6 +1871,9 @@ struct rasta_connection* handle_conreq(struct rasta_receive_handle *h, struct ra
         else {
             logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: ConnectionRequest", "Version unacceptable - sending DisconnectionRequest");
             sr_close_connection(&new_con,h->handle,h->mux,h->info,RASTA_DISC_REASON_INCOMPATIBLEVERSION,0);
+            if (connection == 0) {
+                rasta_connection_pool_release(&h->handle->connection_pool, new_con.state);
+            }
             return connection;
         }
     }
@@ -875,7 +1904,7 @@ struct rasta_connection* handle_conresp(struct rasta_receive_handle *h, struct r
 
             //logger_log(&connection->logger, LOG_LEVEL_INFO, "RaSTA open con", "server is running RaSTA version %s", connectionData.version);
 
-            logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionResponse", "Client has version %s",connectionData.version);
+            logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionResponse", "Client has version %.4s",connectionData.version);
 
             if (version_accepted(h, connectionData.version)) {
 
@@ -892,7 +1921,8 @@ struct rasta_connection* handle_conresp(struct rasta_receive_handle *h, struct r
                 //printf("RECEIVED CS_PDU=%lu (Type=%d)\n", receivedPacket.sequence_number, receivedPacket.type);
 
                 // update tls_state, ready to send data
-                con->current_state = RASTA_CONNECTION_UP;
+                sr_set_state(con, RASTA_CONNECTION_UP);
+                con->reconnect_attempts = 0;
 
                 // send hb
                 logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: ConnectionResponse", "Sending heartbeat..");
@@ -908,6 +1938,9 @@ struct rasta_connection* handle_conresp(struct rasta_receive_handle *h, struct r
                 fire_on_connection_state_change(sr_create_notification_result(h->handle, con));
                 // fire handshake complete event
                 fire_on_handshake_complete(sr_create_notification_result(h->handle, con));
+                if (h->handle->config.values.kex.mode == KEY_EXCHANGE_MODE_NONE) {
+                    sr_bulk_connect_handshake_complete(h->handle, con);
+                }
 
                 init_connection_events(h->handle, con);
 
@@ -969,8 +2002,25 @@ void handle_kex_request(struct rasta_receive_handle *h, struct rasta_connection
                     return;
                 }
 #ifdef ENABLE_OPAQUE
+                if(connection->kex_job != NULL){
+                    logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Req","Key exchange request received while the previous one is computed!");
+                    sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_UNEXPECTEDTYPE ,0);
+                    return;
+                }
+
+                if(receivedPacket.data.length != sizeof(connection->kex_state.client_public)){
+                    logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Req","Client sent Key Exchange Request of invalid length: %u",receivedPacket.data.length);
+                    sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_PROTOCOLERROR ,0);
+                    return;
+                }
+
+                if(connection->current_state == RASTA_CONNECTION_KEX_REQ && h->handle->kex_pool.pending == h->handle->kex_pool.max_pending){
+                    // too many handshakes at once, the client may connect again later
+                    logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Req","Too many key exchanges are computed at once, rejecting handshake");
+                    sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_SERVICENOTALLOWED ,0);
+                    return;
+                }
 
-                struct RastaPacket response;
                 connection->kex_state.last_key_exchanged_millis = get_current_time_ms();
 
                 if(connection->kex_state.last_key_exchanged_millis){
@@ -982,18 +2032,8 @@ void handle_kex_request(struct rasta_receive_handle *h, struct rasta_connection
                 logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: KEX Req","Key exchange request received at %"PRIu64,connection->kex_state.last_key_exchanged_millis);
                 // valid Key Exchange request packet received
 
-                response = createKexResponse(connection->remote_id, connection->my_id, connection->sn_t,
-                                             receivedPacket.sequence_number, current_ts(),
-                                             receivedPacket.timestamp, h->hashing_context, h->handle->config.values.kex.psk,
-                                             (uint8_t *) receivedPacket.data.bytes, receivedPacket.data.length, connection->sn_i,
-                                             &connection->kex_state,
-                                             &h->handle->config.values.kex, h->logger);
-
-                redundancy_mux_send(h->mux, response);
-
-                // set values according to 5.6.2 [3]
+                // set values according to 5.6.2 [3], sn_t is increased when the response is sent
                 connection->sn_r = receivedPacket.sequence_number +1;
-                connection->sn_t += 1;
                 connection->cs_t = receivedPacket.sequence_number;
                 connection->cs_r = receivedPacket.confirmed_sequence_number;
                 connection->ts_r = receivedPacket.timestamp;
@@ -1003,12 +2043,8 @@ void handle_kex_request(struct rasta_receive_handle *h, struct rasta_connection
                 // cs_r updated, remove confirmed messages
                 sr_remove_confirmed_messages(h,connection);
 
-                // wait for client to send auth packet, indicating that on the client's side, the exchange worked
-                connection->current_state = RASTA_CONNECTION_KEX_AUTH;
-
-                logger_hexdump(h->logger,LOG_LEVEL_INFO,connection->kex_state.session_key,sizeof(connection->kex_state.session_key),"Setting hash key to:");
-
-                rasta_set_hash_key_variable(h->hashing_context, (char *) connection->kex_state.session_key, sizeof(connection->kex_state.session_key));
+                // the response is sent when it was computed
+                kex_job_start(connection, kex_job_create(h, connection, &receivedPacket), kex_response_work, kex_response_complete);
 
 #else
                 logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Req", "Not implemented!");
@@ -1056,26 +2092,17 @@ void handle_kex_response(struct rasta_receive_handle *h, struct rasta_connection
                     return;
                 }
 #ifdef ENABLE_OPAQUE
-
-                struct RastaPacket response;
-                int ret;
-
-                logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: KEX Resp", "CTS in SEQ");
-                // valid Key Exchange response packet received
-                ret = kex_recover_credential(&connection->kex_state,(const uint8_t *) receivedPacket.data.bytes,receivedPacket.data.length,connection->my_id,connection->remote_id,connection->sn_i,h->logger);
-
-                if(ret){
-                    logger_log(h->logger,LOG_LEVEL_ERROR,"RaSTA HANDLE: KEX Resp", "Could not recover credentials!");
+                if(connection->kex_job != NULL){
+                    logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Resp","Key exchange response received while the request is computed!");
                     sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_UNEXPECTEDTYPE ,0);
                     return;
                 }
-                response = createKexAuthentication(connection->remote_id,connection->my_id,connection->sn_t,receivedPacket.sequence_number,current_ts(),receivedPacket.timestamp,h->hashing_context,connection->kex_state.user_auth_server,sizeof(connection->kex_state.user_auth_server),h->logger);
 
-                redundancy_mux_send(h->mux, response);
+                logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: KEX Resp", "CTS in SEQ");
+                // valid Key Exchange response packet received
 
-                // set values according to 5.6.2 [3]
+                // set values according to 5.6.2 [3], sn_t is increased when the authentication is sent
                 connection->sn_r = receivedPacket.sequence_number +1;
-                connection->sn_t += 1;
                 connection->cs_t = receivedPacket.sequence_number;
                 connection->cs_r = receivedPacket.confirmed_sequence_number;
                 connection->ts_r = receivedPacket.timestamp;
@@ -1085,12 +2112,8 @@ void handle_kex_response(struct rasta_receive_handle *h, struct rasta_connection
                 // cs_r updated, remove confirmed messages
                 sr_remove_confirmed_messages(h,connection);
 
-                // kex is done from our PoV, can expect data from now
-                connection->current_state = RASTA_CONNECTION_UP;
-
-                logger_hexdump(h->logger,LOG_LEVEL_INFO,connection->kex_state.session_key,sizeof(connection->kex_state.session_key),"Setting hash key to:");
-
-                rasta_set_hash_key_variable(h->hashing_context, (char *) connection->kex_state.session_key, sizeof(connection->kex_state.session_key));
+                // the authentication is sent when the credentials were recovered
+                kex_job_start(connection, kex_job_create(h, connection, &receivedPacket), kex_recover_work, kex_recover_complete);
 #else
                 logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Resp", "Not implemented!");
                 abort();
@@ -1160,7 +2183,7 @@ void handle_kex_auth(struct rasta_receive_handle *h, struct rasta_connection *co
                 sr_remove_confirmed_messages(h,connection);
 
                 // kex is done from our PoV, can expect data from now
-                connection->current_state = RASTA_CONNECTION_UP;
+                sr_set_state(connection, RASTA_CONNECTION_UP);
 #else
                 logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA HANDLE: KEX Auth", "Not implemented!");
                 abort();
@@ -1184,8 +2207,14 @@ void handle_kex_auth(struct rasta_receive_handle *h, struct rasta_connection *co
 
 void handle_discreq(struct rasta_receive_handle *h, struct rasta_connection *connection, struct RastaPacket receivedPacket){
     logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: DisconnectionRequest", "received DiscReq");
+    if (connection->flight_recorder.records != NULL) {
+        struct RastaDisconnectionData reason = extractRastaDisconnectionData(receivedPacket);
+        char detail[64];
+        snprintf(detail, sizeof(detail), "reason=%u details=%u", reason.reason, reason.details);
+        sr_flight_dump(h->handle, connection, RASTA_FLIGHT_TRIGGER_DISCREQ, detail);
+    }
 
-    connection->current_state = RASTA_CONNECTION_CLOSED;
+    sr_set_state(connection, RASTA_CONNECTION_CLOSED);
     sr_reset_connection(connection,connection->remote_id,h->info);
 
     // remove redundancy channel
@@ -1202,6 +2231,7 @@ void handle_discreq(struct rasta_receive_handle *h, struct rasta_connection *con
 
 void handle_hb(struct rasta_receive_handle *h, struct rasta_connection *connection, struct RastaPacket receivedPacket) {
     logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: Heartbeat", "Received heartbeat from %d", receivedPacket.sender_id);
+    RASTA_PROBE2(sr_heartbeat_receive, receivedPacket.sender_id, receivedPacket.sequence_number);
 
     if (connection->current_state == RASTA_CONNECTION_START) {
         //heartbeat is for connection setup
@@ -1229,17 +2259,17 @@ void handle_hb(struct rasta_receive_handle *h, struct rasta_connection *connecti
             // set values according to 5.6.2 [3]
             logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: Heartbeat", "Heartbeat is valid connection successful");
             connection->sn_r = receivedPacket.sequence_number +1;
-            connection->cs_t = receivedPacket.sequence_number;
+            sr_confirm_received(h, connection, receivedPacket.sequence_number);
             connection->cs_r = receivedPacket.confirmed_sequence_number;
             connection->ts_r = receivedPacket.timestamp;
 
             if(h->handle->config.values.kex.mode == KEY_EXCHANGE_MODE_NONE) {
                 // sequence number correct, ready to receive data
-                connection->current_state = RASTA_CONNECTION_UP;
+                sr_set_state(connection, RASTA_CONNECTION_UP);
             }
             else{
                 // need to negotiate session key first
-                connection->current_state = RASTA_CONNECTION_KEX_REQ;
+                sr_set_state(connection, RASTA_CONNECTION_KEX_REQ);
             }
 
             connection->hb_locked = 0;
@@ -1277,13 +2307,17 @@ void handle_hb(struct rasta_receive_handle *h, struct rasta_connection *connecti
 
                 // set values according to 5.6.2 [3]
                 connection->sn_r = receivedPacket.sequence_number +1;
-                connection->cs_t = receivedPacket.sequence_number;
+                sr_confirm_received(h, connection, receivedPacket.sequence_number);
                 connection->cs_r = receivedPacket.confirmed_sequence_number;
                 connection->ts_r = receivedPacket.timestamp;
 
                 connection->cts_r = receivedPacket.confirmed_timestamp;
+
+                // cs_r updated, remove confirmed messages
+                sr_remove_confirmed_messages(h,connection);
+
                 if (connection->current_state == RASTA_CONNECTION_RETRRUN) {
-                    connection->current_state = RASTA_CONNECTION_UP;
+                    sr_set_state(connection, RASTA_CONNECTION_UP);
                     logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: Heartbeat", "State changed from RetrRun to Up");
                     fire_on_connection_state_change(sr_create_notification_result(h->handle,connection));
                 }
@@ -1300,7 +2334,7 @@ void handle_hb(struct rasta_receive_handle *h, struct rasta_connection *connecti
             // ignore message, send RetrReq and goto tls_state RetrReq
             //TODO:send retransmission
             //send_retrreq(con);
-            connection->current_state = RASTA_CONNECTION_RETRREQ;
+            sr_set_state(connection, RASTA_CONNECTION_RETRREQ);
             logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HANDLE: Heartbeat", "Send retransmission");
 
             // fire connection tls_state changed event
@@ -1334,7 +2368,7 @@ void handle_data(struct rasta_receive_handle *h, struct rasta_connection *connec
 
                 // set values according to 5.6.2 [3]
                 connection->sn_r = receivedPacket.sequence_number +1;
-                connection->cs_t = receivedPacket.sequence_number;
+                sr_confirm_received(h, connection, receivedPacket.sequence_number);
                 connection->cs_r = receivedPacket.confirmed_sequence_number;
                 connection->ts_r = receivedPacket.timestamp;
                 connection->cts_r = receivedPacket.confirmed_timestamp;
@@ -1343,7 +2377,11 @@ void handle_data(struct rasta_receive_handle *h, struct rasta_connection *connec
                 // cs_r updated, remove confirmed messages
                 sr_remove_confirmed_messages(h,connection);
 
-
+                // a partner with a used up send window would wait for the next heartbeat otherwise
+                connection->unconfirmed_received++;
+                if (h->config.mwa != 0 && connection->unconfirmed_received >= h->config.mwa) {
+                    send_Heartbeat(h->mux, connection, 1);
+                }
             } else{
                 logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE: Data", "CTS not in SEQ");
 
@@ -1357,7 +2395,7 @@ void handle_data(struct rasta_receive_handle *h, struct rasta_connection *connec
             if (sr_cts_in_seq(connection, h->config, receivedPacket)){
                 // set values according to 5.6.2 [3]
                 connection->sn_r = receivedPacket.sequence_number + 1;
-                connection->cs_t = receivedPacket.sequence_number;
+                sr_confirm_received(h, connection, receivedPacket.sequence_number);
                 connection->ts_r = receivedPacket.timestamp;
             } else{
                 // retransmission failed, disconnect and close
@@ -1378,7 +2416,7 @@ void handle_data(struct rasta_receive_handle *h, struct rasta_connection *connec
             send_RetransmissionRequest(h->mux, connection);
 
             // change tls_state to RetrReq
-            connection->current_state = RASTA_CONNECTION_RETRREQ;
+            sr_set_state(connection, RASTA_CONNECTION_RETRREQ);
 
             fire_on_connection_state_change(sr_create_notification_result(h->handle,connection));
         } else if (connection->current_state == RASTA_CONNECTION_RETRREQ){
@@ -1411,7 +2449,7 @@ void handle_retrreq(struct rasta_receive_handle *h, struct rasta_connection *con
         // FIXME: update connection attr (copy from RASTA_TYPE_DATA case, DRY)
         // set values according to 5.6.2 [3]
         connection->sn_r = receivedPacket.sequence_number +1;
-        connection->cs_t = receivedPacket.sequence_number;
+        sr_confirm_received(h, connection, receivedPacket.sequence_number);
         connection->cs_r = receivedPacket.confirmed_sequence_number;
         connection->ts_r = receivedPacket.timestamp;
 
@@ -1428,10 +2466,10 @@ void handle_retrreq(struct rasta_receive_handle *h, struct rasta_connection *con
 
         if (connection->current_state == RASTA_CONNECTION_UP){
             // change tls_state to up
-            connection->current_state = RASTA_CONNECTION_UP;
+            sr_set_state(connection, RASTA_CONNECTION_UP);
         } else if(connection->current_state == RASTA_CONNECTION_RETRREQ){
             // change tls_state to RetrReq
-            connection->current_state = RASTA_CONNECTION_RETRREQ;
+            sr_set_state(connection, RASTA_CONNECTION_RETRREQ);
         }
 
         // fire connection tls_state changed event
@@ -1449,7 +2487,7 @@ void handle_retrreq(struct rasta_receive_handle *h, struct rasta_connection *con
 
         sr_retransmit_data(h,connection);
         // change tls_state to RetrReq
-        connection->current_state = RASTA_CONNECTION_RETRREQ;
+        sr_set_state(connection, RASTA_CONNECTION_RETRREQ);
 
         // fire connection tls_state changed event
         fire_on_connection_state_change(sr_create_notification_result(h->handle,connection));
@@ -1469,11 +2507,11 @@ void handle_retrresp(struct rasta_receive_handle *h, struct rasta_connection *co
         logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA receive", "RetrResp: CTS in Seq");
 
         // change to retransmission tls_state
-        connection->current_state = RASTA_CONNECTION_RETRRUN;
+        sr_set_state(connection, RASTA_CONNECTION_RETRRUN);
 
         // set values according to 5.6.2 [3]
         connection->sn_r = receivedPacket.sequence_number +1;
-        connection->cs_t = receivedPacket.sequence_number;
+        sr_confirm_received(h, connection, receivedPacket.sequence_number);
         connection->cs_r = receivedPacket.confirmed_sequence_number;
         connection->ts_r = receivedPacket.timestamp;
 
@@ -1506,7 +2544,7 @@ void handle_retrdata(struct rasta_receive_handle *h, struct rasta_connection *co
 
                 // set values according to 5.6.2 [3]
                 connection->sn_r = receivedPacket.sequence_number +1;
-                connection->cs_t = receivedPacket.sequence_number;
+                sr_confirm_received(h, connection, receivedPacket.sequence_number);
                 connection->cs_r = receivedPacket.confirmed_sequence_number;
                 connection->ts_r = receivedPacket.timestamp;
             }
@@ -1523,7 +2561,7 @@ void handle_retrdata(struct rasta_receive_handle *h, struct rasta_connection *co
             // send RetrReq
             logger_log(h->logger, LOG_LEVEL_DEBUG, "Process RetrData", "changing to tls_state RetrReq");
             send_RetransmissionRequest(h->mux,connection);
-            connection->current_state = RASTA_CONNECTION_RETRREQ;
+            sr_set_state(connection, RASTA_CONNECTION_RETRREQ);
             fire_on_connection_state_change(sr_create_notification_result(h->handle,connection));
         }
     }
@@ -1564,6 +2602,63 @@ bool sr_rekeying_skipped(struct rasta_connection *connection, struct RastaConfig
  * threads
  */
 
+/**
+ * puts the connection request of a new connection into the backlog of the handle, so the packets of the established
+ * connections are processed first. A request that does not fit into the backlog is discarded, the client repeats it
+ * @param h the receive handle
+ * @param con the connection of the sender, NULL if it is unknown
+ * @param packet the connection request
+ * @return 1 if the request was taken, 0 if it has to be handled right away
+ */
+static int sr_defer_connection_request(struct rasta_receive_handle *h, struct rasta_connection *con,
+                                       struct RastaPacket *packet) {
+    struct rasta_handle *handle = h->handle;
+    if (handle->conreq_backlog == NULL ||
+        (con != NULL && con->current_state != RASTA_CONNECTION_CLOSED && con->current_state != RASTA_CONNECTION_DOWN)) {
+        return 0;
+    }
+
+    if (fifo_get_size(handle->conreq_backlog) == fifo_get_capacity(handle->conreq_backlog)) {
+        logger_log(h->logger, LOG_LEVEL_INFO, "RaSTA ADMISSION", "discarded the ConReq of %X, too many are waiting",
+                   packet->sender_id);
+        handle->receive_stats.shed_conreqs++;
+        freeRastaByteArray(&packet->data);
+        return 1;
+    }
+
+    struct RastaPacket *deferred = rmalloc(sizeof(struct RastaPacket));
+    *deferred = *packet;
+    fifo_push(handle->conreq_backlog, deferred);
+    handle->receive_stats.deferred_conreqs++;
+    return 1;
+}
+
+/**
+ * handles up to conreq_budget connection requests of the backlog
+ * @param h the receive handle
+ */
+static void sr_admit_connection_requests(struct rasta_receive_handle *h) {
+    struct rasta_handle *handle = h->handle;
+    for (unsigned int i = 0; i < handle->config.values.sending.conreq_budget; i++) {
+        struct RastaPacket *packet = fifo_pop(handle->conreq_backlog);
+        if (packet == NULL) {
+            break;
+        }
+
+        struct rasta_connection *con = rasta_id_index_get(&handle->connection_index, packet->sender_id);
+        if (con == NULL || con->current_state == RASTA_CONNECTION_CLOSED || con->current_state == RASTA_CONNECTION_DOWN) {
+            handle_conreq(h, con, *packet);
+        } else {
+            // an earlier request of the client was admitted already
+            logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA ADMISSION", "discarded a repeated ConReq of %X",
+                       packet->sender_id);
+        }
+
+        freeRastaByteArray(&packet->data);
+        rfree(packet);
+    }
+}
+
 int on_readable_event(void* handle) {
     struct rasta_receive_handle *h = (struct rasta_receive_handle*) handle;
 
@@ -1572,15 +2667,21 @@ int on_readable_event(void* handle) {
     if (!redundancy_mux_try_retrieve_all(h->mux, &receivedPacket)) {
         return 0;
     }
+    h->last_received = 1;
+    h->last_sender_id = receivedPacket.sender_id;
 
     logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA RECEIVE", "Received packet %d from %d to %d", receivedPacket.type, receivedPacket.sender_id, receivedPacket.receiver_id);
+    rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_RECEIVE, receivedPacket.sender_id, receivedPacket.sequence_number,
+                    receivedPacket.confirmed_sequence_number, 0, receivedPacket.type);
+    RASTA_PROBE3(sr_receive, receivedPacket.sender_id, receivedPacket.sequence_number, receivedPacket.type);
 
-    struct rasta_connection* con;
-    for (con = h->handle->first_con; con; con = con->linkedlist_next) {
-        if (con->remote_id == receivedPacket.sender_id) break;
-    }
+    struct rasta_connection* con = rasta_id_index_get(&h->handle->connection_index, receivedPacket.sender_id);
     //new client request
     if (receivedPacket.type == RASTA_TYPE_CONNREQ){
+        if (sr_defer_connection_request(h, con, &receivedPacket)) {
+            // the data is freed when the request is admitted
+            return 0;
+        }
         con = handle_conreq(h, con, receivedPacket);
 
         freeRastaByteArray(&receivedPacket.data);
@@ -1598,6 +2699,7 @@ int on_readable_event(void* handle) {
 
     //handle response
     if (receivedPacket.type == RASTA_TYPE_CONNRESP) {
+        sr_flight_record(con, RASTA_FLIGHT_RECEIVE, &receivedPacket, 0);
         handle_conresp(h, con, receivedPacket);
 
         freeRastaByteArray(&receivedPacket.data);
@@ -1610,8 +2712,21 @@ int on_readable_event(void* handle) {
     // check message checksum
     if (!receivedPacket.checksum_correct){
         logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA RECEIVE", "Received packet checksum incorrect");
+        rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_DISCARD, receivedPacket.sender_id,
+                        receivedPacket.sequence_number, receivedPacket.confirmed_sequence_number, 0,
+                        RASTA_TRACE_DISCARD_CHECKSUM);
+        RASTA_PROBE3(sr_discard, receivedPacket.sender_id, receivedPacket.sequence_number, RASTA_TRACE_DISCARD_CHECKSUM);
+        sr_flight_record(con, RASTA_FLIGHT_DISCARD, &receivedPacket, RASTA_TRACE_DISCARD_CHECKSUM);
         // increase safety error counter
         con->errors.safety++;
+        const struct RastaConfigFlightRecorder * flight = &h->handle->config.values.flight_recorder;
+        if (con->flight_recorder.records != NULL &&
+            rasta_flight_recorder_safety_error(&con->flight_recorder, event_system_now(),
+                                               (uint64_t) h->config.t_max * NS_PER_MS, flight->safety_errors)) {
+            char detail[64];
+            snprintf(detail, sizeof(detail), "%u wrong safety codes within T_MAX", flight->safety_errors);
+            sr_flight_dump(h->handle, con, RASTA_FLIGHT_TRIGGER_SAFETY, detail);
+        }
 
         freeRastaByteArray(&receivedPacket.data);
         return 0;
@@ -1620,6 +2735,11 @@ int on_readable_event(void* handle) {
     // check for plausible ids
     if (!sr_message_authentic(con, receivedPacket)) {
         logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA RECEIVE", "Received packet invalid sender/receiver");
+        rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_DISCARD, receivedPacket.sender_id,
+                        receivedPacket.sequence_number, receivedPacket.confirmed_sequence_number, 0,
+                        RASTA_TRACE_DISCARD_ADDRESS);
+        RASTA_PROBE3(sr_discard, receivedPacket.sender_id, receivedPacket.sequence_number, RASTA_TRACE_DISCARD_ADDRESS);
+        sr_flight_record(con, RASTA_FLIGHT_DISCARD, &receivedPacket, RASTA_TRACE_DISCARD_ADDRESS);
         // increase address error counter
         con->errors.address++;
 
@@ -1627,9 +2747,20 @@ int on_readable_event(void* handle) {
         return 0;
     }
 
+    // a connection taken over from a primary does not know how many PDUs the partner sent since the last round
+    if (con->resync) {
+        con->sn_r = receivedPacket.sequence_number;
+        con->resync = 0;
+    }
+
     // check sequency number range
     if (!sr_sn_range_valid(con, h->config, receivedPacket)){
         logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA RECEIVE", "Received packet sn range invalid");
+        rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_DISCARD, receivedPacket.sender_id,
+                        receivedPacket.sequence_number, receivedPacket.confirmed_sequence_number, 0,
+                        RASTA_TRACE_DISCARD_SN);
+        RASTA_PROBE3(sr_discard, receivedPacket.sender_id, receivedPacket.sequence_number, RASTA_TRACE_DISCARD_SN);
+        sr_flight_record(con, RASTA_FLIGHT_DISCARD, &receivedPacket, RASTA_TRACE_DISCARD_SN);
 
         // invalid -> increase error counter and discard packet
         con->errors.sn++;
@@ -1641,6 +2772,11 @@ int on_readable_event(void* handle) {
     // check confirmed sequence number
     if (!sr_cs_valid(con, receivedPacket)){
         logger_log(h->logger, LOG_LEVEL_ERROR, "RaSTA RECEIVE", "Received packet cs invalid");
+        rasta_trace_add(h->logger->trace, RASTA_TRACE_SR_DISCARD, receivedPacket.sender_id,
+                        receivedPacket.sequence_number, receivedPacket.confirmed_sequence_number, 0,
+                        RASTA_TRACE_DISCARD_CS);
+        RASTA_PROBE3(sr_discard, receivedPacket.sender_id, receivedPacket.sequence_number, RASTA_TRACE_DISCARD_CS);
+        sr_flight_record(con, RASTA_FLIGHT_DISCARD, &receivedPacket, RASTA_TRACE_DISCARD_CS);
 
         // invalid -> increase error counter and discard packet
         con->errors.cs++;
@@ -1656,6 +2792,7 @@ int on_readable_event(void* handle) {
         return 0;
     }
 
+    sr_flight_record(con, RASTA_FLIGHT_RECEIVE, &receivedPacket, 0);
     switch (receivedPacket.type){
         case RASTA_TYPE_RETRDATA:
             handle_retrdata(h,con, receivedPacket);
@@ -1705,7 +2842,19 @@ int event_connection_expired(void* carry_data) {
     struct rasta_connection* connection = data->connection;
     //so check if connection is valid
 
-    if (connection == NULL || connection->hb_locked) {
+    if (connection == NULL) {
+        return 0;
+    }
+
+    // the connection request of a client was not answered
+    if (connection->role == RASTA_ROLE_CLIENT && connection->current_state == RASTA_CONNECTION_START) {
+        disable_timed_event(&connection->send_heartbeat_event);
+        disable_timed_event(&connection->timeout_event);
+        sr_schedule_reconnect(h->handle, connection);
+        return 0;
+    }
+
+    if (connection->hb_locked) {
         return 0;
     }
 
@@ -1714,12 +2863,16 @@ int event_connection_expired(void* carry_data) {
         || connection->current_state == RASTA_CONNECTION_RETRREQ
         || connection->current_state == RASTA_CONNECTION_RETRRUN) {
 
+        sr_flight_dump(h->handle, connection, RASTA_FLIGHT_TRIGGER_TIMEOUT, "T_I expired");
+
         // fire heartbeat timeout event
         fire_on_heartbeat_timeout(sr_create_notification_result(h->handle, connection));
 
         // T_i expired -> close connection
         sr_close_connection(connection,h->handle,h->mux,h->info, RASTA_DISC_REASON_TIMEOUT, 0);
         logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HEARTBEAT", "T_i timer expired - \033[91mdisconnected\033[0m");
+
+        sr_schedule_reconnect(h->handle, connection);
     }
 
     disable_timed_event(&connection->send_heartbeat_event);
@@ -1727,116 +2880,421 @@ int event_connection_expired(void* carry_data) {
     return 0;
 }
 
+/**
+ * @param connection the connection
+ * @return 1 if the connection sends heartbeats in its current state and does not retransmit
+ */
+static int sends_heartbeats(struct rasta_connection* connection) {
+    // a running retransmission ends with its own heartbeat
+    return !connection->hb_locked && !connection->retransmitting && (connection->current_state == RASTA_CONNECTION_UP
+                                      || connection->current_state == RASTA_CONNECTION_RETRREQ
+                                      || connection->current_state == RASTA_CONNECTION_RETRRUN);
+}
+
+/**
+ * adds a connection to the heartbeat batch of a handle
+ * @param h the heartbeat handle
+ * @param count the amount of connections in the batch, increased by one
+ * @param connection the connection
+ */
+static void heartbeat_batch_add(struct rasta_heartbeat_handle* h, unsigned int* count,
+                                struct rasta_connection* connection) {
+    if (*count == h->batch_capacity) {
+        h->batch_capacity = h->batch_capacity ? h->batch_capacity * 2 : 16;
+        h->batch = rrealloc(h->batch, h->batch_capacity * sizeof(struct RastaPacket));
+        h->batch_connections = rrealloc(h->batch_connections, h->batch_capacity * sizeof(struct rasta_connection*));
+    }
+    h->batch_connections[(*count)++] = connection;
+}
+
 int heartbeat_send_event(void* carry_data) {
     struct timed_event_data* data = carry_data;
     struct rasta_heartbeat_handle* h = (struct rasta_heartbeat_handle*) data->handle;
 
     struct rasta_connection* connection = data->connection;
 
-
-    if (connection == NULL || connection->hb_locked) {
+    // a paced retransmission may wait longer than T_H for its turn, its next data packet takes the place of the
+    // heartbeat. Every retransmitted packet reschedules the heartbeat, so this only happens while it waits
+    if (connection != NULL && connection->retransmitting && !connection->hb_locked &&
+        h->handle->receive_handle != NULL) {
+        sr_retransmit_keepalive(h->handle->receive_handle, connection);
         return 0;
     }
 
-
-    //connection is valid, check current tls_state
-    if (connection->current_state == RASTA_CONNECTION_UP
-        || connection->current_state == RASTA_CONNECTION_RETRREQ
-        || connection->current_state == RASTA_CONNECTION_RETRRUN) {
-        send_Heartbeat(h->mux, connection, 0);
-
-        logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HEARTBEAT", "Heartbeat sent to %d", connection->remote_id);
+    if (connection == NULL || !sends_heartbeats(connection)) {
+        return 0;
     }
 
-    return 0;
-}
+    // the connections whose heartbeats are due within the tick send them now, with one batch
+    evtime_t started = get_nanotime();
+    evtime_t horizon = event_system_now() + (evtime_t) h->config.heartbeat_tick_ms * NS_PER_MS;
+    unsigned int count = 0;
+    heartbeat_batch_add(h, &count, connection);
+    for (struct rasta_connection* con = h->handle->first_con; con; con = con->linkedlist_next) {
+        timed_event* event = &con->send_heartbeat_event;
+        if (con != connection && event->enabled && event->last_call + event->interval <= horizon &&
+            sends_heartbeats(con)) {
+            heartbeat_batch_add(h, &count, con);
+        }
+    }
 
-// TODO: split up this mess of a function
-int data_send_event(void * carry_data) {
-    struct rasta_sending_handle * h = carry_data;
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_connection* con = h->batch_connections[i];
+        h->batch[i] = createHeartbeat(con->remote_id, con->my_id, con->sn_t, con->cs_t, sr_timestamp(con), con->ts_r,
+                                      &h->mux->sr_hashing_context);
+        RASTA_PROBE2(sr_heartbeat_send, con->remote_id, con->sn_t);
+        con->sn_t = con->sn_t + 1;
+        con->unconfirmed_received = 0;
+    }
+    redundancy_mux_send_batch(h->mux, h->batch, count);
+    for (unsigned int i = 0; i < count; i++) {
+        sr_flight_record(h->batch_connections[i], RASTA_FLIGHT_SEND, &h->batch[i], 0);
+    }
 
-    for (struct rasta_connection* con = h->handle->first_con; con; con = con->linkedlist_next) {
+    // the event loop schedules the event that fired
+    for (unsigned int i = 1; i < count; i++) {
+        reschedule_event(&h->batch_connections[i]->send_heartbeat_event);
+    }
 
-        if (con->current_state == RASTA_CONNECTION_DOWN || con->current_state == RASTA_CONNECTION_CLOSED) {
-            continue;
+    // the heartbeats are sent together, every one of them costs its connection an equal share
+    unsigned long share = (unsigned long) (get_nanotime() - started) / count;
+    for (unsigned int i = 0; i < count; i++) {
+        rasta_metrics_add(&h->batch_connections[i]->metrics.send_ns, share);
+    }
+
+    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA HEARTBEAT", "Heartbeat sent to %d and %u other connections",
+               connection->remote_id, count - 1);
+    return 0;
+}
+
+void sr_take_send_messages(struct logger_t * logger, struct rasta_connection * con,
+                           struct RastaMessageData * app_messages, uint64_t now, uint64_t encode_ns) {
+    // the queue times are taken with the clock the messages were queued with
+    uint64_t dequeued_ns = encode_ns != 0 ? encode_ns : now;
+    for (unsigned int i = 0; i < app_messages->count; i++) {
+
+        // strict priority, the bulk lane fills the rest of the data packet
+        rasta_send_priority priority = RASTA_SEND_URGENT;
+        struct rasta_queued_message * elem = fifo_pop(con->fifo_send_urgent);
+        if (elem == NULL) {
+            priority = RASTA_SEND_BULK;
+            elem = fifo_pop(con->fifo_send);
         }
+        con->send_queued_bytes -= elem->message.length + RASTA_MESSAGE_LENGTH_PREFIX;
+        logger_log(logger, LOG_LEVEL_DEBUG, "RaSTA send handler", "Adding application message '%s' to data packet",
+                   elem->message.bytes);
+        rasta_residency_record(con->residency, RASTA_RESIDENCY_SEND_QUEUE, elem->queued_ns, encode_ns);
+        rasta_histogram_record(&con->metrics.send_queue_us[priority],
+                               dequeued_ns > elem->queued_ns ? (dequeued_ns - elem->queued_ns) / 1000 : 0);
+
+        // the data packet takes the bytes of the queued message
+        app_messages->data_array[i] = elem->message;
+        rfree(elem);
+    }
+}
 
+// TODO: split up this mess of a function
+/**
+ * sends the next data packet of a connection from its send queue
+ * @param h the sending handle
+ * @param con the connection, its send window has to be open
+ * @param msg_queue the amount of messages in the send queue
+ * @param now the time of the event loop
+ * @param send_started the time the data packet is started in the nanoseconds of get_nanotime()
+ */
+static void sr_send_data_packet(struct rasta_sending_handle * h, struct rasta_connection * con, unsigned int msg_queue,
+                                evtime_t now, evtime_t send_started) {
+    // the messages leave the send queue when the data packet is encoded
+    evtime_t encode_ns = con->residency != NULL ? send_started : 0;
+    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler", "Messages waiting to be send: %d",
+                msg_queue);
 
-        unsigned int retr_data_count = sr_retr_data_available(h->logger,con);
-        if (retr_data_count <= h->config.max_packet) {
-            unsigned int msg_queue = sr_rasta_send_data_available(h->logger,con);
+    con->hb_stopped = 1;
+    con->is_sending = 1;
 
-            if (msg_queue > 0) {
-                logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler", "Messages waiting to be send: %d",
-                            msg_queue);
+    struct RastaMessageData app_messages;
 
-                con->hb_stopped = 1;
-                con->is_sending = 1;
+    if (msg_queue >= h->config.max_packet) {
+        msg_queue = h->config.max_packet;
+    }
+    allocateRastaMessageData(&app_messages, msg_queue);
 
-                struct RastaMessageData app_messages;
-                struct RastaByteArray msg;
+    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler",
+                "Sending %d application messages from queue",
+                msg_queue);
 
-                if (msg_queue >= h->config.max_packet) {
-                    msg_queue = h->config.max_packet;
-                }
-                allocateRastaMessageData(&app_messages, msg_queue);
 
-                logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler",
-                            "Sending %d application messages from queue",
-                            msg_queue);
+    sr_take_send_messages(h->logger, con, &app_messages, now, encode_ns);
 
+    struct RastaPacket data = createDataMessage(con->remote_id, con->my_id, con->sn_t,
+                                                con->cs_t, sr_timestamp(con), con->ts_r,
+                                                app_messages, h->hashing_context);
 
-                for (unsigned int i = 0; i < msg_queue; i++) {
 
-                    struct RastaByteArray * elem;
-                    elem = fifo_pop(con->fifo_send);
-                    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler",
-                                "Adding application message '%s' to data packet",
-                                elem->bytes);
+    // the packet is sent as it is stored for retransmission, so the safety code is calculated once
+    struct rasta_retr_element * stored = retrbuffer_add(&con->retr_buffer, &data, h->hashing_context);
+    if (stored != NULL) {
+        unsigned char * pdu = stored->pdu;
+        redundancy_mux_send_encoded_batch(h->mux, con->remote_id, &pdu, &stored->length, 1);
+    } else {
+        redundancy_mux_send(h->mux, data);
+    }
+    if (encode_ns != 0) {
+        rasta_residency_record(con->residency, RASTA_RESIDENCY_TRANSMIT, encode_ns, get_nanotime());
+    }
+    sr_flight_record(con, RASTA_FLIGHT_SEND, &data, 0);
 
-                    allocateRastaByteArray(&msg, elem->length);
-                    msg.bytes = rmemcpy(msg.bytes, elem->bytes, elem->length);
-                    freeRastaByteArray(elem);
-                    rfree(elem);
-                    app_messages.data_array[i] = msg;
-                }
+    logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler", "Sent data packet from queue");
 
-                struct RastaPacket data = createDataMessage(con->remote_id, con->my_id, con->sn_t,
-                                                            con->cs_t, cur_timestamp(), con->ts_r,
-                                                            app_messages, h->hashing_context);
+    con->sn_t = data.sequence_number + 1;
+    con->unconfirmed_received = 0;
+    sr_replicate_if_due(h->handle, con);
 
+    // set last message ts
+    reschedule_event(&con->send_heartbeat_event);
 
-                struct RastaByteArray packet = rastaModuleToBytes(data, h->hashing_context);
+    con->hb_stopped = 0;
 
-                struct RastaByteArray * to_fifo = rmalloc(sizeof(struct RastaByteArray));
-                allocateRastaByteArray(to_fifo, packet.length);
-                rmemcpy(to_fifo->bytes, packet.bytes, packet.length);
-                fifo_push(con->fifo_retr, to_fifo);
+    freeRastaMessageData(&app_messages);
+    freeRastaByteArray(&data.data);
 
-                redundancy_mux_send(h->mux, data);
+    con->is_sending = 0;
+    rasta_metrics_add(&con->metrics.send_ns, (unsigned long) (get_nanotime() - send_started));
 
-                logger_log(h->logger, LOG_LEVEL_DEBUG, "RaSTA send handler", "Sent data packet from queue");
+    sr_send_check_writable(h->handle, con, h->config);
+}
+
+int data_send_event(void * carry_data) {
+    struct rasta_sending_handle * h = carry_data;
+    evtime_t now = event_system_now();
+    evtime_t run_started = get_nanotime();
+    uint64_t pacing_wait_ns = UINT64_MAX;
+    unsigned int budget = h->config.send_budget;
+    unsigned int sent = 0;
+
+    // the turn starts behind the connection that sent last, so the first connections of the list are not always
+    // served first and the ones left over by the budget go first in the next turn
+    struct rasta_connection * start = rasta_id_index_get(&h->handle->connection_index, h->send_last_id);
+    start = start != NULL && start->linkedlist_next != NULL ? start->linkedlist_next : h->handle->first_con;
+
+    // from the start to the end of the list, then from the beginning up to the start
+    for (int wrapped = 0; wrapped < 2; wrapped++) {
+        struct rasta_connection * con = wrapped ? h->handle->first_con : start;
+        for (struct rasta_connection * next; con != NULL && !(wrapped && con == start); con = next) {
+            // on_writable might close the connection
+            next = con->linkedlist_next;
+
+            // only a connection that keeps waiting for its turn keeps the time it started to wait
+            uint64_t ready_since_ns = con->send_ready_since_ns;
+            con->send_ready_since_ns = 0;
+
+            if (con->current_state == RASTA_CONNECTION_DOWN || con->current_state == RASTA_CONNECTION_CLOSED) {
+                continue;
+            }
 
-                con->sn_t = data.sequence_number + 1;
+            // new data packets follow the retransmission, sr_retransmit_next() wakes up the send handler for them
+            if (con->retransmitting || !sr_send_window_open(con)) {
+                continue;
+            }
 
-                // set last message ts
-                reschedule_event(&con->send_heartbeat_event);
+            unsigned int msg_queue = sr_rasta_send_data_available(h->logger,con);
+            if (msg_queue == 0) {
+                continue;
+            }
 
-                con->hb_stopped = 0;
+            uint64_t wait_ns;
+            if (!sr_send_coalesce_ready(con, h->config, now, &wait_ns)) {
+                // wait for more messages to fill the data packet
+                if (wait_ns < pacing_wait_ns) {
+                    pacing_wait_ns = wait_ns;
+                }
+                continue;
+            }
 
-                freeRastaMessageData(&app_messages);
-                freeRastaByteArray(&packet);
-                freeRastaByteArray(&data.data);
+            if (budget != 0 && sent >= budget) {
+                // the other connections used up this turn, send_notification_event() starts the next one
+                con->send_ready_since_ns = ready_since_ns != 0 ? ready_since_ns : run_started;
+                continue;
+            }
 
-                con->is_sending = 0;
+            if (!sr_send_bucket_take(&con->send_bucket, h->config, now)) {
+                // out of send credit, try again when the next token is available
+                wait_ns = sr_send_bucket_wait(&con->send_bucket, h->config.send_rate);
+                if (wait_ns < pacing_wait_ns) {
+                    pacing_wait_ns = wait_ns;
+                }
+                continue;
             }
+
+            evtime_t send_started = get_nanotime();
+            uint64_t ready_ns = ready_since_ns != 0 ? ready_since_ns : run_started;
+            rasta_histogram_record(&con->metrics.send_schedule_us,
+                                   send_started > ready_ns ? (unsigned long) ((send_started - ready_ns) / 1000) : 0);
+            h->send_last_id = (uint32_t) con->remote_id;
+            sent++;
+
+            sr_send_data_packet(h, con, msg_queue, now, send_started);
         }
+    }
+
+    if (pacing_wait_ns != UINT64_MAX && h->pacing_event != NULL) {
+        h->pacing_event->interval = pacing_wait_ns;
+        enable_timed_event(h->pacing_event);
+    }
+    return 0;
+}
+
+int send_pacing_event(void * carry_data) {
+    struct rasta_sending_handle * h = carry_data;
+    disable_timed_event(h->pacing_event);
+    rasta_handle_notify(h->handle->send_notify_fd);
+    return 0;
+}
 
-        usleep(50);
+/**
+ * checks if data_send_event() would send a data packet for any connection.
+ * Connections without send credit, with messages that wait to be coalesced or with a running retransmission are
+ * skipped, the pacing events wake up the send handler for them
+ * @param h the RaSTA handle
+ * @return 1 if messages can be sent, 0 otherwise
+ */
+static int sr_send_data_pending(struct rasta_handle* h) {
+    evtime_t now = event_system_now();
+    uint64_t wait_ns;
+    for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
+        if (con->current_state == RASTA_CONNECTION_DOWN || con->current_state == RASTA_CONNECTION_CLOSED) {
+            continue;
+        }
+        if (!con->retransmitting
+            && sr_send_window_open(con)
+            && sr_rasta_send_data_available(&h->logger, con) > 0
+            && sr_send_coalesce_ready(con, h->config.values.sending, now, &wait_ns)
+            && sr_send_bucket_ready(&con->send_bucket, h->config.values.sending, now)) {
+            return 1;
+        }
     }
     return 0;
 }
 
+/**
+ * resets an eventfd after its handler woke up
+ * @param notify_fd the eventfd
+ */
+static void sr_clear_notification(int notify_fd) {
+    uint64_t value;
+    // the eventfd is non-blocking, a failed read only means there was nothing to reset
+    ssize_t result = read(notify_fd, &value, sizeof(value));
+    (void) result;
+}
+
+/**
+ * closes the eventfds of the send and receive handlers
+ * @param h the RaSTA handle
+ */
+static void sr_close_notifications(struct rasta_handle* h) {
+    if (h->send_notify_fd != -1) {
+        close(h->send_notify_fd);
+        h->send_notify_fd = -1;
+    }
+    if (h->receive_notify_fd != -1) {
+        close(h->receive_notify_fd);
+        h->receive_notify_fd = -1;
+    }
+}
+
+int send_notification_event(void* carry_data) {
+    struct rasta_sending_handle* h = carry_data;
+    struct rasta_handle* handle = h->handle;
+
+    sr_clear_notification(handle->send_notify_fd);
+    int result = data_send_event(h);
+
+    // more messages are queued than fit in one data packet per connection
+    if (result == 0 && sr_send_data_pending(handle)) {
+        rasta_handle_notify(handle->send_notify_fd);
+    }
+    return result;
+}
+
+int receive_notification_event(void* carry_data) {
+    struct rasta_receive_handle* h = carry_data;
+    struct rasta_handle* handle = h->handle;
+    unsigned int budget = handle->config.values.sending.receive_budget;
+    unsigned int processed = 0;
+    int result = 0;
+
+    sr_clear_notification(handle->receive_notify_fd);
+
+    // redundancy_mux_try_retrieve_all() rotates over the channels, so the budget is shared among the peers
+    evtime_t started = get_nanotime();
+    evtime_t mark = started;
+    while ((budget == 0 || processed < budget) && redundancy_mux_data_available(&handle->mux)) {
+        h->last_received = 0;
+        result = on_readable_event(h);
+        processed++;
+
+        // one clock read per PDU, the time since the previous one is what its sender cost
+        evtime_t now = get_nanotime();
+        struct rasta_connection* sender = h->last_received && handle->receive_notify_fd != -1
+                                              ? rasta_id_index_get(&handle->connection_index, h->last_sender_id)
+                                              : NULL;
+        if (sender != NULL) {
+            rasta_metrics_add(&sender->metrics.receive_ns, (unsigned long) (now - mark));
+        }
+        mark = now;
+
+        if (result != 0 || handle->receive_notify_fd == -1) {
+            // the loop is terminating or the handle was cleaned up by a notification
+            break;
+        }
+    }
+
+    if (processed > 0 && handle->receive_notify_fd != -1) {
+        rasta_receive_stage_record(&handle->mux.receive_stages, RASTA_RECEIVE_STAGE_DISPATCH, processed,
+                                   (unsigned long) (mark - started));
+    }
+
+    handle->receive_stats.wakeups++;
+    handle->receive_stats.packets += processed;
+    handle->receive_stats.last_wakeup_packets = processed;
+    if (processed > handle->receive_stats.max_wakeup_packets) {
+        handle->receive_stats.max_wakeup_packets = processed;
+    }
+
+    if (result != 0 || handle->receive_notify_fd == -1) {
+        return result;
+    }
+
+    // new connections are set up after the packets of the established ones
+    if (handle->conreq_backlog != NULL) {
+        sr_admit_connection_requests(h);
+        if (handle->receive_notify_fd == -1) {
+            return 0;
+        }
+    }
+
+    // the application retrieved messages, confirm the PDUs whose confirmations were held back
+    if (h->receive_held_count > 0) {
+        unsigned int held = 0;
+        for (struct rasta_connection* con = handle->first_con; con != NULL; con = con->linkedlist_next) {
+            held += (unsigned int) sr_release_received(h, con);
+        }
+        h->receive_held_count = held;
+    }
+
+    // the budget is used up, come back for the remaining packets after the other events had their turn
+    if (redundancy_mux_data_available(&handle->mux) ||
+        (handle->conreq_backlog != NULL && fifo_get_size(handle->conreq_backlog) > 0)) {
+        rasta_handle_notify(handle->receive_notify_fd);
+    }
+
+    // received confirmations might have freed space in the retransmission buffer
+    if (sr_send_data_pending(handle)) {
+        rasta_handle_notify(handle->send_notify_fd);
+    }
+    return result;
+}
+
 void sr_init_handle_manually(struct rasta_handle *handle, struct RastaConfigInfo configuration, struct DictionaryArray accepted_version, struct logger_t logger) {
     rasta_handle_manually_init(handle,configuration,accepted_version, logger);
 
@@ -1845,6 +3303,11 @@ void sr_init_handle_manually(struct rasta_handle *handle, struct RastaConfigInfo
     //redundancy_mux_set_config_id(&handle->mux,handle->own_id);
     // register redundancy layer diagnose notification handler
     handle->mux.notifications.on_diagnostics_available = handle->notifications.on_redundancy_diagnostic_notification;
+    handle->mux.callback_executor = handle->callback_executor;
+    if (handle->config.values.flight_recorder.records > 0) {
+        handle->mux.on_transport_failure = sr_on_transport_failure;
+        handle->mux.transport_failure_context = handle;
+    }
 
     // setup MD4
     /*setMD4checksum(handle->config.values.sending.md4_type,
@@ -1854,15 +3317,30 @@ void sr_init_handle_manually(struct rasta_handle *handle, struct RastaConfigInfo
                    handle->config.values.sending.md4_d);*/
 }
 
-void sr_init_handle(struct rasta_handle* handle, const char* config_file_path) {
-
-    rasta_handle_init(handle, config_file_path);
+/**
+ * initializes the redundancy layer and the hashing context of a handle whose configuration is loaded
+ * @param handle the handle
+ * @param socket_owner the handle whose sockets are shared, NULL if the handle opens sockets of its own
+ */
+static void sr_init_layers(struct rasta_handle* handle, struct rasta_handle* socket_owner) {
+    // the receive buffers are taken with the placement of the handle
+    struct rmemory_placement previous_placement = rmemory_set_thread_placement(handle->placement);
 
     // init the redundancy layer
-    handle->mux = redundancy_mux_init_(handle->redlogger, handle->config.values);
+    if (socket_owner != NULL) {
+        handle->mux = redundancy_mux_init_member(handle->redlogger, handle->config.values, &socket_owner->mux);
+        redundancy_mux_add_member(&socket_owner->mux, &handle->mux);
+    } else {
+        handle->mux = redundancy_mux_init_(handle->redlogger, handle->config.values);
+    }
     //redundancy_mux_set_config_id(&handle->mux,handle->own_id);
     // register redundancy layer diagnose notification handler
     handle->mux.notifications.on_diagnostics_available = handle->notifications.on_redundancy_diagnostic_notification;
+    handle->mux.callback_executor = handle->callback_executor;
+    if (handle->config.values.flight_recorder.records > 0) {
+        handle->mux.on_transport_failure = sr_on_transport_failure;
+        handle->mux.transport_failure_context = handle;
+    }
 
     // setup MD4
     /*setMD4checksum(handle->config.values.sending.md4_type,
@@ -1871,142 +3349,1789 @@ void sr_init_handle(struct rasta_handle* handle, const char* config_file_path) {
                    handle->config.values.sending.md4_c,
                    handle->config.values.sending.md4_d);*/
 
-    handle->hashing_context.algorithm = RASTA_ALGO_MD4;
-    handle->hashing_context.hash_length = handle->config.values.sending.md4_type;
-    rasta_md4_set_key(&handle->hashing_context, handle->config.values.sending.md4_a, handle->config.values.sending.md4_b,
-                      handle->config.values.sending.md4_c, handle->config.values.sending.md4_d);
+    handle->hashing_context.algorithm = RASTA_ALGO_MD4;
+    handle->hashing_context.hash_length = handle->config.values.sending.md4_type;
+    rasta_md4_set_key(&handle->hashing_context, handle->config.values.sending.md4_a, handle->config.values.sending.md4_b,
+                      handle->config.values.sending.md4_c, handle->config.values.sending.md4_d);
+
+    handle->rekeying_seed = long_random();
+    handle->reconnect_seed = long_random();
+
+#ifdef ENABLE_OPAQUE
+    // the key exchanges are computed beside the event loop
+    if (handle->config.values.kex.mode != KEY_EXCHANGE_MODE_NONE) {
+        worker_pool_init(&handle->kex_pool, handle->config.values.kex.worker_count,
+                         handle->config.values.kex.max_pending);
+        key_exchange_secrets_init(&handle->kex_secrets, &handle->logger);
+    }
+#endif
+
+    // the port of the metrics endpoint is bound by the owner of the sockets
+    if (handle->config.values.metrics.port != 0 && socket_owner == NULL) {
+        sr_metrics_open_endpoint(handle, handle->config.values.metrics.port);
+    }
+    if (handle->config.values.metrics.stat_page[0] != '\0' && socket_owner == NULL) {
+        unsigned int capacity = handle->config.values.sending.max_connections;
+        handle->stat_page = rasta_stat_page_create(handle->config.values.metrics.stat_page,
+                                                   handle->config.values.general.rasta_id,
+                                                   capacity != 0 ? capacity : RASTA_STAT_PAGE_DEFAULT_CONNECTIONS,
+                                                   handle->mux.port_count,
+                                                   handle->config.values.metrics.stat_interval_ms);
+    }
+
+    // so is the stream to the standby, the sub handles are not replicated
+    if (handle->config.values.replication.role != RASTA_REPLICATION_NONE && socket_owner == NULL) {
+        sr_replication_open(handle, handle->config.values.replication);
+    }
+
+    rmemory_set_thread_placement(previous_placement);
+}
+
+void sr_init_handle(struct rasta_handle* handle, const char* config_file_path) {
+
+    rasta_handle_init(handle, config_file_path);
+
+    sr_init_layers(handle, NULL);
+}
+
+/**
+ * moves the RaSTA ID and the local ports of a handle whose config file has been loaded, before its layers are set up
+ */
+static void apply_offsets(struct rasta_handle* handle, unsigned long id_offset, unsigned int port_offset) {
+    // the sub handles keep a copy of the general configuration
+    handle->config.values.general.rasta_id += id_offset;
+    handle->receive_handle->info = handle->config.values.general;
+    handle->send_handle->info = handle->config.values.general;
+    handle->heartbeat_handle->info = handle->config.values.general;
+
+    for (unsigned int i = 0; i < handle->config.values.redundancy.connections.count; i++) {
+        handle->config.values.redundancy.connections.data[i].port += port_offset;
+    }
+}
+
+void sr_init_handle_with_offsets(struct rasta_handle* handle, const char* config_file_path, unsigned long id_offset,
+                                 unsigned int port_offset) {
+    rasta_handle_init(handle, config_file_path);
+    apply_offsets(handle, id_offset, port_offset);
+    sr_init_layers(handle, NULL);
+}
+
+void sr_init_shard_handle(struct rasta_handle* handle, const char* config_file_path, unsigned int shard_index,
+                          unsigned int shard_count) {
+    rasta_handle_init(handle, config_file_path);
+
+    const struct RastaConfigPlacement * placement = &handle->config.values.placement;
+    if (placement->cpu_count > 0) {
+        rasta_handle_set_cpu(handle, placement->cpus[shard_index % placement->cpu_count]);
+    }
+
+    // the steering program reads the sender id, which is encrypted with DTLS
+    struct RastaConfigInfoRedundancy * redundancy = &handle->config.values.redundancy;
+    if (redundancy->reuseport && shard_count > 1 && handle->config.values.tls.mode == TLS_MODE_DISABLED) {
+        redundancy->reuseport_group = shard_count;
+        apply_offsets(handle, 0, 0);
+    } else {
+        apply_offsets(handle, 0, shard_index * redundancy->connections.count);
+    }
+    sr_init_layers(handle, NULL);
+}
+
+void sr_init_member_handle(struct rasta_handle* handle, const char* config_file_path, unsigned long rasta_id,
+                           struct rasta_handle* socket_owner) {
+    rasta_handle_init(handle, config_file_path);
+    apply_offsets(handle, rasta_id - handle->config.values.general.rasta_id, 0);
+    sr_init_layers(handle, socket_owner);
+}
+
+/**
+ * starts the handshake of a client with a new initial sequence number and sends the ConReq
+ * @param h the RaSTA handle
+ * @param con the connection, initialized by sr_init_connection()
+ */
+static void sr_send_connection_request(struct rasta_handle *h, struct rasta_connection *con) {
+    // initialize seq nums and timestamps
+    con->sn_t = get_initial_seq_num(&h->config);
+    //con->sn_t = 66;
+    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "Using %lu as initial sequence number",
+        (long unsigned int) con->sn_t);
+
+    con->cs_t = 0;
+    con->cts_r = cur_timestamp();
+    con->t_i = h->config.values.sending.t_max;
+
+    unsigned char * version = (unsigned char*)RASTA_VERSION;
+
+    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "Local version is %s", version);
+
+
+    // send ConReq
+    struct RastaPacket conreq = createConnectionRequest(con->remote_id, con->my_id,
+                                                        con->sn_t, cur_timestamp(),
+                                                        h->config.values.sending.send_max,
+                                                        version, &h->hashing_context);
+    con->sn_i = con->sn_t;
+
+    redundancy_mux_send(&h->mux,conreq);
+    freeRastaByteArray(&conreq.data);
+
+    // increase sequence number
+    con->sn_t++;
+
+    // update tls_state
+    con->current_state = RASTA_CONNECTION_START;
+}
+
+/**
+ * sends the connection request of a client again, the connection starts over like after sr_connect()
+ * @param carry_data the timed_event_data of the reconnect event
+ * @return always 0
+ */
+int reconnect_event(void* carry_data) {
+    struct timed_event_data* data = carry_data;
+    struct rasta_handle* h = data->handle;
+    struct rasta_connection* con = data->connection;
+
+    disable_timed_event(&con->reconnect_event);
+    if (con->current_state != RASTA_CONNECTION_START && con->current_state != RASTA_CONNECTION_CLOSED) {
+        return 0;
+    }
+    con->reconnect_attempts++;
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA RECONNECT", "attempt %u to connect to %X", con->reconnect_attempts,
+               con->remote_id);
+
+    // the server does not know the redundancy channel anymore, it only accepts a new one that starts at sequence
+    // number 0
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&h->mux, con->remote_id);
+    if (channel != NULL && channel->connected_channel_count == h->mux.port_count) {
+        struct RastaIPData channels[h->mux.port_count > 0 ? h->mux.port_count : 1];
+        // redundancy_mux_add_channel() expects the transport channels in the order of the sockets
+        for (unsigned int i = 0; i < h->mux.port_count; i++) {
+            const rasta_transport_channel* transport = &channel->connected_channels[rasta_red_path_channel(channel, i)];
+            strncpy(channels[i].ip, transport->ip_address, sizeof(channels[i].ip) - 1);
+            channels[i].ip[sizeof(channels[i].ip) - 1] = '\0';
+            channels[i].port = transport->port;
+        }
+        redundancy_mux_remove_channel(&h->mux, con->remote_id);
+        redundancy_mux_add_channel(&h->mux, con->remote_id, channels);
+        redundancy_mux_set_config_id(&h->mux, con->remote_id);
+    }
+
+    // the connection keeps its slot, its place in the list and the reconnect event that is firing
+    struct rasta_connection new_con;
+    memset(&new_con, 0, sizeof(struct rasta_connection));
+    sr_init_connection(&new_con, &h->connection_pool, con->state, con->remote_id, h->config.values.general,
+                       h->config.values.sending, &h->logger, RASTA_ROLE_CLIENT);
+    new_con.linkedlist_next = con->linkedlist_next;
+    new_con.linkedlist_prev = con->linkedlist_prev;
+    new_con.reconnect_event = con->reconnect_event;
+    new_con.reconnect_carry_data = con->reconnect_carry_data;
+    new_con.reconnect_attempts = con->reconnect_attempts;
+    new_con.bulk_index = con->bulk_index;
+    new_con.replicated = con->replicated;
+    sr_send_connection_request(h, &new_con);
+
+    remove_connection_events(h, con);
+    *con = new_con;
+
+    fire_on_connection_state_change(sr_create_notification_result(h,con));
+
+    init_connection_events(h, con);
+    return 0;
+}
+
+/**
+ * sets up the event that lets a client send its connection request again, if reconnecting is enabled
+ * @param h the handle
+ * @param con the connection
+ */
+static void sr_init_reconnect_event(struct rasta_handle* h, struct rasta_connection* con) {
+    if (h->config.values.sending.reconnect_min_ms > 0) {
+        memset(&con->reconnect_event, 0, sizeof(timed_event));
+        con->reconnect_event.callback = reconnect_event;
+        con->reconnect_event.carry_data = &con->reconnect_carry_data;
+        con->reconnect_carry_data.handle = h;
+        con->reconnect_carry_data.connection = con;
+        add_timed_event(h->ev_sys, &con->reconnect_event);
+    }
+}
+
+/**
+ * opens the connection of a client to a remote entity that has no connection and sends its connection request
+ * @param h the RaSTA handle
+ * @param id the RaSTA ID of the remote entity
+ * @param channels its transport channels
+ * @return the connection, NULL if all connections are in use or the user refused it
+ */
+static struct rasta_connection * sr_open_connection(struct rasta_handle *h, unsigned long id,
+                                                    struct RastaIPData *channels) {
+    //TODO: const ports in redundancy? (why no dynamic port length)
+    struct rasta_connection new_con;
+    memset(&new_con, 0, sizeof(struct rasta_connection));
+    if (!sr_init_connection(&new_con, &h->connection_pool, NULL, id, h->config.values.general,
+                            h->config.values.sending, &h->logger, RASTA_ROLE_CLIENT)) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA CONNECT", "can not connect to %lu, all %u connections are in use",
+                   id, h->connection_pool.capacity);
+        return NULL;
+    }
+
+    redundancy_mux_add_channel(&h->mux,id,channels);
+    redundancy_mux_set_config_id(&h->mux, id);
+
+    sr_send_connection_request(h, &new_con);
+
+    void* memory = h->user_handles->on_connection_start(&new_con);
+    if (memory == NULL) {
+        logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "connection refused by user to %d", new_con.remote_id);
+        rasta_connection_pool_release(&h->connection_pool, new_con.state);
+        return NULL;
+    }
+
+    struct rasta_connection *con = memory;
+    *con = new_con;
+    add_connection_to_list(h, con);
+
+    // fire connection tls_state changed event
+    fire_on_connection_state_change(sr_create_notification_result(h,con));
+
+    init_connection_events(h, con);
+    sr_init_reconnect_event(h, con);
+    return con;
+}
+
+void sr_connect(struct rasta_handle *h, unsigned long id, struct RastaIPData *channels) {
+    //TODO: Error handling
+    if (rasta_id_index_get(&h->connection_index, id) != NULL) return;
+    sr_open_connection(h, id, channels);
+}
+
+unsigned int sr_connect_wave_size(struct RastaConfigInfoSending cfg, unsigned int waiting, unsigned int in_flight) {
+    unsigned int size = waiting;
+    if (cfg.connect_wave_size > 0 && size > cfg.connect_wave_size) {
+        size = cfg.connect_wave_size;
+    }
+    if (cfg.connect_max_in_flight > 0) {
+        unsigned int room = in_flight < cfg.connect_max_in_flight ? cfg.connect_max_in_flight - in_flight : 0;
+        if (size > room) {
+            size = room;
+        }
+    }
+    return size;
+}
+
+/**
+ * counts a peer of the bulk connect as connected or failed, the last one completes the bulk connect
+ * @param h the RaSTA handle
+ * @param index the position of the peer
+ * @param state RASTA_BULK_PEER_CONNECTED or RASTA_BULK_PEER_FAILED
+ */
+static void sr_bulk_connect_settle(struct rasta_handle *h, unsigned int index, rasta_bulk_peer_state state) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    if (bulk->states[index] == RASTA_BULK_PEER_ISSUED) {
+        bulk->status.in_flight--;
+    }
+    bulk->states[index] = state;
+    if (state == RASTA_BULK_PEER_CONNECTED) {
+        bulk->status.connected++;
+    } else {
+        bulk->status.failed++;
+    }
+
+    uint64_t elapsed = event_system_now() - bulk->started;
+    if (bulk->status.connected == bulk->status.total) {
+        bulk->status.all_connected_ns = elapsed;
+    }
+    if (bulk->status.connected + bulk->status.failed < bulk->status.total) {
+        return;
+    }
+
+    bulk->status.complete = 1;
+    bulk->status.complete_ns = elapsed;
+    disable_timed_event(&bulk->wave_event);
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA BULK CONNECT", "%u of %u peers connected in %u waves after %lu ms",
+               bulk->status.connected, bulk->status.total, bulk->status.waves,
+               (unsigned long) (elapsed / NS_PER_MS));
+    fire_on_bulk_connect_complete(h, bulk->status);
+}
+
+static void sr_bulk_connect_handshake_complete(struct rasta_handle *h, struct rasta_connection *con) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    if (con->bulk_index == 0 || bulk == NULL) {
+        return;
+    }
+    unsigned int index = con->bulk_index - 1;
+    con->bulk_index = 0;
+
+    // the connection may still carry the position of an earlier bulk connect
+    if (index < bulk->status.total && bulk->ids[index] == con->remote_id &&
+        bulk->states[index] == RASTA_BULK_PEER_ISSUED) {
+        sr_bulk_connect_settle(h, index, RASTA_BULK_PEER_CONNECTED);
+    }
+}
+
+/**
+ * sends the connection request to a peer of the bulk connect
+ * @param h the RaSTA handle
+ * @param index the position of the peer
+ */
+static void sr_bulk_connect_issue(struct rasta_handle *h, unsigned int index) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    bulk->states[index] = RASTA_BULK_PEER_ISSUED;
+    bulk->status.issued++;
+    bulk->status.in_flight++;
+
+    struct rasta_connection *con = rasta_id_index_get(&h->connection_index, bulk->ids[index]);
+    if (con == NULL) {
+        con = sr_open_connection(h, bulk->ids[index], &bulk->channels[index * bulk->port_count]);
+        if (con == NULL) {
+            sr_bulk_connect_settle(h, index, RASTA_BULK_PEER_FAILED);
+            return;
+        }
+    } else if (con->current_state == RASTA_CONNECTION_UP) {
+        sr_bulk_connect_settle(h, index, RASTA_BULK_PEER_CONNECTED);
+        return;
+    }
+    // an existing connection whose handshake is running is waited for like a new one
+    con->bulk_index = index + 1;
+}
+
+/**
+ * sends the connection requests of the next wave, as many as sr_connect_wave_size() allows
+ * @param h the RaSTA handle
+ */
+static void sr_bulk_connect_send_wave(struct rasta_handle *h) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    unsigned int size = sr_connect_wave_size(h->config.values.sending, bulk->status.total - bulk->next,
+                                             bulk->status.in_flight);
+    if (size == 0) {
+        return;
+    }
+    bulk->status.waves++;
+    for (unsigned int i = 0; i < size; i++) {
+        sr_bulk_connect_issue(h, bulk->next++);
+    }
+}
+
+/**
+ * counts the peers whose connection is gone or closed without a pending reconnect as failed
+ * @param h the RaSTA handle
+ */
+static void sr_bulk_connect_find_failed(struct rasta_handle *h) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    for (unsigned int i = 0; i < bulk->next && !bulk->status.complete; i++) {
+        if (bulk->states[i] != RASTA_BULK_PEER_ISSUED) {
+            continue;
+        }
+        struct rasta_connection *con = rasta_id_index_get(&h->connection_index, bulk->ids[i]);
+        if (con != NULL && ((con->current_state != RASTA_CONNECTION_CLOSED &&
+                             con->current_state != RASTA_CONNECTION_DOWN) || con->reconnect_event.enabled)) {
+            continue;
+        }
+        if (con != NULL) {
+            con->bulk_index = 0;
+        }
+        sr_bulk_connect_settle(h, i, RASTA_BULK_PEER_FAILED);
+    }
+}
+
+/**
+ * the wave event of a bulk connect
+ * @param carry_data the timed_event_data of the bulk connect
+ * @return always 0
+ */
+static int sr_bulk_connect_wave_event(void *carry_data) {
+    struct timed_event_data *data = carry_data;
+    struct rasta_handle *h = data->handle;
+
+    sr_bulk_connect_find_failed(h);
+    if (!h->bulk_connect->status.complete) {
+        sr_bulk_connect_send_wave(h);
+    }
+    return 0;
+}
+
+/**
+ * frees the latest bulk connect of a handle
+ * @param h the RaSTA handle
+ */
+static void sr_bulk_connect_free(struct rasta_handle *h) {
+    struct rasta_bulk_connect *bulk = h->bulk_connect;
+    if (bulk == NULL) {
+        return;
+    }
+    if (bulk->wave_event.ev_sys != NULL) {
+        remove_timed_event(bulk->wave_event.ev_sys, &bulk->wave_event);
+    }
+    rfree(bulk->ids);
+    rfree(bulk->channels);
+    rfree(bulk->states);
+    rfree(bulk);
+    h->bulk_connect = NULL;
+}
+
+int sr_connect_bulk(struct rasta_handle *h, const struct rasta_bulk_peer *peers, unsigned int count) {
+    if (count == 0 || (h->bulk_connect != NULL && !h->bulk_connect->status.complete)) {
+        return 0;
+    }
+    sr_bulk_connect_free(h);
+
+    struct rasta_bulk_connect *bulk = rmalloc(sizeof(struct rasta_bulk_connect));
+    rmemset(bulk, 0, sizeof(struct rasta_bulk_connect));
+    bulk->port_count = h->mux.port_count > 0 ? h->mux.port_count : 1;
+    bulk->ids = rmalloc(count * sizeof(unsigned long));
+    bulk->channels = rmalloc(count * bulk->port_count * sizeof(struct RastaIPData));
+    bulk->states = rmalloc(count * sizeof(rasta_bulk_peer_state));
+    for (unsigned int i = 0; i < count; i++) {
+        bulk->ids[i] = peers[i].id;
+        rmemcpy(&bulk->channels[i * bulk->port_count], peers[i].channels,
+                bulk->port_count * sizeof(struct RastaIPData));
+        bulk->states[i] = RASTA_BULK_PEER_WAITING;
+    }
+    bulk->status.total = count;
+    bulk->started = event_system_now();
+    h->bulk_connect = bulk;
+
+    unsigned int interval_ms = h->config.values.sending.connect_wave_interval_ms;
+    bulk->wave_event.callback = sr_bulk_connect_wave_event;
+    bulk->wave_event.carry_data = &bulk->wave_carry_data;
+    bulk->wave_event.interval = (uint64_t) (interval_ms > 0 ? interval_ms : 1) * NS_PER_MS;
+    bulk->wave_carry_data.handle = h;
+    add_timed_event(h->ev_sys, &bulk->wave_event);
+    enable_timed_event(&bulk->wave_event);
+
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA BULK CONNECT", "connecting to %u peers", count);
+    sr_bulk_connect_send_wave(h);
+    return 1;
+}
+
+int sr_get_bulk_connect_status(struct rasta_handle *h, struct rasta_bulk_connect_status *out) {
+    if (h->bulk_connect == NULL) {
+        return 0;
+    }
+    *out = h->bulk_connect->status;
+    return 1;
+}
+
+int sr_send(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages){
+    return sr_send_priority(h, remote_id, app_messages, RASTA_SEND_BULK);
+}
+
+int sr_send_priority(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages,
+                     rasta_send_priority priority){
+
+    struct rasta_connection *con = rasta_id_index_get(&h->connection_index, remote_id);
+
+    if (con == 0) return 0;
+
+    return sr_send_connection_priority(h, con, app_messages, priority);
+}
+
+/**
+ * puts application messages into the send queue of a connection that is up, without waking up the send handler
+ * @param h the RaSTA handle
+ * @param con the connection
+ * @param app_messages the messages
+ * @param owned 1 if the bytes of the messages are handed to the send queue, 0 if they are copied
+ * @param priority the lane of the send queue
+ * @return 1 if the messages were queued, 0 if there are too many messages for one data packet or the lane is full, no
+ *         message is queued then
+ */
+static int sr_queue_messages(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages,
+                             int owned, rasta_send_priority priority){
+    if (app_messages.count > h->config.values.sending.max_packet){
+        // to many application messages
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA send", "too many application messages to send in one packet. Maximum is %d",
+                   h->config.values.sending.max_packet);
+        return 0;
+    }
+
+    fifo_t * lane = priority == RASTA_SEND_URGENT ? con->fifo_send_urgent : con->fifo_send;
+    if (fifo_get_capacity(lane) - fifo_get_size(lane) < app_messages.count){
+        // the producer is faster than the send window, it is told with on_writable when it can continue
+        logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA send", "%s lane of the send queue of connection to 0x%lX is full",
+                   priority == RASTA_SEND_URGENT ? "urgent" : "bulk", (unsigned long) con->remote_id);
+        con->send_blocked = 1;
+        return 0;
+    }
+
+    // the time of the event loop is enough for the queue times of the priority classes, not for the residency
+    uint64_t queued_ns = con->residency != NULL ? get_nanotime() : event_system_now();
+    for (unsigned int i = 0; i < app_messages.count; ++i) {
+        struct RastaByteArray msg;
+        msg = app_messages.data_array[i];
+
+        // push into queue
+        struct rasta_queued_message * to_fifo = rmalloc(sizeof(struct rasta_queued_message));
+        if (owned) {
+            to_fifo->message = msg;
+        } else {
+            allocateRastaByteArray(&to_fifo->message, msg.length);
+            rmemcpy(to_fifo->message.bytes, msg.bytes, msg.length);
+        }
+        to_fifo->queued_ns = queued_ns;
+        if (sr_rasta_send_data_available(&h->logger, con) == 0) {
+            con->send_queued_since_ns = event_system_now();
+        }
+        fifo_push(lane, to_fifo);
+        con->send_queued_bytes += msg.length + RASTA_MESSAGE_LENGTH_PREFIX;
+    }
+
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA send", "data in send queue");
+    return 1;
+}
+
+/**
+ * sends data on a connection
+ * @param h the RaSTA handle
+ * @param con the connection
+ * @param app_messages the messages
+ * @param owned 1 if the bytes of the messages are handed to the send queue, 0 if they are copied
+ * @param priority the lane of the send queue
+ * @return the same as sr_send()
+ */
+static int sr_send_messages(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages,
+                            int owned, rasta_send_priority priority){
+    if(con->current_state == RASTA_CONNECTION_UP){
+        if (!sr_queue_messages(h, con, app_messages, owned, priority)){
+            return 0;
+        }
+
+        rasta_handle_notify(h->send_notify_fd);
+        return 1;
+
+    } else if (con->current_state == RASTA_CONNECTION_CLOSED || con->current_state == RASTA_CONNECTION_DOWN){
+        // nothing to do besides changing tls_state to closed
+        sr_set_state(con, RASTA_CONNECTION_CLOSED);
+
+        // fire connection tls_state changed event
+        fire_on_connection_state_change(sr_create_notification_result(h,con));
+    } else {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA send", "service not allowed");
+
+        // disconnect and close
+        send_DisconnectionRequest(&h->mux,con, RASTA_DISC_REASON_SERVICENOTALLOWED, 0);
+        sr_set_state(con, RASTA_CONNECTION_CLOSED);
+
+        // fire connection tls_state changed event
+        fire_on_connection_state_change(sr_create_notification_result(h,con));
+    }
+    return 0;
+}
+
+int sr_send_connection(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages){
+    return sr_send_messages(h, con, app_messages, 0, RASTA_SEND_BULK);
+}
+
+int sr_send_connection_priority(struct rasta_handle *h, struct rasta_connection *con,
+                                struct RastaMessageData app_messages, rasta_send_priority priority){
+    return sr_send_messages(h, con, app_messages, 0, priority);
+}
+
+unsigned int sr_send_batch(struct rasta_handle *h, const unsigned long *remote_ids,
+                           const struct RastaMessageData *app_messages, unsigned int count){
+    unsigned int queued = 0;
+    for (unsigned int i = 0; i < count; i++){
+        struct rasta_connection *con = rasta_id_index_get(&h->connection_index, remote_ids[i]);
+        if (con == 0) continue;
+
+        if (con->current_state == RASTA_CONNECTION_UP){
+            queued += (unsigned int) sr_queue_messages(h, con, app_messages[i], 0, RASTA_SEND_BULK);
+        } else {
+            // a connection that is not up is handled like by sr_send(), it does not wake up the send handler
+            sr_send_messages(h, con, app_messages[i], 0, RASTA_SEND_BULK);
+        }
+    }
+
+    if (queued > 0){
+        rasta_handle_notify(h->send_notify_fd);
+    }
+    return queued;
+}
+
+struct RastaByteArray sr_alloc_message(unsigned int length){
+    struct RastaByteArray message;
+    allocateRastaByteArray(&message, length);
+    return message;
+}
+
+int sr_send_owned(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages){
+    struct rasta_connection *con = rasta_id_index_get(&h->connection_index, remote_id);
+
+    if (con == 0) return 0;
+
+    return sr_send_connection_owned(h, con, app_messages);
+}
+
+int sr_send_connection_owned(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages){
+    return sr_send_messages(h, con, app_messages, 1, RASTA_SEND_BULK);
+}
+
+int sr_submit(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages){
+    // runs on other threads, so only the configuration of the handle is read
+    if (app_messages.count > h->config.values.sending.max_packet){
+        return 0;
+    }
+
+    unsigned int length = 0;
+    for (unsigned int i = 0; i < app_messages.count; ++i) {
+        length += RASTA_MESSAGE_LENGTH_PREFIX + app_messages.data_array[i].length;
+    }
+    if (length > sizeof(((struct rasta_submission *) NULL)->data)){
+        return 0;
+    }
+
+    struct rasta_submission * submission = mpsc_queue_reserve(h->submit_queue);
+    if (submission == NULL){
+        return 0;
+    }
+
+    submission->remote_id = remote_id;
+    submission->count = app_messages.count;
+    submission->length = length;
+
+    // the same layout as the data of a data PDU, so the event loop reads it with a RastaMessageIterator
+    unsigned int offset = 0;
+    for (unsigned int i = 0; i < app_messages.count; ++i) {
+        rasta_wire_put_u16(&submission->data[offset], (uint16_t) app_messages.data_array[i].length);
+        rmemcpy(&submission->data[offset + RASTA_MESSAGE_LENGTH_PREFIX], app_messages.data_array[i].bytes,
+                app_messages.data_array[i].length);
+        offset += RASTA_MESSAGE_LENGTH_PREFIX + app_messages.data_array[i].length;
+    }
+
+    mpsc_queue_commit(h->submit_queue, submission);
+    rasta_handle_notify(h->submit_notify_fd);
+
+    return 1;
+}
+
+/**
+ * passes the submissions of sr_submit() to their connections. The send handler is woken up once for all of them
+ * @param carry_data the RaSTA handle
+ * @return 0
+ */
+static int submit_notification_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    struct rasta_submission* submission;
+    int queued = 0;
+
+    // cleared first, so a submission that is added while draining wakes up the event loop again
+    sr_clear_notification(h->submit_notify_fd);
+
+    while ((submission = mpsc_queue_front(h->submit_queue)) != NULL) {
+        struct rasta_connection* con = rasta_id_index_get(&h->connection_index, submission->remote_id);
+
+        if (con != NULL) {
+            // the messages are copied into the send queue right from the slot
+            struct RastaByteArray messages[submission->count > 0 ? submission->count : 1];
+            struct RastaMessageData app_messages;
+            struct RastaMessageIterator iterator;
+            const unsigned char* message;
+
+            app_messages.count = 0;
+            app_messages.data_array = messages;
+            rastaMessageIteratorInit(&iterator, submission->data, submission->length);
+            while (app_messages.count < submission->count &&
+                   rastaMessageIteratorNext(&iterator, &message, &messages[app_messages.count].length)) {
+                messages[app_messages.count].bytes = (unsigned char*) message;
+                app_messages.count++;
+            }
+
+            if (con->current_state == RASTA_CONNECTION_UP) {
+                if (!sr_queue_messages(h, con, app_messages, 0, RASTA_SEND_BULK)) {
+                    // the send queue is full, the submission stays in the queue until the connection is writable
+                    break;
+                }
+                queued = 1;
+            } else {
+                sr_send_connection(h, con, app_messages);
+            }
+        }
+
+        mpsc_queue_release(h->submit_queue);
+    }
+
+    if (queued) {
+        rasta_handle_notify(h->send_notify_fd);
+    }
+    return 0;
+}
+
+int sr_callback_fd(struct rasta_handle *h){
+    return h->callback_executor != NULL ? h->callback_executor->notify_fd : -1;
+}
+
+unsigned int sr_run_callbacks(struct rasta_handle *h, unsigned int max){
+    if (h->callback_executor == NULL) {
+        return 0;
+    }
+    return rasta_callback_executor_run(h->callback_executor, max);
+}
+
+rastaApplicationMessage sr_get_received_data(struct rasta_handle *h, struct rasta_connection * connection){
+    rastaApplicationMessage message;
+    struct rasta_received_message * element;
+
+    element = fifo_pop(connection->fifo_app_msg);
+
+    message = element->message;
+    if (element->queued_ns != 0) {
+        rasta_residency_record(connection->residency, RASTA_RESIDENCY_APPLICATION, element->queued_ns, get_nanotime());
+    }
+
+    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA retrieve", "application message with l %d", message.appMessage.length);
+    //logger_log(&h->logger, LOG_LEVEL_DEBUG, "RETRIEVE DATA", "Convert bytes to packet");
+
+    rfree(element);
+
+    // the receive handler confirms the PDUs that were held back once there is room
+    if (connection->receive_held) {
+        rasta_handle_notify(h->receive_notify_fd);
+    }
+
+    //struct RastaPacket packet = bytesToRastaPacket(msg);
+    //return packet;
+    return message;
+}
+
+unsigned int sr_get_received_data_bulk(struct rasta_handle *h, struct rasta_connection * connection,
+                                       rastaApplicationMessage * messages, unsigned int max){
+    unsigned int count = 0;
+    struct rasta_received_message * element;
+    uint64_t now_ns = connection->residency != NULL ? get_nanotime() : 0;
+
+    while (count < max && (element = fifo_pop(connection->fifo_app_msg)) != NULL) {
+        messages[count++] = element->message;
+        rasta_residency_record(connection->residency, RASTA_RESIDENCY_APPLICATION, element->queued_ns, now_ns);
+        rfree(element);
+    }
+
+    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA retrieve", "%u application messages", count);
+    if (count > 0 && connection->receive_held) {
+        rasta_handle_notify(h->receive_notify_fd);
+    }
+    return count;
+}
+
+void sr_free_received_data_bulk(rastaApplicationMessage * messages, unsigned int count){
+    for (unsigned int i = 0; i < count; ++i) {
+        freeRastaByteArray(&messages[i].appMessage);
+    }
+}
+
+/**
+ * copies the counters of a redundancy or transport channel
+ * @param metrics the counters
+ * @param out the copy is written in here
+ */
+static void snapshot_transport_metrics(const struct rasta_transport_metrics* metrics, struct rasta_transport_metrics* out) {
+    out->pdus_in = rasta_metrics_read(&metrics->pdus_in);
+    out->bytes_in = rasta_metrics_read(&metrics->bytes_in);
+    out->pdus_out = rasta_metrics_read(&metrics->pdus_out);
+    out->bytes_out = rasta_metrics_read(&metrics->bytes_out);
+    out->checksum_errors = rasta_metrics_read(&metrics->checksum_errors);
+}
+
+int sr_get_connection_metrics(struct rasta_handle* h, unsigned long remote_id,
+                              struct rasta_connection_metrics_snapshot* out) {
+    struct rasta_connection* con = rasta_id_index_get(&h->connection_index, remote_id);
+    if (con == NULL) {
+        return 0;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->remote_id = remote_id;
+    out->metrics.retransmitted_pdus = rasta_metrics_read(&con->metrics.retransmitted_pdus);
+    out->metrics.retransmission_requests = rasta_metrics_read(&con->metrics.retransmission_requests);
+    out->metrics.receive_overflows = rasta_metrics_read(&con->metrics.receive_overflows);
+    out->metrics.receive_holds = rasta_metrics_read(&con->metrics.receive_holds);
+    out->metrics.receive_ns = rasta_metrics_read(&con->metrics.receive_ns);
+    out->metrics.send_ns = rasta_metrics_read(&con->metrics.send_ns);
+    rasta_histogram_snapshot(&con->metrics.round_trip_delay, &out->metrics.round_trip_delay);
+    for (unsigned int i = 0; i < RASTA_SEND_PRIORITIES; i++) {
+        rasta_histogram_snapshot(&con->metrics.send_queue_us[i], &out->metrics.send_queue_us[i]);
+    }
+    rasta_histogram_snapshot(&con->metrics.send_schedule_us, &out->metrics.send_schedule_us);
+    out->errors = con->errors;
+    out->send_queue_size = fifo_get_size(con->fifo_send);
+    out->urgent_queue_size = fifo_get_size(con->fifo_send_urgent);
+    out->receive_queue_size = fifo_get_size(con->fifo_app_msg);
+    out->retransmission_queue_size = con->retr_buffer.count;
+    out->send_window = sr_send_window(con);
+
+    rasta_redundancy_channel* channel = redundancy_mux_get_channel(&h->mux, remote_id);
+    if (channel != NULL) {
+        out->defer_queue_size = channel->defer_q.count;
+        out->defer_timeout_ms = channel->defer_timeout;
+        out->defer_timeouts = rasta_metrics_read(&channel->defer_timeouts);
+        out->safety_code_ns = rasta_metrics_read(&channel->safety_code_ns);
+        snapshot_transport_metrics(&channel->metrics, &out->channel);
+
+        out->transport_channel_count = channel->transport_channel_count;
+        if (out->transport_channel_count > RASTA_METRICS_MAX_TRANSPORT_CHANNELS) {
+            out->transport_channel_count = RASTA_METRICS_MAX_TRANSPORT_CHANNELS;
+        }
+        // in the order of the sockets, a transport channel that was not discovered yet has no traffic
+        for (unsigned int i = 0; i < out->transport_channel_count; i++) {
+            int transport = rasta_red_path_channel(channel, i);
+            if (transport >= 0) {
+                snapshot_transport_metrics(&channel->connected_channels[transport].metrics, &out->transport_channels[i]);
+            } else {
+                memset(&out->transport_channels[i], 0, sizeof(out->transport_channels[i]));
+            }
+        }
+    }
+    return 1;
+}
+
+int sr_get_connection_residency(struct rasta_handle* h, unsigned long remote_id, struct rasta_residency_metrics* out) {
+    struct rasta_connection* con = rasta_id_index_get(&h->connection_index, remote_id);
+    if (con == NULL || con->residency == NULL) {
+        return 0;
+    }
+
+    memset(out, 0, sizeof(*out));
+    rasta_residency_snapshot(con->residency, RASTA_RESIDENCY_SEND_QUEUE, RASTA_RESIDENCY_TRANSMIT, out);
+    rasta_residency_snapshot(con->residency, RASTA_RESIDENCY_APPLICATION, RASTA_RESIDENCY_APPLICATION, out);
+    // the defer queue and the receive queue belong to the redundancy channel
+    rasta_redundancy_channel* channel = redundancy_mux_get_channel(&h->mux, remote_id);
+    if (channel != NULL) {
+        rasta_residency_snapshot(channel->residency, RASTA_RESIDENCY_DEFER, RASTA_RESIDENCY_RECEIVE_QUEUE, out);
+    }
+    return 1;
+}
+
+unsigned int sr_get_top_peers(struct rasta_handle* h, struct rasta_peer_usage* out, unsigned int max) {
+    struct rasta_connection_metrics_snapshot snapshot;
+    unsigned int count = 0;
+    for (struct rasta_connection* con = h->first_con; con != NULL; con = con->linkedlist_next) {
+        if (!sr_get_connection_metrics(h, con->remote_id, &snapshot)) {
+            continue;
+        }
+        struct rasta_peer_usage usage;
+        usage.remote_id = snapshot.remote_id;
+        usage.receive_ns = snapshot.metrics.receive_ns;
+        usage.send_ns = snapshot.metrics.send_ns;
+        usage.safety_code_ns = snapshot.safety_code_ns;
+        usage.pdus_in = snapshot.channel.pdus_in;
+        usage.bytes_in = snapshot.channel.bytes_in;
+        usage.pdus_out = snapshot.channel.pdus_out;
+        usage.bytes_out = snapshot.channel.bytes_out;
+        usage.retransmitted_pdus = snapshot.metrics.retransmitted_pdus;
+        count = rasta_peer_ranking_insert(out, count, max, &usage);
+    }
+    return count;
+}
+
+int sr_get_transmit_stats(struct rasta_handle* h, unsigned int channel, struct RastaUDPTransmitStats* out) {
+    if (channel >= h->mux.port_count) {
+        return 0;
+    }
+    udp_transmit_stats(&h->mux.udp_socket_states[channel], out);
+    return 1;
+}
+
+int sr_get_socket_stats(struct rasta_handle* h, unsigned int channel, struct RastaUDPBufferStats* out) {
+    if (channel >= h->mux.port_count) {
+        return 0;
+    }
+    udp_buffer_stats(&h->mux.udp_socket_states[channel], out);
+    return 1;
+}
+
+int sr_get_path_metrics(struct rasta_handle* h, unsigned int path, struct rasta_transport_metrics* out) {
+    if (path >= h->mux.port_count) {
+        return 0;
+    }
+    snapshot_transport_metrics(&h->mux.path_metrics[path], out);
+    return 1;
+}
+
+void sr_get_pending_channel_stats(struct rasta_handle* h, struct RastaPendingChannelStats* out) {
+    out->count = h->mux.pending_count;
+    out->evictions = rasta_metrics_read(&h->mux.pending_evictions);
+    out->drops = rasta_metrics_read(&h->mux.pending_drops);
+}
+
+void sr_get_loop_lag(struct rasta_handle* h, struct rasta_histogram* out) {
+    rasta_histogram_snapshot(&h->loop_lag, out);
+}
+
+void sr_get_receive_stage_metrics(struct rasta_handle* h, struct rasta_receive_stage_metrics* out) {
+    rasta_receive_stage_snapshot(&h->mux.receive_stages, out);
+}
+
+/**
+ * writes a histogram as a Prometheus summary
+ * @param out the stream to write to
+ * @param name the name of the metric
+ * @param labels the labels of the metric without braces, may be empty
+ * @param histogram the histogram
+ */
+static void write_summary(FILE* out, const char* name, const char* labels, const struct rasta_histogram* histogram) {
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        fprintf(out, "%s{%s%squantile=\"%g\"} %lu\n", name, labels, labels[0] ? "," : "", quantiles[i],
+                rasta_histogram_percentile(histogram, quantiles[i] * 100));
+    }
+    fprintf(out, "%s_sum%s%s%s %lu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", histogram->sum);
+    fprintf(out, "%s_count%s%s%s %lu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", histogram->count);
+}
+
+void sr_write_metrics(struct rasta_handle* h, FILE* out) {
+    struct rasta_connection_metrics_snapshot snapshot;
+    struct rasta_residency_metrics residency;
+    char labels[64];
+    char stage_labels[96];
+
+    fprintf(out, "# TYPE rasta_connection_pdus_in_total counter\n"
+                 "# TYPE rasta_connection_bytes_in_total counter\n"
+                 "# TYPE rasta_connection_pdus_out_total counter\n"
+                 "# TYPE rasta_connection_bytes_out_total counter\n"
+                 "# TYPE rasta_connection_retransmitted_pdus_total counter\n"
+                 "# TYPE rasta_connection_retransmission_requests_total counter\n"
+                 "# TYPE rasta_connection_receive_overflows_total counter\n"
+                 "# TYPE rasta_connection_receive_holds_total counter\n"
+                 "# TYPE rasta_connection_errors_total counter\n"
+                 "# TYPE rasta_connection_queue_size gauge\n"
+                 "# TYPE rasta_connection_send_window gauge\n"
+                 "# TYPE rasta_connection_defer_timeout_ms gauge\n"
+                 "# TYPE rasta_connection_defer_timeouts_total counter\n"
+                 "# TYPE rasta_connection_round_trip_delay_ms summary\n"
+                 "# TYPE rasta_connection_send_queue_us summary\n"
+                 "# TYPE rasta_connection_send_schedule_us summary\n"
+                 "# TYPE rasta_connection_time_ns_total counter\n"
+                 "# TYPE rasta_connection_residency_us summary\n"
+                 "# TYPE rasta_transport_pdus_in_total counter\n"
+                 "# TYPE rasta_transport_bytes_in_total counter\n"
+                 "# TYPE rasta_transport_pdus_out_total counter\n"
+                 "# TYPE rasta_transport_bytes_out_total counter\n"
+                 "# TYPE rasta_transport_checksum_errors_total counter\n");
+
+    for (struct rasta_connection* con = h->first_con; con != NULL; con = con->linkedlist_next) {
+        if (!sr_get_connection_metrics(h, con->remote_id, &snapshot)) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "remote_id=\"0x%lX\"", snapshot.remote_id);
+
+        fprintf(out, "rasta_connection_pdus_in_total{%s} %lu\n", labels, snapshot.channel.pdus_in);
+        fprintf(out, "rasta_connection_bytes_in_total{%s} %lu\n", labels, snapshot.channel.bytes_in);
+        fprintf(out, "rasta_connection_pdus_out_total{%s} %lu\n", labels, snapshot.channel.pdus_out);
+        fprintf(out, "rasta_connection_bytes_out_total{%s} %lu\n", labels, snapshot.channel.bytes_out);
+        fprintf(out, "rasta_connection_retransmitted_pdus_total{%s} %lu\n", labels, snapshot.metrics.retransmitted_pdus);
+        fprintf(out, "rasta_connection_retransmission_requests_total{%s} %lu\n", labels,
+                snapshot.metrics.retransmission_requests);
+        fprintf(out, "rasta_connection_receive_overflows_total{%s} %lu\n", labels, snapshot.metrics.receive_overflows);
+        fprintf(out, "rasta_connection_receive_holds_total{%s} %lu\n", labels, snapshot.metrics.receive_holds);
+
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"safety\"} %u\n", labels, snapshot.errors.safety);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"address\"} %u\n", labels, snapshot.errors.address);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"type\"} %u\n", labels, snapshot.errors.type);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"sn\"} %u\n", labels, snapshot.errors.sn);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"cs\"} %u\n", labels, snapshot.errors.cs);
+
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"send\"} %u\n", labels, snapshot.send_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"urgent\"} %u\n", labels, snapshot.urgent_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"receive\"} %u\n", labels, snapshot.receive_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"retransmission\"} %u\n", labels,
+                snapshot.retransmission_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"defer\"} %u\n", labels, snapshot.defer_queue_size);
+        fprintf(out, "rasta_connection_defer_timeout_ms{%s} %u\n", labels, snapshot.defer_timeout_ms);
+        fprintf(out, "rasta_connection_defer_timeouts_total{%s} %lu\n", labels, snapshot.defer_timeouts);
+        fprintf(out, "rasta_connection_send_window{%s} %u\n", labels, snapshot.send_window);
+
+        write_summary(out, "rasta_connection_round_trip_delay_ms", labels, &snapshot.metrics.round_trip_delay);
+        for (unsigned int i = 0; i < RASTA_SEND_PRIORITIES; i++) {
+            snprintf(stage_labels, sizeof(stage_labels), "%s,priority=\"%s\"", labels,
+                     i == RASTA_SEND_URGENT ? "urgent" : "bulk");
+            write_summary(out, "rasta_connection_send_queue_us", stage_labels, &snapshot.metrics.send_queue_us[i]);
+        }
+        write_summary(out, "rasta_connection_send_schedule_us", labels, &snapshot.metrics.send_schedule_us);
+
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"receive\"} %lu\n", labels, snapshot.metrics.receive_ns);
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"send\"} %lu\n", labels, snapshot.metrics.send_ns);
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"safety_code\"} %lu\n", labels,
+                snapshot.safety_code_ns);
+
+        if (sr_get_connection_residency(h, con->remote_id, &residency)) {
+            for (unsigned int stage = 0; stage < RASTA_RESIDENCY_STAGES; stage++) {
+                snprintf(stage_labels, sizeof(stage_labels), "%s,stage=\"%s\"", labels,
+                         rasta_residency_stage_name((rasta_residency_stage) stage));
+                write_summary(out, "rasta_connection_residency_us", stage_labels, &residency.wait_us[stage]);
+            }
+        }
+
+        for (unsigned int i = 0; i < snapshot.transport_channel_count; i++) {
+            const struct rasta_transport_metrics* transport = &snapshot.transport_channels[i];
+            fprintf(out, "rasta_transport_pdus_in_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->pdus_in);
+            fprintf(out, "rasta_transport_bytes_in_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->bytes_in);
+            fprintf(out, "rasta_transport_pdus_out_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->pdus_out);
+            fprintf(out, "rasta_transport_bytes_out_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->bytes_out);
+            fprintf(out, "rasta_transport_checksum_errors_total{%s,channel=\"%u\"} %lu\n", labels, i,
+                    transport->checksum_errors);
+        }
+    }
+
+    // the ranking changes between scrapes, so the series of the top peers are gauges
+    struct rasta_peer_usage top[RASTA_METRICS_TOP_PEERS];
+    unsigned int top_count = sr_get_top_peers(h, top, RASTA_METRICS_TOP_PEERS);
+    fprintf(out, "# TYPE rasta_top_peer_time_ns gauge\n"
+                 "# TYPE rasta_top_peer_pdus gauge\n"
+                 "# TYPE rasta_top_peer_bytes gauge\n"
+                 "# TYPE rasta_top_peer_retransmitted_pdus gauge\n");
+    for (unsigned int i = 0; i < top_count; i++) {
+        snprintf(labels, sizeof(labels), "rank=\"%u\",remote_id=\"0x%lX\"", i + 1, top[i].remote_id);
+        fprintf(out, "rasta_top_peer_time_ns{%s} %lu\n", labels, rasta_peer_usage_ns(&top[i]));
+        fprintf(out, "rasta_top_peer_pdus{%s} %lu\n", labels, top[i].pdus_in + top[i].pdus_out);
+        fprintf(out, "rasta_top_peer_bytes{%s} %lu\n", labels, top[i].bytes_in + top[i].bytes_out);
+        fprintf(out, "rasta_top_peer_retransmitted_pdus{%s} %lu\n", labels, top[i].retransmitted_pdus);
+    }
+
+    // the sockets are shared by all connections, a handle that shares the sockets of another one reports them too
+    struct RastaUDPTransmitStats transmit;
+    fprintf(out, "# TYPE rasta_transmit_queue_size gauge\n"
+                 "# TYPE rasta_transmit_queued_total counter\n"
+                 "# TYPE rasta_transmit_drops_total counter\n");
+    for (unsigned int i = 0; sr_get_transmit_stats(h, i, &transmit); i++) {
+        fprintf(out, "rasta_transmit_queue_size{channel=\"%u\"} %u\n", i, transmit.depth);
+        fprintf(out, "rasta_transmit_queued_total{channel=\"%u\"} %lu\n", i, transmit.queued);
+        fprintf(out, "rasta_transmit_drops_total{channel=\"%u\"} %lu\n", i, transmit.drops);
+    }
+
+    struct RastaUDPBufferStats socket_stats;
+    fprintf(out, "# TYPE rasta_socket_receive_buffer_bytes gauge\n"
+                 "# TYPE rasta_socket_send_buffer_bytes gauge\n"
+                 "# TYPE rasta_socket_kernel_drops_total counter\n");
+    for (unsigned int i = 0; sr_get_socket_stats(h, i, &socket_stats); i++) {
+        fprintf(out, "rasta_socket_receive_buffer_bytes{channel=\"%u\"} %u\n", i, socket_stats.receive_buffer);
+        fprintf(out, "rasta_socket_send_buffer_bytes{channel=\"%u\"} %u\n", i, socket_stats.send_buffer);
+        fprintf(out, "rasta_socket_kernel_drops_total{channel=\"%u\"} %lu\n", i, socket_stats.kernel_drops);
+    }
+
+    struct rasta_transport_metrics path;
+    fprintf(out, "# TYPE rasta_path_pdus_in_total counter\n"
+                 "# TYPE rasta_path_bytes_in_total counter\n"
+                 "# TYPE rasta_path_pdus_out_total counter\n"
+                 "# TYPE rasta_path_bytes_out_total counter\n"
+                 "# TYPE rasta_path_checksum_errors_total counter\n");
+    for (unsigned int i = 0; sr_get_path_metrics(h, i, &path); i++) {
+        fprintf(out, "rasta_path_pdus_in_total{channel=\"%u\"} %lu\n", i, path.pdus_in);
+        fprintf(out, "rasta_path_bytes_in_total{channel=\"%u\"} %lu\n", i, path.bytes_in);
+        fprintf(out, "rasta_path_pdus_out_total{channel=\"%u\"} %lu\n", i, path.pdus_out);
+        fprintf(out, "rasta_path_bytes_out_total{channel=\"%u\"} %lu\n", i, path.bytes_out);
+        fprintf(out, "rasta_path_checksum_errors_total{channel=\"%u\"} %lu\n", i, path.checksum_errors);
+    }
+
+    struct RastaPendingChannelStats pending;
+    sr_get_pending_channel_stats(h, &pending);
+    fprintf(out, "# TYPE rasta_pending_channels gauge\n"
+                 "# TYPE rasta_pending_channel_evictions_total counter\n"
+                 "# TYPE rasta_pending_channel_drops_total counter\n");
+    fprintf(out, "rasta_pending_channels %u\n", pending.count);
+    fprintf(out, "rasta_pending_channel_evictions_total %lu\n", pending.evictions);
+    fprintf(out, "rasta_pending_channel_drops_total %lu\n", pending.drops);
+
+    // process-wide, only there if librasta is built with ENABLE_RASTA_MEMORY_ACCOUNTING
+    struct rmemory_subsystem_stats memory;
+    if (rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_OTHER, &memory)) {
+        fprintf(out, "# TYPE rasta_memory_allocations_total counter\n"
+                     "# TYPE rasta_memory_frees_total counter\n"
+                     "# TYPE rasta_memory_allocated_bytes_total counter\n"
+                     "# TYPE rasta_memory_live_bytes gauge\n"
+                     "# TYPE rasta_memory_live_bytes_peak gauge\n");
+        for (unsigned int i = 0; i < RMEMORY_SUBSYSTEMS; i++) {
+            rmemory_get_subsystem_stats((rmemory_subsystem) i, &memory);
+            snprintf(labels, sizeof(labels), "subsystem=\"%s\"", rmemory_subsystem_name((rmemory_subsystem) i));
+            fprintf(out, "rasta_memory_allocations_total{%s} %lu\n", labels, memory.allocations);
+            fprintf(out, "rasta_memory_frees_total{%s} %lu\n", labels, memory.frees);
+            fprintf(out, "rasta_memory_allocated_bytes_total{%s} %lu\n", labels, memory.bytes);
+            fprintf(out, "rasta_memory_live_bytes{%s} %lu\n", labels, memory.live_bytes);
+            fprintf(out, "rasta_memory_live_bytes_peak{%s} %lu\n", labels, memory.peak_live_bytes);
+        }
+    }
+
+    struct rasta_histogram lag;
+    sr_get_loop_lag(h, &lag);
+    fprintf(out, "# TYPE rasta_event_loop_lag_us summary\n");
+    write_summary(out, "rasta_event_loop_lag_us", "", &lag);
+
+    if (h->callback_executor != NULL) {
+        fprintf(out, "# TYPE rasta_callbacks_queued_total counter\n"
+                     "# TYPE rasta_callbacks_coalesced_total counter\n"
+                     "# TYPE rasta_callback_overflows_total counter\n");
+        fprintf(out, "rasta_callbacks_queued_total %lu\n", rasta_metrics_read(&h->callback_executor->queued));
+        fprintf(out, "rasta_callbacks_coalesced_total %lu\n", rasta_metrics_read(&h->callback_executor->coalesced));
+        fprintf(out, "rasta_callback_overflows_total %lu\n", rasta_metrics_read(&h->callback_executor->overflows));
+    }
+
+    struct rasta_receive_stage_metrics stages;
+    sr_get_receive_stage_metrics(h, &stages);
+    fprintf(out, "# TYPE rasta_receive_stage_batches_total counter\n"
+                 "# TYPE rasta_receive_stage_pdus_total counter\n"
+                 "# TYPE rasta_receive_stage_rejected_total counter\n"
+                 "# TYPE rasta_receive_stage_duration_ns summary\n");
+    for (unsigned int i = 0; i < RASTA_RECEIVE_STAGES; i++) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", rasta_receive_stage_name((rasta_receive_stage) i));
+        fprintf(out, "rasta_receive_stage_batches_total{%s} %lu\n", labels, stages.batches[i]);
+        fprintf(out, "rasta_receive_stage_pdus_total{%s} %lu\n", labels, stages.pdus[i]);
+        fprintf(out, "rasta_receive_stage_rejected_total{%s} %lu\n", labels, stages.rejected[i]);
+        write_summary(out, "rasta_receive_stage_duration_ns", labels, &stages.duration[i]);
+    }
+}
+
+void sr_publish_stat_page(struct rasta_handle* h) {
+    struct rasta_stat_page* page = h->stat_page;
+    if (page == NULL) {
+        return;
+    }
+    struct rasta_stat_header* header = page->header;
+
+    rasta_stat_page_begin(page);
+
+    struct rasta_stat_connection* connections = rasta_stat_page_connections(header);
+    unsigned int count = 0;
+    unsigned int omitted = 0;
+    for (struct rasta_connection* con = h->first_con; con != NULL; con = con->linkedlist_next) {
+        if (count == header->connection_capacity) {
+            omitted++;
+            continue;
+        }
+        // written in place, the readers retry if they overlap with the publication
+        if (sr_get_connection_metrics(h, con->remote_id, &connections[count].snapshot)) {
+            connections[count].state = (uint32_t) con->current_state;
+            count++;
+        }
+    }
+    header->connection_count = count;
+    header->connections_omitted = omitted;
+
+    struct rasta_stat_channel* channels = rasta_stat_page_channels(header);
+    unsigned int channel = 0;
+    for (; channel < header->channel_capacity && sr_get_path_metrics(h, channel, &channels[channel].path); channel++) {
+        sr_get_transmit_stats(h, channel, &channels[channel].transmit);
+    }
+    header->channel_count = channel;
+
+    sr_get_loop_lag(h, &header->loop_lag_us);
+    sr_get_pending_channel_stats(h, &header->pending);
+    if (h->callback_executor != NULL) {
+        header->callbacks_queued = rasta_metrics_read(&h->callback_executor->queued);
+        header->callbacks_coalesced = rasta_metrics_read(&h->callback_executor->coalesced);
+        header->callback_overflows = rasta_metrics_read(&h->callback_executor->overflows);
+    }
+    sr_get_receive_stage_metrics(h, &header->receive_stages);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    rasta_stat_page_end(page, (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec);
+}
+
+/**
+ * publishes the metrics to the stat page
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int stat_page_event(void* carry_data) {
+    sr_publish_stat_page(carry_data);
+    return 0;
+}
+
+/**
+ * answers the pending requests on the Prometheus text endpoint. The request itself is not parsed, every request gets
+ * the metrics
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int metrics_endpoint_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    int client;
+
+    while ((client = accept(h->metrics_fd, NULL, NULL)) != -1) {
+        // the request is not parsed but has to be read, closing a socket with unread data resets the connection and
+        // the scraper loses the response
+        char request[1024];
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        recv(client, request, sizeof(request), 0);
+
+        char* body = NULL;
+        size_t body_length = 0;
+        FILE* stream = open_memstream(&body, &body_length);
+        if (stream == NULL) {
+            close(client);
+            break;
+        }
+        sr_write_metrics(h, stream);
+        fclose(stream);
+
+        char header[128];
+        int header_length = snprintf(header, sizeof(header),
+                                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_length);
+
+        // the client socket is blocking, a scraper reads the small response at once
+        if (send(client, header, (size_t) header_length, MSG_NOSIGNAL) == header_length) {
+            send(client, body, body_length, MSG_NOSIGNAL);
+        }
+        free(body);
+        close(client);
+    }
+    return 0;
+}
+
+void sr_metrics_open_endpoint(struct rasta_handle* h, uint16_t port) {
+    h->metrics_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (h->metrics_fd == -1) {
+        perror("Could not create metrics socket");
+        exit(1);
+    }
+
+    int reuse = 1;
+    setsockopt(h->metrics_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(h->metrics_fd, (struct sockaddr*) &address, sizeof(address)) == -1) {
+        perror("Could not bind metrics socket");
+        exit(1);
+    }
+    if (listen(h->metrics_fd, 8) == -1) {
+        perror("Could not listen on metrics socket");
+        exit(1);
+    }
+
+    memset(&h->metrics_event, 0, sizeof(fd_event));
+    h->metrics_event.callback = metrics_endpoint_event;
+    h->metrics_event.carry_data = h;
+    h->metrics_event.fd = h->metrics_fd;
+    enable_fd_event(&h->metrics_event);
+}
+
+int sr_reload_config(struct rasta_handle* h) {
+    struct RastaConfig loaded = config_load(h->config.filename);
+    if (loaded.dictionary.data == NULL) {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA reload", "could not read %s, keeping the configuration",
+                   h->config.filename);
+        return -1;
+    }
+    struct RastaConfigInfoSending * sending = &h->config.values.sending;
+    const struct RastaConfigInfoSending * reloaded = &loaded.values.sending;
+
+    // the send queues of the connections are allocated for the configured max_packet
+    unsigned int max_packet = reloaded->max_packet;
+    if (2 * max_packet > h->connection_pool.send_queue_size) {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA reload",
+                   "RASTA_MAX_PACKET %u does not fit into the send queues, keeping %u", max_packet, sending->max_packet);
+        max_packet = sending->max_packet;
+    }
+
+    sending->t_h = reloaded->t_h;
+    sending->heartbeat_tick_ms = reloaded->heartbeat_tick_ms;
+    sending->max_packet = max_packet;
+    sending->diag_window = reloaded->diag_window;
+    // the sub handles keep a copy of the sending configuration
+    struct RastaConfigInfoSending * copies[3] = {
+        &h->receive_handle->config, &h->send_handle->config, &h->heartbeat_handle->config
+    };
+    for (unsigned int i = 0; i < 3; i++) {
+        copies[i]->t_h = sending->t_h;
+        copies[i]->heartbeat_tick_ms = sending->heartbeat_tick_ms;
+        copies[i]->max_packet = sending->max_packet;
+        copies[i]->diag_window = sending->diag_window;
+    }
+
+    // the next heartbeat of every connection is sent T_H after now
+    for (struct rasta_connection * con = h->first_con; con; con = con->linkedlist_next) {
+        con->send_heartbeat_event.interval = sending->t_h * 1000000lu;
+        if (con->send_heartbeat_event.enabled) {
+            reschedule_event(&con->send_heartbeat_event);
+        }
+    }
+
+    h->config.values.redundancy.t_seq = loaded.values.redundancy.t_seq;
+    h->config.values.redundancy.n_deferqueue_size = loaded.values.redundancy.n_deferqueue_size;
+    unsigned int kept = redundancy_mux_reconfigure(&h->mux, h->config.values.redundancy.t_seq,
+                                                   h->config.values.redundancy.n_deferqueue_size);
+
+    int max_log_level = rasta_config_log_level(&loaded);
+    if (max_log_level >= 0) {
+        h->logger.max_log_level = (log_level) max_log_level;
+        h->redlogger.max_log_level = (log_level) max_log_level;
+        redundancy_mux_set_log_level(&h->mux, (log_level) max_log_level);
+    }
+
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA reload",
+               "reloaded %s: t_h=%u max_packet=%u diag_window=%u t_seq=%u n_deferqueue_size=%u, %u channels keep "
+               "their defer queue size", h->config.filename, sending->t_h, sending->max_packet, sending->diag_window,
+               h->config.values.redundancy.t_seq, h->config.values.redundancy.n_deferqueue_size, kept);
+    config_free(&loaded);
+    return 0;
+}
+
+/**
+ * reloads the config file when SIGHUP was received
+ * @param carry_data the handle
+ * @return 0
+ */
+static int reload_signal_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+
+    struct signalfd_siginfo info;
+    while (read(h->reload_signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        // several signals that arrived since the last wakeup are handled by one reload
+    }
+    sr_reload_config(h);
+    return 0;
+}
+
+void sr_reload_on_sighup(struct rasta_handle* h) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0) {
+        perror("Could not block SIGHUP");
+        exit(1);
+    }
+
+    h->reload_signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (h->reload_signal_fd == -1) {
+        perror("Could not create signalfd");
+        exit(1);
+    }
+
+    memset(&h->reload_event, 0, sizeof(fd_event));
+    h->reload_event.callback = reload_signal_event;
+    h->reload_event.carry_data = h;
+    h->reload_event.fd = h->reload_signal_fd;
+    enable_fd_event(&h->reload_event);
+}
+
+/**
+ * @return 1 if the state of a connection can be continued by a standby
+ */
+static int sr_replicable(struct rasta_connection* con) {
+    return con->current_state == RASTA_CONNECTION_UP || con->current_state == RASTA_CONNECTION_RETRREQ
+           || con->current_state == RASTA_CONNECTION_RETRRUN;
+}
+
+/**
+ * the amount of sequence numbers a connection that is taken over skips. The primary may have sent up to
+ * sr_replication_due() data packets and the heartbeats of a round after the replicated state, their sequence numbers
+ * must not be used again
+ * @param cfg the sending configuration
+ */
+static uint32_t sr_replication_skip(struct RastaConfigInfoSending cfg) {
+    return 2 * cfg.send_max;
+}
+
+/**
+ * the amount of sequence numbers after which a connection is replicated before the round ends
+ * @param cfg the sending configuration
+ */
+static uint32_t sr_replication_due(struct RastaConfigInfoSending cfg) {
+    return cfg.send_max > 1 ? cfg.send_max / 2 : 1;
+}
+
+/**
+ * queues the CONNECTION record of a connection
+ * @param h the handle
+ * @param con the connection
+ * @return 1 on success, 0 if the standby does not keep up
+ */
+static int sr_replicate_connection(struct rasta_handle* h, struct rasta_connection* con) {
+    struct rasta_replica replica;
+    memset(&replica, 0, sizeof(replica));
+    replica.my_id = con->my_id;
+    replica.remote_id = con->remote_id;
+    replica.network_id = con->network_id;
+    replica.role = (uint8_t) con->role;
+    replica.sn_t = con->sn_t;
+    replica.sn_r = con->sn_r;
+    replica.cs_t = con->cs_t;
+    replica.cs_r = con->cs_r;
+    replica.ts_r = con->ts_r;
+    replica.cts_r = con->cts_r;
+    replica.sn_i = con->sn_i;
+    replica.t_i = con->t_i;
+    replica.connected_recv_buffer_size = con->connected_recv_buffer_size;
+    replica.timestamp_offset = con->timestamp_offset;
+
+    rasta_redundancy_channel* channel = redundancy_mux_get_channel(&h->mux, con->remote_id);
+    if (channel != NULL) {
+        replica.seq_tx = channel->seq_tx;
+        replica.seq_rx = channel->seq_rx;
+        // the standby restores the transport channels in the order of its sockets, a channel after one that was not
+        // discovered yet is discovered by the standby again
+        for (unsigned int i = 0; i < RASTA_REPLICA_MAX_CHANNELS && rasta_red_path_channel(channel, i) >= 0; i++) {
+            const rasta_transport_channel* transport = &channel->connected_channels[rasta_red_path_channel(channel, i)];
+            strncpy(replica.channels[i].ip, transport->ip_address, sizeof(replica.channels[i].ip) - 1);
+            replica.channels[i].port = transport->port;
+            replica.channel_count++;
+        }
+    }
+
+#ifdef ENABLE_OPAQUE
+    if (h->config.values.kex.mode != KEY_EXCHANGE_MODE_NONE) {
+        replica.key_length = sizeof(con->kex_state.session_key);
+        memcpy(replica.key, con->kex_state.session_key, replica.key_length);
+    }
+#endif
+
+    if (!rasta_replication_queue_connection(h->replication, &replica, &con->retr_buffer)) {
+        return 0;
+    }
+    con->replicated = 1;
+    con->replicated_sn_t = con->sn_t;
+    con->replicated_sn_r = con->sn_r;
+    con->replicated_cs_r = con->cs_r;
+    return 1;
+}
+
+/**
+ * queues the REMOVE record of a connection the standby knows
+ * @param h the handle
+ * @param con the connection
+ * @return 1 on success, 0 if the standby does not keep up
+ */
+static int sr_replicate_remove(struct rasta_handle* h, struct rasta_connection* con) {
+    unsigned char body[4];
+    hostLongToLe(con->remote_id, body);
+    con->replicated = 0;
+    return rasta_replication_queue(h->replication, RASTA_REPLICATION_REMOVE, body, sizeof(body));
+}
+
+/**
+ * drops the stream to a standby that does not keep up, the next round connects again and sends all connections
+ * @param h the handle
+ */
+static void sr_replication_lost(struct rasta_handle* h) {
+    logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA replication", "the standby does not keep up, reconnecting");
+    rasta_replication_close_stream(h->replication);
 }
 
-void sr_connect(struct rasta_handle *h, unsigned long id, struct RastaIPData *channels) {
-    for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
-        //TODO: Error handling
-        if (con->remote_id == id) return;
+/**
+ * @return 1 if the records of a primary can be queued
+ */
+static int sr_replication_streaming(struct rasta_handle* h) {
+    return h->replication != NULL && h->replication->role == RASTA_REPLICATION_PRIMARY &&
+           h->replication->fd != -1 && !h->replication->connecting;
+}
+
+/**
+ * sends the connections that changed since the last round and ends the round
+ * @param h the handle
+ * @param full 1 if the stream is new and all connections have to be sent
+ */
+static void sr_replication_round(struct rasta_handle* h, int full) {
+    int queued = !full || rasta_replication_queue(h->replication, RASTA_REPLICATION_RESET, NULL, 0);
+    for (struct rasta_connection* con = h->first_con; con && queued; con = con->linkedlist_next) {
+        if (full) {
+            con->replicated = 0;
+        }
+        if (sr_replicable(con)) {
+            if (!con->replicated || con->sn_t != con->replicated_sn_t || con->sn_r != con->replicated_sn_r ||
+                con->cs_r != con->replicated_cs_r) {
+                queued = sr_replicate_connection(h, con);
+            }
+        } else if (con->replicated) {
+            queued = sr_replicate_remove(h, con);
+        }
     }
-    //TODO: const ports in redundancy? (why no dynamic port length)
-    redundancy_mux_add_channel(&h->mux,id,channels);
 
-    struct rasta_connection new_con;
-    memset(&new_con, 0, sizeof(struct rasta_connection));
-    sr_init_connection(&new_con,id,h->config.values.general,h->config.values.sending,&h->logger, RASTA_ROLE_CLIENT);
-    redundancy_mux_set_config_id(&h->mux, id);
+    if (!queued || !rasta_replication_queue_round(h->replication, cur_timestamp())) {
+        sr_replication_lost(h);
+        return;
+    }
+    rasta_replication_flush(h->replication);
+}
 
-    // initialize seq nums and timestamps
-    new_con.sn_t = get_initial_seq_num(&h->config);
-    //new_con.sn_t = 66;
-    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "Using %lu as initial sequence number",
-        (long unsigned int) new_con.sn_t);
+/**
+ * [PRIMARY] connects to the standby and sends a round
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int replication_round_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    int connected = rasta_replication_connect(h->replication);
+    if (connected == 2) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA replication", "connected to the standby");
+    }
+    if (connected) {
+        sr_replication_round(h, connected == 2);
+    }
+    return 0;
+}
 
-    new_con.cs_t = 0;
-    new_con.cts_r = cur_timestamp();
-    new_con.t_i = h->config.values.sending.t_max;
+static void sr_replicate_if_due(struct rasta_handle* h, struct rasta_connection* con) {
+    if (!sr_replication_streaming(h) || !con->replicated ||
+        con->sn_t - con->replicated_sn_t < sr_replication_due(h->config.values.sending)) {
+        return;
+    }
 
-    unsigned char * version = (unsigned char*)RASTA_VERSION;
+    // the sequence numbers the standby skips when it takes over are not used up before the round ends
+    if (!sr_replicate_connection(h, con)) {
+        sr_replication_lost(h);
+        return;
+    }
+    rasta_replication_flush(h->replication);
+}
 
-    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "Local version is %s", version);
+static void sr_replicate_removed(struct rasta_handle* h, struct rasta_connection* con) {
+    if (con->replicated && sr_replication_streaming(h) && !sr_replicate_remove(h, con)) {
+        sr_replication_lost(h);
+    }
+}
 
+/**
+ * continues a connection of the primary
+ * @param h the handle
+ * @param replica the last replicated state of the connection
+ * @param timestamp_offset the clock of the primary minus the clock of this entity
+ * @return 1 if the connection was taken over
+ */
+static int sr_take_over(struct rasta_handle* h, const struct rasta_replica* replica, uint32_t timestamp_offset) {
+    if (rasta_id_index_get(&h->connection_index, replica->remote_id) != NULL) {
+        return 0;
+    }
 
-    // send ConReq
-    struct RastaPacket conreq = createConnectionRequest(new_con.remote_id, new_con.my_id,
-                                                        new_con.sn_t, cur_timestamp(),
-                                                        h->config.values.sending.send_max,
-                                                        version, &h->hashing_context);
-    new_con.sn_i = new_con.sn_t;
+    struct rasta_connection new_con;
+    memset(&new_con, 0, sizeof(struct rasta_connection));
+    if (!sr_init_connection(&new_con, &h->connection_pool, NULL, replica->remote_id, h->config.values.general,
+                            h->config.values.sending, &h->logger, (rasta_role) replica->role)) {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA replication", "can not take %X over, all %u connections are in use",
+                   replica->remote_id, h->connection_pool.capacity);
+        return 0;
+    }
 
-    redundancy_mux_send(&h->mux,conreq);
+    struct RastaConfigInfoSending cfg = h->config.values.sending;
+    new_con.my_id = replica->my_id;
+    new_con.network_id = replica->network_id;
+    new_con.sn_t = replica->sn_t + sr_replication_skip(cfg);
+    new_con.sn_i = replica->sn_i;
+    new_con.sn_r = replica->sn_r;
+    new_con.cs_t = replica->cs_t;
+    new_con.cs_r = replica->cs_r;
+    new_con.ts_r = replica->ts_r;
+    new_con.cts_r = replica->cts_r;
+    new_con.t_i = replica->t_i;
+    new_con.connected_recv_buffer_size = replica->connected_recv_buffer_size;
+    new_con.timestamp_offset = timestamp_offset + replica->timestamp_offset;
+
+    // the unconfirmed data packets are retransmitted when the partner asks for them
+    size_t offset = 0;
+    uint32_t sequence_number;
+    unsigned int length;
+    const unsigned char* pdu;
+    while ((pdu = rasta_replica_next_pdu(replica, &offset, &sequence_number, &length)) != NULL) {
+        retrbuffer_add_encoded(&new_con.retr_buffer, sequence_number, pdu, length);
+    }
 
-    // increase sequence number
-    new_con.sn_t++;
+#ifdef ENABLE_OPAQUE
+    if (replica->key_length == sizeof(new_con.kex_state.session_key)) {
+        memcpy(new_con.kex_state.session_key, replica->key, replica->key_length);
+        rasta_set_hash_key_variable(&h->hashing_context, (char *) new_con.kex_state.session_key,
+                                    sizeof(new_con.kex_state.session_key));
+    }
+#endif
 
-    // update tls_state
-    new_con.current_state = RASTA_CONNECTION_START;
+    // heartbeats are sent right away, the first PDU of the partner tells which sequence number it is at
+    new_con.current_state = RASTA_CONNECTION_UP;
+    new_con.hb_locked = 0;
+    new_con.resync = 1;
 
-    void* memory = h->user_handles->on_connection_start(&new_con);
-    if (memory == NULL) {
-        logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA CONNECT", "connection refused by user to %d", new_con.remote_id);
-        return;
+    // a channel that was opened by PDUs of the partner before the takeover does not know the sequence numbers
+    redundancy_mux_remove_channel(&h->mux, replica->remote_id);
+    uint32_t channel_skip = sr_replication_skip(cfg);
+    if (channel_skip > 5 * h->config.values.redundancy.n_deferqueue_size) {
+        channel_skip = 5 * h->config.values.redundancy.n_deferqueue_size;
     }
+    redundancy_mux_restore_channel(&h->mux, replica->remote_id, replica->channels, replica->channel_count,
+                                   replica->seq_tx + channel_skip, replica->seq_rx);
 
-    struct rasta_connection *con = memory;
+    struct rasta_connection* con = h->user_handles->on_connection_start(&new_con);
+    if (con == NULL) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA replication", "taking %X over refused by user", replica->remote_id);
+        redundancy_mux_remove_channel(&h->mux, replica->remote_id);
+        rasta_connection_pool_release(&h->connection_pool, new_con.state);
+        return 0;
+    }
     *con = new_con;
     add_connection_to_list(h, con);
-
-    freeRastaByteArray(&conreq.data);
-
-    // fire connection tls_state changed event
-    fire_on_connection_state_change(sr_create_notification_result(h,con));
-
     init_connection_events(h, con);
-}
+    if (con->role == RASTA_ROLE_CLIENT) {
+        sr_init_reconnect_event(h, con);
+    }
 
-void sr_send(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages){
+    fire_on_connection_state_change(sr_create_notification_result(h, con));
+    send_Heartbeat(&h->mux, con, 1);
+    return 1;
+}
 
-    struct rasta_connection *con;
-    for (con = h->first_con; con; con = con->linkedlist_next) {
-        if (con->remote_id == remote_id) break;
+unsigned int sr_replication_takeover(struct rasta_handle* h) {
+    struct rasta_replication* r = h->replication;
+    if (r == NULL || r->role != RASTA_REPLICATION_STANDBY || r->listen_fd == -1) {
+        return 0;
     }
 
-    if (con == 0) return;
-
-    if(con->current_state == RASTA_CONNECTION_UP){
-        if (app_messages.count > h->config.values.sending.max_packet){
-            // to many application messages
-            logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA send", "too many application messages to send in one packet. Maximum is %d",
-                       h->config.values.sending.max_packet);
-            // do nothing and leave method with error code 2
-            return;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < r->entry_count; i++) {
+        struct rasta_replica replica;
+        if (rasta_replica_decode(&replica, r->entries[i]->data, r->entries[i]->length)) {
+            count += (unsigned int) sr_take_over(h, &replica, r->timestamp_offset);
         }
+    }
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA replication", "took %u of %u connections over", count, r->entry_count);
+
+    // the events stay in the event loop until it ends, the standby is done
+    disable_fd_event(&r->listen_event);
+    disable_fd_event(&r->stream_event);
+    disable_timed_event(&r->round_event);
+    rasta_replication_close_stream(r);
+    close(r->listen_fd);
+    r->listen_fd = -1;
+    rasta_replication_clear(r);
+    return count;
+}
 
-        for (unsigned int i = 0; i < app_messages.count; ++i) {
-            struct RastaByteArray msg;
-            msg = app_messages.data_array[i];
+/**
+ * [STANDBY] the primary sent no round for RASTA_REPLICATION_TIMEOUT_ROUNDS rounds
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int replication_watchdog_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA replication", "the primary is silent, taking over");
+    sr_replication_takeover(h);
+    return 0;
+}
 
-            // push into queue
-            struct RastaByteArray * to_fifo = rmalloc(sizeof(struct RastaByteArray));
-            allocateRastaByteArray(to_fifo, msg.length);
-            rmemcpy(to_fifo->bytes, msg.bytes, msg.length);
-            fifo_push(con->fifo_send, to_fifo);
-        }
+/**
+ * [STANDBY] handles the records of the primary
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int replication_stream_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    struct rasta_replication* r = h->replication;
+
+    unsigned int rounds = r->rounds;
+    if (!rasta_replication_receive(r, cur_timestamp())) {
+        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA replication", "lost the primary, taking over");
+        sr_replication_takeover(h);
+        return 0;
+    }
 
-        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA send", "data in send queue");
+    if (r->rounds != rounds && r->primary_interval_ms > 0) {
+        r->round_event.interval = (uint64_t) RASTA_REPLICATION_TIMEOUT_ROUNDS * r->primary_interval_ms * NS_PER_MS;
+        enable_timed_event(&r->round_event);
+    }
+    return 0;
+}
 
-    } else if (con->current_state == RASTA_CONNECTION_CLOSED || con->current_state == RASTA_CONNECTION_DOWN){
-        // nothing to do besides changing tls_state to closed
-        con->current_state = RASTA_CONNECTION_CLOSED;
+/**
+ * [STANDBY] accepts a primary
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int replication_accept_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    struct rasta_replication* r = h->replication;
 
-        // fire connection tls_state changed event
-        fire_on_connection_state_change(sr_create_notification_result(h,con));
-    } else {
-        logger_log(&h->logger, LOG_LEVEL_ERROR, "RaSTA send", "service not allowed");
+    int fd = rasta_replication_accept(r);
+    if (fd == -1) {
+        return 0;
+    }
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA replication", "the primary connected");
 
-        // disconnect and close
-        send_DisconnectionRequest(&h->mux,con, RASTA_DISC_REASON_SERVICENOTALLOWED, 0);
-        con->current_state = RASTA_CONNECTION_CLOSED;
+    // the event is registered again with the new stream
+    if (r->stream_event.fd != -1) {
+        remove_fd_event(h->ev_sys, &r->stream_event);
+    }
+    r->stream_event.fd = fd;
+    enable_fd_event(&r->stream_event);
+    add_fd_event(h->ev_sys, &r->stream_event, EV_READABLE);
+    return 0;
+}
 
-        // fire connection tls_state changed event
-        fire_on_connection_state_change(sr_create_notification_result(h,con));
+void sr_replication_open(struct rasta_handle* h, struct RastaConfigReplication config) {
+    struct rasta_replication* r = rmalloc(sizeof(struct rasta_replication));
+    if (config.role == RASTA_REPLICATION_PRIMARY) {
+        rasta_replication_init_primary(r, config.address.ip, (uint16_t) config.address.port, config.interval_ms);
+    } else {
+        rasta_replication_init_standby(r, config.address.ip, (uint16_t) config.address.port);
+    }
 
-        // leave with error code 1
-        return;
+    memset(&r->round_event, 0, sizeof(timed_event));
+    memset(&r->listen_event, 0, sizeof(fd_event));
+    memset(&r->stream_event, 0, sizeof(fd_event));
+    r->listen_event.fd = -1;
+    r->stream_event.fd = -1;
+    if (config.role == RASTA_REPLICATION_PRIMARY) {
+        r->round_event.callback = replication_round_event;
+        r->round_event.carry_data = h;
+        r->round_event.interval = (uint64_t) config.interval_ms * NS_PER_MS;
+        enable_timed_event(&r->round_event);
+    } else {
+        // armed by the first round of the primary
+        r->round_event.callback = replication_watchdog_event;
+        r->round_event.carry_data = h;
+        r->listen_event.callback = replication_accept_event;
+        r->listen_event.carry_data = h;
+        r->listen_event.fd = r->listen_fd;
+        enable_fd_event(&r->listen_event);
+        r->stream_event.callback = replication_stream_event;
+        r->stream_event.carry_data = h;
     }
+    h->replication = r;
 }
 
-rastaApplicationMessage sr_get_received_data(struct rasta_handle *h, struct rasta_connection * connection){
-    rastaApplicationMessage message;
-    rastaApplicationMessage * element;
+/**
+ * tells the standby that the connections are closed and frees the stream
+ * @param h the handle
+ */
+static void sr_replication_close(struct rasta_handle* h) {
+    if (sr_replication_streaming(h) && rasta_replication_queue(h->replication, RASTA_REPLICATION_RESET, NULL, 0)) {
+        rasta_replication_flush(h->replication);
+    }
+    rasta_replication_free(h->replication);
+    rfree(h->replication);
+    h->replication = NULL;
+}
 
-    element = fifo_pop(connection->fifo_app_msg);
+/**
+ * removes the events and the slot of a closed connection and hands it back to the user
+ * @param h the handle
+ * @param con the connection
+ */
+static void sr_disconnect_release(struct rasta_handle* h, struct rasta_connection* con) {
+    remove_timed_event(h->ev_sys,&con->timeout_event);
+    remove_timed_event(h->ev_sys,&con->send_heartbeat_event);
+    if (con->reconnect_event.ev_sys) {
+        remove_timed_event(h->ev_sys,&con->reconnect_event);
+    }
+    remove_connection_from_list(h,con);
+#ifdef ENABLE_OPAQUE
+    if(h->config.values.kex.rekeying_interval_ms) {
+        remove_timed_event(h->ev_sys,&con->rekeying_event);
+    }
+#endif
 
-    message.id = element->id;
-    message.appMessage = element->appMessage;
+    // the partner drops the redundancy channel with the DiscReq, a new connection has to start a new one at sequence
+    // number 0
+    redundancy_mux_remove_channel(&h->mux, con->remote_id);
 
-    logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA retrieve", "application message with l %d", message.appMessage.length);
-    //logger_log(&h->logger, LOG_LEVEL_DEBUG, "RETRIEVE DATA", "Convert bytes to packet");
+    // the queued notifications of the connection use its slot and the application may free the connection
+    if (h->callback_executor != NULL) {
+        rasta_callback_executor_run(h->callback_executor, UINT_MAX);
+    }
 
-    rfree(element);
+    // the slot is taken by the next connection
+    rasta_connection_pool_release(&h->connection_pool, con->state);
+    con->state = NULL;
 
-    //struct RastaPacket packet = bytesToRastaPacket(msg);
-    //return packet;
-    return message;
+    h->user_handles->on_disconnect(con, con);
 }
 
 /**
@@ -2018,17 +5143,55 @@ void sr_disconnect(struct rasta_handle* h, struct rasta_connection* con) {
     logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA connection", "disconnected %X", con->remote_id);
 
     sr_close_connection(con, h, &h->mux, h->config.values.general, RASTA_DISC_REASON_USERREQUEST, 0);
+    sr_disconnect_release(h, con);
+}
 
-    remove_timed_event(h->ev_sys,&con->timeout_event);
-    remove_timed_event(h->ev_sys,&con->send_heartbeat_event);
-    remove_connection_from_list(h,con);
-#ifdef ENABLE_OPAQUE
-    if(h->config.values.kex.rekeying_interval_ms) {
-        remove_timed_event(h->ev_sys,&con->rekeying_event);
+/**
+ * closes all connections of a handle that are not closed already. The disconnection requests of all of them are sent
+ * with one batch, so the time this takes does not grow with the amount of connections
+ * @param h the handle
+ * @param reason the reason of the disconnection requests
+ * @param notify 1 to fire the state change of the connections, 0 if the handle is cleaned up
+ */
+static void sr_close_all_connections(struct rasta_handle* h, rasta_disconnect_reason reason, int notify) {
+    struct rasta_heartbeat_handle* batch = h->heartbeat_handle;
+    unsigned int count = 0;
+    for (struct rasta_connection* con = h->first_con; con; con = con->linkedlist_next) {
+        if (con->current_state != RASTA_CONNECTION_DOWN && con->current_state != RASTA_CONNECTION_CLOSED) {
+            heartbeat_batch_add(batch, &count, con);
+        }
     }
-#endif
 
-    h->user_handles->on_disconnect(con, con);
+    struct RastaDisconnectionData disconnection_data;
+    disconnection_data.reason = (unsigned short) reason;
+    disconnection_data.details = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_connection* con = batch->batch_connections[i];
+        sr_reset_connection(con, con->remote_id, h->config.values.general);
+        batch->batch[i] = createDisconnectionRequest(con->remote_id, con->my_id, con->sn_t, con->cs_t, sr_timestamp(con),
+                                                     con->ts_r, disconnection_data, &h->mux.sr_hashing_context);
+    }
+    redundancy_mux_send_batch(&h->mux, batch->batch, count);
+
+    for (unsigned int i = 0; i < count; i++) {
+        freeRastaByteArray(&batch->batch[i].data);
+        if (notify) {
+            fire_on_connection_state_change(sr_create_notification_result(h, batch->batch_connections[i]));
+        }
+    }
+}
+
+void sr_disconnect_all(struct rasta_handle* h) {
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA connection", "disconnecting all connections");
+
+    sr_close_all_connections(h, RASTA_DISC_REASON_USERREQUEST, 1);
+
+    struct rasta_connection* con = h->first_con;
+    while (con != NULL) {
+        struct rasta_connection* next = con->linkedlist_next;
+        sr_disconnect_release(h, con);
+        con = next;
+    }
 }
 
 void sr_cleanup(struct rasta_handle *h) {
@@ -2038,31 +5201,95 @@ void sr_cleanup(struct rasta_handle *h) {
     h->recv_running = 0;
     h->send_running = 0;
 
+    // the send and receive handlers must not run anymore
+    sr_close_notifications(h);
+
+    // the notifications that are still queued run here, the ones of the closing connections on this thread
+    if (h->callback_executor != NULL) {
+        rasta_callback_executor_destroy(h->callback_executor);
+        rfree(h->callback_executor);
+        h->callback_executor = NULL;
+        h->mux.callback_executor = NULL;
+    }
+
+#ifdef ENABLE_OPAQUE
+    if (h->config.values.kex.mode != KEY_EXCHANGE_MODE_NONE) {
+        worker_pool_destroy(&h->kex_pool);
+        // the prepared credential requests lend their client secrets from kex_secrets
+        for (struct rasta_connection* connection = h->first_con; connection; connection = connection->linkedlist_next) {
+            key_exchange_discard_credential_request(&connection->kex_prepared);
+        }
+        key_exchange_secrets_free(&h->kex_secrets);
+    }
+#endif
+
     if (h->user_handles->on_rasta_cleanup) {
         h->user_handles->on_rasta_cleanup();
     }
 
+    // the remote entities do not have to wait for their timeouts
+    sr_close_all_connections(h, RASTA_DISC_REASON_USERREQUEST, 0);
+
+    if (h->replication != NULL) {
+        sr_replication_close(h);
+    }
+
     for (struct rasta_connection* connection = h->first_con; connection; connection = connection->linkedlist_next) {
-        // free memory allocated for diagnostic intervals
-        rfree(connection->diagnostic_intervals);
+        // the diagnostic intervals, the queues and the retransmission buffer are in the slot
+        rasta_connection_pool_release(&h->connection_pool, connection->state);
+        connection->state = NULL;
+    }
+    rasta_connection_pool_free(&h->connection_pool);
 
-        //free FIFOs
-        fifo_destroy(connection->fifo_app_msg);
-        fifo_destroy(connection->fifo_send);
-        fifo_destroy(connection->fifo_retr);
+    sr_bulk_connect_free(h);
+
+    if (h->conreq_backlog != NULL) {
+        struct RastaPacket *packet;
+        while ((packet = fifo_pop(h->conreq_backlog)) != NULL) {
+            freeRastaByteArray(&packet->data);
+            rfree(packet);
+        }
+        fifo_destroy(h->conreq_backlog);
+        h->conreq_backlog = NULL;
     }
 
     // set notification pointers to NULL
     h->notifications.on_receive = NULL;
+    h->notifications.on_receive_bulk = NULL;
     h->notifications.on_connection_state_change= NULL;
     h->notifications.on_diagnostic_notification = NULL;
     h->notifications.on_disconnection_request_received = NULL;
     h->notifications.on_redundancy_diagnostic_notification = NULL;
+    h->notifications.on_writable = NULL;
+    h->notifications.on_bulk_connect_complete = NULL;
 
 
+    if (h->stat_page != NULL) {
+        // the last state stays readable after the entity stopped
+        sr_publish_stat_page(h);
+        rasta_stat_page_close(h->stat_page);
+        h->stat_page = NULL;
+    }
+    if (h->metrics_fd != -1) {
+        close(h->metrics_fd);
+        h->metrics_fd = -1;
+    }
+    if (h->reload_signal_fd != -1) {
+        close(h->reload_signal_fd);
+        h->reload_signal_fd = -1;
+    }
+
     // close mux
     redundancy_mux_close(&h->mux);
 
+    // the connections are owned by the user, only the index is freed
+    rasta_id_index_free(&h->connection_index);
+
+
+    // no other thread may submit anymore
+    close(h->submit_notify_fd);
+    h->submit_notify_fd = -1;
+    mpsc_queue_destroy(h->submit_queue);
 
     // free config
     config_free(&h->config);
@@ -2074,6 +5301,8 @@ void sr_cleanup(struct rasta_handle *h) {
 
     rfree(h->receive_handle);
     rfree(h->send_handle);
+    rfree(h->heartbeat_handle->batch);
+    rfree(h->heartbeat_handle->batch_connections);
     rfree(h->heartbeat_handle);
 
     logger_log(&h->logger, LOG_LEVEL_DEBUG, "RaSTA Cleanup", "Cleanup done");
@@ -2095,61 +5324,325 @@ void log_main_loop_state(struct rasta_handle* h, event_system* ev_sys, const cha
         message, fd_event_active_count, fd_event_count, timed_event_active_count, timed_event_count);
 }
 
-#define IO_INTERVAL 10000
-void sr_begin(struct rasta_handle* h, event_system* event_system, int channel_timeout_ms) {
-    timed_event send_event, receive_event;
-    timed_event channel_timeout_event;
+/**
+ * logs the durations of the event loop callbacks since the last call and starts measuring again
+ * @param carry_data the handle
+ * @return always 0
+ */
+static int profile_dump_event(void* carry_data) {
+    struct rasta_handle* h = carry_data;
+    char line[256];
+
+    for (unsigned int i = 0; i < h->profile.entry_count; i++) {
+        if (h->profile.entries[i].count == 0) continue;
+        event_profile_describe(&h->profile.entries[i], line, sizeof(line));
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA profile", "%s", line);
+    }
+    if (h->profile.dropped_calls) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA profile", "%lu calls of further callbacks were not profiled",
+                   (unsigned long) h->profile.dropped_calls);
+    }
+    event_profile_reset(&h->profile);
+    return 0;
+}
+
+/**
+ * names the callbacks of the SR and redundancy layer in the profile of the handle
+ * @param h the handle
+ */
+static void name_profiled_callbacks(struct rasta_handle* h) {
+    event_profile_name(&h->profile, send_notification_event, "send_notification_event");
+    event_profile_name(&h->profile, receive_notification_event, "receive_notification_event");
+    event_profile_name(&h->profile, submit_notification_event, "submit_notification_event");
+    event_profile_name(&h->profile, send_pacing_event, "send_pacing_event");
+    event_profile_name(&h->profile, retransmit_pacing_event, "retransmit_pacing_event");
+    event_profile_name(&h->profile, channel_receive_event, "channel_receive_event");
+    event_profile_name(&h->profile, channel_diagnostics_event, "channel_diagnostics_event");
+    event_profile_name(&h->profile, channel_defer_timeout_event, "channel_defer_timeout_event");
+    event_profile_name(&h->profile, heartbeat_send_event, "heartbeat_send_event");
+    event_profile_name(&h->profile, event_connection_expired, "event_connection_expired");
+    event_profile_name(&h->profile, reconnect_event, "reconnect_event");
+    event_profile_name(&h->profile, metrics_endpoint_event, "metrics_endpoint_event");
+    event_profile_name(&h->profile, profile_dump_event, "profile_dump_event");
+    event_profile_name(&h->profile, replication_round_event, "replication_round_event");
+    event_profile_name(&h->profile, replication_accept_event, "replication_accept_event");
+    event_profile_name(&h->profile, replication_stream_event, "replication_stream_event");
+#ifdef ENABLE_OPAQUE
+    event_profile_name(&h->profile, kex_completion_event, "kex_completion_event");
+    event_profile_name(&h->profile, send_timed_key_exchange, "send_timed_key_exchange");
+#endif
+}
+
+/**
+ * the events a handle adds to the event loop it runs in. They are linked into the event system, so they must not move
+ * until sr_detach()
+ */
+struct sr_loop_events {
+    fd_event send_event, receive_event, submit_event;
+#ifdef ENABLE_OPAQUE
+    fd_event kex_event;
+#endif
+    timed_event send_pacing, retransmit_pacing, channel_timeout_event, channel_diagnostics, profile_event, stat_event;
     struct timeout_event_data timeout_data;
 
+    /**
+     * the receive events of the sockets, a handle that shares the sockets of another one has none
+     */
+    fd_event * channel_events;
+    struct receive_event_data * channel_event_data;
+    unsigned int channel_event_count;
+};
+
+/**
+ * adds the events of a handle to an event loop that is not running yet
+ * @param h the handle
+ * @param event_system the event loop
+ * @param channel_timeout_ms like in sr_begin()
+ * @param events the storage of the events
+ * @param primary 1 if the settings and the profile of the loop are taken from this handle
+ */
+static void sr_attach(struct rasta_handle* h, event_system* event_system, int channel_timeout_ms,
+                      struct sr_loop_events* events, int primary) {
     h->ev_sys = event_system;
+    if (primary) {
+        event_system->lag_histogram = &h->loop_lag;
+        event_system->busy_poll = (char) h->config.values.loop.busy_poll;
+        event_system->pin_cpu = h->config.values.loop.busy_poll_cpu >= 0;
+        event_system->busy_poll_cpu = h->config.values.loop.busy_poll_cpu;
+        event_system->realtime_priority = h->config.values.loop.realtime_priority;
+        event_system->lock_memory = (char) h->config.values.loop.lock_memory;
+    }
+
+    // the callbacks of the application are profiled as well, they are shown with their address
+    memset(&events->profile_event, 0, sizeof(timed_event));
+    if (primary && h->config.values.metrics.profile_interval_ms) {
+        memset(&h->profile, 0, sizeof(h->profile));
+        name_profiled_callbacks(h);
+        event_system->profile = &h->profile;
+
+        events->profile_event.callback = profile_dump_event;
+        events->profile_event.carry_data = h;
+        events->profile_event.interval = (uint64_t) h->config.values.metrics.profile_interval_ms * NS_PER_MS;
+        enable_timed_event(&events->profile_event);
+        add_timed_event(event_system, &events->profile_event);
+    }
+
+    // only copies the counters, the readers of the page cost the event loop nothing
+    memset(&events->stat_event, 0, sizeof(timed_event));
+    if (h->stat_page != NULL) {
+        events->stat_event.callback = stat_page_event;
+        events->stat_event.carry_data = h;
+        events->stat_event.interval = (uint64_t) h->config.values.metrics.stat_interval_ms * NS_PER_MS;
+        enable_timed_event(&events->stat_event);
+        add_timed_event(event_system, &events->stat_event);
+    }
+
+    // the send and receive handlers only run when there is data queued
+    h->send_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    h->receive_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (h->send_notify_fd == -1 || h->receive_notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+
+    memset(&events->send_event, 0, sizeof(fd_event));
+    events->send_event.callback = send_notification_event;
+    events->send_event.carry_data = h->send_handle;
+    events->send_event.fd = h->send_notify_fd;
+    enable_fd_event(&events->send_event);
+    add_fd_event(event_system, &events->send_event, EV_READABLE);
+
+    memset(&events->receive_event, 0, sizeof(fd_event));
+    events->receive_event.callback = receive_notification_event;
+    events->receive_event.carry_data = h->receive_handle;
+    events->receive_event.fd = h->receive_notify_fd;
+    enable_fd_event(&events->receive_event);
+    add_fd_event(event_system, &events->receive_event, EV_READABLE);
+
+    memset(&events->submit_event, 0, sizeof(fd_event));
+    events->submit_event.callback = submit_notification_event;
+    events->submit_event.carry_data = h;
+    events->submit_event.fd = h->submit_notify_fd;
+    enable_fd_event(&events->submit_event);
+    add_fd_event(event_system, &events->submit_event, EV_READABLE);
+
+#ifdef ENABLE_OPAQUE
+    memset(&events->kex_event, 0, sizeof(fd_event));
+    if (h->config.values.kex.mode != KEY_EXCHANGE_MODE_NONE) {
+        events->kex_event.callback = kex_completion_event;
+        events->kex_event.carry_data = h;
+        events->kex_event.fd = h->kex_pool.notify_fd;
+        enable_fd_event(&events->kex_event);
+        add_fd_event(event_system, &events->kex_event, EV_READABLE);
+    }
+#endif
+
+    // enabled by the send handler when a connection ran out of send credit
+    memset(&events->send_pacing, 0, sizeof(timed_event));
+    events->send_pacing.callback = send_pacing_event;
+    events->send_pacing.carry_data = h->send_handle;
+    add_timed_event(event_system, &events->send_pacing);
+    h->send_handle->pacing_event = &events->send_pacing;
+
+    memset(&events->retransmit_pacing, 0, sizeof(timed_event));
+    events->retransmit_pacing.callback = retransmit_pacing_event;
+    events->retransmit_pacing.carry_data = h->receive_handle;
+    add_timed_event(event_system, &events->retransmit_pacing);
+    h->receive_handle->retransmit_event = &events->retransmit_pacing;
+
+    if (h->metrics_fd != -1) {
+        add_fd_event(event_system, &h->metrics_event, EV_READABLE);
+    }
+    if (h->reload_signal_fd != -1) {
+        add_fd_event(event_system, &h->reload_event, EV_READABLE);
+    }
+    if (h->replication != NULL) {
+        add_timed_event(event_system, &h->replication->round_event);
+        if (h->replication->listen_event.fd != -1) {
+            add_fd_event(event_system, &h->replication->listen_event, EV_READABLE);
+        }
+        if (h->replication->stream_event.fd != -1) {
+            add_fd_event(event_system, &h->replication->stream_event, EV_READABLE);
+        }
+    }
 
-    // busy wait like io events TODO: move to a position so it is only called when needed
-    memset(&send_event, 0, sizeof(timed_event));
-    send_event.callback = data_send_event;
-    send_event.interval = IO_INTERVAL * 1000lu;
-    send_event.carry_data = h->send_handle;
-    enable_timed_event(&send_event);
-    add_timed_event(event_system, &send_event);
-
-    memset(&receive_event, 0, sizeof(timed_event));
-    receive_event.callback = on_readable_event;
-    receive_event.interval = IO_INTERVAL * 1000lu;
-    receive_event.carry_data = h->receive_handle;
-    enable_timed_event(&receive_event);
-    add_timed_event(event_system, &receive_event);
+    // data might have been queued before the event loop was started
+    rasta_handle_notify(h->send_notify_fd);
+    rasta_handle_notify(h->receive_notify_fd);
+    rasta_handle_notify(h->submit_notify_fd);
 
     // Handshake timeout event
-    init_channel_timeout_events(&channel_timeout_event, &timeout_data, &h->mux, channel_timeout_ms);
+    init_channel_timeout_events(&events->channel_timeout_event, &events->timeout_data, &h->mux, channel_timeout_ms);
     if (channel_timeout_ms) {
-        enable_timed_event(&channel_timeout_event);
+        enable_timed_event(&events->channel_timeout_event);
+    }
+    add_timed_event(event_system, &events->channel_timeout_event);
+
+    // the diagnosis windows of all transport channels end together, so receiving a PDU only counts it
+    init_channel_diagnostics_event(&events->channel_diagnostics, &h->mux);
+    add_timed_event(event_system, &events->channel_diagnostics);
+
+    // PDUs behind a gap that is not filled within T_SEQ are delivered anyway
+    redundancy_mux_start_defer_timers(&h->mux, event_system, h->receive_notify_fd);
+
+    // the sockets are received from by the handle that has them, it hands the PDUs to the handles that share them
+    events->channel_event_count = h->mux.socket_owner == NULL ? h->mux.port_count : 0;
+    events->channel_events = NULL;
+    events->channel_event_data = NULL;
+    if (events->channel_event_count > 0) {
+        events->channel_events = rmalloc(events->channel_event_count * sizeof(fd_event));
+        events->channel_event_data = rmalloc(events->channel_event_count * sizeof(struct receive_event_data));
+    }
+    for (unsigned int i = 0; i < events->channel_event_count; i++) {
+        memset(&events->channel_events[i], 0, sizeof(fd_event));
+        events->channel_events[i].enabled = 1;
+        events->channel_events[i].callback = channel_receive_event;
+        events->channel_events[i].carry_data = events->channel_event_data + i;
+        events->channel_events[i].fd = udp_receive_fd(&h->mux.udp_socket_states[i]);
+        events->channel_event_data[i].channel_index = (int) i;
+        events->channel_event_data[i].event = events->channel_events + i;
+        events->channel_event_data[i].h = h;
     }
-    add_timed_event(event_system, &channel_timeout_event);
+    for (unsigned int i = 0; i < events->channel_event_count; i++) {
+        add_fd_event(event_system, &events->channel_events[i], EV_READABLE);
+    }
+    if (h->mux.socket_owner == NULL) {
+        redundancy_mux_start_transmit_events(&h->mux, event_system);
+    }
+}
 
-    int channel_event_data_len = h->mux.port_count;
-    fd_event channel_events[channel_event_data_len];
-    struct receive_event_data channel_event_data[channel_event_data_len];
-    for (int i = 0; i < channel_event_data_len; i++) {
-        memset(&channel_events[i], 0, sizeof(fd_event));
-        channel_events[i].enabled = 1;
-        channel_events[i].callback = channel_receive_event;
-        channel_events[i].carry_data = channel_event_data + i;
-        channel_events[i].fd = h->mux.udp_socket_states[i].file_descriptor;
-        channel_event_data[i].channel_index = i;
-        channel_event_data[i].event = channel_events + i;
-        channel_event_data[i].h = h;
+/**
+ * removes the events of a handle from an event loop that has ended
+ * @param h the handle
+ * @param event_system the event loop
+ * @param events the events added by sr_attach()
+ * @param primary like in sr_attach()
+ */
+static void sr_detach(struct rasta_handle* h, event_system* event_system, struct sr_loop_events* events, int primary) {
+    // Remove all stack entries from linked lists...
+    remove_fd_event(event_system, &events->send_event);
+    remove_fd_event(event_system, &events->receive_event);
+    remove_fd_event(event_system, &events->submit_event);
+#ifdef ENABLE_OPAQUE
+    if (h->config.values.kex.mode != KEY_EXCHANGE_MODE_NONE) {
+        remove_fd_event(event_system, &events->kex_event);
+    }
+#endif
+    remove_timed_event(event_system, &events->send_pacing);
+    h->send_handle->pacing_event = NULL;
+    remove_timed_event(event_system, &events->retransmit_pacing);
+    h->receive_handle->retransmit_event = NULL;
+    if (h->metrics_fd != -1) {
+        remove_fd_event(event_system, &h->metrics_event);
+    }
+    if (h->reload_signal_fd != -1) {
+        remove_fd_event(event_system, &h->reload_event);
+    }
+    if (h->replication != NULL) {
+        remove_timed_event(event_system, &h->replication->round_event);
+        if (h->replication->listen_event.fd != -1) {
+            remove_fd_event(event_system, &h->replication->listen_event);
+        }
+        if (h->replication->stream_event.fd != -1) {
+            remove_fd_event(event_system, &h->replication->stream_event);
+        }
+    }
+    if (primary) {
+        event_system->lag_histogram = NULL;
+        event_system->busy_poll = 0;
+        event_system->pin_cpu = 0;
+        event_system->realtime_priority = 0;
+        event_system->lock_memory = 0;
+        if (h->config.values.metrics.profile_interval_ms) {
+            remove_timed_event(event_system, &events->profile_event);
+            event_system->profile = NULL;
+        }
+    }
+    if (h->stat_page != NULL) {
+        remove_timed_event(event_system, &events->stat_event);
     }
-    for (int i = 0; i < channel_event_data_len; i++) {
-        add_fd_event(event_system, &channel_events[i], EV_READABLE);
+    remove_timed_event(event_system, &events->channel_timeout_event);
+    remove_timed_event(event_system, &events->channel_diagnostics);
+    redundancy_mux_stop_defer_timers(&h->mux);
+    for (unsigned int i = 0; i < events->channel_event_count; i++) {
+        remove_fd_event(event_system, &events->channel_events[i]);
     }
+    redundancy_mux_stop_transmit_events(&h->mux, event_system);
+    if (events->channel_event_count > 0) {
+        rfree(events->channel_events);
+        rfree(events->channel_event_data);
+    }
+
+    sr_close_notifications(h);
+}
+
+void sr_begin(struct rasta_handle* h, event_system* event_system, int channel_timeout_ms) {
+    struct sr_loop_events events;
+    // the memory the loop takes comes from the node of the handle
+    struct rmemory_placement previous_placement = rmemory_set_thread_placement(h->placement);
+    sr_attach(h, event_system, channel_timeout_ms, &events, 1);
 
     log_main_loop_state(h, event_system, "event-system started");
     event_system_start(event_system);
 
-    // Remove all stack entries from linked lists...
-    remove_timed_event(event_system, &send_event);
-    remove_timed_event(event_system, &receive_event);
-    remove_timed_event(event_system, &channel_timeout_event);
-    for (int i = 0; i < channel_event_data_len; i++) {
-        remove_fd_event(event_system, &channel_events[i]);
+    sr_detach(h, event_system, &events, 1);
+    rmemory_set_thread_placement(previous_placement);
+}
+
+void sr_begin_shared(struct rasta_handle** handles, unsigned int count, event_system* event_system,
+                     int channel_timeout_ms) {
+    struct rmemory_placement previous_placement = rmemory_set_thread_placement(handles[0]->placement);
+    struct sr_loop_events * events = rmalloc(count * sizeof(struct sr_loop_events));
+    for (unsigned int i = 0; i < count; i++) {
+        sr_attach(handles[i], event_system, channel_timeout_ms, &events[i], i == 0);
+    }
+
+    log_main_loop_state(handles[0], event_system, "event-system started");
+    event_system_start(event_system);
+
+    for (unsigned int i = count; i > 0; i--) {
+        sr_detach(handles[i - 1], event_system, &events[i - 1], i == 1);
     }
+    rfree(events);
+    rmemory_set_thread_placement(previous_placement);
 }
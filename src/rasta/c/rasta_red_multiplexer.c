@@ -1,18 +1,27 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_REDUNDANCY
 #include <rasta_red_multiplexer.h>
 #include <rastaredundancy_new.h>
 #include <string.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <syscall.h>
 #include <event_system.h>
 #include "rastahandle.h"
+#include "rasta_new.h"
 #include "event_system.h"
 #include "rmemory.h"
 #include "udp.h"
+#include "udpimpairment.h"
 #include "rastautil.h"
+#include "rastatrace.h"
+#include "rastaprobes.h"
+
+// the redundancy header has 8 bytes, the sender id is at byte 8 of the SR layer PDU
+#define RED_PDU_SENDER_ID_OFFSET 16
 
 /* --- Notifications --- */
 
@@ -66,6 +75,12 @@ struct new_connection_notification_parameter_wrapper{
     unsigned long id;
 };
 
+// the notifications are copied into the records of the callback executor
+_Static_assert(sizeof(struct diagnose_notification_parameter_wrapper) <= RASTA_CALLBACK_RECORD_MIN_SIZE,
+               "a redundancy diagnosis fits into a callback record");
+_Static_assert(sizeof(struct new_connection_notification_parameter_wrapper) <= RASTA_CALLBACK_RECORD_MIN_SIZE,
+               "a new redundancy channel fits into a callback record");
+
 /**
  * the is the function that handles the call of the onDiagnosticsAvailable notification pointer.
  * this runs on the main thread
@@ -77,7 +92,11 @@ void red_on_new_connection_caller(struct new_connection_notification_parameter_w
     logger_log(&w->mux->logger, LOG_LEVEL_DEBUG, "RaSTA Redundancy onNewConnection caller", "calling onNewConnection function");
     (*w->mux->notifications.on_new_connection)(w->mux, w->id);
 
-    w->mux->notifications_running = (unsigned short)(w->mux->notifications_running -1);
+    __atomic_sub_fetch(&w->mux->notifications_running, 1, __ATOMIC_RELAXED);
+}
+
+static void red_run_on_new_connection(void * record) {
+    red_on_new_connection_caller(record);
 }
 
 /**
@@ -92,15 +111,17 @@ void red_call_on_new_connection(redundancy_mux * mux, unsigned long id){
         return;
     }
 
-    mux->notifications_running++;
+    __atomic_add_fetch(&mux->notifications_running, 1, __ATOMIC_RELAXED);
 
-    struct new_connection_notification_parameter_wrapper* wrapper =
-            rmalloc(sizeof(struct new_connection_notification_parameter_wrapper));
-    wrapper->mux = mux;
-    wrapper->id = id;
+    struct new_connection_notification_parameter_wrapper wrapper;
+    wrapper.mux = mux;
+    wrapper.id = id;
 
-    red_on_new_connection_caller(wrapper);
-    free(wrapper);
+    if (mux->callback_executor != NULL) {
+        rasta_callback_executor_submit(mux->callback_executor, red_run_on_new_connection, &wrapper, sizeof(wrapper));
+        return;
+    }
+    red_on_new_connection_caller(&wrapper);
 
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA Redundancy call onNewConnection", "called onNewConnection");
 }
@@ -116,10 +137,14 @@ void red_on_diagnostic_caller(struct diagnose_notification_parameter_wrapper * w
     logger_log(&w->mux->logger, LOG_LEVEL_DEBUG, "RaSTA Redundancy onDiagnostics caller", "calling onDiagnostics function");
     (*w->mux->notifications.on_diagnostics_available)(w->mux, w->n_diagnose, w->n_missed, w->t_drift, w->t_drift2, w->channel_id);
 
-    w->mux->notifications_running = (unsigned short)(w->mux->notifications_running -1);
+    __atomic_sub_fetch(&w->mux->notifications_running, 1, __ATOMIC_RELAXED);
 
 }
 
+static void red_run_on_diagnostic(void * record) {
+    red_on_diagnostic_caller(record);
+}
+
 /**
  * fires the onDiagnoseAvailable event.
  * This implementation will take care if the function pointer is NULL and start a thread to call the notification
@@ -137,7 +162,7 @@ void red_call_on_diagnostic(redundancy_mux * mux, int n_diagnose,
         return;
     }
 
-    mux->notifications_running++;
+    __atomic_add_fetch(&mux->notifications_running, 1, __ATOMIC_RELAXED);
 
     struct diagnose_notification_parameter_wrapper wrapper;
     wrapper.mux = mux;
@@ -147,6 +172,10 @@ void red_call_on_diagnostic(redundancy_mux * mux, int n_diagnose,
     wrapper.t_drift2 = t_drift2;
     wrapper.channel_id = id;
 
+    if (mux->callback_executor != NULL) {
+        rasta_callback_executor_submit(mux->callback_executor, red_run_on_diagnostic, &wrapper, sizeof(wrapper));
+        return;
+    }
     red_on_diagnostic_caller(&wrapper);
 
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA Redundancy call onDiagnostics", "called onDiagnostics");
@@ -157,177 +186,672 @@ void red_call_on_diagnostic(redundancy_mux * mux, int n_diagnose,
 /* --------------------- */
 
 /**
- * received data on a UDP socket
- * @param mux the multiplexer that is used
- * @param channel_id the index of the udp socket
+ * initial amount of slots of the redundancy channel array
  */
-void receive_packet(redundancy_mux * mux, int channel_id){
-    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "Receive called");
+#define MUX_CHANNEL_MIN_CAPACITY 16
 
-    // receive a packet
-    unsigned char * buffer = rmalloc(sizeof(unsigned char) * MAX_DEFER_QUEUE_MSG_SIZE);
+/**
+ * stores a redundancy channel in the multiplexer. The channel is allocated separately, so pointers to it stay valid
+ * until it is removed
+ * @param mux the multiplexer
+ * @param channel the channel to store
+ * @return the stored channel
+ */
+static rasta_redundancy_channel * redundancy_mux_store_channel(redundancy_mux * mux, rasta_redundancy_channel channel) {
+    if (mux->channel_count == mux->channel_capacity) {
+        mux->channel_capacity *= 2;
+        mux->connected_channels = rrealloc(mux->connected_channels, mux->channel_capacity * sizeof(rasta_redundancy_channel *));
+    }
 
-    // the sender of the received packet
-    struct sockaddr_in sender;
+    rasta_redundancy_channel * stored = rmalloc(sizeof(rasta_redundancy_channel));
+    *stored = channel;
 
-    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d waiting for data on fd %d...", channel_id, mux->udp_socket_states[channel_id].file_descriptor);
+    mux->connected_channels[mux->channel_count] = stored;
+    mux->channel_count++;
+    rasta_id_index_put(&mux->channel_index, stored->associated_id, stored);
+    return stored;
+}
 
-    // wait for pdu
-    size_t len = udp_receive(&mux->udp_socket_states[channel_id], buffer, MAX_DEFER_QUEUE_MSG_SIZE, &sender);
-    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d received data on upd", channel_id);
-    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d received data len = %lu", channel_id, len);
+/**
+ * allocates the redundancy channel array and the id index of a new multiplexer
+ * @param mux the multiplexer
+ */
+static void redundancy_mux_init_channels(redundancy_mux * mux) {
+    mux->channel_capacity = MUX_CHANNEL_MIN_CAPACITY;
+    mux->connected_channels = rmalloc(mux->channel_capacity * sizeof(rasta_redundancy_channel *));
+    mux->channel_count = 0;
+    mux->next_retrieve_index = 0;
+    mux->ev_sys = NULL;
+    mux->receive_notify_fd = -1;
+    mux->socket_owner = NULL;
+    mux->members = NULL;
+    mux->member_count = 0;
+    mux->transmit_events = NULL;
+    mux->pending_channels = NULL;
+    mux->pending_count = 0;
+    mux->pending_evictions = 0;
+    mux->pending_drops = 0;
+
+    rasta_id_index_init(&mux->channel_index);
+    rasta_id_index_init(&mux->member_index);
+}
 
-    if(!len){
-        return;
+/**
+ * removes the defer timer of a channel from the event system, if it was added
+ * @param channel the channel
+ */
+static void redundancy_mux_remove_defer_timer(rasta_redundancy_channel * channel) {
+    if (channel->defer_timeout_event.ev_sys != NULL) {
+        remove_timed_event(channel->defer_timeout_event.ev_sys, &channel->defer_timeout_event);
     }
+    channel->defer_timeout_event.enabled = 0;
+}
 
-    struct RastaByteArray incomingData;
-    incomingData.length = (unsigned int)len;
-    incomingData.bytes = buffer;
-
-    rasta_hashing_context_t test;
-    struct crc_options options;
-
-    test.hash_length = mux->sr_hashing_context.hash_length;
-    test.algorithm = mux->sr_hashing_context.algorithm;
-    allocateRastaByteArray(&test.key, mux->sr_hashing_context.key.length);
-    rmemcpy(test.key.bytes, mux->sr_hashing_context.key.bytes, mux->sr_hashing_context.key.length);
-    rmemcpy(&options, &mux->config.redundancy.crc_type, sizeof(mux->config.redundancy.crc_type));
+/**
+ * processes a PDU that was received on a UDP socket
+ * @param mux the multiplexer that is used
+ * @param channel_id the index of the udp socket
+ * @param receivedPacket the decoded datagram, only valid until the next batch is received
+ * @param sender the sender of the datagram
+ */
+/**
+ * removes a channel from the pending channels of the multiplexer, if it is one of them
+ * @param mux the multiplexer
+ * @param channel the channel
+ */
+static void redundancy_mux_forget_pending(redundancy_mux * mux, rasta_redundancy_channel * channel) {
+    for (unsigned int i = 0; i < mux->pending_count; i++) {
+        if (mux->pending_channels[i] == channel) {
+            // the order does not matter, the eviction looks at the times
+            mux->pending_channels[i] = mux->pending_channels[--mux->pending_count];
+            break;
+        }
+    }
+    channel->pending = 0;
+}
 
-    struct RastaRedundancyPacket receivedPacket = bytesToRastaRedundancyPacket(incomingData,
-            options, &test);
+/**
+ * evicts the least recently active pending channel if the table of pending channels is full
+ * @param mux the multiplexer that is about to add a pending channel
+ */
+static void redundancy_mux_make_room_for_pending(redundancy_mux * mux) {
+    unsigned int max = mux->config.redundancy.max_pending_channels;
+    if (max == 0 || mux->pending_count < max) {
+        return;
+    }
 
-    freeRastaByteArray(&test.key);
+    rasta_redundancy_channel * oldest = mux->pending_channels[0];
+    for (unsigned int i = 1; i < mux->pending_count; i++) {
+        // the times are compared as a difference, they wrap around
+        if ((int32_t) (mux->pending_channels[i]->last_received - oldest->last_received) < 0) {
+            oldest = mux->pending_channels[i];
+        }
+    }
 
+    logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux receive", "evicting pending channel of unknown entity 0x%lX",
+               oldest->associated_id);
+    rasta_metrics_add(&mux->pending_evictions, 1);
+    redundancy_mux_remove_channel(mux, oldest->associated_id);
+}
 
-    rasta_transport_channel connected_channel;
-    connected_channel.ip_address = rmalloc(sizeof(char) * 15);
-    sockaddr_to_host(sender,connected_channel.ip_address);
-    connected_channel.port = ntohs(sender.sin_port);
+/**
+ * adds a channel that was created for an unknown sender to the pending channels
+ * @param mux the multiplexer
+ * @param channel the new channel, redundancy_mux_make_room_for_pending() made room for it
+ */
+static void redundancy_mux_add_pending(redundancy_mux * mux, rasta_redundancy_channel * channel) {
+    unsigned int max = mux->config.redundancy.max_pending_channels;
+    channel->pending = 1;
+    if (max == 0) {
+        return;
+    }
+    if (mux->pending_channels == NULL) {
+        mux->pending_channels = rmalloc(max * sizeof(rasta_redundancy_channel *));
+    }
+    mux->pending_channels[mux->pending_count++] = channel;
+}
 
-    // find assiociated redundancy channel
-    for (unsigned int i = 0; i < mux->channel_count; ++i) {
-        if (receivedPacket.data.sender_id == mux->connected_channels[i].associated_id){
-            // found redundancy channel with associated id
-            // need to check if redundancy channel already knows ip & port of sender
-            rasta_redundancy_channel channel = mux->connected_channels[i];
-            if (channel.connected_channel_count < mux->port_count){
-                // not all remote transport channel endpoints discovered
-
-                int is_channel_saved= 0;
-
-                for (unsigned int j = 0; j < channel.connected_channel_count; ++j) {
-                    if (channel.connected_channels[j].port == connected_channel.port &&
-                        strcmp(connected_channel.ip_address, channel.connected_channels[j].ip_address) == 0){
-                        // channel is already saved
-                        is_channel_saved = 1;
-                    }
-                }
+/**
+ * checks if a PDU of a pending channel exceeds the PDUs an unknown sender may hand to the SR layer
+ * @param mux the multiplexer of the channel
+ * @param channel the channel
+ * @return 1 if the PDU is dropped, 0 otherwise
+ */
+static int redundancy_mux_pending_limit_reached(redundancy_mux * mux, const rasta_redundancy_channel * channel) {
+    unsigned int limit = mux->config.redundancy.pending_pdu_limit;
+    if (!channel->pending || limit == 0 || channel->pending_pdus < limit) {
+        return 0;
+    }
+    rasta_metrics_add(&mux->pending_drops, 1);
+    return 1;
+}
 
-                if (!is_channel_saved){
-                    // channel wasn't saved yet -> add to list
-                    mux->connected_channels[i].connected_channels[channel.connected_channel_count].ip_address = connected_channel.ip_address;
-                    mux->connected_channels[i].connected_channels[channel.connected_channel_count].port = connected_channel.port;
-                    mux->connected_channels[i].connected_channel_count++;
+void redundancy_mux_confirm_channel(redundancy_mux * mux, unsigned long id) {
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(mux, id);
+    if (channel != NULL && channel->pending) {
+        redundancy_mux_forget_pending(mux, channel);
+    }
+}
 
-                    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d discovered client transport channel %s:%d for connection to 0x%lX",
-                               channel_id, connected_channel.ip_address, connected_channel.port, channel.associated_id);
-                } else {
-                    // temp channel no longer needed -> free memory
-                    rfree(connected_channel.ip_address);
-                }
-            }
+/**
+ * creates the transport channel of a remote endpoint that sent a datagram
+ * @param sender the address of the endpoint
+ * @return the transport channel
+ */
+static rasta_transport_channel discovered_transport_channel(struct sockaddr_in sender){
+    rasta_transport_channel transport_channel;
+    memset(&transport_channel, 0, sizeof(transport_channel));
+    transport_channel.ip_address = rmalloc(IPV4_STR_LEN);
+    sockaddr_to_host(sender, transport_channel.ip_address);
+    transport_channel.port = ntohs(sender.sin_port);
+    transport_channel.address = sender;
+    transport_channel.endpoint = sockaddr_to_endpoint(&sender);
+    return transport_channel;
+}
 
+/**
+ * counts a PDU that was sent on a udp socket
+ * @param mux the multiplexer that is used
+ * @param path the index of the udp socket
+ * @param length the length of the PDU
+ */
+static void redundancy_mux_count_path_out(redundancy_mux * mux, unsigned int path, unsigned int length){
+    if (path < mux->port_count) {
+        rasta_metrics_add(&mux->path_metrics[path].pdus_out, 1);
+        rasta_metrics_add(&mux->path_metrics[path].bytes_out, length);
+    }
+}
 
-            // call the receive function of the associated channel
-            /*logger_log(&mux->logger, LOG_LEVEL_DEBUG, "MUX", "count=%d", mux->channel_count);
-            for (int k = 0; k < mux->channel_count; ++k) {
-                logger_log(&mux->logger, LOG_LEVEL_DEBUG, "MUX", "channel %d, id=%0x%lX", i, mux->connected_channels[i].associated_id);
-            }*/
-            rasta_red_f_receive(redundancy_mux_get_channel(mux, receivedPacket.data.sender_id), receivedPacket, channel_id);
+static void handle_received_pdu(redundancy_mux * mux, int channel_id, const struct RastaRedundancyPacketView * receivedPacket,
+                                struct sockaddr_in sender, uint32_t received_at, uint64_t received_ns){
+    // find assiociated redundancy channel
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(mux, receivedPacket->data.sender_id);
+    if (channel != NULL){
+        // an unknown sender only gets to hand a few PDUs to the SR layer before it is accepted
+        if (redundancy_mux_pending_limit_reached(mux, channel)){
+            return;
+        }
+        if (channel->pending){
+            channel->pending_pdus++;
+            channel->last_received = received_at;
+        }
 
-            rfree(buffer);
+        // found redundancy channel with associated id, the PDU belongs to the transport channel of the socket it
+        // arrived on
+        int transport = rasta_red_path_channel(channel, (unsigned int) channel_id);
+        if (transport < 0 && channel->connected_channel_count < channel->transport_channel_count){
+            // the first PDU on this socket discovers the remote transport channel endpoint
+            transport = (int) rasta_red_bind_transport_channel(channel, discovered_transport_channel(sender),
+                                                               (unsigned int) channel_id);
+            rasta_transport_channel * discovered = &channel->connected_channels[transport];
+            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d discovered client transport channel %s:%d for connection to 0x%lX",
+                       channel_id, discovered->ip_address, discovered->port, channel->associated_id);
+        }
+        if (transport < 0){
+            logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux receive", "channel %d has no transport channel for connection to 0x%lX",
+                       channel_id, channel->associated_id);
             return;
         }
+
+        // call the receive function of the associated channel
+        rasta_red_f_receive_view(channel, receivedPacket, transport, received_at, received_ns);
+        redundancy_mux_arm_defer_timer(mux, channel);
+        return;
     }
 
     // no associated channel found -> received message from new partner
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux receive", "received pdu from unknown entity with id=0x%lX",
-        (long unsigned int) receivedPacket.data.sender_id);
-    rasta_redundancy_channel new_channel = rasta_red_init(mux->logger, mux->config, mux->port_count, receivedPacket.data.sender_id);
-    new_channel.associated_id = receivedPacket.data.sender_id;
+        (long unsigned int) receivedPacket->data.sender_id);
+    rasta_redundancy_channel new_channel = rasta_red_init(mux->logger, mux->config, mux->port_count, receivedPacket->data.sender_id);
+    new_channel.associated_id = receivedPacket->data.sender_id;
     // add transport channel to redundancy channel
-    new_channel.connected_channels[0].ip_address = connected_channel.ip_address;
-    new_channel.connected_channels[0].port= connected_channel.port;
-    new_channel.connected_channel_count++;
+    rasta_red_bind_transport_channel(&new_channel, discovered_transport_channel(sender), (unsigned int) channel_id);
 
     new_channel.is_open = 1;
+    new_channel.pending_pdus = 1;
+    new_channel.last_received = received_at;
 
-    //reallocate memory for new client
-    mux->connected_channels = rrealloc(mux->connected_channels, (mux->channel_count + 1) * sizeof(rasta_redundancy_channel));
-
-    mux->connected_channels[mux->channel_count] = new_channel;
-    mux->channel_count++;
+    // the channels of unknown senders are bounded, the least recently active one makes room
+    redundancy_mux_make_room_for_pending(mux);
+    rasta_redundancy_channel * stored = redundancy_mux_store_channel(mux, new_channel);
+    redundancy_mux_add_pending(mux, stored);
 
     // fire new redundancy channel notification
-    red_call_on_new_connection(mux, new_channel.associated_id);
+    red_call_on_new_connection(mux, stored->associated_id);
+
+    // call receive function of new channel, the notification might have removed it again
+    stored = redundancy_mux_get_channel(mux, receivedPacket->data.sender_id);
+    if (stored != NULL) {
+        rasta_red_f_receive_view(stored, receivedPacket, rasta_red_path_channel(stored, (unsigned int) channel_id),
+                                 received_at, received_ns);
+        redundancy_mux_arm_defer_timer(mux, stored);
+    }
+}
 
-    // call receive function of new channel
-    rasta_red_f_receive(redundancy_mux_get_channel(mux, new_channel.associated_id), receivedPacket, channel_id);
+/**
+ * the multiplexer of the RaSTA entity a received PDU is addressed to
+ * @param mux the multiplexer that received the PDU
+ * @param receiver_id the receiver of the PDU
+ * @return the member with the RaSTA ID, @p mux itself if there is none. Its SR layer discards the PDU then
+ */
+static redundancy_mux * redundancy_mux_receiver(redundancy_mux * mux, unsigned long receiver_id) {
+    if (mux->member_count == 0 || receiver_id == mux->config.general.rasta_id) {
+        return mux;
+    }
+    redundancy_mux * member = rasta_id_index_get(&mux->member_index, receiver_id);
+    return member != NULL ? member : mux;
+}
 
-    // free receive buffer
-    rfree(buffer);
+/**
+ * wakes up the SR layers of a multiplexer and its members if PDUs were delivered to their receive queues
+ * @param mux the multiplexer that received the PDUs
+ */
+static void redundancy_mux_notify_receivers(redundancy_mux * mux) {
+    if (mux->receive_notify_fd != -1 && redundancy_mux_data_available(mux)) {
+        rasta_handle_notify(mux->receive_notify_fd);
+    }
+    for (unsigned int i = 0; i < mux->member_count; i++) {
+        redundancy_mux * member = mux->members[i];
+        if (member->receive_notify_fd != -1 && redundancy_mux_data_available(member)) {
+            rasta_handle_notify(member->receive_notify_fd);
+        }
+    }
 }
 
-int channel_receive_event(void * carry_data) {
-    struct receive_event_data * data = carry_data;
-    struct rasta_handle * h = data->h;
-    unsigned int mux_channel_count = h->mux.channel_count;
+/**
+ * records the time a stage of the receive path took for a batch and starts the time of the next stage
+ * @param mux the multiplexer that received the batch
+ * @param stage the stage that is done
+ * @param pdus the amount of PDUs the stage processed
+ * @param started the time the stage started, set to the current time
+ * @return the time the stage took in nanoseconds
+ */
+static unsigned long receive_stage_done(redundancy_mux * mux, rasta_receive_stage stage, unsigned int pdus,
+                                        evtime_t * started) {
+    evtime_t now = get_nanotime();
+    unsigned long duration = (unsigned long) (now - *started);
+    rasta_receive_stage_record(&mux->receive_stages, stage, pdus, duration);
+    *started = now;
+    return duration;
+}
 
-    for (unsigned int i = 0; i < mux_channel_count; ++i) {
-        rasta_redundancy_channel current = h->mux.connected_channels[i];
-        int n_diagnose = h->mux.config.redundancy.n_diagnose;
+/**
+ * receives a batch of the PDUs that are queued on a UDP socket with a single syscall and processes them. Every stage
+ * of the receive path handles the whole batch before the next one starts: draining the socket, checking the CRC
+ * checksums, checking the safety codes and handing the PDUs to their redundancy channels
+ * @param mux the multiplexer that is used
+ * @param channel_id the index of the udp socket
+ */
+static void receive_batch(redundancy_mux * mux, int channel_id){
+    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "Receive called");
 
-        unsigned long channel_diag_start_time = current.connected_channels[data->channel_index].diagnostics_data.start_time;
+    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d waiting for data on fd %d...", channel_id, mux->udp_socket_states[channel_id].file_descriptor);
 
-        if (current_ts() - channel_diag_start_time >= (unsigned long)n_diagnose){
-            // increase n_missed by amount of messages that are not received
+    // wait for pdus
+    evtime_t started = get_nanotime();
+    unsigned int count = udp_receive_batch(&mux->udp_socket_states[channel_id], &mux->receive_batch);
+    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d received %u datagrams on udp", channel_id, count);
+    if (count == 0) {
+        return;
+    }
 
-            // amount of missed packets
-            int missed_count = current.diagnostics_packet_buffer.count -
-                    current.connected_channels[data->channel_index].diagnostics_data.received_packets;
+    // the kernel stamps are in CLOCK_REALTIME, the offset to the monotonic clock of current_ts() is taken once per batch
+    evtime_t realtime_offset = 0;
+    if (mux->config.redundancy.receive_timestamps) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        realtime_offset = (evtime_t) now.tv_sec * 1000000000ull + (evtime_t) now.tv_nsec - get_nanotime();
+    }
 
-            // increase n_missed
-            current.connected_channels[data->channel_index].diagnostics_data.n_missed += missed_count;
+    unsigned char * buffers[UDP_RECEIVE_BATCH_SIZE];
+    unsigned int lengths[UDP_RECEIVE_BATCH_SIZE];
+    struct sockaddr_in senders[UDP_RECEIVE_BATCH_SIZE];
+    uint32_t received_ats[UDP_RECEIVE_BATCH_SIZE];
+    unsigned int kept = 0;
+    unsigned long batch_bytes = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        size_t len;
+        unsigned char * buffer = udp_receive_batch_get(&mux->receive_batch, i, &len, &senders[kept]);
+        batch_bytes += len;
+        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive", "channel %d received data len = %lu", channel_id, len);
+
+        uint64_t stamp = udp_receive_batch_get_timestamp(&mux->receive_batch, i);
+        uint32_t received_at = stamp != 0 ? (uint32_t) ((stamp - realtime_offset) / NS_PER_MS) : current_ts();
+
+        // with several transport channels every PDU arrives more than once. The copies of PDUs that were received on
+        // another channel already are recognized by their sequence number, only their CRC checksum is checked before
+        // they are counted on the transport channel. A damaged copy is decoded like any other PDU, so it counts as a
+        // checksum error and not in the diagnostics
+        uint32_t sequence_number, receiver_id, sender_id;
+        if (rastaRedundancyPacketPeek(buffer, (unsigned int) len, &sequence_number, &receiver_id, &sender_id)) {
+            redundancy_mux * receiver = redundancy_mux_receiver(mux, receiver_id);
+            rasta_redundancy_channel * channel = redundancy_mux_get_channel(receiver, sender_id);
+            if (channel != NULL && redundancy_mux_pending_limit_reached(receiver, channel)) {
+                continue;
+            }
+            // a copy on an unknown transport channel still has to be decoded, it discovers the endpoint
+            int transport = channel != NULL ? rasta_red_path_channel(channel, (unsigned int) channel_id) : -1;
+            if (transport >= 0 && rasta_red_f_known_duplicate(channel, sequence_number)) {
+                unsigned int length = (unsigned int) len;
+                struct RastaRedundancyPacketView view;
+                int decoded;
+                if (rastaRedundancyPacketViewsCheckCrc(&buffer, &length, 1, &mux->config.redundancy.crc_type,
+                                                       &mux->sr_hashing_context, &view, &decoded) == 1 &&
+                    rasta_red_f_receive_duplicate(channel, sequence_number, length, transport, received_at)) {
+                    continue;
+                }
+            }
+        }
 
-            // window finished, fire event
-            // fire diagnostic notification
-            red_call_on_diagnostic(&h->mux,
-                                    h->mux.config.redundancy.n_diagnose,
-                                    current.connected_channels[data->channel_index].diagnostics_data.n_missed,
-                                    current.connected_channels[data->channel_index].diagnostics_data.t_drift,
-                                    current.connected_channels[data->channel_index].diagnostics_data.t_drift2,
-                                    current.associated_id);
+        buffers[kept] = buffer;
+        lengths[kept] = (unsigned int) len;
+        received_ats[kept] = received_at;
+        kept++;
+    }
+    rasta_metrics_add(&mux->path_metrics[channel_id].pdus_in, count);
+    rasta_metrics_add(&mux->path_metrics[channel_id].bytes_in, batch_bytes);
+    receive_stage_done(mux, RASTA_RECEIVE_STAGE_DRAIN, count, &started);
+    evtime_t dequeued_ns = started;
+    rasta_receive_stage_reject(&mux->receive_stages, RASTA_RECEIVE_STAGE_DRAIN, count - kept);
+    if (kept == 0) {
+        return;
+    }
 
-            // reset values
-            current.connected_channels[data->channel_index].diagnostics_data.n_missed = 0;
-            current.connected_channels[data->channel_index].diagnostics_data.received_packets = 0;
-            current.connected_channels[data->channel_index].diagnostics_data.t_drift = 0;
-            current.connected_channels[data->channel_index].diagnostics_data.t_drift2 = 0;
-            current.connected_channels[data->channel_index].diagnostics_data.start_time = current_ts();
+    // decode in place, the SR layer PDU is only copied if a redundancy channel keeps it. The decoding contexts of the
+    // mux are prepared once and not modified afterwards
+    struct RastaRedundancyPacketView views[UDP_RECEIVE_BATCH_SIZE];
+    int decoded[UDP_RECEIVE_BATCH_SIZE];
+    unsigned int pending = rastaRedundancyPacketViewsCheckCrc(buffers, lengths, kept, &mux->config.redundancy.crc_type,
+                                                              &mux->sr_hashing_context, views, decoded);
+    receive_stage_done(mux, RASTA_RECEIVE_STAGE_CRC, kept, &started);
+    rasta_receive_stage_reject(&mux->receive_stages, RASTA_RECEIVE_STAGE_CRC, kept - pending);
+
+    // the redundancy channels discard PDUs with an implausible sequence number without looking at their safety code.
+    // A PDU of an unknown partner is checked, the SR layer decides on it
+    int verify[UDP_RECEIVE_BATCH_SIZE];
+    unsigned int plausible = 0;
+    for (unsigned int i = 0; i < kept; i++) {
+        verify[i] = decoded[i] && views[i].data.length != 0 && views[i].checksum_correct;
+        if (!verify[i]) {
+            continue;
+        }
+        rasta_redundancy_channel * channel = redundancy_mux_get_channel(
+            redundancy_mux_receiver(mux, views[i].data.receiver_id), views[i].data.sender_id);
+        if (channel != NULL && !rasta_red_f_sequence_plausible(channel, views[i].sequence_number)) {
+            verify[i] = 0;
+            continue;
+        }
+        plausible++;
+    }
+    if (pending > 0) {
+        receive_stage_done(mux, RASTA_RECEIVE_STAGE_PLAUSIBILITY, pending, &started);
+        rasta_receive_stage_reject(&mux->receive_stages, RASTA_RECEIVE_STAGE_PLAUSIBILITY, pending - plausible);
+    }
+
+    // the safety codes of the batch are checked together
+    if (plausible > 0) {
+        rastaRedundancyPacketViewsCheckSafetyCode(buffers, kept, &mux->sr_hashing_context, views, verify);
+        unsigned long duration = receive_stage_done(mux, RASTA_RECEIVE_STAGE_SAFETY_CODE, plausible, &started);
+
+        // the PDUs are checked together, every one of them costs its sender an equal share
+        unsigned long share = duration / plausible;
+        for (unsigned int i = 0; i < kept; i++) {
+            if (!verify[i]) {
+                continue;
+            }
+            rasta_redundancy_channel * channel = redundancy_mux_get_channel(
+                redundancy_mux_receiver(mux, views[i].data.receiver_id), views[i].data.sender_id);
+            if (channel != NULL) {
+                rasta_metrics_add(&channel->safety_code_ns, share);
+            }
+        }
+    }
 
-            deferqueue_clear(&current.diagnostics_packet_buffer);
+    unsigned int sequenced = 0;
+    for (unsigned int i = 0; i < kept; i++) {
+        if (!decoded[i] || views[i].data.length == 0){
+            logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux receive", "channel %d discarding pdu with invalid length", channel_id);
+            continue;
+        }
+        if (!views[i].checksum_correct) {
+            rasta_metrics_add(&mux->path_metrics[channel_id].checksum_errors, 1);
         }
 
-        // channel count might have changed due to removal of channels
-        mux_channel_count = h->mux.channel_count;
+        // the sockets may be shared by several entities, every PDU goes to the multiplexer of its receiver
+        redundancy_mux * receiver = redundancy_mux_receiver(mux, views[i].data.receiver_id);
+        if (views[i].checksum_correct && !verify[i]) {
+            // the PDUs in front of it may have made room for it in the meantime, its safety code is checked late then
+            rasta_redundancy_channel * channel = redundancy_mux_get_channel(receiver, views[i].data.sender_id);
+            if (channel == NULL || rasta_red_f_sequence_plausible(channel, views[i].sequence_number)) {
+                int late = 1;
+                rastaRedundancyPacketViewsCheckSafetyCode(&buffers[i], 1, &mux->sr_hashing_context, &views[i], &late);
+            }
+        }
+        handle_received_pdu(receiver, channel_id, &views[i], senders[i], received_ats[i], dequeued_ns);
+        sequenced++;
     }
+    receive_stage_done(mux, RASTA_RECEIVE_STAGE_SEQUENCING, sequenced, &started);
+}
+
+void receive_packet(redundancy_mux * mux, int channel_id){
+    // the datagrams that UDP_GRO coalesced may hold more PDUs than a batch, the batch is shared by all sockets
+    do {
+        receive_batch(mux, channel_id);
+    } while (udp_receive_batch_pending(&mux->receive_batch));
+}
+
+int channel_receive_event(void * carry_data) {
+    struct receive_event_data * data = carry_data;
+    struct rasta_handle * h = data->h;
 
     logger_log(&h->mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive thread", "Thread %d calling receive",
                 data->channel_index);
     receive_packet(&h->mux, data->channel_index);
     logger_log(&h->mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux receive thread", "Thread %d receive done",
                 data->channel_index);
+
+    // wake up the SR layers whose receive queues got PDUs
+    redundancy_mux_notify_receivers(&h->mux);
+    return 0;
+}
+
+void redundancy_mux_diagnose(redundancy_mux * mux) {
+    int n_diagnose = mux->config.redundancy.n_diagnose;
+
+    // the channel count is read in every iteration, a notification might remove channels
+    for (unsigned int i = 0; i < mux->channel_count; ++i) {
+        rasta_redundancy_channel * current = mux->connected_channels[i];
+        unsigned long associated_id = current->associated_id;
+        unsigned int first_received = current->diagnostics_arrivals.count;
+
+        // the delays of the window are complete, the defer timer waits for the skew they show
+        rasta_red_adapt_defer_timeout(current);
+
+        for (unsigned int j = 0; j < current->connected_channel_count; ++j) {
+            rasta_redundancy_diagnostics_data * diagnostics = &current->connected_channels[j].diagnostics_data;
+
+            // increase n_missed by the amount of packets that were received on other channels but not on this one
+            diagnostics->n_missed += (int) first_received - diagnostics->received_packets;
+            if (first_received > 0 && diagnostics->received_packets == 0 && mux->on_transport_failure != NULL) {
+                mux->on_transport_failure(mux->transport_failure_context, associated_id,
+                                          current->connected_channels[j].path);
+            }
+
+            // missed PDUs that the kernel dropped because the socket was not read fast enough
+            unsigned int path = current->connected_channels[j].path;
+            if (path < mux->port_count) {
+                uint64_t socket_drops = mux->udp_socket_states[path].kernel_drops;
+                diagnostics->kernel_drops = (unsigned long) (socket_drops - diagnostics->kernel_drops_start);
+                diagnostics->kernel_drops_start = socket_drops;
+                if (diagnostics->kernel_drops > 0) {
+                    logger_log(&mux->logger, LOG_LEVEL_ERROR, "RaSTA RedMux diagnose",
+                               "the receive buffer of transport channel %u dropped %lu datagrams", path + 1,
+                               diagnostics->kernel_drops);
+                }
+            }
+
+            // window finished, fire diagnostic notification
+            red_call_on_diagnostic(mux, n_diagnose, diagnostics->n_missed, diagnostics->t_drift,
+                                   diagnostics->t_drift2, associated_id);
+
+            if (i >= mux->channel_count || mux->connected_channels[i] != current) {
+                break;
+            }
+
+            // reset values
+            diagnostics->n_missed = 0;
+            diagnostics->received_packets = 0;
+            diagnostics->t_drift = 0;
+            diagnostics->t_drift2 = 0;
+            diagnostics->drift_samples = 0;
+            diagnostics->start_time = current_ts();
+        }
+
+        if (i >= mux->channel_count || mux->connected_channels[i] != current) {
+            // the channel was removed by the notification, the next channel moved to this index
+            --i;
+            continue;
+        }
+        rasta_arrival_ring_clear(&current->diagnostics_arrivals);
+    }
+}
+
+int channel_diagnostics_event(void * carry_data) {
+    redundancy_mux_diagnose(carry_data);
+    return 0;
+}
+
+void init_channel_diagnostics_event(timed_event * event, struct redundancy_mux * mux) {
+    memset(event, 0, sizeof(timed_event));
+    event->callback = channel_diagnostics_event;
+    event->carry_data = mux;
+    event->interval = (uint64_t) mux->config.redundancy.n_diagnose * 1000000lu;
+    if (mux->config.redundancy.n_diagnose > 0) {
+        enable_timed_event(event);
+    }
+}
+
+void redundancy_mux_start_defer_timers(redundancy_mux * mux, event_system * ev_sys, int receive_notify_fd) {
+    mux->ev_sys = ev_sys;
+    mux->receive_notify_fd = receive_notify_fd;
+
+    // PDUs might have been deferred before the loop was started
+    for (unsigned int i = 0; i < mux->channel_count; ++i) {
+        redundancy_mux_arm_defer_timer(mux, mux->connected_channels[i]);
+    }
+}
+
+void redundancy_mux_stop_defer_timers(redundancy_mux * mux) {
+    for (unsigned int i = 0; i < mux->channel_count; ++i) {
+        redundancy_mux_remove_defer_timer(mux->connected_channels[i]);
+    }
+    mux->ev_sys = NULL;
+    mux->receive_notify_fd = -1;
+}
+
+/**
+ * sends the datagrams that wait for a socket while it is writable
+ * @param carry_data the struct transmit_event_data of the socket
+ * @return always 0
+ */
+static int transmit_event(void * carry_data) {
+    struct transmit_event_data * data = carry_data;
+    if (udp_transmit_flush(data->state) == 0) {
+        disable_fd_event(&data->event);
+    }
+    return 0;
+}
+
+void redundancy_mux_start_transmit_events(redundancy_mux * mux, event_system * ev_sys) {
+    mux->transmit_events = rmalloc(mux->port_count * sizeof(struct transmit_event_data));
+    for (unsigned int i = 0; i < mux->port_count; ++i) {
+        struct transmit_event_data * data = &mux->transmit_events[i];
+        memset(&data->event, 0, sizeof(fd_event));
+        data->state = &mux->udp_socket_states[i];
+        data->event.callback = transmit_event;
+        data->event.carry_data = data;
+        data->event.fd = mux->udp_socket_states[i].file_descriptor;
+        // datagrams might have been queued before the loop was started
+        data->event.enabled = udp_transmit_pending(data->state) > 0;
+        add_fd_event(ev_sys, &data->event, EV_WRITABLE);
+    }
+}
+
+void redundancy_mux_stop_transmit_events(redundancy_mux * mux, event_system * ev_sys) {
+    if (mux->transmit_events == NULL) {
+        return;
+    }
+    for (unsigned int i = 0; i < mux->port_count; ++i) {
+        remove_fd_event(ev_sys, &mux->transmit_events[i].event);
+    }
+    rfree(mux->transmit_events);
+    mux->transmit_events = NULL;
+}
+
+/**
+ * enables the writable event of a socket if datagrams wait for it
+ * @param mux the multiplexer that sent on the socket
+ * @param channel_index the index of the socket
+ */
+static void arm_transmit_event(redundancy_mux * mux, unsigned int channel_index) {
+    // the owner of the sockets has the events
+    redundancy_mux * owner = mux->socket_owner != NULL ? mux->socket_owner : mux;
+    if (owner->transmit_events == NULL || udp_transmit_pending(&owner->udp_socket_states[channel_index]) == 0) {
+        return;
+    }
+    struct transmit_event_data * data = &owner->transmit_events[channel_index];
+    if (!data->event.enabled) {
+        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send", "transport channel %u is not writable, "
+                   "%u datagrams wait for it", channel_index + 1, udp_transmit_pending(data->state));
+        enable_fd_event(&data->event);
+    }
+}
+
+/**
+ * @param channel the redundancy channel
+ * @return the time in ms the oldest PDU in the defer queue of @p channel is waiting, the queue must not be empty
+ */
+static uint32_t oldest_deferred_age(rasta_redundancy_channel * channel) {
+    return current_ts() - (uint32_t) deferqueue_first(&channel->defer_q)->received_timestamp;
+}
+
+void redundancy_mux_arm_defer_timer(redundancy_mux * mux, rasta_redundancy_channel * channel) {
+    timed_event * event = &channel->defer_timeout_event;
+
+    // an armed timer fires for a PDU that is at least as old as the oldest one deferred now
+    if (mux->ev_sys == NULL || event->enabled || channel->defer_q.count == 0) {
+        return;
+    }
+
+    if (event->ev_sys == NULL) {
+        event->callback = channel_defer_timeout_event;
+        event->carry_data = channel;
+        channel->mux = mux;
+        add_timed_event(mux->ev_sys, event);
+    }
+
+    uint32_t age = oldest_deferred_age(channel);
+    uint32_t timeout = channel->defer_timeout;
+    event->interval = (uint64_t) (age < timeout ? timeout - age : 0) * NS_PER_MS;
+    enable_timed_event(event);
+}
+
+int channel_defer_timeout_event(void * carry_data) {
+    rasta_redundancy_channel * channel = carry_data;
+    redundancy_mux * mux = channel->mux;
+
+    disable_timed_event(&channel->defer_timeout_event);
+
+    // the PDUs the timer was armed for might have been delivered since, then only the remaining ones are waited for
+    if (channel->defer_q.count > 0 && oldest_deferred_age(channel) >= channel->defer_timeout) {
+        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux defer timeout", "channel 0x%lX gives up seq_rx=%lu",
+                   channel->associated_id, channel->seq_rx);
+        rasta_red_f_deferTmo(channel);
+        rasta_handle_notify(mux->receive_notify_fd);
+    }
+
+    redundancy_mux_arm_defer_timer(mux, channel);
     return 0;
 }
 
@@ -356,6 +880,49 @@ void init_channel_timeout_events(timed_event * event, struct timeout_event_data
 
 /* ----------------------------*/
 
+/**
+ * prepares the hashing context and CRC options that are used to decode every received PDU, so the receive path
+ * only has to read them
+ * @param mux the multiplexer, the config has to be set
+ */
+static void redundancy_mux_init_decoding(redundancy_mux * mux){
+    // generate the CRC table now instead of on the first received PDU
+    if (mux->config.redundancy.crc_type.width > 0){
+        crc_generate_table(&mux->config.redundancy.crc_type);
+    }
+
+    // init hashing context
+    mux->sr_hashing_context.hash_length = mux->config.sending.md4_type;
+    mux->sr_hashing_context.algorithm = mux->config.sending.sr_hash_algorithm;
+
+    if (mux->sr_hashing_context.algorithm == RASTA_ALGO_MD4){
+        // use MD4 IV as key, this also precomputes the MD4 state
+        rasta_md4_set_key(&mux->sr_hashing_context, mux->config.sending.md4_a, mux->config.sending.md4_b,
+                          mux->config.sending.md4_c, mux->config.sending.md4_d);
+    } else {
+        // use the sr_hash_key
+        allocateRastaByteArray(&mux->sr_hashing_context.key, sizeof(unsigned int));
+
+        // convert unsigned in to byte array
+        mux->sr_hashing_context.key.bytes[0] = (mux->config.sending.sr_hash_key >> 24) & 0xFF;
+        mux->sr_hashing_context.key.bytes[1] = (mux->config.sending.sr_hash_key >> 16) & 0xFF;
+        mux->sr_hashing_context.key.bytes[2] = (mux->config.sending.sr_hash_key >> 8) & 0xFF;
+        mux->sr_hashing_context.key.bytes[3] = (mux->config.sending.sr_hash_key) & 0xFF;
+        rasta_hash_prepare_key(&mux->sr_hashing_context);
+    }
+}
+
+/**
+ * @param port_count the amount of udp sockets
+ * @return the zeroed traffic counters of every udp socket
+ */
+static struct rasta_transport_metrics * redundancy_mux_alloc_path_metrics(unsigned int port_count){
+    unsigned int size = (port_count > 0 ? port_count : 1) * sizeof(struct rasta_transport_metrics);
+    struct rasta_transport_metrics * metrics = rmalloc(size);
+    memset(metrics, 0, size);
+    return metrics;
+}
+
 redundancy_mux redundancy_mux_init_(struct logger_t logger, struct RastaConfigInfo config){
     redundancy_mux mux;
 
@@ -365,20 +932,27 @@ redundancy_mux redundancy_mux_init_(struct logger_t logger, struct RastaConfigIn
     mux.config = config;
 
     mux.notifications_running = 0;
+    mux.callback_executor = NULL;
 
     logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "init memory for %d listen ports", mux.port_count);
 
     // init and bind udp sockets + threads array
     mux.udp_socket_states = rmalloc(mux.port_count * sizeof(struct RastaUDPState));
+    mux.path_metrics = redundancy_mux_alloc_path_metrics(mux.port_count);
 
 
     // allocate memory for connected channels
-    mux.connected_channels = rmalloc(sizeof(rasta_redundancy_channel));
-    mux.channel_count = 0;
+    redundancy_mux_init_channels(&mux);
+
+    // receive buffers shared by all udp sockets
+    udp_receive_batch_init(&mux.receive_batch, UDP_RECEIVE_BATCH_SIZE, MAX_DEFER_QUEUE_MSG_SIZE);
+    memset(&mux.receive_stages, 0, sizeof(mux.receive_stages));
 
     // init notifications to NULL
     mux.notifications.on_diagnostics_available = NULL;
     mux.notifications.on_new_connection = NULL;
+    mux.on_transport_failure = NULL;
+    mux.transport_failure_context = NULL;
 
     // load ports that are specified in config
     if (mux.config.redundancy.connections.count > 0){
@@ -388,39 +962,144 @@ redundancy_mux redundancy_mux_init_(struct logger_t logger, struct RastaConfigIn
         for (unsigned int j = 0; j < mux.config.redundancy.connections.count; ++j) {
             // init socket
              udp_init(&mux.udp_socket_states[j],&config.tls);
+            if (config.redundancy.reuseport_group) {
+                udp_enable_reuseport(&mux.udp_socket_states[j]);
+            }
+            if (config.loop.socket_busy_poll_us) {
+                udp_set_busy_poll(&mux.udp_socket_states[j], config.loop.socket_busy_poll_us);
+            }
+            if (config.redundancy.receive_timestamps) {
+                udp_enable_receive_timestamps(&mux.udp_socket_states[j]);
+            }
+            udp_enable_drop_counter(&mux.udp_socket_states[j]);
+            if (j < config.redundancy.socket_buffers.count) {
+                udp_set_buffer_sizes(&mux.udp_socket_states[j], config.redundancy.socket_buffers.data[j].receive,
+                                     config.redundancy.socket_buffers.data[j].send);
+            }
 
             // bind socket to device and port
             udp_bind_device(&mux.udp_socket_states[j],
                             (uint16_t )mux.config.redundancy.connections.data[j].port,
                             mux.config.redundancy.connections.data[j].ip);
+            if (config.redundancy.reuseport_group) {
+                // every shard receives the datagrams of the remote entities it serves
+                udp_steer_reuseport(&mux.udp_socket_states[j], config.redundancy.reuseport_group,
+                                    RED_PDU_SENDER_ID_OFFSET);
+            }
 
             mux.listen_ports[j] = (uint16_t )mux.config.redundancy.connections.data[j].port;
-        }
-    }
 
-    // init hashing context
-    mux.sr_hashing_context.hash_length = config.sending.md4_type;
-    mux.sr_hashing_context.algorithm = config.sending.sr_hash_algorithm;
+            // the transport channels are impaired independently, with their own random decisions
+            const struct RastaConfigImpairments * impairments = &mux.config.redundancy.impairments;
+            if (j < impairments->count && udp_impairment_is_active(&impairments->data[j])) {
+                logger_log(&mux.logger, LOG_LEVEL_INFO, "RaSTA RedMux init", "impairing transport channel %u", j + 1);
+                mux.udp_socket_states[j].impairment = udp_impairment_create(mux.udp_socket_states[j].file_descriptor,
+                                                                            &impairments->data[j],
+                                                                            impairments->seed + j);
+            }
 
-    if (mux.sr_hashing_context.algorithm == RASTA_ALGO_MD4){
-        // use MD4 IV as key
-        rasta_md4_set_key(&mux.sr_hashing_context, config.sending.md4_a, config.sending.md4_b,
-                          config.sending.md4_c, config.sending.md4_d);
-    } else {
-        // use the sr_hash_key
-        allocateRastaByteArray(&mux.sr_hashing_context.key, sizeof(unsigned int));
+            // the datagrams of this transport channel take TCP or TLS streams instead of the socket
+            const struct RastaConfigTcpChannels * tcp_channels = &mux.config.redundancy.tcp_channels;
+            if (j < tcp_channels->count && tcp_channels->types[j] != TRANSPORT_CHANNEL_UDP) {
+                if (config.redundancy.reuseport_group) {
+                    logger_log(&mux.logger, LOG_LEVEL_ERROR, "RaSTA RedMux init",
+                               "TCP is not used with shared listen ports on transport channel %u", j + 1);
+                } else {
+                    int tls = tcp_channels->types[j] == TRANSPORT_CHANNEL_TLS;
+                    logger_log(&mux.logger, LOG_LEVEL_INFO, "RaSTA RedMux init", "transport channel %u uses %s",
+                               j + 1, tls ? "TLS over TCP" : "TCP");
+                    udp_enable_tcp(&mux.udp_socket_states[j], tls);
+                }
+            }
 
-        // convert unsigned in to byte array
-        mux.sr_hashing_context.key.bytes[0] = (config.sending.sr_hash_key >> 24) & 0xFF;
-        mux.sr_hashing_context.key.bytes[1] = (config.sending.sr_hash_key >> 16) & 0xFF;
-        mux.sr_hashing_context.key.bytes[2] = (config.sending.sr_hash_key >> 8) & 0xFF;
-        mux.sr_hashing_context.key.bytes[3] = (config.sending.sr_hash_key) & 0xFF;
+            // entities on the same host exchange the datagrams of this transport channel through shared memory
+            const struct RastaConfigShmChannels * shm_channels = &mux.config.redundancy.shm_channels;
+            if (j < shm_channels->count && shm_channels->names[j][0] != '\0') {
+                if (config.redundancy.reuseport_group) {
+                    logger_log(&mux.logger, LOG_LEVEL_ERROR, "RaSTA RedMux init",
+                               "shared memory is not used with shared listen ports on transport channel %u", j + 1);
+                } else {
+                    logger_log(&mux.logger, LOG_LEVEL_INFO, "RaSTA RedMux init",
+                               "transport channel %u uses shared memory %s", j + 1, shm_channels->names[j]);
+                    udp_enable_shm(&mux.udp_socket_states[j], shm_channels->names[j]);
+                }
+            }
+            if (config.redundancy.udp_offload) {
+                udp_enable_offload(&mux.udp_socket_states[j]);
+            }
+
+            // a dedicated interface receives the datagrams of this transport channel into an AF_XDP socket
+            const struct RastaConfigXdpChannels * xdp_channels = &mux.config.redundancy.xdp_channels;
+            if (j < xdp_channels->count && xdp_channels->interfaces[j][0] != '\0') {
+                logger_log(&mux.logger, LOG_LEVEL_INFO, "RaSTA RedMux init",
+                           "transport channel %u uses AF_XDP on %s queue %u", j + 1, xdp_channels->interfaces[j],
+                           xdp_channels->queue);
+                udp_enable_xdp(&mux.udp_socket_states[j], xdp_channels->interfaces[j], xdp_channels->queue);
+            }
+        }
     }
 
+    redundancy_mux_init_decoding(&mux);
+
     logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "initialization done");
     return mux;
 }
 
+redundancy_mux redundancy_mux_init_member(struct logger_t logger, struct RastaConfigInfo config, redundancy_mux * owner){
+    redundancy_mux mux;
+
+    mux.logger = logger;
+    mux.listen_ports = owner->listen_ports;
+    mux.port_count = owner->port_count;
+    mux.config = config;
+
+    mux.notifications_running = 0;
+    mux.callback_executor = NULL;
+
+    // the PDUs are received into the batch of the owner
+    mux.udp_socket_states = owner->udp_socket_states;
+    mux.path_metrics = owner->path_metrics;
+    memset(&mux.receive_batch, 0, sizeof(mux.receive_batch));
+    memset(&mux.receive_stages, 0, sizeof(mux.receive_stages));
+
+    redundancy_mux_init_channels(&mux);
+    mux.socket_owner = owner;
+
+    mux.notifications.on_diagnostics_available = NULL;
+    mux.notifications.on_new_connection = NULL;
+    mux.on_transport_failure = NULL;
+    mux.transport_failure_context = NULL;
+
+    redundancy_mux_init_decoding(&mux);
+
+    logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "sharing the sockets of 0x%lX",
+               owner->config.general.rasta_id);
+    return mux;
+}
+
+void redundancy_mux_add_member(redundancy_mux * owner, redundancy_mux * member){
+    owner->members = rrealloc(owner->members, (owner->member_count + 1) * sizeof(redundancy_mux *));
+    owner->members[owner->member_count] = member;
+    owner->member_count++;
+    rasta_id_index_put(&owner->member_index, member->config.general.rasta_id, member);
+}
+
+/**
+ * stops handing PDUs to a member, see redundancy_mux_add_member()
+ * @param owner the multiplexer that has the sockets
+ * @param member the member
+ */
+static void redundancy_mux_remove_member(redundancy_mux * owner, redundancy_mux * member){
+    for (unsigned int i = 0; i < owner->member_count; i++) {
+        if (owner->members[i] == member) {
+            owner->member_count--;
+            owner->members[i] = owner->members[owner->member_count];
+            rasta_id_index_remove(&owner->member_index, member->config.general.rasta_id);
+            return;
+        }
+    }
+}
+
 redundancy_mux redundancy_mux_init(struct logger_t logger, uint16_t * listen_ports, unsigned int port_count, struct RastaConfigInfo config){
     redundancy_mux mux;
 
@@ -430,26 +1109,54 @@ redundancy_mux redundancy_mux_init(struct logger_t logger, uint16_t * listen_por
     mux.config = config;
 
     mux.notifications_running = 0;
+    mux.callback_executor = NULL;
 
     logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "init memory for %d listen ports", port_count);
 
     // init and bind udp sockets + threads array
-    mux.udp_socket_states = rmalloc(port_count * sizeof(int));
+    mux.udp_socket_states = rmalloc(port_count * sizeof(struct RastaUDPState));
+    mux.path_metrics = redundancy_mux_alloc_path_metrics(port_count);
 
     // set up udp sockets
     for (unsigned int i = 0; i < port_count; ++i) {
         logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "setting up udp socket %d/%d", i+1,port_count);
         udp_init(&mux.udp_socket_states[i],&config.tls);
+        if (config.redundancy.reuseport_group) {
+            udp_enable_reuseport(&mux.udp_socket_states[i]);
+        }
+        if (config.loop.socket_busy_poll_us) {
+            udp_set_busy_poll(&mux.udp_socket_states[i], config.loop.socket_busy_poll_us);
+        }
+        if (config.redundancy.receive_timestamps) {
+            udp_enable_receive_timestamps(&mux.udp_socket_states[i]);
+        }
+        udp_enable_drop_counter(&mux.udp_socket_states[i]);
+        if (i < config.redundancy.socket_buffers.count) {
+            udp_set_buffer_sizes(&mux.udp_socket_states[i], config.redundancy.socket_buffers.data[i].receive,
+                                 config.redundancy.socket_buffers.data[i].send);
+        }
         udp_bind(&mux.udp_socket_states[i], listen_ports[i]);
+        if (config.redundancy.udp_offload) {
+            udp_enable_offload(&mux.udp_socket_states[i]);
+        }
+        if (config.redundancy.reuseport_group) {
+            udp_steer_reuseport(&mux.udp_socket_states[i], config.redundancy.reuseport_group, RED_PDU_SENDER_ID_OFFSET);
+        }
     }
 
     // allocate memory for connected channels
-    mux.connected_channels = rmalloc(sizeof(rasta_redundancy_channel));
-    mux.channel_count = 0;
+    redundancy_mux_init_channels(&mux);
+
+    // receive buffers shared by all udp sockets
+    udp_receive_batch_init(&mux.receive_batch, UDP_RECEIVE_BATCH_SIZE, MAX_DEFER_QUEUE_MSG_SIZE);
+
+    redundancy_mux_init_decoding(&mux);
 
     // init notifications to NULL
     mux.notifications.on_diagnostics_available = NULL;
     mux.notifications.on_new_connection = NULL;
+    mux.on_transport_failure = NULL;
+    mux.transport_failure_context = NULL;
 
     // load channel that is specified in config
     if (mux.config.redundancy.connections.count > 0){
@@ -469,8 +1176,7 @@ redundancy_mux redundancy_mux_init(struct logger_t logger, uint16_t * listen_por
         }
 
 
-        mux.connected_channels[mux.channel_count] = new_channel;
-        mux.channel_count++;
+        redundancy_mux_store_channel(&mux, new_channel);
     }
 
     logger_log(&mux.logger, LOG_LEVEL_DEBUG, "RaSTA RedMux init", "initialization done");
@@ -478,46 +1184,100 @@ redundancy_mux redundancy_mux_init(struct logger_t logger, uint16_t * listen_por
 }
 
 void redundancy_mux_close(redundancy_mux * mux){
-    // close the sockets of the transport channels
-    for (unsigned int i = 0; i < mux->port_count; ++i) {
-        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux close", "closing udp socket %d/%d", i+1, mux->port_count);
-        udp_close(&mux->udp_socket_states[i]);
-    }
+    if (mux->socket_owner != NULL) {
+        // the sockets stay open for the owner and the other members
+        redundancy_mux_remove_member(mux->socket_owner, mux);
+        mux->socket_owner = NULL;
+    } else {
+        // close the sockets of the transport channels
+        for (unsigned int i = 0; i < mux->port_count; ++i) {
+            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux close", "closing udp socket %d/%d", i+1, mux->port_count);
+            udp_close(&mux->udp_socket_states[i]);
+        }
+
+        // free arrays
+        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux close", "freeing thread data");
+        rfree(mux->udp_socket_states);
+        rfree(mux->path_metrics);
 
-    // free arrays
-    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux close", "freeing thread data");
-    rfree(mux->udp_socket_states);
+        udp_receive_batch_free(&mux->receive_batch);
+    }
+    mux->udp_socket_states = NULL;
+    mux->path_metrics = NULL;
     mux->port_count = 0;
 
+    if (mux->members != NULL) {
+        rfree(mux->members);
+        mux->members = NULL;
+    }
+    mux->member_count = 0;
+    rasta_id_index_free(&mux->member_index);
+
     // close the redundancy channels
     for (unsigned int j = 0; j < mux->channel_count; ++j) {
         logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux close", "cleanup connected channel %d/%d", j+1, mux->channel_count);
-        rasta_red_cleanup(&mux->connected_channels[j]);
+        redundancy_mux_remove_defer_timer(mux->connected_channels[j]);
+        rasta_red_cleanup(mux->connected_channels[j]);
+        rfree(mux->connected_channels[j]);
     }
     rfree(mux->connected_channels);
+    rasta_id_index_free(&mux->channel_index);
+    mux->channel_count = 0;
+
+    if (mux->pending_channels != NULL) {
+        rfree(mux->pending_channels);
+        mux->pending_channels = NULL;
+    }
+    mux->pending_count = 0;
 
     freeRastaByteArray(&mux->sr_hashing_context.key);
 
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux close", "redundancy multiplexer closed");
 }
 
-rasta_redundancy_channel * redundancy_mux_get_channel(redundancy_mux * mux, unsigned long id){
-    // iterate over all known channels
-    for (unsigned int i = 0; i < mux->channel_count; ++i) {
-        // check if channel id == wanted id
-        if (mux->connected_channels[i].associated_id == id){
-            return &mux->connected_channels[i];
+unsigned int redundancy_mux_reconfigure(redundancy_mux * mux, unsigned int t_seq, unsigned int n_deferqueue_size){
+    unsigned int kept = 0;
+    mux->config.redundancy.t_seq = t_seq;
+    mux->config.redundancy.n_deferqueue_size = n_deferqueue_size;
+
+    for (unsigned int j = 0; j < mux->channel_count; ++j) {
+        rasta_redundancy_channel * channel = mux->connected_channels[j];
+        channel->configuration_parameters.t_seq = t_seq;
+        if (channel->defer_timeout > t_seq || !channel->configuration_parameters.adaptive_t_seq) {
+            channel->defer_timeout = t_seq;
+        }
+        if (channel->configuration_parameters.n_deferqueue_size != n_deferqueue_size &&
+            !rasta_red_resize_buffers(channel, n_deferqueue_size, mux->config.sending.send_max)) {
+            logger_log(&mux->logger, LOG_LEVEL_ERROR, "RaSTA RedMux reconfigure",
+                       "channel 0x%lX holds too many PDUs, keeping its defer queue size %u", channel->associated_id,
+                       channel->configuration_parameters.n_deferqueue_size);
+            kept++;
         }
     }
+    return kept;
+}
 
-    // wanted id is unknown, return NULL
-    return NULL;
+void redundancy_mux_set_log_level(redundancy_mux * mux, log_level max_log_level){
+    mux->logger.max_log_level = max_log_level;
+    for (unsigned int j = 0; j < mux->channel_count; ++j) {
+        mux->connected_channels[j]->logger.max_log_level = max_log_level;
+    }
+}
+
+rasta_redundancy_channel * redundancy_mux_get_channel(redundancy_mux * mux, unsigned long id){
+    // NULL if the id is unknown
+    return rasta_id_index_get(&mux->channel_index, id);
 }
 
 void redundancy_mux_set_config_id(redundancy_mux * mux, unsigned long id){
     // only set if a channel is available
     if (mux->channel_count > 0){
-        mux->connected_channels[0].associated_id = id;
+        // the index position depends on the id
+        if (rasta_id_index_get(&mux->channel_index, mux->connected_channels[0]->associated_id) == mux->connected_channels[0]) {
+            rasta_id_index_remove(&mux->channel_index, mux->connected_channels[0]->associated_id);
+        }
+        mux->connected_channels[0]->associated_id = id;
+        rasta_id_index_put(&mux->channel_index, id, mux->connected_channels[0]);
     }
 }
 
@@ -536,9 +1296,15 @@ void redundancy_mux_send(redundancy_mux * mux, struct RastaPacket data){
     }
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send", "current seq_tx=%lu", receiver->seq_tx);
 
-    // create packet to send and convert to byte array
-    struct RastaRedundancyPacket packet = createRedundancyPacket(receiver->seq_tx, data, mux->config.redundancy.crc_type);
-    struct RastaByteArray data_to_send = rastaRedundancyPacketToBytes(packet, &receiver->hashing_context);
+    // encode the redundancy PDU straight into the transmit buffer, the receive buffers have the same size
+    unsigned char data_to_send[MAX_DEFER_QUEUE_MSG_SIZE];
+    unsigned int length = rastaRedundancyPacketEncode(receiver->seq_tx, &data, &mux->config.redundancy.crc_type,
+                                                      &receiver->hashing_context, data_to_send, sizeof(data_to_send));
+    if (length == 0){
+        logger_log(&mux->logger, LOG_LEVEL_ERROR, "RaSTA RedMux send", "PDU with length %u can not be encoded",
+                   data.length);
+        return;
+    }
 
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send", "redundancy packet created");
 
@@ -553,16 +1319,153 @@ void redundancy_mux_send(redundancy_mux * mux, struct RastaPacket data){
 
         channel = receiver->connected_channels[i];
 
-        // send using the channel specific udp socket
-        udp_send(&mux->udp_socket_states[i], data_to_send.bytes, data_to_send.length, channel.ip_address, channel.port);
+        // send using the udp socket of the transport channel
+        udp_send_sockaddr(&mux->udp_socket_states[channel.path], data_to_send, length, channel.address);
+        arm_transmit_event(mux, channel.path);
+        redundancy_mux_count_path_out(mux, channel.path, length);
+        RASTA_PROBE3(red_send_channel, receiver->associated_id, channel.path, length);
+        rasta_metrics_add(&receiver->connected_channels[i].metrics.pdus_out, 1);
+        rasta_metrics_add(&receiver->connected_channels[i].metrics.bytes_out, length);
 
         logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send", "Sent data over channel %s:%d",
                    channel.ip_address, channel.port);
     }
 
-    freeRastaByteArray(&data_to_send);
-
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA Red send", "Data sent over all transport channels");
+    rasta_metrics_add(&receiver->metrics.pdus_out, 1);
+    rasta_metrics_add(&receiver->metrics.bytes_out, data.length);
+    rasta_trace_add(mux->logger.trace, RASTA_TRACE_RED_SEND, receiver->associated_id, receiver->seq_tx - 1, 0, 0,
+                       receiver->connected_channel_count);
+    RASTA_PROBE3(red_send, receiver->associated_id, receiver->seq_tx - 1, receiver->connected_channel_count);
+}
+
+/**
+ * sends redundancy layer PDUs on every transport channel of their receivers. Every transport channel has its own
+ * socket, so all PDUs of a transport channel go out with one syscall
+ * @param mux the multiplexer that is used
+ * @param receivers the redundancy channel of every PDU, PDUs with NULL are skipped
+ * @param pdus the encoded redundancy layer PDUs
+ * @param pdu_lengths the length of every PDU
+ * @param count the amount of PDUs
+ */
+static void send_redundancy_pdus(redundancy_mux * mux, rasta_redundancy_channel * const * receivers,
+                                 unsigned char * const * pdus, const unsigned int * pdu_lengths, unsigned int count){
+    unsigned char * messages[count];
+    size_t message_lengths[count];
+    struct sockaddr_in addresses[count];
+
+    for (unsigned int i = 0; i < mux->port_count; ++i) {
+        unsigned int message_count = 0;
+
+        for (unsigned int n = 0; n < count; n++) {
+            int transport = receivers[n] != NULL ? rasta_red_path_channel(receivers[n], i) : -1;
+            if (transport < 0) {
+                continue;
+            }
+            rasta_transport_channel * channel = &receivers[n]->connected_channels[transport];
+            messages[message_count] = pdus[n];
+            message_lengths[message_count] = pdu_lengths[n];
+            rasta_metrics_add(&channel->metrics.pdus_out, 1);
+            rasta_metrics_add(&channel->metrics.bytes_out, pdu_lengths[n]);
+            redundancy_mux_count_path_out(mux, i, pdu_lengths[n]);
+            RASTA_PROBE3(red_send_channel, receivers[n]->associated_id, i, pdu_lengths[n]);
+            addresses[message_count] = channel->address;
+            message_count++;
+        }
+
+        if (message_count > 0) {
+            udp_send_batch(&mux->udp_socket_states[i], messages, message_lengths, addresses, message_count);
+            arm_transmit_event(mux, i);
+            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send batch", "sent %u PDUs on transport channel %u",
+                       message_count, i + 1);
+        }
+    }
+}
+
+void redundancy_mux_send_batch(redundancy_mux * mux, struct RastaPacket * data, unsigned int count){
+    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send batch", "sending %u data packets", count);
+
+    if (count == 0) {
+        return;
+    }
+
+    unsigned char pdus[count][MAX_DEFER_QUEUE_MSG_SIZE];
+    unsigned char * pdu_pointers[count];
+    unsigned int pdu_lengths[count];
+    rasta_redundancy_channel * receivers[count];
+
+    // create the redundancy PDUs, the sequence numbers are assigned in the order of the batch
+    for (unsigned int n = 0; n < count; n++) {
+        pdu_pointers[n] = pdus[n];
+        receivers[n] = redundancy_mux_get_channel(mux, data[n].receiver_id);
+
+        if (receivers[n] == NULL){
+            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send batch", "redundancy channel with id=0x%lX unknown",
+                       (long unsigned int) data[n].receiver_id);
+            continue;
+        }
+
+        pdu_lengths[n] = rastaRedundancyPacketEncode(receivers[n]->seq_tx, &data[n], &mux->config.redundancy.crc_type,
+                                                     &receivers[n]->hashing_context, pdus[n], MAX_DEFER_QUEUE_MSG_SIZE);
+        if (pdu_lengths[n] == 0){
+            logger_log(&mux->logger, LOG_LEVEL_ERROR, "RaSTA RedMux send batch", "PDU with length %u can not be encoded",
+                       data[n].length);
+            receivers[n] = NULL;
+            continue;
+        }
+        rasta_trace_add(mux->logger.trace, RASTA_TRACE_RED_SEND, receivers[n]->associated_id, receivers[n]->seq_tx,
+                           0, 0, receivers[n]->connected_channel_count);
+        RASTA_PROBE3(red_send, receivers[n]->associated_id, receivers[n]->seq_tx, receivers[n]->connected_channel_count);
+        rasta_metrics_add(&receivers[n]->metrics.pdus_out, 1);
+        rasta_metrics_add(&receivers[n]->metrics.bytes_out, data[n].length);
+        receivers[n]->seq_tx = receivers[n]->seq_tx +1;
+    }
+
+    send_redundancy_pdus(mux, receivers, pdu_pointers, pdu_lengths, count);
+}
+
+void redundancy_mux_send_encoded_batch(redundancy_mux * mux, unsigned long id, unsigned char * const * data,
+                                       const unsigned int * lengths, unsigned int count){
+    logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send batch", "sending %u encoded data packets", count);
+
+    if (count == 0) {
+        return;
+    }
+
+    rasta_redundancy_channel * receiver = redundancy_mux_get_channel(mux, id);
+    if (receiver == NULL){
+        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux send batch", "redundancy channel with id=0x%lX unknown",
+                   (long unsigned int) id);
+        return;
+    }
+
+    unsigned char pdus[count][MAX_DEFER_QUEUE_MSG_SIZE];
+    unsigned char * pdu_pointers[count];
+    unsigned int pdu_lengths[count];
+    rasta_redundancy_channel * receivers[count];
+
+    // only the redundancy header and the CRC checksum are added, the SR layer PDUs are copied as they are
+    for (unsigned int n = 0; n < count; n++) {
+        pdu_pointers[n] = pdus[n];
+        receivers[n] = receiver;
+
+        pdu_lengths[n] = rastaRedundancyPacketWrap(receiver->seq_tx, data[n], lengths[n],
+                                                   &mux->config.redundancy.crc_type, pdus[n], MAX_DEFER_QUEUE_MSG_SIZE);
+        if (pdu_lengths[n] == 0){
+            logger_log(&mux->logger, LOG_LEVEL_ERROR, "RaSTA RedMux send batch", "PDU with length %u can not be encoded",
+                       lengths[n]);
+            receivers[n] = NULL;
+            continue;
+        }
+        rasta_trace_add(mux->logger.trace, RASTA_TRACE_RED_SEND, receiver->associated_id, receiver->seq_tx, 0, 0,
+                           receiver->connected_channel_count);
+        RASTA_PROBE3(red_send, receiver->associated_id, receiver->seq_tx, receiver->connected_channel_count);
+        rasta_metrics_add(&receiver->metrics.pdus_out, 1);
+        rasta_metrics_add(&receiver->metrics.bytes_out, lengths[n]);
+        receiver->seq_tx = receiver->seq_tx +1;
+    }
+
+    send_redundancy_pdus(mux, receivers, pdu_pointers, pdu_lengths, count);
 }
 
 int redundancy_try_mux_retrieve(redundancy_mux * mux, unsigned long id, struct RastaPacket * out) {
@@ -574,7 +1477,7 @@ int redundancy_try_mux_retrieve(redundancy_mux * mux, unsigned long id, struct R
         return 0;
     }
 
-    struct RastaByteArray * element;
+    struct rasta_delivered_packet * element;
 
     if (fifo_get_size(target->fifo_recv) == 0) {
         return 0;
@@ -583,38 +1486,52 @@ int redundancy_try_mux_retrieve(redundancy_mux * mux, unsigned long id, struct R
 
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux retrieve", "Found element in queue");
 
+    // the redundancy layer has already decoded and checked the PDU, the data is handed over to the caller
     element = fifo_pop(target->fifo_recv);
+    if (element->delivered_ns != 0) {
+        rasta_residency_record(target->residency, RASTA_RESIDENCY_RECEIVE_QUEUE, element->delivered_ns, get_nanotime());
+    }
 
-    struct RastaPacket packet = bytesToRastaPacket(*element, &target->hashing_context);
-
-    freeRastaByteArray(element);
+    *out = element->packet;
     rfree(element);
-
-    *out = packet;
     return 1;
 }
 
 void redundancy_mux_wait_for_notifications(redundancy_mux * mux){
-    if (mux->notifications_running == 0){
-        logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "all notification threads finished");
+    // the notifications are called on the thread of the multiplexer and return before it goes on, only a call from
+    // within a notification sees one running. Waiting for it there would never end
+    if (mux->notifications_running > 0){
+        logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "called from within %d notification(s), not waiting",
+                   mux->notifications_running);
         return;
     }
-    logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "waiting for %d notification thread(s) to finish", mux->notifications_running);
-    while (mux->notifications_running > 0){
-        // busy wait
-        // to avoid to much CPU utilization, force context switch by sleeping for 0ns
-        nanosleep((const struct timespec[]){{0, 0L}}, NULL);
-    }
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "all notification threads finished");
 }
 
 void redundancy_mux_wait_for_entity(redundancy_mux * mux, unsigned long id){
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "waiting for entity with id=0x%lX", id);
-    rasta_redundancy_channel * target = NULL;
-    while (target == NULL){
-        target = redundancy_mux_get_channel(mux, id);
-        // to avoid to much CPU utilization, force context switch by sleeping for 0ns
-        nanosleep((const struct timespec[]){{0, 0L}}, NULL);
+
+    // nobody else receives while the caller waits, the thread sleeps in poll() until one of the sockets is readable
+    redundancy_mux * sockets = mux->socket_owner != NULL ? mux->socket_owner : mux;
+    struct pollfd readable[sockets->port_count > 0 ? sockets->port_count : 1];
+    for (unsigned int i = 0; i < sockets->port_count; i++) {
+        readable[i].fd = udp_receive_fd(&sockets->udp_socket_states[i]);
+        readable[i].events = POLLIN;
+    }
+
+    while (redundancy_mux_get_channel(mux, id) == NULL){
+        if (poll(readable, sockets->port_count, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Could not wait for the sockets");
+            exit(1);
+        }
+        for (unsigned int i = 0; i < sockets->port_count; i++) {
+            if (readable[i].revents & POLLIN) {
+                receive_packet(sockets, (int) i);
+            }
+        }
     }
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux wait", "entity with id=0x%lX available", id);
 }
@@ -627,15 +1544,27 @@ void redundancy_mux_add_channel(redundancy_mux * mux, unsigned long id, struct R
         rasta_red_add_transport_channel(&channel, transport_channels[i].ip, (uint16_t)transport_channels[i].port);
     }
 
-    //reallocate memory for new client
-    mux->connected_channels = rrealloc(mux->connected_channels, (mux->channel_count + 1) * sizeof(rasta_redundancy_channel));
-
-    mux->connected_channels[mux->channel_count] = channel;
-    mux->channel_count++;
+    redundancy_mux_store_channel(mux, channel);
 
     logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux add channel", "added new redundancy channel for ID=0x%lX", id);
 }
 
+void redundancy_mux_restore_channel(redundancy_mux * mux, unsigned long id, const struct RastaIPData * transport_channels,
+                                    unsigned int count, uint32_t seq_tx, uint32_t seq_rx){
+    rasta_redundancy_channel channel = rasta_red_init(mux->logger, mux->config, mux->port_count, id);
+
+    for (unsigned int i = 0; i < count && i < mux->port_count; ++i) {
+        rasta_red_add_transport_channel(&channel, (char *) transport_channels[i].ip, (uint16_t)transport_channels[i].port);
+    }
+    channel.seq_tx = seq_tx;
+    channel.seq_rx = seq_rx;
+    channel.resync = 1;
+
+    redundancy_mux_store_channel(mux, channel);
+
+    logger_log(&mux->logger, LOG_LEVEL_INFO, "RaSTA RedMux restore channel", "restored redundancy channel for ID=0x%lX", id);
+}
+
 void redundancy_mux_remove_channel(redundancy_mux * mux, unsigned long channel_id){
     rasta_redundancy_channel * channel = redundancy_mux_get_channel(mux, channel_id);
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux remove channel", "removing channel with ID=0x%lX", channel_id);
@@ -645,27 +1574,28 @@ void redundancy_mux_remove_channel(redundancy_mux * mux, unsigned long channel_i
         return;
     }
 
-    rasta_redundancy_channel * new_channels = rmalloc((mux->channel_count -1) * sizeof(rasta_redundancy_channel));
+    rasta_id_index_remove(&mux->channel_index, channel_id);
+    if (channel->pending) {
+        redundancy_mux_forget_pending(mux, channel);
+    }
 
-    int newIndex = 0;
+    // close the gap in the channel array, the order of the remaining channels is kept
     for (unsigned int i = 0; i < mux->channel_count; ++i) {
-        rasta_redundancy_channel c = mux->connected_channels[i];
-
-        if (c.associated_id == channel_id){
-            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux remove channel", "skipping channel with ID=0x%lX", c.associated_id);
-            // channel to remove, skip
-            continue;
+        if (mux->connected_channels[i] == channel){
+            logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux remove channel", "removing channel at index %u", i);
+            memmove(&mux->connected_channels[i], &mux->connected_channels[i + 1],
+                    (mux->channel_count - i - 1) * sizeof(rasta_redundancy_channel *));
+            break;
         }
-
-        logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux remove channel", "copy channel with ID=0x%lX", c.associated_id);
-        // otherwise copy to new channel array
-        new_channels[newIndex] = c;
-        newIndex++;
     }
-
-    rfree(mux->connected_channels);
-    mux->connected_channels = new_channels;
     mux->channel_count --;
+    if (mux->next_retrieve_index >= mux->channel_count) {
+        mux->next_retrieve_index = 0;
+    }
+
+    redundancy_mux_remove_defer_timer(channel);
+    rasta_red_cleanup(channel);
+    rfree(channel);
     logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux remove channel", "%d channels left", mux->channel_count);
 }
 
@@ -681,21 +1611,33 @@ unsigned int get_queue_msg_count(redundancy_mux * mux, unsigned int redundancy_c
         return 0;
     }
 
-    rasta_redundancy_channel channel = mux->connected_channels[redundancy_channel_index];
+    rasta_redundancy_channel * channel = mux->connected_channels[redundancy_channel_index];
 
-    if (channel.fifo_recv == NULL){
+    if (channel->fifo_recv == NULL){
         return 0;
     }
-    unsigned int size = fifo_get_size(channel.fifo_recv);
+    unsigned int size = fifo_get_size(channel->fifo_recv);
 
     return size;
 }
 
 int redundancy_mux_try_retrieve_all(redundancy_mux * mux, struct RastaPacket* out) {
-    for (unsigned int i = 0; i < mux->channel_count; i++) {
+    // start after the channel that was served last, so one busy peer can not starve the others
+    for (unsigned int n = 0; n < mux->channel_count; n++) {
+        unsigned int i = (mux->next_retrieve_index + n) % mux->channel_count;
         if (get_queue_msg_count(mux, i) > 0){
             logger_log(&mux->logger, LOG_LEVEL_DEBUG, "RaSTA RedMux retrieve all", "channel with index %d has messages", i);
-            redundancy_try_mux_retrieve(mux, mux->connected_channels[i].associated_id, out);
+            mux->next_retrieve_index = (i + 1) % mux->channel_count;
+            redundancy_try_mux_retrieve(mux, mux->connected_channels[i]->associated_id, out);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int redundancy_mux_data_available(redundancy_mux * mux) {
+    for (unsigned int i = 0; i < mux->channel_count; i++) {
+        if (get_queue_msg_count(mux, i) > 0){
             return 1;
         }
     }
@@ -0,0 +1,91 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_REDUNDANCY
+#include "rastaarrivalring.h"
+#include "rmemory.h"
+
+/**
+ * rounds a capacity up to a power of two
+ * @param capacity the requested capacity
+ * @return the smallest power of two that is at least capacity and 1
+ */
+static unsigned int arrival_ring_capacity(unsigned int capacity) {
+    unsigned int result = 1;
+    while (result < capacity) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * allocates the slots of the ring, all slots are unused afterwards
+ * @param ring the ring
+ * @param capacity the amount of slots, has to be a power of two
+ */
+static void arrival_ring_allocate(struct rasta_arrival_ring * ring, unsigned int capacity) {
+    ring->entries = rmalloc(capacity * sizeof(struct rasta_arrival));
+    rmemset(ring->entries, 0, capacity * sizeof(struct rasta_arrival));
+    ring->capacity = capacity;
+}
+
+void rasta_arrival_ring_init(struct rasta_arrival_ring * ring, unsigned int capacity) {
+    arrival_ring_allocate(ring, arrival_ring_capacity(capacity));
+    ring->window = 1;
+    ring->count = 0;
+}
+
+void rasta_arrival_ring_free(struct rasta_arrival_ring * ring) {
+    rfree(ring->entries);
+    ring->entries = NULL;
+    ring->capacity = 0;
+    ring->count = 0;
+}
+
+void rasta_arrival_ring_put(struct rasta_arrival_ring * ring, uint32_t sequence_number, uint32_t received_at) {
+    struct rasta_arrival * entry = &ring->entries[sequence_number & (ring->capacity - 1)];
+    entry->sequence_number = sequence_number;
+    entry->received_at = received_at;
+    entry->window = ring->window;
+    ring->count++;
+}
+
+int rasta_arrival_ring_get(const struct rasta_arrival_ring * ring, uint32_t sequence_number, uint32_t * received_at) {
+    const struct rasta_arrival * entry = &ring->entries[sequence_number & (ring->capacity - 1)];
+    if (entry->window != ring->window || entry->sequence_number != sequence_number) {
+        return 0;
+    }
+    *received_at = entry->received_at;
+    return 1;
+}
+
+void rasta_arrival_ring_clear(struct rasta_arrival_ring * ring) {
+    ring->count = 0;
+    ring->window++;
+    if (ring->window == 0) {
+        // the windows wrapped around, slots of a window with the same number must not be taken for current ones
+        rmemset(ring->entries, 0, ring->capacity * sizeof(struct rasta_arrival));
+        ring->window = 1;
+    }
+}
+
+void rasta_arrival_ring_resize(struct rasta_arrival_ring * ring, unsigned int capacity) {
+    capacity = arrival_ring_capacity(capacity);
+    if (capacity == ring->capacity) {
+        return;
+    }
+
+    struct rasta_arrival * old_entries = ring->entries;
+    unsigned int old_capacity = ring->capacity;
+
+    arrival_ring_allocate(ring, capacity);
+    for (unsigned int i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].window != ring->window) {
+            continue;
+        }
+        // when the ring shrinks, the newer of two colliding arrivals is kept like in rasta_arrival_ring_put()
+        struct rasta_arrival * entry = &ring->entries[old_entries[i].sequence_number & (capacity - 1)];
+        if (entry->window != ring->window ||
+            (int32_t) (old_entries[i].sequence_number - entry->sequence_number) > 0) {
+            *entry = old_entries[i];
+        }
+    }
+    rfree(old_entries);
+}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include "rastablake2.h"
 #include "rmemory.h"
 
@@ -71,24 +72,27 @@ static const uint64_t blake2b_iv[8] = {
         0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179
 };
 
+// Message word schedule, shared by the scalar and the lane compression.
+
+static const uint8_t sigma[12][16] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+        { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+        { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+        { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+        { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+        { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+        { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+        { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+        { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
 // Compression function. "last" flag indicates last block.
 
 static void blake2b_compress(rasta_blake2b_ctx *ctx, int last)
 {
-    const uint8_t sigma[12][16] = {
-            { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
-            { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
-            { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
-            { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
-            { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
-            { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
-            { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
-            { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
-            { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
-            { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
-            { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
-            { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
-    };
     int i;
     uint64_t v[16], m[16];
 
@@ -149,14 +153,36 @@ int rasta_blake2b_init(rasta_blake2b_ctx *ctx, size_t outlen,
     return 0;
 }
 
+void rasta_blake2b_compress_key(rasta_blake2b_ctx *ctx)
+{
+    if (ctx->c != 128)
+        return;                         // no key block
+    ctx->t[0] += ctx->c;
+    if (ctx->t[0] < ctx->c)
+        ctx->t[1]++;
+    blake2b_compress(ctx, 0);
+    ctx->c = 0;
+}
+
+void rasta_blake2b_init_keyed(rasta_blake2b_ctx *ctx, size_t outlen, const uint64_t keyed[8])
+{
+    // the input block is filled from the start, so it does not have to be cleared
+    memcpy(ctx->h, keyed, sizeof(ctx->h));
+    ctx->t[0] = 128;
+    ctx->t[1] = 0;
+    ctx->c = 0;
+    ctx->outlen = outlen;
+}
+
 // Add "inlen" bytes from "in" into the hash.
 
 void rasta_blake2b_update(rasta_blake2b_ctx *ctx,
                           const void *in, size_t inlen)       // data bytes
 {
-    size_t i;
+    const uint8_t *data = (const uint8_t *) in;
+    size_t n;
 
-    for (i = 0; i < inlen; i++) {
+    while (inlen > 0) {
         if (ctx->c == 128) {            // buffer full ?
             ctx->t[0] += ctx->c;        // add counters
             if (ctx->t[0] < ctx->c)     // carry overflow ?
@@ -164,7 +190,13 @@ void rasta_blake2b_update(rasta_blake2b_ctx *ctx,
             blake2b_compress(ctx, 0);   // compress (not last)
             ctx->c = 0;                 // counter to zero
         }
-        ctx->b[ctx->c++] = ((const uint8_t *) in)[i];
+        n = 128 - ctx->c;               // copy as much as fits
+        if (n > inlen)
+            n = inlen;
+        memcpy(&ctx->b[ctx->c], data, n);
+        ctx->c += n;
+        data += n;
+        inlen -= n;
     }
 }
 
@@ -203,4 +235,153 @@ int rasta_blake2b(void *out, size_t outlen,
     rasta_blake2b_final(&ctx, out);
 
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * the words of BLAKE2B_LANES messages at the same position, one message per lane. The vector extension is translated
+ * to AVX2 if the compiler may use it, otherwise to SSE2 on x86 and NEON on ARM
+ */
+typedef uint64_t blake2b_lanes __attribute__((vector_size(BLAKE2B_LANES * sizeof(uint64_t))));
+
+/**
+ * compresses one 128-byte block of every lane, the same as blake2b_compress()
+ * @param h the chained state of the lanes
+ * @param m the 16 words of the block of every lane
+ * @param t the low and high 64 bits of the offset of every lane
+ * @param last all bits set for the lanes whose last block is compressed
+ */
+static void blake2b_compress_lanes(blake2b_lanes h[8], const blake2b_lanes m[16], const blake2b_lanes t[2],
+                                   const blake2b_lanes *last)
+{
+    int i;
+    blake2b_lanes v[16];
+
+    for (i = 0; i < 8; i++) {
+        v[i] = h[i];
+        v[i + 8] = (blake2b_lanes){ 0 } + blake2b_iv[i];
+    }
+    v[12] ^= t[0];
+    v[13] ^= t[1];
+    v[14] ^= *last;
+
+    for (i = 0; i < 12; i++) {
+        B2B_G( 0, 4,  8, 12, m[sigma[i][ 0]], m[sigma[i][ 1]]);
+        B2B_G( 1, 5,  9, 13, m[sigma[i][ 2]], m[sigma[i][ 3]]);
+        B2B_G( 2, 6, 10, 14, m[sigma[i][ 4]], m[sigma[i][ 5]]);
+        B2B_G( 3, 7, 11, 15, m[sigma[i][ 6]], m[sigma[i][ 7]]);
+        B2B_G( 0, 5, 10, 15, m[sigma[i][ 8]], m[sigma[i][ 9]]);
+        B2B_G( 1, 6, 11, 12, m[sigma[i][10]], m[sigma[i][11]]);
+        B2B_G( 2, 7,  8, 13, m[sigma[i][12]], m[sigma[i][13]]);
+        B2B_G( 3, 4,  9, 14, m[sigma[i][14]], m[sigma[i][15]]);
+    }
+
+    for (i = 0; i < 8; ++i)
+        h[i] ^= v[i] ^ v[i + 8];
+}
+
+/**
+ * hashes up to BLAKE2B_LANES messages at once
+ * @param ctx the state every message continues, no data may be buffered
+ * @param in the messages
+ * @param inlen the lengths of the messages
+ * @param count the amount of messages, at most BLAKE2B_LANES
+ * @param out the digests of the messages
+ */
+static void blake2b_lanes_hash(const rasta_blake2b_ctx *ctx, const unsigned char * const *in,
+                               const unsigned int *inlen, unsigned int count, unsigned char (*out)[64])
+{
+    blake2b_lanes h[8] = { { 0 } };
+    unsigned int blocks[BLAKE2B_LANES];
+    unsigned int max_blocks = 0;
+
+    for (int l = 0; l < BLAKE2B_LANES; l++) {
+        for (int i = 0; i < 8; i++)
+            h[i][l] = ctx->h[i];
+
+        // the last block is compressed even for an empty message, unused lanes do not compress any block
+        if ((unsigned int) l < count)
+            blocks[l] = (inlen[l] == 0) ? 1 : (inlen[l] + 127) / 128;
+        else
+            blocks[l] = 0;
+        if (blocks[l] > max_blocks)
+            max_blocks = blocks[l];
+    }
+
+    for (unsigned int index = 0; index < max_blocks; index++) {
+        uint8_t bytes[BLAKE2B_LANES][128];
+        blake2b_lanes m[16] = { { 0 } }, t[2] = { { 0 } }, last = { 0 }, active = { 0 };
+
+        for (int l = 0; l < BLAKE2B_LANES; l++) {
+            uint64_t offset = 0;
+
+            memset(bytes[l], 0, 128);
+            if (index < blocks[l]) {
+                size_t start = (size_t) index * 128;
+                size_t available = inlen[l] - start;
+                if (available > 128)
+                    available = 128;
+                if (available > 0)
+                    memcpy(bytes[l], in[l] + start, available);
+                offset = start + available;
+            }
+
+            // the offset includes the bytes of the current block, the last one is zero padded
+            t[0][l] = ctx->t[0] + offset;
+            t[1][l] = ctx->t[1] + (t[0][l] < offset);
+            active[l] = (index < blocks[l]) ? ~(uint64_t) 0 : 0;
+            last[l] = (index + 1 == blocks[l]) ? ~(uint64_t) 0 : 0;
+
+            for (int w = 0; w < 16; w++)
+                m[w][l] = B2B_GET64(&bytes[l][8 * w]);
+        }
+
+        blake2b_lanes updated[8];
+        for (int i = 0; i < 8; i++)
+            updated[i] = h[i];
+        blake2b_compress_lanes(updated, m, t, &last);
+
+        // lanes whose message is complete keep their state
+        for (int i = 0; i < 8; i++)
+            h[i] = (updated[i] & active) | (h[i] & ~active);
+    }
+
+    for (unsigned int l = 0; l < count; l++) {
+        for (size_t i = 0; i < ctx->outlen; i++)
+            out[l][i] = (h[i >> 3][l] >> (8 * (i & 7))) & 0xFF;
+    }
+}
+
+void rasta_blake2b_multi(const rasta_blake2b_ctx *ctx, const unsigned char * const *in, const unsigned int *inlen,
+                         unsigned int count, unsigned char (*out)[64])
+{
+    rasta_blake2b_ctx start = *ctx;
+    int key_block = (start.c == 128);
+
+    // a buffered key block is compressed once for all messages, this is only valid for messages that are not empty
+    rasta_blake2b_compress_key(&start);
+
+    if (start.c != 0) {
+        // the lanes only start at block boundaries
+        for (unsigned int i = 0; i < count; i++) {
+            rasta_blake2b_ctx copy = *ctx;
+            rasta_blake2b_update(&copy, in[i], inlen[i]);
+            rasta_blake2b_final(&copy, out[i]);
+        }
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; i += BLAKE2B_LANES) {
+        unsigned int lanes = (count - i < BLAKE2B_LANES) ? count - i : BLAKE2B_LANES;
+        blake2b_lanes_hash(&start, &in[i], &inlen[i], lanes, &out[i]);
+    }
+
+    if (key_block) {
+        // the key block is the last block of an empty message
+        for (unsigned int i = 0; i < count; i++) {
+            if (inlen[i] == 0) {
+                rasta_blake2b_ctx copy = *ctx;
+                rasta_blake2b_final(&copy, out[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
+#include "rastaconnectionpool.h"
+#include "rastahandle.h"
+#include "rasta_new.h"
+#include "rmemory.h"
+#include "rastaflightrecorder.h"
+
+/**
+ * alignment of the parts of a slot
+ */
+#define SLOT_PART_ALIGNMENT 16
+
+/**
+ * alignment of the slots in the slab, so two connections do not share a cache line
+ */
+#define SLOT_ALIGNMENT 64
+
+static size_t align_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void rasta_connection_pool_init(struct rasta_connection_pool * pool, struct RastaConfigInfoSending cfg, int residency,
+                                unsigned int flight_records) {
+    pool->diagnostic_interval_count = cfg.t_max / DIAGNOSTIC_INTERVAL_SIZE;
+    if (cfg.t_max % DIAGNOSTIC_INTERVAL_SIZE > 0) {
+        pool->diagnostic_interval_count++;
+    }
+    // the receive queue and the retransmission buffer hold a send window, the send queue its messages. With
+    // backpressure the receive queue also keeps room for the messages of the send window of the partner
+    pool->receive_queue_size = cfg.send_max + sr_receive_reserve(cfg);
+    pool->retransmission_count = cfg.send_max > 0 ? cfg.send_max : 1;
+    unsigned int send_queue_size = cfg.send_max * cfg.max_packet;
+    pool->send_queue_size = send_queue_size > 2 * cfg.max_packet ? send_queue_size : 2 * cfg.max_packet;
+    // the urgent lane holds the messages of the next two data packets
+    pool->urgent_queue_size = 2 * cfg.max_packet;
+
+    size_t size = align_up(pool->diagnostic_interval_count * sizeof(struct diagnostic_interval), SLOT_PART_ALIGNMENT);
+    pool->receive_queue_offset = size;
+    size += align_up(fifo_memory_size(pool->receive_queue_size), SLOT_PART_ALIGNMENT);
+    pool->send_queue_offset = size;
+    size += align_up(fifo_memory_size(pool->send_queue_size), SLOT_PART_ALIGNMENT);
+    pool->urgent_queue_offset = size;
+    size += align_up(fifo_memory_size(pool->urgent_queue_size), SLOT_PART_ALIGNMENT);
+    pool->retransmission_offset = size;
+    size += align_up(pool->retransmission_count * sizeof(struct rasta_retr_element), SLOT_PART_ALIGNMENT);
+    pool->residency_offset = 0;
+    if (residency) {
+        pool->residency_offset = size;
+        size += align_up(sizeof(struct rasta_residency_metrics), SLOT_PART_ALIGNMENT);
+    }
+    pool->flight_record_count = flight_records;
+    pool->flight_record_offset = size;
+    size += flight_records * sizeof(struct rasta_flight_record);
+    pool->slot_size = align_up(size, SLOT_ALIGNMENT);
+
+    pool->capacity = cfg.max_connections;
+    pool->free_count = cfg.max_connections;
+    if (pool->capacity == 0) {
+        pool->slab = NULL;
+        pool->free_slots = NULL;
+        return;
+    }
+
+    // rmalloc() aligns like malloc(), the slab is moved to the next cache line
+    pool->slab = rmalloc(pool->capacity * pool->slot_size + SLOT_ALIGNMENT);
+    pool->free_slots = rmalloc(pool->capacity * sizeof(unsigned int));
+    for (unsigned int i = 0; i < pool->capacity; i++) {
+        // the first slot is taken first
+        pool->free_slots[i] = pool->capacity - 1 - i;
+    }
+}
+
+/**
+ * @return the first slot of the slab
+ */
+static unsigned char * slab_start(struct rasta_connection_pool * pool) {
+    return (unsigned char *) align_up((size_t) pool->slab, SLOT_ALIGNMENT);
+}
+
+void rasta_connection_pool_free(struct rasta_connection_pool * pool) {
+    if (pool->slab != NULL) {
+        rfree(pool->slab);
+        rfree(pool->free_slots);
+        pool->slab = NULL;
+        pool->free_slots = NULL;
+    }
+    pool->capacity = 0;
+    pool->free_count = 0;
+}
+
+void rasta_connection_pool_reset(struct rasta_connection_pool * pool, void * memory, struct rasta_connection_slot * slot) {
+    unsigned char * base = memory;
+
+    slot->memory = memory;
+    slot->diagnostic_intervals = (struct diagnostic_interval *) base;
+    slot->fifo_app_msg = fifo_init_in(base + pool->receive_queue_offset, pool->receive_queue_size);
+    slot->fifo_send = fifo_init_in(base + pool->send_queue_offset, pool->send_queue_size);
+    slot->fifo_send_urgent = fifo_init_in(base + pool->urgent_queue_offset, pool->urgent_queue_size);
+    slot->retransmission_elements = (struct rasta_retr_element *) (base + pool->retransmission_offset);
+    slot->residency = NULL;
+    if (pool->residency_offset > 0) {
+        slot->residency = (struct rasta_residency_metrics *) (base + pool->residency_offset);
+        rmemset(slot->residency, 0, sizeof(struct rasta_residency_metrics));
+    }
+    // the records are only read up to the amount recorded, so they are not cleared
+    slot->flight_records = NULL;
+    if (pool->flight_record_count > 0) {
+        slot->flight_records = (struct rasta_flight_record *) (base + pool->flight_record_offset);
+    }
+}
+
+int rasta_connection_pool_take(struct rasta_connection_pool * pool, struct rasta_connection_slot * slot) {
+    void * memory;
+
+    if (pool->capacity == 0) {
+        memory = rmalloc(pool->slot_size);
+    } else if (pool->free_count == 0) {
+        return 0;
+    } else {
+        pool->free_count--;
+        memory = slab_start(pool) + pool->free_slots[pool->free_count] * pool->slot_size;
+    }
+
+    rasta_connection_pool_reset(pool, memory, slot);
+    return 1;
+}
+
+void rasta_connection_pool_release(struct rasta_connection_pool * pool, void * memory) {
+    if (memory == NULL) {
+        return;
+    }
+
+    if (pool->capacity == 0) {
+        rfree(memory);
+        return;
+    }
+    pool->free_slots[pool->free_count] = (unsigned int) (((unsigned char *) memory - slab_start(pool)) / pool->slot_size);
+    pool->free_count++;
+}
+
+size_t rasta_connection_pool_slot_size(struct rasta_connection_pool * pool) {
+    return pool->slot_size;
+}
@@ -1,5 +1,32 @@
+#include <stddef.h>
+#include <string.h>
 #include "rastacrc.h"
 
+/**
+ * the lookup tables of the standard options, generated at build time by tools/generate_crc_tables.c
+ */
+extern const uint32_t crc_table_opt_b[8][256];
+extern const uint32_t crc_table_opt_c[8][256];
+extern const uint32_t crc_table_opt_d[8][256];
+extern const uint32_t crc_table_opt_e[8][256];
+
+/**
+ * the amount of non-standard crc parameter sets whose tables are kept
+ */
+#define CRC_CUSTOM_TABLE_COUNT 4
+
+/**
+ * lookup tables for one set of non-standard crc parameters
+ */
+struct crc_custom_tables {
+    unsigned short width;
+    unsigned long polynom;
+    int refin;
+    uint32_t table[8][256];
+};
+
+static struct crc_custom_tables custom_tables[CRC_CUSTOM_TABLE_COUNT];
+static unsigned int custom_table_count = 0;
 
 /**
  * reflects the lower @p n bits
@@ -45,7 +72,8 @@ struct crc_options crc_init_opt_b(){
     options.crc_high_bit = (unsigned long)1<<(options.width-1);
 
 
-    options.is_table_generated=0;
+    options.table = crc_table_opt_b;
+    options.is_table_generated=1;
 
     return options;
 }
@@ -66,7 +94,8 @@ struct crc_options crc_init_opt_c(){
     options.crc_high_bit = (unsigned long)1<<(options.width-1);
 
 
-    options.is_table_generated=0;
+    options.table = crc_table_opt_c;
+    options.is_table_generated=1;
 
     return options;
 }
@@ -87,7 +116,8 @@ struct crc_options crc_init_opt_d(){
     options.crc_high_bit = (unsigned long)1<<(options.width-1);
 
 
-    options.is_table_generated=0;
+    options.table = crc_table_opt_d;
+    options.is_table_generated=1;
 
     return options;
 }
@@ -108,40 +138,179 @@ struct crc_options crc_init_opt_e(){
     options.crc_high_bit = (unsigned long)1<<(options.width-1);
 
 
-    options.is_table_generated=0;
+    options.table = crc_table_opt_e;
+    options.is_table_generated=1;
 
     return options;
 }
 
 
-void crc_generate_table(struct crc_options* options) {
-    // generate table
+/**
+ * calculates a single entry of the byte lookup table
+ * @param options the options which are used
+ * @param index the index of the entry
+ * @return the crc of the byte @p index
+ */
+static uint32_t crc_table_entry(const struct crc_options * options, unsigned int index) {
     unsigned long bit;
+    unsigned long crc=(unsigned long)index;
 
-    for (int i=0; i<256; i++) {
+    if (options->refin){
+        crc=reflect(crc, 8);
+    }
+    crc<<= options->width-8;
 
-        unsigned long crc=(unsigned long)i;
-        if (options->refin){
-            crc=reflect(crc, 8);
-        }
-        crc<<= options->width-8;
+    for (int j=0; j<8; j++) {
+        bit = crc & options->crc_high_bit;
+        crc<<= 1;
+        if (bit) crc^= options->polynom;
+    }
 
-        for (int j=0; j<8; j++) {
-            bit = crc & options->crc_high_bit;
-            crc<<= 1;
-            if (bit) crc^= options->polynom;
+    if (options->refin){
+        crc = reflect(crc, options->width);
+    }
+    crc&= options->crc_mask;
+
+    return (uint32_t) crc;
+}
+
+/**
+ * finds or generates the lookup tables for non-standard parameters
+ * @param options the options which the tables are generated for
+ * @return the tables or NULL if there is no space left for further parameters
+ */
+static const uint32_t (*get_custom_table(const struct crc_options * options))[256] {
+    for (unsigned int i = 0; i < custom_table_count; i++) {
+        struct crc_custom_tables * entry = &custom_tables[i];
+        if (entry->width == options->width && entry->polynom == options->polynom && entry->refin == options->refin) {
+            return (const uint32_t (*)[256]) entry->table;
         }
+    }
 
-        if (options->refin){
-            crc = reflect(crc, options->width);
+    if (custom_table_count == CRC_CUSTOM_TABLE_COUNT) {
+        return NULL;
+    }
+
+    struct crc_custom_tables * entry = &custom_tables[custom_table_count];
+    entry->width = options->width;
+    entry->polynom = options->polynom;
+    entry->refin = options->refin;
+
+    for (unsigned int i = 0; i < 256; i++) {
+        entry->table[0][i] = crc_table_entry(options, i);
+    }
+
+    // append a zero byte to the crc of the previous table
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t crc = entry->table[k-1][i];
+            if (options->refin) {
+                crc = (crc >> 8) ^ entry->table[0][crc & 0xff];
+            } else {
+                crc = ((crc << 8) & (uint32_t) options->crc_mask) ^ entry->table[0][(crc >> (options->width-8)) & 0xff];
+            }
+            entry->table[k][i] = crc;
         }
-        crc&= options->crc_mask;
-        options->table[i]= crc;
+    }
+
+    custom_table_count++;
+
+    return (const uint32_t (*)[256]) entry->table;
+}
+
+void crc_generate_table(struct crc_options* options) {
+    // the tables of the standard options are assigned by the init functions already
+    if (options->table == NULL && options->width >= 8 && options->width <= 32) {
+        options->table = get_custom_table(options);
     }
 
     options->is_table_generated = 1;
 }
-unsigned long crc_calculate(struct crc_options* options, struct RastaByteArray data) {
+
+/**
+ * processes the data 8 bytes at a time. The crc register is at most 4 bytes, so it is consumed completely by every
+ * step and the result is the xor of the table entries of all 8 (combined) bytes.
+ * Defines one function for reflected and one for normal input, so the loop does not branch on the options.
+ * The reflected register is consumed from the lowest byte, the normal one from the highest byte
+ * @param options the options which are used, the tables have to be available
+ * @param crc the current crc register
+ * @param data the data, the remaining bytes (less than 8) are left in it
+ * @return the crc register after processing the blocks
+ */
+#define DEFINE_CRC_SLICING(name, register_byte) \
+    static uint32_t name(const struct crc_options * options, uint32_t crc, struct RastaByteArray * data) { \
+        const uint32_t (*table)[256] = options->table; \
+        const unsigned int register_bytes = options->width / 8; \
+        while (data->length >= 8) { \
+            uint32_t next = 0; \
+            for (unsigned int j = 0; j < 8; j++) { \
+                unsigned int index = data->bytes[j]; \
+                if (j < register_bytes) { \
+                    index ^= (register_byte) & 0xff; \
+                } \
+                next ^= table[7-j][index]; \
+            } \
+            crc = next; \
+            data->bytes += 8; \
+            data->length -= 8; \
+        } \
+        return crc; \
+    }
+
+DEFINE_CRC_SLICING(crc_calculate_slicing_reflected, crc >> (8*j))
+DEFINE_CRC_SLICING(crc_calculate_slicing_normal, crc >> (options->width - 8*(j+1)))
+
+/**
+ * looks up the crc of a single byte, either in the table or by calculating it
+ * @param options the options which are used
+ * @param index the byte
+ * @return the crc of the byte
+ */
+static uint32_t crc_lookup(const struct crc_options * options, unsigned int index) {
+    return (options->table != NULL) ? options->table[0][index] : crc_table_entry(options, index);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/**
+ * continues a CRC as in 6.3.6 c) with the crc32 instruction of SSE4.2, which uses the same polynom. It consumes
+ * the reflected register from the lowest byte like crc_calculate_slicing_reflected()
+ * @param crc the current crc register
+ * @param bytes the data
+ * @param length the amount of bytes in @p bytes
+ * @return the crc register after processing the data
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc_calculate_sse42(uint32_t crc, const unsigned char * bytes, unsigned int length) {
+    uint64_t register_64 = crc;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        register_64 = __builtin_ia32_crc32di(register_64, word);
+        bytes += 8;
+        length -= 8;
+    }
+    crc = (uint32_t) register_64;
+    while (length--) {
+        crc = __builtin_ia32_crc32qi(crc, *bytes++);
+    }
+    return crc;
+}
+
+/**
+ * @param options the options which are used
+ * @return 1 if the CRC can be calculated by crc_calculate_sse42()
+ */
+static int crc_use_sse42(const struct crc_options * options) {
+    return options->table == crc_table_opt_c && __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+unsigned long crc_begin(struct crc_options * options) {
+    if (options->width == 0){
+        // no checksum
+        return 0;
+    }
+
     if (!options->is_table_generated){
         crc_generate_table(options);
     }
@@ -152,17 +321,63 @@ unsigned long crc_calculate(struct crc_options* options, struct RastaByteArray d
         crc = reflect(crc, options->width);
     }
 
-    if (!options->refin){
+    return crc & options->crc_mask;
+}
+
+unsigned long crc_update(struct crc_options * options, unsigned long crc, const unsigned char * bytes,
+                         unsigned int length) {
+    if (options->width == 0){
+        return 0;
+    }
+
+    struct RastaByteArray data;
+    data.bytes = (unsigned char *) bytes;
+    data.length = length;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (crc_use_sse42(options)){
+        return crc_calculate_sse42((uint32_t) crc, bytes, length);
+    }
+#endif
+
+    // only the lower width bits of the register are part of the crc
+    crc &= options->crc_mask;
+
+    if (options->table != NULL){
+        // the options are resolved once, the loops over the data only use the tables
+        const uint32_t * table = options->table[0];
+        if (options->refin){
+            crc = crc_calculate_slicing_reflected(options, (uint32_t) crc, &data);
+            while (data.length--){
+                crc = (crc >> 8) ^ table[(crc & 0xff) ^ *data.bytes++];
+            }
+        } else{
+            crc = crc_calculate_slicing_normal(options, (uint32_t) crc, &data);
+            const unsigned int shift = options->width - 8;
+            while (data.length--){
+                crc = (crc << 8) ^ table[((crc >> shift) & 0xff) ^ *data.bytes++];
+            }
+        }
+    } else if (!options->refin){
         while (data.length--){
-            crc = (crc << 8) ^ options->table[ ((crc >> (options->width-8)) & 0xff) ^ *data.bytes++];
+            crc = (crc << 8) ^ crc_lookup(options, ((crc >> (options->width-8)) & 0xff) ^ *data.bytes++);
         }
     }
     else{
         while (data.length--){
-            crc = (crc >> 8) ^ options->table[ (crc & 0xff) ^ *data.bytes++];
+            crc = (crc >> 8) ^ crc_lookup(options, (crc & 0xff) ^ *data.bytes++);
         }
     }
 
+    return crc;
+}
+
+unsigned long crc_end(struct crc_options * options, unsigned long crc) {
+    if (options->width == 0){
+        return 0;
+    }
+
+    crc &= options->crc_mask;
     if (options->refout ^ options->refin){
         crc = reflect(crc, options->width);
     }
@@ -170,4 +385,10 @@ unsigned long crc_calculate(struct crc_options* options, struct RastaByteArray d
     crc&= options->crc_mask;
 
     return crc;
-}
\ No newline at end of file
+}
+
+unsigned long crc_calculate(struct crc_options* options, struct RastaByteArray data) {
+    unsigned long crc = crc_begin(options);
+    crc = crc_update(options, crc, data.bytes, data.length);
+    return crc_end(options, crc);
+}
@@ -1,7 +1,42 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_REDUNDANCY
 #include <stdlib.h>
 #include "rmemory.h"
 #include "rastadeferqueue.h"
 
+/**
+ * calculates the home slot of a sequence number in the sequence number table.
+ * Sequence numbers in the queue are close to each other, so the low bits spread them without collisions
+ * @param queue the queue that is used
+ * @param seq_nr the sequence number
+ * @return the index in queue#seq_slots where the search for @p seq_nr starts
+ */
+static unsigned int home_slot(struct defer_queue * queue, unsigned long seq_nr){
+    return (unsigned int)(seq_nr & queue->slot_mask);
+}
+
+/**
+ * finds the slot of a given element inside the sequence number table of the given queue.
+ * The sequence_number is used as the unique identifier
+ * @param queue the queue that will be searched
+ * @param seq_nr the sequence number to be located
+ * @return -1 if there is no element with the specified @p seq_nr, index in queue#seq_slots of the element otherwise
+ */
+static int find_slot(struct defer_queue * queue, unsigned long seq_nr){
+    if (queue->count == 0){
+        return -1;
+    }
+
+    unsigned int slot = home_slot(queue, seq_nr);
+    while (queue->seq_slots[slot] != -1){
+        if (queue->elements[queue->seq_slots[slot]].packet.sequence_number == seq_nr){
+            return (int)slot;
+        }
+        slot = (slot + 1) & queue->slot_mask;
+    }
+
+    return -1;
+}
+
 /**
  * finds the index of a given element inside the given queue.
  * The sequence_number is used as the unique identifier
@@ -9,28 +44,56 @@
  * @param seq_nr the sequence number to be located
  * @return -1 if there is no element with the specified @p seq_nr, index of the element otherwise
  */
-int find_index(struct defer_queue* queue, unsigned long seq_nr){
-    unsigned int index = 0;
-
-    // naive implementation of search. performance shouldn't be an issue as the amount of messages in the queue is small
-    while ( index < queue->max_count && queue->elements[index].packet.sequence_number != seq_nr ) ++index;
+static int find_index(struct defer_queue * queue, unsigned long seq_nr){
+    int slot = find_slot(queue, seq_nr);
 
-    return ( index == queue->max_count ? -1 : (int)index );
+    return (slot == -1 ? -1 : queue->seq_slots[slot]);
 }
 
-int cmpfkt(const void * a, const void * b){
-    long long a_ts = (long long)((struct rasta_redundancy_packet_wrapper*)a)->received_timestamp;
-    long long b_ts = (long long)((struct rasta_redundancy_packet_wrapper*)b)->received_timestamp;
+/**
+ * frees a slot of the sequence number table. Following entries of the same probe sequence are moved up, so no
+ * tombstones are needed
+ * @param queue the queue that is used
+ * @param slot the slot that is freed
+ */
+static void free_slot(struct defer_queue * queue, unsigned int slot){
+    unsigned int next = slot;
 
-    return (int) (a_ts - b_ts);
+    while (1){
+        next = (next + 1) & queue->slot_mask;
+        if (queue->seq_slots[next] == -1){
+            break;
+        }
+
+        unsigned int home = home_slot(queue, queue->elements[queue->seq_slots[next]].packet.sequence_number);
+        // the entry at next can fill the gap if its home slot is not between the gap and next (cyclic)
+        if (((next - home) & queue->slot_mask) >= ((next - slot) & queue->slot_mask)){
+            queue->seq_slots[slot] = queue->seq_slots[next];
+            slot = next;
+        }
+    }
+
+    queue->seq_slots[slot] = -1;
 }
 
 /**
- * sorts the elements in the queue in ascending time (first element has oldest timestamp)
- * @param queue the queue that will be sorted
+ * marks all elements as unused and empties the sequence number table
+ * @param queue the queue that will be reset
  */
-void sort(struct defer_queue * queue){
-    qsort(queue->elements, queue->count, sizeof(struct rasta_redundancy_packet_wrapper), cmpfkt);
+static void reset(struct defer_queue * queue){
+    for (unsigned int i = 0; i <= queue->slot_mask; ++i) {
+        queue->seq_slots[i] = -1;
+    }
+
+    for (unsigned int i = 0; i < queue->max_count; ++i) {
+        queue->elements[i].newer = (i + 1 < queue->max_count) ? (int)(i + 1) : -1;
+        queue->elements[i].older = -1;
+    }
+
+    queue->free_list = (queue->max_count > 0) ? 0 : -1;
+    queue->oldest = -1;
+    queue->newest = -1;
+    queue->count = 0;
 }
 
 struct defer_queue deferqueue_init(unsigned int n_max){
@@ -39,12 +102,20 @@ struct defer_queue deferqueue_init(unsigned int n_max){
     // allocate the array
     queue.elements = rmalloc(n_max * sizeof(struct rasta_redundancy_packet_wrapper));
 
-    // set count to 0
-    queue.count = 0;
+    // the table has at least twice as many slots as there are elements, so the probe sequences stay short
+    unsigned int slot_count = 2;
+    while (slot_count < 2 * n_max) {
+        slot_count *= 2;
+    }
+    queue.seq_slots = rmalloc(slot_count * sizeof(int));
+    queue.slot_mask = slot_count - 1;
 
     // set max count
     queue.max_count = n_max;
 
+    // set count to 0
+    reset(&queue);
+
     return queue;
 }
 
@@ -55,60 +126,156 @@ int deferqueue_isfull(struct defer_queue * queue) {
     return result;
 }
 
-void deferqueue_add(struct defer_queue * queue, struct RastaRedundancyPacket packet, unsigned long recv_ts){
+void deferqueue_add(struct defer_queue * queue, const struct RastaRedundancyPacket * packet, unsigned long recv_ts){
+    deferqueue_add_received(queue, packet, recv_ts, 0);
+}
+
+void deferqueue_add_received(struct defer_queue * queue, const struct RastaRedundancyPacket * packet,
+                             unsigned long recv_ts, uint64_t received_ns){
     if((queue->count == queue->max_count)){
         // queue full, return
         return;
     }
 
-    struct rasta_redundancy_packet_wrapper element;
-    element.packet = packet;
-    element.received_timestamp = recv_ts;
+    if (find_slot(queue, packet->sequence_number) != -1){
+        // element already in queue
+        return;
+    }
+
+    // take an unused element
+    int index = queue->free_list;
+    struct rasta_redundancy_packet_wrapper * element = &queue->elements[index];
+    queue->free_list = element->newer;
+
+    element->packet = *packet;
+    element->received_timestamp = recv_ts;
+    element->received_ns = received_ns;
 
-    // add element to the end
-    queue->elements[queue->count] = element;
+    // find the position in time order. PDUs are usually added in the order they are received, so this search
+    // stops at the newest element
+    int older = queue->newest;
+    while (older != -1 && queue->elements[older].received_timestamp > recv_ts){
+        older = queue->elements[older].older;
+    }
+
+    element->older = older;
+    if (older == -1){
+        element->newer = queue->oldest;
+        queue->oldest = index;
+    } else{
+        element->newer = queue->elements[older].newer;
+        queue->elements[older].newer = index;
+    }
+
+    if (element->newer == -1){
+        queue->newest = index;
+    } else{
+        queue->elements[element->newer].older = index;
+    }
+
+    // add to the sequence number table
+    unsigned int slot = home_slot(queue, packet->sequence_number);
+    while (queue->seq_slots[slot] != -1){
+        slot = (slot + 1) & queue->slot_mask;
+    }
+    queue->seq_slots[slot] = index;
 
     // increase count
     queue->count = queue->count + 1;
+}
+
+/**
+ * removes the element of a slot of the sequence number table from the queue
+ * @param queue the queue that is used
+ * @param slot the slot of the element in queue#seq_slots
+ */
+static void remove_slot(struct defer_queue * queue, int slot){
+    int index = queue->seq_slots[slot];
+    struct rasta_redundancy_packet_wrapper * element = &queue->elements[index];
+
+    free_slot(queue, (unsigned int)slot);
+
+    // unlink from time order
+    if (element->older == -1){
+        queue->oldest = element->newer;
+    } else{
+        queue->elements[element->older].newer = element->newer;
+    }
 
-    // sort array
-    sort(queue);
+    if (element->newer == -1){
+        queue->newest = element->older;
+    } else{
+        queue->elements[element->newer].older = element->older;
+    }
+
+    // return the element to the unused elements
+    element->newer = queue->free_list;
+    element->older = -1;
+    queue->free_list = index;
+
+    // decrease counter
+    queue->count = queue->count -1;
 }
 
 void deferqueue_remove(struct defer_queue * queue, unsigned long seq_nr){
-    int index = find_index(queue, seq_nr);
-    if (index < 0){
+    int slot = find_slot(queue, seq_nr);
+    if (slot < 0){
         // element not in queue
         return;
     }
 
-    if ((unsigned int)index != (queue->count - 1)){
-        // element to delete isn't at the last position
-        // to be able to add the next element to the last position without overriding something
-        // the currently last element is moved to the index where the element to delete is located
-        queue->elements[index] = queue->elements[queue->count-1];
-    }
+    remove_slot(queue, slot);
+}
 
-    // decrease counter
-    queue->count = queue->count -1;
+int deferqueue_take(struct defer_queue * queue, unsigned long seq_nr, struct RastaRedundancyPacket * out){
+    uint64_t received_ns;
+    return deferqueue_take_received(queue, seq_nr, out, &received_ns);
+}
+
+int deferqueue_take_received(struct defer_queue * queue, unsigned long seq_nr, struct RastaRedundancyPacket * out,
+                             uint64_t * received_ns){
+    int slot = find_slot(queue, seq_nr);
+    if (slot < 0){
+        return 0;
+    }
 
-    // sort the array
-    sort(queue);
+    *out = queue->elements[queue->seq_slots[slot]].packet;
+    *received_ns = queue->elements[queue->seq_slots[slot]].received_ns;
+    remove_slot(queue, slot);
+    return 1;
 }
 
 int deferqueue_contains(struct defer_queue * queue, unsigned long seq_nr){
-    int result = (find_index(queue, seq_nr) != -1);
+    int result = (find_slot(queue, seq_nr) != -1);
 
     return result;
 }
 
 void deferqueue_destroy(struct defer_queue * queue){
     rfree(queue->elements);
+    rfree(queue->seq_slots);
 
     queue->count = 0;
     queue->max_count= 0;
 }
 
+int deferqueue_resize(struct defer_queue * queue, unsigned int n_max){
+    if (queue->count > n_max){
+        return 0;
+    }
+
+    // the elements are added oldest first, so each one is appended to the time order
+    struct defer_queue resized = deferqueue_init(n_max);
+    for (int i = queue->oldest; i != -1; i = queue->elements[i].newer) {
+        deferqueue_add_received(&resized, &queue->elements[i].packet, queue->elements[i].received_timestamp,
+                                queue->elements[i].received_ns);
+    }
+
+    deferqueue_destroy(queue);
+    *queue = resized;
+    return 1;
+}
+
 int deferqueue_smallest_seqnr(struct defer_queue * queue){
 
     int index = 0;
@@ -116,8 +283,8 @@ int deferqueue_smallest_seqnr(struct defer_queue * queue){
     // largest number possible
     unsigned long smallest = 0xFFFFFFFF;
 
-    // naive implementation of search. performance shouldn't be an issue as the amount of messages in the queue is small
-    for (unsigned int i = 0; i < queue->max_count; ++i) {
+    // only called on timeouts, a linear search over the stored elements is sufficient
+    for (int i = queue->oldest; i != -1; i = queue->elements[i].newer) {
         if(queue->elements[i].packet.sequence_number < smallest){
             smallest = queue->elements[i].packet.sequence_number;
             index = i;
@@ -152,7 +319,23 @@ unsigned long deferqueue_get_ts(struct defer_queue * queue, unsigned long seq_nr
     return result;
 }
 
+struct rasta_redundancy_packet_wrapper * deferqueue_first(struct defer_queue * queue){
+    if (queue->oldest == -1){
+        return NULL;
+    }
+
+    return &queue->elements[queue->oldest];
+}
+
+struct rasta_redundancy_packet_wrapper * deferqueue_next(struct defer_queue * queue,
+                                                          struct rasta_redundancy_packet_wrapper * element){
+    if (element->newer == -1){
+        return NULL;
+    }
+
+    return &queue->elements[element->newer];
+}
+
 void deferqueue_clear(struct defer_queue * queue){
-    // just set count to 0, elements that are in the queue will be overridden
-    queue->count = 0;
+    reset(queue);
 }
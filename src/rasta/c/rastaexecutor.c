@@ -0,0 +1,180 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "rastaexecutor.h"
+#include "rmemory.h"
+
+/**
+ * a queued record and the function that runs it
+ */
+struct rasta_callback_slot {
+    rasta_callback_run_ptr run;
+    union {
+        // the records hold pointers and integers, the alignment of the union is enough for them
+        void * pointer;
+        unsigned long number;
+        double real;
+    } align;
+    unsigned char record[];
+};
+
+/**
+ * signals the eventfd unless it is signaled already
+ * @param executor the executor
+ */
+static void executor_signal(struct rasta_callback_executor * executor) {
+    if (!__atomic_exchange_n(&executor->signaled, 1, __ATOMIC_SEQ_CST)) {
+        uint64_t value = 1;
+        // can only fail if the counter would overflow, the consumers are woken up in that case anyway
+        ssize_t written = write(executor->notify_fd, &value, sizeof(value));
+        (void) written;
+    }
+}
+
+/**
+ * runs the queued callbacks until the executor is destroyed
+ * @param carry_data the executor
+ * @return NULL
+ */
+static void * executor_run_thread(void * carry_data) {
+    struct rasta_callback_executor * executor = carry_data;
+    struct pollfd waiting = {.fd = executor->notify_fd, .events = POLLIN};
+
+    while (!__atomic_load_n(&executor->stopping, __ATOMIC_ACQUIRE)) {
+        if (poll(&waiting, 1, -1) < 0 && errno != EINTR) {
+            perror("Could not wait for callbacks");
+            break;
+        }
+        rasta_callback_executor_run(executor, UINT_MAX);
+    }
+    return NULL;
+}
+
+void rasta_callback_executor_init(struct rasta_callback_executor * executor, unsigned int capacity, size_t record_size,
+                                  int start_thread) {
+    if (record_size < RASTA_CALLBACK_RECORD_MIN_SIZE) {
+        record_size = RASTA_CALLBACK_RECORD_MIN_SIZE;
+    }
+    // the slots follow each other in the queue, every record has to start aligned
+    record_size = (record_size + sizeof(unsigned long) - 1) & ~(sizeof(unsigned long) - 1);
+    executor->record_size = record_size;
+    executor->queue = mpsc_queue_init(capacity,
+                                      (unsigned int) (offsetof(struct rasta_callback_slot, record) + record_size));
+
+    executor->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (executor->notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+    executor->signaled = 0;
+
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&executor->lock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    executor->depth = 0;
+
+    executor->queued = 0;
+    executor->coalesced = 0;
+    executor->overflows = 0;
+
+    executor->stopping = 0;
+    executor->has_thread = start_thread;
+    if (start_thread && pthread_create(&executor->thread, NULL, executor_run_thread, executor) != 0) {
+        perror("Could not create callback thread");
+        exit(1);
+    }
+}
+
+void rasta_callback_executor_destroy(struct rasta_callback_executor * executor) {
+    if (executor->has_thread) {
+        __atomic_store_n(&executor->stopping, 1, __ATOMIC_RELEASE);
+        uint64_t value = 1;
+        ssize_t written = write(executor->notify_fd, &value, sizeof(value));
+        (void) written;
+        pthread_join(executor->thread, NULL);
+        executor->has_thread = 0;
+    }
+
+    // the queued records may hold resources of the application, e.g. received messages it still has to take
+    rasta_callback_executor_run(executor, UINT_MAX);
+
+    close(executor->notify_fd);
+    executor->notify_fd = -1;
+    mpsc_queue_destroy(executor->queue);
+    executor->queue = NULL;
+    pthread_mutex_destroy(&executor->lock);
+}
+
+void rasta_callback_executor_submit(struct rasta_callback_executor * executor, rasta_callback_run_ptr run,
+                                    const void * record, size_t size) {
+    struct rasta_callback_slot * slot = mpsc_queue_reserve(executor->queue);
+    if (slot == NULL) {
+        __atomic_add_fetch(&executor->overflows, 1, __ATOMIC_RELAXED);
+        // the oldest callbacks run on this thread until there is room, so the order of the notifications is kept
+        while ((slot = mpsc_queue_reserve(executor->queue)) == NULL) {
+            if (rasta_callback_executor_run(executor, 1) == 0) {
+                break;
+            }
+        }
+    }
+
+    if (slot == NULL) {
+        // submitted from a callback of this thread while the queue is full, the queued callbacks can not run before
+        // the callback returns
+        run((void *) record);
+        return;
+    }
+
+    memcpy(slot->record, record, size);
+    slot->run = run;
+    mpsc_queue_commit(executor->queue, slot);
+    __atomic_add_fetch(&executor->queued, 1, __ATOMIC_RELAXED);
+
+    executor_signal(executor);
+}
+
+void rasta_callback_executor_coalesced(struct rasta_callback_executor * executor) {
+    __atomic_add_fetch(&executor->coalesced, 1, __ATOMIC_RELAXED);
+}
+
+unsigned int rasta_callback_executor_run(struct rasta_callback_executor * executor, unsigned int max) {
+    pthread_mutex_lock(&executor->lock);
+    if (executor->depth > 0) {
+        // called from a callback, the queued records run after it returned
+        pthread_mutex_unlock(&executor->lock);
+        return 0;
+    }
+    executor->depth++;
+
+    // the signal is taken before the queue is read, so a record that is submitted meanwhile signals the eventfd again
+    __atomic_store_n(&executor->signaled, 0, __ATOMIC_SEQ_CST);
+    uint64_t count;
+    ssize_t ignore = read(executor->notify_fd, &count, sizeof(count));
+    (void) ignore;
+
+    unsigned int ran = 0;
+    struct rasta_callback_slot * slot;
+    while (ran < max && (slot = mpsc_queue_front(executor->queue)) != NULL) {
+        // the record is run in place, the slot is only handed back to the producers afterwards
+        slot->run(slot->record);
+        mpsc_queue_release(executor->queue);
+        ran++;
+    }
+
+    if (mpsc_queue_front(executor->queue) != NULL) {
+        executor_signal(executor);
+    }
+
+    executor->depth--;
+    pthread_mutex_unlock(&executor->lock);
+    return ran;
+}
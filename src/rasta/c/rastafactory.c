@@ -2,7 +2,9 @@
 // Created by tobia on 29.11.2017.
 //
 
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_CODEC
 #include "rastafactory.h"
+#include "rastawire.h"
 #include "rmemory.h"
 #include <stdlib.h>
 
@@ -68,11 +70,8 @@ struct RastaPacket initializePacket(rasta_conn_type type, uint32_t receiver_id,
         result.checksum.length = 0;
     }
 
-    //calculate the length of the packet
-    //static length: 28
-    //checksum length: {0,8,16}
-    //data length= data_length
-    result.length = (uint16_t)(28 + 8 * hashing_context->hash_length + data_length);
+    //calculate the length of the packet, the safety code has 0, 8 or 16 bytes
+    result.length = (uint16_t) rasta_sr_pdu_length(data_length, 8 * hashing_context->hash_length);
 
     return result;
 }
@@ -81,26 +80,21 @@ struct RastaPacket createConnectionRequest(uint32_t receiver_id, uint32_t sender
                                            uint32_t timestamp, uint16_t send_max,
                                            const unsigned char version[4], rasta_hashing_context_t * hashing_context) {
 
-    struct RastaPacket p = initializePacket(RASTA_TYPE_CONNREQ,receiver_id,sender_id,initial_sequence_number,0,timestamp,0,14, hashing_context);
+    struct RastaPacket p = initializePacket(RASTA_TYPE_CONNREQ,receiver_id,sender_id,initial_sequence_number,0,timestamp,0,RASTA_CONN_DATA_LENGTH, hashing_context);
 
 
 
     //insert protocol version 03.03. (§10 in ISO)
 
-    p.data.bytes[0] = version[0];
-    p.data.bytes[1] = version[1];
-    p.data.bytes[2] = version[2];
-    p.data.bytes[3] = version[3];
+    rmemcpy(&p.data.bytes[RASTA_CONN_DATA_OFFSET_VERSION], version, RASTA_CONN_DATA_VERSION_LENGTH);
 
     //insert sendmax
 
-    hostShortTole(send_max,&p.data.bytes[4]);
+    rasta_wire_put_u16(&p.data.bytes[RASTA_CONN_DATA_OFFSET_SEND_MAX], send_max);
 
     //insert zeros
 
-    for (int i = 6; i <= 13; i++) {
-        p.data.bytes[i] = 0x00;
-    }
+    rmemset(&p.data.bytes[RASTA_CONN_DATA_OFFSET_RESERVE], 0, RASTA_CONN_DATA_LENGTH - RASTA_CONN_DATA_OFFSET_RESERVE);
 
     return  p;
 
@@ -110,24 +104,19 @@ struct RastaPacket createConnectionResponse(uint32_t receiver_id, uint32_t sende
                                             uint32_t timestamp, uint32_t confirmed_timestamp, uint16_t send_max,
                                             const unsigned char version[4], rasta_hashing_context_t * hashing_context) {
     struct RastaPacket p = initializePacket(RASTA_TYPE_CONNRESP,receiver_id,sender_id,initial_sequence_number,
-            confirmed_sequence_number,timestamp,confirmed_timestamp,14,hashing_context);
+            confirmed_sequence_number,timestamp,confirmed_timestamp,RASTA_CONN_DATA_LENGTH,hashing_context);
 
     //insert protocol version 03.03. (§10 in ISO)
 
-    p.data.bytes[0] = version[0];
-    p.data.bytes[1] = version[1];
-    p.data.bytes[2] = version[2];
-    p.data.bytes[3] = version[3];
+    rmemcpy(&p.data.bytes[RASTA_CONN_DATA_OFFSET_VERSION], version, RASTA_CONN_DATA_VERSION_LENGTH);
 
     //insert sendmax
 
-    hostShortTole(send_max,&p.data.bytes[4]);
+    rasta_wire_put_u16(&p.data.bytes[RASTA_CONN_DATA_OFFSET_SEND_MAX], send_max);
 
     //insert zeros
 
-    for (int i = 6; i <= 13; i++) {
-        p.data.bytes[i] = 0x00;
-    }
+    rmemset(&p.data.bytes[RASTA_CONN_DATA_OFFSET_RESERVE], 0, RASTA_CONN_DATA_LENGTH - RASTA_CONN_DATA_OFFSET_RESERVE);
 
     return  p;
 
@@ -136,14 +125,20 @@ struct RastaPacket createConnectionResponse(uint32_t receiver_id, uint32_t sende
 #ifdef ENABLE_OPAQUE
 struct RastaPacket createKexRequest(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
                                     uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const char *psk, struct key_exchange_state *kex_state, struct logger_t *logger) {
-    struct RastaPacket p = initializePacket(RASTA_TYPE_KEX_REQUEST,receiver_id,sender_id,sequence_number,
-                                            confirmed_sequence_number,timestamp,confirmed_timestamp,sizeof(kex_state->client_public), hashing_context);
     int ret = key_exchange_prepare_credential_request(kex_state,psk,logger);
     if(ret) {
         logger_log(logger,LOG_LEVEL_ERROR,"createKexRequest","kex_exchange_prepare_credential_request failed!");
         abort();
     }
 
+    return createPreparedKexRequest(receiver_id,sender_id,sequence_number,confirmed_sequence_number,timestamp,confirmed_timestamp,hashing_context,kex_state);
+}
+
+struct RastaPacket createPreparedKexRequest(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
+                                            uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const struct key_exchange_state *kex_state) {
+    struct RastaPacket p = initializePacket(RASTA_TYPE_KEX_REQUEST,receiver_id,sender_id,sequence_number,
+                                            confirmed_sequence_number,timestamp,confirmed_timestamp,sizeof(kex_state->client_public), hashing_context);
+
     memcpy(&p.data.bytes[0],kex_state->client_public,sizeof(kex_state->client_public));
 
     return p;
@@ -171,9 +166,6 @@ struct RastaPacket createKexExchangeRequest(uint32_t receiver_id, uint32_t sende
 #ifdef ENABLE_OPAQUE
 struct RastaPacket createKexResponse(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
                                      uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const char *psk, const uint8_t *received_client_kex_request, size_t client_kex_request_length, uint32_t initial_sequence_number, struct key_exchange_state *kex_state, const struct RastaConfigKex *kex_config, struct logger_t *logger) {
-    struct RastaPacket p = initializePacket(RASTA_TYPE_KEX_RESPONSE,receiver_id,sender_id,sequence_number,
-                                            confirmed_sequence_number,timestamp,confirmed_timestamp,sizeof(kex_state->certificate_response), hashing_context);
-
     int ret;
 
     if(kex_config->has_psk_record){
@@ -202,6 +194,14 @@ struct RastaPacket createKexResponse(uint32_t receiver_id, uint32_t sender_id, u
         abort();
     }
 
+    return createPreparedKexResponse(receiver_id,sender_id,sequence_number,confirmed_sequence_number,timestamp,confirmed_timestamp,hashing_context,kex_state);
+}
+
+struct RastaPacket createPreparedKexResponse(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
+                                             uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const struct key_exchange_state *kex_state) {
+    struct RastaPacket p = initializePacket(RASTA_TYPE_KEX_RESPONSE,receiver_id,sender_id,sequence_number,
+                                            confirmed_sequence_number,timestamp,confirmed_timestamp,sizeof(kex_state->certificate_response), hashing_context);
+
     memcpy(&p.data.bytes[0],kex_state->certificate_response,sizeof(kex_state->certificate_response));
 
     return p;
@@ -265,15 +265,12 @@ struct RastaConnectionData extractRastaConnectionData(struct RastaPacket p) {
 
 
 
-    if (p.data.length == 14) {
+    if (p.data.length == RASTA_CONN_DATA_LENGTH) {
 
         //extract version
-        result.version [0] = p.data.bytes[0];
-        result.version [1] = p.data.bytes[1];
-        result.version [2] = p.data.bytes[2];
-        result.version [3] = p.data.bytes[3];
+        rmemcpy(result.version, &p.data.bytes[RASTA_CONN_DATA_OFFSET_VERSION], RASTA_CONN_DATA_VERSION_LENGTH);
 
-        result.send_max = leShortToHost(&p.data.bytes[4]);
+        result.send_max = rasta_wire_get_u16(&p.data.bytes[RASTA_CONN_DATA_OFFSET_SEND_MAX]);
     }
     else {
         result.send_max = 0;
@@ -301,13 +298,13 @@ struct RastaPacket createRetransmissionResponse(uint32_t receiver_id, uint32_t s
 struct RastaPacket createDisconnectionRequest(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
                                               uint32_t timestamp, uint32_t confirmed_timestamp, struct RastaDisconnectionData data, rasta_hashing_context_t * hashing_context) {
     struct RastaPacket p = initializePacket(RASTA_TYPE_DISCREQ,receiver_id,sender_id,sequence_number,
-            confirmed_sequence_number,timestamp,confirmed_timestamp,4, hashing_context);
+            confirmed_sequence_number,timestamp,confirmed_timestamp,RASTA_DISC_DATA_LENGTH, hashing_context);
 
     //Details
-    hostShortTole(data.details,&p.data.bytes[0]);
+    rasta_wire_put_u16(&p.data.bytes[RASTA_DISC_DATA_OFFSET_DETAILS], data.details);
 
     //Reason
-    hostShortTole(data.reason,&p.data.bytes[2]);
+    rasta_wire_put_u16(&p.data.bytes[RASTA_DISC_DATA_OFFSET_REASON], data.reason);
 
     return p;
 }
@@ -316,13 +313,13 @@ struct RastaPacket createDisconnectionRequest(uint32_t receiver_id, uint32_t sen
 struct RastaDisconnectionData extractRastaDisconnectionData(struct RastaPacket p) {
     struct RastaDisconnectionData result;
 
-    if (p.data.length == 4) {
+    if (p.data.length == RASTA_DISC_DATA_LENGTH) {
 
         //details
-        result.details = leShortToHost(&p.data.bytes[0]);
+        result.details = rasta_wire_get_u16(&p.data.bytes[RASTA_DISC_DATA_OFFSET_DETAILS]);
 
         //reason
-        result.reason = leShortToHost(&p.data.bytes[2]);
+        result.reason = rasta_wire_get_u16(&p.data.bytes[RASTA_DISC_DATA_OFFSET_REASON]);
     }
     else {
         result.details = 0;
@@ -350,7 +347,7 @@ struct RastaPacket createDataMessage(uint32_t receiver_id, uint32_t sender_id, u
         message_length += data.data_array[i].length;
     }
 
-    message_length = message_length + 2*data.count;
+    message_length = message_length + RASTA_MESSAGE_LENGTH_PREFIX * data.count;
 
     struct RastaPacket p = initializePacket(RASTA_TYPE_DATA,receiver_id, sender_id,sequence_number,
             confirmed_sequence_number,timestamp,confirmed_timestamp,message_length, hashing_context);
@@ -360,13 +357,11 @@ struct RastaPacket createDataMessage(uint32_t receiver_id, uint32_t sender_id, u
 
     for (unsigned int i = 0; i < data.count; i++) {
 
-        hostShortTole((unsigned short)data.data_array[i].length, &p.data.bytes[0+message_length]);
-
-        for (unsigned int j = 0; j < data.data_array[i].length; j++) {
-            p.data.bytes[2+message_length+j] = data.data_array[i].bytes[j];
-        }
+        rasta_wire_put_u16(&p.data.bytes[message_length], (uint16_t) data.data_array[i].length);
+        rmemcpy(&p.data.bytes[message_length + RASTA_MESSAGE_LENGTH_PREFIX], data.data_array[i].bytes,
+                data.data_array[i].length);
 
-        message_length += data.data_array[i].length + 2;
+        message_length += data.data_array[i].length + RASTA_MESSAGE_LENGTH_PREFIX;
     }
 
     return p;
@@ -376,38 +371,55 @@ struct RastaPacket createDataMessage(uint32_t receiver_id, uint32_t sender_id, u
 
 
 
+void rastaMessageIteratorInit(struct RastaMessageIterator * iterator, const unsigned char * data, unsigned int length) {
+    iterator->bytes = data;
+    iterator->length = length;
+    iterator->position = 0;
+}
+
+int rastaMessageIteratorNext(struct RastaMessageIterator * iterator, const unsigned char ** message, unsigned int * message_length) {
+    // every message is prefixed with its length
+    if (iterator->position + RASTA_MESSAGE_LENGTH_PREFIX > iterator->length) {
+        return 0;
+    }
+
+    const uint16_t length = rasta_wire_get_u16(&iterator->bytes[iterator->position]);
+    if (iterator->position + RASTA_MESSAGE_LENGTH_PREFIX + length > iterator->length) {
+        // message exceeds the data, stop here
+        iterator->position = iterator->length;
+        return 0;
+    }
+
+    *message = &iterator->bytes[iterator->position + RASTA_MESSAGE_LENGTH_PREFIX];
+    *message_length = length;
+    iterator->position += length + RASTA_MESSAGE_LENGTH_PREFIX;
+
+    return 1;
+}
+
 struct RastaMessageData extractMessageData(struct RastaPacket p) {
-    unsigned int current_length = 0;
+    struct RastaMessageIterator iterator;
+    const unsigned char * message;
+    unsigned int message_length;
     unsigned int counter = 0;
 
-    while (current_length < p.data.length) {
-        const uint16_t length = leShortToHost(&p.data.bytes[0+current_length]);
-
-        current_length += length + 2;
+    rastaMessageIteratorInit(&iterator, p.data.bytes, p.data.length);
+    while (rastaMessageIteratorNext(&iterator, &message, &message_length)) {
         counter++;
     }
 
     struct RastaMessageData result;
     allocateRastaMessageData(&result,counter);
 
-    current_length = 0;
-
+    rastaMessageIteratorInit(&iterator, p.data.bytes, p.data.length);
     for(unsigned int i = 0; i < result.count; i++) {
-        const uint16_t length = leShortToHost(&p.data.bytes[0+current_length]);
-
-        allocateRastaByteArray(&result.data_array[i],length);
-
-        for (int j = 0; j < length; j++) {
-            result.data_array[i].bytes[j] = p.data.bytes[2+current_length+j];
-        }
-
-        current_length += length + 2;
+        rastaMessageIteratorNext(&iterator, &message, &message_length);
 
+        allocateRastaByteArray(&result.data_array[i],message_length);
+        rmemcpy(result.data_array[i].bytes, message, message_length);
     }
 
     return result;
-
-
 }
 
 struct RastaPacket createRetransmittedDataMessage(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
@@ -422,19 +434,19 @@ struct RastaPacket createRetransmittedDataMessage(uint32_t receiver_id, uint32_t
 
 }
 
-struct RastaRedundancyPacket createRedundancyPacket(uint32_t sequence_number, struct RastaPacket inner_data, struct crc_options checksum_type){
+struct RastaRedundancyPacket createRedundancyPacket(uint32_t sequence_number, const struct RastaPacket * inner_data, struct crc_options * checksum_type){
     struct RastaRedundancyPacket packet;
 
     packet.sequence_number = sequence_number;
-    packet.data = inner_data;
+    packet.data = *inner_data;
     packet.checksum_type = checksum_type;
 
     // reserved bytes have to be 0s in version 03.03
     packet.reserve = 0x0000;
 
-    // length = 2 bytes length field + 2 bytes reserve + 4 bytes seq. nr. + inner data length + checksum length
+    // length = redundancy header + inner data length + checksum length
     // checksum width in crc_options is in bit, so divide by 8 for bytes
-    packet.length = (uint16_t)(8 + inner_data.length + (checksum_type.width / 8));
+    packet.length = (uint16_t) rasta_red_pdu_length(inner_data->length, (unsigned int)(checksum_type->width / 8));
 
     // set checksum_correct to 1 as checksum will be calculated on conversion to bytes
     packet.checksum_correct = 1;
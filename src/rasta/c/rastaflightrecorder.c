@@ -0,0 +1,109 @@
+#include <time.h>
+#include "rastaflightrecorder.h"
+
+void rasta_flight_recorder_init(struct rasta_flight_recorder * recorder, struct rasta_flight_record * records,
+                                unsigned int capacity) {
+    recorder->records = capacity > 0 ? records : NULL;
+    recorder->capacity = capacity;
+    recorder->next = 0;
+    recorder->safety_window_start_ns = 0;
+    recorder->safety_errors = 0;
+}
+
+int rasta_flight_recorder_safety_error(struct rasta_flight_recorder * recorder, uint64_t now_ns, uint64_t window_ns,
+                                       unsigned int threshold) {
+    if (recorder->safety_errors == 0 || now_ns - recorder->safety_window_start_ns > window_ns) {
+        recorder->safety_window_start_ns = now_ns;
+        recorder->safety_errors = 0;
+    }
+    recorder->safety_errors++;
+    if (recorder->safety_errors < threshold) {
+        return 0;
+    }
+    recorder->safety_errors = 0;
+    return 1;
+}
+
+/**
+ * @param event a recorded event
+ * @return the name of @p event
+ */
+static const char * flight_event_name(unsigned int event) {
+    switch (event) {
+        case RASTA_FLIGHT_RECEIVE:
+            return "receive";
+        case RASTA_FLIGHT_DISCARD:
+            return "discard";
+        case RASTA_FLIGHT_SEND:
+            return "send";
+        case RASTA_FLIGHT_RETRANSMIT:
+            return "retransmit";
+        default:
+            return "unknown";
+    }
+}
+
+const char * rasta_flight_trigger_name(rasta_flight_trigger trigger) {
+    switch (trigger) {
+        case RASTA_FLIGHT_TRIGGER_TIMEOUT:
+            return "timeout";
+        case RASTA_FLIGHT_TRIGGER_DISCREQ:
+            return "discreq";
+        case RASTA_FLIGHT_TRIGGER_SAFETY:
+            return "safety";
+        case RASTA_FLIGHT_TRIGGER_CHANNEL:
+            return "channel";
+        default:
+            return "unknown";
+    }
+}
+
+void rasta_flight_recorder_write(const struct rasta_flight_recorder * recorder, FILE * out, unsigned long local_id,
+                                 unsigned long remote_id, rasta_flight_trigger trigger, const char * detail,
+                                 uint64_t now_ns) {
+    unsigned long count = recorder->next < recorder->capacity ? recorder->next : recorder->capacity;
+
+    fprintf(out, "# local_id=0x%lX remote_id=0x%lX trigger=%s records=%lu%s%s\n", local_id, remote_id,
+            rasta_flight_trigger_name(trigger), count, detail[0] ? " " : "", detail);
+    fprintf(out, "# time_ms event type sn cs ts cts detail send_queue retransmission_queue receive_queue\n");
+
+    for (unsigned long i = recorder->next - count; i < recorder->next; i++) {
+        const struct rasta_flight_record * record = &recorder->records[i % recorder->capacity];
+        // the times are relative to the dump, so the last records are the ones just before the anomaly
+        double time_ms = -(double) (now_ns - record->time_ns) / 1000000.0;
+        fprintf(out, "%.3f %s %u %u %u %u %u %u %u %u %u\n", time_ms, flight_event_name(record->event), record->type,
+                record->sequence_number, record->confirmed_sequence_number, record->timestamp,
+                record->confirmed_timestamp, record->detail, record->send_queue, record->retransmission_queue,
+                record->receive_queue);
+    }
+}
+
+int rasta_flight_recorder_dump(struct rasta_flight_recorder * recorder, const char * directory, unsigned long local_id,
+                               unsigned long remote_id, rasta_flight_trigger trigger, const char * detail,
+                               uint64_t now_ns, char * path, size_t path_size) {
+    char file_path[4096];
+
+    if (recorder->records == NULL || recorder->next == 0) {
+        return 0;
+    }
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    unsigned long long epoch_ms = (unsigned long long) wall.tv_sec * 1000 + (unsigned long long) wall.tv_nsec / 1000000;
+    snprintf(file_path, sizeof(file_path), "%s/rasta_flight_0x%lX_0x%lX_%llu_%s.txt", directory, local_id, remote_id,
+             epoch_ms, rasta_flight_trigger_name(trigger));
+    if (path != NULL) {
+        snprintf(path, path_size, "%s", file_path);
+    }
+
+    FILE * out = fopen(file_path, "w");
+    if (out == NULL) {
+        return 0;
+    }
+    rasta_flight_recorder_write(recorder, out, local_id, remote_id, trigger, detail, now_ns);
+    int written = !ferror(out);
+    written = fclose(out) == 0 && written;
+
+    recorder->next = 0;
+    return written;
+}
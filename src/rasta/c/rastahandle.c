@@ -2,14 +2,22 @@
 // Created by tobia on 22.03.2018.
 //
 
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
 #include "rastahandle.h"
 #include "rmemory.h"
 
 
 #define RASTA_CONFIG_KEY_LOGGER_TYPE "LOGGER_TYPE"
+#define RASTA_CONFIG_KEY_LOGGER_ASYNC_RECORDS "LOGGER_ASYNC_RECORDS"
 #define RASTA_CONFIG_KEY_LOGGER_FILE "LOGGER_FILE"
 #define RASTA_CONFIG_KEY_LOGGER_MAX_LEVEL "LOGGER_MAX_LEVEL"
+#define RASTA_CONFIG_KEY_LOGGER_TRACE_FILE "LOGGER_TRACE_FILE"
+#define RASTA_CONFIG_KEY_LOGGER_TRACE_RECORDS "LOGGER_TRACE_RECORDS"
 #define RASTA_CONFIG_KEY_ACCEPTED_VERSIONS "RASTA_ACCEPTED_VERSIONS"
 
 //---------- Util functions for calling notifications in new thread ----------
@@ -19,11 +27,59 @@ struct rasta_notification_result sr_create_notification_result(struct rasta_hand
     struct rasta_notification_result r;
 
     r.handle = handle;
+    r.con = connection;
+#ifdef RASTA_NOTIFICATION_COPY
     r.connection = *connection;
+#endif
+    r.remote_id = connection->remote_id;
+    r.state = connection->current_state;
+    r.diagnostic_intervals = connection->diagnostic_intervals;
+    r.diagnostic_intervals_length = connection->diagnostic_intervals_length;
 
     return r;
 }
 
+/**
+ * a notification in the callback executor
+ */
+struct rasta_callback_record {
+    struct rasta_notification_result result;
+
+    /**
+     * reason and detail of a DiscReq
+     */
+    unsigned short reason;
+    unsigned short detail;
+
+    /**
+     * the progress of a completed bulk connect
+     */
+    struct rasta_bulk_connect_status bulk_status;
+
+    /**
+     * the copy of the diagnostic intervals of a diagnostic notification
+     */
+    struct diagnostic_interval intervals[];
+};
+
+/**
+ * hands a notification to the callback executor of the handle
+ * @param result the notification
+ * @param run runs the notification, it gets a struct rasta_callback_record
+ * @param record the record, the notification result is its first member
+ * @param size the size of the record
+ * @return 1 if the executor runs the notification, 0 if there is no executor and the caller has to run it
+ */
+static int rasta_handle_defer_notification(struct rasta_notification_result * result, rasta_callback_run_ptr run,
+                                           const void * record, size_t size) {
+    struct rasta_callback_executor * executor = result->handle->callback_executor;
+    if (executor == NULL) {
+        return 0;
+    }
+    rasta_callback_executor_submit(executor, run, record, size);
+    return 1;
+}
+
 /**
  * the is the function that handles the call of the onConnectionStateChange notification pointer.
  * this runs on a separate thread
@@ -34,9 +90,24 @@ void on_constatechange_call(struct rasta_notification_result * result){
     (*result->handle->notifications.on_connection_state_change)(result);
 }
 
+/**
+ * runs a state change notification of the callback executor with the latest state of the connection
+ * @param record the notification result
+ */
+static void run_constatechange(void * record) {
+    struct rasta_notification_result * result = record;
+
+    // the state changes that are fired from now on queue a new notification
+    __atomic_store_n(&result->con->state_change_queued, 0, __ATOMIC_SEQ_CST);
+    result->state = __atomic_load_n(&result->con->notified_state, __ATOMIC_SEQ_CST);
+
+    on_constatechange_call(result);
+}
+
 /**
  * fires the onConnectionStateChange event.
- * This implementation will take care if the function pointer is NULL and start a thread to call the notification
+ * This implementation will take care if the function pointer is NULL. With a callback executor, the state changes
+ * of a connection that are fired while its notification is queued are merged into it
  * @param connection the connection that is used
  */
 void fire_on_connection_state_change(struct rasta_notification_result result){
@@ -45,6 +116,17 @@ void fire_on_connection_state_change(struct rasta_notification_result result){
         return;
     }
 
+    struct rasta_callback_executor * executor = result.handle->callback_executor;
+    if (executor != NULL) {
+        __atomic_store_n(&result.con->notified_state, result.state, __ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(&result.con->state_change_queued, 1, __ATOMIC_SEQ_CST)) {
+            rasta_callback_executor_coalesced(executor);
+            return;
+        }
+        rasta_callback_executor_submit(executor, run_constatechange, &result, sizeof(result));
+        return;
+    }
+
     on_constatechange_call(&result);
 }
 
@@ -53,6 +135,10 @@ void on_receive_call(struct rasta_notification_result * result){
     (*result->handle->notifications.on_receive)(result);
 }
 
+static void run_receive(void * record) {
+    on_receive_call(record);
+}
+
 /**
  * fires the onConnectionStateChange event.
  * This implementation will take care if the function pointer is NULL and start a thread to call the notification
@@ -64,20 +150,54 @@ void fire_on_receive(struct rasta_notification_result result){
         return;
     }
 
-    //create container
-    struct rasta_notification_result* container = rmalloc(sizeof(struct rasta_notification_result));
-    *container = result;
-
+    if (rasta_handle_defer_notification(&result, run_receive, &result, sizeof(result))) {
+        return;
+    }
     on_receive_call(&result);
 }
 
-void on_discrequest_change_call(struct rasta_disconnect_notification_result * container){
-    struct rasta_disconnect_notification_result * result = (struct rasta_disconnect_notification_result * )container;
+static void run_receive_bulk(void * record) {
+    struct rasta_notification_result * result = record;
+    (*result->handle->notifications.on_receive_bulk)(result);
+}
 
+void fire_on_receive_bulk(struct rasta_notification_result result){
+    if (result.handle->notifications.on_receive_bulk == NULL){
+        // notification not set, do nothing
+        return;
+    }
+
+    if (rasta_handle_defer_notification(&result, run_receive_bulk, &result, sizeof(result))) {
+        return;
+    }
+    run_receive_bulk(&result);
+}
+
+static void run_writable(void * record) {
+    struct rasta_notification_result * result = record;
+    (*result->handle->notifications.on_writable)(result);
+}
+
+void fire_on_writable(struct rasta_notification_result result){
+    if (result.handle->notifications.on_writable == NULL){
+        // notification not set, do nothing
+        return;
+    }
+
+    if (rasta_handle_defer_notification(&result, run_writable, &result, sizeof(result))) {
+        return;
+    }
+    run_writable(&result);
+}
+
+void on_discrequest_change_call(struct rasta_disconnect_notification_result * result){
     (*result->result.handle->notifications.on_disconnection_request_received)(&result->result,result->reason,result->detail);
+}
 
-    //free container
-    rfree(container);
+static void run_discrequest_change(void * record) {
+    struct rasta_callback_record * callback = record;
+    (*callback->result.handle->notifications.on_disconnection_request_received)(&callback->result, callback->reason,
+                                                                               callback->detail);
 }
 
 /**
@@ -92,15 +212,20 @@ void fire_on_discrequest_state_change(struct rasta_notification_result result, s
         return;
     }
 
-    //create container
-
+    struct rasta_callback_record record;
+    record.result = result;
+    record.reason = data.reason;
+    record.detail = data.details;
+    if (rasta_handle_defer_notification(&result, run_discrequest_change, &record, sizeof(record))) {
+        return;
+    }
 
-    struct rasta_disconnect_notification_result* container = rmalloc(sizeof(struct rasta_disconnect_notification_result));
-    container->result = result;
-    container->reason = data.reason;
-    container->detail = data.details;
+    struct rasta_disconnect_notification_result container;
+    container.result = result;
+    container.reason = data.reason;
+    container.detail = data.details;
 
-    on_discrequest_change_call(container);
+    on_discrequest_change_call(&container);
 }
 
 
@@ -114,9 +239,12 @@ void on_diagnostic_call(void * container){
     struct rasta_notification_result * result = (struct rasta_notification_result * )container;
 
     (*result->handle->notifications.on_diagnostic_notification)(result);
+}
 
-    //free container
-    rfree(container);
+static void run_diagnostic(void * record) {
+    struct rasta_callback_record * callback = record;
+    callback->result.diagnostic_intervals = callback->intervals;
+    on_diagnostic_call(&callback->result);
 }
 
 /**
@@ -131,12 +259,25 @@ void fire_on_diagnostic_notification(struct rasta_notification_result result){
         return;
     }
 
-    if (result.connection.received_diagnostic_message_count <= 0) {
+    if (result.con->received_diagnostic_message_count <= 0) {
         // no diagnostic notification to send
         return;
     }
 
-    //create container
+    struct rasta_callback_executor * executor = result.handle->callback_executor;
+    size_t size = sizeof(struct rasta_callback_record) +
+                  result.diagnostic_intervals_length * sizeof(struct diagnostic_interval);
+    if (executor != NULL && size <= executor->record_size) {
+        // the intervals are reset after the notification, the record carries a copy
+        struct rasta_callback_record * record = rmalloc(size);
+        record->result = result;
+        memcpy(record->intervals, result.diagnostic_intervals,
+               result.diagnostic_intervals_length * sizeof(struct diagnostic_interval));
+        rasta_callback_executor_submit(executor, run_diagnostic, record, size);
+        rfree(record);
+        return;
+    }
+
     on_diagnostic_call(&result);
 }
 
@@ -144,6 +285,10 @@ void on_handshake_complete_call(struct rasta_notification_result * result) {
     (*result->handle->notifications.on_handshake_complete)(result);
 }
 
+static void run_handshake_complete(void * record) {
+    on_handshake_complete_call(record);
+}
+
 void fire_on_handshake_complete(struct rasta_notification_result result){
 
     if (result.handle->notifications.on_handshake_complete == NULL){
@@ -151,6 +296,9 @@ void fire_on_handshake_complete(struct rasta_notification_result result){
         return;
     }
 
+    if (rasta_handle_defer_notification(&result, run_handshake_complete, &result, sizeof(result))) {
+        return;
+    }
     on_handshake_complete_call(&result);
 }
 
@@ -160,6 +308,10 @@ void on_heartbeat_timeout_call(struct rasta_notification_result* container){
     (*result->handle->notifications.on_heartbeat_timeout)(result);
 }
 
+static void run_heartbeat_timeout(void * record) {
+    on_heartbeat_timeout_call(record);
+}
+
 void fire_on_heartbeat_timeout(struct rasta_notification_result result){
 
     if (result.handle->notifications.on_heartbeat_timeout == NULL){
@@ -167,9 +319,102 @@ void fire_on_heartbeat_timeout(struct rasta_notification_result result){
         return;
     }
 
+    if (rasta_handle_defer_notification(&result, run_heartbeat_timeout, &result, sizeof(result))) {
+        return;
+    }
     on_heartbeat_timeout_call(&result);
 }
 
+static void run_bulk_connect_complete(void * record) {
+    struct rasta_callback_record * callback = record;
+    (*callback->result.handle->notifications.on_bulk_connect_complete)(&callback->result, &callback->bulk_status);
+}
+
+void fire_on_bulk_connect_complete(struct rasta_handle *handle, struct rasta_bulk_connect_status status){
+    if (handle->notifications.on_bulk_connect_complete == NULL){
+        // notification not set, do nothing
+        return;
+    }
+
+    // the notification belongs to all connections of the bulk connect, not to one of them
+    struct rasta_callback_record record;
+    memset(&record, 0, sizeof(record));
+    record.result.handle = handle;
+    record.result.state = RASTA_CONNECTION_CLOSED;
+    record.bulk_status = status;
+    if (rasta_handle_defer_notification(&record.result, run_bulk_connect_complete, &record, sizeof(record))) {
+        return;
+    }
+    run_bulk_connect_complete(&record);
+}
+
+/**
+ * allocates the connection pool with the placement of the handle
+ * @param h the RaSTA handle
+ */
+static void rasta_handle_init_connection_pool(struct rasta_handle *h) {
+    struct rmemory_placement previous = rmemory_set_thread_placement(h->placement);
+    rasta_connection_pool_init(&h->connection_pool, h->config.values.sending, h->config.values.metrics.residency,
+                               h->config.values.flight_recorder.records);
+    rmemory_set_thread_placement(previous);
+
+    if (h->connection_pool.capacity > 0) {
+        logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE", "preallocated %u connections, %zu bytes each",
+                   h->connection_pool.capacity, sr_connection_footprint(h));
+    }
+}
+
+void rasta_handle_set_cpu(struct rasta_handle *h, int cpu) {
+    h->cpu = cpu;
+    if (!h->config.values.placement.numa) {
+        return;
+    }
+
+    int node = rmemory_cpu_node(cpu);
+    if (node < 0 || node == h->placement.numa_node) {
+        return;
+    }
+    h->placement.numa_node = node;
+    // no connection took a slot yet
+    rasta_connection_pool_free(&h->connection_pool);
+    rasta_handle_init_connection_pool(h);
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE", "placed the memory of CPU %d on NUMA node %d", cpu, node);
+}
+
+/**
+ * creates the queue and the eventfd that let other threads submit application messages
+ * @param h the RaSTA handle
+ */
+static void rasta_handle_init_submissions(struct rasta_handle *h) {
+    h->submit_queue = mpsc_queue_init(RASTA_SUBMIT_QUEUE_SIZE, sizeof(struct rasta_submission));
+    h->submit_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (h->submit_notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+}
+
+/**
+ * starts the callback executor of the handle if RASTA_CALLBACK_QUEUE is set, its records hold the diagnostic
+ * intervals of a connection
+ * @param h the RaSTA handle, the connection pool has to be initialized
+ */
+static void rasta_handle_init_callbacks(struct rasta_handle *h) {
+    h->callback_executor = NULL;
+    if (h->config.values.loop.callback_queue == 0) {
+        return;
+    }
+
+    h->callback_executor = rmalloc(sizeof(struct rasta_callback_executor));
+    rasta_callback_executor_init(h->callback_executor, h->config.values.loop.callback_queue,
+                                 sizeof(struct rasta_callback_record) +
+                                 h->connection_pool.diagnostic_interval_count * sizeof(struct diagnostic_interval),
+                                 h->config.values.loop.callback_thread);
+    logger_log(&h->logger, LOG_LEVEL_INFO, "RaSTA HANDLE", "notifications are queued for %s, up to %u",
+               h->config.values.loop.callback_thread ? "the callback thread" : "the application",
+               h->config.values.loop.callback_queue);
+}
+
 void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo configuration, struct DictionaryArray accepted_versions , struct logger_t logger) {
 
     h->config.values = configuration;
@@ -179,14 +424,26 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
 
     // set notification pointers to NULL
     h->notifications.on_receive = NULL;
+    h->notifications.on_receive_bulk = NULL;
     h->notifications.on_connection_state_change= NULL;
     h->notifications.on_diagnostic_notification = NULL;
     h->notifications.on_disconnection_request_received = NULL;
     h->notifications.on_redundancy_diagnostic_notification = NULL;
+    h->notifications.on_writable = NULL;
 
     // init the list
     h->first_con = NULL;
     h->last_con = NULL;
+    rasta_id_index_init(&h->connection_index);
+
+    h->cpu = -1;
+    h->placement.numa_node = -1;
+    h->placement.huge_pages = h->config.values.placement.huge_pages;
+    rasta_handle_init_connection_pool(h);
+
+    // new connections are only admitted in batches if a budget is set
+    h->conreq_backlog = h->config.values.sending.conreq_budget > 0 ? fifo_init(RASTA_CONREQ_BACKLOG_SIZE) : NULL;
+    h->bulk_connect = NULL;
 
     // init hashing context
     h->hashing_context.hash_length = h->config.values.sending.md4_type;
@@ -205,6 +462,7 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
         h->hashing_context.key.bytes[1] = (h->config.values.sending.sr_hash_key >> 16) & 0xFF;
         h->hashing_context.key.bytes[2] = (h->config.values.sending.sr_hash_key >> 8) & 0xFF;
         h->hashing_context.key.bytes[3] = (h->config.values.sending.sr_hash_key) & 0xFF;
+        rasta_hash_prepare_key(&h->hashing_context);
     }
 
     //setup thread data
@@ -212,6 +470,20 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
     h->send_running = 0;
     h->hb_running = 0;
 
+    // created when the event loop starts
+    h->send_notify_fd = -1;
+    h->receive_notify_fd = -1;
+    rasta_handle_init_submissions(h);
+    rasta_handle_init_callbacks(h);
+    memset(&h->receive_stats, 0, sizeof(h->receive_stats));
+    memset(&h->rekeying_stats, 0, sizeof(h->rekeying_stats));
+    memset(&h->loop_lag, 0, sizeof(h->loop_lag));
+    // opened with the other layers
+    h->metrics_fd = -1;
+    h->stat_page = NULL;
+    h->reload_signal_fd = -1;
+    h->replication = NULL;
+
     h->receive_handle = rmalloc(sizeof(struct rasta_receive_handle));
     h->heartbeat_handle = rmalloc(sizeof(struct rasta_heartbeat_handle));
     h->send_handle = rmalloc(sizeof(struct rasta_sending_handle));
@@ -224,6 +496,12 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
     h->receive_handle->logger = &h->logger;
     h->receive_handle->mux = &h->mux;
     h->receive_handle->hashing_context = &h->hashing_context;
+    memset(&h->receive_handle->retransmit_bucket, 0, sizeof(h->receive_handle->retransmit_bucket));
+    h->receive_handle->retransmit_last_id = 0;
+    h->receive_handle->receive_held_count = 0;
+    h->receive_handle->last_received = 0;
+    h->receive_handle->last_sender_id = 0;
+    h->receive_handle->retransmit_event = NULL;
 
     //send
     h->send_handle->config = h->config.values.sending;
@@ -233,6 +511,8 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
     h->send_handle->logger = &h->logger;
     h->send_handle->mux = &h->mux;
     h->send_handle->hashing_context = &h->hashing_context;
+    h->send_handle->pacing_event = NULL;
+    h->send_handle->send_last_id = 0;
 
     //heartbeat
     h->heartbeat_handle->config = h->config.values.sending;
@@ -241,11 +521,23 @@ void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo c
     h->heartbeat_handle->running = &h->hb_running;
     h->heartbeat_handle->logger = &h->logger;
     h->heartbeat_handle->mux = &h->mux;
+    h->heartbeat_handle->batch = NULL;
+    h->heartbeat_handle->batch_connections = NULL;
+    h->heartbeat_handle->batch_capacity = 0;
     h->heartbeat_handle->hashing_context = &h->hashing_context;
 
     h->receive_handle->accepted_version = accepted_versions;
 }
 
+int rasta_config_log_level(struct RastaConfig * config) {
+    struct DictionaryEntry logger_maxlvl = config_get(config, RASTA_CONFIG_KEY_LOGGER_MAX_LEVEL);
+    return logger_maxlvl.type == DICTIONARY_NUMBER ? (int) logger_maxlvl.value.number : -1;
+}
+
+size_t sr_connection_footprint(struct rasta_handle *h) {
+    return sizeof(struct rasta_connection) + rasta_connection_pool_slot_size(&h->connection_pool);
+}
+
 void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
 
     h->config = config_load(config_file_path);
@@ -255,13 +547,13 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
     struct DictionaryEntry logger_maxlvl = config_get(&h->config,
                                                       RASTA_CONFIG_KEY_LOGGER_MAX_LEVEL);
     struct DictionaryEntry logger_file = config_get(&h->config, RASTA_CONFIG_KEY_LOGGER_FILE);
+    struct DictionaryEntry logger_async_records = config_get(&h->config, RASTA_CONFIG_KEY_LOGGER_ASYNC_RECORDS);
+    struct DictionaryEntry logger_trace_file = config_get(&h->config, RASTA_CONFIG_KEY_LOGGER_TRACE_FILE);
+    struct DictionaryEntry logger_trace_records = config_get(&h->config, RASTA_CONFIG_KEY_LOGGER_TRACE_RECORDS);
 
     if (logger_ty.type == DICTIONARY_NUMBER && logger_maxlvl.type == DICTIONARY_NUMBER) {
         h->logger = logger_init((log_level) logger_maxlvl.value.number, (logger_type) logger_ty.value.number);
 
-        //h->redlogger = logger_init(LOG_LEVEL_NONE,LOGGER_TYPE_CONSOLE);
-        h->redlogger = h->logger;
-
         if (h->logger.type == LOGGER_TYPE_FILE) {
             // need to set log file
             if (logger_file.type == DICTIONARY_STRING) {
@@ -271,6 +563,26 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
                 exit(1);
             }
         }
+
+        // by default the messages are written synchronously
+        if (logger_async_records.type == DICTIONARY_NUMBER && logger_async_records.value.number > 0 &&
+            h->logger.max_log_level != LOG_LEVEL_NONE) {
+            logger_enable_async(&h->logger, (unsigned int) logger_async_records.value.number);
+        }
+
+        // by default no binary trace is recorded
+        if (logger_trace_records.type == DICTIONARY_NUMBER && logger_trace_records.value.number > 0) {
+            if (logger_trace_file.type != DICTIONARY_STRING) {
+                // error in config
+                exit(1);
+            }
+            logger_enable_trace(&h->logger, logger_trace_file.value.string.c,
+                                (unsigned int) logger_trace_records.value.number);
+        }
+
+        // the redundancy layer shares the logger, so it is copied after it was set up
+        //h->redlogger = logger_init(LOG_LEVEL_NONE,LOGGER_TYPE_CONSOLE);
+        h->redlogger = h->logger;
     } else {
         // error in config
         exit(1);
@@ -283,15 +595,27 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
 
     // set notification pointers to NULL
     h->notifications.on_receive = NULL;
+    h->notifications.on_receive_bulk = NULL;
     h->notifications.on_connection_state_change= NULL;
     h->notifications.on_diagnostic_notification = NULL;
     h->notifications.on_disconnection_request_received = NULL;
     h->notifications.on_redundancy_diagnostic_notification = NULL;
+    h->notifications.on_writable = NULL;
 
 
     // init the list
     h->first_con = NULL;
     h->last_con = NULL;
+    rasta_id_index_init(&h->connection_index);
+
+    h->cpu = -1;
+    h->placement.numa_node = -1;
+    h->placement.huge_pages = h->config.values.placement.huge_pages;
+    rasta_handle_init_connection_pool(h);
+
+    // new connections are only admitted in batches if a budget is set
+    h->conreq_backlog = h->config.values.sending.conreq_budget > 0 ? fifo_init(RASTA_CONREQ_BACKLOG_SIZE) : NULL;
+    h->bulk_connect = NULL;
 
     // init hashing context
     h->hashing_context.hash_length = h->config.values.sending.md4_type;
@@ -310,6 +634,7 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
         h->hashing_context.key.bytes[1] = (h->config.values.sending.sr_hash_key >> 16) & 0xFF;
         h->hashing_context.key.bytes[2] = (h->config.values.sending.sr_hash_key >> 8) & 0xFF;
         h->hashing_context.key.bytes[3] = (h->config.values.sending.sr_hash_key) & 0xFF;
+        rasta_hash_prepare_key(&h->hashing_context);
     }
 
     //setup thread data
@@ -317,6 +642,20 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
     h->send_running = 0;
     h->hb_running = 0;
 
+    // created when the event loop starts
+    h->send_notify_fd = -1;
+    h->receive_notify_fd = -1;
+    rasta_handle_init_submissions(h);
+    rasta_handle_init_callbacks(h);
+    memset(&h->receive_stats, 0, sizeof(h->receive_stats));
+    memset(&h->rekeying_stats, 0, sizeof(h->rekeying_stats));
+    memset(&h->loop_lag, 0, sizeof(h->loop_lag));
+    // opened with the other layers
+    h->metrics_fd = -1;
+    h->stat_page = NULL;
+    h->reload_signal_fd = -1;
+    h->replication = NULL;
+
     h->receive_handle = rmalloc(sizeof(struct rasta_receive_handle));
     h->heartbeat_handle = rmalloc(sizeof(struct rasta_heartbeat_handle));
     h->send_handle = rmalloc(sizeof(struct rasta_sending_handle));
@@ -329,6 +668,12 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
     h->receive_handle->logger = &h->logger;
     h->receive_handle->mux = &h->mux;
     h->receive_handle->hashing_context = &h->hashing_context;
+    memset(&h->receive_handle->retransmit_bucket, 0, sizeof(h->receive_handle->retransmit_bucket));
+    h->receive_handle->retransmit_last_id = 0;
+    h->receive_handle->receive_held_count = 0;
+    h->receive_handle->last_received = 0;
+    h->receive_handle->last_sender_id = 0;
+    h->receive_handle->retransmit_event = NULL;
 
     //send
     h->send_handle->config = h->config.values.sending;
@@ -338,6 +683,8 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
     h->send_handle->logger = &h->logger;
     h->send_handle->mux = &h->mux;
     h->send_handle->hashing_context = &h->hashing_context;
+    h->send_handle->pacing_event = NULL;
+    h->send_handle->send_last_id = 0;
 
     //heartbeat
     h->heartbeat_handle->config = h->config.values.sending;
@@ -346,6 +693,9 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
     h->heartbeat_handle->running = &h->hb_running;
     h->heartbeat_handle->logger = &h->logger;
     h->heartbeat_handle->mux = &h->mux;
+    h->heartbeat_handle->batch = NULL;
+    h->heartbeat_handle->batch_connections = NULL;
+    h->heartbeat_handle->batch_capacity = 0;
     h->heartbeat_handle->hashing_context = &h->hashing_context;
 
     if (config_accepted_version.type == DICTIONARY_ARRAY) {
@@ -360,3 +710,13 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path) {
 
 
 }
+
+void rasta_handle_notify(int notify_fd) {
+    if (notify_fd == -1) {
+        return;
+    }
+    uint64_t value = 1;
+    // can only fail if the counter would overflow, the handler is woken up in that case anyway
+    ssize_t written = write(notify_fd, &value, sizeof(value));
+    (void) written;
+}
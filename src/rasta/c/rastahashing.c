@@ -1,7 +1,28 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_CODEC
 #include "rastahashing.h"
 #include <rmemory.h>
 #include <stdlib.h>
 
+/**
+ * builds the MD4 state with the initial value that is stored in the key of the hashing context
+ * @param context the hashing context, the key needs at least 16 bytes
+ * @return the MD4 state
+ */
+static MD4_CONTEXT rasta_get_md4_ctx_from_key(rasta_hashing_context_t * context){
+    MD4_u32plus a, b, c, d;
+
+    // read a, b, c, d from key
+    a = leLongToHost(&context->key.bytes[0]);
+
+    b = leLongToHost(&context->key.bytes[4]);
+
+    c = leLongToHost(&context->key.bytes[8]);
+
+    d = leLongToHost(&context->key.bytes[12]);
+
+    return md4InitContext(a, b, c, d);
+}
+
 void rasta_md4_set_key(rasta_hashing_context_t * context, MD4_u32plus a, MD4_u32plus b, MD4_u32plus c, MD4_u32plus d){
     // MD4 IV has length 4*4 bytes
     allocateRastaByteArray(&context->key, 16);
@@ -19,6 +40,8 @@ void rasta_md4_set_key(rasta_hashing_context_t * context, MD4_u32plus a, MD4_u32
 
     hostLongToLe(d, buffer);
     rmemcpy(&context->key.bytes[12], buffer, 4 * sizeof(unsigned char));
+
+    rasta_hash_prepare_key(context);
 }
 
 void rasta_set_hash_key_variable(rasta_hashing_context_t *context, const char *key, size_t key_length){
@@ -28,44 +51,369 @@ void rasta_set_hash_key_variable(rasta_hashing_context_t *context, const char *k
     allocateRastaByteArray(&context->key,key_length);
     memcpy(context->key.bytes,key,key_length);
     context->key.length = key_length;
-}
 
-MD4_CONTEXT rasta_get_md4_ctx_from_key(rasta_hashing_context_t * context){
-    MD4_u32plus a, b, c, d;
+    rasta_hash_prepare_key(context);
+}
 
-    // read a, b, c, d from key
-    a = leLongToHost(&context->key.bytes[0]);
+void rasta_hash_prepare_key(rasta_hashing_context_t * context){
+    if (context->key.length >= 16){
+        // the MD4 initial value is read from the first 16 bytes of the key
+        context->md4_context = rasta_get_md4_ctx_from_key(context);
+    }
 
-    b = leLongToHost(&context->key.bytes[4]);
+    // without a key there is no key block, the hashes use rasta_blake2b_init() then
+    context->blake2b_keyed_valid = context->key.length > 0;
+    for (unsigned int i = 0; i < 2 && context->blake2b_keyed_valid; i++){
+        rasta_blake2b_ctx keyed;
+        if (rasta_blake2b_init(&keyed, (size_t) (i + 1) * 8, context->key.bytes, (size_t) context->key.length)){
+            // the key is too long, rasta_blake2b_init() fails for every hash then
+            context->blake2b_keyed_valid = 0;
+            break;
+        }
+        rasta_blake2b_compress_key(&keyed);
+        rmemcpy(context->blake2b_keyed[i], keyed.h, sizeof(keyed.h));
+    }
 
-    c = leLongToHost(&context->key.bytes[8]);
+    // SipHash reads 16 bytes of the key, a shorter key is padded with zeros
+    unsigned char siphash_key[16] = { 0 };
+    rmemcpy(siphash_key, context->key.bytes,
+            context->key.length < sizeof(siphash_key) ? context->key.length : sizeof(siphash_key));
+    for (unsigned int i = 0; i < 2; i++){
+        rasta_siphash24_ctx keyed;
+        rasta_siphash24_init(&keyed, siphash_key, (int) i + 1);
+        rmemcpy(context->siphash24_keyed[i], keyed.v, sizeof(keyed.v));
+    }
+}
 
-    d = leLongToHost(&context->key.bytes[12]);
+/**
+ * starts BLAKE2b with the key block of the hashing context
+ * @param state the state to start
+ * @param context the hashing context
+ * @param hash_length RASTA_CHECKSUM_8B or RASTA_CHECKSUM_16B
+ * @param chained 1 to continue after the compressed key block, only possible if a message follows, since the key
+ *        block is the last block of an empty message
+ * @return 0 on success, -1 if the key can not be used
+ */
+static int blake2b_start(rasta_blake2b_ctx * state, const rasta_hashing_context_t * context, int hash_length,
+                         int chained){
+    if (chained && context->blake2b_keyed_valid){
+        rasta_blake2b_init_keyed(state, (size_t) hash_length * 8, context->blake2b_keyed[hash_length - 1]);
+        return 0;
+    }
+    return rasta_blake2b_init(state, (size_t) hash_length * 8, context->key.bytes, (size_t) context->key.length);
+}
 
-    return md4InitContext(a, b, c, d);
+/**
+ * starts SipHash 2-4 with the key schedule of the hashing context
+ * @param state the state to start
+ * @param context the hashing context
+ * @param hash_length the checksum length
+ */
+static void siphash24_start(rasta_siphash24_ctx * state, const rasta_hashing_context_t * context, int hash_length){
+    if (hash_length == RASTA_CHECKSUM_8B || hash_length == RASTA_CHECKSUM_16B){
+        rasta_siphash24_init_keyed(state, context->siphash24_keyed[hash_length - 1], hash_length);
+    } else{
+        rasta_siphash24_init(state, context->key.bytes, hash_length);
+    }
 }
 
-void rasta_calculate_hash(struct RastaByteArray data, rasta_hashing_context_t * context,  unsigned char * hash){
-    MD4_CONTEXT md4_ctx;
+void rasta_hash_init(rasta_hash_state_t * state, rasta_hashing_context_t * context){
     if(!context->key.length){
         // should never happen
         abort();
     }
+
+    state->algorithm = context->algorithm;
+    state->hash_length = context->hash_length;
+    state->context = context;
+
     switch (context->algorithm){
+        case RASTA_ALGO_BLAKE2B:
+            // the prepared key block only exists for 8 and 16 byte checksums. If the message stays empty,
+            // rasta_hash_final() starts again
+            if (context->hash_length != RASTA_CHECKSUM_NONE &&
+                blake2b_start(&state->state.blake2b, context, context->hash_length,
+                              context->hash_length <= RASTA_CHECKSUM_16B)){
+                // something went wrong, e.g. the key is too long. No data is hashed then
+                state->hash_length = RASTA_CHECKSUM_NONE;
+            }
+            break;
+        case RASTA_ALGO_SIPHASH_2_4:
+            siphash24_start(&state->state.siphash24, context, context->hash_length);
+            break;
         case RASTA_ALGO_MD4:
-            md4_ctx = rasta_get_md4_ctx_from_key(context);
-            generateMD4WithVector(data.bytes, data.length, context->hash_length,  &md4_ctx, hash);
+        default:
+            // just use MD4, the hash updates the state, so work on a copy of the prepared one
+            state->algorithm = RASTA_ALGO_MD4;
+            state->state.md4 = context->md4_context;
             break;
+    }
+}
+
+void rasta_hash_update(rasta_hash_state_t * state, const unsigned char * data, unsigned int length){
+    switch (state->algorithm){
         case RASTA_ALGO_BLAKE2B:
-            generateBlake2(data.bytes, data.length, context->key.bytes, context->key.length, context->hash_length, hash);
+            if (state->hash_length != RASTA_CHECKSUM_NONE){
+                rasta_blake2b_update(&state->state.blake2b, data, (size_t) length);
+            }
             break;
         case RASTA_ALGO_SIPHASH_2_4:
-            generateSiphash24(data.bytes, data.length, context->key.bytes, context->hash_length, hash);
+            rasta_siphash24_update(&state->state.siphash24, data, (size_t) length);
             break;
         default:
-            // just use MD4
-            md4_ctx = rasta_get_md4_ctx_from_key(context);
-            generateMD4WithVector(data.bytes, data.length, context->hash_length,  &md4_ctx, hash);
+            md4Update(&state->state.md4, data, length);
             break;
     }
 }
+
+void rasta_hash_final(rasta_hash_state_t * state, unsigned char * hash){
+    switch (state->algorithm){
+        case RASTA_ALGO_BLAKE2B:
+            if (state->hash_length == RASTA_CHECKSUM_NONE){
+                // if no hash is wanted, return 8 zero bytes
+                rmemset(hash, 0, 8);
+            } else if (state->state.blake2b.c == 0){
+                // nothing was added after the compressed key block, which is the last block of an empty message
+                rasta_blake2b_ctx empty;
+                blake2b_start(&empty, state->context, state->hash_length, 0);
+                rasta_blake2b_final(&empty, hash);
+            } else{
+                rasta_blake2b_final(&state->state.blake2b, hash);
+            }
+            break;
+        case RASTA_ALGO_SIPHASH_2_4:
+            rasta_siphash24_final(&state->state.siphash24, hash);
+            break;
+        default:
+            md4Final(&state->state.md4, state->hash_length, hash);
+            break;
+    }
+}
+
+/**
+ * hashes with the generic state, used for parameters that have no specialized function
+ */
+static void hash_generic(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length,
+                         unsigned char * hash){
+    rasta_hash_state_t state;
+
+    rasta_hash_init(&state, context);
+    rasta_hash_update(&state, data, length);
+    rasta_hash_final(&state, hash);
+}
+
+/**
+ * defines the hash function of MD4 with a fixed checksum length, it starts with the prepared state
+ */
+#define DEFINE_MD4_HASH(name, type) \
+    static void name(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length, \
+                     unsigned char * hash){ \
+        MD4_CONTEXT state = context->md4_context; \
+        md4Update(&state, data, length); \
+        md4Final(&state, type, hash); \
+    }
+
+/**
+ * defines the hash function of BLAKE2b with a fixed checksum length, it continues after the prepared key block. A key
+ * that can not be used gives 8 zero bytes like rasta_hash_init()
+ */
+#define DEFINE_BLAKE2B_HASH(name, type) \
+    static void name(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length, \
+                     unsigned char * hash){ \
+        rasta_blake2b_ctx state; \
+        if (blake2b_start(&state, context, type, length > 0)){ \
+            rmemset(hash, 0, 8); \
+            return; \
+        } \
+        rasta_blake2b_update(&state, data, (size_t) length); \
+        rasta_blake2b_final(&state, hash); \
+    }
+
+/**
+ * defines the hash function of SipHash 2-4 with a fixed checksum length, it starts with the prepared key schedule
+ */
+#define DEFINE_SIPHASH24_HASH(name, type) \
+    static void name(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length, \
+                     unsigned char * hash){ \
+        rasta_siphash24_ctx state; \
+        siphash24_start(&state, context, type); \
+        rasta_siphash24_update(&state, data, (size_t) length); \
+        rasta_siphash24_final(&state, hash); \
+    }
+
+DEFINE_MD4_HASH(hash_md4_none, RASTA_CHECKSUM_NONE)
+DEFINE_MD4_HASH(hash_md4_8b, RASTA_CHECKSUM_8B)
+DEFINE_MD4_HASH(hash_md4_16b, RASTA_CHECKSUM_16B)
+DEFINE_BLAKE2B_HASH(hash_blake2b_8b, RASTA_CHECKSUM_8B)
+DEFINE_BLAKE2B_HASH(hash_blake2b_16b, RASTA_CHECKSUM_16B)
+DEFINE_SIPHASH24_HASH(hash_siphash24_none, RASTA_CHECKSUM_NONE)
+DEFINE_SIPHASH24_HASH(hash_siphash24_8b, RASTA_CHECKSUM_8B)
+DEFINE_SIPHASH24_HASH(hash_siphash24_16b, RASTA_CHECKSUM_16B)
+
+/**
+ * BLAKE2b without a checksum gives 8 zero bytes like rasta_hash_final()
+ */
+static void hash_blake2b_none(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length,
+                              unsigned char * hash){
+    (void) context;
+    (void) data;
+    (void) length;
+    rmemset(hash, 0, 8);
+}
+
+/**
+ * the hash functions indexed by the algorithm and the checksum length
+ */
+static const rasta_hash_function hash_functions[3][3] = {
+    [RASTA_ALGO_MD4] = { hash_md4_none, hash_md4_8b, hash_md4_16b },
+    [RASTA_ALGO_BLAKE2B] = { hash_blake2b_none, hash_blake2b_8b, hash_blake2b_16b },
+    [RASTA_ALGO_SIPHASH_2_4] = { hash_siphash24_none, hash_siphash24_8b, hash_siphash24_16b },
+};
+
+rasta_hash_function rasta_hash_select(const rasta_hashing_context_t * context){
+    if ((unsigned int) context->hash_length > RASTA_CHECKSUM_16B){
+        return hash_generic;
+    }
+
+    // unknown algorithms use MD4, see rasta_hash_init()
+    unsigned int algorithm = (unsigned int) context->algorithm <= RASTA_ALGO_SIPHASH_2_4 ? context->algorithm
+                                                                                       : RASTA_ALGO_MD4;
+    return hash_functions[algorithm][context->hash_length];
+}
+
+void rasta_calculate_hash(struct RastaByteArray data, rasta_hashing_context_t * context,  unsigned char * hash){
+    if(!context->key.length){
+        // should never happen
+        abort();
+    }
+
+    rasta_hash_select(context)(context, data.bytes, data.length, hash);
+}
+
+unsigned long rasta_hash_crc_update(rasta_hashing_context_t * context, struct crc_options * crc_options,
+                                    unsigned long crc, const unsigned char * data, unsigned int length,
+                                    unsigned char * hash){
+    if (length <= RASTA_HASH_CRC_CHUNK){
+        // the data fits into one chunk, so the specialized hash function is used
+        crc = crc_update(crc_options, crc, data, length);
+        rasta_hash_select(context)(context, data, length, hash);
+        return crc;
+    }
+
+    rasta_hash_state_t state;
+    rasta_hash_init(&state, context);
+
+    while (length > 0){
+        unsigned int chunk = (length < RASTA_HASH_CRC_CHUNK) ? length : RASTA_HASH_CRC_CHUNK;
+
+        rasta_hash_update(&state, data, chunk);
+        crc = crc_update(crc_options, crc, data, chunk);
+
+        data += chunk;
+        length -= chunk;
+    }
+
+    rasta_hash_final(&state, hash);
+    return crc;
+}
+
+/**
+ * checks the checksums of messages one by one
+ * @param context the hashing context that contains the neccessary parameters for hashing the data
+ * @param data the messages
+ * @param lengths the amount of bytes in every message
+ * @param hashes the checksums that are expected for the messages
+ * @param count the amount of messages
+ * @param results set to 1 for every message whose checksum is correct, 0 otherwise
+ */
+static void verify_each(rasta_hashing_context_t * context, const unsigned char * const * data,
+                        const unsigned int * lengths, const unsigned char * const * hashes, unsigned int count,
+                        int * results){
+    unsigned int hash_len = context->hash_length * 8;
+
+    if(!context->key.length){
+        // should never happen
+        abort();
+    }
+
+    // the parameters are the same for all messages
+    rasta_hash_function hash_function = rasta_hash_select(context);
+    for (unsigned int i = 0; i < count; i++){
+        unsigned char hash[16];
+
+        hash_function(context, data[i], lengths[i], hash);
+        results[i] = (rmemcmp(hash, hashes[i], hash_len) == 0);
+    }
+}
+
+void rasta_hash_verify_batch(rasta_hashing_context_t * context, const unsigned char * const * data,
+                             const unsigned int * lengths, const unsigned char * const * hashes, unsigned int count,
+                             int * results){
+    unsigned int hash_len = context->hash_length * 8;
+
+    // a single message would leave most lanes unused
+    if (count == 1 || context->hash_length == RASTA_CHECKSUM_NONE || context->hash_length > RASTA_CHECKSUM_16B){
+        verify_each(context, data, lengths, hashes, count, results);
+        return;
+    }
+
+    if(!context->key.length){
+        // should never happen
+        abort();
+    }
+
+    if (context->algorithm == RASTA_ALGO_BLAKE2B){
+        // all messages continue after the prepared key block, rasta_blake2b_multi() compresses it if the key can not
+        // be prepared
+        rasta_blake2b_ctx keyed;
+        if (blake2b_start(&keyed, context, context->hash_length, 1)){
+            // the key can not be used, see rasta_hash_init()
+            verify_each(context, data, lengths, hashes, count, results);
+            return;
+        }
+
+        for (unsigned int i = 0; i < count; i += BLAKE2B_LANES){
+            unsigned int n = (count - i < BLAKE2B_LANES) ? count - i : BLAKE2B_LANES;
+            unsigned char digests[BLAKE2B_LANES][64];
+
+            rasta_blake2b_multi(&keyed, &data[i], &lengths[i], n, digests);
+            for (unsigned int j = 0; j < n; j++){
+                if (lengths[i + j] == 0 && keyed.c == 0){
+                    // the key block is the last block of an empty message
+                    verify_each(context, &data[i + j], &lengths[i + j], &hashes[i + j], 1, &results[i + j]);
+                } else{
+                    results[i + j] = (rmemcmp(digests[j], hashes[i + j], hash_len) == 0);
+                }
+            }
+        }
+        return;
+    }
+
+    if (context->algorithm == RASTA_ALGO_SIPHASH_2_4){
+        for (unsigned int i = 0; i < count; i += SIPHASH_LANES){
+            unsigned int n = (count - i < SIPHASH_LANES) ? count - i : SIPHASH_LANES;
+            unsigned char digests[SIPHASH_LANES][16];
+
+            rasta_siphash24_multi_keyed(context->siphash24_keyed[context->hash_length - 1], context->hash_length,
+                                        &data[i], &lengths[i], n, digests);
+            for (unsigned int j = 0; j < n; j++){
+                results[i + j] = (rmemcmp(digests[j], hashes[i + j], hash_len) == 0);
+            }
+        }
+        return;
+    }
+
+    // MD4 (also used for unknown algorithms, see rasta_hash_init()). All messages start with the prepared state, so
+    // they are hashed side by side
+    for (unsigned int i = 0; i < count; i += MD4_LANES){
+        unsigned int n = (count - i < MD4_LANES) ? count - i : MD4_LANES;
+        unsigned char digests[MD4_LANES][16];
+
+        md4MultiBuffer(&context->md4_context, &data[i], &lengths[i], n, digests);
+
+        for (unsigned int j = 0; j < n; j++){
+            // the safety code is the beginning of the hash
+            results[i + j] = (rmemcmp(digests[j], hashes[i + j], hash_len) == 0);
+        }
+    }
+}
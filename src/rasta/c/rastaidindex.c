@@ -0,0 +1,125 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
+#include "rastaidindex.h"
+#include "rmemory.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * amount of slots of a new index
+ */
+#define ID_INDEX_INITIAL_CAPACITY 32
+
+/**
+ * calculates the home slot of a RaSTA ID
+ * @param id the RaSTA ID
+ * @param capacity the amount of slots, has to be a power of two
+ * @return the slot
+ */
+static unsigned int id_index_slot(unsigned long id, unsigned int capacity) {
+    // RaSTA IDs are often consecutive, mix the bits so they do not cluster
+    uint64_t hash = (uint64_t) id;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (unsigned int) (hash & (capacity - 1));
+}
+
+/**
+ * allocates the slots of the index, all slots are free afterwards
+ * @param index the index
+ * @param capacity the amount of slots, has to be a power of two
+ */
+static void id_index_allocate(struct rasta_id_index * index, unsigned int capacity) {
+    index->entries = rmalloc(capacity * sizeof(struct rasta_id_index_entry));
+    rmemset(index->entries, 0, capacity * sizeof(struct rasta_id_index_entry));
+    index->capacity = capacity;
+    index->count = 0;
+}
+
+/**
+ * finds the slot of a RaSTA ID
+ * @param index the index
+ * @param id the RaSTA ID
+ * @return the slot of the ID or the free slot where it would be inserted
+ */
+static unsigned int id_index_find(struct rasta_id_index * index, unsigned long id) {
+    unsigned int mask = index->capacity - 1;
+    unsigned int slot = id_index_slot(id, index->capacity);
+    while (index->entries[slot].value != NULL && index->entries[slot].id != id) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void rasta_id_index_init(struct rasta_id_index * index) {
+    id_index_allocate(index, ID_INDEX_INITIAL_CAPACITY);
+}
+
+void rasta_id_index_free(struct rasta_id_index * index) {
+    rfree(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+void rasta_id_index_put(struct rasta_id_index * index, unsigned long id, void * value) {
+    if (index->capacity == 0) {
+        // the index was freed before
+        id_index_allocate(index, ID_INDEX_INITIAL_CAPACITY);
+    }
+
+    // keep the load factor at most 1/2, so probe sequences stay short
+    if (2 * (index->count + 1) > index->capacity) {
+        struct rasta_id_index_entry * old_entries = index->entries;
+        unsigned int old_capacity = index->capacity;
+
+        id_index_allocate(index, 2 * old_capacity);
+        for (unsigned int i = 0; i < old_capacity; ++i) {
+            if (old_entries[i].value != NULL) {
+                index->entries[id_index_find(index, old_entries[i].id)] = old_entries[i];
+                index->count++;
+            }
+        }
+        rfree(old_entries);
+    }
+
+    unsigned int slot = id_index_find(index, id);
+    if (index->entries[slot].value == NULL) {
+        index->count++;
+    }
+    index->entries[slot].id = id;
+    index->entries[slot].value = value;
+}
+
+void * rasta_id_index_get(struct rasta_id_index * index, unsigned long id) {
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    return index->entries[id_index_find(index, id)].value;
+}
+
+void rasta_id_index_remove(struct rasta_id_index * index, unsigned long id) {
+    if (index->capacity == 0) {
+        return;
+    }
+    unsigned int mask = index->capacity - 1;
+    unsigned int slot = id_index_find(index, id);
+    if (index->entries[slot].value == NULL) {
+        return;
+    }
+    index->entries[slot].value = NULL;
+    index->count--;
+
+    // move the following entries back, so no probe sequence is interrupted by the free slot
+    unsigned int next = (slot + 1) & mask;
+    while (index->entries[next].value != NULL) {
+        unsigned int home = id_index_slot(index->entries[next].id, index->capacity);
+        // the entry may fill the free slot if its home is not in the cyclic range (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            index->entries[slot] = index->entries[next];
+            index->entries[next].value = NULL;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
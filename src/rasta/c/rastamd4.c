@@ -23,9 +23,20 @@
 	(a) += f((b), (c), (d)) + (x); \
 	(a) = (((a) << (s)) | (((a) & 0xffffffff) >> (32 - (s))));
 
-#if defined(__i386__) || defined(__x86_64__) || defined(__vax__)
+#if defined(__i386__) || defined(__x86_64__) || defined(__vax__) || defined(__aarch64__) || \
+	(defined(__ARM_FEATURE_UNALIGNED) && defined(__ARMEL__))
+/*
+ * Little-endian targets that load unaligned words read the block directly. The copy compiles to a single load and,
+ * unlike a cast, is allowed for data of any alignment
+ */
+static inline MD4_u32plus load_word(const unsigned char *ptr)
+{
+    MD4_u32plus word;
+    memcpy(&word, ptr, sizeof(word));
+    return word;
+}
 #define SET(n) \
-	(*(MD4_u32plus *)&ptr[(n) * 4])
+	load_word(&ptr[(n) * 4])
 #define GET(n) \
 	SET(n)
 #else
@@ -217,6 +228,217 @@ void MD4_Final_Rasta(unsigned char *result, MD4_CTX_RASTA *ctx)
     memset(ctx, 0, sizeof(*ctx));
 }
 
+#ifndef USE_OPENSSL
+/**
+ * the MD4 words of MD4_LANES messages, one message per lane. The vector extension is translated to SSE2 on x86 and
+ * NEON on ARM
+ */
+typedef MD4_u32plus md4_lanes __attribute__((vector_size(MD4_LANES * sizeof(MD4_u32plus))));
+
+/**
+ * processes one 64-byte block of every lane
+ * @param state the a, b, c, d words of the lanes
+ * @param block the 16 words of the block of every lane
+ */
+static void body_lanes(md4_lanes state[4], const md4_lanes block[16])
+{
+    md4_lanes a, b, c, d;
+    const MD4_u32plus ac1 = 0x5a827999, ac2 = 0x6ed9eba1;
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+
+/* Round 1 */
+    STEP(F, a, b, c, d, block[0], 3)
+    STEP(F, d, a, b, c, block[1], 7)
+    STEP(F, c, d, a, b, block[2], 11)
+    STEP(F, b, c, d, a, block[3], 19)
+    STEP(F, a, b, c, d, block[4], 3)
+    STEP(F, d, a, b, c, block[5], 7)
+    STEP(F, c, d, a, b, block[6], 11)
+    STEP(F, b, c, d, a, block[7], 19)
+    STEP(F, a, b, c, d, block[8], 3)
+    STEP(F, d, a, b, c, block[9], 7)
+    STEP(F, c, d, a, b, block[10], 11)
+    STEP(F, b, c, d, a, block[11], 19)
+    STEP(F, a, b, c, d, block[12], 3)
+    STEP(F, d, a, b, c, block[13], 7)
+    STEP(F, c, d, a, b, block[14], 11)
+    STEP(F, b, c, d, a, block[15], 19)
+
+/* Round 2 */
+    STEP(G, a, b, c, d, block[0] + ac1, 3)
+    STEP(G, d, a, b, c, block[4] + ac1, 5)
+    STEP(G, c, d, a, b, block[8] + ac1, 9)
+    STEP(G, b, c, d, a, block[12] + ac1, 13)
+    STEP(G, a, b, c, d, block[1] + ac1, 3)
+    STEP(G, d, a, b, c, block[5] + ac1, 5)
+    STEP(G, c, d, a, b, block[9] + ac1, 9)
+    STEP(G, b, c, d, a, block[13] + ac1, 13)
+    STEP(G, a, b, c, d, block[2] + ac1, 3)
+    STEP(G, d, a, b, c, block[6] + ac1, 5)
+    STEP(G, c, d, a, b, block[10] + ac1, 9)
+    STEP(G, b, c, d, a, block[14] + ac1, 13)
+    STEP(G, a, b, c, d, block[3] + ac1, 3)
+    STEP(G, d, a, b, c, block[7] + ac1, 5)
+    STEP(G, c, d, a, b, block[11] + ac1, 9)
+    STEP(G, b, c, d, a, block[15] + ac1, 13)
+
+/* Round 3 */
+    STEP(H, a, b, c, d, block[0] + ac2, 3)
+    STEP(H, d, a, b, c, block[8] + ac2, 9)
+    STEP(H, c, d, a, b, block[4] + ac2, 11)
+    STEP(H, b, c, d, a, block[12] + ac2, 15)
+    STEP(H, a, b, c, d, block[2] + ac2, 3)
+    STEP(H, d, a, b, c, block[10] + ac2, 9)
+    STEP(H, c, d, a, b, block[6] + ac2, 11)
+    STEP(H, b, c, d, a, block[14] + ac2, 15)
+    STEP(H, a, b, c, d, block[1] + ac2, 3)
+    STEP(H, d, a, b, c, block[9] + ac2, 9)
+    STEP(H, c, d, a, b, block[5] + ac2, 11)
+    STEP(H, b, c, d, a, block[13] + ac2, 15)
+    STEP(H, a, b, c, d, block[3] + ac2, 3)
+    STEP(H, d, a, b, c, block[11] + ac2, 9)
+    STEP(H, c, d, a, b, block[7] + ac2, 11)
+    STEP(H, b, c, d, a, block[15] + ac2, 15)
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+/**
+ * copies a block of a message including the MD4 padding
+ * @param data the message
+ * @param length the length of the message
+ * @param index the index of the block
+ * @param block the 64 bytes of the block
+ */
+static void md4_padded_block(const unsigned char* data, unsigned int length, unsigned int index, unsigned char* block)
+{
+    unsigned long start = (unsigned long) index * 64;
+
+    if (start + 64 <= length) {
+        memcpy(block, &data[start], 64);
+        return;
+    }
+
+    unsigned long available = (start < length) ? length - start : 0;
+    memset(block, 0, 64);
+    if (available > 0) {
+        memcpy(block, &data[start], available);
+    }
+
+    if (start <= length) {
+        // the padding starts with a single 1 bit
+        block[available] = 0x80;
+    }
+
+    if (index == (length + 8) / 64) {
+        // the last block ends with the message length in bits
+        unsigned long long bits = (unsigned long long) length << 3;
+        for (int i = 0; i < 8; i++) {
+            block[56 + i] = (unsigned char)(bits >> (8 * i));
+        }
+    }
+}
+
+/**
+ * hashes up to MD4_LANES messages at once
+ * @param context the state every message starts with
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages, at most MD4_LANES
+ * @param results the full MD4-Hashes of the messages
+ */
+static void md4_lanes_hash(const MD4_CONTEXT* context, const unsigned char* const* data, const unsigned int* lengths,
+                           unsigned int count, unsigned char (*results)[16])
+{
+    md4_lanes state[4];
+    unsigned int blocks[MD4_LANES];
+    unsigned int max_blocks = 0;
+
+    for (int l = 0; l < MD4_LANES; l++) {
+        state[0][l] = context->a;
+        state[1][l] = context->b;
+        state[2][l] = context->c;
+        state[3][l] = context->d;
+
+        // unused lanes do not process any block
+        blocks[l] = ((unsigned int) l < count) ? (lengths[l] + 8) / 64 + 1 : 0;
+        if (blocks[l] > max_blocks) {
+            max_blocks = blocks[l];
+        }
+    }
+
+    for (unsigned int index = 0; index < max_blocks; index++) {
+        unsigned char bytes[MD4_LANES][64];
+        md4_lanes block[16];
+        md4_lanes active;
+
+        for (int l = 0; l < MD4_LANES; l++) {
+            active[l] = (index < blocks[l]) ? 0xffffffff : 0;
+            if (index < blocks[l]) {
+                md4_padded_block(data[l], lengths[l], index, bytes[l]);
+            } else {
+                memset(bytes[l], 0, 64);
+            }
+
+            for (int w = 0; w < 16; w++) {
+                block[w][l] = (MD4_u32plus)bytes[l][w * 4] |
+                              ((MD4_u32plus)bytes[l][w * 4 + 1] << 8) |
+                              ((MD4_u32plus)bytes[l][w * 4 + 2] << 16) |
+                              ((MD4_u32plus)bytes[l][w * 4 + 3] << 24);
+            }
+        }
+
+        md4_lanes updated[4] = { state[0], state[1], state[2], state[3] };
+        body_lanes(updated, block);
+
+        // lanes whose message is complete keep their state
+        for (int i = 0; i < 4; i++) {
+            state[i] = (updated[i] & active) | (state[i] & ~active);
+        }
+    }
+
+    for (unsigned int l = 0; l < count; l++) {
+        OUT(&results[l][0], state[0][l])
+        OUT(&results[l][4], state[1][l])
+        OUT(&results[l][8], state[2][l])
+        OUT(&results[l][12], state[3][l])
+    }
+}
+#endif
+
+void md4MultiBuffer(const MD4_CONTEXT* context, const unsigned char* const* data, const unsigned int* lengths,
+                    unsigned int count, unsigned char (*results)[16]) {
+#ifdef USE_OPENSSL
+    for (unsigned int i = 0; i < count; i++) {
+        MD4_CONTEXT copy = *context;
+        MD4_Update (&copy, data[i], lengths[i]);
+        MD4_Final (results[i], &copy);
+    }
+#else
+    if (context->lo != 0 || context->hi != 0) {
+        // the lanes expect a state that did not process any data yet
+        for (unsigned int i = 0; i < count; i++) {
+            MD4_CONTEXT copy = *context;
+            MD4_Update_Rasta(&copy, data[i], lengths[i]);
+            MD4_Final_Rasta(results[i], &copy);
+        }
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; i += MD4_LANES) {
+        unsigned int lanes = (count - i < MD4_LANES) ? count - i : MD4_LANES;
+        md4_lanes_hash(context, &data[i], &lengths[i], lanes, &results[i]);
+    }
+#endif
+}
+
 MD4_CONTEXT md4InitContext (MD4_u32plus a, MD4_u32plus b, MD4_u32plus c, MD4_u32plus d){
 #ifdef USE_OPENSSL
     MD4_CTX context;
@@ -247,13 +469,19 @@ void generateMD4(unsigned char* data, int length, int type, unsigned char* resul
     generateMD4WithVector(data, length, type, &context, result);
 }
 
-void generateMD4WithVector(unsigned char* data, int length, int type, MD4_CONTEXT* context, unsigned char* result) {
-    unsigned char MD4code[type == 2 ? 16 : 8];
+void md4Update(MD4_CONTEXT* context, const unsigned char* data, unsigned long length) {
 #ifdef USE_OPENSSL
     MD4_Update (context, data, length);
-    MD4_Final (MD4code, context);
 #else
     MD4_Update_Rasta(context, data, length);
+#endif
+}
+
+void md4Final(MD4_CONTEXT* context, int type, unsigned char* result) {
+    unsigned char MD4code[16];
+#ifdef USE_OPENSSL
+    MD4_Final (MD4code, context);
+#else
     MD4_Final_Rasta(MD4code, context);
 #endif
 
@@ -280,4 +508,9 @@ void generateMD4WithVector(unsigned char* data, int length, int type, MD4_CONTEX
         default:
             return;
     }
-}
\ No newline at end of file
+}
+
+void generateMD4WithVector(unsigned char* data, int length, int type, MD4_CONTEXT* context, unsigned char* result) {
+    md4Update(context, data, (unsigned long) length);
+    md4Final(context, type, result);
+}
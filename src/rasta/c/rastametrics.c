@@ -0,0 +1,176 @@
+#include <stdint.h>
+#include <string.h>
+#include "rastametrics.h"
+
+#define SUB_BUCKETS (1u << RASTA_HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * @param value a value
+ * @return the index of the bucket that counts @p value
+ */
+static unsigned int bucket_index(unsigned long value) {
+    if (value > UINT32_MAX) {
+        value = UINT32_MAX;
+    }
+    if (value < SUB_BUCKETS) {
+        return (unsigned int) value;
+    }
+
+    // the position of the highest set bit selects the power of two, the bits below it the sub-bucket
+    unsigned int magnitude = (unsigned int) (sizeof(unsigned long) * 8 - 1) - (unsigned int) __builtin_clzl(value);
+    unsigned int shift = magnitude - RASTA_HISTOGRAM_SUB_BUCKET_BITS;
+    return ((shift + 1) << RASTA_HISTOGRAM_SUB_BUCKET_BITS) + (unsigned int) ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+void rasta_histogram_record(struct rasta_histogram * histogram, unsigned long value) {
+    rasta_metrics_add(&histogram->buckets[bucket_index(value)], 1);
+    rasta_metrics_add(&histogram->count, 1);
+    rasta_metrics_add(&histogram->sum, value);
+    if (value > rasta_metrics_read(&histogram->max)) {
+        __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+    }
+}
+
+void rasta_histogram_snapshot(const struct rasta_histogram * histogram, struct rasta_histogram * out) {
+    for (unsigned int i = 0; i < RASTA_HISTOGRAM_BUCKETS; i++) {
+        out->buckets[i] = rasta_metrics_read(&histogram->buckets[i]);
+    }
+    out->count = rasta_metrics_read(&histogram->count);
+    out->sum = rasta_metrics_read(&histogram->sum);
+    out->max = rasta_metrics_read(&histogram->max);
+}
+
+unsigned long rasta_histogram_bucket_limit(unsigned int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    unsigned int shift = (bucket >> RASTA_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    unsigned long lower = (unsigned long) (SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+    return lower + (1ul << shift) - 1;
+}
+
+unsigned long rasta_histogram_percentile(const struct rasta_histogram * histogram, double percentile) {
+    unsigned long count = 0;
+    for (unsigned int i = 0; i < RASTA_HISTOGRAM_BUCKETS; i++) {
+        count += histogram->buckets[i];
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // the rank of the value that is at the percentile, starting with 1
+    unsigned long rank = (unsigned long) (percentile / 100.0 * (double) count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > count) {
+        rank = count;
+    }
+
+    unsigned long seen = 0;
+    for (unsigned int i = 0; i < RASTA_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            unsigned long limit = rasta_histogram_bucket_limit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void rasta_receive_stage_record(struct rasta_receive_stage_metrics * metrics, rasta_receive_stage stage,
+                                unsigned int pdus, unsigned long duration) {
+    rasta_metrics_add(&metrics->batches[stage], 1);
+    rasta_metrics_add(&metrics->pdus[stage], pdus);
+    rasta_histogram_record(&metrics->duration[stage], duration);
+}
+
+void rasta_receive_stage_reject(struct rasta_receive_stage_metrics * metrics, rasta_receive_stage stage,
+                                unsigned int pdus) {
+    rasta_metrics_add(&metrics->rejected[stage], pdus);
+}
+
+void rasta_receive_stage_snapshot(const struct rasta_receive_stage_metrics * metrics,
+                                  struct rasta_receive_stage_metrics * out) {
+    for (unsigned int i = 0; i < RASTA_RECEIVE_STAGES; i++) {
+        out->batches[i] = rasta_metrics_read(&metrics->batches[i]);
+        out->pdus[i] = rasta_metrics_read(&metrics->pdus[i]);
+        out->rejected[i] = rasta_metrics_read(&metrics->rejected[i]);
+        rasta_histogram_snapshot(&metrics->duration[i], &out->duration[i]);
+    }
+}
+
+const char * rasta_receive_stage_name(rasta_receive_stage stage) {
+    static const char * const names[RASTA_RECEIVE_STAGES] = {
+        [RASTA_RECEIVE_STAGE_DRAIN] = "drain",
+        [RASTA_RECEIVE_STAGE_CRC] = "crc",
+        [RASTA_RECEIVE_STAGE_PLAUSIBILITY] = "plausibility",
+        [RASTA_RECEIVE_STAGE_SAFETY_CODE] = "safety_code",
+        [RASTA_RECEIVE_STAGE_SEQUENCING] = "sequencing",
+        [RASTA_RECEIVE_STAGE_DISPATCH] = "dispatch",
+    };
+    return (unsigned int) stage < RASTA_RECEIVE_STAGES ? names[stage] : "unknown";
+}
+
+void rasta_residency_record(struct rasta_residency_metrics * metrics, rasta_residency_stage stage, uint64_t since_ns,
+                            uint64_t now_ns) {
+    if (metrics == NULL || since_ns == 0) {
+        return;
+    }
+    unsigned long wait_us = now_ns > since_ns ? (unsigned long) ((now_ns - since_ns) / 1000) : 0;
+    rasta_histogram_record(&metrics->wait_us[stage], wait_us);
+}
+
+void rasta_residency_snapshot(const struct rasta_residency_metrics * metrics, rasta_residency_stage first,
+                              rasta_residency_stage last, struct rasta_residency_metrics * out) {
+    if (metrics == NULL) {
+        return;
+    }
+    for (unsigned int i = first; i <= last; i++) {
+        rasta_histogram_snapshot(&metrics->wait_us[i], &out->wait_us[i]);
+    }
+}
+
+const char * rasta_residency_stage_name(rasta_residency_stage stage) {
+    static const char * const names[RASTA_RESIDENCY_STAGES] = {
+        [RASTA_RESIDENCY_SEND_QUEUE] = "send_queue",
+        [RASTA_RESIDENCY_TRANSMIT] = "transmit",
+        [RASTA_RESIDENCY_DEFER] = "defer",
+        [RASTA_RESIDENCY_RECEIVE_QUEUE] = "receive_queue",
+        [RASTA_RESIDENCY_APPLICATION] = "application",
+    };
+    return (unsigned int) stage < RASTA_RESIDENCY_STAGES ? names[stage] : "unknown";
+}
+
+/**
+ * @param a what a peer costs
+ * @param b what another peer costs
+ * @return 1 if @p a is ranked in front of @p b
+ */
+static int peer_usage_greater(const struct rasta_peer_usage * a, const struct rasta_peer_usage * b) {
+    unsigned long a_ns = rasta_peer_usage_ns(a);
+    unsigned long b_ns = rasta_peer_usage_ns(b);
+    if (a_ns != b_ns) {
+        return a_ns > b_ns;
+    }
+    return a->bytes_in + a->bytes_out > b->bytes_in + b->bytes_out;
+}
+
+unsigned int rasta_peer_ranking_insert(struct rasta_peer_usage * ranking, unsigned int count, unsigned int capacity,
+                                       const struct rasta_peer_usage * usage) {
+    // the ranking is short, an insertion keeps it ordered without sorting all connections
+    unsigned int position = count;
+    while (position > 0 && peer_usage_greater(usage, &ranking[position - 1])) {
+        position--;
+    }
+    if (position >= capacity) {
+        return count;
+    }
+    if (count == capacity) {
+        count--;
+    }
+    memmove(&ranking[position + 1], &ranking[position], (count - position) * sizeof(*ranking));
+    ranking[position] = *usage;
+    return count + 1;
+}
@@ -1,11 +1,19 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_CODEC
 #include "rastamodule.h"
+#include "rastawire.h"
 #include "rmemory.h"
-#include <endian.h>
 
 //
 // Created by tobia on 27.11.2017.
 //
 
+_Static_assert(RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP + 4 == RASTA_SR_HEADER_LENGTH,
+               "the data follows the confirmed timestamp");
+_Static_assert(RASTA_RED_OFFSET_SEQUENCE_NUMBER + 4 == RASTA_RED_HEADER_LENGTH,
+               "the SR layer PDU follows the redundancy sequence number");
+_Static_assert(RASTA_CONN_DATA_OFFSET_RESERVE + 8 == RASTA_CONN_DATA_LENGTH,
+               "8 reserved bytes end the connection data");
+
 rasta_error_type rastamodule_lasterror = RASTA_ERRORS_NONE;
 
 
@@ -21,8 +29,7 @@ rasta_error_type getRastamoduleLastError() {
  * @param result the assigned uchar array; length should be 2
  */
 void hostShortTole(uint16_t v, unsigned char* result) {
-    uint16_t *target = (uint16_t *) result;
-    *target = htole16(v);
+    rasta_wire_put_u16(result, v);
 }
 
 /**
@@ -31,15 +38,17 @@ void hostShortTole(uint16_t v, unsigned char* result) {
  * @return the ushort
  */
 uint16_t leShortToHost(const unsigned char *v) {
-    const uint16_t *value_network_byte_order = (uint16_t *) v;
-    return le16toh(*value_network_byte_order);
+    return rasta_wire_get_u16(v);
 }
 
 
 unsigned int getDataLength(struct RastaPacket packet, rasta_hashing_context_t * hashing_context) {
     //calculated depending on the checksum type
-    unsigned int length = packet.length - 28 - hashing_context->hash_length * 8;
-    return (length > 0) ? (unsigned int)length : 0;
+    unsigned int checksum_len = hashing_context->hash_length * 8;
+    if (packet.length < RASTA_SR_HEADER_LENGTH + checksum_len) {
+        return 0;
+    }
+    return rasta_sr_data_length(packet.length, checksum_len);
 }
 
 
@@ -57,7 +66,7 @@ struct RastaByteArray allocateBytes(struct RastaPacket packet, rasta_hashing_con
     allocateRastaByteArray(&result,packet.length);
     //check packet length
     unsigned int checksum_len = hashing_context->hash_length * 8;
-    if (packet.length < (28+checksum_len)) rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
+    if (packet.length < rasta_sr_pdu_length(0, checksum_len)) rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
     return result;
 }
 
@@ -67,64 +76,65 @@ struct RastaByteArray allocateBytes(struct RastaPacket packet, rasta_hashing_con
  * @param packet the packet to pack
  */
 void packFields(struct RastaByteArray result, struct RastaPacket packet) {
+    rasta_sr_header_write(result.bytes, packet.length, packet.type, packet.receiver_id, packet.sender_id,
+                          packet.sequence_number, packet.confirmed_sequence_number, packet.timestamp,
+                          packet.confirmed_timestamp);
+}
 
-    //pack message length
-    hostShortTole(packet.length, &result.bytes[0]);
 
-    //pack message type
-    uint16_t type = packet.type;
+/**
+ * writes the header fields and the data of a rasta packet into a buffer, but not its safety code
+ * @param packet the packet
+ * @param checksum_len the length of the safety code in bytes
+ * @param buffer the buffer
+ * @param capacity the amount of bytes that fit into @p buffer
+ * @return 0 if the length field of the packet is invalid or the packet does not fit, 1 otherwise
+ */
+static int packPacket(const struct RastaPacket * packet, unsigned int checksum_len, unsigned char * buffer,
+                      unsigned int capacity) {
+    if (packet->length < rasta_sr_pdu_length(0, checksum_len) || packet->length > capacity) {
+        return 0;
+    }
 
-    hostShortTole(type, &result.bytes[2]);
+    rasta_sr_header_write(buffer, packet->length, packet->type, packet->receiver_id, packet->sender_id,
+                          packet->sequence_number, packet->confirmed_sequence_number, packet->timestamp,
+                          packet->confirmed_timestamp);
 
-    //pack receiver id
-    hostLongToLe(packet.receiver_id, &result.bytes[4]);
+    //pack data, the PDUs without data like heartbeats have no bytes
+    unsigned int data_length = rasta_sr_data_length(packet->length, checksum_len);
+    if (data_length > 0) {
+        rmemcpy(&buffer[RASTA_SR_OFFSET_DATA], packet->data.bytes, data_length);
+    }
 
-    //pack sender id
-    hostLongToLe(packet.sender_id, &result.bytes[8]);
+    return 1;
+}
 
-    //pack sequence number
-    hostLongToLe(packet.sequence_number, &result.bytes[12]);
+unsigned int rastaPacketEncode(const struct RastaPacket * packet, rasta_hashing_context_t * hashing_context,
+                               unsigned char * buffer, unsigned int capacity) {
+    unsigned int checksum_len = hashing_context->hash_length * 8;
+    if (!packPacket(packet, checksum_len, buffer, capacity)) {
+        return 0;
+    }
 
-    //pack confirmed sequence number
-    hostLongToLe(packet.confirmed_sequence_number, &result.bytes[16]);
+    //calculate the safety code over everything in front of it and write it behind the data
+    unsigned char checksum[16];
+    struct RastaByteArray data_to_hash;
+    data_to_hash.bytes = buffer;
+    data_to_hash.length = packet->length - checksum_len;
 
-    //pack timestamp
-    hostLongToLe(packet.timestamp, &result.bytes[20]);
+    rasta_calculate_hash(data_to_hash, hashing_context, checksum);
+    rmemcpy(&buffer[packet->length - checksum_len], checksum, checksum_len);
 
-    //pack confirmed timestamp
-    hostLongToLe(packet.confirmed_timestamp, &result.bytes[24]);
+    return packet->length;
 }
 
-
 struct RastaByteArray rastaModuleToBytes(struct RastaPacket packet, rasta_hashing_context_t * hashing_context) {
     struct RastaByteArray result;
     result = allocateBytes(packet, hashing_context);
 
     if (rastamodule_lasterror != RASTA_ERRORS_NONE) return result;
 
-    packFields(result, packet);
-
-    //pack data
-    unsigned int len = getDataLength(packet, hashing_context);
-    for (unsigned int i = 0; i < len; i++) {
-        result.bytes[28+i] = packet.data.bytes[i];
-    }
-
-    //calculate md4 checksum
-    unsigned char checksum[16];
-    unsigned int checksum_len = hashing_context->hash_length * 8;
-
-    struct RastaByteArray data_to_hash;
-    allocateRastaByteArray(&data_to_hash, (unsigned int)(packet.length - checksum_len));
-    rmemcpy(data_to_hash.bytes, result.bytes, (unsigned int)(packet.length - checksum_len));
-
-    rasta_calculate_hash(data_to_hash, hashing_context, checksum);
-
-    freeRastaByteArray(&data_to_hash);
-
-    for (unsigned int i = 0; i < checksum_len; i++) {
-        result.bytes[28+len+i] = checksum[i];
-    }
+    rastaPacketEncode(&packet, hashing_context, result.bytes, result.length);
 
     return result;
 }
@@ -139,204 +149,441 @@ struct RastaByteArray rastaModuleToBytesNoChecksum(struct RastaPacket packet, ra
 
     //pack data
     unsigned int len = getDataLength(packet, hashing_context);
-    /*for (int i = 0; i < len; i++) {
-        result.bytes[28+i] = packet.data.bytes[i];
-    }*/
-    rmemcpy(&result.bytes[28], packet.data.bytes, len);
+    if (len > 0) {
+        rmemcpy(&result.bytes[RASTA_SR_OFFSET_DATA], packet.data.bytes, len);
+    }
 
 
     //pack checksum
     unsigned int checksum_len = hashing_context->hash_length * 8;
-    /*for (int j = 0; j < checksum_len; ++j) {
-        result.bytes[28+len+j] = packet.checksum.bytes[j];
-    }*/
-    rmemcpy(&result.bytes[28 + len], packet.checksum.bytes, checksum_len);
+    if (checksum_len > 0) {
+        rmemcpy(&result.bytes[RASTA_SR_OFFSET_DATA + len], packet.checksum.bytes, checksum_len);
+    }
 
     return result;
 }
 
-struct RastaPacket bytesToRastaPacket(struct RastaByteArray data, rasta_hashing_context_t * hashing_context) {
+/**
+ * creates a packet that marks a failed decode, it has length 0 and owns no memory
+ * @return the packet
+ */
+static struct RastaPacket invalidRastaPacket() {
     struct RastaPacket result;
+    rmemset(&result, 0, sizeof(result));
+    result.length = 0;
+    result.checksum_correct = 0;
+    result.data.bytes = NULL;
+    result.checksum.bytes = NULL;
+    return result;
+}
 
-    result.checksum_correct = 1;
+/**
+ * decodes a rasta packet without copying it, but does not check the safety code
+ * @param bytes the buffer that contains the packet
+ * @param length the amount of bytes in @p bytes
+ * @param checksum_len the length of the safety code in bytes
+ * @param view the view that is filled, checksum_correct is not set
+ * @return 1 if the packet was decoded, 0 if @p length or the length field of the packet is invalid
+ */
+static int parsePacketView(const unsigned char * bytes, unsigned int length, unsigned int checksum_len,
+                           struct RastaPacketView * view) {
 
-    if (data.length < 28 + hashing_context->hash_length * 8) {
-        result.length = 0;
-        result.checksum_correct = 0;
-        rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
-        return result;
+    if (length < rasta_sr_pdu_length(0, checksum_len)) {
+        return 0;
     }
 
-    //length
-    result.length = leShortToHost(&data.bytes[0]);
-
+    view->length = rasta_wire_get_u16(&bytes[RASTA_SR_OFFSET_LENGTH]);
+    if (view->length < rasta_sr_pdu_length(0, checksum_len) || view->length > length) {
+        return 0;
+    }
 
+    view->type = (rasta_conn_type) rasta_wire_get_u16(&bytes[RASTA_SR_OFFSET_TYPE]);
+    view->receiver_id = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_RECEIVER_ID]);
+    view->sender_id = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_SENDER_ID]);
+    view->sequence_number = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_SEQUENCE_NUMBER]);
+    view->confirmed_sequence_number = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_CONFIRMED_SEQUENCE_NUMBER]);
+    view->timestamp = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_TIMESTAMP]);
+    view->confirmed_timestamp = rasta_wire_get_u32(&bytes[RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP]);
 
-    //type
-    result.type = (rasta_conn_type) leShortToHost(&data.bytes[2]);
+    //data
+    view->data = &bytes[RASTA_SR_OFFSET_DATA];
+    view->data_length = rasta_sr_data_length(view->length, checksum_len);
 
-    //receiver id
-    result.receiver_id = leLongToHost(&data.bytes[4]);
+    view->checksum = &bytes[RASTA_SR_OFFSET_DATA + view->data_length];
+    view->checksum_length = checksum_len;
 
-    //sender id
-    result.sender_id = leLongToHost(&data.bytes[8]);
+    return 1;
+}
 
-    //sequence number
-    result.sequence_number = leLongToHost(&data.bytes[12]);
+int rastaPacketViewFromBytes(const unsigned char * bytes, unsigned int length, rasta_hashing_context_t * hashing_context,
+                             struct RastaPacketView * view) {
+    unsigned int checksum_len = hashing_context->hash_length * 8;
 
-    //confirmed sequence number
-    result.confirmed_sequence_number = leLongToHost(&data.bytes[16]);
+    if (!parsePacketView(bytes, length, checksum_len, view)) {
+        return 0;
+    }
 
-    //timestamp
-    result.timestamp = leLongToHost(&data.bytes[20]);
+    //checksum, the safety code covers everything before it
+    unsigned char checksum[16];
+    struct RastaByteArray data_to_hash;
+    data_to_hash.bytes = (unsigned char *) bytes;
+    data_to_hash.length = view->length - checksum_len;
 
-    //confirmed timestamp
-    result.confirmed_timestamp = leLongToHost(&data.bytes[24]);
+    rasta_calculate_hash(data_to_hash, hashing_context, checksum);
 
-    //data
-    result.data.length = 0;
+    view->checksum_correct = (rmemcmp(checksum, view->checksum, checksum_len) == 0);
 
-    unsigned int len = getDataLength(result, hashing_context);
-    allocateRastaByteArray(&result.data,len);
+    return 1;
+}
 
-    for (unsigned int i = 0; i < len; i++) {
-        result.data.bytes[i] = data.bytes[28+i];
-    }
+struct RastaPacket rastaPacketFromView(const struct RastaPacketView * view) {
+    struct RastaPacket result;
 
-    //checksum
-    unsigned char checksum[16];
-    unsigned int checksum_len = hashing_context->hash_length * 8;
+    result.length = view->length;
+    result.type = view->type;
+    result.receiver_id = view->receiver_id;
+    result.sender_id = view->sender_id;
+    result.sequence_number = view->sequence_number;
+    result.confirmed_sequence_number = view->confirmed_sequence_number;
+    result.timestamp = view->timestamp;
+    result.confirmed_timestamp = view->confirmed_timestamp;
 
-    struct RastaByteArray data_to_hash;
-    allocateRastaByteArray(&data_to_hash, (unsigned int)(result.length - checksum_len));
+    allocateRastaByteArray(&result.data, view->data_length);
+    rmemcpy(result.data.bytes, view->data, view->data_length);
 
-    rmemcpy(data_to_hash.bytes, data.bytes, data_to_hash.length);
+    allocateRastaByteArray(&result.checksum, view->checksum_length);
+    rmemcpy(result.checksum.bytes, view->checksum, view->checksum_length);
 
-    rasta_calculate_hash(data_to_hash, hashing_context, checksum);
+    result.checksum_correct = view->checksum_correct;
 
-    freeRastaByteArray(&data_to_hash);
+    return result;
+}
 
+struct RastaPacket bytesToRastaPacket(struct RastaByteArray data, rasta_hashing_context_t * hashing_context) {
+    struct RastaPacketView view;
 
-    allocateRastaByteArray(&result.checksum, checksum_len);
-    rmemcpy(result.checksum.bytes, &data.bytes[28+len], checksum_len);
-    result.checksum_correct = (rmemcmp(&checksum, &data.bytes[28+len], checksum_len) == 0);
+    if (!rastaPacketViewFromBytes(data.bytes, data.length, hashing_context, &view)) {
+        rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
+        return invalidRastaPacket();
+    }
 
-    return result;
+    return rastaPacketFromView(&view);
 }
 
 
-struct RastaByteArray rastaRedundancyPacketToBytes(struct RastaRedundancyPacket packet, rasta_hashing_context_t * hashing_context){
+/**
+ * writes the CRC checksum behind a redundancy layer PDU
+ * @param checksum the checksum
+ * @param crc_len the length of the checksum in bytes
+ * @param destination the bytes behind the PDU
+ */
+static void pack_redundancy_checksum(unsigned long checksum, unsigned int crc_len, unsigned char * destination){
     uint8_t checksum_storage[sizeof(uint32_t)];
-    struct RastaByteArray result;
-    allocateRastaByteArray(&result, packet.length);
+    rasta_wire_put_u32(checksum_storage, (uint32_t) checksum);
+    rmemcpy(destination, checksum_storage, crc_len);
+}
+
+/**
+ * writes the header and the CRC checksum of a redundancy layer PDU whose SR layer PDU is already in the buffer
+ * @param length_field the value of the length field
+ * @param reserve the reserve bytes
+ * @param sequence_number the redundancy layer sequence number
+ * @param length the length of the whole redundancy layer PDU
+ * @param checksum_type the options that are used to generate the CRC checksum
+ * @param buffer the buffer that contains the SR layer PDU at RASTA_RED_OFFSET_PDU
+ */
+static void wrap_redundancy_packet(uint16_t length_field, uint16_t reserve, uint32_t sequence_number,
+                                   unsigned int length, struct crc_options * checksum_type, unsigned char * buffer){
+    unsigned int crc_len = (unsigned int)(checksum_type->width / 8);
 
-    // pack packet length
-    hostShortTole(packet.length, &result.bytes[0]);
+    rasta_red_header_write(buffer, length_field, reserve, sequence_number);
 
-    // pack reserve bytes
-    hostShortTole(packet.reserve, &result.bytes[2]);
+    if (crc_len > 0){
+        struct RastaByteArray data_wo_checksum;
+        data_wo_checksum.bytes = buffer;
+        data_wo_checksum.length = length - crc_len;
 
-    //pack sequence number
-    hostLongToLe(packet.sequence_number, &result.bytes[4]);
+        // the checksum covers everything in front of it, so it is calculated on the buffer itself
+        pack_redundancy_checksum(crc_calculate(checksum_type, data_wo_checksum), crc_len, &buffer[length - crc_len]);
+    }
+}
 
-    // convert internal RaSTA packet to bytes
-    unsigned int internal_packet_len = packet.data.length;
-    struct RastaByteArray internal_packet_bytes = rastaModuleToBytes(packet.data, hashing_context);
+/**
+ * writes a redundancy layer PDU with the given length field and reserve bytes into a buffer,
+ * see rastaRedundancyPacketEncode()
+ */
+static unsigned int encode_redundancy_packet(uint16_t length_field, uint16_t reserve, uint32_t sequence_number,
+                                             const struct RastaPacket * packet, struct crc_options * checksum_type,
+                                             rasta_hashing_context_t * hashing_context, unsigned char * buffer,
+                                             unsigned int capacity){
+    unsigned int crc_len = (unsigned int)(checksum_type->width / 8);
+    unsigned int checksum_len = hashing_context->hash_length * 8;
+    unsigned int length = rasta_red_pdu_length(packet->length, crc_len);
+
+    if (length > capacity || length > UINT16_MAX){
+        return 0;
+    }
 
-    // pack data into result
-    for (unsigned int i = 0; i < internal_packet_len; ++i) {
-        result.bytes[8+i] = internal_packet_bytes.bytes[i];
+    // the SR layer PDU goes right behind the redundancy header
+    unsigned char * pdu = &buffer[RASTA_RED_OFFSET_PDU];
+    if (!packPacket(packet, checksum_len, pdu, capacity - RASTA_RED_HEADER_LENGTH - crc_len)){
+        return 0;
     }
 
-    // initialize a byte array containing all data except checksum
-    // this is needed, as otherwise the 0s/unset bytes in the result byte array will be used in calculating the checksum
-    struct RastaByteArray temp_wo_checksum;
-    unsigned int len_wo_checksum = (unsigned int)packet.length - (packet.checksum_type.width/8);
-    allocateRastaByteArray(&temp_wo_checksum, len_wo_checksum);
+    rasta_red_header_write(buffer, length_field, reserve, sequence_number);
 
-    // copy data
-    for (unsigned int j = 0; j < len_wo_checksum; ++j) {
-        temp_wo_checksum.bytes[j] = result.bytes[j];
+    // the safety code and the CRC checksum are calculated in one pass over the SR layer PDU, the CRC checksum also
+    // covers the safety code
+    unsigned char * safety_code = &pdu[packet->length - checksum_len];
+    unsigned char checksum[16];
+    unsigned long crc = crc_begin(checksum_type);
+    crc = crc_update(checksum_type, crc, buffer, RASTA_RED_HEADER_LENGTH);
+    crc = rasta_hash_crc_update(hashing_context, checksum_type, crc, pdu, packet->length - checksum_len, checksum);
+    rmemcpy(safety_code, checksum, checksum_len);
+
+    if (crc_len > 0){
+        crc = crc_update(checksum_type, crc, safety_code, checksum_len);
+        pack_redundancy_checksum(crc_end(checksum_type, crc), crc_len, &buffer[length - crc_len]);
     }
 
-    // generate checksum
-    unsigned long checksum = crc_calculate(&packet.checksum_type, temp_wo_checksum);
+    return length;
+}
+
+unsigned int rastaRedundancyPacketEncode(uint32_t sequence_number, const struct RastaPacket * packet,
+                                         struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context,
+                                         unsigned char * buffer, unsigned int capacity){
+    uint16_t length = (uint16_t) rasta_red_pdu_length(packet->length, (unsigned int)(checksum_type->width / 8));
+
+    // reserved bytes have to be 0s in version 03.03
+    return encode_redundancy_packet(length, 0x0000, sequence_number, packet, checksum_type, hashing_context,
+                                    buffer, capacity);
+}
+
+unsigned int rastaRedundancyPacketWrap(uint32_t sequence_number, const unsigned char * pdu, unsigned int pdu_length,
+                                       struct crc_options * checksum_type, unsigned char * buffer,
+                                       unsigned int capacity){
+    unsigned int length = rasta_red_pdu_length(pdu_length, (unsigned int)(checksum_type->width / 8));
 
-    // pack checksum
-    hostLongToLe(checksum, checksum_storage);
-    for (int k = 0; k < (packet.checksum_type.width/8); ++k) {
-        result.bytes[8+internal_packet_len+k] = checksum_storage[k];
+    if (length > capacity || length > UINT16_MAX){
+        return 0;
     }
 
-    // free the temporary checksum data
-    freeRastaByteArray(&temp_wo_checksum);
+    rmemcpy(&buffer[RASTA_RED_OFFSET_PDU], pdu, pdu_length);
 
-    return result;
+    // reserved bytes have to be 0s in version 03.03
+    wrap_redundancy_packet((uint16_t) length, 0x0000, sequence_number, length, checksum_type, buffer);
+
+    return length;
 }
 
-struct RastaRedundancyPacket bytesToRastaRedundancyPacket(struct RastaByteArray data, struct crc_options checksum_type, rasta_hashing_context_t * hashing_context){
-    struct RastaRedundancyPacket packet;
-    packet.checksum_type = checksum_type;
+void rastaPacketRestamp(unsigned char * pdu, unsigned int length, rasta_conn_type type, uint32_t sequence_number,
+                        uint32_t confirmed_sequence_number, uint32_t timestamp, uint32_t confirmed_timestamp,
+                        rasta_hashing_context_t * hashing_context){
+    unsigned int checksum_len = hashing_context->hash_length * 8;
 
-    //length
-    packet.length = leShortToHost(&data.bytes[0]);
+    rasta_wire_put_u16(&pdu[RASTA_SR_OFFSET_TYPE], (uint16_t) type);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_SEQUENCE_NUMBER], sequence_number);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_CONFIRMED_SEQUENCE_NUMBER], confirmed_sequence_number);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_TIMESTAMP], timestamp);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP], confirmed_timestamp);
 
-    // reserved bytes
-    packet.reserve = leShortToHost(&data.bytes[2]);
+    // the safety code covers the header, so it is calculated again
+    unsigned char checksum[16];
+    struct RastaByteArray data_to_hash;
+    data_to_hash.bytes = pdu;
+    data_to_hash.length = length - checksum_len;
 
+    rasta_calculate_hash(data_to_hash, hashing_context, checksum);
+    rmemcpy(&pdu[length - checksum_len], checksum, checksum_len);
+}
 
-    //sequence number
-    packet.sequence_number = leLongToHost(&data.bytes[4]);
+struct RastaByteArray rastaRedundancyPacketToBytes(const struct RastaRedundancyPacket * packet, rasta_hashing_context_t * hashing_context){
+    struct RastaByteArray result;
+    allocateRastaByteArray(&result, packet->length);
 
-    // length of the carried data (the rasta packet) is total length - 8 bytes of length, reserve and seq nr before
-    // and the in the checksum_type specified amount of bytes for the checksum after the data (divided by 8 because
-    // the crc length is specified in bits)
-    unsigned int data_len = data.length - 8 - (checksum_type.width/8);
+    encode_redundancy_packet(packet->length, packet->reserve, packet->sequence_number, &packet->data,
+                             packet->checksum_type, hashing_context, result.bytes, result.length);
 
-    struct RastaByteArray internal_packet_bytes;
-    allocateRastaByteArray(&internal_packet_bytes, data_len);
+    return result;
+}
 
-    // copy internal data bytes
-    for (unsigned int i = 0; i < data_len; ++i) {
-        internal_packet_bytes.bytes[i] = data.bytes[8+i];
-    }
+struct RastaRedundancyPacket bytesToRastaRedundancyPacket(struct RastaByteArray data, struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context){
+    return bytesToRastaRedundancyPacketWithOptions(data, checksum_type, hashing_context);
+}
 
-    // convert to rasta packet
-    packet.data = bytesToRastaPacket(internal_packet_bytes, hashing_context);
+/**
+ * decodes a redundancy layer packet without copying it and checks the CRC checksum, see
+ * rastaRedundancyPacketViewFromBytes()
+ * @param verify_safety_code 1 if the safety code of the SR layer packet is checked, 0 if it is checked by the caller
+ */
+static int parseRedundancyPacketView(const unsigned char * bytes, unsigned int length, struct crc_options * checksum_type,
+                                     rasta_hashing_context_t * hashing_context, struct RastaRedundancyPacketView * view,
+                                     int verify_safety_code){
+    // the checksum_type specifies the length of the checksum after the data in bits
+    unsigned int crc_len = (unsigned int)(checksum_type->width / 8);
+
+    if (length < rasta_red_pdu_length(0, crc_len)){
+        return 0;
+    }
 
-    // free the packet bytes
-    freeRastaByteArray(&internal_packet_bytes);
+    view->length = rasta_wire_get_u16(&bytes[RASTA_RED_OFFSET_LENGTH]);
+    view->reserve = rasta_wire_get_u16(&bytes[RASTA_RED_OFFSET_RESERVE]);
+    view->sequence_number = rasta_wire_get_u32(&bytes[RASTA_RED_OFFSET_SEQUENCE_NUMBER]);
 
-    // calculate the checksum of the received data
-    struct RastaByteArray data_wo_checksum;
-    unsigned  int data_wo_checksum_len = data.length - (checksum_type.width/8);
-    allocateRastaByteArray(&data_wo_checksum, data_wo_checksum_len);
+    // length of the carried data (the rasta packet) is total length - the header of length, reserve and seq nr
+    // before and the checksum after the data
+    unsigned int data_len = length - RASTA_RED_HEADER_LENGTH - crc_len;
 
-    // copy data
-    for (unsigned int j = 0; j < data_wo_checksum_len; ++j) {
-        data_wo_checksum.bytes[j] = data.bytes[j];
+    // decode the rasta packet, a length of 0 marks an invalid one
+    unsigned int checksum_len = hashing_context->hash_length * 8;
+    if (!parsePacketView(&bytes[RASTA_RED_OFFSET_PDU], data_len, checksum_len, &view->data)){
+        rmemset(&view->data, 0, sizeof(view->data));
     }
 
-    // calculate the actual checksum
-    unsigned long calculated_checksum = crc_calculate(&checksum_type, data_wo_checksum);
+    // the CRC covers everything before the checksum
+    unsigned long crc = crc_begin(checksum_type);
+    unsigned int covered = 0;
+
+    if (verify_safety_code && view->data.length != 0){
+        // the safety code is checked in the same pass over the SR layer packet, it covers everything before it
+        unsigned int hashed = view->data.length - checksum_len;
+        unsigned char checksum[16];
 
-    // free data
-    freeRastaByteArray(&data_wo_checksum);
+        crc = crc_update(checksum_type, crc, bytes, RASTA_RED_HEADER_LENGTH);
+        crc = rasta_hash_crc_update(hashing_context, checksum_type, crc, &bytes[RASTA_RED_OFFSET_PDU], hashed,
+                                    checksum);
+        covered = RASTA_RED_HEADER_LENGTH + hashed;
+
+        view->data.checksum_correct = (rmemcmp(checksum, view->data.checksum, checksum_len) == 0);
+    }
 
     // checksum check
-    packet.checksum_correct = 1;
+    view->checksum_correct = 1;
 
-    if (data.length == data_wo_checksum_len){
+    if (crc_len == 0){
         // no checksum was used, nothing to check
-        return packet;
+        return 1;
     }
 
+    // calculate the checksum of the rest of the received data
+    unsigned long calculated_checksum = crc_end(checksum_type, crc_update(checksum_type, crc, &bytes[covered],
+                                                                          length - crc_len - covered));
+
     // convert the previously calculated checksum into byte array for comparison with data checksum
     unsigned char data_checksum[4];
-    hostLongToLe(calculated_checksum, data_checksum);
+    rasta_wire_put_u32(data_checksum, (uint32_t) calculated_checksum);
+
+    view->checksum_correct = (rmemcmp(data_checksum, &bytes[RASTA_RED_OFFSET_PDU + data_len], crc_len) == 0);
+
+    return 1;
+}
+
+int rastaRedundancyPacketViewFromBytes(const unsigned char * bytes, unsigned int length, struct crc_options * checksum_type,
+                                       rasta_hashing_context_t * hashing_context, struct RastaRedundancyPacketView * view){
+    return parseRedundancyPacketView(bytes, length, checksum_type, hashing_context, view, 1);
+}
+
+int rastaRedundancyPacketPeek(const unsigned char * bytes, unsigned int length, uint32_t * sequence_number,
+                              uint32_t * receiver_id, uint32_t * sender_id){
+    // the redundancy layer header and the SR layer header up to the sender
+    if (length < RASTA_RED_OFFSET_PDU + RASTA_SR_OFFSET_SENDER_ID + 4){
+        return 0;
+    }
 
-    packet.checksum_correct = (rmemcmp(data_checksum, &data.bytes[8+data_len], (checksum_type.width / 8)) == 0);
+    *sequence_number = rasta_wire_get_u32(&bytes[RASTA_RED_OFFSET_SEQUENCE_NUMBER]);
+    *receiver_id = rasta_wire_get_u32(&bytes[RASTA_RED_OFFSET_PDU + RASTA_SR_OFFSET_RECEIVER_ID]);
+    *sender_id = rasta_wire_get_u32(&bytes[RASTA_RED_OFFSET_PDU + RASTA_SR_OFFSET_SENDER_ID]);
+    return 1;
+}
 
+unsigned int rastaRedundancyPacketViewsCheckCrc(unsigned char * const * bytes, const unsigned int * lengths,
+                                                unsigned int count, struct crc_options * checksum_type,
+                                                rasta_hashing_context_t * hashing_context,
+                                                struct RastaRedundancyPacketView * views, int * decoded){
+    unsigned int pending = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        // the CRC checksum is far cheaper than the safety code, so damaged packets never get hashed
+        decoded[i] = parseRedundancyPacketView(bytes[i], lengths[i], checksum_type, hashing_context, &views[i], 0);
+        views[i].data.checksum_correct = 0;
+        if (decoded[i] && views[i].data.length != 0 && views[i].checksum_correct) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+unsigned int rastaRedundancyPacketViewsCheckSafetyCode(unsigned char * const * bytes, unsigned int count,
+                                                       rasta_hashing_context_t * hashing_context,
+                                                       struct RastaRedundancyPacketView * views, const int * verify){
+    const unsigned char * hashed_data[count];
+    unsigned int hashed_lengths[count];
+    const unsigned char * checksums[count];
+    int checksum_correct[count];
+    unsigned int indices[count];
+    unsigned int hashed = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (!verify[i] || views[i].data.length == 0 || !views[i].checksum_correct) {
+            continue;
+        }
+
+        // the safety codes of all SR layer packets are checked together
+        hashed_data[hashed] = &bytes[i][RASTA_RED_OFFSET_PDU];
+        hashed_lengths[hashed] = views[i].data.length - views[i].data.checksum_length;
+        checksums[hashed] = views[i].data.checksum;
+        indices[hashed] = i;
+        hashed++;
+    }
+
+    if (hashed == 0) {
+        return 0;
+    }
+    rasta_hash_verify_batch(hashing_context, hashed_data, hashed_lengths, checksums, hashed, checksum_correct);
+
+    for (unsigned int n = 0; n < hashed; n++) {
+        views[indices[n]].data.checksum_correct = checksum_correct[n];
+    }
+    return hashed;
+}
+
+void rastaRedundancyPacketViewsFromBytes(unsigned char * const * bytes, const unsigned int * lengths, unsigned int count,
+                                         struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context,
+                                         struct RastaRedundancyPacketView * views, int * decoded){
+    if (rastaRedundancyPacketViewsCheckCrc(bytes, lengths, count, checksum_type, hashing_context, views, decoded) > 0) {
+        rastaRedundancyPacketViewsCheckSafetyCode(bytes, count, hashing_context, views, decoded);
+    }
+}
+
+struct RastaRedundancyPacket bytesToRastaRedundancyPacketWithOptions(struct RastaByteArray data, struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context){
+    struct RastaRedundancyPacket packet;
+    packet.checksum_type = checksum_type;
+
+    struct RastaRedundancyPacketView view;
+    if (!rastaRedundancyPacketViewFromBytes(data.bytes, data.length, checksum_type, hashing_context, &view)){
+        rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
+        packet.length = 0;
+        packet.reserve = 0;
+        packet.sequence_number = 0;
+        packet.data = invalidRastaPacket();
+        packet.checksum_correct = 0;
+        return packet;
+    }
+
+    packet.length = view.length;
+    packet.reserve = view.reserve;
+    packet.sequence_number = view.sequence_number;
+    packet.checksum_correct = view.checksum_correct;
+
+    if (view.data.length == 0){
+        rastamodule_lasterror = RASTA_ERRORS_PACKAGE_LENGTH_INVALID;
+        packet.data = invalidRastaPacket();
+    } else {
+        packet.data = rastaPacketFromView(&view.data);
+    }
 
     return packet;
 }
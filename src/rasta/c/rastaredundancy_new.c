@@ -1,3 +1,4 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_REDUNDANCY
 #include <rastaredundancy_new.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -6,6 +7,16 @@
 #include <string.h>
 #include "rastaredundancy_new.h"
 #include "rastautil.h"
+#include "rastatrace.h"
+#include "rastaprobes.h"
+#include "udp.h"
+
+/**
+ * @return the size of the receive buffer of a channel, it holds at least a full send window of the peer
+ */
+static unsigned int receive_buffer_size(unsigned int n_deferqueue_size, unsigned int send_max){
+    return n_deferqueue_size < send_max ? send_max : n_deferqueue_size;
+}
 
 rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConfigInfo config, unsigned int transport_channel_count,
                                         unsigned long id){
@@ -17,6 +28,10 @@ rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConf
     channel.configuration_parameters = config.redundancy;
 
     channel.is_open = 0;
+    channel.resync = 0;
+    channel.pending = 0;
+    channel.pending_pdus = 0;
+    channel.last_received = 0;
 
     // init sequence numbers
     channel.seq_rx = 0;
@@ -24,10 +39,20 @@ rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConf
 
     // init defer queue
     channel.defer_q = deferqueue_init(config.redundancy.n_deferqueue_size);
-    channel.fifo_recv = fifo_init(config.redundancy.n_deferqueue_size);
+    memset(&channel.defer_timeout_event, 0, sizeof(timed_event));
+    channel.mux = NULL;
+    channel.defer_timeout = config.redundancy.t_seq;
+    channel.defer_timeouts = 0;
+    channel.safety_code_ns = 0;
+    channel.residency = NULL;
+    if (config.metrics.residency) {
+        channel.residency = rmalloc(sizeof(struct rasta_residency_metrics));
+        rmemset(channel.residency, 0, sizeof(struct rasta_residency_metrics));
+    }
+    channel.fifo_recv = fifo_init(receive_buffer_size(config.redundancy.n_deferqueue_size, config.sending.send_max));
 
     // init diagnostics buffer
-    channel.diagnostics_packet_buffer = deferqueue_init(10 * config.redundancy.n_deferqueue_size);
+    rasta_arrival_ring_init(&channel.diagnostics_arrivals, 10 * config.redundancy.n_deferqueue_size);
 
     // init hashing context
     channel.hashing_context.hash_length = config.sending.md4_type;
@@ -46,17 +71,66 @@ rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConf
         channel.hashing_context.key.bytes[1] = (config.sending.sr_hash_key >> 16) & 0xFF;
         channel.hashing_context.key.bytes[2] = (config.sending.sr_hash_key >> 8) & 0xFF;
         channel.hashing_context.key.bytes[3] = (config.sending.sr_hash_key) & 0xFF;
+        rasta_hash_prepare_key(&channel.hashing_context);
     }
     // init transport channel buffer;
     logger_log(&channel.logger, LOG_LEVEL_DEBUG, "RaSTA Red init", "space for %d connected channels", transport_channel_count);
     channel.connected_channels = rmalloc(transport_channel_count * sizeof(rasta_transport_channel));
+    rmemset(channel.connected_channels, 0, transport_channel_count * sizeof(rasta_transport_channel));
     channel.connected_channel_count = 0;
     channel.transport_channel_count = transport_channel_count;
+    channel.path_channels = rmalloc((transport_channel_count > 0 ? transport_channel_count : 1) * sizeof(int));
+    for (unsigned int i = 0; i < transport_channel_count; ++i) {
+        channel.path_channels[i] = -1;
+    }
+
+    rmemset(&channel.metrics, 0, sizeof(channel.metrics));
 
     return channel;
 }
 
 
+/**
+ * frees the SR layer PDU inside a redundancy layer PDU that is not passed to the next layer
+ * @param packet the discarded packet
+ */
+static void discard_packet(struct RastaRedundancyPacket * packet){
+    freeRastaByteArray(&packet->data.data);
+    freeRastaByteArray(&packet->data.checksum);
+}
+
+/**
+ * passes a decoded SR layer PDU to the next layer by pushing it into the receive FIFO.
+ * The data and checksum of @p packet are owned by the FIFO afterwards
+ * @param channel the redundancy channel that is used
+ * @param seq_pdu the sequence number of the redundancy layer PDU
+ * @param packet the SR layer PDU
+ * @param received_ns the time the PDU was taken from the socket in the nanoseconds of get_nanotime(), 0 if it is not
+ * known
+ */
+static void deliver_packet(rasta_redundancy_channel * channel, unsigned long seq_pdu, struct RastaPacket packet,
+                           uint64_t received_ns){
+    struct rasta_delivered_packet * to_fifo = rmalloc(sizeof(struct rasta_delivered_packet));
+    to_fifo->packet = packet;
+    to_fifo->delivered_ns = 0;
+    if (channel->residency != NULL) {
+        to_fifo->delivered_ns = get_nanotime();
+        rasta_residency_record(channel->residency, RASTA_RESIDENCY_DEFER, received_ns, to_fifo->delivered_ns);
+    }
+
+    RASTA_PROBE3(red_deliver, channel->associated_id, seq_pdu, packet.sequence_number);
+
+    rasta_metrics_add(&channel->metrics.pdus_in, 1);
+    rasta_metrics_add(&channel->metrics.bytes_in, packet.length);
+
+    if (!fifo_push(channel->fifo_recv, to_fifo)){
+        logger_log(&channel->logger, LOG_LEVEL_INFO, "RaSTA Red receive", "receive buffer full, discarding message");
+        freeRastaByteArray(&to_fifo->packet.data);
+        freeRastaByteArray(&to_fifo->packet.checksum);
+        rfree(to_fifo);
+    }
+}
+
 /**
  * delivers a message in the defer queue to next layer i.e. adds it to the receive buffer
  * see 6.6.4.4.6 for more details
@@ -65,32 +139,21 @@ rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConf
 void deliverDeferQueue(rasta_redundancy_channel * channel){
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red deliver deferq", "f_deliverDeferQueue called");
 
-    // check if message with seq_pdu == seq_rx in defer queue
-    while (deferqueue_contains(&channel->defer_q, channel->seq_rx)){
-        logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red deliver deferq", "deferq contains seq_pdu=%lu",
+    // check if message with seq_pdu == seq_rx in defer queue and remove it from the queue
+    struct RastaRedundancyPacket deferred;
+    uint64_t received_ns;
+    while (deferqueue_take_received(&channel->defer_q, channel->seq_rx, &deferred, &received_ns)){
+        logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red deliver deferq", "deferq contained seq_pdu=%lu",
                    channel->seq_rx);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DELIVER, channel->associated_id, channel->seq_rx, 0,
+                           0, 0);
 
-        // forward to next layer by pushing into receive FIFO
-
-        struct RastaByteArray innerPackerBytes;
-        // convert inner data (RaSTA SR layer PDU) to byte array
-        innerPackerBytes = rastaModuleToBytes(deferqueue_get(&channel->defer_q, channel->seq_rx).data,
-                &channel->hashing_context);
-
-        // add to queue
-        struct RastaByteArray * to_fifo = rmalloc(sizeof(struct RastaByteArray));
-        allocateRastaByteArray(to_fifo, innerPackerBytes.length);
-        rmemcpy(to_fifo->bytes, innerPackerBytes.bytes, innerPackerBytes.length);
-        fifo_push(channel->fifo_recv, to_fifo);
-
-        freeRastaByteArray(&innerPackerBytes);
+        // forward to next layer by pushing into receive FIFO. The SR layer PDU was decoded and its safety code
+        // checked when it was received, the FIFO takes it over as it is
+        deliver_packet(channel, channel->seq_rx, deferred.data, received_ns);
 
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red deliver deferq", "added message to buffer");
 
-        // remove message from queue (effectively a pop operation with the get call)
-        deferqueue_remove(&channel->defer_q, channel->seq_rx);
-        logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red deliver deferq", "remove message from deferq");
-
         // increase seq_rx
         channel->seq_rx = channel->seq_rx +1;
     }
@@ -98,13 +161,108 @@ void deliverDeferQueue(rasta_redundancy_channel * channel){
                channel->seq_rx);
 }
 
-void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedundancyPacket packet, int channel_id){
+/**
+ * a PDU that was received by a redundancy channel. Either the decoded packet or a view into the receive buffer is set,
+ * a viewed PDU is only copied if the channel keeps it
+ */
+struct received_pdu{
+    uint32_t sequence_number;
+    int checksum_correct;
+    unsigned int length;
+    struct RastaRedundancyPacket * packet;
+    const struct RastaRedundancyPacketView * view;
+    /**
+     * the time the PDU has been received, in the milliseconds of current_ts()
+     */
+    uint32_t received_at;
+
+    /**
+     * the time the PDU was taken from the socket in the nanoseconds of get_nanotime(), 0 if it is not known
+     */
+    uint64_t received_ns;
+};
+
+/**
+ * gets a packet that owns the SR layer PDU of a received PDU
+ * @param pdu the received PDU
+ * @param packet the decoded packet or a copy of the viewed one is written in here
+ */
+static void take_packet(const struct received_pdu * pdu, struct RastaRedundancyPacket * packet){
+    if (pdu->packet != NULL){
+        *packet = *pdu->packet;
+        return;
+    }
+
+    packet->length = pdu->view->length;
+    packet->reserve = pdu->view->reserve;
+    packet->sequence_number = pdu->view->sequence_number;
+    packet->checksum_correct = pdu->view->checksum_correct;
+    packet->data = rastaPacketFromView(&pdu->view->data);
+    // the checksum has been checked already, the options are not used afterwards
+    packet->checksum_type = NULL;
+}
+
+/**
+ * frees a received PDU that is not passed to the next layer
+ * @param pdu the discarded PDU
+ */
+static void discard_pdu(const struct received_pdu * pdu){
+    if (pdu->packet != NULL){
+        discard_packet(pdu->packet);
+    }
+}
+
+/**
+ * updates the diagnostics of a transport channel with the delay of a PDU that was received on another transport
+ * channel first
+ * @param channel the redundancy channel that is used
+ * @param sequence_number the sequence number of the PDU
+ * @param channel_id the index of the transport channel the copy has been received on
+ * @param received_at the time the copy has been received in the milliseconds of current_ts()
+ */
+static void record_duplicate_delay(rasta_redundancy_channel * channel, unsigned long sequence_number, int channel_id,
+                                   uint32_t received_at){
+    // calculate delay by looking for the received ts in the diagnostics arrivals
+    uint32_t ts;
+    if (rasta_arrival_ring_get(&channel->diagnostics_arrivals, (uint32_t) sequence_number, &ts)){
+        // seq_pdu was in queue, received time is ts
+        unsigned long delay = received_at - ts;
+
+        // if delay > T_SEQ, message is late
+        if (delay > channel->configuration_parameters.t_seq){
+            // channel is late, increase missed counter
+            channel->connected_channels[channel_id].diagnostics_data.n_missed++;
+        } else{
+            // update t_drift and t_drift2
+            channel->connected_channels[channel_id].diagnostics_data.t_drift += delay;
+            channel->connected_channels[channel_id].diagnostics_data.t_drift2 += (delay * delay);
+            channel->connected_channels[channel_id].diagnostics_data.drift_samples++;
+        }
+    }
+}
+
+/**
+ * the f_receive function of the redundancy layer for a PDU that is either decoded or viewed in the receive buffer
+ * @param channel the redundancy channel that is used
+ * @param pdu the received PDU
+ * @param channel_id the index of the transport channel, the @p pdu has been received
+ */
+static void receive_pdu(rasta_redundancy_channel * channel, const struct received_pdu * pdu, int channel_id){
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "Channel %d: ptr=%p", channel_id, (void*) channel);
 
-    if(!packet.checksum_correct){
+    struct rasta_transport_metrics * transport_metrics = &channel->connected_channels[channel_id].metrics;
+    rasta_metrics_add(&transport_metrics->pdus_in, 1);
+    rasta_metrics_add(&transport_metrics->bytes_in, pdu->length);
+
+    if(!pdu->checksum_correct){
+        rasta_metrics_add(&transport_metrics->checksum_errors, 1);
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "Channel 0: Packet checksum incorrect on channel %d", channel_id);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_CHECKSUM_INCORRECT, channel->associated_id, 0, 0,
+                           channel_id, 0);
+        RASTA_PROBE2(red_checksum_error, channel->associated_id, channel_id);
 
         // checksum incorrect, exit function
+        discard_pdu(pdu);
         return;
     }
 
@@ -112,60 +270,55 @@ void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedunda
 
     // increase amount of received packets of this channel
     channel->connected_channels[channel_id].diagnostics_data.received_packets += 1;
+    rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_RECEIVE, channel->associated_id, pdu->sequence_number,
+                       channel->seq_rx, channel_id, 0);
+    RASTA_PROBE3(red_receive, channel->associated_id, pdu->sequence_number, channel_id);
+
+    // the PDUs the partner sent before the channel was taken over are not known
+    if (channel->resync) {
+        channel->seq_rx = pdu->sequence_number;
+        channel->resync = 0;
+    }
 
     // only accept pdu with seq. nr = 0 as first message
-    if (channel->seq_rx == 0 && channel->seq_tx == 0 && packet.sequence_number != 0) {
+    if (channel->seq_rx == 0 && channel->seq_tx == 0 && pdu->sequence_number != 0) {
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: first seq_pdu != 0", channel_id);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id,
+                           pdu->sequence_number, channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_FIRST_NOT_ZERO);
+        RASTA_PROBE3(red_discard, channel->associated_id, pdu->sequence_number, RASTA_TRACE_DISCARD_FIRST_NOT_ZERO);
 
+        discard_pdu(pdu);
         return;
     }
 
     // check seq_pdu
-    if (packet.sequence_number < channel->seq_rx){
+    if (pdu->sequence_number < channel->seq_rx){
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: seq_pdu < seq_rx", channel_id);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id,
+                           pdu->sequence_number, channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_DUPLICATE);
+        RASTA_PROBE3(red_discard, channel->associated_id, pdu->sequence_number, RASTA_TRACE_DISCARD_DUPLICATE);
         // message has been received by other transport channel
-        // -> calculate delay by looking for the received ts in diagnostics queue
-
-        unsigned long ts = deferqueue_get_ts(&channel->diagnostics_packet_buffer, packet.sequence_number);
-        if(ts != 0){
-            // seq_pdu was in queue, received time is ts
-            unsigned long delay = current_ts() - ts;
-
-            // if delay > T_SEQ, message is late
-            if (delay > channel->configuration_parameters.t_seq){
-                // channel is late, increase missed counter
-                channel->connected_channels[channel_id].diagnostics_data.n_missed++;
-            } else{
-                // update t_drift and t_drift2
-                channel->connected_channels[channel_id].diagnostics_data.t_drift += delay;
-                channel->connected_channels[channel_id].diagnostics_data.t_drift2 += (delay * delay);
-            }
-        }
+        record_duplicate_delay(channel, pdu->sequence_number, channel_id, pdu->received_at);
 
         // discard message
+        discard_pdu(pdu);
         return;
-    } else if (packet.sequence_number == channel->seq_rx){
+    } else if (pdu->sequence_number == channel->seq_rx){
         channel->seq_rx++;
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: correct seq. nr. delivering to next layer",
                    channel_id);
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: seq_pdu=%lu, seq_rx=%lu",
-            channel_id, (long unsigned int) packet.sequence_number, channel->seq_rx - 1);
-        // received packet as first transport channel -> add with ts to diagnostics buffer
-        deferqueue_add(&channel->diagnostics_packet_buffer, packet, current_ts());
+            channel_id, (long unsigned int) pdu->sequence_number, channel->seq_rx - 1);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DELIVER, channel->associated_id,
+                           pdu->sequence_number, 0, channel_id, 0);
+        struct RastaRedundancyPacket packet;
+        take_packet(pdu, &packet);
 
-        // forward to next layer by pushing into receive FIFO
+        // received packet as first transport channel -> remember its arrival for the diagnostics
+        rasta_arrival_ring_put(&channel->diagnostics_arrivals, (uint32_t) pdu->sequence_number, pdu->received_at);
 
-        struct RastaByteArray innerPackerBytes;
-        // convert inner data (RaSTA SR layer PDU) to byte array
-        innerPackerBytes = rastaModuleToBytesNoChecksum(packet.data, &channel->hashing_context);
-
-        // add to queue
-        struct RastaByteArray * to_fifo = rmalloc(sizeof(struct RastaByteArray));
-        allocateRastaByteArray(to_fifo, innerPackerBytes.length);
-        rmemcpy(to_fifo->bytes, innerPackerBytes.bytes, innerPackerBytes.length);
-        fifo_push(channel->fifo_recv, to_fifo);
-
-        freeRastaByteArray(&innerPackerBytes);
+        // forward to next layer by pushing into receive FIFO, the SR layer PDU has already been decoded and checked
+        deliver_packet(channel, pdu->sequence_number, packet.data, pdu->received_ns);
 
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: added message to buffer",
                    channel_id);
@@ -176,44 +329,174 @@ void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedunda
 
         // deliver message to upper layer
         deliverDeferQueue(channel);
-    } else if (channel->seq_rx < packet.sequence_number
-               && packet.sequence_number <= (channel->seq_rx + channel->configuration_parameters.n_deferqueue_size * 10)){
+    } else if (channel->seq_rx < pdu->sequence_number
+               && pdu->sequence_number <= (channel->seq_rx + channel->configuration_parameters.n_deferqueue_size * 10)){
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: seq_rx < seq_pdu && seq_pdu <= (seq_rx + 10 * MAX_DEFERQUEUE_SIZE)"
                 , channel_id);
 
         // check if message is in defer queue
-        if (deferqueue_contains(&channel->defer_q, packet.sequence_number)){
+        if (deferqueue_contains(&channel->defer_q, pdu->sequence_number)){
             logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: packet already in deferq",
                        channel_id);
+            rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id,
+                               pdu->sequence_number, channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_DUPLICATE);
+            RASTA_PROBE3(red_discard, channel->associated_id, pdu->sequence_number, RASTA_TRACE_DISCARD_DUPLICATE);
 
             // discard message
             // possibly statistic analysis
+            discard_pdu(pdu);
             return;
         } else{
             // check if queue is full
             if (deferqueue_isfull(&channel->defer_q)){
                 logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: deferq full", channel_id);
+                rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id,
+                                   pdu->sequence_number, channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_DEFERQ_FULL);
+                RASTA_PROBE3(red_discard, channel->associated_id, pdu->sequence_number, RASTA_TRACE_DISCARD_DEFERQ_FULL);
 
                 // full -> discard message
+                discard_pdu(pdu);
                 return;
             } else{
                 logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: adding message to deferq",
                            channel_id);
+                rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DEFER, channel->associated_id,
+                                   pdu->sequence_number, channel->seq_rx, channel_id, 0);
+                RASTA_PROBE3(red_defer, channel->associated_id, pdu->sequence_number, channel->seq_rx);
 
                 // add message to defer queue
-                deferqueue_add(&channel->defer_q, packet, current_ts());
+                struct RastaRedundancyPacket packet;
+                take_packet(pdu, &packet);
+                deferqueue_add_received(&channel->defer_q, &packet, pdu->received_at, pdu->received_ns);
             }
         }
-    } else if (packet.sequence_number > (channel->seq_rx + channel->configuration_parameters.n_deferqueue_size * 10)){
+    } else if (pdu->sequence_number > (channel->seq_rx + channel->configuration_parameters.n_deferqueue_size * 10)){
         logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red receive", "channel %d: seq_pdu > seq_rx + 10 * MAX_DEFERQUEUE_SIZE"
                 , channel_id);
+        rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id,
+                           pdu->sequence_number, channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_OUT_OF_RANGE);
+        RASTA_PROBE3(red_discard, channel->associated_id, pdu->sequence_number, RASTA_TRACE_DISCARD_OUT_OF_RANGE);
 
         // discard message
+        discard_pdu(pdu);
         return;
     }
 }
 
+void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedundancyPacket * packet, int channel_id){
+    struct received_pdu pdu = { packet->sequence_number, packet->checksum_correct, packet->length, packet, NULL, current_ts(),
+                                0 };
+    receive_pdu(channel, &pdu, channel_id);
+}
+
+void rasta_red_f_receive_view(rasta_redundancy_channel * channel, const struct RastaRedundancyPacketView * packet, int channel_id,
+                              uint32_t received_at, uint64_t received_ns){
+    struct received_pdu pdu = { packet->sequence_number, packet->checksum_correct, packet->length, NULL, packet, received_at,
+                                received_ns };
+    receive_pdu(channel, &pdu, channel_id);
+}
+
+int rasta_red_f_sequence_plausible(rasta_redundancy_channel * channel, unsigned long sequence_number){
+    // the same decisions as receive_pdu() before it keeps a PDU
+    if (channel->resync){
+        return 1;
+    }
+    if (channel->seq_rx == 0 && channel->seq_tx == 0 && sequence_number != 0){
+        return 0;
+    }
+    if (sequence_number < channel->seq_rx){
+        return 0;
+    }
+    if (sequence_number == channel->seq_rx){
+        return 1;
+    }
+    if (sequence_number > channel->seq_rx + channel->configuration_parameters.n_deferqueue_size * 10){
+        return 0;
+    }
+    return !deferqueue_contains(&channel->defer_q, sequence_number) && !deferqueue_isfull(&channel->defer_q);
+}
+
+int rasta_red_f_known_duplicate(rasta_redundancy_channel * channel, unsigned long sequence_number){
+    // the first PDU and the first one after a takeover set seq_rx, so they are never a duplicate
+    if (channel->resync || (channel->seq_rx == 0 && channel->seq_tx == 0)){
+        return 0;
+    }
+    return sequence_number < channel->seq_rx || deferqueue_contains(&channel->defer_q, sequence_number);
+}
+
+int rasta_red_f_receive_duplicate(rasta_redundancy_channel * channel, unsigned long sequence_number, unsigned int length,
+                                  int channel_id, uint32_t received_at){
+    if (!rasta_red_f_known_duplicate(channel, sequence_number)){
+        return 0;
+    }
+
+    struct rasta_transport_metrics * transport_metrics = &channel->connected_channels[channel_id].metrics;
+    rasta_metrics_add(&transport_metrics->pdus_in, 1);
+    rasta_metrics_add(&transport_metrics->bytes_in, length);
+    channel->connected_channels[channel_id].diagnostics_data.received_packets += 1;
+
+    rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DISCARD, channel->associated_id, sequence_number,
+                       channel->seq_rx, channel_id, RASTA_TRACE_DISCARD_DUPLICATE);
+    RASTA_PROBE3(red_discard, channel->associated_id, sequence_number, RASTA_TRACE_DISCARD_DUPLICATE);
+
+    if (sequence_number < channel->seq_rx){
+        record_duplicate_delay(channel, sequence_number, channel_id, received_at);
+    }
+    return 1;
+}
+
+/**
+ * @param value a number
+ * @return the square root of @p value, rounded up
+ */
+static uint64_t sqrt_ceil(uint64_t value){
+    uint64_t root = 0;
+    for (uint64_t bit = (uint64_t) 1 << 31; bit > 0; bit >>= 1){
+        uint64_t candidate = root | bit;
+        if (candidate * candidate <= value){
+            root = candidate;
+        }
+    }
+    return root * root < value ? root + 1 : root;
+}
+
+void rasta_red_adapt_defer_timeout(rasta_redundancy_channel * channel){
+    unsigned int t_seq = channel->configuration_parameters.t_seq;
+    uint64_t k = channel->configuration_parameters.adaptive_t_seq;
+
+    // the delays of all transport channels, each one is the skew of a copy behind the first one
+    uint64_t samples = 0, sum = 0, sum2 = 0;
+    for (unsigned int i = 0; i < channel->connected_channel_count; i++){
+        rasta_redundancy_diagnostics_data * diagnostics = &channel->connected_channels[i].diagnostics_data;
+        samples += diagnostics->drift_samples;
+        sum += diagnostics->t_drift;
+        sum2 += diagnostics->t_drift2;
+    }
+
+    unsigned int timeout = t_seq;
+    if (k > 0 && samples >= RED_ADAPTIVE_MIN_SAMPLES){
+        uint64_t mean = (sum + samples - 1) / samples;
+        uint64_t variance = sum2 > sum * sum / samples ? (sum2 - sum * sum / samples) / samples : 0;
+        // the delays are differences of millisecond timestamps, each one may be 1 ms short
+        uint64_t adapted = mean + sqrt_ceil(k * k * variance) + 1;
+        if (adapted < t_seq){
+            timeout = (unsigned int) adapted;
+        }
+    }
+
+    if (timeout != channel->defer_timeout){
+        logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red adapt", "channel 0x%lX waits %u ms for missing PDUs "
+                   "(%lu delays)", channel->associated_id, timeout, (unsigned long) samples);
+    }
+    channel->defer_timeout = timeout;
+}
+
 void rasta_red_f_deferTmo(rasta_redundancy_channel * channel){
+    if (channel->defer_q.count == 0){
+        return;
+    }
+    rasta_metrics_add(&channel->defer_timeouts, 1);
+
     // find smallest seq_pdu in defer queue
     int smallest_index = deferqueue_smallest_seqnr(&channel->defer_q);
 
@@ -221,28 +504,72 @@ void rasta_red_f_deferTmo(rasta_redundancy_channel * channel){
     channel->seq_rx = channel->defer_q.elements[smallest_index].packet.sequence_number;
 
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red f_deferTmo", "calling f_deliverDeferQueue");
+    rasta_trace_add(channel->logger.trace, RASTA_TRACE_RED_DEFER_TIMEOUT, channel->associated_id, channel->seq_rx, 0,
+                       0, 0);
+    RASTA_PROBE2(red_defer_timeout, channel->associated_id, channel->seq_rx);
     deliverDeferQueue(channel);
 }
 
 void rasta_red_add_transport_channel(rasta_redundancy_channel * channel, char * ip, uint16_t port){
     rasta_transport_channel transport_channel;
+    rmemset(&transport_channel, 0, sizeof(transport_channel));
 
     transport_channel.port = port;
-    transport_channel.ip_address = rmalloc(sizeof(char) * 15);
-    rmemcpy(transport_channel.ip_address, ip, 15);
+    transport_channel.address = host_port_to_sockaddr(ip, port);
+    transport_channel.endpoint = sockaddr_to_endpoint(&transport_channel.address);
+    transport_channel.ip_address = rmalloc(IPV4_STR_LEN);
+    sockaddr_to_host(transport_channel.address, transport_channel.ip_address);
 
-    channel->connected_channels[channel->connected_channel_count] = transport_channel;
+    // the configured transport channels are in the order of the local sockets
+    rasta_red_bind_transport_channel(channel, transport_channel, channel->connected_channel_count);
+}
+
+unsigned int rasta_red_bind_transport_channel(rasta_redundancy_channel * channel, rasta_transport_channel transport_channel,
+                                              unsigned int path){
+    unsigned int index = channel->connected_channel_count;
+    transport_channel.path = path;
+    channel->connected_channels[index] = transport_channel;
     channel->connected_channel_count++;
+    if (path < channel->transport_channel_count){
+        channel->path_channels[path] = (int) index;
+    }
+    return index;
 }
 
 
+int rasta_red_resize_buffers(rasta_redundancy_channel * channel, unsigned int n_deferqueue_size, unsigned int send_max){
+    unsigned int recv_size = receive_buffer_size(n_deferqueue_size, send_max);
+    if (channel->defer_q.count > n_deferqueue_size || fifo_get_size(channel->fifo_recv) > recv_size){
+        return 0;
+    }
+
+    deferqueue_resize(&channel->defer_q, n_deferqueue_size);
+    rasta_arrival_ring_resize(&channel->diagnostics_arrivals, 10 * n_deferqueue_size);
+
+    // the PDUs that were not retrieved yet keep their order
+    fifo_t * fifo_recv = fifo_init(recv_size);
+    void * pdu;
+    while ((pdu = fifo_pop(channel->fifo_recv)) != NULL){
+        fifo_push(fifo_recv, pdu);
+    }
+    fifo_destroy(channel->fifo_recv);
+    channel->fifo_recv = fifo_recv;
+
+    channel->configuration_parameters.n_deferqueue_size = n_deferqueue_size;
+    return 1;
+}
+
 void rasta_red_cleanup(rasta_redundancy_channel * channel){
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red cleanup", "destroying defer queues");
-    // destroy the defer queue
+    // destroy the defer queue, its messages were not delivered
+    for (struct rasta_redundancy_packet_wrapper * element = deferqueue_first(&channel->defer_q); element != NULL;
+         element = deferqueue_next(&channel->defer_q, element)) {
+        discard_packet(&element->packet);
+    }
     deferqueue_destroy(&channel->defer_q);
 
-    // destroy the diagnostics buffer
-    deferqueue_destroy(&channel->diagnostics_packet_buffer);
+    // free the diagnostics arrivals
+    rasta_arrival_ring_free(&channel->diagnostics_arrivals);
 
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red cleanup", "freeing connected channels");
     // free the channels
@@ -250,13 +577,22 @@ void rasta_red_cleanup(rasta_redundancy_channel * channel){
         rfree(channel->connected_channels[i].ip_address);
     }
     rfree(channel->connected_channels);
+    rfree(channel->path_channels);
     channel->transport_channel_count = 0;
     channel->connected_channel_count = 0;
 
     logger_log(&channel->logger, LOG_LEVEL_DEBUG, "RaSTA Red cleanup", "freeing FIFO");
 
-    // free the receive FIFO
+    // free the receive FIFO and the messages that have not been retrieved
+    struct rasta_delivered_packet * remaining;
+    while ((remaining = fifo_pop(channel->fifo_recv)) != NULL){
+        freeRastaByteArray(&remaining->packet.data);
+        freeRastaByteArray(&remaining->packet.checksum);
+        rfree(remaining);
+    }
     fifo_destroy(channel->fifo_recv);
+    rfree(channel->residency);
+    channel->residency = NULL;
 
     freeRastaByteArray(&channel->hashing_context.key);
 
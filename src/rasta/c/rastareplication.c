@@ -0,0 +1,555 @@
+#define _GNU_SOURCE // accept4
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
+#include "rastareplication.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include "rastautil.h"
+#include "rmemory.h"
+
+/**
+ * the fixed part of a CONNECTION record body
+ */
+#define REPLICA_FIXED_SIZE 68
+
+/**
+ * the size of a transport channel and of the header of a PDU in a CONNECTION record body
+ */
+#define REPLICA_CHANNEL_SIZE 6
+#define REPLICA_PDU_HEADER_SIZE 6
+
+static void put_u16(unsigned char * out, uint16_t v) {
+    out[0] = (unsigned char) (v & 0xFF);
+    out[1] = (unsigned char) (v >> 8);
+}
+
+static uint16_t get_u16(const unsigned char * in) {
+    return (uint16_t) (in[0] | (in[1] << 8));
+}
+
+static void put_u32(unsigned char * out, uint32_t v) {
+    unsigned char bytes[4];
+    hostLongToLe(v, bytes);
+    memcpy(out, bytes, 4);
+}
+
+static uint32_t get_u32(const unsigned char * in) {
+    unsigned char bytes[4];
+    memcpy(bytes, in, 4);
+    return leLongToHost(bytes);
+}
+
+/**
+ * initializes the fields both roles have
+ */
+static void replication_init(struct rasta_replication * replication, rasta_replication_role role, const char * ip,
+                             uint16_t port) {
+    memset(replication, 0, sizeof(*replication));
+    replication->role = role;
+    replication->listen_fd = -1;
+    replication->fd = -1;
+
+    replication->address.sin_family = AF_INET;
+    replication->address.sin_port = htons(port);
+    if (strcmp(ip, "*") == 0) {
+        replication->address.sin_addr.s_addr = htonl(INADDR_ANY);
+    } else if (inet_pton(AF_INET, ip, &replication->address.sin_addr) != 1) {
+        fprintf(stderr, "Invalid replication address %s\n", ip);
+        exit(1);
+    }
+    rasta_id_index_init(&replication->entry_index);
+}
+
+void rasta_replication_init_primary(struct rasta_replication * replication, const char * ip, uint16_t port,
+                                    unsigned int interval_ms) {
+    replication_init(replication, RASTA_REPLICATION_PRIMARY, ip, port);
+    replication->interval_ms = interval_ms;
+}
+
+void rasta_replication_init_standby(struct rasta_replication * replication, const char * ip, uint16_t port) {
+    replication_init(replication, RASTA_REPLICATION_STANDBY, ip, port);
+
+    replication->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (replication->listen_fd == -1) {
+        perror("Could not create replication socket");
+        exit(1);
+    }
+
+    int reuse = 1;
+    setsockopt(replication->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (bind(replication->listen_fd, (struct sockaddr *) &replication->address, sizeof(replication->address)) == -1) {
+        perror("Could not bind replication socket");
+        exit(1);
+    }
+    if (listen(replication->listen_fd, 1) == -1) {
+        perror("Could not listen on replication socket");
+        exit(1);
+    }
+
+    // the port is known when 0 was given
+    socklen_t length = sizeof(replication->address);
+    getsockname(replication->listen_fd, (struct sockaddr *) &replication->address, &length);
+}
+
+void rasta_replication_free(struct rasta_replication * replication) {
+    rasta_replication_close_stream(replication);
+    if (replication->listen_fd != -1) {
+        close(replication->listen_fd);
+        replication->listen_fd = -1;
+    }
+    rasta_replication_clear(replication);
+    rasta_id_index_free(&replication->entry_index);
+    rfree(replication->entries);
+    rfree(replication->out);
+    rfree(replication->in);
+    replication->entries = NULL;
+    replication->out = NULL;
+    replication->in = NULL;
+    replication->entry_capacity = 0;
+    replication->out_capacity = 0;
+    replication->in_capacity = 0;
+}
+
+void rasta_replication_close_stream(struct rasta_replication * replication) {
+    if (replication->fd != -1) {
+        close(replication->fd);
+        replication->fd = -1;
+    }
+    replication->connecting = 0;
+    replication->out_length = 0;
+    replication->in_length = 0;
+}
+
+int rasta_replication_connect(struct rasta_replication * replication) {
+    if (replication->fd == -1) {
+        replication->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (replication->fd == -1) {
+            return 0;
+        }
+        int nodelay = 1;
+        setsockopt(replication->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        if (connect(replication->fd, (struct sockaddr *) &replication->address, sizeof(replication->address)) == 0) {
+            return 2;
+        }
+        if (errno != EINPROGRESS) {
+            rasta_replication_close_stream(replication);
+            return 0;
+        }
+        replication->connecting = 1;
+    }
+
+    if (replication->connecting) {
+        struct pollfd writable = { .fd = replication->fd, .events = POLLOUT };
+        if (poll(&writable, 1, 0) < 1) {
+            return 0;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(replication->fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+            // the standby is not there yet, the next round tries again
+            rasta_replication_close_stream(replication);
+            return 0;
+        }
+        replication->connecting = 0;
+        return 2;
+    }
+    return 1;
+}
+
+/**
+ * makes room for @p length more bytes in a buffer
+ * @return 1 on success, 0 if the buffer would grow beyond @p limit
+ */
+static int reserve(unsigned char ** buffer, size_t * capacity, size_t used, size_t length, size_t limit) {
+    if (used + length > limit) {
+        return 0;
+    }
+    if (used + length > *capacity) {
+        size_t grown = *capacity ? *capacity : 4096;
+        while (grown < used + length) {
+            grown *= 2;
+        }
+        *buffer = rrealloc(*buffer, grown);
+        *capacity = grown;
+    }
+    return 1;
+}
+
+/**
+ * writes the header of a record
+ */
+static void put_header(unsigned char * out, rasta_replication_record_type type, size_t length) {
+    put_u32(out, RASTA_REPLICATION_MAGIC);
+    put_u16(out + 4, RASTA_REPLICATION_VERSION);
+    put_u16(out + 6, (uint16_t) type);
+    put_u32(out + 8, (uint32_t) length);
+}
+
+int rasta_replication_queue(struct rasta_replication * replication, rasta_replication_record_type type,
+                            const unsigned char * body, size_t length) {
+    if (!reserve(&replication->out, &replication->out_capacity, replication->out_length,
+                 RASTA_REPLICATION_HEADER_SIZE + length, RASTA_REPLICATION_MAX_QUEUED)) {
+        return 0;
+    }
+    unsigned char * record = replication->out + replication->out_length;
+    put_header(record, type, length);
+    if (length > 0) {
+        memcpy(record + RASTA_REPLICATION_HEADER_SIZE, body, length);
+    }
+    replication->out_length += RASTA_REPLICATION_HEADER_SIZE + length;
+    return 1;
+}
+
+int rasta_replication_queue_connection(struct rasta_replication * replication, const struct rasta_replica * replica,
+                                       struct retr_buffer * retr_buffer) {
+    size_t length = rasta_replica_encoded_size(replica, retr_buffer);
+    if (!reserve(&replication->out, &replication->out_capacity, replication->out_length,
+                 RASTA_REPLICATION_HEADER_SIZE + length, RASTA_REPLICATION_MAX_QUEUED)) {
+        return 0;
+    }
+
+    // the body is encoded straight behind its header
+    unsigned char * record = replication->out + replication->out_length;
+    put_header(record, RASTA_REPLICATION_CONNECTION, length);
+    rasta_replica_encode(replica, retr_buffer, record + RASTA_REPLICATION_HEADER_SIZE, length);
+    replication->out_length += RASTA_REPLICATION_HEADER_SIZE + length;
+    return 1;
+}
+
+int rasta_replication_queue_round(struct rasta_replication * replication, uint32_t timestamp) {
+    unsigned char body[8];
+    put_u32(body, timestamp);
+    put_u32(body + 4, replication->interval_ms);
+    return rasta_replication_queue(replication, RASTA_REPLICATION_ROUND, body, sizeof(body));
+}
+
+int rasta_replication_flush(struct rasta_replication * replication) {
+    if (replication->fd == -1 || replication->connecting) {
+        return replication->fd != -1;
+    }
+
+    size_t sent = 0;
+    while (sent < replication->out_length) {
+        ssize_t result = send(replication->fd, replication->out + sent, replication->out_length - sent,
+                              MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (result > 0) {
+            sent += (size_t) result;
+        } else if (result == -1 && errno == EINTR) {
+            continue;
+        } else if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            rasta_replication_close_stream(replication);
+            return 0;
+        }
+    }
+
+    // the rest is sent behind the next round
+    memmove(replication->out, replication->out + sent, replication->out_length - sent);
+    replication->out_length -= sent;
+    return 1;
+}
+
+size_t rasta_replica_encoded_size(const struct rasta_replica * replica, struct retr_buffer * retr_buffer) {
+    size_t length = REPLICA_FIXED_SIZE + replica->channel_count * REPLICA_CHANNEL_SIZE + replica->key_length;
+    for (unsigned int i = 0; i < retrbuffer_size(retr_buffer); i++) {
+        length += REPLICA_PDU_HEADER_SIZE + retrbuffer_get(retr_buffer, i)->length;
+    }
+    return length;
+}
+
+size_t rasta_replica_encode(const struct rasta_replica * replica, struct retr_buffer * retr_buffer,
+                            unsigned char * out, size_t capacity) {
+    size_t length = rasta_replica_encoded_size(replica, retr_buffer);
+    if (length > capacity || replica->channel_count > RASTA_REPLICA_MAX_CHANNELS ||
+        replica->key_length > RASTA_REPLICA_MAX_KEY) {
+        return 0;
+    }
+
+    put_u32(out, replica->my_id);
+    put_u32(out + 4, replica->remote_id);
+    put_u32(out + 8, replica->network_id);
+    out[12] = replica->role;
+    out[13] = (unsigned char) replica->channel_count;
+    out[14] = (unsigned char) replica->key_length;
+    out[15] = 0;
+    put_u32(out + 16, replica->sn_t);
+    put_u32(out + 20, replica->sn_r);
+    put_u32(out + 24, replica->cs_t);
+    put_u32(out + 28, replica->cs_r);
+    put_u32(out + 32, replica->ts_r);
+    put_u32(out + 36, replica->cts_r);
+    put_u32(out + 40, replica->sn_i);
+    put_u32(out + 44, replica->t_i);
+    put_u32(out + 48, (uint32_t) replica->connected_recv_buffer_size);
+    put_u32(out + 52, replica->seq_tx);
+    put_u32(out + 56, replica->seq_rx);
+    put_u32(out + 60, retrbuffer_size(retr_buffer));
+    put_u32(out + 64, replica->timestamp_offset);
+
+    unsigned char * position = out + REPLICA_FIXED_SIZE;
+    for (unsigned int i = 0; i < replica->channel_count; i++) {
+        struct in_addr address;
+        if (inet_pton(AF_INET, replica->channels[i].ip, &address) != 1) {
+            address.s_addr = htonl(INADDR_ANY);
+        }
+        memcpy(position, &address.s_addr, 4);
+        put_u16(position + 4, (uint16_t) replica->channels[i].port);
+        position += REPLICA_CHANNEL_SIZE;
+    }
+
+    memcpy(position, replica->key, replica->key_length);
+    position += replica->key_length;
+
+    for (unsigned int i = 0; i < retrbuffer_size(retr_buffer); i++) {
+        struct rasta_retr_element * element = retrbuffer_get(retr_buffer, i);
+        put_u32(position, element->sequence_number);
+        put_u16(position + 4, (uint16_t) element->length);
+        memcpy(position + REPLICA_PDU_HEADER_SIZE, element->pdu, element->length);
+        position += REPLICA_PDU_HEADER_SIZE + element->length;
+    }
+    return length;
+}
+
+int rasta_replica_decode(struct rasta_replica * replica, const unsigned char * data, size_t length) {
+    if (length < REPLICA_FIXED_SIZE) {
+        return 0;
+    }
+
+    memset(replica, 0, sizeof(*replica));
+    replica->my_id = get_u32(data);
+    replica->remote_id = get_u32(data + 4);
+    replica->network_id = get_u32(data + 8);
+    replica->role = data[12];
+    replica->channel_count = data[13];
+    replica->key_length = data[14];
+    replica->sn_t = get_u32(data + 16);
+    replica->sn_r = get_u32(data + 20);
+    replica->cs_t = get_u32(data + 24);
+    replica->cs_r = get_u32(data + 28);
+    replica->ts_r = get_u32(data + 32);
+    replica->cts_r = get_u32(data + 36);
+    replica->sn_i = get_u32(data + 40);
+    replica->t_i = get_u32(data + 44);
+    replica->connected_recv_buffer_size = (int32_t) get_u32(data + 48);
+    replica->seq_tx = get_u32(data + 52);
+    replica->seq_rx = get_u32(data + 56);
+    replica->retr_count = get_u32(data + 60);
+    replica->timestamp_offset = get_u32(data + 64);
+
+    size_t variable = replica->channel_count * REPLICA_CHANNEL_SIZE + replica->key_length;
+    if (replica->channel_count > RASTA_REPLICA_MAX_CHANNELS || replica->key_length > RASTA_REPLICA_MAX_KEY ||
+        length - REPLICA_FIXED_SIZE < variable) {
+        return 0;
+    }
+
+    const unsigned char * position = data + REPLICA_FIXED_SIZE;
+    for (unsigned int i = 0; i < replica->channel_count; i++) {
+        struct in_addr address;
+        memcpy(&address.s_addr, position, 4);
+        inet_ntop(AF_INET, &address, replica->channels[i].ip, sizeof(replica->channels[i].ip));
+        replica->channels[i].port = get_u16(position + 4);
+        position += REPLICA_CHANNEL_SIZE;
+    }
+
+    memcpy(replica->key, position, replica->key_length);
+    position += replica->key_length;
+
+    replica->retr = position;
+    replica->retr_length = length - (size_t) (position - data);
+
+    // every PDU has to be complete, so rasta_replica_next_pdu() does not have to check again
+    size_t offset = 0;
+    for (unsigned int i = 0; i < replica->retr_count; i++) {
+        if (replica->retr_length - offset < REPLICA_PDU_HEADER_SIZE) {
+            return 0;
+        }
+        size_t pdu_length = get_u16(replica->retr + offset + 4);
+        if (pdu_length > MAX_DEFER_QUEUE_MSG_SIZE ||
+            replica->retr_length - offset - REPLICA_PDU_HEADER_SIZE < pdu_length) {
+            return 0;
+        }
+        offset += REPLICA_PDU_HEADER_SIZE + pdu_length;
+    }
+    return offset == replica->retr_length;
+}
+
+const unsigned char * rasta_replica_next_pdu(const struct rasta_replica * replica, size_t * offset,
+                                             uint32_t * sequence_number, unsigned int * length) {
+    if (*offset >= replica->retr_length) {
+        return NULL;
+    }
+    const unsigned char * position = replica->retr + *offset;
+    *sequence_number = get_u32(position);
+    *length = get_u16(position + 4);
+    *offset += REPLICA_PDU_HEADER_SIZE + *length;
+    return position + REPLICA_PDU_HEADER_SIZE;
+}
+
+int rasta_replication_accept(struct rasta_replication * replication) {
+    int client = accept4(replication->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client == -1) {
+        return -1;
+    }
+
+    // a restarted primary replaces the old stream, it starts with a RESET
+    rasta_replication_close_stream(replication);
+    replication->fd = client;
+    return client;
+}
+
+struct rasta_replica_entry * rasta_replication_get(struct rasta_replication * replication, uint32_t remote_id) {
+    return rasta_id_index_get(&replication->entry_index, remote_id);
+}
+
+/**
+ * removes the replica of a connection
+ */
+static void replication_remove(struct rasta_replication * replication, uint32_t remote_id) {
+    struct rasta_replica_entry * entry = rasta_replication_get(replication, remote_id);
+    if (entry == NULL) {
+        return;
+    }
+    rasta_id_index_remove(&replication->entry_index, remote_id);
+
+    // the last entry takes the place of the removed one
+    struct rasta_replica_entry * last = replication->entries[--replication->entry_count];
+    replication->entries[entry->position] = last;
+    last->position = entry->position;
+
+    rfree(entry->data);
+    rfree(entry);
+}
+
+void rasta_replication_clear(struct rasta_replication * replication) {
+    for (unsigned int i = 0; i < replication->entry_count; i++) {
+        rasta_id_index_remove(&replication->entry_index, replication->entries[i]->remote_id);
+        rfree(replication->entries[i]->data);
+        rfree(replication->entries[i]);
+    }
+    replication->entry_count = 0;
+}
+
+/**
+ * stores the CONNECTION record of a connection in place of the previous one
+ * @return 0 if the record is malformed
+ */
+static int replication_store(struct rasta_replication * replication, const unsigned char * body, size_t length) {
+    struct rasta_replica replica;
+    if (!rasta_replica_decode(&replica, body, length)) {
+        return 0;
+    }
+
+    struct rasta_replica_entry * entry = rasta_replication_get(replication, replica.remote_id);
+    if (entry == NULL) {
+        if (replication->entry_count == replication->entry_capacity) {
+            replication->entry_capacity = replication->entry_capacity ? replication->entry_capacity * 2 : 16;
+            replication->entries = rrealloc(replication->entries,
+                                            replication->entry_capacity * sizeof(struct rasta_replica_entry *));
+        }
+        entry = rmalloc(sizeof(struct rasta_replica_entry));
+        entry->remote_id = replica.remote_id;
+        entry->position = replication->entry_count;
+        entry->data = NULL;
+        entry->length = 0;
+        replication->entries[replication->entry_count++] = entry;
+        rasta_id_index_put(&replication->entry_index, replica.remote_id, entry);
+    }
+
+    if (entry->length != length) {
+        rfree(entry->data);
+        entry->data = rmalloc(length);
+        entry->length = length;
+    }
+    memcpy(entry->data, body, length);
+    return 1;
+}
+
+/**
+ * handles a complete record
+ * @return 0 if the record is malformed
+ */
+static int replication_handle(struct rasta_replication * replication, uint16_t type, const unsigned char * body,
+                              size_t length, uint32_t now) {
+    switch (type) {
+        case RASTA_REPLICATION_CONNECTION:
+            return replication_store(replication, body, length);
+        case RASTA_REPLICATION_REMOVE:
+            if (length != 4) {
+                return 0;
+            }
+            replication_remove(replication, get_u32(body));
+            return 1;
+        case RASTA_REPLICATION_ROUND:
+            if (length != 8) {
+                return 0;
+            }
+            replication->timestamp_offset = get_u32(body) - now;
+            replication->primary_interval_ms = get_u32(body + 4);
+            replication->rounds++;
+            return 1;
+        case RASTA_REPLICATION_RESET:
+            rasta_replication_clear(replication);
+            return 1;
+        default:
+            // records of later versions are skipped
+            return 1;
+    }
+}
+
+int rasta_replication_receive(struct rasta_replication * replication, uint32_t now) {
+    if (replication->fd == -1) {
+        return 0;
+    }
+
+    for (;;) {
+        if (!reserve(&replication->in, &replication->in_capacity, replication->in_length, 65536,
+                     RASTA_REPLICATION_HEADER_SIZE + RASTA_REPLICATION_MAX_RECORD + 65536)) {
+            return 0;
+        }
+        ssize_t result = recv(replication->fd, replication->in + replication->in_length, 65536, MSG_DONTWAIT);
+        if (result == 0) {
+            return 0;
+        }
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 1;
+            }
+            return 0;
+        }
+        replication->in_length += (size_t) result;
+
+        // the complete records are handled, a partial one waits for the rest
+        size_t position = 0;
+        while (replication->in_length - position >= RASTA_REPLICATION_HEADER_SIZE) {
+            const unsigned char * header = replication->in + position;
+            uint32_t length = get_u32(header + 8);
+            if (get_u32(header) != RASTA_REPLICATION_MAGIC || get_u16(header + 4) != RASTA_REPLICATION_VERSION ||
+                length > RASTA_REPLICATION_MAX_RECORD) {
+                return 0;
+            }
+            if (replication->in_length - position - RASTA_REPLICATION_HEADER_SIZE < length) {
+                break;
+            }
+            if (!replication_handle(replication, get_u16(header + 6), header + RASTA_REPLICATION_HEADER_SIZE,
+                                    length, now)) {
+                return 0;
+            }
+            position += RASTA_REPLICATION_HEADER_SIZE + length;
+        }
+        memmove(replication->in, replication->in + position, replication->in_length - position);
+        replication->in_length -= position;
+    }
+}
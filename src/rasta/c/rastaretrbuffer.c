@@ -0,0 +1,95 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SR
+#include "rmemory.h"
+#include "rastaretrbuffer.h"
+#include <string.h>
+
+struct retr_buffer retrbuffer_init(unsigned int n_max){
+    return retrbuffer_init_in(rmalloc(n_max * sizeof(struct rasta_retr_element)), n_max);
+}
+
+struct retr_buffer retrbuffer_init_in(struct rasta_retr_element * elements, unsigned int n_max){
+    struct retr_buffer buffer;
+
+    buffer.elements = elements;
+    buffer.max_count = n_max;
+    buffer.first = 0;
+    buffer.count = 0;
+
+    return buffer;
+}
+
+struct rasta_retr_element * retrbuffer_add(struct retr_buffer * buffer, const struct RastaPacket * packet,
+                                           rasta_hashing_context_t * hashing_context){
+    if (buffer->count == buffer->max_count){
+        // buffer full
+        return NULL;
+    }
+
+    struct rasta_retr_element * element = &buffer->elements[(buffer->first + buffer->count) % buffer->max_count];
+
+    // the PDU is encoded straight into its slot
+    element->length = rastaPacketEncode(packet, hashing_context, element->pdu, sizeof(element->pdu));
+    if (element->length == 0){
+        return NULL;
+    }
+    element->sequence_number = packet->sequence_number;
+
+    buffer->count++;
+
+    return element;
+}
+
+struct rasta_retr_element * retrbuffer_add_encoded(struct retr_buffer * buffer, uint32_t sequence_number,
+                                                   const unsigned char * pdu, unsigned int length){
+    if (buffer->count == buffer->max_count || length > MAX_DEFER_QUEUE_MSG_SIZE){
+        return NULL;
+    }
+
+    struct rasta_retr_element * element = &buffer->elements[(buffer->first + buffer->count) % buffer->max_count];
+    memcpy(element->pdu, pdu, length);
+    element->length = length;
+    element->sequence_number = sequence_number;
+
+    buffer->count++;
+
+    return element;
+}
+
+unsigned int retrbuffer_confirm(struct retr_buffer * buffer, uint32_t confirmed_sequence_number){
+    unsigned int removed = 0;
+
+    // the PDUs are stored in the order of their sequence numbers, so the confirmed ones are at the beginning
+    while (buffer->count > 0 &&
+           (int32_t)(confirmed_sequence_number - buffer->elements[buffer->first].sequence_number) >= 0){
+        buffer->first = (buffer->first + 1) % buffer->max_count;
+        buffer->count--;
+        removed++;
+    }
+
+    return removed;
+}
+
+struct rasta_retr_element * retrbuffer_get(struct retr_buffer * buffer, unsigned int index){
+    if (index >= buffer->count){
+        return NULL;
+    }
+
+    return &buffer->elements[(buffer->first + index) % buffer->max_count];
+}
+
+unsigned int retrbuffer_size(struct retr_buffer * buffer){
+    return buffer->count;
+}
+
+void retrbuffer_clear(struct retr_buffer * buffer){
+    buffer->first = 0;
+    buffer->count = 0;
+}
+
+void retrbuffer_destroy(struct retr_buffer * buffer){
+    rfree(buffer->elements);
+
+    buffer->elements = NULL;
+    buffer->count = 0;
+    buffer->max_count = 0;
+}
@@ -315,3 +315,379 @@ int halfsiphash(const uint8_t *in, const size_t inlen, const uint8_t *k,
 
     return 0;
 }
+
+/**
+ * processes one message word of a SipHash 2-4 calculation
+ * @param ctx the state
+ * @param m the message word
+ */
+static void siphash_compress(rasta_siphash24_ctx * ctx, uint64_t m) {
+    uint64_t v0 = ctx->v[0], v1 = ctx->v[1], v2 = ctx->v[2], v3 = ctx->v[3];
+
+    v3 ^= m;
+    for (int i = 0; i < cROUNDS; ++i)
+        SIPROUND;
+    v0 ^= m;
+
+    ctx->v[0] = v0; ctx->v[1] = v1; ctx->v[2] = v2; ctx->v[3] = v3;
+}
+
+/**
+ * processes one message word of a HalfSipHash 2-4 calculation, the rounds are the same as in halfsiphash()
+ * @param ctx the state
+ * @param m the message word
+ */
+static void halfsiphash_compress(rasta_siphash24_ctx * ctx, uint32_t m) {
+    uint32_t v0 = (uint32_t) ctx->v[0], v1 = (uint32_t) ctx->v[1], v2 = (uint32_t) ctx->v[2], v3 = (uint32_t) ctx->v[3];
+
+    v3 ^= m;
+    for (int i = 0; i < cROUNDS; ++i)
+        SIPROUND_H;
+    v0 ^= m;
+
+    ctx->v[0] = v0; ctx->v[1] = v1; ctx->v[2] = v2; ctx->v[3] = v3;
+}
+
+void rasta_siphash24_init(rasta_siphash24_ctx * ctx, const unsigned char * key, int hash_type) {
+    ctx->hash_type = hash_type;
+    ctx->buffered = 0;
+    ctx->length = 0;
+
+    if (hash_type == 2) {
+        uint64_t k0 = U8TO64_LE(key);
+        uint64_t k1 = U8TO64_LE(key + 8);
+        ctx->v[0] = 0x736f6d6570736575ULL ^ k0;
+        ctx->v[1] = 0x646f72616e646f6dULL ^ k1 ^ 0xee;
+        ctx->v[2] = 0x6c7967656e657261ULL ^ k0;
+        ctx->v[3] = 0x7465646279746573ULL ^ k1;
+    } else if (hash_type == 1) {
+        uint32_t k0 = U8TO32_LE(key);
+        uint32_t k1 = U8TO32_LE(key + 4);
+        ctx->v[0] = k0;
+        ctx->v[1] = k1 ^ 0xee;
+        ctx->v[2] = 0x6c796765 ^ k0;
+        ctx->v[3] = 0x74656462 ^ k1;
+    }
+}
+
+void rasta_siphash24_init_keyed(rasta_siphash24_ctx * ctx, const uint64_t keyed[4], int hash_type) {
+    ctx->hash_type = hash_type;
+    ctx->buffered = 0;
+    ctx->length = 0;
+    memcpy(ctx->v, keyed, sizeof(ctx->v));
+}
+
+void rasta_siphash24_update(rasta_siphash24_ctx * ctx, const unsigned char * data, size_t length) {
+    if (ctx->hash_type != 1 && ctx->hash_type != 2) {
+        return;
+    }
+
+    // SipHash processes 8 byte words, HalfSipHash 4 byte words
+    const size_t word_size = (ctx->hash_type == 2) ? 8 : 4;
+    ctx->length += length;
+
+    while (length > 0) {
+        if (ctx->buffered == 0 && length >= word_size) {
+            // whole words are read from the data directly
+            if (ctx->hash_type == 2) {
+                siphash_compress(ctx, U8TO64_LE(data));
+            } else {
+                halfsiphash_compress(ctx, U8TO32_LE(data));
+            }
+            data += word_size;
+            length -= word_size;
+            continue;
+        }
+
+        ctx->buffer[ctx->buffered++] = *data++;
+        length--;
+
+        if (ctx->buffered == word_size) {
+            if (ctx->hash_type == 2) {
+                siphash_compress(ctx, U8TO64_LE(ctx->buffer));
+            } else {
+                halfsiphash_compress(ctx, U8TO32_LE(ctx->buffer));
+            }
+            ctx->buffered = 0;
+        }
+    }
+}
+
+void rasta_siphash24_final(rasta_siphash24_ctx * ctx, unsigned char * result) {
+    if (ctx->hash_type == 2) {
+        uint64_t b = ((uint64_t) ctx->length) << 56;
+        for (size_t i = 0; i < ctx->buffered; i++) {
+            b |= ((uint64_t) ctx->buffer[i]) << (8 * i);
+        }
+        siphash_compress(ctx, b);
+
+        uint64_t v0 = ctx->v[0], v1 = ctx->v[1], v2 = ctx->v[2], v3 = ctx->v[3];
+        v2 ^= 0xee;
+        for (int i = 0; i < dROUNDS; ++i)
+            SIPROUND;
+        b = v0 ^ v1 ^ v2 ^ v3;
+        U64TO8_LE(result, b);
+
+        v1 ^= 0xdd;
+        for (int i = 0; i < dROUNDS; ++i)
+            SIPROUND;
+        b = v0 ^ v1 ^ v2 ^ v3;
+        U64TO8_LE(result + 8, b);
+    } else if (ctx->hash_type == 1) {
+        uint32_t b = ((uint32_t) ctx->length) << 24;
+        for (size_t i = 0; i < ctx->buffered; i++) {
+            b |= ((uint32_t) ctx->buffer[i]) << (8 * i);
+        }
+        halfsiphash_compress(ctx, b);
+
+        uint32_t v0 = (uint32_t) ctx->v[0], v1 = (uint32_t) ctx->v[1], v2 = (uint32_t) ctx->v[2], v3 = (uint32_t) ctx->v[3];
+        v2 ^= 0xee;
+        for (int i = 0; i < dROUNDS; ++i)
+            SIPROUND_H;
+        b = v1 ^ v3;
+        U32TO8_LE_H(result, b);
+
+        v1 ^= 0xdd;
+        for (int i = 0; i < dROUNDS; ++i)
+            SIPROUND_H;
+        b = v1 ^ v3;
+        U32TO8_LE_H(result + 4, b);
+    } else {
+        // if no hash is wanted, return 8 zero bytes
+        memset(result, 0, 8);
+    }
+}
+
+/**
+ * the SipHash state words of SIPHASH_LANES messages, one message per lane. The vector extension is translated to
+ * AVX2 if the compiler may use it, otherwise to SSE2 on x86 and NEON on ARM
+ */
+typedef uint64_t siphash_lanes __attribute__((vector_size(SIPHASH_LANES * sizeof(uint64_t))));
+
+/**
+ * the HalfSipHash state words of SIPHASH_LANES messages, one message per lane
+ */
+typedef uint32_t halfsiphash_lanes __attribute__((vector_size(SIPHASH_LANES * sizeof(uint32_t))));
+
+#define ROTL_LANES(x, b) (((x) << (b)) | ((x) >> (64 - (b))))
+
+/**
+ * one round of SIPROUND in every lane
+ * @param v the state of the lanes
+ */
+static void sipround_lanes(siphash_lanes v[4]) {
+    v[0] += v[1];
+    v[1] = ROTL_LANES(v[1], 13);
+    v[1] ^= v[0];
+    v[0] = ROTL_LANES(v[0], 32);
+    v[2] += v[3];
+    v[3] = ROTL_LANES(v[3], 16);
+    v[3] ^= v[2];
+    v[0] += v[3];
+    v[3] = ROTL_LANES(v[3], 21);
+    v[3] ^= v[0];
+    v[2] += v[1];
+    v[1] = ROTL_LANES(v[1], 17);
+    v[1] ^= v[2];
+    v[2] = ROTL_LANES(v[2], 32);
+}
+
+/**
+ * one round of SIPROUND_H in every lane. SIPROUND_H uses the 64 bit ROTL on 32 bit words, where only the left shift
+ * has an effect, so the lanes shift as well to get the same hashes
+ * @param v the state of the lanes
+ */
+static void halfsipround_lanes(halfsiphash_lanes v[4]) {
+    v[0] += v[1];
+    v[1] = v[1] << 5;
+    v[1] ^= v[0];
+    v[0] = v[0] << 16;
+    v[2] += v[3];
+    v[3] = v[3] << 8;
+    v[3] ^= v[2];
+    v[0] += v[3];
+    v[3] = v[3] << 7;
+    v[3] ^= v[0];
+    v[2] += v[1];
+    v[1] = v[1] << 13;
+    v[1] ^= v[2];
+    v[2] = v[2] << 16;
+}
+
+/**
+ * reads the last message word, which contains the remaining bytes and the low byte of the message length
+ * @param data the message
+ * @param length the length of the message
+ * @param word_size the size of a message word, 8 for SipHash and 4 for HalfSipHash
+ * @return the last message word
+ */
+static uint64_t last_word(const unsigned char * data, unsigned int length, unsigned int word_size) {
+    uint64_t b = ((uint64_t) (length & 0xFF)) << (8 * (word_size - 1));
+    const unsigned char * rest = data + length - (length % word_size);
+
+    for (unsigned int i = 0; i < length % word_size; i++) {
+        b |= ((uint64_t) rest[i]) << (8 * i);
+    }
+
+    return b;
+}
+
+/**
+ * hashes up to SIPHASH_LANES messages at once with SipHash 2-4
+ * @param keyed the internal state after the key schedule, see rasta_siphash24_init()
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages, at most SIPHASH_LANES
+ * @param results the 16 byte hashes of the messages
+ */
+static void siphash_lanes_hash(const uint64_t keyed[4], const unsigned char * const * data,
+                               const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]) {
+    siphash_lanes v[4] = { { 0 } };
+    unsigned int words[SIPHASH_LANES];
+    unsigned int max_words = 0;
+
+    for (int l = 0; l < SIPHASH_LANES; l++) {
+        for (int i = 0; i < 4; i++) {
+            v[i][l] = keyed[i];
+        }
+
+        // the whole words and the last word, unused lanes do not process any word
+        words[l] = ((unsigned int) l < count) ? lengths[l] / 8 + 1 : 0;
+        if (words[l] > max_words) {
+            max_words = words[l];
+        }
+    }
+
+    for (unsigned int index = 0; index < max_words; index++) {
+        siphash_lanes m = { 0 }, active = { 0 };
+
+        for (int l = 0; l < SIPHASH_LANES; l++) {
+            m[l] = 0;
+            if (index + 1 < words[l]) {
+                m[l] = U8TO64_LE(data[l] + 8 * index);
+            } else if (index + 1 == words[l]) {
+                m[l] = last_word(data[l], lengths[l], 8);
+            }
+            active[l] = (index < words[l]) ? ~(uint64_t) 0 : 0;
+        }
+
+        siphash_lanes updated[4] = { v[0], v[1], v[2], v[3] };
+        updated[3] ^= m;
+        for (int i = 0; i < cROUNDS; ++i)
+            sipround_lanes(updated);
+        updated[0] ^= m;
+
+        // lanes whose message is complete keep their state
+        for (int i = 0; i < 4; i++) {
+            v[i] = (updated[i] & active) | (v[i] & ~active);
+        }
+    }
+
+    v[2] ^= 0xee;
+    for (int i = 0; i < dROUNDS; ++i)
+        sipround_lanes(v);
+    siphash_lanes first = v[0] ^ v[1] ^ v[2] ^ v[3];
+
+    v[1] ^= 0xdd;
+    for (int i = 0; i < dROUNDS; ++i)
+        sipround_lanes(v);
+    siphash_lanes second = v[0] ^ v[1] ^ v[2] ^ v[3];
+
+    for (unsigned int l = 0; l < count; l++) {
+        U64TO8_LE(results[l], first[l]);
+        U64TO8_LE(results[l] + 8, second[l]);
+    }
+}
+
+/**
+ * hashes up to SIPHASH_LANES messages at once with HalfSipHash 2-4
+ * @param keyed the internal state after the key schedule, see rasta_siphash24_init()
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages, at most SIPHASH_LANES
+ * @param results the 8 byte hashes of the messages
+ */
+static void halfsiphash_lanes_hash(const uint64_t keyed[4], const unsigned char * const * data,
+                                   const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]) {
+    halfsiphash_lanes v[4] = { { 0 } };
+    unsigned int words[SIPHASH_LANES];
+    unsigned int max_words = 0;
+
+    for (int l = 0; l < SIPHASH_LANES; l++) {
+        for (int i = 0; i < 4; i++) {
+            v[i][l] = (uint32_t) keyed[i];
+        }
+
+        // the whole words and the last word, unused lanes do not process any word
+        words[l] = ((unsigned int) l < count) ? lengths[l] / 4 + 1 : 0;
+        if (words[l] > max_words) {
+            max_words = words[l];
+        }
+    }
+
+    for (unsigned int index = 0; index < max_words; index++) {
+        halfsiphash_lanes m = { 0 }, active = { 0 };
+
+        for (int l = 0; l < SIPHASH_LANES; l++) {
+            m[l] = 0;
+            if (index + 1 < words[l]) {
+                m[l] = U8TO32_LE(data[l] + 4 * index);
+            } else if (index + 1 == words[l]) {
+                m[l] = (uint32_t) last_word(data[l], lengths[l], 4);
+            }
+            active[l] = (index < words[l]) ? 0xffffffff : 0;
+        }
+
+        halfsiphash_lanes updated[4] = { v[0], v[1], v[2], v[3] };
+        updated[3] ^= m;
+        for (int i = 0; i < cROUNDS; ++i)
+            halfsipround_lanes(updated);
+        updated[0] ^= m;
+
+        // lanes whose message is complete keep their state
+        for (int i = 0; i < 4; i++) {
+            v[i] = (updated[i] & active) | (v[i] & ~active);
+        }
+    }
+
+    v[2] ^= 0xee;
+    for (int i = 0; i < dROUNDS; ++i)
+        halfsipround_lanes(v);
+    halfsiphash_lanes first = v[1] ^ v[3];
+
+    v[1] ^= 0xdd;
+    for (int i = 0; i < dROUNDS; ++i)
+        halfsipround_lanes(v);
+    halfsiphash_lanes second = v[1] ^ v[3];
+
+    for (unsigned int l = 0; l < count; l++) {
+        U32TO8_LE_H(results[l], first[l]);
+        U32TO8_LE_H(results[l] + 4, second[l]);
+    }
+}
+
+void rasta_siphash24_multi(const unsigned char * key, int hash_type, const unsigned char * const * data,
+                           const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]) {
+    rasta_siphash24_ctx start;
+
+    rasta_siphash24_init(&start, key, hash_type);
+    rasta_siphash24_multi_keyed(start.v, hash_type, data, lengths, count, results);
+}
+
+void rasta_siphash24_multi_keyed(const uint64_t keyed[4], int hash_type, const unsigned char * const * data,
+                                 const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]) {
+    for (unsigned int i = 0; i < count; i += SIPHASH_LANES) {
+        unsigned int lanes = (count - i < SIPHASH_LANES) ? count - i : SIPHASH_LANES;
+
+        if (hash_type == 2) {
+            siphash_lanes_hash(keyed, &data[i], &lengths[i], lanes, &results[i]);
+        } else if (hash_type == 1) {
+            halfsiphash_lanes_hash(keyed, &data[i], &lengths[i], lanes, &results[i]);
+        } else {
+            // if no hash is wanted, return 8 zero bytes
+            for (unsigned int l = 0; l < lanes; l++) {
+                memset(results[i + l], 0, 8);
+            }
+        }
+    }
+}
@@ -0,0 +1,398 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_LOGGING
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "rastastatpage.h"
+#include "rmemory.h"
+
+/**
+ * the attempts of a reader to take a copy before it gives up
+ */
+#define STAT_PAGE_COPY_ATTEMPTS 1000
+
+/**
+ * @param connection_capacity the maximum amount of connections in the page
+ * @param channel_capacity the maximum amount of transport channels in the page
+ * @return the size of a page
+ */
+static size_t stat_page_size(unsigned int connection_capacity, unsigned int channel_capacity) {
+    return sizeof(struct rasta_stat_header) + (size_t) connection_capacity * sizeof(struct rasta_stat_connection) +
+           (size_t) channel_capacity * sizeof(struct rasta_stat_channel);
+}
+
+struct rasta_stat_page * rasta_stat_page_create(const char * path, unsigned long local_id,
+                                                unsigned int connection_capacity, unsigned int channel_capacity,
+                                                unsigned int interval_ms) {
+    // the page is written next to the old one and replaces it at once, truncating the old file would kill its readers
+    char temporary[PATH_MAX];
+    if (snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, (int) getpid()) >= (int) sizeof(temporary)) {
+        fprintf(stderr, "The path of the stat page is too long\n");
+        exit(1);
+    }
+
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("Could not create stat page");
+        exit(1);
+    }
+
+    size_t size = stat_page_size(connection_capacity, channel_capacity);
+    if (ftruncate(fd, (off_t) size) == -1) {
+        perror("Could not resize stat page");
+        exit(1);
+    }
+
+    void * mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Could not map stat page");
+        exit(1);
+    }
+    close(fd);
+
+    struct rasta_stat_page * page = rmalloc(sizeof(struct rasta_stat_page));
+    page->header = mapping;
+    page->mapped_size = size;
+
+    // the file was just created, so everything else is zero
+    struct rasta_stat_header * header = page->header;
+    header->version = RASTA_STAT_PAGE_VERSION;
+    header->header_size = sizeof(struct rasta_stat_header);
+    header->connection_size = sizeof(struct rasta_stat_connection);
+    header->channel_size = sizeof(struct rasta_stat_channel);
+    header->connection_capacity = connection_capacity;
+    header->channel_capacity = channel_capacity;
+    header->pid = (uint32_t) getpid();
+    header->local_id = local_id;
+    header->interval_ms = interval_ms;
+    header->running = 1;
+    __atomic_store_n(&header->magic, RASTA_STAT_PAGE_MAGIC, __ATOMIC_RELEASE);
+
+    if (rename(temporary, path) == -1) {
+        perror("Could not publish stat page");
+        exit(1);
+    }
+    return page;
+}
+
+void rasta_stat_page_close(struct rasta_stat_page * page) {
+    rasta_stat_page_begin(page);
+    page->header->running = 0;
+    rasta_stat_page_end(page, page->header->published_ns);
+
+    munmap(page->header, page->mapped_size);
+    rfree(page);
+}
+
+void rasta_stat_page_begin(struct rasta_stat_page * page) {
+    uint64_t sequence = __atomic_load_n(&page->header->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&page->header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    // a reader that sees any of the following stores also sees the odd sequence
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void rasta_stat_page_end(struct rasta_stat_page * page, uint64_t published_ns) {
+    page->header->published_ns = published_ns;
+    page->header->publications++;
+    uint64_t sequence = __atomic_load_n(&page->header->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&page->header->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+struct rasta_stat_page * rasta_stat_page_open(const char * path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        perror("Could not open stat page");
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || (size_t) file_stat.st_size < sizeof(struct rasta_stat_header)) {
+        fprintf(stderr, "%s is not a stat page\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t) file_stat.st_size;
+    void * mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("Could not map stat page");
+        return NULL;
+    }
+
+    // the sizes do not change after the magic was written
+    const struct rasta_stat_header * header = mapping;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != RASTA_STAT_PAGE_MAGIC ||
+        header->version != RASTA_STAT_PAGE_VERSION || header->header_size != sizeof(struct rasta_stat_header) ||
+        header->connection_size != sizeof(struct rasta_stat_connection) ||
+        header->channel_size != sizeof(struct rasta_stat_channel) ||
+        stat_page_size(header->connection_capacity, header->channel_capacity) != size) {
+        fprintf(stderr, "%s is not a stat page of this version\n", path);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    struct rasta_stat_page * page = rmalloc(sizeof(struct rasta_stat_page));
+    page->header = mapping;
+    page->mapped_size = size;
+    return page;
+}
+
+void rasta_stat_page_unmap(struct rasta_stat_page * page) {
+    munmap(page->header, page->mapped_size);
+    rfree(page);
+}
+
+int rasta_stat_page_copy(const struct rasta_stat_page * page, void * out) {
+    for (unsigned int attempt = 0; attempt < STAT_PAGE_COPY_ATTEMPTS; attempt++) {
+        uint64_t before = __atomic_load_n(&page->header->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            // the event loop is publishing, it only takes a few microseconds
+            sched_yield();
+            continue;
+        }
+
+        memcpy(out, page->header, page->mapped_size);
+
+        // the copy has to be complete before the sequence is read again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->header->sequence, __ATOMIC_RELAXED) == before) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @param state a rasta_sr_state
+ * @return the name of the state
+ */
+static const char * stat_state_name(uint32_t state) {
+    static const char * const names[] = {
+        [RASTA_CONNECTION_CLOSED] = "closed",
+        [RASTA_CONNECTION_DOWN] = "down",
+        [RASTA_CONNECTION_START] = "start",
+        [RASTA_CONNECTION_KEX_REQ] = "kex_req",
+        [RASTA_CONNECTION_KEX_RESP] = "kex_resp",
+        [RASTA_CONNECTION_KEX_AUTH] = "kex_auth",
+        [RASTA_CONNECTION_UP] = "up",
+        [RASTA_CONNECTION_RETRREQ] = "retrreq",
+        [RASTA_CONNECTION_RETRRUN] = "retrrun",
+    };
+    if (state >= sizeof(names) / sizeof(names[0]) || names[state] == NULL) {
+        return "unknown";
+    }
+    return names[state];
+}
+
+/**
+ * writes a histogram as a Prometheus summary, like sr_write_metrics()
+ * @param out the stream to write to
+ * @param name the name of the metric
+ * @param labels the labels of the metric without braces, may be empty
+ * @param histogram the histogram
+ */
+static void write_summary(FILE * out, const char * name, const char * labels, const struct rasta_histogram * histogram) {
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        fprintf(out, "%s{%s%squantile=\"%g\"} %lu\n", name, labels, labels[0] ? "," : "", quantiles[i],
+                rasta_histogram_percentile(histogram, quantiles[i] * 100));
+    }
+    fprintf(out, "%s_sum%s%s%s %lu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", histogram->sum);
+    fprintf(out, "%s_count%s%s%s %lu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", histogram->count);
+}
+
+void rasta_stat_page_write_prometheus(struct rasta_stat_header * header, FILE * out) {
+    char labels[64];
+
+    fprintf(out, "# TYPE rasta_stat_page_running gauge\n"
+                 "# TYPE rasta_stat_page_published_seconds gauge\n"
+                 "# TYPE rasta_stat_page_publications_total counter\n"
+                 "# TYPE rasta_stat_page_connections_omitted gauge\n");
+    fprintf(out, "rasta_stat_page_running %u\n", header->running);
+    fprintf(out, "rasta_stat_page_published_seconds %.3f\n", (double) header->published_ns / 1e9);
+    fprintf(out, "rasta_stat_page_publications_total %lu\n", (unsigned long) header->publications);
+    fprintf(out, "rasta_stat_page_connections_omitted %u\n", header->connections_omitted);
+
+    // the same names as the endpoint of the entity, so the dashboards do not depend on where the metrics come from
+    fprintf(out, "# TYPE rasta_connection_up gauge\n"
+                 "# TYPE rasta_connection_pdus_in_total counter\n"
+                 "# TYPE rasta_connection_bytes_in_total counter\n"
+                 "# TYPE rasta_connection_pdus_out_total counter\n"
+                 "# TYPE rasta_connection_bytes_out_total counter\n"
+                 "# TYPE rasta_connection_retransmitted_pdus_total counter\n"
+                 "# TYPE rasta_connection_retransmission_requests_total counter\n"
+                 "# TYPE rasta_connection_receive_overflows_total counter\n"
+                 "# TYPE rasta_connection_receive_holds_total counter\n"
+                 "# TYPE rasta_connection_errors_total counter\n"
+                 "# TYPE rasta_connection_queue_size gauge\n"
+                 "# TYPE rasta_connection_send_window gauge\n"
+                 "# TYPE rasta_connection_defer_timeout_ms gauge\n"
+                 "# TYPE rasta_connection_defer_timeouts_total counter\n"
+                 "# TYPE rasta_connection_round_trip_delay_ms summary\n"
+                 "# TYPE rasta_connection_send_queue_us summary\n"
+                 "# TYPE rasta_connection_send_schedule_us summary\n"
+                 "# TYPE rasta_connection_time_ns_total counter\n"
+                 "# TYPE rasta_transport_pdus_in_total counter\n"
+                 "# TYPE rasta_transport_bytes_in_total counter\n"
+                 "# TYPE rasta_transport_pdus_out_total counter\n"
+                 "# TYPE rasta_transport_bytes_out_total counter\n"
+                 "# TYPE rasta_transport_checksum_errors_total counter\n");
+
+    struct rasta_stat_connection * connections = rasta_stat_page_connections(header);
+    for (unsigned int c = 0; c < header->connection_count && c < header->connection_capacity; c++) {
+        const struct rasta_connection_metrics_snapshot * snapshot = &connections[c].snapshot;
+        char stage_labels[96];
+        snprintf(labels, sizeof(labels), "remote_id=\"0x%lX\"", snapshot->remote_id);
+
+        fprintf(out, "rasta_connection_up{%s,state=\"%s\"} %d\n", labels, stat_state_name(connections[c].state),
+                connections[c].state == RASTA_CONNECTION_UP || connections[c].state == RASTA_CONNECTION_RETRREQ ||
+                connections[c].state == RASTA_CONNECTION_RETRRUN);
+        fprintf(out, "rasta_connection_pdus_in_total{%s} %lu\n", labels, snapshot->channel.pdus_in);
+        fprintf(out, "rasta_connection_bytes_in_total{%s} %lu\n", labels, snapshot->channel.bytes_in);
+        fprintf(out, "rasta_connection_pdus_out_total{%s} %lu\n", labels, snapshot->channel.pdus_out);
+        fprintf(out, "rasta_connection_bytes_out_total{%s} %lu\n", labels, snapshot->channel.bytes_out);
+        fprintf(out, "rasta_connection_retransmitted_pdus_total{%s} %lu\n", labels,
+                snapshot->metrics.retransmitted_pdus);
+        fprintf(out, "rasta_connection_retransmission_requests_total{%s} %lu\n", labels,
+                snapshot->metrics.retransmission_requests);
+        fprintf(out, "rasta_connection_receive_overflows_total{%s} %lu\n", labels, snapshot->metrics.receive_overflows);
+        fprintf(out, "rasta_connection_receive_holds_total{%s} %lu\n", labels, snapshot->metrics.receive_holds);
+
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"safety\"} %u\n", labels, snapshot->errors.safety);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"address\"} %u\n", labels, snapshot->errors.address);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"type\"} %u\n", labels, snapshot->errors.type);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"sn\"} %u\n", labels, snapshot->errors.sn);
+        fprintf(out, "rasta_connection_errors_total{%s,type=\"cs\"} %u\n", labels, snapshot->errors.cs);
+
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"send\"} %u\n", labels, snapshot->send_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"urgent\"} %u\n", labels, snapshot->urgent_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"receive\"} %u\n", labels, snapshot->receive_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"retransmission\"} %u\n", labels,
+                snapshot->retransmission_queue_size);
+        fprintf(out, "rasta_connection_queue_size{%s,queue=\"defer\"} %u\n", labels, snapshot->defer_queue_size);
+        fprintf(out, "rasta_connection_defer_timeout_ms{%s} %u\n", labels, snapshot->defer_timeout_ms);
+        fprintf(out, "rasta_connection_defer_timeouts_total{%s} %lu\n", labels, snapshot->defer_timeouts);
+        fprintf(out, "rasta_connection_send_window{%s} %u\n", labels, snapshot->send_window);
+
+        write_summary(out, "rasta_connection_round_trip_delay_ms", labels, &snapshot->metrics.round_trip_delay);
+        for (unsigned int i = 0; i < RASTA_SEND_PRIORITIES; i++) {
+            snprintf(stage_labels, sizeof(stage_labels), "%s,priority=\"%s\"", labels,
+                     i == RASTA_SEND_URGENT ? "urgent" : "bulk");
+            write_summary(out, "rasta_connection_send_queue_us", stage_labels, &snapshot->metrics.send_queue_us[i]);
+        }
+        write_summary(out, "rasta_connection_send_schedule_us", labels, &snapshot->metrics.send_schedule_us);
+
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"receive\"} %lu\n", labels, snapshot->metrics.receive_ns);
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"send\"} %lu\n", labels, snapshot->metrics.send_ns);
+        fprintf(out, "rasta_connection_time_ns_total{%s,path=\"safety_code\"} %lu\n", labels,
+                snapshot->safety_code_ns);
+
+        for (unsigned int i = 0; i < snapshot->transport_channel_count; i++) {
+            const struct rasta_transport_metrics * transport = &snapshot->transport_channels[i];
+            fprintf(out, "rasta_transport_pdus_in_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->pdus_in);
+            fprintf(out, "rasta_transport_bytes_in_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->bytes_in);
+            fprintf(out, "rasta_transport_pdus_out_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->pdus_out);
+            fprintf(out, "rasta_transport_bytes_out_total{%s,channel=\"%u\"} %lu\n", labels, i, transport->bytes_out);
+            fprintf(out, "rasta_transport_checksum_errors_total{%s,channel=\"%u\"} %lu\n", labels, i,
+                    transport->checksum_errors);
+        }
+    }
+
+    fprintf(out, "# TYPE rasta_transmit_queue_size gauge\n"
+                 "# TYPE rasta_transmit_queued_total counter\n"
+                 "# TYPE rasta_transmit_drops_total counter\n"
+                 "# TYPE rasta_path_pdus_in_total counter\n"
+                 "# TYPE rasta_path_bytes_in_total counter\n"
+                 "# TYPE rasta_path_pdus_out_total counter\n"
+                 "# TYPE rasta_path_bytes_out_total counter\n"
+                 "# TYPE rasta_path_checksum_errors_total counter\n");
+    struct rasta_stat_channel * channels = rasta_stat_page_channels(header);
+    for (unsigned int i = 0; i < header->channel_count && i < header->channel_capacity; i++) {
+        fprintf(out, "rasta_transmit_queue_size{channel=\"%u\"} %u\n", i, channels[i].transmit.depth);
+        fprintf(out, "rasta_transmit_queued_total{channel=\"%u\"} %lu\n", i,
+                (unsigned long) channels[i].transmit.queued);
+        fprintf(out, "rasta_transmit_drops_total{channel=\"%u\"} %lu\n", i, (unsigned long) channels[i].transmit.drops);
+        fprintf(out, "rasta_path_pdus_in_total{channel=\"%u\"} %lu\n", i, channels[i].path.pdus_in);
+        fprintf(out, "rasta_path_bytes_in_total{channel=\"%u\"} %lu\n", i, channels[i].path.bytes_in);
+        fprintf(out, "rasta_path_pdus_out_total{channel=\"%u\"} %lu\n", i, channels[i].path.pdus_out);
+        fprintf(out, "rasta_path_bytes_out_total{channel=\"%u\"} %lu\n", i, channels[i].path.bytes_out);
+        fprintf(out, "rasta_path_checksum_errors_total{channel=\"%u\"} %lu\n", i, channels[i].path.checksum_errors);
+    }
+
+    fprintf(out, "# TYPE rasta_pending_channels gauge\n"
+                 "# TYPE rasta_pending_channel_evictions_total counter\n"
+                 "# TYPE rasta_pending_channel_drops_total counter\n");
+    fprintf(out, "rasta_pending_channels %u\n", header->pending.count);
+    fprintf(out, "rasta_pending_channel_evictions_total %lu\n", header->pending.evictions);
+    fprintf(out, "rasta_pending_channel_drops_total %lu\n", header->pending.drops);
+
+    fprintf(out, "# TYPE rasta_event_loop_lag_us summary\n");
+    write_summary(out, "rasta_event_loop_lag_us", "", &header->loop_lag_us);
+
+    fprintf(out, "# TYPE rasta_callbacks_queued_total counter\n"
+                 "# TYPE rasta_callbacks_coalesced_total counter\n"
+                 "# TYPE rasta_callback_overflows_total counter\n");
+    fprintf(out, "rasta_callbacks_queued_total %lu\n", (unsigned long) header->callbacks_queued);
+    fprintf(out, "rasta_callbacks_coalesced_total %lu\n", (unsigned long) header->callbacks_coalesced);
+    fprintf(out, "rasta_callback_overflows_total %lu\n", (unsigned long) header->callback_overflows);
+
+    fprintf(out, "# TYPE rasta_receive_stage_batches_total counter\n"
+                 "# TYPE rasta_receive_stage_pdus_total counter\n"
+                 "# TYPE rasta_receive_stage_rejected_total counter\n"
+                 "# TYPE rasta_receive_stage_duration_ns summary\n");
+    for (unsigned int i = 0; i < RASTA_RECEIVE_STAGES; i++) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", rasta_receive_stage_name((rasta_receive_stage) i));
+        fprintf(out, "rasta_receive_stage_batches_total{%s} %lu\n", labels, header->receive_stages.batches[i]);
+        fprintf(out, "rasta_receive_stage_pdus_total{%s} %lu\n", labels, header->receive_stages.pdus[i]);
+        fprintf(out, "rasta_receive_stage_rejected_total{%s} %lu\n", labels, header->receive_stages.rejected[i]);
+        write_summary(out, "rasta_receive_stage_duration_ns", labels, &header->receive_stages.duration[i]);
+    }
+}
+
+void rasta_stat_page_write_text(struct rasta_stat_header * header, FILE * out) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t now_ns = (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+    double age_ms = header->published_ns != 0 && now_ns > header->published_ns
+                    ? (double) (now_ns - header->published_ns) / 1e6 : 0;
+
+    fprintf(out, "local_id=0x%lX pid=%u %s publications=%lu age=%.0fms interval=%ums\n",
+            (unsigned long) header->local_id, header->pid, header->running ? "running" : "closed",
+            (unsigned long) header->publications, age_ms, header->interval_ms);
+    fprintf(out, "event loop lag us: p50=%lu p99=%lu max=%lu\n",
+            rasta_histogram_percentile(&header->loop_lag_us, 50), rasta_histogram_percentile(&header->loop_lag_us, 99),
+            header->loop_lag_us.max);
+
+    fprintf(out, "\n%-10s %-8s %10s %10s %8s %8s %6s %6s %6s %6s %8s %8s\n", "remote_id", "state", "pdus_in",
+            "pdus_out", "retrans", "errors", "send", "urgent", "recv", "unconf", "rtd_p50", "rtd_p99");
+    struct rasta_stat_connection * connections = rasta_stat_page_connections(header);
+    for (unsigned int c = 0; c < header->connection_count && c < header->connection_capacity; c++) {
+        const struct rasta_connection_metrics_snapshot * snapshot = &connections[c].snapshot;
+        unsigned int errors = snapshot->errors.safety + snapshot->errors.address + snapshot->errors.type +
+                              snapshot->errors.sn + snapshot->errors.cs;
+        fprintf(out, "0x%-8lX %-8s %10lu %10lu %8lu %8u %6u %6u %6u %6u %8lu %8lu\n", snapshot->remote_id,
+                stat_state_name(connections[c].state), snapshot->channel.pdus_in, snapshot->channel.pdus_out,
+                snapshot->metrics.retransmitted_pdus, errors, snapshot->send_queue_size, snapshot->urgent_queue_size,
+                snapshot->receive_queue_size, snapshot->retransmission_queue_size,
+                rasta_histogram_percentile(&snapshot->metrics.round_trip_delay, 50),
+                rasta_histogram_percentile(&snapshot->metrics.round_trip_delay, 99));
+    }
+    if (header->connections_omitted > 0) {
+        fprintf(out, "%u connections did not fit into the page\n", header->connections_omitted);
+    }
+
+    fprintf(out, "\n%-8s %10s %10s %8s %8s %8s\n", "channel", "pdus_in", "pdus_out", "crc_err", "queued", "drops");
+    struct rasta_stat_channel * channels = rasta_stat_page_channels(header);
+    for (unsigned int i = 0; i < header->channel_count && i < header->channel_capacity; i++) {
+        fprintf(out, "%-8u %10lu %10lu %8lu %8lu %8lu\n", i, channels[i].path.pdus_in, channels[i].path.pdus_out,
+                channels[i].path.checksum_errors, (unsigned long) channels[i].transmit.queued,
+                (unsigned long) channels[i].transmit.drops);
+    }
+}
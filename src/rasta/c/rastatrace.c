@@ -0,0 +1,193 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_LOGGING
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "rastatrace.h"
+#include "logging.h"
+#include "rmemory.h"
+
+struct rasta_trace * rasta_trace_open(const char * path, unsigned int capacity) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("Could not open trace file");
+        exit(1);
+    }
+
+    // several entities may open the same file at once, only one of them may initialize it
+    if (flock(fd, LOCK_EX) == -1) {
+        perror("Could not lock trace file");
+        exit(1);
+    }
+
+    size_t size = sizeof(struct rasta_trace_header) + (size_t) capacity * sizeof(struct rasta_trace_record);
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        perror("Could not read size of trace file");
+        exit(1);
+    }
+
+    int reuse = 0;
+    if ((size_t) file_stat.st_size == size) {
+        struct rasta_trace_header existing;
+        reuse = pread(fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+                existing.magic == RASTA_TRACE_MAGIC && existing.version == RASTA_TRACE_VERSION &&
+                existing.record_size == sizeof(struct rasta_trace_record) && existing.capacity == capacity;
+    }
+
+    if (!reuse && (ftruncate(fd, 0) == -1 || ftruncate(fd, (off_t) size) == -1)) {
+        perror("Could not resize trace file");
+        exit(1);
+    }
+
+    void * mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Could not map trace file");
+        exit(1);
+    }
+
+    struct rasta_trace * trace = rmalloc(sizeof(struct rasta_trace));
+    trace->header = mapping;
+    trace->records = (struct rasta_trace_record *) (trace->header + 1);
+    trace->mapped_size = size;
+
+    if (!reuse) {
+        // the file was truncated, so all records are zero and their index does not match
+        trace->header->record_size = sizeof(struct rasta_trace_record);
+        trace->header->capacity = capacity;
+        trace->header->next = 0;
+        trace->header->version = RASTA_TRACE_VERSION;
+        __atomic_store_n(&trace->header->magic, RASTA_TRACE_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    // the mapping keeps the file open, so closing the descriptor would not release the lock
+    flock(fd, LOCK_UN);
+    close(fd);
+    return trace;
+}
+
+void (rasta_trace_add)(struct rasta_trace * trace, rasta_trace_event event, unsigned long connection_id,
+                          unsigned long sequence_a, unsigned long sequence_b, unsigned int channel, unsigned int value) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint64_t position = __atomic_fetch_add(&trace->header->next, 1, __ATOMIC_RELAXED);
+    struct rasta_trace_record * record = &trace->records[position % trace->header->capacity];
+
+    record->timestamp = (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+    record->event = (uint16_t) event;
+    record->channel = (uint16_t) channel;
+    record->connection_id = (uint32_t) connection_id;
+    record->sequence_a = (uint32_t) sequence_a;
+    record->sequence_b = (uint32_t) sequence_b;
+    record->value = value;
+    __atomic_store_n(&record->index, (uint32_t) (position + 1), __ATOMIC_RELEASE);
+}
+
+void rasta_trace_close(struct rasta_trace * trace) {
+    munmap(trace->header, trace->mapped_size);
+    rfree(trace);
+}
+
+/**
+ * @param reason a discard reason
+ * @return a text that describes @p reason
+ */
+static const char * discard_reason_string(unsigned int reason) {
+    switch (reason) {
+        case RASTA_TRACE_DISCARD_FIRST_NOT_ZERO:
+            return "first seq_pdu != 0";
+        case RASTA_TRACE_DISCARD_DUPLICATE:
+            return "packet already received";
+        case RASTA_TRACE_DISCARD_DEFERQ_FULL:
+            return "deferq full";
+        case RASTA_TRACE_DISCARD_OUT_OF_RANGE:
+            return "seq_pdu out of range";
+        case RASTA_TRACE_DISCARD_CHECKSUM:
+            return "checksum incorrect";
+        case RASTA_TRACE_DISCARD_ADDRESS:
+            return "invalid sender/receiver";
+        case RASTA_TRACE_DISCARD_SN:
+            return "sn range invalid";
+        case RASTA_TRACE_DISCARD_CS:
+            return "cs invalid";
+        default:
+            return "unknown reason";
+    }
+}
+
+void rasta_trace_render(const struct rasta_trace_record * record, char * out, size_t size) {
+    char message[256];
+    const char * location;
+
+    switch ((rasta_trace_event) record->event) {
+        case RASTA_TRACE_RED_RECEIVE:
+            location = "RaSTA Red receive";
+            snprintf(message, sizeof(message), "channel %u: id=0x%X, seq_pdu=%u, seq_rx=%u", record->channel,
+                     record->connection_id, record->sequence_a, record->sequence_b);
+            break;
+        case RASTA_TRACE_RED_CHECKSUM_INCORRECT:
+            location = "RaSTA Red receive";
+            snprintf(message, sizeof(message), "channel %u: id=0x%X, packet checksum incorrect", record->channel,
+                     record->connection_id);
+            break;
+        case RASTA_TRACE_RED_DELIVER:
+            location = "RaSTA Red deliver";
+            snprintf(message, sizeof(message), "channel %u: id=0x%X, delivering seq_pdu=%u to next layer", record->channel,
+                     record->connection_id, record->sequence_a);
+            break;
+        case RASTA_TRACE_RED_DISCARD:
+            location = "RaSTA Red receive";
+            snprintf(message, sizeof(message), "channel %u: id=0x%X, discarding seq_pdu=%u, seq_rx=%u: %s",
+                     record->channel, record->connection_id, record->sequence_a, record->sequence_b, discard_reason_string(record->value));
+            break;
+        case RASTA_TRACE_RED_DEFER:
+            location = "RaSTA Red receive";
+            snprintf(message, sizeof(message), "channel %u: id=0x%X, adding seq_pdu=%u to deferq, seq_rx=%u",
+                     record->channel, record->connection_id, record->sequence_a, record->sequence_b);
+            break;
+        case RASTA_TRACE_RED_DEFER_TIMEOUT:
+            location = "RaSTA Red f_deferTmo";
+            snprintf(message, sizeof(message), "id=0x%X, defer timeout, seq_rx=%u", record->connection_id, record->sequence_a);
+            break;
+        case RASTA_TRACE_RED_SEND:
+            location = "RaSTA RedMux send";
+            snprintf(message, sizeof(message), "id=0x%X, sent seq_tx=%u over %u transport channels",
+                     record->connection_id, record->sequence_a, record->value);
+            break;
+        case RASTA_TRACE_SR_RECEIVE:
+            location = "RaSTA RECEIVE";
+            snprintf(message, sizeof(message), "Received packet %u from 0x%X, sn=%u, cs=%u", record->value,
+                     record->connection_id, record->sequence_a, record->sequence_b);
+            break;
+        case RASTA_TRACE_SR_DISCARD:
+            location = "RaSTA RECEIVE";
+            snprintf(message, sizeof(message), "Discarding packet from 0x%X, sn=%u, cs=%u: %s", record->connection_id,
+                     record->sequence_a, record->sequence_b, discard_reason_string(record->value));
+            break;
+        case RASTA_TRACE_SR_RETRANSMIT:
+            location = "RaSTA retransmit";
+            snprintf(message, sizeof(message), "id=0x%X, retransmitting %u packets from sn=%u", record->connection_id,
+                     record->value, record->sequence_a);
+            break;
+        default:
+            location = "RaSTA trace";
+            snprintf(message, sizeof(message), "unknown event %u", record->event);
+            break;
+    }
+
+    // the same timestamp as in the text log
+    time_t seconds = (time_t) (record->timestamp / 1000000000);
+    struct tm tt;
+    char timestamp[30];
+    char timestamp2[60];
+    strftime(timestamp, sizeof(timestamp), "%x|%X", localtime_r(&seconds, &tt));
+    snprintf(timestamp2, sizeof(timestamp2), "%s (Epoch time: %llu)", timestamp,
+             (unsigned long long) (record->timestamp / 1000000));
+
+    snprintf(out, size, LOG_FORMAT, timestamp2, "TRACE", location, message);
+}
@@ -1,35 +1,23 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_CODEC
 #include <stdlib.h>
-#include <time.h>
 #include "rastautil.h"
-#include <endian.h>
+#include "rmemory.h"
+#include "event_system.h"
+#include "rastawire.h"
 
 
 uint32_t current_ts(){
-    long ms;
-    time_t s;
-    struct timespec spec;
-
-    clock_gettime(CLOCK_MONOTONIC, &spec);
-
-    s = spec.tv_sec;
-
-    // seconds to milliseconds
-    ms = s * 1000;
-
-    // nanoseconds to milliseconds
-    ms += (long)(spec.tv_nsec / 1.0e6);
-
-    return (uint32_t)ms;
+    return event_system_now_ms();
 }
 
 void freeRastaByteArray(struct RastaByteArray* data) {
     data->length = 0;
-    free(data->bytes);
+    rfree(data->bytes);
 }
 
 
 void allocateRastaByteArray(struct RastaByteArray* data, unsigned int length) {
-    data->bytes = malloc(length);
+    data->bytes = rmalloc(length);
     data->length = length;
 }
 
@@ -41,11 +29,9 @@ int isBigEndian() {
 }
 
 void hostLongToLe(uint32_t v, unsigned char* result) {
-    uint32_t *target = (uint32_t *) result;
-    *target = htole32(v);
+    rasta_wire_put_u32(result, v);
 }
 
 uint32_t leLongToHost(const unsigned char v[4]) {
-    uint32_t *result = (uint32_t*) v;
-    return le32toh(*result);
+    return rasta_wire_get_u32(v);
 }
\ No newline at end of file
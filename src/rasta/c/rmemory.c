@@ -3,20 +3,614 @@
 //malloc, free, memcopy und memset
 //
 
+// the allocator itself is not tagged
+#define RMEMORY_IMPLEMENTATION
+
 #include <malloc.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 #include "rmemory.h"
 
-void * rmalloc(unsigned int size) {
+/**
+ * amount of pooled size classes, the smallest class holds 16 bytes and every further class doubles the size.
+ * The largest class holds a receive buffer of MAX_DEFER_QUEUE_MSG_SIZE bytes
+ */
+#define RMEMORY_CLASS_COUNT 7
+
+#define RMEMORY_MIN_CLASS_SIZE 16
+
+/**
+ * memory that is taken at once when the pool of a size class is empty
+ */
+#define RMEMORY_SLAB_SIZE 16384
+
+/**
+ * size class of the blocks that are not pooled
+ */
+#define RMEMORY_LARGE RMEMORY_CLASS_COUNT
+
+/**
+ * size classes of the blocks that are mapped for a placement, with normal pages and with reserved huge pages
+ */
+#define RMEMORY_MAPPED (RMEMORY_CLASS_COUNT + 1)
+#define RMEMORY_MAPPED_HUGE (RMEMORY_CLASS_COUNT + 2)
+
+/**
+ * blocks of at least this size are mapped for themselves if the thread has a placement, smaller ones come from
+ * malloc() to keep the page tables small
+ */
+#define RMEMORY_MAPPED_MIN_SIZE 65536
+
+#define RMEMORY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * memory that is mapped at once for the slabs of a thread with a placement, one huge page
+ */
+#define RMEMORY_CHUNK_SIZE RMEMORY_HUGE_PAGE_SIZE
+
+/**
+ * the highest NUMA node a placement binds to
+ */
+#define RMEMORY_MAX_NODES 1024
+
+/**
+ * precedes every block, keeps the block aligned like malloc()
+ */
+union rmemory_header {
+    struct {
+        /**
+         * the size class of the block or RMEMORY_LARGE
+         */
+        unsigned int size_class;
+
+        /**
+         * the requested size of the block
+         */
+        unsigned int size;
+
+        /**
+         * the rmemory_subsystem that allocated the block
+         */
+        unsigned int subsystem;
+    } info;
+    max_align_t align;
+};
+
+/**
+ * an unused block in the pool of a size class
+ */
+struct rmemory_free_block {
+    struct rmemory_free_block * next;
+};
+
+static atomic_ulong allocations;
+static atomic_ulong frees;
+static atomic_ulong system_allocations;
+static atomic_ulong mapped_bytes;
+static atomic_ulong huge_page_bytes;
+
+/**
+ * the system allocations before the last rmemory_seal(), 0 before the first one
+ */
+static atomic_ulong sealed_at;
+static atomic_bool sealed;
+
+#ifdef USE_STATIC_MEMORY
+/**
+ * precedes every piece of the static memory, a piece is never split or merged again
+ */
+union rmemory_static_header {
+    struct {
+        size_t capacity;
+        union rmemory_static_header * next;
+    } info;
+    max_align_t align;
+};
+
+/**
+ * the static memory, the pieces are cut from its beginning. A large block that is freed is kept in static_free and
+ * reused by the next large block that fits, the slabs of the pools are never freed
+ */
+static union {
+    max_align_t align;
+    unsigned char bytes[RASTA_STATIC_MEMORY_BYTES];
+} static_memory;
+static size_t static_used;
+static union rmemory_static_header * static_free;
+static atomic_flag static_lock = ATOMIC_FLAG_INIT;
+#endif
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+/**
+ * the counters of every subsystem, shared by all threads
+ */
+static struct {
+    atomic_ulong allocations;
+    atomic_ulong frees;
+    atomic_ulong bytes;
+    atomic_ulong live_bytes;
+    atomic_ulong peak_live_bytes;
+} subsystem_counters[RMEMORY_SUBSYSTEMS];
+
+/**
+ * adds to the live bytes of a subsystem and raises its high-water mark
+ * @param subsystem the subsystem
+ * @param size the amount of bytes that became live
+ */
+static void account_live(unsigned int subsystem, unsigned long size) {
+    unsigned long live = atomic_fetch_add_explicit(&subsystem_counters[subsystem].live_bytes, size,
+                                                   memory_order_relaxed) + size;
+    unsigned long peak = atomic_load_explicit(&subsystem_counters[subsystem].peak_live_bytes, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&subsystem_counters[subsystem].peak_live_bytes, &peak,
+                                                                 live, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+#endif
+
+#ifdef ENABLE_MEMORY_POOL
+/**
+ * the unused blocks of every size class. Every thread has its own pools, so no locking is needed. A block that is
+ * freed by another thread than the one that allocated it joins the pool of the freeing thread
+ */
+static _Thread_local struct rmemory_free_block * free_lists[RMEMORY_CLASS_COUNT];
+#endif
+
+/**
+ * the placement of the thread and the rest of the chunk its next slabs are cut from
+ */
+static _Thread_local struct rmemory_placement thread_placement = { -1, 0 };
+static _Thread_local unsigned char * chunk;
+static _Thread_local size_t chunk_left;
+
+/**
+ * @return 1 if the memory of the thread is mapped for a placement
+ */
+static int placed(void) {
+#if defined(USE_USER_ARENA) || defined(USE_STATIC_MEMORY)
+    return 0;
+#else
+    return thread_placement.numa_node >= 0 || thread_placement.huge_pages;
+#endif
+}
+
+/**
+ * @param size the size of memory
+ * @param huge 1 if the memory is backed by reserved huge pages
+ * @return the size of its mapping
+ */
+static size_t mapped_length(size_t size, int huge) {
+    size_t page_size = huge ? RMEMORY_HUGE_PAGE_SIZE : (size_t) sysconf(_SC_PAGESIZE);
+    return (size + page_size - 1) / page_size * page_size;
+}
+
+/**
+ * binds memory that was not touched yet to the NUMA node of the placement of the thread. The kernel takes the memory
+ * from other nodes if the node is full or does not exist
+ * @param memory the memory
+ * @param length the length of its mapping
+ */
+static void bind_node(void * memory, size_t length) {
+#ifdef SYS_mbind
+    unsigned long mask[RMEMORY_MAX_NODES / (8 * sizeof(unsigned long))];
+    unsigned int bits = 8 * sizeof(unsigned long);
+    int node = thread_placement.numa_node;
+
+    if (node < 0 || node >= RMEMORY_MAX_NODES) {
+        return;
+    }
+    memset(mask, 0, sizeof(mask));
+    mask[node / bits] |= 1UL << (node % bits);
+    // the kernel does not count the last bit of the mask
+    syscall(SYS_mbind, memory, length, MPOL_PREFERRED, mask, RMEMORY_MAX_NODES + 1, 0);
+#else
+    (void) memory;
+    (void) length;
+#endif
+}
+
+/**
+ * maps memory for the placement of the thread
+ * @param size the size of the memory
+ * @param huge set to 1 if the memory is backed by reserved huge pages
+ * @return the memory or NULL if no memory is left
+ */
+static void * map_placed(size_t size, int * huge) {
+    void * memory = MAP_FAILED;
+    size_t length = 0;
+
+    *huge = 0;
+    // a reserved huge page is not split, so it is only taken for memory that fills most of it
+    if (thread_placement.huge_pages && size >= RMEMORY_HUGE_PAGE_SIZE / 2) {
+        length = mapped_length(size, 1);
+        memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        *huge = memory != MAP_FAILED;
+    }
+    if (memory == MAP_FAILED) {
+        // no huge pages are reserved, transparent huge pages back the memory if they are enabled
+        length = mapped_length(size, 0);
+        memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return NULL;
+        }
+        if (thread_placement.huge_pages) {
+            madvise(memory, length, MADV_HUGEPAGE);
+        }
+    }
+    bind_node(memory, length);
+
+    atomic_fetch_add_explicit(&system_allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mapped_bytes, length, memory_order_relaxed);
+    if (*huge) {
+        atomic_fetch_add_explicit(&huge_page_bytes, length, memory_order_relaxed);
+    }
+    return memory;
+}
+
+/**
+ * unmaps a block that was mapped by map_placed()
+ * @param memory the memory
+ * @param size the size it was mapped with
+ * @param huge 1 if the memory is backed by reserved huge pages
+ */
+static void unmap_placed(void * memory, size_t size, int huge) {
+    size_t length = mapped_length(size, huge);
+    munmap(memory, length);
+    atomic_fetch_sub_explicit(&mapped_bytes, length, memory_order_relaxed);
+    if (huge) {
+        atomic_fetch_sub_explicit(&huge_page_bytes, length, memory_order_relaxed);
+    }
+}
+
+#ifdef USE_STATIC_MEMORY
+/**
+ * takes a piece of the static memory, the smallest freed one that fits or a new one
+ * @param size the size of the memory
+ * @return the memory or NULL if the static memory is used up
+ */
+static void * static_alloc(size_t size) {
+    union rmemory_static_header * piece = NULL;
+    while (atomic_flag_test_and_set_explicit(&static_lock, memory_order_acquire)) {
+    }
+
+    union rmemory_static_header ** best = NULL;
+    for (union rmemory_static_header ** link = &static_free; *link != NULL; link = &(*link)->info.next) {
+        if ((*link)->info.capacity >= size && (best == NULL || (*link)->info.capacity < (*best)->info.capacity)) {
+            best = link;
+        }
+    }
+    if (best != NULL) {
+        piece = *best;
+        *best = piece->info.next;
+    } else {
+        size_t length = sizeof(union rmemory_static_header) +
+                        (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+        if (length <= sizeof(static_memory.bytes) - static_used) {
+            piece = (union rmemory_static_header *) &static_memory.bytes[static_used];
+            piece->info.capacity = length - sizeof(union rmemory_static_header);
+            static_used += length;
+        }
+    }
+
+    atomic_flag_clear_explicit(&static_lock, memory_order_release);
+    if (piece == NULL) {
+        fprintf(stderr, "the static memory of %zu bytes is used up\n", sizeof(static_memory.bytes));
+        return NULL;
+    }
+    return piece + 1;
+}
+
+/**
+ * gives a piece back to static_alloc()
+ * @param memory the memory returned by static_alloc()
+ */
+static void static_free_piece(void * memory) {
+    union rmemory_static_header * piece = (union rmemory_static_header *) memory - 1;
+    while (atomic_flag_test_and_set_explicit(&static_lock, memory_order_acquire)) {
+    }
+    piece->info.next = static_free;
+    static_free = piece;
+    atomic_flag_clear_explicit(&static_lock, memory_order_release);
+}
+#endif
+
+static void * system_alloc(size_t size) {
+    atomic_fetch_add_explicit(&system_allocations, 1, memory_order_relaxed);
+#if defined(USE_STATIC_MEMORY)
+    return static_alloc(size);
+#elif defined(USE_USER_ARENA)
+    return rasta_arena_alloc(size);
+#else
     return malloc(size);
+#endif
+}
+
+static void system_free(void * memory) {
+#if defined(USE_STATIC_MEMORY)
+    static_free_piece(memory);
+#elif defined(USE_USER_ARENA)
+    rasta_arena_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+/**
+ * @param size the requested size of a block
+ * @return the smallest size class that holds @p size bytes or RMEMORY_LARGE
+ */
+static unsigned int size_class_of(unsigned int size) {
+#ifdef ENABLE_MEMORY_POOL
+    unsigned int size_class = 0;
+    unsigned int class_size = RMEMORY_MIN_CLASS_SIZE;
+    while (class_size < size && size_class < RMEMORY_CLASS_COUNT) {
+        class_size *= 2;
+        size_class++;
+    }
+    return size_class;
+#else
+    (void) size;
+    return RMEMORY_LARGE;
+#endif
+}
+
+#ifdef ENABLE_MEMORY_POOL
+/**
+ * fills the empty pool of a size class with the blocks of a new slab. Slabs are never given back to the system
+ * @param size_class the size class
+ * @return 1 if the pool has blocks, 0 if no memory is left
+ */
+static int refill(unsigned int size_class) {
+    size_t block_size = sizeof(union rmemory_header) + ((size_t) RMEMORY_MIN_CLASS_SIZE << size_class);
+    size_t count = RMEMORY_SLAB_SIZE / block_size;
+
+    unsigned char * slab;
+    if (placed()) {
+        // the slabs of all size classes share the chunks, so a huge page is not taken by one small size class
+        if (chunk_left < count * block_size) {
+            int huge;
+            chunk = map_placed(RMEMORY_CHUNK_SIZE, &huge);
+            chunk_left = chunk != NULL ? RMEMORY_CHUNK_SIZE : 0;
+        }
+        if (chunk_left < count * block_size) {
+            return 0;
+        }
+        slab = chunk;
+        chunk += count * block_size;
+        chunk_left -= count * block_size;
+    } else {
+        slab = system_alloc(count * block_size);
+        if (slab == NULL) {
+            return 0;
+        }
+    }
+
+    for (size_t i = count; i > 0; i--) {
+        struct rmemory_free_block * block = (struct rmemory_free_block *) &slab[(i - 1) * block_size];
+        block->next = free_lists[size_class];
+        free_lists[size_class] = block;
+    }
+    return 1;
+}
+#endif
+
+void * rmalloc(unsigned int size) {
+    return rmalloc_tagged(size, RMEMORY_SUBSYSTEM_OTHER);
+}
+
+void * rmalloc_tagged(unsigned int size, rmemory_subsystem subsystem) {
+    unsigned int size_class = size_class_of(size);
+    union rmemory_header * header;
+
+#ifdef ENABLE_MEMORY_POOL
+    if (size_class != RMEMORY_LARGE) {
+        if (free_lists[size_class] == NULL && !refill(size_class)) {
+            return NULL;
+        }
+        struct rmemory_free_block * block = free_lists[size_class];
+        free_lists[size_class] = block->next;
+        header = (union rmemory_header *) block;
+    } else
+#endif
+    if (placed() && size >= RMEMORY_MAPPED_MIN_SIZE) {
+        int huge;
+        header = map_placed(sizeof(union rmemory_header) + (size_t) size, &huge);
+        if (header == NULL) {
+            return NULL;
+        }
+        size_class = huge ? RMEMORY_MAPPED_HUGE : RMEMORY_MAPPED;
+    } else {
+        header = system_alloc(sizeof(union rmemory_header) + (size_t) size);
+        if (header == NULL) {
+            return NULL;
+        }
+    }
+
+    header->info.size_class = size_class;
+    header->info.size = size;
+    header->info.subsystem = (unsigned int) subsystem < RMEMORY_SUBSYSTEMS ? (unsigned int) subsystem
+                                                                          : RMEMORY_SUBSYSTEM_OTHER;
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    atomic_fetch_add_explicit(&subsystem_counters[header->info.subsystem].allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&subsystem_counters[header->info.subsystem].bytes, size, memory_order_relaxed);
+    account_live(header->info.subsystem, size);
+#endif
+
+    return header + 1;
 }
 
 void * rrealloc(void* element, unsigned int size) {
-    return realloc(element,size);
+    return rrealloc_tagged(element, size, RMEMORY_SUBSYSTEM_OTHER);
+}
+
+void * rrealloc_tagged(void* element, unsigned int size, rmemory_subsystem subsystem) {
+    if (element == NULL) {
+        return rmalloc_tagged(size, subsystem);
+    }
+
+    union rmemory_header * header = (union rmemory_header *) element - 1;
+    if (header->info.size_class < RMEMORY_CLASS_COUNT &&
+        size <= (unsigned int) RMEMORY_MIN_CLASS_SIZE << header->info.size_class) {
+        // the block is large enough
+#ifdef ENABLE_MEMORY_ACCOUNTING
+        if (size > header->info.size) {
+            account_live(header->info.subsystem, size - header->info.size);
+        } else {
+            atomic_fetch_sub_explicit(&subsystem_counters[header->info.subsystem].live_bytes, header->info.size - size,
+                                      memory_order_relaxed);
+        }
+#endif
+        header->info.size = size;
+        return element;
+    }
+
+    void * result = rmalloc_tagged(size, subsystem);
+    if (result == NULL) {
+        return NULL;
+    }
+    memcpy(result, element, header->info.size < size ? header->info.size : size);
+    rfree(element);
+
+    return result;
 }
 
 void rfree(void * element) {
-    free(element);
+    if (element == NULL) {
+        return;
+    }
+
+    union rmemory_header * header = (union rmemory_header *) element - 1;
+    atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    atomic_fetch_add_explicit(&subsystem_counters[header->info.subsystem].frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&subsystem_counters[header->info.subsystem].live_bytes, header->info.size,
+                              memory_order_relaxed);
+#endif
+
+    unsigned int size_class = header->info.size_class;
+#ifdef ENABLE_MEMORY_POOL
+    if (size_class < RMEMORY_CLASS_COUNT) {
+        // the link to the next unused block overwrites the header
+        struct rmemory_free_block * block = (struct rmemory_free_block *) header;
+        block->next = free_lists[size_class];
+        free_lists[size_class] = block;
+        return;
+    }
+#endif
+
+    if (size_class == RMEMORY_MAPPED || size_class == RMEMORY_MAPPED_HUGE) {
+        unmap_placed(header, sizeof(union rmemory_header) + (size_t) header->info.size,
+                     size_class == RMEMORY_MAPPED_HUGE);
+        return;
+    }
+    system_free(header);
+}
+
+void rmemory_get_stats(struct rmemory_stats * stats) {
+    stats->allocations = atomic_load_explicit(&allocations, memory_order_relaxed);
+    stats->frees = atomic_load_explicit(&frees, memory_order_relaxed);
+    stats->system_allocations = atomic_load_explicit(&system_allocations, memory_order_relaxed);
+    stats->mapped_bytes = atomic_load_explicit(&mapped_bytes, memory_order_relaxed);
+    stats->huge_page_bytes = atomic_load_explicit(&huge_page_bytes, memory_order_relaxed);
+#ifdef USE_STATIC_MEMORY
+    while (atomic_flag_test_and_set_explicit(&static_lock, memory_order_acquire)) {
+    }
+    stats->static_bytes = static_used;
+    atomic_flag_clear_explicit(&static_lock, memory_order_release);
+#else
+    stats->static_bytes = 0;
+#endif
+    stats->sealed_system_allocations = atomic_load_explicit(&sealed, memory_order_acquire)
+        ? stats->system_allocations - atomic_load_explicit(&sealed_at, memory_order_relaxed) : 0;
+}
+
+void rmemory_seal(void) {
+    atomic_store_explicit(&sealed_at, atomic_load_explicit(&system_allocations, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(&sealed, 1, memory_order_release);
+}
+
+struct rmemory_placement rmemory_set_thread_placement(struct rmemory_placement placement) {
+    struct rmemory_placement previous = thread_placement;
+    if (placement.numa_node != previous.numa_node || placement.huge_pages != previous.huge_pages) {
+        // the rest of the chunk stays mapped, its slabs would be on the wrong node
+        chunk = NULL;
+        chunk_left = 0;
+    }
+    thread_placement = placement;
+    return previous;
+}
+
+int rmemory_cpu_node(int cpu) {
+    char path[64];
+    int node = -1;
+
+    if (cpu < 0) {
+        return -1;
+    }
+    // the directory of a CPU links to the directory of its node
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR * dir = opendir(path);
+    if (dir == NULL) {
+        return -1;
+    }
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (sscanf(entry->d_name, "node%d", &node) == 1) {
+            break;
+        }
+        node = -1;
+    }
+    closedir(dir);
+    return node;
+}
+
+int rmemory_get_subsystem_stats(rmemory_subsystem subsystem, struct rmemory_subsystem_stats * stats) {
+    memset(stats, 0, sizeof(*stats));
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    if ((unsigned int) subsystem >= RMEMORY_SUBSYSTEMS) {
+        return 0;
+    }
+    stats->allocations = atomic_load_explicit(&subsystem_counters[subsystem].allocations, memory_order_relaxed);
+    stats->frees = atomic_load_explicit(&subsystem_counters[subsystem].frees, memory_order_relaxed);
+    stats->bytes = atomic_load_explicit(&subsystem_counters[subsystem].bytes, memory_order_relaxed);
+    stats->live_bytes = atomic_load_explicit(&subsystem_counters[subsystem].live_bytes, memory_order_relaxed);
+    stats->peak_live_bytes = atomic_load_explicit(&subsystem_counters[subsystem].peak_live_bytes,
+                                                  memory_order_relaxed);
+    return 1;
+#else
+    (void) subsystem;
+    return 0;
+#endif
+}
+
+const char * rmemory_subsystem_name(rmemory_subsystem subsystem) {
+    switch (subsystem) {
+        case RMEMORY_SUBSYSTEM_CODEC:
+            return "codec";
+        case RMEMORY_SUBSYSTEM_FIFO:
+            return "fifo";
+        case RMEMORY_SUBSYSTEM_REDUNDANCY:
+            return "redundancy";
+        case RMEMORY_SUBSYSTEM_SR:
+            return "sr";
+        case RMEMORY_SUBSYSTEM_SCI:
+            return "sci";
+        case RMEMORY_SUBSYSTEM_LOGGING:
+            return "logging";
+        case RMEMORY_SUBSYSTEM_TRANSPORT:
+            return "transport";
+        default:
+            return "other";
+    }
 }
 
 void* rmemcpy(void *dest, const void *src, unsigned int n) {
@@ -37,4 +631,4 @@ void rstrcat(char * dest, const char * src){
 
 int rmemcmp(const  void * a, const void * b, unsigned int len) {
     return memcmp(a, b, len);
-}
\ No newline at end of file
+}
@@ -1,18 +1,63 @@
+#define _GNU_SOURCE // recvmmsg
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
 #include "udp.h"
 #include <stdio.h>
 #include <string.h> //memset
 #include <stdlib.h>
 #include <stdbool.h>
 #include <arpa/inet.h>
+#include <netinet/udp.h>
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
+#include <linux/filter.h>
 #include "rmemory.h"
+#include "udpimpairment.h"
+#include "udpshm.h"
+#include "udptcp.h"
+
+#ifdef ENABLE_IO_URING
+#include "udpuring.h"
+#endif
+
+#ifdef ENABLE_AF_XDP
+#include <sys/epoll.h>
+#include "udpxdp.h"
+#endif
 
 #ifdef ENABLE_TLS
+#include <sys/random.h>
+#include <poll.h>
 #include <wolfssl/options.h>
 #include <wolfssl/ssl.h>
+#include "rastasiphash24.h"
+#endif
+
+// room for a SCM_TIMESTAMPNS control message in the control buffer of a slot
+#define UDP_TIMESTAMP_CONTROL_SIZE CMSG_SPACE(sizeof(struct timespec))
+
+// room for the SO_RXQ_OVFL counter of the datagrams the kernel dropped because the receive buffer was full
+#define UDP_DROPS_CONTROL_SIZE CMSG_SPACE(sizeof(uint32_t))
+
+// the control buffer of a slot
+#define UDP_RECEIVE_CONTROL_SIZE (UDP_TIMESTAMP_CONTROL_SIZE + UDP_DROPS_CONTROL_SIZE)
+
+// the options of the UDP segmentation offloads, older C libraries do not define them
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
 #endif
 
+// room for the UDP_SEGMENT control message of a message that is cut into datagrams by the kernel
+#define UDP_SEGMENT_CONTROL_SIZE CMSG_SPACE(sizeof(uint16_t))
+
+// room for the receive timestamp, the drop counter and the UDP_GRO segment size of a coalesced datagram
+#define UDP_GRO_CONTROL_SIZE (UDP_RECEIVE_CONTROL_SIZE + CMSG_SPACE(sizeof(int)))
 
 struct sockaddr_in host_port_to_sockaddr(const char *host, uint16_t port) {
     struct sockaddr_in receiver;
@@ -56,23 +101,204 @@ static void handle_port_unavailable(const uint16_t port) {
     exit(1);
 }
 
-#ifdef ENABLE_TLS
+struct udp_transmit_queue {
+    unsigned char datagrams[UDP_TRANSMIT_QUEUE_SLOTS][UDP_TRANSMIT_SLOT_SIZE];
+    size_t lengths[UDP_TRANSMIT_QUEUE_SLOTS];
+    struct sockaddr_in receivers[UDP_TRANSMIT_QUEUE_SLOTS];
+    unsigned int head;
+    unsigned int count;
 
-static void
-get_client_addr_from_socket(const struct RastaUDPState *state, struct sockaddr_in *client_addr, socklen_t *addr_len) {
-    ssize_t received_bytes;
-    char buffer;
-    // wait for the first byte of the DTLS Client hello to identify the prospective client
-    received_bytes = recvfrom(state->file_descriptor, &buffer, sizeof(buffer), MSG_PEEK,
-                              (struct sockaddr *) client_addr, addr_len);
+    uint64_t queued;
+    uint64_t drops;
+};
 
-    if (received_bytes < 0) {
-        perror("No clients waiting to connect");
-        exit(1);
+/**
+ * @return 1 if the datagram after @p previous can be sent in the same UDP_SEGMENT message as the datagrams from
+ * @p first on. All segments but the last one of a message have the length of the first one
+ */
+static int gso_continues(size_t * message_lengths, struct sockaddr_in * receivers, unsigned int first,
+                         unsigned int previous, size_t total) {
+    unsigned int next = previous + 1;
+    return next - first < UDP_GSO_MAX_SEGMENTS && message_lengths[previous] == message_lengths[first] &&
+           message_lengths[next] <= message_lengths[first] && total + message_lengths[next] <= UDP_GSO_MAX_BYTES &&
+           receivers[next].sin_addr.s_addr == receivers[first].sin_addr.s_addr &&
+           receivers[next].sin_port == receivers[first].sin_port;
+}
+
+/**
+ * hands datagrams to the kernel with as few sendmmsg() calls as possible, without blocking. With UDP_SEGMENT, the
+ * consecutive datagrams of equal length to the same receiver are put into one message
+ * @return the amount of datagrams that were sent, the datagrams from there on did not fit into the socket buffer
+ */
+static unsigned int send_datagrams_now(struct RastaUDPState * state, unsigned char ** messages,
+                                       size_t * message_lengths, struct sockaddr_in * receivers, unsigned int count) {
+    struct mmsghdr headers[UDP_SEND_BATCH_SIZE];
+    struct iovec iovecs[UDP_SEND_BATCH_SIZE];
+    unsigned char controls[UDP_SEND_BATCH_SIZE][UDP_SEGMENT_CONTROL_SIZE];
+    unsigned int segments[UDP_SEND_BATCH_SIZE];
+
+    // the headers live on the stack, larger batches are sent in chunks
+    for (unsigned int offset = 0; offset < count; offset += UDP_SEND_BATCH_SIZE) {
+        unsigned int chunk = count - offset < UDP_SEND_BATCH_SIZE ? count - offset : UDP_SEND_BATCH_SIZE;
+
+        rmemset(headers, 0, sizeof(headers));
+        unsigned int header_count = 0;
+        for (unsigned int i = 0; i < chunk; i++) {
+            iovecs[i].iov_base = messages[offset + i];
+            iovecs[i].iov_len = message_lengths[offset + i];
+        }
+        for (unsigned int i = 0; i < chunk; i += segments[header_count++]) {
+            unsigned int first = offset + i;
+            unsigned int last = first;
+            size_t total = message_lengths[first];
+            while (state->gso && last + 1 < offset + chunk &&
+                   gso_continues(message_lengths, receivers, first, last, total)) {
+                last++;
+                total += message_lengths[last];
+            }
+            segments[header_count] = last - first + 1;
+
+            struct msghdr * header = &headers[header_count].msg_hdr;
+            header->msg_iov = &iovecs[i];
+            header->msg_iovlen = segments[header_count];
+            header->msg_name = &receivers[first];
+            header->msg_namelen = sizeof(struct sockaddr_in);
+            if (segments[header_count] > 1) {
+                header->msg_control = controls[header_count];
+                header->msg_controllen = UDP_SEGMENT_CONTROL_SIZE;
+                struct cmsghdr * control = CMSG_FIRSTHDR(header);
+                control->cmsg_level = SOL_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t segment_size = (uint16_t) message_lengths[first];
+                rmemcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+            }
+        }
+
+        // sendmmsg may send less messages than requested, continue with the remaining ones
+        unsigned int sent = 0;
+        unsigned int sent_datagrams = 0;
+        while (sent < header_count) {
+            int result = sendmmsg(state->file_descriptor, headers + sent, header_count - sent, MSG_DONTWAIT);
+            if (result == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                    return offset + sent_datagrams;
+                }
+                if (segments[sent] > 1 && (errno == EIO || errno == EINVAL)) {
+                    // e.g. the route goes through IPsec, the remaining datagrams are sent one by one
+                    fprintf(stderr, "UDP_SEGMENT can not be used on the udp socket, sending the datagrams separately\n");
+                    state->gso = 0;
+                    unsigned int done = offset + sent_datagrams;
+                    return done + send_datagrams_now(state, messages + done, message_lengths + done, receivers + done,
+                                                     count - done);
+                }
+                perror("failed to send data");
+                exit(1);
+            }
+            for (int j = 0; j < result; j++) {
+                sent_datagrams += segments[sent + j];
+            }
+            sent += (unsigned int) result;
+        }
+    }
+    return count;
+}
+
+/**
+ * appends a datagram to the transmit queue of a socket or drops it if there is no room
+ */
+static void transmit_queue_push(struct RastaUDPState * state, const unsigned char * message, size_t message_length,
+                                const struct sockaddr_in * receiver) {
+    if (state->transmit_queue == NULL) {
+        state->transmit_queue = rmalloc(sizeof(struct udp_transmit_queue));
+        rmemset(state->transmit_queue, 0, sizeof(struct udp_transmit_queue));
+    }
+    struct udp_transmit_queue * queue = state->transmit_queue;
+
+    // like a datagram that is lost on the way, the retransmissions and the other transport channels cover it
+    if (queue->count == UDP_TRANSMIT_QUEUE_SLOTS || message_length > UDP_TRANSMIT_SLOT_SIZE) {
+        queue->drops++;
+        return;
+    }
+
+    unsigned int slot = (queue->head + queue->count) % UDP_TRANSMIT_QUEUE_SLOTS;
+    rmemcpy(queue->datagrams[slot], message, message_length);
+    queue->lengths[slot] = message_length;
+    queue->receivers[slot] = *receiver;
+    queue->count++;
+    queue->queued++;
+}
+
+/**
+ * sends datagrams on the socket without blocking. The datagrams that the socket does not take right away and all
+ * datagrams while others are waiting are put into the transmit queue, so the order is kept
+ */
+static void send_datagrams(struct RastaUDPState * state, unsigned char ** messages, size_t * message_lengths,
+                           struct sockaddr_in * receivers, unsigned int count) {
+    unsigned int sent = 0;
+    if (udp_transmit_pending(state) == 0) {
+        sent = send_datagrams_now(state, messages, message_lengths, receivers, count);
+    }
+    for (unsigned int i = sent; i < count; i++) {
+        transmit_queue_push(state, messages[i], message_lengths[i], &receivers[i]);
+    }
+}
+
+unsigned int udp_transmit_flush(struct RastaUDPState * state) {
+    struct udp_transmit_queue * queue = state->transmit_queue;
+    if (queue == NULL) {
+        return 0;
+    }
+
+    unsigned char * messages[UDP_SEND_BATCH_SIZE];
+    while (queue->count > 0) {
+        // the slots up to the end of the ring, the ones behind the wrap follow with the next chunk
+        unsigned int chunk = UDP_TRANSMIT_QUEUE_SLOTS - queue->head;
+        if (chunk > queue->count) {
+            chunk = queue->count;
+        }
+        if (chunk > UDP_SEND_BATCH_SIZE) {
+            chunk = UDP_SEND_BATCH_SIZE;
+        }
+        for (unsigned int i = 0; i < chunk; i++) {
+            messages[i] = queue->datagrams[queue->head + i];
+        }
+
+        unsigned int sent = send_datagrams_now(state, messages, queue->lengths + queue->head,
+                                               queue->receivers + queue->head, chunk);
+        queue->head = (queue->head + sent) % UDP_TRANSMIT_QUEUE_SLOTS;
+        queue->count -= sent;
+        if (sent < chunk) {
+            break;
+        }
     }
+    return queue->count;
+}
+
+unsigned int udp_transmit_pending(struct RastaUDPState * state) {
+    return state->transmit_queue != NULL ? state->transmit_queue->count : 0;
+}
 
+void udp_transmit_stats(struct RastaUDPState * state, struct RastaUDPTransmitStats * out) {
+    rmemset(out, 0, sizeof(*out));
+    if (state->transmit_queue != NULL) {
+        out->depth = state->transmit_queue->count;
+        out->queued = state->transmit_queue->queued;
+        out->drops = state->transmit_queue->drops;
+    }
 }
 
+#ifdef ENABLE_TLS
+
+// the largest payload of a UDP datagram
+#define UDP_MAX_DATAGRAM_SIZE 65507
+
+// room for a record in a RastaDTLSSendBatch, larger records are sent on their own
+#define UDP_DTLS_SEND_SLOT_SIZE 2048
+
 static void wolfssl_initialize_if_necessary(){
     static bool wolfssl_initialized = false;
     if(!wolfssl_initialized){
@@ -81,6 +307,194 @@ static void wolfssl_initialize_if_necessary(){
     }
 }
 
+/**
+ * the DTLS session with a single peer. The sockets are never connected, udp.c receives and sends the datagrams itself
+ * and exchanges them with WolfSSL through the IO callbacks, so they can be batched like plain datagrams
+ */
+struct RastaDTLSPeer {
+    struct RastaUDPState *state;
+    struct sockaddr_in address;
+    /**
+     * the key of address, see sockaddr_to_endpoint()
+     */
+    uint64_t endpoint;
+    WOLFSSL *ssl;
+    enum RastaTLSConnectionState tls_state;
+    /**
+     * the received datagram that WolfSSL has not read yet
+     */
+    const unsigned char *pending;
+    int pending_length;
+};
+
+struct RastaDTLSSendBatch {
+    unsigned char records[UDP_SEND_BATCH_SIZE][UDP_DTLS_SEND_SLOT_SIZE];
+    size_t lengths[UDP_SEND_BATCH_SIZE];
+    struct sockaddr_in receivers[UDP_SEND_BATCH_SIZE];
+    unsigned int count;
+};
+
+static void dtls_send_batch_flush(struct RastaUDPState *state) {
+    struct RastaDTLSSendBatch *batch = state->dtls_send_batch;
+    unsigned char *records[UDP_SEND_BATCH_SIZE];
+    for (unsigned int i = 0; i < batch->count; i++) {
+        records[i] = batch->records[i];
+    }
+    send_datagrams(state, records, batch->lengths, batch->receivers, batch->count);
+    batch->count = 0;
+}
+
+static int dtls_peer_io_receive(WOLFSSL *ssl, char *buf, int sz, void *ctx) {
+    (void) ssl;
+    struct RastaDTLSPeer *peer = ctx;
+    if (peer->pending_length == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    }
+    // a datagram is always read as a whole, like recvfrom() truncates it
+    int length = peer->pending_length < sz ? peer->pending_length : sz;
+    rmemcpy(buf, peer->pending, (size_t) length);
+    peer->pending_length = 0;
+    return length;
+}
+
+static int dtls_peer_io_send(WOLFSSL *ssl, char *buf, int sz, void *ctx) {
+    (void) ssl;
+    struct RastaDTLSPeer *peer = ctx;
+    struct RastaDTLSSendBatch *batch = peer->state->dtls_send_batch;
+
+    // handshake records are sent right away, the handshake waits for the answer
+    if (batch != NULL && peer->tls_state == RASTA_TLS_CONNECTION_ESTABLISHED && sz <= UDP_DTLS_SEND_SLOT_SIZE) {
+        if (batch->count == UDP_SEND_BATCH_SIZE) {
+            dtls_send_batch_flush(peer->state);
+        }
+        rmemcpy(batch->records[batch->count], buf, (size_t) sz);
+        batch->lengths[batch->count] = (size_t) sz;
+        batch->receivers[batch->count] = peer->address;
+        batch->count++;
+        return sz;
+    }
+
+    // a record of an established session waits in the transmit queue, only the handshake is told to retry
+    if (peer->tls_state == RASTA_TLS_CONNECTION_ESTABLISHED) {
+        unsigned char *record = (unsigned char *) buf;
+        size_t length = (size_t) sz;
+        send_datagrams(peer->state, &record, &length, &peer->address, 1);
+        return sz;
+    }
+
+    if (sendto(peer->state->file_descriptor, buf, (size_t) sz, 0, (struct sockaddr *) &peer->address,
+               sizeof(peer->address)) == -1) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? WOLFSSL_CBIO_ERR_WANT_WRITE : WOLFSSL_CBIO_ERR_GENERAL;
+    }
+    return sz;
+}
+
+/**
+ * derives the HelloVerifyRequest cookie from the address of the sender, so the server can verify it without keeping
+ * any state for senders that did not return it yet
+ */
+static int dtls_generate_cookie(WOLFSSL *ssl, unsigned char *buf, int sz, void *ctx) {
+    (void) ssl;
+    struct RastaDTLSPeer *peer = ctx;
+    unsigned char address[6];
+    unsigned char cookie[16];
+
+    rmemcpy(address, &peer->address.sin_addr.s_addr, 4);
+    rmemcpy(address + 4, &peer->address.sin_port, 2);
+    generateSiphash24(address, sizeof(address), peer->state->dtls_cookie_secret, 2, cookie);
+
+    int length = sz < (int) sizeof(cookie) ? sz : (int) sizeof(cookie);
+    rmemcpy(buf, cookie, (size_t) length);
+    return length;
+}
+
+static struct RastaDTLSPeer *dtls_peer_new(struct RastaUDPState *state) {
+    struct RastaDTLSPeer *peer = rmalloc(sizeof(struct RastaDTLSPeer));
+    rmemset(peer, 0, sizeof(struct RastaDTLSPeer));
+    peer->state = state;
+    peer->tls_state = RASTA_TLS_CONNECTION_READY;
+
+    peer->ssl = wolfSSL_new(state->ctx);
+    if(!peer->ssl){
+        fprintf(stderr, "Error allocating WolfSSL object.\n");
+        exit(1);
+    }
+    wolfSSL_SetIOReadCtx(peer->ssl, peer);
+    wolfSSL_SetIOWriteCtx(peer->ssl, peer);
+    wolfSSL_SetCookieCtx(peer->ssl, peer);
+    // the IO callbacks never block, missing data is reported as a read error that can be retried
+    wolfSSL_dtls_set_using_nonblock(peer->ssl, 1);
+    return peer;
+}
+
+/**
+ * @param notify if a close_notify is sent to the peer, which resumes the session with its next handshake
+ */
+static void dtls_peer_free(struct RastaDTLSPeer *peer, bool notify) {
+    if (notify && peer->tls_state == RASTA_TLS_CONNECTION_ESTABLISHED) {
+        wolfSSL_shutdown(peer->ssl);
+    }
+    wolfSSL_free(peer->ssl);
+    rfree(peer);
+}
+
+static struct RastaDTLSPeer *dtls_peer_find(const struct RastaUDPState *state, uint64_t endpoint) {
+    for (unsigned int i = 0; i < state->dtls_peer_count; i++) {
+        if (state->dtls_peers[i]->endpoint == endpoint) {
+            return state->dtls_peers[i];
+        }
+    }
+    return NULL;
+}
+
+static void dtls_peer_remove(struct RastaUDPState *state, struct RastaDTLSPeer *peer) {
+    for (unsigned int i = 0; i < state->dtls_peer_count; i++) {
+        if (state->dtls_peers[i] == peer) {
+            // the table is unordered, the last peer takes the free slot
+            state->dtls_peers[i] = state->dtls_peers[--state->dtls_peer_count];
+            break;
+        }
+    }
+    dtls_peer_free(peer, false);
+}
+
+/**
+ * hands a datagram to a session and decrypts all records in it. @p out may be the datagram itself, the IO callback
+ * copies it before any plaintext is written
+ * @param error the WolfSSL error is written in here, 0 if the session can go on
+ * @return the length of the plaintext written to @p out
+ */
+static size_t dtls_peer_read(struct RastaDTLSPeer *peer, const unsigned char *datagram, size_t length,
+                             unsigned char *out, size_t max_out, int *error) {
+    size_t received_total = 0;
+    int receive_len;
+
+    peer->pending = datagram;
+    peer->pending_length = (int) length;
+    do{
+        receive_len = wolfSSL_read(peer->ssl, out + received_total, (int) (max_out - received_total));
+        if(receive_len <= 0){
+            break;
+        }
+        received_total += (size_t) receive_len;
+    }while(received_total < max_out);
+    peer->pending_length = 0;
+
+    *error = receive_len > 0 ? 0 : wolfSSL_get_error(peer->ssl, receive_len);
+    if (*error == SSL_ERROR_WANT_READ || *error == SSL_ERROR_WANT_WRITE) {
+        *error = 0;
+    }
+    return received_total;
+}
+
+/**
+ * @return if the datagram starts with a ClientHello of a new handshake: a handshake record (22) of epoch 0 whose
+ * handshake message has type 1
+ */
+static bool dtls_is_client_hello(const unsigned char *record, size_t length) {
+    return length > 13 && record[0] == 22 && record[3] == 0 && record[4] == 0 && record[13] == 1;
+}
+
 static void wolfssl_start_dtls_server(struct RastaUDPState *state, const struct RastaConfigTLS *tls_config){
     int err;
     wolfssl_initialize_if_necessary();
@@ -113,14 +527,21 @@ static void wolfssl_start_dtls_server(struct RastaUDPState *state, const struct
         printf("Error loading server private key file %s as PEM file: %d.\n", tls_config->key_path,err);
         exit(1);
     }
-    state->ssl = wolfSSL_new(state->ctx);
-    if(!state->ssl){
-        fprintf(stderr, "Error allocating WolfSSL object.\n");
+
+    wolfSSL_CTX_SetIORecv(state->ctx, dtls_peer_io_receive);
+    wolfSSL_CTX_SetIOSend(state->ctx, dtls_peer_io_send);
+    wolfSSL_CTX_SetGenCookie(state->ctx, dtls_generate_cookie);
+    if (getrandom(state->dtls_cookie_secret, sizeof(state->dtls_cookie_secret), 0) !=
+        (ssize_t) sizeof(state->dtls_cookie_secret)) {
+        perror("Could not generate the DTLS cookie secret");
         exit(1);
     }
 
-    wolfSSL_set_fd(state->ssl,state->file_descriptor);
-    state->tls_state = RASTA_TLS_CONNECTION_READY;
+    state->dtls_client = NULL;
+    state->dtls_send_batch = NULL;
+    state->dtls_peers = rmalloc(UDP_DTLS_MAX_PEERS * sizeof(struct RastaDTLSPeer *));
+    state->dtls_peer_count = 0;
+    state->dtls_listener = dtls_peer_new(state);
     state->tls_config = tls_config;
 
 }
@@ -138,34 +559,22 @@ static void set_dtls_async(struct RastaUDPState *state) {
         perror("Error setting socket non-blocking");
         exit(1);
     }
-
-    // inform wolfssl to expect read / write errors due to non-blocking nature of socket
-    wolfSSL_dtls_set_using_nonblock(state->ssl,1);
 }
 
-static void wolfssl_accept(struct RastaUDPState *state) {
-    struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-
-    // need to open UDP "connection" and accept client before the remaining methods (send / receive) work as expected by RaSTA
+static struct RastaDTLSPeer *wolfssl_new_client_session(struct RastaUDPState *state) {
+    struct RastaDTLSPeer *peer = dtls_peer_new(state);
 
-    get_client_addr_from_socket(state, &client_addr, &addr_len);
-    // we have received a client hello and can now accept the connection
-
-    if(connect(state->file_descriptor,(struct sockaddr *) &client_addr,sizeof(client_addr)) != 0){
-        perror("Could not connect to client");
-        exit(1);
+    if(state->tls_config->tls_hostname[0]) {
+        wolfSSL_check_domain_name(peer->ssl, state->tls_config->tls_hostname);
     }
-
-    if (wolfSSL_accept(state->ssl) != SSL_SUCCESS) {
-
-        int e = wolfSSL_get_error(state->ssl, 0);
-
-        fprintf(stderr,"WolfSSL could not accept connection: %s\n", wolfSSL_ERR_reason_error_string(e));
-        exit(1);
+    else{
+        fprintf(stderr, "No TLS hostname specified. Will accept ANY valid TLS certificate. Double-check configuration file.");
     }
-    set_dtls_async(state);
-
+#ifdef HAVE_SESSION_TICKET
+    // the ticket lets a reconnect resume the session without a full handshake
+    wolfSSL_UseSessionTicket(peer->ssl);
+#endif
+    return peer;
 }
 
 static void wolfssl_start_dtls_client(struct RastaUDPState *state, const struct RastaConfigTLS *tls_config){
@@ -188,83 +597,259 @@ static void wolfssl_start_dtls_client(struct RastaUDPState *state, const struct
         fprintf(stderr, "Error loading CA certificate file %s\n", tls_config->ca_cert_path);
         exit(1);
     }
-    state->ssl = wolfSSL_new(state->ctx);
-    if(!state->ssl){
-        const char *error_str = wolfSSL_ERR_reason_error_string(wolfSSL_get_error(state->ssl,0));
-        fprintf(stderr, "Error allocating WolfSSL session: %s.\n",error_str);
+    wolfSSL_CTX_SetIORecv(state->ctx, dtls_peer_io_receive);
+    wolfSSL_CTX_SetIOSend(state->ctx, dtls_peer_io_send);
+
+    state->dtls_send_batch = NULL;
+    state->dtls_peers = NULL;
+    state->dtls_peer_count = 0;
+    state->dtls_listener = NULL;
+    state->dtls_client = wolfssl_new_client_session(state);
+}
+
+/**
+ * runs the handshake of a client with the server at @p receiver. It blocks like the connect() of a stream socket, the
+ * answers of the server are received here and the flights are repeated when WolfSSL's timeout expires
+ */
+static void wolfssl_connect_dtls_client(struct RastaUDPState *state, const struct sockaddr_in *receiver) {
+    struct RastaDTLSPeer *peer = state->dtls_client;
+    unsigned char datagram[UDP_MAX_DATAGRAM_SIZE];
+    int result;
+
+    peer->address = *receiver;
+    peer->endpoint = sockaddr_to_endpoint(receiver);
+
+    while ((result = wolfSSL_connect(peer->ssl)) != SSL_SUCCESS) {
+        peer->pending_length = 0;
+        int connect_error = wolfSSL_get_error(peer->ssl, result);
+        if (connect_error != SSL_ERROR_WANT_READ && connect_error != SSL_ERROR_WANT_WRITE) {
+            fprintf(stderr,"WolfSSL connect error: %s\n", wolfSSL_ERR_reason_error_string(connect_error));
+            exit(1);
+        }
+
+        struct pollfd readable = {.fd = state->file_descriptor, .events = POLLIN};
+        int ready = poll(&readable, 1, wolfSSL_dtls_get_current_timeout(peer->ssl) * 1000);
+        if (ready < 0 && errno != EINTR) {
+            perror("Error waiting for the DTLS handshake");
+            exit(1);
+        }
+        if (ready == 0) {
+            if (wolfSSL_dtls_got_timeout(peer->ssl) != SSL_SUCCESS) {
+                fprintf(stderr, "WolfSSL connect error: the server did not answer\n");
+                exit(1);
+            }
+            continue;
+        }
+        if (ready < 0) {
+            continue;
+        }
+
+        struct sockaddr_in sender;
+        socklen_t sender_size = sizeof(sender);
+        ssize_t datagram_len = recvfrom(state->file_descriptor, datagram, sizeof(datagram), 0,
+                                        (struct sockaddr *) &sender, &sender_size);
+        if (datagram_len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            perror("an error occured while trying to receive data");
+            exit(1);
+        }
+        if (sockaddr_to_endpoint(&sender) == peer->endpoint) {
+            peer->pending = datagram;
+            peer->pending_length = (int) datagram_len;
+        }
+    }
+    peer->pending_length = 0;
+    peer->tls_state = RASTA_TLS_CONNECTION_ESTABLISHED;
+    set_dtls_async(state);
+}
+
+/**
+ * replaces the session of a client after the server closed it. The next send starts a handshake that resumes the old
+ * session if the server still knows it
+ */
+static void wolfssl_resume_dtls_client(struct RastaUDPState *state) {
+    struct RastaDTLSPeer *peer = wolfssl_new_client_session(state);
+    wolfSSL_set_session(peer->ssl, wolfSSL_get_session(state->dtls_client->ssl));
+    dtls_peer_free(state->dtls_client, false);
+    state->dtls_client = peer;
+}
+
+static size_t dtls_client_process(struct RastaUDPState *state, const unsigned char *datagram, size_t length,
+                                  const struct sockaddr_in *sender, unsigned char *out, size_t max_out) {
+    struct RastaDTLSPeer *peer = state->dtls_client;
+    if (peer->tls_state != RASTA_TLS_CONNECTION_ESTABLISHED || sockaddr_to_endpoint(sender) != peer->endpoint) {
+        // nothing can be decrypted before the next send started the handshake
+        return 0;
+    }
+
+    int error;
+    size_t received_total = dtls_peer_read(peer, datagram, length, out, max_out, &error);
+    if (error == SSL_ERROR_ZERO_RETURN) {
+        wolfssl_resume_dtls_client(state);
+    } else if (error != 0) {
+        fprintf(stderr, "WolfSSL decryption failed: %s.\n", wolfSSL_ERR_reason_error_string(error));
         exit(1);
     }
+    return received_total;
+}
+
+static size_t dtls_server_process(struct RastaUDPState *state, const unsigned char *datagram, size_t length,
+                                  const struct sockaddr_in *sender, unsigned char *out, size_t max_out) {
+    uint64_t endpoint = sockaddr_to_endpoint(sender);
+    struct RastaDTLSPeer *peer = dtls_peer_find(state, endpoint);
+    if (peer != NULL && peer->tls_state == RASTA_TLS_CONNECTION_ESTABLISHED && dtls_is_client_hello(datagram, length)) {
+        // the peer lost its session, e.g. because it was restarted, and starts over with the cookie exchange
+        dtls_peer_remove(state, peer);
+        peer = NULL;
+    }
 
-    if(state->tls_config->tls_hostname[0]) {
-        wolfSSL_check_domain_name(state->ssl, state->tls_config->tls_hostname);
+    if (peer == NULL) {
+        peer = state->dtls_listener;
+        peer->address = *sender;
+        peer->endpoint = endpoint;
+        peer->pending = datagram;
+        peer->pending_length = (int) length;
+
+        // answers with a HelloVerifyRequest until the ClientHello carries the cookie of the sender
+        int accepted = wolfDTLS_accept_stateless(peer->ssl);
+        peer->pending_length = 0;
+        if (accepted != WOLFSSL_SUCCESS) {
+            return 0;
+        }
+
+        // the sender owns its address, the listener continues as its session
+        state->dtls_listener = dtls_peer_new(state);
+        if (state->dtls_peer_count == UDP_DTLS_MAX_PEERS) {
+            fprintf(stderr, "Too many DTLS peers, ignoring the handshake of a new one.\n");
+            dtls_peer_free(peer, false);
+            return 0;
+        }
+        state->dtls_peers[state->dtls_peer_count++] = peer;
+        // the ClientHello has been read already
+        datagram = NULL;
+        length = 0;
     }
-    else{
-        fprintf(stderr, "No TLS hostname specified. Will accept ANY valid TLS certificate. Double-check configuration file.");
+
+    int error;
+    size_t received_total = 0;
+    if (peer->tls_state == RASTA_TLS_CONNECTION_READY) {
+        peer->pending = datagram;
+        peer->pending_length = (int) length;
+        int result = wolfSSL_accept(peer->ssl);
+        peer->pending_length = 0;
+        if (result == SSL_SUCCESS) {
+            peer->tls_state = RASTA_TLS_CONNECTION_ESTABLISHED;
+            return 0;
+        }
+        error = wolfSSL_get_error(peer->ssl, result);
+        if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+            error = 0;
+        }
+    } else {
+        received_total = dtls_peer_read(peer, datagram, length, out, max_out, &error);
+    }
+
+    if (error == SSL_ERROR_ZERO_RETURN) {
+        // the peer closed its session
+        dtls_peer_remove(state, peer);
+    } else if (error != 0) {
+        // a single peer does not take down the sessions of the others
+        fprintf(stderr, "WolfSSL session of a peer failed: %s.\n", wolfSSL_ERR_reason_error_string(error));
+        dtls_peer_remove(state, peer);
     }
+    return received_total;
+}
 
-    wolfSSL_set_fd(state->ssl,state->file_descriptor);
-    state->tls_state = RASTA_TLS_CONNECTION_READY;
+/**
+ * hands a received datagram to the session of its sender
+ * @return the length of the plaintext written to @p out, 0 if the datagram only carried handshake records
+ */
+static size_t dtls_process(struct RastaUDPState *state, const unsigned char *datagram, size_t length,
+                           const struct sockaddr_in *sender, unsigned char *out, size_t max_out) {
+    if (state->dtls_peers != NULL) {
+        return dtls_server_process(state, datagram, length, sender, out, max_out);
+    }
+    return dtls_client_process(state, datagram, length, sender, out, max_out);
 }
 
 static size_t wolfssl_receive_dtls(struct RastaUDPState * state, unsigned char *received_message, size_t max_buffer_len, struct sockaddr_in *sender){
-    int receive_len, received_total = 0;
+    unsigned char datagram[UDP_MAX_DATAGRAM_SIZE];
     socklen_t sender_size = sizeof(*sender);
-
-    get_client_addr_from_socket(state,sender,&sender_size);
-
-    if(state -> tls_state == RASTA_TLS_CONNECTION_READY){
-        wolfssl_accept(state);
-        state->tls_state = RASTA_TLS_CONNECTION_ESTABLISHED;
-        return 0;
+    ssize_t datagram_len = recvfrom(state->file_descriptor, datagram, sizeof(datagram), 0, (struct sockaddr *) sender,
+                                    &sender_size);
+    if (datagram_len < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        perror("an error occured while trying to receive data");
+        exit(1);
     }
-    if(state->tls_state == RASTA_TLS_CONNECTION_ESTABLISHED) {
-        // read as many bytes as available at this time
-        do{
-            receive_len = wolfSSL_read(state->ssl, received_message, (int) max_buffer_len);
-            if(receive_len < 0){
-                break;
-            }
-            received_message += receive_len;
-            max_buffer_len -= receive_len;
-            received_total += receive_len;
-        }while(receive_len > 0 && max_buffer_len);
-
-        if (receive_len < 0) {
-            int readErr = wolfSSL_get_error(state->ssl, 0);
-            if (readErr != SSL_ERROR_WANT_READ && readErr != SSL_ERROR_WANT_WRITE) {
-                fprintf(stderr, "WolfSSL decryption failed: %s.\n", wolfSSL_ERR_reason_error_string(readErr));
-                exit(1);
-            }
+    return dtls_process(state, datagram, (size_t) datagram_len, sender, received_message, max_buffer_len);
+}
+
+/**
+ * decrypts the datagrams of a batch in place. Datagrams without plaintext are left out by moving the following ones
+ * to the front, only the slots before the current one are overwritten
+ * @return the amount of slots with plaintext
+ */
+static unsigned int wolfssl_receive_dtls_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch,
+                                               unsigned int received) {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < received; i++) {
+        size_t length = dtls_process(state, batch->buffers + i * batch->slot_size, batch->messages[i].msg_len,
+                                     &batch->senders[i], batch->buffers + count * batch->slot_size,
+                                     batch->buffer_size);
+        if (length > 0) {
+            batch->senders[count] = batch->senders[i];
+            batch->timestamps[count] = batch->timestamps[i];
+            batch->messages[count].msg_len = (unsigned int) length;
+            count++;
         }
     }
-    return received_total;
+    return count;
 }
 
 static void wolfssl_send_tls(struct RastaUDPState * state, unsigned char *message, size_t message_len, struct sockaddr_in *receiver){
-    if(state->tls_state != RASTA_TLS_CONNECTION_ESTABLISHED){
-        wolfSSL_dtls_set_peer(state->ssl, receiver, sizeof(*receiver));
-
-        if (wolfSSL_connect(state->ssl) != SSL_SUCCESS) {
-            int connect_error = wolfSSL_get_error(state->ssl, 0);
-            fprintf(stderr,"WolfSSL connect error: %s\n", wolfSSL_ERR_reason_error_string(connect_error));
-            exit(1);
+    struct RastaDTLSPeer *peer;
+    if (state->dtls_peers != NULL) {
+        peer = dtls_peer_find(state, sockaddr_to_endpoint(receiver));
+        if (peer == NULL || peer->tls_state != RASTA_TLS_CONNECTION_ESTABLISHED) {
+            // a server cannot start a session, the message is lost like a datagram without a receiver
+            return;
+        }
+    } else {
+        peer = state->dtls_client;
+        if (peer->tls_state != RASTA_TLS_CONNECTION_ESTABLISHED) {
+            wolfssl_connect_dtls_client(state, receiver);
         }
-        state->tls_state = RASTA_TLS_CONNECTION_ESTABLISHED;
-        set_dtls_async(state);
     }
 
-    if(wolfSSL_write(state->ssl,message,(int) message_len) != (int) message_len){
+    if(wolfSSL_write(peer->ssl,message,(int) message_len) != (int) message_len){
         fprintf(stderr, "WolfSSL write error!");
-        exit(1);
+        if (state->dtls_peers == NULL) {
+            exit(1);
+        }
+        dtls_peer_remove(state, peer);
     }
 
 }
 
 static void wolfssl_cleanup(struct RastaUDPState *state){
-    state->tls_state = RASTA_TLS_CONNECTION_CLOSED;
-    wolfSSL_set_fd(state->ssl,0);
-    wolfSSL_shutdown(state->ssl);
-    wolfSSL_free(state->ssl);
+    if (state->dtls_peers != NULL) {
+        // the peers resume their sessions when the server is back
+        for (unsigned int i = 0; i < state->dtls_peer_count; i++) {
+            dtls_peer_free(state->dtls_peers[i], true);
+        }
+        dtls_peer_free(state->dtls_listener, false);
+        rfree(state->dtls_peers);
+        state->dtls_peers = NULL;
+        state->dtls_peer_count = 0;
+    } else {
+        dtls_peer_free(state->dtls_client, true);
+        state->dtls_client = NULL;
+    }
     wolfSSL_CTX_free(state->ctx);
 }
 
@@ -280,6 +865,12 @@ static void handle_tls_mode(struct RastaUDPState *state) {
     switch(tls_config->mode){
         case TLS_MODE_DISABLED:
             state->activeMode = TLS_MODE_DISABLED;
+#ifdef ENABLE_IO_URING
+            state->uring = udp_uring_create(state->file_descriptor, UDP_RECEIVE_CONTROL_SIZE);
+            if (state->uring == NULL) {
+                fprintf(stderr, "io_uring is not supported by the kernel, using recvmmsg instead\n");
+            }
+#endif
             break;
 #ifdef ENABLE_TLS
         case TLS_MODE_DTLS_1_2:
@@ -338,6 +929,33 @@ void udp_bind_device(struct RastaUDPState * state, uint16_t port, char * ip) {
 void udp_close(struct RastaUDPState * state) {
     int file_descriptor = state-> file_descriptor;
     if (file_descriptor >= 0) {
+        if (state->impairment != NULL) {
+            udp_impairment_destroy(state->impairment);
+            state->impairment = NULL;
+        }
+        if (state->shm != NULL) {
+            udp_shm_destroy(state->shm);
+            state->shm = NULL;
+        }
+        if (state->tcp != NULL) {
+            udp_tcp_destroy(state->tcp);
+            state->tcp = NULL;
+        }
+#ifdef ENABLE_AF_XDP
+        if (state->xdp != NULL) {
+            udp_xdp_destroy(state->xdp);
+            state->xdp = NULL;
+        }
+#endif
+        // the datagrams that are still waiting are lost like the ones in the socket buffer
+        rfree(state->transmit_queue);
+        state->transmit_queue = NULL;
+#ifdef ENABLE_IO_URING
+        if (state->uring != NULL) {
+            udp_uring_destroy(state->uring);
+            state->uring = NULL;
+        }
+#endif
 
 #ifdef ENABLE_TLS
         if(state->activeMode != TLS_MODE_DISABLED){
@@ -382,9 +1000,340 @@ size_t udp_receive(struct RastaUDPState * state, unsigned char *received_message
     return 0;
 }
 
+void udp_receive_batch_init(struct RastaUDPReceiveBatch * batch, unsigned int capacity, size_t buffer_size) {
+    batch->slot_size = buffer_size + UDP_DTLS_RECORD_OVERHEAD;
+    batch->buffers = rmalloc(capacity * batch->slot_size);
+    batch->buffer_size = buffer_size;
+    batch->capacity = capacity;
+    batch->messages = rmalloc(capacity * sizeof(struct mmsghdr));
+    batch->iovecs = rmalloc(capacity * sizeof(struct iovec));
+    batch->senders = rmalloc(capacity * sizeof(struct sockaddr_in));
+    batch->controls = rmalloc(capacity * UDP_RECEIVE_CONTROL_SIZE);
+    batch->timestamps = rmalloc(capacity * sizeof(uint64_t));
+    batch->count = 0;
+    batch->gro_buffers = NULL;
+    batch->gro_count = 0;
+    batch->gro_index = 0;
+    batch->gro_offset = 0;
+    batch->segments = NULL;
+    batch->segmented = 0;
+
+    // the slots never move, so the headers only have to be set up once
+    rmemset(batch->messages, 0, capacity * sizeof(struct mmsghdr));
+    for (unsigned int i = 0; i < capacity; i++) {
+        batch->iovecs[i].iov_base = batch->buffers + i * batch->slot_size;
+        batch->iovecs[i].iov_len = buffer_size;
+        batch->messages[i].msg_hdr.msg_iov = &batch->iovecs[i];
+        batch->messages[i].msg_hdr.msg_iovlen = 1;
+        batch->messages[i].msg_hdr.msg_name = &batch->senders[i];
+        batch->messages[i].msg_hdr.msg_control = batch->controls + i * UDP_RECEIVE_CONTROL_SIZE;
+    }
+}
+
+void udp_receive_batch_free(struct RastaUDPReceiveBatch * batch) {
+    rfree(batch->buffers);
+    rfree(batch->messages);
+    rfree(batch->iovecs);
+    rfree(batch->senders);
+    rfree(batch->controls);
+    rfree(batch->timestamps);
+    if (batch->gro_buffers != NULL) {
+        rfree(batch->gro_buffers);
+        rfree(batch->gro_messages);
+        rfree(batch->gro_iovecs);
+        rfree(batch->gro_senders);
+        rfree(batch->gro_controls);
+        batch->gro_buffers = NULL;
+    }
+    if (batch->segments != NULL) {
+        rfree(batch->segments);
+        rfree(batch->segment_lengths);
+        batch->segments = NULL;
+    }
+    batch->capacity = 0;
+    batch->count = 0;
+    batch->gro_count = 0;
+    batch->gro_index = 0;
+}
+
+/**
+ * allocates the segments of a batch, they point at the datagrams wherever they were received
+ */
+static void batch_init_segments(struct RastaUDPReceiveBatch * batch) {
+    if (batch->segments == NULL) {
+        batch->segments = rmalloc(batch->capacity * sizeof(unsigned char *));
+        batch->segment_lengths = rmalloc(batch->capacity * sizeof(size_t));
+    }
+}
+
+/**
+ * allocates the buffers of a batch for the coalesced datagrams of a socket with UDP_GRO
+ */
+static void gro_batch_init(struct RastaUDPReceiveBatch * batch) {
+    batch->gro_buffers = rmalloc(UDP_GRO_RECEIVE_BATCH_SIZE * UDP_GSO_MAX_BYTES);
+    batch->gro_messages = rmalloc(UDP_GRO_RECEIVE_BATCH_SIZE * sizeof(struct mmsghdr));
+    batch->gro_iovecs = rmalloc(UDP_GRO_RECEIVE_BATCH_SIZE * sizeof(struct iovec));
+    batch->gro_senders = rmalloc(UDP_GRO_RECEIVE_BATCH_SIZE * sizeof(struct sockaddr_in));
+    batch->gro_controls = rmalloc(UDP_GRO_RECEIVE_BATCH_SIZE * UDP_GRO_CONTROL_SIZE);
+    batch_init_segments(batch);
+
+    rmemset(batch->gro_messages, 0, UDP_GRO_RECEIVE_BATCH_SIZE * sizeof(struct mmsghdr));
+    for (unsigned int i = 0; i < UDP_GRO_RECEIVE_BATCH_SIZE; i++) {
+        batch->gro_iovecs[i].iov_base = batch->gro_buffers + i * UDP_GSO_MAX_BYTES;
+        batch->gro_messages[i].msg_hdr.msg_iov = &batch->gro_iovecs[i];
+        batch->gro_messages[i].msg_hdr.msg_iovlen = 1;
+        batch->gro_messages[i].msg_hdr.msg_name = &batch->gro_senders[i];
+        batch->gro_messages[i].msg_hdr.msg_control = batch->gro_controls + i * UDP_GRO_CONTROL_SIZE;
+    }
+}
+
+/**
+ * reads the SCM_TIMESTAMPNS and SO_RXQ_OVFL control messages of @p message. The kernel puts its drop counter into
+ * every datagram, the datagrams dropped since the last one are added to state->kernel_drops
+ * @return the time of the SCM_TIMESTAMPNS control message of @p message in nanoseconds, 0 if it has none
+ */
+static uint64_t read_receive_controls(struct RastaUDPState * state, struct msghdr * message) {
+    uint64_t timestamp = 0;
+    for (struct cmsghdr * control = CMSG_FIRSTHDR(message); control != NULL; control = CMSG_NXTHDR(message, control)) {
+        if (control->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (control->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec stamp;
+            rmemcpy(&stamp, CMSG_DATA(control), sizeof(stamp));
+            timestamp = (uint64_t) stamp.tv_sec * 1000000000ull + (uint64_t) stamp.tv_nsec;
+        }
+#ifdef SO_RXQ_OVFL
+        else if (control->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t overflow;
+            rmemcpy(&overflow, CMSG_DATA(control), sizeof(overflow));
+            // the counter of the kernel wraps around, the difference does not
+            state->kernel_drops += (uint32_t) (overflow - state->rxq_overflow);
+            state->rxq_overflow = overflow;
+        }
+#endif
+    }
+    return timestamp;
+}
+
+/**
+ * copies the datagrams of the shared memory rings into a batch and fills the rest of it from the socket, without
+ * waiting
+ * @return the amount of received datagrams, -1 if the socket failed
+ */
+static int shm_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch) {
+    int socket_readable;
+    unsigned int received = udp_shm_receive(state->shm, batch, &socket_readable);
+    if (!socket_readable || received == batch->capacity) {
+        return (int) received;
+    }
+
+    int from_socket = recvmmsg(state->file_descriptor, batch->messages + received, batch->capacity - received,
+                               MSG_DONTWAIT, NULL);
+    if (from_socket == -1) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? (int) received : -1;
+    }
+    return (int) received + from_socket;
+}
+
+/**
+ * @return the length of the segments of a datagram that UDP_GRO coalesced, 0 if the datagram was not coalesced
+ */
+static size_t read_gro_segment_size(struct msghdr * message) {
+    for (struct cmsghdr * control = CMSG_FIRSTHDR(message); control != NULL; control = CMSG_NXTHDR(message, control)) {
+        if (control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO) {
+            int segment_size;
+            rmemcpy(&segment_size, CMSG_DATA(control), sizeof(segment_size));
+            return segment_size > 0 ? (size_t) segment_size : 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * receives the coalesced datagrams of a socket with UDP_GRO and splits them into the slots of the batch. The segments
+ * that do not fit are kept for the next call, which does not receive from the socket then
+ * @return the amount of datagrams in the batch
+ */
+static unsigned int gro_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch) {
+    if (batch->gro_buffers == NULL) {
+        gro_batch_init(batch);
+    }
+
+    if (!udp_receive_batch_pending(batch)) {
+        for (unsigned int i = 0; i < UDP_GRO_RECEIVE_BATCH_SIZE; i++) {
+            batch->gro_messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            batch->gro_messages[i].msg_hdr.msg_controllen = UDP_GRO_CONTROL_SIZE;
+            batch->gro_iovecs[i].iov_len = UDP_GSO_MAX_BYTES;
+        }
+        int received = recvmmsg(state->file_descriptor, batch->gro_messages, UDP_GRO_RECEIVE_BATCH_SIZE,
+                                MSG_WAITFORONE, NULL);
+        if (received == -1) {
+            perror("an error occured while trying to receive data");
+            exit(1);
+        }
+        batch->gro_count = (unsigned int) received;
+        batch->gro_index = 0;
+        batch->gro_offset = 0;
+    }
+
+    unsigned int count = 0;
+    while (count < batch->capacity && udp_receive_batch_pending(batch)) {
+        struct mmsghdr * message = &batch->gro_messages[batch->gro_index];
+        size_t length = message->msg_len;
+        size_t segment_size = read_gro_segment_size(&message->msg_hdr);
+        size_t remaining = length - batch->gro_offset;
+        size_t segment = segment_size != 0 && segment_size < remaining ? segment_size : remaining;
+
+        batch->segments[count] = batch->gro_buffers + batch->gro_index * UDP_GSO_MAX_BYTES + batch->gro_offset;
+        batch->segment_lengths[count] = segment;
+        batch->senders[count] = batch->gro_senders[batch->gro_index];
+        batch->timestamps[count] = read_receive_controls(state, &message->msg_hdr);
+        count++;
+
+        batch->gro_offset += segment;
+        if (batch->gro_offset >= length) {
+            batch->gro_index++;
+            batch->gro_offset = 0;
+        }
+    }
+    batch->segmented = 1;
+    batch->count = count;
+    return count;
+}
+
+#ifdef ENABLE_AF_XDP
+/**
+ * hands the datagrams of the AF_XDP socket to a batch. The datagrams that the XDP program passed on to the UDP socket
+ * are received while the AF_XDP socket has none. Waits for the first datagram on either socket
+ * @return the amount of datagrams in the batch
+ */
+static unsigned int xdp_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch) {
+    batch_init_segments(batch);
+    batch->segmented = 1;
+
+    unsigned int count;
+    while ((count = udp_xdp_receive(state->xdp, batch)) == 0) {
+        for (unsigned int i = 0; i < batch->capacity; i++) {
+            batch->messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            batch->messages[i].msg_hdr.msg_controllen = UDP_RECEIVE_CONTROL_SIZE;
+            batch->iovecs[i].iov_len = batch->buffer_size;
+        }
+        int received = recvmmsg(state->file_descriptor, batch->messages, batch->capacity, MSG_DONTWAIT, NULL);
+        if (received > 0) {
+            for (int i = 0; i < received; i++) {
+                batch->segments[i] = batch->buffers + (size_t) i * batch->slot_size;
+                batch->segment_lengths[i] = batch->messages[i].msg_len;
+                batch->timestamps[i] = read_receive_controls(state, &batch->messages[i].msg_hdr);
+            }
+            count = (unsigned int) received;
+            break;
+        }
+        if (received == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            perror("an error occured while trying to receive data");
+            exit(1);
+        }
+        struct epoll_event event;
+        if (epoll_wait(udp_xdp_receive_fd(state->xdp), &event, 1, -1) == -1 && errno != EINTR) {
+            perror("an error occured while trying to receive data");
+            exit(1);
+        }
+    }
+    batch->count = count;
+    return count;
+}
+#endif
+
+/**
+ * copies the frames of the TCP streams into a batch, without waiting
+ * @return the amount of received datagrams
+ */
+static unsigned int tcp_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch) {
+    batch->segmented = 0;
+    batch->count = udp_tcp_receive(state->tcp, batch);
+    for (unsigned int i = 0; i < batch->count; i++) {
+        batch->timestamps[i] = 0;
+    }
+    return batch->count;
+}
+
+unsigned int udp_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch) {
+    if (state->tcp != NULL) {
+        return tcp_receive_batch(state, batch);
+    }
+#ifdef ENABLE_AF_XDP
+    if (state->xdp != NULL) {
+        return xdp_receive_batch(state, batch);
+    }
+#endif
+    if (state->gro) {
+        return gro_receive_batch(state, batch);
+    }
+    batch->segmented = 0;
+
+    // DTLS records are larger than their plaintext
+    size_t receive_size = state->activeMode == TLS_MODE_DISABLED ? batch->buffer_size : batch->slot_size;
+    for (unsigned int i = 0; i < batch->capacity; i++) {
+        // the kernel overwrites the address length with the length of the actual sender address
+        batch->messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        batch->messages[i].msg_hdr.msg_controllen = UDP_RECEIVE_CONTROL_SIZE;
+        batch->iovecs[i].iov_len = receive_size;
+    }
+
+    // wait for the first datagram, then take everything else that is already queued
+    int received;
+    if (state->shm != NULL) {
+        received = shm_receive_batch(state, batch);
+    }
+#ifdef ENABLE_IO_URING
+    else if (state->uring != NULL) {
+        // the kernel has already received the datagrams into the provided buffers
+        received = (int) udp_uring_receive(state->uring, batch);
+    }
+#endif
+    else {
+        received = recvmmsg(state->file_descriptor, batch->messages, batch->capacity, MSG_WAITFORONE, NULL);
+    }
+    if (received == -1) {
+        // the socket of a DTLS client is non-blocking
+        if (state->activeMode != TLS_MODE_DISABLED && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            batch->count = 0;
+            return 0;
+        }
+        perror("an error occured while trying to receive data");
+        exit(1);
+    }
+
+    batch->count = (unsigned int) received;
+    for (unsigned int i = 0; i < batch->count; i++) {
+        batch->timestamps[i] = read_receive_controls(state, &batch->messages[i].msg_hdr);
+    }
+#ifdef ENABLE_TLS
+    if (state->activeMode != TLS_MODE_DISABLED) {
+        batch->count = wolfssl_receive_dtls_batch(state, batch, batch->count);
+    }
+#endif
+    return batch->count;
+}
+
+unsigned char * udp_receive_batch_get(struct RastaUDPReceiveBatch * batch, unsigned int index, size_t * length,
+                                      struct sockaddr_in * sender) {
+    *sender = batch->senders[index];
+    if (batch->segmented) {
+        *length = batch->segment_lengths[index];
+        return batch->segments[index];
+    }
+    *length = batch->messages[index].msg_len;
+    return batch->buffers + index * batch->slot_size;
+}
+
+uint64_t udp_receive_batch_get_timestamp(struct RastaUDPReceiveBatch * batch, unsigned int index) {
+    return batch->timestamps[index];
+}
+
 void udp_send(struct RastaUDPState * state, unsigned char *message, size_t message_len, char *host, uint16_t port) {
     struct sockaddr_in receiver = host_port_to_sockaddr(host, port);
-    if(state->activeMode == TLS_MODE_DISABLED) {
+    if(state->activeMode == TLS_MODE_DISABLED || state->tcp != NULL) {
 
         // send the message using the other send function
         udp_send_sockaddr(state, message, message_len, receiver);
@@ -398,12 +1347,27 @@ void udp_send(struct RastaUDPState * state, unsigned char *message, size_t messa
 
 void udp_send_sockaddr(struct RastaUDPState * state, unsigned char *message, size_t message_len, struct sockaddr_in receiver)
         {
+    if (state->tcp != NULL) {
+        udp_tcp_push(state->tcp, message, message_len, &receiver);
+        udp_tcp_flush(state->tcp);
+        return;
+    }
     if(state->activeMode == TLS_MODE_DISABLED) {
-        if (sendto(state->file_descriptor, message, message_len, 0, (struct sockaddr *) &receiver, sizeof(receiver)) ==
-            -1) {
-            perror("failed to send data");
-            exit(1);
+        if (state->impairment != NULL) {
+            udp_impairment_send(state->impairment, message, message_len, &receiver);
+            return;
+        }
+        if (state->shm != NULL && udp_shm_push(state->shm, message, message_len, &receiver)) {
+            udp_shm_flush(state->shm);
+            return;
         }
+#ifdef ENABLE_AF_XDP
+        if (state->xdp != NULL && udp_xdp_push(state->xdp, message, message_len, &receiver)) {
+            udp_xdp_flush(state->xdp);
+            return;
+        }
+#endif
+        send_datagrams(state, &message, &message_len, &receiver, 1);
     }
 #ifdef ENABLE_TLS
     else{
@@ -414,11 +1378,133 @@ void udp_send_sockaddr(struct RastaUDPState * state, unsigned char *message, siz
 #endif
 }
 
+/**
+ * hands a datagram to the shared memory rings or the AF_XDP socket
+ * @return 1 if the datagram was taken, 0 if it has to be sent on the socket
+ */
+static int bypass_push(struct RastaUDPState * state, const unsigned char * message, size_t message_length,
+                       const struct sockaddr_in * receiver) {
+    if (state->shm != NULL) {
+        return udp_shm_push(state->shm, message, message_length, receiver);
+    }
+#ifdef ENABLE_AF_XDP
+    if (state->xdp != NULL) {
+        return udp_xdp_push(state->xdp, message, message_length, receiver);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * publishes the datagrams of the previous bypass_push() calls
+ */
+static void bypass_flush(struct RastaUDPState * state) {
+    if (state->shm != NULL) {
+        udp_shm_flush(state->shm);
+    }
+#ifdef ENABLE_AF_XDP
+    if (state->xdp != NULL) {
+        udp_xdp_flush(state->xdp);
+    }
+#endif
+}
+
+/**
+ * copies the datagrams to the peers on the same host into their shared memory rings or the datagrams to the known
+ * senders of the AF_XDP socket into its TX ring and sends the others on the socket
+ */
+static void bypass_send_batch(struct RastaUDPState * state, unsigned char ** messages, size_t * message_lengths,
+                              struct sockaddr_in * receivers, unsigned int count) {
+    unsigned char * remote_messages[UDP_SEND_BATCH_SIZE];
+    size_t remote_lengths[UDP_SEND_BATCH_SIZE];
+    struct sockaddr_in remote_receivers[UDP_SEND_BATCH_SIZE];
+    unsigned int remote_count = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (bypass_push(state, messages[i], message_lengths[i], &receivers[i])) {
+            continue;
+        }
+        remote_messages[remote_count] = messages[i];
+        remote_lengths[remote_count] = message_lengths[i];
+        remote_receivers[remote_count] = receivers[i];
+        remote_count++;
+        if (remote_count == UDP_SEND_BATCH_SIZE) {
+            send_datagrams(state, remote_messages, remote_lengths, remote_receivers, remote_count);
+            remote_count = 0;
+        }
+    }
+    bypass_flush(state);
+    if (remote_count > 0) {
+        send_datagrams(state, remote_messages, remote_lengths, remote_receivers, remote_count);
+    }
+}
+
+void udp_send_batch(struct RastaUDPState * state, unsigned char ** messages, size_t * message_lengths,
+                    struct sockaddr_in * receivers, unsigned int count) {
+    if (state->tcp != NULL) {
+        // the datagrams to a peer are sent with one write, the kernel or WolfSSL cuts them into records
+        for (unsigned int i = 0; i < count; i++) {
+            udp_tcp_push(state->tcp, messages[i], message_lengths[i], &receivers[i]);
+        }
+        udp_tcp_flush(state->tcp);
+        return;
+    }
+#ifdef ENABLE_TLS
+    if(state->activeMode != TLS_MODE_DISABLED) {
+        // the encrypted records are collected by dtls_peer_io_send() and sent together
+        struct RastaDTLSSendBatch records;
+        records.count = 0;
+        state->dtls_send_batch = &records;
+        for (unsigned int i = 0; i < count; i++) {
+            wolfssl_send_tls(state, messages[i], message_lengths[i], &receivers[i]);
+        }
+        dtls_send_batch_flush(state);
+        state->dtls_send_batch = NULL;
+        return;
+    }
+#endif
+    if(state->impairment != NULL) {
+        for (unsigned int i = 0; i < count; i++) {
+            udp_send_sockaddr(state, messages[i], message_lengths[i], receivers[i]);
+        }
+        return;
+    }
+
+    if (state->shm != NULL) {
+        bypass_send_batch(state, messages, message_lengths, receivers, count);
+        return;
+    }
+#ifdef ENABLE_AF_XDP
+    if (state->xdp != NULL) {
+        bypass_send_batch(state, messages, message_lengths, receivers, count);
+        return;
+    }
+#endif
+
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        udp_uring_send(state->uring, messages, message_lengths, receivers, count);
+        return;
+    }
+#endif
+    send_datagrams(state, messages, message_lengths, receivers, count);
+}
+
 void udp_init(struct RastaUDPState *state,const struct RastaConfigTLS *tls_config) {
     // the file descriptor of the socket
     int file_desc;
 
     state->tls_config = tls_config;
+    state->impairment = NULL;
+    state->uring = NULL;
+    state->shm = NULL;
+    state->xdp = NULL;
+    state->tcp = NULL;
+    state->transmit_queue = NULL;
+    state->gso = 0;
+    state->gro = 0;
+    state->rxq_overflow = 0;
+    state->kernel_drops = 0;
 
     // create a udp socket
     if ((file_desc=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1)
@@ -430,6 +1516,257 @@ void udp_init(struct RastaUDPState *state,const struct RastaConfigTLS *tls_confi
     state->file_descriptor = file_desc;
 }
 
+void udp_enable_reuseport(struct RastaUDPState * state) {
+    int enable = 1;
+    if (setsockopt(state->file_descriptor, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1) {
+        perror("could not set SO_REUSEPORT on the udp socket");
+    }
+}
+
+void udp_steer_reuseport(struct RastaUDPState * state, unsigned int group_size, unsigned int offset) {
+    // classic BPF loads words in network byte order, so the little endian value is put together byte by byte
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset + 3),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset + 2),
+        BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset + 1),
+        BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offset),
+        BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, group_size),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    struct sock_fprog program = { sizeof(code) / sizeof(code[0]), code };
+    if (setsockopt(state->file_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+        perror("could not attach the SO_REUSEPORT steering program to the udp socket");
+    }
+}
+
+void udp_enable_shm(struct RastaUDPState * state, const char * name) {
+    if (state->activeMode != TLS_MODE_DISABLED) {
+        fprintf(stderr, "shared memory transport channels are not used with DTLS\n");
+        return;
+    }
+    if (state->tcp != NULL) {
+        fprintf(stderr, "shared memory transport channels are not used with TCP\n");
+        return;
+    }
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        // the datagrams of the entities on other hosts are received with recvmmsg() next to the rings
+        udp_uring_destroy(state->uring);
+        state->uring = NULL;
+    }
+#endif
+    state->shm = udp_shm_create(state->file_descriptor, name);
+}
+
+void udp_enable_offload(struct RastaUDPState * state) {
+    if (state->activeMode != TLS_MODE_DISABLED) {
+        fprintf(stderr, "UDP segmentation offloads are not used with DTLS\n");
+        return;
+    }
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        // the io_uring backend hands the datagrams to the kernel one by one
+        udp_uring_destroy(state->uring);
+        state->uring = NULL;
+    }
+#endif
+
+    // a segment size of 0 only checks that the kernel knows UDP_SEGMENT, every message sets its own
+    int segment_size = 0;
+    if (setsockopt(state->file_descriptor, SOL_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) == -1) {
+        perror("could not set UDP_SEGMENT on the udp socket");
+    } else {
+        state->gso = 1;
+    }
+
+    // the rings are read into the slots of the batch, which do not hold coalesced datagrams
+    if (state->shm != NULL) {
+        return;
+    }
+    int enable = 1;
+    if (setsockopt(state->file_descriptor, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == -1) {
+        perror("could not set UDP_GRO on the udp socket");
+    } else {
+        state->gro = 1;
+    }
+}
+
+void udp_enable_xdp(struct RastaUDPState * state, const char * interface, unsigned int queue) {
+#ifdef ENABLE_AF_XDP
+    if (state->activeMode != TLS_MODE_DISABLED) {
+        fprintf(stderr, "AF_XDP is not used with DTLS\n");
+        return;
+    }
+    if (state->shm != NULL) {
+        fprintf(stderr, "AF_XDP is not used next to shared memory\n");
+        return;
+    }
+    if (state->tcp != NULL) {
+        fprintf(stderr, "AF_XDP is not used with TCP\n");
+        return;
+    }
+    state->xdp = udp_xdp_create(state->file_descriptor, interface, queue);
+    if (state->xdp == NULL) {
+        return;
+    }
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        // the datagrams the program passes on are received with recvmmsg() next to the AF_XDP socket
+        udp_uring_destroy(state->uring);
+        state->uring = NULL;
+    }
+#endif
+    if (state->gro) {
+        // the slots of the batch that the passed on datagrams are received into do not hold coalesced datagrams
+        int disable = 0;
+        if (setsockopt(state->file_descriptor, SOL_UDP, UDP_GRO, &disable, sizeof(disable)) == -1) {
+            perror("could not clear UDP_GRO on the udp socket");
+        }
+        state->gro = 0;
+    }
+#else
+    (void) state;
+    fprintf(stderr, "AF_XDP is not compiled in, %s queue %u uses the udp socket\n", interface, queue);
+#endif
+}
+
+void udp_enable_tcp(struct RastaUDPState * state, int tls) {
+#ifndef ENABLE_TLS
+    if (tls) {
+        // the datagrams are not sent unencrypted instead
+        fprintf(stderr, "TLS is not compiled in, the TLS transport channel can not be used\n");
+        exit(1);
+    }
+#endif
+    state->tcp = udp_tcp_create(state->file_descriptor, tls ? UDP_TCP_MODE_TLS : UDP_TCP_MODE_PLAIN, state->tls_config);
+    if (state->tcp == NULL) {
+        if (tls) {
+            exit(1);
+        }
+        return;
+    }
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        udp_uring_destroy(state->uring);
+        state->uring = NULL;
+    }
+#endif
+}
+
+int udp_receive_fd(struct RastaUDPState * state) {
+    if (state->tcp != NULL) {
+        return udp_tcp_receive_fd(state->tcp);
+    }
+    if (state->shm != NULL) {
+        return udp_shm_receive_fd(state->shm);
+    }
+#ifdef ENABLE_AF_XDP
+    if (state->xdp != NULL) {
+        return udp_xdp_receive_fd(state->xdp);
+    }
+#endif
+#ifdef ENABLE_IO_URING
+    if (state->uring != NULL) {
+        return udp_uring_start_receive(state->uring);
+    }
+#endif
+    return state->file_descriptor;
+}
+
+void udp_set_busy_poll(struct RastaUDPState * state, unsigned int busy_poll_us) {
+#ifdef SO_BUSY_POLL
+    int value = (int) busy_poll_us;
+    // values above net.core.busy_read need CAP_NET_ADMIN
+    if (setsockopt(state->file_descriptor, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) == -1) {
+        perror("could not set SO_BUSY_POLL on the udp socket");
+    }
+#else
+    (void) state;
+    (void) busy_poll_us;
+#endif
+}
+
+void udp_enable_receive_timestamps(struct RastaUDPState * state) {
+    // software stamps of the kernel, hardware stamps are in the clock of each NIC and not comparable between channels
+    int enable = 1;
+    if (setsockopt(state->file_descriptor, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == -1) {
+        perror("could not set SO_TIMESTAMPNS on the udp socket");
+    }
+}
+
+void udp_enable_drop_counter(struct RastaUDPState * state) {
+#ifdef SO_RXQ_OVFL
+    int enable = 1;
+    if (setsockopt(state->file_descriptor, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == -1) {
+        perror("could not set SO_RXQ_OVFL on the udp socket");
+    }
+#else
+    (void) state;
+#endif
+}
+
+/**
+ * sets one buffer size of a socket, the FORCE option ignores the limit of the sysctl but needs CAP_NET_ADMIN
+ * @return the size the kernel uses, it doubles the requested size for its bookkeeping
+ */
+static int set_buffer_size(int file_descriptor, int option, int force_option, unsigned int bytes) {
+    int value = (int) bytes;
+    if (setsockopt(file_descriptor, SOL_SOCKET, force_option, &value, sizeof(value)) == -1 &&
+        setsockopt(file_descriptor, SOL_SOCKET, option, &value, sizeof(value)) == -1) {
+        return -1;
+    }
+    int actual = 0;
+    socklen_t length = sizeof(actual);
+    if (getsockopt(file_descriptor, SOL_SOCKET, option, &actual, &length) == -1) {
+        return -1;
+    }
+    return actual;
+}
+
+void udp_set_buffer_sizes(struct RastaUDPState * state, unsigned int receive_bytes, unsigned int send_bytes) {
+    if (receive_bytes > 0) {
+        int actual = set_buffer_size(state->file_descriptor, SO_RCVBUF, SO_RCVBUFFORCE, receive_bytes);
+        if (actual == -1) {
+            perror("could not set SO_RCVBUF on the udp socket");
+        } else if ((unsigned int) actual < receive_bytes) {
+            fprintf(stderr, "the receive buffer of the udp socket is %d instead of %u bytes, raise net.core.rmem_max\n",
+                    actual / 2, receive_bytes);
+        }
+    }
+    if (send_bytes > 0) {
+        int actual = set_buffer_size(state->file_descriptor, SO_SNDBUF, SO_SNDBUFFORCE, send_bytes);
+        if (actual == -1) {
+            perror("could not set SO_SNDBUF on the udp socket");
+        } else if ((unsigned int) actual < send_bytes) {
+            fprintf(stderr, "the send buffer of the udp socket is %d instead of %u bytes, raise net.core.wmem_max\n",
+                    actual / 2, send_bytes);
+        }
+    }
+}
+
+void udp_buffer_stats(struct RastaUDPState * state, struct RastaUDPBufferStats * out) {
+    rmemset(out, 0, sizeof(*out));
+    int value;
+    socklen_t length = sizeof(value);
+    if (getsockopt(state->file_descriptor, SOL_SOCKET, SO_RCVBUF, &value, &length) == 0) {
+        out->receive_buffer = (unsigned int) value;
+    }
+    length = sizeof(value);
+    if (getsockopt(state->file_descriptor, SOL_SOCKET, SO_SNDBUF, &value, &length) == 0) {
+        out->send_buffer = (unsigned int) value;
+    }
+    out->kernel_drops = state->kernel_drops;
+}
+
 void sockaddr_to_host(struct sockaddr_in sockaddr, char* host){
     inet_ntop(AF_INET, &(sockaddr.sin_addr), host, IPV4_STR_LEN);
 }
@@ -0,0 +1,242 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
+#include "udpimpairment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include "rmemory.h"
+#include "event_system.h"
+
+/**
+ * splitmix64, small and fast enough for a decision per datagram
+ * @param state the state of the generator
+ * @return the next random number
+ */
+static uint64_t next_random(uint64_t * state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @param state the state of the generator
+ * @param percentage a percentage
+ * @return 1 with the probability @p percentage
+ */
+static int happens(uint64_t * state, double percentage) {
+    if (percentage <= 0) {
+        return 0;
+    }
+    return (double) (next_random(state) >> 11) * (100.0 / 9007199254740992.0) < percentage;
+}
+
+static void send_datagram(int file_descriptor, const unsigned char * message, size_t message_len,
+                          const struct sockaddr_in * receiver) {
+    if (sendto(file_descriptor, message, message_len, 0, (const struct sockaddr *) receiver,
+               sizeof(struct sockaddr_in)) == -1) {
+        perror("failed to send data");
+        exit(1);
+    }
+}
+
+static int datagram_before(const struct udp_impairment_datagram * a, const struct udp_impairment_datagram * b) {
+    return a->due < b->due || (a->due == b->due && a->order < b->order);
+}
+
+static void heap_push(struct udp_impairment * impairment, struct udp_impairment_datagram * datagram) {
+    unsigned int i = impairment->pending_count++;
+    while (i > 0) {
+        unsigned int parent = (i - 1) / 2;
+        if (!datagram_before(datagram, impairment->pending[parent])) {
+            break;
+        }
+        impairment->pending[i] = impairment->pending[parent];
+        i = parent;
+    }
+    impairment->pending[i] = datagram;
+}
+
+static struct udp_impairment_datagram * heap_pop(struct udp_impairment * impairment) {
+    struct udp_impairment_datagram * first = impairment->pending[0];
+    struct udp_impairment_datagram * last = impairment->pending[--impairment->pending_count];
+
+    unsigned int i = 0;
+    while (1) {
+        unsigned int child = 2 * i + 1;
+        if (child >= impairment->pending_count) {
+            break;
+        }
+        if (child + 1 < impairment->pending_count &&
+            datagram_before(impairment->pending[child + 1], impairment->pending[child])) {
+            child++;
+        }
+        if (!datagram_before(impairment->pending[child], last)) {
+            break;
+        }
+        impairment->pending[i] = impairment->pending[child];
+        i = child;
+    }
+    if (impairment->pending_count > 0) {
+        impairment->pending[i] = last;
+    }
+    return first;
+}
+
+static void * impairment_thread(void * carry_data) {
+    struct udp_impairment * impairment = carry_data;
+
+    pthread_mutex_lock(&impairment->lock);
+    while (!impairment->stopping) {
+        if (impairment->pending_count == 0) {
+            pthread_cond_wait(&impairment->changed, &impairment->lock);
+            continue;
+        }
+
+        struct udp_impairment_datagram * first = impairment->pending[0];
+        if (first->due > event_system_now()) {
+            struct timespec due = {
+                .tv_sec = (time_t) (first->due / 1000000000),
+                .tv_nsec = (long) (first->due % 1000000000)
+            };
+            pthread_cond_timedwait(&impairment->changed, &impairment->lock, &due);
+            continue;
+        }
+
+        // the slot is not reused before it is back in the free slots, so the datagram is sent without the lock
+        heap_pop(impairment);
+        pthread_mutex_unlock(&impairment->lock);
+        send_datagram(impairment->file_descriptor, first->data, first->length, &first->receiver);
+        pthread_mutex_lock(&impairment->lock);
+        impairment->free_slots[impairment->free_count++] = first;
+    }
+    pthread_mutex_unlock(&impairment->lock);
+    return NULL;
+}
+
+int udp_impairment_is_active(const struct RastaConfigImpairment * config) {
+    return config->loss > 0 || config->duplicate > 0 || (config->reorder > 0 && config->reorder_us > 0) ||
+           config->delay_us > 0 || config->jitter_us > 0;
+}
+
+struct udp_impairment * udp_impairment_create(int file_descriptor, const struct RastaConfigImpairment * config,
+                                              unsigned long seed) {
+    struct udp_impairment * impairment = rmalloc(sizeof(struct udp_impairment));
+    rmemset(impairment, 0, sizeof(struct udp_impairment));
+    impairment->config = *config;
+    impairment->file_descriptor = file_descriptor;
+    impairment->random = seed;
+
+    pthread_mutex_init(&impairment->lock, NULL);
+
+    // the due times are measured with the monotonic clock
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&impairment->changed, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    // only losses and duplicates can be injected without delaying datagrams
+    if (config->delay_us > 0 || config->jitter_us > 0 || (config->reorder > 0 && config->reorder_us > 0)) {
+        impairment->slots = rmalloc(UDP_IMPAIRMENT_MAX_PENDING * sizeof(struct udp_impairment_datagram));
+        impairment->free_slots = rmalloc(UDP_IMPAIRMENT_MAX_PENDING * sizeof(struct udp_impairment_datagram *));
+        impairment->pending = rmalloc(UDP_IMPAIRMENT_MAX_PENDING * sizeof(struct udp_impairment_datagram *));
+        for (unsigned int i = 0; i < UDP_IMPAIRMENT_MAX_PENDING; i++) {
+            impairment->free_slots[i] = &impairment->slots[i];
+        }
+        impairment->free_count = UDP_IMPAIRMENT_MAX_PENDING;
+
+        if (pthread_create(&impairment->thread, NULL, impairment_thread, impairment) != 0) {
+            perror("Could not start the thread of the impairment");
+            exit(1);
+        }
+        impairment->thread_running = 1;
+    }
+    return impairment;
+}
+
+void udp_impairment_destroy(struct udp_impairment * impairment) {
+    if (impairment->thread_running) {
+        pthread_mutex_lock(&impairment->lock);
+        impairment->stopping = 1;
+        pthread_cond_signal(&impairment->changed);
+        pthread_mutex_unlock(&impairment->lock);
+        pthread_join(impairment->thread, NULL);
+
+        rfree(impairment->slots);
+        rfree(impairment->free_slots);
+        rfree(impairment->pending);
+    }
+
+    pthread_cond_destroy(&impairment->changed);
+    pthread_mutex_destroy(&impairment->lock);
+    rfree(impairment);
+}
+
+void udp_impairment_send(struct udp_impairment * impairment, const unsigned char * message, size_t message_len,
+                         const struct sockaddr_in * receiver) {
+    const struct RastaConfigImpairment * config = &impairment->config;
+
+    pthread_mutex_lock(&impairment->lock);
+    impairment->stats.datagrams++;
+
+    if (happens(&impairment->random, config->loss)) {
+        impairment->stats.dropped++;
+        pthread_mutex_unlock(&impairment->lock);
+        return;
+    }
+
+    unsigned int copies = 1;
+    if (happens(&impairment->random, config->duplicate)) {
+        impairment->stats.duplicated++;
+        copies = 2;
+    }
+
+    int wake_up = 0;
+    for (unsigned int c = 0; c < copies; c++) {
+        uint64_t delay_us = config->delay_us;
+        if (config->jitter_us > 0) {
+            delay_us += next_random(&impairment->random) % (config->jitter_us + 1);
+        }
+        if (config->reorder_us > 0 && happens(&impairment->random, config->reorder)) {
+            impairment->stats.reordered++;
+            delay_us += config->reorder_us;
+        }
+
+        if (delay_us == 0) {
+            send_datagram(impairment->file_descriptor, message, message_len, receiver);
+            continue;
+        }
+
+        if (impairment->free_count == 0 || message_len > UDP_IMPAIRMENT_MAX_DATAGRAM) {
+            impairment->stats.overflows++;
+            continue;
+        }
+
+        struct udp_impairment_datagram * datagram = impairment->free_slots[--impairment->free_count];
+        datagram->due = event_system_now() + delay_us * 1000;
+        datagram->order = impairment->order++;
+        datagram->receiver = *receiver;
+        datagram->length = message_len;
+        memcpy(datagram->data, message, message_len);
+        heap_push(impairment, datagram);
+        impairment->stats.delayed++;
+
+        // the thread only has to wake up earlier if the datagram is due first
+        if (impairment->pending[0] == datagram) {
+            wake_up = 1;
+        }
+    }
+
+    if (wake_up) {
+        pthread_cond_signal(&impairment->changed);
+    }
+    pthread_mutex_unlock(&impairment->lock);
+}
+
+void udp_impairment_get_stats(struct udp_impairment * impairment, struct udp_impairment_stats * stats) {
+    pthread_mutex_lock(&impairment->lock);
+    *stats = impairment->stats;
+    pthread_mutex_unlock(&impairment->lock);
+}
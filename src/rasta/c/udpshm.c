@@ -0,0 +1,511 @@
+#define _GNU_SOURCE // memfd_create, accept4, mmsghdr
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
+#include "udpshm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include "rmemory.h"
+
+// the names of the abstract unix sockets are prefixed, so they do not collide with the ones of other programs
+#define UDP_SHM_RENDEZVOUS_PREFIX "rasta-shm/"
+
+// the datagram of a slot
+#define UDP_SHM_PAYLOAD_SIZE (UDP_SHM_SLOT_SIZE - sizeof(uint32_t) - sizeof(struct sockaddr_in))
+
+// the listener sends the memfd and the doorbells of both rings
+#define UDP_SHM_PASSED_FDS 3
+
+// the socket, the listening or pending unix socket and two file descriptors per peer
+#define UDP_SHM_EVENTS (2 * UDP_SHM_MAX_PEERS + 2)
+
+struct udp_shm_slot {
+    uint32_t length;
+    struct sockaddr_in sender;
+    unsigned char data[UDP_SHM_PAYLOAD_SIZE];
+};
+
+_Static_assert(sizeof(struct udp_shm_slot) == UDP_SHM_SLOT_SIZE, "a slot has to fill UDP_SHM_SLOT_SIZE");
+
+/**
+ * a ring in the shared memory. Only the producer writes head and only the consumer writes tail, so they are on
+ * cache lines of their own
+ */
+struct udp_shm_ring {
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t tail __attribute__((aligned(64)));
+    /**
+     * 1 while the consumer waits for the doorbell, the producer that publishes datagrams clears it and signals the
+     * doorbell once
+     */
+    uint32_t doorbell_armed;
+    struct udp_shm_slot slots[UDP_SHM_RING_SLOTS] __attribute__((aligned(64)));
+};
+
+/**
+ * the memfd of a peer
+ */
+struct udp_shm_region {
+    struct udp_shm_ring to_listener;
+    struct udp_shm_ring to_connector;
+};
+
+static void epoll_add(struct udp_shm * shm, int fd) {
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(shm->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("could not watch the shared memory transport channel");
+        exit(1);
+    }
+}
+
+static void epoll_remove(struct udp_shm * shm, int fd) {
+    epoll_ctl(shm->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+static int create_doorbell() {
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1) {
+        perror("could not create the doorbell of a shared memory ring");
+        exit(1);
+    }
+    return fd;
+}
+
+static void ring_doorbell(int doorbell) {
+    uint64_t value = 1;
+    // the counter only overflows if the consumer does not run at all, it is woken up either way
+    if (write(doorbell, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        perror("could not signal the doorbell of a shared memory ring");
+        exit(1);
+    }
+}
+
+/**
+ * maps the memfd of a peer
+ * @return the region, NULL if it could not be mapped
+ */
+static struct udp_shm_region * map_region(int memfd) {
+    void * region = mmap(NULL, sizeof(struct udp_shm_region), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, memfd, 0);
+    if (region == MAP_FAILED) {
+        perror("could not map the shared memory rings");
+        return NULL;
+    }
+    return region;
+}
+
+/**
+ * adds a peer whose new rings are mapped
+ */
+static void add_peer(struct udp_shm * shm, struct udp_shm_peer * peer) {
+    peer->endpoint = sockaddr_to_endpoint(&peer->address);
+    peer->send_head = 0;
+
+    // the listener may have published datagrams before the doorbell was armed, the first receive copies them
+    epoll_add(shm, peer->receive_doorbell);
+    ring_doorbell(peer->receive_doorbell);
+    shm->peers[shm->peer_count] = *peer;
+    shm->peer_count++;
+}
+
+/**
+ * tries to connect to the listener of the rendezvous and listens on it if there is none. If both fail, the transport
+ * channel stays on UDP only
+ */
+static void rendezvous(struct udp_shm * shm) {
+    // another entity may start listening between the failed connect and the bind
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            perror("could not create the rendezvous of a shared memory transport channel");
+            exit(1);
+        }
+        if (connect(fd, (struct sockaddr *) &shm->rendezvous, shm->rendezvous_length) == 0) {
+            // the listener answers with the rings when it handles the connection
+            if (send(fd, &shm->address, sizeof(shm->address), MSG_NOSIGNAL) == sizeof(shm->address)) {
+                shm->pending_fd = fd;
+                epoll_add(shm, fd);
+                return;
+            }
+            close(fd);
+            continue;
+        }
+        close(fd);
+
+        fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            perror("could not create the rendezvous of a shared memory transport channel");
+            exit(1);
+        }
+        if (bind(fd, (struct sockaddr *) &shm->rendezvous, shm->rendezvous_length) == 0 &&
+            listen(fd, UDP_SHM_MAX_PEERS) == 0) {
+            shm->listen_fd = fd;
+            epoll_add(shm, fd);
+            return;
+        }
+        close(fd);
+    }
+    fprintf(stderr, "could not meet the shared memory peers of %s, using UDP only\n", shm->rendezvous.sun_path + 1);
+}
+
+/**
+ * unmaps the rings of a peer and closes its file descriptors
+ * @param index the index of the peer, the last peer takes its place
+ */
+static void detach_peer(struct udp_shm * shm, unsigned int index) {
+    struct udp_shm_peer * peer = &shm->peers[index];
+    epoll_remove(shm, peer->control_fd);
+    epoll_remove(shm, peer->receive_doorbell);
+    close(peer->control_fd);
+    close(peer->send_doorbell);
+    close(peer->receive_doorbell);
+    munmap(peer->region, sizeof(struct udp_shm_region));
+
+    shm->peer_count--;
+    shm->peers[index] = shm->peers[shm->peer_count];
+}
+
+/**
+ * listener: accepts a connecting entity and sends it a new pair of rings
+ */
+static void accept_peer(struct udp_shm * shm) {
+    int fd = accept4(shm->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    // the connecting entity sends its address right after connecting
+    struct udp_shm_peer peer;
+    if (recv(fd, &peer.address, sizeof(peer.address), 0) != sizeof(peer.address)) {
+        close(fd);
+        return;
+    }
+    // a restarted entity replaces its old rings
+    uint64_t endpoint = sockaddr_to_endpoint(&peer.address);
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        if (shm->peers[i].endpoint == endpoint) {
+            detach_peer(shm, i);
+            break;
+        }
+    }
+    if (shm->peer_count == UDP_SHM_MAX_PEERS) {
+        // the entity keeps using UDP
+        close(fd);
+        return;
+    }
+
+    int memfd = memfd_create("rasta-shm", MFD_CLOEXEC);
+    if (memfd == -1 || ftruncate(memfd, sizeof(struct udp_shm_region)) == -1) {
+        perror("could not create the shared memory rings");
+        exit(1);
+    }
+    peer.region = map_region(memfd);
+    if (peer.region == NULL) {
+        close(memfd);
+        close(fd);
+        return;
+    }
+    peer.control_fd = fd;
+    peer.send_ring = &peer.region->to_connector;
+    peer.receive_ring = &peer.region->to_listener;
+    peer.send_doorbell = create_doorbell();
+    peer.receive_doorbell = create_doorbell();
+
+    int fds[UDP_SHM_PASSED_FDS] = { memfd, peer.receive_doorbell, peer.send_doorbell };
+    union {
+        struct cmsghdr header;
+        unsigned char buffer[CMSG_SPACE(sizeof(fds))];
+    } control;
+    rmemset(&control, 0, sizeof(control));
+    struct iovec iovec = { &shm->address, sizeof(shm->address) };
+    struct msghdr message;
+    rmemset(&message, 0, sizeof(message));
+    message.msg_iov = &iovec;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    rmemcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    int sent = sendmsg(fd, &message, MSG_NOSIGNAL) == sizeof(shm->address);
+    // the peer has its own references now
+    close(memfd);
+    if (!sent) {
+        close(peer.send_doorbell);
+        close(peer.receive_doorbell);
+        munmap(peer.region, sizeof(struct udp_shm_region));
+        close(fd);
+        return;
+    }
+    epoll_add(shm, fd);
+    add_peer(shm, &peer);
+}
+
+/**
+ * connecting entity: takes the rings the listener has sent, or meets again if the listener is gone
+ */
+static void attach_to_listener(struct udp_shm * shm) {
+    int fd = shm->pending_fd;
+
+    struct udp_shm_peer peer;
+    int fds[UDP_SHM_PASSED_FDS];
+    union {
+        struct cmsghdr header;
+        unsigned char buffer[CMSG_SPACE(sizeof(fds))];
+    } control;
+    struct iovec iovec = { &peer.address, sizeof(peer.address) };
+    struct msghdr message;
+    rmemset(&message, 0, sizeof(message));
+    message.msg_iov = &iovec;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received = recvmsg(fd, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+    int passed = header != NULL && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+                 header->cmsg_len == CMSG_LEN(sizeof(fds));
+    if (passed) {
+        rmemcpy(fds, CMSG_DATA(header), sizeof(fds));
+    }
+
+    epoll_remove(shm, fd);
+    shm->pending_fd = -1;
+    if (received != sizeof(peer.address) || !passed) {
+        // the listener is gone
+        if (passed) {
+            for (int i = 0; i < UDP_SHM_PASSED_FDS; i++) {
+                close(fds[i]);
+            }
+        }
+        close(fd);
+        rendezvous(shm);
+        return;
+    }
+
+    peer.region = map_region(fds[0]);
+    close(fds[0]);
+    if (peer.region == NULL) {
+        close(fds[1]);
+        close(fds[2]);
+        close(fd);
+        return;
+    }
+    peer.control_fd = fd;
+    peer.send_ring = &peer.region->to_listener;
+    peer.receive_ring = &peer.region->to_connector;
+    peer.send_doorbell = fds[1];
+    peer.receive_doorbell = fds[2];
+    epoll_add(shm, fd);
+    add_peer(shm, &peer);
+}
+
+/**
+ * handles a readable unix socket of a peer, the peers only close them
+ */
+static void check_peer(struct udp_shm * shm, int fd) {
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        if (shm->peers[i].control_fd == fd) {
+            unsigned char byte;
+            ssize_t received = recv(fd, &byte, sizeof(byte), MSG_DONTWAIT | MSG_PEEK);
+            if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            }
+            detach_peer(shm, i);
+            if (shm->listen_fd == -1) {
+                // the listener is gone, this entity may have to listen now
+                rendezvous(shm);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * resets the doorbell of a peer, the datagrams of all rings are copied afterwards anyway
+ */
+static void clear_doorbell(struct udp_shm * shm, int fd) {
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        if (shm->peers[i].receive_doorbell == fd) {
+            uint64_t value;
+            if (read(fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+                perror("could not reset the doorbell of a shared memory ring");
+                exit(1);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * copies the datagrams of the receive ring of a peer into the free slots of a batch
+ * @param first the first free slot
+ * @return the amount of copied datagrams
+ */
+static unsigned int drain_ring(struct udp_shm_peer * peer, struct RastaUDPReceiveBatch * batch, unsigned int first) {
+    struct udp_shm_ring * ring = peer->receive_ring;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    unsigned int count = 0;
+    while (tail != head && first + count < batch->capacity) {
+        struct udp_shm_slot * slot = &ring->slots[tail & (UDP_SHM_RING_SLOTS - 1)];
+        unsigned int index = first + count;
+        size_t length = slot->length < batch->buffer_size ? slot->length : batch->buffer_size;
+        rmemcpy(batch->buffers + index * batch->slot_size, slot->data, length);
+        batch->messages[index].msg_len = (unsigned int) length;
+        // the rings carry no receive timestamps
+        batch->messages[index].msg_hdr.msg_controllen = 0;
+        batch->senders[index] = slot->sender;
+        tail++;
+        count++;
+    }
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+    if (tail == head) {
+        // sleep until the producer publishes the next datagram. If it did so before the doorbell was armed, the
+        // doorbell is signaled right away so the datagrams are not left behind
+        __atomic_store_n(&ring->doorbell_armed, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail) {
+            return count;
+        }
+    }
+    // the batch is full, the rest of the ring is copied by the next call
+    ring_doorbell(peer->receive_doorbell);
+    return count;
+}
+
+struct udp_shm * udp_shm_create(int file_descriptor, const char * name) {
+    struct udp_shm * shm = rmalloc(sizeof(struct udp_shm));
+    rmemset(shm, 0, sizeof(struct udp_shm));
+    shm->socket_fd = file_descriptor;
+    shm->listen_fd = -1;
+    shm->pending_fd = -1;
+    shm->peer_count = 0;
+
+    socklen_t length = sizeof(shm->address);
+    if (getsockname(file_descriptor, (struct sockaddr *) &shm->address, &length) == -1) {
+        perror("could not read the address of the udp socket");
+        exit(1);
+    }
+
+    // an abstract socket name starts with a zero byte and is not terminated
+    shm->rendezvous.sun_family = AF_UNIX;
+    int name_length = snprintf(shm->rendezvous.sun_path + 1, sizeof(shm->rendezvous.sun_path) - 1, "%s%s",
+                               UDP_SHM_RENDEZVOUS_PREFIX, name);
+    shm->rendezvous_length = (socklen_t) (offsetof(struct sockaddr_un, sun_path) + 1 + name_length);
+
+    shm->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shm->epoll_fd == -1) {
+        perror("could not create the epoll instance of a shared memory transport channel");
+        exit(1);
+    }
+    epoll_add(shm, file_descriptor);
+    rendezvous(shm);
+    return shm;
+}
+
+void udp_shm_destroy(struct udp_shm * shm) {
+    while (shm->peer_count > 0) {
+        detach_peer(shm, shm->peer_count - 1);
+    }
+    if (shm->listen_fd != -1) {
+        close(shm->listen_fd);
+    }
+    if (shm->pending_fd != -1) {
+        close(shm->pending_fd);
+    }
+    close(shm->epoll_fd);
+    rfree(shm);
+}
+
+int udp_shm_receive_fd(struct udp_shm * shm) {
+    return shm->epoll_fd;
+}
+
+unsigned int udp_shm_receive(struct udp_shm * shm, struct RastaUDPReceiveBatch * batch, int * socket_readable) {
+    *socket_readable = 0;
+
+    struct epoll_event events[UDP_SHM_EVENTS];
+    int count = epoll_wait(shm->epoll_fd, events, UDP_SHM_EVENTS, 0);
+    if (count == -1 && errno != EINTR) {
+        perror("an error occured while trying to receive data");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == shm->socket_fd) {
+            *socket_readable = 1;
+        } else if (fd == shm->listen_fd) {
+            accept_peer(shm);
+        } else if (fd == shm->pending_fd) {
+            attach_to_listener(shm);
+        } else {
+            // the file descriptors of a detached peer may be reported after it was detached
+            clear_doorbell(shm, fd);
+            check_peer(shm, fd);
+        }
+    }
+
+    unsigned int received = 0;
+    // every ring is visited, a ring that does not fit into the batch anymore signals its doorbell again
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        received += drain_ring(&shm->peers[i], batch, received);
+    }
+    return received;
+}
+
+int udp_shm_push(struct udp_shm * shm, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver) {
+    if (message_length > UDP_SHM_PAYLOAD_SIZE) {
+        return 0;
+    }
+    uint64_t endpoint = sockaddr_to_endpoint(receiver);
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        struct udp_shm_peer * peer = &shm->peers[i];
+        if (peer->endpoint != endpoint) {
+            continue;
+        }
+
+        struct udp_shm_ring * ring = peer->send_ring;
+        if (peer->send_head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= UDP_SHM_RING_SLOTS) {
+            // the ring is full, the datagram takes the socket instead of being dropped
+            return 0;
+        }
+        struct udp_shm_slot * slot = &ring->slots[peer->send_head & (UDP_SHM_RING_SLOTS - 1)];
+        slot->length = (uint32_t) message_length;
+        slot->sender = shm->address;
+        rmemcpy(slot->data, message, (unsigned int) message_length);
+        peer->send_head++;
+        return 1;
+    }
+    return 0;
+}
+
+void udp_shm_flush(struct udp_shm * shm) {
+    for (unsigned int i = 0; i < shm->peer_count; i++) {
+        struct udp_shm_peer * peer = &shm->peers[i];
+        struct udp_shm_ring * ring = peer->send_ring;
+        if (__atomic_load_n(&ring->head, __ATOMIC_RELAXED) == peer->send_head) {
+            continue;
+        }
+        __atomic_store_n(&ring->head, peer->send_head, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->doorbell_armed, __ATOMIC_SEQ_CST) &&
+            __atomic_exchange_n(&ring->doorbell_armed, 0, __ATOMIC_SEQ_CST)) {
+            ring_doorbell(peer->send_doorbell);
+        }
+    }
+}
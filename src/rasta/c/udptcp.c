@@ -0,0 +1,706 @@
+#define _GNU_SOURCE // accept4, mmsghdr
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
+#include "udptcp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#ifdef ENABLE_TLS
+#include <linux/tls.h>
+#endif
+#include "rmemory.h"
+
+// the listener, the eventfd and the streams
+#define UDP_TCP_EVENTS (UDP_TCP_MAX_STREAMS + 2)
+
+// the longest datagram, a frame always fits into the buffers of a stream
+#define UDP_TCP_MAX_DATAGRAM_SIZE (UDP_TCP_BUFFER_SIZE - UDP_TCP_FRAME_HEADER_SIZE)
+
+// the hello carries the port of the dialing transport channel in network byte order
+#define UDP_TCP_HELLO_SIZE 2
+
+#ifdef ENABLE_TLS
+// the cipher suites whose records the kernel can take over, see tls12_crypto_info_aes_gcm_128
+#define UDP_TCP_TLS_CIPHERS "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:AES128-GCM-SHA256"
+#endif
+
+static void put_frame_header(unsigned char * out, size_t length) {
+    out[0] = (unsigned char) (length >> 8);
+    out[1] = (unsigned char) length;
+}
+
+static size_t get_frame_header(const unsigned char * in) {
+    return ((size_t) in[0] << 8) | in[1];
+}
+
+static void signal_pending(struct udp_tcp * tcp) {
+    uint64_t value = 1;
+    if (write(tcp->pending_fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        perror("could not signal the received frames of a TCP transport channel");
+        exit(1);
+    }
+}
+
+static void clear_pending(struct udp_tcp * tcp) {
+    uint64_t value;
+    if (read(tcp->pending_fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        perror("could not clear the received frames of a TCP transport channel");
+        exit(1);
+    }
+}
+
+static void epoll_add(struct udp_tcp * tcp, int fd, uint32_t events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(tcp->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("could not watch the TCP transport channel");
+        exit(1);
+    }
+}
+
+/**
+ * changes the events a stream is registered for
+ */
+static void stream_watch(struct udp_tcp * tcp, struct udp_tcp_stream * stream, uint32_t events) {
+    if (stream->events == events) {
+        return;
+    }
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = stream->fd;
+    if (epoll_ctl(tcp->epoll_fd, EPOLL_CTL_MOD, stream->fd, &event) == -1) {
+        perror("could not watch a stream of the TCP transport channel");
+        exit(1);
+    }
+    stream->events = events;
+}
+
+/**
+ * adds a stream on a connected or connecting socket
+ */
+static struct udp_tcp_stream * stream_new(struct udp_tcp * tcp, int fd, enum udp_tcp_stream_state state,
+                                          int dialed) {
+    // the frames are collected by udp_tcp_flush() already, they do not have to wait for more
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    struct udp_tcp_stream * stream = rmalloc(sizeof(struct udp_tcp_stream));
+    rmemset(stream, 0, sizeof(struct udp_tcp_stream));
+    stream->fd = fd;
+    stream->state = state;
+    stream->dialed = dialed;
+    stream->send_buffer = rmalloc(UDP_TCP_BUFFER_SIZE);
+    stream->receive_buffer = rmalloc(UDP_TCP_BUFFER_SIZE);
+    stream->events = state == UDP_TCP_STREAM_CONNECTING ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    epoll_add(tcp, fd, stream->events);
+
+    tcp->streams[tcp->stream_count] = stream;
+    tcp->stream_count++;
+    return stream;
+}
+
+/**
+ * closes a stream, the frames in its buffers are lost like datagrams on a closed socket. The last stream takes its
+ * index
+ */
+static void stream_close(struct udp_tcp * tcp, unsigned int index) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    epoll_ctl(tcp->epoll_fd, EPOLL_CTL_DEL, stream->fd, NULL);
+#ifdef ENABLE_TLS
+    if (stream->ssl != NULL) {
+        wolfSSL_free(stream->ssl);
+    }
+#endif
+    close(stream->fd);
+    rfree(stream->send_buffer);
+    rfree(stream->receive_buffer);
+    rfree(stream);
+
+    tcp->stream_count--;
+    tcp->streams[index] = tcp->streams[tcp->stream_count];
+}
+
+/**
+ * @return the index of the stream on @p fd, -1 if it was closed already
+ */
+static int find_stream(struct udp_tcp * tcp, int fd) {
+    for (unsigned int i = 0; i < tcp->stream_count; i++) {
+        if (tcp->streams[i]->fd == fd) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * sends as much of the send buffer of a stream as the socket takes and waits for the socket to become writable if
+ * some is left
+ * @return 0 if the stream was closed
+ */
+static int stream_send(struct udp_tcp * tcp, unsigned int index) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    size_t sent = 0;
+    while (sent < stream->send_length) {
+        ssize_t result;
+#ifdef ENABLE_TLS
+        if (stream->ssl != NULL && !stream->ktls) {
+            // an unfinished write has to be repeated with its length, the bytes at its start are unchanged
+            size_t length = stream->tls_write_length != 0 ? stream->tls_write_length : stream->send_length - sent;
+            int written = wolfSSL_write(stream->ssl, stream->send_buffer + sent, (int) length);
+            if (written <= 0) {
+                if (wolfSSL_get_error(stream->ssl, written) == WOLFSSL_ERROR_WANT_WRITE) {
+                    stream->tls_write_length = length;
+                    break;
+                }
+                stream_close(tcp, index);
+                return 0;
+            }
+            stream->tls_write_length = 0;
+            sent += (size_t) written;
+            continue;
+        }
+#endif
+        result = send(stream->fd, stream->send_buffer + sent, stream->send_length - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (result > 0) {
+            sent += (size_t) result;
+        } else if (result == -1 && errno == EINTR) {
+            continue;
+        } else if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            stream_close(tcp, index);
+            return 0;
+        }
+    }
+
+    memmove(stream->send_buffer, stream->send_buffer + sent, stream->send_length - sent);
+    stream->send_length -= sent;
+    stream_watch(tcp, stream, stream->send_length > 0 ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    return 1;
+}
+
+/**
+ * reads the stream into its receive buffer until the socket has nothing left or the buffer is full
+ * @return 0 if the stream was closed
+ */
+static int stream_read(struct udp_tcp * tcp, unsigned int index) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    while (stream->receive_length < UDP_TCP_BUFFER_SIZE) {
+        unsigned char * free_space = stream->receive_buffer + stream->receive_length;
+        size_t free_length = UDP_TCP_BUFFER_SIZE - stream->receive_length;
+#ifdef ENABLE_TLS
+        if (stream->ssl != NULL && !stream->ktls) {
+            int result = wolfSSL_read(stream->ssl, free_space, (int) free_length);
+            if (result <= 0) {
+                if (wolfSSL_get_error(stream->ssl, result) == WOLFSSL_ERROR_WANT_READ) {
+                    return 1;
+                }
+                stream_close(tcp, index);
+                return 0;
+            }
+            stream->receive_length += (size_t) result;
+            continue;
+        }
+#endif
+        // with kTLS an alert is not application data and fails the recv(), the stream is closed then
+        ssize_t result = recv(stream->fd, free_space, free_length, MSG_DONTWAIT);
+        if (result > 0) {
+            stream->receive_length += (size_t) result;
+        } else if (result == -1 && errno == EINTR) {
+            continue;
+        } else if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        } else {
+            stream_close(tcp, index);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef ENABLE_TLS
+static void fill_crypto_info(struct tls12_crypto_info_aes_gcm_128 * info, const unsigned char * key,
+                             const unsigned char * iv) {
+    rmemset(info, 0, sizeof(struct tls12_crypto_info_aes_gcm_128));
+    info->info.version = TLS_1_2_VERSION;
+    info->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+    rmemcpy(info->key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+    // the implicit part of the nonce, the explicit part is sent in every record
+    rmemcpy(info->salt, iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+    // the Finished messages were record 0 of both directions, the explicit nonces follow the record numbers
+    info->rec_seq[TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE - 1] = 1;
+    info->iv[TLS_CIPHER_AES_GCM_128_IV_SIZE - 1] = 1;
+}
+
+/**
+ * hands the session keys of a stream whose handshake just finished to the kernel. Nothing follows the Finished
+ * messages before the hello of the dialing entity, so WolfSSL has not read a single record the kernel would miss
+ * @return 1 if the kernel took over the records, 0 if WolfSSL keeps them, -1 if the stream has to be closed
+ */
+static int install_ktls(struct udp_tcp_stream * stream) {
+    WOLFSSL * ssl = stream->ssl;
+    if (wolfSSL_pending(ssl) != 0 || wolfSSL_GetBulkCipher(ssl) != wolfssl_aes_gcm ||
+        wolfSSL_GetKeySize(ssl) != TLS_CIPHER_AES_GCM_128_KEY_SIZE ||
+        wolfSSL_GetIVSize(ssl) < TLS_CIPHER_AES_GCM_128_SALT_SIZE) {
+        return 0;
+    }
+    if (setsockopt(stream->fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == -1) {
+        // the kernel has no tls module
+        return 0;
+    }
+
+    int client = wolfSSL_GetSide(ssl) == WOLFSSL_CLIENT_END;
+    struct tls12_crypto_info_aes_gcm_128 transmit;
+    struct tls12_crypto_info_aes_gcm_128 receive;
+    fill_crypto_info(&transmit, client ? wolfSSL_GetClientWriteKey(ssl) : wolfSSL_GetServerWriteKey(ssl),
+                     client ? wolfSSL_GetClientWriteIV(ssl) : wolfSSL_GetServerWriteIV(ssl));
+    fill_crypto_info(&receive, client ? wolfSSL_GetServerWriteKey(ssl) : wolfSSL_GetClientWriteKey(ssl),
+                     client ? wolfSSL_GetServerWriteIV(ssl) : wolfSSL_GetClientWriteIV(ssl));
+
+    // a socket with the ULP but without keys is still a plain TCP socket
+    int result = 0;
+    if (setsockopt(stream->fd, SOL_TLS, TLS_TX, &transmit, sizeof(transmit)) == 0) {
+        result = setsockopt(stream->fd, SOL_TLS, TLS_RX, &receive, sizeof(receive)) == 0 ? 1 : -1;
+    }
+    explicit_bzero(&transmit, sizeof(transmit));
+    explicit_bzero(&receive, sizeof(receive));
+    return result;
+}
+
+/**
+ * continues the handshake of a stream, the kernel takes over the records when it finishes
+ * @return 0 if the stream was closed
+ */
+static int stream_handshake(struct udp_tcp * tcp, unsigned int index) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    int result = stream->dialed ? wolfSSL_connect(stream->ssl) : wolfSSL_accept(stream->ssl);
+    if (result != SSL_SUCCESS) {
+        int error = wolfSSL_get_error(stream->ssl, result);
+        if (error == WOLFSSL_ERROR_WANT_READ) {
+            stream_watch(tcp, stream, EPOLLIN);
+            return 1;
+        }
+        if (error == WOLFSSL_ERROR_WANT_WRITE) {
+            stream_watch(tcp, stream, EPOLLIN | EPOLLOUT);
+            return 1;
+        }
+        fprintf(stderr, "TLS handshake of a TCP transport channel failed: %d\n", error);
+        stream_close(tcp, index);
+        return 0;
+    }
+
+    int ktls = install_ktls(stream);
+    if (ktls == -1) {
+        perror("could not hand the receive keys of a TLS stream to the kernel");
+        stream_close(tcp, index);
+        return 0;
+    }
+    stream->ktls = ktls;
+    if (ktls) {
+        tcp->stats.ktls++;
+    } else {
+        tcp->stats.userspace_tls++;
+    }
+
+    stream_watch(tcp, stream, EPOLLIN);
+    if (!stream->dialed) {
+        stream->state = UDP_TCP_STREAM_HELLO;
+        return 1;
+    }
+    // the hello and the datagrams that waited for the handshake
+    stream->state = UDP_TCP_STREAM_ESTABLISHED;
+    return stream_send(tcp, index);
+}
+
+static WOLFSSL_CTX * tls_context(WOLFSSL_METHOD * method, const struct RastaConfigTLS * tls_config, int server) {
+    WOLFSSL_CTX * ctx = wolfSSL_CTX_new(method);
+    if (ctx == NULL) {
+        fprintf(stderr, "Could not allocate WolfSSL context!\n");
+        exit(1);
+    }
+    if (wolfSSL_CTX_set_cipher_list(ctx, UDP_TCP_TLS_CIPHERS) != SSL_SUCCESS) {
+        fprintf(stderr, "WolfSSL does not support the AES-128-GCM cipher suites\n");
+        exit(1);
+    }
+    if (tls_config->ca_cert_path[0] &&
+        wolfSSL_CTX_load_verify_locations(ctx, tls_config->ca_cert_path, 0) != SSL_SUCCESS) {
+        fprintf(stderr, "Error loading CA certificate file %s\n", tls_config->ca_cert_path);
+        exit(1);
+    }
+    if (server) {
+        if (wolfSSL_CTX_use_certificate_file(ctx, tls_config->cert_path, SSL_FILETYPE_PEM) != SSL_SUCCESS) {
+            fprintf(stderr, "Error loading server certificate file %s as PEM file.\n", tls_config->cert_path);
+            exit(1);
+        }
+        if (wolfSSL_CTX_use_PrivateKey_file(ctx, tls_config->key_path, SSL_FILETYPE_PEM) != SSL_SUCCESS) {
+            fprintf(stderr, "Error loading server private key file %s as PEM file.\n", tls_config->key_path);
+            exit(1);
+        }
+    }
+    return ctx;
+}
+
+/**
+ * starts the TLS session of a connected stream
+ * @return 0 if the stream was closed
+ */
+static int stream_start_tls(struct udp_tcp * tcp, unsigned int index, const char * hostname) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    stream->ssl = wolfSSL_new(stream->dialed ? tcp->client_ctx : tcp->server_ctx);
+    if (stream->ssl == NULL || wolfSSL_set_fd(stream->ssl, stream->fd) != SSL_SUCCESS) {
+        fprintf(stderr, "Could not allocate the TLS session of a TCP transport channel\n");
+        stream_close(tcp, index);
+        return 0;
+    }
+    // the default IO callbacks of WolfSSL send on the socket of a peer that may have closed it
+    wolfSSL_SetIOWriteFlags(stream->ssl, MSG_NOSIGNAL);
+    if (stream->dialed && hostname[0]) {
+        wolfSSL_check_domain_name(stream->ssl, hostname);
+    }
+    stream->state = UDP_TCP_STREAM_HANDSHAKE;
+    return stream_handshake(tcp, index);
+}
+#endif
+
+/**
+ * starts a dialed stream whose connect finished
+ * @return 0 if the stream was closed
+ */
+static int stream_connected(struct udp_tcp * tcp, unsigned int index) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(stream->fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+        stream_close(tcp, index);
+        return 0;
+    }
+#ifdef ENABLE_TLS
+    if (tcp->mode == UDP_TCP_MODE_TLS) {
+        return stream_start_tls(tcp, index, tcp->tls_hostname);
+    }
+#endif
+    stream->state = UDP_TCP_STREAM_ESTABLISHED;
+    return stream_send(tcp, index);
+}
+
+static void accept_streams(struct udp_tcp * tcp) {
+    for (;;) {
+        struct sockaddr_in peer;
+        socklen_t length = sizeof(peer);
+        int fd = accept4(tcp->listen_fd, (struct sockaddr *) &peer, &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("could not accept a stream of the TCP transport channel");
+            }
+            return;
+        }
+        if (tcp->stream_count == UDP_TCP_MAX_STREAMS) {
+            close(fd);
+            continue;
+        }
+#ifdef ENABLE_TLS
+        if (tcp->mode == UDP_TCP_MODE_TLS && tcp->server_ctx == NULL) {
+            // without a certificate, this entity only dials
+            close(fd);
+            continue;
+        }
+#endif
+
+        // the port is the one of the connecting socket until the hello arrives
+        struct udp_tcp_stream * stream = stream_new(tcp, fd, UDP_TCP_STREAM_HELLO, 0);
+        stream->address = peer;
+        tcp->stats.accepted++;
+#ifdef ENABLE_TLS
+        if (tcp->mode == UDP_TCP_MODE_TLS) {
+            stream_start_tls(tcp, tcp->stream_count - 1, "");
+        }
+#endif
+    }
+}
+
+/**
+ * dials the stream to a peer, the hello is the first frame in its send buffer
+ * @return the stream, NULL if it could not be dialed
+ */
+static struct udp_tcp_stream * dial(struct udp_tcp * tcp, const struct sockaddr_in * receiver) {
+    if (tcp->stream_count == UDP_TCP_MAX_STREAMS) {
+        return NULL;
+    }
+#ifdef ENABLE_TLS
+    if (tcp->mode == UDP_TCP_MODE_TLS && tcp->client_ctx == NULL) {
+        // without a CA certificate, this entity only accepts
+        return NULL;
+    }
+#endif
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("could not open a stream of the TCP transport channel");
+        return NULL;
+    }
+    // the stream leaves from the address of the transport channel, its port is sent in the hello
+    struct sockaddr_in local = tcp->address;
+    local.sin_port = 0;
+    if (bind(fd, (struct sockaddr *) &local, sizeof(local)) == -1 ||
+        (connect(fd, (const struct sockaddr *) receiver, sizeof(struct sockaddr_in)) == -1 && errno != EINPROGRESS)) {
+        perror("could not dial a stream of the TCP transport channel");
+        close(fd);
+        return NULL;
+    }
+
+    struct udp_tcp_stream * stream = stream_new(tcp, fd, UDP_TCP_STREAM_CONNECTING, 1);
+    stream->address = *receiver;
+    stream->endpoint = sockaddr_to_endpoint(receiver);
+    put_frame_header(stream->send_buffer, UDP_TCP_HELLO_SIZE);
+    rmemcpy(stream->send_buffer + UDP_TCP_FRAME_HEADER_SIZE, &tcp->address.sin_port, UDP_TCP_HELLO_SIZE);
+    stream->send_length = UDP_TCP_FRAME_HEADER_SIZE + UDP_TCP_HELLO_SIZE;
+    tcp->stats.dialed++;
+    return stream;
+}
+
+/**
+ * handles the epoll events of a stream
+ */
+static void stream_handle(struct udp_tcp * tcp, unsigned int index, uint32_t events) {
+    struct udp_tcp_stream * stream = tcp->streams[index];
+    switch (stream->state) {
+        case UDP_TCP_STREAM_CONNECTING:
+            stream_connected(tcp, index);
+            return;
+#ifdef ENABLE_TLS
+        case UDP_TCP_STREAM_HANDSHAKE:
+            stream_handshake(tcp, index);
+            return;
+#endif
+        default:
+            break;
+    }
+    if ((events & EPOLLOUT) && !stream_send(tcp, index)) {
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        stream_read(tcp, index);
+    }
+}
+
+/**
+ * copies the complete frames of the receive buffer of a stream into the batch. A stream that breaks the framing is
+ * shut down, its hang up closes it with the next receive
+ * @return 1 if complete frames are left because the batch is full
+ */
+static int take_frames(struct udp_tcp_stream * stream, struct RastaUDPReceiveBatch * batch, unsigned int * received) {
+    size_t offset = 0;
+    int left = 0;
+    while (stream->receive_length - offset >= UDP_TCP_FRAME_HEADER_SIZE) {
+        size_t length = get_frame_header(stream->receive_buffer + offset);
+        if (length > UDP_TCP_MAX_DATAGRAM_SIZE) {
+            shutdown(stream->fd, SHUT_RDWR);
+            stream->receive_length = 0;
+            return 0;
+        }
+        if (stream->receive_length - offset - UDP_TCP_FRAME_HEADER_SIZE < length) {
+            break;
+        }
+        if (*received == batch->capacity) {
+            left = 1;
+            break;
+        }
+        const unsigned char * data = stream->receive_buffer + offset + UDP_TCP_FRAME_HEADER_SIZE;
+        offset += UDP_TCP_FRAME_HEADER_SIZE + length;
+
+        if (stream->state == UDP_TCP_STREAM_HELLO) {
+            if (length != UDP_TCP_HELLO_SIZE) {
+                shutdown(stream->fd, SHUT_RDWR);
+                stream->receive_length = 0;
+                return 0;
+            }
+            rmemcpy(&stream->address.sin_port, data, UDP_TCP_HELLO_SIZE);
+            stream->endpoint = sockaddr_to_endpoint(&stream->address);
+            stream->state = UDP_TCP_STREAM_ESTABLISHED;
+            continue;
+        }
+        if (length > batch->buffer_size) {
+            // longer than the slots, like a datagram that does not fit into the receive buffer of a UDP socket
+            continue;
+        }
+
+        unsigned int index = *received;
+        rmemcpy(batch->buffers + index * batch->slot_size, data, (unsigned int) length);
+        batch->messages[index].msg_len = (unsigned int) length;
+        batch->messages[index].msg_hdr.msg_controllen = 0;
+        batch->senders[index] = stream->address;
+        (*received)++;
+    }
+
+    memmove(stream->receive_buffer, stream->receive_buffer + offset, stream->receive_length - offset);
+    stream->receive_length -= offset;
+    return left;
+}
+
+struct udp_tcp * udp_tcp_create(int file_descriptor, enum udp_tcp_mode mode, const struct RastaConfigTLS * tls_config) {
+    struct udp_tcp * tcp = rmalloc(sizeof(struct udp_tcp));
+    rmemset(tcp, 0, sizeof(struct udp_tcp));
+    tcp->mode = mode;
+
+    socklen_t length = sizeof(tcp->address);
+    if (getsockname(file_descriptor, (struct sockaddr *) &tcp->address, &length) == -1) {
+        perror("could not read the address of the udp socket");
+        rfree(tcp);
+        return NULL;
+    }
+
+    tcp->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (tcp->listen_fd == -1) {
+        perror("could not open the listener of the TCP transport channel");
+        rfree(tcp);
+        return NULL;
+    }
+    // a restarted entity listens again while the streams of the last run are in TIME_WAIT
+    int reuse = 1;
+    setsockopt(tcp->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(tcp->listen_fd, (struct sockaddr *) &tcp->address, sizeof(tcp->address)) == -1 ||
+        listen(tcp->listen_fd, UDP_TCP_MAX_STREAMS) == -1) {
+        perror("could not listen on the address of the TCP transport channel");
+        close(tcp->listen_fd);
+        rfree(tcp);
+        return NULL;
+    }
+
+#ifdef ENABLE_TLS
+    if (mode == UDP_TCP_MODE_TLS) {
+        wolfSSL_Init();
+        rmemcpy(tcp->tls_hostname, tls_config->tls_hostname, sizeof(tcp->tls_hostname));
+        if (tls_config->ca_cert_path[0]) {
+            tcp->client_ctx = tls_context(wolfTLSv1_2_client_method(), tls_config, 0);
+            if (!tls_config->tls_hostname[0]) {
+                fprintf(stderr, "No TLS hostname specified. Will accept ANY valid TLS certificate. "
+                                "Double-check configuration file.\n");
+            }
+        }
+        if (tls_config->cert_path[0] && tls_config->key_path[0]) {
+            tcp->server_ctx = tls_context(wolfTLSv1_2_server_method(), tls_config, 1);
+        }
+        if (tcp->client_ctx == NULL && tcp->server_ctx == NULL) {
+            fprintf(stderr, "CA certificate path, certificate path or private key path missing!\n");
+            exit(1);
+        }
+    }
+#else
+    (void) tls_config;
+#endif
+
+    tcp->pending_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    tcp->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (tcp->pending_fd == -1 || tcp->epoll_fd == -1) {
+        perror("could not create the epoll instance of the TCP transport channel");
+        exit(1);
+    }
+    epoll_add(tcp, tcp->listen_fd, EPOLLIN);
+    epoll_add(tcp, tcp->pending_fd, EPOLLIN);
+    return tcp;
+}
+
+void udp_tcp_destroy(struct udp_tcp * tcp) {
+    while (tcp->stream_count > 0) {
+        stream_close(tcp, tcp->stream_count - 1);
+    }
+#ifdef ENABLE_TLS
+    if (tcp->client_ctx != NULL) {
+        wolfSSL_CTX_free(tcp->client_ctx);
+    }
+    if (tcp->server_ctx != NULL) {
+        wolfSSL_CTX_free(tcp->server_ctx);
+    }
+#endif
+    close(tcp->listen_fd);
+    close(tcp->pending_fd);
+    close(tcp->epoll_fd);
+    rfree(tcp);
+}
+
+int udp_tcp_receive_fd(struct udp_tcp * tcp) {
+    return tcp->epoll_fd;
+}
+
+unsigned int udp_tcp_receive(struct udp_tcp * tcp, struct RastaUDPReceiveBatch * batch) {
+    struct epoll_event events[UDP_TCP_EVENTS];
+    int count = epoll_wait(tcp->epoll_fd, events, UDP_TCP_EVENTS, 0);
+    if (count == -1 && errno != EINTR) {
+        perror("an error occured while trying to receive data");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == tcp->listen_fd) {
+            accept_streams(tcp);
+        } else if (fd == tcp->pending_fd) {
+            clear_pending(tcp);
+        } else {
+            // a stream that was closed by an earlier event may still be reported
+            int index = find_stream(tcp, fd);
+            if (index != -1) {
+                stream_handle(tcp, (unsigned int) index, events[i].events);
+            }
+        }
+    }
+
+    unsigned int received = 0;
+    int left = 0;
+    for (unsigned int i = 0; i < tcp->stream_count; i++) {
+        struct udp_tcp_stream * stream = tcp->streams[(tcp->next_stream + i) % tcp->stream_count];
+        left |= take_frames(stream, batch, &received);
+    }
+    if (tcp->stream_count > 0) {
+        tcp->next_stream = (tcp->next_stream + 1) % tcp->stream_count;
+    }
+    if (left) {
+        // the frames did not fit into the batch, the event loop comes back for them
+        signal_pending(tcp);
+    }
+    return received;
+}
+
+int udp_tcp_push(struct udp_tcp * tcp, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver) {
+    if (message_length > UDP_TCP_MAX_DATAGRAM_SIZE) {
+        tcp->stats.drops++;
+        return 0;
+    }
+    uint64_t endpoint = sockaddr_to_endpoint(receiver);
+    struct udp_tcp_stream * stream = NULL;
+    for (unsigned int i = 0; i < tcp->stream_count; i++) {
+        // accepted streams have no endpoint before their hello
+        if (tcp->streams[i]->endpoint == endpoint) {
+            stream = tcp->streams[i];
+            break;
+        }
+    }
+    if (stream == NULL) {
+        stream = dial(tcp, receiver);
+    }
+    if (stream == NULL || UDP_TCP_BUFFER_SIZE - stream->send_length < UDP_TCP_FRAME_HEADER_SIZE + message_length) {
+        tcp->stats.drops++;
+        return 0;
+    }
+
+    put_frame_header(stream->send_buffer + stream->send_length, message_length);
+    rmemcpy(stream->send_buffer + stream->send_length + UDP_TCP_FRAME_HEADER_SIZE, message,
+            (unsigned int) message_length);
+    stream->send_length += UDP_TCP_FRAME_HEADER_SIZE + message_length;
+    return 1;
+}
+
+void udp_tcp_flush(struct udp_tcp * tcp) {
+    // the last stream takes the index of a closed one, so the streams are visited from the end
+    for (unsigned int i = tcp->stream_count; i > 0; i--) {
+        struct udp_tcp_stream * stream = tcp->streams[i - 1];
+        if (stream->state == UDP_TCP_STREAM_ESTABLISHED && stream->send_length > 0) {
+            stream_send(tcp, i - 1);
+        }
+    }
+}
@@ -0,0 +1,374 @@
+#define _GNU_SOURCE // mmsghdr
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
+#include "udpuring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "rmemory.h"
+
+// the provided buffers of the receive ring
+#define UDP_URING_BUFFER_GROUP 0
+
+// the receive ring only submits the multishot recvmsg, every completion takes one provided buffer
+#define UDP_URING_RECEIVE_ENTRIES 4
+#define UDP_URING_RECEIVE_COMPLETIONS (2 * UDP_URING_BUFFER_COUNT)
+
+// the socket is registered as fixed file 0 of both rings
+#define UDP_URING_SOCKET 0
+
+static int uring_setup(unsigned int entries, struct io_uring_params * params) {
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned int opcode, void * arg, unsigned int count) {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static void queue_close(struct udp_uring_queue * queue) {
+    if (queue->sqes != NULL) {
+        munmap(queue->sqes, queue->sqes_size);
+    }
+    if (queue->cq_ring != NULL && queue->cq_ring != queue->sq_ring) {
+        munmap(queue->cq_ring, queue->cq_ring_size);
+    }
+    if (queue->sq_ring != NULL) {
+        munmap(queue->sq_ring, queue->sq_ring_size);
+    }
+    if (queue->fd >= 0) {
+        close(queue->fd);
+    }
+}
+
+/**
+ * creates an io_uring and maps its queues
+ * @param queue the queues
+ * @param entries the size of the submission queue
+ * @param completions the size of the completion queue
+ * @param socket_fd the socket that is registered as fixed file
+ * @return 0 on success, -1 if the kernel does not support it
+ */
+static int queue_open(struct udp_uring_queue * queue, unsigned int entries, unsigned int completions, int socket_fd) {
+    rmemset(queue, 0, sizeof(struct udp_uring_queue));
+
+    struct io_uring_params params;
+    rmemset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = completions;
+    queue->fd = uring_setup(entries, &params);
+    if (queue->fd < 0) {
+        return -1;
+    }
+
+    queue->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    queue->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        // both queues are in one mapping
+        if (queue->cq_ring_size > queue->sq_ring_size) {
+            queue->sq_ring_size = queue->cq_ring_size;
+        }
+        queue->cq_ring_size = queue->sq_ring_size;
+    }
+
+    queue->sq_ring = mmap(NULL, queue->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, queue->fd,
+                          IORING_OFF_SQ_RING);
+    if (queue->sq_ring == MAP_FAILED) {
+        queue->sq_ring = NULL;
+        queue_close(queue);
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        queue->cq_ring = queue->sq_ring;
+    } else {
+        queue->cq_ring = mmap(NULL, queue->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              queue->fd, IORING_OFF_CQ_RING);
+        if (queue->cq_ring == MAP_FAILED) {
+            queue->cq_ring = NULL;
+            queue_close(queue);
+            return -1;
+        }
+    }
+    queue->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    queue->sqes = mmap(NULL, queue->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, queue->fd,
+                       IORING_OFF_SQES);
+    if (queue->sqes == MAP_FAILED) {
+        queue->sqes = NULL;
+        queue_close(queue);
+        return -1;
+    }
+
+    unsigned char * sq = queue->sq_ring;
+    queue->sq_head = (unsigned int *) (sq + params.sq_off.head);
+    queue->sq_tail = (unsigned int *) (sq + params.sq_off.tail);
+    queue->sq_mask = *(unsigned int *) (sq + params.sq_off.ring_mask);
+    queue->sq_array = (unsigned int *) (sq + params.sq_off.array);
+
+    unsigned char * cq = queue->cq_ring;
+    queue->cq_head = (unsigned int *) (cq + params.cq_off.head);
+    queue->cq_tail = (unsigned int *) (cq + params.cq_off.tail);
+    queue->cq_mask = *(unsigned int *) (cq + params.cq_off.ring_mask);
+    queue->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+    // the socket is looked up once instead of on every request
+    if (uring_register(queue->fd, IORING_REGISTER_FILES, &socket_fd, 1) < 0) {
+        queue_close(queue);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @param queue the queues
+ * @return the next free submission queue entry, it is submitted by the next uring_enter() call. The queues are only
+ * used by one thread at a time and never hold more entries than they were created with
+ */
+static struct io_uring_sqe * queue_get_sqe(struct udp_uring_queue * queue) {
+    unsigned int tail = *queue->sq_tail;
+    unsigned int index = tail & queue->sq_mask;
+    struct io_uring_sqe * sqe = &queue->sqes[index];
+    rmemset(sqe, 0, sizeof(struct io_uring_sqe));
+    queue->sq_array[index] = index;
+    __atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+static void buffer_ring_add(struct udp_uring * uring, unsigned short id) {
+    struct io_uring_buf * buffer = &uring->buffer_ring->bufs[uring->buffer_tail & (UDP_URING_BUFFER_COUNT - 1)];
+    buffer->addr = (uint64_t) (uintptr_t) (uring->buffers + (size_t) id * UDP_URING_BUFFER_SIZE);
+    buffer->len = UDP_URING_BUFFER_SIZE;
+    buffer->bid = id;
+    uring->buffer_tail++;
+}
+
+static void buffer_ring_publish(struct udp_uring * uring) {
+    __atomic_store_n(&uring->buffer_ring->tail, uring->buffer_tail, __ATOMIC_RELEASE);
+}
+
+struct udp_uring * udp_uring_create(int file_descriptor, size_t control_size) {
+    struct udp_uring * uring = rmalloc(sizeof(struct udp_uring));
+    rmemset(uring, 0, sizeof(struct udp_uring));
+    uring->file_descriptor = file_descriptor;
+    uring->receive_queue.fd = -1;
+    uring->send_queue.fd = -1;
+
+    if (queue_open(&uring->receive_queue, UDP_URING_RECEIVE_ENTRIES, UDP_URING_RECEIVE_COMPLETIONS,
+                   file_descriptor) < 0 ||
+        queue_open(&uring->send_queue, UDP_URING_SEND_DEPTH, 2 * UDP_URING_SEND_DEPTH, file_descriptor) < 0) {
+        udp_uring_destroy(uring);
+        return NULL;
+    }
+
+    // the kernel writes into the buffers until the rings are closed, so they are not taken from the allocator
+    uring->buffer_ring_size = UDP_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+    uring->buffer_ring = mmap(NULL, uring->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uring->buffers = mmap(NULL, (size_t) UDP_URING_BUFFER_COUNT * UDP_URING_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (uring->buffer_ring == MAP_FAILED || uring->buffers == MAP_FAILED) {
+        perror("could not map the io_uring buffers");
+        exit(1);
+    }
+
+    struct io_uring_buf_reg registration;
+    rmemset(&registration, 0, sizeof(registration));
+    registration.ring_addr = (uint64_t) (uintptr_t) uring->buffer_ring;
+    registration.ring_entries = UDP_URING_BUFFER_COUNT;
+    registration.bgid = UDP_URING_BUFFER_GROUP;
+    if (uring_register(uring->receive_queue.fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        udp_uring_destroy(uring);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < UDP_URING_BUFFER_COUNT; i++) {
+        buffer_ring_add(uring, (unsigned short) i);
+    }
+    buffer_ring_publish(uring);
+
+    uring->receive_header.msg_namelen = sizeof(struct sockaddr_in);
+    uring->receive_header.msg_controllen = control_size;
+    return uring;
+}
+
+void udp_uring_destroy(struct udp_uring * uring) {
+    if (uring->receive_armed) {
+        // the kernel must not write into the buffers anymore when they are unmapped
+        struct io_uring_sync_cancel_reg cancel;
+        rmemset(&cancel, 0, sizeof(cancel));
+        cancel.flags = IORING_ASYNC_CANCEL_ANY;
+        cancel.timeout.tv_sec = -1;
+        cancel.timeout.tv_nsec = -1;
+        uring_register(uring->receive_queue.fd, IORING_REGISTER_SYNC_CANCEL, &cancel, 1);
+    }
+    queue_close(&uring->receive_queue);
+    queue_close(&uring->send_queue);
+    if (uring->buffer_ring != NULL && uring->buffer_ring != MAP_FAILED) {
+        munmap(uring->buffer_ring, uring->buffer_ring_size);
+    }
+    if (uring->buffers != NULL && uring->buffers != MAP_FAILED) {
+        munmap(uring->buffers, (size_t) UDP_URING_BUFFER_COUNT * UDP_URING_BUFFER_SIZE);
+    }
+    rfree(uring);
+}
+
+int udp_uring_start_receive(struct udp_uring * uring) {
+    if (!uring->receive_armed) {
+        struct io_uring_sqe * sqe = queue_get_sqe(&uring->receive_queue);
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->fd = UDP_URING_SOCKET;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        sqe->addr = (uint64_t) (uintptr_t) &uring->receive_header;
+        sqe->len = 1;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->buf_group = UDP_URING_BUFFER_GROUP;
+
+        while (uring_enter(uring->receive_queue.fd, 1, 0, 0) < 0) {
+            if (errno != EINTR) {
+                perror("could not arm the io_uring receive");
+                exit(1);
+            }
+        }
+        uring->receive_armed = 1;
+    }
+    return uring->receive_queue.fd;
+}
+
+unsigned int udp_uring_receive(struct udp_uring * uring, struct RastaUDPReceiveBatch * batch) {
+    struct udp_uring_queue * queue = &uring->receive_queue;
+    udp_uring_start_receive(uring);
+
+    // like recvmmsg() with MSG_WAITFORONE, the first completion is waited for
+    while (*queue->cq_head == __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE)) {
+        if (uring_enter(queue->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            perror("an error occured while trying to receive data");
+            exit(1);
+        }
+    }
+
+    unsigned int head = *queue->cq_head;
+    unsigned int tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+    size_t name_size = uring->receive_header.msg_namelen;
+    size_t control_size = uring->receive_header.msg_controllen;
+
+    unsigned int count = 0;
+    while (head != tail && count < batch->capacity) {
+        struct io_uring_cqe * cqe = &queue->cqes[head & queue->cq_mask];
+        head++;
+
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            uring->receive_armed = 0;
+        }
+        if (cqe->res < 0) {
+            // all provided buffers are in use, the receive is armed again below
+            if (cqe->res == -ENOBUFS) {
+                continue;
+            }
+            fprintf(stderr, "an error occured while trying to receive data: %s\n", strerror(-cqe->res));
+            exit(1);
+        }
+        if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+            continue;
+        }
+
+        unsigned short id = (unsigned short) (cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        unsigned char * buffer = uring->buffers + (size_t) id * UDP_URING_BUFFER_SIZE;
+        struct io_uring_recvmsg_out * out = (struct io_uring_recvmsg_out *) buffer;
+        unsigned char * name = buffer + sizeof(struct io_uring_recvmsg_out);
+        unsigned char * control = name + name_size;
+        unsigned char * payload = control + control_size;
+
+        // like recvmmsg(), a datagram that is longer than the slot is truncated
+        size_t length = out->payloadlen;
+        size_t room = UDP_URING_BUFFER_SIZE - (size_t) (payload - buffer);
+        if (length > room) {
+            length = room;
+        }
+        if (length > batch->buffer_size) {
+            length = batch->buffer_size;
+        }
+
+        rmemcpy(batch->buffers + count * batch->slot_size, payload, (unsigned int) length);
+        rmemset(&batch->senders[count], 0, sizeof(struct sockaddr_in));
+        rmemcpy(&batch->senders[count], name, out->namelen < name_size ? out->namelen : (unsigned int) name_size);
+        size_t control_length = out->controllen < control_size ? out->controllen : control_size;
+        rmemcpy(batch->messages[count].msg_hdr.msg_control, control, (unsigned int) control_length);
+        batch->messages[count].msg_hdr.msg_controllen = control_length;
+        batch->messages[count].msg_len = (unsigned int) length;
+        count++;
+
+        buffer_ring_add(uring, id);
+    }
+    __atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+    buffer_ring_publish(uring);
+
+    if (!uring->receive_armed) {
+        udp_uring_start_receive(uring);
+    }
+    return count;
+}
+
+/**
+ * reaps the completed sendmsg requests
+ * @param queue the send queue
+ * @return the amount of completed requests
+ */
+static unsigned int reap_sends(struct udp_uring_queue * queue) {
+    unsigned int head = *queue->cq_head;
+    unsigned int tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned int completed = 0;
+    for (; head != tail; head++, completed++) {
+        struct io_uring_cqe * cqe = &queue->cqes[head & queue->cq_mask];
+        if (cqe->res < 0) {
+            fprintf(stderr, "failed to send data: %s\n", strerror(-cqe->res));
+            exit(1);
+        }
+    }
+    __atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+    return completed;
+}
+
+void udp_uring_send(struct udp_uring * uring, unsigned char ** messages, size_t * message_lengths,
+                    struct sockaddr_in * receivers, unsigned int count) {
+    struct udp_uring_queue * queue = &uring->send_queue;
+    for (unsigned int offset = 0; offset < count; offset += UDP_URING_SEND_DEPTH) {
+        unsigned int chunk = count - offset < UDP_URING_SEND_DEPTH ? count - offset : UDP_URING_SEND_DEPTH;
+
+        for (unsigned int i = 0; i < chunk; i++) {
+            uring->send_iovecs[i].iov_base = messages[offset + i];
+            uring->send_iovecs[i].iov_len = message_lengths[offset + i];
+            uring->send_receivers[i] = receivers[offset + i];
+            rmemset(&uring->send_headers[i], 0, sizeof(struct msghdr));
+            uring->send_headers[i].msg_iov = &uring->send_iovecs[i];
+            uring->send_headers[i].msg_iovlen = 1;
+            uring->send_headers[i].msg_name = &uring->send_receivers[i];
+            uring->send_headers[i].msg_namelen = sizeof(struct sockaddr_in);
+
+            struct io_uring_sqe * sqe = queue_get_sqe(queue);
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = UDP_URING_SOCKET;
+            sqe->flags = IOSQE_FIXED_FILE;
+            sqe->addr = (uint64_t) (uintptr_t) &uring->send_headers[i];
+            sqe->len = 1;
+        }
+
+        // submit and wait with the same syscall, the headers and datagrams have to live until the sends complete
+        unsigned int submitted = 0;
+        unsigned int completed = 0;
+        while (completed < chunk) {
+            int result = uring_enter(queue->fd, chunk - submitted, chunk - completed, IORING_ENTER_GETEVENTS);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("failed to send data");
+                exit(1);
+            }
+            submitted += (unsigned int) result;
+            completed += reap_sends(queue);
+        }
+    }
+}
@@ -0,0 +1,612 @@
+#define _GNU_SOURCE // mmsghdr
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_TRANSPORT
+#include "udpxdp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_xdp.h>
+#include "rmemory.h"
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+// the headers of a datagram without IPv4 options
+#define UDP_XDP_ETH_HEADER 14
+#define UDP_XDP_IP_HEADER 20
+#define UDP_XDP_UDP_HEADER 8
+#define UDP_XDP_HEADERS (UDP_XDP_ETH_HEADER + UDP_XDP_IP_HEADER + UDP_XDP_UDP_HEADER)
+
+// the offsets of the fields that the program and the receive look at
+#define UDP_XDP_OFFSET_ETHERTYPE 12
+#define UDP_XDP_OFFSET_IP 14
+#define UDP_XDP_OFFSET_FRAGMENT 20
+#define UDP_XDP_OFFSET_PROTOCOL 23
+#define UDP_XDP_OFFSET_SOURCE 26
+#define UDP_XDP_OFFSET_DESTINATION 30
+#define UDP_XDP_OFFSET_UDP 34
+#define UDP_XDP_OFFSET_DESTINATION_PORT 36
+
+#define UDP_XDP_INSN(code, dst, src, off, imm) ((struct bpf_insn) { (code), (dst), (src), (off), (imm) })
+
+static int bpf(int command, union bpf_attr * attr) {
+    return (int) syscall(__NR_bpf, command, attr, sizeof(*attr));
+}
+
+/**
+ * the program redirects the unfragmented IPv4 datagrams without options to the address of the socket into the XSKMAP
+ * at the receive queue. A queue without an AF_XDP socket passes them on to the kernel, like all other frames
+ * @return the file descriptor of the program, -1 if the kernel refused it
+ */
+static int load_program(struct udp_xdp * xdp) {
+    // the loads are in the byte order of the host, so the constants are compared in network byte order
+    struct bpf_insn code[] = {
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, 0, 0), // data
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_1, 4, 0), // data_end
+        UDP_XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+        UDP_XDP_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, UDP_XDP_HEADERS),
+        UDP_XDP_INSN(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 19, 0),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_ETHERTYPE, 0),
+        UDP_XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 17, htons(ETH_P_IP)),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_IP, 0),
+        UDP_XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 15, 0x45),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_PROTOCOL, 0),
+        UDP_XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 13, IPPROTO_UDP),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_FRAGMENT, 0),
+        UDP_XDP_INSN(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3fff)), // more fragments, offset
+        UDP_XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 10, 0),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_DESTINATION, 0),
+        UDP_XDP_INSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, 8, (int32_t) xdp->address.sin_addr.s_addr),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, UDP_XDP_OFFSET_DESTINATION_PORT, 0),
+        UDP_XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 6, xdp->address.sin_port),
+        UDP_XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, 16, 0), // rx_queue_index
+        UDP_XDP_INSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, xdp->map_fd),
+        UDP_XDP_INSN(0, 0, 0, 0, 0),
+        UDP_XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS), // the action without a socket
+        UDP_XDP_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+        UDP_XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+        UDP_XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS),
+        UDP_XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+    };
+    static char verifier_log[4096];
+
+    union bpf_attr attr;
+    rmemset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uint64_t) (uintptr_t) code;
+    attr.insn_cnt = sizeof(code) / sizeof(code[0]);
+    attr.license = (uint64_t) (uintptr_t) "MIT";
+    attr.log_buf = (uint64_t) (uintptr_t) verifier_log;
+    attr.log_size = sizeof(verifier_log);
+    attr.log_level = 1;
+    verifier_log[0] = '\0';
+    int fd = bpf(BPF_PROG_LOAD, &attr);
+    if (fd == -1) {
+        perror("could not load the XDP program");
+        if (verifier_log[0] != '\0') {
+            fprintf(stderr, "%s\n", verifier_log);
+        }
+    }
+    return fd;
+}
+
+/**
+ * creates the XSKMAP, puts the AF_XDP socket in at its queue, loads the program and attaches it to the interface
+ * @return 0 on success, -1 otherwise
+ */
+static int attach_program(struct udp_xdp * xdp) {
+    union bpf_attr attr;
+    rmemset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = xdp->queue + 1;
+    xdp->map_fd = bpf(BPF_MAP_CREATE, &attr);
+    if (xdp->map_fd == -1) {
+        perror("could not create the XSKMAP of the XDP program");
+        return -1;
+    }
+
+    uint32_t key = xdp->queue;
+    uint32_t value = (uint32_t) xdp->xsk_fd;
+    rmemset(&attr, 0, sizeof(attr));
+    attr.map_fd = (uint32_t) xdp->map_fd;
+    attr.key = (uint64_t) (uintptr_t) &key;
+    attr.value = (uint64_t) (uintptr_t) &value;
+    if (bpf(BPF_MAP_UPDATE_ELEM, &attr) == -1) {
+        perror("could not add the AF_XDP socket to the XSKMAP");
+        return -1;
+    }
+
+    xdp->program_fd = load_program(xdp);
+    if (xdp->program_fd == -1) {
+        return -1;
+    }
+
+    // the program stays attached while the link is open, in the mode of the driver if it has one
+    rmemset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = (uint32_t) xdp->program_fd;
+    attr.link_create.target_ifindex = xdp->ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    xdp->link_fd = bpf(BPF_LINK_CREATE, &attr);
+    if (xdp->link_fd == -1) {
+        // e.g. EBUSY if another program is attached to the interface
+        perror("could not attach the XDP program to the interface");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * maps a ring of the AF_XDP socket
+ * @return 0 on success, -1 otherwise
+ */
+static int map_ring(struct udp_xdp * xdp, struct udp_xdp_ring * ring, const struct xdp_ring_offset * offsets,
+                    size_t descriptor_size, off_t page_offset) {
+    ring->map_size = offsets->desc + UDP_XDP_FRAMES * descriptor_size;
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xdp->xsk_fd,
+                     page_offset);
+    if (ring->map == MAP_FAILED) {
+        ring->map = NULL;
+        perror("could not map the rings of the AF_XDP socket");
+        return -1;
+    }
+    unsigned char * base = ring->map;
+    ring->producer = (uint32_t *) (base + offsets->producer);
+    ring->consumer = (uint32_t *) (base + offsets->consumer);
+    ring->flags = (uint32_t *) (base + offsets->flags);
+    ring->descriptors = base + offsets->desc;
+    ring->mask = UDP_XDP_FRAMES - 1;
+    return 0;
+}
+
+static void unmap_ring(struct udp_xdp_ring * ring) {
+    if (ring->map != NULL) {
+        munmap(ring->map, ring->map_size);
+        ring->map = NULL;
+    }
+}
+
+/**
+ * registers the UMEM, sizes and maps the rings and binds the AF_XDP socket to the queue, zero copy if the driver
+ * supports it
+ * @return 0 on success, -1 otherwise
+ */
+static int open_xsk(struct udp_xdp * xdp) {
+    xdp->xsk_fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (xdp->xsk_fd == -1) {
+        perror("could not create the AF_XDP socket");
+        return -1;
+    }
+
+    xdp->umem_size = 2 * UDP_XDP_FRAMES * UDP_XDP_FRAME_SIZE;
+    xdp->umem = mmap(NULL, xdp->umem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (xdp->umem == MAP_FAILED) {
+        xdp->umem = NULL;
+        perror("could not allocate the UMEM of the AF_XDP socket");
+        return -1;
+    }
+
+    struct xdp_umem_reg umem;
+    rmemset(&umem, 0, sizeof(umem));
+    umem.addr = (uint64_t) (uintptr_t) xdp->umem;
+    umem.len = xdp->umem_size;
+    umem.chunk_size = UDP_XDP_FRAME_SIZE;
+    umem.headroom = 0;
+    if (setsockopt(xdp->xsk_fd, SOL_XDP, XDP_UMEM_REG, &umem, sizeof(umem)) == -1) {
+        perror("could not register the UMEM of the AF_XDP socket");
+        return -1;
+    }
+
+    int ring_size = UDP_XDP_FRAMES;
+    if (setsockopt(xdp->xsk_fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) == -1 ||
+        setsockopt(xdp->xsk_fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) == -1 ||
+        setsockopt(xdp->xsk_fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) == -1 ||
+        setsockopt(xdp->xsk_fd, SOL_XDP, XDP_TX_RING, &ring_size, sizeof(ring_size)) == -1) {
+        perror("could not size the rings of the AF_XDP socket");
+        return -1;
+    }
+
+    struct xdp_mmap_offsets offsets;
+    socklen_t length = sizeof(offsets);
+    if (getsockopt(xdp->xsk_fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &length) == -1) {
+        perror("could not read the ring offsets of the AF_XDP socket");
+        return -1;
+    }
+    if (map_ring(xdp, &xdp->fill, &offsets.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) == -1 ||
+        map_ring(xdp, &xdp->completion, &offsets.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) == -1 ||
+        map_ring(xdp, &xdp->rx, &offsets.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) == -1 ||
+        map_ring(xdp, &xdp->tx, &offsets.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) == -1) {
+        return -1;
+    }
+
+    // the kernel receives into every frame of the first half, the second half is sent from
+    uint64_t * fill = xdp->fill.descriptors;
+    for (unsigned int i = 0; i < UDP_XDP_FRAMES; i++) {
+        fill[i] = (uint64_t) i * UDP_XDP_FRAME_SIZE;
+        xdp->free_frames[i] = (uint64_t) (UDP_XDP_FRAMES + i) * UDP_XDP_FRAME_SIZE;
+    }
+    xdp->free_count = UDP_XDP_FRAMES;
+    __atomic_store_n(xdp->fill.producer, UDP_XDP_FRAMES, __ATOMIC_RELEASE);
+
+    struct sockaddr_xdp address;
+    rmemset(&address, 0, sizeof(address));
+    address.sxdp_family = AF_XDP;
+    address.sxdp_ifindex = xdp->ifindex;
+    address.sxdp_queue_id = xdp->queue;
+    const uint16_t modes[] = { XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP, XDP_COPY | XDP_USE_NEED_WAKEUP, XDP_COPY };
+    for (unsigned int i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        address.sxdp_flags = modes[i];
+        if (bind(xdp->xsk_fd, (struct sockaddr *) &address, sizeof(address)) == 0) {
+            xdp->need_wakeup = (modes[i] & XDP_USE_NEED_WAKEUP) != 0;
+            return 0;
+        }
+    }
+    perror("could not bind the AF_XDP socket to the receive queue");
+    return -1;
+}
+
+/**
+ * reads the link layer address and the MTU of the interface
+ * @return 0 on success, -1 otherwise
+ */
+static int read_interface(struct udp_xdp * xdp, const char * interface) {
+    struct ifreq request;
+    rmemset(&request, 0, sizeof(request));
+    snprintf(request.ifr_name, sizeof(request.ifr_name), "%s", interface);
+    if (ioctl(xdp->socket_fd, SIOCGIFHWADDR, &request) == -1) {
+        perror("could not read the link layer address of the interface");
+        return -1;
+    }
+    rmemcpy(xdp->link_address, request.ifr_hwaddr.sa_data, sizeof(xdp->link_address));
+    if (ioctl(xdp->socket_fd, SIOCGIFMTU, &request) == -1) {
+        perror("could not read the MTU of the interface");
+        return -1;
+    }
+    xdp->mtu = (unsigned int) request.ifr_mtu;
+    if (ioctl(xdp->socket_fd, SIOCGIFFLAGS, &request) == -1) {
+        perror("could not read the flags of the interface");
+        return -1;
+    }
+    xdp->loopback = (request.ifr_flags & IFF_LOOPBACK) != 0;
+    return 0;
+}
+
+static void epoll_add(struct udp_xdp * xdp, int fd) {
+    struct epoll_event event;
+    rmemset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(xdp->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("could not watch the AF_XDP socket");
+        exit(1);
+    }
+}
+
+struct udp_xdp * udp_xdp_create(int file_descriptor, const char * interface, unsigned int queue) {
+    struct udp_xdp * xdp = rmalloc(sizeof(struct udp_xdp));
+    rmemset(xdp, 0, sizeof(struct udp_xdp));
+    xdp->socket_fd = file_descriptor;
+    xdp->xsk_fd = -1;
+    xdp->map_fd = -1;
+    xdp->program_fd = -1;
+    xdp->link_fd = -1;
+    xdp->epoll_fd = -1;
+    xdp->queue = queue;
+
+    socklen_t length = sizeof(xdp->address);
+    if (getsockname(file_descriptor, (struct sockaddr *) &xdp->address, &length) == -1) {
+        perror("could not read the address of the udp socket");
+        exit(1);
+    }
+    if (xdp->address.sin_addr.s_addr == htonl(INADDR_ANY)) {
+        fprintf(stderr, "AF_XDP needs a udp socket that is bound to a specific address, using the udp socket only\n");
+        udp_xdp_destroy(xdp);
+        return NULL;
+    }
+
+    xdp->ifindex = if_nametoindex(interface);
+    if (xdp->ifindex == 0 || read_interface(xdp, interface) == -1 || open_xsk(xdp) == -1 ||
+        attach_program(xdp) == -1) {
+        fprintf(stderr, "AF_XDP can not be used on %s queue %u, using the udp socket only\n", interface, queue);
+        udp_xdp_destroy(xdp);
+        return NULL;
+    }
+
+    xdp->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (xdp->epoll_fd == -1) {
+        perror("could not create the epoll instance of an AF_XDP socket");
+        exit(1);
+    }
+    epoll_add(xdp, file_descriptor);
+    epoll_add(xdp, xdp->xsk_fd);
+    return xdp;
+}
+
+void udp_xdp_destroy(struct udp_xdp * xdp) {
+    // closing the link detaches the program, the frames in flight are gone with the UMEM
+    if (xdp->link_fd != -1) {
+        close(xdp->link_fd);
+    }
+    if (xdp->program_fd != -1) {
+        close(xdp->program_fd);
+    }
+    if (xdp->map_fd != -1) {
+        close(xdp->map_fd);
+    }
+    unmap_ring(&xdp->fill);
+    unmap_ring(&xdp->completion);
+    unmap_ring(&xdp->rx);
+    unmap_ring(&xdp->tx);
+    if (xdp->xsk_fd != -1) {
+        close(xdp->xsk_fd);
+    }
+    if (xdp->umem != NULL) {
+        munmap(xdp->umem, xdp->umem_size);
+    }
+    if (xdp->epoll_fd != -1) {
+        close(xdp->epoll_fd);
+    }
+    rfree(xdp);
+}
+
+int udp_xdp_receive_fd(struct udp_xdp * xdp) {
+    return xdp->epoll_fd;
+}
+
+/**
+ * adds 16 bit words in network byte order to a ones' complement sum
+ */
+static uint32_t checksum_add(uint32_t sum, const unsigned char * data, size_t length) {
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        sum += (uint32_t) (data[i] << 8 | data[i + 1]);
+    }
+    if (length & 1) {
+        sum += (uint32_t) (data[length - 1] << 8);
+    }
+    return sum;
+}
+
+/**
+ * @return the folded and complemented sum, in network byte order
+ */
+static uint16_t checksum_finish(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return htons((uint16_t) ~sum);
+}
+
+/**
+ * @param ip the IPv4 header
+ * @param udp the UDP header and the data
+ * @param udp_length the length of the UDP header and the data
+ * @return the ones' complement sum of the UDP pseudo header, the UDP header and the data
+ */
+static uint32_t udp_checksum_sum(const unsigned char * ip, const unsigned char * udp, size_t udp_length) {
+    uint32_t sum = checksum_add(0, ip + UDP_XDP_OFFSET_SOURCE - UDP_XDP_OFFSET_IP, 8); // both addresses
+    sum += IPPROTO_UDP;
+    sum += (uint32_t) udp_length;
+    return checksum_add(sum, udp, udp_length);
+}
+
+/**
+ * remembers the link layer address of a sender, so the replies can be sent through the TX ring
+ */
+static void learn_neighbour(struct udp_xdp * xdp, in_addr_t address, const unsigned char * link_address) {
+    for (unsigned int i = 0; i < xdp->neighbour_count; i++) {
+        if (xdp->neighbours[i].address == address) {
+            rmemcpy(xdp->neighbours[i].link_address, link_address, 6);
+            return;
+        }
+    }
+    unsigned int index;
+    if (xdp->neighbour_count < UDP_XDP_MAX_NEIGHBOURS) {
+        index = xdp->neighbour_count++;
+    } else {
+        index = xdp->next_neighbour;
+        xdp->next_neighbour = (xdp->next_neighbour + 1) % UDP_XDP_MAX_NEIGHBOURS;
+    }
+    xdp->neighbours[index].address = address;
+    rmemcpy(xdp->neighbours[index].link_address, link_address, 6);
+}
+
+/**
+ * checks the headers of a received frame, which the program has only looked at in parts
+ * @param frame the frame
+ * @param length its length
+ * @param udp_length set to the length of the UDP header and the data
+ * @return 1 if the frame carries a valid datagram
+ */
+static int check_frame(const struct udp_xdp * xdp, const unsigned char * frame, size_t length, size_t * udp_length) {
+    if (length < UDP_XDP_HEADERS) {
+        return 0;
+    }
+    const unsigned char * ip = frame + UDP_XDP_OFFSET_IP;
+    const unsigned char * udp = frame + UDP_XDP_OFFSET_UDP;
+    size_t ip_length = (size_t) (ip[2] << 8 | ip[3]);
+    *udp_length = (size_t) (udp[4] << 8 | udp[5]);
+    if (ip_length > length - UDP_XDP_ETH_HEADER || ip_length != UDP_XDP_IP_HEADER + *udp_length ||
+        *udp_length < UDP_XDP_UDP_HEADER) {
+        return 0;
+    }
+    if (checksum_finish(checksum_add(0, ip, UDP_XDP_IP_HEADER)) != 0) {
+        return 0;
+    }
+    // a checksum of 0 was not computed by the sender
+    if (!xdp->loopback && (udp[6] != 0 || udp[7] != 0) &&
+        checksum_finish(udp_checksum_sum(ip, udp, *udp_length)) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+unsigned int udp_xdp_receive(struct udp_xdp * xdp, struct RastaUDPReceiveBatch * batch) {
+    // the fill ring has room for every frame of the first half, so the frames of the previous batch always fit
+    uint64_t * fill = xdp->fill.descriptors;
+    uint32_t fill_producer = *xdp->fill.producer;
+    for (unsigned int i = 0; i < xdp->held_count; i++) {
+        fill[fill_producer++ & xdp->fill.mask] = xdp->held_frames[i];
+    }
+    __atomic_store_n(xdp->fill.producer, fill_producer, __ATOMIC_RELEASE);
+    if (xdp->held_count > 0 && xdp->need_wakeup &&
+        (__atomic_load_n(xdp->fill.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)) {
+        recvfrom(xdp->xsk_fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+    xdp->held_count = 0;
+
+    struct xdp_desc * descriptors = xdp->rx.descriptors;
+    uint32_t consumer = *xdp->rx.consumer;
+    uint32_t producer = __atomic_load_n(xdp->rx.producer, __ATOMIC_ACQUIRE);
+    unsigned int count = 0;
+    while (consumer != producer && count < batch->capacity) {
+        struct xdp_desc * descriptor = &descriptors[consumer++ & xdp->rx.mask];
+        unsigned char * frame = xdp->umem + descriptor->addr;
+        // the frame is given back with the next call, wherever the driver put the data into it
+        xdp->held_frames[xdp->held_count++] = descriptor->addr & ~((uint64_t) UDP_XDP_FRAME_SIZE - 1);
+
+        size_t udp_length;
+        if (!check_frame(xdp, frame, descriptor->len, &udp_length)) {
+            xdp->dropped++;
+            continue;
+        }
+        const unsigned char * ip = frame + UDP_XDP_OFFSET_IP;
+        const unsigned char * udp = frame + UDP_XDP_OFFSET_UDP;
+        struct sockaddr_in * sender = &batch->senders[count];
+        rmemset(sender, 0, sizeof(*sender));
+        sender->sin_family = AF_INET;
+        rmemcpy(&sender->sin_addr.s_addr, ip + UDP_XDP_OFFSET_SOURCE - UDP_XDP_OFFSET_IP, 4);
+        rmemcpy(&sender->sin_port, udp, 2);
+        learn_neighbour(xdp, sender->sin_addr.s_addr, frame + 6);
+
+        size_t data_length = udp_length - UDP_XDP_UDP_HEADER;
+        batch->segments[count] = frame + UDP_XDP_HEADERS;
+        batch->segment_lengths[count] = data_length < batch->buffer_size ? data_length : batch->buffer_size;
+        // the frames carry no receive timestamps
+        batch->timestamps[count] = 0;
+        count++;
+    }
+    __atomic_store_n(xdp->rx.consumer, consumer, __ATOMIC_RELEASE);
+    xdp->received += count;
+    return count;
+}
+
+/**
+ * takes the frames of the sent datagrams back from the completion ring
+ */
+static void reap_completions(struct udp_xdp * xdp) {
+    uint64_t * completions = xdp->completion.descriptors;
+    uint32_t consumer = *xdp->completion.consumer;
+    uint32_t producer = __atomic_load_n(xdp->completion.producer, __ATOMIC_ACQUIRE);
+    while (consumer != producer) {
+        xdp->free_frames[xdp->free_count++] = completions[consumer++ & xdp->completion.mask];
+    }
+    __atomic_store_n(xdp->completion.consumer, consumer, __ATOMIC_RELEASE);
+}
+
+int udp_xdp_push(struct udp_xdp * xdp, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver) {
+    if (xdp->loopback || UDP_XDP_HEADERS + message_length > UDP_XDP_FRAME_SIZE ||
+        UDP_XDP_IP_HEADER + UDP_XDP_UDP_HEADER + message_length > xdp->mtu) {
+        return 0;
+    }
+    const struct udp_xdp_neighbour * neighbour = NULL;
+    for (unsigned int i = 0; i < xdp->neighbour_count; i++) {
+        if (xdp->neighbours[i].address == receiver->sin_addr.s_addr) {
+            neighbour = &xdp->neighbours[i];
+            break;
+        }
+    }
+    if (neighbour == NULL) {
+        // the kernel resolves the address until the receiver has sent a frame here
+        return 0;
+    }
+    if (xdp->free_count == 0) {
+        reap_completions(xdp);
+        if (xdp->free_count == 0) {
+            return 0;
+        }
+    }
+
+    uint64_t address = xdp->free_frames[--xdp->free_count];
+    unsigned char * frame = xdp->umem + address;
+    rmemcpy(frame, neighbour->link_address, 6);
+    rmemcpy(frame + 6, xdp->link_address, 6);
+    uint16_t ethertype = htons(ETH_P_IP);
+    rmemcpy(frame + UDP_XDP_OFFSET_ETHERTYPE, &ethertype, 2);
+
+    unsigned char * ip = frame + UDP_XDP_OFFSET_IP;
+    size_t udp_length = UDP_XDP_UDP_HEADER + message_length;
+    size_t ip_length = UDP_XDP_IP_HEADER + udp_length;
+    uint16_t id = xdp->next_ip_id++;
+    ip[0] = 0x45;
+    ip[1] = 0;
+    ip[2] = (unsigned char) (ip_length >> 8);
+    ip[3] = (unsigned char) ip_length;
+    ip[4] = (unsigned char) (id >> 8);
+    ip[5] = (unsigned char) id;
+    ip[6] = 0x40; // don't fragment
+    ip[7] = 0;
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP;
+    ip[10] = 0;
+    ip[11] = 0;
+    rmemcpy(ip + 12, &xdp->address.sin_addr.s_addr, 4);
+    rmemcpy(ip + 16, &receiver->sin_addr.s_addr, 4);
+    uint16_t ip_checksum = checksum_finish(checksum_add(0, ip, UDP_XDP_IP_HEADER));
+    rmemcpy(ip + 10, &ip_checksum, 2);
+
+    unsigned char * udp = frame + UDP_XDP_OFFSET_UDP;
+    rmemcpy(udp, &xdp->address.sin_port, 2);
+    rmemcpy(udp + 2, &receiver->sin_port, 2);
+    udp[4] = (unsigned char) (udp_length >> 8);
+    udp[5] = (unsigned char) udp_length;
+    udp[6] = 0;
+    udp[7] = 0;
+    rmemcpy(udp + UDP_XDP_UDP_HEADER, message, message_length);
+    uint16_t udp_checksum = checksum_finish(udp_checksum_sum(ip, udp, udp_length));
+    if (udp_checksum == 0) {
+        // 0 means that there is no checksum
+        udp_checksum = 0xffff;
+    }
+    rmemcpy(udp + 6, &udp_checksum, 2);
+
+    // the TX ring has room for every frame of the second half
+    struct xdp_desc * descriptors = xdp->tx.descriptors;
+    uint32_t producer = *xdp->tx.producer + xdp->tx_pending;
+    struct xdp_desc * descriptor = &descriptors[producer & xdp->tx.mask];
+    descriptor->addr = address;
+    descriptor->len = (uint32_t) (UDP_XDP_ETH_HEADER + ip_length);
+    descriptor->options = 0;
+    xdp->tx_pending++;
+    return 1;
+}
+
+void udp_xdp_flush(struct udp_xdp * xdp) {
+    if (xdp->tx_pending == 0) {
+        return;
+    }
+    __atomic_store_n(xdp->tx.producer, *xdp->tx.producer + xdp->tx_pending, __ATOMIC_RELEASE);
+    xdp->sent += xdp->tx_pending;
+    xdp->tx_pending = 0;
+
+    // in copy mode the frames are only sent by the syscall
+    if (!xdp->need_wakeup || (__atomic_load_n(xdp->tx.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)) {
+        if (sendto(xdp->xsk_fd, NULL, 0, MSG_DONTWAIT, NULL, 0) == -1 && errno != EAGAIN && errno != EBUSY &&
+            errno != ENOBUFS && errno != ENETDOWN) {
+            perror("failed to send data");
+            exit(1);
+        }
+    }
+    reap_completions(xdp);
+}
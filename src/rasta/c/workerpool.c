@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "workerpool.h"
+#include "rmemory.h"
+
+/**
+ * takes the queued jobs and runs their work until the pool is destroyed
+ * @param carry_data the pool
+ * @return NULL
+ */
+static void * worker_run(void * carry_data) {
+    struct worker_pool * pool = carry_data;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->first_queued == NULL && !pool->stopping) {
+            pthread_cond_wait(&pool->available, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        struct worker_job * job = pool->first_queued;
+        pool->first_queued = job->next;
+        if (pool->first_queued == NULL) {
+            pool->last_queued = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        job->work(job->carry_data);
+
+        // there is a slot for every pending job, so the queue is never full
+        struct worker_job ** completion = mpsc_queue_reserve(pool->completions);
+        *completion = job;
+        mpsc_queue_commit(pool->completions, completion);
+
+        uint64_t value = 1;
+        // can only fail if the counter would overflow, the event loop is woken up in that case anyway
+        ssize_t written = write(pool->notify_fd, &value, sizeof(value));
+        (void) written;
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+void worker_pool_init(struct worker_pool * pool, unsigned int thread_count, unsigned int max_pending) {
+    pool->thread_count = thread_count;
+    pool->first_queued = NULL;
+    pool->last_queued = NULL;
+    pool->stopping = 0;
+    pool->pending = 0;
+    pool->max_pending = max_pending;
+
+    pool->jobs = rmalloc(max_pending * sizeof(struct worker_job));
+    pool->free_jobs = NULL;
+    for (unsigned int i = max_pending; i > 0; i--) {
+        pool->jobs[i - 1].next = pool->free_jobs;
+        pool->free_jobs = &pool->jobs[i - 1];
+    }
+
+    pool->completions = mpsc_queue_init(max_pending, sizeof(struct worker_job *));
+
+    pool->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pool->notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->available, NULL);
+
+    pool->threads = rmalloc(thread_count * sizeof(pthread_t));
+    for (unsigned int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_run, pool) != 0) {
+            perror("Could not create worker thread");
+            exit(1);
+        }
+    }
+}
+
+int worker_pool_submit(struct worker_pool * pool, worker_pool_work_ptr work, worker_pool_complete_ptr complete,
+                       void * carry_data) {
+    if (pool->free_jobs == NULL) {
+        return 0;
+    }
+
+    struct worker_job * job = pool->free_jobs;
+    pool->free_jobs = job->next;
+    pool->pending++;
+
+    job->work = work;
+    job->complete = complete;
+    job->carry_data = carry_data;
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->last_queued == NULL) {
+        pool->first_queued = job;
+    } else {
+        pool->last_queued->next = job;
+    }
+    pool->last_queued = job;
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 1;
+}
+
+/**
+ * runs the completion function of a job and gives its slot back
+ * @param pool the pool
+ * @param job the job
+ * @param cancelled passed to the completion function
+ */
+static void worker_pool_finish(struct worker_pool * pool, struct worker_job * job, int cancelled) {
+    worker_pool_complete_ptr complete = job->complete;
+    void * carry_data = job->carry_data;
+
+    // the completion function may submit the next job into the slot
+    job->next = pool->free_jobs;
+    pool->free_jobs = job;
+    pool->pending--;
+
+    complete(carry_data, cancelled);
+}
+
+void worker_pool_complete(struct worker_pool * pool) {
+    uint64_t value;
+    // the eventfd is non-blocking, a failed read only means there was nothing to reset
+    ssize_t result = read(pool->notify_fd, &value, sizeof(value));
+    (void) result;
+
+    struct worker_job ** completion;
+    while ((completion = mpsc_queue_front(pool->completions)) != NULL) {
+        struct worker_job * job = *completion;
+        mpsc_queue_release(pool->completions);
+
+        worker_pool_finish(pool, job, 0);
+    }
+}
+
+void worker_pool_destroy(struct worker_pool * pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+
+    // the workers finish the jobs they are running
+    for (unsigned int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    worker_pool_complete(pool);
+
+    struct worker_job * job = pool->first_queued;
+    while (job != NULL) {
+        struct worker_job * next = job->next;
+        worker_pool_finish(pool, job, 1);
+        job = next;
+    }
+    pool->first_queued = NULL;
+    pool->last_queued = NULL;
+
+    pthread_cond_destroy(&pool->available);
+    pthread_mutex_destroy(&pool->lock);
+
+    close(pool->notify_fd);
+    pool->notify_fd = -1;
+    mpsc_queue_destroy(pool->completions);
+    rfree(pool->threads);
+    rfree(pool->jobs);
+}
@@ -35,10 +35,101 @@ struct RastaConfigInfoSending {
     unsigned short send_max;
     unsigned int max_packet;
     unsigned int diag_window;
+    /**
+     * maximum amount of received packets that are processed per wakeup of the receive handler, 0 drains all
+     * pending packets. Non-standard extension
+     */
+    unsigned int receive_budget;
+    /**
+     * maximum amount of data packets that are sent from the send queues per wakeup of the send handler, 0 sends one
+     * data packet per connection. Non-standard extension
+     */
+    unsigned int send_budget;
+    /**
+     * 1 if the confirmations of received PDUs are held back while the receive queue has no room for another send window
+     * of messages, so the partner stops sending instead of the messages being dropped. 0 drops the messages that do
+     * not fit. Non-standard extension
+     */
+    unsigned int receive_backpressure;
+    /**
+     * maximum amount of data packets per second that are sent on a connection, 0 disables pacing.
+     * Non-standard extension
+     */
+    unsigned int send_rate;
+    /**
+     * amount of data packets that may be sent on a connection at once before send_rate applies.
+     * Non-standard extension
+     */
+    unsigned int send_burst;
+    /**
+     * maximum amount of retransmitted data packets per second that are sent by a handle, shared by the connections
+     * that retransmit at the same time. 0 sends all unconfirmed data packets of a connection at once. A connection
+     * whose heartbeat is due while it waits sends its next data packet without credit, so the partner receives a PDU
+     * at least every t_h. Non-standard extension
+     */
+    unsigned int retransmit_rate;
+    /**
+     * amount of retransmitted data packets that may be sent at once before retransmit_rate applies, they are sent
+     * in one batch. Non-standard extension
+     */
+    unsigned int retransmit_burst;
+    /**
+     * time in microseconds that an application message may wait in the send queue, so it is sent in one data packet
+     * together with later messages. 0 sends the messages as soon as possible. Non-standard extension
+     */
+    unsigned int send_coalesce_us;
+    /**
+     * time in ms a heartbeat may be sent before it is due, so it is sent in one batch with the heartbeats of the other
+     * connections that are due within this time. 0 only batches the heartbeats that are due at the same time, it has
+     * to be less than t_h. Non-standard extension
+     */
+    unsigned int heartbeat_tick_ms;
+    /**
+     * amount of connections whose queues are allocated at once when the handle is initialized, further connections
+     * are refused. 0 allocates the queues of every connection when it is opened. Non-standard extension
+     */
+    unsigned int max_connections;
+    /**
+     * maximum amount of connection requests of new connections that are handled per wakeup of the receive handler,
+     * after the packets of the established connections. 0 handles them as soon as they are received.
+     * Non-standard extension
+     */
+    unsigned int conreq_budget;
+    /**
+     * delay in ms before a client sends its connection request again after it was not answered or the connection
+     * timed out. The delay doubles with every attempt up to reconnect_max_ms, a random jitter of up to half the
+     * delay is subtracted. 0 does not reconnect. Non-standard extension
+     */
+    unsigned int reconnect_min_ms;
+    unsigned int reconnect_max_ms;
+    /**
+     * amount of connection requests sr_connect_bulk() sends at once, every connect_wave_interval_ms. 0 sends the
+     * requests of all peers in one wave. Non-standard extension
+     */
+    unsigned int connect_wave_size;
+    /**
+     * time in ms between two waves of sr_connect_bulk(), has to be at least 1. Non-standard extension
+     */
+    unsigned int connect_wave_interval_ms;
+    /**
+     * maximum amount of handshakes of sr_connect_bulk() that are not finished at the same time, a wave is smaller if
+     * it would exceed it. 0 does not limit them. Non-standard extension
+     */
+    unsigned int connect_max_in_flight;
     unsigned int sr_hash_key;
     rasta_hash_algorithm sr_hash_algorithm;
 };
 
+/**
+ * maximum length of the name of a shared memory transport channel, including the terminating zero
+ */
+#define RASTA_SHM_NAME_LEN 64
+
+/**
+ * maximum length of the name of the interface of an AF_XDP transport channel, including the terminating zero
+ */
+#define RASTA_XDP_INTERFACE_LEN 16
+
 /**
  * represents an IP and Port
  */
@@ -55,6 +146,107 @@ struct RastaConfigRedundancyConnections {
     unsigned int count;
 };
 
+/**
+ * Non-standard extension: impairments that are injected into the datagrams sent on a transport channel, to test and
+ * benchmark the redundancy layer under conditions that loopback does not produce
+ */
+struct RastaConfigImpairment {
+    /**
+     * percentages of the datagrams that are dropped, sent twice and held back by reorder_us
+     */
+    double loss;
+    double duplicate;
+    double reorder;
+
+    /**
+     * fixed delay of every datagram, i.e. the skew to the other transport channels
+     */
+    unsigned int delay_us;
+
+    /**
+     * maximum random delay that is added to every datagram
+     */
+    unsigned int jitter_us;
+
+    /**
+     * delay that is added to the reordered datagrams
+     */
+    unsigned int reorder_us;
+};
+
+/**
+ * the impairments of the transport channels, entry i applies to the datagrams sent on transport channel i
+ */
+struct RastaConfigImpairments {
+    struct RastaConfigImpairment *data;
+    unsigned int count;
+
+    /**
+     * the seed of the random decisions, the same seed impairs the same sequence of datagrams in the same way
+     */
+    unsigned long seed;
+};
+
+/**
+ * Non-standard extension: the names of the shared memory rendezvous of the transport channels, entry i applies to
+ * transport channel i. An empty name keeps the transport channel on UDP only
+ */
+struct RastaConfigShmChannels {
+    char (*names)[RASTA_SHM_NAME_LEN];
+    unsigned int count;
+};
+
+/**
+ * Non-standard extension: how a transport channel exchanges its datagrams
+ */
+enum RastaTransportChannelType {
+    TRANSPORT_CHANNEL_UDP,
+    /**
+     * over TCP streams, see udptcp.h
+     */
+    TRANSPORT_CHANNEL_TCP,
+    /**
+     * over TLS 1.2 streams whose records are encrypted by the kernel after the handshake, see udptcp.h
+     */
+    TRANSPORT_CHANNEL_TLS
+};
+
+/**
+ * Non-standard extension: the types of the transport channels, entry i applies to transport channel i. The transport
+ * channels without an entry use UDP
+ */
+struct RastaConfigTcpChannels {
+    enum RastaTransportChannelType * types;
+    unsigned int count;
+};
+
+struct RastaConfigXdpChannels {
+    char (*interfaces)[RASTA_XDP_INTERFACE_LEN];
+    unsigned int count;
+
+    /**
+     * the receive queue of the interfaces that the AF_XDP sockets are bound to
+     */
+    unsigned int queue;
+};
+
+/**
+ * Non-standard extension: the buffer sizes of the socket of a transport channel in bytes, 0 keeps the size the kernel
+ * gives new sockets
+ */
+struct RastaConfigSocketBuffer {
+    unsigned int receive;
+    unsigned int send;
+};
+
+/**
+ * the socket buffers of the transport channels, entry i applies to the socket of transport channel i
+ */
+struct RastaConfigSocketBuffers {
+    struct RastaConfigSocketBuffer *data;
+    unsigned int count;
+};
+
 /**
  * defined in 7.3
  */
@@ -64,6 +256,74 @@ struct RastaConfigInfoRedundancy {
     unsigned int t_seq;
     int n_diagnose;
     unsigned int n_deferqueue_size;
+
+    /**
+     * Non-standard extension, k > 0 if a missing PDU is only waited for mean + k standard deviations of the skew
+     * between the copies of the transport channels in the last diagnose window instead of T_SEQ, see
+     * rasta_red_adapt_defer_timeout(). 0 always waits T_SEQ
+     */
+    unsigned int adaptive_t_seq;
+
+    /**
+     * Non-standard extension, 1 if the PDUs are stamped with the time the kernel received them instead of the time the
+     * event loop handles them
+     */
+    int receive_timestamps;
+
+    /**
+     * Non-standard extension, 1 if consecutive PDUs of equal length to the same transport channel are sent with one
+     * UDP_SEGMENT message and the kernel coalesces the received ones with UDP_GRO, see udp_enable_offload()
+     */
+    int udp_offload;
+
+    /**
+     * Non-standard extension, the redundancy channels of unknown senders that are kept until the SR layer accepted a
+     * connection request of them. The least recently active one is evicted for a new one, 0 keeps all of them
+     */
+    unsigned int max_pending_channels;
+
+    /**
+     * Non-standard extension, the PDUs of an unknown sender that are handed to the SR layer before it accepted a
+     * connection request of the sender. Further PDUs are dropped, 0 hands all of them to the SR layer
+     */
+    unsigned int pending_pdu_limit;
+
+    /**
+     * Non-standard extension, 1 if the shards of rasta_lib_init_shards() all listen on the configured ports with
+     * SO_REUSEPORT instead of ports of their own. A BPF program steers every datagram to the shard of its sender
+     */
+    int reuseport;
+
+    /**
+     * the amount of sockets that share each listen port, not read from the config file. Set by
+     * sr_init_shard_handle() if the ports are shared, 0 otherwise
+     */
+    unsigned int reuseport_group;
+
+    /**
+     * Non-standard extension, count is 0 if no transport channel is impaired
+     */
+    struct RastaConfigImpairments impairments;
+
+    /**
+     * Non-standard extension, count is 0 if no transport channel uses shared memory, see udpshm.h
+     */
+    struct RastaConfigShmChannels shm_channels;
+
+    /**
+     * Non-standard extension, count is 0 if no transport channel uses AF_XDP, see udpxdp.h
+     */
+    struct RastaConfigXdpChannels xdp_channels;
+
+    /**
+     * Non-standard extension, count is 0 if all transport channels use UDP, see udptcp.h
+     */
+    struct RastaConfigTcpChannels tcp_channels;
+
+    /**
+     * Non-standard extension, count is 0 if all sockets keep the buffer sizes of the kernel, see udp_set_buffer_sizes()
+     */
+    struct RastaConfigSocketBuffers socket_buffers;
 };
 
 /**
@@ -106,6 +366,152 @@ struct RastaConfigTLS {
 };
 
 
+/**
+ * Non-standard extension
+ */
+struct RastaConfigMetrics {
+    /**
+     * TCP port of the Prometheus text endpoint of the metrics, 0 if there is no endpoint
+     */
+    uint16_t port;
+
+    /**
+     * interval in milliseconds in which the durations of the event loop callbacks are logged, 0 if they are not measured
+     */
+    unsigned int profile_interval_ms;
+
+    /**
+     * 1 if every connection records how long its messages wait in the stages of the entity, see
+     * rasta_residency_stage
+     */
+    int residency;
+
+    /**
+     * path of the shared memory page the event loop publishes its metrics to, empty if there is no page, see
+     * rastastatpage.h
+     */
+    char stat_page[PATH_MAX];
+
+    /**
+     * interval in milliseconds in which the metrics are published to the stat page
+     */
+    unsigned int stat_interval_ms;
+};
+
+/**
+ * Non-standard extension
+ */
+struct RastaConfigFlightRecorder {
+    /**
+     * the amount of PDUs every connection keeps in its flight recorder, 0 if nothing is recorded
+     */
+    unsigned int records;
+
+    /**
+     * the anomalies that dump the flight recorder, a combination of rasta_flight_trigger
+     */
+    unsigned int triggers;
+
+    /**
+     * the amount of wrong safety codes within T_MAX that dump the flight recorder
+     */
+    unsigned int safety_errors;
+
+    /**
+     * the directory the dumps are written to
+     */
+    char directory[PATH_MAX];
+};
+
+/**
+ * Non-standard extension
+ */
+struct RastaConfigEventLoop {
+    /**
+     * 1 if the event loop polls the sockets without sleeping, see event_system#busy_poll
+     */
+    int busy_poll;
+    /**
+     * CPU the busy polling or real-time event loop is pinned to, negative if it is not pinned
+     */
+    int busy_poll_cpu;
+    /**
+     * SO_BUSY_POLL of the udp sockets: microseconds the kernel polls the device queue for a datagram before a
+     * receive blocks, 0 if it is not set
+     */
+    unsigned int socket_busy_poll_us;
+    /**
+     * SCHED_FIFO priority of the thread of the event loop, 0 if it keeps its scheduling policy, see
+     * event_system#realtime_priority
+     */
+    int realtime_priority;
+    /**
+     * 1 if the memory of the process is locked when the event loop starts, see event_system#lock_memory
+     */
+    int lock_memory;
+    /**
+     * amount of notifications the callback executor holds, 0 if the event loop calls the notifications itself, see
+     * rastaexecutor.h
+     */
+    unsigned int callback_queue;
+    /**
+     * 1 if the callback executor runs the notifications on a thread of its own, 0 if the application runs them with
+     * sr_run_callbacks()
+     */
+    int callback_thread;
+};
+
+/**
+ * Non-standard extension: the CPUs and the memory of the event loops of a sharded entity, see rasta_lib_init_shards()
+ */
+struct RastaConfigPlacement {
+    /**
+     * the CPUs the shards run on, shard i on entry i modulo cpu_count. 0 entries leave the choice to
+     * rasta_lib_start_shards()
+     */
+    int * cpus;
+    unsigned int cpu_count;
+
+    /**
+     * 1 if the memory of a shard with a CPU is taken from the NUMA node of the CPU
+     */
+    int numa;
+
+    /**
+     * 1 if the memory of the handles is backed by huge pages
+     */
+    int huge_pages;
+};
+
+typedef enum {
+    RASTA_REPLICATION_NONE,
+    /**
+     * replicates the state of the connections to a standby
+     */
+    RASTA_REPLICATION_PRIMARY,
+    /**
+     * receives the state of the connections and takes them over when the primary is lost
+     */
+    RASTA_REPLICATION_STANDBY
+} rasta_replication_role;
+
+/**
+ * Non-standard extension: the hot standby stream, see rastareplication.h
+ */
+struct RastaConfigReplication {
+    rasta_replication_role role;
+
+    /**
+     * the address of the standby, a standby listens on it
+     */
+    struct RastaIPData address;
+
+    /**
+     * interval in milliseconds of the rounds in which the primary sends the changed connections
+     */
+    unsigned int interval_ms;
+};
+
 /**
  * stores all presets after load
  */
@@ -135,6 +541,30 @@ struct RastaConfigInfo {
      */
     struct RastaConfigKex kex;
 
+    /**
+     * Configuration for the metrics export
+     */
+    struct RastaConfigMetrics metrics;
+
+    /**
+     * the flight recorders of the connections
+     */
+    struct RastaConfigFlightRecorder flight_recorder;
+
+    /**
+     * settings of the event loop of sr_begin()
+     */
+    struct RastaConfigEventLoop loop;
+
+    /**
+     * Non-standard extension
+     */
+    struct RastaConfigPlacement placement;
+
+    /**
+     * settings of the hot standby stream
+     */
+    struct RastaConfigReplication replication;
 
 };
 
@@ -161,6 +591,41 @@ struct RastaConfig {
      * the standard values
      */
     struct RastaConfigInfo values;
+
+    /**
+     * the amount of errors that were logged while the config was loaded
+     */
+    unsigned int errors;
+
+    /**
+     * the mapped snapshot the dictionary is read from, NULL if the config was parsed from text
+     */
+    void * snapshot;
+    size_t snapshot_length;
+};
+
+#define RASTA_CONFIG_SNAPSHOT_MAGIC 0x53434652u
+#define RASTA_CONFIG_SNAPSHOT_VERSION 1
+
+/**
+ * the start of a config snapshot, it is followed by entry_count dictionary entries and string_count array elements.
+ * The arrays of the entries hold the position of their first element instead of a pointer
+ */
+struct rasta_config_snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t string_size;
+    uint32_t entry_count;
+    uint32_t string_count;
+    /**
+     * FNV-1a hash of everything behind the header
+     */
+    uint64_t checksum;
+    /**
+     * the config file the snapshot was written from
+     */
+    char source[512];
 };
 
 /**
@@ -168,7 +633,25 @@ struct RastaConfig {
  * @param filename
  * @return
  */
-struct RastaConfig config_load(const char filename[256]);
+struct RastaConfig config_load(const char * filename);
+
+/**
+ * loads a snapshot that was written by config_write_snapshot(). The file is mapped read only and shared, so the
+ * processes that load the same snapshot share its pages. config_load() calls this for snapshots too
+ * NOTE: the dictionary is empty if the snapshot is not valid for this build
+ * @param filename
+ * @return
+ */
+struct RastaConfig config_load_snapshot(const char * filename);
+
+/**
+ * writes the dictionary of a config as a snapshot that config_load_snapshot() maps without parsing. An existing
+ * snapshot is replaced, the processes that mapped it keep the old one
+ * @param cfg the config, nothing is written if errors were logged while it was loaded
+ * @param filename the snapshot
+ * @return 1 if the snapshot was written, 0 otherwise
+ */
+int config_write_snapshot(struct RastaConfig * cfg, const char * filename);
 
 /**
  * returns the entry behind the key
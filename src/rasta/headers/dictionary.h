@@ -66,6 +66,18 @@ struct Dictionary {
 
     struct DictionaryEntry* data;
 
+    /**
+     * positions in data, indexed by the hash of the uppercase key modulo the table size, -1 marks a free slot. The
+     * table has at least twice as many slots as there are entries
+     */
+    int* slots;
+    unsigned int slot_mask;
+
+    /**
+     * the array elements of a dictionary that was created by dictionary_map(), NULL otherwise. The entries of such a
+     * dictionary are not owned by it, their arrays hold the position of their first element in here
+     */
+    const struct DictionaryString* mapped_strings;
 };
 /**
  * returns an allocated DictionaryArray
@@ -142,6 +154,18 @@ int dictionary_addArray(struct Dictionary* dict, const char * key, struct Dictio
  */
 struct DictionaryEntry dictionary_get(struct Dictionary* dict, const char* key);
 
+/**
+ * creates a read only dictionary on entries that are stored elsewhere, e.g. in a mapped file. Only the index is
+ * allocated, dictionary_free() does not free the entries
+ * @param entries the entries with uppercase keys, the data of their arrays is the position of the first element in
+ * @p strings instead of a pointer
+ * @param count the amount of entries
+ * @param strings the elements of all arrays
+ * @return the dictionary, nothing can be added to it
+ */
+struct Dictionary dictionary_map(const struct DictionaryEntry* entries, unsigned int count,
+                                 const struct DictionaryString* strings);
+
 
 #ifdef __cplusplus
 }
@@ -1,19 +1,28 @@
 #ifndef EVENT_LOOP_H
 #define EVENT_LOOP_H
 #include <inttypes.h>
+#include <stdio.h>
 #include <time.h>
 #include <unistd.h>
+#include "rastametrics.h"
+#ifdef ENABLE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {  // only need to export C interface if
               // used by C++ source code
 #endif
 
+// time in nanoseconds
+typedef uint_fast64_t evtime_t;
+
 // event callback pointer, return 0 to keep the loop running, everything else stops the loop
 typedef int (*event_ptr)(void* h);
 
 /**
- * contains a function pointer to a callback function and interval in microseconds
+ * contains a function pointer to a callback function and interval in nanoseconds
+ * has to be zero initialized before it is used
  */
 typedef struct timed_event {
     event_ptr callback;
@@ -23,10 +32,14 @@ typedef struct timed_event {
     uint64_t interval;
     uint64_t last_call;
     char enabled;
+    // the event system this event was added to and the position of the event in its timer heap
+    struct event_system* ev_sys;
+    size_t heap_index;
 } timed_event;
 
 /**
  * contains a function pointer to a callback function and a file descriptor
+ * has to be zero initialized before it is used
  */
 typedef struct fd_event {
     event_ptr callback;
@@ -36,6 +49,10 @@ typedef struct fd_event {
     int fd;
     int options;
     char enabled;
+#ifdef ENABLE_EPOLL
+    // the event system this event was added to, needed to update the epoll registration on enable / disable
+    struct event_system* ev_sys;
+#endif
 } fd_event;
 
 struct timed_event_linked_list_s {
@@ -48,11 +65,213 @@ struct fd_event_linked_list_s {
     fd_event* last;
 };
 
+/**
+ * binary min-heap of the enabled timed events, ordered by timed_event::last_call + timed_event::interval
+ */
+struct timed_event_heap_s {
+    timed_event** events;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * the maximum amount of different callbacks an event_profile keeps apart
+ */
+#define EV_PROFILE_MAX_CALLBACKS 32
+
+/**
+ * how long the calls of one callback took
+ */
+struct event_profile_entry {
+    event_ptr callback;
+    /**
+     * set with event_profile_name(), NULL if the callback has no name
+     */
+    const char* name;
+    /**
+     * the amount of calls and their total and maximum duration in nanoseconds
+     */
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    /**
+     * the amount of calls from timed events, and the total and maximum time these fired after they were due
+     */
+    uint64_t timed_count;
+    uint64_t lag_total_ns;
+    uint64_t lag_max_ns;
+};
+
+/**
+ * profile of the callbacks of an event system, separated by callback function.
+ * Has to be zero initialized before it is used
+ */
+typedef struct event_profile {
+    struct event_profile_entry entries[EV_PROFILE_MAX_CALLBACKS];
+    unsigned int entry_count;
+    /**
+     * calls that were not profiled, because there were more than EV_PROFILE_MAX_CALLBACKS different callbacks
+     */
+    uint64_t dropped_calls;
+} event_profile;
+
+#ifdef ENABLE_EPOLL
+// maximum amount of fd events that are dispatched per call to epoll_wait()
+#define EV_EPOLL_MAX_EVENTS 64
+#endif
+
+/**
+ * the maximum amount of posted tasks that are run per wakeup, the remaining ones run after the other events had
+ * their turn
+ */
+#define EV_TASK_BATCH 64
+
+struct mpsc_queue;
+
+/**
+ * a clock an event system schedules its timed events with instead of CLOCK_MONOTONIC, see event_system::clock.
+ * Has to be zero initialized before it is used
+ */
+typedef struct event_clock {
+    /**
+     * reads the clock in nanoseconds, NULL for a virtual clock. The loop sleeps as if the clock ran at the speed of
+     * CLOCK_MONOTONIC
+     */
+    evtime_t (*read)(void* carry_data);
+    void* carry_data;
+    /**
+     * the time of a virtual clock. Only the loop advances it: when no fd event is ready, the time jumps to the next
+     * timed event instead of sleeping
+     */
+    evtime_t virtual_now;
+} event_clock;
+
+/**
+ * the real-time settings an event loop runs with, read back from the kernel after event_system_start() applied them
+ */
+typedef struct event_realtime_status {
+    /**
+     * 1 if the memory of the process is locked into RAM
+     */
+    char memory_locked;
+    /**
+     * the SCHED_FIFO priority of the thread of the loop, 0 if it runs with another policy
+     */
+    int priority;
+    /**
+     * the CPU the thread of the loop is pinned to, negative if it may run on several
+     */
+    int cpu;
+} event_realtime_status;
+
 typedef struct event_system {
     struct timed_event_linked_list_s timed_events;
     struct fd_event_linked_list_s fd_events;
+    struct timed_event_heap_s timed_event_heap;
+    /**
+     * the timed event whose callback is currently running, NULL if it got removed during the callback
+     */
+    timed_event* firing_event;
+    /**
+     * records how many microseconds the timed events fire after they were due, NULL if it is not measured
+     */
+    struct rasta_histogram* lag_histogram;
+    /**
+     * measures the callbacks, NULL if they are not measured. Only costs a comparison per callback if NULL
+     */
+    event_profile* profile;
+    /**
+     * 1 to poll the fd events without blocking instead of sleeping until the next timed event is due. The loop keeps
+     * a CPU busy but does not wait for the kernel to wake it up
+     */
+    char busy_poll;
+    /**
+     * 1 to pin the thread of a busy polling loop to the CPU busy_poll_cpu while the loop runs
+     */
+    char pin_cpu;
+    int busy_poll_cpu;
+    /**
+     * the SCHED_FIFO priority of the thread while the loop runs, 0 to keep its policy. A real-time loop is pinned
+     * like a busy polling one
+     */
+    int realtime_priority;
+    /**
+     * 1 to lock all current and future memory of the process with mlockall() when the loop starts and to fault in
+     * the stack of the thread, so the loop does not wait for page faults. The memory stays locked after the loop
+     */
+    char lock_memory;
+    /**
+     * the settings the loop got, written by event_system_start() before the first event. Only read back from the
+     * kernel if realtime_priority or lock_memory is set, zero with a negative cpu otherwise
+     */
+    event_realtime_status realtime;
+    /**
+     * the clock of the timed events and of event_system_now() in the callbacks, NULL for get_nanotime()
+     */
+    event_clock* clock;
+    /**
+     * the tasks that other threads posted with event_system_post(), NULL if posting is not enabled. The eventfd
+     * tasks_fd wakes up the loop, tasks_signaled is 1 while it is signaled, so a burst of tasks costs a single write()
+     */
+    struct mpsc_queue* tasks;
+    int tasks_fd;
+    int tasks_signaled;
+    fd_event tasks_event;
+#ifdef ENABLE_EPOLL
+    /**
+     * 1 while event_system_start() is running, the epoll instance is only valid during that time
+     */
+    char running;
+    int epoll_fd;
+    /**
+     * the events returned by the last epoll_wait() call and the amount of events that are not dispatched yet
+     */
+    struct epoll_event ready_events[EV_EPOLL_MAX_EVENTS];
+    int ready_count;
+    int ready_index;
+#endif
 } event_system;
 
+/**
+ * returns the current time of the clock the event system schedules timed events with
+ * @return the monotonic time in nanoseconds
+ */
+evtime_t get_nanotime();
+
+/**
+ * a virtual clock for simulations. A loop on it never sleeps while a timed event is enabled, so hours of heartbeats
+ * and timeouts pass within seconds. The time only jumps when no fd event is ready, so every entity of the simulation
+ * has to run in the same loop and send through transports that are readable as soon as they were written to, like
+ * UDP on the loopback interface or the shared memory rings
+ * @param clock the clock
+ * @param start the time the clock starts at, not 0. get_nanotime() fits the timestamps taken before the loop started
+ */
+void event_clock_init_virtual(event_clock* clock, evtime_t start);
+
+/**
+ * @param clock the clock, NULL for get_nanotime()
+ * @return the current time of the clock in nanoseconds
+ */
+evtime_t event_clock_read(event_clock* clock);
+
+/**
+ * returns the time of the current iteration of the event loop that runs on the calling thread. The loop reads the
+ * clock once when it wakes up, so the callbacks of an iteration share that time instead of reading the clock again.
+ * Threads that do not run an event loop get the current time of get_nanotime()
+ * @return the monotonic time in nanoseconds
+ */
+evtime_t event_system_now();
+
+/**
+ * @return event_system_now() in microseconds
+ */
+uint64_t event_system_now_us();
+
+/**
+ * @return event_system_now() in milliseconds, truncated to the 32 bit of a RaSTA timestamp
+ */
+uint32_t event_system_now_ms();
+
 /**
  * starts an event loop with the given events
  * the events may not be removed while the loop is running, but can be modified
@@ -109,6 +328,75 @@ void add_timed_event(event_system* ev_sys, timed_event* event);
  */
 void remove_timed_event(event_system* ev_sys, timed_event* event);
 
+/**
+ * names a callback in the profile, so event_profile_describe() can print the name instead of the address
+ * @param profile the profile
+ * @param callback the callback
+ * @param name the name, has to stay valid as long as the profile
+ */
+void event_profile_name(event_profile* profile, event_ptr callback, const char* name);
+
+/**
+ * looks up the measurements of a callback
+ * @param profile the profile
+ * @param callback the callback
+ * @return the measurements, NULL if the callback was not called or named yet
+ */
+const struct event_profile_entry* event_profile_get(const event_profile* profile, event_ptr callback);
+
+/**
+ * clears the measurements of the profile, the names of the callbacks are kept
+ * @param profile the profile
+ */
+void event_profile_reset(event_profile* profile);
+
+/**
+ * describes the measurements of a callback in one line without a newline
+ * @param entry the measurements
+ * @param out the text is written in here
+ * @param size the size of @p out, longer texts are truncated
+ */
+void event_profile_describe(const struct event_profile_entry* entry, char* out, size_t size);
+
+/**
+ * writes event_profile_describe() of every called callback, one per line
+ * @param profile the profile
+ * @param out the stream to write to
+ */
+void event_profile_dump(const event_profile* profile, FILE* out);
+
+/**
+ * lets other threads hand work to the loop with event_system_post(). Has to be called on the thread that owns the
+ * event system before other threads post, the loop may already be running
+ * @param ev_sys the event system
+ * @param capacity the minimum amount of tasks that can wait at the same time, rounded up to a power of two
+ */
+void event_system_enable_posting(event_system* ev_sys, unsigned int capacity);
+
+/**
+ * stops posting, the tasks that are still queued are not run. Has to be called on the thread that owns the event
+ * system after the other threads stopped posting
+ * @param ev_sys the event system
+ */
+void event_system_disable_posting(event_system* ev_sys);
+
+/**
+ * runs a function on the thread of the event loop. May be called from any thread, without locking. The tasks of one
+ * thread run in the order they were posted, at most EV_TASK_BATCH per wakeup of the loop
+ * @param ev_sys the event system, posting has to be enabled with event_system_enable_posting()
+ * @param callback the function, return 0 to keep the loop running, everything else stops the loop
+ * @param carry_data the argument of @p callback
+ * @return 1 if the task is queued, 0 if the queue is full and the task will not run
+ */
+int event_system_post(event_system* ev_sys, event_ptr callback, void* carry_data);
+
+/**
+ * wakes up the event loop without a task, e.g. so a busy polling loop or a loop that sleeps until its next timed
+ * event looks at state that another thread changed. May be called from any thread
+ * @param ev_sys the event system, posting has to be enabled with event_system_enable_posting()
+ */
+void event_system_wakeup(event_system* ev_sys);
+
 #define EV_READABLE    (1 << 0)
 #define EV_WRITABLE    (1 << 1)
 #define EV_EXCEPTIONAL (1 << 2)
@@ -6,41 +6,14 @@ extern "C" {  // only need to export C interface if
               // used by C++ source code
 #endif
 
-/**
- * Representation of an element in the FIFO
- */
-struct fifo_element{
-    /**
-     * The data
-     */
-    void * data;
-    /**
-     * The pointer to the next FIFO element.
-     */
-    struct fifo_element * next;
-};
+#include <stddef.h>
 
 /**
- * Representation of a simple FIFO data structure.
+ * Representation of a simple FIFO data structure. The FIFO is a ring of slots that is allocated once, so
+ * pushing and popping do not allocate memory.
+ * One thread may push while another thread pops without any locking (single producer, single consumer)
  */
-typedef struct {
-    /**
-     * The amount of elements in the FIFO
-     */
-    unsigned int size;
-    /**
-     * The maximum amount of elements in the FIFO
-     */
-    unsigned int max_size;
-    /**
-     * The first (oldest) element of the FIFO
-     */
-    struct fifo_element * head;
-    /**
-     * The last (newest) element in the FIFO
-     */
-    struct fifo_element * tail;
-}fifo_t;
+typedef struct fifo fifo_t;
 
 /**
  * Initializes an empty FIFO with given maximum amount of elements.
@@ -49,6 +22,21 @@ typedef struct {
  */
 fifo_t * fifo_init(unsigned int max_size);
 
+/**
+ * Gets the amount of memory that fifo_init_in() needs for a FIFO with given maximum amount of elements.
+ * @param max_size maximum amount of elements in the queue
+ * @return the size in bytes, a multiple of the size of a pointer
+ */
+size_t fifo_memory_size(unsigned int max_size);
+
+/**
+ * Initializes an empty FIFO in memory of the caller, so nothing is allocated. fifo_destroy() must not be called on it
+ * @param memory fifo_memory_size(max_size) bytes that are aligned like a pointer
+ * @param max_size maximum amount of elements in the queue
+ * @return an initialized FIFO at the beginning of @p memory
+ */
+fifo_t * fifo_init_in(void * memory, unsigned int max_size);
+
 /**
  * Destroys the given FIFO and all elements that are still inside.
  * Note: the data of the elements is NOT freed
@@ -56,6 +44,14 @@ fifo_t * fifo_init(unsigned int max_size);
  */
 void fifo_destroy(fifo_t * fifo);
 
+/**
+ * Removes all elements from the FIFO. Neither the producer nor the consumer may use it meanwhile.
+ * Note: the data of the elements is NOT freed
+ * @param fifo the FIFO to use
+ * @param position the amount of elements that count as pushed and popped so far, 0 like a new FIFO
+ */
+void fifo_reset(fifo_t * fifo, unsigned int position);
+
 /**
  * Retrieves the first (oldest) element from the FIFO and removes it from the FIFO.
  * @param fifo the FIFO to use
@@ -63,10 +59,18 @@ void fifo_destroy(fifo_t * fifo);
  */
 void * fifo_pop(fifo_t * fifo);
 
+/**
+ * Retrieves the first (oldest) element from the FIFO without removing it. Only the consumer may call this
+ * @param fifo the FIFO to use
+ * @return the data of the first element or NULL if the FIFO is empty
+ */
+void * fifo_peek(fifo_t * fifo);
+
 /**
  * Adds an element to the end of the FIFO. If the FIFO is full, nothing is done.
  * @param fifo the FIFO to use
  * @param element the data to insert
+ * @return 1 if the element was added, 0 if the FIFO is full or @p element is NULL
  */
 int fifo_push(fifo_t * fifo, void * element);
 
@@ -77,6 +81,13 @@ int fifo_push(fifo_t * fifo, void * element);
  */
 unsigned int fifo_get_size(fifo_t * fifo);
 
+/**
+ * Gets the maximum amount of elements in the FIFO.
+ * @param fifo the FIFO to use
+ * @return the max_size the FIFO was initialized with
+ */
+unsigned int fifo_get_capacity(fifo_t * fifo);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@ extern "C" {  // only need to export C interface if
 #ifdef ENABLE_OPAQUE
 
 #include <opaque.h>
+#include <pthread.h>
 
 #endif
 
@@ -31,6 +32,10 @@ enum KEY_EXCHANGE_MODE {
  * Allow client's rekeying Key Exchange Request to be received up to 500 ms after it was due
  */
 #define REKEYING_ALLOWED_DELAY_MS 500
+#ifdef ENABLE_OPAQUE
+struct key_exchange_secrets;
+#endif
+
 /**
  * Holds state required for key exchange
  */
@@ -44,6 +49,10 @@ struct key_exchange_state {
      * Holds the PSK and other secret data in the client
      */
     uint8_t *client_secret;
+    /**
+     * the pool client_secret was taken from, NULL if it was allocated and locked on its own
+     */
+    struct key_exchange_secrets *secret_owner;
     /**
      * Holds the client public record to be sent to or received by the server
      */
@@ -88,13 +97,140 @@ struct RastaConfigKex {
      * Rekeying interval or 0 when no rekeying is disabled
      */
     uint64_t rekeying_interval_ms;
+    /**
+     * every rekeying interval of a connection is shortened by a random amount of up to this percentage of it, so the
+     * connections that were established together do not rekey together. At most 50
+     */
+    unsigned int rekeying_jitter_percent;
+    /**
+     * the amount of connections of a handle that may rekey at once, 0 for no limit
+     */
+    unsigned int rekeying_max_concurrent;
 
 #ifdef ENABLE_OPAQUE
     bool has_psk_record;
     uint8_t psk_record[OPAQUE_USER_RECORD_LEN];
+    /**
+     * the amount of threads that compute the key exchanges, so the event loop does not have to
+     */
+    unsigned int worker_count;
+    /**
+     * the amount of key exchange computations that can be running or waiting for a worker at once
+     */
+    unsigned int max_pending;
+    /**
+     * the client prepares the credential request of the next rekeying on a worker right after a key exchange, so the
+     * due rekeying only sends it
+     */
+    bool precompute;
 #endif
 };
 
+#ifdef ENABLE_OPAQUE
+/**
+ * amount of user records a struct key_exchange_secrets keeps, the record of a further pair of RaSTA IDs replaces one
+ */
+#define KEX_RECORD_CACHE_SLOTS 64
+
+/**
+ * amount of client secrets a struct key_exchange_secrets lends at once, further secrets are allocated and locked one
+ * by one
+ */
+#define KEX_SECRET_SLOTS 32
+
+/**
+ * size of a lent client secret, large enough for the longest PSK
+ */
+#define KEX_SECRET_SLOT_SIZE (KEX_PSK_MAX + OPAQUE_USER_SESSION_SECRET_LEN)
+
+/**
+ * the user record of a pair of RaSTA IDs
+ */
+struct key_exchange_record {
+    uint32_t my_id;
+    uint32_t remote_id;
+    uint8_t used;
+    uint8_t user_record[OPAQUE_USER_RECORD_LEN];
+};
+
+/**
+ * The secrets a handle keeps across its key exchanges, in pages that are locked in memory and excluded from core
+ * dumps: the user records derived from the PSK, so a rekeying server does not run the registration again, and the
+ * client secrets lent to the credential requests. The PSK of a handle does not change, so the records stay valid as
+ * long as the handle. Shared by the workers of the kex_pool
+ */
+struct key_exchange_secrets {
+    /**
+     * the locked pages, NULL if they could not be locked. The records and the client secrets are prepared on their own
+     * then
+     */
+    void *pages;
+    size_t pages_length;
+
+    struct key_exchange_record *records;
+    uint8_t *secret_slots;
+    uint8_t secret_taken[KEX_SECRET_SLOTS];
+
+    /**
+     * the amount of user records that were found and that had to be derived
+     */
+    uint64_t record_hits;
+    uint64_t record_misses;
+
+    pthread_mutex_t lock;
+};
+
+/**
+ * maps and locks the pages of the secrets
+ * @param secrets the secrets
+ * @param logger
+ * @return 0 on success, 1 if the pages could not be locked. The secrets can be used either way
+ */
+int key_exchange_secrets_init(struct key_exchange_secrets *secrets, struct logger_t *logger);
+
+/**
+ * erases the secrets and unmaps their pages. The client secrets that are lent must not be used anymore
+ * @param secrets the secrets
+ */
+void key_exchange_secrets_free(struct key_exchange_secrets *secrets);
+
+/**
+ * [SERVER] like key_exchange_prepare_from_psk(), but takes the user record of the RaSTA IDs from @p secrets if it was
+ * derived before and keeps a derived one there
+ * @param secrets the secrets of the handle
+ * @param kex_state Key exchange state
+ * @param psk Null-terminated pre-shared key
+ * @param my_id server RaSTA ID
+ * @param remote_id client RaSTA ID
+ * @param logger
+ * @return 0 on success
+ */
+int key_exchange_prepare_from_psk_cached(struct key_exchange_secrets *secrets, struct key_exchange_state *kex_state,
+                                         const char *psk, uint32_t my_id, uint32_t remote_id,
+                                         struct logger_t *logger);
+
+/**
+ * [CLIENT] like key_exchange_prepare_credential_request(), but the client secret is lent from @p secrets while a slot
+ * is free. kex_recover_credential() gives it back
+ * @param secrets the secrets of the handle
+ * @param kex_state Key exchange state
+ * @param psk Null-terminated pre-shared key
+ * @param logger
+ * @return 0 on success
+ */
+int key_exchange_prepare_credential_request_pooled(struct key_exchange_secrets *secrets,
+                                                   struct key_exchange_state *kex_state, const char *psk,
+                                                   struct logger_t *logger);
+
+/**
+ * [CLIENT] erases the client secret of a prepared credential request and gives it back, for a request that is not
+ * recovered with kex_recover_credential(). Nothing happens if there is no client secret
+ * @param kex_state Key exchange state
+ * @return 0 on success, otherwise the pages of a client secret that was allocated on its own could not be unlocked
+ */
+int key_exchange_discard_credential_request(struct key_exchange_state *kex_state);
+#endif
+
 /**
  * [SERVER] Prepare a user record from a PSK and the RaSTA IDs
  * @param kex_state Key exchange state
@@ -4,6 +4,12 @@
  *
  * The supported log level are
  * Debug, Info, Error (and None which can only be used to specify the maximum log level)
+ *
+ * By default, a message is written by the thread that logs it. An asynchronous logger formats the messages into a
+ * ring of preallocated records instead, they are written by a background thread
+ *
+ * logger_log() and logger_hexdump() are macros that check the log level before the arguments are evaluated. The
+ * calls of log levels above RASTA_LOG_LEVEL_COMPILED are removed by the compiler
  */
 
 #ifndef LST_SIMULATOR_LOGGING_H
@@ -15,21 +21,28 @@ extern "C" {  // only need to export C interface if
 #endif
 
 #include <mqueue.h>
-#include "fifo.h"
 #include <stdio.h>
 
 #define LOG_FORMAT "[%s][%s][%s] %s\n"
 
 /**
- * maximum amount of log messages in the buffer
+ * the most detailed log level that is compiled in: 3 = DEBUG, 2 = INFO, 1 = ERROR, 0 = NONE.
+ * Set with the CMake option RASTA_LOG_LEVEL_COMPILED
  */
-#define LOGGER_BUFFER_SIZE 10
+#ifndef RASTA_LOG_LEVEL_COMPILED
+#define RASTA_LOG_LEVEL_COMPILED 3
+#endif
 
 /**
  * maximum size of log messages in bytes
  */
 #define LOGGER_MAX_MSG_SIZE 4096
 
+/**
+ * maximum size of a log message of an asynchronous logger in bytes, longer messages are truncated
+ */
+#define LOGGER_ASYNC_RECORD_SIZE 1024
+
 /**
  * the log level
  */
@@ -72,24 +85,14 @@ typedef enum {
 }logger_type;
 
 /**
- * wrapper struct to pass multiple parameters to the write thread handler
+ * the ring and the writer thread of an asynchronous logger
  */
-typedef struct {
-    /**
-     * the buffer FIFO
-     */
-    fifo_t * buffer;
+struct logger_async;
 
-    /**
-     * if logger is Console or Both: path to the log file. NULL otherwise
-     */
-    char * log_file;
-
-    /**
-     * the type of the logger
-     */
-    logger_type type;
-}write_thread_parameter_wrapper;
+/**
+ * the binary trace of a logger, see rastatrace.h
+ */
+struct rasta_trace;
 
 /**
  * represents a logger
@@ -111,14 +114,14 @@ struct logger_t{
     char* log_file;
 
     /**
-     * the FIFO that is used to buffer log messages
+     * the ring and the writer thread if the logger is asynchronous, NULL otherwise. Copies of the logger share it
      */
-    fifo_t * buffer;
+    struct logger_async * async;
 
     /**
-     * the pointer to the wrapper that was passed to the write thread. Used to free in logger_destroy.
+     * the binary trace that records the hot path events, NULL if they are not traced. Copies of the logger share it
      */
-    write_thread_parameter_wrapper * wrapper_ptr;
+    struct rasta_trace * trace;
 };
 
 /**
@@ -136,6 +139,30 @@ struct logger_t logger_init(log_level max_log_level, logger_type type);
  */
 void logger_set_log_file(struct logger_t* logger, char * path);
 
+/**
+ * makes the logger asynchronous, the messages are written by a background thread afterwards. The log file is opened
+ * once, so logger_set_log_file() has to be called before.
+ * When all records are taken, new messages are dropped and counted
+ * @param logger the logger
+ * @param record_count the amount of messages that can wait for the background thread
+ */
+void logger_enable_async(struct logger_t * logger, unsigned int record_count);
+
+/**
+ * records the hot path events of the logger into a binary trace file, independent of the log level
+ * @param logger the logger
+ * @param path the path to the trace file
+ * @param record_count the amount of records in the ring of the trace file
+ */
+void logger_enable_trace(struct logger_t * logger, const char * path, unsigned int record_count);
+
+/**
+ * the amount of messages an asynchronous logger dropped, because all of its records were taken
+ * @param logger the logger
+ * @return the amount of dropped messages, always 0 for a synchronous logger
+ */
+unsigned long logger_dropped_messages(const struct logger_t * logger);
+
 /**
  * logs a message
  * @param logger the logger which should be used
@@ -144,7 +171,7 @@ void logger_set_log_file(struct logger_t* logger, char * path);
  * @param format the message which should be logged. can contain formatting information like %s, %d, ...
  * @param ... the format parameters
  */
-void logger_log(struct logger_t * logger, log_level level, char* location ,char* format, ...) __attribute__ ((format (printf, 4, 5)));
+void (logger_log)(struct logger_t * logger, log_level level, char* location ,char* format, ...) __attribute__ ((format (printf, 4, 5)));
 
 /**
  * logs a message of a specified condition is true (1)
@@ -158,7 +185,7 @@ void logger_log(struct logger_t * logger, log_level level, char* location ,char*
 void logger_log_if(struct logger_t * logger, int cond, log_level level, char * location, char * format, ...)  __attribute__ ((format (printf, 5, 6)));
 
 /**
- * stops the write thread and frees resources of the logger
+ * writes the remaining messages, stops the writer thread and frees resources of the logger
  * @param logger the logger that is cleared
  */
 void logger_destroy(struct logger_t * logger);
@@ -172,7 +199,25 @@ void logger_destroy(struct logger_t * logger);
  * @param header_fmt format for an extra header, can contain formatting information like %s, %d, ...
  * @param ... format parameters
  */
-void logger_hexdump(struct logger_t *logger, log_level level, const void *data, size_t data_length, char *header_fmt, ...);
+void (logger_hexdump)(struct logger_t *logger, log_level level, const void *data, size_t data_length, char *header_fmt, ...);
+
+/**
+ * checks if a logger logs the messages of a log level
+ * @param logger the logger, may be NULL
+ * @param level the log level of the message
+ * @return 1 if the message is logged, 0 otherwise
+ */
+static inline int logger_enabled(const struct logger_t * logger, log_level level) {
+    return logger != NULL && logger->max_log_level != LOG_LEVEL_NONE && level <= logger->max_log_level;
+}
+
+#define logger_log(logger, level, ...) \
+    ((int) (level) <= RASTA_LOG_LEVEL_COMPILED && logger_enabled((logger), (level)) ? \
+     (logger_log)((logger), (level), __VA_ARGS__) : (void) 0)
+
+#define logger_hexdump(logger, level, ...) \
+    ((int) (level) <= RASTA_LOG_LEVEL_COMPILED && logger_enabled((logger), (level)) ? \
+     (logger_hexdump)((logger), (level), __VA_ARGS__) : (void) 0)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,63 @@
+#ifndef LST_SIMULATOR_MPSCQUEUE_H
+#define LST_SIMULATOR_MPSCQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+/**
+ * Representation of a bounded queue that any amount of threads may add to while a single thread takes the elements
+ * out, without any locking (multiple producers, single consumer).
+ * The elements are slots of a fixed size that are allocated once and written and read in place
+ */
+typedef struct mpsc_queue mpsc_queue_t;
+
+/**
+ * Initializes an empty queue
+ * @param max_size the minimum amount of elements in the queue, rounded up to a power of two
+ * @param element_size the size of an element in bytes
+ * @return an initialized queue
+ */
+mpsc_queue_t * mpsc_queue_init(unsigned int max_size, unsigned int element_size);
+
+/**
+ * Destroys the queue and the elements that are still inside
+ * @param queue the queue to free
+ */
+void mpsc_queue_destroy(mpsc_queue_t * queue);
+
+/**
+ * Reserves the slot at the end of the queue. May be called from any thread. The element is only visible to the
+ * consumer after mpsc_queue_commit() was called
+ * @param queue the queue to use
+ * @return the slot of the new element or NULL if the queue is full
+ */
+void * mpsc_queue_reserve(mpsc_queue_t * queue);
+
+/**
+ * Hands a slot returned by mpsc_queue_reserve() to the consumer
+ * @param queue the queue to use
+ * @param element the written slot
+ */
+void mpsc_queue_commit(mpsc_queue_t * queue, void * element);
+
+/**
+ * Gets the first (oldest) element that was committed. Only the consumer may call this
+ * @param queue the queue to use
+ * @return the slot of the element or NULL if the queue is empty or the oldest element is not committed yet
+ */
+void * mpsc_queue_front(mpsc_queue_t * queue);
+
+/**
+ * Removes the element returned by mpsc_queue_front(), the slot can be reused by the producers afterwards.
+ * Only the consumer may call this
+ * @param queue the queue to use
+ */
+void mpsc_queue_release(mpsc_queue_t * queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_MPSCQUEUE_H
@@ -0,0 +1,459 @@
+#ifndef INCLUDE_RASTA_HPP
+#define INCLUDE_RASTA_HPP
+
+/**
+ * A header-only C++17 wrapper of the RaSTA API. It owns the handle and the received messages, and it calls functors
+ * from the notifications without type erasure. No message is copied besides the copies the C core makes itself:
+ * into the send queue when a message is sent and into the application messages when one is received.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <rasta_lib.h>
+#include <rasta_new.h>
+#include <rastaidindex.h>
+#include <rmemory.h>
+
+namespace rasta {
+
+// Messages that are passed to the C core at once when a range of messages is sent
+inline constexpr unsigned int MAX_MESSAGES_PER_CALL = 16;
+
+/**
+ * The bytes of one message, a std::span<const std::byte> that is available in C++17
+ */
+class ByteView {
+ public:
+    constexpr ByteView() = default;
+
+    ByteView(const void* data, size_t size) : _data(static_cast<const std::byte*>(data)), _size(size) {}
+
+    /**
+     * Views the elements of a contiguous container like std::string, std::vector or std::array
+     */
+    template <typename Container,
+              typename Element = std::remove_pointer_t<decltype(std::data(std::declval<const Container&>()))>,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Container>, ByteView> &&
+                                          std::is_trivially_copyable_v<Element>>>
+    ByteView(const Container& container)  // NOLINT(google-explicit-constructor)
+            : ByteView(std::data(container), std::size(container) * sizeof(Element)) {}
+
+    const std::byte* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+ private:
+    const std::byte* _data = nullptr;
+    size_t _size = 0;
+};
+
+/**
+ * A received application message. It owns its bytes and can only be moved
+ */
+class Message {
+ public:
+    Message() = default;
+
+    explicit Message(rastaApplicationMessage message) : _sender(message.id), _bytes(message.appMessage) {}
+
+    Message(Message&& other) noexcept : _sender(other._sender), _bytes(other._bytes) {
+        other._bytes.bytes = nullptr;
+        other._bytes.length = 0;
+    }
+
+    Message& operator=(Message&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            _sender = other._sender;
+            _bytes = other._bytes;
+            other._bytes.bytes = nullptr;
+            other._bytes.length = 0;
+        }
+        return *this;
+    }
+
+    Message(const Message&) = delete;
+    Message& operator=(const Message&) = delete;
+
+    ~Message() { Reset(); }
+
+    unsigned long Sender() const { return _sender; }
+    const std::byte* data() const { return reinterpret_cast<const std::byte*>(_bytes.bytes); }
+    size_t size() const { return _bytes.length; }
+    bool empty() const { return _bytes.length == 0; }
+    ByteView View() const { return ByteView(_bytes.bytes, _bytes.length); }
+
+    /**
+     * Passes the ownership of the bytes to the caller, who has to free them with freeRastaByteArray()
+     */
+    struct RastaByteArray Release() {
+        struct RastaByteArray bytes = _bytes;
+        _bytes.bytes = nullptr;
+        _bytes.length = 0;
+        return bytes;
+    }
+
+ private:
+    void Reset() {
+        if (_bytes.bytes != nullptr) {
+            freeRastaByteArray(&_bytes);
+            _bytes.bytes = nullptr;
+        }
+    }
+
+    unsigned long _sender = 0;
+    struct RastaByteArray _bytes = {nullptr, 0};
+};
+
+/**
+ * A connection of a handle. It does not own the connection and must only be used on the thread of the event loop,
+ * while the connection exists
+ */
+class Connection {
+ public:
+    Connection() = default;
+    Connection(struct rasta_handle* h, struct rasta_connection* con) : _h(h), _con(con) {}
+
+    explicit operator bool() const { return _con != nullptr; }
+
+    unsigned long RemoteId() const { return _con->remote_id; }
+    rasta_sr_state State() const { return _con->current_state; }
+    bool IsUp() const { return _con->current_state == RASTA_CONNECTION_UP; }
+
+    /**
+     * Sends one message
+     * @return false if the connection is not up, the message is too long or the send queue is full
+     */
+    bool Send(ByteView message) { return Send(&message, 1); }
+
+    /**
+     * Sends messages in as few data PDUs as possible
+     * @return false if the connection is not up, a message is too long or the send queue has no room for all
+     * messages, no message is sent then. OnWritable() is called once there is room again
+     */
+    template <typename Range,
+              typename = std::enable_if_t<std::is_convertible_v<
+                      decltype(std::data(std::declval<const Range&>())), const ByteView*>>>
+    bool Send(const Range& messages) {
+        return Send(std::data(messages), std::size(messages));
+    }
+
+    bool Send(std::initializer_list<ByteView> messages) { return Send(messages.begin(), messages.size()); }
+
+    bool Send(const ByteView* messages, size_t count) {
+        if (!IsUp()) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (messages[i].size() > MAX_APP_MSG_LEN) {
+                return false;
+            }
+        }
+        if (count > Writable()) {
+            // like the C core, so OnWritable() is called once there is room
+            _con->send_blocked = 1;
+            return false;
+        }
+
+        unsigned int per_call = _h->config.values.sending.max_packet;
+        if (per_call > MAX_MESSAGES_PER_CALL) {
+            per_call = MAX_MESSAGES_PER_CALL;
+        }
+
+        // the C core copies the messages into the send queue, so they are passed as they are
+        struct RastaByteArray arrays[MAX_MESSAGES_PER_CALL];
+        for (size_t sent = 0; sent < count;) {
+            unsigned int n = 0;
+            for (; n < per_call && sent + n < count; n++) {
+                arrays[n].bytes = const_cast<unsigned char*>(
+                        reinterpret_cast<const unsigned char*>(messages[sent + n].data()));
+                arrays[n].length = static_cast<unsigned int>(messages[sent + n].size());
+            }
+
+            struct RastaMessageData data;
+            data.count = n;
+            data.data_array = arrays;
+            if (!sr_send_connection(_h, _con, data)) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    /**
+     * @return the messages in the send queue
+     */
+    unsigned int Queued() const { return fifo_get_size(_con->fifo_send); }
+
+    /**
+     * @return the amount of messages that fit into the send queue
+     */
+    unsigned int Writable() const { return fifo_get_capacity(_con->fifo_send) - fifo_get_size(_con->fifo_send); }
+
+    /**
+     * @return the received messages that were not read with Receive() yet
+     */
+    unsigned int Pending() const { return fifo_get_size(_con->fifo_app_msg); }
+
+    /**
+     * @return the oldest received message, or an empty message without a sender if there is none
+     */
+    Message Receive() {
+        if (Pending() == 0) {
+            return Message();
+        }
+        return Message(sr_get_received_data(_h, _con));
+    }
+
+    void Disconnect() { sr_disconnect(_h, _con); }
+
+    struct rasta_connection* Native() const { return _con; }
+
+ private:
+    struct rasta_handle* _h = nullptr;
+    struct rasta_connection* _con = nullptr;
+};
+
+namespace detail {
+
+struct Callback {
+    void* target;
+    void (*destroy)(void*);
+};
+
+template <typename F>
+void DestroyCallback(void* target) {
+    delete static_cast<F*>(target);
+}
+
+/**
+ * Everything a Handle owns. The configuration is the first member, so the notifications find the state from the
+ * handle they are called with
+ */
+struct State {
+    struct rasta_lib_configuration_s configuration;
+    Callback receive;
+    Callback connection_state_change;
+    Callback handshake_complete;
+    Callback disconnection_request;
+    Callback writable;
+};
+
+static_assert(std::is_standard_layout_v<State>, "the state is found from its first member");
+
+inline State* StateOf(struct rasta_handle* h) {
+    static_assert(offsetof(struct rasta_lib_configuration_s, h) == 0, "the handle is the first member");
+    return reinterpret_cast<State*>(h);
+}
+
+template <typename F>
+F& CallbackOf(const Callback& callback) {
+    return *static_cast<F*>(callback.target);
+}
+
+template <typename F>
+void Replace(Callback& callback, F&& f) {
+    using Stored = std::decay_t<F>;
+    if (callback.destroy != nullptr) {
+        callback.destroy(callback.target);
+    }
+    callback.target = new Stored(std::forward<F>(f));
+    callback.destroy = DestroyCallback<Stored>;
+}
+
+/**
+ * @return the connection the notification was fired for, it is only valid during the notification
+ */
+inline Connection ConnectionOf(struct rasta_notification_result* result) {
+    return Connection(result->handle, result->con);
+}
+
+inline void* StartConnection(rasta_lib_connection_t connection) {
+    (void) connection;
+    return malloc(sizeof(rasta_lib_connection_t));
+}
+
+inline void EndConnection(rasta_lib_connection_t connection, void* memory) {
+    (void) connection;
+    free(memory);
+}
+
+}  // namespace detail
+
+/**
+ * A RaSTA entity with its own event loop. It owns the C handle and the callbacks, it can be moved but not copied.
+ * The callbacks are called on the thread that runs the event loop and must not throw
+ */
+class Handle {
+ public:
+    explicit Handle(const std::string& config_path) : _state(new detail::State()) {
+        rasta_lib_init_configuration(&_state->configuration, config_path.c_str());
+        _state->configuration.callback.on_connection_start = detail::StartConnection;
+        _state->configuration.callback.on_disconnect = detail::EndConnection;
+    }
+
+    Handle(Handle&&) noexcept = default;
+    Handle& operator=(Handle&&) noexcept = default;
+
+    struct rasta_handle* Native() { return &_state->configuration.h; }
+    event_system* Events() { return &_state->configuration.rasta_lib_event_system; }
+    unsigned long Id() const { return _state->configuration.h.config.values.general.rasta_id; }
+
+    /**
+     * Connects to a remote entity, only on the thread of the event loop while it runs
+     */
+    void Connect(unsigned long remote_id, struct RastaIPData* channels) { sr_connect(Native(), remote_id, channels); }
+
+    /**
+     * Connects to many remote entities in paced waves, only on the thread of the event loop while it runs
+     * @return false if the previous bulk connect is not complete yet, see sr_connect_bulk()
+     */
+    bool ConnectBulk(const struct rasta_bulk_peer* peers, unsigned int count) {
+        return sr_connect_bulk(Native(), peers, count) != 0;
+    }
+
+    /**
+     * @return the connection to a remote entity, it is empty if there is none
+     */
+    Connection Find(unsigned long remote_id) {
+        auto* con = static_cast<struct rasta_connection*>(rasta_id_index_get(&Native()->connection_index, remote_id));
+        return Connection(Native(), con);
+    }
+
+    /**
+     * Hands a message to the event loop, may be called from any thread
+     * @return false if the message does not fit into the submission queue
+     */
+    bool Submit(unsigned long remote_id, ByteView message) {
+        struct RastaByteArray array;
+        array.bytes = const_cast<unsigned char*>(reinterpret_cast<const unsigned char*>(message.data()));
+        array.length = static_cast<unsigned int>(message.size());
+
+        struct RastaMessageData data;
+        data.count = 1;
+        data.data_array = &array;
+        return sr_submit(Native(), remote_id, data) != 0;
+    }
+
+    /**
+     * Runs the event loop until an event stops it
+     * @param channel_timeout_ms how long the loop waits for the handshakes of the connections that were initiated
+     */
+    void Run(int channel_timeout_ms) { rasta_lib_start(&_state->configuration, channel_timeout_ms); }
+
+    /**
+     * @param f called with a Connection and a Message for every received message. Replaces OnReadable()
+     */
+    template <typename F>
+    void OnReceive(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->receive, std::forward<F>(f));
+        // called once per data PDU, its messages are taken from the connection at once
+        Native()->notifications.on_receive_bulk = [](struct rasta_notification_result* result) noexcept {
+            detail::State* state = detail::StateOf(result->handle);
+            Connection con = detail::ConnectionOf(result);
+            rastaApplicationMessage messages[MAX_MESSAGES_PER_CALL];
+            unsigned int count;
+            while ((count = sr_get_received_data_bulk(result->handle, result->con, messages,
+                                                      MAX_MESSAGES_PER_CALL)) > 0) {
+                for (unsigned int i = 0; i < count; i++) {
+                    detail::CallbackOf<Stored>(state->receive)(con, Message(messages[i]));
+                }
+            }
+        };
+    }
+
+    /**
+     * @param f called with a Connection once per received data PDU, its messages are taken with Connection::Receive().
+     * Replaces OnReceive(), the messages that are not taken stay in the receive queue of the connection
+     */
+    template <typename F>
+    void OnReadable(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->receive, std::forward<F>(f));
+        Native()->notifications.on_receive_bulk = [](struct rasta_notification_result* result) noexcept {
+            detail::CallbackOf<Stored>(detail::StateOf(result->handle)->receive)(detail::ConnectionOf(result));
+        };
+    }
+
+    /**
+     * @param f called with a Connection whenever its state changed
+     */
+    template <typename F>
+    void OnConnectionStateChange(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->connection_state_change, std::forward<F>(f));
+        Native()->notifications.on_connection_state_change = [](struct rasta_notification_result* result) noexcept {
+            detail::CallbackOf<Stored>(detail::StateOf(result->handle)->connection_state_change)(
+                    detail::ConnectionOf(result));
+        };
+    }
+
+    /**
+     * @param f called with a Connection once its handshake completed
+     */
+    template <typename F>
+    void OnHandshakeComplete(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->handshake_complete, std::forward<F>(f));
+        Native()->notifications.on_handshake_complete = [](struct rasta_notification_result* result) noexcept {
+            detail::CallbackOf<Stored>(detail::StateOf(result->handle)->handshake_complete)(
+                    detail::ConnectionOf(result));
+        };
+    }
+
+    /**
+     * @param f called with a Connection, the reason and the details of a received DiscReq
+     */
+    template <typename F>
+    void OnDisconnectionRequest(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->disconnection_request, std::forward<F>(f));
+        Native()->notifications.on_disconnection_request_received =
+                [](struct rasta_notification_result* result, unsigned short reason, unsigned short details) noexcept {
+            detail::CallbackOf<Stored>(detail::StateOf(result->handle)->disconnection_request)(
+                    detail::ConnectionOf(result), reason, details);
+        };
+    }
+
+    /**
+     * @param f called with a Connection whose send queue was full when Send() was called and has room again
+     */
+    template <typename F>
+    void OnWritable(F&& f) {
+        using Stored = std::decay_t<F>;
+        detail::Replace(_state->writable, std::forward<F>(f));
+        Native()->notifications.on_writable = [](struct rasta_notification_result* result) noexcept {
+            detail::CallbackOf<Stored>(detail::StateOf(result->handle)->writable)(detail::ConnectionOf(result));
+        };
+    }
+
+ private:
+    struct Cleanup {
+        void operator()(detail::State* state) const {
+            sr_cleanup(&state->configuration.h);
+            for (detail::Callback* callback : {&state->receive, &state->connection_state_change,
+                                               &state->handshake_complete, &state->disconnection_request,
+                                               &state->writable}) {
+                if (callback->destroy != nullptr) {
+                    callback->destroy(callback->target);
+                }
+            }
+            delete state;
+        }
+    };
+
+    std::unique_ptr<detail::State, Cleanup> _state;
+};
+
+}  // namespace rasta
+
+#endif  // INCLUDE_RASTA_HPP
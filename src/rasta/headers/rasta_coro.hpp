@@ -0,0 +1,653 @@
+#ifndef INCLUDE_RASTA_CORO_HPP
+#define INCLUDE_RASTA_CORO_HPP
+
+/**
+ * C++20 coroutines on top of the C++ wrapper. A Scheduler takes the notifications of a Handle and resumes the
+ * coroutines that wait for a message, for room in a send queue, for a connection or for a timer. Every coroutine is
+ * resumed on the thread of the event loop, by a task that is posted with event_system_post(), and never from within a
+ * notification. Thousands of sessions can be served by the one thread of the loop without locks.
+ * The awaiters are part of the frame of the coroutine and are linked into the lists of the scheduler, so awaiting a
+ * message or a timer does not allocate. Only starting a coroutine allocates its frame.
+ */
+
+#include <chrono>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include <rasta.hpp>
+
+namespace rasta {
+
+// Tasks of other threads that can wait for the event loop at once, see Scheduler::Schedule()
+inline constexpr unsigned int SCHEDULER_POST_CAPACITY = 1024;
+
+/**
+ * A coroutine that runs on its own, nobody waits for its result. It starts at once on the calling thread and runs
+ * until its first co_await, its frame is freed when it returns. It must not throw
+ */
+class Task {
+ public:
+    struct promise_type {
+        Task get_return_object() noexcept { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+namespace detail {
+
+/**
+ * A suspended coroutine in a list of the scheduler, part of the awaiter the coroutine waits with
+ */
+struct Waiter {
+    std::coroutine_handle<> coroutine;
+    Waiter* next = nullptr;
+};
+
+/**
+ * A list of waiters in the order they were added
+ */
+struct WaiterQueue {
+    Waiter* first = nullptr;
+    Waiter* last = nullptr;
+
+    bool Empty() const { return first == nullptr; }
+
+    void Push(Waiter* waiter) {
+        waiter->next = nullptr;
+        if (last != nullptr) {
+            last->next = waiter;
+        } else {
+            first = waiter;
+        }
+        last = waiter;
+    }
+
+    Waiter* Pop() {
+        Waiter* waiter = first;
+        if (waiter != nullptr) {
+            first = waiter->next;
+            if (first == nullptr) {
+                last = nullptr;
+            }
+        }
+        return waiter;
+    }
+
+    /**
+     * removes the first waiter @p matches returns true for
+     */
+    template <typename Predicate>
+    Waiter* Take(Predicate matches) {
+        Waiter* previous = nullptr;
+        for (Waiter* waiter = first; waiter != nullptr; previous = waiter, waiter = waiter->next) {
+            if (!matches(waiter)) {
+                continue;
+            }
+            if (previous != nullptr) {
+                previous->next = waiter->next;
+            } else {
+                first = waiter->next;
+            }
+            if (last == waiter) {
+                last = previous;
+            }
+            return waiter;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * Appends a waiter to the list of a connection. The index holds the first waiter of every connection, most
+ * connections have a single waiter
+ */
+inline void AppendWaiter(struct rasta_id_index* index, unsigned long remote_id, Waiter* waiter) {
+    waiter->next = nullptr;
+    auto* first = static_cast<Waiter*>(rasta_id_index_get(index, remote_id));
+    if (first == nullptr) {
+        rasta_id_index_put(index, remote_id, waiter);
+        return;
+    }
+    while (first->next != nullptr) {
+        first = first->next;
+    }
+    first->next = waiter;
+}
+
+/**
+ * @return the first waiter of a connection, removed from its list, or nullptr if the connection has none
+ */
+inline Waiter* PopWaiter(struct rasta_id_index* index, unsigned long remote_id) {
+    auto* first = static_cast<Waiter*>(rasta_id_index_get(index, remote_id));
+    if (first == nullptr) {
+        return nullptr;
+    }
+    if (first->next != nullptr) {
+        rasta_id_index_put(index, remote_id, first->next);
+    } else {
+        rasta_id_index_remove(index, remote_id);
+    }
+    return first;
+}
+
+}  // namespace detail
+
+class AsyncConnection;
+
+/**
+ * Resumes the coroutines of a Handle on its event loop. It takes the receive, state change, handshake and writable
+ * notifications of the handle, the notifications have to be called by the event loop (RASTA_CALLBACK_QUEUE = 0).
+ * It is created and destroyed on the thread that owns the handle, before the loop runs or while it is stopped, and it
+ * must be destroyed before the handle. The coroutines that still wait are destroyed with it, besides the ones that
+ * wait in Schedule() and were not resumed yet
+ */
+class Scheduler {
+ public:
+    explicit Scheduler(Handle& handle) : _handle(handle) {
+        rasta_id_index_init(&_receivers);
+        rasta_id_index_init(&_writers);
+
+        // a handle may already let other threads post, e.g. for sr_submit()
+        _owns_posting = _handle.Events()->tasks == nullptr;
+        event_system_enable_posting(_handle.Events(), SCHEDULER_POST_CAPACITY);
+
+        // runs the resumptions while the tasks of other threads fill the queue
+        std::memset(&_drain_retry, 0, sizeof(_drain_retry));
+        _drain_retry.callback = Drain;
+        _drain_retry.carry_data = this;
+        _drain_retry.interval = 0;
+        add_timed_event(_handle.Events(), &_drain_retry);
+
+        _handle.OnReadable([this](Connection con) { Deliver(con); });
+        _handle.OnWritable([this](Connection con) { ResumeWriters(con); });
+        _handle.OnHandshakeComplete([this](Connection con) { Established(con); });
+        _handle.OnConnectionStateChange([this](Connection con) {
+            if (con.State() == RASTA_CONNECTION_CLOSED) {
+                Closed(con.RemoteId());
+            }
+        });
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    ~Scheduler() {
+        // the notifications of the handle would find the scheduler that is gone
+        _handle.OnReadable([](Connection) {});
+        _handle.OnWritable([](Connection) {});
+        _handle.OnHandshakeComplete([](Connection) {});
+        _handle.OnConnectionStateChange([](Connection) {});
+
+        // the frames are only destroyed once they are taken out of every list, their awaiters do not unlink themselves
+        detail::WaiterQueue waiting;
+        for (struct rasta_id_index* index : {&_receivers, &_writers}) {
+            for (unsigned int i = 0; i < index->capacity; i++) {
+                for (auto* waiter = static_cast<detail::Waiter*>(index->entries[i].value); waiter != nullptr;) {
+                    detail::Waiter* next = waiter->next;
+                    waiting.Push(waiter);
+                    waiter = next;
+                }
+            }
+            rasta_id_index_free(index);
+        }
+        for (detail::WaiterQueue* queue : {&_ready, &_connecting, &_accepting}) {
+            while (detail::Waiter* waiter = queue->Pop()) {
+                waiting.Push(waiter);
+            }
+        }
+        event_system* ev_sys = _handle.Events();
+        for (timed_event* event = ev_sys->timed_events.first; event != nullptr;) {
+            timed_event* next = event->next;
+            if (event->callback == SleepAwaiter::Fire) {
+                remove_timed_event(ev_sys, event);
+                waiting.Push(static_cast<SleepAwaiter*>(event->carry_data));
+            }
+            event = next;
+        }
+        while (detail::Waiter* waiter = waiting.Pop()) {
+            waiter->coroutine.destroy();
+        }
+
+        remove_timed_event(ev_sys, &_drain_retry);
+        if (_owns_posting) {
+            event_system_disable_posting(ev_sys);
+        }
+    }
+
+    Handle& GetHandle() { return _handle; }
+
+    /**
+     * Waits for a message of a connection
+     */
+    class ReceiveAwaiter : public detail::Waiter {
+     public:
+        ReceiveAwaiter(Scheduler& scheduler, unsigned long remote_id) : _scheduler(scheduler), _remote_id(remote_id) {}
+
+        bool await_ready() {
+            Connection con = _scheduler._handle.Find(_remote_id);
+            if (!con) {
+                return true;
+            }
+            if (con.Pending() > 0) {
+                _message = con.Receive();
+                return true;
+            }
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            this->coroutine = coroutine;
+            detail::AppendWaiter(&_scheduler._receivers, _remote_id, this);
+        }
+
+        /**
+         * @return the message, a message without a sender if the connection is closed
+         */
+        Message await_resume() { return std::move(_message); }
+
+     private:
+        friend class Scheduler;
+        Scheduler& _scheduler;
+        unsigned long _remote_id;
+        Message _message;
+    };
+
+    /**
+     * Waits until a message is in the send queue of a connection
+     */
+    class SendAwaiter : public detail::Waiter {
+     public:
+        SendAwaiter(Scheduler& scheduler, unsigned long remote_id, ByteView message)
+                : _scheduler(scheduler), _remote_id(remote_id), _message(message) {}
+
+        bool await_ready() {
+            Connection con = _scheduler._handle.Find(_remote_id);
+            if (!con || !con.IsUp() || _message.size() > MAX_APP_MSG_LEN) {
+                return true;
+            }
+            // a full send queue makes the connection fire on_writable once there is room
+            _sent = con.Send(_message);
+            return _sent;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            this->coroutine = coroutine;
+            detail::AppendWaiter(&_scheduler._writers, _remote_id, this);
+        }
+
+        /**
+         * @return false if the connection is not up, the message is too long or the connection closed while the send
+         * queue was full
+         */
+        bool await_resume() const { return _sent; }
+
+     private:
+        friend class Scheduler;
+        Scheduler& _scheduler;
+        unsigned long _remote_id;
+        ByteView _message;
+        bool _sent = false;
+    };
+
+    /**
+     * Waits for a timer, the timer is a timed event of the loop in the frame of the coroutine
+     */
+    class SleepAwaiter : public detail::Waiter {
+     public:
+        SleepAwaiter(Scheduler& scheduler, uint64_t nanoseconds) : _scheduler(scheduler), _nanoseconds(nanoseconds) {}
+
+        bool await_ready() const { return false; }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            this->coroutine = coroutine;
+            std::memset(&_event, 0, sizeof(_event));
+            _event.callback = Fire;
+            _event.carry_data = this;
+            _event.interval = _nanoseconds;
+            enable_timed_event(&_event);
+            add_timed_event(_scheduler._handle.Events(), &_event);
+        }
+
+        void await_resume() const {}
+
+     private:
+        friend class Scheduler;
+
+        static int Fire(void* carry_data) {
+            auto* sleeper = static_cast<SleepAwaiter*>(carry_data);
+            remove_timed_event(sleeper->_event.ev_sys, &sleeper->_event);
+            sleeper->_scheduler.Wake(sleeper);
+            return 0;
+        }
+
+        Scheduler& _scheduler;
+        uint64_t _nanoseconds;
+        timed_event _event;
+    };
+
+    /**
+     * Waits for the handshake of a connection that is initiated
+     */
+    class ConnectAwaiter : public detail::Waiter {
+     public:
+        ConnectAwaiter(Scheduler& scheduler, unsigned long remote_id, struct RastaIPData* channels)
+                : _scheduler(scheduler), _remote_id(remote_id), _channels(channels) {}
+
+        bool await_ready() {
+            Connection con = _scheduler._handle.Find(_remote_id);
+            _up = con && con.IsUp();
+            return _up;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            this->coroutine = coroutine;
+            // queued first, the connection may close while it is initiated
+            _scheduler._connecting.Push(this);
+            if (!_scheduler._handle.Find(_remote_id)) {
+                _scheduler._handle.Connect(_remote_id, _channels);
+            }
+        }
+
+        /**
+         * @return the connection, empty if it closed before the handshake completed
+         */
+        AsyncConnection await_resume() const;
+
+     private:
+        friend class Scheduler;
+        Scheduler& _scheduler;
+        unsigned long _remote_id;
+        struct RastaIPData* _channels;
+        bool _up = false;
+    };
+
+    /**
+     * Waits for a connection that a remote entity initiated
+     */
+    class AcceptAwaiter : public detail::Waiter {
+     public:
+        explicit AcceptAwaiter(Scheduler& scheduler) : _scheduler(scheduler) {}
+
+        bool await_ready() {
+            _scheduler._accept = true;
+            if (_scheduler._accepted.empty()) {
+                return false;
+            }
+            _remote_id = _scheduler._accepted.front();
+            _scheduler._accepted.pop_front();
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            this->coroutine = coroutine;
+            _scheduler._accepting.Push(this);
+        }
+
+        AsyncConnection await_resume() const;
+
+     private:
+        friend class Scheduler;
+        Scheduler& _scheduler;
+        unsigned long _remote_id = 0;
+    };
+
+    /**
+     * Moves a coroutine onto the thread of the event loop, e.g. from another thread or before the loop runs
+     */
+    class ScheduleAwaiter {
+     public:
+        explicit ScheduleAwaiter(Scheduler& scheduler) : _scheduler(scheduler) {}
+
+        bool await_ready() const { return false; }
+
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            // the loop runs EV_TASK_BATCH tasks per wakeup, so a full queue has room again soon
+            while (!event_system_post(_scheduler._handle.Events(), Resume, coroutine.address())) {
+                std::this_thread::yield();
+            }
+        }
+
+        void await_resume() const {}
+
+     private:
+        static int Resume(void* address) {
+            std::coroutine_handle<>::from_address(address).resume();
+            return 0;
+        }
+
+        Scheduler& _scheduler;
+    };
+
+    /**
+     * @return an awaiter for the next message of a connection, only on the thread of the event loop
+     */
+    ReceiveAwaiter Receive(unsigned long remote_id) { return ReceiveAwaiter(*this, remote_id); }
+
+    /**
+     * @return an awaiter that sends a message and waits for room in the send queue if it is full, only on the thread
+     * of the event loop. The bytes have to stay valid until the awaiter resumed
+     */
+    SendAwaiter Send(unsigned long remote_id, ByteView message) { return SendAwaiter(*this, remote_id, message); }
+
+    /**
+     * @return an awaiter that resumes after @p duration on the thread of the event loop. Only on the thread of the
+     * event loop or before the loop runs
+     */
+    template <typename Rep, typename Period>
+    SleepAwaiter Sleep(std::chrono::duration<Rep, Period> duration) {
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return SleepAwaiter(*this, nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+    }
+
+    /**
+     * @return an awaiter that initiates a connection unless it exists and waits for its handshake, only on the thread
+     * of the event loop while it runs. The channels have to stay valid while the connection exists
+     */
+    ConnectAwaiter Connect(unsigned long remote_id, struct RastaIPData* channels) {
+        return ConnectAwaiter(*this, remote_id, channels);
+    }
+
+    /**
+     * @return an awaiter for the next connection that a remote entity initiated, only on the thread of the event loop.
+     * Once Accept() was called, the connections that complete their handshake while no coroutine waits are queued
+     */
+    AcceptAwaiter Accept() { return AcceptAwaiter(*this); }
+
+    /**
+     * @return an awaiter that resumes the coroutine on the thread of the event loop, may be awaited on any thread
+     */
+    ScheduleAwaiter Schedule() { return ScheduleAwaiter(*this); }
+
+    /**
+     * Stops the event loop after the coroutines that are resumed next, only on the thread of the event loop. The
+     * waiting coroutines continue when the loop runs again
+     */
+    void Stop() {
+        _stop = true;
+        PostDrain();
+    }
+
+ private:
+    /**
+     * Resumes a coroutine by the next drain of the ready coroutines
+     */
+    void Wake(detail::Waiter* waiter) {
+        _ready.Push(waiter);
+        PostDrain();
+    }
+
+    void PostDrain() {
+        if (_drain_posted) {
+            return;
+        }
+        _drain_posted = true;
+        if (!event_system_post(_handle.Events(), Drain, this)) {
+            // the queue is full of the tasks of other threads, the timer runs the drain in the next iteration
+            enable_timed_event(&_drain_retry);
+        }
+    }
+
+    static int Drain(void* carry_data) {
+        auto* scheduler = static_cast<Scheduler*>(carry_data);
+        scheduler->_drain_posted = false;
+        disable_timed_event(&scheduler->_drain_retry);
+
+        // the coroutines that are woken up meanwhile are resumed by the next drain, which is posted then
+        detail::WaiterQueue ready = std::exchange(scheduler->_ready, detail::WaiterQueue());
+        while (detail::Waiter* waiter = ready.Pop()) {
+            // the waiter is part of the frame, which may be gone after the resumption
+            waiter->coroutine.resume();
+        }
+
+        if (scheduler->_stop) {
+            scheduler->_stop = false;
+            return 1;
+        }
+        return 0;
+    }
+
+    void Deliver(Connection con) {
+        while (con.Pending() > 0) {
+            auto* receiver = static_cast<ReceiveAwaiter*>(detail::PopWaiter(&_receivers, con.RemoteId()));
+            if (receiver == nullptr) {
+                // the messages stay in the receive queue until a coroutine awaits them
+                break;
+            }
+            receiver->_message = con.Receive();
+            Wake(receiver);
+        }
+    }
+
+    void ResumeWriters(Connection con) {
+        auto* writer = static_cast<SendAwaiter*>(rasta_id_index_get(&_writers, con.RemoteId()));
+        // in order, a message that does not fit blocks the connection again and stays first
+        while (writer != nullptr && con.Send(writer->_message)) {
+            detail::PopWaiter(&_writers, con.RemoteId());
+            writer->_sent = true;
+            Wake(writer);
+            writer = static_cast<SendAwaiter*>(rasta_id_index_get(&_writers, con.RemoteId()));
+        }
+    }
+
+    void Established(Connection con) {
+        unsigned long remote_id = con.RemoteId();
+        bool connected = false;
+        while (detail::Waiter* waiter = _connecting.Take([remote_id](detail::Waiter* candidate) {
+                   return static_cast<ConnectAwaiter*>(candidate)->_remote_id == remote_id;
+               })) {
+            static_cast<ConnectAwaiter*>(waiter)->_up = true;
+            Wake(waiter);
+            connected = true;
+        }
+        if (connected || !_accept) {
+            return;
+        }
+
+        if (detail::Waiter* waiter = _accepting.Pop()) {
+            static_cast<AcceptAwaiter*>(waiter)->_remote_id = remote_id;
+            Wake(waiter);
+        } else {
+            _accepted.push_back(remote_id);
+        }
+    }
+
+    void Closed(unsigned long remote_id) {
+        while (detail::Waiter* receiver = detail::PopWaiter(&_receivers, remote_id)) {
+            Wake(receiver);
+        }
+        while (detail::Waiter* writer = detail::PopWaiter(&_writers, remote_id)) {
+            Wake(writer);
+        }
+        while (detail::Waiter* waiter = _connecting.Take([remote_id](detail::Waiter* candidate) {
+                   return static_cast<ConnectAwaiter*>(candidate)->_remote_id == remote_id;
+               })) {
+            Wake(waiter);
+        }
+    }
+
+    Handle& _handle;
+
+    /**
+     * the first ReceiveAwaiter and SendAwaiter of every connection
+     */
+    struct rasta_id_index _receivers;
+    struct rasta_id_index _writers;
+
+    detail::WaiterQueue _connecting;
+    detail::WaiterQueue _accepting;
+
+    /**
+     * the connections that were accepted while no coroutine waited in Accept(), only after Accept() was called once
+     */
+    std::deque<unsigned long> _accepted;
+    bool _accept = false;
+
+    /**
+     * the coroutines that are resumed by the next drain
+     */
+    detail::WaiterQueue _ready;
+    bool _drain_posted = false;
+    timed_event _drain_retry;
+
+    bool _stop = false;
+    bool _owns_posting = false;
+};
+
+/**
+ * A connection in a coroutine. It only holds the RaSTA ID, so it stays safe to use after the connection closed, and
+ * its awaiters tell that the connection is gone. Only on the thread of the event loop
+ */
+class AsyncConnection {
+ public:
+    AsyncConnection() = default;
+    AsyncConnection(Scheduler& scheduler, unsigned long remote_id) : _scheduler(&scheduler), _remote_id(remote_id) {}
+
+    explicit operator bool() const { return _scheduler != nullptr; }
+
+    unsigned long RemoteId() const { return _remote_id; }
+
+    /**
+     * @return the connection, empty once it closed
+     */
+    Connection Find() const { return _scheduler->GetHandle().Find(_remote_id); }
+
+    /**
+     * co_await conn.Receive() returns the next message, a message without a sender once the connection closed
+     */
+    Scheduler::ReceiveAwaiter Receive() const { return _scheduler->Receive(_remote_id); }
+
+    /**
+     * co_await conn.Send(message) returns false if the message could not be sent, see Scheduler::Send()
+     */
+    Scheduler::SendAwaiter Send(ByteView message) const { return _scheduler->Send(_remote_id, message); }
+
+    void Disconnect() const {
+        Connection con = Find();
+        if (con) {
+            con.Disconnect();
+        }
+    }
+
+ private:
+    Scheduler* _scheduler = nullptr;
+    unsigned long _remote_id = 0;
+};
+
+inline AsyncConnection Scheduler::ConnectAwaiter::await_resume() const {
+    return _up ? AsyncConnection(_scheduler, _remote_id) : AsyncConnection();
+}
+
+inline AsyncConnection Scheduler::AcceptAwaiter::await_resume() const {
+    return AsyncConnection(_scheduler, _remote_id);
+}
+
+}  // namespace rasta
+
+#endif  // INCLUDE_RASTA_CORO_HPP
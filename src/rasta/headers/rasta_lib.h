@@ -6,6 +6,7 @@ extern "C" {  // only need to export C interface if
               // used by C++ source code
 #endif
 
+#include<pthread.h>
 #include<rasta_new.h>
 #include<rastahandle.h>
 
@@ -45,6 +46,149 @@ void rasta_lib_init_configuration(rasta_lib_configuration_t user_configuration,
 
 void rasta_lib_start(rasta_lib_configuration_t user_configuration, int channel_timeout_ms);
 
+/**
+ * one handle of a sharded RaSTA entity together with the thread that runs its event loop
+ */
+struct rasta_lib_shard_s {
+    struct rasta_lib_configuration_s configuration;
+
+    /**
+     * runs rasta_lib_start() for this shard
+     */
+    pthread_t thread;
+
+    /**
+     * the cpu the thread is pinned to or -1
+     */
+    int cpu;
+
+    int channel_timeout_ms;
+
+    /**
+     * eventfd that ends the event loop of the shard
+     */
+    int stop_notify_fd;
+    fd_event stop_event;
+};
+
+/**
+ * a RaSTA entity whose connections are served by several event loops, each in its own thread. Every shard has its
+ * own handle loaded from the same config file. Shard i listens on every configured port + i * the amount of configured
+ * ports, and serves the connections to the remote entities whose RaSTA ID is i modulo the amount of shards. With
+ * RASTA_REUSEPORT, all shards listen on the configured ports instead and the kernel steers every datagram to the shard
+ * of its sender
+ */
+typedef struct rasta_lib_shards_s {
+    struct rasta_lib_shard_s * shards;
+    unsigned int count;
+} rasta_lib_shards_t[1];
+
+/**
+ * initializes the handles of a sharded entity. The callbacks and notifications of every shard are set separately
+ * through rasta_lib_get_shard(), they are called on the thread of that shard
+ * @param shards the sharded entity
+ * @param config_file_path the config file of all shards
+ * @param count the amount of shards, at least 1
+ */
+void rasta_lib_init_shards(rasta_lib_shards_t shards, const char* config_file_path, unsigned int count);
+
+/**
+ * @param shards the sharded entity
+ * @return 1 if all shards listen on the configured ports, so the remote entities connect to them without
+ * rasta_lib_shard_channels()
+ */
+int rasta_lib_shards_share_ports(rasta_lib_shards_t shards);
+
+/**
+ * @param remote_id the RaSTA ID of a remote entity
+ * @param count the amount of shards
+ * @return the index of the shard that serves the connection to @p remote_id
+ */
+unsigned int rasta_lib_shard_index(unsigned long remote_id, unsigned int count);
+
+/**
+ * getter for the shard that serves a connection. sr_connect() is only called on the handle of this shard, before
+ * rasta_lib_start_shards() or on the thread of the shard. sr_submit() may be called from any thread
+ * @param shards the sharded entity
+ * @param remote_id the RaSTA ID of the remote entity
+ * @return the shard that serves the connection to @p remote_id
+ */
+struct rasta_lib_configuration_s * rasta_lib_get_shard(rasta_lib_shards_t shards, unsigned long remote_id);
+
+/**
+ * the transport channels of a shard of a remote sharded entity, i.e. the ports of the shard that serves the local
+ * entity when connecting to a sharded server
+ * @param channels the transport channels from the config of the remote entity
+ * @param channel_count the amount of elements in @p channels and @p shard_channels
+ * @param shard_index the index of the remote shard, see rasta_lib_shard_index()
+ * @param shard_channels the transport channels of the remote shard
+ */
+void rasta_lib_shard_channels(const struct RastaIPData * channels, unsigned int channel_count, unsigned int shard_index,
+                              struct RastaIPData * shard_channels);
+
+/**
+ * starts the event loop of every shard in its own thread
+ * @param shards the sharded entity
+ * @param channel_timeout_ms like in rasta_lib_start()
+ * @param pin_threads if not 0, the thread of shard i only runs on cpu i modulo the amount of online cpus. A shard with a
+ * CPU in RASTA_SHARD_CPUS always runs on that CPU
+ */
+void rasta_lib_start_shards(rasta_lib_shards_t shards, int channel_timeout_ms, int pin_threads);
+
+/**
+ * ends the event loops of all shards and waits for their threads
+ * @param shards the sharded entity
+ */
+void rasta_lib_stop_shards(rasta_lib_shards_t shards);
+
+/**
+ * cleans up the handles of all shards with sr_cleanup() and frees the shards. The shards must not run anymore
+ * @param shards the sharded entity
+ */
+void rasta_lib_cleanup_shards(rasta_lib_shards_t shards);
+
+/**
+ * several RaSTA entities with their own RaSTA IDs that share one set of sockets and one event loop. The first entity
+ * opens the sockets from the config file, the received PDUs are handed to the entity they are addressed to. All
+ * entities use the safety and retransmission settings of the same config file
+ */
+typedef struct rasta_lib_entities_s {
+    struct rasta_lib_configuration_s * entities;
+    unsigned int count;
+} rasta_lib_entities_t[1];
+
+/**
+ * initializes the handles of the entities. The callbacks and notifications of every entity are set separately through
+ * rasta_lib_get_entity()
+ * @param entities the entities
+ * @param config_file_path the config file of all entities
+ * @param rasta_ids the RaSTA IDs of the entities
+ * @param count the amount of elements in @p rasta_ids, at least 1
+ */
+void rasta_lib_init_entities(rasta_lib_entities_t entities, const char* config_file_path, const unsigned long * rasta_ids,
+                             unsigned int count);
+
+/**
+ * @param entities the entities
+ * @param rasta_id the RaSTA ID of an entity
+ * @return the entity with @p rasta_id or NULL
+ */
+struct rasta_lib_configuration_s * rasta_lib_get_entity(rasta_lib_entities_t entities, unsigned long rasta_id);
+
+/**
+ * runs all entities in the event loop of the first entity until it ends
+ * @param entities the entities
+ * @param channel_timeout_ms like in rasta_lib_start()
+ */
+void rasta_lib_start_entities(rasta_lib_entities_t entities, int channel_timeout_ms);
+
+/**
+ * cleans up the handles of all entities with sr_cleanup() and frees them. The first entity is cleaned up last, since
+ * it has the sockets
+ * @param entities the entities
+ */
+void rasta_lib_cleanup_entities(rasta_lib_entities_t entities);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,11 +15,6 @@ extern "C" {  // only need to export C interface if
 #include "rastahandle.h"
 #include "event_system.h"
 
-/**
- * size of ring buffer where data is hold for retransmissions
- */
-#define MAX_QUEUE_SIZE 10 // TODO: maybe in config file
-
 /**
  * the maximum length of application messages in the data of a RaSTA packet.
  * Length of a SCI PDU is max. 44 bytes
@@ -110,19 +105,219 @@ void sr_init_handle(struct rasta_handle* handle, const char* config_file_path);
 void sr_init_handle_manually(struct rasta_handle *handle, struct RastaConfigInfo configuration, struct DictionaryArray accepted_version, struct logger_t logger);
 
 /**
- * connects to another rasta instance
+ * initializes the rasta handle like sr_init_handle(), but moves the RaSTA ID and the local ports from the config file,
+ * so several handles can be initialized from the same config file
+ * @param handle
+ * @param config_file_path
+ * @param id_offset added to the RaSTA ID
+ * @param port_offset added to the port of every local redundancy channel
+ */
+void sr_init_handle_with_offsets(struct rasta_handle* handle, const char* config_file_path, unsigned long id_offset,
+                                 unsigned int port_offset);
+
+/**
+ * initializes the handle of a shard of a sharded entity like sr_init_handle(). With RASTA_REUSEPORT, all shards listen
+ * on the configured ports and the datagrams are steered to the shard that serves their sender, see
+ * rasta_lib_shard_index(). Otherwise, or if DTLS is used, the local ports are moved by @p shard_index * the amount of
+ * ports. The shards have to be initialized in the order of their index
+ * @param handle
+ * @param config_file_path
+ * @param shard_index the index of the shard
+ * @param shard_count the amount of shards
+ */
+void sr_init_shard_handle(struct rasta_handle* handle, const char* config_file_path, unsigned int shard_index,
+                          unsigned int shard_count);
+
+/**
+ * initializes the handle of another RaSTA entity that shares the sockets and the event loop of @p socket_owner, like
+ * sr_init_handle() but with its own RaSTA ID. The PDUs received on the sockets are handed to the entity they are
+ * addressed to. The handle is run together with its owner by sr_begin_shared() and cleaned up before it
+ * @param handle
+ * @param config_file_path the config file of @p socket_owner
+ * @param rasta_id the RaSTA ID of the entity
+ * @param socket_owner the handle that has the sockets, it must not be moved afterwards. NULL if @p handle opens the
+ * sockets itself
+ */
+void sr_init_member_handle(struct rasta_handle* handle, const char* config_file_path, unsigned long rasta_id,
+                           struct rasta_handle* socket_owner);
+
+/**
+ * connects to another rasta instance. With reconnect_min_ms the connection request is sent again if it is not
+ * answered within T_MAX or the connection times out later
  * @param handle
  * @param id
  */
 void sr_connect(struct rasta_handle *handle, unsigned long id, struct RastaIPData *channels);
 
 /**
- * send data to another instance
+ * the delay before a client sends its connection request again: reconnect_min_ms doubled for every previous attempt,
+ * at most reconnect_max_ms, minus a random jitter of up to half of it, so the clients of a restarted server spread
+ * their requests
+ * @param cfg the sending configuration
+ * @param attempt the amount of previous attempts
+ * @param seed the state of rand_r()
+ * @return the delay in ms
+ */
+unsigned int sr_reconnect_delay_ms(struct RastaConfigInfoSending cfg, unsigned int attempt, unsigned int * seed);
+
+/**
+ * a peer of sr_connect_bulk()
+ */
+struct rasta_bulk_peer {
+    unsigned long id;
+    /**
+     * the transport channels of the peer, one for every redundancy channel of the handle like in sr_connect()
+     */
+    struct RastaIPData *channels;
+};
+
+/**
+ * connects to many peers without waiting for one handshake before the next connection request is sent. The requests
+ * are sent in waves of connect_wave_size every connect_wave_interval_ms, the first wave right away, and a wave is
+ * smaller while connect_max_in_flight handshakes are not finished, so the handshakes of the peers overlap and the time
+ * until all peers are connected depends on the round trip time and the pacing instead of the amount of peers. The key
+ * exchange follows the handshake of each connection if it is enabled, the peer counts as connected after it.
+ * A peer that is connected already counts as connected, one whose connection can not be opened or is closed without
+ * reconnect_min_ms counts as failed. The progress is read with sr_get_bulk_connect_status(), on_bulk_connect_complete
+ * is fired once every peer is connected or failed. Only on the thread of the event loop while it runs
+ * @param h the RaSTA handle
+ * @param peers the peers, they are copied
+ * @param count the amount of peers
+ * @return 1 if the bulk connect was started, 0 if @p count is 0 or the previous bulk connect is not complete yet
+ */
+int sr_connect_bulk(struct rasta_handle *h, const struct rasta_bulk_peer *peers, unsigned int count);
+
+/**
+ * the amount of connection requests of the next wave of a bulk connect
+ * @param cfg the sending configuration
+ * @param waiting the amount of peers whose connection requests were not sent yet
+ * @param in_flight the amount of handshakes that are not finished
+ * @return at most connect_wave_size and at most as many as connect_max_in_flight leaves room for
+ */
+unsigned int sr_connect_wave_size(struct RastaConfigInfoSending cfg, unsigned int waiting, unsigned int in_flight);
+
+/**
+ * @param h the RaSTA handle
+ * @param out the progress of the latest bulk connect
+ * @return 1 if @p out was filled, 0 if sr_connect_bulk() was not called
+ */
+int sr_get_bulk_connect_status(struct rasta_handle *h, struct rasta_bulk_connect_status *out);
+
+/**
+ * send data to another instance. The send queue of a connection holds sending.send_max data packets of messages,
+ * if there is no room for all of @p app_messages none of them are queued and the on_writable notification is fired
+ * once there is room again
+ * @param h
+ * @param remote_id
+ * @param app_messages
+ * @return 1 if the messages were queued, 0 if the connection is unknown or not up, there are too many messages for
+ *         one data packet or the send queue is full
+ */
+int sr_send(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages);
+
+/**
+ * send data to another instance in a priority class. The messages of RASTA_SEND_URGENT are put into the next data
+ * packet before any message of RASTA_SEND_BULK and are not held back by RASTA_SEND_COALESCE_US, sr_send() sends in
+ * RASTA_SEND_BULK. The urgent lane holds the messages of two data packets, the bulk lane the ones of sending.send_max
+ * data packets
+ * @param h
+ * @param remote_id
+ * @param app_messages
+ * @param priority the lane of the send queue
+ * @return the same as sr_send(), 0 if the lane is full
+ */
+int sr_send_priority(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages,
+                     rasta_send_priority priority);
+
+/**
+ * like sr_send_priority() but without looking up the connection by its remote id
+ * @param h
+ * @param con the connection
+ * @param app_messages
+ * @param priority the lane of the send queue
+ * @return the same as sr_send_priority()
+ */
+int sr_send_connection_priority(struct rasta_handle *h, struct rasta_connection *con,
+                                struct RastaMessageData app_messages, rasta_send_priority priority);
+
+/**
+ * send data on a connection, like sr_send() but without looking up the connection by its remote id
+ * @param h
+ * @param con the connection, e.g. from a notification or the connection list of the handle
+ * @param app_messages
+ * @return the same as sr_send()
+ */
+int sr_send_connection(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages);
+
+/**
+ * send data to several instances like sr_send(), but the send handler is woken up once for all of them instead of once
+ * per receiver
+ * @param h
+ * @param remote_ids the RaSTA IDs of the receivers, an ID may appear several times
+ * @param app_messages the messages of each receiver, they are copied
+ * @param count the amount of receivers
+ * @return the amount of receivers whose messages were queued
+ */
+unsigned int sr_send_batch(struct rasta_handle *h, const unsigned long *remote_ids,
+                           const struct RastaMessageData *app_messages, unsigned int count);
+
+/**
+ * allocates an application message for sr_send_owned(), so its payload is written in place instead of being copied
+ * into the send queue
+ * @param length the length of the message
+ * @return the message, its bytes are not initialized
+ */
+struct RastaByteArray sr_alloc_message(unsigned int length);
+
+/**
+ * send data to another instance like sr_send(), but the bytes of the messages are handed to the send queue instead of
+ * being copied. They have to be allocated with sr_alloc_message() and are freed once they are sent. The data_array of
+ * @p app_messages stays with the caller
+ * @param h
+ * @param remote_id
+ * @param app_messages
+ * @return the same as sr_send(). If 0 is returned, the messages still belong to the caller
+ */
+int sr_send_owned(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages);
+
+/**
+ * like sr_send_owned() but without looking up the connection by its remote id
+ * @param h
+ * @param con the connection
+ * @param app_messages
+ * @return the same as sr_send_owned()
+ */
+int sr_send_connection_owned(struct rasta_handle *h, struct rasta_connection *con, struct RastaMessageData app_messages);
+
+/**
+ * send data to another instance from any thread. The messages are copied and handed to the event loop without
+ * locking, which passes them to sr_send() in the order they were submitted. Must not be called anymore once
+ * sr_cleanup() started
  * @param h
  * @param remote_id
  * @param app_messages
+ * @return 1 if the messages were submitted, 0 if there are too many or too long messages or the event loop did not
+ *         keep up with the submissions. Submissions wait in the queue while the send queue of their connection is full
+ */
+int sr_submit(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages);
+
+/**
+ * file descriptor that is readable while notifications wait in the callback executor, for applications that run
+ * them with sr_run_callbacks() (RASTA_CALLBACK_THREAD = 0)
+ * @param h
+ * @return the eventfd, -1 if the notifications are called by the event loop
  */
-void sr_send(struct rasta_handle *h, unsigned long remote_id, struct RastaMessageData app_messages);
+int sr_callback_fd(struct rasta_handle *h);
+
+/**
+ * runs the notifications that wait in the callback executor on the calling thread, one at a time and in the order
+ * they were fired. May be called from any thread, also while the event loop runs. The notifications may only use
+ * the functions that are safe on other threads, e.g. sr_get_received_data(), sr_submit() or event_system_post()
+ * @param h
+ * @param max the maximum amount of notifications that are run
+ * @return the amount of notifications that were run
+ */
+unsigned int sr_run_callbacks(struct rasta_handle *h, unsigned int max);
 
 
 /**
@@ -134,6 +329,109 @@ void sr_send(struct rasta_handle *h, unsigned long remote_id, struct RastaMessag
  */
 rastaApplicationMessage sr_get_received_data(struct rasta_handle *h, struct rasta_connection * connection);
 
+/**
+ * moves up to @p max received messages into @p messages at once, e.g. in the onReceiveBulk event. The bytes of the
+ * messages come from the allocator of the library and stay valid until they are freed with
+ * sr_free_received_data_bulk()
+ * @param h
+ * @param connection
+ * @param messages the messages are written in here, in the order they were received
+ * @param max the length of @p messages
+ * @return the amount of messages that were written, 0 if no message is left
+ */
+unsigned int sr_get_received_data_bulk(struct rasta_handle *h, struct rasta_connection * connection,
+                                       rastaApplicationMessage * messages, unsigned int max);
+
+/**
+ * frees the bytes of the messages of sr_get_received_data_bulk()
+ * @param messages the messages
+ * @param count the amount of messages
+ */
+void sr_free_received_data_bulk(rastaApplicationMessage * messages, unsigned int count);
+
+/**
+ * queues the application messages of a received data PDU in the receive queue of a connection and fires on_receive
+ * for each of them. Messages that do not fit are dropped and counted in rasta_connection_metrics#receive_overflows
+ * @param h the receive handle
+ * @param con the connection
+ * @param packet the data PDU
+ */
+void sr_add_app_messages_to_buffer(struct rasta_receive_handle *h, struct rasta_connection * con, struct RastaPacket packet);
+
+/**
+ * the room the receive queue of a connection keeps for the messages of a send window of the partner while
+ * RASTA_RECEIVE_BACKPRESSURE holds back the confirmations
+ * @param cfg the sending configuration
+ * @return the amount of messages, 0 without backpressure
+ */
+unsigned int sr_receive_reserve(struct RastaConfigInfoSending cfg);
+
+/**
+ * confirms a received PDU with the next PDUs that are sent to the partner. With RASTA_RECEIVE_BACKPRESSURE the
+ * confirmation is held back while the receive queue has no room for another send window of messages, so the send
+ * window of the partner closes until the application retrieved its messages
+ * @param h the receive handle
+ * @param connection the connection
+ * @param sequence_number the sequence number of the received PDU
+ */
+void sr_confirm_received(struct rasta_receive_handle *h, struct rasta_connection * connection,
+                         uint32_t sequence_number);
+
+/**
+ * confirms the PDUs whose confirmations were held back, if the receive queue has room again, and sends a heartbeat
+ * with the confirmation, so the partner can send again right away
+ * @param h the receive handle
+ * @param connection the connection
+ * @return 1 if the confirmation is still held back, 0 otherwise
+ */
+int sr_release_received(struct rasta_receive_handle *h, struct rasta_connection * connection);
+
+/**
+ * allocates the diagnostic sub intervals of a connection, one for every DIAGNOSTIC_INTERVAL_SIZE ms up to T_MAX
+ * @param connection the connection
+ * @param cfg the sending configuration
+ */
+void sr_diagnostic_interval_init(struct rasta_connection * connection, struct RastaConfigInfoSending cfg);
+
+/**
+ * counts a received message in the diagnostic sub interval of its round trip delay
+ * @param connection the connection
+ * @param t_rtd the round trip delay of the message in ms
+ * @param t_alive the time since the last confirmed timestamp in ms
+ */
+void sr_diagnostic_record(struct rasta_connection * connection, unsigned long t_rtd, unsigned long t_alive);
+
+/**
+ * counts a received message with a confirmed timestamp in the diagnostic sub intervals, fires on_diagnostic_notification
+ * and starts the next window after diag_window messages
+ * @param connection the connection
+ * @param receivedPacket the received packet
+ * @param cfg the sending configuration
+ * @param h the RaSTA handle
+ */
+void updateDiagnostic(struct rasta_connection * connection, struct RastaPacket receivedPacket,
+                      struct RastaConfigInfoSending cfg, struct rasta_handle *h);
+
+/**
+ * moves the next application messages of the send queue into the data of a data packet, the urgent lane first, and
+ * records how long they waited
+ * @param logger the logger
+ * @param con the connection, its send queue holds at least app_messages->count messages
+ * @param app_messages the messages are written in here, its count is the amount that is taken
+ * @param now the time of the event loop
+ * @param encode_ns the time the data packet is encoded in the nanoseconds of get_nanotime(), 0 if the connection
+ *        records no residency
+ */
+/**
+ * @param logger the logger
+ * @param connection the connection
+ * @return the amount of application messages in both lanes of the send queue
+ */
+unsigned int sr_rasta_send_data_available(struct logger_t *logger, struct rasta_connection * connection);
+
+void sr_take_send_messages(struct logger_t * logger, struct rasta_connection * con,
+                           struct RastaMessageData * app_messages, uint64_t now, uint64_t encode_ns);
+
 /**
  * closes the connection to the connection
  * @param h
@@ -141,6 +439,13 @@ rastaApplicationMessage sr_get_received_data(struct rasta_handle *h, struct rast
  */
 void sr_disconnect(struct rasta_handle *h, struct rasta_connection* con);
 
+/**
+ * closes all connections of the handle, like sr_disconnect() for each of them. The disconnection requests are sent
+ * with one batch
+ * @param h the handle
+ */
+void sr_disconnect_all(struct rasta_handle *h);
+
 /**
  * used to end all threads an free assigned ressources
  * always use this when a programm terminates otherwise it may not start again
@@ -150,6 +455,260 @@ void sr_cleanup(struct rasta_handle *h);
 
 void sr_begin(struct rasta_handle * h, event_system* event_system, int wait_for_handshake);
 
+/**
+ * runs several handles in one event loop like sr_begin(), the first one has the sockets and the others were
+ * initialized with sr_init_member_handle(). The settings of the event loop are taken from the first handle
+ * @param handles the handles
+ * @param count the amount of handles
+ * @param event_system the event loop
+ * @param channel_timeout_ms like in sr_begin()
+ */
+void sr_begin_shared(struct rasta_handle ** handles, unsigned int count, event_system* event_system,
+                     int channel_timeout_ms);
+
+/**
+ * the receive handler of the event loop: processes the PDUs the redundancy layer received, up to the receive budget,
+ * and admits waiting connection requests afterwards. sr_begin() runs it when its eventfd is notified
+ * @param carry_data the rasta_receive_handle of the handle
+ * @return 0, or the value of a notification that terminates the event loop
+ */
+int receive_notification_event(void* carry_data);
+
+/**
+ * the send handler of the event loop: sends a data packet from the send queue of every connection that may send one,
+ * up to RASTA_SEND_BUDGET data packets. The connections take turns, every run starts behind the connection that sent
+ * last
+ * @param carry_data the rasta_sending_handle of the handle
+ * @return 0
+ */
+int data_send_event(void* carry_data);
+
+/**
+ * the heartbeat handler of a connection: sends its heartbeat and the heartbeats of the other connections of the handle
+ * that are due within RASTA_HEARTBEAT_TICK_MS with one batch, and reschedules the events of the other connections
+ * @param carry_data the timed_event_data of the connection
+ * @return 0
+ */
+int heartbeat_send_event(void* carry_data);
+
+/**
+ * the maximum amount of transport channels in a struct rasta_connection_metrics_snapshot
+ */
+#define RASTA_METRICS_MAX_TRANSPORT_CHANNELS 8
+
+/**
+ * the metrics of a connection at one point in time
+ */
+struct rasta_connection_metrics_snapshot {
+    unsigned long remote_id;
+
+    /**
+     * retransmissions and the round trip delay
+     */
+    struct rasta_connection_metrics metrics;
+
+    /**
+     * the error counters as specified in 5.5.5
+     */
+    struct rasta_error_counters errors;
+
+    /**
+     * the amount of application messages waiting in the bulk lane of the send queue, in its urgent lane and to be read
+     * by the application
+     */
+    unsigned int send_queue_size;
+    unsigned int urgent_queue_size;
+    unsigned int receive_queue_size;
+
+    /**
+     * the amount of sent data PDUs that are not confirmed yet
+     */
+    unsigned int retransmission_queue_size;
+
+    /**
+     * the amount of data PDUs that may be unconfirmed at once: the size of the retransmission buffer, at most the
+     * N_SENDMAX of the connection partner
+     */
+    unsigned int send_window;
+
+    /**
+     * the amount of PDUs in the defer queue of the redundancy channel
+     */
+    unsigned int defer_queue_size;
+
+    /**
+     * the time in ms a missing PDU is waited for, T_SEQ or the skew of the transport channels with RASTA_ADAPTIVE_T_SEQ
+     */
+    unsigned int defer_timeout_ms;
+
+    /**
+     * how often the defer queue timed out and missing PDUs were given up
+     */
+    unsigned long defer_timeouts;
+
+    /**
+     * the share of the connection in the batched safety code checks of received PDUs, in nanoseconds
+     */
+    unsigned long safety_code_ns;
+
+    /**
+     * the PDUs passed to and from the SR layer
+     */
+    struct rasta_transport_metrics channel;
+
+    /**
+     * the traffic on each transport channel in the order of the udp sockets, at most
+     * RASTA_METRICS_MAX_TRANSPORT_CHANNELS
+     */
+    unsigned int transport_channel_count;
+    struct rasta_transport_metrics transport_channels[RASTA_METRICS_MAX_TRANSPORT_CHANNELS];
+};
+
+/**
+ * takes a snapshot of the metrics of a connection. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param remote_id the RaSTA ID of the remote entity
+ * @param out the snapshot is written in here
+ * @return 1 if the connection exists, 0 otherwise
+ */
+int sr_get_connection_metrics(struct rasta_handle * h, unsigned long remote_id,
+                              struct rasta_connection_metrics_snapshot * out);
+
+/**
+ * takes a snapshot of how long the messages of a connection waited in the stages of the entity, see
+ * RASTA_RESIDENCY_HISTOGRAMS. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param remote_id the RaSTA ID of the remote entity
+ * @param out the histograms are written in here
+ * @return 1 if the connection exists and records its residency, 0 otherwise
+ */
+int sr_get_connection_residency(struct rasta_handle * h, unsigned long remote_id,
+                                struct rasta_residency_metrics * out);
+
+/**
+ * the amount of peers that sr_write_metrics() ranks by their cost
+ */
+#define RASTA_METRICS_TOP_PEERS 10
+
+/**
+ * ranks the connections by the time the event loop spent on them, ties by their bytes. Has to be called on the thread
+ * of the event loop
+ * @param h the handle
+ * @param out the most expensive connections are written in here, the most expensive one first
+ * @param max the maximum amount of connections in @p out
+ * @return the amount of connections in @p out
+ */
+unsigned int sr_get_top_peers(struct rasta_handle * h, struct rasta_peer_usage * out, unsigned int max);
+
+/**
+ * copies the counters of the transmit queue of a transport channel. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param channel the index of the transport channel
+ * @param out the counters are written in here
+ * @return 1 if the transport channel exists, 0 otherwise
+ */
+int sr_get_transmit_stats(struct rasta_handle * h, unsigned int channel, struct RastaUDPTransmitStats * out);
+
+/**
+ * copies the buffer sizes of the socket of a transport channel and the datagrams the kernel dropped because its
+ * receive buffer was full. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param channel the index of the transport channel
+ * @param out the stats are written in here
+ * @return 1 if the transport channel exists, 0 otherwise
+ */
+int sr_get_socket_stats(struct rasta_handle * h, unsigned int channel, struct RastaUDPBufferStats * out);
+
+/**
+ * copies the traffic on a udp socket, of all connections together, including the copies that were discarded as
+ * duplicates. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param path the index of the udp socket
+ * @param out the counters are written in here
+ * @return 1 if the socket exists, 0 otherwise
+ */
+int sr_get_path_metrics(struct rasta_handle * h, unsigned int path, struct rasta_transport_metrics * out);
+
+/**
+ * copies the counters of the redundancy channels of unknown senders. Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param out the counters are written in here
+ */
+void sr_get_pending_channel_stats(struct rasta_handle * h, struct RastaPendingChannelStats * out);
+
+/**
+ * takes a snapshot of how late the timed events of the event loop fired, in microseconds. May be called from any thread
+ * @param h the handle
+ * @param out the snapshot is written in here
+ */
+void sr_get_loop_lag(struct rasta_handle * h, struct rasta_histogram * out);
+
+/**
+ * takes a snapshot of how long the stages of the receive path took for the batches of received PDUs, in nanoseconds.
+ * May be called from any thread
+ * @param h the handle
+ * @param out the snapshot is written in here
+ */
+void sr_get_receive_stage_metrics(struct rasta_handle * h, struct rasta_receive_stage_metrics * out);
+
+/**
+ * writes the metrics of all connections and of the event loop in the Prometheus text format.
+ * Has to be called on the thread of the event loop
+ * @param h the handle
+ * @param out the stream to write to
+ */
+void sr_write_metrics(struct rasta_handle * h, FILE * out);
+
+/**
+ * opens the Prometheus text endpoint, which serves sr_write_metrics() on every HTTP request while the event loop runs.
+ * Called by sr_init_layers() if RASTA_METRICS_PORT is set, exits the program if the port can not be bound
+ * @param h the handle
+ * @param port the TCP port to listen on
+ */
+void sr_metrics_open_endpoint(struct rasta_handle * h, uint16_t port);
+
+/**
+ * copies the metrics of the connections, of the sockets and of the event loop to the stat page of the handle. Called
+ * by the event loop every RASTA_STAT_INTERVAL_MS if RASTA_STAT_PAGE is set, does nothing without a stat page. Has to
+ * be called on the thread of the event loop
+ * @param h the handle
+ */
+void sr_publish_stat_page(struct rasta_handle * h);
+
+/**
+ * reads the config file of the handle again and applies the parameters that can be changed without dropping the
+ * connections: RASTA_T_H, RASTA_MAX_PACKET, RASTA_DIAG_WINDOW, RASTA_T_SEQ, RASTA_N_DEFERQUEUE_SIZE and
+ * LOGGER_MAX_LEVEL. The other parameters keep their values until the handle is initialized again. Must be called on the
+ * thread of the event loop
+ * @param h the handle
+ * @return 0 if the parameters were applied, -1 if the config file could not be read
+ */
+int sr_reload_config(struct rasta_handle * h);
+
+/**
+ * lets the event loop of the handle call sr_reload_config() when the process receives SIGHUP. SIGHUP is blocked in the
+ * calling thread, so call this before other threads are started, they inherit the signal mask
+ * @param h the handle, not running yet
+ */
+void sr_reload_on_sighup(struct rasta_handle * h);
+
+/**
+ * opens the stream to a hot standby, or the port a standby waits for its primary on, see rastareplication.h. Called by
+ * sr_init_layers() if RASTA_REPLICATION_ROLE is set, exits the program if the socket can not be opened
+ * @param h the handle, not running yet
+ * @param config the role and the address
+ */
+void sr_replication_open(struct rasta_handle * h, struct RastaConfigReplication config);
+
+/**
+ * [STANDBY] continues the replicated connections of the primary and stops waiting for it. Called by the event loop when
+ * the stream to the primary breaks or no round arrived for RASTA_REPLICATION_TIMEOUT_ROUNDS rounds, must be called on
+ * the thread of the event loop
+ * @param h the handle
+ * @return the amount of connections that were taken over
+ */
+unsigned int sr_replication_takeover(struct rasta_handle * h);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,8 @@ extern "C" {  // only need to export C interface if
 #include "rastamodule.h"
 #include "rastaredundancy_new.h"
 #include <udp.h>
+#include "rastaidindex.h"
+#include "rastaexecutor.h"
 
 /**
  * define struct as type here to allow usage in notification pointers
@@ -23,6 +25,14 @@ struct receive_event_data {
     int channel_index;
 };
 
+/**
+ * the writable event of a socket, it is enabled while datagrams wait in the transmit queue of the socket
+ */
+struct transmit_event_data {
+    fd_event event;
+    struct RastaUDPState * state;
+};
+
 /**
  * pointer to a function that will be called in a separate thread when a new entity has sent data to this entity
  * first parameter is the redundancy multiplexer that fired the event
@@ -72,6 +82,24 @@ struct timeout_event_data {
  */
 void init_channel_timeout_events(timed_event * event, struct timeout_event_data * t_data, struct redundancy_mux * mux, int channel_timeout_ms);
 
+/**
+ * the redundancy channels of unknown senders that wait for their connection request to be accepted
+ */
+struct RastaPendingChannelStats {
+    /**
+     * the pending channels
+     */
+    unsigned int count;
+    /**
+     * the pending channels that were evicted for a newer one
+     */
+    unsigned long evictions;
+    /**
+     * the PDUs of pending channels that were dropped because they exceeded RASTA_PENDING_PDU_LIMIT
+     */
+    unsigned long drops;
+};
+
 /**
  * representation of a redundancy layer multiplexer.
  * is used to handle multiple redundancy channels.
@@ -93,15 +121,62 @@ struct redundancy_mux{
     struct RastaUDPState * udp_socket_states;
 
     /**
-     * the redundancy channels to remote entities this multiplexer is aware of
+     * the traffic on every udp socket, of all redundancy channels together. Array has length port_count, a member
+     * shares the one of the owner of the sockets
+     */
+    struct rasta_transport_metrics * path_metrics;
+
+    /**
+     * receive buffers for the udp sockets, lets a single syscall receive multiple PDUs
+     */
+    struct RastaUDPReceiveBatch receive_batch;
+
+    /**
+     * how long the stages of the receive path took. The PDUs that are received on the sockets of this multiplexer are
+     * counted in its first five stages, the SR layer of the entity counts the dispatch stage
+     */
+    struct rasta_receive_stage_metrics receive_stages;
+
+    /**
+     * the redundancy channels to remote entities this multiplexer is aware of.
+     * Every channel is allocated separately, so pointers to it stay valid while other channels are added or removed
      */
-    rasta_redundancy_channel * connected_channels;
+    rasta_redundancy_channel ** connected_channels;
 
     /**
      * the amount of known redundancy channels, i.e. the length of connected_channels
      */
     unsigned int channel_count;
 
+    /**
+     * the amount of allocated slots in connected_channels
+     */
+    unsigned int channel_capacity;
+
+    /**
+     * maps the associated_id of the channels in connected_channels to the channel
+     */
+    struct rasta_id_index channel_index;
+
+    /**
+     * the pending channels of unknown senders, at most max_pending_channels of the redundancy config. Allocated when
+     * the first one is added
+     */
+    rasta_redundancy_channel ** pending_channels;
+    unsigned int pending_count;
+
+    /**
+     * the pending channels that were evicted for a newer one, and the PDUs of pending channels that were dropped
+     * because they exceeded pending_pdu_limit
+     */
+    unsigned long pending_evictions;
+    unsigned long pending_drops;
+
+    /**
+     * index of the redundancy channel that redundancy_mux_try_retrieve_all() checks first
+     */
+    unsigned int next_retrieve_index;
+
     /**
      * the logger that is used to log information
      */
@@ -117,15 +192,58 @@ struct redundancy_mux{
      */
     rasta_redundancy_notifications notifications;
 
+    /**
+     * called on the thread of the event loop when a transport channel received none of the PDUs of a diagnosis
+     * window that the other transport channels of its redundancy channel received, NULL if nobody is told. The
+     * parameters are transport_failure_context, the id of the redundancy channel and the index of the udp socket of the
+     * transport channel
+     */
+    void (*on_transport_failure)(void *, unsigned long, unsigned int);
+    void * transport_failure_context;
+
     /**
      * amount of notification thread that are currently running
      */
      unsigned int notifications_running;
 
+    /**
+     * runs the notifications on other threads than the event loop, NULL if the event loop calls them. Owned by the
+     * RaSTA handle of the multiplexer
+     */
+    struct rasta_callback_executor * callback_executor;
+
      /**
-      * Hashing paramenter for SR layer checksum
+      * Hashing paramenter for SR layer checksum, used to decode every received PDU together with the CRC options
+      * in config. Both are prepared at initialization and only read afterwards
       */
       rasta_hashing_context_t sr_hashing_context;
+
+    /**
+     * the event system of the loop that runs the multiplexer and the eventfd that wakes up the SR layer, set by
+     * redundancy_mux_start_defer_timers(). The defer timers of the channels are only armed while the loop runs
+     */
+    event_system * ev_sys;
+    int receive_notify_fd;
+
+    /**
+     * Non-standard extension: the multiplexer whose sockets this one sends on, NULL if it has sockets of its own. See
+     * redundancy_mux_init_member()
+     */
+    struct redundancy_mux * socket_owner;
+
+    /**
+     * the multiplexers of the other RaSTA entities that share the sockets of this one, indexed by their RaSTA ID. A
+     * received PDU is handed to the multiplexer of its receiver
+     */
+    struct redundancy_mux ** members;
+    unsigned int member_count;
+    struct rasta_id_index member_index;
+
+    /**
+     * one writable event per socket, NULL while the multiplexer is not in an event loop or uses the sockets of its
+     * socket_owner
+     */
+    struct transmit_event_data * transmit_events;
 };
 
 /**
@@ -145,6 +263,25 @@ redundancy_mux redundancy_mux_init(struct logger_t logger, uint16_t * listen_por
  * @return an initialized redundancy layer multiplexer
  */
 redundancy_mux redundancy_mux_init_(struct logger_t logger, struct RastaConfigInfo config);
+/**
+ * initializes the multiplexer of a RaSTA entity that shares the sockets of another multiplexer instead of opening
+ * sockets of its own. It sends on the sockets of @p owner and receives the PDUs addressed to its RaSTA ID from @p owner
+ * once it is added with redundancy_mux_add_member()
+ * @param logger the logger that is used to log information
+ * @param config configuration for redundancy channels, only the RaSTA ID may differ from the config of @p owner
+ * @param owner the multiplexer that has the sockets, it has to be closed after this one
+ * @return an initialized redundancy layer multiplexer
+ */
+redundancy_mux redundancy_mux_init_member(struct logger_t logger, struct RastaConfigInfo config, redundancy_mux * owner);
+
+/**
+ * lets a multiplexer that was initialized with redundancy_mux_init_member() receive the PDUs to its RaSTA ID. It is
+ * removed again when it is closed
+ * @param owner the multiplexer that has the sockets
+ * @param member the multiplexer at its final address
+ */
+void redundancy_mux_add_member(redundancy_mux * owner, redundancy_mux * member);
+
 /**
  * starts the redundancy layer multiplexer and opens (if specified) all redundancy channels
  * @param mux the multiplexer that will be opened
@@ -157,8 +294,99 @@ void redundancy_mux_open(redundancy_mux * mux);
  */
 void redundancy_mux_close(redundancy_mux * mux);
 
+/**
+ * applies the redundancy layer parameters that can be changed while the channels are open. T_SEQ takes effect for the
+ * next deferred PDU, the defer queues and receive buffers are resized. The new channels use all parameters
+ * @param mux the multiplexer
+ * @param t_seq the new T_SEQ in milliseconds
+ * @param n_deferqueue_size the new size of the defer queues
+ * @return the amount of channels whose buffers hold too many PDUs to be resized now, they keep their size
+ */
+unsigned int redundancy_mux_reconfigure(redundancy_mux * mux, unsigned int t_seq, unsigned int n_deferqueue_size);
+
+/**
+ * changes the maximum log level of a multiplexer and its channels
+ * @param mux the multiplexer
+ * @param max_log_level the new maximum log level
+ */
+void redundancy_mux_set_log_level(redundancy_mux * mux, log_level max_log_level);
+
+/**
+ * receives all PDUs that are queued on a UDP socket with a single syscall and hands them to the multiplexer of their
+ * receiver
+ * @param mux the multiplexer that has the socket
+ * @param channel_id the index of the udp socket
+ */
+void receive_packet(redundancy_mux * mux, int channel_id);
+
 int channel_receive_event(void * carry_data);
 
+/**
+ * ends the diagnosis window of every transport channel of the multiplexer as described in 6.6.3.2, fires the
+ * diagnostic notification for each of them and starts the next window
+ * @param mux the redundancy multiplexer
+ */
+void redundancy_mux_diagnose(redundancy_mux * mux);
+
+/**
+ * the callback of the diagnostics event, calls redundancy_mux_diagnose()
+ * @param carry_data the redundancy multiplexer
+ * @return 0, the event loop keeps running
+ */
+int channel_diagnostics_event(void * carry_data);
+
+/**
+ * initializes the event that ends the diagnosis windows every N_diagnose ms
+ * @param event the event, it is enabled if N_diagnose is greater than 0
+ * @param mux the redundancy multiplexer that contains the channels
+ */
+void init_channel_diagnostics_event(timed_event * event, struct redundancy_mux * mux);
+
+/**
+ * lets the defer timers of the channels run in an event loop, those of the channels with deferred PDUs are armed
+ * @param mux the redundancy multiplexer
+ * @param ev_sys the event system of the loop
+ * @param receive_notify_fd the eventfd that is notified when a timer delivered PDUs to a receive queue, -1 for none
+ */
+void redundancy_mux_start_defer_timers(redundancy_mux * mux, event_system * ev_sys, int receive_notify_fd);
+
+/**
+ * removes the defer timers of all channels from the event system of the loop
+ * @param mux the redundancy multiplexer
+ */
+void redundancy_mux_stop_defer_timers(redundancy_mux * mux);
+
+/**
+ * adds a writable event per socket to an event loop, so the datagrams that wait for a socket are sent as soon as it
+ * takes them and the other sockets never wait for it. Only the multiplexer that owns the sockets adds them
+ * @param mux the multiplexer
+ * @param ev_sys the event loop
+ */
+void redundancy_mux_start_transmit_events(redundancy_mux * mux, event_system * ev_sys);
+
+/**
+ * removes the events of redundancy_mux_start_transmit_events()
+ * @param mux the multiplexer
+ * @param ev_sys the event loop
+ */
+void redundancy_mux_stop_transmit_events(redundancy_mux * mux, event_system * ev_sys);
+
+/**
+ * arms the defer timer of a channel, so it fires T_SEQ after the oldest PDU in the defer queue was received.
+ * Nothing happens if the queue is empty, the timer is already armed or the loop does not run
+ * @param mux the redundancy multiplexer that contains the channel
+ * @param channel the channel
+ */
+void redundancy_mux_arm_defer_timer(redundancy_mux * mux, rasta_redundancy_channel * channel);
+
+/**
+ * the callback of the defer timer of a channel, calls rasta_red_f_deferTmo() if the oldest deferred PDU waited
+ * T_SEQ and arms the timer for the PDUs that are still deferred
+ * @param carry_data the redundancy channel
+ * @return 0, the event loop keeps running
+ */
+int channel_defer_timeout_event(void * carry_data);
+
 /**
  * getter for a redundancy channel
  * @param mux the redundancy multiplexer that contains the channel
@@ -183,6 +411,27 @@ void redundancy_mux_set_config_id(redundancy_mux * mux, unsigned long id);
  */
 void redundancy_mux_send(redundancy_mux * mux, struct RastaPacket data);
 
+/**
+ * sends multiple PDUs, each to the redundancy channel identified by its receiver id. The copies for a transport
+ * channel are sent with a single syscall
+ * @param mux the multiplexer which will try to send the @p data
+ * @param data the PDUs which will be sent, in this order
+ * @param count the amount of PDUs in @p data
+ */
+void redundancy_mux_send_batch(redundancy_mux * mux, struct RastaPacket * data, unsigned int count);
+
+/**
+ * sends multiple SR layer PDUs that are already encoded including their safety code to the redundancy channel with
+ * RaSTA ID @p id, like redundancy_mux_send_batch()
+ * @param mux the multiplexer which will try to send the @p data
+ * @param id the RaSTA ID of the receiver of all PDUs
+ * @param data the encoded PDUs which will be sent, in this order
+ * @param lengths the length of every PDU in @p data
+ * @param count the amount of PDUs in @p data
+ */
+void redundancy_mux_send_encoded_batch(redundancy_mux * mux, unsigned long id, unsigned char * const * data,
+                                       const unsigned int * lengths, unsigned int count);
+
 /**
  * retrieves a message from the queue of the redundancy channel to entity with RaSTA ID @p id.
  * If the queue is empty, this call will block until a message is available.
@@ -194,13 +443,16 @@ void redundancy_mux_send(redundancy_mux * mux, struct RastaPacket data);
 int redundancy_try_mux_retrieve(redundancy_mux * mux, unsigned long id, struct RastaPacket * out);
 
 /**
- * blocks until all notification threads are finished
+ * the notifications run on the thread of the multiplexer and are finished when it goes on, so this returns right away.
+ * A call from within a notification does not wait for itself either
  * @param mux the multiplexer that is used
  */
 void redundancy_mux_wait_for_notifications(redundancy_mux * mux);
 
 /**
- * blocks until an entity with RaSTA ID @p id is discovered (i.e. the multiplexer has received something from that entity)
+ * blocks until an entity with RaSTA ID @p id is discovered (i.e. the multiplexer has received something from that entity).
+ * The sockets are received from meanwhile, the thread sleeps while none of them is readable. Must not be called while
+ * the event loop of the multiplexer runs
  * @param mux the multiplexer that is used
  * @param id the RaSTA ID of the entity
  */
@@ -215,6 +467,20 @@ void redundancy_mux_wait_for_entity(redundancy_mux * mux, unsigned long id);
  */
 void redundancy_mux_add_channel(redundancy_mux * mux, unsigned long id, struct RastaIPData * transport_channels);
 
+/**
+ * adds a redundancy channel that continues the channel of another entity, e.g. one that was replicated to a standby.
+ * The receive sequence number is taken from the first PDU of the partner, the PDUs the other entity received after
+ * @p seq_rx are unknown
+ * @param mux the multiplexer where the redundancy channel is added
+ * @param id the RaSTA ID of the remote partner
+ * @param transport_channels the transport channels of the partner that were known
+ * @param count the amount of @p transport_channels, at most mux#port_count
+ * @param seq_tx the next sequence number that is sent
+ * @param seq_rx the next sequence number that was expected
+ */
+void redundancy_mux_restore_channel(redundancy_mux * mux, unsigned long id, const struct RastaIPData * transport_channels,
+                                    unsigned int count, uint32_t seq_tx, uint32_t seq_rx);
+
 /**
  * removes an existing redundancy channel from the multiplexer if the channels exists. If the channel with the given
  * ID does not exist in the mux, nothing happens
@@ -224,12 +490,29 @@ void redundancy_mux_add_channel(redundancy_mux * mux, unsigned long id, struct R
 void redundancy_mux_remove_channel(redundancy_mux * mux, unsigned long channel_id);
 
 /**
- * block until a PDU is available in any of the connected redundancy channels
+ * marks the redundancy channel of a sender as accepted, it is not evicted for other unknown senders anymore and all its
+ * PDUs are handed to the SR layer. Called when the SR layer accepted a connection request
+ * @param mux the multiplexer that contains the channel
+ * @param id the RaSTA ID of the sender
+ */
+void redundancy_mux_confirm_channel(redundancy_mux * mux, unsigned long id);
+
+/**
+ * retrieves a PDU from any of the connected redundancy channels. The channels are served round robin, i.e. every
+ * call starts with the channel after the one that was served by the previous call
  * @param mux the multiplexer that is used
- * @return a packet that was received in any of the connected redundancy channels
+ * @param out the retrieved packet
+ * @return 1 if a packet was retrieved, 0 if no packet is available
  */
 int redundancy_mux_try_retrieve_all(redundancy_mux * mux, struct RastaPacket* out);
 
+/**
+ * checks if a PDU is available in any of the connected redundancy channels
+ * @param mux the multiplexer that is used
+ * @return 1 if redundancy_mux_try_retrieve_all() would return a packet, 0 otherwise
+ */
+int redundancy_mux_data_available(redundancy_mux * mux);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,101 @@
+#ifndef LST_SIMULATOR_RASTAARRIVALRING_H
+#define LST_SIMULATOR_RASTAARRIVALRING_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+
+/**
+ * the time a PDU was received first
+ */
+struct rasta_arrival {
+    /**
+     * the sequence number of the PDU
+     */
+    uint32_t sequence_number;
+    /**
+     * the time the PDU was received in the milliseconds of current_ts()
+     */
+    uint32_t received_at;
+    /**
+     * the diagnose window the arrival belongs to, 0 if the slot was never used
+     */
+    uint32_t window;
+};
+
+/**
+ * Representation of the arrival times of the PDUs a redundancy channel received first within a diagnose window, so
+ * the delay of a copy on another transport channel can be calculated. The slots are indexed by the sequence number
+ * modulo the capacity, a new arrival overwrites the one of the same slot. Clearing the ring only starts a new window,
+ * the arrivals of older windows are ignored without touching the slots.
+ */
+struct rasta_arrival_ring {
+    /**
+     * The slots of the ring
+     */
+    struct rasta_arrival * entries;
+    /**
+     * The amount of slots, always a power of two
+     */
+    unsigned int capacity;
+    /**
+     * The current diagnose window, never 0
+     */
+    uint32_t window;
+    /**
+     * The amount of arrivals in the current window, also the ones that were overwritten
+     */
+    unsigned int count;
+};
+
+/**
+ * initializes an empty arrival ring
+ * @param ring the ring
+ * @param capacity the amount of arrivals that are kept at least, rounded up to a power of two
+ */
+void rasta_arrival_ring_init(struct rasta_arrival_ring * ring, unsigned int capacity);
+
+/**
+ * frees the memory of the ring
+ * @param ring the ring
+ */
+void rasta_arrival_ring_free(struct rasta_arrival_ring * ring);
+
+/**
+ * stores the arrival of a PDU in the current window
+ * @param ring the ring
+ * @param sequence_number the sequence number of the PDU
+ * @param received_at the time the PDU was received in the milliseconds of current_ts()
+ */
+void rasta_arrival_ring_put(struct rasta_arrival_ring * ring, uint32_t sequence_number, uint32_t received_at);
+
+/**
+ * getter for the arrival of a PDU in the current window
+ * @param ring the ring
+ * @param sequence_number the sequence number of the PDU
+ * @param received_at set to the time the PDU was received if it is known
+ * @return 1 if the arrival is known, 0 if the PDU was not received in this window or has been overwritten
+ */
+int rasta_arrival_ring_get(const struct rasta_arrival_ring * ring, uint32_t sequence_number, uint32_t * received_at);
+
+/**
+ * forgets all arrivals and starts a new window, in constant time
+ * @param ring the ring
+ */
+void rasta_arrival_ring_clear(struct rasta_arrival_ring * ring);
+
+/**
+ * changes the capacity of the ring. The arrivals of the current window are kept as long as their slots do not collide
+ * @param ring the ring
+ * @param capacity the amount of arrivals that are kept at least, rounded up to a power of two
+ */
+void rasta_arrival_ring_resize(struct rasta_arrival_ring * ring, unsigned int capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAARRIVALRING_H
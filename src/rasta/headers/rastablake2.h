@@ -18,6 +18,11 @@ void generateBlake2(unsigned char* data, int data_length, const unsigned char *
 
 int rasta_blake2b_selftest();
 
+/**
+ * amount of messages that rasta_blake2b_multi() hashes at once
+ */
+#define BLAKE2B_LANES 4
+
 /*
  * Start of BLAKE2 implementation from RFC 7693
  * https://tools.ietf.org/html/rfc7693#page-16
@@ -39,6 +44,22 @@ typedef struct {
 int rasta_blake2b_init(rasta_blake2b_ctx *ctx, size_t outlen,
                        const void *key, size_t keylen);    // secret key
 
+/**
+ * compresses the key block that rasta_blake2b_init() buffers, so the states that continue @p ctx do not compress it
+ * again. @p ctx is only valid for data that is not empty afterwards, the key block is the last block of an empty
+ * message
+ * @param ctx a state that was initialized with a key and has no data yet
+ */
+void rasta_blake2b_compress_key(rasta_blake2b_ctx *ctx);
+
+/**
+ * starts a calculation after a key block that rasta_blake2b_compress_key() compressed, the data must not be empty
+ * @param ctx the state that is initialized
+ * @param outlen the digest size in bytes, the same as the one of the compressed state
+ * @param keyed the chained state of the compressed state
+ */
+void rasta_blake2b_init_keyed(rasta_blake2b_ctx *ctx, size_t outlen, const uint64_t keyed[8]);
+
 // Add "inlen" bytes from "in" into the hash.
 void rasta_blake2b_update(rasta_blake2b_ctx *ctx,   // context
                     const void *in, size_t inlen);      // data to be hashed
@@ -52,4 +73,16 @@ int rasta_blake2b(void *out, size_t outlen,   // return buffer for digest
             const void *key, size_t keylen,     // optional secret key
             const void *in, size_t inlen);      // data to be hashed
 
+/**
+ * generates the digests of multiple messages that continue the same state, e.g. one that has been initialized with
+ * the same key. BLAKE2B_LANES messages are processed at once
+ * @param ctx the state every message continues, it is not modified
+ * @param in the messages
+ * @param inlen the lengths of the messages
+ * @param count the amount of messages
+ * @param out the digests of the messages, the size is given in init
+ */
+void rasta_blake2b_multi(const rasta_blake2b_ctx *ctx, const unsigned char * const *in, const unsigned int *inlen,
+                         unsigned int count, unsigned char (*out)[64]);
+
 #endif //RASTA_RASTABLAKE2_H
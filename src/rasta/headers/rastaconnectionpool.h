@@ -0,0 +1,141 @@
+#ifndef LST_SIMULATOR_RASTACONNECTIONPOOL_H
+#define LST_SIMULATOR_RASTACONNECTIONPOOL_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stddef.h>
+#include "config.h"
+#include "fifo.h"
+
+struct diagnostic_interval;
+struct rasta_retr_element;
+struct rasta_residency_metrics;
+struct rasta_flight_record;
+
+/**
+ * The memory of the queues and buffers of a connection: the diagnostic intervals, the receive queue, the send queue,
+ * the slots of the retransmission buffer and, if they are enabled, the residency histograms and the flight recorder.
+ * Their sizes only depend on the configuration, so every connection of a handle needs the same amount and all of it is
+ * carved from one slot.
+ * With RASTA_MAX_CONNECTIONS the slots of all connections are allocated at once in one slab and a connection that is
+ * closed hands its slot to the next one. Otherwise every connection allocates its slot on its own.
+ * The pool does not lock, it is used by the thread that opens and closes the connections like the connection list
+ */
+struct rasta_connection_pool {
+    /**
+     * capacity slots of slot_size bytes, NULL if the slots are allocated on demand
+     */
+    unsigned char * slab;
+    size_t slot_size;
+    unsigned int capacity;
+
+    /**
+     * the indices of the slots that are not in use, the next slot is taken from the end
+     */
+    unsigned int * free_slots;
+    unsigned int free_count;
+
+    /**
+     * the amount of elements of the parts of a slot and where they start, the diagnostic intervals are at the
+     * beginning
+     */
+    unsigned int diagnostic_interval_count;
+    unsigned int receive_queue_size;
+    unsigned int send_queue_size;
+    unsigned int urgent_queue_size;
+    unsigned int retransmission_count;
+    size_t receive_queue_offset;
+    size_t send_queue_offset;
+    size_t urgent_queue_offset;
+    size_t retransmission_offset;
+
+    /**
+     * where the residency histograms start, 0 if the slots have none
+     */
+    size_t residency_offset;
+
+    /**
+     * the amount of flight records of a slot and where they start, see RASTA_FLIGHT_RECORDS
+     */
+    unsigned int flight_record_count;
+    size_t flight_record_offset;
+};
+
+/**
+ * the parts of a slot
+ */
+struct rasta_connection_slot {
+    /**
+     * the slot, has to be given back with rasta_connection_pool_release()
+     */
+    void * memory;
+    struct diagnostic_interval * diagnostic_intervals;
+    fifo_t * fifo_app_msg;
+    fifo_t * fifo_send;
+    fifo_t * fifo_send_urgent;
+    struct rasta_retr_element * retransmission_elements;
+
+    /**
+     * the residency histograms, zeroed when the slot is taken or reset, NULL if the slots have none
+     */
+    struct rasta_residency_metrics * residency;
+
+    /**
+     * the ring of the flight recorder, NULL if the slots have none
+     */
+    struct rasta_flight_record * flight_records;
+};
+
+/**
+ * computes the layout of the slots and allocates the slab if the amount of connections is limited
+ * @param pool the pool
+ * @param cfg the sending configuration, max_connections is the amount of slots
+ * @param residency 1 if every slot holds residency histograms, see RASTA_RESIDENCY_HISTOGRAMS
+ * @param flight_records the amount of flight records of every slot, see RASTA_FLIGHT_RECORDS
+ */
+void rasta_connection_pool_init(struct rasta_connection_pool * pool, struct RastaConfigInfoSending cfg, int residency,
+                                unsigned int flight_records);
+
+/**
+ * frees the slab. The slots must not be used anymore, slots that were allocated on demand have to be released before
+ * @param pool the pool
+ */
+void rasta_connection_pool_free(struct rasta_connection_pool * pool);
+
+/**
+ * takes a slot and initializes its queues, all of them are empty afterwards
+ * @param pool the pool
+ * @param slot the parts of the taken slot
+ * @return 1 on success, 0 if every slot is in use
+ */
+int rasta_connection_pool_take(struct rasta_connection_pool * pool, struct rasta_connection_slot * slot);
+
+/**
+ * initializes the queues of a slot that is in use again, e.g. when a closed connection is opened again
+ * @param pool the pool
+ * @param memory the slot, returned by rasta_connection_pool_take()
+ * @param slot the parts of the slot
+ */
+void rasta_connection_pool_reset(struct rasta_connection_pool * pool, void * memory, struct rasta_connection_slot * slot);
+
+/**
+ * gives a slot back, the queues of the slot must not be used anymore
+ * @param pool the pool
+ * @param memory the slot, NULL is ignored
+ */
+void rasta_connection_pool_release(struct rasta_connection_pool * pool, void * memory);
+
+/**
+ * @param pool the pool
+ * @return the amount of bytes of a slot
+ */
+size_t rasta_connection_pool_slot_size(struct rasta_connection_pool * pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTACONNECTIONPOOL_H
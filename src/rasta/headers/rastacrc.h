@@ -12,14 +12,18 @@
  *      // initialize the options as in 6.3.6 b)
  *      struct crc_options options_b = crc_init_opt_b();
  *
- *      // pre generate the crc table, this is optional but recommended if not called the table will be generated when
- *      // the checksum is calculated, thus making the first computation slower
- *      crc_generate_table(&options_b);
+ *      // the tables of the standard options are precomputed, so crc_generate_table is only needed for other options
  *
  *      // calculate the checksum
  *      unsigned long res = crc_calculate(&options_b, data);
  *
  *      // res has value 0x0E7C650A now
+ *
+ *      // the same checksum over data that is added piece by piece
+ *      unsigned long crc = crc_begin(&options_b);
+ *      crc = crc_update(&options_b, crc, data.bytes, 4);
+ *      crc = crc_update(&options_b, crc, data.bytes + 4, 5);
+ *      res = crc_end(&options_b, crc);
  */
 
 #ifndef LST_SIMULATOR_RASTACRC_H
@@ -79,9 +83,12 @@ struct crc_options{
      */
     int is_table_generated;
     /**
-     * the precomputed crc lookup table, generate by calling 'crc_generate_table'
+     * the crc lookup tables, table[0] is used for single bytes and table[k] contains the crc of a byte followed by
+     * k zero bytes. Points to static data that is shared by all options with the same parameters, the standard
+     * options b) to e) use tables that are generated at build time. NULL if the table entries are computed for every
+     * byte
      */
-    unsigned long table[256];
+    const uint32_t (*table)[256];
 };
 
 /**
@@ -120,7 +127,8 @@ struct crc_options crc_init_opt_d();
 struct crc_options crc_init_opt_e();
 
 /**
- * generate the crc lookup table for the given @p options
+ * assigns the crc lookup table for the given @p options. The standard options already contain their precomputed
+ * table, for other parameters the table is generated
  * @param options the options which the table is generated for
  */
 void crc_generate_table(struct crc_options * options);
@@ -134,6 +142,34 @@ void crc_generate_table(struct crc_options * options);
  */
 unsigned long crc_calculate (struct crc_options * options, struct RastaByteArray data);
 
+/**
+ * starts a crc that is calculated over data that is added piece by piece. The result of crc_end() after adding data
+ * with crc_update() is the same as the one of crc_calculate() over the concatenated data. The crc of the options c)
+ * uses the crc32 instruction of SSE4.2 if the processor supports it
+ * @param options the options which are used, the lookup table is generated if it has not been generated yet
+ * @return the initial crc register
+ */
+unsigned long crc_begin(struct crc_options * options);
+
+/**
+ * adds data to a crc
+ * @param options the options which are used, they have to be passed to crc_begin() first
+ * @param crc the current crc register
+ * @param bytes the data
+ * @param length the amount of bytes in @p bytes
+ * @return the crc register after adding the data
+ */
+unsigned long crc_update(struct crc_options * options, unsigned long crc, const unsigned char * bytes,
+                         unsigned int length);
+
+/**
+ * finishes a crc
+ * @param options the options which are used
+ * @param crc the crc register after adding all data
+ * @return the checksum
+ */
+unsigned long crc_end(struct crc_options * options, unsigned long crc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,7 @@
 /**
- * a simple implementation of the defer queue which is used in the redundancy layer
- * This implementation uses an arraylist for storage of the elements
+ * implementation of the defer queue which is used in the redundancy layer
+ * The elements are stored in a fixed pool, a table indexed by the sequence number modulo its size finds an element
+ * in constant time and a list keeps the elements in the order of their timestamps.
  * the sequence number is used as an unique identifier
  */
 
@@ -21,6 +22,22 @@ extern "C" {  // only need to export C interface if
 struct rasta_redundancy_packet_wrapper{
     struct RastaRedundancyPacket packet;
     unsigned long received_timestamp;
+
+    /**
+     * the time the PDU was taken from the socket in the nanoseconds of get_nanotime(), 0 if it is not known
+     */
+    uint64_t received_ns;
+
+    /**
+     * position of the next element with a larger timestamp, -1 if this is the newest element.
+     * Free elements use it to link the free list
+     */
+    int newer;
+
+    /**
+     * position of the next element with a smaller timestamp, -1 if this is the oldest element
+     */
+    int older;
 };
 
 /**
@@ -28,10 +45,35 @@ struct rasta_redundancy_packet_wrapper{
  */
 struct defer_queue{
     /**
-     * the stored elements
+     * the pool of elements, has max_count entries. Positions of stored elements do not change until they are removed
      */
     struct rasta_redundancy_packet_wrapper * elements;
 
+    /**
+     * positions in elements, indexed by the sequence number modulo the table size, -1 marks a free slot
+     */
+    int * seq_slots;
+
+    /**
+     * the size of seq_slots minus one, the size is a power of two
+     */
+    unsigned int slot_mask;
+
+    /**
+     * position of the element with the smallest timestamp, -1 if the queue is empty
+     */
+    int oldest;
+
+    /**
+     * position of the element with the largest timestamp, -1 if the queue is empty
+     */
+    int newest;
+
+    /**
+     * position of the first unused element, -1 if the queue is full
+     */
+    int free_list;
+
     /**
      * the amount of elements that are currently in the queue
      */
@@ -56,14 +98,22 @@ struct defer_queue deferqueue_init(unsigned int n_max);
  */
 void deferqueue_destroy(struct defer_queue * queue);
 
+/**
+ * changes the maximum amount of elements of a queue, the stored elements keep their order
+ * @param queue the queue
+ * @param n_max the new maximum amount of elements
+ * @return 1 if the queue was resized, 0 if it holds more than @p n_max elements and was not changed
+ */
+int deferqueue_resize(struct defer_queue * queue, unsigned int n_max);
+
 /**
  * adds an element to the queue if the queue is not full and the element isn't already in the queue.
  * The sequence_number of the element is used as an unique identifier
  * @param queue the queue where the @p element will be added
- * @param packet the element that will be added
+ * @param packet the element that will be added, it is copied into the queue
  * @param recv_ts the timestamp when the @p element was received
  */
-void deferqueue_add(struct defer_queue * queue, struct RastaRedundancyPacket packet, unsigned long recv_ts);
+void deferqueue_add(struct defer_queue * queue, const struct RastaRedundancyPacket * packet, unsigned long recv_ts);
 
 /**
  * removes the given element from the queue if it exists.
@@ -72,6 +122,29 @@ void deferqueue_add(struct defer_queue * queue, struct RastaRedundancyPacket pac
  */
 void deferqueue_remove(struct defer_queue * queue, unsigned long seq_nr);
 
+/**
+ * removes the element with the given sequence_number from the queue and returns it, with a single lookup
+ * @param queue the queue where the element is removed
+ * @param seq_nr the sequence_number of the element
+ * @param out the removed element is written in here, it owns the SR layer PDU afterwards
+ * @return 1 if the element was in the queue, 0 otherwise
+ */
+int deferqueue_take(struct defer_queue * queue, unsigned long seq_nr, struct RastaRedundancyPacket * out);
+
+/**
+ * like deferqueue_add(), and keeps the time the PDU was taken from the socket
+ * @param received_ns the time in the nanoseconds of get_nanotime(), 0 if it is not known
+ */
+void deferqueue_add_received(struct defer_queue * queue, const struct RastaRedundancyPacket * packet,
+                             unsigned long recv_ts, uint64_t received_ns);
+
+/**
+ * like deferqueue_take(), and returns the time the PDU was taken from the socket
+ * @param received_ns set to the time that was passed to deferqueue_add_received(), 0 if it is not known
+ */
+int deferqueue_take_received(struct defer_queue * queue, unsigned long seq_nr, struct RastaRedundancyPacket * out,
+                             uint64_t * received_ns);
+
 /**
  * checks if the queue contains the element with the given sequence_number
  * @param queue the queue that will be searched
@@ -90,7 +163,7 @@ int deferqueue_isfull(struct defer_queue * queue);
 /**
  * finds the element with the smallest sequence_number
  * @param queue the queue that will be searched
- * @return the index of the element with the smallest sequence_number
+ * @return the position of the element with the smallest sequence_number in queue#elements
  */
 int deferqueue_smallest_seqnr(struct defer_queue * queue);
 
@@ -112,6 +185,22 @@ struct RastaRedundancyPacket deferqueue_get(struct defer_queue * queue, unsigned
  */
 unsigned long deferqueue_get_ts(struct defer_queue * queue, unsigned long seq_nr);
 
+/**
+ * gets the element with the smallest timestamp
+ * @param queue the queue that will be used
+ * @return the oldest element or NULL if the queue is empty
+ */
+struct rasta_redundancy_packet_wrapper * deferqueue_first(struct defer_queue * queue);
+
+/**
+ * gets the element that was received after @p element
+ * @param queue the queue that contains @p element
+ * @param element an element of the queue
+ * @return the element with the next larger timestamp or NULL if @p element is the newest one
+ */
+struct rasta_redundancy_packet_wrapper * deferqueue_next(struct defer_queue * queue,
+                                                          struct rasta_redundancy_packet_wrapper * element);
+
 /**
  * removes all elements from the @p queue
  * @param queue the queue that is cleared
@@ -0,0 +1,117 @@
+#ifndef LST_SIMULATOR_RASTAEXECUTOR_H
+#define LST_SIMULATOR_RASTAEXECUTOR_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stddef.h>
+#include <pthread.h>
+#include "mpscqueue.h"
+
+/**
+ * An executor that runs the notifications of the event loop on application threads. The event loop copies a record
+ * of the notification into a bounded lock-free queue and goes on, so a slow callback does not delay the heartbeats
+ * and timeouts. The callbacks run one at a time in the order they were submitted, either on the thread of the
+ * executor or on the threads of the application that call rasta_callback_executor_run() when the notify_fd is
+ * readable. When the queue is full, the submitting thread runs the queued callbacks itself until there is room, so
+ * no notification is lost and the order is kept
+ */
+
+/**
+ * runs a notification
+ * @param record the copy of the record that was passed to rasta_callback_executor_submit()
+ */
+typedef void (*rasta_callback_run_ptr)(void * record);
+
+/**
+ * the size of a record that always fits into the queue, the records of the redundancy layer are not larger
+ */
+#define RASTA_CALLBACK_RECORD_MIN_SIZE 64
+
+struct rasta_callback_executor {
+    /**
+     * the submitted records
+     */
+    mpsc_queue_t * queue;
+
+    /**
+     * the maximum size of a record
+     */
+    size_t record_size;
+
+    /**
+     * eventfd that is readable while records are queued, it is only signaled again after a consumer took the signal
+     */
+    int notify_fd;
+    int signaled;
+
+    /**
+     * recursive, the consumers take turns with it. Nested runs from a callback return without running anything
+     */
+    pthread_mutex_t lock;
+    unsigned int depth;
+
+    /**
+     * the thread of the executor, only if it was started with one
+     */
+    pthread_t thread;
+    int has_thread;
+    int stopping;
+
+    /**
+     * the records that were queued, the notifications that were merged into a queued record and the times the
+     * queue was full
+     */
+    unsigned long queued;
+    unsigned long coalesced;
+    unsigned long overflows;
+};
+
+/**
+ * initializes an executor
+ * @param executor the executor
+ * @param capacity the amount of records the queue holds at least
+ * @param record_size the maximum size of a record, at least RASTA_CALLBACK_RECORD_MIN_SIZE is used
+ * @param start_thread 1 if the executor runs the callbacks on a thread of its own, 0 if the application runs them
+ */
+void rasta_callback_executor_init(struct rasta_callback_executor * executor, unsigned int capacity, size_t record_size,
+                                  int start_thread);
+
+/**
+ * stops the thread of the executor, runs the callbacks that are still queued on the calling thread and frees the
+ * queue. Nothing may be submitted anymore
+ * @param executor the executor
+ */
+void rasta_callback_executor_destroy(struct rasta_callback_executor * executor);
+
+/**
+ * queues a copy of a record, run is called with it on a consumer. May be called from any thread
+ * @param executor the executor
+ * @param run the function that runs the notification
+ * @param record the record
+ * @param size the size of the record, at most executor#record_size
+ */
+void rasta_callback_executor_submit(struct rasta_callback_executor * executor, rasta_callback_run_ptr run,
+                                    const void * record, size_t size);
+
+/**
+ * counts a notification that did not need a record of its own because a queued record delivers it
+ * @param executor the executor
+ */
+void rasta_callback_executor_coalesced(struct rasta_callback_executor * executor);
+
+/**
+ * runs queued callbacks on the calling thread, after the ones another consumer is running
+ * @param executor the executor
+ * @param max the maximum amount of callbacks
+ * @return the amount of callbacks that were run
+ */
+unsigned int rasta_callback_executor_run(struct rasta_callback_executor * executor, unsigned int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAEXECUTOR_H
@@ -40,6 +40,27 @@ struct RastaMessageData {
     struct RastaByteArray* data_array;
 };
 
+/**
+ * iterates over the application messages in the data of a data message or retransmitted data message without copying
+ * them
+ */
+struct RastaMessageIterator {
+    /**
+     * the data of the message
+     */
+    const unsigned char * bytes;
+
+    /**
+     * the amount of bytes in bytes
+     */
+    unsigned int length;
+
+    /**
+     * offset of the next application message in bytes
+     */
+    unsigned int position;
+};
+
 /**
  * returns the last error from a previously called rasta function
  * note: calling this function will reset the errors to none
@@ -125,6 +146,38 @@ struct RastaPacket createKexRequest(uint32_t receiver_id, uint32_t sender_id, ui
  */
 struct RastaPacket createKexResponse(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
                                      uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const char *psk, const uint8_t *received_client_kex_request, size_t client_kex_request_length, uint32_t initial_sequence_number, struct key_exchange_state *kex_state, const struct RastaConfigKex *kex_config, struct logger_t *logger);
+#ifdef ENABLE_OPAQUE
+/**
+ * Non-standard. Creates a Kex Exchange Request from a state that key_exchange_prepare_credential_request() prepared,
+ * so the OPAQUE computation can run separately
+ * @param receiver_id
+ * @param sender_id
+ * @param sequence_number
+ * @param confirmed_sequence_number
+ * @param timestamp
+ * @param confirmed_timestamp
+ * @param hashing_context
+ * @param kex_state the prepared key exchange state
+ * @return
+ */
+struct RastaPacket createPreparedKexRequest(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
+                                            uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const struct key_exchange_state *kex_state);
+/**
+ * Non-standard. Creates a Key Exchange Response from a state that kex_prepare_credential_response() prepared,
+ * so the OPAQUE computation can run separately
+ * @param receiver_id
+ * @param sender_id
+ * @param sequence_number
+ * @param confirmed_sequence_number
+ * @param timestamp
+ * @param confirmed_timestamp
+ * @param hashing_context
+ * @param kex_state the prepared key exchange state
+ * @return
+ */
+struct RastaPacket createPreparedKexResponse(uint32_t receiver_id, uint32_t sender_id, uint32_t sequence_number, uint32_t confirmed_sequence_number,
+                                             uint32_t timestamp, uint32_t confirmed_timestamp, rasta_hashing_context_t * hashing_context, const struct key_exchange_state *kex_state);
+#endif
 /**
  * Non-standard. Creates a Key Exchange Authentication PDU.
  * @param receiver_id
@@ -243,14 +296,32 @@ struct RastaPacket createRetransmittedDataMessage(uint32_t receiver_id, uint32_t
  */
 struct RastaMessageData extractMessageData(struct RastaPacket p);
 
+/**
+ * initializes an iterator over the application messages in the data of a data message
+ * @param iterator the iterator that is initialized
+ * @param data the data of the packet
+ * @param length the amount of bytes in @p data
+ */
+void rastaMessageIteratorInit(struct RastaMessageIterator * iterator, const unsigned char * data, unsigned int length);
+
+/**
+ * gets the next application message, the message points into the data of the packet
+ * @param iterator the iterator that is used
+ * @param message the start of the application message
+ * @param message_length the length of the application message
+ * @return 1 if there was another message, 0 if all messages have been returned or the data is malformed
+ */
+int rastaMessageIteratorNext(struct RastaMessageIterator * iterator, const unsigned char ** message, unsigned int * message_length);
+
 /**
  * creates a redundancy PDU carrying the specified @p inner_data
  * @param sequence_number the sequence number of the PDU
- * @param inner_data the SR-layer packet that is contained in the PDU
- * @param checksum_type the options for the CRC algorithm that will be used to calculate the checksum
+ * @param inner_data the SR-layer packet that is contained in the PDU, the PDU takes over its data and checksum
+ * @param checksum_type the options for the CRC algorithm that will be used to calculate the checksum, the PDU refers
+ * to them
  * @return a RaSTA redundancy layer PDU
  */
-struct RastaRedundancyPacket createRedundancyPacket(uint32_t sequence_number, struct RastaPacket inner_data, struct crc_options checksum_type);
+struct RastaRedundancyPacket createRedundancyPacket(uint32_t sequence_number, const struct RastaPacket * inner_data, struct crc_options * checksum_type);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,191 @@
+#ifndef LST_SIMULATOR_RASTAFLIGHTRECORDER_H
+#define LST_SIMULATOR_RASTAFLIGHTRECORDER_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * A flight recorder keeps the last PDUs of a connection in a ring in memory. Recording takes the time of the event
+ * loop and a few stores, nothing is written until an anomaly triggers a dump, which writes the ring into a text file
+ * and empties it. The recorder is used by the thread of the event loop only
+ */
+
+/**
+ * the recorded events
+ */
+typedef enum {
+    /**
+     * the SR layer accepted a received PDU
+     */
+    RASTA_FLIGHT_RECEIVE = 1,
+    /**
+     * the SR layer discarded a received PDU, detail is a rasta_trace_discard_reason
+     */
+    RASTA_FLIGHT_DISCARD = 2,
+    /**
+     * the SR layer sent a PDU
+     */
+    RASTA_FLIGHT_SEND = 3,
+    /**
+     * the SR layer sent a PDU again, the sequence number is the one of the first PDU, detail = the amount of PDUs
+     */
+    RASTA_FLIGHT_RETRANSMIT = 4
+} rasta_flight_event;
+
+/**
+ * the anomalies that dump the recorder, they can be combined
+ */
+typedef enum {
+    /**
+     * T_I expired, see event_connection_expired()
+     */
+    RASTA_FLIGHT_TRIGGER_TIMEOUT = 1,
+    /**
+     * the partner sent a disconnection request
+     */
+    RASTA_FLIGHT_TRIGGER_DISCREQ = 2,
+    /**
+     * the safety codes of several received PDUs were wrong within T_MAX
+     */
+    RASTA_FLIGHT_TRIGGER_SAFETY = 4,
+    /**
+     * a transport channel received none of the PDUs of a diagnosis window that the other ones received
+     */
+    RASTA_FLIGHT_TRIGGER_CHANNEL = 8
+} rasta_flight_trigger;
+
+#define RASTA_FLIGHT_TRIGGER_ALL (RASTA_FLIGHT_TRIGGER_TIMEOUT | RASTA_FLIGHT_TRIGGER_DISCREQ | \
+                                  RASTA_FLIGHT_TRIGGER_SAFETY | RASTA_FLIGHT_TRIGGER_CHANNEL)
+
+/**
+ * a recorded PDU
+ */
+struct rasta_flight_record {
+    /**
+     * the time of the event loop in nanoseconds
+     */
+    uint64_t time_ns;
+
+    uint32_t sequence_number;
+    uint32_t confirmed_sequence_number;
+    uint32_t timestamp;
+    uint32_t confirmed_timestamp;
+
+    /**
+     * the PDU type, see rasta_conn_type
+     */
+    uint16_t type;
+    uint8_t event;
+    uint8_t detail;
+
+    /**
+     * the messages in the send queue, the PDUs in the retransmission buffer and the messages in the receive queue of
+     * the connection
+     */
+    uint16_t send_queue;
+    uint16_t retransmission_queue;
+    uint16_t receive_queue;
+};
+
+/**
+ * the ring of a connection and the state of its safety code trigger
+ */
+struct rasta_flight_recorder {
+    /**
+     * capacity records, NULL if nothing is recorded
+     */
+    struct rasta_flight_record * records;
+    unsigned int capacity;
+
+    /**
+     * the amount of records since the last dump, the next record is written at next % capacity
+     */
+    unsigned long next;
+
+    /**
+     * the time of the first wrong safety code of the current window and the amount of them since
+     */
+    uint64_t safety_window_start_ns;
+    unsigned int safety_errors;
+};
+
+/**
+ * sets up an empty recorder
+ * @param recorder the recorder
+ * @param records the ring, NULL if nothing is recorded
+ * @param capacity the amount of records in the ring
+ */
+void rasta_flight_recorder_init(struct rasta_flight_recorder * recorder, struct rasta_flight_record * records,
+                                unsigned int capacity);
+
+/**
+ * takes the next record of the ring, the oldest one is overwritten when the ring is full
+ * @param recorder the recorder
+ * @return the record to fill in, NULL if the recorder does not record
+ */
+static inline struct rasta_flight_record * rasta_flight_recorder_next(struct rasta_flight_recorder * recorder) {
+    if (recorder->records == NULL) {
+        return NULL;
+    }
+    return &recorder->records[recorder->next++ % recorder->capacity];
+}
+
+/**
+ * counts a wrong safety code
+ * @param recorder the recorder
+ * @param now_ns the current time
+ * @param window_ns the time in which @p threshold wrong safety codes trigger a dump
+ * @param threshold the amount of wrong safety codes that trigger a dump
+ * @return 1 if the wrong safety codes within @p window_ns reached @p threshold, the count starts again then
+ */
+int rasta_flight_recorder_safety_error(struct rasta_flight_recorder * recorder, uint64_t now_ns, uint64_t window_ns,
+                                       unsigned int threshold);
+
+/**
+ * writes the records, the oldest one first
+ * @param recorder the recorder
+ * @param out the text is written in here
+ * @param local_id the RaSTA ID of this entity
+ * @param remote_id the RaSTA ID of the remote entity
+ * @param trigger what triggered the dump
+ * @param detail a description of the anomaly, may be empty
+ * @param now_ns the time of the event loop, the times of the records are written relative to it
+ */
+void rasta_flight_recorder_write(const struct rasta_flight_recorder * recorder, FILE * out, unsigned long local_id,
+                                 unsigned long remote_id, rasta_flight_trigger trigger, const char * detail,
+                                 uint64_t now_ns);
+
+/**
+ * writes the records into a new file rasta_flight_<local id>_<remote id>_<epoch ms>_<trigger>.txt and empties the
+ * ring. Nothing is written if nothing was recorded since the last dump
+ * @param recorder the recorder
+ * @param directory the directory of the file
+ * @param local_id the RaSTA ID of this entity
+ * @param remote_id the RaSTA ID of the remote entity
+ * @param trigger what triggered the dump
+ * @param detail a description of the anomaly, may be empty
+ * @param now_ns the time of the event loop
+ * @param path the path of the file is written in here, may be NULL
+ * @param path_size the size of @p path
+ * @return 1 if the file was written, 0 if there was nothing to write or the file could not be written
+ */
+int rasta_flight_recorder_dump(struct rasta_flight_recorder * recorder, const char * directory, unsigned long local_id,
+                               unsigned long remote_id, rasta_flight_trigger trigger, const char * detail,
+                               uint64_t now_ns, char * path, size_t path_size);
+
+/**
+ * @param trigger a trigger
+ * @return the name of @p trigger as in RASTA_FLIGHT_TRIGGERS, in lower case
+ */
+const char * rasta_flight_trigger_name(rasta_flight_trigger trigger);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAFLIGHTRECORDER_H
@@ -18,6 +18,16 @@ extern "C" {  // only need to export C interface if
 #include "logging.h"
 #include "config.h"
 #include "rasta_red_multiplexer.h"
+#include "rastaidindex.h"
+#include "rastaconnectionpool.h"
+#include "rastaretrbuffer.h"
+#include "mpscqueue.h"
+#include "workerpool.h"
+#include "rastaexecutor.h"
+#include "rastametrics.h"
+#include "rastaflightrecorder.h"
+#include "rastareplication.h"
+#include "rmemory.h"
 
 #ifdef ENABLE_OPAQUE
 #include <opaque.h>
@@ -73,6 +83,8 @@ typedef enum {
             RASTA_CONNECTION_RETRRUN
 } rasta_sr_state;
 
+struct rasta_stat_page;
+
 /**
 * representation of the RaSTA error counters, as specified in 5.5.5
 */
@@ -136,69 +148,130 @@ struct timed_event_data {
     struct rasta_connection* connection;
 };
 
-struct rasta_connection {
+/**
+ * the amount of sr_submit() calls that can wait for the event loop at once
+ */
+#define RASTA_SUBMIT_QUEUE_SIZE 64
 
-    struct rasta_connection* linkedlist_next;
-    struct rasta_connection* linkedlist_prev;
+/**
+ * the amount of connection requests that can wait for admission, further requests are discarded
+ */
+#define RASTA_CONREQ_BACKLOG_SIZE 256
 
+/**
+ * application messages that sr_submit() hands to the event loop, the element type of the submission queue
+ */
+struct rasta_submission {
     /**
-     * the event operating the heartbeats on this connection
+     * the RaSTA ID of the receiver
      */
-    timed_event send_heartbeat_event;
-    struct timed_event_data heartbeat_carry_data;
+    unsigned long remote_id;
 
     /**
-     * the event watching the connection timeout
+     * the amount of application messages in data
      */
-    timed_event timeout_event;
-    struct timed_event_data timeout_carry_data;
+    unsigned int count;
 
-#ifdef ENABLE_OPAQUE
     /**
-     * triggers new key exchange
+     * the amount of bytes in data
      */
-    timed_event rekeying_event;
-    struct timed_event_data rekeying_carry_data;
-#endif
+    unsigned int length;
 
     /**
-     * 1 if the process for sending heartbeats should be paused, otherwise 0
+     * the application messages, every message is prefixed with its length in 2 bytes like in a data PDU
      */
-    int hb_stopped;
+    unsigned char data[MAX_DEFER_QUEUE_MSG_SIZE];
+};
 
+/**
+ * token bucket that paces the data packets sent on a connection
+ * the tokens are kept as send credit in nanoseconds, every data packet costs 1s / RASTA_SEND_RATE
+ */
+struct rasta_send_bucket {
     /**
-     * bool value if data from the send buffer is sent right now
+     * the available send credit in nanoseconds
      */
-    int is_sending;
+    uint64_t credit_ns;
 
     /**
-     * blocks heartbeats until connection handshake is complete
+     * the time the credit was last topped up
      */
-    int hb_locked;
+    uint64_t last_refill_ns;
+};
+
+/**
+ * an application message in the send queue of a connection
+ */
+struct rasta_queued_message {
+    struct RastaByteArray message;
+
+    /**
+     * the time sr_send() queued the message, 0 if the connection records no residency
+     */
+    uint64_t queued_ns;
+};
+
+/**
+ * A RaSTA connection. The send loop of the event system checks every connection of a handle each time it runs, the
+ * receive path validates every PDU against the sequence numbers and identifiers, so the fields both of them read come
+ * first: the first 64 bytes hold what the send loop needs to skip a connection or to find that it may send, the next
+ * 64 bytes the pacing state and what a received PDU is checked against, see the static assertions in rasta_new.c.
+ * The waiting times of the send queue, the confirmation and notification flags, the timers, the diagnostics, the
+ * counters and the key exchange state are only used now and then and follow behind them
+ */
+struct rasta_connection {
+
+    struct rasta_connection* linkedlist_next;
 
     rasta_sr_state current_state;
 
     /**
-     * the name of the receiving message queue
+     * the N_SENDMAX of the connection partner,  -1 if not connected
      */
-    fifo_t * fifo_app_msg;
+    int connected_recv_buffer_size;
+
+    /**
+     * the sent data PDUs that are not confirmed yet, for retransmission purposes
+     */
+    struct retr_buffer retr_buffer;
+
+    /**
+     * the amount of bytes the application messages in fifo_send and fifo_send_urgent take in the data of a data packet
+     */
+    unsigned int send_queued_bytes;
 
     /**
-     * the name of the sending message queue
+     * 1 if sr_send() rejected messages because a lane of the send queue was full, on_writable is fired once there is
+     * room again
+     */
+    int send_blocked;
+
+    /**
+     * the bulk lane of the send queue, holds struct rasta_queued_message
      */
     fifo_t * fifo_send;
 
     /**
-     * the N_SENDMAX of the connection partner,  -1 if not connected
+     * the urgent lane of the send queue. Data packets are filled from it first, so its messages overtake the ones in
+     * fifo_send
      */
-    int connected_recv_buffer_size;
+    fifo_t * fifo_send_urgent;
 
     /**
-     * defines if who started the connection
-     * Client: Connection request sent
-     * Server: Connection request received
+     * paces the data packets sent from the send queue
      */
-    rasta_role role;
+    struct rasta_send_bucket send_bucket;
+
+    /**
+     * 1 while the data packets in retr_buffer are retransmitted. New data packets and heartbeats wait until the
+     * heartbeat that closes the retransmission was sent
+     */
+    int retransmitting;
+
+    /**
+     * the sequence number of the next data packet in retr_buffer that is retransmitted
+     */
+    uint32_t retransmit_sn;
 
     /**
      * send sequence number (seq nr of the next PDU that will be sent)
@@ -209,11 +282,6 @@ struct rasta_connection {
      */
     uint32_t sn_r;
 
-    /**
-     * Initial sequence number
-     */
-    uint32_t sn_i;
-
     /**
      * sequence number that has to be checked in the next sent PDU
      */
@@ -245,11 +313,88 @@ struct rasta_connection {
      * the RaSTA connections receiver identifier
      */
     uint32_t remote_id;
+
+    /**
+     * defines if who started the connection
+     * Client: Connection request sent
+     * Server: Connection request received
+     */
+    rasta_role role;
+
+    /**
+     * blocks heartbeats until connection handshake is complete
+     */
+    int hb_locked;
+
+    /**
+     * bool value if data from the send buffer is sent right now
+     */
+    int is_sending;
+
+    /**
+     * the time the oldest application message in the send queue was queued, only valid while the send queue is not
+     * empty
+     */
+    uint64_t send_queued_since_ns;
+
+    /**
+     * the time in the nanoseconds of get_nanotime() since the next data packet could be sent but the send budget of
+     * the send handler was used up by other connections, 0 while the connection does not wait for its turn
+     */
+    uint64_t send_ready_since_ns;
+
+    /**
+     * the data PDUs received since a PDU that confirms them was sent, they are confirmed by a heartbeat once there are
+     * mwa of them
+     */
+    unsigned int unconfirmed_received;
+
+    /**
+     * the sequence number of the last received PDU that cs_t confirms once the receive queue has room again
+     */
+    uint32_t cs_received;
+
+    /**
+     * 1 while cs_t is held back because the application does not retrieve the received messages, see
+     * RASTA_RECEIVE_BACKPRESSURE
+     */
+    int receive_held;
+
+    /**
+     * 1 while a state change notification of the connection waits in the callback executor, the state changes that
+     * are fired meanwhile only update notified_state
+     */
+    int state_change_queued;
+    rasta_sr_state notified_state;
+
+    /**
+     * the name of the receiving message queue, holds the received application messages and when they were queued
+     */
+    fifo_t * fifo_app_msg;
+
+    struct rasta_connection* linkedlist_prev;
+
+    /**
+     * 1 if the process for sending heartbeats should be paused, otherwise 0
+     */
+    int hb_stopped;
+
+    /**
+     * Initial sequence number
+     */
+    uint32_t sn_i;
+
     /**
      * the identifier of the RaSTA network this connection belongs to
      */
     uint32_t network_id;
 
+    /**
+     * the slot of rasta_handle#connection_pool that holds the diagnostic intervals, both queues and the slots of the
+     * retransmission buffer
+     */
+    void * state;
+
     /**
      * counts received diagnostic relevant messages since last diagnosticNotification
      */
@@ -265,15 +410,103 @@ struct rasta_connection {
     struct diagnostic_interval* diagnostic_intervals;
 
     /**
-     * the pdu fifo for retransmission purposes
+     * the event operating the heartbeats on this connection
      */
-    fifo_t * fifo_retr;
+    timed_event send_heartbeat_event;
+    struct timed_event_data heartbeat_carry_data;
+
+    /**
+     * the event watching the connection timeout
+     */
+    timed_event timeout_event;
+    struct timed_event_data timeout_carry_data;
+
+    /**
+     * sends the connection request of a client again, only added if reconnect_min_ms is set
+     */
+    timed_event reconnect_event;
+    struct timed_event_data reconnect_carry_data;
+
+    /**
+     * amount of connection requests the client sent again since the last completed handshake
+     */
+    unsigned int reconnect_attempts;
+
+    /**
+     * the position of the peer in the bulk connect of the handle plus 1, 0 if the handshake of the connection is not
+     * waited for by a bulk connect
+     */
+    unsigned int bulk_index;
+
+#ifdef ENABLE_OPAQUE
+    /**
+     * triggers new key exchange
+     */
+    timed_event rekeying_event;
+    struct timed_event_data rekeying_carry_data;
+
+    /**
+     * the key exchange computation that runs on the kex_pool of the handle, NULL if there is none. A job that does
+     * not belong to its connection anymore when it completes is discarded
+     */
+    struct rasta_kex_job * kex_job;
+
+    /**
+     * [CLIENT] the credential request of the next rekeying, prepared on the kex_pool after a key exchange. Only its
+     * client_secret, secret_owner, password_length and client_public are used, client_secret is NULL if none is ready
+     */
+    struct key_exchange_state kex_prepared;
+
+    /**
+     * the job that prepares kex_prepared, NULL if there is none
+     */
+    struct rasta_kex_job * kex_prepare_job;
+
+    /**
+     * when the pending periodic rekeying was due, 0 if there is none
+     */
+    uint64_t rekeying_due_ms;
+#endif
 
     /**
     *   the error counters as specified in 5.5.5
     */
     struct rasta_error_counters errors;
 
+    /**
+     * retransmissions and round trip delays for capacity planning, the traffic is counted by the redundancy channel
+     */
+    struct rasta_connection_metrics metrics;
+
+    /**
+     * how long the messages of the connection waited in its queues, NULL without RASTA_RESIDENCY_HISTOGRAMS
+     */
+    struct rasta_residency_metrics * residency;
+
+    /**
+     * the last PDUs of the connection, dumped when an anomaly happens, see RASTA_FLIGHT_RECORDS
+     */
+    struct rasta_flight_recorder flight_recorder;
+
+    /**
+     * added to the time of the event loop for the timestamps of the connection, so a connection that a standby took
+     * over keeps the clock of the primary its partner knows
+     */
+    uint32_t timestamp_offset;
+
+    /**
+     * 1 if the standby knows the connection, the sequence numbers of the state that was replicated last
+     */
+    int replicated;
+    uint32_t replicated_sn_t;
+    uint32_t replicated_sn_r;
+    uint32_t replicated_cs_r;
+
+    /**
+     * 1 after a takeover until the first PDU of the partner sets sn_r
+     */
+    int resync;
+
     /**
      * Session data for and derived from key exchange
      */
@@ -286,9 +519,30 @@ struct rasta_connection {
  */
 struct rasta_notification_result {
     /**
-     * copy of the calling rasta connection (this should always be used first)
+     * the connection that fired the notification, only valid while the notification is called
+     */
+    struct rasta_connection *con;
+
+#ifdef RASTA_NOTIFICATION_COPY
+    /**
+     * copy of the connection like in older versions, only built with ENABLE_RASTA_NOTIFICATION_COPY
      */
     struct rasta_connection connection;
+#endif
+
+    /**
+     * the id and the state of the connection when the notification was fired. With a callback executor, a state change
+     * notification carries the latest state of the state changes that were merged into it
+     */
+    unsigned long remote_id;
+    rasta_sr_state state;
+
+    /**
+     * the diagnostic intervals of a diagnostic notification, a copy with a callback executor because the connection
+     * starts the next intervals right away
+     */
+    struct diagnostic_interval * diagnostic_intervals;
+    unsigned int diagnostic_intervals_length;
 
     /**
      * handle, don't touch
@@ -302,6 +556,12 @@ struct rasta_notification_result {
  */
 typedef void(*on_receive_ptr)(struct rasta_notification_result *result);
 
+/**
+ * pointer to a function that will be called once for all application messages of a received data PDU
+ * first parameter is the connection that fired the event
+ */
+typedef void(*on_receive_bulk_ptr)(struct rasta_notification_result *result);
+
 /**
  * pointer to a function that will be called when connection tls_state has changed
  * first parameter is the connection that fired the event
@@ -336,6 +596,71 @@ typedef void(*on_handshake_complete_ptr)(struct rasta_notification_result *);
  */
 typedef void(*on_heartbeat_timeout_ptr)(struct rasta_notification_result *);
 
+/**
+ * progress of the bulk connect of a handle, see sr_connect_bulk()
+ */
+struct rasta_bulk_connect_status {
+    /**
+     * amount of peers of the bulk connect
+     */
+    unsigned int total;
+
+    /**
+     * amount of peers whose connection requests were sent
+     */
+    unsigned int issued;
+
+    /**
+     * amount of peers that completed the handshake, and the key exchange if it is enabled
+     */
+    unsigned int connected;
+
+    /**
+     * amount of peers whose connection could not be opened or was closed and is not reconnected
+     */
+    unsigned int failed;
+
+    /**
+     * amount of peers whose connection requests were sent and that are neither connected nor failed yet
+     */
+    unsigned int in_flight;
+
+    /**
+     * amount of waves of connection requests that were sent
+     */
+    unsigned int waves;
+
+    /**
+     * 1 once every peer is connected or failed
+     */
+    int complete;
+
+    /**
+     * time in ns from sr_connect_bulk() until the last peer was connected, only valid if every peer is connected
+     */
+    uint64_t all_connected_ns;
+
+    /**
+     * time in ns from sr_connect_bulk() until every peer was connected or failed, only valid if complete is set
+     */
+    uint64_t complete_ns;
+};
+
+/**
+ * pointer to a function that will be called when the send queue of a connection that rejected messages has room
+ * for a data packet of messages again
+ * first parameter is the connection that fired the event
+ */
+typedef void(*on_writable_ptr)(struct rasta_notification_result *);
+
+/**
+ * pointer to a function that will be called when every peer of a bulk connect is connected or failed
+ * first parameter is the notification, it has no connection
+ * second parameter is the final progress of the bulk connect
+ */
+typedef void(*on_bulk_connect_complete_ptr)(struct rasta_notification_result *result,
+                                            const struct rasta_bulk_connect_status *status);
+
 /**
  * function pointers for the notifications that are specified in 5.2.2
  */
@@ -345,6 +670,12 @@ struct rasta_notification_ptr{
      */
     on_receive_ptr on_receive;
 
+    /**
+     * called once per received data PDU after all of its application messages are ready for processing, they can be
+     * read with sr_get_received_data_bulk()
+     */
+    on_receive_bulk_ptr on_receive_bulk;
+
     /**
      * called when connection tls_state has changed
      */
@@ -374,6 +705,17 @@ struct rasta_notification_ptr{
      * called when the T_i timer of an entity expired
      */
     on_heartbeat_timeout_ptr on_heartbeat_timeout;
+
+    /**
+     * called when the send queue of a connection has room for sending.max_packet messages again after sr_send()
+     * rejected messages because it was full
+     */
+    on_writable_ptr on_writable;
+
+    /**
+     * called once when every peer of sr_connect_bulk() is connected or failed
+     */
+    on_bulk_connect_complete_ptr on_bulk_connect_complete;
 };
 
 struct rasta_disconnect_notification_result {
@@ -406,6 +748,16 @@ struct rasta_sending_handle {
      * The paramenters that are used for SR checksums
      */
     rasta_hashing_context_t * hashing_context;
+
+    /**
+     * wakes up the send handler when a paced connection has send credit again, NULL while the event loop is not running
+     */
+    timed_event * pacing_event;
+
+    /**
+     * the connection that sent a data packet from its send queue last, the next turn starts behind it
+     */
+    uint32_t send_last_id;
 };
 
 struct rasta_heartbeat_handle {
@@ -430,6 +782,13 @@ struct rasta_heartbeat_handle {
      * The paramenters that are used for SR checksums
      */
     rasta_hashing_context_t * hashing_context;
+
+    /**
+     * the heartbeats that are sent together and their connections, grown when more connections are due at once
+     */
+    struct RastaPacket * batch;
+    struct rasta_connection ** batch_connections;
+    unsigned int batch_capacity;
 };
 
 struct rasta_receive_handle {
@@ -456,6 +815,149 @@ struct rasta_receive_handle {
      */
     rasta_hashing_context_t * hashing_context;
 
+    /**
+     * paces the retransmitted data packets of all connections of the handle, see retransmit_rate
+     */
+    struct rasta_send_bucket retransmit_bucket;
+
+    /**
+     * the connection that retransmitted last, the next turn starts behind it
+     */
+    uint32_t retransmit_last_id;
+
+    /**
+     * the amount of connections whose confirmations were held back by the last check, they are confirmed by
+     * receive_notification_event() once their receive queues have room again
+     */
+    unsigned int receive_held_count;
+
+    /**
+     * wakes up the retransmissions when there is credit for more data packets, NULL while the event loop is not
+     * running
+     */
+    timed_event * retransmit_event;
+
+    /**
+     * set by on_readable_event() when it handled a PDU, so its time is accounted to the connection of the sender
+     */
+    int last_received;
+    unsigned long last_sender_id;
+};
+
+/**
+ * counters of the receive handler, i.e. how many packets it processed per wakeup
+ */
+struct rasta_receive_statistics {
+    /**
+     * amount of wakeups of the receive handler
+     */
+    unsigned long wakeups;
+
+    /**
+     * amount of packets processed over all wakeups
+     */
+    unsigned long packets;
+
+    /**
+     * amount of packets processed by the latest wakeup
+     */
+    unsigned int last_wakeup_packets;
+
+    /**
+     * highest amount of packets processed by a single wakeup
+     */
+    unsigned int max_wakeup_packets;
+
+    /**
+     * amount of connection requests that waited for a later wakeup because conreq_budget was used up
+     */
+    unsigned long deferred_conreqs;
+
+    /**
+     * amount of connection requests that were discarded because the backlog was full
+     */
+    unsigned long shed_conreqs;
+};
+
+/**
+ * counters of the rekeying scheduler of a handle. The latency of a rekeying is the time from when it was due until
+ * the new session key is used, including the time it was deferred
+ */
+struct rasta_rekeying_statistics {
+    /**
+     * amount of periodic rekeyings that were started
+     */
+    unsigned long started;
+
+    /**
+     * amount of periodic rekeyings that were completed
+     */
+    unsigned long completed;
+
+    /**
+     * how often a due rekeying waited, because rekeying_max_concurrent connections were rekeying already
+     */
+    unsigned long deferred;
+
+    /**
+     * amount of started rekeyings that sent a credential request prepared after the previous key exchange
+     */
+    unsigned long precomputed;
+
+    /**
+     * the latency of the latest rekeying, the highest latency and the sum over all completed rekeyings
+     */
+    uint64_t last_latency_ms;
+    uint64_t max_latency_ms;
+    uint64_t total_latency_ms;
+};
+
+/**
+ * the state of a peer of a bulk connect
+ */
+typedef enum {
+    /**
+     * the connection request was not sent yet
+     */
+    RASTA_BULK_PEER_WAITING,
+    /**
+     * the connection request was sent, the handshake is not finished
+     */
+    RASTA_BULK_PEER_ISSUED,
+    RASTA_BULK_PEER_CONNECTED,
+    RASTA_BULK_PEER_FAILED
+} rasta_bulk_peer_state;
+
+/**
+ * a bulk connect of a handle, see sr_connect_bulk()
+ */
+struct rasta_bulk_connect {
+    /**
+     * the ids of the peers and their transport channels, port_count channels per peer, in the order of the waves
+     */
+    unsigned long * ids;
+    struct RastaIPData * channels;
+    unsigned int port_count;
+    rasta_bulk_peer_state * states;
+
+    /**
+     * the peer whose connection request is sent next
+     */
+    unsigned int next;
+
+    struct rasta_bulk_connect_status status;
+
+    /**
+     * the time of the event loop when the bulk connect was started, in ns
+     */
+    uint64_t started;
+
+    /**
+     * sends the next wave and finds the handshakes that failed, every connect_wave_interval_ms until the bulk
+     * connect is complete
+     */
+    timed_event wave_event;
+    struct timed_event_data wave_carry_data;
 };
 
 struct rasta_handle {
@@ -512,6 +1014,23 @@ struct rasta_handle {
     struct rasta_connection* first_con;
     struct rasta_connection* last_con;
 
+    /**
+     * maps the remote_id of the connections in the linked list to the connection
+     */
+    struct rasta_id_index connection_index;
+
+    /**
+     * the memory of the queues of the connections
+     */
+    struct rasta_connection_pool connection_pool;
+
+    /**
+     * the CPU the event loop of the handle runs on, negative if it is not pinned, and where the memory of the handle
+     * and of its event loop comes from, see rmemory_set_thread_placement()
+     */
+    int cpu;
+    struct rmemory_placement placement;
+
     /**
      * The paramenters that are used for SR checksums
      */
@@ -522,6 +1041,105 @@ struct rasta_handle {
      */
     event_system* ev_sys;
 
+    /**
+     * eventfds that wake up the send handler when data was queued in a fifo_send and the receive handler
+     * when the redundancy layer queued data in a fifo_recv. -1 while the event loop is not running
+     */
+    int send_notify_fd;
+    int receive_notify_fd;
+
+    /**
+     * application messages that other threads submitted with sr_submit(), taken out by the event loop
+     */
+    mpsc_queue_t * submit_queue;
+
+    /**
+     * eventfd that wakes up the event loop when a submission was added to submit_queue. Other threads may use it
+     * at any time, so it exists as long as the handle
+     */
+    int submit_notify_fd;
+
+    /**
+     * runs the notifications on other threads than the event loop, NULL if they are called by the event loop, see
+     * RASTA_CALLBACK_QUEUE
+     */
+    struct rasta_callback_executor * callback_executor;
+
+#ifdef ENABLE_OPAQUE
+    /**
+     * the threads that compute the key exchanges of the connections, only started if key exchanges are enabled
+     */
+    struct worker_pool kex_pool;
+
+    /**
+     * the user records and client secrets the key exchanges of the handle reuse, shared by the kex_pool
+     */
+    struct key_exchange_secrets kex_secrets;
+#endif
+
+    /**
+     * packets processed per wakeup of the receive handler
+     */
+    struct rasta_receive_statistics receive_stats;
+
+    /**
+     * latency of the periodic rekeyings of the connections
+     */
+    struct rasta_rekeying_statistics rekeying_stats;
+
+    /**
+     * state of rand_r() for the jitter of the rekeying intervals
+     */
+    unsigned int rekeying_seed;
+
+    /**
+     * connection requests of new connections that wait for admission, NULL if conreq_budget is not set
+     */
+    fifo_t * conreq_backlog;
+
+    /**
+     * state of rand_r() for the jitter of the reconnect delays
+     */
+    unsigned int reconnect_seed;
+
+    /**
+     * the latest bulk connect, NULL if sr_connect_bulk() was not called
+     */
+    struct rasta_bulk_connect * bulk_connect;
+
+    /**
+     * how late the timed events of the event loop fired, in microseconds
+     */
+    struct rasta_histogram loop_lag;
+
+    /**
+     * the listening socket of the Prometheus text endpoint and its event, -1 if there is no endpoint
+     */
+    int metrics_fd;
+    fd_event metrics_event;
+
+    /**
+     * the shared memory page the metrics are published to, NULL if there is no page, see RASTA_STAT_PAGE
+     */
+    struct rasta_stat_page * stat_page;
+
+    /**
+     * the signalfd that receives SIGHUP and its event, -1 if the config file is not reloaded on SIGHUP, see
+     * sr_reload_on_sighup()
+     */
+    int reload_signal_fd;
+    fd_event reload_event;
+
+    /**
+     * the hot standby stream, NULL if the state is not replicated
+     */
+    struct rasta_replication* replication;
+
+    /**
+     * durations of the event loop callbacks, only measured if RASTA_PROFILE_INTERVAL_MS is set
+     */
+    event_profile profile;
+
     /**
      * the user specified configurations for RaSTA
      */
@@ -547,6 +1165,18 @@ void fire_on_connection_state_change(struct rasta_notification_result result);
  */
 void fire_on_receive(struct rasta_notification_result result);
 
+/**
+ * fires the onReceiveBulk event set in the rasta handle
+ * @param result
+ */
+void fire_on_receive_bulk(struct rasta_notification_result result);
+
+/**
+ * fires the onWritable event set in the rasta handle
+ * @param result
+ */
+void fire_on_writable(struct rasta_notification_result result);
+
 /**
  * fires the onDisconnectionRequest event set in the rasta handle
  * @param result
@@ -572,6 +1202,13 @@ void fire_on_handshake_complete(struct rasta_notification_result result);
  */
 void fire_on_heartbeat_timeout(struct rasta_notification_result result);
 
+/**
+ * fires the onBulkConnectComplete event set in the rasta handle
+ * @param handle the handle of the bulk connect
+ * @param status the final progress of the bulk connect
+ */
+void fire_on_bulk_connect_complete(struct rasta_handle *handle, struct rasta_bulk_connect_status status);
+
 /**
  * initializes the rasta handle
  * configurates itself with the given config file automatically
@@ -580,6 +1217,20 @@ void fire_on_heartbeat_timeout(struct rasta_notification_result result);
  */
 void rasta_handle_init(struct rasta_handle *h, const char* config_file_path);
 
+/**
+ * wakes up the event loop handler that waits for the eventfd @p notify_fd
+ * @param notify_fd the eventfd, nothing happens if it is -1
+ */
+void rasta_handle_notify(int notify_fd);
+
+/**
+ * pins the handle to a CPU, called before the connections are made. With RASTA_NUMA_PLACEMENT the memory of the
+ * handle is taken from the NUMA node of @p cpu from now on, the connection pool is allocated there again
+ * @param h the RaSTA handle
+ * @param cpu the CPU the event loop of the handle will run on
+ */
+void rasta_handle_set_cpu(struct rasta_handle *h, int cpu);
+
 /**
  * initializes the rasta handle
  * configurateable through parameters
@@ -590,6 +1241,21 @@ void rasta_handle_init(struct rasta_handle *h, const char* config_file_path);
  */
 void rasta_handle_manually_init(struct rasta_handle *h, struct RastaConfigInfo configuration, struct DictionaryArray accepted_versions , struct logger_t logger);
 
+/**
+ * the maximum log level of a loaded config file
+ * @param config the config
+ * @return the log level or -1 if LOGGER_MAX_LEVEL is not set
+ */
+int rasta_config_log_level(struct RastaConfig * config);
+
+/**
+ * the memory a connection of the handle occupies: the rasta_connection that on_connection_start allocates and the
+ * slot of the connection pool with its queues. It is the same for every connection of the handle
+ * @param h the RaSTA handle
+ * @return the size in bytes
+ */
+size_t sr_connection_footprint(struct rasta_handle *h);
+
 #ifdef __cplusplus
 }
 #endif
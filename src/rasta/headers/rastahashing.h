@@ -5,6 +5,7 @@
 #include <rastamd4.h>
 #include <rastablake2.h>
 #include <rastasiphash24.h>
+#include <rastacrc.h>
 
 
 /**
@@ -56,8 +57,90 @@ typedef struct rasta_hashing_ctx{
      * The key / iv for the hashing algorithm
      */
     struct RastaByteArray key;
+    /**
+     * The MD4 state after loading the initial value from the key, so it is not rebuilt for every hash.
+     * Updated by rasta_md4_set_key() and rasta_set_hash_key_variable()
+     */
+    MD4_CONTEXT md4_context;
+    /**
+     * The chained BLAKE2b states of 8 and 16 byte checksums after the key block, so the key block is compressed once
+     * per key instead of once per hash. Only valid if blake2b_keyed_valid is 1, i.e. the key is at most 64 bytes long
+     */
+    uint64_t blake2b_keyed[2][8];
+    int blake2b_keyed_valid;
+    /**
+     * The SipHash 2-4 states of 8 and 16 byte checksums after the key schedule
+     */
+    uint64_t siphash24_keyed[2][4];
 }rasta_hashing_context_t;
 
+/**
+ * state of a checksum calculation over data that is added piece by piece
+ */
+typedef struct rasta_hash_state{
+    /**
+     * the hashing algorithm
+     */
+    rasta_hash_algorithm algorithm;
+    /**
+     * the length of the resulting hash
+     */
+    rasta_checksum_type hash_length;
+    /**
+     * the hashing context the calculation started with, an empty message is hashed with its key
+     */
+    const struct rasta_hashing_ctx * context;
+    /**
+     * the state of the algorithm
+     */
+    union {
+        MD4_CONTEXT md4;
+        rasta_blake2b_ctx blake2b;
+        rasta_siphash24_ctx siphash24;
+    } state;
+}rasta_hash_state_t;
+
+/**
+ * starts a checksum calculation with the parameters in the hashing context. The result of adding data with
+ * rasta_hash_update() is the same as the one of rasta_calculate_hash() over the concatenated data
+ * @param state the state that is initialized
+ * @param context the hashing context that contains the neccessary parameters for hashing the data
+ */
+void rasta_hash_init(rasta_hash_state_t * state, rasta_hashing_context_t * context);
+
+/**
+ * adds data to a checksum calculation
+ * @param state the state of the calculation
+ * @param data the data to hash
+ * @param length the amount of bytes in @p data
+ */
+void rasta_hash_update(rasta_hash_state_t * state, const unsigned char * data, unsigned int length);
+
+/**
+ * finishes a checksum calculation
+ * @param state the state of the calculation, it can not be used afterwards
+ * @param hash the resulting hash
+ */
+void rasta_hash_final(rasta_hash_state_t * state, unsigned char * hash);
+
+/**
+ * calculates the checksum of a message for one combination of algorithm and checksum length
+ * @param context the hashing context, only its key and prepared MD4 state are read
+ * @param data the data to hash
+ * @param length the amount of bytes in @p data
+ * @param hash the resulting hash
+ */
+typedef void (*rasta_hash_function)(rasta_hashing_context_t * context, const unsigned char * data, unsigned int length,
+                                    unsigned char * hash);
+
+/**
+ * selects the hash function that is specialized for the algorithm and checksum length of the hashing context, so
+ * hashing with it does not depend on the parameters anymore. It has to be selected again when they change
+ * @param context the hashing context
+ * @return the hash function, it gives the same result as rasta_calculate_hash()
+ */
+rasta_hash_function rasta_hash_select(const rasta_hashing_context_t * context);
+
 /**
  * Calculates a checksum over the given data using the parameters in the hashing context
  * @param data the data to hash
@@ -66,6 +149,42 @@ typedef struct rasta_hashing_ctx{
  */
 void rasta_calculate_hash(struct RastaByteArray data, rasta_hashing_context_t * context,  unsigned char * hash);
 
+/**
+ * checks the checksums of multiple messages. Several messages are hashed at once, MD4_LANES with MD4, BLAKE2B_LANES
+ * with BLAKE2b and SIPHASH_LANES with SipHash 2-4
+ * @param context the hashing context that contains the neccessary parameters for hashing the data
+ * @param data the messages
+ * @param lengths the amount of bytes in every message
+ * @param hashes the checksums that are expected for the messages, the length is given by the context
+ * @param count the amount of messages
+ * @param results set to 1 for every message whose checksum is correct, 0 otherwise
+ */
+void rasta_hash_verify_batch(rasta_hashing_context_t * context, const unsigned char * const * data,
+                             const unsigned int * lengths, const unsigned char * const * hashes, unsigned int count,
+                             int * results);
+
+/**
+ * the amount of bytes rasta_hash_crc_update() hashes before it adds them to the CRC, a multiple of the block sizes of
+ * all algorithms that is small enough to stay in the L1 cache
+ */
+#define RASTA_HASH_CRC_CHUNK 256
+
+/**
+ * calculates the checksum of a message and adds the message to a CRC in one pass over the data, so every chunk of it
+ * is read from the cache again by the second calculation. Used for SR layer PDUs that are carried in a redundancy
+ * layer PDU, the safety code is not added to the CRC
+ * @param context the hashing context that contains the neccessary parameters for hashing the data
+ * @param crc_options the options of the CRC, see crc_begin()
+ * @param crc the current crc register
+ * @param data the data to hash
+ * @param length the amount of bytes in @p data
+ * @param hash the resulting hash, it has to have space for 16 bytes
+ * @return the crc register after adding @p data
+ */
+unsigned long rasta_hash_crc_update(rasta_hashing_context_t * context, struct crc_options * crc_options,
+                                    unsigned long crc, const unsigned char * data, unsigned int length,
+                                    unsigned char * hash);
+
 /**
  * Sets the key of the hashing context based the the MD4 initial value
  * @param context the context where the key is set
@@ -75,6 +194,14 @@ void rasta_calculate_hash(struct RastaByteArray data, rasta_hashing_context_t *
  * @param d D part of the initial MD4 value
  */
 void rasta_md4_set_key(rasta_hashing_context_t * context, MD4_u32plus a, MD4_u32plus b, MD4_u32plus c, MD4_u32plus d);
+/**
+ * prepares the states of all algorithms from the key of the hashing context, see md4_context, blake2b_keyed and
+ * siphash24_keyed. Called by rasta_md4_set_key() and rasta_set_hash_key_variable(), it has to be called again when
+ * the key is changed in another way
+ * @param context the context whose key is set
+ */
+void rasta_hash_prepare_key(rasta_hashing_context_t * context);
+
 /**
  * Sets a variable-length key for use with the different hash functions
  * @param context context for the key
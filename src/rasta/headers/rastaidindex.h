@@ -0,0 +1,81 @@
+#ifndef LST_SIMULATOR_RASTAIDINDEX_H
+#define LST_SIMULATOR_RASTAIDINDEX_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+/**
+ * An entry in the id index
+ */
+struct rasta_id_index_entry {
+    /**
+     * The RaSTA ID
+     */
+    unsigned long id;
+    /**
+     * The element that is associated with the ID, NULL if the slot is free
+     */
+    void * value;
+};
+
+/**
+ * Representation of a hash table that maps RaSTA IDs to elements, e.g. connections or redundancy channels.
+ * The index uses open addressing with linear probing and only stores pointers, the elements are owned by the caller.
+ */
+struct rasta_id_index {
+    /**
+     * The slots of the table
+     */
+    struct rasta_id_index_entry * entries;
+    /**
+     * The amount of slots, always a power of two
+     */
+    unsigned int capacity;
+    /**
+     * The amount of used slots
+     */
+    unsigned int count;
+};
+
+/**
+ * initializes an empty id index
+ * @param index the index
+ */
+void rasta_id_index_init(struct rasta_id_index * index);
+
+/**
+ * frees the memory of the index, the elements are not freed. Afterwards the index behaves like an empty index
+ * @param index the index
+ */
+void rasta_id_index_free(struct rasta_id_index * index);
+
+/**
+ * associates an element with a RaSTA ID. An element that is already associated with the ID is replaced
+ * @param index the index
+ * @param id the RaSTA ID
+ * @param value the element, must not be NULL
+ */
+void rasta_id_index_put(struct rasta_id_index * index, unsigned long id, void * value);
+
+/**
+ * getter for the element that is associated with a RaSTA ID
+ * @param index the index
+ * @param id the RaSTA ID
+ * @return the element or NULL if the ID is unknown
+ */
+void * rasta_id_index_get(struct rasta_id_index * index, unsigned long id);
+
+/**
+ * removes the element that is associated with a RaSTA ID. If the ID is unknown, nothing happens
+ * @param index the index
+ * @param id the RaSTA ID
+ */
+void rasta_id_index_remove(struct rasta_id_index * index, unsigned long id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAIDINDEX_H
@@ -20,6 +20,11 @@ typedef struct {
     MD4_u32plus block[16];
 } MD4_CTX_RASTA;
 
+/**
+ * amount of messages that md4MultiBuffer() hashes at once
+ */
+#define MD4_LANES 4
+
 #ifdef USE_OPENSSL
 #include <openssl/md4.h>
 #define MD4_CONTEXT MD4_CTX
@@ -46,6 +51,34 @@ MD4_CONTEXT md4InitContext (MD4_u32plus a, MD4_u32plus b, MD4_u32plus c, MD4_u32
  */
 void generateMD4(unsigned char* data, int length, int type, unsigned char* result);
 
+/**
+ * adds data to the MD4-Hash that is calculated in the context
+ * @param context the MD4 state
+ * @param data array of the data
+ * @param length of data
+ */
+void md4Update(MD4_CONTEXT* context, const unsigned char* data, unsigned long length);
+
+/**
+ * finishes the MD4-Hash that is calculated in the context and saves it in result
+ * @param context the MD4 state, it can not be used afterwards
+ * @param type of security code (0 means no code, 1 means half the code, 2 all of the code)
+ * @param result array for the result
+ */
+void md4Final(MD4_CONTEXT* context, int type, unsigned char* result);
+
+/**
+ * generates the full MD4-Hashes of multiple messages that start with the same state. MD4_LANES messages are
+ * processed at once
+ * @param context the state every message starts with, it is not modified
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages
+ * @param results the 16 byte hashes of the messages
+ */
+void md4MultiBuffer(const MD4_CONTEXT* context, const unsigned char* const* data, const unsigned int* lengths,
+                    unsigned int count, unsigned char (*results)[16]);
+
 /**
  * generates MD4-Hash for data and saves it in result
  * @param data array of the data
@@ -0,0 +1,366 @@
+#ifndef LST_SIMULATOR_RASTAMETRICS_H
+#define LST_SIMULATOR_RASTAMETRICS_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+
+/**
+ * Counters and latency histograms for capacity planning. Every counter has a single writer, the thread of the event
+ * loop, which updates it with relaxed atomic stores. So the counters can be read from any thread without locking,
+ * as long as the object that contains them exists
+ */
+
+/**
+ * amount of sub-buckets per power of two of a histogram, as a power of two. 2 bits of precision put a recorded
+ * value into a bucket that is at most 25% wider than the value
+ */
+#define RASTA_HISTOGRAM_SUB_BUCKET_BITS 2
+
+/**
+ * amount of buckets of a histogram, enough for all 32 bit values
+ */
+#define RASTA_HISTOGRAM_BUCKETS ((32 - RASTA_HISTOGRAM_SUB_BUCKET_BITS + 1) << RASTA_HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * a log-linear histogram like HDR histograms: the buckets double in width with every power of two, and every power of
+ * two is split into 1 << RASTA_HISTOGRAM_SUB_BUCKET_BITS linear sub-buckets. Has to be zero initialized
+ */
+struct rasta_histogram {
+    unsigned long buckets[RASTA_HISTOGRAM_BUCKETS];
+
+    /**
+     * the amount, the sum and the maximum of the recorded values
+     */
+    unsigned long count;
+    unsigned long sum;
+    unsigned long max;
+};
+
+/**
+ * traffic counters of a redundancy channel or of one of its transport channels
+ */
+struct rasta_transport_metrics {
+    unsigned long pdus_in;
+    unsigned long bytes_in;
+    unsigned long pdus_out;
+    unsigned long bytes_out;
+
+    /**
+     * received PDUs with an incorrect CRC checksum or safety code
+     */
+    unsigned long checksum_errors;
+};
+
+/**
+ * the priority classes of the send queue of a connection, see sr_send_priority(). The messages of the urgent lane are
+ * put into the next data PDU before any message of the bulk lane
+ */
+typedef enum {
+    RASTA_SEND_URGENT = 0,
+    RASTA_SEND_BULK = 1
+} rasta_send_priority;
+
+/**
+ * amount of priority classes of the send queue
+ */
+#define RASTA_SEND_PRIORITIES 2
+
+/**
+ * counters of a SR layer connection
+ */
+struct rasta_connection_metrics {
+    /**
+     * data PDUs that were sent again after a retransmission request
+     */
+    unsigned long retransmitted_pdus;
+
+    /**
+     * retransmission requests that were sent
+     */
+    unsigned long retransmission_requests;
+
+    /**
+     * received application messages that were dropped because the receive queue was full, and the times the
+     * confirmations were held back because the application did not retrieve its messages
+     */
+    unsigned long receive_overflows;
+    unsigned long receive_holds;
+
+    /**
+     * the round trip delay T_RTD in milliseconds, measured with the confirmed timestamp of every received PDU. The
+     * clocks of the entities are not synchronized, so half of it is an upper bound of the one-way delay
+     */
+    struct rasta_histogram round_trip_delay;
+
+    /**
+     * the time the event loop spent on the connection in nanoseconds: handling its received PDUs in the SR layer,
+     * and building and sending its data PDUs, retransmissions and heartbeats including their safety codes
+     */
+    unsigned long receive_ns;
+    unsigned long send_ns;
+
+    /**
+     * the time the application messages of every priority class waited in the send queue until their data PDU was
+     * built, in microseconds
+     */
+    struct rasta_histogram send_queue_us[RASTA_SEND_PRIORITIES];
+
+    /**
+     * the time the data packets waited for the turn of the connection in the send handler after they could have been
+     * sent, in microseconds
+     */
+    struct rasta_histogram send_schedule_us;
+};
+
+/**
+ * what a connection costs the entity, to find the peers that keep the event loop busy
+ */
+struct rasta_peer_usage {
+    unsigned long remote_id;
+
+    /**
+     * see rasta_connection_metrics::receive_ns and rasta_connection_metrics::send_ns
+     */
+    unsigned long receive_ns;
+    unsigned long send_ns;
+
+    /**
+     * the share of the connection in the time that the batched checks of the safety codes of received PDUs took
+     */
+    unsigned long safety_code_ns;
+
+    /**
+     * the PDUs and bytes passed to and from the SR layer
+     */
+    unsigned long pdus_in;
+    unsigned long bytes_in;
+    unsigned long pdus_out;
+    unsigned long bytes_out;
+
+    unsigned long retransmitted_pdus;
+};
+
+/**
+ * the stages that received PDUs pass through. Every stage processes the whole batch of PDUs before the next stage
+ * starts, so the code and the data of one stage stay in the caches while it runs
+ */
+typedef enum {
+    /**
+     * reading the datagrams from a socket
+     */
+    RASTA_RECEIVE_STAGE_DRAIN = 0,
+    /**
+     * decoding the redundancy layer PDUs and checking their CRC checksums
+     */
+    RASTA_RECEIVE_STAGE_CRC = 1,
+    /**
+     * checking if the redundancy channels would accept the sequence numbers of the PDUs
+     */
+    RASTA_RECEIVE_STAGE_PLAUSIBILITY = 2,
+    /**
+     * checking the safety codes of the SR layer PDUs, several at once
+     */
+    RASTA_RECEIVE_STAGE_SAFETY_CODE = 3,
+    /**
+     * ordering the PDUs of the redundancy channels and putting them into the receive queues
+     */
+    RASTA_RECEIVE_STAGE_SEQUENCING = 4,
+    /**
+     * handling the PDUs of the receive queues in the SR layer
+     */
+    RASTA_RECEIVE_STAGE_DISPATCH = 5,
+    RASTA_RECEIVE_STAGES = 6
+} rasta_receive_stage;
+
+/**
+ * the places where application messages and the PDUs that carry them wait inside the entity, from sr_send() on one
+ * side to sr_get_received_data() on the other
+ */
+typedef enum {
+    /**
+     * from sr_send() until the message is packed into a data PDU, i.e. coalescing, pacing and a closed send window
+     */
+    RASTA_RESIDENCY_SEND_QUEUE = 0,
+    /**
+     * from packing a data PDU until the sockets took it
+     */
+    RASTA_RESIDENCY_TRANSMIT = 1,
+    /**
+     * from taking a PDU from a socket until the redundancy channel released it in order, i.e. the checks of the
+     * receive path and the defer queue
+     */
+    RASTA_RESIDENCY_DEFER = 2,
+    /**
+     * from the release of a PDU until the SR layer took it from the receive FIFO of the redundancy channel
+     */
+    RASTA_RESIDENCY_RECEIVE_QUEUE = 3,
+    /**
+     * from the receive queue until the application read the message with sr_get_received_data()
+     */
+    RASTA_RESIDENCY_APPLICATION = 4,
+    RASTA_RESIDENCY_STAGES = 5
+} rasta_residency_stage;
+
+/**
+ * how long messages and PDUs waited in every stage, in microseconds. Only recorded with RASTA_RESIDENCY_HISTOGRAMS
+ */
+struct rasta_residency_metrics {
+    struct rasta_histogram wait_us[RASTA_RESIDENCY_STAGES];
+};
+
+/**
+ * how long the stages of the receive path took
+ */
+struct rasta_receive_stage_metrics {
+    /**
+     * the amount of batches and of PDUs that every stage processed
+     */
+    unsigned long batches[RASTA_RECEIVE_STAGES];
+    unsigned long pdus[RASTA_RECEIVE_STAGES];
+
+    /**
+     * the PDUs that every stage discarded, they do not reach the later stages
+     */
+    unsigned long rejected[RASTA_RECEIVE_STAGES];
+
+    /**
+     * the time every stage took for a batch, in nanoseconds
+     */
+    struct rasta_histogram duration[RASTA_RECEIVE_STAGES];
+};
+
+/**
+ * adds to a counter, may only be called by the single writer of the counter
+ * @param counter the counter
+ * @param amount the amount to add
+ */
+static inline void rasta_metrics_add(unsigned long * counter, unsigned long amount) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+/**
+ * reads a counter, may be called from any thread
+ * @param counter the counter
+ * @return the value of the counter
+ */
+static inline unsigned long rasta_metrics_read(const unsigned long * counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+/**
+ * records a value, may only be called by the single writer of the histogram
+ * @param histogram the histogram
+ * @param value the value, larger values than UINT32_MAX are counted in the last bucket
+ */
+void rasta_histogram_record(struct rasta_histogram * histogram, unsigned long value);
+
+/**
+ * copies a histogram, may be called from any thread. The copy is not taken atomically, so a value that is recorded
+ * at the same time may be missing from some of the fields
+ * @param histogram the histogram
+ * @param out the copy is written in here
+ */
+void rasta_histogram_snapshot(const struct rasta_histogram * histogram, struct rasta_histogram * out);
+
+/**
+ * @param bucket the index of a bucket
+ * @return the largest value that is counted in @p bucket
+ */
+unsigned long rasta_histogram_bucket_limit(unsigned int bucket);
+
+/**
+ * estimates a percentile of the recorded values
+ * @param histogram the histogram, should be a snapshot if it is written at the same time
+ * @param percentile the percentile between 0 and 100
+ * @return the largest value of the bucket that contains the percentile, at most the maximum. 0 if the histogram is empty
+ */
+unsigned long rasta_histogram_percentile(const struct rasta_histogram * histogram, double percentile);
+
+/**
+ * records that a stage processed a batch of received PDUs, may only be called by the single writer of the metrics
+ * @param metrics the metrics of the receive path
+ * @param stage the stage
+ * @param pdus the amount of PDUs in the batch
+ * @param duration the time the stage took for the batch, in nanoseconds
+ */
+void rasta_receive_stage_record(struct rasta_receive_stage_metrics * metrics, rasta_receive_stage stage,
+                                unsigned int pdus, unsigned long duration);
+
+/**
+ * records that a stage discarded received PDUs, may only be called by the single writer of the metrics
+ * @param metrics the metrics of the receive path
+ * @param stage the stage
+ * @param pdus the amount of discarded PDUs
+ */
+void rasta_receive_stage_reject(struct rasta_receive_stage_metrics * metrics, rasta_receive_stage stage,
+                                unsigned int pdus);
+
+/**
+ * copies the metrics of the receive path, may be called from any thread, see rasta_histogram_snapshot()
+ * @param metrics the metrics
+ * @param out the copy is written in here
+ */
+void rasta_receive_stage_snapshot(const struct rasta_receive_stage_metrics * metrics,
+                                  struct rasta_receive_stage_metrics * out);
+
+/**
+ * records how long a message or a PDU waited in a stage, may only be called by the single writer of the metrics
+ * @param metrics the metrics, nothing is recorded if it is NULL
+ * @param stage the stage
+ * @param since_ns the time it entered the stage in the nanoseconds of get_nanotime(), nothing is recorded if it is 0
+ * @param now_ns the time it left the stage
+ */
+void rasta_residency_record(struct rasta_residency_metrics * metrics, rasta_residency_stage stage, uint64_t since_ns,
+                            uint64_t now_ns);
+
+/**
+ * adds a copy of the histograms of some stages to a snapshot, may be called from any thread, see
+ * rasta_histogram_snapshot()
+ * @param metrics the metrics, nothing is copied if it is NULL
+ * @param first the first stage that is copied
+ * @param last the last stage that is copied
+ * @param out the histograms are written in here
+ */
+void rasta_residency_snapshot(const struct rasta_residency_metrics * metrics, rasta_residency_stage first,
+                              rasta_residency_stage last, struct rasta_residency_metrics * out);
+
+/**
+ * @param stage a stage of the residency of messages
+ * @return the name of the stage, as used for the labels of the metrics
+ */
+const char * rasta_residency_stage_name(rasta_residency_stage stage);
+
+/**
+ * @param usage what a connection costs
+ * @return the time the event loop spent on the connection in nanoseconds
+ */
+static inline unsigned long rasta_peer_usage_ns(const struct rasta_peer_usage * usage) {
+    return usage->receive_ns + usage->send_ns + usage->safety_code_ns;
+}
+
+/**
+ * adds a peer to a ranking of the peers that cost the most time, ties are ranked by their bytes
+ * @param ranking the ranking, ordered from the most expensive peer
+ * @param count the amount of peers in @p ranking
+ * @param capacity the maximum amount of peers in @p ranking, a peer that is cheaper than all of them is not added
+ * @param usage what the peer costs
+ * @return the amount of peers in @p ranking afterwards
+ */
+unsigned int rasta_peer_ranking_insert(struct rasta_peer_usage * ranking, unsigned int count, unsigned int capacity,
+                                       const struct rasta_peer_usage * usage);
+
+/**
+ * @param stage a stage of the receive path
+ * @return the name of the stage, as used for the labels of the metrics
+ */
+const char * rasta_receive_stage_name(rasta_receive_stage stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAMETRICS_H
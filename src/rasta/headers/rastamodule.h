@@ -155,9 +155,10 @@ struct RastaPacket {
 
     unsigned short length;
     /**
-     *  the package type
+     *  the package type, one of rasta_conn_type. Kept in the 2 bytes of the PDU field, so it shares 4 bytes with
+     *  the length
      */
-    rasta_conn_type type;
+    uint16_t type;
 
     uint32_t receiver_id;
     uint32_t sender_id;
@@ -169,12 +170,13 @@ struct RastaPacket {
     uint32_t timestamp;
     uint32_t confirmed_timestamp;
 
-    struct RastaByteArray data;
-    struct RastaByteArray checksum;
-
     //1 if the checksum is correct, 0 if it's not
     //NOTE: this field is only set, if you use the "bytestoRastaPacket" function
+    //in front of the byte arrays, so the packet fits into 64 bytes without padding
     int checksum_correct;
+
+    struct RastaByteArray data;
+    struct RastaByteArray checksum;
 };
 
 /**
@@ -208,9 +210,83 @@ struct RastaRedundancyPacket {
     int checksum_correct;
 
     /**
-     * the parameters of the checksum that is used
+     * the parameters of the checksum that is used, they are not copied and have to outlive the packet.
+     * NULL for a received packet whose checksum has been checked already
+     */
+    struct crc_options * checksum_type;
+};
+
+/**
+ * non-owning view of a RaSTA SR layer PDU inside a byte buffer. The header fields are decoded, data and checksum
+ * point into the buffer, so the view is only valid as long as the buffer
+ */
+struct RastaPacketView {
+    /**
+     * the length of the packet
+     */
+    unsigned short length;
+
+    /**
+     *  the package type
+     */
+    rasta_conn_type type;
+
+    uint32_t receiver_id;
+    uint32_t sender_id;
+
+    uint32_t sequence_number;
+    uint32_t confirmed_sequence_number;
+
+    uint32_t timestamp;
+    uint32_t confirmed_timestamp;
+
+    /**
+     * the payload of the packet and its length
+     */
+    const unsigned char * data;
+    unsigned int data_length;
+
+    /**
+     * the safety code of the packet and its length
+     */
+    const unsigned char * checksum;
+    unsigned int checksum_length;
+
+    /**
+     * 1 if the safety code is correct, 0 otherwise
+     */
+    int checksum_correct;
+};
+
+/**
+ * non-owning view of a RaSTA redundancy layer PDU inside a byte buffer, see RastaPacketView
+ */
+struct RastaRedundancyPacketView {
+    /**
+     * the overall length of the redundancy packet
+     */
+    uint16_t length;
+
+    /**
+     * reserved bytes for future use
+     */
+    uint16_t reserve;
+
+    /**
+     * pdu sequence number
+     */
+    uint32_t sequence_number;
+
+    /**
+     * the carried SR layer PDU
+     */
+    struct RastaPacketView data;
+
+    /**
+     * 1 if the CRC checksum correct, 0 otherwise
+     * Will be 1 of no checksum was used
      */
-    struct crc_options checksum_type;
+    int checksum_correct;
 };
 
 /**
@@ -220,6 +296,33 @@ struct RastaRedundancyPacket {
  */
 struct RastaByteArray rastaModuleToBytes(struct RastaPacket packet, rasta_hashing_context_t * hashing_context);
 
+/**
+ * writes a rasta packet including its safety code into a buffer that is provided by the caller
+ * @param packet the packet
+ * @param hashing_context the hashing parameters that are used for the safety code
+ * @param buffer the buffer the packet is written to
+ * @param capacity the amount of bytes available in @p buffer
+ * @return the amount of bytes written, 0 if the length of the packet is invalid or exceeds @p capacity
+ */
+unsigned int rastaPacketEncode(const struct RastaPacket * packet, rasta_hashing_context_t * hashing_context,
+                               unsigned char * buffer, unsigned int capacity);
+
+/**
+ * changes the header fields of an encoded rasta packet that differ between a packet and its retransmission and
+ * calculates the safety code again. The data of the packet stays as it is
+ * @param pdu the encoded packet
+ * @param length the length of the encoded packet
+ * @param type the new packet type
+ * @param sequence_number the new sequence number
+ * @param confirmed_sequence_number the new confirmed sequence number
+ * @param timestamp the new timestamp
+ * @param confirmed_timestamp the new confirmed timestamp
+ * @param hashing_context the hashing parameters that are used for the safety code
+ */
+void rastaPacketRestamp(unsigned char * pdu, unsigned int length, rasta_conn_type type, uint32_t sequence_number,
+                        uint32_t confirmed_sequence_number, uint32_t timestamp, uint32_t confirmed_timestamp,
+                        rasta_hashing_context_t * hashing_context);
+
 /**
  * Accepts a rasta packet and converts it into an allocated bytearray without calculating the safety code
  * @param packet the packet
@@ -234,24 +337,157 @@ struct RastaByteArray rastaModuleToBytesNoChecksum(struct RastaPacket packet, ra
  */
 struct RastaPacket bytesToRastaPacket(struct RastaByteArray data, rasta_hashing_context_t * hashing_context);
 
+/**
+ * decodes a rasta packet without copying it and checks the safety code
+ * @param bytes the buffer that contains the packet
+ * @param length the amount of bytes in @p bytes
+ * @param hashing_context the hashing parameters that are used for the safety code
+ * @param view the view that is filled, it points into @p bytes
+ * @return 1 if the packet was decoded, 0 if @p length or the length field of the packet is invalid
+ */
+int rastaPacketViewFromBytes(const unsigned char * bytes, unsigned int length, rasta_hashing_context_t * hashing_context,
+                             struct RastaPacketView * view);
+
+/**
+ * copies a viewed rasta packet into a packet that owns its data and checksum
+ * @param view the view of the packet
+ * @return the packet, free data and checksum with freeRastaByteArray
+ */
+struct RastaPacket rastaPacketFromView(const struct RastaPacketView * view);
+
 
 /**
  * Accepts a RaSTA redundancy layer packet and converts it into a byte array
- * @param packet the redundancy layer packet that will be converted
+ * @param packet the redundancy layer packet that will be converted, packet#checksum_type must be set
  * @param hashing_context the hashing parameters that are used for the SR layer hash
  * @return an already allocated RastaByteArray (no need to free it yourself)
  */
-struct RastaByteArray rastaRedundancyPacketToBytes(struct RastaRedundancyPacket packet, rasta_hashing_context_t * hashing_context);
+struct RastaByteArray rastaRedundancyPacketToBytes(const struct RastaRedundancyPacket * packet, rasta_hashing_context_t * hashing_context);
+
+/**
+ * writes a RaSTA redundancy layer PDU that wraps @p packet into a buffer that is provided by the caller.
+ * Header, SR layer PDU, safety code and CRC checksum are written in one pass without further allocations
+ * @param sequence_number the redundancy layer sequence number
+ * @param packet the SR layer PDU that is transported
+ * @param checksum_type the options that are used to generate the CRC checksum
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @param buffer the buffer the PDU is written to
+ * @param capacity the amount of bytes available in @p buffer
+ * @return the amount of bytes written, 0 if the PDU is invalid or exceeds @p capacity
+ */
+unsigned int rastaRedundancyPacketEncode(uint32_t sequence_number, const struct RastaPacket * packet,
+                                         struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context,
+                                         unsigned char * buffer, unsigned int capacity);
+
+/**
+ * writes a RaSTA redundancy layer PDU that wraps an already encoded SR layer PDU into a buffer that is provided by
+ * the caller, so the safety code of the SR layer PDU is not calculated again
+ * @param sequence_number the redundancy layer sequence number
+ * @param pdu the encoded SR layer PDU, see rastaPacketEncode()
+ * @param pdu_length the length of @p pdu
+ * @param checksum_type the options that are used to generate the CRC checksum
+ * @param buffer the buffer the PDU is written to
+ * @param capacity the amount of bytes available in @p buffer
+ * @return the amount of bytes written, 0 if the PDU exceeds @p capacity
+ */
+unsigned int rastaRedundancyPacketWrap(uint32_t sequence_number, const unsigned char * pdu, unsigned int pdu_length,
+                                       struct crc_options * checksum_type, unsigned char * buffer,
+                                       unsigned int capacity);
 
 /**
  * Accepts a byte array and converts it into a RaSTA redundancy layer packet
  * This function will check whether the CRC checksum is correct and set the flag RastaRedundancyPacket#checksum_correct
  * @param data the byte array which contains the packet
- * @param checksum_type the options that were used to generate the checksum in the @p data byte array
+ * @param checksum_type the options that were used to generate the checksum in the @p data byte array, the returned
+ * packet refers to them
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @return a RaSTA Redundancy layer packet containing all data that was in the @p data byte array
+ */
+struct RastaRedundancyPacket bytesToRastaRedundancyPacket(struct RastaByteArray data, struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context);
+
+/**
+ * Accepts a byte array and converts it into a RaSTA redundancy layer packet, the same as bytesToRastaRedundancyPacket()
+ * @param data the byte array which contains the packet
+ * @param checksum_type the options that were used to generate the checksum in the @p data byte array. The CRC table
+ * is generated if it does not exist yet, generate it beforehand to use the options from multiple threads
  * @param hashing_context the hashing parameters that are used for the SR layer hash
  * @return a RaSTA Redundancy layer packet containing all data that was in the @p data byte array
  */
-struct RastaRedundancyPacket bytesToRastaRedundancyPacket(struct RastaByteArray data, struct crc_options checksum_type, rasta_hashing_context_t * hashing_context);
+struct RastaRedundancyPacket bytesToRastaRedundancyPacketWithOptions(struct RastaByteArray data, struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context);
+
+/**
+ * decodes a RaSTA redundancy layer packet without copying it and checks the CRC checksum and the safety code of the
+ * carried SR layer PDU
+ * @param bytes the buffer that contains the packet
+ * @param length the amount of bytes in @p bytes
+ * @param checksum_type the options that were used to generate the checksum, see bytesToRastaRedundancyPacketWithOptions
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @param view the view that is filled, it points into @p bytes
+ * @return 1 if the packet was decoded, 0 if it is too short to carry an SR layer PDU
+ */
+int rastaRedundancyPacketViewFromBytes(const unsigned char * bytes, unsigned int length, struct crc_options * checksum_type,
+                                       rasta_hashing_context_t * hashing_context, struct RastaRedundancyPacketView * view);
+
+/**
+ * reads the sequence number of a redundancy layer packet and the receiver and the sender of the carried SR layer PDU,
+ * without checking the packet
+ * @param bytes the buffer that contains the packet
+ * @param length the amount of bytes in @p bytes
+ * @param sequence_number set to the sequence number of the redundancy layer packet
+ * @param receiver_id set to the receiver of the SR layer PDU
+ * @param sender_id set to the sender of the SR layer PDU
+ * @return 1 if the packet is long enough to carry an SR layer header, 0 otherwise
+ */
+int rastaRedundancyPacketPeek(const unsigned char * bytes, unsigned int length, uint32_t * sequence_number,
+                              uint32_t * receiver_id, uint32_t * sender_id);
+
+/**
+ * the first stage of rastaRedundancyPacketViewsFromBytes(): decodes multiple redundancy layer packets and checks their
+ * CRC checksums. The safety codes are not checked, the SR layer packets are marked as incorrect until
+ * rastaRedundancyPacketViewsCheckSafetyCode() checked them
+ * @param bytes the buffers that contain the packets
+ * @param lengths the amount of bytes in every buffer
+ * @param count the amount of packets
+ * @param checksum_type the options that were used to generate the CRC checksums
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @param views the views that are filled, they point into @p bytes
+ * @param decoded set to the return value of rastaRedundancyPacketViewFromBytes() for every packet
+ * @return the amount of packets with a correct CRC checksum, whose safety code still has to be checked with
+ * rastaRedundancyPacketViewsCheckSafetyCode()
+ */
+unsigned int rastaRedundancyPacketViewsCheckCrc(unsigned char * const * bytes, const unsigned int * lengths,
+                                                unsigned int count, struct crc_options * checksum_type,
+                                                rasta_hashing_context_t * hashing_context,
+                                                struct RastaRedundancyPacketView * views, int * decoded);
+
+/**
+ * the second stage of rastaRedundancyPacketViewsFromBytes(): checks the safety codes of the decoded SR layer packets
+ * together, see rasta_hash_verify_batch(). Packets with an incorrect CRC checksum are skipped
+ * @param bytes the buffers that contain the packets
+ * @param count the amount of packets
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @param views the views of rastaRedundancyPacketViewsCheckCrc()
+ * @param verify the packets whose safety code is checked, e.g. the results of rastaRedundancyPacketViewsCheckCrc()
+ * @return the amount of checked safety codes
+ */
+unsigned int rastaRedundancyPacketViewsCheckSafetyCode(unsigned char * const * bytes, unsigned int count,
+                                                       rasta_hashing_context_t * hashing_context,
+                                                       struct RastaRedundancyPacketView * views, const int * verify);
+
+/**
+ * decodes multiple redundancy layer packets like rastaRedundancyPacketViewFromBytes(). The safety codes of the SR
+ * layer packets are checked together, see rasta_hash_verify_batch()
+ * @param bytes the buffers that contain the packets
+ * @param lengths the amount of bytes in every buffer
+ * @param count the amount of packets
+ * @param checksum_type the options that were used to generate the CRC checksums
+ * @param hashing_context the hashing parameters that are used for the SR layer hash
+ * @param views the views that are filled, they point into @p bytes
+ * @param decoded set to the return value of rastaRedundancyPacketViewFromBytes() for every packet
+ */
+void rastaRedundancyPacketViewsFromBytes(unsigned char * const * bytes, const unsigned int * lengths, unsigned int count,
+                                         struct crc_options * checksum_type, rasta_hashing_context_t * hashing_context,
+                                         struct RastaRedundancyPacketView * views, int * decoded);
 
 #ifdef __cplusplus
 }
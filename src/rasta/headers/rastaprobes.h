@@ -0,0 +1,39 @@
+#ifndef LST_SIMULATOR_RASTAPROBES_H
+#define LST_SIMULATOR_RASTAPROBES_H
+
+/**
+ * USDT probes of the provider "rasta" at the hot paths of the protocol, for perf and bpftrace. They are only compiled
+ * in with the CMake option ENABLE_RASTA_USDT, without it they expand to nothing and their arguments are not evaluated.
+ * A probe that is compiled in costs a nop as long as no tracer is attached.
+ * Example bpftrace scripts are in examples/bpftrace.
+ *
+ * The probes and their arguments:
+ *   red_receive(remote_id, seq_pdu, channel)        redundancy PDU with a correct checksum received
+ *   red_checksum_error(remote_id, channel)          redundancy PDU with an incorrect checksum discarded
+ *   red_discard(remote_id, seq_pdu, reason)         redundancy PDU discarded, reason is a rasta_trace_discard_reason
+ *   red_defer(remote_id, seq_pdu, seq_rx)           redundancy PDU added to the defer queue
+ *   red_defer_timeout(remote_id, seq_rx)            defer timeout skipped the missing PDUs
+ *   red_deliver(remote_id, seq_pdu, sn)             SR PDU with sequence number sn passed to the SR layer
+ *   red_send(remote_id, seq_tx, channel_count)      redundancy PDU created for sending
+ *   red_send_channel(remote_id, channel, length)    redundancy PDU sent on one transport channel
+ *   sr_receive(remote_id, sn, type)                 SR PDU taken from the redundancy layer by the SR layer
+ *   sr_discard(remote_id, sn, reason)               SR PDU discarded, reason is a rasta_trace_discard_reason
+ *   sr_state(remote_id, old_state, new_state)       state of a connection changed, see rasta_sr_state
+ *   sr_retransmit_start(remote_id, sn, count)       the unconfirmed PDUs are sent again, starting with sn
+ *   sr_retransmit_end(remote_id, sn)                the retransmission was sent and closed with a heartbeat
+ *   sr_heartbeat_send(remote_id, sn)                heartbeat sent
+ *   sr_heartbeat_receive(remote_id, sn)             heartbeat received
+ */
+
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+
+#define RASTA_PROBE2(name, a, b) DTRACE_PROBE2(rasta, name, a, b)
+#define RASTA_PROBE3(name, a, b, c) DTRACE_PROBE3(rasta, name, a, b, c)
+#else
+// sizeof does not evaluate the arguments, but keeps variables that are only passed to probes from being unused
+#define RASTA_PROBE2(name, a, b) ((void) sizeof(a), (void) sizeof(b))
+#define RASTA_PROBE3(name, a, b, c) ((void) sizeof(a), (void) sizeof(b), (void) sizeof(c))
+#endif
+
+#endif //LST_SIMULATOR_RASTAPROBES_H
@@ -7,17 +7,39 @@ extern "C" {  // only need to export C interface if
 #endif
 
 #include <stdint.h>
+#include <netinet/in.h>
 #include "rastadeferqueue.h"
+#include "rastaarrivalring.h"
 #include "rastacrc.h"
 #include "logging.h"
 #include "config.h"
 #include "fifo.h"
+#include "rastametrics.h"
+#include "event_system.h"
 
 /**
  * maximum size of messages in the defer queue in bytes
  */
 #define MAX_DEFER_QUEUE_MSG_SIZE 1000
 
+/**
+ * an SR layer PDU in the receive FIFO of a redundancy channel
+ */
+struct rasta_delivered_packet {
+    struct RastaPacket packet;
+
+    /**
+     * the time the PDU was pushed into the FIFO in the nanoseconds of get_nanotime(), 0 if residency is not recorded
+     */
+    uint64_t delivered_ns;
+};
+
+/**
+ * the amount of delays between the copies of PDUs a diagnose window has to contain before the defer timeout is
+ * adapted to them
+ */
+#define RED_ADAPTIVE_MIN_SAMPLES 16
+
 /**
  * representation of the transport channel diagnostic data
  */
@@ -42,10 +64,27 @@ typedef struct {
      */
     unsigned long t_drift2;
 
+    /**
+     * Non-standard extension: the amount of delays that were added to t_drift and t_drift2
+     */
+    unsigned long drift_samples;
+
     /**
      * amount of packets that are received within the current diagnose window
      */
     int received_packets;
+
+    /**
+     * Non-standard extension: the datagrams the kernel dropped on the local socket of the transport channel in the
+     * last finished diagnose window because its receive buffer was full, of all remote entities on the socket. They
+     * are counted in n_missed as well, but were lost on this host and not on the network
+     */
+    unsigned long kernel_drops;
+
+    /**
+     * the drop counter of the socket when the current diagnose window was started
+     */
+    uint64_t kernel_drops_start;
 }rasta_redundancy_diagnostics_data;
 
 /**
@@ -68,7 +107,7 @@ typedef enum {
  */
 typedef struct {
     /**
-     * IPv4 address in format a.b.c.d
+     * IPv4 address in format a.b.c.d, only used for logging and by the applications
      */
     char * ip_address;
 
@@ -77,13 +116,35 @@ typedef struct {
      */
     uint16_t port;
 
+    /**
+     * ip_address and port resolved once, so sending does not have to parse the address again
+     */
+    struct sockaddr_in address;
+
+    /**
+     * address and port packed by sockaddr_to_endpoint(), received datagrams are matched to the channel by this key
+     */
+    uint64_t endpoint;
+
+    /**
+     * the index of the local UDP socket the channel sends and receives on, see rasta_redundancy_channel#path_channels
+     */
+    unsigned int path;
+
     /**
      * data used for transport channel diagnostics as in 6.6.3.2
      */
     rasta_redundancy_diagnostics_data diagnostics_data;
+
+    /**
+     * the traffic on this transport channel
+     */
+    struct rasta_transport_metrics metrics;
 }rasta_transport_channel;
 
 
+struct redundancy_mux;
+
 /**
  * representation of a RaSTA redundancy channel
  */
@@ -119,12 +180,43 @@ typedef struct {
     struct defer_queue defer_q;
 
     /**
-     * used to store all received packets within a diagnose window
+     * fires defer_timeout after the oldest PDU in the defer queue was received and calls rasta_red_f_deferTmo(), armed
+     * by the multiplexer in mux while its event loop runs
+     */
+    timed_event defer_timeout_event;
+    struct redundancy_mux * mux;
+
+    /**
+     * the time in ms a missing PDU is waited for, T_SEQ unless it is adapted to the skew between the transport
+     * channels, see rasta_red_adapt_defer_timeout()
+     */
+    unsigned int defer_timeout;
+
+    /**
+     * amount of calls of rasta_red_f_deferTmo(), i.e. how often missing PDUs were given up
+     */
+    unsigned long defer_timeouts;
+
+    /**
+     * the share of the channel in the time of the batched safety code checks of received PDUs, in nanoseconds
+     */
+    unsigned long safety_code_ns;
+
+    /**
+     * the residency of the received PDUs in RASTA_RESIDENCY_DEFER and RASTA_RESIDENCY_RECEIVE_QUEUE, NULL unless
+     * RASTA_RESIDENCY_HISTOGRAMS is set
+     */
+    struct rasta_residency_metrics * residency;
+
+    /**
+     * the arrival times of the PDUs that were received first within a diagnose window, at least the last
+     * 10 * n_deferqueue_size of them
      */
-    struct defer_queue diagnostics_packet_buffer;
+    struct rasta_arrival_ring diagnostics_arrivals;
 
     /**
-     * the FIFO where the messages for the upper layer are stored
+     * the FIFO where the messages for the upper layer are stored.
+     * The elements are allocated, already decoded SR layer PDUs (struct rasta_delivered_packet *)
      */
     fifo_t * fifo_recv;
 
@@ -144,6 +236,18 @@ typedef struct {
      */
     unsigned int transport_channel_count;
 
+    /**
+     * the index in connected_channels of the transport channel of every local UDP socket, -1 while the channel of a
+     * socket is not known. A server discovers the channels in the order their first PDUs arrive, so the index of a
+     * transport channel is not the one of its socket. Has transport_channel_count entries
+     */
+    int * path_channels;
+
+    /**
+     * the PDUs passed to and from the SR layer, i.e. without the copies on the other transport channels
+     */
+    struct rasta_transport_metrics metrics;
+
     /**
      * logger used for logging
      */
@@ -154,6 +258,24 @@ typedef struct {
      */
     int is_open;
 
+    /**
+     * 1 if seq_rx is taken from the next PDU with a correct checksum, e.g. after a standby took the channel over
+     */
+    int resync;
+
+    /**
+     * Non-standard extension: 1 while the channel was created for an unknown sender and the SR layer did not accept a
+     * connection request of it yet, see redundancy_mux_confirm_channel()
+     */
+    int pending;
+
+    /**
+     * the PDUs of a pending channel that were handed to the SR layer and the time the last one was received, in the
+     * milliseconds of current_ts()
+     */
+    unsigned int pending_pdus;
+    uint32_t last_received;
+
     /**
      * configuration parameters of the redundancy layer
      */
@@ -179,17 +301,75 @@ rasta_redundancy_channel rasta_red_init(struct logger_t logger, struct RastaConf
 /**
  * the f_receive function of the redundancy layer
  * @param channel the redundancy channel that is used
- * @param packet the packet that has been received over UDP
+ * @param packet the packet that has been received over UDP. The channel takes over the memory of packet#data,
+ * in the end it is either passed to the next layer or freed
  * @param channel_id the index of the transport channel, the @p packet has been received
  */
-void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedundancyPacket packet, int channel_id);
+void rasta_red_f_receive(rasta_redundancy_channel * channel, struct RastaRedundancyPacket * packet, int channel_id);
+
+/**
+ * the f_receive function of the redundancy layer for a PDU that is still in the receive buffer. The carried SR layer
+ * PDU is only copied if the channel passes it to the next layer or defers it
+ * @param channel the redundancy channel that is used
+ * @param packet the view of the packet that has been received over UDP
+ * @param channel_id the index of the transport channel, the @p packet has been received
+ * @param received_at the time the @p packet has been received in the milliseconds of current_ts()
+ * @param received_ns the time the @p packet was taken from the socket in the nanoseconds of get_nanotime(), 0 if it
+ * is not known
+ */
+void rasta_red_f_receive_view(rasta_redundancy_channel * channel, const struct RastaRedundancyPacketView * packet, int channel_id,
+                              uint32_t received_at, uint64_t received_ns);
+
+/**
+ * checks if the channel would pass a PDU with a correct CRC checksum to the next layer or defer it. The other PDUs are
+ * discarded by their sequence number, so their safety code does not have to be checked
+ * @param channel the redundancy channel that is used
+ * @param sequence_number the sequence number of the redundancy layer PDU
+ * @return 1 if the PDU is kept, 0 if rasta_red_f_receive() discards it
+ */
+int rasta_red_f_sequence_plausible(rasta_redundancy_channel * channel, unsigned long sequence_number);
+
+/**
+ * checks if a PDU is the copy of one that has been received on another transport channel before, by its sequence
+ * number only
+ * @param channel the redundancy channel that is used
+ * @param sequence_number the sequence number of the redundancy layer PDU
+ * @return 1 if rasta_red_f_receive_duplicate() would handle the PDU, 0 otherwise
+ */
+int rasta_red_f_known_duplicate(rasta_redundancy_channel * channel, unsigned long sequence_number);
+
+/**
+ * checks if a PDU is the copy of one that has been received on another transport channel before, by its sequence
+ * number only. A known copy is counted like the duplicates rasta_red_f_receive() discards and its delay is added to
+ * the diagnostics, its safety code does not have to be checked then. Its CRC checksum has to be checked before, so a
+ * damaged PDU is not counted as received. The channel must know all transport channels
+ * @param channel the redundancy channel that is used
+ * @param sequence_number the sequence number of the redundancy layer PDU
+ * @param length the length of the PDU
+ * @param channel_id the index of the transport channel the PDU has been received on
+ * @param received_at the time the PDU has been received in the milliseconds of current_ts()
+ * @return 1 if the PDU is a known duplicate and was handled, 0 if it has to be decoded and passed to
+ * rasta_red_f_receive_view()
+ */
+int rasta_red_f_receive_duplicate(rasta_redundancy_channel * channel, unsigned long sequence_number, unsigned int length,
+                                  int channel_id, uint32_t received_at);
 
 /**
- * the f_deferTmo function of the redundancy layer
+ * the f_deferTmo function of the redundancy layer: the missing PDUs before the smallest deferred sequence number are
+ * given up and the deferred PDUs are delivered up to the next gap. Does nothing if the defer queue is empty
  * @param channel the redundancy channel that is used
  */
 void rasta_red_f_deferTmo(rasta_redundancy_channel * channel);
 
+/**
+ * Non-standard extension: sets the defer timeout of a channel to the skew between its transport channels in the
+ * diagnose window that just finished, mean + k * standard deviation of the delays in t_drift and t_drift2 with k =
+ * RastaConfigInfoRedundancy#adaptive_t_seq, at most T_SEQ. Keeps T_SEQ while adaptive_t_seq is 0 or the window did
+ * not contain RED_ADAPTIVE_MIN_SAMPLES delays. Has to be called before the diagnostics of the window are reset
+ * @param channel the redundancy channel
+ */
+void rasta_red_adapt_defer_timeout(rasta_redundancy_channel * channel);
+
 /**
  * blocks until the tls_state is closed and all notification threads terminate
  * @param channel the channel that is used
@@ -204,6 +384,34 @@ void rasta_red_wait_for_close(rasta_redundancy_channel * channel);
  */
 void rasta_red_add_transport_channel(rasta_redundancy_channel * channel, char * ip, uint16_t port);
 
+/**
+ * adds a transport channel that sends and receives on a given local UDP socket, e.g. one a server discovered
+ * @param channel the redundancy channel where the transport channel will be added
+ * @param transport_channel the transport channel, the redundancy channel takes over its memory
+ * @param path the index of the local UDP socket
+ * @return the index of the transport channel in connected_channels
+ */
+unsigned int rasta_red_bind_transport_channel(rasta_redundancy_channel * channel, rasta_transport_channel transport_channel,
+                                              unsigned int path);
+
+/**
+ * @param channel the redundancy channel
+ * @param path the index of a local UDP socket
+ * @return the index in connected_channels of the transport channel on the socket, -1 if it is not known yet
+ */
+static inline int rasta_red_path_channel(const rasta_redundancy_channel * channel, unsigned int path) {
+    return path < channel->transport_channel_count ? channel->path_channels[path] : -1;
+}
+
+/**
+ * changes the size of the defer queue and the receive buffers of an open channel, the PDUs in them are kept
+ * @param channel the redundancy channel
+ * @param n_deferqueue_size the new size of the defer queue
+ * @param send_max the send window of the peer, the receive buffer holds at least as many PDUs
+ * @return 1 if the buffers were resized, 0 if they hold more PDUs than fit and were not changed
+ */
+int rasta_red_resize_buffers(rasta_redundancy_channel * channel, unsigned int n_deferqueue_size, unsigned int send_max);
+
 /**
  * frees memory for the @p channel
  * @param channel the channel that is freed
@@ -0,0 +1,352 @@
+#ifndef LST_SIMULATOR_RASTAREPLICATION_H
+#define LST_SIMULATOR_RASTAREPLICATION_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include "config.h"
+#include "event_system.h"
+#include "rastaidindex.h"
+#include "rastaretrbuffer.h"
+
+/**
+ * Non-standard extension: a TCP stream from a primary RaSTA entity to a hot standby. The primary sends the state of
+ * every connection that changed since the last round: the sequence numbers and timestamps of the SR layer, the
+ * sequence numbers and transport channels of the redundancy channel, the session key and the unconfirmed PDUs of the
+ * retransmission buffer. Every round ends with a ROUND record that carries the time of the primary, so the standby
+ * knows the stream is alive and how far its clock is off. The standby keeps the latest record of every connection and
+ * decodes them when it takes over.
+ *
+ * A record is a 12 byte header followed by its body, all integers are little endian:
+ * - 4 bytes RASTA_REPLICATION_MAGIC
+ * - 2 bytes RASTA_REPLICATION_VERSION
+ * - 2 bytes the record type
+ * - 4 bytes the length of the body
+ */
+
+#define RASTA_REPLICATION_MAGIC 0x52535250
+#define RASTA_REPLICATION_VERSION 1
+#define RASTA_REPLICATION_HEADER_SIZE 12
+
+/**
+ * the bytes that queue up for a standby that does not read before rounds are skipped
+ */
+#define RASTA_REPLICATION_MAX_QUEUED (4 * 1024 * 1024)
+
+/**
+ * the largest body a standby accepts
+ */
+#define RASTA_REPLICATION_MAX_RECORD (1024 * 1024)
+
+/**
+ * the amount of rounds without a ROUND record after which a standby considers the primary lost
+ */
+#define RASTA_REPLICATION_TIMEOUT_ROUNDS 3
+
+#define RASTA_REPLICA_MAX_CHANNELS 8
+#define RASTA_REPLICA_MAX_KEY 64
+
+typedef enum {
+    /**
+     * the state of a connection, the body is encoded by rasta_replica_encode()
+     */
+    RASTA_REPLICATION_CONNECTION = 1,
+    /**
+     * a connection was closed, the body is the 4 byte remote id
+     */
+    RASTA_REPLICATION_REMOVE = 2,
+    /**
+     * the end of a round, the body is the 4 byte timestamp of the primary and the 4 byte interval of the rounds in ms
+     */
+    RASTA_REPLICATION_ROUND = 3,
+    /**
+     * all records sent before are void, sent when the stream starts and when the primary shuts down
+     */
+    RASTA_REPLICATION_RESET = 4
+} rasta_replication_record_type;
+
+/**
+ * the replicated state of a connection
+ */
+struct rasta_replica {
+    uint32_t my_id;
+    uint32_t remote_id;
+    uint32_t network_id;
+    uint8_t role;
+
+    uint32_t sn_t;
+    uint32_t sn_r;
+    uint32_t cs_t;
+    uint32_t cs_r;
+    uint32_t ts_r;
+    uint32_t cts_r;
+    uint32_t sn_i;
+    uint32_t t_i;
+    int32_t connected_recv_buffer_size;
+
+    /**
+     * the timestamps of the connection minus the clock of the primary, not 0 for a connection the primary took over
+     */
+    uint32_t timestamp_offset;
+
+    /**
+     * the sequence numbers of the redundancy channel
+     */
+    uint32_t seq_tx;
+    uint32_t seq_rx;
+
+    /**
+     * the transport channels of the partner that are known to the redundancy channel
+     */
+    unsigned int channel_count;
+    struct RastaIPData channels[RASTA_REPLICA_MAX_CHANNELS];
+
+    /**
+     * the session key of the key exchange, key_length is 0 without one
+     */
+    unsigned int key_length;
+    uint8_t key[RASTA_REPLICA_MAX_KEY];
+
+    /**
+     * the unconfirmed PDUs of the retransmission buffer as they are in the decoded record, see rasta_replica_next_pdu()
+     */
+    const unsigned char * retr;
+    size_t retr_length;
+    unsigned int retr_count;
+};
+
+/**
+ * the last record of a connection a standby has received
+ */
+struct rasta_replica_entry {
+    uint32_t remote_id;
+
+    /**
+     * the position in rasta_replication#entries
+     */
+    unsigned int position;
+    size_t length;
+    unsigned char * data;
+};
+
+struct rasta_replication {
+    rasta_replication_role role;
+
+    /**
+     * the standby, or the address the standby listens on
+     */
+    struct sockaddr_in address;
+
+    /**
+     * the listening socket of a standby, -1 on a primary
+     */
+    int listen_fd;
+
+    /**
+     * the stream, -1 while there is none
+     */
+    int fd;
+
+    /**
+     * 1 while the non blocking connect of a primary has not finished
+     */
+    int connecting;
+
+    /**
+     * the interval of the rounds of the primary in ms
+     */
+    unsigned int interval_ms;
+
+    /**
+     * the records that were not sent yet
+     */
+    unsigned char * out;
+    size_t out_length;
+    size_t out_capacity;
+
+    /**
+     * the received bytes that do not form a full record yet
+     */
+    unsigned char * in;
+    size_t in_length;
+    size_t in_capacity;
+
+    /**
+     * the replicas of a standby by remote id
+     */
+    struct rasta_replica_entry ** entries;
+    unsigned int entry_count;
+    unsigned int entry_capacity;
+    struct rasta_id_index entry_index;
+
+    /**
+     * the timestamp of the primary minus the time of the standby when the last ROUND was received
+     */
+    uint32_t timestamp_offset;
+
+    /**
+     * the amount of ROUND records a standby has received, and the interval of the rounds the last one announced
+     */
+    unsigned int rounds;
+    unsigned int primary_interval_ms;
+
+    /**
+     * the events of the handle that uses the stream
+     */
+    timed_event round_event;
+    fd_event listen_event;
+    fd_event stream_event;
+};
+
+/**
+ * a primary that connects to a standby. Nothing is sent before rasta_replication_connect()
+ * @param replication the stream
+ * @param ip the IPv4 address of the standby
+ * @param port the port of the standby
+ * @param interval_ms the interval of the rounds
+ */
+void rasta_replication_init_primary(struct rasta_replication * replication, const char * ip, uint16_t port,
+                                    unsigned int interval_ms);
+
+/**
+ * a standby that waits for its primary
+ * @param replication the stream
+ * @param ip the IPv4 address that is listened on, "*" for all
+ * @param port the port that is listened on
+ */
+void rasta_replication_init_standby(struct rasta_replication * replication, const char * ip, uint16_t port);
+
+/**
+ * closes the sockets and frees the replicas
+ * @param replication the stream
+ */
+void rasta_replication_free(struct rasta_replication * replication);
+
+/**
+ * [PRIMARY] starts connecting to the standby if there is no stream, does not block
+ * @param replication the stream
+ * @return 1 if the stream is connected, 2 if it got connected by this call and the whole state has to be sent,
+ * 0 otherwise
+ */
+int rasta_replication_connect(struct rasta_replication * replication);
+
+/**
+ * [PRIMARY] appends a record to the queued records
+ * @param replication the stream
+ * @param type the type of the record
+ * @param body the body
+ * @param length the length of the body
+ * @return 1 on success, 0 if RASTA_REPLICATION_MAX_QUEUED are queued already
+ */
+int rasta_replication_queue(struct rasta_replication * replication, rasta_replication_record_type type,
+                            const unsigned char * body, size_t length);
+
+/**
+ * [PRIMARY] appends the CONNECTION record of a connection to the queued records
+ * @param replication the stream
+ * @param replica the state of the connection, retr is ignored
+ * @param retr_buffer the retransmission buffer of the connection
+ * @return 1 on success, 0 if RASTA_REPLICATION_MAX_QUEUED are queued already
+ */
+int rasta_replication_queue_connection(struct rasta_replication * replication, const struct rasta_replica * replica,
+                                       struct retr_buffer * retr_buffer);
+
+/**
+ * [PRIMARY] appends a ROUND record
+ * @param replication the stream
+ * @param timestamp the time of the primary in the milliseconds of the RaSTA timestamps
+ * @return 1 on success, 0 if RASTA_REPLICATION_MAX_QUEUED are queued already
+ */
+int rasta_replication_queue_round(struct rasta_replication * replication, uint32_t timestamp);
+
+/**
+ * [PRIMARY] sends as much of the queued records as the socket takes, does not block
+ * @param replication the stream
+ * @return 1 if the stream is still there, 0 if it got closed
+ */
+int rasta_replication_flush(struct rasta_replication * replication);
+
+/**
+ * the size of the CONNECTION record body of a replica
+ * @param replica the state of the connection
+ * @param retr_buffer the retransmission buffer of the connection
+ * @return the amount of bytes rasta_replica_encode() writes
+ */
+size_t rasta_replica_encoded_size(const struct rasta_replica * replica, struct retr_buffer * retr_buffer);
+
+/**
+ * encodes the body of a CONNECTION record
+ * @param replica the state of the connection, retr is ignored
+ * @param retr_buffer the retransmission buffer of the connection
+ * @param out the body
+ * @param capacity the size of @p out
+ * @return the length of the body or 0 if it does not fit into @p out
+ */
+size_t rasta_replica_encode(const struct rasta_replica * replica, struct retr_buffer * retr_buffer,
+                            unsigned char * out, size_t capacity);
+
+/**
+ * decodes the body of a CONNECTION record, retr points into @p data afterwards
+ * @param replica the decoded state
+ * @param data the body
+ * @param length the length of the body
+ * @return 1 on success, 0 if the body is malformed
+ */
+int rasta_replica_decode(struct rasta_replica * replica, const unsigned char * data, size_t length);
+
+/**
+ * iterates the PDUs of the retransmission buffer of a decoded replica
+ * @param replica the replica
+ * @param offset 0 for the first PDU, advanced by every call
+ * @param sequence_number the sequence number of the PDU
+ * @param length the length of the PDU
+ * @return the PDU or NULL if there are no more
+ */
+const unsigned char * rasta_replica_next_pdu(const struct rasta_replica * replica, size_t * offset,
+                                             uint32_t * sequence_number, unsigned int * length);
+
+/**
+ * [STANDBY] accepts a new primary, the stream of the previous one is closed. Does not block
+ * @param replication the stream
+ * @return the new stream or -1 if no primary is waiting
+ */
+int rasta_replication_accept(struct rasta_replication * replication);
+
+/**
+ * [STANDBY] reads the records that are available, does not block
+ * @param replication the stream
+ * @param now the time of the standby in the milliseconds of the RaSTA timestamps
+ * @return 1 if the stream still works, 0 if the primary closed it or sent malformed records
+ */
+int rasta_replication_receive(struct rasta_replication * replication, uint32_t now);
+
+/**
+ * closes the stream and drops the bytes that were not sent or handled, the replicas are kept
+ * @param replication the stream
+ */
+void rasta_replication_close_stream(struct rasta_replication * replication);
+
+/**
+ * [STANDBY] the replica of a connection
+ * @param replication the stream
+ * @param remote_id the connection
+ * @return the record or NULL if there is none
+ */
+struct rasta_replica_entry * rasta_replication_get(struct rasta_replication * replication, uint32_t remote_id);
+
+/**
+ * [STANDBY] removes all replicas
+ * @param replication the stream
+ */
+void rasta_replication_clear(struct rasta_replication * replication);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAREPLICATION_H
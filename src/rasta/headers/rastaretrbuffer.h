@@ -0,0 +1,139 @@
+/**
+ * implementation of the retransmission buffer which is used in the SR layer
+ * The sent data PDUs are kept in a ring of fixed slots until they are confirmed. Every slot holds the encoded PDU
+ * next to its sequence number, so neither confirming nor retransmitting has to decode a PDU.
+ */
+
+#ifndef LST_SIMULATOR_RASTARETRBUFFER_H
+#define LST_SIMULATOR_RASTARETRBUFFER_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include "rastamodule.h"
+#include "rastaredundancy_new.h"
+
+/**
+ * a sent SR layer PDU, the element type of the retransmission buffer
+ */
+struct rasta_retr_element{
+    /**
+     * the sequence number of the PDU, the same as in the encoded header
+     */
+    uint32_t sequence_number;
+
+    /**
+     * the amount of bytes in pdu
+     */
+    unsigned int length;
+
+    /**
+     * the encoded PDU including its safety code. Every SR layer PDU fits into a redundancy layer PDU
+     */
+    unsigned char pdu[MAX_DEFER_QUEUE_MSG_SIZE];
+};
+
+/**
+ * representation of the retransmission buffer
+ */
+struct retr_buffer{
+    /**
+     * the slots of the ring, has max_count entries
+     */
+    struct rasta_retr_element * elements;
+
+    /**
+     * position of the oldest element
+     */
+    unsigned int first;
+
+    /**
+     * the amount of elements that are currently in the buffer
+     */
+    unsigned int count;
+
+    /**
+     * maximum number of elements in the buffer
+     */
+    unsigned int max_count;
+};
+
+/**
+ * initializes a new retransmission buffer
+ * @param n_max the maximum amount of PDUs
+ * @return an empty retransmission buffer
+ */
+struct retr_buffer retrbuffer_init(unsigned int n_max);
+
+/**
+ * initializes a new retransmission buffer on slots of the caller, retrbuffer_destroy() must not be called on it
+ * @param elements the slots, at least @p n_max
+ * @param n_max the maximum amount of PDUs
+ * @return an empty retransmission buffer
+ */
+struct retr_buffer retrbuffer_init_in(struct rasta_retr_element * elements, unsigned int n_max);
+
+/**
+ * encodes a PDU and appends it to the buffer. If the buffer is full, nothing is done
+ * @param buffer the buffer that is used
+ * @param packet the PDU
+ * @param hashing_context the hashing parameters that are used for the safety code
+ * @return the stored element or NULL if the buffer is full or the PDU can not be encoded
+ */
+struct rasta_retr_element * retrbuffer_add(struct retr_buffer * buffer, const struct RastaPacket * packet,
+                                           rasta_hashing_context_t * hashing_context);
+
+/**
+ * appends a PDU that is encoded already, e.g. one that was replicated from another entity. If the buffer is full,
+ * nothing is done
+ * @param buffer the buffer that is used
+ * @param sequence_number the sequence number in the header of the PDU
+ * @param pdu the encoded PDU including its safety code
+ * @param length the length of the PDU
+ * @return the stored element or NULL if the buffer is full or the PDU is too long
+ */
+struct rasta_retr_element * retrbuffer_add_encoded(struct retr_buffer * buffer, uint32_t sequence_number,
+                                                   const unsigned char * pdu, unsigned int length);
+
+/**
+ * removes all PDUs whose sequence number is confirmed, i.e. confirmed_sequence_number - sequence number >= 0
+ * @param buffer the buffer that is used
+ * @param confirmed_sequence_number the confirmed sequence number
+ * @return the amount of removed PDUs
+ */
+unsigned int retrbuffer_confirm(struct retr_buffer * buffer, uint32_t confirmed_sequence_number);
+
+/**
+ * getter for the stored PDUs in the order they were added
+ * @param buffer the buffer that is used
+ * @param index the position of the PDU, 0 is the oldest one
+ * @return the element or NULL if there are not enough PDUs in the buffer
+ */
+struct rasta_retr_element * retrbuffer_get(struct retr_buffer * buffer, unsigned int index);
+
+/**
+ * the amount of PDUs in the buffer
+ * @param buffer the buffer that is used
+ * @return the amount of PDUs
+ */
+unsigned int retrbuffer_size(struct retr_buffer * buffer);
+
+/**
+ * removes all PDUs from the buffer
+ * @param buffer the buffer that is used
+ */
+void retrbuffer_clear(struct retr_buffer * buffer);
+
+/**
+ * frees the memory of the buffer
+ * @param buffer the buffer that is destroyed
+ */
+void retrbuffer_destroy(struct retr_buffer * buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTARETRBUFFER_H
@@ -18,6 +18,94 @@
 void generateSiphash24(const unsigned char* data, int data_length, const unsigned char * key,  int hash_type, unsigned char* result);
 
 
+/**
+ * state of a SipHash 2-4 calculation over data that is added piece by piece
+ */
+typedef struct {
+    /**
+     * the internal state, HalfSipHash only uses the lower 32 bits
+     */
+    uint64_t v[4];
+    /**
+     * bytes that do not fill a whole message word yet
+     */
+    uint8_t buffer[8];
+    /**
+     * amount of bytes in buffer
+     */
+    size_t buffered;
+    /**
+     * amount of bytes that have been added
+     */
+    size_t length;
+    /**
+     * type of security code (0 means no code, 1 means first 8 bytes, 2 means first 16 bytes)
+     */
+    int hash_type;
+} rasta_siphash24_ctx;
+
+/**
+ * starts a SipHash 2-4 calculation, the result will be the same as the one of generateSiphash24()
+ * @param ctx the state that is initialized
+ * @param key the key for the SipHash function
+ * @param hash_type type of security code (0 means no code, 1 means first 8 bytes, 2 means first 16 bytes)
+ */
+void rasta_siphash24_init(rasta_siphash24_ctx * ctx, const unsigned char * key, int hash_type);
+
+/**
+ * starts a SipHash 2-4 calculation from a state that rasta_siphash24_init() derived from the key, so the key is not
+ * read again
+ * @param ctx the state that is initialized
+ * @param keyed the internal state of a state that was initialized with the key and @p hash_type
+ * @param hash_type type of security code (0 means no code, 1 means first 8 bytes, 2 means first 16 bytes)
+ */
+void rasta_siphash24_init_keyed(rasta_siphash24_ctx * ctx, const uint64_t keyed[4], int hash_type);
+
+/**
+ * adds data to a SipHash 2-4 calculation
+ * @param ctx the state
+ * @param data array of the data
+ * @param length length of data
+ */
+void rasta_siphash24_update(rasta_siphash24_ctx * ctx, const unsigned char * data, size_t length);
+
+/**
+ * finishes a SipHash 2-4 calculation and saves the hash in result
+ * @param ctx the state
+ * @param result array for the result
+ */
+void rasta_siphash24_final(rasta_siphash24_ctx * ctx, unsigned char * result);
+
+/**
+ * amount of messages that rasta_siphash24_multi() hashes at once
+ */
+#define SIPHASH_LANES 4
+
+/**
+ * generates the SipHash 2-4 hashes of multiple messages with the same key, the results are the same as the ones of
+ * generateSiphash24(). SIPHASH_LANES messages are processed at once
+ * @param key the key for the SipHash function
+ * @param hash_type type of security code (0 means no code, 1 means first 8 bytes, 2 means first 16 bytes)
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages
+ * @param results the hashes of the messages
+ */
+void rasta_siphash24_multi(const unsigned char * key, int hash_type, const unsigned char * const * data,
+                           const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]);
+
+/**
+ * rasta_siphash24_multi() for a key whose schedule is already done
+ * @param keyed the internal state of a state that was initialized with the key and @p hash_type
+ * @param hash_type type of security code (0 means no code, 1 means first 8 bytes, 2 means first 16 bytes)
+ * @param data the messages
+ * @param lengths the lengths of the messages
+ * @param count the amount of messages
+ * @param results the hashes of the messages
+ */
+void rasta_siphash24_multi_keyed(const uint64_t keyed[4], int hash_type, const unsigned char * const * data,
+                                 const unsigned int * lengths, unsigned int count, unsigned char (*results)[16]);
+
 int siphash(const uint8_t *in, size_t inlen, const uint8_t *k,
             uint8_t *out, size_t outlen);
 
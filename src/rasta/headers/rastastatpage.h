@@ -0,0 +1,218 @@
+#ifndef LST_SIMULATOR_RASTASTATPAGE_H
+#define LST_SIMULATOR_RASTASTATPAGE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "rasta_new.h"
+
+/**
+ * A page of shared memory that the event loop publishes its metrics to, so monitoring reads them without a syscall
+ * and without any work of the entity. The page is a memory-mapped file, usually in /dev/shm. The event loop copies
+ * the counters into it in every interval, the readers take a consistent copy with the seqlock in the header and only
+ * retry if they overlapped with a publication. The rasta_stat tool prints the page, rasta_stat_exporter serves it in
+ * the Prometheus text format
+ */
+
+/**
+ * identifies the format of a stat page
+ */
+#define RASTA_STAT_PAGE_MAGIC 0x52535450
+#define RASTA_STAT_PAGE_VERSION 1
+
+/**
+ * the amount of connections in a page of a handle whose connections are allocated on demand
+ */
+#define RASTA_STAT_PAGE_DEFAULT_CONNECTIONS 256
+
+/**
+ * a connection in the page
+ */
+struct rasta_stat_connection {
+    /**
+     * the rasta_sr_state of the connection
+     */
+    uint32_t state;
+    uint32_t reserved;
+    struct rasta_connection_metrics_snapshot snapshot;
+};
+
+/**
+ * a transport channel of the sockets in the page
+ */
+struct rasta_stat_channel {
+    /**
+     * the traffic of all connections on the transport channel
+     */
+    struct rasta_transport_metrics path;
+    struct RastaUDPTransmitStats transmit;
+};
+
+/**
+ * the start of a stat page, connection_capacity connections and channel_capacity channels follow it
+ */
+struct rasta_stat_header {
+    /**
+     * written last when the page is created
+     */
+    uint32_t magic;
+    uint32_t version;
+
+    /**
+     * the sizes of the parts of the page, a reader of another build only accepts the page if they match
+     */
+    uint32_t header_size;
+    uint32_t connection_size;
+    uint32_t channel_size;
+    uint32_t connection_capacity;
+    uint32_t channel_capacity;
+
+    /**
+     * the process and the RaSTA ID of the entity
+     */
+    uint32_t pid;
+    uint64_t local_id;
+
+    /**
+     * odd while the event loop publishes, incremented before and after every publication
+     */
+    uint64_t sequence;
+
+    /**
+     * the wall clock time of the last publication in nanoseconds since 1.1.1970, and the amount of publications
+     */
+    uint64_t published_ns;
+    uint64_t publications;
+
+    /**
+     * the interval of the publications in milliseconds
+     */
+    uint32_t interval_ms;
+
+    /**
+     * 1 while the entity publishes, 0 after it closed the page
+     */
+    uint32_t running;
+
+    /**
+     * the connections in the page and the ones that did not fit
+     */
+    uint32_t connection_count;
+    uint32_t connections_omitted;
+    uint32_t channel_count;
+    uint32_t reserved;
+
+    /**
+     * the metrics of the event loop, see sr_write_metrics()
+     */
+    struct rasta_histogram loop_lag_us;
+    struct RastaPendingChannelStats pending;
+    uint64_t callbacks_queued;
+    uint64_t callbacks_coalesced;
+    uint64_t callback_overflows;
+    struct rasta_receive_stage_metrics receive_stages;
+};
+
+/**
+ * a mapping of a stat page
+ */
+struct rasta_stat_page {
+    struct rasta_stat_header * header;
+    size_t mapped_size;
+};
+
+/**
+ * creates a stat page and maps it for writing, exits the program if it can not be created. The page replaces a file
+ * of the same path at once, readers of the old file keep their mapping of it
+ * @param path the path of the page, e.g. /dev/shm/rasta_stat
+ * @param local_id the RaSTA ID of the entity
+ * @param connection_capacity the maximum amount of connections in the page
+ * @param channel_capacity the maximum amount of transport channels in the page
+ * @param interval_ms the interval of the publications in milliseconds
+ * @return the page
+ */
+struct rasta_stat_page * rasta_stat_page_create(const char * path, unsigned long local_id,
+                                                unsigned int connection_capacity, unsigned int channel_capacity,
+                                                unsigned int interval_ms);
+
+/**
+ * marks the page as closed and unmaps it. The file is kept, so the last publication can still be read
+ * @param page the page
+ */
+void rasta_stat_page_close(struct rasta_stat_page * page);
+
+/**
+ * starts a publication, the page may be written until rasta_stat_page_end(). May only be called by a single writer
+ * @param page the page
+ */
+void rasta_stat_page_begin(struct rasta_stat_page * page);
+
+/**
+ * ends a publication, the readers take the page afterwards
+ * @param page the page
+ * @param published_ns the wall clock time of the publication in nanoseconds since 1.1.1970
+ */
+void rasta_stat_page_end(struct rasta_stat_page * page, uint64_t published_ns);
+
+/**
+ * maps a stat page for reading
+ * @param path the path of the page
+ * @return the page, NULL if it does not exist or is not a stat page of this build. The reason is printed to stderr
+ */
+struct rasta_stat_page * rasta_stat_page_open(const char * path);
+
+/**
+ * unmaps a page that was opened with rasta_stat_page_open()
+ * @param page the page
+ */
+void rasta_stat_page_unmap(struct rasta_stat_page * page);
+
+/**
+ * takes a consistent copy of a page, without a syscall unless a publication is running
+ * @param page the page
+ * @param out the copy is written in here, page#mapped_size bytes
+ * @return 1 on success, 0 if the publications kept overlapping with the copy
+ */
+int rasta_stat_page_copy(const struct rasta_stat_page * page, void * out);
+
+/**
+ * @param header a page or a copy of it
+ * @return the connections of the page
+ */
+static inline struct rasta_stat_connection * rasta_stat_page_connections(struct rasta_stat_header * header) {
+    return (struct rasta_stat_connection *) ((unsigned char *) header + header->header_size);
+}
+
+/**
+ * @param header a page or a copy of it
+ * @return the transport channels of the page
+ */
+static inline struct rasta_stat_channel * rasta_stat_page_channels(struct rasta_stat_header * header) {
+    return (struct rasta_stat_channel *) ((unsigned char *) header + header->header_size +
+                                          (size_t) header->connection_capacity * header->connection_size);
+}
+
+/**
+ * writes a copy of a page like sr_write_metrics()
+ * @param header the copy
+ * @param out the stream to write to
+ */
+void rasta_stat_page_write_prometheus(struct rasta_stat_header * header, FILE * out);
+
+/**
+ * writes a copy of a page as a table for humans
+ * @param header the copy
+ * @param out the stream to write to
+ */
+void rasta_stat_page_write_text(struct rasta_stat_header * header, FILE * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTASTATPAGE_H
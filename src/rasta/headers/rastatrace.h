@@ -0,0 +1,190 @@
+#ifndef LST_SIMULATOR_RASTATRACE_H
+#define LST_SIMULATOR_RASTATRACE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A binary trace of the events on the hot paths of the protocol. Every event is a fixed-size record in a ring that
+ * is memory-mapped from a file, so recording only takes a timestamp and a few stores and the records survive a
+ * crash of the process. The file is decoded offline by the rasta_trace_decode tool, which renders the records like
+ * the text log.
+ * Any amount of threads and processes may record into the same file at once
+ */
+
+/**
+ * identifies the format of a trace file
+ */
+#define RASTA_TRACE_MAGIC 0x52545243
+#define RASTA_TRACE_VERSION 1
+
+/**
+ * the traced events
+ */
+typedef enum {
+    /**
+     * the redundancy layer received a PDU with a correct checksum, sequence_a = seq_pdu, sequence_b = seq_rx
+     */
+    RASTA_TRACE_RED_RECEIVE = 1,
+    /**
+     * the redundancy layer discarded a PDU with an incorrect checksum
+     */
+    RASTA_TRACE_RED_CHECKSUM_INCORRECT = 2,
+    /**
+     * the redundancy layer passed a PDU to the SR layer, sequence_a = seq_pdu
+     */
+    RASTA_TRACE_RED_DELIVER = 3,
+    /**
+     * the redundancy layer discarded a PDU, value is a rasta_trace_discard_reason
+     */
+    RASTA_TRACE_RED_DISCARD = 4,
+    /**
+     * the redundancy layer added a PDU to the defer queue, sequence_a = seq_pdu, sequence_b = seq_rx
+     */
+    RASTA_TRACE_RED_DEFER = 5,
+    /**
+     * the defer timeout skipped the missing PDUs, sequence_a = the new seq_rx
+     */
+    RASTA_TRACE_RED_DEFER_TIMEOUT = 6,
+    /**
+     * the redundancy layer sent a PDU, sequence_a = seq_tx, value = the amount of transport channels it was sent on
+     */
+    RASTA_TRACE_RED_SEND = 7,
+    /**
+     * the SR layer received a PDU, sequence_a = sn, sequence_b = cs, value = the PDU type
+     */
+    RASTA_TRACE_SR_RECEIVE = 8,
+    /**
+     * the SR layer discarded a PDU, sequence_a = sn, sequence_b = cs, value is a rasta_trace_discard_reason
+     */
+    RASTA_TRACE_SR_DISCARD = 9,
+    /**
+     * the SR layer retransmits its unconfirmed PDUs, sequence_a = sn of the first PDU, value = the amount of PDUs
+     */
+    RASTA_TRACE_SR_RETRANSMIT = 10
+} rasta_trace_event;
+
+/**
+ * why a PDU was discarded
+ */
+typedef enum {
+    RASTA_TRACE_DISCARD_FIRST_NOT_ZERO = 1,
+    RASTA_TRACE_DISCARD_DUPLICATE = 2,
+    RASTA_TRACE_DISCARD_DEFERQ_FULL = 3,
+    RASTA_TRACE_DISCARD_OUT_OF_RANGE = 4,
+    RASTA_TRACE_DISCARD_CHECKSUM = 5,
+    RASTA_TRACE_DISCARD_ADDRESS = 6,
+    RASTA_TRACE_DISCARD_SN = 7,
+    RASTA_TRACE_DISCARD_CS = 8
+} rasta_trace_discard_reason;
+
+/**
+ * a recorded event
+ */
+struct rasta_trace_record {
+    /**
+     * wall clock time of the event in nanoseconds since 1.1.1970
+     */
+    uint64_t timestamp;
+
+    /**
+     * the lower 32 bit of the position of the record in the trace plus 1. Written last, records whose index does not
+     * match their position were not completely written
+     */
+    uint32_t index;
+
+    uint16_t event;
+
+    /**
+     * the index of the transport channel or 0
+     */
+    uint16_t channel;
+
+    /**
+     * the RaSTA ID of the remote entity
+     */
+    uint32_t connection_id;
+
+    uint32_t sequence_a;
+    uint32_t sequence_b;
+    uint32_t value;
+};
+
+/**
+ * the start of a trace file, the records follow it
+ */
+struct rasta_trace_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+
+    /**
+     * the amount of records that were ever recorded, the next record is written at next % capacity
+     */
+    uint64_t next;
+
+    uint8_t padding[40];
+};
+
+/**
+ * a mapped trace file
+ */
+struct rasta_trace {
+    struct rasta_trace_header * header;
+    struct rasta_trace_record * records;
+    size_t mapped_size;
+};
+
+/**
+ * maps a trace file to record into. A trace file with the same capacity is continued, otherwise it is cleared.
+ * Exits the program if the file can not be mapped
+ * @param path the path to the trace file
+ * @param capacity the amount of records in the ring, when it is full the oldest records are overwritten
+ * @return the mapped trace
+ */
+struct rasta_trace * rasta_trace_open(const char * path, unsigned int capacity);
+
+/**
+ * records an event. May be called from any thread
+ * @param trace the trace
+ * @param event the event
+ * @param connection_id the RaSTA ID of the remote entity
+ * @param sequence_a the first sequence number, see rasta_trace_event
+ * @param sequence_b the second sequence number, see rasta_trace_event
+ * @param channel the index of the transport channel
+ * @param value an additional value, see rasta_trace_event
+ */
+void (rasta_trace_add)(struct rasta_trace * trace, rasta_trace_event event, unsigned long connection_id,
+                          unsigned long sequence_a, unsigned long sequence_b, unsigned int channel, unsigned int value);
+
+/**
+ * unmaps a trace file, the records stay in the file
+ * @param trace the trace to close
+ */
+void rasta_trace_close(struct rasta_trace * trace);
+
+/**
+ * renders a record like a message of the text log
+ * @param record the record
+ * @param out the text is written in here, ending with a newline
+ * @param size the size of @p out, longer texts are truncated
+ */
+void rasta_trace_render(const struct rasta_trace_record * record, char * out, size_t size);
+
+/**
+ * rasta_trace_add() is a macro that only evaluates its arguments if @p trace is not NULL
+ */
+#define rasta_trace_add(trace, ...) \
+    ((trace) != NULL ? (rasta_trace_add)((trace), __VA_ARGS__) : (void) 0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTATRACE_H
@@ -27,8 +27,8 @@ void freeRastaByteArray(struct RastaByteArray* data);
 void allocateRastaByteArray(struct RastaByteArray* data, unsigned int length);
 
 /**
- * this will generate a 4 byte timestamp of the current system time
- * @return current system time in s since 1970
+ * this will generate a 4 byte timestamp of the current time
+ * @return the time of the event loop in ms, see event_system_now_ms()
  */
 uint32_t current_ts();
 
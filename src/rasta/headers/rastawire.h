@@ -0,0 +1,178 @@
+#ifndef LST_SIMULATOR_RASTAWIRE_H
+#define LST_SIMULATOR_RASTAWIRE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+/**
+ * The layout of the SR layer and the redundancy layer PDUs on the wire. All fields are little-endian and are not
+ * aligned, the accessors copy them byte-wise, so the compiler turns them into single loads and stores where the
+ * target allows it.
+ *
+ * SR layer PDU:
+ *   0  length                      2 bytes, of the whole PDU including the safety code
+ *   2  type                        2 bytes, one of rasta_conn_type
+ *   4  receiver id                 4 bytes
+ *   8  sender id                   4 bytes
+ *  12  sequence number             4 bytes
+ *  16  confirmed sequence number   4 bytes
+ *  20  timestamp                   4 bytes
+ *  24  confirmed timestamp         4 bytes
+ *  28  data                        length - 28 - safety code length bytes
+ *      safety code                 0, 8 or 16 bytes
+ *
+ * redundancy layer PDU:
+ *   0  length                      2 bytes, of the whole PDU including the CRC checksum
+ *   2  reserve                     2 bytes, 0 in version 03.03
+ *   4  sequence number             4 bytes
+ *   8  SR layer PDU
+ *      CRC checksum                0, 2 or 4 bytes
+ */
+
+#define RASTA_SR_OFFSET_LENGTH 0
+#define RASTA_SR_OFFSET_TYPE 2
+#define RASTA_SR_OFFSET_RECEIVER_ID 4
+#define RASTA_SR_OFFSET_SENDER_ID 8
+#define RASTA_SR_OFFSET_SEQUENCE_NUMBER 12
+#define RASTA_SR_OFFSET_CONFIRMED_SEQUENCE_NUMBER 16
+#define RASTA_SR_OFFSET_TIMESTAMP 20
+#define RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP 24
+#define RASTA_SR_OFFSET_DATA 28
+#define RASTA_SR_HEADER_LENGTH 28
+
+/**
+ * the data of a connection request and a connection response: the protocol version, send max and 8 reserved bytes
+ */
+#define RASTA_CONN_DATA_OFFSET_VERSION 0
+#define RASTA_CONN_DATA_VERSION_LENGTH 4
+#define RASTA_CONN_DATA_OFFSET_SEND_MAX 4
+#define RASTA_CONN_DATA_OFFSET_RESERVE 6
+#define RASTA_CONN_DATA_LENGTH 14
+
+/**
+ * the data of a disconnection request
+ */
+#define RASTA_DISC_DATA_OFFSET_DETAILS 0
+#define RASTA_DISC_DATA_OFFSET_REASON 2
+#define RASTA_DISC_DATA_LENGTH 4
+
+/**
+ * every application message in the data of a data message is prefixed with its length in 2 bytes
+ */
+#define RASTA_MESSAGE_LENGTH_PREFIX 2
+
+#define RASTA_RED_OFFSET_LENGTH 0
+#define RASTA_RED_OFFSET_RESERVE 2
+#define RASTA_RED_OFFSET_SEQUENCE_NUMBER 4
+#define RASTA_RED_OFFSET_PDU 8
+#define RASTA_RED_HEADER_LENGTH 8
+
+/**
+ * reads 2 little-endian bytes
+ * @param bytes the bytes, they do not have to be aligned
+ * @return the value in host byte order
+ */
+static inline uint16_t rasta_wire_get_u16(const unsigned char * bytes) {
+    uint16_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return le16toh(value);
+}
+
+/**
+ * reads 4 little-endian bytes
+ * @param bytes the bytes, they do not have to be aligned
+ * @return the value in host byte order
+ */
+static inline uint32_t rasta_wire_get_u32(const unsigned char * bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return le32toh(value);
+}
+
+/**
+ * writes a value as 2 little-endian bytes
+ * @param bytes the destination, it does not have to be aligned
+ * @param value the value in host byte order
+ */
+static inline void rasta_wire_put_u16(unsigned char * bytes, uint16_t value) {
+    value = htole16(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+/**
+ * writes a value as 4 little-endian bytes
+ * @param bytes the destination, it does not have to be aligned
+ * @param value the value in host byte order
+ */
+static inline void rasta_wire_put_u32(unsigned char * bytes, uint32_t value) {
+    value = htole32(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+/**
+ * @param data_length the length of the data of an SR layer PDU
+ * @param checksum_len the length of the safety code in bytes
+ * @return the length of the whole SR layer PDU
+ */
+static inline unsigned int rasta_sr_pdu_length(unsigned int data_length, unsigned int checksum_len) {
+    return RASTA_SR_HEADER_LENGTH + data_length + checksum_len;
+}
+
+/**
+ * @param pdu_length the length of an SR layer PDU, at least RASTA_SR_HEADER_LENGTH + @p checksum_len
+ * @param checksum_len the length of the safety code in bytes
+ * @return the length of its data
+ */
+static inline unsigned int rasta_sr_data_length(unsigned int pdu_length, unsigned int checksum_len) {
+    return pdu_length - RASTA_SR_HEADER_LENGTH - checksum_len;
+}
+
+/**
+ * @param sr_length the length of the carried SR layer PDU
+ * @param crc_len the length of the CRC checksum in bytes
+ * @return the length of the whole redundancy layer PDU
+ */
+static inline unsigned int rasta_red_pdu_length(unsigned int sr_length, unsigned int crc_len) {
+    return RASTA_RED_HEADER_LENGTH + sr_length + crc_len;
+}
+
+/**
+ * writes the header of an SR layer PDU
+ * @param pdu the PDU, at least RASTA_SR_HEADER_LENGTH bytes
+ */
+static inline void rasta_sr_header_write(unsigned char * pdu, uint16_t length, uint16_t type, uint32_t receiver_id,
+                                         uint32_t sender_id, uint32_t sequence_number,
+                                         uint32_t confirmed_sequence_number, uint32_t timestamp,
+                                         uint32_t confirmed_timestamp) {
+    rasta_wire_put_u16(&pdu[RASTA_SR_OFFSET_LENGTH], length);
+    rasta_wire_put_u16(&pdu[RASTA_SR_OFFSET_TYPE], type);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_RECEIVER_ID], receiver_id);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_SENDER_ID], sender_id);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_SEQUENCE_NUMBER], sequence_number);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_CONFIRMED_SEQUENCE_NUMBER], confirmed_sequence_number);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_TIMESTAMP], timestamp);
+    rasta_wire_put_u32(&pdu[RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP], confirmed_timestamp);
+}
+
+/**
+ * writes the header of a redundancy layer PDU
+ * @param pdu the PDU, at least RASTA_RED_HEADER_LENGTH bytes
+ */
+static inline void rasta_red_header_write(unsigned char * pdu, uint16_t length, uint16_t reserve,
+                                          uint32_t sequence_number) {
+    rasta_wire_put_u16(&pdu[RASTA_RED_OFFSET_LENGTH], length);
+    rasta_wire_put_u16(&pdu[RASTA_RED_OFFSET_RESERVE], reserve);
+    rasta_wire_put_u32(&pdu[RASTA_RED_OFFSET_SEQUENCE_NUMBER], sequence_number);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_RASTAWIRE_H
@@ -10,8 +10,160 @@ extern "C" {  // only need to export C interface if
               // used by C++ source code
 #endif
 
+#include <stddef.h>
+
+/**
+ * statistics of the allocations made through rmalloc() and rrealloc()
+ */
+struct rmemory_stats {
+    /**
+     * amount of blocks that were handed out
+     */
+    unsigned long allocations;
+
+    /**
+     * amount of blocks that were given back with rfree()
+     */
+    unsigned long frees;
+
+    /**
+     * amount of times memory was taken from the system allocator (or the user arena). Does not grow once every size
+     * class has enough blocks in its pool
+     */
+    unsigned long system_allocations;
+
+    /**
+     * bytes of the memory that is mapped for a placement, see rmemory_set_thread_placement(), and the part of it that
+     * is backed by reserved huge pages
+     */
+    unsigned long mapped_bytes;
+    unsigned long huge_page_bytes;
+
+    /**
+     * bytes of the static memory of ENABLE_RASTA_STATIC_MEMORY that were taken for slabs and large blocks, 0 in other
+     * builds. The rest of RASTA_STATIC_MEMORY_BYTES is still free
+     */
+    unsigned long static_bytes;
+
+    /**
+     * the times memory was taken from the system allocator (or the user arena or the static memory) after
+     * rmemory_seal(), 0 if the pools covered every allocation since then
+     */
+    unsigned long sealed_system_allocations;
+};
+
+/**
+ * where the memory of a thread comes from
+ */
+struct rmemory_placement {
+    /**
+     * the NUMA node the memory is taken from if it has enough, negative for the policy of the thread
+     */
+    int numa_node;
+
+    /**
+     * 1 if the memory is backed by huge pages, transparent huge pages if none are reserved
+     */
+    int huge_pages;
+};
+
+/**
+ * the subsystems whose allocations are counted separately if librasta is built with ENABLE_RASTA_MEMORY_ACCOUNTING.
+ * A source file picks its subsystem by defining RMEMORY_SUBSYSTEM before its first include, the allocations of all
+ * other files, also the ones of the application, count to RMEMORY_SUBSYSTEM_OTHER
+ */
+typedef enum {
+    RMEMORY_SUBSYSTEM_OTHER = 0,
+    /**
+     * encoding and decoding of PDUs, also every RastaByteArray, see allocateRastaByteArray()
+     */
+    RMEMORY_SUBSYSTEM_CODEC = 1,
+    RMEMORY_SUBSYSTEM_FIFO = 2,
+    RMEMORY_SUBSYSTEM_REDUNDANCY = 3,
+    RMEMORY_SUBSYSTEM_SR = 4,
+    RMEMORY_SUBSYSTEM_SCI = 5,
+    RMEMORY_SUBSYSTEM_LOGGING = 6,
+    RMEMORY_SUBSYSTEM_TRANSPORT = 7,
+} rmemory_subsystem;
+
+#define RMEMORY_SUBSYSTEMS 8
+
+/**
+ * the allocations of one subsystem, the sizes are the requested ones
+ */
+struct rmemory_subsystem_stats {
+    unsigned long allocations;
+    unsigned long frees;
+
+    /**
+     * the bytes of all allocations
+     */
+    unsigned long bytes;
+
+    /**
+     * the bytes of the blocks that were not freed yet and their high-water mark
+     */
+    unsigned long live_bytes;
+    unsigned long peak_live_bytes;
+};
+
+#ifdef USE_USER_ARENA
+/**
+ * takes memory from the application, called by rmalloc() for new slabs and blocks that are too large for the pools.
+ * Has to be provided by the application if librasta is built with ENABLE_RASTA_USER_ARENA
+ * @param size the size of the memory
+ * @return pointer to memory aligned like malloc() or NULL if no memory is left
+ */
+void * rasta_arena_alloc(size_t size);
+
+/**
+ * gives back memory returned by rasta_arena_alloc(). Has to be provided by the application if librasta is built with
+ * ENABLE_RASTA_USER_ARENA
+ * @param memory pointer to the memory
+ */
+void rasta_arena_free(void * memory);
+#endif
+
+#ifdef USE_STATIC_MEMORY
+/**
+ * the capacities of a build with ENABLE_RASTA_STATIC_MEMORY, set with the CMake cache variables of the same names.
+ * config_load() rejects a configuration that needs more. The longest message is MAX_DEFER_QUEUE_MSG_SIZE in every build
+ */
+#ifndef RASTA_STATIC_MAX_CONNECTIONS
+#define RASTA_STATIC_MAX_CONNECTIONS 16
+#endif
+#ifndef RASTA_STATIC_MAX_TRANSPORT_CHANNELS
+#define RASTA_STATIC_MAX_TRANSPORT_CHANNELS 4
+#endif
+#ifndef RASTA_STATIC_DEFER_QUEUE_SIZE
+#define RASTA_STATIC_DEFER_QUEUE_SIZE 16
+#endif
+/**
+ * the largest RASTA_SEND_MAX and RASTA_MWA, i.e. the PDUs in the send queue and the retransmission buffer
+ */
+#ifndef RASTA_STATIC_SEND_WINDOW
+#define RASTA_STATIC_SEND_WINDOW 64
+#endif
+
 /**
- * Allocates memory of size
+ * the memory a connection needs at most: its send queue, its retransmission buffer and its receive queue of full PDUs,
+ * the defer queues of its transport channels and 64 KiB for the rest of its state
+ */
+#define RASTA_STATIC_CONNECTION_BYTES \
+    ((3 * RASTA_STATIC_SEND_WINDOW + RASTA_STATIC_MAX_TRANSPORT_CHANNELS * RASTA_STATIC_DEFER_QUEUE_SIZE) * 1024 + 65536)
+
+/**
+ * the size of the static memory: the connections and 8 MiB for the handle, the sockets, their receive buffers, the
+ * configuration and the logger. Can be set directly with the CMake cache variable of the same name
+ */
+#ifndef RASTA_STATIC_MEMORY_BYTES
+#define RASTA_STATIC_MEMORY_BYTES (8u * 1024 * 1024 + RASTA_STATIC_MAX_CONNECTIONS * RASTA_STATIC_CONNECTION_BYTES)
+#endif
+#endif
+
+/**
+ * Allocates memory of size. Small blocks are taken from per-size pools, if librasta is built with
+ * ENABLE_RASTA_MEMORY_POOL. The pools are kept per thread and only grow
  * @param size the size of the memory
  * @return pointer to memory
  */
@@ -25,6 +177,24 @@ void * rmalloc(unsigned int size);
  * @return
  */
 void * rrealloc(void* element, unsigned int size);
+
+/**
+ * rmalloc() that counts the allocation to a subsystem, rmalloc() maps to it with ENABLE_RASTA_MEMORY_ACCOUNTING
+ * @param size the size of the memory
+ * @param subsystem the subsystem that allocates
+ * @return pointer to memory
+ */
+void * rmalloc_tagged(unsigned int size, rmemory_subsystem subsystem);
+
+/**
+ * rrealloc() that counts a new block to a subsystem, a block that still fits stays with its subsystem
+ * @param element the memory or NULL
+ * @param size the new size
+ * @param subsystem the subsystem that allocates
+ * @return pointer to memory
+ */
+void * rrealloc_tagged(void* element, unsigned int size, rmemory_subsystem subsystem);
+
 /**
  * frees an allocated memory
  * @param element pointer to the memory
@@ -74,6 +244,58 @@ void rstrcat(char * dest, const char * src);
  */
 int rmemcmp(const  void * a, const void * b, unsigned int len);
 
+/**
+ * sets where the calling thread takes new slabs for its pools and blocks of at least 64 KiB from. These are mapped
+ * from the system and bound to the NUMA node, slabs are cut from 2 MiB chunks with huge pages. Blocks that are freed
+ * go back to their thread as before, so a block keeps the node it was placed on. Without placement the memory comes
+ * from malloc(), with ENABLE_RASTA_USER_ARENA or ENABLE_RASTA_STATIC_MEMORY it always comes from the arena or the static
+ * memory
+ * @param placement the new placement of the thread, a negative node and no huge pages end the placement
+ * @return the placement the thread had before
+ */
+struct rmemory_placement rmemory_set_thread_placement(struct rmemory_placement placement);
+
+/**
+ * @param cpu a CPU
+ * @return the NUMA node of @p cpu or -1 if it is not known
+ */
+int rmemory_cpu_node(int cpu);
+
+/**
+ * marks the end of the initialization of the application, the system allocations after it are counted in
+ * rmemory_stats#sealed_system_allocations. With the pools, a steady state takes every block from them and the counter
+ * stays 0. Can be called again, e.g. after a connection was opened for the first time
+ */
+void rmemory_seal(void);
+
+/**
+ * reads the allocation statistics of all threads
+ * @param stats the statistics are written here
+ */
+void rmemory_get_stats(struct rmemory_stats * stats);
+
+/**
+ * reads the allocation statistics of a subsystem of all threads
+ * @param subsystem the subsystem
+ * @param stats the statistics are written here
+ * @return 1 if librasta is built with ENABLE_RASTA_MEMORY_ACCOUNTING, 0 otherwise
+ */
+int rmemory_get_subsystem_stats(rmemory_subsystem subsystem, struct rmemory_subsystem_stats * stats);
+
+/**
+ * @param subsystem the subsystem
+ * @return the name of the subsystem, e.g. for metric labels
+ */
+const char * rmemory_subsystem_name(rmemory_subsystem subsystem);
+
+#if defined(ENABLE_MEMORY_ACCOUNTING) && !defined(RMEMORY_IMPLEMENTATION)
+#ifndef RMEMORY_SUBSYSTEM
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_OTHER
+#endif
+#define rmalloc(size) rmalloc_tagged((size), RMEMORY_SUBSYSTEM)
+#define rrealloc(element, size) rrealloc_tagged((element), (size), RMEMORY_SUBSYSTEM)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,25 +21,241 @@ extern "C" {  // only need to export C interface if
 
 #define IPV4_STR_LEN 16
 
+// amount of datagrams that can be received by a single udp_receive_batch() call
+#define UDP_RECEIVE_BATCH_SIZE 32
+
+// amount of datagrams that are handed to the kernel by a single syscall in udp_send_batch()
+#define UDP_SEND_BATCH_SIZE 32
+
+// room for the header, IV and MAC of a DTLS record in the slots of a RastaUDPReceiveBatch
+#define UDP_DTLS_RECORD_OVERHEAD 128
+
+// amount of datagrams the transmit queue of a socket holds while the socket is not writable
+#define UDP_TRANSMIT_QUEUE_SLOTS 256
+
+// room for a datagram in the transmit queue, larger datagrams are dropped when they can not be sent right away
+#define UDP_TRANSMIT_SLOT_SIZE 2048
+
+// most datagrams the kernel sends with one UDP_SEGMENT message
+#define UDP_GSO_MAX_SEGMENTS 64
+
+// the largest payload of a UDP_SEGMENT message and of a datagram that UDP_GRO coalesced
+#define UDP_GSO_MAX_BYTES 65507
+
+// amount of coalesced datagrams a single udp_receive_batch() call takes from a socket with UDP_GRO
+#define UDP_GRO_RECEIVE_BATCH_SIZE 8
+
 #ifdef ENABLE_TLS
 enum RastaTLSConnectionState{
     RASTA_TLS_CONNECTION_READY,
     RASTA_TLS_CONNECTION_ESTABLISHED,
     RASTA_TLS_CONNECTION_CLOSED
 };
+
+/**
+ * the DTLS session with a single peer, defined in udp.c
+ */
+struct RastaDTLSPeer;
+
+/**
+ * the records of a udp_send_batch() call on a DTLS socket, defined in udp.c
+ */
+struct RastaDTLSSendBatch;
+
+// amount of DTLS peers a server socket accepts at the same time
+#define UDP_DTLS_MAX_PEERS 64
 #endif
 
+struct udp_impairment;
+struct udp_uring;
+struct udp_shm;
+struct udp_xdp;
+struct udp_tcp;
+
+/**
+ * the datagrams of a socket that are waiting for it to become writable, defined in udp.c
+ */
+struct udp_transmit_queue;
+
+/**
+ * the counters of the transmit queue of a socket
+ */
+struct RastaUDPTransmitStats {
+    /**
+     * the datagrams in the queue
+     */
+    unsigned int depth;
+    /**
+     * the datagrams that had to wait for the socket
+     */
+    uint64_t queued;
+    /**
+     * the datagrams that were dropped because the queue was full or they did not fit into a slot
+     */
+    uint64_t drops;
+};
+
+/**
+ * the buffers of a socket as the kernel reports them, see udp_buffer_stats()
+ */
+struct RastaUDPBufferStats {
+    /**
+     * the sizes of the buffers in bytes, including the bookkeeping of the kernel
+     */
+    unsigned int receive_buffer;
+    unsigned int send_buffer;
+    /**
+     * the datagrams the kernel dropped because the receive buffer was full, see udp_enable_drop_counter()
+     */
+    uint64_t kernel_drops;
+};
+
 struct RastaUDPState{
     int file_descriptor;
     enum RastaTLSMode activeMode;
     const struct RastaConfigTLS *tls_config;
+
+    /**
+     * the datagrams are sent through this impairment if it is not NULL, see udpimpairment.h. DTLS records are not
+     * impaired
+     */
+    struct udp_impairment *impairment;
+
+    /**
+     * the io_uring backend of the socket, see udpuring.h. NULL if it is not compiled in, the kernel does not support
+     * it or DTLS is used
+     */
+    struct udp_uring *uring;
+
+    /**
+     * the shared memory paths to the entities on the same host, see udpshm.h. NULL if the transport channel only uses
+     * UDP
+     */
+    struct udp_shm *shm;
+
+    /**
+     * the AF_XDP socket of the transport channel, see udpxdp.h. NULL if it is not compiled in or could not be set
+     * up, the UDP socket is used alone then
+     */
+    struct udp_xdp *xdp;
+
+    /**
+     * the TCP or TLS streams that replace the socket, see udptcp.h. NULL if the transport channel uses UDP
+     */
+    struct udp_tcp *tcp;
+
+    /**
+     * the datagrams that wait for the socket to become writable, allocated when the first one has to wait. The socket
+     * is never blocked on, see udp_transmit_flush()
+     */
+    struct udp_transmit_queue *transmit_queue;
+
+    /**
+     * 1 if consecutive datagrams of equal length to the same receiver are sent with one UDP_SEGMENT message, 1 if
+     * the kernel coalesces received datagrams of the same sender with UDP_GRO, see udp_enable_offload()
+     */
+    int gso;
+    int gro;
+
+    /**
+     * the last SO_RXQ_OVFL counter of the kernel and the datagrams it dropped since the socket was created, only
+     * counted with udp_enable_drop_counter() and while the socket receives datagrams
+     */
+    uint32_t rxq_overflow;
+    uint64_t kernel_drops;
 #ifdef ENABLE_TLS
     WOLFSSL_CTX* ctx;
-    WOLFSSL* ssl;
-    enum RastaTLSConnectionState tls_state;
+    /**
+     * the session of a DTLS client, a server keeps one session per peer in dtls_peers instead
+     */
+    struct RastaDTLSPeer * dtls_client;
+
+    /**
+     * DTLS server: the sessions of the peers that passed the cookie exchange, unordered. New senders are handled by
+     * dtls_listener without keeping any state until they return a valid cookie
+     */
+    struct RastaDTLSPeer ** dtls_peers;
+    unsigned int dtls_peer_count;
+    struct RastaDTLSPeer * dtls_listener;
+    /**
+     * the secret the HelloVerifyRequest cookies are derived from
+     */
+    unsigned char dtls_cookie_secret[16];
+    /**
+     * collects the encrypted records of a udp_send_batch() call for sendmmsg(), NULL outside of it
+     */
+    struct RastaDTLSSendBatch * dtls_send_batch;
 #endif
 };
 
+/**
+ * preallocated receive buffers for udp_receive_batch(). The slots are reused by every call, so the received
+ * datagrams have to be processed before the next batch is received
+ */
+struct RastaUDPReceiveBatch {
+    /**
+     * capacity * slot_size bytes, slot i starts at buffers + i * slot_size
+     */
+    unsigned char * buffers;
+    /**
+     * the longest datagram that is received, or the longest plaintext of a DTLS record
+     */
+    size_t buffer_size;
+    /**
+     * buffer_size and the room for the DTLS record overhead, the records are decrypted in place
+     */
+    size_t slot_size;
+    unsigned int capacity;
+
+    /**
+     * message headers, io vectors and sender addresses for recvmmsg(), one per slot
+     */
+    struct mmsghdr * messages;
+    struct iovec * iovecs;
+    struct sockaddr_in * senders;
+
+    /**
+     * control buffers for the kernel receive timestamps, one per slot
+     */
+    unsigned char * controls;
+    /**
+     * the kernel receive timestamp of the datagram in slot i in nanoseconds of CLOCK_REALTIME, 0 if the socket has no
+     * receive timestamps enabled
+     */
+    uint64_t * timestamps;
+
+    /**
+     * amount of slots filled by the last udp_receive_batch() call
+     */
+    unsigned int count;
+
+    /**
+     * sockets with UDP_GRO: UDP_GRO_RECEIVE_BATCH_SIZE buffers of UDP_GSO_MAX_BYTES for the coalesced datagrams and
+     * their message headers, allocated by the first udp_receive_batch() call on such a socket. NULL otherwise
+     */
+    unsigned char * gro_buffers;
+    struct mmsghdr * gro_messages;
+    struct iovec * gro_iovecs;
+    struct sockaddr_in * gro_senders;
+    unsigned char * gro_controls;
+
+    /**
+     * the coalesced datagrams of the last receive, the next datagram that is split and the offset of its next
+     * segment. The segments that did not fit into the batch are returned by the next udp_receive_batch() call
+     */
+    unsigned int gro_count;
+    unsigned int gro_index;
+    size_t gro_offset;
+
+    /**
+     * 1 if the last udp_receive_batch() call split coalesced datagrams, the datagrams of the batch are the segments
+     * then and point into gro_buffers, one per slot
+     */
+    int segmented;
+    unsigned char ** segments;
+    size_t * segment_lengths;
+};
+
 /**
  * This function will initialise an udp socket and return its file descriptor, which is used to reference it in later
  * function calls
@@ -48,6 +264,117 @@ struct RastaUDPState{
  */
 void udp_init(struct RastaUDPState * state,const struct RastaConfigTLS *tls_config);
 
+/**
+ * sets SO_BUSY_POLL on the socket, a receive that would block polls the device queue for @p busy_poll_us
+ * microseconds first. A failure is only reported, the socket works without it
+ * @param state the udp socket's tls_state buffer
+ * @param busy_poll_us the time in microseconds
+ */
+void udp_set_busy_poll(struct RastaUDPState * state, unsigned int busy_poll_us);
+
+/**
+ * sets SO_TIMESTAMPNS on the socket, the kernel stamps every received datagram with the time it arrived. The stamps
+ * are returned by udp_receive_batch_get_timestamp(). A failure is only reported, the datagrams are not stamped then
+ * @param state the udp socket's tls_state buffer
+ */
+void udp_enable_receive_timestamps(struct RastaUDPState * state);
+
+/**
+ * sets SO_RXQ_OVFL on the socket, every received datagram carries the counter of the datagrams the kernel dropped
+ * because the receive buffer was full. udp_receive_batch() adds them up in state->kernel_drops. The datagrams of
+ * AF_XDP and shared memory paths are not counted. A failure is only reported, the drops are not counted then
+ * @param state the udp socket's tls_state buffer
+ */
+void udp_enable_drop_counter(struct RastaUDPState * state);
+
+/**
+ * sets the receive and send buffer sizes of the socket. SO_RCVBUFFORCE and SO_SNDBUFFORCE are tried first, without
+ * CAP_NET_ADMIN the kernel limits the sizes to net.core.rmem_max and net.core.wmem_max, which is reported on stderr.
+ * A failure is only reported
+ * @param state the udp socket's tls_state buffer
+ * @param receive_bytes the size of the receive buffer, 0 keeps the size of the kernel
+ * @param send_bytes the size of the send buffer, 0 keeps the size of the kernel
+ */
+void udp_set_buffer_sizes(struct RastaUDPState * state, unsigned int receive_bytes, unsigned int send_bytes);
+
+/**
+ * reads the buffer sizes of the socket from the kernel and the counted drops
+ * @param state the udp socket's tls_state buffer
+ * @param out the stats
+ */
+void udp_buffer_stats(struct RastaUDPState * state, struct RastaUDPBufferStats * out);
+
+/**
+ * sets SO_REUSEPORT on the socket, so it can be bound to a port together with the other sockets of its group. Has to
+ * be called before the socket is bound
+ * @param state the udp socket's tls_state buffer
+ */
+void udp_enable_reuseport(struct RastaUDPState * state);
+
+/**
+ * attaches a classic BPF program to the SO_REUSEPORT group of a bound socket. It steers every datagram to the socket
+ * at index (the 32 bit little endian value at @p offset of the datagram) modulo @p group_size, the sockets are indexed
+ * in the order they were bound. Datagrams that are too short go to the first socket. A failure is only reported, the
+ * kernel hashes the datagrams on their sender address then
+ * @param state the udp socket's tls_state buffer
+ * @param group_size the amount of sockets in the group
+ * @param offset the offset of the value in the datagram
+ */
+void udp_steer_reuseport(struct RastaUDPState * state, unsigned int group_size, unsigned int offset);
+
+/**
+ * exchanges the datagrams with the entities on the same host that use the same @p name through shared memory, see
+ * udpshm.h. Has to be called after the socket is bound to a specific address. Replaces the io_uring backend, is not
+ * used with DTLS. udp_receive() only receives from the socket
+ * @param state the udp socket's tls_state buffer
+ * @param name the name of the rendezvous, less than RASTA_SHM_NAME_LEN characters
+ */
+void udp_enable_shm(struct RastaUDPState * state, const char * name);
+
+/**
+ * sends consecutive datagrams of equal length to the same receiver with a single UDP_SEGMENT message, the kernel cuts
+ * them into datagrams as late as possible, and lets the kernel coalesce the received datagrams of a sender with
+ * UDP_GRO. Has to be called after the socket is bound and after udp_enable_shm(). Replaces the io_uring backend, is
+ * not used with DTLS. UDP_GRO is not used next to shared memory, udp_receive() does not split coalesced datagrams.
+ * A failure is only reported, the datagrams are sent and received one by one then
+ * @param state the udp socket's tls_state buffer
+ */
+void udp_enable_offload(struct RastaUDPState * state);
+
+/**
+ * receives the datagrams to the address of the socket on one receive queue of a dedicated interface through an
+ * AF_XDP socket and sends the datagrams to the senders that were seen on it through the same socket, see udpxdp.h.
+ * Has to be called after the socket is bound to a specific address and after udp_enable_offload(). Needs
+ * CAP_NET_ADMIN and CAP_BPF, replaces the io_uring backend and UDP_GRO, is not used with DTLS or shared memory.
+ * udp_receive() only receives from the socket. A failure is only reported, the socket is used alone then
+ * @param state the udp socket's tls_state buffer
+ * @param interface the name of the interface
+ * @param queue the receive queue of the interface
+ */
+void udp_enable_xdp(struct RastaUDPState * state, const char * interface, unsigned int queue);
+
+/**
+ * exchanges the datagrams of the transport channel over TCP streams instead of the socket, see udptcp.h. With @p tls
+ * the streams are encrypted by TLS 1.2 with the certificates of the TLS options, independent of their mode, and the
+ * kernel takes over the records after the handshake (kTLS) if it can. Has to be called after the socket is bound to
+ * a specific address. Replaces the io_uring backend, DTLS, shared memory and AF_XDP. udp_receive() only receives from
+ * the socket. A failure is only reported for plain TCP, the socket is used then. With @p tls it exits instead, also
+ * if TLS is not compiled in
+ * @param state the udp socket's tls_state buffer
+ * @param tls 1 if the streams use TLS
+ */
+void udp_enable_tcp(struct RastaUDPState * state, int tls);
+
+/**
+ * the file descriptor the event loop waits on until datagrams can be received with udp_receive_batch(). This is the
+ * socket, the ring of the io_uring backend or the epoll instance of the shared memory, the AF_XDP or the TCP
+ * backend. The receive of the io_uring backend belongs to the calling thread, so this has to be called by the thread
+ * that runs the event loop
+ * @param state the udp socket's tls_state buffer
+ * @return the file descriptor
+ */
+int udp_receive_fd(struct RastaUDPState * state);
+
 /**
  * Binds a given file descriptor to the given @p port
  * @param state tls_state with the file descriptor which will be bound to to the @p port.
@@ -74,6 +401,59 @@ void udp_bind_device(struct RastaUDPState * state, uint16_t port, char * ip);
  */
 size_t udp_receive(struct RastaUDPState * state, unsigned char* received_message,size_t max_buffer_len, struct sockaddr_in *sender);
 
+/**
+ * allocates the buffers of a receive batch
+ * @param batch the batch to initialize
+ * @param capacity the maximum amount of datagrams per batch
+ * @param buffer_size the maximum length of a datagram
+ */
+void udp_receive_batch_init(struct RastaUDPReceiveBatch * batch, unsigned int capacity, size_t buffer_size);
+
+/**
+ * frees the buffers of a receive batch
+ * @param batch the batch to free
+ */
+void udp_receive_batch_free(struct RastaUDPReceiveBatch * batch);
+
+/**
+ * Receives all datagrams that are queued on the socket, up to the capacity of the @p batch, with a single syscall.
+ * The first datagram is waited for, so this should only be called if the socket is readable.
+ * If TLS is used, the records are decrypted into the slots and the datagrams that only carried handshake records are
+ * left out
+ * @param state tls_state which should be used to receive data
+ * @param batch the batch the datagrams are received into, batch#count is set to the amount of received datagrams
+ * @return the amount of received datagrams
+ */
+unsigned int udp_receive_batch(struct RastaUDPState * state, struct RastaUDPReceiveBatch * batch);
+
+/**
+ * @param batch the batch
+ * @return 1 if the batch holds segments of coalesced datagrams that did not fit into the last udp_receive_batch()
+ * call, the next call returns them without receiving from the socket
+ */
+static inline int udp_receive_batch_pending(const struct RastaUDPReceiveBatch * batch) {
+    return batch->gro_index < batch->gro_count;
+}
+
+/**
+ * getter for a datagram of the last received batch
+ * @param batch the batch
+ * @param index the index of the datagram, has to be less than batch#count
+ * @param length the length of the datagram will be written in here
+ * @param sender information about the sender of the datagram will be stored here
+ * @return the datagram
+ */
+unsigned char * udp_receive_batch_get(struct RastaUDPReceiveBatch * batch, unsigned int index, size_t * length,
+                                      struct sockaddr_in * sender);
+
+/**
+ * getter for the kernel receive timestamp of a datagram of the last received batch
+ * @param batch the batch
+ * @param index the index of the datagram, has to be less than batch#count
+ * @return the time the datagram arrived in nanoseconds of CLOCK_REALTIME, 0 if the datagram was not stamped
+ */
+uint64_t udp_receive_batch_get_timestamp(struct RastaUDPReceiveBatch * batch, unsigned int index);
+
 /**
  * Sends a message via the given file descriptor to a @p host and @p port
  * @param state tls_state which is used to send the message
@@ -95,14 +475,70 @@ void udp_send(struct RastaUDPState * state, unsigned char* message, size_t messa
  */
 void udp_send_sockaddr(struct RastaUDPState * state, unsigned char* message, size_t message_len, struct sockaddr_in receiver);
 
+/**
+ * Sends multiple messages via the given file descriptor with a single syscall. Message i is sent to receivers[i]
+ * If TLS is used, the messages are encrypted one by one and the records are sent together
+ * @param state tls_state which is used to send the messages
+ * @param messages the messages which will be send
+ * @param message_lengths the length of every message
+ * @param receivers address information about the receiver of every message
+ * @param count the amount of messages
+ */
+void udp_send_batch(struct RastaUDPState * state, unsigned char ** messages, size_t * message_lengths,
+                    struct sockaddr_in * receivers, unsigned int count);
+
+/**
+ * sends the datagrams that wait in the transmit queue of a socket, as many as the socket takes without blocking.
+ * Call it when the socket is writable while udp_transmit_pending() is not 0
+ * @param state the socket
+ * @return the amount of datagrams that are still waiting
+ */
+unsigned int udp_transmit_flush(struct RastaUDPState * state);
+
+/**
+ * @param state the socket
+ * @return the amount of datagrams in the transmit queue of the socket
+ */
+unsigned int udp_transmit_pending(struct RastaUDPState * state);
+
+/**
+ * copies the counters of the transmit queue of a socket
+ * @param state the socket
+ * @param out the counters are written in here
+ */
+void udp_transmit_stats(struct RastaUDPState * state, struct RastaUDPTransmitStats * out);
+
+/**
+ * converts an IPv4 address in the format a.b.c.d and a port into the address information used by the socket API
+ * @param host the IPv4 address
+ * @param port the port
+ * @return the address information
+ */
+struct sockaddr_in host_port_to_sockaddr(const char *host, uint16_t port);
+
 /**
  * Closes the udp socket
  * @param state the tls_state which identifies the socket
  */
 void udp_close(struct RastaUDPState * state);
 
+/**
+ * formats the IPv4 address of a socket address
+ * @param sockaddr the socket address
+ * @param host the address in the format a.b.c.d is written in here, has to hold IPV4_STR_LEN characters
+ */
 void sockaddr_to_host(struct sockaddr_in sockaddr, char* host);
 
+/**
+ * packs the IPv4 address and the port of a socket address into one integer, so transport endpoints can be compared
+ * without formatting them
+ * @param sockaddr the socket address
+ * @return the address in the upper and the port in the lower 16 bit, both in network byte order
+ */
+static inline uint64_t sockaddr_to_endpoint(const struct sockaddr_in * sockaddr) {
+    return ((uint64_t) sockaddr->sin_addr.s_addr << 16) | sockaddr->sin_port;
+}
+
 #ifdef __cplusplus
 }
 #endif
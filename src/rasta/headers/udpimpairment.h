@@ -0,0 +1,146 @@
+#ifndef LST_SIMULATOR_UDPIMPAIRMENT_H
+#define LST_SIMULATOR_UDPIMPAIRMENT_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <pthread.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include "config.h"
+
+/**
+ * A shim below the UDP sockets that impairs the datagrams sent on a transport channel like a real network path:
+ * datagrams are dropped, duplicated, reordered and delayed as configured with RASTA_IMPAIRMENTS. The random decisions
+ * are drawn from a generator seeded with RASTA_IMPAIRMENT_SEED, so the same sequence of datagrams is impaired the same
+ * way in every run. Delayed datagrams are sent by a thread of the impairment when they are due
+ */
+
+/**
+ * maximum amount of delayed datagrams per transport channel, datagrams that do not fit anymore are dropped
+ */
+#define UDP_IMPAIRMENT_MAX_PENDING 1024
+
+/**
+ * maximum length of a delayed datagram
+ */
+#define UDP_IMPAIRMENT_MAX_DATAGRAM 1024
+
+/**
+ * what happened to the datagrams that passed the impairment
+ */
+struct udp_impairment_stats {
+    unsigned long datagrams;
+    unsigned long dropped;
+    unsigned long duplicated;
+    unsigned long reordered;
+    unsigned long delayed;
+
+    /**
+     * datagrams that were dropped because too many were delayed at once
+     */
+    unsigned long overflows;
+};
+
+/**
+ * a datagram that waits until it is due
+ */
+struct udp_impairment_datagram {
+    uint64_t due;
+
+    /**
+     * ties of the due time are sent in the order they were delayed
+     */
+    unsigned long order;
+
+    struct sockaddr_in receiver;
+    size_t length;
+    unsigned char data[UDP_IMPAIRMENT_MAX_DATAGRAM];
+};
+
+struct udp_impairment {
+    struct RastaConfigImpairment config;
+    int file_descriptor;
+
+    /**
+     * the state of the random generator, only used by the thread that sends on the socket
+     */
+    uint64_t random;
+
+    /**
+     * guards the delayed datagrams and the statistics, the thread waits on changed for an earlier due time
+     */
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+
+    /**
+     * UDP_IMPAIRMENT_MAX_PENDING slots for delayed datagrams, the unused ones are in free_slots
+     */
+    struct udp_impairment_datagram * slots;
+    struct udp_impairment_datagram ** free_slots;
+    unsigned int free_count;
+
+    /**
+     * the delayed datagrams as a binary min-heap ordered by their due time
+     */
+    struct udp_impairment_datagram ** pending;
+    unsigned int pending_count;
+    unsigned long order;
+
+    /**
+     * the thread that sends the delayed datagrams, only started if datagrams can be delayed
+     */
+    pthread_t thread;
+    int thread_running;
+    int stopping;
+
+    struct udp_impairment_stats stats;
+};
+
+/**
+ * @param config the impairment of a transport channel
+ * @return 1 if @p config changes any datagram, 0 otherwise
+ */
+int udp_impairment_is_active(const struct RastaConfigImpairment * config);
+
+/**
+ * creates the impairment of a socket
+ * @param file_descriptor the socket the impaired datagrams are sent on
+ * @param config the impairment
+ * @param seed the seed of the random decisions
+ * @return the impairment
+ */
+struct udp_impairment * udp_impairment_create(int file_descriptor, const struct RastaConfigImpairment * config,
+                                              unsigned long seed);
+
+/**
+ * stops the thread of the impairment and frees it, datagrams that are still delayed are dropped
+ * @param impairment the impairment
+ */
+void udp_impairment_destroy(struct udp_impairment * impairment);
+
+/**
+ * sends a datagram through the impairment, i.e. drops, duplicates or delays it. Must only be called by one thread
+ * at a time, like the other send functions of a socket
+ * @param impairment the impairment
+ * @param message the datagram
+ * @param message_len the length of the datagram
+ * @param receiver the receiver of the datagram
+ */
+void udp_impairment_send(struct udp_impairment * impairment, const unsigned char * message, size_t message_len,
+                         const struct sockaddr_in * receiver);
+
+/**
+ * reads the statistics of an impairment, may be called from any thread
+ * @param impairment the impairment
+ * @param stats the statistics are written in here
+ */
+void udp_impairment_get_stats(struct udp_impairment * impairment, struct udp_impairment_stats * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_UDPIMPAIRMENT_H
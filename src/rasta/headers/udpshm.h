@@ -0,0 +1,158 @@
+#ifndef LST_SIMULATOR_UDPSHM_H
+#define LST_SIMULATOR_UDPSHM_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/un.h>
+#include "udp.h"
+
+/**
+ * A shared memory backend below the UDP socket of a transport channel (Linux only), for RaSTA entities that run on
+ * the same host. The entities whose transport channels use the same name meet at an abstract unix socket: the first one
+ * listens on it, every later one connects and gets a memfd with two single producer single consumer rings from the
+ * listener, one per direction, and an eventfd per ring as its doorbell. Datagrams to a peer that is attached this way
+ * are copied into its ring without a syscall, all other datagrams and the datagrams that do not fit into the ring
+ * still use the socket. The event loop waits on an epoll instance that contains the socket, the doorbells and the
+ * unix sockets, so the datagrams of both paths are received by udp_receive_batch().
+ * A peer is detached when its unix socket is closed. A connecting entity whose listener is gone meets again, so the
+ * entities can be restarted in any order
+ */
+
+/**
+ * amount of slots of a ring, has to be a power of 2
+ */
+#define UDP_SHM_RING_SLOTS 256
+
+/**
+ * size of a slot: the length and the sender of the datagram and the datagram
+ */
+#define UDP_SHM_SLOT_SIZE 2048
+
+/**
+ * amount of peers a listening entity attaches at the same time, further peers keep using UDP
+ */
+#define UDP_SHM_MAX_PEERS 16
+
+struct udp_shm_region;
+struct udp_shm_ring;
+
+/**
+ * an entity that is attached through shared memory
+ */
+struct udp_shm_peer {
+    /**
+     * the address of the transport channel of the peer, the datagrams to it are put into send_ring
+     */
+    struct sockaddr_in address;
+    uint64_t endpoint;
+
+    /**
+     * the unix socket the peer was attached through, it is readable when the peer closes it
+     */
+    int control_fd;
+
+    struct udp_shm_region * region;
+    struct udp_shm_ring * send_ring;
+    struct udp_shm_ring * receive_ring;
+
+    /**
+     * the eventfds that are signaled when a sleeping consumer of send_ring and receive_ring has to wake up
+     */
+    int send_doorbell;
+    int receive_doorbell;
+
+    /**
+     * the head of send_ring including the datagrams that are not published by udp_shm_flush() yet
+     */
+    uint32_t send_head;
+};
+
+struct udp_shm {
+    /**
+     * the bound UDP socket, it stays owned by the RastaUDPState
+     */
+    int socket_fd;
+    struct sockaddr_in address;
+
+    /**
+     * the abstract address of the rendezvous
+     */
+    struct sockaddr_un rendezvous;
+    socklen_t rendezvous_length;
+
+    /**
+     * the listening unix socket if this entity listens, -1 otherwise
+     */
+    int listen_fd;
+
+    /**
+     * the unix socket of a connecting entity until the listener has sent the rings, -1 otherwise
+     */
+    int pending_fd;
+
+    /**
+     * the file descriptor the event loop waits on
+     */
+    int epoll_fd;
+
+    struct udp_shm_peer peers[UDP_SHM_MAX_PEERS];
+    unsigned int peer_count;
+};
+
+/**
+ * meets the entities that use the same name and adds the shared memory paths to a bound socket
+ * @param file_descriptor the socket, has to be bound to a specific address
+ * @param name the name of the rendezvous
+ * @return the backend
+ */
+struct udp_shm * udp_shm_create(int file_descriptor, const char * name);
+
+/**
+ * detaches all peers and closes the rendezvous, the socket stays open
+ * @param shm the backend
+ */
+void udp_shm_destroy(struct udp_shm * shm);
+
+/**
+ * @param shm the backend
+ * @return the file descriptor that is readable while datagrams or peers wait to be handled
+ */
+int udp_shm_receive_fd(struct udp_shm * shm);
+
+/**
+ * attaches and detaches the peers whose unix sockets are readable and copies the datagrams of the rings into the slots
+ * of a batch, up to its capacity. Does not block
+ * @param shm the backend
+ * @param batch the batch, batch#count is not changed
+ * @param socket_readable set to 1 if datagrams wait on the socket, 0 otherwise
+ * @return the amount of datagrams copied from the rings
+ */
+unsigned int udp_shm_receive(struct udp_shm * shm, struct RastaUDPReceiveBatch * batch, int * socket_readable);
+
+/**
+ * copies a datagram into the ring of the peer at @p receiver. It is not visible to the peer before udp_shm_flush()
+ * @param shm the backend
+ * @param message the datagram
+ * @param message_length the length of the datagram
+ * @param receiver the receiver
+ * @return 1 if the datagram was taken, 0 if it has to be sent on the socket
+ */
+int udp_shm_push(struct udp_shm * shm, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver);
+
+/**
+ * publishes the datagrams of the previous udp_shm_push() calls and wakes up the peers that sleep
+ * @param shm the backend
+ */
+void udp_shm_flush(struct udp_shm * shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_UDPSHM_H
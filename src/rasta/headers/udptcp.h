@@ -0,0 +1,223 @@
+#ifndef LST_SIMULATOR_UDPTCP_H
+#define LST_SIMULATOR_UDPTCP_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "udp.h"
+
+/**
+ * A TCP backend that replaces the UDP socket of a transport channel (Linux only). Every transport channel listens on a
+ * TCP socket at the address of its UDP socket and exchanges the datagrams with a peer over a stream, one frame per
+ * datagram: its length as 16 bit big endian and the datagram. The first frame of a stream is the hello of the entity
+ * that dialed it, it carries the port of the dialing transport channel, so both ends see the address of the UDP
+ * socket of the other one as the sender, like on UDP. A stream is dialed when the first datagram to a peer without a
+ * stream is sent, the frames wait in its buffer until it is connected.
+ * With TLS, the streams run a TLS 1.2 handshake with WolfSSL, limited to the AES-128-GCM cipher suites. After the
+ * handshake the session keys are handed to the kernel (kTLS, TCP_ULP "tls"), which encrypts and decrypts the records
+ * itself or lets the NIC do it, so the frames are sent and received with plain send() and recv(). A stream whose
+ * kernel has no tls module keeps WolfSSL in userspace.
+ * The event loop waits on an epoll instance that contains the listener, the streams and an eventfd that is signaled
+ * while received frames wait in the buffers of the streams. The UDP socket stays bound but is not used
+ */
+
+/**
+ * amount of streams a transport channel keeps open at the same time, further peers are not accepted or dialed
+ */
+#define UDP_TCP_MAX_STREAMS 64
+
+/**
+ * size of the send and the receive buffer of a stream, the datagrams that do not fit into the send buffer are dropped
+ * like on a full UDP socket
+ */
+#define UDP_TCP_BUFFER_SIZE 65536
+
+/**
+ * the length of a frame in front of its datagram
+ */
+#define UDP_TCP_FRAME_HEADER_SIZE 2
+
+enum udp_tcp_mode {
+    UDP_TCP_MODE_PLAIN,
+    UDP_TCP_MODE_TLS
+};
+
+enum udp_tcp_stream_state {
+    /**
+     * the non-blocking connect of a dialed stream has not finished yet
+     */
+    UDP_TCP_STREAM_CONNECTING,
+    /**
+     * the TLS handshake has not finished yet
+     */
+    UDP_TCP_STREAM_HANDSHAKE,
+    /**
+     * an accepted stream whose hello has not been received yet, nothing is sent on it
+     */
+    UDP_TCP_STREAM_HELLO,
+    UDP_TCP_STREAM_ESTABLISHED
+};
+
+/**
+ * a stream to a peer
+ */
+struct udp_tcp_stream {
+    int fd;
+    enum udp_tcp_stream_state state;
+
+    /**
+     * the address of the UDP socket of the peer, known from the hello on an accepted stream
+     */
+    struct sockaddr_in address;
+    uint64_t endpoint;
+
+    /**
+     * 1 if this entity dialed the stream and sends the hello
+     */
+    int dialed;
+
+    /**
+     * the frames that wait to be sent and the received bytes that were not handed to a batch yet
+     */
+    unsigned char * send_buffer;
+    size_t send_length;
+    unsigned char * receive_buffer;
+    size_t receive_length;
+
+    /**
+     * the epoll events the stream is registered for, EPOLLOUT while the send buffer waits for the socket
+     */
+    uint32_t events;
+
+    /**
+     * 1 if the kernel encrypts and decrypts the records of the stream
+     */
+    int ktls;
+#ifdef ENABLE_TLS
+    WOLFSSL * ssl;
+    /**
+     * the length of an unfinished wolfSSL_write(), which has to be repeated with the same length, 0 otherwise
+     */
+    size_t tls_write_length;
+#endif
+};
+
+/**
+ * the counters of a TCP backend
+ */
+struct udp_tcp_stats {
+    /**
+     * the streams that were dialed and accepted
+     */
+    uint64_t dialed;
+    uint64_t accepted;
+    /**
+     * the streams whose records the kernel took over and the ones that kept WolfSSL in userspace
+     */
+    uint64_t ktls;
+    uint64_t userspace_tls;
+    /**
+     * the datagrams that did not fit into the send buffer of their stream or had no stream
+     */
+    uint64_t drops;
+};
+
+struct udp_tcp {
+    /**
+     * the address of the bound UDP socket, the listener uses the same address
+     */
+    struct sockaddr_in address;
+    enum udp_tcp_mode mode;
+
+    int listen_fd;
+    /**
+     * signaled while received frames wait in the buffers of the streams
+     */
+    int pending_fd;
+    /**
+     * the file descriptor the event loop waits on
+     */
+    int epoll_fd;
+
+    /**
+     * the streams, unordered
+     */
+    struct udp_tcp_stream * streams[UDP_TCP_MAX_STREAMS];
+    unsigned int stream_count;
+    /**
+     * the stream the next batch is filled from first, so a busy stream can not starve the others
+     */
+    unsigned int next_stream;
+
+    struct udp_tcp_stats stats;
+#ifdef ENABLE_TLS
+    /**
+     * the contexts of the dialed and the accepted streams
+     */
+    WOLFSSL_CTX * client_ctx;
+    WOLFSSL_CTX * server_ctx;
+    /**
+     * the name the certificates of the dialed streams are checked for, empty if any valid certificate is accepted
+     */
+    char tls_hostname[MAX_DOMAIN_LENGTH];
+#endif
+};
+
+/**
+ * listens for streams at the address of a bound socket
+ * @param file_descriptor the UDP socket, has to be bound to a specific address. It stays owned by the RastaUDPState
+ * @param mode UDP_TCP_MODE_TLS if the streams are encrypted
+ * @param tls_config the certificates of the streams, only read with UDP_TCP_MODE_TLS. A stream is accepted if the
+ * certificate and the key are set and dialed if the CA certificate is set
+ * @return the backend, NULL if the listener could not be opened
+ */
+struct udp_tcp * udp_tcp_create(int file_descriptor, enum udp_tcp_mode mode, const struct RastaConfigTLS * tls_config);
+
+/**
+ * closes all streams and the listener
+ * @param tcp the backend
+ */
+void udp_tcp_destroy(struct udp_tcp * tcp);
+
+/**
+ * @param tcp the backend
+ * @return the file descriptor that is readable while streams or frames wait to be handled
+ */
+int udp_tcp_receive_fd(struct udp_tcp * tcp);
+
+/**
+ * accepts, connects and closes the streams that are ready and copies the received frames into the slots of a batch,
+ * up to its capacity. Does not block
+ * @param tcp the backend
+ * @param batch the batch, batch#count is not changed
+ * @return the amount of datagrams copied into the batch
+ */
+unsigned int udp_tcp_receive(struct udp_tcp * tcp, struct RastaUDPReceiveBatch * batch);
+
+/**
+ * copies a datagram into the send buffer of the stream to @p receiver and dials the stream if there is none. It is not
+ * sent before udp_tcp_flush()
+ * @param tcp the backend
+ * @param message the datagram
+ * @param message_length the length of the datagram
+ * @param receiver the address of the UDP socket of the receiver
+ * @return 1 if the datagram was taken, 0 if it was dropped
+ */
+int udp_tcp_push(struct udp_tcp * tcp, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver);
+
+/**
+ * sends the send buffers of the established streams, as much as the sockets take without blocking
+ * @param tcp the backend
+ */
+void udp_tcp_flush(struct udp_tcp * tcp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_UDPTCP_H
@@ -0,0 +1,139 @@
+#ifndef LST_SIMULATOR_UDPURING_H
+#define LST_SIMULATOR_UDPURING_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+#include "udp.h"
+
+/**
+ * An io_uring backend below the UDP sockets of the transport channels (Linux only, ENABLE_IO_URING). A multishot
+ * recvmsg stays armed on the socket and the kernel receives the datagrams into a ring of provided buffers, so
+ * udp_receive_batch() only reaps the completion queue without a syscall. The event loop waits on the file descriptor
+ * of the ring instead of the socket. udp_send_batch() submits one sendmsg per datagram and waits for all of them with
+ * a single io_uring_enter()
+ */
+
+/**
+ * amount of provided buffers per socket, has to be a power of 2. A datagram that arrives while all buffers wait to be
+ * reaped ends the multishot receive, it is armed again by the next udp_uring_receive() call
+ */
+#define UDP_URING_BUFFER_COUNT 256
+
+/**
+ * size of a provided buffer: the io_uring_recvmsg_out header, the sender address, the control messages and the
+ * datagram
+ */
+#define UDP_URING_BUFFER_SIZE 2048
+
+/**
+ * amount of sendmsg requests that are submitted together, larger batches are sent in chunks
+ */
+#define UDP_URING_SEND_DEPTH 64
+
+/**
+ * the mapped submission and completion queues of an io_uring
+ */
+struct udp_uring_queue {
+    int fd;
+
+    unsigned int * sq_head;
+    unsigned int * sq_tail;
+    unsigned int sq_mask;
+    unsigned int * sq_array;
+    struct io_uring_sqe * sqes;
+
+    unsigned int * cq_head;
+    unsigned int * cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe * cqes;
+
+    void * sq_ring;
+    size_t sq_ring_size;
+    void * cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+struct udp_uring {
+    int file_descriptor;
+
+    /**
+     * the multishot recvmsg and its provided buffers
+     */
+    struct udp_uring_queue receive_queue;
+    struct io_uring_buf_ring * buffer_ring;
+    size_t buffer_ring_size;
+    unsigned char * buffers;
+    unsigned short buffer_tail;
+
+    /**
+     * the template of the multishot recvmsg, only the lengths of the sender address and the control messages are used
+     */
+    struct msghdr receive_header;
+    int receive_armed;
+
+    /**
+     * the sendmsg requests of a batch, their headers have to live until the requests are completed
+     */
+    struct udp_uring_queue send_queue;
+    struct msghdr send_headers[UDP_URING_SEND_DEPTH];
+    struct iovec send_iovecs[UDP_URING_SEND_DEPTH];
+    struct sockaddr_in send_receivers[UDP_URING_SEND_DEPTH];
+};
+
+/**
+ * sets up the rings of a bound socket
+ * @param file_descriptor the socket
+ * @param control_size the room for the control messages of a received datagram
+ * @return the rings, NULL if the kernel does not support io_uring with provided buffer rings
+ */
+struct udp_uring * udp_uring_create(int file_descriptor, size_t control_size);
+
+/**
+ * closes the rings, the socket stays open
+ * @param uring the rings
+ */
+void udp_uring_destroy(struct udp_uring * uring);
+
+/**
+ * arms the multishot recvmsg if it is not armed yet. The receive belongs to the calling thread, so this has to be
+ * called by the thread that runs the event loop
+ * @param uring the rings
+ * @return the file descriptor that is readable while completed receives wait to be reaped
+ */
+int udp_uring_start_receive(struct udp_uring * uring);
+
+/**
+ * reaps the completed receives into the slots of a batch, up to its capacity. The first completion is waited for,
+ * the receive is armed first if necessary. The datagrams are copied, so the provided buffers are returned to the
+ * kernel right away. The control messages are copied into batch#controls and the msg_controllen of the message
+ * headers is set to their length
+ * @param uring the rings
+ * @param batch the batch, batch#count is not changed
+ * @return the amount of received datagrams, 0 if the completions only reported exhausted buffers
+ */
+unsigned int udp_uring_receive(struct udp_uring * uring, struct RastaUDPReceiveBatch * batch);
+
+/**
+ * sends datagrams with one sendmsg request each and waits until all of them are sent
+ * @param uring the rings
+ * @param messages the datagrams
+ * @param message_lengths the lengths of the datagrams
+ * @param receivers the receiver of each datagram
+ * @param count the amount of datagrams
+ */
+void udp_uring_send(struct udp_uring * uring, unsigned char ** messages, size_t * message_lengths,
+                    struct sockaddr_in * receivers, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_UDPURING_H
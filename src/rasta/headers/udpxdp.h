@@ -0,0 +1,197 @@
+#ifndef LST_SIMULATOR_UDPXDP_H
+#define LST_SIMULATOR_UDPXDP_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include "udp.h"
+
+/**
+ * An AF_XDP backend below the UDP socket of a transport channel (Linux only, ENABLE_AF_XDP), for dedicated NICs. A
+ * small XDP program on the interface redirects the IPv4 datagrams to the address of the socket into an AF_XDP socket
+ * on one receive queue, everything else goes on to the kernel. The frames are received into a UMEM, udp_xdp_receive()
+ * checks their headers and checksums and hands the datagrams to the receive batch right where they are in the UMEM,
+ * until the next receive gives the frames back to the kernel.
+ * Datagrams to a sender whose link layer address has been seen in a received frame are written into the UMEM with
+ * their Ethernet, IPv4 and UDP headers and put into the TX ring, all other datagrams still use the socket. The socket
+ * stays bound, it keeps the port and receives the datagrams the program passes on, e.g. fragments or the ones of
+ * other receive queues. The event loop waits on an epoll instance that contains both sockets
+ */
+
+/**
+ * size of a frame of the UMEM, a datagram has to fit into one frame with its headers
+ */
+#define UDP_XDP_FRAME_SIZE 2048
+
+/**
+ * amount of frames of the UMEM that are filled by the kernel and of the ones that are sent, also the size of each of
+ * the four rings. Has to be a power of 2
+ */
+#define UDP_XDP_FRAMES 1024
+
+/**
+ * amount of senders whose link layer address is remembered, the oldest one is forgotten when a new one is seen
+ */
+#define UDP_XDP_MAX_NEIGHBOURS 16
+
+/**
+ * a mapped ring of the AF_XDP socket. Only this side writes producer of the fill and the TX ring and consumer of the
+ * RX and the completion ring
+ */
+struct udp_xdp_ring {
+    uint32_t * producer;
+    uint32_t * consumer;
+    uint32_t * flags;
+    void * descriptors;
+    uint32_t mask;
+
+    void * map;
+    size_t map_size;
+};
+
+/**
+ * a sender that was seen in a received frame
+ */
+struct udp_xdp_neighbour {
+    in_addr_t address;
+    unsigned char link_address[6];
+};
+
+struct udp_xdp {
+    /**
+     * the bound UDP socket, it stays owned by the RastaUDPState
+     */
+    int socket_fd;
+    struct sockaddr_in address;
+
+    int xsk_fd;
+    unsigned int ifindex;
+    unsigned int queue;
+    unsigned char link_address[6];
+    unsigned int mtu;
+
+    /**
+     * 1 on the loopback interface. Its frames carry the partial UDP checksums of the sending sockets, and the kernel
+     * drops the frames from loopback addresses that did not take its own output path, so nothing is sent through the
+     * TX ring there
+     */
+    int loopback;
+
+    /**
+     * the XSKMAP of the program, the program and the link that keeps it attached to the interface
+     */
+    int map_fd;
+    int program_fd;
+    int link_fd;
+
+    /**
+     * the file descriptor the event loop waits on
+     */
+    int epoll_fd;
+
+    /**
+     * the first UDP_XDP_FRAMES frames are received into, the others are sent from
+     */
+    unsigned char * umem;
+    size_t umem_size;
+
+    struct udp_xdp_ring fill;
+    struct udp_xdp_ring completion;
+    struct udp_xdp_ring rx;
+    struct udp_xdp_ring tx;
+
+    /**
+     * 1 if the kernel only looks at the fill and the TX ring after a syscall when the rings say so
+     */
+    int need_wakeup;
+
+    /**
+     * the frames that are referenced by the receive batch, they are put into the fill ring by the next receive
+     */
+    uint64_t held_frames[UDP_XDP_FRAMES];
+    unsigned int held_count;
+
+    /**
+     * the frames that can be sent from
+     */
+    uint64_t free_frames[UDP_XDP_FRAMES];
+    unsigned int free_count;
+
+    /**
+     * the amount of datagrams in the TX ring that the kernel has not been told about yet
+     */
+    unsigned int tx_pending;
+
+    struct udp_xdp_neighbour neighbours[UDP_XDP_MAX_NEIGHBOURS];
+    unsigned int neighbour_count;
+    unsigned int next_neighbour;
+
+    uint16_t next_ip_id;
+
+    /**
+     * the datagrams received and sent through the AF_XDP socket and the frames that were dropped because their
+     * headers or checksums were wrong
+     */
+    uint64_t received;
+    uint64_t sent;
+    uint64_t dropped;
+};
+
+/**
+ * attaches the XDP program of a bound socket to an interface and opens the AF_XDP socket on one of its receive queues
+ * @param file_descriptor the socket, has to be bound to a specific address
+ * @param interface the name of the interface
+ * @param queue the receive queue, the datagrams that arrive on other queues are received by the socket
+ * @return the backend, NULL if the kernel, the interface or the privileges do not allow it
+ */
+struct udp_xdp * udp_xdp_create(int file_descriptor, const char * interface, unsigned int queue);
+
+/**
+ * detaches the program and closes the AF_XDP socket, the UDP socket stays open
+ * @param xdp the backend
+ */
+void udp_xdp_destroy(struct udp_xdp * xdp);
+
+/**
+ * @param xdp the backend
+ * @return the file descriptor that is readable while datagrams wait on either socket
+ */
+int udp_xdp_receive_fd(struct udp_xdp * xdp);
+
+/**
+ * gives the frames of the previous call back to the kernel and hands the received datagrams to the segments of a
+ * batch, up to its capacity. Does not block
+ * @param xdp the backend
+ * @param batch the batch, its segments have to be allocated. batch#count is not changed
+ * @return the amount of datagrams, their data stays valid until the next call
+ */
+unsigned int udp_xdp_receive(struct udp_xdp * xdp, struct RastaUDPReceiveBatch * batch);
+
+/**
+ * writes a datagram into a frame of the TX ring. It is not sent before udp_xdp_flush()
+ * @param xdp the backend
+ * @param message the datagram
+ * @param message_length the length of the datagram
+ * @param receiver the receiver
+ * @return 1 if the datagram was taken, 0 if it has to be sent on the socket because the link layer address of the
+ * receiver is not known, the datagram is too long, all frames are in use or the interface is the loopback interface
+ */
+int udp_xdp_push(struct udp_xdp * xdp, const unsigned char * message, size_t message_length,
+                 const struct sockaddr_in * receiver);
+
+/**
+ * hands the datagrams of the previous udp_xdp_push() calls to the kernel
+ * @param xdp the backend
+ */
+void udp_xdp_flush(struct udp_xdp * xdp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_UDPXDP_H
@@ -0,0 +1,130 @@
+#ifndef LST_SIMULATOR_WORKERPOOL_H
+#define LST_SIMULATOR_WORKERPOOL_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <pthread.h>
+#include "mpscqueue.h"
+
+/**
+ * A pool of threads that runs expensive computations for an event loop. The event loop submits a job, a worker
+ * thread runs its work function and the event loop runs its completion function again, after it was woken up
+ * by the notify_fd of the pool. Only the thread of the event loop may submit jobs and complete them
+ */
+
+/**
+ * the computation of a job, runs on a worker thread
+ * @param carry_data the data that was passed to worker_pool_submit()
+ */
+typedef void (*worker_pool_work_ptr)(void * carry_data);
+
+/**
+ * finishes a job on the thread of the event loop
+ * @param carry_data the data that was passed to worker_pool_submit()
+ * @param cancelled 1 if the pool was destroyed before the work was run, 0 otherwise
+ */
+typedef void (*worker_pool_complete_ptr)(void * carry_data, int cancelled);
+
+/**
+ * a submitted job
+ */
+struct worker_job {
+    worker_pool_work_ptr work;
+    worker_pool_complete_ptr complete;
+    void * carry_data;
+
+    /**
+     * the next job in the list of free or queued jobs
+     */
+    struct worker_job * next;
+};
+
+struct worker_pool {
+    /**
+     * the worker threads
+     */
+    pthread_t * threads;
+    unsigned int thread_count;
+
+    /**
+     * guards the queued jobs and stopping, the workers wait on available for a queued job
+     */
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+
+    /**
+     * jobs that wait for a worker, oldest first
+     */
+    struct worker_job * first_queued;
+    struct worker_job * last_queued;
+
+    /**
+     * set when the pool is destroyed, the workers return instead of taking the next job
+     */
+    int stopping;
+
+    /**
+     * the slots of all jobs, there are max_pending of them. The unused slots are in free_jobs, which only the
+     * event loop uses
+     */
+    struct worker_job * jobs;
+    struct worker_job * free_jobs;
+
+    /**
+     * the amount of jobs that were submitted and not completed yet, never more than max_pending
+     */
+    unsigned int pending;
+    unsigned int max_pending;
+
+    /**
+     * the jobs whose work is done, i.e. pointers to struct worker_job
+     */
+    mpsc_queue_t * completions;
+
+    /**
+     * eventfd that wakes up the event loop when a job was added to completions
+     */
+    int notify_fd;
+};
+
+/**
+ * creates the worker threads of a pool
+ * @param pool the pool to initialize
+ * @param thread_count the amount of worker threads, at least 1
+ * @param max_pending the amount of jobs that can be submitted and not completed at once, at least 1
+ */
+void worker_pool_init(struct worker_pool * pool, unsigned int thread_count, unsigned int max_pending);
+
+/**
+ * hands a job to the workers
+ * @param pool the pool
+ * @param work the computation that runs on a worker thread
+ * @param complete runs on the thread of the event loop in worker_pool_complete() after @p work returned
+ * @param carry_data passed to @p work and @p complete
+ * @return 1 if the job was submitted, 0 if max_pending jobs are pending already
+ */
+int worker_pool_submit(struct worker_pool * pool, worker_pool_work_ptr work, worker_pool_complete_ptr complete,
+                       void * carry_data);
+
+/**
+ * runs the completion functions of all jobs whose work is done. Called by the event loop when the notify_fd
+ * of the pool is readable
+ * @param pool the pool
+ */
+void worker_pool_complete(struct worker_pool * pool);
+
+/**
+ * waits for the running jobs and stops the worker threads. The completion functions of all pending jobs are run,
+ * the ones whose work was not started yet are cancelled
+ * @param pool the pool to destroy
+ */
+void worker_pool_destroy(struct worker_pool * pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_WORKERPOOL_H
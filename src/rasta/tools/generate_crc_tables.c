@@ -0,0 +1,118 @@
+/**
+ * Generates the CRC lookup tables of the standard RaSTA CRC options (6.3.6 b) to e)) as C source, so the library
+ * does not have to compute them at runtime.
+ * Usage: generate_crc_tables <output file>
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+/**
+ * the parameters of a CRC variant that determine its lookup tables
+ */
+struct crc_variant {
+    const char * name;
+    unsigned int width;
+    uint32_t polynom;
+    int refin;
+};
+
+static const struct crc_variant variants[] = {
+    { "crc_table_opt_b", 32, 0xEE5B42FD, 0 },
+    { "crc_table_opt_c", 32, 0x1EDC6F41, 1 },
+    { "crc_table_opt_d", 16, 0x1021, 1 },
+    { "crc_table_opt_e", 16, 0x8005, 1 },
+};
+
+/**
+ * reflects the lower @p n bits
+ * @param crc_in the crc input value
+ * @param n the number of bits that will be reflected
+ * @return the calculated value
+ */
+static uint32_t reflect(uint32_t crc_in, unsigned int n) {
+    uint32_t crc_out = 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        if (crc_in & ((uint32_t)1 << i)) {
+            crc_out |= (uint32_t)1 << (n - 1 - i);
+        }
+    }
+    return crc_out;
+}
+
+/**
+ * generates the tables of a variant, entry k contains the crc of a byte followed by k zero bytes
+ * @param variant the variant
+ * @param table the tables that are filled
+ */
+static void generate(const struct crc_variant * variant, uint32_t table[8][256]) {
+    const uint32_t mask = (variant->width == 32) ? 0xFFFFFFFF : (((uint32_t)1 << variant->width) - 1);
+    const uint32_t high_bit = (uint32_t)1 << (variant->width - 1);
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = variant->refin ? reflect(i, 8) : i;
+        crc <<= variant->width - 8;
+
+        for (int j = 0; j < 8; j++) {
+            uint32_t bit = crc & high_bit;
+            crc <<= 1;
+            if (bit) crc ^= variant->polynom;
+        }
+
+        if (variant->refin) {
+            crc = reflect(crc & mask, variant->width);
+        }
+        table[0][i] = crc & mask;
+    }
+
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t crc = table[k-1][i];
+            if (variant->refin) {
+                crc = (crc >> 8) ^ table[0][crc & 0xff];
+            } else {
+                crc = ((crc << 8) & mask) ^ table[0][(crc >> (variant->width - 8)) & 0xff];
+            }
+            table[k][i] = crc;
+        }
+    }
+}
+
+int main(int argc, char * argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE * out = fopen(argv[1], "w");
+    if (out == NULL) {
+        perror("fopen");
+        exit(1);
+    }
+
+    fprintf(out, "// generated by generate_crc_tables, do not edit\n\n#include <stdint.h>\n");
+
+    static uint32_t table[8][256];
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        generate(&variants[v], table);
+
+        fprintf(out, "\nconst uint32_t %s[8][256] = {\n", variants[v].name);
+        for (int k = 0; k < 8; k++) {
+            fprintf(out, "    {");
+            for (int i = 0; i < 256; i++) {
+                fprintf(out, "%s0x%08" PRIX32 ",", (i % 8 == 0) ? "\n        " : " ", table[k][i]);
+            }
+            fprintf(out, "\n    },\n");
+        }
+        fprintf(out, "};\n");
+    }
+
+    if (fclose(out) != 0) {
+        perror("fclose");
+        exit(1);
+    }
+
+    return 0;
+}
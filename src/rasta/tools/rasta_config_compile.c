@@ -0,0 +1,37 @@
+/**
+ * Validates a config file and writes it as a snapshot (see config_write_snapshot()). Every entry point that takes a
+ * config file takes the snapshot as well, the entities on a host that load the same snapshot share it read only.
+ * Usage: rasta_config_compile <config file> <snapshot>
+ */
+
+#include <stdio.h>
+#include <config.h>
+
+int main(int argc, char * argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <config file> <snapshot>\n", argv[0]);
+        return 1;
+    }
+
+    struct RastaConfig config = config_load(argv[1]);
+    if (config.dictionary.data == NULL || config.errors > 0) {
+        fprintf(stderr, "%s has %u errors, no snapshot was written\n", argv[1], config.errors);
+        config_free(&config);
+        return 1;
+    }
+    if (config.snapshot != NULL) {
+        fprintf(stderr, "%s is a snapshot already\n", argv[1]);
+        config_free(&config);
+        return 1;
+    }
+
+    if (!config_write_snapshot(&config, argv[2])) {
+        perror(argv[2]);
+        config_free(&config);
+        return 1;
+    }
+
+    printf("%s: %u keys\n", argv[2], config.dictionary.size);
+    config_free(&config);
+    return 0;
+}
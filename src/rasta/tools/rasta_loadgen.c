@@ -0,0 +1,749 @@
+/**
+ * Simulates thousands of RaSTA clients, like the field elements of a station, against one server to find its capacity.
+ * Every simulated client is an entity with its own RaSTA ID. The clients are spread over several event loops, each of
+ * them runs its clients as entities that share one set of sockets. Every client connects once, sends application
+ * messages at a configured rate and size, and is closed and connected again after a configured lifetime. The tool
+ * reports the clients that are up, the handshake times and the sent messages every interval, together with the values
+ * the metrics endpoint of the server reports.
+ * Usage: rasta_loadgen <client config file> [--connections=<n>] [--threads=<n>] [--rate=<messages/s>] ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <rasta_lib.h>
+#include <rasta_new.h>
+#include <rastametrics.h>
+#include <fifo.h>
+#include <rmemory.h>
+
+#define NS_PER_SECOND 1000000000lu
+
+/**
+ * how often a loop sends the messages that are due and checks the lifetimes and the pending connects of its clients
+ */
+#define TICK_INTERVAL_NS (NS_PER_MS / 2)
+
+/**
+ * the largest response of the metrics endpoint of the server that is read
+ */
+#define MAX_METRICS_RESPONSE (64 * 1024 * 1024)
+
+#define MAX_SERVER_CHANNELS 8
+
+struct loadgen_options {
+    const char * config_path;
+    unsigned int connections;
+    unsigned int threads;
+    unsigned long server_id;
+    struct RastaIPData server_channels[MAX_SERVER_CHANNELS];
+    unsigned int server_channel_count;
+    unsigned int server_shards;
+
+    /**
+     * the application messages per second of every connection, 0 sends none
+     */
+    double rate;
+    unsigned int size;
+
+    /**
+     * 0 keeps the values of the config file
+     */
+    unsigned int heartbeat_ms;
+    unsigned int reconnect_min_ms;
+    unsigned int reconnect_max_ms;
+    int reconnect_set;
+
+    /**
+     * the time a connection stays up before the client closes it and connects again, 0 keeps it up
+     */
+    unsigned int lifetime_ms;
+
+    /**
+     * the connects of all clients are spread over this time
+     */
+    unsigned int ramp_ms;
+    unsigned int seconds;
+    unsigned int report_ms;
+
+    /**
+     * the metrics endpoint of the server, port 0 if it is not scraped
+     */
+    struct sockaddr_in metrics;
+};
+
+struct loadgen_group;
+
+struct loadgen_client {
+    struct loadgen_group * group;
+    struct rasta_lib_configuration_s * entity;
+    struct RastaIPData server_channels[MAX_SERVER_CHANNELS];
+
+    /**
+     * the times of the loop the client connects, was connected and is closed, 0 if they are not pending
+     */
+    uint64_t connect_at;
+    uint64_t connected_at;
+    uint64_t up_since;
+    uint64_t close_at;
+
+    unsigned int attempts;
+    unsigned long sent;
+};
+
+/**
+ * the clients of one event loop
+ */
+struct loadgen_group {
+    rasta_lib_entities_t entities;
+    struct loadgen_client * clients;
+    unsigned int count;
+    pthread_t thread;
+
+    timed_event tick_event;
+    timed_event termination_event;
+    unsigned int seed;
+
+    /**
+     * written by the loop, read by the reports
+     */
+    struct rasta_histogram handshake_ms;
+    atomic_uint up;
+    atomic_ulong handshakes;
+    atomic_ulong closed;
+    atomic_ulong heartbeat_timeouts;
+    atomic_ulong sent;
+    atomic_ulong queue_full;
+};
+
+/**
+ * the sums of what the metrics endpoint of the server reported
+ */
+struct server_sample {
+    int valid;
+    unsigned long connections;
+    /**
+     * the PDUs the server received from the clients since the previous sample
+     */
+    unsigned long pdus_in;
+    unsigned long retransmission_requests;
+    unsigned long errors;
+    unsigned long defer_timeouts;
+    unsigned long transmit_drops;
+    unsigned long max_send_queue;
+    unsigned long max_receive_queue;
+    unsigned long lag_p99_us;
+};
+
+static struct loadgen_options options;
+static struct loadgen_group * groups;
+
+/**
+ * the clients by their index, which is their RaSTA ID minus the one of the config file
+ */
+static struct loadgen_client ** clients_by_index;
+static unsigned long base_id;
+
+/**
+ * the PDU counter the server reported last for every client by its index. A connection the server opened again starts
+ * at 0, so the differences are summed instead of the counters
+ */
+static unsigned long * server_pdus_in;
+
+static uint64_t get_walltime() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * NS_PER_SECOND + (uint64_t) t.tv_nsec;
+}
+
+static struct loadgen_client * get_client(struct rasta_handle * h) {
+    unsigned long index = h->config.values.general.rasta_id - base_id;
+    return index < options.connections ? clients_by_index[index] : NULL;
+}
+
+void * on_con_start(rasta_lib_connection_t connection) {
+    (void) connection;
+    return malloc(sizeof(rasta_lib_connection_t));
+}
+
+void on_con_end(rasta_lib_connection_t connection, void * memory) {
+    (void) connection;
+    free(memory);
+}
+
+void on_connection_state_change(struct rasta_notification_result * result) {
+    struct loadgen_client * client = get_client(result->handle);
+    if (client == NULL) {
+        return;
+    }
+    struct loadgen_group * group = client->group;
+    uint64_t now = get_walltime();
+
+    if (result->con->current_state == RASTA_CONNECTION_UP && client->up_since == 0) {
+        client->up_since = now;
+        if (client->connected_at != 0) {
+            rasta_histogram_record(&group->handshake_ms, (unsigned long) ((now - client->connected_at) / NS_PER_MS));
+        }
+        client->attempts = 0;
+        if (options.lifetime_ms > 0) {
+            client->close_at = now + (uint64_t) options.lifetime_ms * NS_PER_MS;
+        }
+        atomic_fetch_add_explicit(&group->up, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&group->handshakes, 1, memory_order_relaxed);
+    } else if ((result->con->current_state == RASTA_CONNECTION_CLOSED ||
+                result->con->current_state == RASTA_CONNECTION_DOWN) && client->up_since != 0) {
+        client->up_since = 0;
+        client->close_at = 0;
+        // a reconnect of the library sends a new connection request, its handshake is timed from here
+        client->connected_at = now;
+        atomic_fetch_sub_explicit(&group->up, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&group->closed, 1, memory_order_relaxed);
+    }
+}
+
+void on_heartbeat_timeout(struct rasta_notification_result * result) {
+    struct loadgen_client * client = get_client(result->handle);
+    if (client != NULL) {
+        atomic_fetch_add_explicit(&client->group->heartbeat_timeouts, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * sends the application messages of a client that are due since its connection is up
+ * @param client the client
+ * @param con its connection, which is up
+ * @param now the current time
+ */
+static void send_due(struct loadgen_client * client, struct rasta_connection * con, uint64_t now) {
+    struct rasta_handle * h = &client->entity->h;
+    unsigned long due = (unsigned long) ((double) (now - client->up_since) * options.rate / NS_PER_SECOND);
+    if (due <= client->sent) {
+        return;
+    }
+
+    unsigned char bytes[MAX_APP_MSG_LEN];
+    memset(bytes, 0x5a, sizeof(bytes));
+    struct RastaByteArray message = { .bytes = bytes, .length = options.size };
+    struct RastaMessageData data = { .count = 1, .data_array = &message };
+
+    unsigned long count = due - client->sent;
+    for (unsigned long i = 0; i < count; i++) {
+        // a server that does not confirm fast enough lets the send queue fill up, the messages are skipped then
+        if (fifo_get_size(con->fifo_send) >= h->config.values.sending.max_packet) {
+            atomic_fetch_add_explicit(&client->group->queue_full, count - i, memory_order_relaxed);
+            break;
+        }
+        sr_send_connection(h, con, data);
+    }
+    client->sent = due;
+    atomic_fetch_add_explicit(&client->group->sent, count, memory_order_relaxed);
+}
+
+int tick_event(void * carry_data) {
+    struct loadgen_group * group = carry_data;
+    uint64_t now = get_walltime();
+
+    for (unsigned int i = 0; i < group->count; i++) {
+        struct loadgen_client * client = &group->clients[i];
+        struct rasta_handle * h = &client->entity->h;
+        struct rasta_connection * con = h->first_con;
+
+        if (client->connect_at != 0 && now >= client->connect_at) {
+            client->connect_at = 0;
+            client->connected_at = now;
+            client->sent = 0;
+            sr_connect(h, options.server_id, client->server_channels);
+            continue;
+        }
+        if (con == NULL || con->current_state != RASTA_CONNECTION_UP || client->up_since == 0) {
+            continue;
+        }
+
+        if (client->close_at != 0 && now >= client->close_at) {
+            // the client connects again after the reconnect delay, like after a lost connection
+            sr_disconnect(h, con);
+            unsigned int delay_ms = h->config.values.sending.reconnect_min_ms > 0 ?
+                                    sr_reconnect_delay_ms(h->config.values.sending, client->attempts++, &group->seed) : 0;
+            client->connect_at = now + (uint64_t) delay_ms * NS_PER_MS + 1;
+            continue;
+        }
+        if (options.rate > 0) {
+            send_due(client, con, now);
+        }
+    }
+    return 0;
+}
+
+int terminate_event(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+/**
+ * sets the heartbeat interval of a handle that has not started, the sub handles keep a copy of it
+ */
+static void set_heartbeat_interval(struct rasta_handle * h, unsigned int t_h) {
+    h->config.values.sending.t_h = t_h;
+    h->receive_handle->config.t_h = t_h;
+    h->send_handle->config.t_h = t_h;
+    h->heartbeat_handle->config.t_h = t_h;
+}
+
+/**
+ * initializes the clients of an event loop. The first client opens the sockets of the config file, moved by the index
+ * of the group, the other ones share them
+ * @param group the group
+ * @param index the index of the group
+ * @param first the index of the first client of the group
+ * @param count the amount of clients of the group
+ * @param port_count the amount of local ports in the config file
+ */
+static void group_init(struct loadgen_group * group, unsigned int index, unsigned int first, unsigned int count,
+                       unsigned int port_count) {
+    memset(group, 0, sizeof(struct loadgen_group));
+    group->count = count;
+    group->seed = index + 1;
+    group->clients = calloc(count, sizeof(struct loadgen_client));
+    group->entities->count = count;
+    group->entities->entities = rmalloc(count * sizeof(struct rasta_lib_configuration_s));
+    if (group->clients == NULL || group->entities->entities == NULL) {
+        perror("Could not allocate clients");
+        exit(1);
+    }
+
+    // like rasta_lib_init_entities(), but every group has its own ports
+    struct rasta_handle * owner = &group->entities->entities[0].h;
+    for (unsigned int i = 0; i < count; i++) {
+        struct rasta_lib_configuration_s * entity = &group->entities->entities[i];
+        memset(entity, 0, sizeof(struct rasta_lib_configuration_s));
+        if (i == 0) {
+            sr_init_handle_with_offsets(&entity->h, options.config_path, first, index * port_count);
+        } else {
+            sr_init_member_handle(&entity->h, options.config_path, base_id + first + i, owner);
+        }
+        entity->h.user_handles = &entity->callback;
+        entity->callback.on_connection_start = on_con_start;
+        entity->callback.on_disconnect = on_con_end;
+        entity->h.notifications.on_connection_state_change = on_connection_state_change;
+        entity->h.notifications.on_heartbeat_timeout = on_heartbeat_timeout;
+        if (options.heartbeat_ms > 0) {
+            set_heartbeat_interval(&entity->h, options.heartbeat_ms);
+        }
+        if (options.reconnect_set) {
+            entity->h.config.values.sending.reconnect_min_ms = options.reconnect_min_ms;
+            entity->h.config.values.sending.reconnect_max_ms = options.reconnect_max_ms;
+        }
+
+        struct loadgen_client * client = &group->clients[i];
+        client->group = group;
+        client->entity = entity;
+        // without shared ports, every shard of the server listens on its own ports
+        unsigned int shard = rasta_lib_shard_index(base_id + first + i, options.server_shards);
+        rasta_lib_shard_channels(options.server_channels, options.server_channel_count, shard,
+                                 client->server_channels);
+        clients_by_index[first + i] = client;
+    }
+
+    event_system * ev_sys = &group->entities->entities[0].rasta_lib_event_system;
+    group->tick_event.callback = tick_event;
+    group->tick_event.carry_data = group;
+    group->tick_event.interval = TICK_INTERVAL_NS;
+    enable_timed_event(&group->tick_event);
+    add_timed_event(ev_sys, &group->tick_event);
+
+    group->termination_event.callback = terminate_event;
+    group->termination_event.interval = (uint64_t) options.seconds * NS_PER_SECOND;
+    enable_timed_event(&group->termination_event);
+    add_timed_event(ev_sys, &group->termination_event);
+}
+
+static void * group_run(void * carry_data) {
+    struct loadgen_group * group = carry_data;
+    rasta_lib_start_entities(group->entities, 0);
+
+    event_system * ev_sys = &group->entities->entities[0].rasta_lib_event_system;
+    remove_timed_event(ev_sys, &group->tick_event);
+    remove_timed_event(ev_sys, &group->termination_event);
+    return NULL;
+}
+
+/**
+ * @param line a line of the metrics endpoint
+ * @param name the name of a metric
+ * @return the value of the line if it is a sample of @p name, with or without labels, -1 otherwise
+ */
+static double metric_value(const char * line, const char * name) {
+    size_t length = strlen(name);
+    if (strncmp(line, name, length) != 0 || (line[length] != ' ' && line[length] != '{')) {
+        return -1;
+    }
+    const char * value = strrchr(line, ' ');
+    return value != NULL ? strtod(value + 1, NULL) : -1;
+}
+
+/**
+ * reads the metrics endpoint of the server and sums the samples of all connections
+ * @param sample the sums, valid is 0 if the endpoint could not be read completely
+ */
+static void scrape_server(struct server_sample * sample) {
+    memset(sample, 0, sizeof(*sample));
+    if (options.metrics.sin_port == 0) {
+        return;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return;
+    }
+    struct timeval timeout = { .tv_sec = 2, .tv_usec = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *) &options.metrics, sizeof(options.metrics)) == -1) {
+        close(fd);
+        return;
+    }
+    static const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    if (send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) != (ssize_t) sizeof(request) - 1) {
+        close(fd);
+        return;
+    }
+
+    size_t capacity = 65536, length = 0;
+    char * response = malloc(capacity + 1);
+    for (;;) {
+        if (length == capacity) {
+            if (capacity >= MAX_METRICS_RESPONSE) {
+                break;
+            }
+            capacity *= 2;
+            response = realloc(response, capacity + 1);
+        }
+        ssize_t result = recv(fd, response + length, capacity - length, 0);
+        if (result <= 0) {
+            break;
+        }
+        length += (size_t) result;
+    }
+    close(fd);
+    response[length] = '\0';
+
+    // the loop lag follows the connections, a response that got cut off before it is no sample
+    char * body = strstr(response, "\r\n\r\n");
+    for (char * line = body != NULL ? strtok(body + 4, "\n") : NULL; line != NULL; line = strtok(NULL, "\n")) {
+        double value;
+        if ((value = metric_value(line, "rasta_connection_pdus_in_total")) >= 0) {
+            sample->connections++;
+            const char * remote_id = strstr(line, "remote_id=\"");
+            unsigned long index = remote_id != NULL ? strtoul(remote_id + 11, NULL, 16) - base_id : options.connections;
+            if (index < options.connections) {
+                unsigned long * last = &server_pdus_in[index];
+                sample->pdus_in += (unsigned long) value >= *last ? (unsigned long) value - *last : (unsigned long) value;
+                *last = (unsigned long) value;
+            }
+        } else if ((value = metric_value(line, "rasta_connection_retransmission_requests_total")) >= 0) {
+            sample->retransmission_requests += (unsigned long) value;
+        } else if ((value = metric_value(line, "rasta_connection_errors_total")) >= 0) {
+            sample->errors += (unsigned long) value;
+        } else if ((value = metric_value(line, "rasta_connection_defer_timeouts_total")) >= 0) {
+            sample->defer_timeouts += (unsigned long) value;
+        } else if ((value = metric_value(line, "rasta_transmit_drops_total")) >= 0) {
+            sample->transmit_drops += (unsigned long) value;
+        } else if ((value = metric_value(line, "rasta_connection_queue_size")) >= 0) {
+            unsigned long * max = strstr(line, "queue=\"send\"") ? &sample->max_send_queue :
+                                  strstr(line, "queue=\"receive\"") ? &sample->max_receive_queue : NULL;
+            if (max != NULL && (unsigned long) value > *max) {
+                *max = (unsigned long) value;
+            }
+        } else if ((value = metric_value(line, "rasta_event_loop_lag_us")) >= 0 && strstr(line, "quantile=\"0.99\"")) {
+            sample->lag_p99_us = (unsigned long) value;
+            sample->valid = 1;
+        }
+    }
+    free(response);
+}
+
+/**
+ * the sums over all loops
+ */
+struct client_sample {
+    unsigned int up;
+    unsigned long handshakes;
+    unsigned long closed;
+    unsigned long heartbeat_timeouts;
+    unsigned long sent;
+    unsigned long queue_full;
+    struct rasta_histogram handshake_ms;
+};
+
+static void sample_clients(struct client_sample * sample) {
+    memset(sample, 0, sizeof(*sample));
+    for (unsigned int i = 0; i < options.threads; i++) {
+        struct loadgen_group * group = &groups[i];
+        sample->up += atomic_load_explicit(&group->up, memory_order_relaxed);
+        sample->handshakes += atomic_load_explicit(&group->handshakes, memory_order_relaxed);
+        sample->closed += atomic_load_explicit(&group->closed, memory_order_relaxed);
+        sample->heartbeat_timeouts += atomic_load_explicit(&group->heartbeat_timeouts, memory_order_relaxed);
+        sample->sent += atomic_load_explicit(&group->sent, memory_order_relaxed);
+        sample->queue_full += atomic_load_explicit(&group->queue_full, memory_order_relaxed);
+
+        struct rasta_histogram handshake_ms;
+        rasta_histogram_snapshot(&group->handshake_ms, &handshake_ms);
+        for (unsigned int b = 0; b < RASTA_HISTOGRAM_BUCKETS; b++) {
+            sample->handshake_ms.buckets[b] += handshake_ms.buckets[b];
+        }
+        sample->handshake_ms.count += handshake_ms.count;
+        sample->handshake_ms.sum += handshake_ms.sum;
+        if (handshake_ms.max > sample->handshake_ms.max) {
+            sample->handshake_ms.max = handshake_ms.max;
+        }
+    }
+}
+
+/**
+ * @return the change of a counter per second
+ */
+static unsigned long per_second(unsigned long now, unsigned long before, uint64_t elapsed_ns) {
+    return elapsed_ns > 0 && now >= before ? (unsigned long) ((now - before) * NS_PER_SECOND / elapsed_ns) : 0;
+}
+
+static int parse_address(const char * text, struct RastaIPData * address) {
+    const char * colon = strrchr(text, ':');
+    if (colon == NULL || colon - text >= (long) sizeof(address->ip) || atoi(colon + 1) <= 0) {
+        return 0;
+    }
+    memset(address->ip, 0, sizeof(address->ip));
+    memcpy(address->ip, text, colon - text);
+    address->port = atoi(colon + 1);
+    struct in_addr check;
+    return inet_pton(AF_INET, address->ip, &check) == 1;
+}
+
+static int parse_options(int argc, char * argv[]) {
+    memset(&options, 0, sizeof(options));
+    options.connections = 1000;
+    options.threads = 1;
+    options.server_id = 0x61;
+    options.server_shards = 1;
+    options.rate = 1;
+    options.size = 40;
+    options.ramp_ms = 1000;
+    options.seconds = 10;
+    options.report_ms = 1000;
+    parse_address("127.0.0.1:8888", &options.server_channels[0]);
+    parse_address("127.0.0.1:8889", &options.server_channels[1]);
+    options.server_channel_count = 2;
+
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        if (arg[0] != '-') {
+            if (options.config_path != NULL) {
+                return 0;
+            }
+            options.config_path = arg;
+        } else if (strncmp(arg, "--connections=", 14) == 0) {
+            options.connections = (unsigned int) strtoul(arg + 14, NULL, 0);
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            options.threads = (unsigned int) strtoul(arg + 10, NULL, 0);
+        } else if (strncmp(arg, "--server-id=", 12) == 0) {
+            options.server_id = strtoul(arg + 12, NULL, 0);
+        } else if (strncmp(arg, "--server=", 9) == 0) {
+            char list[256];
+            snprintf(list, sizeof(list), "%s", arg + 9);
+            options.server_channel_count = 0;
+            for (char * item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                if (options.server_channel_count == MAX_SERVER_CHANNELS ||
+                    !parse_address(item, &options.server_channels[options.server_channel_count++])) {
+                    return 0;
+                }
+            }
+        } else if (strncmp(arg, "--server-shards=", 16) == 0) {
+            options.server_shards = (unsigned int) strtoul(arg + 16, NULL, 0);
+        } else if (strncmp(arg, "--rate=", 7) == 0) {
+            options.rate = atof(arg + 7);
+        } else if (strncmp(arg, "--size=", 7) == 0) {
+            options.size = (unsigned int) strtoul(arg + 7, NULL, 0);
+        } else if (strncmp(arg, "--heartbeat-ms=", 15) == 0) {
+            options.heartbeat_ms = (unsigned int) strtoul(arg + 15, NULL, 0);
+        } else if (strncmp(arg, "--reconnect-ms=", 15) == 0) {
+            char * end;
+            options.reconnect_set = 1;
+            options.reconnect_min_ms = (unsigned int) strtoul(arg + 15, &end, 0);
+            options.reconnect_max_ms = *end == ',' ? (unsigned int) strtoul(end + 1, NULL, 0) :
+                                       options.reconnect_min_ms;
+        } else if (strncmp(arg, "--lifetime-ms=", 14) == 0) {
+            options.lifetime_ms = (unsigned int) strtoul(arg + 14, NULL, 0);
+        } else if (strncmp(arg, "--ramp-ms=", 10) == 0) {
+            options.ramp_ms = (unsigned int) strtoul(arg + 10, NULL, 0);
+        } else if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = (unsigned int) strtoul(arg + 10, NULL, 0);
+        } else if (strncmp(arg, "--report-ms=", 12) == 0) {
+            options.report_ms = (unsigned int) strtoul(arg + 12, NULL, 0);
+        } else if (strncmp(arg, "--metrics=", 10) == 0) {
+            struct RastaIPData address;
+            if (!parse_address(arg + 10, &address)) {
+                return 0;
+            }
+            options.metrics.sin_family = AF_INET;
+            options.metrics.sin_port = htons((uint16_t) address.port);
+            inet_pton(AF_INET, address.ip, &options.metrics.sin_addr);
+        } else {
+            return 0;
+        }
+    }
+
+    return options.config_path != NULL && options.connections > 0 && options.threads > 0 &&
+           options.threads <= options.connections && options.server_shards > 0 && options.rate >= 0 &&
+           options.size <= MAX_APP_MSG_LEN && options.seconds > 0 && options.report_ms > 0 &&
+           options.reconnect_min_ms <= options.reconnect_max_ms;
+}
+
+/**
+ * every client has three event fds, so a station needs more than the default limit of open files
+ */
+static void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char * argv[]) {
+    if (!parse_options(argc, argv)) {
+        fprintf(stderr, "usage: %s <client config file> [--connections=<n>] [--threads=<n>] "
+                        "[--server=<ip:port>[,<ip:port>...]] [--server-id=<id>] [--server-shards=<n>] "
+                        "[--rate=<messages/s per connection>] [--size=<0 to %d bytes>] [--heartbeat-ms=<ms>] "
+                        "[--reconnect-ms=<min>[,<max>]] [--lifetime-ms=<ms>] [--ramp-ms=<ms>] [--seconds=<s>] "
+                        "[--report-ms=<ms>] [--metrics=<ip:port of the server endpoint>]\n", argv[0], MAX_APP_MSG_LEN);
+        return 1;
+    }
+    raise_file_limit();
+
+    struct RastaConfig config = config_load(options.config_path);
+    if (config.dictionary.data == NULL) {
+        fprintf(stderr, "could not read %s\n", options.config_path);
+        return 1;
+    }
+    base_id = config.values.general.rasta_id;
+    unsigned int port_count = config.values.redundancy.connections.count;
+    config_free(&config);
+
+    clients_by_index = calloc(options.connections, sizeof(struct loadgen_client *));
+    server_pdus_in = calloc(options.connections, sizeof(unsigned long));
+    groups = calloc(options.threads, sizeof(struct loadgen_group));
+    if (clients_by_index == NULL || groups == NULL) {
+        perror("Could not allocate clients");
+        return 1;
+    }
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < options.threads; i++) {
+        unsigned int count = options.connections / options.threads + (i < options.connections % options.threads);
+        group_init(&groups[i], i, first, count, port_count);
+        first += count;
+    }
+
+    // the connects are spread over the ramp in the order of the RaSTA IDs
+    uint64_t start = get_walltime();
+    for (unsigned int i = 0; i < options.connections; i++) {
+        clients_by_index[i]->connect_at = start + (uint64_t) options.ramp_ms * NS_PER_MS * i / options.connections + 1;
+    }
+
+    printf("%u connections to 0x%lX on %u threads, %g messages/s of %u bytes per connection, %u s\n",
+           options.connections, options.server_id, options.threads, options.rate, options.size, options.seconds);
+    for (unsigned int i = 0; i < options.threads; i++) {
+        pthread_create(&groups[i].thread, NULL, group_run, &groups[i]);
+    }
+
+    struct client_sample clients, previous_clients;
+    struct server_sample server, previous_server;
+    memset(&previous_clients, 0, sizeof(previous_clients));
+    scrape_server(&previous_server);
+    uint64_t previous = start;
+    unsigned int peak_up = 0;
+    unsigned long peak_lag_us = 0, peak_server_connections = 0, peak_server_pdus = 0;
+    uint64_t end = start + (uint64_t) options.seconds * NS_PER_SECOND;
+
+    for (uint64_t now = start; now < end; now = get_walltime()) {
+        uint64_t wait = (uint64_t) options.report_ms * NS_PER_MS;
+        if (end - now < wait) {
+            wait = end - now;
+        }
+        struct timespec pause = { .tv_sec = (time_t) (wait / NS_PER_SECOND), .tv_nsec = (long) (wait % NS_PER_SECOND) };
+        nanosleep(&pause, NULL);
+
+        now = get_walltime();
+        uint64_t elapsed = now - previous;
+        sample_clients(&clients);
+        scrape_server(&server);
+
+        printf("%6.1f s  up %u/%u  handshakes %lu (p50 %lu ms, p99 %lu ms)  closed %lu  timeouts %lu  "
+               "sent %lu/s  queue full %lu", (double) (now - start) / NS_PER_SECOND, clients.up, options.connections,
+               clients.handshakes, rasta_histogram_percentile(&clients.handshake_ms, 50),
+               rasta_histogram_percentile(&clients.handshake_ms, 99), clients.closed, clients.heartbeat_timeouts,
+               per_second(clients.sent, previous_clients.sent, elapsed), clients.queue_full);
+        if (server.valid) {
+            unsigned long pdus_in = previous_server.valid ? per_second(server.pdus_in, 0, elapsed) : 0;
+            printf("  | server: connections %lu  PDUs in %lu/s  retransmission requests %lu  errors %lu  "
+                   "transmit drops %lu  max send queue %lu  loop lag p99 %lu us", server.connections, pdus_in,
+                   server.retransmission_requests, server.errors, server.transmit_drops, server.max_send_queue,
+                   server.lag_p99_us);
+            if (server.connections > peak_server_connections) {
+                peak_server_connections = server.connections;
+            }
+            if (pdus_in > peak_server_pdus) {
+                peak_server_pdus = pdus_in;
+            }
+            if (server.lag_p99_us > peak_lag_us) {
+                peak_lag_us = server.lag_p99_us;
+            }
+        } else if (options.metrics.sin_port != 0) {
+            printf("  | server: metrics endpoint not reachable");
+        }
+        printf("\n");
+        fflush(stdout);
+
+        if (clients.up > peak_up) {
+            peak_up = clients.up;
+        }
+        previous = now;
+        previous_clients = clients;
+        previous_server = server;
+    }
+
+    for (unsigned int i = 0; i < options.threads; i++) {
+        pthread_join(groups[i].thread, NULL);
+    }
+
+    sample_clients(&clients);
+    printf("peak: %u of %u connections up, %lu handshakes (p50 %lu ms, p99 %lu ms, max %lu ms), %lu closed, "
+           "%lu heartbeat timeouts, %lu messages sent, %lu skipped on full send queues\n", peak_up,
+           options.connections, clients.handshakes, rasta_histogram_percentile(&clients.handshake_ms, 50),
+           rasta_histogram_percentile(&clients.handshake_ms, 99), clients.handshake_ms.max, clients.closed,
+           clients.heartbeat_timeouts, clients.sent, clients.queue_full);
+    if (options.metrics.sin_port != 0) {
+        printf("server peak: %lu connections, %lu PDUs/s in, loop lag p99 %lu us\n", peak_server_connections,
+               peak_server_pdus, peak_lag_us);
+    }
+    int result = peak_up == options.connections ? 0 : 2;
+    if (result != 0) {
+        printf("only %u of %u connections were up at the same time\n", peak_up, options.connections);
+    }
+
+    for (unsigned int i = 0; i < options.threads; i++) {
+        rasta_lib_cleanup_entities(groups[i].entities);
+        free(groups[i].clients);
+    }
+    free(groups);
+    free(clients_by_index);
+    free(server_pdus_in);
+    return result;
+}
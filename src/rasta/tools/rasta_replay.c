@@ -0,0 +1,651 @@
+/**
+ * Replays captured RaSTA traffic offline through the receive path of an entity and measures every stage:
+ * the redundancy layer PDUs of the UDP datagrams in a pcap or pcapng file are decoded with
+ * bytesToRastaRedundancyPacket(), passed to rasta_red_f_receive() and processed by the receive handler of the SR layer.
+ * The entity is set up from its config file and answers to a simulated peer on the loopback interface, so nothing is
+ * sent to the hosts in the capture. Only the PDUs addressed to the RASTA_ID of the config are replayed.
+ * The event loop does not run, so heartbeats, connection timeouts and defer queue timeouts do not fire.
+ * Usage: rasta_replay <config file> <capture file> [fast|original]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <rasta_lib.h>
+#include <rasta_new.h>
+#include <rastamodule.h>
+#include <rastametrics.h>
+
+#define PCAP_MAGIC_MICROSECONDS 0xA1B2C3D4
+#define PCAP_MAGIC_NANOSECONDS 0xA1B23C4D
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_INTERFACE_DESCRIPTION 1
+#define PCAPNG_SIMPLE_PACKET 3
+#define PCAPNG_ENHANCED_PACKET 6
+#define PCAPNG_OPTION_TSRESOL 9
+
+/**
+ * the link types of the frames that are understood
+ */
+#define LINKTYPE_NULL 0
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_LINUX_SLL 113
+#define LINKTYPE_IPV4 228
+#define LINKTYPE_LINUX_SLL2 276
+
+/**
+ * amount of interfaces of a pcapng section that are distinguished
+ */
+#define MAX_INTERFACES 64
+
+/**
+ * amount of transport channels of the replayed entity and of destination ports in the capture that are distinguished
+ */
+#define MAX_TRANSPORT_CHANNELS RASTA_METRICS_MAX_TRANSPORT_CHANNELS
+
+/**
+ * a UDP datagram of the capture, the payload points into the loaded file
+ */
+struct capture_datagram {
+    uint64_t timestamp_ns;
+    uint16_t destination_port;
+    const unsigned char * payload;
+    unsigned int length;
+};
+
+struct capture {
+    unsigned char * file;
+    size_t file_size;
+
+    struct capture_datagram * datagrams;
+    unsigned int count;
+    unsigned int capacity;
+
+    /**
+     * all frames of the capture and the ones that are no complete IPv4 UDP datagrams
+     */
+    unsigned long frames;
+    unsigned long skipped;
+};
+
+/**
+ * the interfaces of a pcapng section
+ */
+struct capture_interfaces {
+    unsigned int count;
+    uint16_t link_types[MAX_INTERFACES];
+    uint64_t units_per_second[MAX_INTERFACES];
+};
+
+/**
+ * the time a stage of the receive path took per PDU
+ */
+struct replay_stage {
+    const char * name;
+    struct rasta_histogram latency;
+    uint64_t total_ns;
+    unsigned long pdus;
+};
+
+/**
+ * the transport channels of the remote entities: the answers of the replayed entity are sent to these sockets and
+ * counted
+ */
+struct simulated_peer {
+    unsigned int count;
+    int sockets[MAX_TRANSPORT_CHANNELS];
+    struct RastaIPData channels[MAX_TRANSPORT_CHANNELS];
+    unsigned long received;
+};
+
+static unsigned long delivered_messages = 0;
+
+static uint64_t get_walltime() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+static uint16_t read16(const unsigned char * bytes, int swapped) {
+    return swapped ? (uint16_t) (bytes[0] << 8 | bytes[1]) : (uint16_t) (bytes[1] << 8 | bytes[0]);
+}
+
+static uint32_t read32(const unsigned char * bytes, int swapped) {
+    if (swapped) {
+        return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 | (uint32_t) bytes[2] << 8 | bytes[3];
+    }
+    return (uint32_t) bytes[3] << 24 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[1] << 8 | bytes[0];
+}
+
+static uint16_t read16_network(const unsigned char * bytes) {
+    return (uint16_t) (bytes[0] << 8 | bytes[1]);
+}
+
+/**
+ * adds the UDP datagram in a frame to the capture, other frames are counted as skipped
+ * @param cap the capture
+ * @param link_type the link type of the interface the frame was captured on
+ * @param frame the captured bytes of the frame
+ * @param length the amount of captured bytes
+ * @param timestamp_ns the time the frame was captured
+ */
+static void add_frame(struct capture * cap, uint32_t link_type, const unsigned char * frame, unsigned int length,
+                      uint64_t timestamp_ns) {
+    cap->frames++;
+
+    // find the IPv4 header
+    unsigned int offset;
+    uint16_t ethertype = 0x0800;
+    switch (link_type) {
+        case LINKTYPE_NULL:
+            // the address family in the byte order of the capturing host
+            offset = 4;
+            if (length < offset || (read32(frame, 0) != AF_INET && read32(frame, 1) != AF_INET)) {
+                ethertype = 0;
+            }
+            break;
+        case LINKTYPE_ETHERNET:
+            offset = 14;
+            if (length < offset) {
+                ethertype = 0;
+                break;
+            }
+            ethertype = read16_network(&frame[12]);
+            while ((ethertype == 0x8100 || ethertype == 0x88A8) && length >= offset + 4) {
+                ethertype = read16_network(&frame[offset + 2]);
+                offset += 4;
+            }
+            break;
+        case LINKTYPE_LINUX_SLL:
+            offset = 16;
+            ethertype = length < offset ? 0 : read16_network(&frame[14]);
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            offset = 20;
+            ethertype = length < offset ? 0 : read16_network(&frame[0]);
+            break;
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+            offset = 0;
+            break;
+        default:
+            ethertype = 0;
+            offset = 0;
+            break;
+    }
+
+    if (ethertype != 0x0800 || length < offset + 20 || (frame[offset] >> 4) != 4) {
+        cap->skipped++;
+        return;
+    }
+
+    const unsigned char * ip = &frame[offset];
+    unsigned int ip_header_length = (unsigned int) (ip[0] & 0x0F) * 4;
+    unsigned int ip_length = read16_network(&ip[2]);
+    uint16_t fragment = read16_network(&ip[6]);
+    // fragments of larger datagrams are not reassembled
+    if (ip[9] != IPPROTO_UDP || (fragment & 0x3FFF) != 0 || ip_header_length < 20 ||
+        ip_length > length - offset || ip_length < ip_header_length + 8) {
+        cap->skipped++;
+        return;
+    }
+
+    const unsigned char * udp = &ip[ip_header_length];
+    unsigned int udp_length = read16_network(&udp[4]);
+    if (udp_length < 8 || udp_length > ip_length - ip_header_length) {
+        cap->skipped++;
+        return;
+    }
+
+    if (cap->count == cap->capacity) {
+        cap->capacity = cap->capacity ? 2 * cap->capacity : 1024;
+        cap->datagrams = realloc(cap->datagrams, cap->capacity * sizeof(struct capture_datagram));
+        if (cap->datagrams == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    struct capture_datagram * datagram = &cap->datagrams[cap->count++];
+    datagram->timestamp_ns = timestamp_ns;
+    datagram->destination_port = read16_network(&udp[2]);
+    datagram->payload = &udp[8];
+    datagram->length = udp_length - 8;
+}
+
+/**
+ * reads the frames of a classic pcap file
+ * @return 1 on success, 0 if the file is malformed
+ */
+static int parse_pcap(struct capture * cap) {
+    if (cap->file_size < 24) {
+        return 0;
+    }
+
+    uint32_t magic = read32(cap->file, 0);
+    int swapped = 0;
+    if (magic != PCAP_MAGIC_MICROSECONDS && magic != PCAP_MAGIC_NANOSECONDS) {
+        swapped = 1;
+        magic = read32(cap->file, 1);
+        if (magic != PCAP_MAGIC_MICROSECONDS && magic != PCAP_MAGIC_NANOSECONDS) {
+            return 0;
+        }
+    }
+    uint64_t ns_per_unit = magic == PCAP_MAGIC_NANOSECONDS ? 1 : 1000;
+    uint32_t link_type = read32(&cap->file[20], swapped) & 0x0FFFFFFF;
+
+    size_t position = 24;
+    while (position + 16 <= cap->file_size) {
+        const unsigned char * record = &cap->file[position];
+        uint64_t seconds = read32(record, swapped);
+        uint64_t fraction = read32(&record[4], swapped);
+        uint32_t captured = read32(&record[8], swapped);
+        if (captured > cap->file_size - position - 16) {
+            return 0;
+        }
+
+        add_frame(cap, link_type, &record[16], captured, seconds * 1000000000 + fraction * ns_per_unit);
+        position += 16 + captured;
+    }
+    return 1;
+}
+
+/**
+ * reads the resolution of the timestamps from the options of an interface description block
+ * @param options the options
+ * @param length the amount of bytes of the options
+ * @param swapped 1 if the section is in the other byte order
+ * @return the units of a timestamp per second
+ */
+static uint64_t pcapng_units_per_second(const unsigned char * options, size_t length, int swapped) {
+    size_t position = 0;
+    while (position + 4 <= length) {
+        uint16_t code = read16(&options[position], swapped);
+        uint16_t option_length = read16(&options[position + 2], swapped);
+        if (code == 0 || position + 4 + option_length > length) {
+            break;
+        }
+        if (code == PCAPNG_OPTION_TSRESOL && option_length >= 1) {
+            unsigned char resolution = options[position + 4];
+            unsigned int exponent = resolution & 0x7F;
+            uint64_t base = (resolution & 0x80) ? 2 : 10;
+            uint64_t units = 1;
+            for (unsigned int i = 0; i < exponent && units < 1000000000000ULL; i++) {
+                units *= base;
+            }
+            return units;
+        }
+        position += 4 + ((option_length + 3u) & ~3u);
+    }
+    return 1000000;
+}
+
+/**
+ * reads the frames of a pcapng file
+ * @return 1 on success, 0 if the file is malformed
+ */
+static int parse_pcapng(struct capture * cap) {
+    struct capture_interfaces interfaces;
+    interfaces.count = 0;
+    int swapped = 0;
+
+    size_t position = 0;
+    while (position + 12 <= cap->file_size) {
+        const unsigned char * block = &cap->file[position];
+        uint32_t type = read32(block, 0);
+        if (type == PCAPNG_SECTION_HEADER) {
+            // every section has its own byte order and interfaces
+            swapped = read32(&block[8], 0) != PCAPNG_BYTE_ORDER_MAGIC;
+            interfaces.count = 0;
+        } else {
+            type = read32(block, swapped);
+        }
+
+        uint32_t length = read32(&block[4], swapped);
+        if (length < 12 || length > cap->file_size - position) {
+            return 0;
+        }
+        const unsigned char * body = &block[8];
+        size_t body_length = length - 12;
+
+        if (type == PCAPNG_INTERFACE_DESCRIPTION && body_length >= 8) {
+            if (interfaces.count < MAX_INTERFACES) {
+                interfaces.link_types[interfaces.count] = read16(body, swapped);
+                interfaces.units_per_second[interfaces.count] = pcapng_units_per_second(&body[8], body_length - 8,
+                                                                                        swapped);
+                interfaces.count++;
+            }
+        } else if (type == PCAPNG_ENHANCED_PACKET && body_length >= 20) {
+            uint32_t interface = read32(body, swapped);
+            uint64_t timestamp = (uint64_t) read32(&body[4], swapped) << 32 | read32(&body[8], swapped);
+            uint32_t captured = read32(&body[12], swapped);
+            if (captured > body_length - 20) {
+                return 0;
+            }
+            if (interface < interfaces.count) {
+                uint64_t units = interfaces.units_per_second[interface];
+                uint64_t timestamp_ns = (uint64_t) ((long double) timestamp * 1000000000.0L / (long double) units);
+                add_frame(cap, interfaces.link_types[interface], &body[20], captured, timestamp_ns);
+            } else {
+                cap->frames++;
+                cap->skipped++;
+            }
+        } else if (type == PCAPNG_SIMPLE_PACKET && body_length >= 4 && interfaces.count > 0) {
+            // simple packets have no timestamp and belong to the first interface
+            uint32_t captured = read32(body, swapped);
+            if (captured > body_length - 4) {
+                captured = (uint32_t) body_length - 4;
+            }
+            add_frame(cap, interfaces.link_types[0], &body[4], captured, 0);
+        }
+
+        position += length;
+    }
+    return 1;
+}
+
+/**
+ * loads a pcap or pcapng file and collects its UDP datagrams
+ * @param cap the capture
+ * @param path the path of the file
+ * @return 1 on success, 0 if the file is no capture or malformed
+ */
+static int load_capture(struct capture * cap, const char * path) {
+    memset(cap, 0, sizeof(struct capture));
+
+    FILE * in = fopen(path, "rb");
+    if (in == NULL) {
+        perror("fopen");
+        exit(1);
+    }
+    if (fseek(in, 0, SEEK_END) != 0) {
+        perror("fseek");
+        exit(1);
+    }
+    long size = ftell(in);
+    rewind(in);
+    if (size < 4) {
+        fclose(in);
+        return 0;
+    }
+
+    cap->file_size = (size_t) size;
+    cap->file = malloc(cap->file_size);
+    if (cap->file == NULL || fread(cap->file, 1, cap->file_size, in) != cap->file_size) {
+        perror("fread");
+        exit(1);
+    }
+    fclose(in);
+
+    if (read32(cap->file, 0) == PCAPNG_SECTION_HEADER) {
+        return parse_pcapng(cap);
+    }
+    return parse_pcap(cap);
+}
+
+/**
+ * opens a socket on the loopback interface for every transport channel of the replayed entity
+ * @param peer the simulated peer
+ * @param count the amount of transport channels
+ */
+static void simulated_peer_open(struct simulated_peer * peer, unsigned int count) {
+    peer->count = count;
+    peer->received = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        peer->sockets[i] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (peer->sockets[i] == -1) {
+            perror("socket");
+            exit(1);
+        }
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t address_length = sizeof(address);
+        if (bind(peer->sockets[i], (struct sockaddr *) &address, sizeof(address)) == -1 ||
+            getsockname(peer->sockets[i], (struct sockaddr *) &address, &address_length) == -1) {
+            perror("bind");
+            exit(1);
+        }
+
+        strcpy(peer->channels[i].ip, "127.0.0.1");
+        peer->channels[i].port = ntohs(address.sin_port);
+    }
+}
+
+/**
+ * counts and discards the PDUs the replayed entity sent to the simulated peer
+ * @param peer the simulated peer
+ */
+static void simulated_peer_drain(struct simulated_peer * peer) {
+    unsigned char buffer[MAX_DEFER_QUEUE_MSG_SIZE];
+    for (unsigned int i = 0; i < peer->count; i++) {
+        while (recv(peer->sockets[i], buffer, sizeof(buffer), 0) >= 0) {
+            peer->received++;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            perror("recv");
+            exit(1);
+        }
+    }
+}
+
+static void simulated_peer_close(struct simulated_peer * peer) {
+    for (unsigned int i = 0; i < peer->count; i++) {
+        close(peer->sockets[i]);
+    }
+}
+
+/**
+ * @param ports the destination ports that were seen, in the order they were seen first
+ * @param port_count the amount of elements in @p ports, increased if @p port is new
+ * @param transport_channel_count the amount of transport channels of the replayed entity
+ * @param port the destination port of a datagram
+ * @return the transport channel the datagram is received on: the transport channels are assigned to the destination
+ * ports in the order they appear in the capture
+ */
+static int transport_channel_of(uint16_t * ports, unsigned int * port_count, unsigned int transport_channel_count,
+                                uint16_t port) {
+    for (unsigned int i = 0; i < *port_count; i++) {
+        if (ports[i] == port) {
+            return (int) (i % transport_channel_count);
+        }
+    }
+    if (*port_count < MAX_TRANSPORT_CHANNELS) {
+        ports[*port_count] = port;
+        (*port_count)++;
+        return (int) ((*port_count - 1) % transport_channel_count);
+    }
+    return 0;
+}
+
+static void stage_record(struct replay_stage * stage, uint64_t duration_ns, unsigned long pdus) {
+    if (pdus == 0) {
+        return;
+    }
+    stage->total_ns += duration_ns;
+    stage->pdus += pdus;
+    for (unsigned long i = 0; i < pdus; i++) {
+        rasta_histogram_record(&stage->latency, (unsigned long) (duration_ns / pdus));
+    }
+}
+
+static void stage_print(const struct replay_stage * stage) {
+    if (stage->pdus == 0) {
+        printf("  %-11s %9u\n", stage->name, 0);
+        return;
+    }
+    printf("  %-11s %9lu %12.0f %8lu %8lu %8lu %8lu\n", stage->name, stage->pdus,
+           stage->total_ns > 0 ? (double) stage->pdus * 1e9 / (double) stage->total_ns : 0.0,
+           rasta_histogram_percentile(&stage->latency, 50), rasta_histogram_percentile(&stage->latency, 99),
+           stage->latency.max, (unsigned long) (stage->total_ns / stage->pdus));
+}
+
+static void* on_con_start(rasta_lib_connection_t connection) {
+    (void) connection;
+    return malloc(sizeof(struct rasta_connection));
+}
+
+static void on_receive(struct rasta_notification_result * result) {
+    rastaApplicationMessage message = sr_get_received_data(result->handle, result->con);
+    freeRastaByteArray(&message.appMessage);
+    delivered_messages++;
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 3 || argc > 4 || (argc == 4 && strcmp(argv[3], "fast") != 0 && strcmp(argv[3], "original") != 0)) {
+        fprintf(stderr, "usage: %s <config file> <capture file> [fast|original]\n", argv[0]);
+        return 1;
+    }
+    int original_timing = argc == 4 && strcmp(argv[3], "original") == 0;
+
+    struct capture cap;
+    if (!load_capture(&cap, argv[2])) {
+        fprintf(stderr, "%s is no pcap or pcapng file or is truncated\n", argv[2]);
+        return 1;
+    }
+
+    rasta_lib_configuration_t rc;
+    rasta_lib_init_configuration(rc, argv[1]);
+    struct rasta_handle * h = &rc->h;
+    rc->callback.on_connection_start = on_con_start;
+    h->notifications.on_receive = on_receive;
+
+    // the receive handler runs without the event loop, the events of the connections are only added to it and the
+    // notifications go to eventfds like in sr_begin()
+    h->ev_sys = &rc->rasta_lib_event_system;
+    h->send_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    h->receive_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (h->send_notify_fd == -1 || h->receive_notify_fd == -1) {
+        perror("Could not create eventfd");
+        exit(1);
+    }
+
+    if (h->mux.port_count == 0 || h->mux.port_count > MAX_TRANSPORT_CHANNELS) {
+        fprintf(stderr, "%s has to configure 1 to %d transport channels\n", argv[1], MAX_TRANSPORT_CHANNELS);
+        return 1;
+    }
+    struct simulated_peer peer;
+    simulated_peer_open(&peer, h->mux.port_count);
+
+    struct replay_stage stages[3];
+    memset(stages, 0, sizeof(stages));
+    stages[0].name = "decode";
+    stages[1].name = "redundancy";
+    stages[2].name = "sr";
+
+    uint16_t ports[MAX_TRANSPORT_CHANNELS];
+    unsigned int port_count = 0;
+    unsigned long malformed = 0, other_receivers = 0;
+    uint32_t own_id = (uint32_t) h->config.values.general.rasta_id;
+
+    uint64_t replay_start = get_walltime();
+    uint64_t first_timestamp = cap.count > 0 ? cap.datagrams[0].timestamp_ns : 0;
+
+    for (unsigned int i = 0; i < cap.count; i++) {
+        const struct capture_datagram * datagram = &cap.datagrams[i];
+
+        if (original_timing && datagram->timestamp_ns > first_timestamp) {
+            uint64_t due = replay_start + (datagram->timestamp_ns - first_timestamp);
+            struct timespec wakeup = { (time_t) (due / 1000000000), (long) (due % 1000000000) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR) {
+            }
+        }
+
+        // the packet takes over a copy of the SR layer PDU, the capture stays untouched
+        struct RastaByteArray data;
+        data.bytes = (unsigned char *) datagram->payload;
+        data.length = datagram->length;
+
+        uint64_t start = get_walltime();
+        struct RastaRedundancyPacket packet = bytesToRastaRedundancyPacket(data, &h->mux.config.redundancy.crc_type,
+                                                                           &h->hashing_context);
+        stage_record(&stages[0], get_walltime() - start, 1);
+
+        if (packet.length == 0) {
+            malformed++;
+            continue;
+        }
+        if (packet.data.receiver_id != own_id) {
+            // sent by the replayed entity itself or to another one
+            other_receivers++;
+            freeRastaByteArray(&packet.data.data);
+            freeRastaByteArray(&packet.data.checksum);
+            continue;
+        }
+
+        int transport_channel = transport_channel_of(ports, &port_count, h->mux.port_count,
+                                                     datagram->destination_port);
+
+        start = get_walltime();
+        rasta_redundancy_channel * channel = redundancy_mux_get_channel(&h->mux, packet.data.sender_id);
+        if (channel == NULL) {
+            // a new remote entity, it is answered by the simulated peer
+            redundancy_mux_add_channel(&h->mux, packet.data.sender_id, peer.channels);
+            channel = redundancy_mux_get_channel(&h->mux, packet.data.sender_id);
+        }
+        rasta_red_f_receive(channel, &packet, transport_channel);
+        stage_record(&stages[1], get_walltime() - start, 1);
+
+        unsigned long processed = h->receive_stats.packets;
+        start = get_walltime();
+        while (redundancy_mux_data_available(&h->mux)) {
+            receive_notification_event(h->receive_handle);
+        }
+        stage_record(&stages[2], get_walltime() - start, h->receive_stats.packets - processed);
+
+        simulated_peer_drain(&peer);
+    }
+    uint64_t replay_time = get_walltime() - replay_start;
+
+    struct rasta_error_counters errors;
+    memset(&errors, 0, sizeof(errors));
+    unsigned long connections = 0, up = 0;
+    for (struct rasta_connection * con = h->first_con; con; con = con->linkedlist_next) {
+        connections++;
+        up += con->current_state == RASTA_CONNECTION_UP;
+        errors.safety += con->errors.safety;
+        errors.address += con->errors.address;
+        errors.type += con->errors.type;
+        errors.sn += con->errors.sn;
+        errors.cs += con->errors.cs;
+    }
+
+    printf("%s: %lu frames, %u UDP datagrams, %lu other frames\n", argv[2], cap.frames, cap.count, cap.skipped);
+    printf("replayed %s in %.3f s: %lu malformed, %lu addressed to other entities than %u\n",
+           original_timing ? "with the original timing" : "as fast as possible", (double) replay_time / 1e9,
+           malformed, other_receivers, own_id);
+    printf("  %-11s %9s %12s %8s %8s %8s %8s\n", "stage", "PDUs", "PDUs/s", "p50 ns", "p99 ns", "max ns", "mean ns");
+    for (unsigned int i = 0; i < 3; i++) {
+        stage_print(&stages[i]);
+    }
+    printf("sr layer: %lu connections, %lu up, %lu application messages delivered\n", connections, up,
+           delivered_messages);
+    printf("  errors: safety %u, address %u, type %u, sn %u, cs %u\n", errors.safety, errors.address, errors.type,
+           errors.sn, errors.cs);
+    printf("simulated peer: %lu PDUs received\n", peer.received);
+
+    struct rasta_connection * con = h->first_con;
+    sr_cleanup(h);
+    simulated_peer_close(&peer);
+    while (con != NULL) {
+        struct rasta_connection * next = con->linkedlist_next;
+        free(con);
+        con = next;
+    }
+    free(cap.datagrams);
+    free(cap.file);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * Prints the metrics an entity publishes to its stat page (see rastastatpage.h), as a table or in the Prometheus text
+ * format. Reading the page takes no time of the entity.
+ * Usage: rasta_stat <stat page> [--prometheus] [--watch=<ms>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <rastastatpage.h>
+
+int main(int argc, char * argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <stat page> [--prometheus] [--watch=<ms>]\n", argv[0]);
+        return 1;
+    }
+
+    int prometheus = 0;
+    long watch_ms = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--prometheus") == 0) {
+            prometheus = 1;
+        } else if (strncmp(argv[i], "--watch=", 8) == 0) {
+            watch_ms = strtol(argv[i] + 8, NULL, 10);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    struct rasta_stat_page * page = rasta_stat_page_open(argv[1]);
+    if (page == NULL) {
+        return 1;
+    }
+
+    struct rasta_stat_header * copy = malloc(page->mapped_size);
+    if (copy == NULL) {
+        perror("malloc");
+        return 1;
+    }
+
+    do {
+        if (!rasta_stat_page_copy(page, copy)) {
+            fprintf(stderr, "the entity kept publishing while the page was read\n");
+            return 1;
+        }
+        if (watch_ms > 0 && !prometheus) {
+            // clears the terminal, like watch
+            fputs("\033[H\033[2J", stdout);
+        }
+        if (prometheus) {
+            rasta_stat_page_write_prometheus(copy, stdout);
+        } else {
+            rasta_stat_page_write_text(copy, stdout);
+        }
+        fflush(stdout);
+
+        if (watch_ms > 0) {
+            struct timespec interval = {.tv_sec = watch_ms / 1000, .tv_nsec = (watch_ms % 1000) * 1000000};
+            nanosleep(&interval, NULL);
+        }
+    } while (watch_ms > 0);
+
+    free(copy);
+    rasta_stat_page_unmap(page);
+    return 0;
+}
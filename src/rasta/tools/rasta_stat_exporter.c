@@ -0,0 +1,150 @@
+/**
+ * Serves the stat page of an entity (see rastastatpage.h) in the Prometheus text format. Runs beside the entity, so a
+ * scrape costs the event loop of the entity nothing, unlike RASTA_METRICS_PORT. Every request reads the page again,
+ * a page that was replaced by a restarted entity is mapped again.
+ * Usage: rasta_stat_exporter <stat page> [--port=<port>]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <rastastatpage.h>
+
+/**
+ * the page and the file it was mapped from
+ */
+struct exporter_page {
+    const char * path;
+    struct rasta_stat_page * page;
+    dev_t device;
+    ino_t inode;
+};
+
+/**
+ * maps the page again if it does not exist yet or was replaced since it was mapped
+ * @param exporter the page
+ */
+static void exporter_refresh(struct exporter_page * exporter) {
+    struct stat file_stat;
+    if (stat(exporter->path, &file_stat) == -1) {
+        return;
+    }
+    if (exporter->page != NULL && file_stat.st_dev == exporter->device && file_stat.st_ino == exporter->inode) {
+        return;
+    }
+    if (exporter->page != NULL) {
+        rasta_stat_page_unmap(exporter->page);
+    }
+    exporter->page = rasta_stat_page_open(exporter->path);
+    exporter->device = file_stat.st_dev;
+    exporter->inode = file_stat.st_ino;
+}
+
+/**
+ * writes the metrics of the page
+ * @param exporter the page
+ * @param out the stream to write to
+ */
+static void exporter_write(struct exporter_page * exporter, FILE * out) {
+    exporter_refresh(exporter);
+
+    struct rasta_stat_header * copy = NULL;
+    if (exporter->page != NULL) {
+        copy = malloc(exporter->page->mapped_size);
+        if (copy != NULL && !rasta_stat_page_copy(exporter->page, copy)) {
+            free(copy);
+            copy = NULL;
+        }
+    }
+
+    fprintf(out, "# TYPE rasta_stat_page_up gauge\n");
+    fprintf(out, "rasta_stat_page_up %d\n", copy != NULL);
+    if (copy != NULL) {
+        rasta_stat_page_write_prometheus(copy, out);
+        free(copy);
+    }
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <stat page> [--port=<port>]\n", argv[0]);
+        return 1;
+    }
+
+    long port = 9101;
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--port=", 7) == 0) {
+            port = strtol(argv[i] + 7, NULL, 10);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (port <= 0 || port > 65535) {
+        fprintf(stderr, "invalid port %ld\n", port);
+        return 1;
+    }
+
+    struct exporter_page exporter = {.path = argv[1], .page = NULL};
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener == -1) {
+        perror("Could not create socket");
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listener, (struct sockaddr *) &address, sizeof(address)) == -1 || listen(listener, 8) == -1) {
+        perror("Could not listen");
+        return 1;
+    }
+
+    for (;;) {
+        int client = accept(listener, NULL, NULL);
+        if (client == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("accept");
+            return 1;
+        }
+
+        // the request is not parsed but has to be read, see the endpoint of the entity
+        char request[1024];
+        struct timeval timeout = {.tv_sec = 0, .tv_usec = 100000};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        recv(client, request, sizeof(request), 0);
+
+        char * body = NULL;
+        size_t body_length = 0;
+        FILE * stream = open_memstream(&body, &body_length);
+        if (stream == NULL) {
+            close(client);
+            continue;
+        }
+        exporter_write(&exporter, stream);
+        fclose(stream);
+
+        char header[128];
+        int header_length = snprintf(header, sizeof(header),
+                                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_length);
+        if (send(client, header, (size_t) header_length, MSG_NOSIGNAL) == header_length) {
+            send(client, body, body_length, MSG_NOSIGNAL);
+        }
+        free(body);
+        close(client);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * Prints the records of a binary trace file (see rastatrace.h) like the text log, oldest first.
+ * Usage: rasta_trace_decode <trace file>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <rastatrace.h>
+
+int main(int argc, char * argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE * in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        perror("fopen");
+        exit(1);
+    }
+
+    struct rasta_trace_header header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != RASTA_TRACE_MAGIC ||
+        header.version != RASTA_TRACE_VERSION || header.record_size != sizeof(struct rasta_trace_record) ||
+        header.capacity == 0) {
+        fprintf(stderr, "%s is not a trace file of this version\n", argv[1]);
+        return 1;
+    }
+
+    struct rasta_trace_record * records = malloc((size_t) header.capacity * sizeof(struct rasta_trace_record));
+    if (records == NULL || fread(records, sizeof(struct rasta_trace_record), header.capacity, in) != header.capacity) {
+        fprintf(stderr, "%s is truncated\n", argv[1]);
+        return 1;
+    }
+    fclose(in);
+
+    // when the ring is full, the oldest record is the one that is overwritten next
+    uint64_t first = header.next > header.capacity ? header.next - header.capacity : 0;
+    unsigned long incomplete = 0;
+    char line[512];
+
+    for (uint64_t position = first; position < header.next; position++) {
+        const struct rasta_trace_record * record = &records[position % header.capacity];
+        if (record->index != (uint32_t) (position + 1)) {
+            // the process stopped while writing it
+            incomplete++;
+            continue;
+        }
+        rasta_trace_render(record, line, sizeof(line));
+        fputs(line, stdout);
+    }
+
+    if (incomplete > 0) {
+        fprintf(stderr, "%lu records were not completely written\n", incomplete);
+    }
+
+    free(records);
+    return 0;
+}
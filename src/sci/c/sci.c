@@ -1,7 +1,10 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
 #include <sci.h>
 #include <memory.h>
 #include <rmemory.h>
 #include <rastafactory.h>
+#include <rasta_new.h>
+#include <sci_name_table.h>
 
 void sci_set_sender(sci_telegram * telegram, char * sender_name){
     size_t name_len = strlen(sender_name);
@@ -29,43 +32,45 @@ void sci_set_message_type(sci_telegram * telegram, unsigned short message_type){
     hostShortTole(message_type, telegram->message_type);
 }
 
-struct RastaByteArray sci_encode_telegram(sci_telegram * telegram){
-    struct RastaByteArray encoded_telegram;
-    allocateRastaByteArray(&encoded_telegram, SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD + telegram->payload.used_bytes);
-
+unsigned int sci_encode_telegram_into(sci_telegram * telegram, unsigned char * buffer){
     // pack the SCI protocol type
-    encoded_telegram.bytes[0] = telegram->protocol_type;
+    buffer[0] = telegram->protocol_type;
 
     // pack the message type
-    rmemcpy(&encoded_telegram.bytes[1], telegram->message_type, 2);
+    rmemcpy(&buffer[1], telegram->message_type, 2);
 
     // pack the sender
-    rmemcpy(&encoded_telegram.bytes[3], telegram->sender, SCI_NAME_LENGTH);
+    rmemcpy(&buffer[3], telegram->sender, SCI_NAME_LENGTH);
 
     // pack the receiver
-    rmemcpy(&encoded_telegram.bytes[23], telegram->receiver, SCI_NAME_LENGTH);
+    rmemcpy(&buffer[23], telegram->receiver, SCI_NAME_LENGTH);
 
     if (telegram->payload.used_bytes > 0){
         // pack the payload
-        rmemcpy(&encoded_telegram.bytes[43], telegram->payload.data, telegram->payload.used_bytes);
+        rmemcpy(&buffer[43], telegram->payload.data, telegram->payload.used_bytes);
     }
 
+    return SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD + telegram->payload.used_bytes;
+}
+
+struct RastaByteArray sci_encode_telegram(sci_telegram * telegram){
+    struct RastaByteArray encoded_telegram;
+    allocateRastaByteArray(&encoded_telegram, SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD + telegram->payload.used_bytes);
+    sci_encode_telegram_into(telegram, encoded_telegram.bytes);
+
     return encoded_telegram;
 }
 
-sci_telegram * sci_decode_telegram(struct RastaByteArray data){
+int sci_decode_telegram_into(struct RastaByteArray data, sci_telegram * telegram){
     if(data.length > SCI_MAX_TELEGRAM_LENGTH || data.length < SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD){
         // size does not match
-        return NULL;
+        return 0;
     }
 
-    sci_telegram * telegram = rmalloc(sizeof(sci_telegram));
-
-
     // check if a valid protocol was provided
     if (!(data.bytes[0] == SCI_PROTOCOL_P || data.bytes[0] == SCI_PROTOCOL_LS)){
         // invalid protocol
-        return NULL;
+        return 0;
     }
 
     // copy the basic data into the telegram
@@ -76,18 +81,162 @@ sci_telegram * sci_decode_telegram(struct RastaByteArray data){
 
     // copy the payload
     unsigned int payload_size = data.length - SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD;
+    telegram->payload.used_bytes = payload_size;
     if (payload_size > 0){
         // the telegram contains a payload
-        sci_payload payload;
-        payload.used_bytes = payload_size;
-        rmemcpy(payload.data, &data.bytes[43], payload_size);
+        rmemcpy(telegram->payload.data, &data.bytes[43], payload_size);
+    }
 
-        telegram->payload = payload;
+    return 1;
+}
+
+sci_telegram * sci_decode_telegram(struct RastaByteArray data){
+    sci_telegram decoded;
+    if (!sci_decode_telegram_into(data, &decoded)){
+        return NULL;
     }
 
+    sci_telegram * telegram = rmalloc(sizeof(sci_telegram));
+    *telegram = decoded;
     return telegram;
 }
 
 unsigned short sci_get_message_type(sci_telegram * telegram){
     return leShortToHost(telegram->message_type);
-}
\ No newline at end of file
+}
+
+void sci_batch_init(sci_batch * batch){
+    batch->open = 0;
+    batch->count = 0;
+}
+
+int sci_batch_add(sci_batch * batch, unsigned long rasta_id, sci_telegram * telegram){
+    if (batch->count == SCI_BATCH_MAX_TELEGRAMS){
+        return 0;
+    }
+
+    batch->rasta_ids[batch->count] = rasta_id;
+    batch->telegrams[batch->count].bytes = batch->buffers[batch->count];
+    batch->telegrams[batch->count].length = sci_encode_telegram_into(telegram, batch->buffers[batch->count]);
+    batch->count++;
+    return 1;
+}
+
+int sci_batch_add_encoded(sci_batch * batch, unsigned long rasta_id, const unsigned char * bytes, unsigned int length){
+    if (batch->count == SCI_BATCH_MAX_TELEGRAMS){
+        return 0;
+    }
+
+    batch->rasta_ids[batch->count] = rasta_id;
+    batch->telegrams[batch->count].bytes = batch->buffers[batch->count];
+    batch->telegrams[batch->count].length = length;
+    rmemcpy(batch->buffers[batch->count], bytes, length);
+    batch->count++;
+    return 1;
+}
+
+void sci_batch_send(sci_batch * batch, struct rasta_handle * handle){
+    unsigned int max_packet = handle->config.values.sending.max_packet;
+    if (max_packet == 0){
+        max_packet = 1;
+    }
+
+    struct RastaByteArray messages[SCI_BATCH_MAX_TELEGRAMS];
+    int sent[SCI_BATCH_MAX_TELEGRAMS] = {0};
+    // every receiver gets at least one telegram per call, so there are never more calls than telegrams
+    unsigned long rasta_ids[SCI_BATCH_MAX_TELEGRAMS];
+    struct RastaMessageData calls[SCI_BATCH_MAX_TELEGRAMS];
+    unsigned int call_count = 0;
+    unsigned int message_count = 0;
+
+    // the telegrams of the first receiver that is left are sent together, then those of the next one
+    for (unsigned int first = 0; first < batch->count; first++){
+        if (sent[first]){
+            continue;
+        }
+
+        unsigned long rasta_id = batch->rasta_ids[first];
+        unsigned int start = message_count;
+        for (unsigned int i = first; i < batch->count; i++){
+            if (sent[i] || batch->rasta_ids[i] != rasta_id){
+                continue;
+            }
+            messages[message_count++] = batch->telegrams[i];
+            sent[i] = 1;
+        }
+
+        // a single call may not pass more messages than fit into one data PDU
+        for (unsigned int offset = start; offset < message_count; offset += max_packet){
+            rasta_ids[call_count] = rasta_id;
+            calls[call_count].count = message_count - offset < max_packet ? message_count - offset : max_packet;
+            calls[call_count].data_array = &messages[offset];
+            call_count++;
+        }
+    }
+
+    // the send handler is woken up once for all receivers
+    sr_send_batch(handle, rasta_ids, calls, call_count);
+    sci_batch_free(batch);
+}
+
+void sci_batch_free(sci_batch * batch){
+    // the telegrams are stored in the buffers of the batch
+    batch->count = 0;
+}
+
+sci_return_code sci_broadcast_telegram(struct rasta_handle * handle, const struct sci_name_table * names,
+                                       sci_batch * batch, sci_telegram * telegram, char ** receivers,
+                                       unsigned int count){
+    unsigned char encoded[SCI_MAX_TELEGRAM_LENGTH];
+    unsigned int length = sci_encode_telegram_into(telegram, encoded);
+    rfree(telegram);
+
+    sci_return_code result = SUCCESS;
+    unsigned char buffers[SCI_BATCH_MAX_TELEGRAMS][SCI_MAX_TELEGRAM_LENGTH];
+    struct RastaByteArray telegrams[SCI_BATCH_MAX_TELEGRAMS];
+    struct RastaMessageData calls[SCI_BATCH_MAX_TELEGRAMS];
+    unsigned long rasta_ids[SCI_BATCH_MAX_TELEGRAMS];
+    unsigned int pending = 0;
+
+    for (unsigned int i = 0; i < count; i++){
+        // only the receiver differs, the padded name is the key of the table
+        unsigned char * buffer = buffers[pending];
+        rmemcpy(buffer, encoded, length);
+        size_t name_len = strlen(receivers[i]);
+        rmemset(&buffer[23], SCI_NAME_PADDING_CHAR, SCI_NAME_LENGTH);
+        rmemcpy(&buffer[23], receivers[i], (unsigned int) (name_len < SCI_NAME_LENGTH ? name_len : SCI_NAME_LENGTH));
+
+        sci_name_handle name = sci_name_table_find(names, (const char *) &buffer[23]);
+        if (name == SCI_NAME_HANDLE_UNKNOWN){
+            result = UNKNOWN_SCI_NAME;
+            continue;
+        }
+        unsigned long rasta_id = sci_name_table_rasta_id(names, name);
+
+        if (batch->open){
+            // the telegrams are sent with the others when the batch ends, a full batch is sent right away
+            if (!sci_batch_add_encoded(batch, rasta_id, buffer, length)){
+                sci_batch_send(batch, handle);
+                sci_batch_add_encoded(batch, rasta_id, buffer, length);
+            }
+            continue;
+        }
+
+        telegrams[pending].bytes = buffer;
+        telegrams[pending].length = length;
+        calls[pending].count = 1;
+        calls[pending].data_array = &telegrams[pending];
+        rasta_ids[pending] = rasta_id;
+        pending++;
+
+        if (pending == SCI_BATCH_MAX_TELEGRAMS){
+            sr_send_batch(handle, rasta_ids, calls, pending);
+            pending = 0;
+        }
+    }
+
+    if (pending > 0){
+        sr_send_batch(handle, rasta_ids, calls, pending);
+    }
+    return result;
+}
@@ -0,0 +1,114 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
+#include <sci_name_table.h>
+#include <rmemory.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * amount of slots of a new table
+ */
+#define NAME_TABLE_INITIAL_CAPACITY 32
+
+/**
+ * hashes a padded SCI name. The name is read as two 8 byte and one 4 byte word, which are mixed like in MurmurHash3
+ * @param name the name, SCI_NAME_LENGTH bytes
+ * @return the hash
+ */
+static uint64_t name_hash(const char * name) {
+    uint64_t a, b;
+    uint32_t c;
+    memcpy(&a, name, sizeof(a));
+    memcpy(&b, name + 8, sizeof(b));
+    memcpy(&c, name + 16, sizeof(c));
+
+    uint64_t hash = a * 0x9E3779B97F4A7C15ULL;
+    hash ^= (b ^ (hash >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    hash ^= (c ^ (hash >> 32)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * finds the slot of a name
+ * @param table the table
+ * @param name the name
+ * @return the slot of the name or the free slot where it would be inserted
+ */
+static unsigned int name_table_find_slot(const struct sci_name_table * table, const char * name) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int slot = (unsigned int) (name_hash(name) & mask);
+    while (table->slots[slot] != 0 &&
+           memcmp(table->entries[table->slots[slot] - 1].name, name, SCI_NAME_LENGTH) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * allocates free slots and puts all registered names into them again
+ * @param table the table
+ * @param capacity the amount of slots, has to be a power of two
+ */
+static void name_table_rehash(struct sci_name_table * table, unsigned int capacity) {
+    rfree(table->slots);
+    table->slots = rmalloc(capacity * sizeof(unsigned int));
+    rmemset(table->slots, 0, capacity * sizeof(unsigned int));
+    table->capacity = capacity;
+
+    for (unsigned int i = 0; i < table->count; ++i) {
+        table->slots[name_table_find_slot(table, table->entries[i].name)] = i + 1;
+    }
+}
+
+void sci_name_table_init(struct sci_name_table * table) {
+    table->entries = NULL;
+    table->count = 0;
+    table->entries_capacity = 0;
+    table->slots = NULL;
+    name_table_rehash(table, NAME_TABLE_INITIAL_CAPACITY);
+}
+
+void sci_name_table_free(struct sci_name_table * table) {
+    rfree(table->entries);
+    rfree(table->slots);
+    table->entries = NULL;
+    table->slots = NULL;
+    table->count = 0;
+    table->entries_capacity = 0;
+    table->capacity = 0;
+}
+
+sci_name_handle sci_name_table_put(struct sci_name_table * table, const char * name, unsigned long rasta_id) {
+    sci_name_handle handle = sci_name_table_find(table, name);
+    if (handle != SCI_NAME_HANDLE_UNKNOWN) {
+        return handle;
+    }
+
+    if (table->count == table->entries_capacity) {
+        table->entries_capacity = table->entries_capacity == 0 ? 8 : 2 * table->entries_capacity;
+        table->entries = rrealloc(table->entries, table->entries_capacity * sizeof(struct sci_name_table_entry));
+    }
+
+    // keep the load factor at most 1/2, so probe sequences stay short
+    if (2 * (table->count + 1) > table->capacity) {
+        name_table_rehash(table, 2 * table->capacity);
+    }
+
+    handle = (sci_name_handle) table->count;
+    rmemcpy(table->entries[handle].name, name, SCI_NAME_LENGTH);
+    table->entries[handle].rasta_id = rasta_id;
+    table->slots[name_table_find_slot(table, name)] = (unsigned int) handle + 1;
+    table->count++;
+    return handle;
+}
+
+sci_name_handle sci_name_table_find(const struct sci_name_table * table, const char * name) {
+    if (table->capacity == 0) {
+        return SCI_NAME_HANDLE_UNKNOWN;
+    }
+
+    unsigned int slot = name_table_find_slot(table, name);
+    return table->slots[slot] == 0 ? SCI_NAME_HANDLE_UNKNOWN : (sci_name_handle) (table->slots[slot] - 1);
+}
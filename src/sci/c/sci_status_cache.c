@@ -0,0 +1,107 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
+#include <sci_status_cache.h>
+#include <rmemory.h>
+#include <string.h>
+
+/**
+ * amount of receivers a cache has entries for when the first status is stored
+ */
+#define STATUS_CACHE_INITIAL_RECEIVERS 16
+
+void sci_status_cache_init(sci_status_cache * cache){
+    cache->enabled = 0;
+    cache->max_refresh_ms = 0;
+    cache->entries = NULL;
+    cache->receiver_capacity = 0;
+    cache->suppressed = 0;
+}
+
+void sci_status_cache_free(sci_status_cache * cache){
+    rfree(cache->entries);
+    sci_status_cache_init(cache);
+}
+
+void sci_status_cache_enable(sci_status_cache * cache, unsigned int max_refresh_ms){
+    cache->enabled = 1;
+    cache->max_refresh_ms = max_refresh_ms;
+    if (cache->entries != NULL){
+        rmemset(cache->entries, 0,
+                (unsigned int) (cache->receiver_capacity * SCI_STATUS_CACHE_SLOTS * sizeof(struct sci_status_cache_entry)));
+    }
+}
+
+void sci_status_cache_disable(sci_status_cache * cache){
+    cache->enabled = 0;
+}
+
+/**
+ * getter for the entry of a receiver and a kind of status
+ * @param cache the cache
+ * @param receiver the handle of the receiver
+ * @param slot the kind of status
+ * @return the entry, NULL if there is none for the receiver yet
+ */
+static struct sci_status_cache_entry * status_cache_entry(const sci_status_cache * cache, sci_name_handle receiver,
+                                                          unsigned int slot){
+    if (receiver < 0 || (unsigned int) receiver >= cache->receiver_capacity){
+        return NULL;
+    }
+    return &cache->entries[(unsigned int) receiver * SCI_STATUS_CACHE_SLOTS + slot];
+}
+
+int sci_status_cache_suppress(sci_status_cache * cache, sci_name_handle receiver, unsigned int slot,
+                              const sci_payload * payload, uint32_t now){
+    if (!cache->enabled){
+        return 0;
+    }
+
+    struct sci_status_cache_entry * entry = status_cache_entry(cache, receiver, slot);
+    if (entry == NULL || !entry->valid){
+        return 0;
+    }
+    if (cache->max_refresh_ms > 0 && now - entry->sent_at >= cache->max_refresh_ms){
+        return 0;
+    }
+    if (entry->payload.used_bytes != payload->used_bytes ||
+        memcmp(entry->payload.data, payload->data, payload->used_bytes) != 0){
+        return 0;
+    }
+
+    cache->suppressed++;
+    return 1;
+}
+
+void sci_status_cache_store(sci_status_cache * cache, sci_name_handle receiver, unsigned int slot,
+                            const sci_payload * payload, uint32_t now){
+    if (!cache->enabled || receiver < 0){
+        return;
+    }
+
+    if ((unsigned int) receiver >= cache->receiver_capacity){
+        // the handles are small and dense, the entries grow like the ones of the name table
+        unsigned int capacity = cache->receiver_capacity > 0 ? cache->receiver_capacity : STATUS_CACHE_INITIAL_RECEIVERS;
+        while (capacity <= (unsigned int) receiver){
+            capacity *= 2;
+        }
+        size_t entry_size = SCI_STATUS_CACHE_SLOTS * sizeof(struct sci_status_cache_entry);
+        cache->entries = rrealloc(cache->entries, (unsigned int) (capacity * entry_size));
+        rmemset((unsigned char *) cache->entries + cache->receiver_capacity * entry_size, 0,
+                (unsigned int) ((capacity - cache->receiver_capacity) * entry_size));
+        cache->receiver_capacity = capacity;
+    }
+
+    struct sci_status_cache_entry * entry = status_cache_entry(cache, receiver, slot);
+    entry->valid = 1;
+    entry->sent_at = now;
+    entry->payload.used_bytes = payload->used_bytes;
+    rmemcpy(entry->payload.data, payload->data, payload->used_bytes);
+}
+
+void sci_status_cache_refresh(sci_status_cache * cache, sci_name_handle receiver){
+    for (unsigned int slot = 0; slot < SCI_STATUS_CACHE_SLOTS; slot++){
+        struct sci_status_cache_entry * entry = status_cache_entry(cache, receiver, slot);
+        if (entry != NULL){
+            entry->valid = 0;
+        }
+    }
+}
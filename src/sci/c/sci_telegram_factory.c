@@ -1,3 +1,4 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
 #include <sci_telegram_factory.h>
 #include <rmemory.h>
 #include <sci.h>
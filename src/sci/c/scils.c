@@ -1,3 +1,4 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
 #include <scils.h>
 #include <rmemory.h>
 #include <memory.h>
@@ -5,45 +6,111 @@
 #include <rasta_new.h>
 #include <sci.h>
 
+/**
+ * the kinds of status telegrams of the status cache
+ */
+#define SCILS_STATUS_SIGNAL_ASPECT 0
+#define SCILS_STATUS_BRIGHTNESS 1
+
 /**
  * Tries to send a SCI telegram to the receiver using the underlying RaSTA instance
  * @param ls the SCI-LS instance
- * @param telegram the telegram to send
+ * @param telegram the telegram to send, it is freed afterwards
+ * @param queued set to 1 if RaSTA took the telegram or it was added to the batch, 0 otherwise
  * @return 0 if success, error code otherwise
  */
-sci_return_code scils_send_telegram(scils_t * ls, sci_telegram * telegram){
-    struct RastaByteArray data = sci_encode_telegram(telegram);
-
-    char * sci_name = sci_get_name_string(telegram->receiver);
-
-    unsigned long rastaId;
-    int res = hashmap_get(ls->sciNamesToRastaIds, sci_name, (void **) &rastaId);
-    rfree(sci_name);
-
-    if (res == MAP_MISSING){
+static sci_return_code scils_transmit_telegram(scils_t * ls, sci_telegram * telegram, int * queued){
+    *queued = 0;
+    // the padded name of the telegram is the key, so the lookup does not allocate
+    sci_name_handle handle = sci_name_table_find(&ls->sciNamesToRastaIds, telegram->receiver);
+    if (handle == SCI_NAME_HANDLE_UNKNOWN){
         // SCI name not in map
+        rfree(telegram);
         return UNKNOWN_SCI_NAME;
     }
+    unsigned long rastaId = sci_name_table_rasta_id(&ls->sciNamesToRastaIds, handle);
 
-    struct RastaMessageData messageData;
-    allocateRastaMessageData(&messageData, 1);
-    messageData.data_array[0] = data;
+    if (ls->batch.open){
+        // the telegram is sent with the others when the batch ends, a full batch is sent right away
+        if (!sci_batch_add(&ls->batch, rastaId, telegram)){
+            sci_batch_send(&ls->batch, ls->rasta_handle);
+            sci_batch_add(&ls->batch, rastaId, telegram);
+        }
+        rfree(telegram);
+        *queued = 1;
+        return SUCCESS;
+    }
 
-    sr_send(ls->rasta_handle, rastaId, messageData);
+    // sr_send copies the message, so the telegram is encoded on the stack
+    unsigned char buffer[SCI_MAX_TELEGRAM_LENGTH];
+    struct RastaByteArray data;
+    data.bytes = buffer;
+    data.length = sci_encode_telegram_into(telegram, buffer);
+    rfree(telegram);
+
+    struct RastaMessageData messageData;
+    messageData.count = 1;
+    messageData.data_array = &data;
 
-    freeRastaMessageData(&messageData);
+    *queued = sr_send(ls->rasta_handle, rastaId, messageData);
     return SUCCESS;
 }
 
+/**
+ * Tries to send a SCI telegram to the receiver using the underlying RaSTA instance
+ * @param ls the SCI-LS instance
+ * @param telegram the telegram to send, it is freed afterwards
+ * @return 0 if success, error code otherwise
+ */
+sci_return_code scils_send_telegram(scils_t * ls, sci_telegram * telegram){
+    int queued;
+    return scils_transmit_telegram(ls, telegram, &queued);
+}
+
+/**
+ * Sends a status telegram unless the receiver has the status already, see scils_enable_status_cache()
+ * @param ls the SCI-LS instance
+ * @param telegram the status telegram, it is freed afterwards
+ * @param slot the kind of status
+ * @return 0 if success, error code otherwise
+ */
+static sci_return_code scils_send_status_telegram(scils_t * ls, sci_telegram * telegram, unsigned int slot){
+    if (!ls->status_cache.enabled){
+        return scils_send_telegram(ls, telegram);
+    }
+
+    sci_name_handle receiver = sci_name_table_find(&ls->sciNamesToRastaIds, telegram->receiver);
+    uint32_t now = current_ts();
+    if (sci_status_cache_suppress(&ls->status_cache, receiver, slot, &telegram->payload, now)){
+        rfree(telegram);
+        return SUCCESS;
+    }
+
+    // the telegram is freed when it is sent
+    sci_payload payload = telegram->payload;
+    int queued;
+    sci_return_code result = scils_transmit_telegram(ls, telegram, &queued);
+    if (queued){
+        sci_status_cache_store(&ls->status_cache, receiver, slot, &payload, now);
+    }
+    return result;
+}
+
 scils_t * scils_init(struct rasta_handle * handle, char * sciName){
     scils_t * scils = rmalloc(sizeof(scils_t));
 
     scils->rasta_handle = handle;
-    scils->sciName = rmalloc((unsigned int)strlen(sciName));
+    scils->sciName = rmalloc((unsigned int)strlen(sciName) + 1);
     strcpy(scils->sciName, sciName);
 
     // initialize map
-    scils->sciNamesToRastaIds = hashmap_new();
+    sci_name_table_init(&scils->sciNamesToRastaIds);
+
+    // telegrams are sent right away until a batch begins
+    sci_batch_init(&scils->batch);
+
+    // all status telegrams are sent until the cache is enabled
+    sci_status_cache_init(&scils->status_cache);
 
     // initialize notifications to NULL
     scils->notifications.on_status_begin_received = NULL;
@@ -60,11 +127,30 @@ scils_t * scils_init(struct rasta_handle * handle, char * sciName){
 }
 
 void scils_cleanup(scils_t * ls){
-    hashmap_free(ls->sciNamesToRastaIds);
+    sci_batch_free(&ls->batch);
+    sci_status_cache_free(&ls->status_cache);
+    sci_name_table_free(&ls->sciNamesToRastaIds);
     rfree(ls->sciName);
     rfree(ls);
 }
 
+void scils_begin_batch(scils_t * ls){
+    ls->batch.open = 1;
+}
+
+void scils_end_batch(scils_t * ls){
+    sci_batch_send(&ls->batch, ls->rasta_handle);
+    ls->batch.open = 0;
+}
+
+void scils_enable_status_cache(scils_t * ls, unsigned int max_refresh_ms){
+    sci_status_cache_enable(&ls->status_cache, max_refresh_ms);
+}
+
+void scils_disable_status_cache(scils_t * ls){
+    sci_status_cache_disable(&ls->status_cache);
+}
+
 sci_return_code scils_send_version_request(scils_t *ls, char *receiver, unsigned char estw_version){
     sci_telegram * telegram = sci_create_version_request(SCI_PROTOCOL_LS, ls->sciName, receiver, estw_version);
 
@@ -89,6 +175,8 @@ sci_return_code scils_send_status_request(scils_t *ls, char *receiver){
 sci_return_code scils_send_status_begin(scils_t *ls, char *receiver){
     sci_telegram * telegram = sci_create_status_begin(SCI_PROTOCOL_LS, ls->sciName, receiver);
 
+    // the status report that begins has to contain every status
+    sci_status_cache_refresh(&ls->status_cache, sci_name_table_find(&ls->sciNamesToRastaIds, telegram->receiver));
     return scils_send_telegram(ls, telegram);
 }
 
@@ -107,7 +195,7 @@ sci_return_code scils_send_show_signal_aspect(scils_t * ls, char * receiver, sci
 sci_return_code scils_send_signal_aspect_status(scils_t * ls, char * receiver, scils_signal_aspect signal_aspect){
     sci_telegram * telegram = scils_create_signal_aspect_status(ls->sciName, receiver, signal_aspect);
 
-    return scils_send_telegram(ls, telegram);
+    return scils_send_status_telegram(ls, telegram, SCILS_STATUS_SIGNAL_ASPECT);
 }
 
 sci_return_code scils_send_change_brightness(scils_t * ls, char * receiver, scils_brightness brightness){
@@ -116,10 +204,30 @@ sci_return_code scils_send_change_brightness(scils_t * ls, char * receiver, scil
     return scils_send_telegram(ls, telegram);
 }
 
+sci_return_code scils_broadcast_status_request(scils_t * ls, char ** receivers, unsigned int count){
+    sci_telegram * telegram = sci_create_status_request(SCI_PROTOCOL_LS, ls->sciName, "");
+
+    return sci_broadcast_telegram(ls->rasta_handle, &ls->sciNamesToRastaIds, &ls->batch, telegram, receivers, count);
+}
+
+sci_return_code scils_broadcast_show_signal_aspect(scils_t * ls, char ** receivers, unsigned int count,
+                                                   scils_signal_aspect signal_aspect){
+    sci_telegram * telegram = scils_create_show_signal_aspect(ls->sciName, "", signal_aspect);
+
+    return sci_broadcast_telegram(ls->rasta_handle, &ls->sciNamesToRastaIds, &ls->batch, telegram, receivers, count);
+}
+
+sci_return_code scils_broadcast_change_brightness(scils_t * ls, char ** receivers, unsigned int count,
+                                                  scils_brightness brightness){
+    sci_telegram * telegram = scils_create_change_brightness(ls->sciName, "", brightness);
+
+    return sci_broadcast_telegram(ls->rasta_handle, &ls->sciNamesToRastaIds, &ls->batch, telegram, receivers, count);
+}
+
 sci_return_code scils_send_brightness_status(scils_t * ls, char * receiver, scils_brightness brightness){
     sci_telegram * telegram = scils_create_brightness_status(ls->sciName, receiver, brightness);
 
-    return scils_send_telegram(ls, telegram);
+    return scils_send_status_telegram(ls, telegram, SCILS_STATUS_BRIGHTNESS);
 }
 
 /**
@@ -228,20 +336,21 @@ void handle_brightness_status(scils_t * ls, sci_telegram * telegram){
 }
 
 void scils_on_rasta_receive(scils_t * ls, rastaApplicationMessage message){
-    sci_telegram * parsed = sci_decode_telegram(message.appMessage);
-
-    if (parsed == NULL){
+    // the telegram is decoded on the stack, so handling it does not allocate
+    sci_telegram telegram;
+    if (!sci_decode_telegram_into(message.appMessage, &telegram)){
         // parsing error -> it's not a SCI telegram
         return;
     }
+    sci_telegram * parsed = &telegram;
 
     if (parsed->protocol_type != SCI_PROTOCOL_LS){
         // not a SCI-LS telegram
         return;
     }
 
-    // add SCI name <-> RaSTA ID relation to map if not already in there
-    scils_register_sci_name(ls, parsed->sender, message.id);
+    // add SCI name <-> RaSTA ID relation to map if not already in there, the sender is already padded
+    sci_name_handle sender = sci_name_table_put(&ls->sciNamesToRastaIds, parsed->sender, message.id);
 
     // handle the received telegram
     switch (sci_get_message_type(parsed)){
@@ -252,12 +361,15 @@ void scils_on_rasta_receive(scils_t * ls, rastaApplicationMessage message){
             scils_handle_version_response(ls, parsed);
             break;
         case SCI_MESSAGE_TYPE_STATUS_REQUEST:
+            // the sender asks for every status
+            sci_status_cache_refresh(&ls->status_cache, sender);
             // call the notification handler if not null
             if (ls->notifications.on_status_request_received != NULL){
                 (*ls->notifications.on_status_request_received)(ls, parsed->sender);
             }
             break;
         case SCI_MESSAGE_TYPE_STATUS_BEGIN:
+            sci_status_cache_refresh(&ls->status_cache, sender);
             // call the notification handler if not null
             if (ls->notifications.on_status_begin_received!= NULL){
                 (*ls->notifications.on_status_begin_received)(ls, parsed->sender);
@@ -290,17 +402,13 @@ void scils_register_sci_name(scils_t * ls, char * sci_name, unsigned long rasta_
     sci_telegram tmp;
     sci_set_sender(&tmp, sci_name);
 
-    char * key = sci_get_name_string(tmp.sender);
+    // a name that is already registered keeps its RaSTA ID
+    sci_name_table_put(&ls->sciNamesToRastaIds, tmp.sender, rasta_id);
+}
 
-    unsigned long rastaId;
-    int res = hashmap_get(ls->sciNamesToRastaIds, key, (void **) &rastaId);
-    if (res == MAP_MISSING){
-        // SCI name not in map -> add to map
-        res = hashmap_put(ls->sciNamesToRastaIds, key, (any_t) rasta_id);
-        if (res != MAP_OK){
-            // something went wrong
-            rfree(key);
-            return;
-        }
-    }
-}
\ No newline at end of file
+sci_name_handle scils_lookup_sci_name(scils_t * ls, char * sci_name){
+    sci_telegram tmp;
+    sci_set_sender(&tmp, sci_name);
+
+    return sci_name_table_find(&ls->sciNamesToRastaIds, tmp.sender);
+}
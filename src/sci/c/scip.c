@@ -1,3 +1,4 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
 #include <scip.h>
 #include <sci_telegram_factory.h>
 #include <sci.h>
@@ -5,44 +6,109 @@
 #include <memory.h>
 #include <rasta_new.h>
 
+/**
+ * the kind of status telegram of the status cache
+ */
+#define SCIP_STATUS_LOCATION 0
+
 /**
  * Tries to send a SCI telegram to the receiver using the underlying RaSTA instance
  * @param p the SCI-P instance
- * @param telegram the telegram to send
+ * @param telegram the telegram to send, it is freed afterwards
+ * @param queued set to 1 if RaSTA took the telegram or it was added to the batch, 0 otherwise
  * @return 0 if success, error code otherwise
  */
-sci_return_code send_telegram(scip_t * p, sci_telegram * telegram){
-    struct RastaByteArray data = sci_encode_telegram(telegram);
-
-    char * sci_name = sci_get_name_string(telegram->receiver);
-
-    unsigned long rastaId;
-    int res = hashmap_get(p->sciNamesToRastaIds, sci_name, (void **) &rastaId);
-    rfree(sci_name);
-
-    if (res == MAP_MISSING){
+static sci_return_code transmit_telegram(scip_t * p, sci_telegram * telegram, int * queued){
+    *queued = 0;
+    // the padded name of the telegram is the key, so the lookup does not allocate
+    sci_name_handle handle = sci_name_table_find(&p->sciNamesToRastaIds, telegram->receiver);
+    if (handle == SCI_NAME_HANDLE_UNKNOWN){
         // SCI name not in map
+        rfree(telegram);
         return UNKNOWN_SCI_NAME;
     }
+    unsigned long rastaId = sci_name_table_rasta_id(&p->sciNamesToRastaIds, handle);
 
-    struct RastaMessageData messageData;
-    allocateRastaMessageData(&messageData, 1);
-    messageData.data_array[0] = data;
+    if (p->batch.open){
+        // the telegram is sent with the others when the batch ends, a full batch is sent right away
+        if (!sci_batch_add(&p->batch, rastaId, telegram)){
+            sci_batch_send(&p->batch, p->rasta_handle);
+            sci_batch_add(&p->batch, rastaId, telegram);
+        }
+        rfree(telegram);
+        *queued = 1;
+        return SUCCESS;
+    }
 
-    sr_send(p->rasta_handle, rastaId, messageData);
+    // sr_send copies the message, so the telegram is encoded on the stack
+    unsigned char buffer[SCI_MAX_TELEGRAM_LENGTH];
+    struct RastaByteArray data;
+    data.bytes = buffer;
+    data.length = sci_encode_telegram_into(telegram, buffer);
+    rfree(telegram);
 
-    freeRastaMessageData(&messageData);
+    struct RastaMessageData messageData;
+    messageData.count = 1;
+    messageData.data_array = &data;
+
+    *queued = sr_send(p->rasta_handle, rastaId, messageData);
     return SUCCESS;
 }
+
+/**
+ * Tries to send a SCI telegram to the receiver using the underlying RaSTA instance
+ * @param p the SCI-P instance
+ * @param telegram the telegram to send, it is freed afterwards
+ * @return 0 if success, error code otherwise
+ */
+sci_return_code send_telegram(scip_t * p, sci_telegram * telegram){
+    int queued;
+    return transmit_telegram(p, telegram, &queued);
+}
+
+/**
+ * Sends a status telegram unless the receiver has the status already, see scip_enable_status_cache()
+ * @param p the SCI-P instance
+ * @param telegram the status telegram, it is freed afterwards
+ * @param slot the kind of status
+ * @return 0 if success, error code otherwise
+ */
+static sci_return_code send_status_telegram(scip_t * p, sci_telegram * telegram, unsigned int slot){
+    if (!p->status_cache.enabled){
+        return send_telegram(p, telegram);
+    }
+
+    sci_name_handle receiver = sci_name_table_find(&p->sciNamesToRastaIds, telegram->receiver);
+    uint32_t now = current_ts();
+    if (sci_status_cache_suppress(&p->status_cache, receiver, slot, &telegram->payload, now)){
+        rfree(telegram);
+        return SUCCESS;
+    }
+
+    // the telegram is freed when it is sent
+    sci_payload payload = telegram->payload;
+    int queued;
+    sci_return_code result = transmit_telegram(p, telegram, &queued);
+    if (queued){
+        sci_status_cache_store(&p->status_cache, receiver, slot, &payload, now);
+    }
+    return result;
+}
 scip_t * scip_init(struct rasta_handle * handle, char * sciName){
     scip_t * scip = rmalloc(sizeof(scip_t));
 
     scip->rasta_handle = handle;
-    scip->sciName = rmalloc((unsigned int)strlen(sciName));
+    scip->sciName = rmalloc((unsigned int)strlen(sciName) + 1);
     strcpy(scip->sciName, sciName);
 
     // initialize map
-    scip->sciNamesToRastaIds = hashmap_new();
+    sci_name_table_init(&scip->sciNamesToRastaIds);
+
+    // telegrams are sent right away until a batch begins
+    sci_batch_init(&scip->batch);
+
+    // all status telegrams are sent until the cache is enabled
+    sci_status_cache_init(&scip->status_cache);
 
     // initialize notifications to NULL
     scip->notifications.on_change_location_received = NULL;
@@ -58,11 +124,30 @@ scip_t * scip_init(struct rasta_handle * handle, char * sciName){
 }
 
 void scip_cleanup(scip_t * p){
-    hashmap_free(p->sciNamesToRastaIds);
+    sci_batch_free(&p->batch);
+    sci_status_cache_free(&p->status_cache);
+    sci_name_table_free(&p->sciNamesToRastaIds);
     rfree(p->sciName);
     rfree(p);
 }
 
+void scip_begin_batch(scip_t * p){
+    p->batch.open = 1;
+}
+
+void scip_end_batch(scip_t * p){
+    sci_batch_send(&p->batch, p->rasta_handle);
+    p->batch.open = 0;
+}
+
+void scip_enable_status_cache(scip_t * p, unsigned int max_refresh_ms){
+    sci_status_cache_enable(&p->status_cache, max_refresh_ms);
+}
+
+void scip_disable_status_cache(scip_t * p){
+    sci_status_cache_disable(&p->status_cache);
+}
+
 sci_return_code scip_send_version_request(scip_t *p, char *receiver, unsigned char estw_version){
     sci_telegram * telegram = sci_create_version_request(SCI_PROTOCOL_P, p->sciName, receiver, estw_version);
 
@@ -84,9 +169,17 @@ sci_return_code scip_send_status_request(scip_t *p, char *receiver){
     return send_telegram(p, telegram);
 }
 
+sci_return_code scip_broadcast_status_request(scip_t *p, char **receivers, unsigned int count){
+    sci_telegram * telegram = sci_create_status_request(SCI_PROTOCOL_P, p->sciName, "");
+
+    return sci_broadcast_telegram(p->rasta_handle, &p->sciNamesToRastaIds, &p->batch, telegram, receivers, count);
+}
+
 sci_return_code scip_send_status_begin(scip_t *p, char *receiver){
     sci_telegram * telegram = sci_create_status_begin(SCI_PROTOCOL_P, p->sciName, receiver);
 
+    // the status report that begins has to contain every status
+    sci_status_cache_refresh(&p->status_cache, sci_name_table_find(&p->sciNamesToRastaIds, telegram->receiver));
     return send_telegram(p, telegram);
 }
 
@@ -105,7 +198,7 @@ sci_return_code scip_send_change_location(scip_t *p, char *receiver, scip_point_
 sci_return_code scip_send_location_status(scip_t *p, char *receiver, scip_point_location current_location){
     sci_telegram * telegram = scip_create_location_status_telegram(p->sciName, receiver, current_location);
 
-    return send_telegram(p, telegram);
+    return send_status_telegram(p, telegram, SCIP_STATUS_LOCATION);
 }
 
 sci_return_code scip_send_timeout(scip_t *p, char *receiver){
@@ -184,21 +277,21 @@ void handle_location_status(scip_t * p, sci_telegram * telegram){
 }
 
 void scip_on_rasta_receive(scip_t * p, rastaApplicationMessage message){
-    sci_telegram * parsed = sci_decode_telegram(message.appMessage);
-
-
-    if (parsed == NULL){
+    // the telegram is decoded on the stack, so handling it does not allocate
+    sci_telegram telegram;
+    if (!sci_decode_telegram_into(message.appMessage, &telegram)){
         // parsing error -> it's not a SCI telegram
         return;
     }
+    sci_telegram * parsed = &telegram;
 
     if (parsed->protocol_type != SCI_PROTOCOL_P){
         // not a SCI-P telegram
         return;
     }
 
-    // add SCI name <-> RaSTA ID relation to map if not already in there
-    scip_register_sci_name(p, parsed->sender, message.id);
+    // add SCI name <-> RaSTA ID relation to map if not already in there, the sender is already padded
+    sci_name_handle sender = sci_name_table_put(&p->sciNamesToRastaIds, parsed->sender, message.id);
 
     // handle the received telegram
     switch (sci_get_message_type(parsed)){
@@ -209,12 +302,15 @@ void scip_on_rasta_receive(scip_t * p, rastaApplicationMessage message){
             handle_version_response(p, parsed);
             break;
         case SCI_MESSAGE_TYPE_STATUS_REQUEST:
+            // the sender asks for every status
+            sci_status_cache_refresh(&p->status_cache, sender);
             // call the notification handler if not null
             if (p->notifications.on_status_request_received != NULL){
                 (*p->notifications.on_status_request_received)(p, parsed->sender);
             }
             break;
         case SCI_MESSAGE_TYPE_STATUS_BEGIN:
+            sci_status_cache_refresh(&p->status_cache, sender);
             // call the notification handler if not null
             if (p->notifications.on_status_begin_received!= NULL){
                 (*p->notifications.on_status_begin_received)(p, parsed->sender);
@@ -247,17 +343,13 @@ void scip_register_sci_name(scip_t * p, char * sci_name, unsigned long rasta_id)
     sci_telegram tmp;
     sci_set_sender(&tmp, sci_name);
 
-    char * key = sci_get_name_string(tmp.sender);
+    // a name that is already registered keeps its RaSTA ID
+    sci_name_table_put(&p->sciNamesToRastaIds, tmp.sender, rasta_id);
+}
 
-    unsigned long rastaId;
-    int res = hashmap_get(p->sciNamesToRastaIds, key, (void **) &rastaId);
-    if (res == MAP_MISSING){
-        // SCI name not in map -> add to map
-        res = hashmap_put(p->sciNamesToRastaIds, key, (any_t) rasta_id);
-        if (res != MAP_OK){
-            // something went wrong
-            rfree(key);
-            return;
-        }
-    }
-}
\ No newline at end of file
+sci_name_handle scip_lookup_sci_name(scip_t * p, char * sci_name){
+    sci_telegram tmp;
+    sci_set_sender(&tmp, sci_name);
+
+    return sci_name_table_find(&p->sciNamesToRastaIds, tmp.sender);
+}
@@ -1,3 +1,4 @@
+#define RMEMORY_SUBSYSTEM RMEMORY_SUBSYSTEM_SCI
 #include <scip_telegram_factory.h>
 
 sci_telegram * scip_create_change_location_telegram(char *sender, char *receiver, scip_point_target_location location){
@@ -86,6 +86,45 @@ typedef struct {
     sci_payload payload;
 }sci_telegram;
 
+/**
+ * Maximum amount of telegrams that are collected by a batch before it is sent
+ */
+#define SCI_BATCH_MAX_TELEGRAMS 64
+
+/**
+ * Encoded telegrams that are collected to be sent together. The telegrams to one receiver are packed into as few
+ * RaSTA data PDUs as possible, instead of one PDU per telegram.
+ */
+typedef struct {
+    /**
+     * 1 while telegrams are collected, 0 if they are sent right away
+     */
+    int open;
+
+    /**
+     * The amount of collected telegrams
+     */
+    unsigned int count;
+
+    /**
+     * The RaSTA ID of the receiver of every telegram
+     */
+    unsigned long rasta_ids[SCI_BATCH_MAX_TELEGRAMS];
+
+    /**
+     * The encoded telegrams, their bytes point into buffers
+     */
+    struct RastaByteArray telegrams[SCI_BATCH_MAX_TELEGRAMS];
+
+    /**
+     * The storage of the encoded telegrams, so collecting telegrams does not allocate
+     */
+    unsigned char buffers[SCI_BATCH_MAX_TELEGRAMS][SCI_MAX_TELEGRAM_LENGTH];
+}sci_batch;
+
+struct rasta_handle;
+struct sci_name_table;
+
 /**
  * Enumeration with the allowed results for a BTP version check
  */
@@ -145,6 +184,77 @@ struct RastaByteArray sci_encode_telegram(sci_telegram * telegram);
  */
 sci_telegram * sci_decode_telegram(struct RastaByteArray data);
 
+/**
+ * Encodes the given telegram into a buffer of the caller, without allocating.
+ * @param telegram the telegram that will be encoded
+ * @param buffer the buffer, at least SCI_MAX_TELEGRAM_LENGTH bytes long
+ * @return the length of the encoded telegram
+ */
+unsigned int sci_encode_telegram_into(sci_telegram * telegram, unsigned char * buffer);
+
+/**
+ * Tries to decode a SCI telegram from a byte array into a telegram of the caller, without allocating.
+ * @param data the byte array that will be parsed
+ * @param telegram the decoded telegram is written in here
+ * @return 1 if the byte array contains a valid telegram, 0 otherwise
+ */
+int sci_decode_telegram_into(struct RastaByteArray data, sci_telegram * telegram);
+
+/**
+ * Initializes an empty batch that is not collecting telegrams.
+ * @param batch the batch
+ */
+void sci_batch_init(sci_batch * batch);
+
+/**
+ * Encodes a telegram into the batch.
+ * @param batch the batch
+ * @param rasta_id the RaSTA ID of the receiver of the telegram
+ * @param telegram the telegram
+ * @return 1 if the telegram was added, 0 if the batch is full
+ */
+int sci_batch_add(sci_batch * batch, unsigned long rasta_id, sci_telegram * telegram);
+
+/**
+ * Adds a telegram that is encoded already to the batch.
+ * @param batch the batch
+ * @param rasta_id the RaSTA ID of the receiver of the telegram
+ * @param bytes the encoded telegram
+ * @param length the length of the encoded telegram, at most SCI_MAX_TELEGRAM_LENGTH
+ * @return 1 if the telegram was added, 0 if the batch is full
+ */
+int sci_batch_add_encoded(sci_batch * batch, unsigned long rasta_id, const unsigned char * bytes, unsigned int length);
+
+/**
+ * Sends the telegrams of the batch and empties it. The telegrams to one receiver are sent in their order, with
+ * as many telegrams per RaSTA data PDU as the handle allows.
+ * @param batch the batch
+ * @param handle the RaSTA handle the telegrams are sent with
+ */
+void sci_batch_send(sci_batch * batch, struct rasta_handle * handle);
+
+/**
+ * Sends a telegram to several receivers. The telegram is encoded once, only its receiver field is written for every
+ * receiver. All telegrams are queued with one call to sr_send_batch(), or added to the batch if it is open.
+ * @param handle the RaSTA handle the telegrams are sent with
+ * @param names the table that maps the SCI names of the receivers to their RaSTA IDs
+ * @param batch the batch of the SCI instance
+ * @param telegram the telegram, its receiver is ignored. It is freed afterwards
+ * @param receivers the SCI names of the receivers without padding
+ * @param count the amount of receivers
+ * @return 0 if the telegram was sent to all receivers, UNKNOWN_SCI_NAME if a name is not registered. The telegram is
+ * still sent to the other receivers then
+ */
+sci_return_code sci_broadcast_telegram(struct rasta_handle * handle, const struct sci_name_table * names,
+                                       sci_batch * batch, sci_telegram * telegram, char ** receivers,
+                                       unsigned int count);
+
+/**
+ * Drops the telegrams of the batch without sending them.
+ * @param batch the batch
+ */
+void sci_batch_free(sci_batch * batch);
+
 #ifdef __cplusplus
 }
 #endif
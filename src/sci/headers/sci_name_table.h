@@ -0,0 +1,102 @@
+#ifndef LST_SIMULATOR_SCI_NAME_TABLE_H
+#define LST_SIMULATOR_SCI_NAME_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <sci.h>
+
+/**
+ * A small integer that stands for a registered SCI name, valid as long as the table exists.
+ * Senders can look a name up once and use the handle afterwards.
+ */
+typedef int sci_name_handle;
+
+/**
+ * Handle that is returned for names that are not registered
+ */
+#define SCI_NAME_HANDLE_UNKNOWN (-1)
+
+/**
+ * A registered SCI name
+ */
+struct sci_name_table_entry {
+    /**
+     * The SCI name, padded with underscores like in a telegram
+     */
+    char name[SCI_NAME_LENGTH];
+    /**
+     * The RaSTA ID of the entity with the name
+     */
+    unsigned long rasta_id;
+};
+
+/**
+ * Representation of a hash table that maps the padded SCI names of telegrams to RaSTA IDs. The names are used as
+ * they are, so looking up the receiver of a telegram does not allocate. Every name gets a handle, which is its index
+ * in the entries. The table uses open addressing with linear probing.
+ */
+struct sci_name_table {
+    /**
+     * The registered names in the order they were registered, indexed by their handle
+     */
+    struct sci_name_table_entry * entries;
+    unsigned int count;
+    unsigned int entries_capacity;
+
+    /**
+     * The slots of the hash table, every slot holds the handle of a name + 1 or 0 if it is free
+     */
+    unsigned int * slots;
+    /**
+     * The amount of slots, always a power of two
+     */
+    unsigned int capacity;
+};
+
+/**
+ * initializes an empty table
+ * @param table the table
+ */
+void sci_name_table_init(struct sci_name_table * table);
+
+/**
+ * frees the memory of the table
+ * @param table the table
+ */
+void sci_name_table_free(struct sci_name_table * table);
+
+/**
+ * registers a SCI name. A name that is already registered keeps its RaSTA ID
+ * @param table the table
+ * @param name the name, padded to SCI_NAME_LENGTH bytes
+ * @param rasta_id the RaSTA ID of the entity with the name
+ * @return the handle of the name
+ */
+sci_name_handle sci_name_table_put(struct sci_name_table * table, const char * name, unsigned long rasta_id);
+
+/**
+ * looks up the handle of a SCI name
+ * @param table the table
+ * @param name the name, padded to SCI_NAME_LENGTH bytes
+ * @return the handle or SCI_NAME_HANDLE_UNKNOWN if the name is not registered
+ */
+sci_name_handle sci_name_table_find(const struct sci_name_table * table, const char * name);
+
+/**
+ * getter for the RaSTA ID of a handle
+ * @param table the table
+ * @param handle a handle returned by the table
+ * @return the RaSTA ID
+ */
+static inline unsigned long sci_name_table_rasta_id(const struct sci_name_table * table, sci_name_handle handle) {
+    return table->entries[handle].rasta_id;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_SCI_NAME_TABLE_H
@@ -0,0 +1,126 @@
+#ifndef LST_SIMULATOR_SCI_STATUS_CACHE_H
+#define LST_SIMULATOR_SCI_STATUS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {  // only need to export C interface if
+              // used by C++ source code
+#endif
+
+#include <stdint.h>
+#include <sci.h>
+#include <sci_name_table.h>
+
+/**
+ * Amount of status telegrams that are cached per receiver, e.g. the signal aspect and the brightness of a SCI-LS
+ * instance
+ */
+#define SCI_STATUS_CACHE_SLOTS 2
+
+/**
+ * The last status that was sent to a receiver
+ */
+struct sci_status_cache_entry {
+    /**
+     * 1 if the payload is known, 0 if the next status is sent anyway
+     */
+    int valid;
+    /**
+     * The time the status was sent in the milliseconds of current_ts()
+     */
+    uint32_t sent_at;
+    /**
+     * The payload of the status telegram
+     */
+    sci_payload payload;
+};
+
+/**
+ * Representation of the status telegrams that were sent to every receiver. A status telegram that has the payload of
+ * the last one that RaSTA accepted for the receiver is not sent again, unless the receiver asked for the status or
+ * a status report began since then, or the last one is older than the maximum refresh interval. The entries are
+ * indexed by the name handles of the sci_name_table of the instance.
+ */
+typedef struct {
+    /**
+     * 1 if status telegrams are suppressed, 0 if all of them are sent
+     */
+    int enabled;
+    /**
+     * Milliseconds after which an unchanged status is sent again, 0 if it is only sent again after a refresh
+     */
+    unsigned int max_refresh_ms;
+
+    /**
+     * SCI_STATUS_CACHE_SLOTS entries per receiver, starting at the name handle times SCI_STATUS_CACHE_SLOTS
+     */
+    struct sci_status_cache_entry * entries;
+    unsigned int receiver_capacity;
+
+    /**
+     * The amount of status telegrams that were not sent
+     */
+    unsigned long suppressed;
+} sci_status_cache;
+
+/**
+ * Initializes a disabled cache.
+ * @param cache the cache
+ */
+void sci_status_cache_init(sci_status_cache * cache);
+
+/**
+ * Frees the memory of the cache.
+ * @param cache the cache
+ */
+void sci_status_cache_free(sci_status_cache * cache);
+
+/**
+ * Enables the cache, it starts empty.
+ * @param cache the cache
+ * @param max_refresh_ms milliseconds after which an unchanged status is sent again, 0 if it is only sent again after
+ * a refresh
+ */
+void sci_status_cache_enable(sci_status_cache * cache, unsigned int max_refresh_ms);
+
+/**
+ * Disables the cache, all status telegrams are sent again.
+ * @param cache the cache
+ */
+void sci_status_cache_disable(sci_status_cache * cache);
+
+/**
+ * Checks if a status telegram can be left out and counts it if so.
+ * @param cache the cache
+ * @param receiver the handle of the receiver
+ * @param slot the kind of status, less than SCI_STATUS_CACHE_SLOTS
+ * @param payload the payload of the status telegram
+ * @param now the current time in the milliseconds of current_ts()
+ * @return 1 if the receiver has the status already, 0 if the telegram has to be sent
+ */
+int sci_status_cache_suppress(sci_status_cache * cache, sci_name_handle receiver, unsigned int slot,
+                              const sci_payload * payload, uint32_t now);
+
+/**
+ * Remembers a status telegram that RaSTA accepted for a receiver.
+ * @param cache the cache
+ * @param receiver the handle of the receiver
+ * @param slot the kind of status, less than SCI_STATUS_CACHE_SLOTS
+ * @param payload the payload of the status telegram
+ * @param now the time the telegram was sent in the milliseconds of current_ts()
+ */
+void sci_status_cache_store(sci_status_cache * cache, sci_name_handle receiver, unsigned int slot,
+                            const sci_payload * payload, uint32_t now);
+
+/**
+ * Forgets the status telegrams that were sent to a receiver, so the next ones are sent in any case. Used when the
+ * receiver asks for the status or a status report begins.
+ * @param cache the cache
+ * @param receiver the handle of the receiver
+ */
+void sci_status_cache_refresh(sci_status_cache * cache, sci_name_handle receiver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LST_SIMULATOR_SCI_STATUS_CACHE_H
@@ -7,7 +7,8 @@ extern "C" {  // only need to export C interface if
 #endif
 
 #include <sci.h>
-#include <hashmap.h>
+#include <sci_name_table.h>
+#include <sci_status_cache.h>
 #include <scils_telegram_factory.h>
 #include <rasta_new.h>
 
@@ -144,9 +145,20 @@ struct scils_t{
      */
     struct rasta_handle * rasta_handle;
     /**
-     * Used for mapping RaSTA IDs to SCI names
+     * Used for mapping SCI names to RaSTA IDs
      */
-    map_t sciNamesToRastaIds;
+    struct sci_name_table sciNamesToRastaIds;
+
+    /**
+     * The telegrams that are collected between begin and end of a batch
+     */
+    sci_batch batch;
+
+    /**
+     * The signal aspect and brightness status telegrams that were sent to every receiver, see
+     * scils_enable_status_cache()
+     */
+    sci_status_cache status_cache;
 
     scils_notification_ptr notifications;
 };
@@ -165,6 +177,35 @@ scils_t * scils_init(struct rasta_handle * handle, char * sciName);
  */
 void scils_cleanup(scils_t * ls);
 
+/**
+ * Begins a batch: until scils_end_batch() is called, the telegrams of the scils_send_* functions are only encoded
+ * and collected. Use it for bursts like a status report, so the telegrams are packed into few RaSTA data PDUs.
+ * @param ls the SCI-LS instance
+ */
+void scils_begin_batch(scils_t * ls);
+
+/**
+ * Ends the batch and sends the collected telegrams, the telegrams to one receiver keep their order.
+ * @param ls the SCI-LS instance
+ */
+void scils_end_batch(scils_t * ls);
+
+/**
+ * Leaves out signal aspect status and brightness status telegrams that have the same status as the last one RaSTA
+ * accepted for the receiver. The next status telegrams are sent in any case after a status request of the receiver
+ * was received or a status begin was sent to or received from it.
+ * @param ls the SCI-LS instance
+ * @param max_refresh_ms milliseconds after which an unchanged status is sent again, 0 if it is only sent again after
+ * a status request or status begin
+ */
+void scils_enable_status_cache(scils_t * ls, unsigned int max_refresh_ms);
+
+/**
+ * Sends all status telegrams again.
+ * @param ls the SCI-LS instance
+ */
+void scils_disable_status_cache(scils_t * ls);
+
 /**
  * Sends a version request to the specified receiver.
  * @param p the used SCI-LS instance
@@ -239,6 +280,37 @@ sci_return_code scils_send_signal_aspect_status(scils_t * ls, char * receiver, s
  */
 sci_return_code scils_send_change_brightness(scils_t * ls, char * receiver, scils_brightness brightness);
 
+/**
+ * Sends a status request to several receivers. The telegram is encoded once for all of them.
+ * @param ls the used SCI-LS instance
+ * @param receivers the SCI names of the receivers
+ * @param count the amount of receivers
+ * @return 0 if the operation was successful, UNKNOWN_SCI_NAME if a receiver is not registered
+ */
+sci_return_code scils_broadcast_status_request(scils_t * ls, char ** receivers, unsigned int count);
+
+/**
+ * Sends a show signal aspect command to several receivers. The telegram is encoded once for all of them.
+ * @param ls the used SCI-LS instance
+ * @param receivers the SCI names of the receivers
+ * @param count the amount of receivers
+ * @param signal_aspect the signal aspect to display
+ * @return 0 if the operation was successful, UNKNOWN_SCI_NAME if a receiver is not registered
+ */
+sci_return_code scils_broadcast_show_signal_aspect(scils_t * ls, char ** receivers, unsigned int count,
+                                                   scils_signal_aspect signal_aspect);
+
+/**
+ * Sends a change brightness command to several receivers. The telegram is encoded once for all of them.
+ * @param ls the used SCI-LS instance
+ * @param receivers the SCI names of the receivers
+ * @param count the amount of receivers
+ * @param brightness the brightness to display
+ * @return 0 if the operation was successful, UNKNOWN_SCI_NAME if a receiver is not registered
+ */
+sci_return_code scils_broadcast_change_brightness(scils_t * ls, char ** receivers, unsigned int count,
+                                                  scils_brightness brightness);
+
 /**
  * Sends a brightness status to the specified receiver.
  * @param ls the used SCI-LS instance
@@ -263,6 +335,15 @@ void scils_on_rasta_receive(scils_t * ls, rastaApplicationMessage message);
  */
 void scils_register_sci_name(scils_t * ls, char * sci_name, unsigned long rasta_id);
 
+/**
+ * Looks up the handle of a registered SCI name. The handle stays valid for the lifetime of the instance and can be
+ * cached by senders that send many telegrams to the same remote.
+ * @param ls the SCI instance
+ * @param sci_name the SCI name of the remote
+ * @return the handle of the name or SCI_NAME_HANDLE_UNKNOWN if the name is not registered
+ */
+sci_name_handle scils_lookup_sci_name(scils_t * ls, char * sci_name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,7 +8,8 @@ extern "C" {  // only need to export C interface if
 #endif
 
 #include <rastahandle.h>
-#include <hashmap.h>
+#include <sci_name_table.h>
+#include <sci_status_cache.h>
 #include <sci.h>
 #include <scip_telegram_factory.h>
 #include <rasta_new.h>
@@ -133,9 +134,20 @@ struct scip_t{
      */
     struct rasta_handle * rasta_handle;
     /**
-     * Used for mapping RaSTA IDs to SCI names
+     * Used for mapping SCI names to RaSTA IDs
      */
-    map_t sciNamesToRastaIds;
+    struct sci_name_table sciNamesToRastaIds;
+
+    /**
+     * The telegrams that are collected between begin and end of a batch
+     */
+    sci_batch batch;
+
+    /**
+     * The location status telegrams that were sent to every receiver, see scip_enable_status_cache()
+     */
+    sci_status_cache status_cache;
+
     scip_notification_ptr notifications;
 };
 
@@ -153,6 +165,35 @@ scip_t * scip_init(struct rasta_handle * handle, char * sciName);
  */
 void scip_cleanup(scip_t * p);
 
+/**
+ * Begins a batch: until scip_end_batch() is called, the telegrams of the scip_send_* functions are only encoded
+ * and collected. Use it for bursts like a status report, so the telegrams are packed into few RaSTA data PDUs.
+ * @param p the SCI-P instance
+ */
+void scip_begin_batch(scip_t * p);
+
+/**
+ * Ends the batch and sends the collected telegrams, the telegrams to one receiver keep their order.
+ * @param p the SCI-P instance
+ */
+void scip_end_batch(scip_t * p);
+
+/**
+ * Leaves out location status telegrams that have the same location as the last one RaSTA accepted for the receiver.
+ * The next location status is sent in any case after a status request of the receiver was received or a status begin
+ * was sent to or received from it.
+ * @param p the SCI-P instance
+ * @param max_refresh_ms milliseconds after which an unchanged location is sent again, 0 if it is only sent again
+ * after a status request or status begin
+ */
+void scip_enable_status_cache(scip_t * p, unsigned int max_refresh_ms);
+
+/**
+ * Sends all location status telegrams again.
+ * @param p the SCI-P instance
+ */
+void scip_disable_status_cache(scip_t * p);
+
 /**
  * Sends a version request to the specified receiver.
  * @param p the used SCI-P instance
@@ -184,6 +225,15 @@ sci_return_code scip_send_version_response(scip_t *p, char *receiver, unsigned c
  */
 sci_return_code scip_send_status_request(scip_t *p, char *receiver);
 
+/**
+ * Sends a status request to several receivers. The telegram is encoded once for all of them.
+ * @param p the used SCI-P instance
+ * @param receivers the SCI names of the receivers
+ * @param count the amount of receivers
+ * @return 0 if the operation was successful, UNKNOWN_SCI_NAME if a receiver is not registered
+ */
+sci_return_code scip_broadcast_status_request(scip_t *p, char **receivers, unsigned int count);
+
 /**
  * Sends a status begin to the specified receiver.
  * @param p the used SCI-P instance
@@ -241,6 +291,15 @@ void scip_on_rasta_receive(scip_t * p, rastaApplicationMessage message);
  */
 void scip_register_sci_name(scip_t * p, char * sci_name, unsigned long rasta_id);
 
+/**
+ * Looks up the handle of a registered SCI name. The handle stays valid for the lifetime of the instance and can be
+ * cached by senders that send many telegrams to the same remote.
+ * @param p the SCI instance
+ * @param sci_name the SCI name of the remote
+ * @return the handle of the name or SCI_NAME_HANDLE_UNKNOWN if the name is not registered
+ */
+sci_name_handle scip_lookup_sci_name(scip_t * p, char * sci_name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,554 @@
+/**
+ * Microbenchmarks of the codec, the checksums, the queues and the SCI layer. The results are written as JSON in the
+ * format of google-benchmark, so the tools of google-benchmark (e.g. compare.py) can compare two runs.
+ * Usage: rasta_bench [--filter=<substring of the names>] [--min-time=<seconds per benchmark>] [--out=<file>]
+ * Build with CMAKE_BUILD_TYPE=Release for comparable results.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <rastacrc.h>
+#include <rastadeferqueue.h>
+#include <rastafactory.h>
+#include <rastahashing.h>
+#include <rastamodule.h>
+#include <rastautil.h>
+#include <fifo.h>
+#include <hashmap.h>
+#include <sci.h>
+#include <sci_name_table.h>
+#include <scils.h>
+#include <scils_telegram_factory.h>
+#include <scip.h>
+#include <scip_telegram_factory.h>
+
+// the benchmarks are measured this often, the fastest repetition is reported
+#define REPETITIONS 3
+
+// the length of an application message, the maximum of a SCI PDU
+#define APP_MESSAGE_LENGTH 44
+
+// the SCI names of a large station, for the lookups of the receivers
+#define SCI_NAME_COUNT 1024
+
+/**
+ * runs the measured operation @p iterations times
+ */
+typedef void (*bench_function)(void * state, unsigned long iterations);
+
+/**
+ * keeps the results of the measured operations from being optimized away
+ */
+static volatile unsigned long sink;
+
+static const char * filter = NULL;
+static double min_time = 0.2;
+static FILE * out;
+static int benchmark_count = 0;
+
+static uint64_t get_time(clockid_t clock) {
+    struct timespec t;
+    clock_gettime(clock, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+/**
+ * measures a benchmark and writes its result
+ * @param name the name of the benchmark
+ * @param function the benchmark
+ * @param state the argument of @p function
+ * @param bytes the amount of bytes processed per iteration, 0 if the throughput is not reported
+ */
+static void run(const char * name, bench_function function, void * state, unsigned long bytes) {
+    if (filter != NULL && strstr(name, filter) == NULL) {
+        return;
+    }
+
+    // double the iterations until a repetition takes at least min_time
+    unsigned long iterations = 1;
+    uint64_t real_time, cpu_time;
+    while (1) {
+        uint64_t real_start = get_time(CLOCK_MONOTONIC);
+        function(state, iterations);
+        real_time = get_time(CLOCK_MONOTONIC) - real_start;
+        if (real_time >= (uint64_t) (min_time * 1e9) || iterations >= (1ul << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double best_real = -1, best_cpu = -1;
+    for (int r = 0; r < REPETITIONS; r++) {
+        uint64_t real_start = get_time(CLOCK_MONOTONIC);
+        uint64_t cpu_start = get_time(CLOCK_PROCESS_CPUTIME_ID);
+        function(state, iterations);
+        cpu_time = get_time(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+        real_time = get_time(CLOCK_MONOTONIC) - real_start;
+
+        double real_per_iteration = (double) real_time / (double) iterations;
+        double cpu_per_iteration = (double) cpu_time / (double) iterations;
+        if (best_real < 0 || real_per_iteration < best_real) {
+            best_real = real_per_iteration;
+            best_cpu = cpu_per_iteration;
+        }
+    }
+
+    fprintf(out, "%s    {\n", benchmark_count > 0 ? ",\n" : "");
+    fprintf(out, "      \"name\": \"%s\",\n", name);
+    fprintf(out, "      \"run_type\": \"iteration\",\n");
+    fprintf(out, "      \"repetitions\": %d,\n", REPETITIONS);
+    fprintf(out, "      \"iterations\": %lu,\n", iterations);
+    fprintf(out, "      \"real_time\": %.3f,\n", best_real);
+    fprintf(out, "      \"cpu_time\": %.3f,\n", best_cpu);
+    if (bytes > 0) {
+        fprintf(out, "      \"bytes_per_second\": %.0f,\n", (double) bytes / best_real * 1e9);
+    }
+    fprintf(out, "      \"time_unit\": \"ns\"\n");
+    fprintf(out, "    }");
+    benchmark_count++;
+
+    // progress for the user, the JSON may go to stdout as well
+    fprintf(stderr, "%-48s %12.1f ns %12lu iterations\n", name, best_real, iterations);
+}
+
+/*
+ * CRC
+ */
+
+struct crc_state {
+    struct crc_options options;
+    struct RastaByteArray data;
+};
+
+static void bench_crc(void * state, unsigned long iterations) {
+    struct crc_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sink += crc_calculate(&s->options, s->data);
+    }
+}
+
+/*
+ * safety code
+ */
+
+struct hash_state {
+    rasta_hashing_context_t context;
+    struct RastaByteArray data;
+};
+
+static void bench_hash(void * state, unsigned long iterations) {
+    struct hash_state * s = state;
+    unsigned char hash[16];
+    for (unsigned long i = 0; i < iterations; i++) {
+        rasta_calculate_hash(s->data, &s->context, hash);
+        sink += hash[0];
+    }
+}
+
+/*
+ * codec
+ */
+
+struct codec_state {
+    rasta_hashing_context_t context;
+    struct RastaMessageData messages;
+    struct RastaPacket packet;
+    struct RastaByteArray encoded;
+};
+
+static void bench_create_and_encode(void * state, unsigned long iterations) {
+    struct codec_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        struct RastaPacket packet = createDataMessage(0x61, 0x62, (uint32_t) i, 1, 2, 3, s->messages, &s->context);
+        struct RastaByteArray bytes = rastaModuleToBytes(packet, &s->context);
+        sink += bytes.length;
+        freeRastaByteArray(&bytes);
+        freeRastaByteArray(&packet.data);
+    }
+}
+
+static void bench_decode(void * state, unsigned long iterations) {
+    struct codec_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        struct RastaPacket packet = bytesToRastaPacket(s->encoded, &s->context);
+        sink += (unsigned long) packet.checksum_correct;
+        freeRastaByteArray(&packet.data);
+        freeRastaByteArray(&packet.checksum);
+    }
+}
+
+static void bench_extract_message_data(void * state, unsigned long iterations) {
+    struct codec_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        struct RastaMessageData messages = extractMessageData(s->packet);
+        sink += messages.count;
+        freeRastaMessageData(&messages);
+    }
+}
+
+/*
+ * queues
+ */
+
+static void bench_deferqueue(void * state, unsigned long iterations) {
+    struct defer_queue * queue = state;
+    struct RastaRedundancyPacket packet;
+    memset(&packet, 0, sizeof(packet));
+
+    // the queue holds a few PDUs like a channel that waits for a missing one
+    for (unsigned long i = 0; i < iterations; i++) {
+        packet.sequence_number = (uint32_t) i + 4;
+        deferqueue_add(queue, &packet, i);
+        sink += deferqueue_get(queue, (unsigned long) i + 4).sequence_number;
+        deferqueue_remove(queue, (unsigned long) i + 4);
+    }
+}
+
+static void bench_fifo(void * state, unsigned long iterations) {
+    fifo_t * fifo = state;
+    static int element;
+    for (unsigned long i = 0; i < iterations; i++) {
+        fifo_push(fifo, &element);
+        sink += fifo_pop(fifo) != NULL;
+    }
+}
+
+/*
+ * SCI
+ */
+
+struct sci_state {
+    scils_signal_aspect signal_aspect;
+    sci_telegram * telegram;
+    struct RastaByteArray encoded;
+
+    /**
+     * the receivers of a station as NUL terminated padded names, in the old hashmap and in the name table
+     */
+    char (*names)[SCI_NAME_LENGTH + 1];
+    map_t hashmap;
+    struct sci_name_table table;
+
+    /**
+     * a received show signal aspect telegram and change location telegram, and the instances that handle them
+     */
+    rastaApplicationMessage ls_message;
+    rastaApplicationMessage p_message;
+    scils_t * ls;
+    scip_t * p;
+};
+
+static void bench_sci_encode(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        struct RastaByteArray bytes = sci_encode_telegram(s->telegram);
+        sink += bytes.length;
+        freeRastaByteArray(&bytes);
+    }
+}
+
+static void bench_sci_encode_into(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    unsigned char buffer[SCI_MAX_TELEGRAM_LENGTH];
+    for (unsigned long i = 0; i < iterations; i++) {
+        sink += sci_encode_telegram_into(s->telegram, buffer);
+    }
+}
+
+static void bench_sci_decode(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_telegram * telegram = sci_decode_telegram(s->encoded);
+        sink += telegram->payload.used_bytes;
+        rfree(telegram);
+    }
+}
+
+static void bench_sci_decode_into(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    sci_telegram telegram;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sink += (unsigned long) sci_decode_telegram_into(s->encoded, &telegram);
+    }
+}
+
+static void bench_scils_create_show_signal_aspect(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_telegram * telegram = scils_create_show_signal_aspect("interlocking", "signal", s->signal_aspect);
+        sink += telegram->payload.used_bytes;
+        rfree(telegram);
+    }
+}
+
+static void bench_scils_create_signal_aspect_status(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_telegram * telegram = scils_create_signal_aspect_status("signal", "interlocking", s->signal_aspect);
+        sink += telegram->payload.used_bytes;
+        rfree(telegram);
+    }
+}
+
+static void bench_scip_create_change_location(void * state, unsigned long iterations) {
+    (void) state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_telegram * telegram = scip_create_change_location_telegram("interlocking", "point",
+                                                                       POINT_LOCATION_CHANGE_TO_LEFT);
+        sink += telegram->payload.used_bytes;
+        rfree(telegram);
+    }
+}
+
+static void bench_scip_create_location_status(void * state, unsigned long iterations) {
+    (void) state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_telegram * telegram = scip_create_location_status_telegram("point", "interlocking", POINT_LOCATION_LEFT);
+        sink += telegram->payload.used_bytes;
+        rfree(telegram);
+    }
+}
+
+static void bench_hashmap_get(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        any_t value;
+        hashmap_get(s->hashmap, s->names[i % SCI_NAME_COUNT], &value);
+        sink += (unsigned long) value;
+    }
+}
+
+static void bench_sci_name_table_find(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        sci_name_handle handle = sci_name_table_find(&s->table, s->names[i % SCI_NAME_COUNT]);
+        sink += sci_name_table_rasta_id(&s->table, handle);
+    }
+}
+
+static void on_show_signal_aspect(scils_t * ls, char * sender, scils_signal_aspect signal_aspect) {
+    (void) ls;
+    (void) sender;
+    sink += signal_aspect.main;
+}
+
+static void on_change_location(scip_t * p, char * sender, scip_point_target_location location) {
+    (void) p;
+    (void) sender;
+    sink += location;
+}
+
+static void bench_scils_on_rasta_receive(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        scils_on_rasta_receive(s->ls, s->ls_message);
+    }
+}
+
+static void bench_scip_on_rasta_receive(void * state, unsigned long iterations) {
+    struct sci_state * s = state;
+    for (unsigned long i = 0; i < iterations; i++) {
+        scip_on_rasta_receive(s->p, s->p_message);
+    }
+}
+
+/**
+ * fills a byte array with pseudo random bytes
+ * @param data the array, allocated with @p length bytes
+ * @param length the length
+ */
+static void random_bytes(struct RastaByteArray * data, unsigned int length) {
+    allocateRastaByteArray(data, length);
+    for (unsigned int i = 0; i < length; i++) {
+        data->bytes[i] = (unsigned char) rand();
+    }
+}
+
+int main(int argc, char * argv[]) {
+    out = stdout;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+            min_time = atof(argv[i] + 11);
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out = fopen(argv[i] + 6, "w");
+            if (out == NULL) {
+                perror("Could not open output file");
+                exit(1);
+            }
+        } else {
+            fprintf(stderr, "usage: %s [--filter=<substring>] [--min-time=<seconds>] [--out=<file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    char host_name[256] = "";
+    gethostname(host_name, sizeof(host_name) - 1);
+    char date[64];
+    time_t now = time(NULL);
+    struct tm tm;
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime_r(&now, &tm));
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"host_name\": \"%s\",\n", host_name);
+    fprintf(out, "    \"executable\": \"%s\",\n", argv[0]);
+    fprintf(out, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef NDEBUG
+    fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    fprintf(out, "  },\n  \"benchmarks\": [\n");
+
+    char name[128];
+    const unsigned int lengths[] = { 36, 256, 1024 };
+    const unsigned int length_count = sizeof(lengths) / sizeof(lengths[0]);
+
+    // CRC of the redundancy layer, every option of 6.3.6
+    struct crc_state crc;
+    struct crc_options (*const crc_inits[])(void) = { crc_init_opt_a, crc_init_opt_b, crc_init_opt_c, crc_init_opt_d,
+                                                     crc_init_opt_e };
+    for (unsigned int o = 0; o < sizeof(crc_inits) / sizeof(crc_inits[0]); o++) {
+        crc.options = crc_inits[o]();
+        for (unsigned int l = 0; l < length_count; l++) {
+            random_bytes(&crc.data, lengths[l]);
+            snprintf(name, sizeof(name), "crc_calculate/opt_%c/%u", 'a' + o, lengths[l]);
+            run(name, bench_crc, &crc, lengths[l]);
+            freeRastaByteArray(&crc.data);
+        }
+    }
+
+    // safety code of the SR layer
+    struct hash_state hash;
+    const char * algorithm_names[] = { "md4", "blake2b", "siphash" };
+    const rasta_hash_algorithm algorithms[] = { RASTA_ALGO_MD4, RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4 };
+    unsigned char key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    for (unsigned int a = 0; a < 3; a++) {
+        for (unsigned int hash_length = RASTA_CHECKSUM_8B; hash_length <= RASTA_CHECKSUM_16B; hash_length++) {
+            memset(&hash.context, 0, sizeof(hash.context));
+            hash.context.algorithm = algorithms[a];
+            hash.context.hash_length = (rasta_checksum_type) hash_length;
+            if (algorithms[a] == RASTA_ALGO_MD4) {
+                rasta_md4_set_key(&hash.context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+            } else {
+                rasta_set_hash_key_variable(&hash.context, (const char *) key, sizeof(key));
+            }
+
+            for (unsigned int l = 0; l < length_count; l++) {
+                random_bytes(&hash.data, lengths[l]);
+                snprintf(name, sizeof(name), "rasta_calculate_hash/%s/%u/%u", algorithm_names[a], hash_length * 8,
+                         lengths[l]);
+                run(name, bench_hash, &hash, lengths[l]);
+                freeRastaByteArray(&hash.data);
+            }
+            freeRastaByteArray(&hash.context.key);
+        }
+    }
+
+    // SR layer PDU with one application message and an 8 byte MD4 safety code, like the example configurations
+    struct codec_state codec;
+    memset(&codec, 0, sizeof(codec));
+    codec.context.algorithm = RASTA_ALGO_MD4;
+    codec.context.hash_length = RASTA_CHECKSUM_8B;
+    rasta_md4_set_key(&codec.context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+    allocateRastaMessageData(&codec.messages, 1);
+    for (unsigned int i = 0; i < codec.messages.count; i++) {
+        random_bytes(&codec.messages.data_array[i], APP_MESSAGE_LENGTH);
+    }
+    codec.packet = createDataMessage(0x61, 0x62, 1, 1, 2, 3, codec.messages, &codec.context);
+    codec.encoded = rastaModuleToBytes(codec.packet, &codec.context);
+
+    run("createDataMessage+rastaModuleToBytes", bench_create_and_encode, &codec, codec.encoded.length);
+    run("bytesToRastaPacket", bench_decode, &codec, codec.encoded.length);
+    run("extractMessageData", bench_extract_message_data, &codec, 0);
+
+    freeRastaByteArray(&codec.encoded);
+    freeRastaByteArray(&codec.packet.data);
+    freeRastaMessageData(&codec.messages);
+    freeRastaByteArray(&codec.context.key);
+
+    // defer queue with a few waiting PDUs
+    struct defer_queue queue = deferqueue_init(8);
+    struct RastaRedundancyPacket waiting;
+    memset(&waiting, 0, sizeof(waiting));
+    for (uint32_t i = 1; i < 4; i++) {
+        waiting.sequence_number = i;
+        deferqueue_add(&queue, &waiting, 0);
+    }
+    run("deferqueue_add+get+remove", bench_deferqueue, &queue, 0);
+    deferqueue_destroy(&queue);
+
+    fifo_t * fifo = fifo_init(16);
+    run("fifo_push+fifo_pop", bench_fifo, fifo, 0);
+    fifo_destroy(fifo);
+
+    // SCI-LS signal aspect, the largest telegram of the field elements
+    struct sci_state sci;
+    memset(&sci, 0, sizeof(sci));
+    scils_signal_aspect * defaults = scils_signal_aspect_defaults();
+    sci.signal_aspect = *defaults;
+    rfree(defaults);
+    sci.signal_aspect.main = SCILS_MAIN_HP_0;
+    sci.telegram = scils_create_show_signal_aspect("interlocking", "signal", sci.signal_aspect);
+    sci.encoded = sci_encode_telegram(sci.telegram);
+
+    run("sci_encode_telegram", bench_sci_encode, &sci, sci.encoded.length);
+    run("sci_encode_telegram_into", bench_sci_encode_into, &sci, sci.encoded.length);
+    run("sci_decode_telegram", bench_sci_decode, &sci, sci.encoded.length);
+    run("sci_decode_telegram_into", bench_sci_decode_into, &sci, sci.encoded.length);
+    run("scils_create_show_signal_aspect", bench_scils_create_show_signal_aspect, &sci, 0);
+    run("scils_create_signal_aspect_status", bench_scils_create_signal_aspect_status, &sci, 0);
+    run("scip_create_change_location_telegram", bench_scip_create_change_location, &sci, 0);
+    run("scip_create_location_status_telegram", bench_scip_create_location_status, &sci, 0);
+
+    // the receivers of a station, looked up by their padded names like the receiver of a telegram
+    sci.names = calloc(SCI_NAME_COUNT, sizeof(*sci.names));
+    sci.hashmap = hashmap_new();
+    sci_name_table_init(&sci.table);
+    for (unsigned int i = 0; i < SCI_NAME_COUNT; i++) {
+        snprintf(sci.names[i], sizeof(sci.names[i]), "signal%04u", i);
+        memset(sci.names[i] + strlen(sci.names[i]), SCI_NAME_PADDING_CHAR, SCI_NAME_LENGTH - strlen(sci.names[i]));
+        hashmap_put(sci.hashmap, sci.names[i], (any_t) (unsigned long) (0x1000 + i));
+        sci_name_table_put(&sci.table, sci.names[i], 0x1000 + i);
+    }
+    snprintf(name, sizeof(name), "hashmap_get/%u", SCI_NAME_COUNT);
+    run(name, bench_hashmap_get, &sci, 0);
+    snprintf(name, sizeof(name), "sci_name_table_find/%u", SCI_NAME_COUNT);
+    run(name, bench_sci_name_table_find, &sci, 0);
+
+    // the dispatch of a received telegram to the notification, without a RaSTA handle nothing is answered
+    sci.ls = scils_init(NULL, "signal");
+    sci.ls->notifications.on_show_signal_aspect_received = on_show_signal_aspect;
+    sci.ls_message.id = 0x61;
+    sci.ls_message.appMessage = sci.encoded;
+    run("scils_on_rasta_receive/show_signal_aspect", bench_scils_on_rasta_receive, &sci, sci.encoded.length);
+
+    sci_telegram * change_location = scip_create_change_location_telegram("interlocking", "point",
+                                                                          POINT_LOCATION_CHANGE_TO_LEFT);
+    sci.p = scip_init(NULL, "point");
+    sci.p->notifications.on_change_location_received = on_change_location;
+    sci.p_message.id = 0x61;
+    sci.p_message.appMessage = sci_encode_telegram(change_location);
+    rfree(change_location);
+    run("scip_on_rasta_receive/change_location", bench_scip_on_rasta_receive, &sci, sci.p_message.appMessage.length);
+
+    scils_cleanup(sci.ls);
+    scip_cleanup(sci.p);
+    freeRastaByteArray(&sci.p_message.appMessage);
+    sci_name_table_free(&sci.table);
+    hashmap_free(sci.hashmap);
+    free(sci.names);
+    freeRastaByteArray(&sci.encoded);
+    rfree(sci.telegram);
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
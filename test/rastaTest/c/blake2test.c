@@ -101,3 +101,42 @@ int rasta_blake2b_selftest() {
 
     return 0;
 }
+
+void testBlake2bMulti(){
+    const unsigned int b2b_in_len[9] = {0, 1, 3, 127, 128, 129, 255, 256, 300};
+    const size_t b2b_key_len[3] = {0, 16, 64};
+    uint8_t in[9][300], key[64], expected[64];
+    const unsigned char * messages[9];
+    unsigned char digests[9][64];
+    rasta_blake2b_ctx ctx;
+
+    for (int i = 0; i < 9; i++) {
+        selftest_seq(in[i], b2b_in_len[i], b2b_in_len[i] + 1);
+        messages[i] = in[i];
+    }
+    selftest_seq(key, 64, 64);
+
+    for (int k = 0; k < 3; k++) {
+        // the messages do not fill all lanes of the last batch
+        CU_ASSERT_EQUAL(0, rasta_blake2b_init(&ctx, 16, key, b2b_key_len[k]));
+        rasta_blake2b_multi(&ctx, messages, b2b_in_len, 9, digests);
+
+        for (int i = 0; i < 9; i++) {
+            rasta_blake2b(expected, 16, key, b2b_key_len[k], in[i], b2b_in_len[i]);
+            CU_ASSERT_NSTRING_EQUAL(expected, digests[i], 16);
+        }
+    }
+
+    // a state with buffered data
+    uint8_t prefix[5] = {1, 2, 3, 4, 5};
+    CU_ASSERT_EQUAL(0, rasta_blake2b_init(&ctx, 8, NULL, 0));
+    rasta_blake2b_update(&ctx, prefix, sizeof(prefix));
+    rasta_blake2b_multi(&ctx, messages, b2b_in_len, 9, digests);
+
+    for (int i = 0; i < 9; i++) {
+        rasta_blake2b_ctx copy = ctx;
+        rasta_blake2b_update(&copy, in[i], b2b_in_len[i]);
+        rasta_blake2b_final(&copy, expected);
+        CU_ASSERT_NSTRING_EQUAL(expected, digests[i], 8);
+    }
+}
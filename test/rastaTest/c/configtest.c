@@ -6,6 +6,9 @@
 #include "../headers/configtest.h"
 #include <CUnit/Basic.h>
 #include "config.h"
+#include "rastaflightrecorder.h"
+#include "rmemory.h"
+#include "udpimpairment.h"
 #include <string.h>
 
 void check_std_config() {
@@ -34,13 +37,73 @@ void check_std_config() {
     CU_ASSERT_EQUAL(cfg.values.sending.mwa, 10);
     CU_ASSERT_EQUAL(cfg.values.sending.max_packet, 3);
     CU_ASSERT_EQUAL(cfg.values.sending.diag_window, 5000);
+    CU_ASSERT_EQUAL(cfg.values.sending.receive_budget, 16);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_budget, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.receive_backpressure, 1);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_rate, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_burst, 10);
+    CU_ASSERT_EQUAL(cfg.values.sending.retransmit_rate, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.retransmit_burst, 16);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_coalesce_us, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.heartbeat_tick_ms, 0);
+#ifdef USE_STATIC_MEMORY
+    // every connection takes its slot from the static memory when the handle is created
+    CU_ASSERT_EQUAL(cfg.values.sending.max_connections, RASTA_STATIC_MAX_CONNECTIONS);
+#else
+    CU_ASSERT_EQUAL(cfg.values.sending.max_connections, 0);
+#endif
+    CU_ASSERT_EQUAL(cfg.values.sending.conreq_budget, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.reconnect_min_ms, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.reconnect_max_ms, 30000);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_wave_size, 32);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_wave_interval_ms, 5);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_max_in_flight, 128);
 
     //check redundancy
     CU_ASSERT_EQUAL(cfg.values.redundancy.connections.count,0);
     CU_ASSERT_EQUAL(cfg.values.redundancy.crc_type.width,0);
     CU_ASSERT_EQUAL(cfg.values.redundancy.t_seq, 100);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.adaptive_t_seq, 0);
     CU_ASSERT_EQUAL(cfg.values.redundancy.n_diagnose, 200);
     CU_ASSERT_EQUAL(cfg.values.redundancy.n_deferqueue_size, 4);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.max_pending_channels, 64);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.pending_pdu_limit, 16);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.udp_offload, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.count, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.seed, 1);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.shm_channels.count, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.xdp_channels.count, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.xdp_channels.queue, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.tcp_channels.count, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.count, 0);
+
+    //check real-time event loop
+    CU_ASSERT_EQUAL(cfg.values.loop.realtime_priority, 0);
+    CU_ASSERT_EQUAL(cfg.values.loop.lock_memory, 0);
+    CU_ASSERT_EQUAL(cfg.values.loop.callback_queue, 0);
+    CU_ASSERT_EQUAL(cfg.values.loop.callback_thread, 1);
+
+    //check metrics
+    CU_ASSERT_EQUAL(cfg.values.metrics.port, 0);
+    CU_ASSERT_EQUAL(cfg.values.metrics.residency, 0);
+    CU_ASSERT_STRING_EQUAL(cfg.values.metrics.stat_page, "");
+    CU_ASSERT_EQUAL(cfg.values.metrics.stat_interval_ms, 1000);
+
+    //check flight recorder
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.records, 0);
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.triggers, RASTA_FLIGHT_TRIGGER_ALL);
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.safety_errors, 5);
+    CU_ASSERT_STRING_EQUAL(cfg.values.flight_recorder.directory, ".");
+
+    //check placement
+    CU_ASSERT_EQUAL(cfg.values.placement.cpu_count, 0);
+    CU_ASSERT_EQUAL(cfg.values.placement.numa, 0);
+    CU_ASSERT_EQUAL(cfg.values.placement.huge_pages, 0);
+
+    //check hot standby
+    CU_ASSERT_EQUAL(cfg.values.replication.role, RASTA_REPLICATION_NONE);
+    CU_ASSERT_EQUAL(cfg.values.replication.address.port, 0);
+    CU_ASSERT_EQUAL(cfg.values.replication.interval_ms, 20);
 
     //cechk general
     CU_ASSERT_EQUAL(cfg.values.general.rasta_network,0);
@@ -63,12 +126,57 @@ void check_var_config() {
     fprintf(f,"RASTA_MWA = 15\n");
     fprintf(f,"RASTA_MAX_PACKET = 4\n");
     fprintf(f,"RASTA_DIAG_WINDOW = 6000\n");
+    fprintf(f,"RASTA_RECEIVE_BUDGET = 0\n");
+    fprintf(f,"RASTA_SEND_BUDGET = 8\n");
+    fprintf(f,"RASTA_RECEIVE_BACKPRESSURE = 0\n");
+    fprintf(f,"RASTA_SEND_RATE = 500\n");
+    fprintf(f,"RASTA_SEND_BURST = 5\n");
+    fprintf(f,"RASTA_RETRANSMIT_RATE = 2000\n");
+    fprintf(f,"RASTA_RETRANSMIT_BURST = 8\n");
+    fprintf(f,"RASTA_SEND_COALESCE_US = 250\n");
+    fprintf(f,"RASTA_HEARTBEAT_TICK_MS = 20\n");
+    fprintf(f,"RASTA_MAX_CONNECTIONS = 64\n");
+    fprintf(f,"RASTA_CONREQ_BUDGET = 8\n");
+    fprintf(f,"RASTA_RECONNECT_MIN_MS = 200\n");
+    fprintf(f,"RASTA_RECONNECT_MAX_MS = 10000\n");
+    fprintf(f,"RASTA_CONNECT_WAVE_SIZE = 8\n");
+    fprintf(f,"RASTA_CONNECT_WAVE_INTERVAL_MS = 20\n");
+    fprintf(f,"RASTA_CONNECT_MAX_IN_FLIGHT = 0\n");
+    fprintf(f,"RASTA_REALTIME_PRIORITY = 50\n");
+    fprintf(f,"RASTA_LOCK_MEMORY = 1\n");
+    fprintf(f,"RASTA_CALLBACK_QUEUE = 512\n");
+    fprintf(f,"RASTA_CALLBACK_THREAD = 0\n");
+    fprintf(f,"RASTA_METRICS_PORT = 9100\n");
+    fprintf(f,"RASTA_RESIDENCY_HISTOGRAMS = 1\n");
+    fprintf(f,"RASTA_STAT_PAGE = \"/dev/shm/rasta_stat\"\n");
+    fprintf(f,"RASTA_STAT_INTERVAL_MS = 250\n");
+    fprintf(f,"RASTA_FLIGHT_RECORDS = 256\n");
+    fprintf(f,"RASTA_FLIGHT_TRIGGERS = {\"TIMEOUT\"; \"CHANNEL\"}\n");
+    fprintf(f,"RASTA_FLIGHT_SAFETY_ERRORS = 3\n");
+    fprintf(f,"RASTA_FLIGHT_DIRECTORY = \"/var/log/rasta\"\n");
+    fprintf(f,"RASTA_SHARD_CPUS = {\"2\"; \"3\"; \"10\"}\n");
+    fprintf(f,"RASTA_NUMA_PLACEMENT = 1\n");
+    fprintf(f,"RASTA_HUGE_PAGES = 1\n");
+    fprintf(f,"RASTA_REPLICATION_ROLE = PRIMARY\n");
+    fprintf(f,"RASTA_REPLICATION_ADDRESS = \"10.0.0.2:9300\"\n");
+    fprintf(f,"RASTA_REPLICATION_INTERVAL_MS = 10\n");
 
     fprintf(f,"RASTA_REDUNDANCY_CONNECTIONS = {\"192.168.2.1:8000\"; \"83.23.1.2:40\"}\n");
     fprintf(f,"RASTA_CRC_TYPE = TYPE_C\n");
     fprintf(f,"RASTA_T_SEQ = 50\n");
+    fprintf(f,"RASTA_ADAPTIVE_T_SEQ = 3\n");
     fprintf(f,"RASTA_N_DIAGNOSE = 100\n");
     fprintf(f,"RASTA_N_DEFERQUEUE_SIZE = 2\n");
+    fprintf(f,"RASTA_MAX_PENDING_CHANNELS = 8\n");
+    fprintf(f,"RASTA_PENDING_PDU_LIMIT = 4\n");
+    fprintf(f,"RASTA_UDP_OFFLOAD = 1\n");
+    fprintf(f,"RASTA_IMPAIRMENTS = {\"\"; \"loss=1.5,duplicate=2,reorder=3,reorder_us=1000,delay_us=3000,jitter_us=500\"}\n");
+    fprintf(f,"RASTA_IMPAIRMENT_SEED = 42\n");
+    fprintf(f,"RASTA_SHM_CHANNELS = {\"interlocking_1\"; \"\"}\n");
+    fprintf(f,"RASTA_XDP_CHANNELS = {\"\"; \"eth2\"}\n");
+    fprintf(f,"RASTA_XDP_QUEUE = 3\n");
+    fprintf(f,"RASTA_TCP_CHANNELS = {\"tls\"; \"\"; \"tcp\"}\n");
+    fprintf(f,"RASTA_SOCKET_BUFFERS = {\"rcvbuf=4194304,sndbuf=1048576\"; \"sndbuf=65536\"}\n");
     fprintf(f,"RASTA_NETWORK = 1234\n");
     fprintf(f,"RASTA_ID = 2345\n");
 
@@ -95,6 +203,54 @@ void check_var_config() {
     CU_ASSERT_EQUAL(cfg.values.sending.mwa, 15);
     CU_ASSERT_EQUAL(cfg.values.sending.max_packet, 4);
     CU_ASSERT_EQUAL(cfg.values.sending.diag_window, 6000);
+    CU_ASSERT_EQUAL(cfg.values.sending.receive_budget, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_budget, 8);
+    CU_ASSERT_EQUAL(cfg.values.sending.receive_backpressure, 0);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_rate, 500);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_burst, 5);
+    CU_ASSERT_EQUAL(cfg.values.sending.retransmit_rate, 2000);
+    CU_ASSERT_EQUAL(cfg.values.sending.retransmit_burst, 8);
+    CU_ASSERT_EQUAL(cfg.values.sending.send_coalesce_us, 250);
+    CU_ASSERT_EQUAL(cfg.values.sending.heartbeat_tick_ms, 20);
+    CU_ASSERT_EQUAL(cfg.values.sending.max_connections, 64);
+    CU_ASSERT_EQUAL(cfg.values.sending.conreq_budget, 8);
+    CU_ASSERT_EQUAL(cfg.values.sending.reconnect_min_ms, 200);
+    CU_ASSERT_EQUAL(cfg.values.sending.reconnect_max_ms, 10000);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_wave_size, 8);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_wave_interval_ms, 20);
+    CU_ASSERT_EQUAL(cfg.values.sending.connect_max_in_flight, 0);
+
+    //check real-time event loop
+    CU_ASSERT_EQUAL(cfg.values.loop.realtime_priority, 50);
+    CU_ASSERT_EQUAL(cfg.values.loop.lock_memory, 1);
+    CU_ASSERT_EQUAL(cfg.values.loop.callback_queue, 512);
+    CU_ASSERT_EQUAL(cfg.values.loop.callback_thread, 0);
+
+    //check metrics
+    CU_ASSERT_EQUAL(cfg.values.metrics.port, 9100);
+    CU_ASSERT_EQUAL(cfg.values.metrics.residency, 1);
+    CU_ASSERT_STRING_EQUAL(cfg.values.metrics.stat_page, "/dev/shm/rasta_stat");
+    CU_ASSERT_EQUAL(cfg.values.metrics.stat_interval_ms, 250);
+
+    //check flight recorder
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.records, 256);
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.triggers, RASTA_FLIGHT_TRIGGER_TIMEOUT | RASTA_FLIGHT_TRIGGER_CHANNEL);
+    CU_ASSERT_EQUAL(cfg.values.flight_recorder.safety_errors, 3);
+    CU_ASSERT_STRING_EQUAL(cfg.values.flight_recorder.directory, "/var/log/rasta");
+
+    //check placement
+    CU_ASSERT_EQUAL_FATAL(cfg.values.placement.cpu_count, 3);
+    CU_ASSERT_EQUAL(cfg.values.placement.cpus[0], 2);
+    CU_ASSERT_EQUAL(cfg.values.placement.cpus[1], 3);
+    CU_ASSERT_EQUAL(cfg.values.placement.cpus[2], 10);
+    CU_ASSERT_EQUAL(cfg.values.placement.numa, 1);
+    CU_ASSERT_EQUAL(cfg.values.placement.huge_pages, 1);
+
+    //check hot standby
+    CU_ASSERT_EQUAL(cfg.values.replication.role, RASTA_REPLICATION_PRIMARY);
+    CU_ASSERT_EQUAL(strcmp(cfg.values.replication.address.ip, "10.0.0.2"), 0);
+    CU_ASSERT_EQUAL(cfg.values.replication.address.port, 9300);
+    CU_ASSERT_EQUAL(cfg.values.replication.interval_ms, 10);
 
     //check redundancy
     CU_ASSERT_EQUAL(cfg.values.redundancy.connections.count,2);
@@ -108,8 +264,42 @@ void check_var_config() {
     CU_ASSERT_EQUAL(cfg.values.redundancy.crc_type.polynom,0x1EDC6F41);
 
     CU_ASSERT_EQUAL(cfg.values.redundancy.t_seq, 50);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.adaptive_t_seq, 3);
     CU_ASSERT_EQUAL(cfg.values.redundancy.n_diagnose, 100);
     CU_ASSERT_EQUAL(cfg.values.redundancy.n_deferqueue_size, 2);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.max_pending_channels, 8);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.pending_pdu_limit, 4);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.udp_offload, 1);
+
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.count, 2);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.seed, 42);
+    CU_ASSERT_FALSE(udp_impairment_is_active(&cfg.values.redundancy.impairments.data[0]));
+    CU_ASSERT_EQUAL((int) (cfg.values.redundancy.impairments.data[1].loss * 10), 15);
+    CU_ASSERT_EQUAL((int) (cfg.values.redundancy.impairments.data[1].duplicate * 10), 20);
+    CU_ASSERT_EQUAL((int) (cfg.values.redundancy.impairments.data[1].reorder * 10), 30);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.data[1].reorder_us, 1000);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.data[1].delay_us, 3000);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.impairments.data[1].jitter_us, 500);
+
+    CU_ASSERT_EQUAL(cfg.values.redundancy.shm_channels.count, 2);
+    CU_ASSERT_EQUAL(strcmp(cfg.values.redundancy.shm_channels.names[0], "interlocking_1"), 0);
+    CU_ASSERT_EQUAL(strcmp(cfg.values.redundancy.shm_channels.names[1], ""), 0);
+
+    CU_ASSERT_EQUAL(cfg.values.redundancy.xdp_channels.count, 2);
+    CU_ASSERT_EQUAL(strcmp(cfg.values.redundancy.xdp_channels.interfaces[0], ""), 0);
+    CU_ASSERT_EQUAL(strcmp(cfg.values.redundancy.xdp_channels.interfaces[1], "eth2"), 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.xdp_channels.queue, 3);
+
+    CU_ASSERT_EQUAL(cfg.values.redundancy.tcp_channels.count, 3);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.tcp_channels.types[0], TRANSPORT_CHANNEL_TLS);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.tcp_channels.types[1], TRANSPORT_CHANNEL_UDP);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.tcp_channels.types[2], TRANSPORT_CHANNEL_TCP);
+
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.count, 2);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.data[0].receive, 4194304);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.data[0].send, 1048576);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.data[1].receive, 0);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.socket_buffers.data[1].send, 65536);
 
     //cechk general
     CU_ASSERT_EQUAL(cfg.values.general.rasta_network,1234);
@@ -140,4 +330,65 @@ void check_var_config() {
     CU_ASSERT_EQUAL(entr.value.number, 0xff32);
 
 
-}
\ No newline at end of file
+}
+
+void check_config_snapshot() {
+    remove("config.cfg");
+    remove("config.snapshot");
+
+    FILE *f = fopen("config.cfg", "w");
+    fprintf(f,"RASTA_T_H = 200\n");
+    fprintf(f,"RASTA_REDUNDANCY_CONNECTIONS = {\"192.168.2.1:8000\"; \"83.23.1.2:40\"}\n");
+    fprintf(f,"RASTA_CRC_TYPE = TYPE_C\n");
+    fprintf(f,"RASTA_ID = 2345\n");
+    fprintf(f,"STRING = \"Test\"\n");
+    fprintf(f,"ARRAY = {\"1st entry\"; \"2nd entry\"}\n");
+    fclose(f);
+
+    struct RastaConfig text = config_load("config.cfg");
+    CU_ASSERT_EQUAL(text.errors, 0);
+    CU_ASSERT_EQUAL(config_write_snapshot(&text, "config.snapshot"), 1);
+
+    // config_load recognizes the snapshot
+    struct RastaConfig cfg = config_load("config.snapshot");
+    CU_ASSERT_PTR_NOT_NULL(cfg.snapshot);
+    CU_ASSERT_EQUAL(cfg.dictionary.size, text.dictionary.size);
+    CU_ASSERT_EQUAL(memcmp(&cfg.values.sending, &text.values.sending, sizeof(cfg.values.sending)), 0);
+    CU_ASSERT_EQUAL(cfg.values.general.rasta_id, 2345);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.crc_type.polynom, 0x1EDC6F41);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.connections.count, 2);
+    CU_ASSERT_EQUAL(cfg.values.redundancy.connections.data[1].port, 40);
+
+    struct DictionaryEntry entr = config_get(&cfg, "string");
+    CU_ASSERT_EQUAL(entr.type, DICTIONARY_STRING);
+    CU_ASSERT_EQUAL(strcmp(entr.value.string.c, "Test"), 0);
+    entr = config_get(&cfg, "ARRAY");
+    CU_ASSERT_EQUAL(entr.type, DICTIONARY_ARRAY);
+    CU_ASSERT_EQUAL(entr.value.array.count, 2);
+    CU_ASSERT_EQUAL(strcmp(entr.value.array.data[1].c, "2nd entry"), 0);
+
+    config_free(&cfg);
+    config_free(&text);
+
+    // a changed byte is rejected
+    f = fopen("config.snapshot", "r+b");
+    fseek(f, -1, SEEK_END);
+    fputc('x', f);
+    fclose(f);
+    cfg = config_load_snapshot("config.snapshot");
+    CU_ASSERT_PTR_NULL(cfg.dictionary.data);
+    CU_ASSERT_PTR_NULL(cfg.snapshot);
+    CU_ASSERT_EQUAL(cfg.errors, 1);
+    config_free(&cfg);
+
+    // a config with errors is not written
+    f = fopen("config.cfg", "w");
+    fprintf(f,"RASTA_CRC_TYPE = TYPE_X\n");
+    fclose(f);
+    text = config_load("config.cfg");
+    CU_ASSERT_EQUAL(text.errors, 1);
+    CU_ASSERT_EQUAL(config_write_snapshot(&text, "config.snapshot"), 0);
+    config_free(&text);
+
+    remove("config.snapshot");
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <CUnit/Basic.h>
 #include <stdio.h>
+#include <stdint.h>
 
 void testDictionary() {
     struct Dictionary dict = dictionary_create(0);
@@ -61,3 +62,55 @@ void testDictionary() {
 
 }
 
+void testDictionaryManyKeys() {
+    struct Dictionary dict = dictionary_create(0);
+    char key[32];
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        CU_ASSERT_EQUAL(dictionary_addNumber(&dict, key, i), 1);
+    }
+    CU_ASSERT_EQUAL(dict.size, 500);
+
+    // a key is found in every case after the index grew, it can not be added twice
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), i % 2 ? "KEY_%d" : "Key_%d", i);
+        struct DictionaryEntry entr = dictionary_get(&dict, key);
+        CU_ASSERT_EQUAL(entr.type, DICTIONARY_NUMBER);
+        CU_ASSERT_EQUAL(entr.value.number, i);
+    }
+    CU_ASSERT_EQUAL(dictionary_addNumber(&dict, "KEY_7", 8), 0);
+    CU_ASSERT_EQUAL(dictionary_isin(&dict, "key_500"), 0);
+    CU_ASSERT_EQUAL(dictionary_isin(&dict, "key_"), 0);
+    CU_ASSERT_EQUAL(dictionary_get(&dict, "key_1x").type, DICTIONARY_ERROR);
+
+    dictionary_free(&dict);
+}
+
+void testDictionaryMap() {
+    struct DictionaryString strings[2];
+    strcpy(strings[0].c, "first");
+    strcpy(strings[1].c, "second");
+
+    struct DictionaryEntry entries[2];
+    memset(entries, 0, sizeof(entries));
+    entries[0].type = DICTIONARY_NUMBER;
+    strcpy(entries[0].key, "NUMBER");
+    entries[0].value.number = 3;
+    entries[1].type = DICTIONARY_ARRAY;
+    strcpy(entries[1].key, "ARRAY");
+    entries[1].value.array.data = (struct DictionaryString *) (uintptr_t) 0;
+    entries[1].value.array.count = 2;
+
+    struct Dictionary dict = dictionary_map(entries, 2, strings);
+    CU_ASSERT_EQUAL(dictionary_get(&dict, "number").value.number, 3);
+
+    struct DictionaryEntry entr = dictionary_get(&dict, "Array");
+    CU_ASSERT_EQUAL(entr.type, DICTIONARY_ARRAY);
+    CU_ASSERT_EQUAL(entr.value.array.count, 2);
+    CU_ASSERT_EQUAL(strcmp(entr.value.array.data[1].c, "second"), 0);
+
+    // the entries are borrowed
+    CU_ASSERT_EQUAL(dictionary_addNumber(&dict, "OTHER", 1), 0);
+    dictionary_free(&dict);
+    CU_ASSERT_EQUAL(entries[0].value.number, 3);
+}
@@ -0,0 +1,621 @@
+#define _GNU_SOURCE // sched_getaffinity
+#include <CUnit/Basic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "../headers/eventsystemTest.h"
+#include "event_system.h"
+
+#define MS_TO_NANO(ms) ((ms) * (uint64_t) 1000000)
+
+struct order_data {
+    int order[4];
+    int calls;
+};
+
+static struct order_data order_result;
+
+static int record_order(void* carry_data) {
+    int id = *(int*) carry_data;
+    if (order_result.calls < 4) {
+        order_result.order[order_result.calls] = id;
+    }
+    order_result.calls++;
+    return 0;
+}
+
+static int stop_loop(void* carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+void test_event_system_timed_event_order() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    memset(&order_result, 0, sizeof(order_result));
+
+    timed_event events[3];
+    int ids[3] = {0, 1, 2};
+    uint64_t intervals[3] = {MS_TO_NANO(100), MS_TO_NANO(40), MS_TO_NANO(60)};
+    for (int i = 0; i < 3; i++) {
+        memset(&events[i], 0, sizeof(timed_event));
+        events[i].callback = record_order;
+        events[i].carry_data = &ids[i];
+        events[i].interval = intervals[i];
+        enable_timed_event(&events[i]);
+        add_timed_event(&ev_sys, &events[i]);
+    }
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(110);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    event_system_start(&ev_sys);
+
+    CU_ASSERT_EQUAL(order_result.calls, 4);
+    CU_ASSERT_EQUAL(order_result.order[0], 1);
+    CU_ASSERT_EQUAL(order_result.order[1], 2);
+    CU_ASSERT_EQUAL(order_result.order[2], 1);
+    CU_ASSERT_EQUAL(order_result.order[3], 0);
+
+    for (int i = 0; i < 3; i++) {
+        remove_timed_event(&ev_sys, &events[i]);
+    }
+    remove_timed_event(&ev_sys, &terminator);
+    CU_ASSERT_EQUAL(ev_sys.timed_events.first, NULL);
+    CU_ASSERT_EQUAL(ev_sys.timed_event_heap.count, 0);
+}
+
+void test_event_system_disabled_timed_event() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    memset(&order_result, 0, sizeof(order_result));
+
+    int id = 0;
+    timed_event disabled_event;
+    memset(&disabled_event, 0, sizeof(timed_event));
+    disabled_event.callback = record_order;
+    disabled_event.carry_data = &id;
+    disabled_event.interval = MS_TO_NANO(1);
+    enable_timed_event(&disabled_event);
+    add_timed_event(&ev_sys, &disabled_event);
+    disable_timed_event(&disabled_event);
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(10);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    CU_ASSERT_EQUAL(ev_sys.timed_event_heap.count, 1);
+
+    event_system_start(&ev_sys);
+
+    CU_ASSERT_EQUAL(order_result.calls, 0);
+
+    remove_timed_event(&ev_sys, &disabled_event);
+    remove_timed_event(&ev_sys, &terminator);
+}
+
+struct remove_data {
+    event_system* ev_sys;
+    timed_event* event;
+    int calls;
+};
+
+static int remove_self(void* carry_data) {
+    struct remove_data* data = carry_data;
+    data->calls++;
+    remove_timed_event(data->ev_sys, data->event);
+    return 0;
+}
+
+void test_event_system_remove_in_callback() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+
+    timed_event self_removing;
+    struct remove_data data = {&ev_sys, &self_removing, 0};
+    memset(&self_removing, 0, sizeof(timed_event));
+    self_removing.callback = remove_self;
+    self_removing.carry_data = &data;
+    self_removing.interval = MS_TO_NANO(1);
+    enable_timed_event(&self_removing);
+    add_timed_event(&ev_sys, &self_removing);
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(10);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    event_system_start(&ev_sys);
+
+    CU_ASSERT_EQUAL(data.calls, 1);
+    CU_ASSERT_EQUAL(ev_sys.timed_events.first, &terminator);
+
+    remove_timed_event(&ev_sys, &terminator);
+}
+
+static int busy_event(void* carry_data) {
+    (void) carry_data;
+    evtime_t start = get_nanotime();
+    while (get_nanotime() - start < MS_TO_NANO(2)) {
+    }
+    return 0;
+}
+
+void test_event_system_profile() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    event_profile profile;
+    memset(&profile, 0, sizeof(event_profile));
+    event_profile_name(&profile, busy_event, "busy_event");
+    ev_sys.profile = &profile;
+
+    timed_event busy;
+    memset(&busy, 0, sizeof(timed_event));
+    busy.callback = busy_event;
+    busy.interval = MS_TO_NANO(5);
+    enable_timed_event(&busy);
+    add_timed_event(&ev_sys, &busy);
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(22);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    event_system_start(&ev_sys);
+
+    const struct event_profile_entry* entry = event_profile_get(&profile, busy_event);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+    CU_ASSERT_STRING_EQUAL(entry->name, "busy_event");
+    CU_ASSERT_EQUAL(entry->count, 4);
+    CU_ASSERT_EQUAL(entry->timed_count, 4);
+    CU_ASSERT(entry->max_ns >= MS_TO_NANO(2));
+    CU_ASSERT(entry->total_ns >= 4 * MS_TO_NANO(2));
+
+    // the terminator was called once and is shown with its address
+    entry = event_profile_get(&profile, stop_loop);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+    CU_ASSERT_EQUAL(entry->count, 1);
+    CU_ASSERT_PTR_NULL(entry->name);
+
+    char line[256];
+    event_profile_describe(event_profile_get(&profile, busy_event), line, sizeof(line));
+    CU_ASSERT_EQUAL(strncmp(line, "busy_event: 4 calls", strlen("busy_event: 4 calls")), 0);
+
+    event_profile_reset(&profile);
+    entry = event_profile_get(&profile, busy_event);
+    CU_ASSERT_EQUAL(entry->count, 0);
+    CU_ASSERT_STRING_EQUAL(entry->name, "busy_event");
+
+    remove_timed_event(&ev_sys, &busy);
+    remove_timed_event(&ev_sys, &terminator);
+}
+
+struct loop_time_data {
+    evtime_t first;
+    evtime_t second;
+};
+
+static int record_loop_time(void* carry_data) {
+    struct loop_time_data* data = carry_data;
+    data->first = event_system_now();
+    struct timespec pause = {0, MS_TO_NANO(2)};
+    nanosleep(&pause, NULL);
+    // the time of the iteration does not change during the callback
+    data->second = event_system_now();
+    return 1;
+}
+
+void test_event_system_loop_time() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    struct loop_time_data data;
+    memset(&data, 0, sizeof(data));
+
+    timed_event event;
+    memset(&event, 0, sizeof(timed_event));
+    event.callback = record_loop_time;
+    event.carry_data = &data;
+    event.interval = MS_TO_NANO(10);
+    enable_timed_event(&event);
+    add_timed_event(&ev_sys, &event);
+
+    evtime_t before = get_nanotime();
+    event_system_start(&ev_sys);
+
+    CU_ASSERT(data.first >= before + MS_TO_NANO(10));
+    CU_ASSERT_EQUAL(data.first, data.second);
+
+    // without a running loop the clock is read on every call
+    CU_ASSERT(event_system_now() >= data.second + MS_TO_NANO(2));
+}
+
+struct busy_poll_data {
+    int fd;
+    int reads;
+    int ticks;
+};
+
+static int read_pipe(void* carry_data) {
+    struct busy_poll_data* data = carry_data;
+    char byte;
+    if (read(data->fd, &byte, 1) == 1) {
+        data->reads++;
+    }
+    return 0;
+}
+
+static int count_ticks(void* carry_data) {
+    struct busy_poll_data* data = carry_data;
+    data->ticks++;
+    return data->ticks == 3;
+}
+
+void test_event_system_busy_poll() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    ev_sys.busy_poll = 1;
+    ev_sys.pin_cpu = 1;
+    ev_sys.busy_poll_cpu = 0;
+
+    cpu_set_t cpus_before;
+    CU_ASSERT_EQUAL(sched_getaffinity(0, sizeof(cpu_set_t), &cpus_before), 0);
+
+    int pipe_fds[2];
+    CU_ASSERT_EQUAL_FATAL(pipe(pipe_fds), 0);
+    CU_ASSERT_EQUAL(write(pipe_fds[1], "x", 1), 1);
+    struct busy_poll_data data = {pipe_fds[0], 0, 0};
+
+    fd_event readable;
+    memset(&readable, 0, sizeof(fd_event));
+    readable.callback = read_pipe;
+    readable.carry_data = &data;
+    readable.fd = pipe_fds[0];
+    enable_fd_event(&readable);
+    add_fd_event(&ev_sys, &readable, EV_READABLE);
+
+    timed_event tick;
+    memset(&tick, 0, sizeof(timed_event));
+    tick.callback = count_ticks;
+    tick.carry_data = &data;
+    tick.interval = MS_TO_NANO(5);
+    enable_timed_event(&tick);
+    add_timed_event(&ev_sys, &tick);
+
+    evtime_t before = get_nanotime();
+    event_system_start(&ev_sys);
+
+    // the loop did not sleep, but the timer still only fired when it was due
+    CU_ASSERT_EQUAL(data.reads, 1);
+    CU_ASSERT_EQUAL(data.ticks, 3);
+    CU_ASSERT(get_nanotime() >= before + 3 * MS_TO_NANO(5));
+
+    // the thread may run on its previous CPUs again
+    cpu_set_t cpus_after;
+    CU_ASSERT_EQUAL(sched_getaffinity(0, sizeof(cpu_set_t), &cpus_after), 0);
+    CU_ASSERT(CPU_EQUAL(&cpus_before, &cpus_after));
+
+    remove_fd_event(&ev_sys, &readable);
+    remove_timed_event(&ev_sys, &tick);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+void test_event_system_realtime() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    ev_sys.realtime_priority = 10;
+    ev_sys.pin_cpu = 1;
+    ev_sys.busy_poll_cpu = 0;
+#ifndef __SANITIZE_ADDRESS__
+    // the shadow memory of the address sanitizer is too large to be locked
+    ev_sys.lock_memory = 1;
+#endif
+
+    int policy_before;
+    struct sched_param param_before;
+    CU_ASSERT_EQUAL(pthread_getschedparam(pthread_self(), &policy_before, &param_before), 0);
+    cpu_set_t cpus_before;
+    CU_ASSERT_EQUAL(sched_getaffinity(0, sizeof(cpu_set_t), &cpus_before), 0);
+
+    struct busy_poll_data data = {-1, 0, 0};
+    timed_event tick;
+    memset(&tick, 0, sizeof(timed_event));
+    tick.callback = count_ticks;
+    tick.carry_data = &data;
+    tick.interval = MS_TO_NANO(2);
+    enable_timed_event(&tick);
+    add_timed_event(&ev_sys, &tick);
+
+    event_system_start(&ev_sys);
+    CU_ASSERT_EQUAL(data.ticks, 3);
+
+    // the status tells what the kernel applied, without CAP_SYS_NICE the loop keeps its policy
+    CU_ASSERT(ev_sys.realtime.priority == 10 || ev_sys.realtime.priority == 0);
+    if (ev_sys.realtime.priority == 10) {
+        CU_ASSERT_EQUAL(ev_sys.realtime.cpu, 0);
+    }
+
+    // the thread gets its policy and its CPUs back
+    int policy_after;
+    struct sched_param param_after;
+    CU_ASSERT_EQUAL(pthread_getschedparam(pthread_self(), &policy_after, &param_after), 0);
+    CU_ASSERT_EQUAL(policy_after, policy_before);
+    CU_ASSERT_EQUAL(param_after.sched_priority, param_before.sched_priority);
+    cpu_set_t cpus_after;
+    CU_ASSERT_EQUAL(sched_getaffinity(0, sizeof(cpu_set_t), &cpus_after), 0);
+    CU_ASSERT(CPU_EQUAL(&cpus_before, &cpus_after));
+
+    remove_timed_event(&ev_sys, &tick);
+    munlockall();
+}
+
+#define POST_THREADS 4
+#define POSTS_PER_THREAD 200
+
+struct post_data {
+    event_system* ev_sys;
+    int thread;
+    int next[POST_THREADS];
+    int in_order;
+    int runs;
+};
+
+struct posted_task {
+    struct post_data* data;
+    int thread;
+    int sequence;
+};
+
+static struct posted_task posted_tasks[POST_THREADS][POSTS_PER_THREAD];
+
+static int run_posted(void* carry_data) {
+    struct posted_task* task = carry_data;
+    struct post_data* data = task->data;
+    if (data->next[task->thread] == task->sequence) {
+        data->in_order++;
+    }
+    data->next[task->thread] = task->sequence + 1;
+    data->runs++;
+    return data->runs == POST_THREADS * POSTS_PER_THREAD;
+}
+
+struct post_thread_arg {
+    struct post_data* data;
+    int thread;
+};
+
+static void* post_from_thread(void* carry_data) {
+    struct post_thread_arg* arg = carry_data;
+    for (int i = 0; i < POSTS_PER_THREAD; i++) {
+        struct posted_task* task = &posted_tasks[arg->thread][i];
+        task->data = arg->data;
+        task->thread = arg->thread;
+        task->sequence = i;
+        while (!event_system_post(arg->data->ev_sys, run_posted, task)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_event_system_post() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    event_system_enable_posting(&ev_sys, 16);
+
+    struct post_data data;
+    memset(&data, 0, sizeof(data));
+    data.ev_sys = &ev_sys;
+
+    // the threads post while the loop runs, the full queue makes them wait for it
+    pthread_t threads[POST_THREADS];
+    struct post_thread_arg args[POST_THREADS];
+    for (int i = 0; i < POST_THREADS; i++) {
+        args[i].data = &data;
+        args[i].thread = i;
+        CU_ASSERT_EQUAL_FATAL(pthread_create(&threads[i], NULL, post_from_thread, &args[i]), 0);
+    }
+
+    // the last task stops the loop
+    event_system_start(&ev_sys);
+    for (int i = 0; i < POST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CU_ASSERT_EQUAL(data.runs, POST_THREADS * POSTS_PER_THREAD);
+    CU_ASSERT_EQUAL(data.in_order, POST_THREADS * POSTS_PER_THREAD);
+    for (int i = 0; i < POST_THREADS; i++) {
+        CU_ASSERT_EQUAL(data.next[i], POSTS_PER_THREAD);
+    }
+
+    event_system_disable_posting(&ev_sys);
+    CU_ASSERT_PTR_NULL(ev_sys.tasks);
+}
+
+static int count_posted(void* carry_data) {
+    (*(int*) carry_data)++;
+    return 0;
+}
+
+void test_event_system_post_batch() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    int runs = 0;
+
+    // nothing is queued before posting is enabled
+    CU_ASSERT_EQUAL(event_system_post(&ev_sys, count_posted, &runs), 0);
+
+    event_system_enable_posting(&ev_sys, 2 * EV_TASK_BATCH);
+    for (int i = 0; i < 2 * EV_TASK_BATCH; i++) {
+        CU_ASSERT_EQUAL(event_system_post(&ev_sys, count_posted, &runs), 1);
+    }
+    CU_ASSERT_EQUAL(event_system_post(&ev_sys, count_posted, &runs), 0);
+
+    // a wakeup runs a single batch and signals the eventfd again for the rest
+    CU_ASSERT_EQUAL(ev_sys.tasks_event.callback(ev_sys.tasks_event.carry_data), 0);
+    CU_ASSERT_EQUAL(runs, EV_TASK_BATCH);
+    CU_ASSERT_EQUAL(ev_sys.tasks_signaled, 1);
+    CU_ASSERT_EQUAL(event_system_post(&ev_sys, count_posted, &runs), 1);
+
+    CU_ASSERT_EQUAL(ev_sys.tasks_event.callback(ev_sys.tasks_event.carry_data), 0);
+    CU_ASSERT_EQUAL(runs, 2 * EV_TASK_BATCH);
+    CU_ASSERT_EQUAL(ev_sys.tasks_event.callback(ev_sys.tasks_event.carry_data), 0);
+    CU_ASSERT_EQUAL(runs, 2 * EV_TASK_BATCH + 1);
+    CU_ASSERT_EQUAL(ev_sys.tasks_signaled, 0);
+
+    event_system_disable_posting(&ev_sys);
+}
+
+struct virtual_time_data {
+    evtime_t start;
+    int heartbeats;
+    int hours;
+    int hours_on_time;
+};
+
+static int count_heartbeat(void* carry_data) {
+    struct virtual_time_data* data = carry_data;
+    data->heartbeats++;
+    return 0;
+}
+
+static int record_hour(void* carry_data) {
+    struct virtual_time_data* data = carry_data;
+    data->hours++;
+    if (event_system_now() == data->start + (evtime_t) data->hours * MS_TO_NANO(3600 * 1000)) {
+        data->hours_on_time++;
+    }
+    return 0;
+}
+
+void test_event_system_virtual_time() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    event_clock clock;
+    memset(&clock, 0, sizeof(event_clock));
+    event_clock_init_virtual(&clock, get_nanotime());
+    ev_sys.clock = &clock;
+    struct virtual_time_data data;
+    memset(&data, 0, sizeof(data));
+    data.start = clock.virtual_now;
+
+    timed_event heartbeat, hour, terminator;
+    memset(&heartbeat, 0, sizeof(timed_event));
+    heartbeat.callback = count_heartbeat;
+    heartbeat.carry_data = &data;
+    heartbeat.interval = MS_TO_NANO(1000);
+    enable_timed_event(&heartbeat);
+    add_timed_event(&ev_sys, &heartbeat);
+
+    memset(&hour, 0, sizeof(timed_event));
+    hour.callback = record_hour;
+    hour.carry_data = &data;
+    hour.interval = MS_TO_NANO(3600 * 1000);
+    enable_timed_event(&hour);
+    add_timed_event(&ev_sys, &hour);
+
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(24 * 3600 * 1000 + 500);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    evtime_t before = get_nanotime();
+    event_system_start(&ev_sys);
+
+    // a day passed without sleeping, every timer fired exactly when it was due
+    CU_ASSERT_EQUAL(data.heartbeats, 24 * 3600);
+    CU_ASSERT_EQUAL(data.hours, 24);
+    CU_ASSERT_EQUAL(data.hours_on_time, 24);
+    CU_ASSERT_EQUAL(clock.virtual_now, data.start + MS_TO_NANO(24 * 3600 * 1000 + 500));
+    CU_ASSERT(get_nanotime() - before < MS_TO_NANO(10 * 1000));
+
+    remove_timed_event(&ev_sys, &heartbeat);
+    remove_timed_event(&ev_sys, &hour);
+    remove_timed_event(&ev_sys, &terminator);
+}
+
+struct virtual_fd_data {
+    int fds[2];
+    evtime_t written;
+    evtime_t read;
+    int reads;
+};
+
+static int write_virtual_pipe(void* carry_data) {
+    struct virtual_fd_data* data = carry_data;
+    data->written = event_system_now();
+    CU_ASSERT_EQUAL(write(data->fds[1], "x", 1), 1);
+    return 0;
+}
+
+static int read_virtual_pipe(void* carry_data) {
+    struct virtual_fd_data* data = carry_data;
+    char byte;
+    if (read(data->fds[0], &byte, 1) == 1) {
+        data->read = event_system_now();
+        data->reads++;
+    }
+    return 0;
+}
+
+void test_event_system_virtual_time_fd() {
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    event_clock clock;
+    memset(&clock, 0, sizeof(event_clock));
+    event_clock_init_virtual(&clock, MS_TO_NANO(1000));
+    ev_sys.clock = &clock;
+    struct virtual_fd_data data;
+    memset(&data, 0, sizeof(data));
+    CU_ASSERT_EQUAL_FATAL(pipe(data.fds), 0);
+
+    fd_event readable;
+    memset(&readable, 0, sizeof(fd_event));
+    readable.callback = read_virtual_pipe;
+    readable.carry_data = &data;
+    readable.fd = data.fds[0];
+    enable_fd_event(&readable);
+    add_fd_event(&ev_sys, &readable, EV_READABLE);
+
+    timed_event writer, terminator;
+    memset(&writer, 0, sizeof(timed_event));
+    writer.callback = write_virtual_pipe;
+    writer.carry_data = &data;
+    writer.interval = MS_TO_NANO(10);
+    enable_timed_event(&writer);
+    add_timed_event(&ev_sys, &writer);
+
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_loop;
+    terminator.interval = MS_TO_NANO(3600 * 1000 + 5);
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+
+    event_system_start(&ev_sys);
+
+    // the time did not move on while the written byte was waiting
+    CU_ASSERT_EQUAL(data.reads, 360000);
+    CU_ASSERT_EQUAL(data.written, MS_TO_NANO(1000) + MS_TO_NANO(3600 * 1000));
+    CU_ASSERT_EQUAL(data.read, data.written);
+
+    remove_fd_event(&ev_sys, &readable);
+    remove_timed_event(&ev_sys, &writer);
+    remove_timed_event(&ev_sys, &terminator);
+    close(data.fds[0]);
+    close(data.fds[1]);
+}
@@ -1,4 +1,7 @@
 #include <CUnit/Basic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
 #include <fifo.h>
 #include <rmemory.h>
 #include <rastautil.h>
@@ -7,45 +10,38 @@
 void test_push(){
     fifo_t * fifo = fifo_init(3);
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
-    CU_ASSERT_EQUAL(fifo->head, NULL);
-    CU_ASSERT_EQUAL(fifo->tail, NULL);
 
     struct RastaByteArray elem;
     allocateRastaByteArray(&elem, 10);
     rmemcpy(elem.bytes, "Hello", 6);
 
-    fifo_push(fifo, &elem);
-
+    CU_ASSERT_EQUAL(fifo_push(fifo, &elem), 1);
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 1);
-    CU_ASSERT_EQUAL(fifo->head->data, &elem);
-    CU_ASSERT_EQUAL(fifo->tail->data, &elem);
-    CU_ASSERT_EQUAL(fifo->head->next, NULL);
-    CU_ASSERT_EQUAL(fifo->tail->next, NULL);
 
     char * test_str = rmalloc(10);
     rmemcpy(test_str, "Hello", 6);
 
-    fifo_push(fifo, test_str);
-
+    CU_ASSERT_EQUAL(fifo_push(fifo, test_str), 1);
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 2);
-    CU_ASSERT_EQUAL(fifo->head->data, &elem);
-    CU_ASSERT_EQUAL(fifo->tail->data, test_str);
-    CU_ASSERT_EQUAL(fifo->head->next->data, test_str);
 
-    struct fifo_element * struct_elem  = rmalloc(sizeof(struct fifo_element));
-    fifo_push(fifo, struct_elem);
+    struct RastaByteArray * struct_elem  = rmalloc(sizeof(struct RastaByteArray));
+    CU_ASSERT_EQUAL(fifo_push(fifo, struct_elem), 1);
+    CU_ASSERT_EQUAL(fifo_get_size(fifo), 3);
 
+    // full
+    CU_ASSERT_EQUAL(fifo_push(fifo, &elem), 0);
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 3);
-    CU_ASSERT_EQUAL(fifo->head->data, &elem);
-    CU_ASSERT_EQUAL(fifo->tail->data, struct_elem);
-    CU_ASSERT_EQUAL(fifo->head->next->data, test_str);
-    CU_ASSERT_EQUAL(fifo->tail->next, NULL);
 
-    fifo_push(fifo, &elem);
+    // NULL can not be told apart from an empty FIFO
+    CU_ASSERT_EQUAL(fifo_push(fifo, NULL), 0);
 
-    CU_ASSERT_EQUAL(fifo_get_size(fifo), 3);
+    // the elements keep their order
+    CU_ASSERT_EQUAL(fifo_pop(fifo), &elem);
+    CU_ASSERT_EQUAL(fifo_pop(fifo), test_str);
+    CU_ASSERT_EQUAL(fifo_pop(fifo), struct_elem);
 
     fifo_destroy(fifo);
+    freeRastaByteArray(&elem);
     rfree(test_str);
     rfree(struct_elem);
 }
@@ -53,8 +49,8 @@ void test_push(){
 void test_pop(){
     fifo_t * fifo = fifo_init(3);
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
-    CU_ASSERT_EQUAL(fifo->head, NULL);
-    CU_ASSERT_EQUAL(fifo->tail, NULL);
+    CU_ASSERT_PTR_NULL(fifo_pop(fifo));
+    CU_ASSERT_PTR_NULL(fifo_peek(fifo));
 
     int elem = 42;
 
@@ -65,38 +61,120 @@ void test_pop(){
 
     fifo_push(fifo, test_str);
 
-    struct fifo_element * struct_elem  = rmalloc(sizeof(struct fifo_element));
+    struct RastaByteArray * struct_elem  = rmalloc(sizeof(struct RastaByteArray));
     fifo_push(fifo, struct_elem);
 
+    // peeking does not remove the element
+    CU_ASSERT_EQUAL(fifo_peek(fifo), &elem);
+    CU_ASSERT_EQUAL(fifo_get_size(fifo), 3);
+
     int res = *(int *)fifo_pop(fifo);
 
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 2);
     CU_ASSERT_EQUAL(res, elem);
-    CU_ASSERT_EQUAL(fifo->head->data, test_str);
-    CU_ASSERT_EQUAL(fifo->tail->data, struct_elem);
-    CU_ASSERT_EQUAL(fifo->head->next, fifo->tail);
-    CU_ASSERT_EQUAL(fifo->tail->next, NULL);
 
     char * res_str = (char *)fifo_pop(fifo);
 
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 1);
     CU_ASSERT_EQUAL(res_str, test_str);
-    CU_ASSERT_EQUAL(fifo->head->data, struct_elem);
-    CU_ASSERT_EQUAL(fifo->tail->data, struct_elem);
-    CU_ASSERT_EQUAL(fifo->head->next, NULL);
-    CU_ASSERT_EQUAL(fifo->tail->next, NULL);
 
-    struct fifo_element * res_struct = (struct fifo_element *)fifo_pop(fifo);
+    struct RastaByteArray * res_struct = (struct RastaByteArray *)fifo_pop(fifo);
 
     CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
     CU_ASSERT_EQUAL(res_struct, struct_elem);
-    CU_ASSERT_EQUAL(fifo->head, NULL);
-    CU_ASSERT_EQUAL(fifo->tail, NULL);
 
     void * emtpy_pop_res = fifo_pop(fifo);
     CU_ASSERT_EQUAL(emtpy_pop_res, NULL);
+    CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
 
     fifo_destroy(fifo);
     rfree(test_str);
     rfree(struct_elem);
-}
\ No newline at end of file
+}
+
+void test_fifo_wrap_around(){
+    int values[5];
+    fifo_t * fifo = fifo_init(3);
+
+    // the elements move over the end of the ring several times
+    for (unsigned int round = 0; round < 10; round++) {
+        for (unsigned int i = 0; i < 2; i++) {
+            CU_ASSERT_EQUAL(fifo_push(fifo, &values[(2 * round + i) % 5]), 1);
+        }
+        CU_ASSERT_EQUAL(fifo_get_size(fifo), 2);
+        for (unsigned int i = 0; i < 2; i++) {
+            CU_ASSERT_EQUAL(fifo_pop(fifo), &values[(2 * round + i) % 5]);
+        }
+        CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
+    }
+
+    // a FIFO without slots is always full
+    fifo_t * empty = fifo_init(0);
+    CU_ASSERT_EQUAL(fifo_push(empty, &values[0]), 0);
+    CU_ASSERT_PTR_NULL(fifo_pop(empty));
+
+    fifo_destroy(empty);
+    fifo_destroy(fifo);
+}
+
+void test_fifo_counter_wrap(){
+    int values[20];
+    // not a power of 2, like a send_max of 20
+    fifo_t * fifo = fifo_init(20);
+    fifo_reset(fifo, UINT_MAX - 4);
+
+    for (unsigned int round = 0; round < 3; round++) {
+        for (unsigned int i = 0; i < 20; i++) {
+            CU_ASSERT_EQUAL(fifo_push(fifo, &values[i]), 1);
+        }
+        CU_ASSERT_EQUAL(fifo_push(fifo, &values[0]), 0);
+        CU_ASSERT_EQUAL(fifo_get_size(fifo), 20);
+        for (unsigned int i = 0; i < 20; i++) {
+            CU_ASSERT_EQUAL(fifo_peek(fifo), &values[i]);
+            CU_ASSERT_EQUAL(fifo_pop(fifo), &values[i]);
+        }
+        CU_ASSERT_PTR_NULL(fifo_pop(fifo));
+    }
+
+    fifo_destroy(fifo);
+}
+
+#define SPSC_COUNT 100000
+
+static unsigned int spsc_values[SPSC_COUNT];
+
+static void * spsc_producer(void * carry_data){
+    fifo_t * fifo = carry_data;
+    for (unsigned int i = 0; i < SPSC_COUNT; i++) {
+        spsc_values[i] = i;
+        while (!fifo_push(fifo, &spsc_values[i])) {
+            // full, let the consumer run
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_fifo_spsc(){
+    fifo_t * fifo = fifo_init(8);
+    pthread_t producer;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&producer, NULL, spsc_producer, fifo), 0);
+
+    unsigned int in_order = 1;
+    for (unsigned int i = 0; i < SPSC_COUNT; i++) {
+        unsigned int * value;
+        while ((value = fifo_pop(fifo)) == NULL) {
+            // empty, let the producer run
+            sched_yield();
+        }
+        // the value was written before the element was pushed
+        if (value != &spsc_values[i] || *value != i) {
+            in_order = 0;
+        }
+    }
+    CU_ASSERT(in_order);
+
+    pthread_join(producer, NULL);
+    CU_ASSERT_EQUAL(fifo_get_size(fifo), 0);
+    fifo_destroy(fifo);
+}
@@ -0,0 +1,99 @@
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../headers/loggingTest.h"
+#include "logging.h"
+
+/**
+ * counts the lines of a file that contain a string
+ */
+static unsigned long count_lines(const char * path, const char * text) {
+    FILE * file = fopen(path, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+
+    unsigned long count = 0;
+    char line[LOGGER_MAX_MSG_SIZE];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strstr(line, text) != NULL) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+void test_logger_async_file() {
+    char path[] = "/tmp/rasta_logger_test_XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+
+    struct logger_t logger = logger_init(LOG_LEVEL_INFO, LOGGER_TYPE_FILE);
+    logger_set_log_file(&logger, path);
+    logger_enable_async(&logger, 64);
+
+    for (int i = 0; i < 10; i++) {
+        logger_log(&logger, LOG_LEVEL_INFO, "TEST", "message %d", i);
+    }
+    // filtered out like in a synchronous logger
+    logger_log(&logger, LOG_LEVEL_DEBUG, "TEST", "message debug");
+
+    CU_ASSERT_EQUAL(logger_dropped_messages(&logger), 0);
+    logger_destroy(&logger);
+
+    CU_ASSERT_EQUAL(count_lines(path, "[TEST] message"), 10);
+    CU_ASSERT_EQUAL(count_lines(path, "[TEST] message 9"), 1);
+    CU_ASSERT_EQUAL(count_lines(path, "debug"), 0);
+    unlink(path);
+}
+
+void test_logger_async_dropped() {
+    char path[] = "/tmp/rasta_logger_test_XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+
+    struct logger_t logger = logger_init(LOG_LEVEL_INFO, LOGGER_TYPE_FILE);
+    logger_set_log_file(&logger, path);
+    logger_enable_async(&logger, 2);
+
+    for (int i = 0; i < 1000; i++) {
+        logger_log(&logger, LOG_LEVEL_INFO, "TEST", "message %d", i);
+    }
+
+    unsigned long dropped = logger_dropped_messages(&logger);
+    logger_destroy(&logger);
+
+    // every message is either written or counted as dropped
+    CU_ASSERT_EQUAL(count_lines(path, "[TEST] message") + dropped, 1000);
+    if (dropped > 0) {
+        CU_ASSERT(count_lines(path, "log messages dropped") > 0);
+    }
+    unlink(path);
+}
+
+static int evaluated_arguments;
+
+static int count_evaluation(int value) {
+    evaluated_arguments++;
+    return value;
+}
+
+void test_logger_level_check() {
+    struct logger_t logger = logger_init(LOG_LEVEL_ERROR, LOGGER_TYPE_FILE);
+    evaluated_arguments = 0;
+
+    // the arguments of filtered messages are not evaluated
+    logger_log(&logger, LOG_LEVEL_INFO, "TEST", "message %d", count_evaluation(1));
+    logger_log(NULL, LOG_LEVEL_ERROR, "TEST", "message %d", count_evaluation(2));
+    logger_hexdump(&logger, LOG_LEVEL_DEBUG, "data", 4, "header %d", count_evaluation(3));
+    CU_ASSERT_EQUAL(evaluated_arguments, 0);
+
+    CU_ASSERT(logger_enabled(&logger, LOG_LEVEL_ERROR));
+    CU_ASSERT(!logger_enabled(&logger, LOG_LEVEL_INFO));
+    CU_ASSERT(!logger_enabled(NULL, LOG_LEVEL_ERROR));
+
+    logger_destroy(&logger);
+}
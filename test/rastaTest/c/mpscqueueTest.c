@@ -0,0 +1,124 @@
+#include <CUnit/Basic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../headers/mpscqueueTest.h"
+#include "mpscqueue.h"
+
+struct test_element {
+    unsigned int producer;
+    unsigned int value;
+};
+
+void test_mpsc_queue_order() {
+    // rounded up to 4 slots
+    mpsc_queue_t * queue = mpsc_queue_init(3, sizeof(struct test_element));
+    CU_ASSERT_PTR_NULL(mpsc_queue_front(queue));
+
+    // the elements move over the end of the ring several times
+    for (unsigned int round = 0; round < 3; round++) {
+        for (unsigned int i = 0; i < 4; i++) {
+            struct test_element * element = mpsc_queue_reserve(queue);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(element);
+            element->value = round * 4 + i;
+            mpsc_queue_commit(queue, element);
+        }
+
+        // full
+        CU_ASSERT_PTR_NULL(mpsc_queue_reserve(queue));
+
+        for (unsigned int i = 0; i < 4; i++) {
+            struct test_element * element = mpsc_queue_front(queue);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(element);
+            CU_ASSERT_EQUAL(element->value, round * 4 + i);
+            mpsc_queue_release(queue);
+        }
+        CU_ASSERT_PTR_NULL(mpsc_queue_front(queue));
+    }
+
+    mpsc_queue_destroy(queue);
+}
+
+void test_mpsc_queue_uncommitted() {
+    mpsc_queue_t * queue = mpsc_queue_init(4, sizeof(struct test_element));
+
+    struct test_element * first = mpsc_queue_reserve(queue);
+    struct test_element * second = mpsc_queue_reserve(queue);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+    CU_ASSERT(first != second);
+
+    second->value = 2;
+    mpsc_queue_commit(queue, second);
+    CU_ASSERT_PTR_NULL(mpsc_queue_front(queue));
+
+    first->value = 1;
+    mpsc_queue_commit(queue, first);
+    CU_ASSERT_EQUAL(((struct test_element *) mpsc_queue_front(queue))->value, 1);
+    mpsc_queue_release(queue);
+    CU_ASSERT_EQUAL(((struct test_element *) mpsc_queue_front(queue))->value, 2);
+    mpsc_queue_release(queue);
+    CU_ASSERT_PTR_NULL(mpsc_queue_front(queue));
+
+    mpsc_queue_destroy(queue);
+}
+
+#define MPSC_PRODUCERS 4
+#define MPSC_COUNT 20000
+
+struct producer_data {
+    mpsc_queue_t * queue;
+    unsigned int producer;
+};
+
+static void * mpsc_producer(void * carry_data) {
+    struct producer_data * data = carry_data;
+    for (unsigned int i = 0; i < MPSC_COUNT; i++) {
+        struct test_element * element;
+        while ((element = mpsc_queue_reserve(data->queue)) == NULL) {
+            // full, let the consumer run
+            sched_yield();
+        }
+        element->producer = data->producer;
+        element->value = i;
+        mpsc_queue_commit(data->queue, element);
+    }
+    return NULL;
+}
+
+void test_mpsc_queue_threads() {
+    mpsc_queue_t * queue = mpsc_queue_init(16, sizeof(struct test_element));
+    pthread_t producers[MPSC_PRODUCERS];
+    struct producer_data data[MPSC_PRODUCERS];
+
+    for (unsigned int i = 0; i < MPSC_PRODUCERS; i++) {
+        data[i].queue = queue;
+        data[i].producer = i;
+        CU_ASSERT_EQUAL_FATAL(pthread_create(&producers[i], NULL, mpsc_producer, &data[i]), 0);
+    }
+
+    // the elements of every producer arrive in the order they were added
+    unsigned int next[MPSC_PRODUCERS] = { 0 };
+    unsigned int in_order = 1;
+    for (unsigned int received = 0; received < MPSC_PRODUCERS * MPSC_COUNT; received++) {
+        struct test_element * element;
+        while ((element = mpsc_queue_front(queue)) == NULL) {
+            // empty, let the producers run
+            sched_yield();
+        }
+        if (element->producer >= MPSC_PRODUCERS || element->value != next[element->producer]) {
+            in_order = 0;
+        } else {
+            next[element->producer]++;
+        }
+        mpsc_queue_release(queue);
+    }
+    CU_ASSERT(in_order);
+
+    for (unsigned int i = 0; i < MPSC_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+        CU_ASSERT_EQUAL(next[i], MPSC_COUNT);
+    }
+    CU_ASSERT_PTR_NULL(mpsc_queue_front(queue));
+
+    mpsc_queue_destroy(queue);
+}
@@ -1,45 +1,95 @@
-//
-// Created by erica on 04/07/2022.
-//
-#include <key_exchange.h>
-#include <logging.h>
-#include <CUnit/Basic.h>
-
-#ifdef ENABLE_OPAQUE
-#include <opaque.h>
-
-void opaque_wrapper_test(){
-    const char *psk = "MySecretPW";
-    struct key_exchange_state kex_state;
-    const uint32_t server_id = 42, client_id=21, isn=0xdeadbeef;
-    struct logger_t logger = logger_init(LOG_LEVEL_DEBUG,LOGGER_TYPE_CONSOLE);
-    uint8_t server_session_key[OPAQUE_SHARED_SECRETBYTES];
-    uint8_t server_user_auth[crypto_auth_hmacsha512_BYTES];
-    uint8_t client_user_auth[crypto_auth_hmacsha512_BYTES];
-    int ret;
-
-    ret = key_exchange_prepare_from_psk(&kex_state,psk,server_id,client_id,&logger);
-    CU_ASSERT_EQUAL(ret,0);
-
-    ret = key_exchange_prepare_credential_request(&kex_state,psk,&logger);
-    CU_ASSERT_EQUAL(ret,0);
-
-    ret = kex_prepare_credential_response(&kex_state,kex_state.client_public,sizeof(kex_state.client_public),server_id,client_id,isn,&logger);
-    CU_ASSERT_EQUAL(ret,0);
-    memcpy(server_session_key,kex_state.session_key,OPAQUE_SHARED_SECRETBYTES);
-    memcpy(server_user_auth,kex_state.user_auth_server,crypto_auth_hmacsha512_BYTES);
-
-    ret = kex_recover_credential(&kex_state,kex_state.certificate_response,sizeof(kex_state.certificate_response),client_id,server_id,isn,&logger);
-    CU_ASSERT_EQUAL(ret,0);
-
-    // server and client should calculate the same key
-    CU_ASSERT_NSTRING_EQUAL(kex_state.session_key,server_session_key,OPAQUE_SHARED_SECRETBYTES);
-
-    memcpy(client_user_auth,kex_state.user_auth_server,crypto_auth_hmacsha512_BYTES);
-    memcpy(kex_state.user_auth_server,client_user_auth,crypto_auth_hmacsha512_BYTES);
-
-    ret = kex_authenticate_user(&kex_state,client_user_auth,sizeof(client_user_auth),&logger);
-    CU_ASSERT_EQUAL(ret,0);
-
-}
-#endif
\ No newline at end of file
+//
+// Created by erica on 04/07/2022.
+//
+#include <key_exchange.h>
+#include <logging.h>
+#include <CUnit/Basic.h>
+
+#ifdef ENABLE_OPAQUE
+#include <opaque.h>
+
+void opaque_wrapper_test(){
+    const char *psk = "MySecretPW";
+    struct key_exchange_state kex_state;
+    const uint32_t server_id = 42, client_id=21, isn=0xdeadbeef;
+    struct logger_t logger = logger_init(LOG_LEVEL_DEBUG,LOGGER_TYPE_CONSOLE);
+    uint8_t server_session_key[OPAQUE_SHARED_SECRETBYTES];
+    uint8_t server_user_auth[crypto_auth_hmacsha512_BYTES];
+    uint8_t client_user_auth[crypto_auth_hmacsha512_BYTES];
+    int ret;
+
+    ret = key_exchange_prepare_from_psk(&kex_state,psk,server_id,client_id,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+    ret = key_exchange_prepare_credential_request(&kex_state,psk,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+    ret = kex_prepare_credential_response(&kex_state,kex_state.client_public,sizeof(kex_state.client_public),server_id,client_id,isn,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    memcpy(server_session_key,kex_state.session_key,OPAQUE_SHARED_SECRETBYTES);
+    memcpy(server_user_auth,kex_state.user_auth_server,crypto_auth_hmacsha512_BYTES);
+
+    ret = kex_recover_credential(&kex_state,kex_state.certificate_response,sizeof(kex_state.certificate_response),client_id,server_id,isn,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+    // server and client should calculate the same key
+    CU_ASSERT_NSTRING_EQUAL(kex_state.session_key,server_session_key,OPAQUE_SHARED_SECRETBYTES);
+
+    memcpy(client_user_auth,kex_state.user_auth_server,crypto_auth_hmacsha512_BYTES);
+    memcpy(kex_state.user_auth_server,client_user_auth,crypto_auth_hmacsha512_BYTES);
+
+    ret = kex_authenticate_user(&kex_state,client_user_auth,sizeof(client_user_auth),&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+}
+
+void opaque_secrets_test(){
+    const char *psk = "MySecretPW";
+    struct key_exchange_state server_state, client_state;
+    const uint32_t server_id = 42, client_id=21, isn=0xdeadbeef;
+    struct logger_t logger = logger_init(LOG_LEVEL_DEBUG,LOGGER_TYPE_CONSOLE);
+    struct key_exchange_secrets secrets;
+    uint8_t first_record[OPAQUE_USER_RECORD_LEN];
+    int ret;
+
+    ret = key_exchange_secrets_init(&secrets,&logger);
+    CU_ASSERT_EQUAL_FATAL(ret,0);
+
+    // the rekeying server reuses the record of the first key exchange
+    ret = key_exchange_prepare_from_psk_cached(&secrets,&server_state,psk,server_id,client_id,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    memcpy(first_record,server_state.user_record,sizeof(first_record));
+    memset(server_state.user_record,0,sizeof(server_state.user_record));
+    ret = key_exchange_prepare_from_psk_cached(&secrets,&server_state,psk,server_id,client_id,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    CU_ASSERT_EQUAL(memcmp(server_state.user_record,first_record,sizeof(first_record)),0);
+    CU_ASSERT_EQUAL(secrets.record_hits,1);
+    CU_ASSERT_EQUAL(secrets.record_misses,1);
+
+    // other IDs get their own record
+    ret = key_exchange_prepare_from_psk_cached(&secrets,&server_state,psk,server_id,client_id + 1,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    CU_ASSERT_EQUAL(secrets.record_misses,2);
+    ret = key_exchange_prepare_from_psk_cached(&secrets,&server_state,psk,server_id,client_id,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+    // the client secret is lent from the pool and given back when the credentials are recovered
+    ret = key_exchange_prepare_credential_request_pooled(&secrets,&client_state,psk,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    CU_ASSERT_PTR_EQUAL(client_state.secret_owner,&secrets);
+    CU_ASSERT_EQUAL(secrets.secret_taken[0],1);
+
+    ret = kex_prepare_credential_response(&server_state,client_state.client_public,sizeof(client_state.client_public),server_id,client_id,isn,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    ret = kex_recover_credential(&client_state,server_state.certificate_response,sizeof(server_state.certificate_response),client_id,server_id,isn,&logger);
+    CU_ASSERT_EQUAL(ret,0);
+    CU_ASSERT_NSTRING_EQUAL(client_state.session_key,server_state.session_key,OPAQUE_SHARED_SECRETBYTES);
+    CU_ASSERT_PTR_NULL(client_state.secret_owner);
+    CU_ASSERT_EQUAL(secrets.secret_taken[0],0);
+
+    ret = kex_authenticate_user(&server_state,client_state.user_auth_server,sizeof(client_state.user_auth_server),&logger);
+    CU_ASSERT_EQUAL(ret,0);
+
+    key_exchange_secrets_free(&secrets);
+}
+#endif
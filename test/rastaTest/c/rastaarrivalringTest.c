@@ -0,0 +1,74 @@
+#include <CUnit/Basic.h>
+#include "../headers/rastaarrivalringTest.h"
+#include "rastaarrivalring.h"
+
+void test_arrival_ring_put_get() {
+    struct rasta_arrival_ring ring;
+    rasta_arrival_ring_init(&ring, 40);
+    CU_ASSERT_EQUAL(ring.capacity, 64);
+
+    uint32_t received_at = 0;
+    CU_ASSERT_FALSE(rasta_arrival_ring_get(&ring, 0, &received_at));
+
+    // one more arrival than slots, the first one is overwritten
+    for (uint32_t i = 0; i <= 64; i++) {
+        rasta_arrival_ring_put(&ring, 100 + i, 5000 + i);
+    }
+    CU_ASSERT_EQUAL(ring.count, 65);
+    CU_ASSERT_FALSE(rasta_arrival_ring_get(&ring, 100, &received_at));
+    CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, 101, &received_at));
+    CU_ASSERT_EQUAL(received_at, 5001);
+    CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, 164, &received_at));
+    CU_ASSERT_EQUAL(received_at, 5064);
+
+    // a new window forgets all arrivals
+    rasta_arrival_ring_clear(&ring);
+    CU_ASSERT_EQUAL(ring.count, 0);
+    CU_ASSERT_FALSE(rasta_arrival_ring_get(&ring, 164, &received_at));
+    rasta_arrival_ring_put(&ring, 164, 6000);
+    CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, 164, &received_at));
+    CU_ASSERT_EQUAL(received_at, 6000);
+
+    // the arrival time 0 is a valid time
+    rasta_arrival_ring_put(&ring, 0, 0);
+    received_at = 1;
+    CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, 0, &received_at));
+    CU_ASSERT_EQUAL(received_at, 0);
+
+    rasta_arrival_ring_free(&ring);
+}
+
+void test_arrival_ring_resize() {
+    struct rasta_arrival_ring ring;
+    rasta_arrival_ring_init(&ring, 8);
+
+    rasta_arrival_ring_put(&ring, 1, 10);
+    rasta_arrival_ring_clear(&ring);
+    for (uint32_t i = 2; i < 10; i++) {
+        rasta_arrival_ring_put(&ring, i, 10 * i);
+    }
+
+    // growing keeps the arrivals of the window, but not the older ones
+    rasta_arrival_ring_resize(&ring, 32);
+    CU_ASSERT_EQUAL(ring.capacity, 32);
+    CU_ASSERT_EQUAL(ring.count, 8);
+    uint32_t received_at;
+    CU_ASSERT_FALSE(rasta_arrival_ring_get(&ring, 1, &received_at));
+    for (uint32_t i = 2; i < 10; i++) {
+        CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, i, &received_at));
+        CU_ASSERT_EQUAL(received_at, 10 * i);
+    }
+
+    // shrinking keeps the newer of two arrivals that share a slot
+    rasta_arrival_ring_resize(&ring, 4);
+    CU_ASSERT_EQUAL(ring.capacity, 4);
+    for (uint32_t i = 2; i < 6; i++) {
+        CU_ASSERT_FALSE(rasta_arrival_ring_get(&ring, i, &received_at));
+    }
+    for (uint32_t i = 6; i < 10; i++) {
+        CU_ASSERT_TRUE(rasta_arrival_ring_get(&ring, i, &received_at));
+        CU_ASSERT_EQUAL(received_at, 10 * i);
+    }
+
+    rasta_arrival_ring_free(&ring);
+}
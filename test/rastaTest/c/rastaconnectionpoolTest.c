@@ -0,0 +1,151 @@
+#include <stdint.h>
+#include <CUnit/Basic.h>
+#include "../headers/rastaconnectionpoolTest.h"
+#include "rastaconnectionpool.h"
+#include "rastahandle.h"
+#include "rasta_new.h"
+
+static struct RastaConfigInfoSending pool_config(unsigned int max_connections) {
+    struct RastaConfigInfoSending cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.t_max = 1800;
+    cfg.send_max = 20;
+    cfg.max_packet = 3;
+    cfg.max_connections = max_connections;
+    return cfg;
+}
+
+void test_connection_pool_slab() {
+    struct rasta_connection_pool pool;
+    rasta_connection_pool_init(&pool, pool_config(3), 0, 0);
+    CU_ASSERT_EQUAL(pool.capacity, 3);
+
+    struct rasta_connection_slot slots[3];
+    for (unsigned int i = 0; i < 3; i++) {
+        CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slots[i]), 1);
+        // the slots start on their own cache line
+        CU_ASSERT_EQUAL((uintptr_t) slots[i].memory % 64, 0);
+    }
+    CU_ASSERT(slots[0].memory != slots[1].memory);
+    CU_ASSERT(slots[1].memory != slots[2].memory);
+
+    struct rasta_connection_slot refused;
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &refused), 0);
+
+    // a released slot is taken by the next connection, with empty queues
+    CU_ASSERT_EQUAL(fifo_push(slots[1].fifo_send, &pool), 1);
+    rasta_connection_pool_release(&pool, slots[1].memory);
+    struct rasta_connection_slot reused;
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &reused), 1);
+    CU_ASSERT_PTR_EQUAL(reused.memory, slots[1].memory);
+    CU_ASSERT_EQUAL(fifo_get_size(reused.fifo_send), 0);
+
+    rasta_connection_pool_free(&pool);
+}
+
+void test_connection_pool_layout() {
+    struct rasta_connection_pool pool;
+    rasta_connection_pool_init(&pool, pool_config(1), 0, 0);
+
+    struct rasta_connection_slot slot;
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+
+    // one diagnostic interval for every 500 ms of T_MAX, the send queue holds the messages of a send window and its
+    // urgent lane the ones of two data packets
+    CU_ASSERT_EQUAL(pool.diagnostic_interval_count, 4);
+    CU_ASSERT_EQUAL(fifo_get_capacity(slot.fifo_app_msg), 20);
+    CU_ASSERT_EQUAL(fifo_get_capacity(slot.fifo_send), 60);
+    CU_ASSERT_EQUAL(fifo_get_capacity(slot.fifo_send_urgent), 6);
+    CU_ASSERT_EQUAL(pool.retransmission_count, 20);
+
+    unsigned char * start = slot.memory;
+    unsigned char * end = start + rasta_connection_pool_slot_size(&pool);
+    CU_ASSERT((unsigned char *) (slot.diagnostic_intervals + pool.diagnostic_interval_count) <=
+              (unsigned char *) slot.fifo_app_msg);
+    CU_ASSERT((unsigned char *) slot.fifo_app_msg + fifo_memory_size(20) <= (unsigned char *) slot.fifo_send);
+    CU_ASSERT((unsigned char *) slot.fifo_send + fifo_memory_size(60) <= (unsigned char *) slot.fifo_send_urgent);
+    CU_ASSERT((unsigned char *) slot.fifo_send_urgent + fifo_memory_size(6) <=
+              (unsigned char *) slot.retransmission_elements);
+    CU_ASSERT((unsigned char *) (slot.retransmission_elements + pool.retransmission_count) <= end);
+
+    // every slot of the queues can be written
+    for (unsigned int i = 0; i < 60; i++) {
+        CU_ASSERT_EQUAL(fifo_push(slot.fifo_send, &pool), 1);
+    }
+    CU_ASSERT_EQUAL(fifo_push(slot.fifo_send, &pool), 0);
+    CU_ASSERT_EQUAL(fifo_get_size(slot.fifo_app_msg), 0);
+
+    rasta_connection_pool_free(&pool);
+
+    // with backpressure the receive queue keeps room for the messages of another send window
+    struct RastaConfigInfoSending cfg = pool_config(1);
+    cfg.receive_backpressure = 1;
+    rasta_connection_pool_init(&pool, cfg, 0, 0);
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+    CU_ASSERT_EQUAL(fifo_get_capacity(slot.fifo_app_msg), 20 + 60);
+    rasta_connection_pool_free(&pool);
+}
+
+void test_connection_pool_on_demand() {
+    struct rasta_connection_pool pool;
+    rasta_connection_pool_init(&pool, pool_config(0), 0, 0);
+    CU_ASSERT_PTR_NULL(pool.slab);
+
+    struct rasta_connection_slot slots[8];
+    for (unsigned int i = 0; i < 8; i++) {
+        CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slots[i]), 1);
+    }
+    for (unsigned int i = 0; i < 8; i++) {
+        rasta_connection_pool_release(&pool, slots[i].memory);
+    }
+
+    rasta_connection_pool_free(&pool);
+}
+
+void test_connection_pool_residency() {
+    struct rasta_connection_pool pool;
+    rasta_connection_pool_init(&pool, pool_config(1), 0, 0);
+    struct rasta_connection_slot slot;
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+    CU_ASSERT_PTR_NULL(slot.residency);
+    size_t plain_size = rasta_connection_pool_slot_size(&pool);
+    rasta_connection_pool_free(&pool);
+
+    rasta_connection_pool_init(&pool, pool_config(1), 1, 0);
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+    CU_ASSERT_PTR_NOT_NULL(slot.residency);
+    // the histograms follow the other parts, the padding of the slot without them may hide a part of their size
+    CU_ASSERT(rasta_connection_pool_slot_size(&pool) > plain_size);
+    CU_ASSERT(rasta_connection_pool_slot_size(&pool) >= pool.residency_offset + sizeof(struct rasta_residency_metrics));
+    unsigned char * end = (unsigned char *) slot.memory + rasta_connection_pool_slot_size(&pool);
+    CU_ASSERT((unsigned char *) (slot.retransmission_elements + pool.retransmission_count) <=
+              (unsigned char *) slot.residency);
+    CU_ASSERT((unsigned char *) (slot.residency + 1) <= end);
+
+    // a reset slot starts with empty histograms
+    rasta_residency_record(slot.residency, RASTA_RESIDENCY_SEND_QUEUE, 1, 1001);
+    rasta_connection_pool_reset(&pool, slot.memory, &slot);
+    CU_ASSERT_EQUAL(slot.residency->wait_us[RASTA_RESIDENCY_SEND_QUEUE].count, 0);
+
+    rasta_connection_pool_free(&pool);
+}
+
+void test_connection_pool_flight_records() {
+    struct rasta_connection_pool pool;
+    rasta_connection_pool_init(&pool, pool_config(1), 1, 16);
+    struct rasta_connection_slot slot;
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+    CU_ASSERT_PTR_NOT_NULL(slot.flight_records);
+
+    // the ring follows the residency histograms and every record can be written
+    unsigned char * end = (unsigned char *) slot.memory + rasta_connection_pool_slot_size(&pool);
+    CU_ASSERT((unsigned char *) (slot.residency + 1) <= (unsigned char *) slot.flight_records);
+    CU_ASSERT((unsigned char *) (slot.flight_records + 16) <= end);
+    memset(slot.flight_records, 0xFF, 16 * sizeof(struct rasta_flight_record));
+    rasta_connection_pool_free(&pool);
+
+    rasta_connection_pool_init(&pool, pool_config(1), 0, 0);
+    CU_ASSERT_EQUAL(rasta_connection_pool_take(&pool, &slot), 1);
+    CU_ASSERT_PTR_NULL(slot.flight_records);
+    rasta_connection_pool_free(&pool);
+}
@@ -70,4 +70,93 @@ void test_without_gen_table(){
     unsigned long res = crc_calculate(&options_b, data_to_test);
 
     CU_ASSERT_EQUAL(res, OPT_B_EXPECTED);
-}
\ No newline at end of file
+}
+void test_slicing_matches_bytewise(){
+    struct crc_options variants[4] = { crc_init_opt_b(), crc_init_opt_c(), crc_init_opt_d(), crc_init_opt_e() };
+
+    unsigned char bytes[67];
+    for (unsigned int i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (unsigned char)(i * 37 + 11);
+    }
+
+    for (int v = 0; v < 4; v++) {
+        CU_ASSERT_PTR_NOT_NULL(variants[v].table);
+
+        // without tables the crc of every byte is calculated when it is processed
+        struct crc_options bytewise = variants[v];
+        bytewise.table = NULL;
+
+        // cover every split into 8 byte blocks and remaining bytes, at every alignment
+        for (unsigned int offset = 0; offset < 3; offset++) {
+            for (unsigned int length = 0; length + offset <= sizeof(bytes); length++) {
+                struct RastaByteArray data;
+                data.bytes = &bytes[offset];
+                data.length = length;
+
+                CU_ASSERT_EQUAL(crc_calculate(&variants[v], data), crc_calculate(&bytewise, data));
+            }
+        }
+    }
+}
+
+void test_precomputed_tables(){
+    struct crc_options variants[4] = { crc_init_opt_b(), crc_init_opt_c(), crc_init_opt_d(), crc_init_opt_e() };
+
+    for (int v = 0; v < 4; v++) {
+        // generating the tables for a copy with the same parameters results in the same table entries
+        struct crc_options generated = variants[v];
+        generated.table = NULL;
+        generated.is_table_generated = 0;
+        crc_generate_table(&generated);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(generated.table);
+        CU_ASSERT(generated.table != variants[v].table);
+
+        for (int k = 0; k < 8; k++) {
+            for (int i = 0; i < 256; i++) {
+                CU_ASSERT_EQUAL(generated.table[k][i], variants[v].table[k][i]);
+            }
+        }
+
+        // the generated tables are shared by options with the same parameters
+        struct crc_options again = generated;
+        again.table = NULL;
+        crc_generate_table(&again);
+        CU_ASSERT_PTR_EQUAL(again.table, generated.table);
+    }
+}
+
+void test_crc_incremental(){
+    struct crc_options variants[4] = { crc_init_opt_b(), crc_init_opt_c(), crc_init_opt_d(), crc_init_opt_e() };
+
+    unsigned char bytes[67];
+    for (unsigned int i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (unsigned char)(i * 53 + 7);
+    }
+
+    struct RastaByteArray data;
+    data.bytes = bytes;
+    data.length = sizeof(bytes);
+
+    for (int v = 0; v < 4; v++) {
+        unsigned long expected = crc_calculate(&variants[v], data);
+
+        // every split into two pieces, also at positions inside the 8 byte blocks
+        for (unsigned int split = 0; split <= sizeof(bytes); split++) {
+            unsigned long crc = crc_begin(&variants[v]);
+            crc = crc_update(&variants[v], crc, bytes, split);
+            crc = crc_update(&variants[v], crc, &bytes[split], sizeof(bytes) - split);
+            CU_ASSERT_EQUAL(crc_end(&variants[v], crc), expected);
+        }
+    }
+
+    // the check value of the crc as in 6.3.6 c), which may use the crc32 instruction
+    struct crc_options options_c = crc_init_opt_c();
+    unsigned long crc = crc_begin(&options_c);
+    crc = crc_update(&options_c, crc, (const unsigned char *) "1234", 4);
+    crc = crc_update(&options_c, crc, (const unsigned char *) "56789", 5);
+    CU_ASSERT_EQUAL(crc_end(&options_c, crc), 0xE3069283);
+
+    // no checksum
+    struct crc_options options_a = crc_init_opt_a();
+    CU_ASSERT_EQUAL(crc_end(&options_a, crc_update(&options_a, crc_begin(&options_a), bytes, sizeof(bytes))), 0);
+}
@@ -1,7 +1,23 @@
 #include <CUnit/Basic.h>
+#include <string.h>
 #include "../headers/rastadeferqueueTest.h"
 #include "rastadeferqueue.h"
 
+/**
+ * gets the element at the given position in time order
+ * @param queue the queue that is used
+ * @param position 0 for the oldest element
+ * @return the element
+ */
+static struct rasta_redundancy_packet_wrapper * element_at(struct defer_queue * queue, unsigned int position) {
+    struct rasta_redundancy_packet_wrapper * element = deferqueue_first(queue);
+    for (unsigned int i = 0; i < position && element != NULL; ++i) {
+        element = deferqueue_next(queue, element);
+    }
+    CU_ASSERT_PTR_NOT_NULL_FATAL(element);
+    return element;
+}
+
 void test_deferqueue_init() {
     struct defer_queue queue_to_test = deferqueue_init(3);
 
@@ -17,7 +33,7 @@ void test_deferqueue_destroy() {
     struct RastaRedundancyPacket packet;
     packet.sequence_number = 1;
 
-    deferqueue_add(&queue_to_test, packet, 42);
+    deferqueue_add(&queue_to_test, &packet, 42);
 
     deferqueue_destroy(&queue_to_test);
 
@@ -36,14 +52,14 @@ void test_deferqueue_add() {
     packet2.sequence_number = 2;
     unsigned long packet2_ts = 43;
 
-    deferqueue_add(&queue_to_test, packet, packet_ts);
-    deferqueue_add(&queue_to_test, packet2, packet2_ts);
+    deferqueue_add(&queue_to_test, &packet, packet_ts);
+    deferqueue_add(&queue_to_test, &packet2, packet2_ts);
 
     CU_ASSERT_EQUAL(queue_to_test.count, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].packet.sequence_number, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].packet.sequence_number, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, packet_ts);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].received_timestamp, packet2_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, 1);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->packet.sequence_number, 2);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, packet_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->received_timestamp, packet2_ts);
 }
 
 void test_deferqueue_remove() {
@@ -58,14 +74,14 @@ void test_deferqueue_remove() {
     packet2.sequence_number = 2;
     unsigned long packet2_ts = 43;
 
-    deferqueue_add(&queue_to_test, packet, packet_ts);
-    deferqueue_add(&queue_to_test, packet2, packet2_ts);
+    deferqueue_add(&queue_to_test, &packet, packet_ts);
+    deferqueue_add(&queue_to_test, &packet2, packet2_ts);
 
     deferqueue_remove(&queue_to_test, 1);
 
     CU_ASSERT_EQUAL(queue_to_test.count, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].packet.sequence_number, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, packet2_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, 2);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, packet2_ts);
 
     deferqueue_remove(&queue_to_test, 2);
 
@@ -83,12 +99,12 @@ void test_deferqueue_add_full() {
     packet2.sequence_number = 2;
     unsigned long packet2_ts = 43;
 
-    deferqueue_add(&queue_to_test, packet, packet_ts);
-    deferqueue_add(&queue_to_test, packet2, packet2_ts);
+    deferqueue_add(&queue_to_test, &packet, packet_ts);
+    deferqueue_add(&queue_to_test, &packet2, packet2_ts);
 
     CU_ASSERT_EQUAL(queue_to_test.count, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].packet.sequence_number, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, packet_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, 1);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, packet_ts);
 }
 
 void test_deferqueue_remove_not_in_queue() {
@@ -102,16 +118,16 @@ void test_deferqueue_remove_not_in_queue() {
     packet2.sequence_number = 2;
     unsigned long packet2_ts = 43;
 
-    deferqueue_add(&queue_to_test, packet, packet_ts);
-    deferqueue_add(&queue_to_test, packet2, packet2_ts);
+    deferqueue_add(&queue_to_test, &packet, packet_ts);
+    deferqueue_add(&queue_to_test, &packet2, packet2_ts);
 
     deferqueue_remove(&queue_to_test, 3);
 
     CU_ASSERT_EQUAL(queue_to_test.count, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].packet.sequence_number, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].packet.sequence_number, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, packet_ts);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].received_timestamp, packet2_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, 1);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->packet.sequence_number, 2);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, packet_ts);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->received_timestamp, packet2_ts);
 }
 
 void test_deferqueue_contains() {
@@ -125,8 +141,8 @@ void test_deferqueue_contains() {
     packet2.sequence_number = 2;
     unsigned long packet2_ts = 43;
 
-    deferqueue_add(&queue_to_test, packet, packet_ts);
-    deferqueue_add(&queue_to_test, packet2, packet2_ts);
+    deferqueue_add(&queue_to_test, &packet, packet_ts);
+    deferqueue_add(&queue_to_test, &packet2, packet2_ts);
 
     int res = deferqueue_contains(&queue_to_test, 1);
     CU_ASSERT_EQUAL(res, 1);
@@ -147,8 +163,8 @@ void test_deferqueue_isfull() {
     struct RastaRedundancyPacket packet2;
     packet2.sequence_number = 2;
 
-    deferqueue_add(&queue_to_test, packet, 1);
-    deferqueue_add(&queue_to_test, packet2, 2);
+    deferqueue_add(&queue_to_test, &packet, 1);
+    deferqueue_add(&queue_to_test, &packet2, 2);
 
     int res = deferqueue_isfull(&queue_to_test);
 
@@ -158,7 +174,7 @@ void test_deferqueue_isfull() {
     struct RastaRedundancyPacket packet3;
     packet3.sequence_number = 3;
 
-    deferqueue_add(&queue_to_test, packet3, 3);
+    deferqueue_add(&queue_to_test, &packet3, 3);
 
     res = deferqueue_isfull(&queue_to_test);
     CU_ASSERT_EQUAL(res, 1);
@@ -176,9 +192,9 @@ void test_deferqueue_smallestseqnr() {
     struct RastaRedundancyPacket packet3;
     packet3.sequence_number = 2;
 
-    deferqueue_add(&queue_to_test, packet, 1);
-    deferqueue_add(&queue_to_test, packet2, 2);
-    deferqueue_add(&queue_to_test, packet3, 3);
+    deferqueue_add(&queue_to_test, &packet, 1);
+    deferqueue_add(&queue_to_test, &packet2, 2);
+    deferqueue_add(&queue_to_test, &packet3, 3);
 
     int res = deferqueue_smallest_seqnr(&queue_to_test);
 
@@ -197,9 +213,9 @@ void test_deferqueue_get() {
     struct RastaRedundancyPacket packet3;
     packet3.sequence_number = 2;
 
-    deferqueue_add(&queue_to_test, packet, 1);
-    deferqueue_add(&queue_to_test, packet2, 2);
-    deferqueue_add(&queue_to_test, packet3, 3);
+    deferqueue_add(&queue_to_test, &packet, 1);
+    deferqueue_add(&queue_to_test, &packet2, 2);
+    deferqueue_add(&queue_to_test, &packet3, 3);
 
     struct RastaRedundancyPacket res = deferqueue_get(&queue_to_test, 1);
     CU_ASSERT_EQUAL(res.sequence_number, 1);
@@ -224,19 +240,19 @@ void test_deferqueue_sorted() {
     packet3.sequence_number = 2;
     unsigned long ts_3 = 1;
 
-    deferqueue_add(&queue_to_test, packet, ts_1);
-    deferqueue_add(&queue_to_test, packet2, ts_2);
-    deferqueue_add(&queue_to_test, packet3, ts_3);
+    deferqueue_add(&queue_to_test, &packet, ts_1);
+    deferqueue_add(&queue_to_test, &packet2, ts_2);
+    deferqueue_add(&queue_to_test, &packet3, ts_3);
 
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, 1);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].received_timestamp, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[2].received_timestamp, 3);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, 1);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->received_timestamp, 2);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 2)->received_timestamp, 3);
 
     // remove the first element: last element is move to first place
     deferqueue_remove(&queue_to_test, 2);
 
-    CU_ASSERT_EQUAL(queue_to_test.elements[0].received_timestamp, 2);
-    CU_ASSERT_EQUAL(queue_to_test.elements[1].received_timestamp, 3);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->received_timestamp, 2);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->received_timestamp, 3);
 }
 
 void test_deferqueue_clear() {
@@ -250,8 +266,8 @@ void test_deferqueue_clear() {
     packet2.sequence_number = 1;
     unsigned long ts_2 = 3;
 
-    deferqueue_add(&queue_to_test, packet, ts_1);
-    deferqueue_add(&queue_to_test, packet2, ts_2);
+    deferqueue_add(&queue_to_test, &packet, ts_1);
+    deferqueue_add(&queue_to_test, &packet2, ts_2);
 
     deferqueue_clear(&queue_to_test);
 
@@ -269,8 +285,8 @@ void test_deferqueue_get_ts() {
     packet2.sequence_number = 1;
     unsigned long ts_2 = 3;
 
-    deferqueue_add(&queue_to_test, packet, ts_1);
-    deferqueue_add(&queue_to_test, packet2, ts_2);
+    deferqueue_add(&queue_to_test, &packet, ts_1);
+    deferqueue_add(&queue_to_test, &packet2, ts_2);
 
     CU_ASSERT_EQUAL(deferqueue_get_ts(&queue_to_test, 3), ts_1);
     CU_ASSERT_EQUAL(deferqueue_get_ts(&queue_to_test, 1), ts_2);
@@ -287,8 +303,150 @@ void test_deferqueue_get_ts_doesnt_contain() {
     packet2.sequence_number = 1;
     unsigned long ts_2 = 3;
 
-    deferqueue_add(&queue_to_test, packet, ts_1);
-    deferqueue_add(&queue_to_test, packet2, ts_2);
+    deferqueue_add(&queue_to_test, &packet, ts_1);
+    deferqueue_add(&queue_to_test, &packet2, ts_2);
 
     CU_ASSERT_EQUAL(deferqueue_get_ts(&queue_to_test, 8), 0);
 }
+
+void test_deferqueue_large() {
+    unsigned int n = 300;
+    struct defer_queue queue_to_test = deferqueue_init(n);
+
+    // sequence numbers are spread over ten times the queue size, so several of them share a table slot
+    for (unsigned int i = 0; i < n; ++i) {
+        struct RastaRedundancyPacket packet;
+        packet.sequence_number = 1000 + ((i * 7) % (10 * n));
+        deferqueue_add(&queue_to_test, &packet, i + 1);
+    }
+
+    CU_ASSERT_EQUAL(deferqueue_isfull(&queue_to_test), 1);
+
+    for (unsigned int i = 0; i < n; ++i) {
+        CU_ASSERT_EQUAL(deferqueue_get_ts(&queue_to_test, 1000 + ((i * 7) % (10 * n))), i + 1);
+    }
+    CU_ASSERT_EQUAL(deferqueue_contains(&queue_to_test, 1001), 0);
+
+    // remove every second element, the others have to stay reachable
+    for (unsigned int i = 0; i < n; i += 2) {
+        deferqueue_remove(&queue_to_test, 1000 + ((i * 7) % (10 * n)));
+    }
+
+    CU_ASSERT_EQUAL(queue_to_test.count, n / 2);
+    for (unsigned int i = 0; i < n; ++i) {
+        CU_ASSERT_EQUAL(deferqueue_contains(&queue_to_test, 1000 + ((i * 7) % (10 * n))), i % 2);
+    }
+
+    // the remaining elements are still ordered by timestamp
+    unsigned int visited = 0;
+    unsigned long last_ts = 0;
+    for (struct rasta_redundancy_packet_wrapper * element = deferqueue_first(&queue_to_test); element != NULL;
+         element = deferqueue_next(&queue_to_test, element)) {
+        CU_ASSERT(element->received_timestamp > last_ts);
+        last_ts = element->received_timestamp;
+        visited++;
+    }
+    CU_ASSERT_EQUAL(visited, n / 2);
+
+    CU_ASSERT_EQUAL(queue_to_test.elements[deferqueue_smallest_seqnr(&queue_to_test)].packet.sequence_number, 1007);
+
+    deferqueue_destroy(&queue_to_test);
+}
+
+void test_deferqueue_reuse() {
+    struct defer_queue queue_to_test = deferqueue_init(2);
+
+    struct RastaRedundancyPacket packet;
+
+    for (unsigned int i = 0; i < 10; ++i) {
+        packet.sequence_number = i;
+        deferqueue_add(&queue_to_test, &packet, 10 - i);
+
+        packet.sequence_number = i + 2;
+        deferqueue_add(&queue_to_test, &packet, 20 - i);
+
+        // the queue is full, a third element is discarded
+        packet.sequence_number = i + 4;
+        deferqueue_add(&queue_to_test, &packet, 1);
+        CU_ASSERT_EQUAL(deferqueue_contains(&queue_to_test, i + 4), 0);
+
+        CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, i);
+        CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->packet.sequence_number, i + 2);
+
+        if (i % 2 == 0) {
+            deferqueue_remove(&queue_to_test, i);
+            deferqueue_remove(&queue_to_test, i + 2);
+        } else {
+            deferqueue_clear(&queue_to_test);
+        }
+
+        CU_ASSERT_EQUAL(queue_to_test.count, 0);
+        CU_ASSERT_PTR_NULL(deferqueue_first(&queue_to_test));
+    }
+
+    deferqueue_destroy(&queue_to_test);
+}
+
+void test_deferqueue_take() {
+    struct defer_queue queue_to_test = deferqueue_init(3);
+
+    struct RastaRedundancyPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    for (unsigned int i = 0; i < 3; ++i) {
+        packet.sequence_number = 5 + i;
+        packet.data.sequence_number = 100 + i;
+        deferqueue_add(&queue_to_test, &packet, 10 + i);
+    }
+
+    struct RastaRedundancyPacket taken;
+    CU_ASSERT_EQUAL(deferqueue_take(&queue_to_test, 6, &taken), 1);
+    CU_ASSERT_EQUAL(taken.sequence_number, 6);
+    CU_ASSERT_EQUAL(taken.data.sequence_number, 101);
+    CU_ASSERT_EQUAL(queue_to_test.count, 2);
+    CU_ASSERT_EQUAL(deferqueue_contains(&queue_to_test, 6), 0);
+
+    // the remaining elements keep their time order
+    CU_ASSERT_EQUAL(deferqueue_first(&queue_to_test)->packet.sequence_number, 5);
+    CU_ASSERT_EQUAL(deferqueue_next(&queue_to_test, deferqueue_first(&queue_to_test))->packet.sequence_number, 7);
+
+    CU_ASSERT_EQUAL(deferqueue_take(&queue_to_test, 6, &taken), 0);
+    CU_ASSERT_EQUAL(queue_to_test.count, 2);
+
+    deferqueue_destroy(&queue_to_test);
+}
+
+void test_deferqueue_resize() {
+    struct defer_queue queue_to_test = deferqueue_init(3);
+
+    struct RastaRedundancyPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    unsigned long timestamps[3] = { 30, 10, 20 };
+    for (unsigned int i = 0; i < 3; ++i) {
+        packet.sequence_number = 5 + i;
+        deferqueue_add(&queue_to_test, &packet, timestamps[i]);
+    }
+
+    // a queue does not shrink below its elements
+    CU_ASSERT_EQUAL(deferqueue_resize(&queue_to_test, 2), 0);
+    CU_ASSERT_EQUAL(queue_to_test.max_count, 3);
+    CU_ASSERT_EQUAL(queue_to_test.count, 3);
+
+    // the elements keep their time order and timestamps, the new places can be used
+    CU_ASSERT_EQUAL(deferqueue_resize(&queue_to_test, 5), 1);
+    CU_ASSERT_EQUAL(queue_to_test.max_count, 5);
+    CU_ASSERT_EQUAL(queue_to_test.count, 3);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 0)->packet.sequence_number, 6);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 1)->packet.sequence_number, 7);
+    CU_ASSERT_EQUAL(element_at(&queue_to_test, 2)->packet.sequence_number, 5);
+    CU_ASSERT_EQUAL(deferqueue_get_ts(&queue_to_test, 5), 30);
+
+    for (unsigned int i = 0; i < 2; ++i) {
+        packet.sequence_number = 8 + i;
+        deferqueue_add(&queue_to_test, &packet, 40 + i);
+    }
+    CU_ASSERT_EQUAL(queue_to_test.count, 5);
+    CU_ASSERT_TRUE(deferqueue_isfull(&queue_to_test));
+    CU_ASSERT_EQUAL(deferqueue_contains(&queue_to_test, 9), 1);
+
+    deferqueue_destroy(&queue_to_test);
+}
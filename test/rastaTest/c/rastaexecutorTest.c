@@ -0,0 +1,138 @@
+#include <CUnit/Basic.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include "../headers/rastaexecutorTest.h"
+#include "rastaexecutor.h"
+#include "rastahandle.h"
+
+static int callback_order[16];
+static unsigned int callback_count;
+
+static void record_callback(void * record) {
+    int value;
+    memcpy(&value, record, sizeof(value));
+    if (callback_count < 16) {
+        callback_order[callback_count] = value;
+    }
+    __atomic_add_fetch(&callback_count, 1, __ATOMIC_SEQ_CST);
+}
+
+void test_callback_executor_order() {
+    struct rasta_callback_executor executor;
+    rasta_callback_executor_init(&executor, 8, sizeof(int), 0);
+    CU_ASSERT_EQUAL(executor.record_size, RASTA_CALLBACK_RECORD_MIN_SIZE);
+    callback_count = 0;
+
+    for (int i = 0; i < 3; i++) {
+        rasta_callback_executor_submit(&executor, record_callback, &i, sizeof(i));
+    }
+    // nothing runs on the submitting thread while there is room
+    CU_ASSERT_EQUAL(callback_count, 0);
+    CU_ASSERT_EQUAL(executor.queued, 3);
+
+    struct pollfd readable = {.fd = executor.notify_fd, .events = POLLIN};
+    CU_ASSERT_EQUAL(poll(&readable, 1, 0), 1);
+
+    CU_ASSERT_EQUAL(rasta_callback_executor_run(&executor, 2), 2);
+    CU_ASSERT_EQUAL(callback_count, 2);
+    // the remaining callback signals the eventfd again
+    CU_ASSERT_EQUAL(poll(&readable, 1, 0), 1);
+    CU_ASSERT_EQUAL(rasta_callback_executor_run(&executor, 10), 1);
+    CU_ASSERT_EQUAL(poll(&readable, 1, 0), 0);
+
+    CU_ASSERT_EQUAL(callback_count, 3);
+    for (int i = 0; i < 3; i++) {
+        CU_ASSERT_EQUAL(callback_order[i], i);
+    }
+
+    rasta_callback_executor_destroy(&executor);
+}
+
+void test_callback_executor_overflow() {
+    struct rasta_callback_executor executor;
+    rasta_callback_executor_init(&executor, 4, sizeof(int), 0);
+    callback_count = 0;
+
+    int submitted = 0;
+    while (executor.overflows == 0 && submitted < 16) {
+        rasta_callback_executor_submit(&executor, record_callback, &submitted, sizeof(submitted));
+        submitted++;
+    }
+    // the oldest callback made room for the last one
+    CU_ASSERT_EQUAL(executor.overflows, 1);
+    CU_ASSERT_EQUAL(callback_count, 1);
+    CU_ASSERT_EQUAL(callback_order[0], 0);
+
+    // the queued callbacks run when the executor is destroyed
+    rasta_callback_executor_destroy(&executor);
+    CU_ASSERT_EQUAL(callback_count, (unsigned int) submitted);
+    for (int i = 0; i < submitted; i++) {
+        CU_ASSERT_EQUAL(callback_order[i], i);
+    }
+}
+
+void test_callback_executor_thread() {
+    struct rasta_callback_executor executor;
+    rasta_callback_executor_init(&executor, 8, sizeof(int), 1);
+    callback_count = 0;
+
+    for (int i = 0; i < 4; i++) {
+        rasta_callback_executor_submit(&executor, record_callback, &i, sizeof(i));
+    }
+    for (int i = 0; i < 1000 && __atomic_load_n(&callback_count, __ATOMIC_SEQ_CST) < 4; i++) {
+        struct timespec pause = {.tv_sec = 0, .tv_nsec = 1000000};
+        nanosleep(&pause, NULL);
+    }
+    CU_ASSERT_EQUAL(__atomic_load_n(&callback_count, __ATOMIC_SEQ_CST), 4);
+    CU_ASSERT_EQUAL(callback_order[3], 3);
+
+    rasta_callback_executor_destroy(&executor);
+}
+
+static rasta_sr_state notified_states[4];
+static unsigned int notified_state_count;
+
+static void record_state_change(struct rasta_notification_result * result) {
+    if (notified_state_count < 4) {
+        notified_states[notified_state_count] = result->state;
+    }
+    notified_state_count++;
+}
+
+void test_callback_executor_state_coalescing() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    struct rasta_callback_executor executor;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    rasta_callback_executor_init(&executor, 8, 0, 0);
+    h.callback_executor = &executor;
+    h.notifications.on_connection_state_change = record_state_change;
+    notified_state_count = 0;
+
+    con.current_state = RASTA_CONNECTION_START;
+    fire_on_connection_state_change(sr_create_notification_result(&h, &con));
+    con.current_state = RASTA_CONNECTION_UP;
+    fire_on_connection_state_change(sr_create_notification_result(&h, &con));
+    con.current_state = RASTA_CONNECTION_RETRREQ;
+    fire_on_connection_state_change(sr_create_notification_result(&h, &con));
+    CU_ASSERT_EQUAL(notified_state_count, 0);
+    CU_ASSERT_EQUAL(executor.queued, 1);
+    CU_ASSERT_EQUAL(executor.coalesced, 2);
+
+    // one notification with the latest state
+    rasta_callback_executor_run(&executor, 10);
+    CU_ASSERT_EQUAL(notified_state_count, 1);
+    CU_ASSERT_EQUAL(notified_states[0], RASTA_CONNECTION_RETRREQ);
+
+    // a state change after the notification ran queues a new one
+    con.current_state = RASTA_CONNECTION_UP;
+    fire_on_connection_state_change(sr_create_notification_result(&h, &con));
+    CU_ASSERT_EQUAL(executor.queued, 2);
+    rasta_callback_executor_run(&executor, 10);
+    CU_ASSERT_EQUAL(notified_state_count, 2);
+    CU_ASSERT_EQUAL(notified_states[1], RASTA_CONNECTION_UP);
+
+    rasta_callback_executor_destroy(&executor);
+}
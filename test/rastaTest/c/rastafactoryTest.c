@@ -227,6 +227,54 @@ void checkMessagePacket() {
     freeRastaMessageData(&data);
 }
 
+void checkMessageIterator() {
+    rasta_hashing_context_t hashing_context;
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    hashing_context.hash_length = RASTA_CHECKSUM_8B;
+    rasta_md4_set_key(&hashing_context, 0, 0, 0, 0);
+
+    struct RastaMessageData data;
+    allocateRastaMessageData(&data,2);
+    allocateRastaByteArray(&data.data_array[0],2);
+    allocateRastaByteArray(&data.data_array[1],3);
+
+    data.data_array[0].bytes[0] = 1;
+    data.data_array[0].bytes[1] = 2;
+    data.data_array[1].bytes[0] = 3;
+    data.data_array[1].bytes[1] = 4;
+    data.data_array[1].bytes[2] = 5;
+
+    struct RastaPacket r = createDataMessage(1,2,3,4,5,6,data, &hashing_context);
+
+    struct RastaMessageIterator iterator;
+    const unsigned char * message;
+    unsigned int message_length;
+
+    rastaMessageIteratorInit(&iterator, r.data.bytes, r.data.length);
+
+    // the messages point into the packet data behind their length field
+    CU_ASSERT_EQUAL(rastaMessageIteratorNext(&iterator, &message, &message_length), 1);
+    CU_ASSERT_EQUAL(message_length, 2);
+    CU_ASSERT_PTR_EQUAL(message, &r.data.bytes[2]);
+    CU_ASSERT_EQUAL(message[1], 2);
+
+    CU_ASSERT_EQUAL(rastaMessageIteratorNext(&iterator, &message, &message_length), 1);
+    CU_ASSERT_EQUAL(message_length, 3);
+    CU_ASSERT_PTR_EQUAL(message, &r.data.bytes[6]);
+    CU_ASSERT_EQUAL(message[2], 5);
+
+    CU_ASSERT_EQUAL(rastaMessageIteratorNext(&iterator, &message, &message_length), 0);
+
+    // a message that exceeds the data ends the iteration
+    rastaMessageIteratorInit(&iterator, r.data.bytes, r.data.length - 1);
+    CU_ASSERT_EQUAL(rastaMessageIteratorNext(&iterator, &message, &message_length), 1);
+    CU_ASSERT_EQUAL(rastaMessageIteratorNext(&iterator, &message, &message_length), 0);
+
+    freeRastaByteArray(&r.data);
+    freeRastaMessageData(&data);
+    freeRastaByteArray(&hashing_context.key);
+}
+
 void testCreateRedundancyPacket() {
     // create test inner packet
     struct RastaPacket inner_test;
@@ -234,14 +282,15 @@ void testCreateRedundancyPacket() {
     inner_test.sequence_number = 42;
 
     // crc opt b = 32bit/4byte width
-    struct RastaRedundancyPacket pdu_to_test = createRedundancyPacket(1, inner_test, crc_init_opt_b());
+    struct crc_options checksum_options = crc_init_opt_b();
+    struct RastaRedundancyPacket pdu_to_test = createRedundancyPacket(1, &inner_test, &checksum_options);
 
     unsigned short expected_len = 8 + 10 + 4;
 
     CU_ASSERT_EQUAL(pdu_to_test.reserve, 0x0000);
     CU_ASSERT_EQUAL(pdu_to_test.checksum_correct, 1);
     CU_ASSERT_EQUAL(pdu_to_test.data.sequence_number, 42);
-    CU_ASSERT_EQUAL(pdu_to_test.checksum_type.width, crc_init_opt_b().width);
+    CU_ASSERT_PTR_EQUAL(pdu_to_test.checksum_type, &checksum_options);
     CU_ASSERT_EQUAL(pdu_to_test.length, expected_len);
 }
 
@@ -252,13 +301,14 @@ void testCreateRedundancyPacketNoChecksum() {
     inner_test.sequence_number = 42;
 
     // crc opt a = no crc / 0 bit width
-    struct RastaRedundancyPacket pdu_to_test = createRedundancyPacket(1, inner_test, crc_init_opt_a());
+    struct crc_options checksum_options = crc_init_opt_a();
+    struct RastaRedundancyPacket pdu_to_test = createRedundancyPacket(1, &inner_test, &checksum_options);
 
     unsigned short expected_len = 8 + 10 + 0;
 
     CU_ASSERT_EQUAL(pdu_to_test.reserve, 0x0000);
     CU_ASSERT_EQUAL(pdu_to_test.checksum_correct, 1);
     CU_ASSERT_EQUAL(pdu_to_test.data.sequence_number, 42);
-    CU_ASSERT_EQUAL(pdu_to_test.checksum_type.width, crc_init_opt_a().width);
+    CU_ASSERT_PTR_EQUAL(pdu_to_test.checksum_type, &checksum_options);
     CU_ASSERT_EQUAL(pdu_to_test.length, expected_len);
 }
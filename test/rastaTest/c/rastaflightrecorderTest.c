@@ -0,0 +1,101 @@
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../headers/rastaflightrecorderTest.h"
+#include "rastaflightrecorder.h"
+
+/**
+ * records a PDU with the given sequence number
+ */
+static void record_pdu(struct rasta_flight_recorder * recorder, uint64_t time_ns, uint32_t sequence_number) {
+    struct rasta_flight_record * record = rasta_flight_recorder_next(recorder);
+    memset(record, 0, sizeof(*record));
+    record->time_ns = time_ns;
+    record->sequence_number = sequence_number;
+    record->type = 6240;
+    record->event = RASTA_FLIGHT_SEND;
+    record->send_queue = 2;
+}
+
+void test_flight_recorder_ring() {
+    struct rasta_flight_record records[3];
+    struct rasta_flight_recorder recorder;
+    rasta_flight_recorder_init(&recorder, records, 3);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        record_pdu(&recorder, 1000000000 + i * 1000000, i);
+    }
+    CU_ASSERT_EQUAL(recorder.next, 5);
+
+    char text[1024];
+    FILE * out = fmemopen(text, sizeof(text), "w");
+    rasta_flight_recorder_write(&recorder, out, 0x61, 0x62, RASTA_FLIGHT_TRIGGER_TIMEOUT, "T_I expired", 1005000000);
+    fclose(out);
+
+    // the two oldest records were overwritten, the last one is 1 ms before the dump
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "# local_id=0x61 remote_id=0x62 trigger=timeout records=3 T_I expired\n"));
+    char * first = strstr(text, "-3.000 send 6240 2 ");
+    char * last = strstr(text, "-1.000 send 6240 4 ");
+    CU_ASSERT_PTR_NOT_NULL(first);
+    CU_ASSERT_PTR_NOT_NULL(last);
+    CU_ASSERT(first < last);
+    CU_ASSERT_PTR_NULL(strstr(text, "send 6240 1 "));
+
+    // nothing is recorded without a ring
+    struct rasta_flight_recorder disabled;
+    rasta_flight_recorder_init(&disabled, records, 0);
+    CU_ASSERT_PTR_NULL(rasta_flight_recorder_next(&disabled));
+}
+
+void test_flight_recorder_dump() {
+    char directory[] = "/tmp/rasta_flight_test_XXXXXX";
+    CU_ASSERT_FATAL(mkdtemp(directory) != NULL);
+
+    struct rasta_flight_record records[4];
+    struct rasta_flight_recorder recorder;
+    rasta_flight_recorder_init(&recorder, records, 4);
+    char path[512];
+
+    CU_ASSERT_EQUAL(rasta_flight_recorder_dump(&recorder, directory, 0x62, 0x61, RASTA_FLIGHT_TRIGGER_CHANNEL, "", 0,
+                                               path, sizeof(path)), 0);
+
+    record_pdu(&recorder, 1000, 7);
+    CU_ASSERT_EQUAL(rasta_flight_recorder_dump(&recorder, directory, 0x62, 0x61, RASTA_FLIGHT_TRIGGER_CHANNEL, "",
+                                               2000, path, sizeof(path)), 1);
+    CU_ASSERT_EQUAL(recorder.next, 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(path, "/rasta_flight_0x62_0x61_"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(path, "_channel.txt"));
+
+    FILE * in = fopen(path, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(in);
+    char line[256];
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), in));
+    CU_ASSERT_STRING_EQUAL(line, "# local_id=0x62 remote_id=0x61 trigger=channel records=1\n");
+    fclose(in);
+    unlink(path);
+
+    // the ring was emptied, so the next anomaly has nothing to write
+    CU_ASSERT_EQUAL(rasta_flight_recorder_dump(&recorder, directory, 0x62, 0x61, RASTA_FLIGHT_TRIGGER_CHANNEL, "",
+                                               3000, path, sizeof(path)), 0);
+    rmdir(directory);
+}
+
+void test_flight_recorder_safety_errors() {
+    struct rasta_flight_record records[1];
+    struct rasta_flight_recorder recorder;
+    rasta_flight_recorder_init(&recorder, records, 1);
+
+    // two errors, then the window expires before the third one
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 100, 1000, 3), 0);
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 600, 1000, 3), 0);
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 1200, 1000, 3), 0);
+
+    // three errors within the window started at 1200
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 1300, 1000, 3), 0);
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 2100, 1000, 3), 1);
+
+    // the count starts again after a dump
+    CU_ASSERT_EQUAL(rasta_flight_recorder_safety_error(&recorder, 2200, 1000, 3), 0);
+}
@@ -0,0 +1,58 @@
+#include <CUnit/Basic.h>
+#include "../headers/rastaidindexTest.h"
+#include "rastaidindex.h"
+
+#define TEST_ELEMENT_COUNT 1000
+
+static int elements[TEST_ELEMENT_COUNT];
+
+void test_id_index_put_get() {
+    struct rasta_id_index index;
+    rasta_id_index_init(&index);
+
+    // more elements than the initial capacity, so the index has to grow
+    for (unsigned long i = 0; i < TEST_ELEMENT_COUNT; i++) {
+        rasta_id_index_put(&index, i * 0x10000, &elements[i]);
+    }
+    CU_ASSERT_EQUAL(index.count, TEST_ELEMENT_COUNT);
+
+    for (unsigned long i = 0; i < TEST_ELEMENT_COUNT; i++) {
+        CU_ASSERT_PTR_EQUAL(rasta_id_index_get(&index, i * 0x10000), &elements[i]);
+    }
+    CU_ASSERT_PTR_NULL(rasta_id_index_get(&index, 0x42));
+
+    // same id replaces the element
+    rasta_id_index_put(&index, 0x10000, &elements[0]);
+    CU_ASSERT_EQUAL(index.count, TEST_ELEMENT_COUNT);
+    CU_ASSERT_PTR_EQUAL(rasta_id_index_get(&index, 0x10000), &elements[0]);
+
+    rasta_id_index_free(&index);
+    CU_ASSERT_PTR_NULL(rasta_id_index_get(&index, 0x10000));
+}
+
+void test_id_index_remove() {
+    struct rasta_id_index index;
+    rasta_id_index_init(&index);
+
+    for (unsigned long i = 0; i < TEST_ELEMENT_COUNT; i++) {
+        rasta_id_index_put(&index, i, &elements[i]);
+    }
+
+    for (unsigned long i = 0; i < TEST_ELEMENT_COUNT; i += 3) {
+        rasta_id_index_remove(&index, i);
+    }
+    // unknown ids are ignored
+    rasta_id_index_remove(&index, TEST_ELEMENT_COUNT);
+
+    for (unsigned long i = 0; i < TEST_ELEMENT_COUNT; i++) {
+        if (i % 3 == 0) {
+            CU_ASSERT_PTR_NULL(rasta_id_index_get(&index, i));
+        }
+        else {
+            CU_ASSERT_PTR_EQUAL(rasta_id_index_get(&index, i), &elements[i]);
+        }
+    }
+    CU_ASSERT_EQUAL(index.count, TEST_ELEMENT_COUNT - (TEST_ELEMENT_COUNT + 2) / 3);
+
+    rasta_id_index_free(&index);
+}
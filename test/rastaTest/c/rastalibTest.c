@@ -0,0 +1,352 @@
+#include <CUnit/Basic.h>
+#include <string.h>
+#include "../headers/rastalibTest.h"
+#include "rasta_lib.h"
+#include "rmemory.h"
+
+void test_rasta_lib_shard_index() {
+    CU_ASSERT_EQUAL(rasta_lib_shard_index(0x61, 1), 0);
+
+    // consecutive IDs are served by different shards
+    unsigned int used[4] = {0};
+    for (unsigned long id = 0x62; id < 0x62 + 4; id++) {
+        unsigned int index = rasta_lib_shard_index(id, 4);
+        CU_ASSERT(index < 4);
+        used[index]++;
+    }
+    for (unsigned int i = 0; i < 4; i++) {
+        CU_ASSERT_EQUAL(used[i], 1);
+    }
+
+    // a connection always belongs to the same shard
+    CU_ASSERT_EQUAL(rasta_lib_shard_index(0x12345678, 3), rasta_lib_shard_index(0x12345678, 3));
+}
+
+void test_rasta_lib_shard_channels() {
+    struct RastaIPData channels[2];
+    strcpy(channels[0].ip, "127.0.0.1");
+    strcpy(channels[1].ip, "127.0.0.2");
+    channels[0].port = 8888;
+    channels[1].port = 8889;
+
+    struct RastaIPData shard_channels[2];
+    rasta_lib_shard_channels(channels, 2, 0, shard_channels);
+    CU_ASSERT_EQUAL(shard_channels[0].port, 8888);
+    CU_ASSERT_EQUAL(shard_channels[1].port, 8889);
+
+    // shard i listens on the configured ports + i * the amount of configured ports
+    rasta_lib_shard_channels(channels, 2, 3, shard_channels);
+    CU_ASSERT_STRING_EQUAL(shard_channels[0].ip, "127.0.0.1");
+    CU_ASSERT_STRING_EQUAL(shard_channels[1].ip, "127.0.0.2");
+    CU_ASSERT_EQUAL(shard_channels[0].port, 8894);
+    CU_ASSERT_EQUAL(shard_channels[1].port, 8895);
+}
+
+static struct rasta_connection * notified_connection;
+static unsigned int notified_count;
+
+static void record_notification(struct rasta_notification_result * result) {
+    notified_connection = result->con;
+    notified_count++;
+    // changes are seen by the library, there is no copy
+    result->con->received_diagnostic_message_count = 0;
+}
+
+void test_notification_live_connection() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    h.notifications.on_receive = record_notification;
+    h.notifications.on_diagnostic_notification = record_notification;
+
+    notified_count = 0;
+    fire_on_receive(sr_create_notification_result(&h, &con));
+    CU_ASSERT_EQUAL(notified_count, 1);
+    CU_ASSERT_PTR_EQUAL(notified_connection, &con);
+
+    con.received_diagnostic_message_count = 1;
+    fire_on_diagnostic_notification(sr_create_notification_result(&h, &con));
+    CU_ASSERT_EQUAL(notified_count, 2);
+    CU_ASSERT_EQUAL(con.received_diagnostic_message_count, 0);
+
+    // without diagnostic messages the notification is not called
+    fire_on_diagnostic_notification(sr_create_notification_result(&h, &con));
+    CU_ASSERT_EQUAL(notified_count, 2);
+}
+
+static void push_received(struct rasta_connection * con, unsigned long id, unsigned char byte) {
+    rastaApplicationMessage * element = rmalloc(sizeof(rastaApplicationMessage));
+    element->id = id;
+    allocateRastaByteArray(&element->appMessage, 1);
+    element->appMessage.bytes[0] = byte;
+    fifo_push(con->fifo_app_msg, element);
+}
+
+void test_receive_bulk() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    con.fifo_app_msg = fifo_init(8);
+
+    for (unsigned char i = 0; i < 5; i++) {
+        push_received(&con, 0x61, i);
+    }
+
+    rastaApplicationMessage messages[3];
+    CU_ASSERT_EQUAL(sr_get_received_data_bulk(&h, &con, messages, 3), 3);
+    for (unsigned char i = 0; i < 3; i++) {
+        CU_ASSERT_EQUAL(messages[i].id, 0x61);
+        CU_ASSERT_EQUAL(messages[i].appMessage.length, 1);
+        CU_ASSERT_EQUAL(messages[i].appMessage.bytes[0], i);
+    }
+    sr_free_received_data_bulk(messages, 3);
+
+    // the rest is left for the next call
+    CU_ASSERT_EQUAL(sr_get_received_data_bulk(&h, &con, messages, 3), 2);
+    CU_ASSERT_EQUAL(messages[0].appMessage.bytes[0], 3);
+    CU_ASSERT_EQUAL(messages[1].appMessage.bytes[0], 4);
+    sr_free_received_data_bulk(messages, 2);
+
+    CU_ASSERT_EQUAL(sr_get_received_data_bulk(&h, &con, messages, 3), 0);
+    fifo_destroy(con.fifo_app_msg);
+}
+
+void test_send_owned() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    h.logger = logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE);
+    h.send_notify_fd = -1;
+    h.config.values.sending.max_packet = 2;
+    con.current_state = RASTA_CONNECTION_UP;
+    con.fifo_send = fifo_init(3);
+    con.fifo_send_urgent = fifo_init(4);
+
+    // the queue takes the buffer of an owned message, a copied message gets its own
+    struct RastaByteArray owned = sr_alloc_message(4);
+    memcpy(owned.bytes, "abcd", 4);
+    struct RastaByteArray copied = { .bytes = (unsigned char *) "efg", .length = 3 };
+    struct RastaMessageData messages = { .count = 1, .data_array = &owned };
+    CU_ASSERT_EQUAL(sr_send_connection_owned(&h, &con, messages), 1);
+    messages.data_array = &copied;
+    CU_ASSERT_EQUAL(sr_send_connection(&h, &con, messages), 1);
+    CU_ASSERT_EQUAL(con.send_queued_bytes, 4 + 2 + 3 + 2);
+
+    struct RastaByteArray * queued = fifo_pop(con.fifo_send);
+    CU_ASSERT_PTR_EQUAL(queued->bytes, owned.bytes);
+    CU_ASSERT_EQUAL(queued->length, 4);
+    freeRastaByteArray(queued);
+    rfree(queued);
+    queued = fifo_pop(con.fifo_send);
+    CU_ASSERT(queued->bytes != copied.bytes);
+    CU_ASSERT_EQUAL(memcmp(queued->bytes, "efg", 3), 0);
+    freeRastaByteArray(queued);
+    rfree(queued);
+
+    // rejected messages stay with the caller
+    struct RastaByteArray rejected[3] = { sr_alloc_message(1), sr_alloc_message(1), sr_alloc_message(1) };
+    messages.count = 3;
+    messages.data_array = rejected;
+    CU_ASSERT_EQUAL(sr_send_connection_owned(&h, &con, messages), 0);
+    CU_ASSERT_EQUAL(fifo_get_size(con.fifo_send), 0);
+    for (unsigned int i = 0; i < 3; i++) {
+        freeRastaByteArray(&rejected[i]);
+    }
+
+    fifo_destroy(con.fifo_send);
+    fifo_destroy(con.fifo_send_urgent);
+}
+
+void test_send_priority() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    h.logger = logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE);
+    h.send_notify_fd = -1;
+    h.config.values.sending.max_packet = 2;
+    con.current_state = RASTA_CONNECTION_UP;
+    con.fifo_send = fifo_init(4);
+    con.fifo_send_urgent = fifo_init(2);
+
+    // a burst of bulk messages is queued before an urgent one
+    struct RastaByteArray bulk[2] = { { .bytes = (unsigned char *) "b1", .length = 2 },
+                                      { .bytes = (unsigned char *) "b2", .length = 2 } };
+    struct RastaByteArray urgent = { .bytes = (unsigned char *) "u1", .length = 2 };
+    struct RastaMessageData messages = { .count = 2, .data_array = bulk };
+    CU_ASSERT_EQUAL(sr_send_connection(&h, &con, messages), 1);
+    CU_ASSERT_EQUAL(sr_send_connection(&h, &con, messages), 1);
+    messages.count = 1;
+    messages.data_array = &urgent;
+    CU_ASSERT_EQUAL(sr_send_connection_priority(&h, &con, messages, RASTA_SEND_URGENT), 1);
+    CU_ASSERT_EQUAL(fifo_get_size(con.fifo_send), 4);
+    CU_ASSERT_EQUAL(fifo_get_size(con.fifo_send_urgent), 1);
+    CU_ASSERT_EQUAL(sr_rasta_send_data_available(&h.logger, &con), 5);
+
+    // the urgent message leads the next data packet, the bulk lane fills the rest in its order
+    struct RastaMessageData data;
+    allocateRastaMessageData(&data, 2);
+    sr_take_send_messages(&h.logger, &con, &data, event_system_now(), 0);
+    CU_ASSERT_EQUAL(memcmp(data.data_array[0].bytes, "u1", 2), 0);
+    CU_ASSERT_EQUAL(memcmp(data.data_array[1].bytes, "b1", 2), 0);
+    freeRastaMessageData(&data);
+    allocateRastaMessageData(&data, 2);
+    sr_take_send_messages(&h.logger, &con, &data, event_system_now(), 0);
+    CU_ASSERT_EQUAL(memcmp(data.data_array[0].bytes, "b2", 2), 0);
+    CU_ASSERT_EQUAL(memcmp(data.data_array[1].bytes, "b1", 2), 0);
+    freeRastaMessageData(&data);
+    CU_ASSERT_EQUAL(sr_rasta_send_data_available(&h.logger, &con), 1);
+    CU_ASSERT_EQUAL(con.send_queued_bytes, 2 + 2);
+
+    // the wait of every message is recorded in the histogram of its class
+    CU_ASSERT_EQUAL(con.metrics.send_queue_us[RASTA_SEND_URGENT].count, 1);
+    CU_ASSERT_EQUAL(con.metrics.send_queue_us[RASTA_SEND_BULK].count, 3);
+
+    // a full urgent lane rejects the messages, even while the bulk lane has room
+    struct RastaByteArray urgent_burst[2] = { urgent, urgent };
+    messages.count = 2;
+    messages.data_array = urgent_burst;
+    CU_ASSERT_EQUAL(sr_send_connection_priority(&h, &con, messages, RASTA_SEND_URGENT), 1);
+    messages.count = 1;
+    CU_ASSERT_EQUAL(sr_send_connection_priority(&h, &con, messages, RASTA_SEND_URGENT), 0);
+    CU_ASSERT(con.send_blocked);
+
+    struct RastaByteArray * queued;
+    while ((queued = fifo_pop(con.fifo_send_urgent)) != NULL || (queued = fifo_pop(con.fifo_send)) != NULL) {
+        freeRastaByteArray(queued);
+        rfree(queued);
+    }
+    fifo_destroy(con.fifo_send);
+    fifo_destroy(con.fifo_send_urgent);
+}
+
+void test_diagnostic_record() {
+    static struct rasta_connection con;
+    memset(&con, 0, sizeof(con));
+    struct RastaConfigInfoSending cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.t_max = 1800;
+
+    sr_diagnostic_interval_init(&con, cfg);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals_length, 4);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[3].interval_start, 1500);
+
+    sr_diagnostic_record(&con, 0, 0);
+    sr_diagnostic_record(&con, 499, 700);
+    sr_diagnostic_record(&con, 500, 999);
+    sr_diagnostic_record(&con, 1799, 1799);
+    // beyond T_MAX the message is not counted
+    sr_diagnostic_record(&con, 2000, 2000);
+
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[0].message_count, 2);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[0].t_alive_message_count, 1);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[1].message_count, 1);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[1].t_alive_message_count, 1);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[2].message_count, 0);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[3].message_count, 1);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[3].t_alive_message_count, 1);
+
+    rfree(con.diagnostic_intervals);
+}
+
+static unsigned int diagnostic_notifications;
+static unsigned int diagnostic_messages[2];
+static unsigned int diagnostic_alive_messages[2];
+
+static void record_diagnostic(struct rasta_notification_result * result) {
+    if (diagnostic_notifications < 2) {
+        for (unsigned int i = 0; i < result->diagnostic_intervals_length; i++) {
+            diagnostic_messages[diagnostic_notifications] += result->diagnostic_intervals[i].message_count;
+            diagnostic_alive_messages[diagnostic_notifications] +=
+                    result->diagnostic_intervals[i].t_alive_message_count;
+        }
+    }
+    diagnostic_notifications++;
+}
+
+void test_diagnostic_window() {
+    static struct rasta_handle h;
+    static struct rasta_connection con;
+    memset(&h, 0, sizeof(h));
+    memset(&con, 0, sizeof(con));
+    h.notifications.on_diagnostic_notification = record_diagnostic;
+    struct RastaConfigInfoSending cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.t_max = 1800;
+    cfg.diag_window = 5;
+    sr_diagnostic_interval_init(&con, cfg);
+
+    diagnostic_notifications = 0;
+    memset(diagnostic_messages, 0, sizeof(diagnostic_messages));
+    memset(diagnostic_alive_messages, 0, sizeof(diagnostic_alive_messages));
+
+    // every message confirms the current time, so it counts in the first sub interval
+    struct RastaPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    for (unsigned int i = 0; i < 2 * cfg.diag_window; i++) {
+        packet.confirmed_timestamp = event_system_now_ms();
+        con.cts_r = event_system_now_ms();
+        updateDiagnostic(&con, packet, cfg, &h);
+    }
+
+    // one notification per window, each with all messages of its window
+    CU_ASSERT_EQUAL(diagnostic_notifications, 2);
+    for (unsigned int i = 0; i < 2; i++) {
+        CU_ASSERT_EQUAL(diagnostic_messages[i], cfg.diag_window);
+        CU_ASSERT_EQUAL(diagnostic_alive_messages[i], cfg.diag_window);
+    }
+    CU_ASSERT_EQUAL(con.received_diagnostic_message_count, 0);
+    CU_ASSERT_EQUAL(con.diagnostic_intervals[0].message_count, 0);
+
+    rfree(con.diagnostic_intervals);
+}
+
+void test_reconnect_delay() {
+    struct RastaConfigInfoSending cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.reconnect_min_ms = 100;
+    cfg.reconnect_max_ms = 1000;
+    unsigned int seed = 1;
+
+    // at most half of the delay is taken off
+    for (unsigned int i = 0; i < 100; i++) {
+        unsigned int first = sr_reconnect_delay_ms(cfg, 0, &seed);
+        CU_ASSERT(first >= 50 && first <= 100);
+        unsigned int third = sr_reconnect_delay_ms(cfg, 2, &seed);
+        CU_ASSERT(third >= 200 && third <= 400);
+        // the delay does not grow beyond reconnect_max_ms
+        unsigned int late = sr_reconnect_delay_ms(cfg, 40, &seed);
+        CU_ASSERT(late >= 500 && late <= 1000);
+    }
+
+    // the clients of a restarted server do not reconnect at the same time
+    unsigned int first = sr_reconnect_delay_ms(cfg, 3, &seed);
+    int spread = 0;
+    for (unsigned int i = 0; i < 10; i++) {
+        if (sr_reconnect_delay_ms(cfg, 3, &seed) != first) {
+            spread = 1;
+        }
+    }
+    CU_ASSERT(spread);
+}
+
+void test_connect_wave_size() {
+    struct RastaConfigInfoSending cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.connect_wave_size = 32;
+    cfg.connect_max_in_flight = 100;
+
+    CU_ASSERT_EQUAL(sr_connect_wave_size(cfg, 1000, 0), 32);
+    CU_ASSERT_EQUAL(sr_connect_wave_size(cfg, 10, 0), 10);
+    // the wave only fills the room the unfinished handshakes leave
+    CU_ASSERT_EQUAL(sr_connect_wave_size(cfg, 1000, 80), 20);
+    CU_ASSERT_EQUAL(sr_connect_wave_size(cfg, 1000, 100), 0);
+
+    // without limits every waiting peer is in the wave
+    cfg.connect_wave_size = 0;
+    cfg.connect_max_in_flight = 0;
+    CU_ASSERT_EQUAL(sr_connect_wave_size(cfg, 1000, 500), 1000);
+}
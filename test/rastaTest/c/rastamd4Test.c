@@ -6,8 +6,10 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rastamd4.h>
+#include <rastahashing.h>
 #include <rmemory.h>
 #include "../headers/rastamd4Test.h"
 
@@ -157,3 +159,319 @@ void testRastaMD4Sample() {
         CU_ASSERT_EQUAL(md4[i],calc_md4[i]);
     }
 }
+
+void testRastaHashingContextMD4() {
+    // MD4("") = 31d6cfe0d16ae931b73c59d7e0c089c0 source: Test Suite https://tools.ietf.org/html/rfc1320
+    unsigned char hashOfEmptyString[16] = {
+        0x31, 0xd6, 0xcf, 0xe0, 0xd1, 0x6a, 0xe9, 0x31, 0xb7, 0x3c, 0x59, 0xd7, 0xe0, 0xc0, 0x89, 0xc0
+    };
+
+    struct RastaByteArray data;
+    data.bytes = (unsigned char *) "";
+    data.length = 0;
+
+    rasta_hashing_context_t context;
+    context.algorithm = RASTA_ALGO_MD4;
+    context.hash_length = RASTA_CHECKSUM_16B;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    // the prepared MD4 state is reused, so hashing twice has to give the same result
+    unsigned char hash[16];
+    for (int n = 0; n < 2; n++) {
+        rasta_calculate_hash(data, &context, hash);
+        for (int i = 0; i < 16; i++) {
+            CU_ASSERT_EQUAL(hash[i], hashOfEmptyString[i]);
+        }
+    }
+
+    // setting the same initial value as a variable key prepares the same state
+    unsigned char key[16];
+    rmemcpy(key, context.key.bytes, 16);
+    freeRastaByteArray(&context.key);
+    rasta_md4_set_key(&context, 0, 0, 0, 0);
+    rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+
+    rasta_calculate_hash(data, &context, hash);
+    for (int i = 0; i < 16; i++) {
+        CU_ASSERT_EQUAL(hash[i], hashOfEmptyString[i]);
+    }
+
+    freeRastaByteArray(&context.key);
+}
+
+void testRastaHashIncremental() {
+    unsigned char data[70];
+    for (unsigned int i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)(i * 13 + 7);
+    }
+
+    unsigned char key[32];
+    for (unsigned int i = 0; i < sizeof(key); i++) {
+        key[i] = (unsigned char)(0xA0 + i);
+    }
+
+    rasta_hashing_context_t context;
+    context.key.bytes = NULL;
+    rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+
+    rasta_hash_algorithm algorithms[3] = { RASTA_ALGO_MD4, RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4 };
+    rasta_checksum_type lengths[2] = { RASTA_CHECKSUM_8B, RASTA_CHECKSUM_16B };
+
+    for (int a = 0; a < 3; a++) {
+        for (int l = 0; l < 2; l++) {
+            context.algorithm = algorithms[a];
+            context.hash_length = lengths[l];
+
+            // the hash of the whole data from the underlying implementation
+            unsigned char expected[16];
+            MD4_CONTEXT md4_ctx = context.md4_context;
+            switch (context.algorithm) {
+                case RASTA_ALGO_BLAKE2B:
+                    generateBlake2(data, sizeof(data), key, sizeof(key), context.hash_length, expected);
+                    break;
+                case RASTA_ALGO_SIPHASH_2_4:
+                    generateSiphash24(data, sizeof(data), key, context.hash_length, expected);
+                    break;
+                default:
+                    generateMD4WithVector(data, sizeof(data), context.hash_length, &md4_ctx, expected);
+                    break;
+            }
+
+            // adding the data in two pieces has to give the same result for every split
+            for (unsigned int split = 0; split <= sizeof(data); split++) {
+                unsigned char hash[16];
+                rasta_hash_state_t state;
+                rasta_hash_init(&state, &context);
+                rasta_hash_update(&state, data, split);
+                rasta_hash_update(&state, &data[split], sizeof(data) - split);
+                rasta_hash_final(&state, hash);
+
+                CU_ASSERT_EQUAL(rmemcmp(hash, expected, context.hash_length * 8), 0);
+            }
+
+            // adding single bytes
+            unsigned char hash[16];
+            rasta_hash_state_t state;
+            rasta_hash_init(&state, &context);
+            for (unsigned int i = 0; i < sizeof(data); i++) {
+                rasta_hash_update(&state, &data[i], 1);
+            }
+            rasta_hash_final(&state, hash);
+            CU_ASSERT_EQUAL(rmemcmp(hash, expected, context.hash_length * 8), 0);
+        }
+    }
+
+    freeRastaByteArray(&context.key);
+}
+
+void testRastaHashPreparedKey() {
+    unsigned char data[150];
+    for (unsigned int i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)(i * 7 + 1);
+    }
+
+    unsigned char first_key[16];
+    unsigned char key[40];
+    for (unsigned int i = 0; i < sizeof(key); i++) {
+        key[i] = (unsigned char)(0x30 + i);
+        if (i < sizeof(first_key)) {
+            first_key[i] = (unsigned char)(0xF0 - i);
+        }
+    }
+
+    rasta_hashing_context_t context;
+    context.key.bytes = NULL;
+    rasta_set_hash_key_variable(&context, (const char *) first_key, sizeof(first_key));
+    // the states of the first key must not be used for the new one
+    rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+
+    rasta_hash_algorithm algorithms[2] = { RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4 };
+    rasta_checksum_type lengths[2] = { RASTA_CHECKSUM_8B, RASTA_CHECKSUM_16B };
+    unsigned int message_lengths[4] = { 0, 1, 128, 150 };
+
+    for (int a = 0; a < 2; a++) {
+        for (int l = 0; l < 2; l++) {
+            context.algorithm = algorithms[a];
+            context.hash_length = lengths[l];
+
+            const unsigned char * messages[4];
+            const unsigned char * hashes[4];
+            unsigned char expected[4][16];
+            for (int m = 0; m < 4; m++) {
+                if (context.algorithm == RASTA_ALGO_BLAKE2B) {
+                    generateBlake2(data, message_lengths[m], key, sizeof(key), context.hash_length, expected[m]);
+                } else {
+                    generateSiphash24(data, message_lengths[m], key, context.hash_length, expected[m]);
+                }
+                messages[m] = data;
+                hashes[m] = expected[m];
+
+                unsigned char hash[16];
+                rasta_hash_select(&context)(&context, data, message_lengths[m], hash);
+                CU_ASSERT_EQUAL(rmemcmp(hash, expected[m], context.hash_length * 8), 0);
+
+                rasta_hash_state_t state;
+                rasta_hash_init(&state, &context);
+                rasta_hash_update(&state, data, message_lengths[m]);
+                rasta_hash_final(&state, hash);
+                CU_ASSERT_EQUAL(rmemcmp(hash, expected[m], context.hash_length * 8), 0);
+            }
+
+            int results[4] = { 0 };
+            rasta_hash_verify_batch(&context, messages, message_lengths, hashes, 4, results);
+            for (int m = 0; m < 4; m++) {
+                CU_ASSERT_EQUAL(results[m], 1);
+            }
+        }
+    }
+
+    // BLAKE2b can not use a key of more than 64 bytes, the hash is 8 zero bytes then
+    unsigned char long_key[65] = { 0 };
+    unsigned char zeros[8] = { 0 };
+    rasta_set_hash_key_variable(&context, (const char *) long_key, sizeof(long_key));
+    context.algorithm = RASTA_ALGO_BLAKE2B;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    for (int m = 0; m < 4; m++) {
+        unsigned char hash[8] = { 1 };
+        rasta_hash_select(&context)(&context, data, message_lengths[m], hash);
+        CU_ASSERT_EQUAL(rmemcmp(hash, zeros, sizeof(zeros)), 0);
+    }
+
+    freeRastaByteArray(&context.key);
+}
+
+void testMD4MultiBuffer() {
+    unsigned char data[200];
+    for (unsigned int i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)(i * 29 + 3);
+    }
+
+    MD4_CONTEXT initial = md4InitContext(0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210);
+
+    // messages of different lengths cover every padding case and unused lanes
+    const unsigned char * messages[9];
+    unsigned int lengths[9];
+    unsigned char results[9][16];
+
+    for (unsigned int start = 0; start + 9 <= sizeof(data); start += 7) {
+        for (unsigned int i = 0; i < 9; i++) {
+            messages[i] = &data[i];
+            lengths[i] = start + i * 3 > sizeof(data) - i ? sizeof(data) - i : start + i * 3;
+        }
+
+        for (unsigned int count = 1; count <= 9; count++) {
+            md4MultiBuffer(&initial, messages, lengths, count, results);
+
+            for (unsigned int i = 0; i < count; i++) {
+                unsigned char expected[16];
+                MD4_CONTEXT copy = initial;
+                generateMD4WithVector((unsigned char *) messages[i], (int) lengths[i], 2, &copy, expected);
+                CU_ASSERT_EQUAL(rmemcmp(results[i], expected, 16), 0);
+            }
+        }
+    }
+}
+
+void testRastaHashVerifyBatch() {
+    unsigned char data[6][200];
+    const unsigned char * messages[6];
+    unsigned int lengths[6];
+    unsigned char hashes[6][16];
+    const unsigned char * expected[6];
+    int results[6];
+
+    rasta_hashing_context_t context;
+    context.key.bytes = NULL;
+    unsigned char key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+
+    rasta_hash_algorithm algorithms[3] = { RASTA_ALGO_MD4, RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4 };
+    rasta_checksum_type hash_lengths[2] = { RASTA_CHECKSUM_8B, RASTA_CHECKSUM_16B };
+    for (int a = 0; a < 6; a++) {
+        context.algorithm = algorithms[a % 3];
+        context.hash_length = hash_lengths[a / 3];
+
+        for (int i = 0; i < 6; i++) {
+            rmemset(data[i], i + 1, sizeof(data[i]));
+            messages[i] = data[i];
+            // includes an empty message and messages longer than a BLAKE2b block
+            lengths[i] = (unsigned int)(37 * i);
+            expected[i] = hashes[i];
+
+            struct RastaByteArray message;
+            message.bytes = data[i];
+            message.length = lengths[i];
+            rasta_calculate_hash(message, &context, hashes[i]);
+        }
+
+        // corrupt the safety code of one message
+        hashes[4][0] ^= 0xFF;
+
+        rasta_hash_verify_batch(&context, messages, lengths, expected, 6, results);
+        for (int i = 0; i < 6; i++) {
+            CU_ASSERT_EQUAL(results[i], i != 4);
+        }
+    }
+
+    freeRastaByteArray(&context.key);
+}
+
+void testRastaHashSelect() {
+    unsigned char data[150];
+    for (unsigned int i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)(i * 17 + 1);
+    }
+
+    rasta_hashing_context_t context;
+    context.key.bytes = NULL;
+    unsigned char key[16] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+    rasta_set_hash_key_variable(&context, (const char *) key, sizeof(key));
+
+    // the last algorithm is unknown and hashed with MD4
+    rasta_hash_algorithm algorithms[4] = { RASTA_ALGO_MD4, RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4,
+                                           (rasta_hash_algorithm) 7 };
+    rasta_checksum_type lengths[3] = { RASTA_CHECKSUM_NONE, RASTA_CHECKSUM_8B, RASTA_CHECKSUM_16B };
+
+    for (int a = 0; a < 4; a++) {
+        for (int l = 0; l < 3; l++) {
+            context.algorithm = algorithms[a];
+            context.hash_length = lengths[l];
+            rasta_hash_function hash_function = rasta_hash_select(&context);
+
+            for (unsigned int length = 0; length <= sizeof(data); length += 50) {
+                unsigned char expected[16] = { 0 };
+                unsigned char hash[16] = { 0 };
+                rasta_hash_state_t state;
+                rasta_hash_init(&state, &context);
+                rasta_hash_update(&state, data, length);
+                rasta_hash_final(&state, expected);
+
+                hash_function(&context, data, length, hash);
+                CU_ASSERT_EQUAL(rmemcmp(hash, expected, sizeof(hash)), 0);
+            }
+        }
+    }
+
+    freeRastaByteArray(&context.key);
+}
+
+void testMD4Unaligned() {
+    unsigned char message[150];
+    for (unsigned int i = 0; i < sizeof(message); i++) {
+        message[i] = (unsigned char) (i * 31 + 7);
+    }
+
+    MD4_CONTEXT context = md4InitContext(0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210);
+    unsigned char expected[16];
+    generateMD4WithVector(message, sizeof(message), 2, &context, expected);
+
+    // the block words are loaded the same way from data at any address
+    unsigned char buffer[sizeof(message) + 8];
+    for (unsigned int offset = 1; offset < 8; offset++) {
+        memcpy(&buffer[offset], message, sizeof(message));
+        unsigned char result[16];
+        context = md4InitContext(0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210);
+        generateMD4WithVector(&buffer[offset], sizeof(message), 2, &context, result);
+        CU_ASSERT_EQUAL(memcmp(result, expected, sizeof(expected)), 0);
+    }
+}
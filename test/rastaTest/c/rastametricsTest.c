@@ -0,0 +1,161 @@
+#include <CUnit/Basic.h>
+#include <stdint.h>
+#include <string.h>
+#include "../headers/rastametricsTest.h"
+#include "rastametrics.h"
+
+void test_rasta_histogram_buckets() {
+    // the limits of the buckets increase and every value up to UINT32_MAX has a bucket
+    CU_ASSERT_EQUAL(rasta_histogram_bucket_limit(0), 0);
+    CU_ASSERT_EQUAL(rasta_histogram_bucket_limit(3), 3);
+    CU_ASSERT_EQUAL(rasta_histogram_bucket_limit(4), 4);
+    CU_ASSERT_EQUAL(rasta_histogram_bucket_limit(8), 9);
+    CU_ASSERT_EQUAL(rasta_histogram_bucket_limit(RASTA_HISTOGRAM_BUCKETS - 1), UINT32_MAX);
+    for (unsigned int i = 1; i < RASTA_HISTOGRAM_BUCKETS; i++) {
+        CU_ASSERT(rasta_histogram_bucket_limit(i) > rasta_histogram_bucket_limit(i - 1));
+    }
+
+    struct rasta_histogram histogram;
+    memset(&histogram, 0, sizeof(histogram));
+
+    rasta_histogram_record(&histogram, 2);
+    rasta_histogram_record(&histogram, 8);
+    rasta_histogram_record(&histogram, 9);
+    rasta_histogram_record(&histogram, 10);
+    rasta_histogram_record(&histogram, (unsigned long) UINT32_MAX + 5);
+
+    CU_ASSERT_EQUAL(histogram.buckets[2], 1);
+    CU_ASSERT_EQUAL(histogram.buckets[8], 2);
+    CU_ASSERT_EQUAL(histogram.buckets[9], 1);
+    CU_ASSERT_EQUAL(histogram.buckets[RASTA_HISTOGRAM_BUCKETS - 1], 1);
+    CU_ASSERT_EQUAL(histogram.count, 5);
+    CU_ASSERT_EQUAL(histogram.sum, 2 + 8 + 9 + 10 + (unsigned long) UINT32_MAX + 5);
+    CU_ASSERT_EQUAL(histogram.max, (unsigned long) UINT32_MAX + 5);
+
+    struct rasta_histogram snapshot;
+    rasta_histogram_snapshot(&histogram, &snapshot);
+    CU_ASSERT_EQUAL(memcmp(&histogram, &snapshot, sizeof(snapshot)), 0);
+}
+
+void test_rasta_histogram_percentile() {
+    struct rasta_histogram histogram;
+    memset(&histogram, 0, sizeof(histogram));
+
+    CU_ASSERT_EQUAL(rasta_histogram_percentile(&histogram, 50), 0);
+
+    for (unsigned long value = 1; value <= 1000; value++) {
+        rasta_histogram_record(&histogram, value);
+    }
+
+    // at most 25% above the exact percentile
+    unsigned long median = rasta_histogram_percentile(&histogram, 50);
+    CU_ASSERT(median >= 500 && median <= 625);
+    unsigned long p99 = rasta_histogram_percentile(&histogram, 99);
+    CU_ASSERT(p99 >= 990 && p99 <= 1000);
+
+    // never above the maximum
+    CU_ASSERT_EQUAL(rasta_histogram_percentile(&histogram, 100), 1000);
+    CU_ASSERT_EQUAL(rasta_histogram_percentile(&histogram, 0), 1);
+}
+
+void test_receive_stage_metrics() {
+    struct rasta_receive_stage_metrics metrics;
+    memset(&metrics, 0, sizeof(metrics));
+
+    rasta_receive_stage_record(&metrics, RASTA_RECEIVE_STAGE_CRC, 16, 2000);
+    rasta_receive_stage_record(&metrics, RASTA_RECEIVE_STAGE_CRC, 4, 500);
+    rasta_receive_stage_record(&metrics, RASTA_RECEIVE_STAGE_DISPATCH, 20, 9000);
+    rasta_receive_stage_reject(&metrics, RASTA_RECEIVE_STAGE_CRC, 3);
+
+    struct rasta_receive_stage_metrics snapshot;
+    rasta_receive_stage_snapshot(&metrics, &snapshot);
+    CU_ASSERT_EQUAL(snapshot.batches[RASTA_RECEIVE_STAGE_CRC], 2);
+    CU_ASSERT_EQUAL(snapshot.pdus[RASTA_RECEIVE_STAGE_CRC], 20);
+    CU_ASSERT_EQUAL(snapshot.duration[RASTA_RECEIVE_STAGE_CRC].sum, 2500);
+    CU_ASSERT_EQUAL(snapshot.duration[RASTA_RECEIVE_STAGE_CRC].max, 2000);
+    CU_ASSERT_EQUAL(snapshot.batches[RASTA_RECEIVE_STAGE_DISPATCH], 1);
+    CU_ASSERT_EQUAL(snapshot.batches[RASTA_RECEIVE_STAGE_DRAIN], 0);
+    CU_ASSERT_EQUAL(snapshot.rejected[RASTA_RECEIVE_STAGE_CRC], 3);
+    CU_ASSERT_EQUAL(snapshot.rejected[RASTA_RECEIVE_STAGE_DISPATCH], 0);
+
+    // every stage has a name for the labels
+    CU_ASSERT_STRING_EQUAL(rasta_receive_stage_name(RASTA_RECEIVE_STAGE_DRAIN), "drain");
+    CU_ASSERT_STRING_EQUAL(rasta_receive_stage_name(RASTA_RECEIVE_STAGE_PLAUSIBILITY), "plausibility");
+    CU_ASSERT_STRING_EQUAL(rasta_receive_stage_name(RASTA_RECEIVE_STAGE_SAFETY_CODE), "safety_code");
+    CU_ASSERT_STRING_EQUAL(rasta_receive_stage_name(RASTA_RECEIVE_STAGES), "unknown");
+}
+
+/**
+ * @param remote_id the RaSTA ID of the peer
+ * @param ns the time the peer costs
+ * @param bytes the bytes the peer received
+ * @return what the peer costs
+ */
+static struct rasta_peer_usage peer_usage(unsigned long remote_id, unsigned long ns, unsigned long bytes) {
+    struct rasta_peer_usage usage;
+    memset(&usage, 0, sizeof(usage));
+    usage.remote_id = remote_id;
+    usage.receive_ns = ns / 2;
+    usage.safety_code_ns = ns - ns / 2;
+    usage.bytes_in = bytes;
+    return usage;
+}
+
+void test_peer_ranking() {
+    struct rasta_peer_usage ranking[3];
+    unsigned int count = 0;
+
+    struct rasta_peer_usage usage = peer_usage(1, 100, 0);
+    CU_ASSERT_EQUAL(rasta_peer_usage_ns(&usage), 100);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    usage = peer_usage(2, 500, 0);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    usage = peer_usage(3, 50, 0);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(ranking[0].remote_id, 2);
+    CU_ASSERT_EQUAL(ranking[1].remote_id, 1);
+    CU_ASSERT_EQUAL(ranking[2].remote_id, 3);
+
+    // a full ranking drops its cheapest peer for a more expensive one, a cheaper one is not added
+    usage = peer_usage(4, 200, 0);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    usage = peer_usage(5, 10, 0);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(ranking[0].remote_id, 2);
+    CU_ASSERT_EQUAL(ranking[1].remote_id, 4);
+    CU_ASSERT_EQUAL(ranking[2].remote_id, 1);
+
+    // ties are ranked by the bytes
+    usage = peer_usage(6, 200, 1000);
+    count = rasta_peer_ranking_insert(ranking, count, 3, &usage);
+    CU_ASSERT_EQUAL(ranking[1].remote_id, 6);
+    CU_ASSERT_EQUAL(ranking[2].remote_id, 4);
+}
+
+void test_residency_metrics() {
+    struct rasta_residency_metrics residency;
+    memset(&residency, 0, sizeof(residency));
+
+    // the waits are recorded in microseconds, messages without a timestamp are not recorded
+    rasta_residency_record(&residency, RASTA_RESIDENCY_DEFER, 1000000, 1250000);
+    rasta_residency_record(&residency, RASTA_RESIDENCY_DEFER, 0, 1250000);
+    rasta_residency_record(NULL, RASTA_RESIDENCY_DEFER, 1000000, 1250000);
+    CU_ASSERT_EQUAL(residency.wait_us[RASTA_RESIDENCY_DEFER].count, 1);
+    CU_ASSERT_EQUAL(residency.wait_us[RASTA_RESIDENCY_DEFER].sum, 250);
+    CU_ASSERT_EQUAL(residency.wait_us[RASTA_RESIDENCY_SEND_QUEUE].count, 0);
+
+    // the snapshot only copies the given stages
+    rasta_residency_record(&residency, RASTA_RESIDENCY_APPLICATION, 1000, 3000);
+    struct rasta_residency_metrics out;
+    memset(&out, 0, sizeof(out));
+    rasta_residency_snapshot(&residency, RASTA_RESIDENCY_SEND_QUEUE, RASTA_RESIDENCY_DEFER, &out);
+    CU_ASSERT_EQUAL(out.wait_us[RASTA_RESIDENCY_DEFER].count, 1);
+    CU_ASSERT_EQUAL(out.wait_us[RASTA_RESIDENCY_APPLICATION].count, 0);
+    rasta_residency_snapshot(NULL, RASTA_RESIDENCY_SEND_QUEUE, RASTA_RESIDENCY_APPLICATION, &out);
+    CU_ASSERT_EQUAL(out.wait_us[RASTA_RESIDENCY_DEFER].count, 1);
+
+    CU_ASSERT_STRING_EQUAL(rasta_residency_stage_name(RASTA_RESIDENCY_RECEIVE_QUEUE), "receive_queue");
+    CU_ASSERT_STRING_EQUAL(rasta_residency_stage_name(RASTA_RESIDENCY_STAGES), "unknown");
+}
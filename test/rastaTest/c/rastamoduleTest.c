@@ -4,6 +4,9 @@
 
 #include "../headers/rastamoduleTest.h"
 #include "rastamodule.h"
+#include "rastafactory.h"
+#include "rastawire.h"
+#include "rmemory.h"
 
 #include "CUnit/Basic.h"
 
@@ -100,14 +103,15 @@ void testRedundancyConversionWithCrcChecksumCorrect() {
     packet_to_test.length = 50;
     packet_to_test.reserve = 0;
     packet_to_test.sequence_number = 1;
-    packet_to_test.checksum_type = crc_init_opt_b();
+    struct crc_options checksum_options = crc_init_opt_b();
+    packet_to_test.checksum_type = &checksum_options;
     packet_to_test.data = r;
 
     struct RastaByteArray convertedToBytes;
-    convertedToBytes = rastaRedundancyPacketToBytes(packet_to_test, &context);
+    convertedToBytes = rastaRedundancyPacketToBytes(&packet_to_test, &context);
 
     struct RastaRedundancyPacket convertedFromBytes;
-    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, crc_init_opt_b(), &context);
+    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, &checksum_options, &context);
 
     CU_ASSERT_EQUAL(convertedFromBytes.length, packet_to_test.length);
     CU_ASSERT_EQUAL(convertedFromBytes.reserve, packet_to_test.reserve);
@@ -160,14 +164,15 @@ void testRedundancyConversionWithoutChecksum() {
     packet_to_test.length = 50;
     packet_to_test.reserve = 0;
     packet_to_test.sequence_number = 1;
-    packet_to_test.checksum_type = crc_init_opt_a();
+    struct crc_options checksum_options = crc_init_opt_a();
+    packet_to_test.checksum_type = &checksum_options;
     packet_to_test.data = r;
 
     struct RastaByteArray convertedToBytes;
-    convertedToBytes = rastaRedundancyPacketToBytes(packet_to_test, &context);
+    convertedToBytes = rastaRedundancyPacketToBytes(&packet_to_test, &context);
 
     struct RastaRedundancyPacket convertedFromBytes;
-    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, crc_init_opt_a(), &context);
+    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, &checksum_options, &context);
 
     CU_ASSERT_EQUAL(convertedFromBytes.length, packet_to_test.length);
     CU_ASSERT_EQUAL(convertedFromBytes.reserve, packet_to_test.reserve);
@@ -218,19 +223,401 @@ void testRedundancyConversionIncorrectChecksum() {
     packet_to_test.length = 50;
     packet_to_test.reserve = 0;
     packet_to_test.sequence_number = 1;
-    packet_to_test.checksum_type = crc_init_opt_b();
+    struct crc_options checksum_options = crc_init_opt_b();
+    packet_to_test.checksum_type = &checksum_options;
     packet_to_test.data = r;
 
     struct RastaByteArray convertedToBytes;
-    convertedToBytes = rastaRedundancyPacketToBytes(packet_to_test, &context);
+    convertedToBytes = rastaRedundancyPacketToBytes(&packet_to_test, &context);
 
     // simulate error in packet transmission
     convertedToBytes.bytes[16] = 0x42;
 
     struct RastaRedundancyPacket convertedFromBytes;
-    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, crc_init_opt_b(), &context);
+    convertedFromBytes = bytesToRastaRedundancyPacket(convertedToBytes, &checksum_options, &context);
 
     //check if internal packet checksum is incorrect
     CU_ASSERT_EQUAL(convertedFromBytes.data.checksum_correct,0);
 }
 
+
+void testRedundancyConversionView() {
+    rasta_hashing_context_t context;
+    context.algorithm = RASTA_ALGO_MD4;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    rasta_md4_set_key(&context, 0, 0, 0 ,0);
+
+    struct RastaRedundancyPacket packet_to_test;
+    struct RastaPacket r;
+    r.length = 38;
+    r.type = 6543;
+    r.sender_id = 12345;
+    r.receiver_id = 54321;
+    r.sequence_number = 1357;
+    r.confirmed_sequence_number = 7531;
+    r.timestamp = 2468;
+    r.confirmed_timestamp = 8642;
+    allocateRastaByteArray(&r.data,2);
+
+    r.data.bytes[0] = 0x11;
+    r.data.bytes[1] = 0x22;
+
+    packet_to_test.length = 50;
+    packet_to_test.reserve = 0;
+    packet_to_test.sequence_number = 1;
+    struct crc_options checksum_options = crc_init_opt_b();
+    packet_to_test.checksum_type = &checksum_options;
+    packet_to_test.data = r;
+
+    struct RastaByteArray convertedToBytes;
+    convertedToBytes = rastaRedundancyPacketToBytes(&packet_to_test, &context);
+
+    struct crc_options options = crc_init_opt_b();
+    struct RastaRedundancyPacketView view;
+    int res = rastaRedundancyPacketViewFromBytes(convertedToBytes.bytes, convertedToBytes.length, &options, &context, &view);
+
+    CU_ASSERT_EQUAL(res, 1);
+    CU_ASSERT_EQUAL(view.length, packet_to_test.length);
+    CU_ASSERT_EQUAL(view.sequence_number, packet_to_test.sequence_number);
+    CU_ASSERT_EQUAL(view.checksum_correct, 1);
+
+    // internal package, the data is not copied
+    CU_ASSERT_EQUAL(view.data.length, r.length);
+    CU_ASSERT_EQUAL(view.data.type, r.type);
+    CU_ASSERT_EQUAL(view.data.sender_id, r.sender_id);
+    CU_ASSERT_EQUAL(view.data.receiver_id, r.receiver_id);
+    CU_ASSERT_EQUAL(view.data.sequence_number, r.sequence_number);
+    CU_ASSERT_EQUAL(view.data.confirmed_timestamp, r.confirmed_timestamp);
+    CU_ASSERT_EQUAL(view.data.data_length, r.data.length);
+    CU_ASSERT_PTR_EQUAL(view.data.data, &convertedToBytes.bytes[8 + 28]);
+    CU_ASSERT_PTR_EQUAL(view.data.checksum, &convertedToBytes.bytes[8 + 28 + 2]);
+    CU_ASSERT_EQUAL(view.data.checksum_length, 8);
+    CU_ASSERT_EQUAL(view.data.checksum_correct, 1);
+
+    // the owning copy has the same content
+    struct RastaPacket copy = rastaPacketFromView(&view.data);
+    CU_ASSERT_EQUAL(copy.sequence_number, r.sequence_number);
+    CU_ASSERT_EQUAL(copy.data.length, r.data.length);
+    CU_ASSERT_EQUAL(copy.data.bytes[0], 0x11);
+    CU_ASSERT_EQUAL(copy.data.bytes[1], 0x22);
+    CU_ASSERT_EQUAL(copy.checksum_correct, 1);
+    freeRastaByteArray(&copy.data);
+    freeRastaByteArray(&copy.checksum);
+
+    // a manipulated payload is detected by both checksums
+    convertedToBytes.bytes[8 + 28] ^= 0xFF;
+    res = rastaRedundancyPacketViewFromBytes(convertedToBytes.bytes, convertedToBytes.length, &options, &context, &view);
+    CU_ASSERT_EQUAL(res, 1);
+    CU_ASSERT_EQUAL(view.checksum_correct, 0);
+    CU_ASSERT_EQUAL(view.data.checksum_correct, 0);
+
+    // too short to carry the inner packet
+    res = rastaRedundancyPacketViewFromBytes(convertedToBytes.bytes, 20, &options, &context, &view);
+    CU_ASSERT_EQUAL(res, 1);
+    CU_ASSERT_EQUAL(view.data.length, 0);
+
+    // too short for the redundancy header
+    res = rastaRedundancyPacketViewFromBytes(convertedToBytes.bytes, 4, &options, &context, &view);
+    CU_ASSERT_EQUAL(res, 0);
+
+    freeRastaByteArray(&convertedToBytes);
+    freeRastaByteArray(&r.data);
+    freeRastaByteArray(&context.key);
+}
+
+void testRedundancyPacketEncode(){
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct RastaPacket r;
+    r.length = 38;
+    r.type = 6543;
+    r.sender_id = 12345;
+    r.receiver_id = 54321;
+    r.sequence_number = 1357;
+    r.confirmed_sequence_number = 7531;
+    r.timestamp = 2468;
+    r.confirmed_timestamp = 8642;
+    allocateRastaByteArray(&r.data, 2);
+    r.data.bytes[0] = 0x11;
+    r.data.bytes[1] = 0x22;
+
+    struct crc_options options = crc_init_opt_b();
+    crc_generate_table(&options);
+    struct RastaRedundancyPacket packet = createRedundancyPacket(42, &r, &options);
+    struct RastaByteArray expected = rastaRedundancyPacketToBytes(&packet, &context);
+
+    // the encoder writes the same bytes into the buffer of the caller
+    unsigned char buffer[128];
+    unsigned int length = rastaRedundancyPacketEncode(42, &r, &options, &context, buffer, sizeof(buffer));
+    CU_ASSERT_EQUAL(length, expected.length);
+    CU_ASSERT_EQUAL(rmemcmp(buffer, expected.bytes, expected.length), 0);
+
+    // the inner packet matches the standalone SR layer encoding
+    struct RastaByteArray inner = rastaModuleToBytes(r, &context);
+    unsigned char inner_buffer[64];
+    CU_ASSERT_EQUAL(rastaPacketEncode(&r, &context, inner_buffer, sizeof(inner_buffer)), inner.length);
+    CU_ASSERT_EQUAL(rmemcmp(inner_buffer, inner.bytes, inner.length), 0);
+    CU_ASSERT_EQUAL(rmemcmp(&buffer[8], inner.bytes, inner.length), 0);
+
+    // a buffer that is too small is not written
+    CU_ASSERT_EQUAL(rastaRedundancyPacketEncode(42, &r, &options, &context, buffer, expected.length - 1), 0);
+    CU_ASSERT_EQUAL(rastaPacketEncode(&r, &context, inner_buffer, r.length - 1), 0);
+
+    freeRastaByteArray(&inner);
+    freeRastaByteArray(&expected);
+    freeRastaByteArray(&r.data);
+    freeRastaByteArray(&context.key);
+}
+
+void testPacketRestampAndWrap(){
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct RastaPacket r;
+    r.length = 38;
+    r.type = RASTA_TYPE_DATA;
+    r.sender_id = 12345;
+    r.receiver_id = 54321;
+    r.sequence_number = 1357;
+    r.confirmed_sequence_number = 7531;
+    r.timestamp = 2468;
+    r.confirmed_timestamp = 8642;
+    allocateRastaByteArray(&r.data, 2);
+    r.data.bytes[0] = 0x11;
+    r.data.bytes[1] = 0x22;
+
+    unsigned char pdu[64];
+    unsigned int length = rastaPacketEncode(&r, &context, pdu, sizeof(pdu));
+    CU_ASSERT_EQUAL(length, 38);
+
+    // the restamped packet is the same as a newly encoded retransmission
+    rastaPacketRestamp(pdu, length, RASTA_TYPE_RETRDATA, 1400, 7600, 2500, 8700, &context);
+    r.type = RASTA_TYPE_RETRDATA;
+    r.sequence_number = 1400;
+    r.confirmed_sequence_number = 7600;
+    r.timestamp = 2500;
+    r.confirmed_timestamp = 8700;
+
+    unsigned char expected[64];
+    CU_ASSERT_EQUAL(rastaPacketEncode(&r, &context, expected, sizeof(expected)), length);
+    CU_ASSERT_EQUAL(rmemcmp(pdu, expected, length), 0);
+
+    struct RastaByteArray bytes;
+    bytes.bytes = pdu;
+    bytes.length = length;
+    struct RastaPacket decoded = bytesToRastaPacket(bytes, &context);
+    CU_ASSERT_EQUAL(decoded.checksum_correct, 1);
+    CU_ASSERT_EQUAL(decoded.sequence_number, 1400);
+    freeRastaByteArray(&decoded.data);
+    freeRastaByteArray(&decoded.checksum);
+
+    // wrapping the encoded packet gives the same redundancy layer PDU as encoding the packet
+    struct crc_options options = crc_init_opt_b();
+    unsigned char wrapped[128], encoded[128];
+    unsigned int wrapped_length = rastaRedundancyPacketWrap(42, pdu, length, &options, wrapped, sizeof(wrapped));
+    CU_ASSERT_EQUAL(wrapped_length, 8 + length + 4);
+    CU_ASSERT_EQUAL(rastaRedundancyPacketEncode(42, &r, &options, &context, encoded, sizeof(encoded)), wrapped_length);
+    CU_ASSERT_EQUAL(rmemcmp(wrapped, encoded, wrapped_length), 0);
+
+    // a buffer that is too small is not written
+    CU_ASSERT_EQUAL(rastaRedundancyPacketWrap(42, pdu, length, &options, wrapped, wrapped_length - 1), 0);
+
+    freeRastaByteArray(&r.data);
+    freeRastaByteArray(&context.key);
+}
+
+void testRedundancyConversionViewBatch(){
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct crc_options options = crc_init_opt_b();
+
+    unsigned char buffers[6][128];
+    unsigned char * bytes[6];
+    unsigned int lengths[6];
+
+    for (unsigned int i = 0; i < 6; i++) {
+        struct RastaPacket r;
+        r.length = (uint16_t)(36 + i * 4);
+        r.type = RASTA_TYPE_DATA;
+        r.sender_id = 12345;
+        r.receiver_id = 54321;
+        r.sequence_number = 100 + i;
+        r.confirmed_sequence_number = 7531;
+        r.timestamp = 2468;
+        r.confirmed_timestamp = 8642;
+        allocateRastaByteArray(&r.data, i * 4);
+        rmemset(r.data.bytes, (int) i, i * 4);
+
+        bytes[i] = buffers[i];
+        lengths[i] = rastaRedundancyPacketEncode(i, &r, &options, &context, buffers[i], sizeof(buffers[i]));
+        freeRastaByteArray(&r.data);
+    }
+
+    // a manipulated payload, a manipulated safety code and a datagram that is too short
+    buffers[1][8 + 28] ^= 0xFF;
+    buffers[2][lengths[2] - 5] ^= 0xFF;
+    lengths[5] = 4;
+
+    struct RastaRedundancyPacketView views[6];
+    int decoded[6];
+    rastaRedundancyPacketViewsFromBytes(bytes, lengths, 6, &options, &context, views, decoded);
+
+    for (unsigned int i = 0; i < 6; i++) {
+        struct RastaRedundancyPacketView expected;
+        int res = rastaRedundancyPacketViewFromBytes(bytes[i], lengths[i], &options, &context, &expected);
+
+        CU_ASSERT_EQUAL(decoded[i], res);
+        if (!res) {
+            continue;
+        }
+        CU_ASSERT_EQUAL(views[i].sequence_number, expected.sequence_number);
+        CU_ASSERT_EQUAL(views[i].checksum_correct, expected.checksum_correct);
+        CU_ASSERT_EQUAL(views[i].data.sequence_number, expected.data.sequence_number);
+        CU_ASSERT_EQUAL(views[i].data.data_length, expected.data.data_length);
+        CU_ASSERT_EQUAL(views[i].data.checksum_correct, expected.data.checksum_correct);
+    }
+
+    CU_ASSERT_EQUAL(views[0].data.checksum_correct, 1);
+    CU_ASSERT_EQUAL(views[1].data.checksum_correct, 0);
+    CU_ASSERT_EQUAL(views[2].data.checksum_correct, 0);
+    CU_ASSERT_EQUAL(views[3].data.checksum_correct, 1);
+    CU_ASSERT_EQUAL(decoded[5], 0);
+
+    freeRastaByteArray(&context.key);
+}
+
+void testRedundancyPacketFusedChecksums(){
+    rasta_hash_algorithm algorithms[3] = { RASTA_ALGO_MD4, RASTA_ALGO_BLAKE2B, RASTA_ALGO_SIPHASH_2_4 };
+    struct crc_options variants[2] = { crc_init_opt_b(), crc_init_opt_c() };
+
+    // the data spans several chunks of the fused calculation
+    unsigned int data_length = 2 * RASTA_HASH_CRC_CHUNK + 77;
+
+    for (int a = 0; a < 3; a++) {
+        for (int v = 0; v < 2; v++) {
+            rasta_hashing_context_t context;
+            context.hash_length = RASTA_CHECKSUM_16B;
+            context.algorithm = algorithms[a];
+            if (algorithms[a] == RASTA_ALGO_MD4) {
+                rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+            } else {
+                context.key.bytes = NULL;
+                rasta_set_hash_key_variable(&context, "0123456789abcdef", 16);
+            }
+
+            struct RastaPacket r;
+            r.length = (uint16_t)(28 + data_length + 16);
+            r.type = RASTA_TYPE_DATA;
+            r.sender_id = 12345;
+            r.receiver_id = 54321;
+            r.sequence_number = 1357;
+            r.confirmed_sequence_number = 7531;
+            r.timestamp = 2468;
+            r.confirmed_timestamp = 8642;
+            allocateRastaByteArray(&r.data, data_length);
+            for (unsigned int i = 0; i < data_length; i++) {
+                r.data.bytes[i] = (unsigned char)(i * 31 + a);
+            }
+
+            unsigned char buffer[1024];
+            unsigned int length = rastaRedundancyPacketEncode(42, &r, &variants[v], &context, buffer, sizeof(buffer));
+            CU_ASSERT_EQUAL_FATAL(length, 8 + r.length + 4);
+
+            // the safety code covers the SR layer packet in front of it
+            unsigned char hash[16];
+            struct RastaByteArray hashed;
+            hashed.bytes = &buffer[8];
+            hashed.length = r.length - 16;
+            rasta_calculate_hash(hashed, &context, hash);
+            CU_ASSERT_EQUAL(rmemcmp(hash, &buffer[8 + r.length - 16], 16), 0);
+
+            // the CRC checksum covers everything in front of it, including the safety code
+            unsigned char crc[4];
+            struct RastaByteArray covered;
+            covered.bytes = buffer;
+            covered.length = length - 4;
+            hostLongToLe((uint32_t) crc_calculate(&variants[v], covered), crc);
+            CU_ASSERT_EQUAL(rmemcmp(crc, &buffer[length - 4], 4), 0);
+
+            struct RastaRedundancyPacketView view;
+            CU_ASSERT_EQUAL(rastaRedundancyPacketViewFromBytes(buffer, length, &variants[v], &context, &view), 1);
+            CU_ASSERT_EQUAL(view.checksum_correct, 1);
+            CU_ASSERT_EQUAL(view.data.checksum_correct, 1);
+
+            // a manipulation in the second chunk is detected by both checksums, also by a batch of one packet
+            buffer[8 + RASTA_HASH_CRC_CHUNK + 3] ^= 0x01;
+            unsigned char * bytes[1] = { buffer };
+            int decoded;
+            CU_ASSERT_EQUAL(rastaRedundancyPacketViewFromBytes(buffer, length, &variants[v], &context, &view), 1);
+            CU_ASSERT_EQUAL(view.checksum_correct, 0);
+            CU_ASSERT_EQUAL(view.data.checksum_correct, 0);
+            rastaRedundancyPacketViewsFromBytes(bytes, &length, 1, &variants[v], &context, &view, &decoded);
+            CU_ASSERT_EQUAL(decoded, 1);
+            CU_ASSERT_EQUAL(view.checksum_correct, 0);
+            CU_ASSERT_EQUAL(view.data.checksum_correct, 0);
+
+            freeRastaByteArray(&r.data);
+            freeRastaByteArray(&context.key);
+        }
+    }
+}
+
+void testWireLayout(){
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct RastaPacket r;
+    r.length = (uint16_t) rasta_sr_pdu_length(2, 8);
+    r.type = RASTA_TYPE_DATA;
+    r.receiver_id = 0x04030201;
+    r.sender_id = 0x08070605;
+    r.sequence_number = 0x0c0b0a09;
+    r.confirmed_sequence_number = 0x100f0e0d;
+    r.timestamp = 0x14131211;
+    r.confirmed_timestamp = 0x18171615;
+    allocateRastaByteArray(&r.data, 2);
+    r.data.bytes[0] = 0x11;
+    r.data.bytes[1] = 0x22;
+
+    struct crc_options options = crc_init_opt_b();
+    crc_generate_table(&options);
+    unsigned char buffer[128];
+    unsigned int length = rastaRedundancyPacketEncode(0x24232221, &r, &options, &context, buffer, sizeof(buffer));
+    CU_ASSERT_EQUAL(length, rasta_red_pdu_length(r.length, 4));
+
+    // the fields are little-endian at the offsets of the layout
+    const unsigned char redundancy_header[] = {(unsigned char) length, 0x00, 0x00, 0x00, 0x21, 0x22, 0x23, 0x24};
+    CU_ASSERT_EQUAL(rmemcmp(buffer, redundancy_header, RASTA_RED_HEADER_LENGTH), 0);
+
+    unsigned char * pdu = &buffer[RASTA_RED_OFFSET_PDU];
+    const unsigned char sr_header[] = {(unsigned char) r.length, 0x00, 0x60, 0x18,
+                                       0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+                                       0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+                                       0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18};
+    CU_ASSERT_EQUAL(rmemcmp(pdu, sr_header, RASTA_SR_HEADER_LENGTH), 0);
+    CU_ASSERT_EQUAL(pdu[RASTA_SR_OFFSET_DATA], 0x11);
+    CU_ASSERT_EQUAL(pdu[RASTA_SR_OFFSET_DATA + 1], 0x22);
+    CU_ASSERT_EQUAL(rasta_sr_data_length(r.length, 8), 2);
+
+    // the accessors read the fields at any alignment
+    CU_ASSERT_EQUAL(rasta_wire_get_u16(&pdu[RASTA_SR_OFFSET_TYPE]), RASTA_TYPE_DATA);
+    CU_ASSERT_EQUAL(rasta_wire_get_u32(&pdu[RASTA_SR_OFFSET_CONFIRMED_TIMESTAMP]), 0x18171615);
+    rasta_wire_put_u32(&buffer[1], 0xdeadbeef);
+    CU_ASSERT_EQUAL(buffer[1], 0xef);
+    CU_ASSERT_EQUAL(rasta_wire_get_u32(&buffer[1]), 0xdeadbeef);
+    rasta_wire_put_u16(&buffer[3], 0xbeef);
+    CU_ASSERT_EQUAL(leShortToHost(&buffer[3]), 0xbeef);
+
+    freeRastaByteArray(&r.data);
+    freeRastaByteArray(&context.key);
+}
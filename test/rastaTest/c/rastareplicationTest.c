@@ -0,0 +1,223 @@
+#include <CUnit/Basic.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "../headers/rastareplicationTest.h"
+#include "rastareplication.h"
+#include "rastautil.h"
+#include "rmemory.h"
+
+/**
+ * a replica with two transport channels and a session key
+ */
+static struct rasta_replica create_replica(uint32_t remote_id, uint32_t sn_t) {
+    struct rasta_replica replica;
+    memset(&replica, 0, sizeof(replica));
+    replica.my_id = 0x61;
+    replica.remote_id = remote_id;
+    replica.network_id = 1234;
+    replica.role = 1;
+    replica.sn_t = sn_t;
+    replica.sn_r = 200;
+    replica.cs_t = sn_t - 3;
+    replica.cs_r = 199;
+    replica.ts_r = 5000;
+    replica.cts_r = 4990;
+    replica.sn_i = 17;
+    replica.t_i = 750;
+    replica.connected_recv_buffer_size = 20;
+    replica.timestamp_offset = 0xfffffff0;
+    replica.seq_tx = 40;
+    replica.seq_rx = 41;
+    replica.channel_count = 2;
+    strcpy(replica.channels[0].ip, "127.0.0.1");
+    replica.channels[0].port = 9998;
+    strcpy(replica.channels[1].ip, "10.1.2.3");
+    replica.channels[1].port = 9999;
+    replica.key_length = 4;
+    memcpy(replica.key, "\x01\x02\x03\x04", 4);
+    return replica;
+}
+
+/**
+ * adds a data PDU with the given sequence number to the buffer
+ */
+static void add_packet(struct retr_buffer * buffer, rasta_hashing_context_t * context, uint32_t sequence_number) {
+    struct RastaPacket packet;
+    packet.length = 38;
+    packet.type = RASTA_TYPE_DATA;
+    packet.sender_id = 0x61;
+    packet.receiver_id = 0x62;
+    packet.sequence_number = sequence_number;
+    packet.confirmed_sequence_number = 199;
+    packet.timestamp = 2468;
+    packet.confirmed_timestamp = 8642;
+    allocateRastaByteArray(&packet.data, 2);
+    packet.data.bytes[0] = 0x11;
+    packet.data.bytes[1] = (unsigned char) sequence_number;
+    retrbuffer_add(buffer, &packet, context);
+    freeRastaByteArray(&packet.data);
+}
+
+/**
+ * receives on the standby until nothing arrives for 100 ms
+ * @return the result of the last rasta_replication_receive()
+ */
+static int pump(struct rasta_replication * standby, uint32_t now) {
+    int result = 1;
+    struct pollfd readable = { .fd = standby->fd, .events = POLLIN };
+    while (result && poll(&readable, 1, 100) > 0) {
+        result = rasta_replication_receive(standby, now);
+    }
+    return result;
+}
+
+void test_replica_encode_decode() {
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct retr_buffer buffer = retrbuffer_init(4);
+    add_packet(&buffer, &context, 101);
+    add_packet(&buffer, &context, 102);
+
+    struct rasta_replica replica = create_replica(0x62, 103);
+    size_t size = rasta_replica_encoded_size(&replica, &buffer);
+    unsigned char data[size];
+    CU_ASSERT_EQUAL(rasta_replica_encode(&replica, &buffer, data, size - 1), 0);
+    CU_ASSERT_EQUAL(rasta_replica_encode(&replica, &buffer, data, size), size);
+
+    struct rasta_replica decoded;
+    CU_ASSERT_EQUAL_FATAL(rasta_replica_decode(&decoded, data, size), 1);
+    CU_ASSERT_EQUAL(decoded.my_id, 0x61);
+    CU_ASSERT_EQUAL(decoded.remote_id, 0x62);
+    CU_ASSERT_EQUAL(decoded.network_id, 1234);
+    CU_ASSERT_EQUAL(decoded.role, 1);
+    CU_ASSERT_EQUAL(decoded.sn_t, 103);
+    CU_ASSERT_EQUAL(decoded.sn_r, 200);
+    CU_ASSERT_EQUAL(decoded.cs_t, 100);
+    CU_ASSERT_EQUAL(decoded.cs_r, 199);
+    CU_ASSERT_EQUAL(decoded.ts_r, 5000);
+    CU_ASSERT_EQUAL(decoded.cts_r, 4990);
+    CU_ASSERT_EQUAL(decoded.sn_i, 17);
+    CU_ASSERT_EQUAL(decoded.t_i, 750);
+    CU_ASSERT_EQUAL(decoded.connected_recv_buffer_size, 20);
+    CU_ASSERT_EQUAL(decoded.timestamp_offset, 0xfffffff0);
+    CU_ASSERT_EQUAL(decoded.seq_tx, 40);
+    CU_ASSERT_EQUAL(decoded.seq_rx, 41);
+    CU_ASSERT_EQUAL(decoded.channel_count, 2);
+    CU_ASSERT_STRING_EQUAL(decoded.channels[1].ip, "10.1.2.3");
+    CU_ASSERT_EQUAL(decoded.channels[1].port, 9999);
+    CU_ASSERT_EQUAL(decoded.key_length, 4);
+    CU_ASSERT_EQUAL(memcmp(decoded.key, "\x01\x02\x03\x04", 4), 0);
+    CU_ASSERT_EQUAL(decoded.retr_count, 2);
+
+    // the PDUs are the ones in the buffer
+    size_t offset = 0;
+    uint32_t sequence_number;
+    unsigned int length;
+    for (unsigned int i = 0; i < 2; i++) {
+        const unsigned char * pdu = rasta_replica_next_pdu(&decoded, &offset, &sequence_number, &length);
+        struct rasta_retr_element * element = retrbuffer_get(&buffer, i);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(pdu);
+        CU_ASSERT_EQUAL(sequence_number, element->sequence_number);
+        CU_ASSERT_EQUAL(length, element->length);
+        CU_ASSERT_EQUAL(memcmp(pdu, element->pdu, length), 0);
+    }
+    CU_ASSERT_PTR_NULL(rasta_replica_next_pdu(&decoded, &offset, &sequence_number, &length));
+
+    // a record that lost its end is refused
+    CU_ASSERT_FALSE(rasta_replica_decode(&decoded, data, size - 1));
+    CU_ASSERT_FALSE(rasta_replica_decode(&decoded, data, 20));
+
+    retrbuffer_destroy(&buffer);
+}
+
+void test_replication_stream() {
+    struct rasta_replication standby, primary;
+    rasta_replication_init_standby(&standby, "127.0.0.1", 0);
+    rasta_replication_init_primary(&primary, "127.0.0.1", ntohs(standby.address.sin_port), 20);
+
+    // the connect finishes within a few rounds
+    int connected = 0;
+    for (unsigned int i = 0; i < 100 && connected == 0; i++) {
+        connected = rasta_replication_connect(&primary);
+        if (connected == 0) {
+            poll(NULL, 0, 1);
+        }
+    }
+    CU_ASSERT_EQUAL_FATAL(connected, 2);
+    CU_ASSERT_EQUAL(rasta_replication_connect(&primary), 1);
+    poll(NULL, 0, 10);
+    CU_ASSERT_NOT_EQUAL(rasta_replication_accept(&standby), -1);
+    CU_ASSERT_FATAL(standby.fd != -1);
+
+    struct retr_buffer buffer = retrbuffer_init(4);
+    struct rasta_replica first = create_replica(0x62, 103);
+    struct rasta_replica second = create_replica(0x63, 50);
+    CU_ASSERT_TRUE(rasta_replication_queue(&primary, RASTA_REPLICATION_RESET, NULL, 0));
+    CU_ASSERT_TRUE(rasta_replication_queue_connection(&primary, &first, &buffer));
+    CU_ASSERT_TRUE(rasta_replication_queue_connection(&primary, &second, &buffer));
+    CU_ASSERT_TRUE(rasta_replication_queue_round(&primary, 1000));
+    CU_ASSERT_TRUE(rasta_replication_flush(&primary));
+    CU_ASSERT_EQUAL(primary.out_length, 0);
+
+    CU_ASSERT_TRUE(pump(&standby, 400));
+    CU_ASSERT_EQUAL(standby.entry_count, 2);
+    CU_ASSERT_EQUAL(standby.rounds, 1);
+    CU_ASSERT_EQUAL(standby.timestamp_offset, 600);
+    CU_ASSERT_EQUAL(standby.primary_interval_ms, 20);
+
+    // a later record replaces the previous one, a removed connection is forgotten
+    first.sn_t = 110;
+    unsigned char remove[4];
+    hostLongToLe(0x63, remove);
+    CU_ASSERT_TRUE(rasta_replication_queue_connection(&primary, &first, &buffer));
+    CU_ASSERT_TRUE(rasta_replication_queue(&primary, RASTA_REPLICATION_REMOVE, remove, sizeof(remove)));
+    CU_ASSERT_TRUE(rasta_replication_queue_round(&primary, 300));
+    CU_ASSERT_TRUE(rasta_replication_flush(&primary));
+
+    CU_ASSERT_TRUE(pump(&standby, 400));
+    CU_ASSERT_EQUAL(standby.entry_count, 1);
+    CU_ASSERT_EQUAL(standby.rounds, 2);
+    CU_ASSERT_EQUAL(standby.timestamp_offset, (uint32_t) -100);
+    CU_ASSERT_PTR_NULL(rasta_replication_get(&standby, 0x63));
+    struct rasta_replica_entry * entry = rasta_replication_get(&standby, 0x62);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+    struct rasta_replica decoded;
+    CU_ASSERT_TRUE(rasta_replica_decode(&decoded, entry->data, entry->length));
+    CU_ASSERT_EQUAL(decoded.sn_t, 110);
+
+    // a RESET voids every record
+    CU_ASSERT_TRUE(rasta_replication_queue(&primary, RASTA_REPLICATION_RESET, NULL, 0));
+    CU_ASSERT_TRUE(rasta_replication_flush(&primary));
+    CU_ASSERT_TRUE(pump(&standby, 400));
+    CU_ASSERT_EQUAL(standby.entry_count, 0);
+
+    // a record that arrives in pieces is handled when it is complete
+    unsigned char round[RASTA_REPLICATION_HEADER_SIZE + 8];
+    hostLongToLe(RASTA_REPLICATION_MAGIC, round);
+    round[4] = RASTA_REPLICATION_VERSION;
+    round[5] = 0;
+    round[6] = RASTA_REPLICATION_ROUND;
+    round[7] = 0;
+    hostLongToLe(8, round + 8);
+    hostLongToLe(500, round + 12);
+    hostLongToLe(20, round + 16);
+    CU_ASSERT_EQUAL(send(primary.fd, round, 5, 0), 5);
+    CU_ASSERT_TRUE(pump(&standby, 400));
+    CU_ASSERT_EQUAL(standby.rounds, 2);
+    CU_ASSERT_EQUAL(send(primary.fd, round + 5, sizeof(round) - 5, 0), sizeof(round) - 5);
+    CU_ASSERT_TRUE(pump(&standby, 400));
+    CU_ASSERT_EQUAL(standby.rounds, 3);
+    CU_ASSERT_EQUAL(standby.timestamp_offset, 100);
+
+    // the standby notices the primary is gone
+    rasta_replication_close_stream(&primary);
+    CU_ASSERT_FALSE(pump(&standby, 400));
+
+    retrbuffer_destroy(&buffer);
+    rasta_replication_free(&primary);
+    rasta_replication_free(&standby);
+}
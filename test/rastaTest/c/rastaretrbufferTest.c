@@ -0,0 +1,138 @@
+#include <CUnit/Basic.h>
+#include "../headers/rastaretrbufferTest.h"
+#include "rastaretrbuffer.h"
+#include "rmemory.h"
+
+/**
+ * creates a data PDU with the given sequence number and an 8 byte safety code
+ * @param sequence_number the sequence number
+ * @return the PDU, the data has to be freed
+ */
+static struct RastaPacket create_packet(uint32_t sequence_number) {
+    struct RastaPacket packet;
+    packet.length = 38;
+    packet.type = RASTA_TYPE_DATA;
+    packet.sender_id = 12345;
+    packet.receiver_id = 54321;
+    packet.sequence_number = sequence_number;
+    packet.confirmed_sequence_number = 7531;
+    packet.timestamp = 2468;
+    packet.confirmed_timestamp = 8642;
+    allocateRastaByteArray(&packet.data, 2);
+    packet.data.bytes[0] = 0x11;
+    packet.data.bytes[1] = (unsigned char) sequence_number;
+
+    return packet;
+}
+
+/**
+ * adds a data PDU with the given sequence number to the buffer
+ * @param buffer the buffer that is used
+ * @param context the hashing parameters
+ * @param sequence_number the sequence number
+ * @return the stored element
+ */
+static struct rasta_retr_element * add_packet(struct retr_buffer * buffer, rasta_hashing_context_t * context,
+                                              uint32_t sequence_number) {
+    struct RastaPacket packet = create_packet(sequence_number);
+    struct rasta_retr_element * element = retrbuffer_add(buffer, &packet, context);
+    freeRastaByteArray(&packet.data);
+
+    return element;
+}
+
+void test_retrbuffer_add_confirm() {
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct retr_buffer buffer = retrbuffer_init(3);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 0);
+
+    // the PDU is stored encoded
+    struct RastaPacket packet = create_packet(1);
+    struct RastaByteArray expected = rastaModuleToBytes(packet, &context);
+    struct rasta_retr_element * element = retrbuffer_add(&buffer, &packet, &context);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(element);
+    CU_ASSERT_EQUAL(element->sequence_number, 1);
+    CU_ASSERT_EQUAL(element->length, expected.length);
+    CU_ASSERT_EQUAL(rmemcmp(element->pdu, expected.bytes, expected.length), 0);
+    freeRastaByteArray(&expected);
+    freeRastaByteArray(&packet.data);
+
+    CU_ASSERT_PTR_NOT_NULL(add_packet(&buffer, &context, 2));
+    CU_ASSERT_PTR_NOT_NULL(add_packet(&buffer, &context, 3));
+
+    // full
+    CU_ASSERT_PTR_NULL(add_packet(&buffer, &context, 4));
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 3);
+
+    CU_ASSERT_EQUAL(retrbuffer_confirm(&buffer, 2), 2);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 1);
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 0)->sequence_number, 3);
+    CU_ASSERT_PTR_NULL(retrbuffer_get(&buffer, 1));
+
+    // the new elements wrap around the end of the ring
+    CU_ASSERT_PTR_NOT_NULL(add_packet(&buffer, &context, 4));
+    CU_ASSERT_PTR_NOT_NULL(add_packet(&buffer, &context, 5));
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 0)->sequence_number, 3);
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 1)->sequence_number, 4);
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 2)->sequence_number, 5);
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 2)->pdu[29], 5);
+
+    // an old confirmation does not remove anything
+    CU_ASSERT_EQUAL(retrbuffer_confirm(&buffer, 1), 0);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 3);
+
+    // a confirmed sequence number that is not in the buffer, e.g. the one of a heartbeat
+    CU_ASSERT_EQUAL(retrbuffer_confirm(&buffer, 6), 3);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 0);
+
+    retrbuffer_destroy(&buffer);
+    CU_ASSERT_EQUAL(buffer.max_count, 0);
+    freeRastaByteArray(&context.key);
+}
+
+void test_retrbuffer_confirm_overflow() {
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct retr_buffer buffer = retrbuffer_init(4);
+    add_packet(&buffer, &context, 0xFFFFFFFE);
+    add_packet(&buffer, &context, 0xFFFFFFFF);
+    add_packet(&buffer, &context, 0);
+    add_packet(&buffer, &context, 1);
+
+    CU_ASSERT_EQUAL(retrbuffer_confirm(&buffer, 0xFFFFFFFD), 0);
+    CU_ASSERT_EQUAL(retrbuffer_confirm(&buffer, 0), 3);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 1);
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 0)->sequence_number, 1);
+
+    retrbuffer_destroy(&buffer);
+    freeRastaByteArray(&context.key);
+}
+
+void test_retrbuffer_clear() {
+    rasta_hashing_context_t context;
+    context.hash_length = RASTA_CHECKSUM_8B;
+    context.algorithm = RASTA_ALGO_MD4;
+    rasta_md4_set_key(&context, 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476);
+
+    struct retr_buffer buffer = retrbuffer_init(2);
+    add_packet(&buffer, &context, 1);
+    add_packet(&buffer, &context, 2);
+
+    retrbuffer_clear(&buffer);
+    CU_ASSERT_EQUAL(retrbuffer_size(&buffer), 0);
+    CU_ASSERT_PTR_NULL(retrbuffer_get(&buffer, 0));
+
+    // the slots can be used again
+    CU_ASSERT_PTR_NOT_NULL(add_packet(&buffer, &context, 3));
+    CU_ASSERT_EQUAL(retrbuffer_get(&buffer, 0)->sequence_number, 3);
+
+    retrbuffer_destroy(&buffer);
+    freeRastaByteArray(&context.key);
+}
@@ -0,0 +1,162 @@
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../headers/rastastatpageTest.h"
+#include "rastastatpage.h"
+
+/**
+ * @param path is set to a path for a stat page that does not exist yet
+ */
+static void stat_page_path(char path[64]) {
+    snprintf(path, 64, "/tmp/rasta_stat_test_%d", (int) getpid());
+    unlink(path);
+}
+
+/**
+ * publishes a connection with some traffic
+ * @param page the page
+ * @param pdus the received PDUs of the connection
+ */
+static void publish_connection(struct rasta_stat_page * page, unsigned long pdus) {
+    rasta_stat_page_begin(page);
+    struct rasta_stat_connection * connection = rasta_stat_page_connections(page->header);
+    memset(connection, 0, sizeof(*connection));
+    connection->state = RASTA_CONNECTION_UP;
+    connection->snapshot.remote_id = 0x62;
+    connection->snapshot.channel.pdus_in = pdus;
+    connection->snapshot.errors.sn = 2;
+    rasta_histogram_record(&connection->snapshot.metrics.round_trip_delay, 12);
+    page->header->connection_count = 1;
+
+    struct rasta_stat_channel * channel = rasta_stat_page_channels(page->header);
+    memset(channel, 0, sizeof(*channel));
+    channel->path.pdus_out = 2 * pdus;
+    page->header->channel_count = 1;
+    rasta_stat_page_end(page, 1700000000000000000ull);
+}
+
+void test_stat_page_publish() {
+    char path[64];
+    stat_page_path(path);
+
+    struct rasta_stat_page * writer = rasta_stat_page_create(path, 0x61, 4, 2, 500);
+    struct rasta_stat_page * reader = rasta_stat_page_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    CU_ASSERT_EQUAL(reader->mapped_size, sizeof(struct rasta_stat_header) + 4 * sizeof(struct rasta_stat_connection) +
+                                         2 * sizeof(struct rasta_stat_channel));
+
+    struct rasta_stat_header * copy = malloc(reader->mapped_size);
+    CU_ASSERT_TRUE(rasta_stat_page_copy(reader, copy));
+    CU_ASSERT_EQUAL(copy->local_id, 0x61);
+    CU_ASSERT_EQUAL(copy->pid, (uint32_t) getpid());
+    CU_ASSERT_EQUAL(copy->interval_ms, 500);
+    CU_ASSERT_EQUAL(copy->running, 1);
+    CU_ASSERT_EQUAL(copy->publications, 0);
+    CU_ASSERT_EQUAL(copy->connection_count, 0);
+
+    publish_connection(writer, 10);
+    publish_connection(writer, 11);
+    CU_ASSERT_TRUE(rasta_stat_page_copy(reader, copy));
+    CU_ASSERT_EQUAL(copy->publications, 2);
+    CU_ASSERT_EQUAL(copy->published_ns, 1700000000000000000ull);
+    CU_ASSERT_EQUAL(copy->sequence, 4);
+    CU_ASSERT_EQUAL(copy->connection_count, 1);
+    CU_ASSERT_EQUAL(rasta_stat_page_connections(copy)[0].state, RASTA_CONNECTION_UP);
+    CU_ASSERT_EQUAL(rasta_stat_page_connections(copy)[0].snapshot.remote_id, 0x62);
+    CU_ASSERT_EQUAL(rasta_stat_page_connections(copy)[0].snapshot.channel.pdus_in, 11);
+    CU_ASSERT_EQUAL(rasta_stat_page_channels(copy)[0].path.pdus_out, 22);
+
+    // the last publication stays readable
+    rasta_stat_page_close(writer);
+    CU_ASSERT_TRUE(rasta_stat_page_copy(reader, copy));
+    CU_ASSERT_EQUAL(copy->running, 0);
+    CU_ASSERT_EQUAL(rasta_stat_page_connections(copy)[0].snapshot.channel.pdus_in, 11);
+
+    free(copy);
+    rasta_stat_page_unmap(reader);
+    unlink(path);
+}
+
+void test_stat_page_seqlock() {
+    char path[64];
+    stat_page_path(path);
+
+    struct rasta_stat_page * writer = rasta_stat_page_create(path, 0x61, 1, 1, 1000);
+    struct rasta_stat_page * reader = rasta_stat_page_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    struct rasta_stat_header * copy = malloc(reader->mapped_size);
+
+    rasta_stat_page_begin(writer);
+    CU_ASSERT_EQUAL(reader->header->sequence, 1);
+    CU_ASSERT_FALSE(rasta_stat_page_copy(reader, copy));
+    rasta_stat_page_end(writer, 1);
+    CU_ASSERT_TRUE(rasta_stat_page_copy(reader, copy));
+    CU_ASSERT_EQUAL(copy->sequence, 2);
+
+    free(copy);
+    rasta_stat_page_unmap(reader);
+    rasta_stat_page_close(writer);
+    unlink(path);
+}
+
+void test_stat_page_replace() {
+    char path[64];
+    stat_page_path(path);
+
+    struct rasta_stat_page * writer = rasta_stat_page_create(path, 0x61, 2, 1, 1000);
+    publish_connection(writer, 5);
+    struct rasta_stat_page * old_reader = rasta_stat_page_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(old_reader);
+    rasta_stat_page_close(writer);
+
+    // a restarted entity with another size, the reader of the old page keeps its mapping
+    writer = rasta_stat_page_create(path, 0x61, 8, 1, 1000);
+    CU_ASSERT_EQUAL(old_reader->header->publications, 2);
+    CU_ASSERT_EQUAL(old_reader->header->connection_capacity, 2);
+
+    struct rasta_stat_page * reader = rasta_stat_page_open(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    CU_ASSERT_EQUAL(reader->header->publications, 0);
+    CU_ASSERT_EQUAL(reader->header->connection_capacity, 8);
+    CU_ASSERT_EQUAL(reader->header->running, 1);
+    rasta_stat_page_unmap(reader);
+    rasta_stat_page_unmap(old_reader);
+    rasta_stat_page_close(writer);
+
+    // not a stat page
+    FILE * f = fopen(path, "w");
+    fprintf(f, "RASTA_ID = 97\n");
+    fclose(f);
+    CU_ASSERT_PTR_NULL(rasta_stat_page_open(path));
+    unlink(path);
+    CU_ASSERT_PTR_NULL(rasta_stat_page_open(path));
+}
+
+void test_stat_page_prometheus() {
+    char path[64];
+    stat_page_path(path);
+
+    struct rasta_stat_page * writer = rasta_stat_page_create(path, 0x61, 2, 1, 1000);
+    publish_connection(writer, 7);
+
+    char * text = NULL;
+    size_t length = 0;
+    FILE * out = open_memstream(&text, &length);
+    rasta_stat_page_write_prometheus(writer->header, out);
+    fclose(out);
+
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_stat_page_running 1\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_stat_page_publications_total 1\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_connection_up{remote_id=\"0x62\",state=\"up\"} 1\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_connection_pdus_in_total{remote_id=\"0x62\"} 7\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_connection_errors_total{remote_id=\"0x62\",type=\"sn\"} 2\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_connection_round_trip_delay_ms_count{remote_id=\"0x62\"} 1\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_path_pdus_out_total{channel=\"0\"} 14\n"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(text, "rasta_event_loop_lag_us_count 0\n"));
+    free(text);
+
+    rasta_stat_page_close(writer);
+    unlink(path);
+}
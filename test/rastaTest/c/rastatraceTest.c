@@ -0,0 +1,82 @@
+#include <CUnit/Basic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../headers/rastatraceTest.h"
+#include "rastatrace.h"
+
+void test_rasta_trace_ring() {
+    char path[] = "/tmp/rasta_trace_test_XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+
+    struct rasta_trace * trace = rasta_trace_open(path, 4);
+    CU_ASSERT_EQUAL(trace->header->magic, RASTA_TRACE_MAGIC);
+    CU_ASSERT_EQUAL(trace->header->capacity, 4);
+
+    for (unsigned int i = 0; i < 6; i++) {
+        rasta_trace_add(trace, RASTA_TRACE_RED_RECEIVE, 0x61, i, i + 1, 1, 0);
+    }
+    CU_ASSERT_EQUAL(trace->header->next, 6);
+
+    // the first two records were overwritten
+    CU_ASSERT_EQUAL(trace->records[0].sequence_a, 4);
+    CU_ASSERT_EQUAL(trace->records[0].index, 5);
+    CU_ASSERT_EQUAL(trace->records[1].sequence_a, 5);
+    CU_ASSERT_EQUAL(trace->records[2].sequence_a, 2);
+    CU_ASSERT_EQUAL(trace->records[2].sequence_b, 3);
+    CU_ASSERT_EQUAL(trace->records[2].event, RASTA_TRACE_RED_RECEIVE);
+    CU_ASSERT_EQUAL(trace->records[2].connection_id, 0x61);
+    CU_ASSERT_EQUAL(trace->records[2].channel, 1);
+    CU_ASSERT(trace->records[2].timestamp > 0);
+
+    // nothing is recorded without a trace
+    struct rasta_trace * disabled = NULL;
+    rasta_trace_add(disabled, RASTA_TRACE_RED_RECEIVE, 0x61, 0, 0, 0, 0);
+
+    rasta_trace_close(trace);
+    unlink(path);
+}
+
+void test_rasta_trace_reopen() {
+    char path[] = "/tmp/rasta_trace_test_XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+
+    struct rasta_trace * trace = rasta_trace_open(path, 8);
+    rasta_trace_add(trace, RASTA_TRACE_SR_RECEIVE, 0x62, 10, 9, 0, 6220);
+    rasta_trace_close(trace);
+
+    trace = rasta_trace_open(path, 8);
+    CU_ASSERT_EQUAL(trace->header->next, 1);
+    CU_ASSERT_EQUAL(trace->records[0].sequence_a, 10);
+    rasta_trace_add(trace, RASTA_TRACE_SR_RECEIVE, 0x62, 11, 10, 0, 6220);
+    CU_ASSERT_EQUAL(trace->header->next, 2);
+    rasta_trace_close(trace);
+
+    trace = rasta_trace_open(path, 16);
+    CU_ASSERT_EQUAL(trace->header->next, 0);
+    CU_ASSERT_EQUAL(trace->records[0].index, 0);
+    rasta_trace_close(trace);
+
+    unlink(path);
+}
+
+void test_rasta_trace_render() {
+    struct rasta_trace_record record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = 1500000000123456789ull;
+    record.event = RASTA_TRACE_RED_DISCARD;
+    record.channel = 1;
+    record.connection_id = 0x61;
+    record.sequence_a = 3;
+    record.sequence_b = 5;
+    record.value = RASTA_TRACE_DISCARD_DUPLICATE;
+
+    char line[512];
+    rasta_trace_render(&record, line, sizeof(line));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "(Epoch time: 1500000000123)][TRACE][RaSTA Red receive]"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "channel 1: id=0x61, discarding seq_pdu=3, seq_rx=5: packet already received\n"));
+}
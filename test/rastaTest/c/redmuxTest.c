@@ -0,0 +1,1689 @@
+#include <CUnit/Basic.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include "../headers/redmuxTest.h"
+#include "rasta_red_multiplexer.h"
+#include "rmemory.h"
+#include "rastautil.h"
+#include "udp.h"
+#include "rasta_new.h"
+#include "event_system.h"
+#include "rastafactory.h"
+#include "rasta_lib.h"
+
+#define TEST_CHANNEL_COUNT 100
+
+/**
+ * creates a multiplexer without udp sockets, so channels can be added without network access
+ * @return the multiplexer
+ */
+static redundancy_mux create_test_mux() {
+    struct RastaConfigInfo config;
+    memset(&config, 0, sizeof(config));
+    config.redundancy.n_deferqueue_size = 4;
+    return redundancy_mux_init_(logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE), config);
+}
+
+void test_redundancy_mux_get_channel() {
+    redundancy_mux mux = create_test_mux();
+
+    // more channels than the initial capacity, so the storage and index have to grow
+    for (unsigned long id = 1; id <= TEST_CHANNEL_COUNT; id++) {
+        redundancy_mux_add_channel(&mux, id * 0x100, NULL);
+    }
+    CU_ASSERT_EQUAL(mux.channel_count, TEST_CHANNEL_COUNT);
+
+    for (unsigned long id = 1; id <= TEST_CHANNEL_COUNT; id++) {
+        rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, id * 0x100);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+        CU_ASSERT_EQUAL(channel->associated_id, id * 0x100);
+    }
+    CU_ASSERT_PTR_NULL(redundancy_mux_get_channel(&mux, 0x42));
+
+    redundancy_mux_close(&mux);
+}
+
+void test_redundancy_mux_remove_channel() {
+    redundancy_mux mux = create_test_mux();
+
+    for (unsigned long id = 1; id <= TEST_CHANNEL_COUNT; id++) {
+        redundancy_mux_add_channel(&mux, id, NULL);
+    }
+
+    // pointers to channels stay valid while other channels are removed
+    rasta_redundancy_channel * last = redundancy_mux_get_channel(&mux, TEST_CHANNEL_COUNT);
+
+    for (unsigned long id = 1; id <= TEST_CHANNEL_COUNT; id += 2) {
+        redundancy_mux_remove_channel(&mux, id);
+    }
+    CU_ASSERT_EQUAL(mux.channel_count, TEST_CHANNEL_COUNT / 2);
+
+    for (unsigned long id = 1; id <= TEST_CHANNEL_COUNT; id++) {
+        rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, id);
+        if (id % 2) {
+            CU_ASSERT_PTR_NULL(channel);
+        }
+        else {
+            CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+            CU_ASSERT_EQUAL(channel->associated_id, id);
+        }
+    }
+    CU_ASSERT_PTR_EQUAL(redundancy_mux_get_channel(&mux, TEST_CHANNEL_COUNT), last);
+
+    // the remaining channels keep their order
+    for (unsigned int i = 0; i < mux.channel_count; i++) {
+        CU_ASSERT_EQUAL(mux.connected_channels[i]->associated_id, 2 * (i + 1));
+    }
+
+    redundancy_mux_close(&mux);
+}
+
+/**
+ * creates a redundancy layer PDU that carries an SR layer PDU as it is returned by the decoder
+ * @param sequence_number the sequence number of the redundancy layer PDU
+ * @return the PDU
+ */
+static struct RastaRedundancyPacket create_test_packet(uint32_t sequence_number) {
+    struct RastaRedundancyPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.sequence_number = sequence_number;
+    packet.checksum_correct = 1;
+    packet.data.sequence_number = 100 + sequence_number;
+    packet.data.checksum_correct = (sequence_number != 1);
+    allocateRastaByteArray(&packet.data.data, 4);
+    allocateRastaByteArray(&packet.data.checksum, 8);
+    return packet;
+}
+
+void test_redundancy_channel_deliver_decoded() {
+    struct RastaConfigInfo config;
+    memset(&config, 0, sizeof(config));
+    config.redundancy.n_deferqueue_size = 4;
+
+    rasta_redundancy_channel channel = rasta_red_init(logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE), config, 1, 0x42);
+    memset(channel.connected_channels, 0, sizeof(rasta_transport_channel));
+    channel.connected_channel_count = 1;
+
+    struct RastaRedundancyPacket packets[3];
+    for (uint32_t i = 0; i < 3; i++) {
+        packets[i] = create_test_packet(i);
+    }
+
+    // the second PDU arrives last and is delivered together with the deferred third one
+    rasta_red_f_receive(&channel, &packets[0], 0);
+    rasta_red_f_receive(&channel, &packets[2], 0);
+    CU_ASSERT_EQUAL(fifo_get_size(channel.fifo_recv), 1);
+    rasta_red_f_receive(&channel, &packets[1], 0);
+    CU_ASSERT_EQUAL(fifo_get_size(channel.fifo_recv), 3);
+
+    // the decoded SR layer PDUs are passed on as they are, including the result of the checksum check
+    for (uint32_t i = 0; i < 3; i++) {
+        struct RastaPacket * delivered = fifo_pop(channel.fifo_recv);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(delivered);
+        CU_ASSERT_EQUAL(delivered->sequence_number, 100 + i);
+        CU_ASSERT_EQUAL(delivered->checksum_correct, i != 1);
+        CU_ASSERT_PTR_EQUAL(delivered->data.bytes, packets[i].data.data.bytes);
+
+        freeRastaByteArray(&delivered->data);
+        freeRastaByteArray(&delivered->checksum);
+        rfree(delivered);
+    }
+
+    rasta_red_cleanup(&channel);
+}
+
+void test_redundancy_channel_early_duplicate() {
+    struct RastaConfigInfo config;
+    memset(&config, 0, sizeof(config));
+    config.redundancy.n_deferqueue_size = 4;
+    config.redundancy.t_seq = 100;
+
+    rasta_redundancy_channel channel = rasta_red_init(logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE), config, 2, 0x42);
+    memset(channel.connected_channels, 0, 2 * sizeof(rasta_transport_channel));
+    channel.connected_channel_count = 2;
+
+    // nothing is a duplicate before the first PDU was received
+    CU_ASSERT_EQUAL(rasta_red_f_receive_duplicate(&channel, 0, 40, 1, 0), 0);
+
+    struct RastaRedundancyPacket packets[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        packets[i] = create_test_packet(i);
+    }
+    rasta_red_f_receive(&channel, &packets[0], 0);
+    rasta_red_f_receive(&channel, &packets[1], 0);
+    rasta_red_f_receive(&channel, &packets[3], 0);
+
+    // the copies of delivered and of deferred PDUs are known, the missing one is not
+    CU_ASSERT_EQUAL(rasta_red_f_receive_duplicate(&channel, 0, 40, 1, current_ts()), 1);
+    CU_ASSERT_EQUAL(rasta_red_f_receive_duplicate(&channel, 3, 40, 1, current_ts()), 1);
+    CU_ASSERT_EQUAL(rasta_red_f_receive_duplicate(&channel, 2, 40, 1, current_ts()), 0);
+    CU_ASSERT_EQUAL(rasta_red_f_receive_duplicate(&channel, 5, 40, 1, current_ts()), 0);
+
+    // only the missing PDU and the ones after the deferred one would be kept
+    CU_ASSERT_EQUAL(rasta_red_f_sequence_plausible(&channel, 1), 0);
+    CU_ASSERT_EQUAL(rasta_red_f_sequence_plausible(&channel, 2), 1);
+    CU_ASSERT_EQUAL(rasta_red_f_sequence_plausible(&channel, 3), 0);
+    CU_ASSERT_EQUAL(rasta_red_f_sequence_plausible(&channel, 4), 1);
+    CU_ASSERT_EQUAL(rasta_red_f_sequence_plausible(&channel, 3 + 4 * 10), 0);
+
+    // the copies are counted on the transport channel they arrived on
+    CU_ASSERT_EQUAL(channel.connected_channels[1].metrics.pdus_in, 2);
+    CU_ASSERT_EQUAL(channel.connected_channels[1].metrics.bytes_in, 80);
+    CU_ASSERT_EQUAL(channel.connected_channels[1].diagnostics_data.received_packets, 2);
+    CU_ASSERT_EQUAL(channel.connected_channels[1].diagnostics_data.n_missed, 0);
+
+    while (fifo_get_size(channel.fifo_recv) > 0) {
+        struct RastaPacket * delivered = fifo_pop(channel.fifo_recv);
+        freeRastaByteArray(&delivered->data);
+        freeRastaByteArray(&delivered->checksum);
+        rfree(delivered);
+    }
+    rasta_red_cleanup(&channel);
+}
+
+void test_redundancy_packet_peek() {
+    unsigned char bytes[20];
+    memset(bytes, 0, sizeof(bytes));
+    hostLongToLe(7, &bytes[4]);
+    hostLongToLe(0x61, &bytes[12]);
+    hostLongToLe(0x62, &bytes[16]);
+
+    uint32_t sequence_number, receiver_id, sender_id;
+    CU_ASSERT_EQUAL(rastaRedundancyPacketPeek(bytes, sizeof(bytes), &sequence_number, &receiver_id, &sender_id), 1);
+    CU_ASSERT_EQUAL(sequence_number, 7);
+    CU_ASSERT_EQUAL(receiver_id, 0x61);
+    CU_ASSERT_EQUAL(sender_id, 0x62);
+
+    // too short to carry the SR layer header
+    CU_ASSERT_EQUAL(rastaRedundancyPacketPeek(bytes, 19, &sequence_number, &receiver_id, &sender_id), 0);
+}
+
+static int diagnosed_count;
+static int diagnosed_missed[2];
+static unsigned long diagnosed_drift[2];
+static unsigned long diagnosed_id;
+
+static void record_diagnostic(redundancy_mux * mux, int n_diagnose, int n_missed, unsigned long t_drift,
+                              unsigned long t_drift2, unsigned long id) {
+    (void) mux;
+    (void) n_diagnose;
+    (void) t_drift2;
+    if (diagnosed_count < 2) {
+        diagnosed_missed[diagnosed_count] = n_missed;
+        diagnosed_drift[diagnosed_count] = t_drift;
+    }
+    diagnosed_id = id;
+    diagnosed_count++;
+}
+
+void test_redundancy_mux_diagnose() {
+    redundancy_mux mux = create_test_mux();
+    mux.notifications.on_diagnostics_available = record_diagnostic;
+    diagnosed_count = 0;
+
+    redundancy_mux_add_channel(&mux, 0x61, NULL);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, 0x61);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+
+    // the test mux has no ports, give the channel two transport channels
+    rfree(channel->connected_channels);
+    channel->connected_channels = rmalloc(2 * sizeof(rasta_transport_channel));
+    char ip[16] = "127.0.0.1";
+    rasta_red_add_transport_channel(channel, ip, 8888);
+    rasta_red_add_transport_channel(channel, ip, 8889);
+
+    // three PDUs arrived first on one of the channels, the second channel received two of them late
+    for (uint32_t i = 0; i < 3; i++) {
+        rasta_arrival_ring_put(&channel->diagnostics_arrivals, i, 1000 + i);
+    }
+    channel->connected_channels[0].diagnostics_data.received_packets = 3;
+    channel->connected_channels[1].diagnostics_data.received_packets = 2;
+    channel->connected_channels[1].diagnostics_data.n_missed = 1;
+    channel->connected_channels[1].diagnostics_data.t_drift = 20;
+
+    redundancy_mux_diagnose(&mux);
+
+    CU_ASSERT_EQUAL(diagnosed_count, 2);
+    CU_ASSERT_EQUAL(diagnosed_id, 0x61);
+    CU_ASSERT_EQUAL(diagnosed_missed[0], 0);
+    CU_ASSERT_EQUAL(diagnosed_missed[1], 2);
+    CU_ASSERT_EQUAL(diagnosed_drift[1], 20);
+
+    // the next window starts empty
+    for (unsigned int i = 0; i < 2; i++) {
+        CU_ASSERT_EQUAL(channel->connected_channels[i].diagnostics_data.received_packets, 0);
+        CU_ASSERT_EQUAL(channel->connected_channels[i].diagnostics_data.n_missed, 0);
+        CU_ASSERT_EQUAL(channel->connected_channels[i].diagnostics_data.t_drift, 0);
+    }
+    uint32_t received_at;
+    CU_ASSERT_EQUAL(channel->diagnostics_arrivals.count, 0);
+    CU_ASSERT_FALSE(rasta_arrival_ring_get(&channel->diagnostics_arrivals, 1, &received_at));
+
+    redundancy_mux_diagnose(&mux);
+    CU_ASSERT_EQUAL(diagnosed_count, 4);
+    CU_ASSERT_EQUAL(diagnosed_missed[0], 0);
+
+    redundancy_mux_close(&mux);
+}
+
+static int stop_defer_test(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+void test_redundancy_mux_defer_timeout() {
+    redundancy_mux mux = create_test_mux();
+    mux.config.redundancy.t_seq = 20;
+    redundancy_mux_add_channel(&mux, 0x62, NULL);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, 0x62);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    rfree(channel->connected_channels);
+    channel->connected_channels = rmalloc(sizeof(rasta_transport_channel));
+    char ip[16] = "127.0.0.1";
+    rasta_red_add_transport_channel(channel, ip, 8888);
+
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    redundancy_mux_start_defer_timers(&mux, &ev_sys, -1);
+
+    // the second PDU is lost, the third and fourth wait in the defer queue
+    struct RastaRedundancyPacket packets[3] = { create_test_packet(0), create_test_packet(2), create_test_packet(3) };
+    for (unsigned int i = 0; i < 3; i++) {
+        rasta_red_f_receive(channel, &packets[i], 0);
+    }
+    redundancy_mux_arm_defer_timer(&mux, channel);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 1);
+    CU_ASSERT(channel->defer_timeout_event.enabled);
+    CU_ASSERT(channel->defer_timeout_event.interval <= 20 * NS_PER_MS);
+
+    // the timer does not fire before T_SEQ is over
+    CU_ASSERT_EQUAL(channel_defer_timeout_event(channel), 0);
+    CU_ASSERT_EQUAL(channel->defer_timeouts, 0);
+    CU_ASSERT(channel->defer_timeout_event.enabled);
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_defer_test;
+    terminator.interval = 60 * NS_PER_MS;
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+    event_system_start(&ev_sys);
+    remove_timed_event(&ev_sys, &terminator);
+
+    // the gap is given up once and the deferred PDUs are delivered in order
+    CU_ASSERT_EQUAL(channel->defer_timeouts, 1);
+    CU_ASSERT_EQUAL(channel->seq_rx, 4);
+    CU_ASSERT_EQUAL(channel->defer_q.count, 0);
+    CU_ASSERT_FALSE(channel->defer_timeout_event.enabled);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 3);
+    for (uint32_t i = 0; i < 3; i++) {
+        struct RastaPacket * delivered = fifo_pop(channel->fifo_recv);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(delivered);
+        CU_ASSERT_EQUAL(delivered->sequence_number, 100 + (i == 0 ? 0 : i + 1));
+        freeRastaByteArray(&delivered->data);
+        freeRastaByteArray(&delivered->checksum);
+        rfree(delivered);
+    }
+
+    // removing the channel takes its timer out of the event system
+    redundancy_mux_remove_channel(&mux, 0x62);
+    CU_ASSERT_PTR_NULL(ev_sys.timed_events.first);
+
+    redundancy_mux_stop_defer_timers(&mux);
+    redundancy_mux_close(&mux);
+}
+
+/**
+ * sets the delays of the copies a transport channel received behind the first ones in the current diagnose window
+ */
+static void set_drift(rasta_transport_channel * transport_channel, unsigned long samples, unsigned long sum,
+                      unsigned long sum2) {
+    transport_channel->diagnostics_data.drift_samples = samples;
+    transport_channel->diagnostics_data.t_drift = sum;
+    transport_channel->diagnostics_data.t_drift2 = sum2;
+}
+
+void test_redundancy_adaptive_defer_timeout() {
+    redundancy_mux mux = create_test_mux();
+    mux.config.redundancy.t_seq = 50;
+    mux.config.redundancy.adaptive_t_seq = 3;
+    redundancy_mux_add_channel(&mux, 0x63, NULL);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, 0x63);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 50);
+
+    rfree(channel->connected_channels);
+    channel->connected_channels = rmalloc(2 * sizeof(rasta_transport_channel));
+    char ip[16] = "127.0.0.1";
+    rasta_red_add_transport_channel(channel, ip, 8888);
+    rasta_red_add_transport_channel(channel, ip, 8889);
+
+    // the copies on the second channel were always 4 ms behind, the next window waits for 4 ms and the rounding
+    set_drift(&channel->connected_channels[1], 20, 20 * 4, 20 * 16);
+    redundancy_mux_diagnose(&mux);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 5);
+    CU_ASSERT_EQUAL(channel->connected_channels[1].diagnostics_data.drift_samples, 0);
+
+    event_system ev_sys;
+    memset(&ev_sys, 0, sizeof(event_system));
+    redundancy_mux_start_defer_timers(&mux, &ev_sys, -1);
+    struct RastaRedundancyPacket packets[2] = { create_test_packet(0), create_test_packet(2) };
+    for (unsigned int i = 0; i < 2; i++) {
+        rasta_red_f_receive(channel, &packets[i], 0);
+    }
+    redundancy_mux_arm_defer_timer(&mux, channel);
+    CU_ASSERT(channel->defer_timeout_event.enabled);
+    CU_ASSERT(channel->defer_timeout_event.interval <= 5 * NS_PER_MS);
+
+    // half of the copies were 2 ms and half 6 ms behind on both channels: 4 ms + 3 * 2 ms + 1 ms
+    set_drift(&channel->connected_channels[0], 10, 10 * 2, 10 * 4);
+    set_drift(&channel->connected_channels[1], 10, 10 * 6, 10 * 36);
+    rasta_red_adapt_defer_timeout(channel);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 11);
+
+    // too few copies to tell the skew
+    set_drift(&channel->connected_channels[0], 0, 0, 0);
+    set_drift(&channel->connected_channels[1], RED_ADAPTIVE_MIN_SAMPLES - 1, 4 * (RED_ADAPTIVE_MIN_SAMPLES - 1),
+              16 * (RED_ADAPTIVE_MIN_SAMPLES - 1));
+    rasta_red_adapt_defer_timeout(channel);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 50);
+
+    // a skew larger than T_SEQ still waits T_SEQ only
+    set_drift(&channel->connected_channels[1], 20, 20 * 45, 20 * 45 * 45 + 20 * 100);
+    rasta_red_adapt_defer_timeout(channel);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 50);
+
+    // without the extension T_SEQ is always waited
+    channel->configuration_parameters.adaptive_t_seq = 0;
+    set_drift(&channel->connected_channels[1], 20, 20 * 4, 20 * 16);
+    rasta_red_adapt_defer_timeout(channel);
+    CU_ASSERT_EQUAL(channel->defer_timeout, 50);
+
+    redundancy_mux_remove_channel(&mux, 0x63);
+    redundancy_mux_stop_defer_timers(&mux);
+    redundancy_mux_close(&mux);
+}
+
+void test_transport_channel_endpoint() {
+    struct RastaConfigInfo config;
+    memset(&config, 0, sizeof(config));
+    config.redundancy.n_deferqueue_size = 4;
+
+    rasta_redundancy_channel channel = rasta_red_init(logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE), config, 3, 0x42);
+    char ip[16] = "192.168.100.200";
+    char other_ip[16] = "192.168.100.201";
+    rasta_red_add_transport_channel(&channel, ip, 8888);
+    rasta_red_add_transport_channel(&channel, ip, 8889);
+    rasta_red_add_transport_channel(&channel, other_ip, 8888);
+
+    struct sockaddr_in sender = host_port_to_sockaddr("192.168.100.200", 8889);
+    CU_ASSERT_EQUAL(channel.connected_channels[1].endpoint, sockaddr_to_endpoint(&sender));
+    CU_ASSERT_NOT_EQUAL(channel.connected_channels[0].endpoint, sockaddr_to_endpoint(&sender));
+    CU_ASSERT_NOT_EQUAL(channel.connected_channels[2].endpoint, channel.connected_channels[0].endpoint);
+
+    // the longest address is formatted completely
+    CU_ASSERT_STRING_EQUAL(channel.connected_channels[0].ip_address, "192.168.100.200");
+    CU_ASSERT_EQUAL(channel.connected_channels[0].port, 8888);
+
+    rasta_red_cleanup(&channel);
+}
+
+/**
+ * @return the current time of CLOCK_REALTIME in nanoseconds
+ */
+static uint64_t realtime_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+void test_udp_receive_timestamps() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    udp_init(&receiver, &tls_config);
+    udp_init(&sender, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    udp_bind_device(&sender, 0, "127.0.0.1");
+    udp_enable_receive_timestamps(&receiver);
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &address, &length);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, 4, 64);
+
+    unsigned char message[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint64_t before = realtime_ns();
+    udp_send_sockaddr(&sender, message, sizeof(message), address);
+    CU_ASSERT_EQUAL(udp_receive_batch(&receiver, &batch), 1);
+    uint64_t after = realtime_ns();
+
+    size_t received_length;
+    struct sockaddr_in from;
+    unsigned char * received = udp_receive_batch_get(&batch, 0, &received_length, &from);
+    CU_ASSERT_EQUAL(received_length, sizeof(message));
+    CU_ASSERT_EQUAL(memcmp(received, message, sizeof(message)), 0);
+
+    // the datagram is stamped by the kernel while it is in flight
+    uint64_t stamp = udp_receive_batch_get_timestamp(&batch, 0);
+    CU_ASSERT(stamp >= before);
+    CU_ASSERT(stamp <= after);
+
+    // without SO_TIMESTAMPNS the datagrams are not stamped
+    udp_send_sockaddr(&receiver, message, sizeof(message), from);
+    CU_ASSERT_EQUAL(udp_receive_batch(&sender, &batch), 1);
+    CU_ASSERT_EQUAL(udp_receive_batch_get_timestamp(&batch, 0), 0);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+void test_udp_kernel_drops() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    udp_init(&receiver, &tls_config);
+    udp_init(&sender, &tls_config);
+    udp_enable_drop_counter(&receiver);
+    udp_set_buffer_sizes(&receiver, 4096, 65536);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    udp_bind_device(&sender, 0, "127.0.0.1");
+
+    // the kernel reports the requested sizes doubled for its bookkeeping
+    struct RastaUDPBufferStats stats;
+    udp_buffer_stats(&receiver, &stats);
+    CU_ASSERT(stats.receive_buffer >= 4096);
+    CU_ASSERT(stats.receive_buffer < 65536);
+    CU_ASSERT(stats.send_buffer >= 65536);
+    CU_ASSERT_EQUAL(stats.kernel_drops, 0);
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &address, &length);
+
+    // far more than the receive buffer holds, the kernel drops the rest
+    unsigned char message[1000];
+    memset(message, 0x5A, sizeof(message));
+    for (unsigned int i = 0; i < 64; i++) {
+        udp_send_sockaddr(&sender, message, sizeof(message), address);
+    }
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, 64, sizeof(message));
+    unsigned int received = udp_receive_batch(&receiver, &batch);
+    CU_ASSERT(received > 0);
+    CU_ASSERT(received < 64);
+
+    // every datagram carries the counter of the time it was queued, the next one after the drops reports them
+    udp_send_sockaddr(&sender, message, sizeof(message), address);
+    CU_ASSERT_EQUAL(udp_receive_batch(&receiver, &batch), 1);
+    udp_buffer_stats(&receiver, &stats);
+    CU_ASSERT(stats.kernel_drops > 0);
+    CU_ASSERT_EQUAL(stats.kernel_drops, 64 - received);
+    CU_ASSERT_EQUAL(stats.kernel_drops, receiver.kernel_drops);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+void test_udp_transmit_queue() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    udp_init(&receiver, &tls_config);
+    udp_init(&sender, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    udp_bind_device(&sender, 0, "127.0.0.1");
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &address, &length);
+
+    // a writable socket takes the datagrams right away, nothing is queued
+    unsigned char message[500];
+    memset(message, 0, sizeof(message));
+    for (unsigned int i = 0; i < 40; i++) {
+        memcpy(message, &i, sizeof(i));
+        udp_send_sockaddr(&sender, message, sizeof(message), address);
+    }
+    CU_ASSERT_EQUAL(udp_transmit_pending(&sender), 0);
+    CU_ASSERT_EQUAL(udp_transmit_flush(&sender), 0);
+
+    struct RastaUDPTransmitStats stats;
+    udp_transmit_stats(&sender, &stats);
+    CU_ASSERT_EQUAL(stats.depth, 0);
+    CU_ASSERT_EQUAL(stats.queued, 0);
+    CU_ASSERT_EQUAL(stats.drops, 0);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, sizeof(message));
+    unsigned int next = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(&receiver), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        unsigned int count = udp_receive_batch(&receiver, &batch);
+        for (unsigned int i = 0; i < count; i++) {
+            size_t received_length;
+            struct sockaddr_in from;
+            unsigned char * received = udp_receive_batch_get(&batch, i, &received_length, &from);
+            unsigned int index;
+            memcpy(&index, received, sizeof(index));
+            CU_ASSERT_EQUAL(received_length, sizeof(message));
+            CU_ASSERT_EQUAL(index, next);
+            next++;
+        }
+    }
+    CU_ASSERT_EQUAL(next, 40);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+#define TEST_OFFLOAD_DATAGRAMS 24
+
+void test_udp_offload() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    udp_init(&receiver, &tls_config);
+    udp_init(&sender, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    udp_bind_device(&sender, 0, "127.0.0.1");
+    udp_enable_offload(&receiver);
+    udp_enable_offload(&sender);
+    CU_ASSERT_EQUAL(sender.gso, 1);
+    CU_ASSERT_EQUAL(receiver.gro, 1);
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &address, &length);
+    struct sockaddr_in sender_address;
+    length = sizeof(sender_address);
+    getsockname(sender.file_descriptor, (struct sockaddr *) &sender_address, &length);
+
+    // a burst of equal datagrams, a shorter one that ends the segmented message and a second burst
+    unsigned char datagrams[TEST_OFFLOAD_DATAGRAMS][100];
+    unsigned char * messages[TEST_OFFLOAD_DATAGRAMS];
+    size_t lengths[TEST_OFFLOAD_DATAGRAMS];
+    struct sockaddr_in receivers[TEST_OFFLOAD_DATAGRAMS];
+    for (unsigned int i = 0; i < TEST_OFFLOAD_DATAGRAMS; i++) {
+        memset(datagrams[i], (int) i, sizeof(datagrams[i]));
+        memcpy(datagrams[i], &i, sizeof(i));
+        messages[i] = datagrams[i];
+        lengths[i] = i == 20 ? 40 : sizeof(datagrams[i]);
+        receivers[i] = address;
+    }
+    udp_send_batch(&sender, messages, lengths, receivers, TEST_OFFLOAD_DATAGRAMS);
+    CU_ASSERT_EQUAL(udp_transmit_pending(&sender), 0);
+
+    // the coalesced datagrams are split, the segments that do not fit into the batch come with the next call
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, 8, sizeof(datagrams[0]));
+    unsigned int next = 0;
+    unsigned int receives = 0;
+    int split = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(&receiver), .events = POLLIN };
+    while (udp_receive_batch_pending(&batch) || poll(&readable, 1, 100) > 0) {
+        if (udp_receive_batch_pending(&batch)) {
+            split = 1;
+        } else {
+            receives++;
+        }
+        unsigned int count = udp_receive_batch(&receiver, &batch);
+        for (unsigned int i = 0; i < count; i++) {
+            size_t received_length;
+            struct sockaddr_in from;
+            unsigned char * received = udp_receive_batch_get(&batch, i, &received_length, &from);
+            unsigned int index;
+            memcpy(&index, received, sizeof(index));
+            CU_ASSERT_EQUAL(index, next);
+            CU_ASSERT_EQUAL(received_length, lengths[next]);
+            CU_ASSERT_EQUAL(received[received_length - 1], next);
+            CU_ASSERT_EQUAL(from.sin_port, sender_address.sin_port);
+            next++;
+        }
+    }
+    CU_ASSERT_EQUAL(next, TEST_OFFLOAD_DATAGRAMS);
+    CU_ASSERT(split);
+    CU_ASSERT(receives < TEST_OFFLOAD_DATAGRAMS / 8);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+void test_udp_reuseport_steering() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState shards[2], sender;
+    udp_init(&shards[0], &tls_config);
+    udp_enable_reuseport(&shards[0]);
+    udp_bind_device(&shards[0], 0, "127.0.0.1");
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(shards[0].file_descriptor, (struct sockaddr *) &address, &length);
+
+    // the second shard joins the group of the port
+    udp_init(&shards[1], &tls_config);
+    udp_enable_reuseport(&shards[1]);
+    udp_bind_device(&shards[1], ntohs(address.sin_port), "127.0.0.1");
+    udp_steer_reuseport(&shards[0], 2, 4);
+
+    udp_init(&sender, &tls_config);
+    udp_bind_device(&sender, 0, "127.0.0.1");
+
+    // the little endian id at offset 4 selects the shard
+    for (unsigned char id = 0; id < 10; id++) {
+        unsigned char message[8] = {0xFF, 0xFF, 0xFF, 0xFF, id, 0, 0, 1};
+        udp_send_sockaddr(&sender, message, sizeof(message), address);
+    }
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, 16, 64);
+    for (unsigned int shard = 0; shard < 2; shard++) {
+        unsigned int received = 0;
+        struct pollfd readable = { .fd = udp_receive_fd(&shards[shard]), .events = POLLIN };
+        while (poll(&readable, 1, 100) > 0) {
+            unsigned int count = udp_receive_batch(&shards[shard], &batch);
+            for (unsigned int i = 0; i < count; i++) {
+                size_t datagram_length;
+                struct sockaddr_in from;
+                unsigned char * datagram = udp_receive_batch_get(&batch, i, &datagram_length, &from);
+                // 0x01000000 + id is odd for the odd ids
+                CU_ASSERT_EQUAL(datagram[4] % 2, shard);
+                received++;
+            }
+        }
+        CU_ASSERT_EQUAL(received, 5);
+    }
+
+    udp_receive_batch_free(&batch);
+    udp_close(&shards[0]);
+    udp_close(&shards[1]);
+    udp_close(&sender);
+}
+
+/**
+ * creates a multiplexer with sockets on ephemeral ports of the loopback interface
+ * @param rasta_id the RaSTA ID of the entity
+ * @param connections the local transport channels, have to stay valid while the multiplexer is used
+ * @param count the amount of transport channels
+ * @return the multiplexer
+ */
+static redundancy_mux create_loopback_mux_paths(unsigned long rasta_id, struct RastaIPData * connections,
+                                                unsigned int count) {
+    struct RastaConfigInfo config;
+    memset(&config, 0, sizeof(config));
+    config.general.rasta_id = rasta_id;
+    config.redundancy.n_deferqueue_size = 4;
+    for (unsigned int i = 0; i < count; i++) {
+        strcpy(connections[i].ip, "127.0.0.1");
+        connections[i].port = 0;
+    }
+    config.redundancy.connections.data = connections;
+    config.redundancy.connections.count = count;
+    return redundancy_mux_init_(logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE), config);
+}
+
+/**
+ * creates a multiplexer with a socket on an ephemeral port of the loopback interface
+ * @param rasta_id the RaSTA ID of the entity
+ * @param connection the local transport channel, has to stay valid while the multiplexer is used
+ * @return the multiplexer
+ */
+static redundancy_mux create_loopback_mux(unsigned long rasta_id, struct RastaIPData * connection) {
+    return create_loopback_mux_paths(rasta_id, connection, 1);
+}
+
+/**
+ * @param state a bound udp socket
+ * @return its local port
+ */
+static uint16_t local_port(struct RastaUDPState * state) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(state->file_descriptor, (struct sockaddr *) &address, &length);
+    return ntohs(address.sin_port);
+}
+
+void test_redundancy_mux_shared_sockets() {
+    struct RastaIPData owner_connection, remote_connection;
+    redundancy_mux owner = create_loopback_mux(0x61, &owner_connection);
+    redundancy_mux remote = create_loopback_mux(0x70, &remote_connection);
+
+    struct RastaConfigInfo member_config = owner.config;
+    member_config.general.rasta_id = 0x62;
+    redundancy_mux member = redundancy_mux_init_member(owner.logger, member_config, &owner);
+    redundancy_mux_add_member(&owner, &member);
+    CU_ASSERT_PTR_EQUAL(member.udp_socket_states, owner.udp_socket_states);
+
+    struct sockaddr_in owner_address;
+    socklen_t length = sizeof(owner_address);
+    getsockname(owner.udp_socket_states[0].file_descriptor, (struct sockaddr *) &owner_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(owner_address.sin_port);
+    redundancy_mux_add_channel(&remote, 0x61, &destination);
+    redundancy_mux_add_channel(&remote, 0x62, &destination);
+
+    // both entities are reached on the same socket, the PDUs are received once and handed to their receiver. The
+    // heartbeats have neither payload nor safety code, so nothing has to be freed
+    rasta_hashing_context_t hashing_context;
+    memset(&hashing_context, 0, sizeof(hashing_context));
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    struct RastaPacket to_member = createHeartbeat(0x62, 0x70, 1, 0, 0, 0, &hashing_context);
+    struct RastaPacket to_owner = createHeartbeat(0x61, 0x70, 1, 0, 0, 0, &hashing_context);
+    redundancy_mux_send(&remote, to_member);
+    redundancy_mux_send(&remote, to_member);
+    redundancy_mux_send(&remote, to_owner);
+
+    struct pollfd readable = { .fd = udp_receive_fd(&owner.udp_socket_states[0]), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        receive_packet(&owner, 0);
+    }
+
+    rasta_redundancy_channel * member_channel = redundancy_mux_get_channel(&member, 0x70);
+    rasta_redundancy_channel * owner_channel = redundancy_mux_get_channel(&owner, 0x70);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(member_channel);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(owner_channel);
+    CU_ASSERT_EQUAL(fifo_get_size(member_channel->fifo_recv), 2);
+    CU_ASSERT_EQUAL(fifo_get_size(owner_channel->fifo_recv), 1);
+
+    // the stages of the receive path are counted by the owner of the sockets
+    CU_ASSERT_EQUAL(owner.receive_stages.pdus[RASTA_RECEIVE_STAGE_DRAIN], 3);
+    CU_ASSERT_EQUAL(owner.receive_stages.pdus[RASTA_RECEIVE_STAGE_CRC], 3);
+    CU_ASSERT_EQUAL(owner.receive_stages.pdus[RASTA_RECEIVE_STAGE_SEQUENCING], 3);
+    CU_ASSERT_EQUAL(owner.receive_stages.duration[RASTA_RECEIVE_STAGE_CRC].count,
+                    owner.receive_stages.batches[RASTA_RECEIVE_STAGE_CRC]);
+    CU_ASSERT_EQUAL(member.receive_stages.batches[RASTA_RECEIVE_STAGE_DRAIN], 0);
+
+    // a closed member is not handed PDUs anymore and leaves the sockets open, the PDU waits behind a gap of the owner
+    redundancy_mux_close(&member);
+    CU_ASSERT_EQUAL(owner.member_count, 0);
+    redundancy_mux_send(&remote, to_member);
+    CU_ASSERT_EQUAL(poll(&readable, 1, 100), 1);
+    receive_packet(&owner, 0);
+    CU_ASSERT_EQUAL(fifo_get_size(owner_channel->fifo_recv) + owner_channel->defer_q.count, 2);
+
+    redundancy_mux_close(&owner);
+    redundancy_mux_close(&remote);
+}
+
+/**
+ * sends heartbeats from a remote entity to the loopback socket of a multiplexer and receives them
+ * @param mux the receiving multiplexer
+ * @param remote the multiplexer of the remote entity, it has a channel to @p mux
+ * @param count the amount of heartbeats
+ */
+static void receive_heartbeats(redundancy_mux * mux, redundancy_mux * remote, unsigned int count) {
+    rasta_hashing_context_t hashing_context;
+    memset(&hashing_context, 0, sizeof(hashing_context));
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    struct RastaPacket heartbeat = createHeartbeat(mux->config.general.rasta_id, remote->config.general.rasta_id, 1, 0,
+                                                   0, 0, &hashing_context);
+    for (unsigned int i = 0; i < count; i++) {
+        redundancy_mux_send(remote, heartbeat);
+    }
+
+    struct pollfd readable = { .fd = udp_receive_fd(&mux->udp_socket_states[0]), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        receive_packet(mux, 0);
+    }
+}
+
+void test_redundancy_mux_pending_channels() {
+    struct RastaIPData connections[4];
+    redundancy_mux mux = create_loopback_mux(0x61, &connections[0]);
+    mux.config.redundancy.max_pending_channels = 2;
+    mux.config.redundancy.pending_pdu_limit = 2;
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(mux.udp_socket_states[0].file_descriptor, (struct sockaddr *) &address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(address.sin_port);
+
+    redundancy_mux remotes[3];
+    for (unsigned int i = 0; i < 3; i++) {
+        remotes[i] = create_loopback_mux(0x70 + i, &connections[i + 1]);
+        redundancy_mux_add_channel(&remotes[i], 0x61, &destination);
+    }
+
+    // an unknown sender only hands the first PDUs to the SR layer
+    receive_heartbeats(&mux, &remotes[0], 3);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&mux, 0x70);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    CU_ASSERT_EQUAL(channel->pending, 1);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 2);
+    CU_ASSERT_EQUAL(mux.pending_drops, 1);
+
+    // the least recently active pending channel makes room for a new one
+    receive_heartbeats(&mux, &remotes[1], 1);
+    CU_ASSERT_EQUAL(mux.pending_count, 2);
+    receive_heartbeats(&mux, &remotes[2], 1);
+    CU_ASSERT_EQUAL(mux.pending_count, 2);
+    CU_ASSERT_EQUAL(mux.pending_evictions, 1);
+    CU_ASSERT_PTR_NULL(redundancy_mux_get_channel(&mux, 0x70));
+    CU_ASSERT_PTR_NOT_NULL(redundancy_mux_get_channel(&mux, 0x72));
+
+    // an accepted channel is neither limited nor evicted
+    redundancy_mux_confirm_channel(&mux, 0x71);
+    CU_ASSERT_EQUAL(mux.pending_count, 1);
+    receive_heartbeats(&mux, &remotes[1], 3);
+    channel = redundancy_mux_get_channel(&mux, 0x71);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    CU_ASSERT_EQUAL(channel->pending, 0);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 4);
+    CU_ASSERT_EQUAL(mux.pending_drops, 1);
+
+    // removing a pending channel frees its slot
+    redundancy_mux_remove_channel(&mux, 0x72);
+    CU_ASSERT_EQUAL(mux.pending_count, 0);
+
+    for (unsigned int i = 0; i < 3; i++) {
+        redundancy_mux_close(&remotes[i]);
+    }
+    redundancy_mux_close(&mux);
+}
+
+void test_redundancy_mux_reconfigure() {
+    redundancy_mux mux = create_test_mux();
+    mux.config.redundancy.t_seq = 50;
+    mux.config.sending.send_max = 2;
+    redundancy_mux_add_channel(&mux, 0x61, NULL);
+    redundancy_mux_add_channel(&mux, 0x62, NULL);
+    rasta_redundancy_channel * idle = redundancy_mux_get_channel(&mux, 0x61);
+    rasta_redundancy_channel * busy = redundancy_mux_get_channel(&mux, 0x62);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(idle);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(busy);
+    rfree(busy->connected_channels);
+    busy->connected_channels = rmalloc(sizeof(rasta_transport_channel));
+    char ip[16] = "127.0.0.1";
+    rasta_red_add_transport_channel(busy, ip, 8888);
+
+    // three PDUs of the busy channel wait behind the lost second one
+    struct RastaRedundancyPacket packets[4] = {
+        create_test_packet(0), create_test_packet(2), create_test_packet(3), create_test_packet(4)
+    };
+    for (unsigned int i = 0; i < 4; i++) {
+        rasta_red_f_receive(busy, &packets[i], 0);
+    }
+    CU_ASSERT_EQUAL(busy->defer_q.count, 3);
+
+    // the busy channel can not shrink below its deferred PDUs, the idle one can
+    CU_ASSERT_EQUAL(redundancy_mux_reconfigure(&mux, 20, 2), 1);
+    CU_ASSERT_EQUAL(idle->defer_q.max_count, 2);
+    CU_ASSERT_EQUAL(busy->defer_q.max_count, 4);
+    CU_ASSERT_EQUAL(idle->configuration_parameters.t_seq, 20);
+    CU_ASSERT_EQUAL(busy->configuration_parameters.t_seq, 20);
+
+    // growing keeps the deferred PDUs
+    CU_ASSERT_EQUAL(redundancy_mux_reconfigure(&mux, 20, 8), 0);
+    CU_ASSERT_EQUAL(busy->defer_q.max_count, 8);
+    CU_ASSERT_EQUAL(busy->configuration_parameters.n_deferqueue_size, 8);
+    CU_ASSERT_EQUAL(fifo_get_capacity(busy->fifo_recv), 8);
+    CU_ASSERT_EQUAL(busy->defer_q.count, 3);
+    CU_ASSERT_EQUAL(deferqueue_contains(&busy->defer_q, 3), 1);
+
+    // the new channels use the new size
+    redundancy_mux_add_channel(&mux, 0x63, NULL);
+    CU_ASSERT_EQUAL(redundancy_mux_get_channel(&mux, 0x63)->defer_q.max_count, 8);
+
+    redundancy_mux_set_log_level(&mux, LOG_LEVEL_DEBUG);
+    CU_ASSERT_EQUAL(mux.logger.max_log_level, LOG_LEVEL_DEBUG);
+    CU_ASSERT_EQUAL(busy->logger.max_log_level, LOG_LEVEL_DEBUG);
+    redundancy_mux_set_log_level(&mux, LOG_LEVEL_NONE);
+
+    redundancy_mux_close(&mux);
+}
+
+void test_heartbeat_batch() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    struct RastaUDPState receiver;
+    udp_init(&receiver, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    struct sockaddr_in receiver_address;
+    socklen_t length = sizeof(receiver_address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &receiver_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(receiver_address.sin_port);
+
+    struct RastaIPData sender_connection;
+    redundancy_mux mux = create_loopback_mux(0x70, &sender_connection);
+
+    static struct rasta_connection connections[4];
+    static struct rasta_handle handle;
+    static struct rasta_heartbeat_handle heartbeat_handle;
+    memset(connections, 0, sizeof(connections));
+    memset(&handle, 0, sizeof(handle));
+    memset(&heartbeat_handle, 0, sizeof(heartbeat_handle));
+    heartbeat_handle.config.t_h = 300;
+    heartbeat_handle.config.heartbeat_tick_ms = 20;
+    heartbeat_handle.mux = &mux;
+    heartbeat_handle.handle = &handle;
+    heartbeat_handle.logger = &mux.logger;
+    handle.first_con = &connections[0];
+
+    // the first heartbeat fires, the second is due within the tick, the third after it and the fourth connection is
+    // closed
+    evtime_t now = event_system_now();
+    evtime_t interval = heartbeat_handle.config.t_h * NS_PER_MS;
+    evtime_t due[4] = { now, now + 5 * NS_PER_MS, now + 200 * NS_PER_MS, now };
+    for (unsigned int i = 0; i < 4; i++) {
+        connections[i].remote_id = 0x61 + i;
+        connections[i].my_id = 0x70;
+        connections[i].sn_t = 10;
+        connections[i].current_state = i == 3 ? RASTA_CONNECTION_CLOSED : RASTA_CONNECTION_UP;
+        connections[i].send_heartbeat_event.enabled = 1;
+        connections[i].send_heartbeat_event.interval = interval;
+        connections[i].send_heartbeat_event.last_call = due[i] - interval;
+        connections[i].linkedlist_next = i < 3 ? &connections[i + 1] : NULL;
+        redundancy_mux_add_channel(&mux, connections[i].remote_id, &destination);
+    }
+
+    struct timed_event_data data = { .handle = &heartbeat_handle, .connection = &connections[0] };
+    CU_ASSERT_EQUAL(heartbeat_send_event(&data), 0);
+    CU_ASSERT_EQUAL(connections[0].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[1].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[2].sn_t, 10);
+    CU_ASSERT_EQUAL(connections[3].sn_t, 10);
+
+    // the heartbeat that was sent early is due a whole interval later, the others keep their schedule
+    CU_ASSERT(connections[1].send_heartbeat_event.last_call >= now);
+    CU_ASSERT_EQUAL(connections[2].send_heartbeat_event.last_call, due[2] - interval);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 1024);
+    unsigned int received = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(&receiver), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        received += udp_receive_batch(&receiver, &batch);
+    }
+    CU_ASSERT_EQUAL(received, 2);
+
+    udp_receive_batch_free(&batch);
+    rfree(heartbeat_handle.batch);
+    rfree(heartbeat_handle.batch_connections);
+    redundancy_mux_close(&mux);
+    udp_close(&receiver);
+}
+
+/**
+ * @param socket a bound udp socket
+ * @return the amount of datagrams that arrive on it
+ */
+static unsigned int count_datagrams(struct RastaUDPState * socket) {
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 1024);
+    unsigned int received = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(socket), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        received += udp_receive_batch(socket, &batch);
+    }
+    udp_receive_batch_free(&batch);
+    return received;
+}
+
+void test_send_budget() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    struct RastaUDPState receiver;
+    udp_init(&receiver, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    struct sockaddr_in receiver_address;
+    socklen_t length = sizeof(receiver_address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &receiver_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(receiver_address.sin_port);
+
+    struct RastaIPData sender_connection;
+    redundancy_mux mux = create_loopback_mux(0x70, &sender_connection);
+
+    static struct rasta_connection connections[3];
+    static struct rasta_handle handle;
+    static struct rasta_sending_handle send_handle;
+    memset(connections, 0, sizeof(connections));
+    memset(&handle, 0, sizeof(handle));
+    memset(&send_handle, 0, sizeof(send_handle));
+    handle.logger = logger_init(LOG_LEVEL_NONE, LOGGER_TYPE_CONSOLE);
+    handle.send_notify_fd = -1;
+    handle.config.values.sending.max_packet = 1;
+    handle.first_con = &connections[0];
+    rasta_id_index_init(&handle.connection_index);
+    send_handle.config.max_packet = 1;
+    send_handle.config.send_budget = 2;
+    send_handle.logger = &mux.logger;
+    send_handle.mux = &mux;
+    send_handle.handle = &handle;
+    send_handle.hashing_context = &mux.sr_hashing_context;
+
+    // every connection has two data packets of messages queued
+    struct RastaByteArray message = { .bytes = (unsigned char *) "m", .length = 1 };
+    struct RastaMessageData messages = { .count = 1, .data_array = &message };
+    for (unsigned int i = 0; i < 3; i++) {
+        connections[i].remote_id = 0x61 + i;
+        connections[i].my_id = 0x70;
+        connections[i].sn_t = 10;
+        connections[i].current_state = RASTA_CONNECTION_UP;
+        connections[i].fifo_send = fifo_init(4);
+        connections[i].fifo_send_urgent = fifo_init(2);
+        connections[i].retr_buffer = retrbuffer_init(4);
+        connections[i].linkedlist_next = i < 2 ? &connections[i + 1] : NULL;
+        rasta_id_index_put(&handle.connection_index, connections[i].remote_id, &connections[i]);
+        redundancy_mux_add_channel(&mux, connections[i].remote_id, &destination);
+        CU_ASSERT_EQUAL(sr_send_connection(&handle, &connections[i], messages), 1);
+        CU_ASSERT_EQUAL(sr_send_connection(&handle, &connections[i], messages), 1);
+    }
+
+    // the budget covers two connections, the third one waits for the next turn
+    CU_ASSERT_EQUAL(data_send_event(&send_handle), 0);
+    CU_ASSERT_EQUAL(connections[0].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[1].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[2].sn_t, 10);
+    CU_ASSERT_NOT_EQUAL(connections[2].send_ready_since_ns, 0);
+
+    // the next turn starts with the connection that was left over
+    CU_ASSERT_EQUAL(data_send_event(&send_handle), 0);
+    CU_ASSERT_EQUAL(connections[0].sn_t, 12);
+    CU_ASSERT_EQUAL(connections[1].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[2].sn_t, 11);
+    CU_ASSERT_EQUAL(connections[2].send_ready_since_ns, 0);
+    CU_ASSERT_NOT_EQUAL(connections[1].send_ready_since_ns, 0);
+
+    // without a budget every connection that has messages sends
+    send_handle.config.send_budget = 0;
+    CU_ASSERT_EQUAL(data_send_event(&send_handle), 0);
+    for (unsigned int i = 0; i < 3; i++) {
+        CU_ASSERT_EQUAL(connections[i].sn_t, 12);
+        CU_ASSERT_EQUAL(connections[i].send_ready_since_ns, 0);
+        CU_ASSERT_EQUAL(connections[i].metrics.send_schedule_us.count, 2);
+    }
+    CU_ASSERT_EQUAL(count_datagrams(&receiver), 6);
+
+    for (unsigned int i = 0; i < 3; i++) {
+        fifo_destroy(connections[i].fifo_send);
+        fifo_destroy(connections[i].fifo_send_urgent);
+        retrbuffer_destroy(&connections[i].retr_buffer);
+    }
+    rasta_id_index_free(&handle.connection_index);
+    logger_destroy(&handle.logger);
+    redundancy_mux_close(&mux);
+    udp_close(&receiver);
+}
+
+/**
+ * lets a connection receive a data packet and confirms it
+ * @param h the receive handle
+ * @param connection the connection
+ * @param sequence_number the sequence number of the data packet
+ * @param count the amount of messages in the data packet
+ */
+static void receive_data_packet(struct rasta_receive_handle * h, struct rasta_connection * connection,
+                                uint32_t sequence_number, unsigned int count) {
+    struct RastaByteArray messages[2] = { { .bytes = (unsigned char *) "a", .length = 1 },
+                                          { .bytes = (unsigned char *) "b", .length = 1 } };
+    struct RastaMessageData data = { .count = count, .data_array = messages };
+    struct RastaPacket packet = createDataMessage(connection->my_id, connection->remote_id, sequence_number, 0, 0, 0,
+                                                  data, &h->mux->sr_hashing_context);
+    sr_add_app_messages_to_buffer(h, connection, packet);
+    sr_confirm_received(h, connection, sequence_number);
+    freeRastaByteArray(&packet.data);
+}
+
+void test_receive_backpressure() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    struct RastaUDPState receiver;
+    udp_init(&receiver, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    struct sockaddr_in receiver_address;
+    socklen_t length = sizeof(receiver_address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &receiver_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(receiver_address.sin_port);
+
+    struct RastaIPData sender_connection;
+    redundancy_mux mux = create_loopback_mux(0x70, &sender_connection);
+
+    static struct rasta_connection connection;
+    static struct rasta_handle handle;
+    static struct rasta_receive_handle receive_handle;
+    memset(&connection, 0, sizeof(connection));
+    memset(&handle, 0, sizeof(handle));
+    memset(&receive_handle, 0, sizeof(receive_handle));
+    handle.receive_notify_fd = -1;
+    receive_handle.config.send_max = 2;
+    receive_handle.config.max_packet = 2;
+    receive_handle.config.diag_window = 1000;
+    receive_handle.config.receive_backpressure = 1;
+    receive_handle.handle = &handle;
+    receive_handle.mux = &mux;
+    receive_handle.logger = &mux.logger;
+
+    // the receive queue holds a send window and keeps room for the messages of another one
+    CU_ASSERT_EQUAL(sr_receive_reserve(receive_handle.config), 4);
+    connection.remote_id = 0x61;
+    connection.my_id = 0x70;
+    connection.sn_t = 10;
+    connection.cs_t = 4;
+    connection.current_state = RASTA_CONNECTION_UP;
+    connection.fifo_app_msg = fifo_init(2 + sr_receive_reserve(receive_handle.config));
+    redundancy_mux_add_channel(&mux, connection.remote_id, &destination);
+
+    // the first data packet leaves room for a send window, the next ones are not confirmed
+    receive_data_packet(&receive_handle, &connection, 5, 2);
+    CU_ASSERT_EQUAL(connection.cs_t, 5);
+    CU_ASSERT_FALSE(connection.receive_held);
+    receive_data_packet(&receive_handle, &connection, 6, 2);
+    receive_data_packet(&receive_handle, &connection, 7, 2);
+    CU_ASSERT_EQUAL(connection.cs_t, 5);
+    CU_ASSERT_TRUE(connection.receive_held);
+    CU_ASSERT_EQUAL(connection.metrics.receive_holds, 1);
+    CU_ASSERT_EQUAL(receive_handle.receive_held_count, 1);
+
+    // a partner that does not respect its send window loses the messages that do not fit, they are not leaked
+    receive_data_packet(&receive_handle, &connection, 8, 1);
+    CU_ASSERT_EQUAL(fifo_get_size(connection.fifo_app_msg), 6);
+    CU_ASSERT_EQUAL(connection.metrics.receive_overflows, 1);
+
+    // the confirmation waits until there is room for a send window again
+    rastaApplicationMessage messages[2];
+    CU_ASSERT_EQUAL(sr_get_received_data_bulk(&handle, &connection, messages, 2), 2);
+    sr_free_received_data_bulk(messages, 2);
+    CU_ASSERT_EQUAL(sr_release_received(&receive_handle, &connection), 1);
+    CU_ASSERT_EQUAL(connection.cs_t, 5);
+    CU_ASSERT_EQUAL(sr_get_received_data_bulk(&handle, &connection, messages, 2), 2);
+    sr_free_received_data_bulk(messages, 2);
+    CU_ASSERT_EQUAL(sr_release_received(&receive_handle, &connection), 0);
+    CU_ASSERT_EQUAL(connection.cs_t, 8);
+    CU_ASSERT_FALSE(connection.receive_held);
+
+    // the confirmation is sent right away with a heartbeat
+    CU_ASSERT_EQUAL(connection.sn_t, 11);
+    CU_ASSERT_EQUAL(count_datagrams(&receiver), 1);
+
+    // without backpressure every received data packet is confirmed
+    receive_handle.config.receive_backpressure = 0;
+    receive_data_packet(&receive_handle, &connection, 9, 2);
+    receive_data_packet(&receive_handle, &connection, 10, 2);
+    CU_ASSERT_EQUAL(connection.cs_t, 10);
+    CU_ASSERT_FALSE(connection.receive_held);
+
+    unsigned int count;
+    while ((count = sr_get_received_data_bulk(&handle, &connection, messages, 2)) > 0) {
+        sr_free_received_data_bulk(messages, count);
+    }
+    fifo_destroy(connection.fifo_app_msg);
+    redundancy_mux_close(&mux);
+    udp_close(&receiver);
+}
+
+void test_heartbeat_paced_retransmission() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    struct RastaUDPState receiver;
+    udp_init(&receiver, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    struct sockaddr_in receiver_address;
+    socklen_t length = sizeof(receiver_address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &receiver_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(receiver_address.sin_port);
+
+    struct RastaIPData sender_connection;
+    redundancy_mux mux = create_loopback_mux(0x70, &sender_connection);
+
+    static struct rasta_connection connection;
+    static struct rasta_handle handle;
+    static struct rasta_heartbeat_handle heartbeat_handle;
+    static struct rasta_receive_handle receive_handle;
+    memset(&connection, 0, sizeof(connection));
+    memset(&handle, 0, sizeof(handle));
+    memset(&heartbeat_handle, 0, sizeof(heartbeat_handle));
+    memset(&receive_handle, 0, sizeof(receive_handle));
+    handle.first_con = &connection;
+    handle.send_notify_fd = -1;
+    handle.receive_handle = &receive_handle;
+    heartbeat_handle.config.t_h = 300;
+    heartbeat_handle.mux = &mux;
+    heartbeat_handle.handle = &handle;
+    heartbeat_handle.logger = &mux.logger;
+    receive_handle.config.retransmit_rate = 1;
+    receive_handle.mux = &mux;
+    receive_handle.handle = &handle;
+    receive_handle.logger = &mux.logger;
+    receive_handle.hashing_context = &mux.sr_hashing_context;
+
+    // three data packets wait for the credit of the handle, which does not have any
+    connection.remote_id = 0x61;
+    connection.my_id = 0x70;
+    connection.current_state = RASTA_CONNECTION_UP;
+    connection.retr_buffer = retrbuffer_init(3);
+    for (uint32_t i = 0; i < 3; i++) {
+        struct RastaPacket packet = createHeartbeat(0x61, 0x70, 20 + i, 0, 0, 0, &mux.sr_hashing_context);
+        retrbuffer_add(&connection.retr_buffer, &packet, &mux.sr_hashing_context);
+    }
+    connection.sn_t = 23;
+    connection.retransmit_sn = 20;
+    connection.retransmitting = 1;
+    redundancy_mux_add_channel(&mux, connection.remote_id, &destination);
+
+    // every due heartbeat sends one retransmitted packet instead, the last one is followed by the closing heartbeat
+    struct timed_event_data data = { .handle = &heartbeat_handle, .connection = &connection };
+    unsigned int expected[3] = { 1, 1, 2 };
+    for (unsigned int i = 0; i < 3; i++) {
+        CU_ASSERT_EQUAL(heartbeat_send_event(&data), 0);
+        CU_ASSERT_EQUAL(connection.retransmit_sn, 21 + i);
+        CU_ASSERT_EQUAL(connection.retransmitting, i < 2);
+        CU_ASSERT_EQUAL(count_datagrams(&receiver), expected[i]);
+    }
+    CU_ASSERT_EQUAL(connection.sn_t, 24);
+
+    retrbuffer_destroy(&connection.retr_buffer);
+    redundancy_mux_close(&mux);
+    udp_close(&receiver);
+}
+
+static int disconnected_count;
+static int closed_notifications;
+
+static void count_disconnect(rasta_lib_connection_t connection, void * memory) {
+    (void) connection;
+    (void) memory;
+    disconnected_count++;
+}
+
+static void count_closed(struct rasta_notification_result * result) {
+    if (result->con->current_state == RASTA_CONNECTION_CLOSED) {
+        closed_notifications++;
+    }
+}
+
+void test_disconnect_all() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    struct RastaUDPState receiver;
+    udp_init(&receiver, &tls_config);
+    udp_bind_device(&receiver, 0, "127.0.0.1");
+    struct sockaddr_in receiver_address;
+    socklen_t length = sizeof(receiver_address);
+    getsockname(receiver.file_descriptor, (struct sockaddr *) &receiver_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(receiver_address.sin_port);
+
+    static struct rasta_connection connections[4];
+    static struct rasta_handle handle;
+    static struct rasta_heartbeat_handle heartbeat_handle;
+    static event_system ev_sys;
+    static struct user_callbacks user_handles;
+    memset(connections, 0, sizeof(connections));
+    memset(&handle, 0, sizeof(handle));
+    memset(&heartbeat_handle, 0, sizeof(heartbeat_handle));
+    memset(&ev_sys, 0, sizeof(ev_sys));
+    memset(&user_handles, 0, sizeof(user_handles));
+    user_handles.on_disconnect = count_disconnect;
+
+    struct RastaIPData sender_connection;
+    handle.mux = create_loopback_mux(0x70, &sender_connection);
+    handle.logger = handle.mux.logger;
+    handle.ev_sys = &ev_sys;
+    handle.heartbeat_handle = &heartbeat_handle;
+    handle.user_handles = &user_handles;
+    handle.notifications.on_connection_state_change = count_closed;
+    handle.first_con = &connections[0];
+    handle.last_con = &connections[3];
+
+    // the fourth connection is closed already and does not get a disconnection request
+    for (unsigned int i = 0; i < 4; i++) {
+        connections[i].remote_id = 0x61 + i;
+        connections[i].my_id = 0x70;
+        connections[i].current_state = i == 3 ? RASTA_CONNECTION_CLOSED : RASTA_CONNECTION_UP;
+        connections[i].linkedlist_prev = i > 0 ? &connections[i - 1] : NULL;
+        connections[i].linkedlist_next = i < 3 ? &connections[i + 1] : NULL;
+        redundancy_mux_add_channel(&handle.mux, connections[i].remote_id, &destination);
+    }
+
+    disconnected_count = 0;
+    closed_notifications = 0;
+    sr_disconnect_all(&handle);
+    CU_ASSERT_PTR_NULL(handle.first_con);
+    CU_ASSERT_EQUAL(disconnected_count, 4);
+    CU_ASSERT_EQUAL(closed_notifications, 3);
+    for (unsigned int i = 0; i < 4; i++) {
+        CU_ASSERT_EQUAL(connections[i].current_state, RASTA_CONNECTION_CLOSED);
+    }
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 1024);
+    unsigned int received = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(&receiver), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        received += udp_receive_batch(&receiver, &batch);
+    }
+    CU_ASSERT_EQUAL(received, 3);
+
+    udp_receive_batch_free(&batch);
+    rfree(heartbeat_handle.batch);
+    rfree(heartbeat_handle.batch_connections);
+    redundancy_mux_close(&handle.mux);
+    udp_close(&receiver);
+}
+
+static unsigned int started_connections;
+static unsigned int bulk_complete_notifications;
+static struct rasta_bulk_connect_status bulk_complete_status;
+
+static void * refuse_connection(rasta_lib_connection_t connection) {
+    (void) connection;
+    started_connections++;
+    return NULL;
+}
+
+static void record_bulk_complete(struct rasta_notification_result * result,
+                                 const struct rasta_bulk_connect_status * status) {
+    CU_ASSERT_PTR_NULL(result->con);
+    bulk_complete_notifications++;
+    bulk_complete_status = *status;
+}
+
+static int stop_bulk_connect_test(void * carry_data) {
+    (void) carry_data;
+    return 1;
+}
+
+void test_bulk_connect() {
+    static struct rasta_handle handle;
+    static struct rasta_connection existing;
+    static event_system ev_sys;
+    static struct user_callbacks user_handles;
+    memset(&handle, 0, sizeof(handle));
+    memset(&existing, 0, sizeof(existing));
+    memset(&ev_sys, 0, sizeof(ev_sys));
+    memset(&user_handles, 0, sizeof(user_handles));
+    user_handles.on_connection_start = refuse_connection;
+
+    struct RastaIPData sender_connection;
+    handle.mux = create_loopback_mux(0x70, &sender_connection);
+    handle.logger = handle.mux.logger;
+    handle.hashing_context = handle.mux.sr_hashing_context;
+    handle.ev_sys = &ev_sys;
+    handle.user_handles = &user_handles;
+    handle.notifications.on_bulk_connect_complete = record_bulk_complete;
+    handle.config.values.general.rasta_id = 0x70;
+    handle.config.values.sending.t_max = 1800;
+    handle.config.values.sending.send_max = 20;
+    handle.config.values.sending.max_packet = 3;
+    handle.config.values.sending.connect_wave_size = 2;
+    handle.config.values.sending.connect_wave_interval_ms = 5;
+    handle.config.values.sending.connect_max_in_flight = 0;
+    rasta_connection_pool_init(&handle.connection_pool, handle.config.values.sending, 0, 0);
+    rasta_id_index_init(&handle.connection_index);
+
+    // the last peer is connected already, the user refuses the connections to the others
+    existing.remote_id = 0x65;
+    existing.current_state = RASTA_CONNECTION_UP;
+    rasta_id_index_put(&handle.connection_index, existing.remote_id, &existing);
+
+    struct RastaIPData channels[5];
+    struct rasta_bulk_peer peers[5];
+    for (unsigned int i = 0; i < 5; i++) {
+        strcpy(channels[i].ip, "127.0.0.1");
+        channels[i].port = 9000 + (int) i;
+        peers[i].id = 0x61 + i;
+        peers[i].channels = &channels[i];
+    }
+
+    started_connections = 0;
+    bulk_complete_notifications = 0;
+    struct rasta_bulk_connect_status status;
+    CU_ASSERT_EQUAL(sr_get_bulk_connect_status(&handle, &status), 0);
+    CU_ASSERT_EQUAL(sr_connect_bulk(&handle, peers, 0), 0);
+    CU_ASSERT_EQUAL(sr_connect_bulk(&handle, peers, 5), 1);
+
+    // the first wave is sent right away, it fails without waiting for the next one
+    CU_ASSERT_EQUAL(sr_get_bulk_connect_status(&handle, &status), 1);
+    CU_ASSERT_EQUAL(status.total, 5);
+    CU_ASSERT_EQUAL(status.waves, 1);
+    CU_ASSERT_EQUAL(status.issued, 2);
+    CU_ASSERT_EQUAL(status.failed, 2);
+    CU_ASSERT_EQUAL(status.in_flight, 0);
+    CU_ASSERT_FALSE(status.complete);
+    CU_ASSERT_EQUAL(started_connections, 2);
+
+    // a bulk connect that is not complete is not replaced
+    CU_ASSERT_EQUAL(sr_connect_bulk(&handle, peers, 5), 0);
+
+    timed_event terminator;
+    memset(&terminator, 0, sizeof(timed_event));
+    terminator.callback = stop_bulk_connect_test;
+    terminator.interval = 40 * NS_PER_MS;
+    enable_timed_event(&terminator);
+    add_timed_event(&ev_sys, &terminator);
+    event_system_start(&ev_sys);
+    remove_timed_event(&ev_sys, &terminator);
+
+    CU_ASSERT_EQUAL(bulk_complete_notifications, 1);
+    CU_ASSERT(bulk_complete_status.complete);
+    CU_ASSERT_EQUAL(bulk_complete_status.waves, 3);
+    CU_ASSERT_EQUAL(bulk_complete_status.issued, 5);
+    CU_ASSERT_EQUAL(bulk_complete_status.connected, 1);
+    CU_ASSERT_EQUAL(bulk_complete_status.failed, 4);
+    CU_ASSERT_EQUAL(bulk_complete_status.in_flight, 0);
+    CU_ASSERT(bulk_complete_status.complete_ns >= 10 * NS_PER_MS);
+    CU_ASSERT_EQUAL(started_connections, 4);
+    CU_ASSERT_FALSE(handle.bulk_connect->wave_event.enabled);
+
+    remove_timed_event(&ev_sys, &handle.bulk_connect->wave_event);
+    rfree(handle.bulk_connect->ids);
+    rfree(handle.bulk_connect->channels);
+    rfree(handle.bulk_connect->states);
+    rfree(handle.bulk_connect);
+    rasta_id_index_free(&handle.connection_index);
+    rasta_connection_pool_free(&handle.connection_pool);
+    redundancy_mux_close(&handle.mux);
+}
+
+void test_redundancy_mux_wait_for_entity() {
+    struct RastaIPData owner_connection, remote_connection;
+    redundancy_mux owner = create_loopback_mux(0x61, &owner_connection);
+    redundancy_mux remote = create_loopback_mux(0x70, &remote_connection);
+
+    struct sockaddr_in owner_address;
+    socklen_t length = sizeof(owner_address);
+    getsockname(owner.udp_socket_states[0].file_descriptor, (struct sockaddr *) &owner_address, &length);
+    struct RastaIPData destination;
+    strcpy(destination.ip, "127.0.0.1");
+    destination.port = ntohs(owner_address.sin_port);
+    redundancy_mux_add_channel(&remote, 0x61, &destination);
+
+    rasta_hashing_context_t hashing_context;
+    memset(&hashing_context, 0, sizeof(hashing_context));
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    struct RastaPacket heartbeat = createHeartbeat(0x61, 0x70, 1, 0, 0, 0, &hashing_context);
+    redundancy_mux_send(&remote, heartbeat);
+
+    // the waiting multiplexer receives the PDU itself
+    CU_ASSERT_PTR_NULL(redundancy_mux_get_channel(&owner, 0x70));
+    redundancy_mux_wait_for_entity(&owner, 0x70);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&owner, 0x70);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 1);
+
+    // no notification runs, nothing is waited for
+    redundancy_mux_wait_for_notifications(&owner);
+
+    redundancy_mux_close(&owner);
+    redundancy_mux_close(&remote);
+}
+
+#define TEST_PATH_COUNT 3
+
+static unsigned int failed_paths;
+
+static void record_path_failure(void * context, unsigned long id, unsigned int path) {
+    (void) context;
+    (void) id;
+    failed_paths |= 1u << path;
+}
+
+/**
+ * receives the PDUs that are queued on a socket of a multiplexer
+ * @param mux the multiplexer
+ * @param path the index of the socket
+ */
+static void receive_path(redundancy_mux * mux, unsigned int path) {
+    struct pollfd readable = { .fd = udp_receive_fd(&mux->udp_socket_states[path]), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        receive_packet(mux, (int) path);
+    }
+}
+
+void test_redundancy_mux_paths() {
+    struct RastaIPData server_connections[TEST_PATH_COUNT], client_connections[TEST_PATH_COUNT];
+    redundancy_mux server = create_loopback_mux_paths(0x61, server_connections, TEST_PATH_COUNT);
+    redundancy_mux client = create_loopback_mux_paths(0x70, client_connections, TEST_PATH_COUNT);
+
+    struct RastaIPData destinations[TEST_PATH_COUNT];
+    for (unsigned int i = 0; i < TEST_PATH_COUNT; i++) {
+        strcpy(destinations[i].ip, "127.0.0.1");
+        destinations[i].port = local_port(&server.udp_socket_states[i]);
+    }
+    redundancy_mux_add_channel(&client, 0x61, destinations);
+
+    rasta_hashing_context_t hashing_context;
+    memset(&hashing_context, 0, sizeof(hashing_context));
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    struct RastaPacket heartbeat = createHeartbeat(0x61, 0x70, 1, 0, 0, 0, &hashing_context);
+
+    // the PDU arrives on the last path first, the server discovers the transport channels in reverse order
+    redundancy_mux_send(&client, heartbeat);
+    for (unsigned int i = TEST_PATH_COUNT; i > 0; i--) {
+        receive_path(&server, i - 1);
+    }
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&server, 0x70);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    CU_ASSERT_EQUAL(channel->connected_channel_count, TEST_PATH_COUNT);
+    for (unsigned int i = 0; i < TEST_PATH_COUNT; i++) {
+        int transport = rasta_red_path_channel(channel, i);
+        CU_ASSERT_EQUAL_FATAL(transport, TEST_PATH_COUNT - 1 - i);
+        CU_ASSERT_EQUAL(channel->connected_channels[transport].path, i);
+        CU_ASSERT_EQUAL(channel->connected_channels[transport].port, local_port(&client.udp_socket_states[i]));
+    }
+
+    // the copies are known by their sequence number and counted on the transport channel of their socket
+    redundancy_mux_send(&client, heartbeat);
+    for (unsigned int i = 0; i < TEST_PATH_COUNT; i++) {
+        receive_path(&server, i);
+    }
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 2);
+    for (unsigned int i = 0; i < TEST_PATH_COUNT; i++) {
+        CU_ASSERT_EQUAL(channel->connected_channels[i].metrics.pdus_in, 2);
+        CU_ASSERT_EQUAL(server.path_metrics[i].pdus_in, 2);
+        CU_ASSERT_EQUAL(client.path_metrics[i].pdus_out, 2);
+    }
+
+    // the answer leaves every socket towards the transport channel that was discovered on it
+    struct RastaPacket answer = createHeartbeat(0x70, 0x61, 1, 0, 0, 0, &hashing_context);
+    redundancy_mux_send(&server, answer);
+    for (unsigned int i = 0; i < TEST_PATH_COUNT; i++) {
+        struct pollfd readable = { .fd = udp_receive_fd(&client.udp_socket_states[i]), .events = POLLIN };
+        CU_ASSERT_EQUAL_FATAL(poll(&readable, 1, 100), 1);
+        CU_ASSERT_EQUAL_FATAL(udp_receive_batch(&client.udp_socket_states[i], &client.receive_batch), 1);
+        size_t length;
+        struct sockaddr_in sender;
+        udp_receive_batch_get(&client.receive_batch, 0, &length, &sender);
+        CU_ASSERT_EQUAL(ntohs(sender.sin_port), local_port(&server.udp_socket_states[i]));
+        CU_ASSERT_EQUAL(server.path_metrics[i].pdus_out, 1);
+    }
+
+    // a PDU that only arrives on the first path reports the other paths as failed, not the transport channels at
+    // their indices
+    redundancy_mux_diagnose(&server);
+    server.on_transport_failure = record_path_failure;
+    failed_paths = 0;
+    redundancy_mux_send(&client, heartbeat);
+    receive_path(&server, 0);
+    redundancy_mux_diagnose(&server);
+    CU_ASSERT_EQUAL(failed_paths, 6);
+
+    redundancy_mux_close(&server);
+    redundancy_mux_close(&client);
+}
+
+void test_redundancy_mux_damaged_duplicate() {
+    struct RastaIPData server_connections[2], client_connections[2];
+    redundancy_mux server = create_loopback_mux_paths(0x61, server_connections, 2);
+    redundancy_mux client = create_loopback_mux_paths(0x70, client_connections, 2);
+    server.config.redundancy.crc_type = crc_init_opt_b();
+    client.config.redundancy.crc_type = crc_init_opt_b();
+
+    struct RastaIPData destinations[2];
+    for (unsigned int i = 0; i < 2; i++) {
+        strcpy(destinations[i].ip, "127.0.0.1");
+        destinations[i].port = local_port(&server.udp_socket_states[i]);
+    }
+    redundancy_mux_add_channel(&client, 0x61, destinations);
+
+    rasta_hashing_context_t hashing_context;
+    memset(&hashing_context, 0, sizeof(hashing_context));
+    hashing_context.algorithm = RASTA_ALGO_MD4;
+    struct RastaPacket heartbeat = createHeartbeat(0x61, 0x70, 1, 0, 0, 0, &hashing_context);
+    redundancy_mux_send(&client, heartbeat);
+    receive_path(&server, 0);
+    receive_path(&server, 1);
+    rasta_redundancy_channel * channel = redundancy_mux_get_channel(&server, 0x70);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(channel);
+    int transport = rasta_red_path_channel(channel, 1);
+    CU_ASSERT_FATAL(transport >= 0);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].metrics.pdus_in, 1);
+
+    // another copy of the delivered PDU from the same socket of the client, once with a damaged CRC checksum
+    unsigned char pdu[MAX_DEFER_QUEUE_MSG_SIZE];
+    unsigned int length = rastaRedundancyPacketEncode(0, &heartbeat, &client.config.redundancy.crc_type,
+                                                      &hashing_context, pdu, sizeof(pdu));
+    CU_ASSERT_FATAL(length > 0);
+    struct sockaddr_in server_address;
+    socklen_t address_length = sizeof(server_address);
+    getsockname(server.udp_socket_states[1].file_descriptor, (struct sockaddr *) &server_address, &address_length);
+
+    pdu[length - 1] ^= 0xff;
+    sendto(client.udp_socket_states[1].file_descriptor, pdu, length, 0, (struct sockaddr *) &server_address,
+           address_length);
+    receive_path(&server, 1);
+    // like every damaged PDU it is a checksum error, it does not count as received in the diagnostics
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].metrics.pdus_in, 2);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].metrics.checksum_errors, 1);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].diagnostics_data.received_packets, 1);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 1);
+
+    // the intact copy is counted on its transport channel without being delivered again
+    pdu[length - 1] ^= 0xff;
+    sendto(client.udp_socket_states[1].file_descriptor, pdu, length, 0, (struct sockaddr *) &server_address,
+           address_length);
+    receive_path(&server, 1);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].metrics.pdus_in, 3);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].metrics.checksum_errors, 1);
+    CU_ASSERT_EQUAL(channel->connected_channels[transport].diagnostics_data.received_packets, 2);
+    CU_ASSERT_EQUAL(fifo_get_size(channel->fifo_recv), 1);
+
+    redundancy_mux_close(&server);
+    redundancy_mux_close(&client);
+}
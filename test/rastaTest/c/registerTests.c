@@ -8,11 +8,34 @@
 #include "rastafactoryTest.h"
 #include "dictionarytest.h"
 #include "rastadeferqueueTest.h"
+#include "rastaretrbufferTest.h"
+#include "rmemoryTest.h"
 #include "configtest.h"
 #include "rastalisttest.h"
 #include "fifotest.h"
+#include "mpscqueueTest.h"
+#include "rastalibTest.h"
+#include "workerpoolTest.h"
+#include "loggingTest.h"
+#include "rastatraceTest.h"
+#include "rastastatpageTest.h"
+#include "rastaflightrecorderTest.h"
+#include "rastametricsTest.h"
+#include "rastareplicationTest.h"
 #include "blake2test.h"
+#include "siphash24test.h"
 #include "opaquetest.h"
+#include "eventsystemTest.h"
+#include "redmuxTest.h"
+#include "rastaidindexTest.h"
+#include "rastaarrivalringTest.h"
+#include "rastaexecutorTest.h"
+#include "rastaconnectionpoolTest.h"
+#include "udpimpairmentTest.h"
+#include "udpshmTest.h"
+#include "udptcpTest.h"
+#include "udpuringTest.h"
+#include "udpxdpTest.h"
 
 int suite_init(void) {
     return 0;
@@ -29,6 +52,13 @@ void cunit_register() {
     //MD4 tests
     CU_add_test(pSuiteMath, "testMD4function", testMD4function);
     CU_add_test(pSuiteMath, "testRastaMD4Sample", testRastaMD4Sample);
+    CU_add_test(pSuiteMath, "testRastaHashingContextMD4", testRastaHashingContextMD4);
+    CU_add_test(pSuiteMath, "testRastaHashIncremental", testRastaHashIncremental);
+    CU_add_test(pSuiteMath, "testRastaHashPreparedKey", testRastaHashPreparedKey);
+    CU_add_test(pSuiteMath, "testMD4MultiBuffer", testMD4MultiBuffer);
+    CU_add_test(pSuiteMath, "testMD4Unaligned", testMD4Unaligned);
+    CU_add_test(pSuiteMath, "testRastaHashVerifyBatch", testRastaHashVerifyBatch);
+    CU_add_test(pSuiteMath, "testRastaHashSelect", testRastaHashSelect);
 
     // Tests for the crc module
     CU_add_test(pSuiteMath, "test_opt_b", test_opt_b);
@@ -36,27 +66,40 @@ void cunit_register() {
     CU_add_test(pSuiteMath, "test_opt_d", test_opt_d);
     CU_add_test(pSuiteMath, "test_opt_e", test_opt_e);
     CU_add_test(pSuiteMath, "test_without_gen_table", test_without_gen_table);
+    CU_add_test(pSuiteMath, "test_slicing_matches_bytewise", test_slicing_matches_bytewise);
+    CU_add_test(pSuiteMath, "test_precomputed_tables", test_precomputed_tables);
+    CU_add_test(pSuiteMath, "test_crc_incremental", test_crc_incremental);
 
     //Tests for rastafactory
     CU_add_test(pSuiteMath, "checkConnectionPacket", checkConnectionPacket);
     CU_add_test(pSuiteMath, "checkNormalPacket", checkNormalPacket);
     CU_add_test(pSuiteMath, "checkDisconnectionRequest", checkDisconnectionRequest);
     CU_add_test(pSuiteMath, "checkMessagePacket", checkMessagePacket);
+    CU_add_test(pSuiteMath, "checkMessageIterator", checkMessageIterator);
 
 
     // Tests for the Redundancy layer factory and model
     CU_add_test(pSuiteMath, "testRedundancyConversionWithCrcChecksumCorrect", testRedundancyConversionWithCrcChecksumCorrect);
     CU_add_test(pSuiteMath, "testRedundancyConversionWithoutChecksum", testRedundancyConversionWithoutChecksum);
     CU_add_test(pSuiteMath, "testRedundancyConversionIncorrectChecksum", testRedundancyConversionIncorrectChecksum);
+    CU_add_test(pSuiteMath, "testRedundancyConversionView", testRedundancyConversionView);
+    CU_add_test(pSuiteMath, "testRedundancyPacketEncode", testRedundancyPacketEncode);
+    CU_add_test(pSuiteMath, "testPacketRestampAndWrap", testPacketRestampAndWrap);
+    CU_add_test(pSuiteMath, "testRedundancyConversionViewBatch", testRedundancyConversionViewBatch);
+    CU_add_test(pSuiteMath, "testRedundancyPacketFusedChecksums", testRedundancyPacketFusedChecksums);
+    CU_add_test(pSuiteMath, "testWireLayout", testWireLayout);
     CU_add_test(pSuiteMath, "testCreateRedundancyPacket", testCreateRedundancyPacket);
     CU_add_test(pSuiteMath, "testCreateRedundancyPacketNoChecksum", testCreateRedundancyPacketNoChecksum);
 
     //Test for dictionary
     CU_add_test(pSuiteMath, "testDictionary", testDictionary);
+    CU_add_test(pSuiteMath, "testDictionaryManyKeys", testDictionaryManyKeys);
+    CU_add_test(pSuiteMath, "testDictionaryMap", testDictionaryMap);
 
     //Test for config
     CU_add_test(pSuiteMath, "check_std_config", check_std_config);
     CU_add_test(pSuiteMath, "check_var_config", check_var_config);
+    CU_add_test(pSuiteMath, "check_config_snapshot", check_config_snapshot);
 
 
     // Tests for the defer queue
@@ -74,6 +117,13 @@ void cunit_register() {
     CU_add_test(pSuiteMath, "test_deferqueue_get_ts", test_deferqueue_get_ts);
     CU_add_test(pSuiteMath, "test_deferqueue_clear", test_deferqueue_clear);
     CU_add_test(pSuiteMath, "test_deferqueue_get_ts_doesnt_contain", test_deferqueue_get_ts_doesnt_contain);
+    CU_add_test(pSuiteMath, "test_deferqueue_large", test_deferqueue_large);
+    CU_add_test(pSuiteMath, "test_deferqueue_reuse", test_deferqueue_reuse);
+    CU_add_test(pSuiteMath, "test_deferqueue_take", test_deferqueue_take);
+    CU_add_test(pSuiteMath, "test_deferqueue_resize", test_deferqueue_resize);
+    CU_add_test(pSuiteMath, "test_retrbuffer_add_confirm", test_retrbuffer_add_confirm);
+    CU_add_test(pSuiteMath, "test_retrbuffer_confirm_overflow", test_retrbuffer_confirm_overflow);
+    CU_add_test(pSuiteMath, "test_retrbuffer_clear", test_retrbuffer_clear);
 
     //tests for rastalist
     //CU_add_test(pSuiteMath, "check_rastalist", check_rastalist);
@@ -81,13 +131,168 @@ void cunit_register() {
     // Tests for the FIFO
     CU_add_test(pSuiteMath, "test_push", test_push);
     CU_add_test(pSuiteMath, "test_pop", test_pop);
+    CU_add_test(pSuiteMath, "test_fifo_wrap_around", test_fifo_wrap_around);
+    CU_add_test(pSuiteMath, "test_fifo_counter_wrap", test_fifo_counter_wrap);
+    CU_add_test(pSuiteMath, "test_fifo_spsc", test_fifo_spsc);
+
+    // Tests for the submission queue
+    CU_add_test(pSuiteMath, "test_mpsc_queue_order", test_mpsc_queue_order);
+    CU_add_test(pSuiteMath, "test_mpsc_queue_uncommitted", test_mpsc_queue_uncommitted);
+    CU_add_test(pSuiteMath, "test_mpsc_queue_threads", test_mpsc_queue_threads);
+
+    // Tests for the sharded handles
+    CU_add_test(pSuiteMath, "test_rasta_lib_shard_index", test_rasta_lib_shard_index);
+    CU_add_test(pSuiteMath, "test_rasta_lib_shard_channels", test_rasta_lib_shard_channels);
+
+    // Tests for the notifications
+    CU_add_test(pSuiteMath, "test_notification_live_connection", test_notification_live_connection);
+    CU_add_test(pSuiteMath, "test_receive_bulk", test_receive_bulk);
+    CU_add_test(pSuiteMath, "test_send_owned", test_send_owned);
+    CU_add_test(pSuiteMath, "test_send_priority", test_send_priority);
+
+    // Tests for the diagnostics
+    CU_add_test(pSuiteMath, "test_diagnostic_record", test_diagnostic_record);
+    CU_add_test(pSuiteMath, "test_diagnostic_window", test_diagnostic_window);
+    CU_add_test(pSuiteMath, "test_reconnect_delay", test_reconnect_delay);
+    CU_add_test(pSuiteMath, "test_connect_wave_size", test_connect_wave_size);
+
+    // Tests for the worker pool
+    CU_add_test(pSuiteMath, "test_worker_pool_complete", test_worker_pool_complete);
+    CU_add_test(pSuiteMath, "test_worker_pool_limit", test_worker_pool_limit);
+    CU_add_test(pSuiteMath, "test_worker_pool_destroy", test_worker_pool_destroy);
+
+    // Tests for the asynchronous logger
+    CU_add_test(pSuiteMath, "test_logger_async_file", test_logger_async_file);
+    CU_add_test(pSuiteMath, "test_logger_async_dropped", test_logger_async_dropped);
+    CU_add_test(pSuiteMath, "test_logger_level_check", test_logger_level_check);
+
+    // Tests for the binary trace
+    CU_add_test(pSuiteMath, "test_rasta_trace_ring", test_rasta_trace_ring);
+    CU_add_test(pSuiteMath, "test_rasta_trace_reopen", test_rasta_trace_reopen);
+    CU_add_test(pSuiteMath, "test_rasta_trace_render", test_rasta_trace_render);
+    CU_add_test(pSuiteMath, "test_stat_page_publish", test_stat_page_publish);
+    CU_add_test(pSuiteMath, "test_stat_page_seqlock", test_stat_page_seqlock);
+    CU_add_test(pSuiteMath, "test_stat_page_replace", test_stat_page_replace);
+    CU_add_test(pSuiteMath, "test_stat_page_prometheus", test_stat_page_prometheus);
+
+    // Tests for the flight recorder
+    CU_add_test(pSuiteMath, "test_flight_recorder_ring", test_flight_recorder_ring);
+    CU_add_test(pSuiteMath, "test_flight_recorder_dump", test_flight_recorder_dump);
+    CU_add_test(pSuiteMath, "test_flight_recorder_safety_errors", test_flight_recorder_safety_errors);
+
+    // Tests for the metrics
+    CU_add_test(pSuiteMath, "test_rasta_histogram_buckets", test_rasta_histogram_buckets);
+    CU_add_test(pSuiteMath, "test_rasta_histogram_percentile", test_rasta_histogram_percentile);
+    CU_add_test(pSuiteMath, "test_receive_stage_metrics", test_receive_stage_metrics);
+    CU_add_test(pSuiteMath, "test_peer_ranking", test_peer_ranking);
+    CU_add_test(pSuiteMath, "test_residency_metrics", test_residency_metrics);
+
+    // Tests for the replication to a standby
+    CU_add_test(pSuiteMath, "test_replica_encode_decode", test_replica_encode_decode);
+    CU_add_test(pSuiteMath, "test_replication_stream", test_replication_stream);
+
+    // Tests for the allocator
+    CU_add_test(pSuiteMath, "test_rmemory_steady_state", test_rmemory_steady_state);
+    CU_add_test(pSuiteMath, "test_rmemory_realloc", test_rmemory_realloc);
+    CU_add_test(pSuiteMath, "test_rmemory_stats", test_rmemory_stats);
+    CU_add_test(pSuiteMath, "test_rmemory_subsystem_stats", test_rmemory_subsystem_stats);
+    CU_add_test(pSuiteMath, "test_rmemory_placement", test_rmemory_placement);
+    CU_add_test(pSuiteMath, "test_rmemory_seal", test_rmemory_seal);
 
     // Tests for BLAKE2 hashes
     CU_add_test(pSuiteMath, "testBlake2Hash", testBlake2Hash);
+    CU_add_test(pSuiteMath, "testBlake2bMulti", testBlake2bMulti);
+    CU_add_test(pSuiteMath, "testSipHash24Multi", testSipHash24Multi);
+
+    // Tests for the event system
+    CU_add_test(pSuiteMath, "test_event_system_timed_event_order", test_event_system_timed_event_order);
+    CU_add_test(pSuiteMath, "test_event_system_disabled_timed_event", test_event_system_disabled_timed_event);
+    CU_add_test(pSuiteMath, "test_event_system_remove_in_callback", test_event_system_remove_in_callback);
+    CU_add_test(pSuiteMath, "test_event_system_profile", test_event_system_profile);
+    CU_add_test(pSuiteMath, "test_event_system_loop_time", test_event_system_loop_time);
+    CU_add_test(pSuiteMath, "test_event_system_busy_poll", test_event_system_busy_poll);
+    CU_add_test(pSuiteMath, "test_event_system_realtime", test_event_system_realtime);
+    CU_add_test(pSuiteMath, "test_event_system_post", test_event_system_post);
+    CU_add_test(pSuiteMath, "test_event_system_post_batch", test_event_system_post_batch);
+    CU_add_test(pSuiteMath, "test_event_system_virtual_time", test_event_system_virtual_time);
+    CU_add_test(pSuiteMath, "test_event_system_virtual_time_fd", test_event_system_virtual_time_fd);
+
+    // Tests for the id index
+    CU_add_test(pSuiteMath, "test_id_index_put_get", test_id_index_put_get);
+    CU_add_test(pSuiteMath, "test_id_index_remove", test_id_index_remove);
+    CU_add_test(pSuiteMath, "test_arrival_ring_put_get", test_arrival_ring_put_get);
+    CU_add_test(pSuiteMath, "test_arrival_ring_resize", test_arrival_ring_resize);
+    CU_add_test(pSuiteMath, "test_callback_executor_order", test_callback_executor_order);
+    CU_add_test(pSuiteMath, "test_callback_executor_overflow", test_callback_executor_overflow);
+    CU_add_test(pSuiteMath, "test_callback_executor_thread", test_callback_executor_thread);
+    CU_add_test(pSuiteMath, "test_callback_executor_state_coalescing", test_callback_executor_state_coalescing);
+
+    // Tests for the connection pool
+    CU_add_test(pSuiteMath, "test_connection_pool_slab", test_connection_pool_slab);
+    CU_add_test(pSuiteMath, "test_connection_pool_layout", test_connection_pool_layout);
+    CU_add_test(pSuiteMath, "test_connection_pool_on_demand", test_connection_pool_on_demand);
+    CU_add_test(pSuiteMath, "test_connection_pool_residency", test_connection_pool_residency);
+    CU_add_test(pSuiteMath, "test_connection_pool_flight_records", test_connection_pool_flight_records);
+
+    // Tests for the redundancy multiplexer
+    CU_add_test(pSuiteMath, "test_redundancy_mux_get_channel", test_redundancy_mux_get_channel);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_remove_channel", test_redundancy_mux_remove_channel);
+    CU_add_test(pSuiteMath, "test_redundancy_channel_deliver_decoded", test_redundancy_channel_deliver_decoded);
+    CU_add_test(pSuiteMath, "test_redundancy_channel_early_duplicate", test_redundancy_channel_early_duplicate);
+    CU_add_test(pSuiteMath, "test_redundancy_packet_peek", test_redundancy_packet_peek);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_diagnose", test_redundancy_mux_diagnose);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_defer_timeout", test_redundancy_mux_defer_timeout);
+    CU_add_test(pSuiteMath, "test_redundancy_adaptive_defer_timeout", test_redundancy_adaptive_defer_timeout);
+    CU_add_test(pSuiteMath, "test_transport_channel_endpoint", test_transport_channel_endpoint);
+    CU_add_test(pSuiteMath, "test_udp_receive_timestamps", test_udp_receive_timestamps);
+    CU_add_test(pSuiteMath, "test_udp_kernel_drops", test_udp_kernel_drops);
+    CU_add_test(pSuiteMath, "test_udp_transmit_queue", test_udp_transmit_queue);
+    CU_add_test(pSuiteMath, "test_udp_offload", test_udp_offload);
+    CU_add_test(pSuiteMath, "test_udp_reuseport_steering", test_udp_reuseport_steering);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_shared_sockets", test_redundancy_mux_shared_sockets);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_pending_channels", test_redundancy_mux_pending_channels);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_reconfigure", test_redundancy_mux_reconfigure);
+    CU_add_test(pSuiteMath, "test_heartbeat_batch", test_heartbeat_batch);
+    CU_add_test(pSuiteMath, "test_heartbeat_paced_retransmission", test_heartbeat_paced_retransmission);
+    CU_add_test(pSuiteMath, "test_send_budget", test_send_budget);
+    CU_add_test(pSuiteMath, "test_receive_backpressure", test_receive_backpressure);
+    CU_add_test(pSuiteMath, "test_disconnect_all", test_disconnect_all);
+    CU_add_test(pSuiteMath, "test_bulk_connect", test_bulk_connect);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_wait_for_entity", test_redundancy_mux_wait_for_entity);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_paths", test_redundancy_mux_paths);
+    CU_add_test(pSuiteMath, "test_redundancy_mux_damaged_duplicate", test_redundancy_mux_damaged_duplicate);
+
+    // Tests for the impairment of transport channels
+    CU_add_test(pSuiteMath, "test_udp_impairment_seed", test_udp_impairment_seed);
+    CU_add_test(pSuiteMath, "test_udp_impairment_delay", test_udp_impairment_delay);
+
+    // Tests for the shared memory transport backend
+    CU_add_test(pSuiteMath, "test_udp_shm_send_receive", test_udp_shm_send_receive);
+    CU_add_test(pSuiteMath, "test_udp_shm_ring_full", test_udp_shm_ring_full);
+    CU_add_test(pSuiteMath, "test_udp_shm_peer_restart", test_udp_shm_peer_restart);
+
+    // Tests for the TCP transport backend
+    CU_add_test(pSuiteMath, "test_udp_tcp_send_receive", test_udp_tcp_send_receive);
+    CU_add_test(pSuiteMath, "test_udp_tcp_buffer_full", test_udp_tcp_buffer_full);
+    CU_add_test(pSuiteMath, "test_udp_tcp_peer_restart", test_udp_tcp_peer_restart);
+
+    // Tests for the io_uring transport backend
+#ifdef ENABLE_IO_URING
+    CU_add_test(pSuiteMath, "test_udp_uring_send_receive", test_udp_uring_send_receive);
+    CU_add_test(pSuiteMath, "test_udp_uring_buffers_exhausted", test_udp_uring_buffers_exhausted);
+#endif
+
+    // Tests for the AF_XDP transport backend
+#ifdef ENABLE_AF_XDP
+    CU_add_test(pSuiteMath, "test_udp_xdp_send_receive", test_udp_xdp_send_receive);
+    CU_add_test(pSuiteMath, "test_udp_xdp_frame", test_udp_xdp_frame);
+    CU_add_test(pSuiteMath, "test_udp_xdp_fallback", test_udp_xdp_fallback);
+#endif
 
     // Tests for OPAQUE
 #ifdef ENABLE_OPAQUE
     CU_add_test(pSuiteMath, "opaque_wrapper_test", opaque_wrapper_test);
+    CU_add_test(pSuiteMath, "opaque_secrets_test", opaque_secrets_test);
 #endif
 }
 
@@ -0,0 +1,234 @@
+#include <CUnit/Basic.h>
+#include <pthread.h>
+#include <string.h>
+#include "../headers/rmemoryTest.h"
+#include "rmemory.h"
+#include "fifo.h"
+#include "rastautil.h"
+
+void test_rmemory_steady_state() {
+#ifdef ENABLE_MEMORY_POOL
+    fifo_t * fifo = fifo_init(8);
+    struct rmemory_stats before;
+    struct rmemory_stats after;
+
+    // the first round fills the pools
+    for (unsigned int round = 0; round < 100; round++) {
+        if (round == 1) {
+            rmemory_get_stats(&before);
+        }
+        for (unsigned int i = 0; i < 8; i++) {
+            struct RastaByteArray * message = rmalloc(sizeof(struct RastaByteArray));
+            allocateRastaByteArray(message, 1000);
+            fifo_push(fifo, message);
+        }
+        for (unsigned int i = 0; i < 8; i++) {
+            struct RastaByteArray * message = fifo_pop(fifo);
+            freeRastaByteArray(message);
+            rfree(message);
+        }
+    }
+    rmemory_get_stats(&after);
+
+    CU_ASSERT_EQUAL(after.system_allocations, before.system_allocations);
+    // the FIFO does not allocate, every message is a byte array header and its bytes
+    CU_ASSERT_EQUAL(after.allocations - before.allocations, 99 * 8 * 2);
+
+    fifo_destroy(fifo);
+#endif
+}
+
+void test_rmemory_realloc() {
+    unsigned char * bytes = rmalloc(10);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bytes);
+    for (unsigned int i = 0; i < 10; i++) {
+        bytes[i] = (unsigned char) i;
+    }
+
+    // still fits into the block
+    bytes = rrealloc(bytes, 16);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bytes);
+
+    bytes = rrealloc(bytes, 300);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bytes);
+    for (unsigned int i = 10; i < 300; i++) {
+        bytes[i] = (unsigned char) i;
+    }
+
+    bytes = rrealloc(bytes, 5000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bytes);
+    for (unsigned int i = 0; i < 300; i++) {
+        CU_ASSERT_EQUAL(bytes[i], (unsigned char) i);
+    }
+
+    bytes = rrealloc(bytes, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bytes);
+    for (unsigned int i = 0; i < 4; i++) {
+        CU_ASSERT_EQUAL(bytes[i], (unsigned char) i);
+    }
+
+    rfree(bytes);
+}
+
+void test_rmemory_stats() {
+    struct rmemory_stats before;
+    struct rmemory_stats after;
+
+    rmemory_get_stats(&before);
+    void * small = rmalloc(24);
+    void * large = rmalloc(100000);
+    rfree(small);
+    rfree(large);
+    rfree(NULL);
+    rmemory_get_stats(&after);
+
+    CU_ASSERT_EQUAL(after.allocations - before.allocations, 2);
+    CU_ASSERT_EQUAL(after.frees - before.frees, 2);
+    // the large block never comes from a pool
+    CU_ASSERT(after.system_allocations - before.system_allocations >= 1);
+}
+
+void test_rmemory_subsystem_stats() {
+    struct rmemory_subsystem_stats before;
+    struct rmemory_subsystem_stats after;
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    CU_ASSERT_FATAL(rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &before));
+    unsigned char * bytes = rmalloc_tagged(100, RMEMORY_SUBSYSTEM_SCI);
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &after);
+    CU_ASSERT_EQUAL(after.allocations - before.allocations, 1);
+    CU_ASSERT_EQUAL(after.bytes - before.bytes, 100);
+    CU_ASSERT_EQUAL(after.live_bytes - before.live_bytes, 100);
+    CU_ASSERT(after.peak_live_bytes >= after.live_bytes);
+
+    // a block that still fits stays with its subsystem, the peak stays where it was
+    bytes = rrealloc_tagged(bytes, 20, RMEMORY_SUBSYSTEM_CODEC);
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &after);
+    CU_ASSERT_EQUAL(after.live_bytes - before.live_bytes, 20);
+    CU_ASSERT(after.peak_live_bytes >= before.live_bytes + 100);
+
+    rfree(bytes);
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &after);
+    CU_ASSERT_EQUAL(after.frees - before.frees, 1);
+    CU_ASSERT_EQUAL(after.live_bytes, before.live_bytes);
+
+    // the FIFO tags its own allocations
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_FIFO, &before);
+    fifo_t * fifo = fifo_init(8);
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_FIFO, &after);
+    CU_ASSERT(after.allocations > before.allocations);
+    fifo_destroy(fifo);
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_FIFO, &after);
+    CU_ASSERT_EQUAL(after.live_bytes, before.live_bytes);
+#else
+    CU_ASSERT_FALSE(rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &before));
+    rfree(rmalloc_tagged(100, RMEMORY_SUBSYSTEM_SCI));
+    rmemory_get_subsystem_stats(RMEMORY_SUBSYSTEM_SCI, &after);
+    CU_ASSERT_EQUAL(after.allocations, 0);
+#endif
+    CU_ASSERT_STRING_EQUAL(rmemory_subsystem_name(RMEMORY_SUBSYSTEM_REDUNDANCY), "redundancy");
+}
+
+/**
+ * the statistics around the allocations of a thread with a placement
+ */
+struct placed_allocations {
+    struct rmemory_stats before;
+    struct rmemory_stats allocated;
+    struct rmemory_stats freed;
+    struct rmemory_placement previous;
+    int content_kept;
+};
+
+/**
+ * allocates on a thread of its own, so the pools of the thread are still empty
+ */
+static void * placed_thread(void * carry_data) {
+    struct placed_allocations * result = carry_data;
+    struct rmemory_placement placement = { rmemory_cpu_node(0), 1 };
+
+    result->previous = rmemory_set_thread_placement(placement);
+    rmemory_get_stats(&result->before);
+    unsigned char * small = rmalloc(24);
+    unsigned char * large = rmalloc(200000);
+    memset(small, 0xAB, 24);
+    memset(large, 0xCD, 200000);
+    rmemory_get_stats(&result->allocated);
+
+    large = rrealloc(large, 300000);
+    result->content_kept = large[0] == 0xCD && large[199999] == 0xCD;
+    rfree(small);
+    rfree(large);
+    rmemory_get_stats(&result->freed);
+
+    rmemory_set_thread_placement(result->previous);
+    return NULL;
+}
+
+void test_rmemory_placement() {
+    struct placed_allocations result;
+    pthread_t thread;
+
+    CU_ASSERT_EQUAL(rmemory_cpu_node(-1), -1);
+    CU_ASSERT_EQUAL(rmemory_cpu_node(1 << 20), -1);
+
+    memset(&result, 0, sizeof(result));
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&thread, NULL, placed_thread, &result), 0);
+    pthread_join(thread, NULL);
+
+    CU_ASSERT_EQUAL(result.previous.numa_node, -1);
+    CU_ASSERT_EQUAL(result.previous.huge_pages, 0);
+    CU_ASSERT(result.content_kept);
+#if !defined(USE_USER_ARENA) && !defined(USE_STATIC_MEMORY)
+    unsigned long chunk = 0;
+#ifdef ENABLE_MEMORY_POOL
+    // the slab of the small block is cut from a chunk, which stays with the thread
+    chunk = 2 * 1024 * 1024;
+#endif
+    CU_ASSERT(result.allocated.mapped_bytes - result.before.mapped_bytes >= chunk + 200000);
+    CU_ASSERT(result.freed.mapped_bytes - result.before.mapped_bytes >= chunk);
+    CU_ASSERT(result.freed.mapped_bytes - result.before.mapped_bytes < chunk + 200000);
+    CU_ASSERT(result.allocated.huge_page_bytes <= result.allocated.mapped_bytes);
+#endif
+}
+
+void test_rmemory_seal() {
+    // a large block is not pooled, the system allocation of the first one is part of the initialization
+    void * block = rmalloc(100000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(block);
+    rfree(block);
+    rmemory_seal();
+
+    struct rmemory_stats stats;
+    rmemory_get_stats(&stats);
+    CU_ASSERT_EQUAL(stats.sealed_system_allocations, 0);
+
+    block = rmalloc(100000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(block);
+    rmemory_get_stats(&stats);
+    CU_ASSERT_EQUAL(stats.sealed_system_allocations, 1);
+
+#ifdef USE_STATIC_MEMORY
+    CU_ASSERT(stats.static_bytes >= 100000);
+    CU_ASSERT(stats.static_bytes <= RASTA_STATIC_MEMORY_BYTES);
+
+    // the freed piece is taken again, the static memory does not grow
+    unsigned long used = stats.static_bytes;
+    rfree(block);
+    block = rmalloc(90000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(block);
+    rmemory_get_stats(&stats);
+    CU_ASSERT_EQUAL(stats.static_bytes, used);
+
+    // more than is left is refused
+    CU_ASSERT_PTR_NULL(rmalloc(RASTA_STATIC_MEMORY_BYTES));
+#else
+    CU_ASSERT_EQUAL(stats.static_bytes, 0);
+#endif
+    rfree(block);
+
+    // sealing again starts counting anew
+    rmemory_seal();
+    rmemory_get_stats(&stats);
+    CU_ASSERT_EQUAL(stats.sealed_system_allocations, 0);
+}
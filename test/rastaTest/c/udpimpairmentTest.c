@@ -0,0 +1,125 @@
+#include "udpimpairmentTest.h"
+#include <CUnit/Basic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "udpimpairment.h"
+
+#define TEST_DATAGRAMS 200
+
+/**
+ * opens a socket on an ephemeral port of the loopback interface
+ * @param address the address of the socket is written in here
+ * @return the file descriptor
+ */
+static int open_loopback_socket(struct sockaddr_in * address) {
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    memset(address, 0, sizeof(struct sockaddr_in));
+    address->sin_family = AF_INET;
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *) address, sizeof(struct sockaddr_in));
+
+    socklen_t length = sizeof(struct sockaddr_in);
+    getsockname(fd, (struct sockaddr *) address, &length);
+    return fd;
+}
+
+/**
+ * @param fd a socket
+ * @return the amount of datagrams that arrive on the socket within 100 ms of each other
+ */
+static unsigned int receive_all(int fd) {
+    unsigned int count = 0;
+    struct pollfd readable = { .fd = fd, .events = POLLIN };
+    unsigned char buffer[64];
+    while (poll(&readable, 1, 100) > 0) {
+        recv(fd, buffer, sizeof(buffer), 0);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * sends TEST_DATAGRAMS datagrams through an impairment
+ * @param config the impairment
+ * @param stats the statistics of the impairment are written in here
+ * @return the amount of received datagrams
+ */
+static unsigned int send_impaired(const struct RastaConfigImpairment * config, struct udp_impairment_stats * stats) {
+    struct sockaddr_in receiver, sender;
+    int receive_fd = open_loopback_socket(&receiver);
+    int send_fd = open_loopback_socket(&sender);
+
+    struct udp_impairment * impairment = udp_impairment_create(send_fd, config, 1234);
+    unsigned char message[8] = {0};
+    for (unsigned int i = 0; i < TEST_DATAGRAMS; i++) {
+        message[0] = (unsigned char) i;
+        udp_impairment_send(impairment, message, sizeof(message), &receiver);
+    }
+
+    unsigned int received = receive_all(receive_fd);
+    udp_impairment_get_stats(impairment, stats);
+    udp_impairment_destroy(impairment);
+    close(send_fd);
+    close(receive_fd);
+    return received;
+}
+
+void test_udp_impairment_seed() {
+    struct RastaConfigImpairment config;
+    memset(&config, 0, sizeof(config));
+    config.loss = 30;
+    config.duplicate = 10;
+    CU_ASSERT_TRUE(udp_impairment_is_active(&config));
+
+    struct udp_impairment_stats first, second;
+    unsigned int first_received = send_impaired(&config, &first);
+    unsigned int second_received = send_impaired(&config, &second);
+
+    CU_ASSERT_EQUAL(first.datagrams, TEST_DATAGRAMS);
+    CU_ASSERT_TRUE(first.dropped > 0 && first.dropped < TEST_DATAGRAMS);
+    CU_ASSERT_TRUE(first.duplicated > 0);
+    CU_ASSERT_EQUAL(first_received, TEST_DATAGRAMS - first.dropped + first.duplicated);
+
+    // the same seed impairs the same datagrams
+    CU_ASSERT_EQUAL(first.dropped, second.dropped);
+    CU_ASSERT_EQUAL(first.duplicated, second.duplicated);
+    CU_ASSERT_EQUAL(first_received, second_received);
+}
+
+void test_udp_impairment_delay() {
+    struct RastaConfigImpairment config;
+    memset(&config, 0, sizeof(config));
+    config.delay_us = 20000;
+    config.jitter_us = 1000;
+
+    struct sockaddr_in receiver, sender;
+    int receive_fd = open_loopback_socket(&receiver);
+    int send_fd = open_loopback_socket(&sender);
+    struct udp_impairment * impairment = udp_impairment_create(send_fd, &config, 1);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned char message[8] = {0};
+    udp_impairment_send(impairment, message, sizeof(message), &receiver);
+
+    // nothing arrives before the delay
+    struct pollfd readable = { .fd = receive_fd, .events = POLLIN };
+    CU_ASSERT_EQUAL(poll(&readable, 1, 5), 0);
+
+    CU_ASSERT_EQUAL(poll(&readable, 1, 1000), 1);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long elapsed_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+    CU_ASSERT_TRUE(elapsed_us >= 20000);
+
+    struct udp_impairment_stats stats;
+    udp_impairment_get_stats(impairment, &stats);
+    CU_ASSERT_EQUAL(stats.delayed, 1);
+
+    udp_impairment_destroy(impairment);
+    close(send_fd);
+    close(receive_fd);
+}
@@ -0,0 +1,232 @@
+#define _GNU_SOURCE // mmsghdr
+#include "udpshmTest.h"
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "udp.h"
+#include "udpshm.h"
+
+/**
+ * binds a socket on an ephemeral port of the loopback interface
+ * @param state the socket
+ * @param tls_config the disabled TLS options
+ * @return the address of the socket
+ */
+static struct sockaddr_in open_loopback_socket(struct RastaUDPState * state, const struct RastaConfigTLS * tls_config) {
+    udp_init(state, tls_config);
+    udp_bind_device(state, 0, "127.0.0.1");
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(state->file_descriptor, (struct sockaddr *) &address, &length);
+    return address;
+}
+
+/**
+ * a name that is not used by a concurrent run of the tests
+ */
+static void unique_name(char * name, const char * test) {
+    snprintf(name, RASTA_SHM_NAME_LEN, "test-%d-%s", (int) getpid(), test);
+}
+
+/**
+ * sends @p count datagrams that carry their index with one batch
+ */
+static void send_indexed(struct RastaUDPState * sender, struct sockaddr_in receiver, unsigned int first,
+                         unsigned int count) {
+    unsigned char data[count][4];
+    unsigned char * messages[count];
+    size_t lengths[count];
+    struct sockaddr_in receivers[count];
+    for (unsigned int i = 0; i < count; i++) {
+        memcpy(data[i], &(unsigned int){first + i}, 4);
+        messages[i] = data[i];
+        lengths[i] = 4;
+        receivers[i] = receiver;
+    }
+    udp_send_batch(sender, messages, lengths, receivers, count);
+}
+
+/**
+ * receives datagrams on both sockets until none of them is readable for 100 ms. The sockets meet while they receive
+ * @param in_order set to the amount of datagrams of @p sender that arrived at @p receiver in order, starting at 0
+ * @param seen marks the indices of the datagrams of @p sender that arrived at @p receiver
+ * @return the amount of datagrams of @p sender that arrived at @p receiver
+ */
+static unsigned int pump(struct RastaUDPState * receiver, struct RastaUDPState * other, struct sockaddr_in sender,
+                         struct RastaUDPReceiveBatch * batch, unsigned int * in_order, unsigned char * seen,
+                         unsigned int seen_size) {
+    unsigned int received = 0;
+    *in_order = 0;
+    struct RastaUDPState * states[2] = { receiver, other };
+    struct pollfd readable[2] = {
+        { .fd = udp_receive_fd(receiver), .events = POLLIN },
+        { .fd = other != NULL ? udp_receive_fd(other) : -1, .events = POLLIN },
+    };
+    while (poll(readable, 2, 100) > 0) {
+        for (unsigned int s = 0; s < 2; s++) {
+            if (!(readable[s].revents & POLLIN)) {
+                continue;
+            }
+            unsigned int count = udp_receive_batch(states[s], batch);
+            for (unsigned int i = 0; s == 0 && i < count; i++) {
+                size_t length;
+                struct sockaddr_in from;
+                unsigned char * datagram = udp_receive_batch_get(batch, i, &length, &from);
+                unsigned int index;
+                memcpy(&index, datagram, 4);
+                if (length != 4 || from.sin_port != sender.sin_port || from.sin_addr.s_addr != sender.sin_addr.s_addr) {
+                    continue;
+                }
+                if (index == *in_order) {
+                    (*in_order)++;
+                }
+                if (seen != NULL && index < seen_size) {
+                    seen[index] = 1;
+                }
+                received++;
+            }
+        }
+    }
+    return received;
+}
+
+/**
+ * @return 1 if a datagram waits on the socket itself
+ */
+static int socket_has_datagram(struct RastaUDPState * state) {
+    unsigned char byte;
+    return recv(state->file_descriptor, &byte, 1, MSG_DONTWAIT | MSG_PEEK) >= 0;
+}
+
+void test_udp_shm_send_receive() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    char name[RASTA_SHM_NAME_LEN];
+    unique_name(name, "send");
+
+    struct RastaUDPState listener, connector, remote;
+    struct sockaddr_in listener_address = open_loopback_socket(&listener, &tls_config);
+    struct sockaddr_in connector_address = open_loopback_socket(&connector, &tls_config);
+    struct sockaddr_in remote_address = open_loopback_socket(&remote, &tls_config);
+    udp_enable_shm(&listener, name);
+    udp_enable_shm(&connector, name);
+    CU_ASSERT_NOT_EQUAL(listener.shm->listen_fd, -1);
+    CU_ASSERT_NOT_EQUAL(connector.shm->pending_fd, -1);
+    CU_ASSERT_NOT_EQUAL(udp_receive_fd(&listener), listener.file_descriptor);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+
+    // the listener hands out the rings, the connector takes them
+    unsigned int in_order;
+    pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(listener.shm->peer_count, 1);
+    CU_ASSERT_EQUAL(connector.shm->peer_count, 1);
+    CU_ASSERT_EQUAL(connector.shm->pending_fd, -1);
+
+    // both directions use the rings, nothing is sent on the sockets
+    send_indexed(&connector, listener_address, 0, 100);
+    CU_ASSERT_FALSE(socket_has_datagram(&listener));
+    CU_ASSERT_EQUAL(pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0), 100);
+    CU_ASSERT_EQUAL(in_order, 100);
+
+    send_indexed(&listener, connector_address, 0, 100);
+    CU_ASSERT_FALSE(socket_has_datagram(&connector));
+    CU_ASSERT_EQUAL(pump(&connector, &listener, listener_address, &batch, &in_order, NULL, 0), 100);
+    CU_ASSERT_EQUAL(in_order, 100);
+
+    // a socket that does not use the name is reached through UDP in both directions
+    send_indexed(&remote, listener_address, 0, 10);
+    CU_ASSERT_EQUAL(pump(&listener, &connector, remote_address, &batch, &in_order, NULL, 0), 10);
+    send_indexed(&listener, remote_address, 0, 10);
+    CU_ASSERT_EQUAL(pump(&remote, NULL, listener_address, &batch, &in_order, NULL, 0), 10);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&listener);
+    udp_close(&connector);
+    udp_close(&remote);
+}
+
+void test_udp_shm_ring_full() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    char name[RASTA_SHM_NAME_LEN];
+    unique_name(name, "full");
+
+    struct RastaUDPState listener, connector;
+    struct sockaddr_in listener_address = open_loopback_socket(&listener, &tls_config);
+    struct sockaddr_in connector_address = open_loopback_socket(&connector, &tls_config);
+    udp_enable_shm(&listener, name);
+    udp_enable_shm(&connector, name);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+    unsigned int in_order;
+    pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(connector.shm->peer_count, 1);
+
+    // the datagrams behind a full ring take the socket, none of them is lost
+    unsigned int total = UDP_SHM_RING_SLOTS + 44;
+    send_indexed(&connector, listener_address, 0, total);
+    CU_ASSERT_TRUE(socket_has_datagram(&listener));
+    unsigned char seen[UDP_SHM_RING_SLOTS + 44];
+    memset(seen, 0, sizeof(seen));
+    CU_ASSERT_EQUAL(pump(&listener, &connector, connector_address, &batch, &in_order, seen, total), total);
+    unsigned int distinct = 0;
+    for (unsigned int i = 0; i < total; i++) {
+        distinct += seen[i];
+    }
+    CU_ASSERT_EQUAL(distinct, total);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&listener);
+    udp_close(&connector);
+}
+
+void test_udp_shm_peer_restart() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+    char name[RASTA_SHM_NAME_LEN];
+    unique_name(name, "restart");
+
+    struct RastaUDPState listener, connector;
+    struct sockaddr_in listener_address = open_loopback_socket(&listener, &tls_config);
+    struct sockaddr_in connector_address = open_loopback_socket(&connector, &tls_config);
+    udp_enable_shm(&listener, name);
+    udp_enable_shm(&connector, name);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+    unsigned int in_order;
+    pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(listener.shm->peer_count, 1);
+
+    // the listener notices the closed connector
+    udp_close(&connector);
+    pump(&listener, NULL, connector_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(listener.shm->peer_count, 0);
+
+    // a restarted connector gets new rings
+    connector_address = open_loopback_socket(&connector, &tls_config);
+    udp_enable_shm(&connector, name);
+    pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(listener.shm->peer_count, 1);
+    CU_ASSERT_EQUAL(connector.shm->peer_count, 1);
+    send_indexed(&connector, listener_address, 0, 10);
+    CU_ASSERT_EQUAL(pump(&listener, &connector, connector_address, &batch, &in_order, NULL, 0), 10);
+    CU_ASSERT_EQUAL(in_order, 10);
+
+    // the connector takes over the rendezvous when the listener is gone
+    udp_close(&listener);
+    pump(&connector, NULL, listener_address, &batch, &in_order, NULL, 0);
+    CU_ASSERT_EQUAL(connector.shm->peer_count, 0);
+    CU_ASSERT_NOT_EQUAL(connector.shm->listen_fd, -1);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&connector);
+}
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE // mmsghdr
+#include "udptcpTest.h"
+#include <CUnit/Basic.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "udp.h"
+#include "udptcp.h"
+
+/**
+ * binds a socket on the loopback interface and lets it exchange its datagrams over TCP
+ * @param state the socket
+ * @param tls_config the disabled TLS options
+ * @param port the port, 0 for an ephemeral one
+ * @return the address of the socket
+ */
+static struct sockaddr_in open_tcp_socket(struct RastaUDPState * state, const struct RastaConfigTLS * tls_config,
+                                          uint16_t port) {
+    udp_init(state, tls_config);
+    udp_bind_device(state, port, "127.0.0.1");
+    udp_enable_tcp(state, 0);
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(state->file_descriptor, (struct sockaddr *) &address, &length);
+    return address;
+}
+
+/**
+ * sends @p count datagrams of @p length bytes that start with their index with one batch
+ */
+static void send_indexed(struct RastaUDPState * sender, struct sockaddr_in receiver, unsigned int first,
+                         unsigned int count, size_t length) {
+    unsigned char data[count][length];
+    unsigned char * messages[count];
+    size_t lengths[count];
+    struct sockaddr_in receivers[count];
+    for (unsigned int i = 0; i < count; i++) {
+        memset(data[i], 0, length);
+        memcpy(data[i], &(unsigned int){first + i}, 4);
+        messages[i] = data[i];
+        lengths[i] = length;
+        receivers[i] = receiver;
+    }
+    udp_send_batch(sender, messages, lengths, receivers, count);
+}
+
+/**
+ * receives datagrams on both sockets until none of them is readable for 100 ms. The streams are connected while they
+ * receive
+ * @param in_order set to the amount of datagrams of @p sender that arrived at @p receiver in order, starting at 0
+ * @return the amount of datagrams of @p sender that arrived at @p receiver
+ */
+static unsigned int pump(struct RastaUDPState * receiver, struct RastaUDPState * other, struct sockaddr_in sender,
+                         struct RastaUDPReceiveBatch * batch, unsigned int * in_order) {
+    unsigned int received = 0;
+    *in_order = 0;
+    struct RastaUDPState * states[2] = { receiver, other };
+    struct pollfd readable[2] = {
+        { .fd = udp_receive_fd(receiver), .events = POLLIN },
+        { .fd = other != NULL ? udp_receive_fd(other) : -1, .events = POLLIN },
+    };
+    while (poll(readable, 2, 100) > 0) {
+        for (unsigned int s = 0; s < 2; s++) {
+            if (!(readable[s].revents & POLLIN)) {
+                continue;
+            }
+            unsigned int count = udp_receive_batch(states[s], batch);
+            for (unsigned int i = 0; s == 0 && i < count; i++) {
+                size_t length;
+                struct sockaddr_in from;
+                unsigned char * datagram = udp_receive_batch_get(batch, i, &length, &from);
+                unsigned int index;
+                memcpy(&index, datagram, 4);
+                if (length < 4 || from.sin_port != sender.sin_port || from.sin_addr.s_addr != sender.sin_addr.s_addr) {
+                    continue;
+                }
+                if (index == *in_order) {
+                    (*in_order)++;
+                }
+                received++;
+            }
+        }
+    }
+    return received;
+}
+
+/**
+ * @return 1 if a datagram waits on the socket itself
+ */
+static int socket_has_datagram(struct RastaUDPState * state) {
+    unsigned char byte;
+    return recv(state->file_descriptor, &byte, 1, MSG_DONTWAIT | MSG_PEEK) >= 0;
+}
+
+void test_udp_tcp_send_receive() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState dialer, acceptor;
+    struct sockaddr_in dialer_address = open_tcp_socket(&dialer, &tls_config, 0);
+    struct sockaddr_in acceptor_address = open_tcp_socket(&acceptor, &tls_config, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(dialer.tcp);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(acceptor.tcp);
+    CU_ASSERT_NOT_EQUAL(udp_receive_fd(&dialer), dialer.file_descriptor);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+
+    // the first datagram dials the stream, the datagrams wait for it and arrive in order
+    unsigned int in_order;
+    send_indexed(&dialer, acceptor_address, 0, 100, 4);
+    CU_ASSERT_EQUAL(pump(&acceptor, &dialer, dialer_address, &batch, &in_order), 100);
+    CU_ASSERT_EQUAL(in_order, 100);
+    CU_ASSERT_FALSE(socket_has_datagram(&acceptor));
+
+    // the answers take the accepted stream
+    send_indexed(&acceptor, dialer_address, 0, 100, 4);
+    CU_ASSERT_EQUAL(pump(&dialer, &acceptor, acceptor_address, &batch, &in_order), 100);
+    CU_ASSERT_EQUAL(in_order, 100);
+    CU_ASSERT_FALSE(socket_has_datagram(&dialer));
+    CU_ASSERT_EQUAL(dialer.tcp->stats.dialed, 1);
+    CU_ASSERT_EQUAL(acceptor.tcp->stats.dialed, 0);
+    CU_ASSERT_EQUAL(acceptor.tcp->stats.accepted, 1);
+    CU_ASSERT_EQUAL(acceptor.tcp->stream_count, 1);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&dialer);
+    udp_close(&acceptor);
+}
+
+void test_udp_tcp_buffer_full() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState dialer, acceptor;
+    struct sockaddr_in dialer_address = open_tcp_socket(&dialer, &tls_config, 0);
+    struct sockaddr_in acceptor_address = open_tcp_socket(&acceptor, &tls_config, 0);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 1024);
+
+    // the stream is not connected yet, the send buffer fills up behind the hello
+    unsigned int taken = (UDP_TCP_BUFFER_SIZE - UDP_TCP_FRAME_HEADER_SIZE - 2) / (UDP_TCP_FRAME_HEADER_SIZE + 1000);
+    for (unsigned int i = 0; i < taken + 10; i++) {
+        send_indexed(&dialer, acceptor_address, i, 1, 1000);
+    }
+    CU_ASSERT_EQUAL(dialer.tcp->stats.drops, 10);
+
+    unsigned int in_order;
+    CU_ASSERT_EQUAL(pump(&acceptor, &dialer, dialer_address, &batch, &in_order), taken);
+    CU_ASSERT_EQUAL(in_order, taken);
+
+    // longer datagrams than a stream holds are dropped right away
+    unsigned char too_long[UDP_TCP_BUFFER_SIZE];
+    memset(too_long, 0, sizeof(too_long));
+    udp_send_sockaddr(&dialer, too_long, sizeof(too_long), acceptor_address);
+    CU_ASSERT_EQUAL(dialer.tcp->stats.drops, 11);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&dialer);
+    udp_close(&acceptor);
+}
+
+void test_udp_tcp_peer_restart() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState dialer, acceptor;
+    struct sockaddr_in dialer_address = open_tcp_socket(&dialer, &tls_config, 0);
+    struct sockaddr_in acceptor_address = open_tcp_socket(&acceptor, &tls_config, 0);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+    unsigned int in_order;
+    send_indexed(&dialer, acceptor_address, 0, 10, 4);
+    CU_ASSERT_EQUAL(pump(&acceptor, &dialer, dialer_address, &batch, &in_order), 10);
+    CU_ASSERT_EQUAL(dialer.tcp->stream_count, 1);
+
+    // the dialer notices the closed stream
+    udp_close(&acceptor);
+    pump(&dialer, NULL, acceptor_address, &batch, &in_order);
+    CU_ASSERT_EQUAL(dialer.tcp->stream_count, 0);
+
+    // the restarted acceptor listens on the same address and gets a new stream
+    open_tcp_socket(&acceptor, &tls_config, ntohs(acceptor_address.sin_port));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(acceptor.tcp);
+    send_indexed(&dialer, acceptor_address, 0, 10, 4);
+    CU_ASSERT_EQUAL(pump(&acceptor, &dialer, dialer_address, &batch, &in_order), 10);
+    CU_ASSERT_EQUAL(in_order, 10);
+    CU_ASSERT_EQUAL(dialer.tcp->stats.dialed, 2);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&dialer);
+    udp_close(&acceptor);
+}
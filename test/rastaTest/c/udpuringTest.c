@@ -0,0 +1,143 @@
+#define _GNU_SOURCE // mmsghdr
+#include "udpuringTest.h"
+#include <CUnit/Basic.h>
+
+#ifdef ENABLE_IO_URING
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "udp.h"
+#include "udpuring.h"
+
+/**
+ * binds a socket on an ephemeral port of the loopback interface
+ * @param state the socket
+ * @param tls_config the disabled TLS options
+ * @return the address of the socket
+ */
+static struct sockaddr_in open_loopback_socket(struct RastaUDPState * state, const struct RastaConfigTLS * tls_config) {
+    udp_init(state, tls_config);
+    udp_bind_device(state, 0, "127.0.0.1");
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(state->file_descriptor, (struct sockaddr *) &address, &length);
+    return address;
+}
+
+/**
+ * sends @p count datagrams that carry their index with one batch
+ */
+static void send_indexed(struct RastaUDPState * sender, struct sockaddr_in receiver, unsigned int first,
+                         unsigned int count) {
+    unsigned char data[count][4];
+    unsigned char * messages[count];
+    size_t lengths[count];
+    struct sockaddr_in receivers[count];
+    for (unsigned int i = 0; i < count; i++) {
+        memcpy(data[i], &(unsigned int){first + i}, 4);
+        messages[i] = data[i];
+        lengths[i] = 4;
+        receivers[i] = receiver;
+    }
+    udp_send_batch(sender, messages, lengths, receivers, count);
+}
+
+/**
+ * receives datagrams until none arrives for 100 ms
+ * @param next the index of the next expected datagram, the datagrams have to arrive in order
+ * @return the amount of received datagrams in order
+ */
+static unsigned int receive_indexed(struct RastaUDPState * receiver, struct RastaUDPReceiveBatch * batch,
+                                    struct sockaddr_in sender, unsigned int next) {
+    unsigned int received = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(receiver), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        unsigned int count = udp_receive_batch(receiver, batch);
+        for (unsigned int i = 0; i < count; i++) {
+            size_t length;
+            struct sockaddr_in from;
+            unsigned char * datagram = udp_receive_batch_get(batch, i, &length, &from);
+            unsigned int index;
+            memcpy(&index, datagram, 4);
+            if (length == 4 && index == next + received && from.sin_port == sender.sin_port) {
+                received++;
+            }
+        }
+    }
+    return received;
+}
+
+void test_udp_uring_send_receive() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    struct sockaddr_in receiver_address = open_loopback_socket(&receiver, &tls_config);
+    struct sockaddr_in sender_address = open_loopback_socket(&sender, &tls_config);
+    if (receiver.uring == NULL) {
+        // the kernel does not support io_uring, the sockets use recvmmsg
+        udp_close(&receiver);
+        udp_close(&sender);
+        return;
+    }
+    CU_ASSERT_NOT_EQUAL(udp_receive_fd(&receiver), receiver.file_descriptor);
+    udp_enable_receive_timestamps(&receiver);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+
+    // more rounds than provided buffers, so the buffers have to be returned to the kernel
+    for (unsigned int round = 0; round < 3; round++) {
+        send_indexed(&sender, receiver_address, round * 100, 100);
+        CU_ASSERT_EQUAL(receive_indexed(&receiver, &batch, sender_address, round * 100), 100);
+    }
+
+    // the control messages are copied out of the provided buffers
+    send_indexed(&sender, receiver_address, 0, 1);
+    struct pollfd readable = { .fd = udp_receive_fd(&receiver), .events = POLLIN };
+    CU_ASSERT_EQUAL(poll(&readable, 1, 1000), 1);
+    CU_ASSERT_EQUAL(udp_receive_batch(&receiver, &batch), 1);
+    CU_ASSERT_NOT_EQUAL(udp_receive_batch_get_timestamp(&batch, 0), 0);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+void test_udp_uring_buffers_exhausted() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    struct sockaddr_in receiver_address = open_loopback_socket(&receiver, &tls_config);
+    struct sockaddr_in sender_address = open_loopback_socket(&sender, &tls_config);
+    if (receiver.uring == NULL) {
+        udp_close(&receiver);
+        udp_close(&sender);
+        return;
+    }
+    udp_receive_fd(&receiver);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+
+    // the sends are split, so the socket buffer never holds many datagrams that are not in a provided buffer yet
+    unsigned int total = UDP_URING_BUFFER_COUNT + 4;
+    for (unsigned int sent = 0; sent < total; sent += total / 4) {
+        send_indexed(&sender, receiver_address, sent, total / 4);
+    }
+    CU_ASSERT_EQUAL(receive_indexed(&receiver, &batch, sender_address, 0), total);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+#else
+
+void test_udp_uring_send_receive() {}
+
+void test_udp_uring_buffers_exhausted() {}
+
+#endif
@@ -0,0 +1,220 @@
+#define _GNU_SOURCE // mmsghdr
+#include "udpxdpTest.h"
+#include <CUnit/Basic.h>
+
+#ifdef ENABLE_AF_XDP
+#include <string.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/if_xdp.h>
+#include "udp.h"
+#include "udpxdp.h"
+
+/**
+ * binds a socket on an ephemeral port of the loopback interface
+ * @param state the socket
+ * @param tls_config the disabled TLS options
+ * @return the address of the socket
+ */
+static struct sockaddr_in open_loopback_socket(struct RastaUDPState * state, const struct RastaConfigTLS * tls_config) {
+    udp_init(state, tls_config);
+    udp_bind_device(state, 0, "127.0.0.1");
+
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    getsockname(state->file_descriptor, (struct sockaddr *) &address, &length);
+    return address;
+}
+
+/**
+ * sends @p count datagrams that carry their index with one batch
+ */
+static void send_indexed(struct RastaUDPState * sender, struct sockaddr_in receiver, unsigned int first,
+                         unsigned int count) {
+    unsigned char data[count][64];
+    unsigned char * messages[count];
+    size_t lengths[count];
+    struct sockaddr_in receivers[count];
+    for (unsigned int i = 0; i < count; i++) {
+        memset(data[i], (int) (first + i), sizeof(data[i]));
+        memcpy(data[i], &(unsigned int){first + i}, 4);
+        messages[i] = data[i];
+        // odd lengths, so the checksums cover a padded last byte as well
+        lengths[i] = 5 + i;
+        receivers[i] = receiver;
+    }
+    udp_send_batch(sender, messages, lengths, receivers, count);
+}
+
+/**
+ * receives datagrams until none arrives for 100 ms
+ * @param next the index of the next expected datagram, the datagrams have to arrive in order
+ * @return the amount of received datagrams in order
+ */
+static unsigned int receive_indexed(struct RastaUDPState * receiver, struct RastaUDPReceiveBatch * batch,
+                                    struct sockaddr_in sender, unsigned int next) {
+    unsigned int received = 0;
+    struct pollfd readable = { .fd = udp_receive_fd(receiver), .events = POLLIN };
+    while (poll(&readable, 1, 100) > 0) {
+        unsigned int count = udp_receive_batch(receiver, batch);
+        for (unsigned int i = 0; i < count; i++) {
+            size_t length;
+            struct sockaddr_in from;
+            unsigned char * datagram = udp_receive_batch_get(batch, i, &length, &from);
+            unsigned int index;
+            memcpy(&index, datagram, 4);
+            if (length == 5 + received && index == next + received &&
+                from.sin_port == sender.sin_port && from.sin_addr.s_addr == sender.sin_addr.s_addr &&
+                datagram[length - 1] == (unsigned char) index) {
+                received++;
+            }
+        }
+    }
+    return received;
+}
+
+void test_udp_xdp_send_receive() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    struct sockaddr_in receiver_address = open_loopback_socket(&receiver, &tls_config);
+    struct sockaddr_in sender_address = open_loopback_socket(&sender, &tls_config);
+    udp_enable_xdp(&receiver, "lo", 0);
+    if (receiver.xdp == NULL) {
+        // no CAP_NET_ADMIN or CAP_BPF, or the kernel does not support AF_XDP
+        udp_close(&receiver);
+        udp_close(&sender);
+        return;
+    }
+    CU_ASSERT_NOT_EQUAL(udp_receive_fd(&receiver), receiver.file_descriptor);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+
+    // the frames of every batch are given back to the kernel, so more rounds than frames have to pass
+    for (unsigned int round = 0; round < 3; round++) {
+        send_indexed(&sender, receiver_address, 0, 40);
+        CU_ASSERT_EQUAL(receive_indexed(&receiver, &batch, sender_address, 0), 40);
+    }
+    CU_ASSERT_EQUAL(receiver.xdp->received, 120);
+    CU_ASSERT_EQUAL(receiver.xdp->dropped, 0);
+
+    // the kernel would drop frames from 127.0.0.1 that come out of the TX ring, so the replies take the socket
+    send_indexed(&receiver, sender_address, 0, 40);
+    CU_ASSERT_EQUAL(receiver.xdp->sent, 0);
+    CU_ASSERT_EQUAL(receive_indexed(&sender, &batch, receiver_address, 0), 40);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+/**
+ * @return the folded ones' complement sum of @p length bytes
+ */
+static uint16_t fold_checksum(uint32_t sum, const unsigned char * data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        sum += i % 2 == 0 ? (uint32_t) data[i] << 8 : data[i];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t) sum;
+}
+
+void test_udp_xdp_frame() {
+    // only the parts of the backend that a push touches, no socket is needed
+    struct udp_xdp * xdp = calloc(1, sizeof(struct udp_xdp));
+    xdp->umem_size = 2 * UDP_XDP_FRAMES * UDP_XDP_FRAME_SIZE;
+    xdp->umem = calloc(1, xdp->umem_size);
+    struct xdp_desc descriptors[UDP_XDP_FRAMES];
+    uint32_t producer = 0;
+    xdp->tx.descriptors = descriptors;
+    xdp->tx.producer = &producer;
+    xdp->tx.mask = UDP_XDP_FRAMES - 1;
+    xdp->free_frames[0] = (uint64_t) UDP_XDP_FRAMES * UDP_XDP_FRAME_SIZE;
+    xdp->free_count = 1;
+    xdp->mtu = 1500;
+    xdp->address.sin_addr.s_addr = inet_addr("10.0.0.1");
+    xdp->address.sin_port = htons(8888);
+    memcpy(xdp->link_address, "\x02\x00\x00\x00\x00\x01", 6);
+
+    struct sockaddr_in receiver;
+    memset(&receiver, 0, sizeof(receiver));
+    receiver.sin_addr.s_addr = inet_addr("10.0.0.2");
+    receiver.sin_port = htons(9999);
+    unsigned char message[] = "odd length";
+
+    // the link layer address of the receiver is not known yet
+    CU_ASSERT_EQUAL(udp_xdp_push(xdp, message, sizeof(message) - 1, &receiver), 0);
+    xdp->neighbours[0].address = receiver.sin_addr.s_addr;
+    memcpy(xdp->neighbours[0].link_address, "\x02\x00\x00\x00\x00\x02", 6);
+    xdp->neighbour_count = 1;
+    CU_ASSERT_EQUAL(udp_xdp_push(xdp, message, sizeof(message) - 1, &receiver), 1);
+    CU_ASSERT_EQUAL(xdp->tx_pending, 1);
+    // all frames are in use and the completion ring is empty
+    uint32_t completion_producer = 0, completion_consumer = 0;
+    xdp->completion.producer = &completion_producer;
+    xdp->completion.consumer = &completion_consumer;
+    CU_ASSERT_EQUAL(udp_xdp_push(xdp, message, sizeof(message) - 1, &receiver), 0);
+
+    size_t data_length = sizeof(message) - 1;
+    CU_ASSERT_EQUAL(descriptors[0].addr, (uint64_t) UDP_XDP_FRAMES * UDP_XDP_FRAME_SIZE);
+    CU_ASSERT_EQUAL(descriptors[0].len, 42 + data_length);
+    unsigned char * frame = xdp->umem + descriptors[0].addr;
+    CU_ASSERT_EQUAL(memcmp(frame, "\x02\x00\x00\x00\x00\x02\x02\x00\x00\x00\x00\x01\x08\x00", 14), 0);
+
+    // a header with a valid checksum sums up to 0xffff
+    unsigned char * ip = frame + 14;
+    CU_ASSERT_EQUAL(ip[0], 0x45);
+    CU_ASSERT_EQUAL(ip[9], IPPROTO_UDP);
+    CU_ASSERT_EQUAL((ip[2] << 8 | ip[3]), 28 + data_length);
+    CU_ASSERT_EQUAL(memcmp(ip + 12, &xdp->address.sin_addr.s_addr, 4), 0);
+    CU_ASSERT_EQUAL(memcmp(ip + 16, &receiver.sin_addr.s_addr, 4), 0);
+    CU_ASSERT_EQUAL(fold_checksum(0, ip, 20), 0xffff);
+
+    unsigned char * udp = ip + 20;
+    size_t udp_length = 8 + data_length;
+    CU_ASSERT_EQUAL(memcmp(udp, &xdp->address.sin_port, 2), 0);
+    CU_ASSERT_EQUAL(memcmp(udp + 2, &receiver.sin_port, 2), 0);
+    CU_ASSERT_EQUAL((udp[4] << 8 | udp[5]), udp_length);
+    uint32_t pseudo_header = fold_checksum(0, ip + 12, 8) + IPPROTO_UDP + (uint32_t) udp_length;
+    CU_ASSERT_EQUAL(fold_checksum(pseudo_header, udp, udp_length), 0xffff);
+    CU_ASSERT_EQUAL(memcmp(udp + 8, message, data_length), 0);
+
+    free(xdp->umem);
+    free(xdp);
+}
+
+void test_udp_xdp_fallback() {
+    struct RastaConfigTLS tls_config;
+    memset(&tls_config, 0, sizeof(tls_config));
+
+    struct RastaUDPState receiver, sender;
+    struct sockaddr_in receiver_address = open_loopback_socket(&receiver, &tls_config);
+    struct sockaddr_in sender_address = open_loopback_socket(&sender, &tls_config);
+    udp_enable_xdp(&receiver, "rasta_none", 0);
+    CU_ASSERT_PTR_NULL(receiver.xdp);
+
+    struct RastaUDPReceiveBatch batch;
+    udp_receive_batch_init(&batch, UDP_RECEIVE_BATCH_SIZE, 64);
+    send_indexed(&sender, receiver_address, 0, 20);
+    CU_ASSERT_EQUAL(receive_indexed(&receiver, &batch, sender_address, 0), 20);
+
+    udp_receive_batch_free(&batch);
+    udp_close(&receiver);
+    udp_close(&sender);
+}
+
+#else
+
+void test_udp_xdp_send_receive() {}
+
+void test_udp_xdp_frame() {}
+
+void test_udp_xdp_fallback() {}
+
+#endif
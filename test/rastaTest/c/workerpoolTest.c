@@ -0,0 +1,125 @@
+#include <CUnit/Basic.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "../headers/workerpoolTest.h"
+#include "workerpool.h"
+
+struct test_job {
+    struct worker_pool * pool;
+    pthread_t work_thread;
+    atomic_int started;
+    atomic_int release;
+    int completed;
+    int cancelled;
+};
+
+static void record_work(void * carry_data) {
+    struct test_job * job = carry_data;
+    job->work_thread = pthread_self();
+}
+
+static void blocking_work(void * carry_data) {
+    struct test_job * job = carry_data;
+    atomic_store(&job->started, 1);
+    while (!atomic_load(&job->release)) {
+        sched_yield();
+    }
+}
+
+static void stopping_work(void * carry_data) {
+    struct test_job * job = carry_data;
+    atomic_store(&job->started, 1);
+    // returns after worker_pool_destroy() was called
+    int stopping = 0;
+    while (!stopping) {
+        sched_yield();
+        pthread_mutex_lock(&job->pool->lock);
+        stopping = job->pool->stopping;
+        pthread_mutex_unlock(&job->pool->lock);
+    }
+}
+
+static void count_completion(void * carry_data, int cancelled) {
+    struct test_job * job = carry_data;
+    job->completed++;
+    job->cancelled += cancelled;
+}
+
+static void wait_for_completions(struct worker_pool * pool) {
+    struct pollfd notification = { .fd = pool->notify_fd, .events = POLLIN };
+    CU_ASSERT_EQUAL_FATAL(poll(&notification, 1, 5000), 1);
+    worker_pool_complete(pool);
+}
+
+void test_worker_pool_complete() {
+    struct worker_pool pool;
+    struct test_job jobs[4] = {0};
+    worker_pool_init(&pool, 2, 4);
+
+    for (int i = 0; i < 4; i++) {
+        CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &jobs[i]), 1);
+    }
+    CU_ASSERT_EQUAL(pool.pending, 4);
+
+    while (pool.pending > 0) {
+        wait_for_completions(&pool);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        CU_ASSERT_EQUAL(jobs[i].completed, 1);
+        CU_ASSERT_EQUAL(jobs[i].cancelled, 0);
+        CU_ASSERT(!pthread_equal(jobs[i].work_thread, pthread_self()));
+    }
+
+    worker_pool_destroy(&pool);
+}
+
+void test_worker_pool_limit() {
+    struct worker_pool pool;
+    struct test_job first = {0};
+    struct test_job second = {0};
+    worker_pool_init(&pool, 1, 2);
+
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, blocking_work, count_completion, &first), 1);
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &second), 1);
+    // both slots are taken
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &second), 0);
+
+    atomic_store(&first.release, 1);
+    while (pool.pending > 0) {
+        wait_for_completions(&pool);
+    }
+    CU_ASSERT_EQUAL(first.completed, 1);
+    CU_ASSERT_EQUAL(second.completed, 1);
+
+    // the slots can be used again
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &second), 1);
+    wait_for_completions(&pool);
+    CU_ASSERT_EQUAL(second.completed, 2);
+
+    worker_pool_destroy(&pool);
+}
+
+void test_worker_pool_destroy() {
+    struct worker_pool pool;
+    struct test_job running = {0};
+    struct test_job queued = {0};
+    worker_pool_init(&pool, 1, 3);
+    running.pool = &pool;
+
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, stopping_work, count_completion, &running), 1);
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &queued), 1);
+    CU_ASSERT_EQUAL(worker_pool_submit(&pool, record_work, count_completion, &queued), 1);
+    while (!atomic_load(&running.started)) {
+        sched_yield();
+    }
+
+    worker_pool_destroy(&pool);
+
+    CU_ASSERT_EQUAL(running.completed, 1);
+    CU_ASSERT_EQUAL(running.cancelled, 0);
+    CU_ASSERT_EQUAL(queued.completed, 2);
+    CU_ASSERT_EQUAL(queued.cancelled, 2);
+    CU_ASSERT_EQUAL(pool.pending, 0);
+}
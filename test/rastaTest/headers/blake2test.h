@@ -3,4 +3,6 @@
 
 void testBlake2Hash();
 
+void testBlake2bMulti();
+
 #endif //RASTA_BLAKE2TEST_H
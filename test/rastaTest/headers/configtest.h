@@ -8,4 +8,9 @@
 void check_std_config();
 void check_var_config();
 
+/**
+ * test if a snapshot of a config is loaded with the same values and a corrupted snapshot is rejected
+ */
+void check_config_snapshot();
+
 #endif //LST_SIMULATOR_CONFIGTEST_H
@@ -7,4 +7,14 @@
 
 void testDictionary();
 
+/**
+ * test if a dictionary with many keys finds them in any case after its index grew
+ */
+void testDictionaryManyKeys();
+
+/**
+ * test if a dictionary on borrowed entries finds their values and arrays and does not free them
+ */
+void testDictionaryMap();
+
 #endif //LST_SIMULATOR_DICTIONARYTEST_H
@@ -0,0 +1,63 @@
+#ifndef LST_SIMULATOR_EVENTSYSTEMTEST_H
+#define LST_SIMULATOR_EVENTSYSTEMTEST_H
+
+/**
+ * test if timed events are called in the order of their deadlines
+ */
+void test_event_system_timed_event_order();
+
+/**
+ * test if disabled timed events are not called
+ */
+void test_event_system_disabled_timed_event();
+
+/**
+ * test if a timed event can remove itself in its callback
+ */
+void test_event_system_remove_in_callback();
+
+/**
+ * test if the profile of an event system counts and measures the calls of every callback
+ */
+void test_event_system_profile();
+
+/**
+ * test if the callbacks of an iteration of the event loop read the same time
+ */
+void test_event_system_loop_time();
+
+/**
+ * test if a busy polling loop handles fd events and fires the timed events when they are due, and if the pinned thread
+ * gets its CPUs back afterwards
+ */
+void test_event_system_busy_poll();
+
+/**
+ * test if a real-time loop reports the scheduling policy, CPU and memory lock it runs with, and if the thread gets its
+ * previous policy and CPUs back afterwards
+ */
+void test_event_system_realtime();
+
+/**
+ * test if the tasks that several threads post to a running loop all run, in the order of each thread, and if a task
+ * can stop the loop
+ */
+void test_event_system_post();
+
+/**
+ * test if a wakeup runs at most EV_TASK_BATCH posted tasks and if a task is refused by a full queue or before posting
+ * is enabled
+ */
+void test_event_system_post_batch();
+
+/**
+ * test if a loop on a virtual clock fires the timed events of a day without sleeping, each at the time it was due
+ */
+void test_event_system_virtual_time();
+
+/**
+ * test if a loop on a virtual clock handles a ready fd event before the time jumps to the next timed event
+ */
+void test_event_system_virtual_time_fd();
+
+#endif //LST_SIMULATOR_EVENTSYSTEMTEST_H
@@ -5,4 +5,19 @@ void test_push();
 
 void test_pop();
 
+/**
+ * test if the order is kept when the elements move over the end of the ring
+ */
+void test_fifo_wrap_around();
+
+/**
+ * test if the order is kept when the counters wrap around and the capacity is not a power of 2
+ */
+void test_fifo_counter_wrap();
+
+/**
+ * test if one thread can push while another one pops
+ */
+void test_fifo_spsc();
+
 #endif //LST_SIMULATOR_FIFOTEST_H
@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_LOGGINGTEST_H
+#define LST_SIMULATOR_LOGGINGTEST_H
+
+/**
+ * test if an asynchronous logger writes all messages to its file before it is destroyed
+ */
+void test_logger_async_file();
+
+/**
+ * test if an asynchronous logger counts the messages that did not fit into its ring
+ */
+void test_logger_async_dropped();
+
+/**
+ * test if the arguments of filtered log messages are not evaluated
+ */
+void test_logger_level_check();
+
+#endif //LST_SIMULATOR_LOGGINGTEST_H
@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_MPSCQUEUETEST_H
+#define LST_SIMULATOR_MPSCQUEUETEST_H
+
+/**
+ * test if elements are taken out in the order they were committed and a full queue rejects new elements
+ */
+void test_mpsc_queue_order();
+
+/**
+ * test if an element that is reserved but not committed yet blocks the elements behind it
+ */
+void test_mpsc_queue_uncommitted();
+
+/**
+ * test if several threads can add elements while another one takes them out
+ */
+void test_mpsc_queue_threads();
+
+#endif //LST_SIMULATOR_MPSCQUEUETEST_H
@@ -1,8 +1,13 @@
-//
-// Created by erica on 04/07/2022.
-//
-
-#ifndef RASTA_OPAQUETEST_H
-#define RASTA_OPAQUETEST_H
-void opaque_wrapper_test();
-#endif //RASTA_OPAQUETEST_H
+//
+// Created by erica on 04/07/2022.
+//
+
+#ifndef RASTA_OPAQUETEST_H
+#define RASTA_OPAQUETEST_H
+void opaque_wrapper_test();
+
+/**
+ * test if the user records of a pair of RaSTA IDs are reused and the client secrets are lent from the locked pool
+ */
+void opaque_secrets_test();
+#endif //RASTA_OPAQUETEST_H
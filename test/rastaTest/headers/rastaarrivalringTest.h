@@ -0,0 +1,14 @@
+#ifndef LST_SIMULATOR_RASTAARRIVALRINGTEST_H
+#define LST_SIMULATOR_RASTAARRIVALRINGTEST_H
+
+/**
+ * test if arrivals are found by their sequence number until they are overwritten or a new window starts
+ */
+void test_arrival_ring_put_get();
+
+/**
+ * test if the arrivals of the current window are kept when the ring is resized
+ */
+void test_arrival_ring_resize();
+
+#endif //LST_SIMULATOR_RASTAARRIVALRINGTEST_H
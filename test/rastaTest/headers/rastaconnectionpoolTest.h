@@ -0,0 +1,29 @@
+#ifndef LST_SIMULATOR_RASTACONNECTIONPOOLTEST_H
+#define LST_SIMULATOR_RASTACONNECTIONPOOLTEST_H
+
+/**
+ * test if the slots of a limited pool are handed out once, refused when all are in use and reused after a release
+ */
+void test_connection_pool_slab();
+
+/**
+ * test if the queues carved from a slot have the sizes of the sending configuration and do not overlap
+ */
+void test_connection_pool_layout();
+
+/**
+ * test if a pool without limit allocates every slot on its own
+ */
+void test_connection_pool_on_demand();
+
+/**
+ * test if the slots hold zeroed residency histograms behind the retransmission buffer only when asked for
+ */
+void test_connection_pool_residency();
+
+/**
+ * test if the slots hold a flight recorder ring of the configured size only when asked for
+ */
+void test_connection_pool_flight_records();
+
+#endif //LST_SIMULATOR_RASTACONNECTIONPOOLTEST_H
@@ -8,4 +8,19 @@ void test_opt_e();
 
 void test_without_gen_table();
 
+/**
+ * test if processing 8 bytes at a time results in the same checksums as processing single bytes
+ */
+void test_slicing_matches_bytewise();
+
+/**
+ * test if the precomputed tables of the standard options match the tables generated at runtime
+ */
+void test_precomputed_tables();
+
+/**
+ * test if a crc over data that is added piece by piece is the same as the one over all data
+ */
+void test_crc_incremental();
+
 #endif //LST_SIMULATOR_RASTACRCTEST_H
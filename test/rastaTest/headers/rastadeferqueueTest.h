@@ -71,6 +71,26 @@ void test_deferqueue_get_ts();
  */
 void test_deferqueue_get_ts_doesnt_contain();
 
+/**
+ * test a queue with many elements whose sequence numbers share table slots
+ */
+void test_deferqueue_large();
+
+/**
+ * test if removed and cleared elements can be used again
+ */
+void test_deferqueue_reuse();
+
+/**
+ * test if taking an element returns it and removes it from the queue
+ */
+void test_deferqueue_take();
+
+/**
+ * test if a resized queue keeps its elements in time order and refuses to shrink below them
+ */
+void test_deferqueue_resize();
+
 
 
 #endif //LST_SIMULATOR_RASTADEFERQUEUETEST_H
@@ -0,0 +1,24 @@
+#ifndef LST_SIMULATOR_RASTAEXECUTORTEST_H
+#define LST_SIMULATOR_RASTAEXECUTORTEST_H
+
+/**
+ * test if the queued callbacks run in the order they were submitted, only when a consumer runs them
+ */
+void test_callback_executor_order();
+
+/**
+ * test if a full queue runs the oldest callbacks on the submitting thread and keeps the order
+ */
+void test_callback_executor_overflow();
+
+/**
+ * test if the thread of the executor runs the callbacks
+ */
+void test_callback_executor_thread();
+
+/**
+ * test if the state changes of a connection are merged while its notification is queued
+ */
+void test_callback_executor_state_coalescing();
+
+#endif //LST_SIMULATOR_RASTAEXECUTORTEST_H
@@ -31,4 +31,9 @@ void checkDisconnectionRequest();
  */
 void checkMessagePacket();
 
+/**
+ * tests the iteration over the application messages of a data message
+ */
+void checkMessageIterator();
+
 #endif //LST_SIMULATOR_RASTAFACTORYTEST_H
@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_RASTAFLIGHTRECORDERTEST_H
+#define LST_SIMULATOR_RASTAFLIGHTRECORDERTEST_H
+
+/**
+ * test if the records overwrite the oldest ones and are written oldest first, relative to the time of the dump
+ */
+void test_flight_recorder_ring();
+
+/**
+ * test if a dump writes a file, empties the ring and writes nothing while nothing was recorded
+ */
+void test_flight_recorder_dump();
+
+/**
+ * test if only wrong safety codes within the window trigger a dump
+ */
+void test_flight_recorder_safety_errors();
+
+#endif //LST_SIMULATOR_RASTAFLIGHTRECORDERTEST_H
@@ -0,0 +1,14 @@
+#ifndef LST_SIMULATOR_RASTAIDINDEXTEST_H
+#define LST_SIMULATOR_RASTAIDINDEXTEST_H
+
+/**
+ * test if elements are found by their id and replaced by a put with the same id
+ */
+void test_id_index_put_get();
+
+/**
+ * test if the remaining elements are still found after elements were removed
+ */
+void test_id_index_remove();
+
+#endif //LST_SIMULATOR_RASTAIDINDEXTEST_H
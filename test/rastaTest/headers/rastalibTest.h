@@ -0,0 +1,55 @@
+#ifndef LST_SIMULATOR_RASTALIBTEST_H
+#define LST_SIMULATOR_RASTALIBTEST_H
+
+/**
+ * test if the connections are spread over the shards by the remote RaSTA ID
+ */
+void test_rasta_lib_shard_index();
+
+/**
+ * test if the transport channels of a remote shard use the ports of that shard
+ */
+void test_rasta_lib_shard_channels();
+
+/**
+ * test if the notifications are called with the live connection
+ */
+void test_notification_live_connection();
+
+/**
+ * test if the received messages are taken from a connection in bulk and in order
+ */
+void test_receive_bulk();
+
+/**
+ * test if the received messages are counted in the diagnostic sub interval of their round trip delay
+ */
+void test_diagnostic_record();
+
+/**
+ * test if a diagnostic notification is fired once per window with the counts of all messages of the window
+ */
+void test_diagnostic_window();
+
+/**
+ * test if the reconnect delay doubles up to its maximum and is shortened by a random jitter
+ */
+void test_reconnect_delay();
+
+/**
+ * test if a wave of a bulk connect is limited by its size and by the handshakes that are not finished
+ */
+void test_connect_wave_size();
+
+/**
+ * test if the send queue takes the buffers of owned messages without copying them and copies the other messages
+ */
+void test_send_owned();
+
+/**
+ * test if urgent messages lead the next data packet before the bulk messages queued earlier, if the wait of both classes
+ * is recorded and if a full urgent lane rejects messages
+ */
+void test_send_priority();
+
+#endif //LST_SIMULATOR_RASTALIBTEST_H
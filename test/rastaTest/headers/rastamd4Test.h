@@ -9,4 +9,36 @@ void testMD4function();
 
 void testRastaMD4Sample();
 
+void testRastaHashingContextMD4();
+
+/**
+ * test if adding the data to a hash piece by piece gives the same hash as hashing all data at once
+ */
+void testRastaHashIncremental();
+
+/**
+ * test if the states that are prepared from a new key give the hashes of the key, also for empty messages and batches
+ */
+void testRastaHashPreparedKey();
+
+/**
+ * test if hashing multiple messages at once gives the same hashes as hashing them one by one
+ */
+void testMD4MultiBuffer();
+
+/**
+ * test if checking the safety codes of multiple messages detects the incorrect ones
+ */
+void testRastaHashVerifyBatch();
+
+/**
+ * test if the specialized hash functions give the same hashes as the incremental calculation for all parameters
+ */
+void testRastaHashSelect();
+
+/**
+ * test if the hash of data at an unaligned address is the hash of the same data at an aligned address
+ */
+void testMD4Unaligned();
+
 #endif //LST_SIMULATOR_RASTAMD4TEST_H
@@ -0,0 +1,29 @@
+#ifndef LST_SIMULATOR_RASTAMETRICSTEST_H
+#define LST_SIMULATOR_RASTAMETRICSTEST_H
+
+/**
+ * test if recorded values are counted in the bucket that contains them
+ */
+void test_rasta_histogram_buckets();
+
+/**
+ * test if the percentiles of a histogram are estimated within the precision of its buckets
+ */
+void test_rasta_histogram_percentile();
+
+/**
+ * test if the batches of the stages of the receive path are counted per stage
+ */
+void test_receive_stage_metrics();
+
+/**
+ * test if the ranking of the peers keeps the most expensive ones in order
+ */
+void test_peer_ranking();
+
+/**
+ * test if the residency of the messages is recorded per stage and only the stages of a snapshot are copied
+ */
+void test_residency_metrics();
+
+#endif //LST_SIMULATOR_RASTAMETRICSTEST_H
@@ -22,4 +22,32 @@ void testRedundancyConversionWithoutChecksum();
  */
 void testRedundancyConversionIncorrectChecksum();
 
+/**
+ * test if decoding a redundancy packet into a view keeps pointing into the buffer and checks both checksums
+ */
+void testRedundancyConversionView();
+
+/**
+ * test if encoding into a caller provided buffer produces the same PDU as the allocating conversion
+ */
+void testRedundancyPacketEncode();
+
+void testPacketRestampAndWrap();
+
+/**
+ * test if decoding multiple redundancy packets at once gives the same views as decoding them one by one
+ */
+void testRedundancyConversionViewBatch();
+
+/**
+ * test if the safety code and the CRC checksum that are calculated in one pass over a long packet match the ones
+ * that are calculated separately, for all algorithms
+ */
+void testRedundancyPacketFusedChecksums();
+
+/**
+ * test if the encoded PDUs match the layout of rastawire.h byte for byte
+ */
+void testWireLayout();
+
 #endif //LST_SIMULATOR_RASTAMODULETEST_H
@@ -0,0 +1,16 @@
+#ifndef LST_SIMULATOR_RASTAREPLICATIONTEST_H
+#define LST_SIMULATOR_RASTAREPLICATIONTEST_H
+
+/**
+ * test if a replica and the PDUs of its retransmission buffer are decoded as they were encoded, and if truncated
+ * records are refused
+ */
+void test_replica_encode_decode();
+
+/**
+ * test if a standby keeps the latest record of every connection a primary sends over the stream, and handles
+ * REMOVE, RESET and ROUND records
+ */
+void test_replication_stream();
+
+#endif //LST_SIMULATOR_RASTAREPLICATIONTEST_H
@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_RASTARETRBUFFERTEST_H
+#define LST_SIMULATOR_RASTARETRBUFFERTEST_H
+
+/**
+ * test if adding and confirming PDUs works, also when the ring wraps around
+ */
+void test_retrbuffer_add_confirm();
+
+/**
+ * test if confirming works when the sequence numbers overflow
+ */
+void test_retrbuffer_confirm_overflow();
+
+/**
+ * test if the buffer is empty after calling clear
+ */
+void test_retrbuffer_clear();
+
+#endif //LST_SIMULATOR_RASTARETRBUFFERTEST_H
@@ -0,0 +1,24 @@
+#ifndef LST_SIMULATOR_RASTASTATPAGETEST_H
+#define LST_SIMULATOR_RASTASTATPAGETEST_H
+
+/**
+ * test if a reader of a stat page takes the values of the last publication and sees when the entity closed the page
+ */
+void test_stat_page_publish();
+
+/**
+ * test if a reader does not take a copy while a publication is running
+ */
+void test_stat_page_seqlock();
+
+/**
+ * test if a page replaces the old one without disturbing its readers and if other files are rejected
+ */
+void test_stat_page_replace();
+
+/**
+ * test if a copy of a page is written with the names of the metrics endpoint
+ */
+void test_stat_page_prometheus();
+
+#endif //LST_SIMULATOR_RASTASTATPAGETEST_H
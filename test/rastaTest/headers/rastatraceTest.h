@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_RASTATRACETEST_H
+#define LST_SIMULATOR_RASTATRACETEST_H
+
+/**
+ * test if the records of a trace are written into the ring of the trace file and overwrite the oldest ones
+ */
+void test_rasta_trace_ring();
+
+/**
+ * test if a trace file is continued when it is opened again with the same capacity and cleared otherwise
+ */
+void test_rasta_trace_reopen();
+
+/**
+ * test if a record is rendered like a message of the text log
+ */
+void test_rasta_trace_render();
+
+#endif //LST_SIMULATOR_RASTATRACETEST_H
@@ -0,0 +1,130 @@
+#ifndef LST_SIMULATOR_REDMUXTEST_H
+#define LST_SIMULATOR_REDMUXTEST_H
+
+/**
+ * test if redundancy channels are found by their id while channels are added
+ */
+void test_redundancy_mux_get_channel();
+
+/**
+ * test if the remaining redundancy channels are still found after channels were removed
+ */
+void test_redundancy_mux_remove_channel();
+
+/**
+ * test if a redundancy channel passes the decoded SR layer PDUs to the next layer in sequence order
+ */
+void test_redundancy_channel_deliver_decoded();
+void test_redundancy_channel_early_duplicate();
+void test_redundancy_packet_peek();
+
+/**
+ * test if the diagnosis windows of all transport channels are ended together and start empty again
+ */
+void test_redundancy_mux_diagnose();
+
+/**
+ * test if the defer timer of a channel gives up a lost PDU after T_SEQ and delivers the deferred ones
+ */
+void test_redundancy_mux_defer_timeout();
+
+/**
+ * test if the defer timeout adapts to the skew between the transport channels of a diagnose window, and if it stays
+ * at T_SEQ without enough delays, without the extension or for a skew larger than T_SEQ
+ */
+void test_redundancy_adaptive_defer_timeout();
+
+/**
+ * test if the transport channels are identified by their packed address and port
+ */
+void test_transport_channel_endpoint();
+
+/**
+ * test if the datagrams of a socket with receive timestamps are stamped with the time the kernel received them
+ */
+void test_udp_receive_timestamps();
+
+/**
+ * test if the datagrams the kernel dropped because the receive buffer was full are counted
+ */
+void test_udp_kernel_drops();
+
+/**
+ * test if a writable socket sends the datagrams in order without queueing them
+ */
+void test_udp_transmit_queue();
+
+/**
+ * test if bursts of equal datagrams are sent with UDP_SEGMENT and the coalesced datagrams are split on receive,
+ * in order and across batches
+ */
+void test_udp_offload();
+
+/**
+ * test if the datagrams are steered to the sockets of a SO_REUSEPORT group by the id in the datagram
+ */
+void test_udp_reuseport_steering();
+
+/**
+ * test if the PDUs received on sockets that are shared by two entities are handed to the entity they are addressed to
+ */
+void test_redundancy_mux_shared_sockets();
+void test_redundancy_mux_pending_channels();
+
+/**
+ * test if the redundancy layer parameters of open channels are changed and their deferred PDUs are kept
+ */
+void test_redundancy_mux_reconfigure();
+
+/**
+ * test if the heartbeats that are due within the heartbeat tick are sent together with the one that fired
+ */
+void test_heartbeat_batch();
+
+/**
+ * test if a connection that waits for the credit of a paced retransmission sends its next retransmitted data packet
+ * when its heartbeat is due
+ */
+void test_heartbeat_paced_retransmission();
+
+/**
+ * test if the connections take turns in the send handler when the send budget does not cover all of them, and if
+ * the time they waited for their turn is recorded
+ */
+void test_send_budget();
+
+/**
+ * test if the confirmations are held back while the receive queue has no room for another send window, and sent with
+ * a heartbeat once the application retrieved its messages
+ */
+void test_receive_backpressure();
+
+/**
+ * test if all connections that are not closed get their disconnection requests with one batch and are handed back
+ */
+void test_disconnect_all();
+
+/**
+ * test if a bulk connect sends its connection requests in paced waves, counts refused and existing connections and
+ * notifies once when every peer is connected or failed
+ */
+void test_bulk_connect();
+
+/**
+ * test if waiting for an unknown entity receives from the sockets until it is discovered
+ */
+void test_redundancy_mux_wait_for_entity();
+
+/**
+ * test if the transport channels a server discovers out of order are sent and received on the socket they were
+ * discovered on, and if the traffic of every socket is counted
+ */
+void test_redundancy_mux_paths();
+
+/**
+ * test if a copy of a delivered PDU with a damaged CRC checksum is counted as a checksum error on its transport
+ * channel and not as a received copy
+ */
+void test_redundancy_mux_damaged_duplicate();
+
+#endif //LST_SIMULATOR_REDMUXTEST_H
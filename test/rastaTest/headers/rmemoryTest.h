@@ -0,0 +1,34 @@
+#ifndef LST_SIMULATOR_RMEMORYTEST_H
+#define LST_SIMULATOR_RMEMORYTEST_H
+
+/**
+ * test if allocating and freeing pooled blocks takes no memory from the system once the pools are filled
+ */
+void test_rmemory_steady_state();
+
+/**
+ * test if rrealloc keeps the content when a block grows into another size class and beyond the pools
+ */
+void test_rmemory_realloc();
+
+/**
+ * test if the statistics count every allocation and free
+ */
+void test_rmemory_stats();
+
+/**
+ * test if the allocations are counted to the subsystem that made them
+ */
+void test_rmemory_subsystem_stats();
+
+/**
+ * test if a thread with a placement maps its slabs and its large blocks and gives the large blocks back
+ */
+void test_rmemory_placement();
+
+/**
+ * test if the system allocations after rmemory_seal() are counted and if the static memory reuses freed blocks
+ */
+void test_rmemory_seal();
+
+#endif //LST_SIMULATOR_RMEMORYTEST_H
@@ -0,0 +1,14 @@
+#ifndef LST_SIMULATOR_UDPIMPAIRMENTTEST_H
+#define LST_SIMULATOR_UDPIMPAIRMENTTEST_H
+
+/**
+ * test if the same seed drops and duplicates the same datagrams
+ */
+void test_udp_impairment_seed();
+
+/**
+ * test if delayed datagrams are received after their delay
+ */
+void test_udp_impairment_delay();
+
+#endif //LST_SIMULATOR_UDPIMPAIRMENTTEST_H
@@ -0,0 +1,20 @@
+#ifndef LST_SIMULATOR_UDPSHMTEST_H
+#define LST_SIMULATOR_UDPSHMTEST_H
+
+/**
+ * test if two sockets that use the same name exchange their datagrams in order through shared memory and keep using
+ * UDP for other sockets
+ */
+void test_udp_shm_send_receive();
+
+/**
+ * test if the datagrams that do not fit into a full ring are sent on the socket instead
+ */
+void test_udp_shm_ring_full();
+
+/**
+ * test if a closed peer is detached and the remaining socket meets a new one
+ */
+void test_udp_shm_peer_restart();
+
+#endif //LST_SIMULATOR_UDPSHMTEST_H
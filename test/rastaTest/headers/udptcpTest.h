@@ -0,0 +1,20 @@
+#ifndef LST_SIMULATOR_UDPTCPTEST_H
+#define LST_SIMULATOR_UDPTCPTEST_H
+
+/**
+ * test if two sockets exchange their datagrams in order over the stream that one of them dialed and see the addresses
+ * of the sockets as the senders
+ */
+void test_udp_tcp_send_receive();
+
+/**
+ * test if the datagrams that do not fit into the send buffer of a stream are dropped and the others arrive
+ */
+void test_udp_tcp_buffer_full();
+
+/**
+ * test if a closed stream is closed by the other end too and a new one is dialed to the restarted peer
+ */
+void test_udp_tcp_peer_restart();
+
+#endif //LST_SIMULATOR_UDPTCPTEST_H
@@ -0,0 +1,14 @@
+#ifndef LST_SIMULATOR_UDPURINGTEST_H
+#define LST_SIMULATOR_UDPURINGTEST_H
+
+/**
+ * test if the datagrams sent by the io_uring backend are received in order with their sender and receive time
+ */
+void test_udp_uring_send_receive();
+
+/**
+ * test if the multishot receive is armed again after more datagrams arrived than there are provided buffers
+ */
+void test_udp_uring_buffers_exhausted();
+
+#endif //LST_SIMULATOR_UDPURINGTEST_H
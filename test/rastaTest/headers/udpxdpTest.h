@@ -0,0 +1,20 @@
+#ifndef LST_SIMULATOR_UDPXDPTEST_H
+#define LST_SIMULATOR_UDPXDPTEST_H
+
+/**
+ * test if the datagrams to the socket are received through the AF_XDP socket on the loopback interface in order and
+ * the replies to their sender are sent on the UDP socket
+ */
+void test_udp_xdp_send_receive();
+
+/**
+ * test if a datagram to a known neighbour is written into a frame of the TX ring with valid headers and checksums
+ */
+void test_udp_xdp_frame();
+
+/**
+ * test if a socket whose interface does not allow AF_XDP keeps using UDP alone
+ */
+void test_udp_xdp_fallback();
+
+#endif //LST_SIMULATOR_UDPXDPTEST_H
@@ -0,0 +1,19 @@
+#ifndef LST_SIMULATOR_WORKERPOOLTEST_H
+#define LST_SIMULATOR_WORKERPOOLTEST_H
+
+/**
+ * test if the work of a job runs on a worker thread and its completion on the thread that completes the pool
+ */
+void test_worker_pool_complete();
+
+/**
+ * test if no more than max_pending jobs can be submitted until they are completed
+ */
+void test_worker_pool_limit();
+
+/**
+ * test if destroying a pool waits for the running job and cancels the ones that did not start
+ */
+void test_worker_pool_destroy();
+
+#endif //LST_SIMULATOR_WORKERPOOLTEST_H
@@ -42,6 +42,7 @@ int main(int argc, char *argv[]){
     configInfoRedundancy.n_diagnose = 10;
     configInfoRedundancy.crc_type = crc_init_opt_a();
     configInfoRedundancy.n_deferqueue_size = 2;
+    configInfoRedundancy.impairments.count = 0;
     info.redundancy = configInfoRedundancy;
 
     struct RastaIPData * listenPortsServer = rmalloc(2 * sizeof(struct RastaIPData));
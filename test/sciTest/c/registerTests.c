@@ -19,6 +19,7 @@ void cunit_register() {
     CU_add_test(sci_suite, "testEncode", testEncode);
     CU_add_test(sci_suite, "testDecode", testDecode);
     CU_add_test(sci_suite, "testDecodeInvalid", testDecodeInvalid);
+    CU_add_test(sci_suite, "testEncodeDecodeInto", testEncodeDecodeInto);
     CU_add_test(sci_suite, "testSetSender", testSetSender);
     CU_add_test(sci_suite, "testSetReceiver", testSetReceiver);
     CU_add_test(sci_suite, "testGetName", testGetName);
@@ -36,12 +37,22 @@ void cunit_register() {
     CU_add_test(sci_suite, "testParseVersionRequest", testParseVersionRequest);
     CU_add_test(sci_suite, "testParseVersionResponse", testParseVersionResponse);
 
+    // Tests for batches of SCI telegrams
+    CU_add_test(sci_suite, "testBatchAdd", testBatchAdd);
+    CU_add_test(sci_suite, "testBroadcast", testBroadcast);
+
+    // Tests for the table of SCI names
+    CU_add_test(sci_suite, "testNameTablePutFind", testNameTablePutFind);
+    CU_add_test(sci_suite, "testNameTableGrow", testNameTableGrow);
+    CU_add_test(sci_suite, "testStatusCache", testStatusCache);
+
     // Tests for creating and parsing SCI-P specific telegrams
     CU_add_test(sci_suite, "testCreateChangeLocation", testCreateChangeLocation);
     CU_add_test(sci_suite, "testCreateLocationStatus", testCreateLocationStatus);
     CU_add_test(sci_suite, "testCreateTimeout", testCreateTimeout);
     CU_add_test(sci_suite, "testParseChangeLocation", testParseChangeLocation);
     CU_add_test(sci_suite, "testParseLocationStatus", testParseLocationStatus);
+    CU_add_test(sci_suite, "testStatusCacheP", testStatusCacheP);
 
     // Tests for creating and parsing SCI-LS specific telegrams
     CU_add_test(sci_suite, "testSignalAspectDefaults", testSignalAspectDefaults);
@@ -53,6 +64,7 @@ void cunit_register() {
     CU_add_test(sci_suite, "testParseSignalAspectStatus", testParseSignalAspectStatus);
     CU_add_test(sci_suite, "testParseChangeBrightness", testParseChangeBrightness);
     CU_add_test(sci_suite, "testParseBrightnessStatus", testParseBrightnessStatus);
+    CU_add_test(sci_suite, "testStatusCacheLS", testStatusCacheLS);
 }
 
 int main () {
@@ -3,7 +3,10 @@
 
 #include <sci.h>
 #include <sci_telegram_factory.h>
+#include <sci_name_table.h>
+#include <sci_status_cache.h>
 #include <rmemory.h>
+#include <stdio.h>
 
 void testEncode(){
     unsigned char expected_telegram[] = {
@@ -292,4 +295,207 @@ void testParseVersionResponse(){
     sci_set_message_type(telegram, SCI_MESSAGE_TYPE_VERSION_REQUEST);
     result = sci_parse_version_response_payload(telegram, &version, &version_check_result, &len, &checksum[0]);
     CU_ASSERT_EQUAL(result, SCI_PARSE_INVALID_MESSAGE_TYPE);
-}
\ No newline at end of file
+}
+void testBatchAdd(){
+    sci_batch batch;
+    sci_batch_init(&batch);
+    CU_ASSERT_EQUAL(batch.open, 0);
+    CU_ASSERT_EQUAL(batch.count, 0);
+
+    sci_telegram * telegram = sci_create_status_begin(SCI_PROTOCOL_LS, "ab", "cd");
+    for (unsigned int i = 0; i < SCI_BATCH_MAX_TELEGRAMS; i++) {
+        CU_ASSERT_EQUAL(sci_batch_add(&batch, 0x61 + (i % 2), telegram), 1);
+    }
+    CU_ASSERT_EQUAL(batch.count, SCI_BATCH_MAX_TELEGRAMS);
+    CU_ASSERT_EQUAL(batch.rasta_ids[1], 0x62);
+
+    // the telegrams are added encoded
+    struct RastaByteArray encoded = sci_encode_telegram(telegram);
+    CU_ASSERT_EQUAL(batch.telegrams[0].length, encoded.length);
+    CU_ASSERT_NSTRING_EQUAL(batch.telegrams[0].bytes, encoded.bytes, encoded.length);
+    freeRastaByteArray(&encoded);
+
+    // a full batch does not take more telegrams
+    CU_ASSERT_EQUAL(sci_batch_add(&batch, 0x61, telegram), 0);
+    CU_ASSERT_EQUAL(batch.count, SCI_BATCH_MAX_TELEGRAMS);
+
+    sci_batch_free(&batch);
+    CU_ASSERT_EQUAL(batch.count, 0);
+    rfree(telegram);
+}
+
+void testBroadcast(){
+    struct sci_name_table table;
+    sci_name_table_init(&table);
+
+    // the table is keyed by the padded names
+    sci_telegram names;
+    sci_set_sender(&names, "ls1");
+    sci_name_table_put(&table, names.sender, 0x61);
+    sci_set_sender(&names, "ls2");
+    sci_name_table_put(&table, names.sender, 0x62);
+
+    sci_batch batch;
+    sci_batch_init(&batch);
+    batch.open = 1;
+
+    char * receivers[] = { "ls1", "unknown", "ls2" };
+    sci_telegram * telegram = sci_create_status_request(SCI_PROTOCOL_LS, "ab", "");
+    sci_return_code result = sci_broadcast_telegram(NULL, &table, &batch, telegram, receivers, 3);
+
+    // the unknown receiver is skipped, the others still get the telegram
+    CU_ASSERT_EQUAL(result, UNKNOWN_SCI_NAME);
+    CU_ASSERT_EQUAL_FATAL(batch.count, 2);
+    CU_ASSERT_EQUAL(batch.rasta_ids[0], 0x61);
+    CU_ASSERT_EQUAL(batch.rasta_ids[1], 0x62);
+
+    // only the receiver differs from the telegram that was sent to one of them
+    sci_telegram * expected = sci_create_status_request(SCI_PROTOCOL_LS, "ab", "ls2");
+    struct RastaByteArray encoded = sci_encode_telegram(expected);
+    CU_ASSERT_EQUAL(batch.telegrams[1].length, encoded.length);
+    CU_ASSERT_NSTRING_EQUAL(batch.telegrams[1].bytes, encoded.bytes, encoded.length);
+    CU_ASSERT_NSTRING_EQUAL(&batch.telegrams[0].bytes[23], "ls1_", 4);
+    CU_ASSERT_NSTRING_EQUAL(&batch.telegrams[0].bytes[43], &encoded.bytes[43], encoded.length - 43);
+    freeRastaByteArray(&encoded);
+    rfree(expected);
+
+    sci_batch_free(&batch);
+    sci_name_table_free(&table);
+}
+
+void testNameTablePutFind(){
+    struct sci_name_table table;
+    sci_name_table_init(&table);
+
+    sci_telegram a, b;
+    sci_set_sender(&a, "ab");
+    sci_set_sender(&b, "abc");
+    CU_ASSERT_EQUAL(sci_name_table_find(&table, a.sender), SCI_NAME_HANDLE_UNKNOWN);
+
+    sci_name_handle handle_a = sci_name_table_put(&table, a.sender, 0x61);
+    sci_name_handle handle_b = sci_name_table_put(&table, b.sender, 0x62);
+    CU_ASSERT_NOT_EQUAL(handle_a, handle_b);
+    CU_ASSERT_EQUAL(sci_name_table_find(&table, a.sender), handle_a);
+    CU_ASSERT_EQUAL(sci_name_table_find(&table, b.sender), handle_b);
+    CU_ASSERT_EQUAL(sci_name_table_rasta_id(&table, handle_a), 0x61);
+    CU_ASSERT_EQUAL(sci_name_table_rasta_id(&table, handle_b), 0x62);
+
+    // a registered name keeps its RaSTA ID
+    CU_ASSERT_EQUAL(sci_name_table_put(&table, a.sender, 0x63), handle_a);
+    CU_ASSERT_EQUAL(sci_name_table_rasta_id(&table, handle_a), 0x61);
+    CU_ASSERT_EQUAL(table.count, 2);
+
+    sci_name_table_free(&table);
+}
+
+void testNameTableGrow(){
+    struct sci_name_table table;
+    sci_name_table_init(&table);
+
+    char name[SCI_NAME_LENGTH + 1];
+    sci_telegram telegram;
+    for (unsigned long i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "station%lu", i);
+        sci_set_sender(&telegram, name);
+        CU_ASSERT_EQUAL(sci_name_table_put(&table, telegram.sender, i), (sci_name_handle) i);
+    }
+    CU_ASSERT(2 * table.count <= table.capacity);
+
+    int all_found = 1;
+    for (unsigned long i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "station%lu", i);
+        sci_set_sender(&telegram, name);
+        sci_name_handle handle = sci_name_table_find(&table, telegram.sender);
+        if (handle != (sci_name_handle) i || sci_name_table_rasta_id(&table, handle) != i) {
+            all_found = 0;
+        }
+    }
+    CU_ASSERT(all_found);
+
+    sci_set_sender(&telegram, "station1000");
+    CU_ASSERT_EQUAL(sci_name_table_find(&table, telegram.sender), SCI_NAME_HANDLE_UNKNOWN);
+
+    sci_name_table_free(&table);
+}
+
+void testEncodeDecodeInto(){
+    sci_telegram * telegram = sci_create_version_request(SCI_PROTOCOL_P, "ab", "cd", 0x42);
+
+    unsigned char buffer[SCI_MAX_TELEGRAM_LENGTH];
+    unsigned int length = sci_encode_telegram_into(telegram, buffer);
+    CU_ASSERT_EQUAL(length, SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD + 1);
+
+    // the same bytes as the allocating variant
+    struct RastaByteArray encoded = sci_encode_telegram(telegram);
+    CU_ASSERT_EQUAL(encoded.length, length);
+    CU_ASSERT_NSTRING_EQUAL(encoded.bytes, buffer, length);
+    freeRastaByteArray(&encoded);
+
+    struct RastaByteArray data;
+    data.bytes = buffer;
+    data.length = length;
+
+    sci_telegram decoded;
+    CU_ASSERT_EQUAL_FATAL(sci_decode_telegram_into(data, &decoded), 1);
+    CU_ASSERT_EQUAL(decoded.protocol_type, SCI_PROTOCOL_P);
+    CU_ASSERT_NSTRING_EQUAL(decoded.sender, telegram->sender, SCI_NAME_LENGTH);
+    CU_ASSERT_NSTRING_EQUAL(decoded.receiver, telegram->receiver, SCI_NAME_LENGTH);
+    CU_ASSERT_EQUAL(sci_get_message_type(&decoded), SCI_MESSAGE_TYPE_VERSION_REQUEST);
+    CU_ASSERT_EQUAL(decoded.payload.used_bytes, 1);
+    CU_ASSERT_EQUAL(decoded.payload.data[0], 0x42);
+
+    // a telegram without payload has no payload after decoding
+    data.length = SCI_TELEGRAM_LENGTH_WITHOUT_PAYLOAD;
+    CU_ASSERT_EQUAL(sci_decode_telegram_into(data, &decoded), 1);
+    CU_ASSERT_EQUAL(decoded.payload.used_bytes, 0);
+
+    // invalid protocol
+    buffer[0] = 0x60;
+    CU_ASSERT_EQUAL(sci_decode_telegram_into(data, &decoded), 0);
+
+    rfree(telegram);
+}
+
+void testStatusCache(){
+    sci_status_cache cache;
+    sci_status_cache_init(&cache);
+
+    sci_payload day, night;
+    day.used_bytes = 1;
+    day.data[0] = 0x01;
+    night.used_bytes = 1;
+    night.data[0] = 0x02;
+
+    // a disabled cache sends everything
+    sci_status_cache_store(&cache, 0, 0, &day, 1000);
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 0, &day, 1000));
+
+    sci_status_cache_enable(&cache, 100);
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 0, &day, 1000));
+    sci_status_cache_store(&cache, 0, 0, &day, 1000);
+    CU_ASSERT_TRUE(sci_status_cache_suppress(&cache, 0, 0, &day, 1050));
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 0, &night, 1050));
+    // the other kind of status and the other receivers are not known
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 1, &day, 1050));
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 1, 0, &day, 1050));
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, SCI_NAME_HANDLE_UNKNOWN, 0, &day, 1050));
+    // the unchanged status is sent again after the maximum refresh interval
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 0, &day, 1100));
+    CU_ASSERT_EQUAL(cache.suppressed, 1);
+
+    // a receiver with a large handle grows the entries, the known ones stay
+    sci_status_cache_store(&cache, 40, 1, &night, 1000);
+    CU_ASSERT(cache.receiver_capacity > 40);
+    CU_ASSERT_TRUE(sci_status_cache_suppress(&cache, 40, 1, &night, 1010));
+    CU_ASSERT_TRUE(sci_status_cache_suppress(&cache, 0, 0, &day, 1010));
+
+    // a refresh sends the next status of the receiver in any case
+    sci_status_cache_refresh(&cache, 40);
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 40, 1, &night, 1010));
+    CU_ASSERT_TRUE(sci_status_cache_suppress(&cache, 0, 0, &day, 1010));
+
+    sci_status_cache_disable(&cache);
+    CU_ASSERT_FALSE(sci_status_cache_suppress(&cache, 0, 0, &day, 1010));
+
+    sci_status_cache_free(&cache);
+}
@@ -2,6 +2,7 @@
 #include <CUnit/CUnit.h>
 
 #include <scils_telegram_factory.h>
+#include <scils.h>
 #include <rmemory.h>
 #include <sci.h>
 
@@ -222,4 +223,57 @@ void testParseBrightnessStatus(){
     CU_ASSERT_EQUAL(result, SCI_PARSE_INVALID_MESSAGE_TYPE);
 
     rfree(telegram);
-}
\ No newline at end of file
+}
+/**
+ * hands a telegram to the SCI-LS instance like RaSTA would
+ * @param ls the SCI-LS instance
+ * @param telegram the received telegram, it is freed afterwards
+ * @param rasta_id the RaSTA ID of the sender
+ */
+static void receive_telegram(scils_t * ls, sci_telegram * telegram, unsigned long rasta_id){
+    rastaApplicationMessage message;
+    message.id = rasta_id;
+    message.appMessage = sci_encode_telegram(telegram);
+    rfree(telegram);
+    scils_on_rasta_receive(ls, message);
+    freeRastaByteArray(&message.appMessage);
+}
+
+void testStatusCacheLS(){
+    scils_t * ls = scils_init(NULL, "ls");
+    scils_register_sci_name(ls, "ixl", 0x61);
+    // the batch collects what would be sent
+    scils_begin_batch(ls);
+    scils_enable_status_cache(ls, 0);
+
+    scils_signal_aspect * aspect = scils_signal_aspect_defaults();
+    scils_send_signal_aspect_status(ls, "ixl", *aspect);
+    scils_send_signal_aspect_status(ls, "ixl", *aspect);
+    scils_send_brightness_status(ls, "ixl", SCILS_BRIGHTNESS_DAY);
+    scils_send_brightness_status(ls, "ixl", SCILS_BRIGHTNESS_DAY);
+    CU_ASSERT_EQUAL(ls->batch.count, 2);
+    CU_ASSERT_EQUAL(ls->status_cache.suppressed, 2);
+
+    // a changed status is sent
+    scils_send_brightness_status(ls, "ixl", SCILS_BRIGHTNESS_NIGHT);
+    CU_ASSERT_EQUAL(ls->batch.count, 3);
+
+    // a status request of the receiver sends every status again
+    receive_telegram(ls, sci_create_status_request(SCI_PROTOCOL_LS, "ixl", "ls"), 0x61);
+    scils_send_signal_aspect_status(ls, "ixl", *aspect);
+    scils_send_brightness_status(ls, "ixl", SCILS_BRIGHTNESS_NIGHT);
+    CU_ASSERT_EQUAL(ls->batch.count, 5);
+
+    // so does a status report
+    scils_send_status_begin(ls, "ixl");
+    scils_send_signal_aspect_status(ls, "ixl", *aspect);
+    CU_ASSERT_EQUAL(ls->batch.count, 7);
+
+    // without the cache, every status is sent
+    scils_disable_status_cache(ls);
+    scils_send_signal_aspect_status(ls, "ixl", *aspect);
+    CU_ASSERT_EQUAL(ls->batch.count, 8);
+
+    rfree(aspect);
+    scils_cleanup(ls);
+}
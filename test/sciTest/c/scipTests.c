@@ -2,6 +2,7 @@
 #include <CUnit/CUnit.h>
 
 #include <scip_telegram_factory.h>
+#include <scip.h>
 #include <rmemory.h>
 #include <sci.h>
 
@@ -84,4 +85,31 @@ void testParseLocationStatus(){
     sci_set_message_type(telegram, SCIP_MESSAGE_TYPE_TIMEOUT);
     result = scip_parse_location_status_payload(telegram, &location);
     CU_ASSERT_EQUAL(result, SCI_PARSE_INVALID_MESSAGE_TYPE);
-}
\ No newline at end of file
+}
+void testStatusCacheP(){
+    scip_t * p = scip_init(NULL, "point");
+    scip_register_sci_name(p, "ixl", 0x61);
+    // the batch collects what would be sent
+    scip_begin_batch(p);
+    scip_enable_status_cache(p, 0);
+
+    scip_send_location_status(p, "ixl", POINT_LOCATION_LEFT);
+    scip_send_location_status(p, "ixl", POINT_LOCATION_LEFT);
+    CU_ASSERT_EQUAL(p->batch.count, 1);
+    scip_send_location_status(p, "ixl", POINT_LOCATION_RIGHT);
+    CU_ASSERT_EQUAL(p->batch.count, 2);
+
+    // a status request of the receiver sends the location again
+    sci_telegram * request = sci_create_status_request(SCI_PROTOCOL_P, "ixl", "point");
+    rastaApplicationMessage message;
+    message.id = 0x61;
+    message.appMessage = sci_encode_telegram(request);
+    rfree(request);
+    scip_on_rasta_receive(p, message);
+    freeRastaByteArray(&message.appMessage);
+    scip_send_location_status(p, "ixl", POINT_LOCATION_RIGHT);
+    CU_ASSERT_EQUAL(p->batch.count, 3);
+    CU_ASSERT_EQUAL(p->status_cache.suppressed, 1);
+
+    scip_cleanup(p);
+}
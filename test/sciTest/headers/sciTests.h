@@ -19,4 +19,14 @@ void testCreateStatusFinish();
 void testParseVersionRequest();
 void testParseVersionResponse();
 
+void testBatchAdd();
+void testBroadcast();
+
+void testNameTablePutFind();
+void testNameTableGrow();
+
+void testStatusCache();
+
+void testEncodeDecodeInto();
+
 #endif //LST_SIMULATOR_SCITESTS_H
@@ -13,4 +13,6 @@ void testParseSignalAspectStatus();
 void testParseChangeBrightness();
 void testParseBrightnessStatus();
 
+void testStatusCacheLS();
+
 #endif //LST_SIMULATOR_SCILSTESTS_H
@@ -8,4 +8,6 @@ void testCreateTimeout();
 void testParseChangeLocation();
 void testParseLocationStatus();
 
+void testStatusCacheP();
+
 #endif //LST_SIMULATOR_SCIPTESTS_H